@@ -217,6 +217,36 @@ static NSError *fakeError() {
   XCTAssertNil([self passwordWithAccount:kKey service:nil]);
 }
 
+/** @fn testPrefetchAllData
+    @brief Tests reading keychain items prefetched in a single query.
+ */
+- (void)testPrefetchAllData {
+  [self setPassword:kData account:accountFromKey(kKey) service:kService];
+  [self setPassword:kOtherData account:accountFromKey(kKey) service:kOtherService];
+  FIRAuthKeychain *keychain = [[FIRAuthKeychain alloc] initWithService:kService];
+  NSError *error = fakeError();
+  XCTAssertTrue([keychain prefetchAllData:&error]);
+  XCTAssertNil(error);
+  // The prefetched item is read from memory from now on.
+  [self deletePasswordWithAccount:accountFromKey(kKey) service:kService];
+  error = fakeError();
+  XCTAssertEqualObjects([keychain dataForKey:kKey error:&error], dataFromString(kData));
+  XCTAssertNil(error);
+  [self deletePasswordWithAccount:accountFromKey(kKey) service:kOtherService];
+}
+
+/** @fn testWriteIsCached
+    @brief Tests reading a keychain item just written.
+ */
+- (void)testWriteIsCached {
+  [self setPassword:nil account:accountFromKey(kKey) service:kService];
+  FIRAuthKeychain *keychain = [[FIRAuthKeychain alloc] initWithService:kService];
+  XCTAssertTrue([keychain setData:dataFromString(kData) forKey:kKey error:NULL]);
+  XCTAssertEqualObjects([self passwordWithAccount:accountFromKey(kKey) service:kService], kData);
+  [self deletePasswordWithAccount:accountFromKey(kKey) service:kService];
+  XCTAssertEqualObjects([keychain dataForKey:kKey error:NULL], dataFromString(kData));
+}
+
 /** @fn testNullErrorParameter
     @brief Tests that 'NULL' can be safely passed in.
  */
@@ -1170,6 +1170,46 @@ static const NSTimeInterval kExpectationTimeout = 2;
   OCMVerifyAll(_mockBackend);
 }
 
+/** @fn testConcurrentGetIDTokenForcingRefreshSharesOneRequest
+    @brief Tests that concurrent @c getIDTokenForcingRefresh:completion: calls are all completed
+        by a single request to the secure token service.
+ */
+- (void)testConcurrentGetIDTokenForcingRefreshSharesOneRequest {
+  id mockGetAccountInfoResponseUser = OCMClassMock([FIRGetAccountInfoResponseUser class]);
+  OCMStub([mockGetAccountInfoResponseUser localID]).andReturn(kLocalID);
+  OCMStub([mockGetAccountInfoResponseUser email]).andReturn(kEmail);
+  OCMStub([mockGetAccountInfoResponseUser displayName]).andReturn(kGoogleDisplayName);
+  OCMStub([mockGetAccountInfoResponseUser passwordHash]).andReturn(kPasswordHash);
+  XCTestExpectation *firstExpectation = [self expectationWithDescription:@"first callback"];
+  XCTestExpectation *secondExpectation = [self expectationWithDescription:@"second callback"];
+  [self signInWithEmailPasswordWithMockUserInfoResponse:mockGetAccountInfoResponseUser
+                                             completion:^(FIRUser *user) {
+    OCMExpect([_mockBackend secureToken:[OCMArg any] callback:[OCMArg any]])
+        .andCallBlock2(^(FIRSecureTokenRequest *_Nullable request,
+                         FIRSecureTokenResponseCallback callback) {
+      dispatch_async(FIRAuthGlobalWorkQueue(), ^() {
+        id mockSecureTokenResponse = OCMClassMock([FIRSecureTokenResponse class]);
+        OCMStub([mockSecureTokenResponse accessToken]).andReturn(kNewAccessToken);
+        callback(mockSecureTokenResponse, nil);
+      });
+    });
+    [user getIDTokenForcingRefresh:YES completion:^(NSString *_Nullable token,
+                                                    NSError *_Nullable error) {
+      XCTAssertNil(error);
+      XCTAssertEqualObjects(token, kNewAccessToken);
+      [firstExpectation fulfill];
+    }];
+    [user getIDTokenForcingRefresh:YES completion:^(NSString *_Nullable token,
+                                                    NSError *_Nullable error) {
+      XCTAssertNil(error);
+      XCTAssertEqualObjects(token, kNewAccessToken);
+      [secondExpectation fulfill];
+    }];
+  }];
+  [self waitForExpectationsWithTimeout:kExpectationTimeout handler:nil];
+  OCMVerifyAll(_mockBackend);
+}
+
 /** @fn testReloadFailure
     @brief Tests the flow of a failed @c reloadWithCompletion: call.
  */
@@ -135,6 +135,22 @@
   XCTAssertNotNil(container.cachedInstances[protocolName]);
 }
 
+- (void)testBackgroundEagerInstantiation {
+  // `FIRTestClassEagerBackground` is instantiated off the main thread, so retrieving it right away
+  // should wait for the pending instance instead of creating a second one.
+  FIRComponentContainer *container =
+      [self containerWithRegistrants:@ [[FIRTestClassEagerBackground class]]];
+  id<FIRTestProtocolEagerBackground> instance1 =
+      FIR_COMPONENT(FIRTestProtocolEagerBackground, container);
+  XCTAssertNotNil(instance1);
+  id<FIRTestProtocolEagerBackground> instance2 =
+      FIR_COMPONENT(FIRTestProtocolEagerBackground, container);
+  XCTAssertEqual(instance1, instance2);
+
+  NSString *protocolName = NSStringFromProtocol(@protocol(FIRTestProtocolEagerBackground));
+  XCTAssertEqual(container.cachedInstances[protocolName], instance1);
+}
+
 #pragma mark - Input Validation Tests
 
 - (void)testProtocolAlreadyRegistered {
@@ -49,6 +49,18 @@
     : NSObject <FIRTestProtocol, FIRComponentLifecycleMaintainer, FIRLibrary>
 @end
 
+#pragma mark - Background Eager Component
+
+/// A test protocol to be used for container testing.
+@protocol FIRTestProtocolEagerBackground
+@end
+
+/// A test class that is a component registrant that provides a cached component requiring eager
+/// instantiation that can happen off the main thread.
+@interface FIRTestClassEagerBackground
+    : NSObject <FIRTestProtocolEagerBackground, FIRComponentLifecycleMaintainer, FIRLibrary>
+@end
+
 #pragma mark - Cached Component
 
 /// A test protocol to be used for container testing.
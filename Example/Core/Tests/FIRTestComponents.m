@@ -97,6 +97,33 @@
 
 @end
 
+#pragma mark - Background Eager Component
+
+@implementation FIRTestClassEagerBackground
+
+/// FIRLibrary conformance.
++ (nonnull NSArray<FIRComponent *> *)componentsToRegister {
+  FIRComponent *testComponent = [FIRComponent
+      componentWithProtocol:@protocol(FIRTestProtocolEagerBackground)
+        instantiationTiming:FIRInstantiationTimingAlwaysEager
+               dependencies:@[]
+         requiresMainThread:NO
+              creationBlock:^id _Nullable(FIRComponentContainer *_Nonnull container,
+                                          BOOL *_Nonnull isCacheable) {
+                // Give `instanceForProtocol:` a chance to be called before the instance is ready.
+                [NSThread sleepForTimeInterval:0.05];
+                *isCacheable = YES;
+                return [[FIRTestClassEagerBackground alloc] init];
+              }];
+  return @[ testComponent ];
+}
+
+/// FIRComponentLifecycleMaintainer conformance.
+- (void)appWillBeDeleted:(FIRApp *)app {
+}
+
+@end
+
 #pragma mark - Cached Component
 
 @implementation FIRTestClassCached
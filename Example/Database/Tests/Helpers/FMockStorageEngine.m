@@ -94,6 +94,19 @@
     return children;
 }
 
+- (NSDictionary *)serverCacheChildrenAtPath:(FPath *)path valuesAtChildPath:(FPath *)childPath {
+    NSMutableDictionary *children = [NSMutableDictionary dictionary];
+    id<FNode> fullNode = [[self.serverCache childCompoundWriteAtPath:path] applyToNode:[FEmptyNode emptyNode]];
+    [fullNode enumerateChildrenUsingBlock:^(NSString *key, id<FNode> childNode, BOOL *stop) {
+        children[key] = (childPath != nil) ? [childNode getChild:childPath] : [FEmptyNode emptyNode];
+    }];
+    return children;
+}
+
+- (NSArray *)serverCacheKeysAtPath:(FPath *)path orderedByChild:(FPath *)childPath params:(FQueryParams *)params {
+    return nil;
+}
+
 - (void)updateServerCache:(id<FNode>)node atPath:(FPath *)path merge:(BOOL)merge {
     if (merge) {
         [node enumerateChildrenUsingBlock:^(NSString *key, id<FNode> childNode, BOOL *stop) {
@@ -212,6 +212,40 @@ static NSString *kFirebaseTestAltNamespace = @"https://foobar.firebaseio.com";
     [database goOnline];
 }
 
+- (void) testStatisticsCountPendingWritesAndEvents {
+    FMockStorageEngine *engine = [[FMockStorageEngine alloc] init];
+    FIRDatabaseReference *ref = [self rootRefWithEngine:engine name:@"statisticsCountPendingWritesAndEvents"];
+    FIRDatabase *database = ref.database;
+
+    [database goOffline];
+
+    __block NSUInteger events = 0;
+    [ref observeEventType:FIRDataEventTypeValue withBlock:^(FIRDataSnapshot *snapshot) {
+        events++;
+    }];
+    [[ref childByAutoId] setValue:@"test-value-1"];
+    [[ref childByAutoId] setValue:@"test-value-2"];
+    [[ref childByAutoId] setValue:@"test-value-3"];
+
+    [self waitForEvents:ref];
+
+    __block FIRDatabaseStatistics *statistics = nil;
+    [database getStatisticsWithCompletion:^(FIRDatabaseStatistics *result) {
+        statistics = result;
+    }];
+    WAIT_FOR(statistics != nil);
+
+    XCTAssertEqual(statistics.pendingWriteCount, (NSUInteger)3);
+    XCTAssertEqual(statistics.trackedQueryCount, (NSUInteger)1);
+    XCTAssertGreaterThanOrEqual(statistics.eventCount, events);
+    XCTAssertGreaterThanOrEqual(statistics.persistenceWriteCount, (NSUInteger)3);
+    XCTAssertGreaterThanOrEqual(statistics.maxEventLatency, statistics.averageEventLatency);
+
+    [database purgeOutstandingWrites];
+    [self waitForEvents:ref];
+    [database goOnline];
+}
+
 - (void) testPurgeWritesAreCanceledInOrder {
     FMockStorageEngine *engine = [[FMockStorageEngine alloc] init];
     FIRDatabaseReference *ref = [self rootRefWithEngine:engine name:@"purgeWritesAndCanceledInOrder"];
@@ -138,4 +138,18 @@ static FCompoundHashSplitStrategy NEVER_SPLIT_STRATEGY = ^BOOL(FCompoundHashBuil
     XCTAssertEqualWithAccuracy(hash1M.hashes.count, 150, 10);
 }
 
+- (void)testDefaultHashIsReusedForUnchangedNodes {
+    id<FNode> node = NODE((@{@"foo": @{@"bar": @"baz"}, @"qux": @"qux"}));
+    FCompoundHash *hash = [FCompoundHash fromNode:node];
+    XCTAssertTrue([FCompoundHash fromNode:node] == hash);
+
+    id<FNode> updated = [node updateChild:PATH(@"foo/bar") withNewChild:NODE(@"changed")];
+    FCompoundHash *updatedHash = [FCompoundHash fromNode:updated];
+    XCTAssertNotEqualObjects(updatedHash.hashes, hash.hashes);
+
+    id<FNode> rebuilt = NODE((@{@"foo": @{@"bar": @"changed"}, @"qux": @"qux"}));
+    XCTAssertEqualObjects([FCompoundHash fromNode:rebuilt].hashes, updatedHash.hashes);
+    XCTAssertEqualObjects([FCompoundHash fromNode:rebuilt].posts, updatedHash.posts);
+}
+
 @end
@@ -206,6 +206,18 @@
     XCTAssertEqualObjects(updatedNode, expectedNode, @"Shallow update should remove deep udpates.");
 }
 
+- (void) testRootMostWritePathIsShallowestWriteOnPath {
+    FCompoundWrite *compoundWrite = [FCompoundWrite emptyWrite];
+    compoundWrite = [compoundWrite addWrite:[FSnapshotUtilities nodeFrom:@"foo-value"] atPath:[[FPath alloc] initWith:@"child-1/foo"]];
+    compoundWrite = [compoundWrite addWrite:[FSnapshotUtilities nodeFrom:@"baz-value"] atPath:[[FPath alloc] initWith:@"child-1/foo/baz"]];
+    XCTAssertEqualObjects([compoundWrite rootMostWritePathOnPath:[[FPath alloc] initWith:@"child-1/foo/baz/qux"]],
+                          [[FPath alloc] initWith:@"child-1/foo"]);
+    XCTAssertEqualObjects([compoundWrite rootMostWritePathOnPath:[[FPath alloc] initWith:@"child-1/foo"]],
+                          [[FPath alloc] initWith:@"child-1/foo"]);
+    XCTAssertNil([compoundWrite rootMostWritePathOnPath:[[FPath alloc] initWith:@"child-1"]]);
+    XCTAssertNil([compoundWrite rootMostWritePathOnPath:[[FPath alloc] initWith:@"child-2/foo"]]);
+}
+
 - (void) testChildPriorityDoesntUpdateEmptyNodePriorityOnChildMerge {
     FCompoundWrite *compoundWrite = [FCompoundWrite emptyWrite];
     compoundWrite = [compoundWrite addWrite:self.priorityNode atPath:[[FPath alloc] initWith:@"child-1/.priority"]];
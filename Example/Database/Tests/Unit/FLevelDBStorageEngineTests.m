@@ -24,6 +24,9 @@
 #import "FWriteRecord.h"
 #import "FTestHelpers.h"
 #import "FEmptyNode.h"
+#import "FCompoundWrite.h"
+#import "FPruneForest.h"
+#import "FIRDatabaseQuery_Private.h"
 
 @interface FLevelDBStorageEngineTests : XCTestCase
 
@@ -107,6 +110,24 @@
     XCTAssertEqualObjects(engine.userWrites, @[OVERWRITE_RECORD(@"other/path", NODE(@"second"), 1)]);
 }
 
+- (void)testBatchedUserWritesAreCommittedOnTheDatabaseQueue {
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    [engine saveUserOverwrite:NODE(@"first") atPath:PATH(@"foo") writeId:1];
+    FCompoundWrite *merge = [[FCompoundWrite emptyWrite] addWrite:NODE(@"second") atKey:@"bar"];
+    [engine saveUserMerge:merge atPath:PATH(@"foo") writeId:2];
+    [engine saveUserOverwrite:NODE(@"third") atPath:PATH(@"foo/baz") writeId:3];
+
+    // Wait for the pending batch to be committed, then read it back from disk.
+    dispatch_sync([FIRDatabaseQuery sharedQueue], ^{});
+    [engine close];
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"test-db"];
+    FLevelDBStorageEngine *reopened = [[FLevelDBStorageEngine alloc] initWithPath:path];
+    NSArray *expected = @[OVERWRITE_RECORD(@"foo", NODE(@"first"), 1),
+                          MERGE_RECORD(@"foo", merge, 2),
+                          OVERWRITE_RECORD(@"foo/baz", NODE(@"third"), 3)];
+    XCTAssertEqualObjects(reopened.userWrites, expected);
+}
+
 - (void)testHugeWriteWorks {
     FLevelDBStorageEngine *engine = [self cleanStorageEngine];
     [engine saveUserOverwrite:TEN_MEG_NODE atPath:PATH(@"foo/bar") writeId:1];
@@ -433,22 +454,126 @@
     XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], NODE((@{@"deep": @"deep-value"})));
 }
 
-// Well this is awkward, but NSJSONSerialization fails to deserialize JSON with tiny/huge doubles
-// It is kind of bad we raise "invalid" data, but at least we don't crash *trollface*
+// Leaves are no longer stored as JSON, so doubles that NSJSONSerialization fails to parse survive a round trip.
 - (void)testExtremeDoublesAsServerCache {
-#ifdef TARGET_OS_IOS
-    if ([[NSProcessInfo processInfo] operatingSystemVersion].majorVersion == 11) {
-        // NSJSONSerialization on iOS 11 correctly serializes small and large doubles.
-        return;
-    }
-#endif
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    id<FNode> node = NODE((@{@"works": @"value", @"tiny": @(2.225073858507201e-308), @"huge": @(1.7976931348623157e308)}));
+    [engine updateServerCache:node atPath:PATH(@"foo") merge:NO];
 
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], node);
+}
+
+- (void)testLeafTypesArePreserved {
     FLevelDBStorageEngine *engine = [self cleanStorageEngine];
-    [engine updateServerCache:NODE((@{@"works": @"value", @"fails": @(2.225073858507201e-308)})) atPath:PATH(@"foo") merge:NO];
+    id<FNode> node = NODE((@{@"true": @YES, @"false": @NO, @"empty": @"", @"unicode": @"f\u00fc/\U0001F525",
+                             @"negative": @(-42), @"double": @(-0.5)}));
+    [engine updateServerCache:node atPath:PATH(@"foo") merge:NO];
+
+    id<FNode> actualData = [engine serverCacheAtPath:PATH(@"foo")];
+    XCTAssertEqualObjects(actualData, node);
+    XCTAssertEqualObjects([actualData dataHash], [node dataHash]);
+}
+
+- (void)testChildrenAreLoadedWithOnlyTheirIndexedValues {
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    [engine updateServerCache:NODE((@{@"a": @{@"order": @1, @"text": @"first"},
+                                      @"a-b": @{@"order": @2, @"nested": @{@"deep": @"value"}},
+                                      @"a0": @"leaf",
+                                      @"b": @{@".priority": @5, @"text": @"last"}}))
+                       atPath:PATH(@"foo")
+                        merge:NO];
+
+    NSDictionary *values = [engine serverCacheChildrenAtPath:PATH(@"foo") valuesAtChildPath:PATH(@"order")];
+    XCTAssertEqualObjects(values, (@{@"a": NODE(@1), @"a-b": NODE(@2), @"a0": [FEmptyNode emptyNode],
+                                     @"b": [FEmptyNode emptyNode]}));
 
-    // Will drop the tiny double
-    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], NODE(@{@"works": @"value"}));
-    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo/fails")], [FEmptyNode emptyNode]);
+    values = [engine serverCacheChildrenAtPath:PATH(@"foo") valuesAtChildPath:PATH(@".priority")];
+    XCTAssertEqualObjects(values[@"b"], NODE(@5));
+    XCTAssertEqualObjects(values[@"a"], [FEmptyNode emptyNode]);
+
+    values = [engine serverCacheChildrenAtPath:PATH(@"foo") valuesAtChildPath:nil];
+    XCTAssertEqualObjects([NSSet setWithArray:values.allKeys], ([NSSet setWithArray:@[@"a", @"a-b", @"a0", @"b"]]));
+
+    XCTAssertEqualObjects([engine serverCacheChildrenAtPath:PATH(@"foo/a0") valuesAtChildPath:nil], @{});
+}
+
+- (void)testServerCacheIndexOrdersLikePathIndex {
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    [engine updateServerCache:NODE((@{@"a": @{@"score": @2}, @"b": @{@"score": @-1.5}, @"c": @{@"score": @"x"},
+                                      @"d": @{@"score": @YES}, @"e": @{@"other": @1}, @"f": @{@"score": @{@"deep": @1}},
+                                      @"10": @{@"score": @2}, @"9": @{@"score": @2}, @"z": @{@"score": @"x"},
+                                      @"y": @{@"score": @"xa"}}))
+                       atPath:PATH(@"list")
+                        merge:NO];
+    FQueryParams *params = [[FQueryParams defaultInstance] orderBy:[[FPathIndex alloc] initWithPath:PATH(@"score")]];
+
+    NSArray *keys = [engine serverCacheKeysAtPath:PATH(@"list") orderedByChild:PATH(@"score") params:params];
+    XCTAssertEqualObjects(keys, (@[@"e", @"d", @"b", @"9", @"10", @"a", @"c", @"z", @"y", @"f"]));
+    keys = [engine serverCacheKeysAtPath:PATH(@"list") orderedByChild:PATH(@"score") params:[params limitToFirst:3]];
+    XCTAssertEqualObjects(keys, (@[@"e", @"d", @"b"]));
+    keys = [engine serverCacheKeysAtPath:PATH(@"list") orderedByChild:PATH(@"score") params:[params limitToLast:2]];
+    XCTAssertEqualObjects(keys, (@[@"y", @"f"]));
+    keys = [engine serverCacheKeysAtPath:PATH(@"list") orderedByChild:PATH(@"score") params:[params startAt:NODE(@2)]];
+    XCTAssertEqualObjects(keys, (@[@"9", @"10", @"a", @"c", @"z", @"y", @"f"]));
+    FQueryParams *range = [[params startAt:NODE(@2) childKey:@"10"] endAt:NODE(@"x")];
+    keys = [engine serverCacheKeysAtPath:PATH(@"list") orderedByChild:PATH(@"score") params:range];
+    XCTAssertEqualObjects(keys, (@[@"10", @"a", @"c", @"z"]));
+}
+
+- (void)testServerCacheIndexIsKeptUpToDate {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"test-db"];
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    [engine updateServerCache:NODE((@{@"a": @{@"score": @3}, @"b": @{@"score": @2}, @"c": @{@"score": @1}}))
+                       atPath:PATH(@"list")
+                        merge:NO];
+    FQueryParams *params = [[FQueryParams defaultInstance] orderBy:[[FPathIndex alloc] initWithPath:PATH(@"score")]];
+    NSArray *keys = [engine serverCacheKeysAtPath:PATH(@"list") orderedByChild:PATH(@"score") params:params];
+    XCTAssertEqualObjects(keys, (@[@"c", @"b", @"a"]));
+
+    [engine updateServerCache:NODE(@0) atPath:PATH(@"list/a/score") merge:NO];
+    [engine updateServerCache:[FEmptyNode emptyNode] atPath:PATH(@"list/b") merge:NO];
+    [engine updateServerCacheWithMerge:[FCompoundWrite compoundWriteWithValueDictionary:@{@"d/score": @5, @"e": @"leaf"}]
+                                atPath:PATH(@"list")];
+    [engine updateServerCache:NODE((@{@"f": @{@"score": @4}})) atPath:PATH(@"list") merge:YES];
+    NSArray *expected = @[@"e", @"a", @"c", @"f", @"d"];
+    keys = [engine serverCacheKeysAtPath:PATH(@"list") orderedByChild:PATH(@"score") params:params];
+    XCTAssertEqualObjects(keys, expected);
+
+    [engine close];
+    engine = [[FLevelDBStorageEngine alloc] initWithPath:path];
+    keys = [engine serverCacheKeysAtPath:PATH(@"list") orderedByChild:PATH(@"score") params:params];
+    XCTAssertEqualObjects(keys, expected);
+
+    [engine updateServerCache:NODE((@{@"list": @{@"g": @{@"score": @1}}})) atPath:PATH(@"") merge:NO];
+    keys = [engine serverCacheKeysAtPath:PATH(@"list") orderedByChild:PATH(@"score") params:params];
+    XCTAssertEqualObjects(keys, @[@"g"]);
+
+    [engine pruneCache:[[FPruneForest empty] prunePath:PATH(@"list")] atPath:PATH(@"")];
+    keys = [engine serverCacheKeysAtPath:PATH(@"list") orderedByChild:PATH(@"score") params:params];
+    XCTAssertEqualObjects(keys, @[]);
+    [engine close];
+}
+
+- (void)testServerCacheSizeIsKeptUpToDate {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"test-db"];
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    XCTAssertEqual([engine serverCacheEstimatedSizeInBytes], 0);
+
+    [engine updateServerCache:SAMPLE_NODE atPath:PATH(@"foo") merge:NO];
+    [engine updateServerCache:NODE((@{@"foo": @"overwritten", @"bar": ONE_MEG_NODE})) atPath:PATH(@"") merge:NO];
+    [engine updateServerCache:NODE((@{@"bar": @"merged", @"baz": @{@"qux": @1}})) atPath:PATH(@"") merge:YES];
+    [engine updateServerCacheWithMerge:[FCompoundWrite compoundWriteWithValueDictionary:@{@"baz/qux": @"value"}]
+                                atPath:PATH(@"")];
+    FPruneForest *forest = [[[FPruneForest empty] prunePath:PATH(@"baz")] keepPath:PATH(@"baz/quu")];
+    [engine pruneCache:forest atPath:PATH(@"")];
+    NSUInteger trackedSize = [engine serverCacheEstimatedSizeInBytes];
+
+    // A new engine measures the cache from scratch.
+    [engine close];
+    FLevelDBStorageEngine *reopened = [[FLevelDBStorageEngine alloc] initWithPath:path];
+    XCTAssertEqual(trackedSize, [reopened serverCacheEstimatedSizeInBytes]);
+    XCTAssertEqualObjects([reopened serverCacheAtPath:PATH(@"")], NODE((@{@"foo": @"overwritten", @"bar": @"merged"})));
+    [reopened close];
 }
 
 - (void)testLongValuesDontLosePrecision {
@@ -21,6 +21,8 @@
 #import "FEmptyNode.h"
 #import "FChildrenNode.h"
 #import "FLeafNode.h"
+#import "FPackedChildrenNode.h"
+#import "FNamedNode.h"
 
 @interface FNodeTests : XCTestCase
 
@@ -171,4 +173,60 @@
     XCTAssertTrue([[empty2 getPriority] isEmpty]);
 }
 
+- (void)testLeafChildrenArePacked {
+    NSDictionary *data = @{ @"a": @1, @"b": @"two", @"c": @YES, @"10": @2.5, @"2": @3 };
+    id<FNode> node = [FSnapshotUtilities nodeFrom:data priority:@"prio"];
+    XCTAssertTrue([node isKindOfClass:[FPackedChildrenNode class]]);
+
+    id<FNode> unpacked = [FEmptyNode emptyNode];
+    for (NSString *key in data) {
+        unpacked = [unpacked updateImmediateChild:key withNewChild:[FSnapshotUtilities nodeFrom:data[key]]];
+    }
+    unpacked = [unpacked updatePriority:[FSnapshotUtilities nodeFrom:@"prio"]];
+    XCTAssertFalse([unpacked isKindOfClass:[FPackedChildrenNode class]]);
+
+    XCTAssertEqualObjects(node, unpacked);
+    XCTAssertEqualObjects(unpacked, node);
+    XCTAssertEqual(node.hash, unpacked.hash);
+    XCTAssertEqualObjects(node.dataHash, unpacked.dataHash);
+    XCTAssertEqualObjects([node valForExport:YES], [unpacked valForExport:YES]);
+    XCTAssertEqual(node.numChildren, 5);
+    XCTAssertEqualObjects([node getImmediateChild:@"b"].val, @"two");
+    XCTAssertTrue([[node getImmediateChild:@"d"] isEmpty]);
+    XCTAssertEqualObjects([node predecessorChildKey:@"10"], @"2");
+    XCTAssertNil([node predecessorChildKey:@"2"]);
+    XCTAssertEqualObjects([(FChildrenNode *)node firstChild].name, @"2");
+    XCTAssertEqualObjects([(FChildrenNode *)node lastChild].name, @"c");
+
+    NSMutableArray *keys = [NSMutableArray array];
+    [node enumerateChildrenReverse:YES usingBlock:^(NSString *key, id<FNode> child, BOOL *stop) {
+        [keys addObject:key];
+    }];
+    XCTAssertEqualObjects(keys, (@[@"c", @"b", @"a", @"10", @"2"]));
+    [keys removeAllObjects];
+    for (FNamedNode *child in [node childEnumerator]) {
+        [keys addObject:child.name];
+    }
+    XCTAssertEqualObjects(keys, (@[@"2", @"10", @"a", @"b", @"c"]));
+}
+
+- (void)testChangingPackedChildrenUnpacksThem {
+    id<FNode> node = [FSnapshotUtilities nodeFrom:@[@1, @2, @3]];
+    XCTAssertTrue([node isKindOfClass:[FPackedChildrenNode class]]);
+
+    id<FNode> updated = [node updateImmediateChild:@"1" withNewChild:[FSnapshotUtilities nodeFrom:@"two"]];
+    XCTAssertFalse([updated isKindOfClass:[FPackedChildrenNode class]]);
+    XCTAssertEqualObjects(updated.val, (@[@1, @"two", @3]));
+    XCTAssertEqualObjects(node.val, (@[@1, @2, @3]));
+
+    id<FNode> removed = [node updateChild:[FPath pathWithString:@"2"] withNewChild:[FEmptyNode emptyNode]];
+    XCTAssertEqualObjects(removed.val, (@[@1, @2]));
+}
+
+- (void)testChildrenWithPriorityAreNotPacked {
+    id<FNode> node = [FSnapshotUtilities nodeFrom:@{ @"a": @1, @"b": @{ @".value": @2, @".priority": @1 } }];
+    XCTAssertFalse([node isKindOfClass:[FPackedChildrenNode class]]);
+    XCTAssertEqualObjects([[node getImmediateChild:@"b"] getPriority].val, @1);
+}
+
 @end
@@ -81,4 +81,27 @@
     }
 }
 
+- (void)testDerivedPathsMatchParsedPaths
+{
+    FPath *path = [[FPath alloc] initWith:@"/a/b/c"];
+    FPath *parent = [path parent];
+    XCTAssertEqualObjects(parent, [[FPath alloc] initWith:@"/a/b"]);
+    XCTAssertEqual([parent hash], [[[FPath alloc] initWith:@"/a/b"] hash]);
+    XCTAssertEqualObjects([parent getBack], @"b");
+    XCTAssertEqualObjects([parent toString], @"/a/b");
+    XCTAssertEqual([parent length], 2);
+    XCTAssertFalse([parent isEqual:path]);
+    XCTAssertTrue([parent contains:path]);
+    XCTAssertFalse([path contains:parent]);
+
+    FPath *middle = [[path popFront] parent];
+    XCTAssertEqualObjects(middle, [[FPath alloc] initWith:@"/b"]);
+    XCTAssertEqualObjects([middle childFromString:@"d"], [[FPath alloc] initWith:@"/b/d"]);
+    XCTAssertEqualObjects([middle childFromString:@"d/e/"], [[FPath alloc] initWith:@"/b/d/e"]);
+    XCTAssertEqualObjects([middle child:[path popFront]], [[FPath alloc] initWith:@"/b/b/c"]);
+    XCTAssertEqual([middle compare:[path popFront]], NSOrderedAscending);
+    XCTAssertTrue([[middle parent] isEmpty]);
+    XCTAssertNil([[middle parent] parent]);
+}
+
 @end
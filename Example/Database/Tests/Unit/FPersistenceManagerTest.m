@@ -22,6 +22,7 @@
 #import "FQuerySpec.h"
 #import "FSnapshotUtilities.h"
 #import "FPathIndex.h"
+#import "FKeyIndex.h"
 #import "FIndexedNode.h"
 #import "FEmptyNode.h"
 
@@ -86,6 +87,50 @@
     XCTAssertTrue([node.indexedNode hasIndex:orderByQuery.index]);
 }
 
+- (void)testLimitQueryOnCompleteLocationOnlyLoadsShownChildren {
+    FPersistenceManager *manager = [self newTestPersistenceManager];
+
+    FQuerySpec *defaultQuery = [FQuerySpec defaultQueryAtPath:PATH(@"foo")];
+    [manager setQueryActive:defaultQuery];
+    [manager updateServerCacheWithNode:NODE((@{@"a": @{@"order": @3}, @"b": @{@"order": @1},
+                                               @"c": @{@"order": @2}, @"d": @{@"other": @0}}))
+                              forQuery:defaultQuery];
+    [manager setQueryComplete:defaultQuery];
+
+    id<FIndex> index = [[FPathIndex alloc] initWithPath:PATH(@"order")];
+    FQuerySpec *lastTwoQuery = [[FQuerySpec alloc] initWithPath:PATH(@"foo")
+                                                         params:[[[FQueryParams defaultInstance] orderBy:index]
+                                                                    limitToLast:2]];
+    FCacheNode *cache = [manager serverCacheForQuery:lastTwoQuery];
+    XCTAssertEqualObjects(cache.node, NODE((@{@"a": @{@"order": @3}, @"c": @{@"order": @2}})));
+    XCTAssertTrue(cache.isFullyInitialized);
+    XCTAssertTrue(cache.isFiltered);
+
+    // Children without the indexed value sort first.
+    FQuerySpec *firstTwoQuery = [[FQuerySpec alloc] initWithPath:PATH(@"foo")
+                                                          params:[[[FQueryParams defaultInstance] orderBy:index]
+                                                                     limitToFirst:2]];
+    cache = [manager serverCacheForQuery:firstTwoQuery];
+    XCTAssertEqualObjects(cache.node, NODE((@{@"d": @{@"other": @0}, @"b": @{@"order": @1}})));
+}
+
+- (void)testRangeQueryOnCompleteLocationOnlyLoadsShownChildren {
+    FPersistenceManager *manager = [self newTestPersistenceManager];
+
+    FQuerySpec *defaultQuery = [FQuerySpec defaultQueryAtPath:PATH(@"foo")];
+    [manager setQueryActive:defaultQuery];
+    [manager updateServerCacheWithNode:NODE((@{@"1": @"one", @"2": @"two", @"10": @"ten", @"b": @"bee"}))
+                              forQuery:defaultQuery];
+    [manager setQueryComplete:defaultQuery];
+
+    // Keys are ordered as integers before strings, not as stored.
+    FQueryParams *params =
+        [[[[FQueryParams defaultInstance] orderBy:[FKeyIndex keyIndex]] startAt:NODE(@"2")] limitToFirst:2];
+    FCacheNode *cache = [manager serverCacheForQuery:[[FQuerySpec alloc] initWithPath:PATH(@"foo") params:params]];
+    XCTAssertEqualObjects(cache.node, NODE((@{@"2": @"two", @"10": @"ten"})));
+    XCTAssertTrue(cache.isFiltered);
+}
+
 - (void)testApplyUserMergeUsesRelativePath {
     FMockStorageEngine *engine = [[FMockStorageEngine alloc] init];
 
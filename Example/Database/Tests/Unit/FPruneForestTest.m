@@ -94,5 +94,20 @@
     XCTAssertFalse([forest shouldPruneUnkeptDescendantsAtPath:[FPath pathWithString:@"qux"]]);
 }
 
+- (void) testEnumeratesRootMostPrunedPaths {
+    FPruneForest *forest = [FPruneForest empty];
+    forest = [forest prunePath:[FPath pathWithString:@"foo"]];
+    forest = [forest keepPath:[FPath pathWithString:@"foo/bar"]];
+    forest = [forest prunePath:[FPath pathWithString:@"foo/bar/baz"]];
+    forest = [forest pruneAll:[NSSet setWithArray:@[@"a", @"b"]] atPath:[FPath pathWithString:@"qux"]];
+    forest = [forest keepPath:[FPath pathWithString:@"quu"]];
+
+    NSMutableSet *pruned = [NSMutableSet set];
+    [forest enumeratePrunedPathsUsingBlock:^(FPath *path) {
+        [pruned addObject:[path toString]];
+    }];
+    XCTAssertEqualObjects(pruned, ([NSSet setWithArray:@[@"/foo", @"/qux/a", @"/qux/b"]]));
+}
+
 
 @end
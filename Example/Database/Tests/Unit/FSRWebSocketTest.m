@@ -0,0 +1,230 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+
+#include <zlib.h>
+
+#import "FSRWebSocket.h"
+
+@interface FSRWebSocket (Tests)
+- (BOOL)_openWithExtensions:(NSString *)extensions;
+- (void)_receiveData:(NSData *)data;
+- (NSData *)_compressedMessage:(NSData *)data;
+@end
+
+static const uint8_t kFFin = 0x80;
+static const uint8_t kFRsv1 = 0x40;
+static const uint8_t kFTextFrame = 0x1;
+static const uint8_t kFContinuationFrame = 0x0;
+
+/** Returns an unmasked frame, as the server sends them. */
+static NSData *FFrame(uint8_t flags, uint8_t opcode, NSData *payload) {
+    NSMutableData *frame = [NSMutableData data];
+    uint8_t header[4] = {(uint8_t)(flags | opcode)};
+    if (payload.length < 126) {
+        header[1] = (uint8_t)payload.length;
+        [frame appendBytes:header length:2];
+    } else {
+        header[1] = 126;
+        header[2] = (uint8_t)(payload.length >> 8);
+        header[3] = (uint8_t)payload.length;
+        [frame appendBytes:header length:4];
+    }
+    [frame appendData:payload];
+    return frame;
+}
+
+/** Deflates text into a stream of its own, ending it with a final block or with a sync flush minus its tail. */
+static NSData *FDeflate(NSString *text, int windowBits, BOOL finalBlock) {
+    NSData *input = [text dataUsingEncoding:NSUTF8StringEncoding];
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -windowBits, 8, Z_DEFAULT_STRATEGY);
+    NSMutableData *output = [NSMutableData dataWithLength:deflateBound(&stream, input.length) + 16];
+    stream.next_in = (Bytef *)input.bytes;
+    stream.avail_in = (uInt)input.length;
+    stream.next_out = (Bytef *)output.mutableBytes;
+    stream.avail_out = (uInt)output.length;
+    deflate(&stream, finalBlock ? Z_FINISH : Z_SYNC_FLUSH);
+    output.length = output.length - stream.avail_out - (finalBlock ? 0 : 4);
+    deflateEnd(&stream);
+    return output;
+}
+
+@interface FSRWebSocketTest : XCTestCase <FSRWebSocketDelegate>
+
+@end
+
+@implementation FSRWebSocketTest {
+    dispatch_queue_t _delegateQueue;
+    NSMutableArray *_messages;
+}
+
+- (void)setUp {
+    [super setUp];
+    _delegateQueue = dispatch_queue_create("FSRWebSocketTest", DISPATCH_QUEUE_SERIAL);
+    _messages = [NSMutableArray array];
+}
+
+- (void)webSocket:(FSRWebSocket *)webSocket didReceiveMessage:(id)message {
+    [_messages addObject:message];
+}
+
+- (FSRWebSocket *)socket {
+    NSURLRequest *request = [NSURLRequest requestWithURL:[NSURL URLWithString:@"ws://example.com/.ws"]];
+    FSRWebSocket *socket = [[FSRWebSocket alloc] initWithURLRequest:request];
+    socket.requestsPerMessageDeflate = YES;
+    socket.delegate = self;
+    [socket setDelegateDispatchQueue:_delegateQueue];
+    return socket;
+}
+
+- (FSRWebSocket *)openSocketWithExtensions:(NSString *)extensions {
+    FSRWebSocket *socket = [self socket];
+    XCTAssertTrue([socket _openWithExtensions:extensions]);
+    return socket;
+}
+
+/** Waits until the socket has handled the frames it read and delivered their messages. */
+- (void)drain:(FSRWebSocket *)socket {
+    for (int i = 0; i < 2; i++) {
+        [socket _receiveData:[NSData data]];
+        dispatch_sync(_delegateQueue, ^{});
+    }
+}
+
+- (void)testAcceptsPerMessageDeflate {
+    FSRWebSocket *socket = [self openSocketWithExtensions:@"permessage-deflate"];
+    XCTAssertTrue(socket.perMessageDeflateNegotiated);
+
+    socket = [self openSocketWithExtensions:@"permessage-deflate; server_no_context_takeover; "
+                                            @"client_no_context_takeover; client_max_window_bits=10"];
+    XCTAssertTrue(socket.perMessageDeflateNegotiated);
+}
+
+- (void)testAcceptsServerWindowSizesTheExtensionAllows {
+    for (NSString *bits in @[ @"8", @"9", @"15", @"\"12\"" ]) {
+        NSString *extensions = [@"permessage-deflate; server_max_window_bits=" stringByAppendingString:bits];
+        XCTAssertTrue([[self socket] _openWithExtensions:extensions], @"%@", bits);
+    }
+}
+
+- (void)testRejectsServerWindowSizesTheExtensionDoesNotAllow {
+    for (NSString *bits in @[ @"=0", @"=7", @"=16", @"=x", @"" ]) {
+        NSString *extensions = [@"permessage-deflate; server_max_window_bits" stringByAppendingString:bits];
+        XCTAssertFalse([[self socket] _openWithExtensions:extensions], @"%@", bits);
+    }
+}
+
+- (void)testRejectsExtensionsThatWereNotRequested {
+    XCTAssertFalse([[self socket] _openWithExtensions:@"x-webkit-deflate-frame"]);
+    XCTAssertFalse([[self socket] _openWithExtensions:@"permessage-deflate, permessage-deflate"]);
+    XCTAssertFalse([[self socket] _openWithExtensions:@"permessage-deflate; client_max_window_bits=16"]);
+
+    FSRWebSocket *socket = [self socket];
+    socket.requestsPerMessageDeflate = NO;
+    XCTAssertFalse([socket _openWithExtensions:@"permessage-deflate"]);
+}
+
+- (void)testDoesNotCompressWithClientWindowZlibCannotHonor {
+    FSRWebSocket *socket = [self openSocketWithExtensions:@"permessage-deflate; client_max_window_bits=8"];
+    XCTAssertNil([socket _compressedMessage:[@"hello hello hello" dataUsingEncoding:NSUTF8StringEncoding]]);
+
+    socket = [self openSocketWithExtensions:@"permessage-deflate; client_max_window_bits=9"];
+    XCTAssertNotNil([socket _compressedMessage:[@"hello hello hello" dataUsingEncoding:NSUTF8StringEncoding]]);
+}
+
+- (void)testRoundTripsCompressedMessages {
+    FSRWebSocket *socket = [self openSocketWithExtensions:@"permessage-deflate"];
+    NSArray<NSString *> *messages = @[ @"{\"t\":\"d\",\"d\":\"héllo héllo héllo\"}", @"{\"t\":\"d\",\"d\":\"héllo\"}" ];
+    for (NSString *message in messages) {
+        // The second message refers back to the first, since both sides keep their context.
+        NSData *compressed = [socket _compressedMessage:[message dataUsingEncoding:NSUTF8StringEncoding]];
+        XCTAssertNotNil(compressed);
+        [socket _receiveData:FFrame(kFFin | kFRsv1, kFTextFrame, compressed)];
+    }
+    [self drain:socket];
+
+    XCTAssertEqualObjects(_messages, messages);
+}
+
+- (void)testInflatesMessageCompressedWithSmallServerWindow {
+    FSRWebSocket *socket = [self openSocketWithExtensions:@"permessage-deflate; server_max_window_bits=9"];
+    NSString *message = @"abcabcabcabcabcabcabcabc";
+    [socket _receiveData:FFrame(kFFin | kFRsv1, kFTextFrame, FDeflate(message, 9, NO))];
+    [self drain:socket];
+
+    XCTAssertEqualObjects(_messages, @[ message ]);
+}
+
+- (void)testReassemblesFragmentedCompressedMessage {
+    FSRWebSocket *socket = [self openSocketWithExtensions:@"permessage-deflate"];
+    NSString *message = @"{\"t\":\"d\",\"d\":\"fragmented fragmented fragmented\"}";
+    NSData *compressed = FDeflate(message, MAX_WBITS, NO);
+    NSUInteger third = compressed.length / 3;
+
+    // Only the first frame of a compressed message has RSV1 set.
+    [socket _receiveData:FFrame(kFRsv1, kFTextFrame, [compressed subdataWithRange:NSMakeRange(0, third)])];
+    [socket _receiveData:FFrame(0, kFContinuationFrame, [compressed subdataWithRange:NSMakeRange(third, third)])];
+    [self drain:socket];
+    XCTAssertEqual(_messages.count, 0);
+
+    NSData *rest = [compressed subdataWithRange:NSMakeRange(2 * third, compressed.length - 2 * third)];
+    [socket _receiveData:FFrame(kFFin, kFContinuationFrame, rest)];
+    [self drain:socket];
+
+    XCTAssertEqualObjects(_messages, @[ message ]);
+}
+
+- (void)testInflatesDataAfterFinalBlock {
+    FSRWebSocket *socket = [self openSocketWithExtensions:@"permessage-deflate"];
+    NSMutableData *compressed = [FDeflate(@"first stream, ", MAX_WBITS, YES) mutableCopy];
+    [compressed appendData:FDeflate(@"second stream", MAX_WBITS, NO)];
+    [socket _receiveData:FFrame(kFFin | kFRsv1, kFTextFrame, compressed)];
+
+    // The next message starts a stream of its own too.
+    [socket _receiveData:FFrame(kFFin | kFRsv1, kFTextFrame, FDeflate(@"next message", MAX_WBITS, NO))];
+    [self drain:socket];
+
+    XCTAssertEqualObjects(_messages, (@[ @"first stream, second stream", @"next message" ]));
+}
+
+- (void)testRejectsRsv1OnContinuationFrame {
+    FSRWebSocket *socket = [self openSocketWithExtensions:@"permessage-deflate"];
+    NSData *compressed = FDeflate(@"continued with the wrong bits", MAX_WBITS, NO);
+    NSUInteger half = compressed.length / 2;
+
+    [socket _receiveData:FFrame(kFRsv1, kFTextFrame, [compressed subdataWithRange:NSMakeRange(0, half)])];
+    NSData *rest = [compressed subdataWithRange:NSMakeRange(half, compressed.length - half)];
+    [socket _receiveData:FFrame(kFFin | kFRsv1, kFContinuationFrame, rest)];
+    [self drain:socket];
+
+    XCTAssertEqual(_messages.count, 0);
+    XCTAssertNotEqual(socket.readyState, SR_OPEN);
+}
+
+- (void)testRejectsRsv1WithoutPerMessageDeflate {
+    FSRWebSocket *socket = [self openSocketWithExtensions:nil];
+    [socket _receiveData:FFrame(kFFin | kFRsv1, kFTextFrame, FDeflate(@"not negotiated", MAX_WBITS, NO))];
+    [self drain:socket];
+
+    XCTAssertEqual(_messages.count, 0);
+    XCTAssertNotEqual(socket.readyState, SR_OPEN);
+}
+
+@end
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "FSyncTree.h"
+#import "FWriteTree.h"
+#import "FListenProvider.h"
+#import "FQuerySpec.h"
+#import "FQueryParams.h"
+#import "FPathIndex.h"
+#import "FCompoundWrite.h"
+#import "FEmptyNode.h"
+#import "FEventRaiser.h"
+#import "FValueEventRegistration.h"
+#import "FChildEventRegistration.h"
+#import "FSnapshotUtilities.h"
+#import "FClock.h"
+#import "FTestHelpers.h"
+
+/**
+ * Benchmarks of the paths a write takes until its events are raised. Like other XCTest performance tests they only
+ * report timings, so compare the results of runs with different numbers of pending writes to see how they scale.
+ */
+@interface FSyncTreeBenchmarkTests : XCTestCase
+
+@end
+
+static const NSInteger kFPendingWrites = 500;
+static const NSInteger kFChildren = 1000;
+
+@implementation FSyncTreeBenchmarkTests
+
+- (FSyncTree *)syncTree {
+    FListenProvider *listenProvider = [[FListenProvider alloc] init];
+    listenProvider.startListening = ^(FQuerySpec *query, NSNumber *tagId, id<FSyncTreeHash> hash, fbt_nsarray_nsstring onComplete) {
+        return @[];
+    };
+    listenProvider.stopListening = ^(FQuerySpec *query, NSNumber *tagId) {
+    };
+    return [[FSyncTree alloc] initWithListenProvider:listenProvider];
+}
+
+- (id<FEventRegistration>)valueRegistration {
+    return [[FValueEventRegistration alloc] initWithRepo:nil handle:0 callback:^(FIRDataSnapshot *snapshot) {
+    } cancelCallback:nil];
+}
+
+- (id<FNode>)childrenWithCount:(NSInteger)count {
+    NSMutableDictionary *children = [NSMutableDictionary dictionaryWithCapacity:count];
+    for (NSInteger i = 0; i < count; i++) {
+        children[[NSString stringWithFormat:@"child-%ld", (long)i]] = @{@"score": @(i), @"name": @"benchmark"};
+    }
+    return NODE(children);
+}
+
+- (void)testBenchmarkApplyUserOverwritesWithPendingWrites {
+    [self measureBlock:^{
+        FSyncTree *syncTree = [self syncTree];
+        [syncTree addEventRegistration:[self valueRegistration] forQuery:[FQuerySpec defaultQueryAtPath:PATH(@"list")]];
+        for (NSInteger i = 0; i < kFPendingWrites; i++) {
+            FPath *path = [PATH(@"list") childFromString:[NSString stringWithFormat:@"child-%ld", (long)i]];
+            [syncTree applyUserOverwriteAtPath:path newData:NODE(@(i)) writeId:i isVisible:YES];
+        }
+    }];
+}
+
+- (void)testBenchmarkAckUserWritesWithPendingWrites {
+    [self measureBlock:^{
+        FSyncTree *syncTree = [self syncTree];
+        [syncTree addEventRegistration:[self valueRegistration] forQuery:[FQuerySpec defaultQueryAtPath:PATH(@"list")]];
+        for (NSInteger i = 0; i < kFPendingWrites; i++) {
+            FPath *path = [PATH(@"list") childFromString:[NSString stringWithFormat:@"child-%ld", (long)i]];
+            [syncTree applyUserOverwriteAtPath:path newData:NODE(@(i)) writeId:i isVisible:YES];
+        }
+        for (NSInteger i = 0; i < kFPendingWrites; i++) {
+            [syncTree ackUserWriteWithWriteId:i revert:NO persist:NO clock:[FSystemClock clock]];
+        }
+    }];
+}
+
+- (void)testBenchmarkWriteTreeShadowingWithPendingWrites {
+    FWriteTree *writeTree = [[FWriteTree alloc] init];
+    for (NSInteger i = 0; i < kFPendingWrites; i++) {
+        FPath *path = [PATH(@"list") childFromString:[NSString stringWithFormat:@"child-%ld", (long)i]];
+        if (i % 2 == 0) {
+            [writeTree addOverwriteAtPath:path newData:NODE(@(i)) writeId:i isVisible:YES];
+        } else {
+            FCompoundWrite *merge = [FCompoundWrite compoundWriteWithValueDictionary:@{@"score": @(i)}];
+            [writeTree addMergeAtPath:path changedChildren:merge writeId:i];
+        }
+    }
+    id<FNode> serverCache = [self childrenWithCount:kFPendingWrites];
+
+    [self measureBlock:^{
+        for (NSInteger i = 0; i < kFPendingWrites; i++) {
+            FPath *path = [PATH(@"list") childFromString:[NSString stringWithFormat:@"child-%ld", (long)i]];
+            [writeTree shadowingWriteAtPath:path];
+        }
+        [writeTree calculateCompleteEventCacheAtPath:PATH(@"list")
+                                 completeServerCache:serverCache
+                                     excludeWriteIds:nil
+                                 includeHiddenWrites:NO];
+    }];
+}
+
+- (void)testBenchmarkViewProcessorServerMergesOnLimitedQuery {
+    FQueryParams *params = [[[FQueryParams defaultInstance] orderBy:[[FPathIndex alloc] initWithPath:PATH(@"score")]]
+                            limitToLast:50];
+    FQuerySpec *query = [[FQuerySpec alloc] initWithPath:PATH(@"list") params:params];
+    id<FNode> children = [self childrenWithCount:kFChildren];
+
+    [self measureBlock:^{
+        FSyncTree *syncTree = [self syncTree];
+        [syncTree addEventRegistration:[self valueRegistration] forQuery:[FQuerySpec defaultQueryAtPath:PATH(@"list")]];
+        [syncTree addEventRegistration:[self valueRegistration] forQuery:query];
+        [syncTree applyServerOverwriteAtPath:PATH(@"list") newData:children];
+        for (NSInteger i = 0; i < kFChildren; i += 10) {
+            NSString *key = [NSString stringWithFormat:@"child-%ld/score", (long)i];
+            FCompoundWrite *merge = [FCompoundWrite compoundWriteWithValueDictionary:@{key: @(kFChildren - i)}];
+            [syncTree applyServerMergeAtPath:PATH(@"list") changedChildren:merge];
+        }
+    }];
+}
+
+- (void)testBenchmarkEventRaising {
+    dispatch_queue_t queue = dispatch_queue_create("FSyncTreeBenchmarkTests", DISPATCH_QUEUE_SERIAL);
+    FEventRaiser *eventRaiser = [[FEventRaiser alloc] initWithQueue:queue];
+    FSyncTree *syncTree = [self syncTree];
+    [syncTree addEventRegistration:[self valueRegistration] forQuery:[FQuerySpec defaultQueryAtPath:PATH(@"list")]];
+    fbt_void_datasnapshot_nsstring childAdded = ^(FIRDataSnapshot *snapshot, NSString *prevName) {
+    };
+    FChildEventRegistration *childRegistration =
+        [[FChildEventRegistration alloc] initWithRepo:nil
+                                               handle:1
+                                            callbacks:@{@(FIRDataEventTypeChildAdded): [childAdded copy]}
+                                       cancelCallback:nil];
+    [syncTree addEventRegistration:childRegistration forQuery:[FQuerySpec defaultQueryAtPath:PATH(@"list")]];
+    NSArray *events = [syncTree applyServerOverwriteAtPath:PATH(@"list") newData:[self childrenWithCount:kFChildren]];
+    XCTAssertGreaterThan(events.count, (NSUInteger)kFChildren);
+
+    [self measureBlock:^{
+        [eventRaiser raiseEvents:events];
+        dispatch_sync(queue, ^{
+        });
+    }];
+}
+
+@end
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+
+#import "FRepoInfo.h"
+#import "FUtilities.h"
+#import "FWebSocketConnection.h"
+
+@interface FWebSocketConnection (Tests)
+- (void)afterPendingMessages:(void (^)(void))block;
+@end
+
+/**
+ * Feeds frames to a connection that is never opened, the way its websocket would, and records what it delivers.
+ */
+@interface FWebSocketConnectionTest : XCTestCase <FWebSocketDelegate>
+
+@end
+
+@implementation FWebSocketConnectionTest {
+    dispatch_queue_t _queue;
+    FWebSocketConnection *_connection;
+    NSMutableArray<NSDictionary *> *_messages;
+    // How many messages had been delivered when the connection reported it was closed, or -1 if it hasn't yet.
+    NSInteger _messagesBeforeDisconnect;
+    XCTestExpectation *_disconnected;
+}
+
+- (void)setUp {
+    [super setUp];
+    _queue = dispatch_queue_create("FWebSocketConnectionTest", DISPATCH_QUEUE_SERIAL);
+    FRepoInfo *repoInfo = [[FRepoInfo alloc] initWithHost:@"example.com" isSecure:NO withNamespace:@"default"];
+    _connection = [[FWebSocketConnection alloc] initWith:repoInfo andQueue:_queue lastSessionID:nil];
+    _connection.delegate = self;
+    _messages = [NSMutableArray array];
+    _messagesBeforeDisconnect = -1;
+}
+
+- (void)onMessage:(FWebSocketConnection *)fwebSocket withMessage:(NSDictionary *)message {
+    [_messages addObject:message ?: (id)[NSNull null]];
+}
+
+- (void)onDisconnect:(FWebSocketConnection *)fwebSocket wasEverConnected:(BOOL)everConnected {
+    _messagesBeforeDisconnect = _messages.count;
+    [_disconnected fulfill];
+}
+
+- (void)receiveFrames:(NSArray<NSString *> *)frames {
+    dispatch_sync(_queue, ^{
+        for (NSString *frame in frames) {
+            [self->_connection webSocket:nil didReceiveMessage:frame];
+        }
+    });
+}
+
+/** Waits until every message received so far has been delivered. */
+- (void)waitForPendingMessages {
+    XCTestExpectation *delivered = [self expectationWithDescription:@"delivered"];
+    dispatch_sync(_queue, ^{
+        [self->_connection afterPendingMessages:^{
+            [delivered fulfill];
+        }];
+    });
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+}
+
+- (void)testReassemblesMultiByteCharactersAcrossFrames {
+    // Two- and three-byte characters and a surrogate pair end up on both sides of each frame boundary.
+    NSString *value = @"héllo 日本語 \U0001F600 wörld";
+    NSArray<NSString *> *frames = @[ @"3", @"{\"t\":\"d\",\"d\":\"hé", @"llo 日本語 \U0001F600",
+                                     @" wörld\"}" ];
+    [self receiveFrames:frames];
+    [self waitForPendingMessages];
+
+    XCTAssertEqualObjects(_messages, (@[ @{@"t" : @"d", @"d" : value} ]));
+}
+
+- (void)testReceivesMessageAfterMultiByteMessage {
+    [self receiveFrames:@[ @"2", @"{\"v\":\"éé", @"é\"}", @"{\"v\":1}" ]];
+    [self waitForPendingMessages];
+
+    XCTAssertEqualObjects(_messages, (@[ @{@"v" : @"ééé"}, @{@"v" : @1} ]));
+}
+
+/** Returns a message big enough to take a while to decode, split into frames. */
+- (NSArray<NSString *> *)framesOfLargeMessageWithValue:(NSInteger)value {
+    NSMutableString *message = [NSMutableString stringWithFormat:@"{\"v\":%ld,\"d\":[", (long)value];
+    for (int i = 0; i < 20000; i++) {
+        [message appendFormat:@"%@{\"k\":\"key%d\",\"n\":%d}", i ? @"," : @"", i, i];
+    }
+    [message appendString:@"]}"];
+
+    NSArray<NSString *> *segments = [FUtilities splitString:message intoMaxSize:16384];
+    NSMutableArray<NSString *> *frames = [NSMutableArray arrayWithObject:[@(segments.count) stringValue]];
+    [frames addObjectsFromArray:segments];
+    return frames;
+}
+
+- (void)testDeliversMessagesInTheOrderTheyWereReceived {
+    // Small messages that decode quickly are interleaved with large ones that don't.
+    NSMutableArray<NSString *> *frames = [NSMutableArray array];
+    for (NSInteger i = 0; i < 10; i++) {
+        if (i % 3 == 0) {
+            [frames addObjectsFromArray:[self framesOfLargeMessageWithValue:i]];
+        } else {
+            [frames addObject:[NSString stringWithFormat:@"{\"v\":%ld}", (long)i]];
+        }
+    }
+    [self receiveFrames:frames];
+    [self waitForPendingMessages];
+
+    XCTAssertEqual(_messages.count, 10);
+    for (NSUInteger i = 0; i < _messages.count; i++) {
+        XCTAssertEqualObjects(_messages[i][@"v"], @(i));
+    }
+}
+
+- (void)testReportsCloseAfterPendingMessages {
+    _disconnected = [self expectationWithDescription:@"disconnected"];
+    NSMutableArray<NSString *> *frames = [NSMutableArray arrayWithObject:@"{\"v\":0}"];
+    [frames addObjectsFromArray:[self framesOfLargeMessageWithValue:1]];
+    dispatch_sync(_queue, ^{
+        for (NSString *frame in frames) {
+            [self->_connection webSocket:nil didReceiveMessage:frame];
+        }
+        // The large message is still being decoded when the websocket closes.
+        [self->_connection webSocket:nil didCloseWithCode:1000 reason:@"done" wasClean:YES];
+    });
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    XCTAssertEqual(_messagesBeforeDisconnect, 2);
+    XCTAssertEqualObjects(_messages[1][@"v"], @1);
+}
+
+- (void)testReportsFailureAfterPendingMessages {
+    _disconnected = [self expectationWithDescription:@"disconnected"];
+    NSArray<NSString *> *frames = [self framesOfLargeMessageWithValue:0];
+    dispatch_sync(_queue, ^{
+        for (NSString *frame in frames) {
+            [self->_connection webSocket:nil didReceiveMessage:frame];
+        }
+        [self->_connection webSocket:nil didFailWithError:[NSError errorWithDomain:@"test" code:1 userInfo:nil]];
+    });
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+
+    XCTAssertEqual(_messagesBeforeDisconnect, 1);
+}
+
+- (void)testDropsMessageWithFrameThatCannotBeEncoded {
+    unichar loneSurrogate = 0xD83D;
+    NSString *invalid = [NSString stringWithFormat:@"é%@\"}", [NSString stringWithCharacters:&loneSurrogate
+                                                                                         length:1]];
+    [self receiveFrames:@[ @"2", @"{\"v\":\"", invalid ]];
+    [self waitForPendingMessages];
+
+    XCTAssertEqual(_messages.count, 0);
+}
+
+@end
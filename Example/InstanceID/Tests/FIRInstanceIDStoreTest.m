@@ -161,6 +161,34 @@ static NSString *const kFIRInstanceIDAPNSTokenKey = @"APNSTuple";
   [self waitForExpectationsWithTimeout:1 handler:nil];
 }
 
+/**
+ *  Tests that the token infos are read from the Keychain once and then served from memory.
+ */
+- (void)testTokenInfosAreReadFromKeychainOnce {
+  FIRInstanceIDTokenInfo *tokenInfo =
+      [[FIRInstanceIDTokenInfo alloc] initWithAuthorizedEntity:kAuthorizedEntity
+                                                         scope:kScope
+                                                         token:kToken
+                                                    appVersion:@"1.0"
+                                                 firebaseAppID:@"firebaseAppID"];
+  FIRInstanceIDFakeKeychain *fakeKeychain = [[FIRInstanceIDFakeKeychain alloc] init];
+  [fakeKeychain setData:[NSKeyedArchiver archivedDataWithRootObject:tokenInfo]
+             forService:[NSString stringWithFormat:@"%@:%@", kAuthorizedEntity, kScope]
+          accessibility:NULL
+                account:FIRInstanceIDAppIdentifier()
+                handler:nil];
+  FIRInstanceIDTokenStore *tokenStore =
+      [[FIRInstanceIDTokenStore alloc] initWithKeychain:fakeKeychain];
+
+  XCTAssertEqual([tokenStore cachedTokenInfos].count, 1);
+  // Reading from the Keychain is no longer needed.
+  fakeKeychain.cannotReadFromKeychain = YES;
+  XCTAssertEqualObjects([tokenStore tokenInfoWithAuthorizedEntity:kAuthorizedEntity
+                                                            scope:kScope].token,
+                        kToken);
+  XCTAssertEqual([tokenStore cachedTokenInfos].count, 1);
+}
+
 /**
  *  Tests that a checkin authentication ID can be stored in the FIRInstanceIDStore.
  */
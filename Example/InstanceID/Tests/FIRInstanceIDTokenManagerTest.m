@@ -176,6 +176,70 @@ static NSString *const kNewAPNSTokenString = @"newAPNSData";
   [self waitForExpectationsWithTimeout:1 handler:nil];
 }
 
+/**
+ *  Tests that concurrent fetches of the same token with the same options share one operation.
+ */
+- (void)testConcurrentFetchesOfSameTokenAreCoalesced {
+  XCTestExpectation *firstExpectation =
+      [self expectationWithDescription:@"First token handler invoked."];
+  XCTestExpectation *secondExpectation =
+      [self expectationWithDescription:@"Second token handler invoked."];
+
+  NSDictionary *tokenOptions = [NSDictionary dictionary];
+
+  // Create a fake operation that always returns success
+  FIRInstanceIDTokenFetchOperation *operation =
+      [[FIRInstanceIDTokenFetchOperation alloc] initWithAuthorizedEntity:kAuthorizedEntity
+                                                                   scope:kScope
+                                                                 options:tokenOptions
+                                                      checkinPreferences:self.fakeCheckin
+                                                                 keyPair:[OCMArg any]];
+  id mockOperation = OCMPartialMock(operation);
+  [[[mockOperation stub] andDo:^(NSInvocation *invocation) {
+    [invocation.target finishWithResult:FIRInstanceIDTokenOperationSucceeded
+                                  token:kToken
+                                  error:nil];
+  }] performTokenOperation];
+
+  // Return our fake operation when asked for an operation. Should the second fetch not be
+  // coalesced, adding the same operation to the queue a second time would raise.
+  __block NSInteger operationCount = 0;
+  [[[self.mockTokenManager stub] andDo:^(NSInvocation *invocation) {
+    operationCount++;
+    __unsafe_unretained FIRInstanceIDTokenFetchOperation *returnedOperation = operation;
+    [invocation setReturnValue:&returnedOperation];
+  }] createFetchOperationWithAuthorizedEntity:[OCMArg any]
+                                        scope:[OCMArg any]
+                                      options:[OCMArg any]
+                                      keyPair:[OCMArg any]];
+
+  [self.tokenManager fetchNewTokenWithAuthorizedEntity:kAuthorizedEntity
+                                                 scope:kScope
+                                               keyPair:[OCMArg any]
+                                               options:tokenOptions
+                                               handler:^(NSString *token, NSError *error) {
+                                                 XCTAssertEqualObjects(token, kToken);
+                                                 XCTAssertNil(error);
+                                                 [firstExpectation fulfill];
+                                               }];
+  [self.tokenManager fetchNewTokenWithAuthorizedEntity:kAuthorizedEntity
+                                                 scope:kScope
+                                               keyPair:[OCMArg any]
+                                               options:tokenOptions
+                                               handler:^(NSString *token, NSError *error) {
+                                                 // Keep 'operation' alive, so it's not
+                                                 // prematurely destroyed
+                                                 XCTAssertNotNil(operation);
+                                                 XCTAssertNotNil(mockOperation);
+                                                 XCTAssertEqualObjects(token, kToken);
+                                                 XCTAssertNil(error);
+                                                 [secondExpectation fulfill];
+                                               }];
+
+  [self waitForExpectationsWithTimeout:1 handler:nil];
+  XCTAssertEqual(operationCount, 1);
+}
+
 /**
  *  Tests that when a new InstanceID token is fetched from the server but unsuccessfully
  *  saved on the client we should return an error instead of the fetched token.
@@ -56,9 +56,13 @@ static NSString *const kTopicToSubscribeTo = @"/topics/abcdef/hello-world";
 @property(nonatomic, readwrite, assign) int64_t lastDisconnectedTimestamp;
 @property(nonatomic, readwrite, assign) NSUInteger subscribeRetryCount;
 @property(nonatomic, readwrite, assign) NSUInteger connectRetryCount;
+@property(nonatomic, readwrite, assign) int64_t connectRetryTimestamp;
+@property(nonatomic, readwrite, assign) GULReachabilityStatus connectRetryReachabilityStatus;
 
 - (NSTimeInterval)connectionTimeoutInterval;
 - (void)setupConnection;
+- (void)tryToConnect;
+- (void)tryToConnectAfterBackoff;
 
 @end
 
@@ -274,6 +278,34 @@ static NSString *const kTopicToSubscribeTo = @"/topics/abcdef/hello-world";
                                }];
 }
 
+- (void)testConnectWaitsForBackoffOnSameNetwork {
+  [[[self.mockReachability stub]
+      andReturnValue:@(kGULReachabilityViaWifi)] reachabilityStatus];
+  self.client.connectRetryReachabilityStatus = kGULReachabilityViaWifi;
+  self.client.connectRetryTimestamp = FIRMessagingCurrentTimestampInMilliseconds() + 60 * 1000;
+
+  // The attempt is deferred to the end of the backoff instead.
+  [[self.mockClient reject] tryToConnect];
+  [self.client tryToConnectAfterBackoff];
+  OCMVerifyAll(self.mockClient);
+
+  [NSObject cancelPreviousPerformRequestsWithTarget:self.client];
+}
+
+- (void)testConnectResetsBackoffOnNetworkChange {
+  [[[self.mockReachability stub]
+      andReturnValue:@(kGULReachabilityViaCellular)] reachabilityStatus];
+  self.client.connectRetryReachabilityStatus = kGULReachabilityViaWifi;
+  self.client.connectRetryTimestamp = FIRMessagingCurrentTimestampInMilliseconds() + 60 * 1000;
+  self.client.connectRetryCount = 5;
+
+  [[self.mockClient expect] tryToConnect];
+  [self.client tryToConnectAfterBackoff];
+  OCMVerifyAll(self.mockClient);
+  XCTAssertEqual(self.client.connectRetryCount, 0u);
+  XCTAssertEqual(self.client.connectRetryTimestamp, 0);
+}
+
 #pragma mark - Private Helpers
 
 - (void)setupFakeConnectionWithClass:(Class)connectionClass
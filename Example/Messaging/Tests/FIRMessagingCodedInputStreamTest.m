@@ -76,6 +76,21 @@
   XCTAssertNil([stream readDataWithLength:length]);
 }
 
+- (void)testReadingDataWithoutCopying {
+  NSData *sampleData = [[self class] sampleData2];
+  FIRMessagingCodedInputStream *stream =
+      [[FIRMessagingCodedInputStream alloc] initWithData:sampleData];
+  int8_t tag;
+  XCTAssertTrue([stream readTag:&tag]);
+  int32_t length;
+  XCTAssertTrue([stream readLength:&length]);
+
+  NSData *data = [stream readDataNoCopyWithLength:length];
+  XCTAssertTrue([[[self class] packetDataForSampleData2] isEqualToData:data]);
+  XCTAssertEqual(data.bytes, (const uint8_t *)sampleData.bytes + stream.offset - length);
+  XCTAssertNil([stream readDataNoCopyWithLength:1]);
+}
+
 + (NSData *)sampleData1 {
   // tag = 2,
   // length = 4,
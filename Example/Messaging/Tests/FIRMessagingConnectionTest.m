@@ -16,6 +16,7 @@
 
 #import <XCTest/XCTest.h>
 
+#import <GoogleUtilities/GULUserDefaults.h>
 #import <OCMock/OCMock.h>
 
 #import "Protos/GtalkCore.pbobjc.h"
@@ -24,12 +25,17 @@
 #import "FIRMessagingConnection.h"
 #import "FIRMessagingDataMessageManager.h"
 #import "FIRMessagingFakeConnection.h"
+#import "FIRMessagingHeartbeatInterval.h"
 #import "FIRMessagingRmqManager.h"
 #import "FIRMessagingSecureSocket.h"
 #import "FIRMessagingUtilities.h"
 
 static NSString *const kDeviceAuthId = @"123456";
 static NSString *const kSecretToken = @"56789";
+static NSString *const kHeartbeatIntervalsSuiteName = @"com.messaging.test_heartbeatIntervals";
+
+static int32_t const kWiFiNetworkType = 1;
+static int32_t const kCellularNetworkType = 0;
 
 // used to verify if we are sending in the right proto or not.
 // set it to negative value to disable this check
@@ -364,6 +370,51 @@ static FIRMessagingProtoTag currentProtoSendTag;
   XCTAssertTrue(self.didSuccessfullySendData);
 }
 
+- (void)testHeartbeatIntervalGrowsUntilTimeout {
+  FIRMessagingHeartbeatInterval *intervals = [self heartbeatIntervals];
+  XCTAssertEqual([intervals intervalForNetworkType:kWiFiNetworkType], 30.0);
+
+  // An ack right after other traffic proves nothing.
+  [intervals didReceiveAckAfterIdleInterval:0.1 networkType:kWiFiNetworkType];
+  XCTAssertEqual([intervals intervalForNetworkType:kWiFiNetworkType], 30.0);
+
+  [intervals didReceiveAckAfterIdleInterval:30.0 networkType:kWiFiNetworkType];
+  XCTAssertEqual([intervals intervalForNetworkType:kWiFiNetworkType], 60.0);
+  [intervals didReceiveAckAfterIdleInterval:60.0 networkType:kWiFiNetworkType];
+  XCTAssertEqual([intervals intervalForNetworkType:kWiFiNetworkType], 120.0);
+  // Each network type is probed separately.
+  XCTAssertEqual([intervals intervalForNetworkType:kCellularNetworkType], 30.0);
+
+  // Falls back to the last interval that was acked, and stays there.
+  [intervals didTimeOutAfterIdleInterval:120.0 networkType:kWiFiNetworkType];
+  XCTAssertEqual([intervals intervalForNetworkType:kWiFiNetworkType], 60.0);
+  [intervals didReceiveAckAfterIdleInterval:60.0 networkType:kWiFiNetworkType];
+  XCTAssertEqual([intervals intervalForNetworkType:kWiFiNetworkType], 60.0);
+
+  // A timeout after the settled interval shortens it.
+  [intervals didTimeOutAfterIdleInterval:60.0 networkType:kWiFiNetworkType];
+  XCTAssertEqual([intervals intervalForNetworkType:kWiFiNetworkType], 30.0);
+  [intervals didTimeOutAfterIdleInterval:30.0 networkType:kWiFiNetworkType];
+  XCTAssertEqual([intervals intervalForNetworkType:kWiFiNetworkType], 30.0);
+}
+
+- (void)testHeartbeatIntervalIsPersisted {
+  FIRMessagingHeartbeatInterval *intervals = [self heartbeatIntervals];
+  [intervals didReceiveAckAfterIdleInterval:30.0 networkType:kCellularNetworkType];
+
+  GULUserDefaults *userDefaults =
+      [[GULUserDefaults alloc] initWithSuiteName:kHeartbeatIntervalsSuiteName];
+  FIRMessagingHeartbeatInterval *reloaded =
+      [[FIRMessagingHeartbeatInterval alloc] initWithUserDefaults:userDefaults];
+  XCTAssertEqual([reloaded intervalForNetworkType:kCellularNetworkType], 60.0);
+}
+
+- (void)testHeartbeatIntervalOnUnknownNetwork {
+  FIRMessagingHeartbeatInterval *intervals = [self heartbeatIntervals];
+  [intervals didReceiveAckAfterIdleInterval:30.0 networkType:-1];
+  XCTAssertEqual([intervals intervalForNetworkType:-1], 30.0);
+}
+
 // TODO: Add tests for Selective/Stream ACK's
 
 #pragma mark - Stubs
@@ -439,6 +490,13 @@ static FIRMessagingProtoTag currentProtoSendTag;
   XCTAssertEqual(self.fakeConnection.inStreamId, 1);
 }
 
+- (FIRMessagingHeartbeatInterval *)heartbeatIntervals {
+  [[[NSUserDefaults alloc] init] removePersistentDomainForName:kHeartbeatIntervalsSuiteName];
+  GULUserDefaults *userDefaults =
+      [[GULUserDefaults alloc] initWithSuiteName:kHeartbeatIntervalsSuiteName];
+  return [[FIRMessagingHeartbeatInterval alloc] initWithUserDefaults:userDefaults];
+}
+
 - (void)setupSuccessfulLoginRequestWithConnection:(FIRMessagingConnection *)fakeConnection {
   [fakeConnection setupConnectionSocket];
 
@@ -20,6 +20,7 @@
 #import "FIRMessagingDefines.h"
 #import "FIRMessagingPendingTopicsList.h"
 #import "FIRMessagingTopicsCommon.h"
+#import "NSError+FIRMessaging.h"
 
 typedef void (^MockDelegateSubscriptionHandler)(NSString *topic,
                                                 FIRMessagingTopicAction action,
@@ -145,6 +146,91 @@ typedef void (^MockDelegateSubscriptionHandler)(NSString *topic,
   XCTAssertEqual(pendingTopics.numberOfBatches, 3);
 }
 
+- (void)testLatestActionForTopicSupersedesPendingAction {
+  FIRMessagingPendingTopicsList *pendingTopics = [[FIRMessagingPendingTopicsList alloc] init];
+  pendingTopics.delegate = self.notReadyDelegate;
+
+  [pendingTopics addOperationForTopic:@"/topics/0"
+                           withAction:FIRMessagingTopicActionSubscribe
+                           completion:nil];
+  [pendingTopics addOperationForTopic:@"/topics/0"
+                           withAction:FIRMessagingTopicActionUnsubscribe
+                           completion:nil];
+  XCTAssertEqual(pendingTopics.numberOfBatches, 1);
+}
+
+- (void)testSupersedingActionMergesAdjacentBatches {
+  FIRMessagingPendingTopicsList *pendingTopics = [[FIRMessagingPendingTopicsList alloc] init];
+  pendingTopics.delegate = self.notReadyDelegate;
+
+  XCTestExpectation *cancelledExpectation =
+      [self expectationWithDescription:@"Superseded unsubscription was cancelled"];
+  [pendingTopics addOperationForTopic:@"/topics/0"
+                           withAction:FIRMessagingTopicActionSubscribe
+                           completion:nil];
+  [pendingTopics addOperationForTopic:@"/topics/1"
+                           withAction:FIRMessagingTopicActionUnsubscribe
+                           completion:^(NSError *error) {
+                             XCTAssertEqual(error.code,
+                                            kFIRMessagingErrorCodePubSubOperationIsCancelled);
+                             [cancelledExpectation fulfill];
+                           }];
+  [pendingTopics addOperationForTopic:@"/topics/2"
+                           withAction:FIRMessagingTopicActionSubscribe
+                           completion:nil];
+  XCTAssertEqual(pendingTopics.numberOfBatches, 3);
+
+  [pendingTopics addOperationForTopic:@"/topics/1"
+                           withAction:FIRMessagingTopicActionSubscribe
+                           completion:nil];
+  XCTAssertEqual(pendingTopics.numberOfBatches, 1);
+
+  [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+- (void)testTopicUpdatesAreLimitedToMaxConcurrentTopicUpdates {
+  FIRMessagingPendingTopicsList *pendingTopics = [[FIRMessagingPendingTopicsList alloc] init];
+  pendingTopics.maxConcurrentTopicUpdates = 2;
+  pendingTopics.delegate = self.alwaysReadyDelegate;
+
+  __block NSInteger requestedUpdates = 0;
+  __block FIRMessagingTopicOperationCompletion firstCompletion;
+  self.alwaysReadyDelegate.subscriptionHandler =
+      ^(NSString *topic,
+        FIRMessagingTopicAction action,
+        FIRMessagingTopicOperationCompletion completion) {
+    // Never complete, except the first update when asked to
+    dispatch_async(dispatch_get_main_queue(), ^{
+      requestedUpdates++;
+      if (!firstCompletion) {
+        firstCompletion = completion;
+      }
+    });
+  };
+
+  for (NSInteger i = 0; i < 5; i++) {
+    NSString *topic = [NSString stringWithFormat:@"/topics/%ld", i];
+    [pendingTopics addOperationForTopic:topic
+                             withAction:FIRMessagingTopicActionSubscribe
+                             completion:nil];
+  }
+
+  XCTestExpectation *limitedExpectation =
+      [self expectationWithDescription:@"Only two topic updates were requested at a time"];
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5 * NSEC_PER_SEC)),
+                 dispatch_get_main_queue(), ^{
+    XCTAssertEqual(requestedUpdates, 2);
+    firstCompletion(nil);
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5 * NSEC_PER_SEC)),
+                   dispatch_get_main_queue(), ^{
+      XCTAssertEqual(requestedUpdates, 3);
+      [limitedExpectation fulfill];
+    });
+  });
+
+  [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
 - (void)testBatchSizeReductionAfterSuccessfulTopicUpdate {
   FIRMessagingPendingTopicsList *pendingTopics = [[FIRMessagingPendingTopicsList alloc] init];
   pendingTopics.delegate = self.alwaysReadyDelegate;
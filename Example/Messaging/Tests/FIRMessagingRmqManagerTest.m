@@ -93,6 +93,36 @@ static NSString *const kRmqDataMessageCategory = @"com.google.gcm-rmq-test";
   XCTAssertEqualObjects(validMessageID, remainingMessages[0]);
 }
 
+/**
+ *  Save and delete s2d messages in nested batches of writes. Everything written in the batches
+ *  should be persisted once the outermost batch ends.
+ */
+- (void)testBatchedS2dWrites {
+  [self.rmqManager beginBatchedWrites];
+  for (int i = 0; i < 250; i++) {
+    [self.rmqManager saveS2dMessageWithRmqId:[NSString stringWithFormat:@"message%d", i]];
+  }
+  [self.rmqManager beginBatchedWrites];
+  [self.rmqManager removeS2dIds:@[ @"message0", @"message1" ]];
+  [self.rmqManager endBatchedWrites];
+  [self.rmqManager endBatchedWrites];
+
+  // Reopen the store to read what was committed to disk.
+  self.rmqManager = [[FIRMessagingRmqManager alloc] initWithDatabaseName:kRmqDatabaseName];
+  NSArray *remainingMessages = [self.rmqManager unackedS2dRmqIds];
+  XCTAssertEqual(248, remainingMessages.count);
+  XCTAssertFalse([remainingMessages containsObject:@"message0"]);
+  XCTAssertTrue([remainingMessages containsObject:@"message249"]);
+
+  // More than one chunk of deletes.
+  NSMutableArray *removeMessages = [NSMutableArray array];
+  for (int i = 2; i < 250; i++) {
+    [removeMessages addObject:[NSString stringWithFormat:@"message%d", i]];
+  }
+  [self.rmqManager removeS2dIds:removeMessages];
+  XCTAssertEqual(0, [self.rmqManager unackedS2dRmqIds].count);
+}
+
 /**
  *  Test loading the RMQ-ID for d2s messages when there are no outgoing messages in the RMQ.
  */
@@ -58,6 +58,7 @@ typedef void(^FIRMessagingTestSocketConnectHandler)(void);
 @property(nonatomic, readwrite, strong) NSError *protoParseError;
 @property(nonatomic, readwrite, strong) GPBMessage *protoReceived;
 @property(nonatomic, readwrite, assign) int8_t protoTagReceived;
+@property(nonatomic, readwrite, assign) NSUInteger protosReceivedCount;
 
 @property(nonatomic, readwrite, copy) FIRMessagingTestSocketDisconnectHandler disconnectHandler;
 @property(nonatomic, readwrite, copy) FIRMessagingTestSocketConnectHandler connectHandler;
@@ -74,6 +75,7 @@ static BOOL isSafeToDisconnectSocket = NO;
   self.protoParseError = nil;
   self.protoReceived = nil;
   self.protoTagReceived = 0;
+  self.protosReceivedCount = 0;
 }
 
 - (void)tearDown {
@@ -141,6 +143,41 @@ static BOOL isSafeToDisconnectSocket = NO;
                                }];
 }
 
+- (void)testReceivingBurstOfDataMessages {
+  // a buffer large enough for all the messages to arrive in one read
+  [self createAndConnectSocketWithBufferSize:1024];
+  [self writeVersionToOutStream];
+  GtalkDataMessageStanza *message = [[GtalkDataMessageStanza alloc] init];
+  [message setCategory:@"socket-test-category"];
+  [message setFrom:@"socket-test-from"];
+  FIRMessagingSetLastStreamId(message, 2);
+  FIRMessagingSetRmq2Id(message, @"socket-test-rmq");
+
+  XCTestExpectation *dataExpectation = [self
+      expectationWithDescription:@"FIRMessaging socket should receive every data message"];
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(2 * NSEC_PER_SEC)),
+                 dispatch_get_main_queue(), ^{
+      for (int i = 0; i < 3; i++) {
+        [self.socket sendData:[message data]
+                      withTag:kFIRMessagingProtoTagDataMessageStanza
+                        rmqId:FIRMessagingGetRmq2Id(message)];
+      }
+  });
+
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(4 * NSEC_PER_SEC)),
+                 dispatch_get_main_queue(), ^{
+      XCTAssertEqual(self.protosReceivedCount, 3);
+      XCTAssertNil(self.protoParseError);
+      XCTAssertEqualObjects(FIRMessagingGetRmq2Id(self.protoReceived), @"socket-test-rmq");
+      [dataExpectation fulfill];
+  });
+
+  [self waitForExpectationsWithTimeout:5.0
+                               handler:^(NSError *error) {
+                                   XCTAssertNil(error);
+                               }];
+}
+
 #pragma mark - Writing
 
 - (void)testLoginRequest {
@@ -281,6 +318,7 @@ static BOOL isSafeToDisconnectSocket = NO;
   self.protoParseError = error;
   self.protoReceived = proto;
   self.protoTagReceived = tag;
+  self.protosReceivedCount++;
 }
 
 - (void)secureSocket:(FIRMessagingSecureSocket *)socket
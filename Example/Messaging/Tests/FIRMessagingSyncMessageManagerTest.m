@@ -190,6 +190,44 @@ static NSString *const kRmqSqliteFilename = @"rmq-sync-manager-test";
   XCTAssertNotNil([self.rmqManager querySyncMessageWithRmqID:noTTLMessageID]);
 }
 
+- (void)testExpiredMessagesArePurgedPeriodically {
+  NSString *expiredMessageID = @"fake-expired-rmqID";
+  NSDictionary *expiredMessage = @{
+    kFIRMessagingMessageIDKey : expiredMessageID,
+    kFIRMessagingMessageSyncMessageTTLKey : @(-86400),  // 1 day in past
+  };
+  XCTAssertFalse([self.syncMessageManager didReceiveAPNSSyncMessage:expiredMessage]);
+
+  for (int i = 0; i < 98; i++) {
+    NSDictionary *message = @{
+      kFIRMessagingMessageIDKey : [NSString stringWithFormat:@"fake-rmqID-%d", i],
+    };
+    XCTAssertFalse([self.syncMessageManager didReceiveAPNSSyncMessage:message]);
+  }
+  XCTAssertNotNil([self.rmqManager querySyncMessageWithRmqID:expiredMessageID]);
+
+  // The 100th new message triggers a purge.
+  XCTAssertFalse([self.syncMessageManager
+      didReceiveAPNSSyncMessage:@{kFIRMessagingMessageIDKey : @"fake-rmqID-last"}]);
+  XCTAssertNil([self.rmqManager querySyncMessageWithRmqID:expiredMessageID]);
+  XCTAssertNotNil([self.rmqManager querySyncMessageWithRmqID:@"fake-rmqID-last"]);
+}
+
+- (void)testPurgingMoreExpiredMessagesThanFitInABatch {
+  for (int i = 0; i < 1200; i++) {
+    XCTAssertTrue([self.rmqManager
+        saveSyncMessageWithRmqID:[NSString stringWithFormat:@"fake-expired-rmqID-%d", i]
+                  expirationTime:FIRMessagingCurrentTimestampInSeconds() - 86400
+                    apnsReceived:YES
+                     mcsReceived:NO
+                           error:nil]);
+  }
+  NSError *error;
+  XCTAssertEqual(1200, [self.rmqManager deleteExpiredOrFinishedSyncMessages:&error]);
+  XCTAssertNil(error);
+  XCTAssertNil([self.rmqManager querySyncMessageWithRmqID:@"fake-expired-rmqID-1199"]);
+}
+
 - (void)testDeleteFinishedMessages {
   NSString *unexpiredMessageID = @"fake-not-expired-rmqID";
   int64_t futureExpirationTime = 86400;  // 1 day in future
@@ -32,6 +32,9 @@ NS_ASSUME_NONNULL_BEGIN
 /// The user ID to be returned from `getUserID`.
 @property(nonatomic, nullable, strong, readonly) NSString *userID;
 
+/// The number of times `getToken` has been called.
+@property(atomic, assign, readonly) NSInteger getTokenCount;
+
 /// Default initializer.
 - (instancetype)initWithToken:(nullable NSString *)token
                        userID:(nullable NSString *)userID
@@ -35,6 +35,9 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (void)getTokenForcingRefresh:(BOOL)forceRefresh withCallback:(FIRTokenCallback)callback {
+  @synchronized(self) {
+    _getTokenCount++;
+  }
   callback(self.token, self.error);
 }
 
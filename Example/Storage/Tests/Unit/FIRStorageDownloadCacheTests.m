@@ -0,0 +1,132 @@
+// Copyright 2019 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "FIRStorageDownloadCache.h"
+#import "FIRStoragePath.h"
+
+@interface FIRStorageDownloadCacheTests : XCTestCase
+
+@property(strong, nonatomic) FIRStorageDownloadCache *cache;
+
+@end
+
+@implementation FIRStorageDownloadCacheTests
+
+- (void)setUp {
+  [super setUp];
+  NSString *directory =
+      [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+  NSURL *directoryURL = [NSURL fileURLWithPath:directory];
+  self.cache = [[FIRStorageDownloadCache alloc] initWithDirectoryURL:directoryURL maxSize:100];
+}
+
+- (void)tearDown {
+  [self.cache removeAllObjects];
+  [super tearDown];
+}
+
+- (FIRStoragePath *)pathForObject:(NSString *)object {
+  return [[FIRStoragePath alloc] initWithBucket:@"bucket" object:object];
+}
+
+- (void)testStoringData {
+  FIRStoragePath *path = [self pathForObject:@"path/to/object"];
+  NSData *data = [@"hello" dataUsingEncoding:NSUTF8StringEncoding];
+  [self.cache storeData:data forPath:path entityTag:@"\"etag\"" generation:@"42"];
+
+  XCTAssertEqualObjects([self.cache entityTagForPath:path], @"\"etag\"");
+  XCTAssertEqualObjects([self.cache generationForPath:path], @"42");
+  XCTAssertEqualObjects([self.cache dataForPath:path], data);
+  XCTAssertNil([self.cache dataForPath:[self pathForObject:@"path/to/other"]]);
+  XCTAssertEqual([self.cache totalSize], 5);
+}
+
+- (void)testStoringFile {
+  FIRStoragePath *path = [self pathForObject:@"object"];
+  NSData *data = [@"hello" dataUsingEncoding:NSUTF8StringEncoding];
+  NSString *filePath =
+      [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+  NSURL *fileURL = [NSURL fileURLWithPath:filePath];
+  XCTAssertTrue([data writeToURL:fileURL atomically:YES]);
+
+  [self.cache storeFileAtURL:fileURL forPath:path entityTag:@"\"etag\"" generation:nil];
+  [[NSFileManager defaultManager] removeItemAtURL:fileURL error:NULL];
+
+  XCTAssertNil([self.cache generationForPath:path]);
+  XCTAssertEqualObjects([NSData dataWithContentsOfURL:[self.cache fileURLForPath:path]], data);
+}
+
+- (void)testObjectsWithoutEntityTagAreNotCached {
+  FIRStoragePath *path = [self pathForObject:@"object"];
+  [self.cache storeData:[NSData data] forPath:path entityTag:nil generation:nil];
+  XCTAssertNil([self.cache entityTagForPath:path]);
+  XCTAssertNil([self.cache dataForPath:path]);
+}
+
+- (void)testObjectsLargerThanTheCacheAreNotCached {
+  FIRStoragePath *path = [self pathForObject:@"object"];
+  [self.cache storeData:[NSMutableData dataWithLength:101]
+                forPath:path
+              entityTag:@"\"etag\""
+             generation:nil];
+  XCTAssertNil([self.cache dataForPath:path]);
+}
+
+- (void)testLeastRecentlyUsedObjectsAreEvicted {
+  FIRStoragePath *first = [self pathForObject:@"first"];
+  FIRStoragePath *second = [self pathForObject:@"second"];
+  FIRStoragePath *third = [self pathForObject:@"third"];
+  NSDate *past = [NSDate dateWithTimeIntervalSinceNow:-60];
+
+  [self.cache storeData:[NSMutableData dataWithLength:40]
+                forPath:first
+              entityTag:@"\"1\""
+             generation:nil];
+  [[self.cache fileURLForPath:first] setResourceValue:past
+                                               forKey:NSURLContentModificationDateKey
+                                                error:NULL];
+  [self.cache storeData:[NSMutableData dataWithLength:40]
+                forPath:second
+              entityTag:@"\"2\""
+             generation:nil];
+  // Using the first object makes the second one the least recently used.
+  [self.cache dataForPath:first];
+  [[self.cache fileURLForPath:second] setResourceValue:past
+                                                forKey:NSURLContentModificationDateKey
+                                                 error:NULL];
+  [self.cache storeData:[NSMutableData dataWithLength:40]
+                forPath:third
+              entityTag:@"\"3\""
+             generation:nil];
+
+  XCTAssertNotNil([self.cache entityTagForPath:first]);
+  XCTAssertNil([self.cache entityTagForPath:second]);
+  XCTAssertNotNil([self.cache entityTagForPath:third]);
+  XCTAssertEqual([self.cache totalSize], 80);
+}
+
+- (void)testLoweringMaxSizeEvictsObjects {
+  FIRStoragePath *path = [self pathForObject:@"object"];
+  [self.cache storeData:[NSMutableData dataWithLength:40]
+                forPath:path
+              entityTag:@"\"etag\""
+             generation:nil];
+  self.cache.maxSize = 10;
+  XCTAssertNil([self.cache dataForPath:path]);
+  XCTAssertEqual([self.cache totalSize], 0);
+}
+
+@end
@@ -0,0 +1,112 @@
+// Copyright 2019 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "FIRStorageDownloadJournal.h"
+
+@interface FIRStorageDownloadJournalTests : XCTestCase
+
+@property(strong, nonatomic) NSURL *fileURL;
+
+@end
+
+@implementation FIRStorageDownloadJournalTests
+
+- (void)setUp {
+  [super setUp];
+  NSString *fileName = [NSString stringWithFormat:@"%@.bin", [NSUUID UUID].UUIDString];
+  NSString *filePath = [NSTemporaryDirectory() stringByAppendingPathComponent:fileName];
+  self.fileURL = [NSURL fileURLWithPath:filePath];
+}
+
+- (void)tearDown {
+  FIRStorageDownloadJournal *journal =
+      [[FIRStorageDownloadJournal alloc] initWithFileURL:self.fileURL
+                                             totalLength:0
+                                           segmentLength:1
+                                               entityTag:nil];
+  [journal removeWithPartialFile:YES];
+  [super tearDown];
+}
+
+- (FIRStorageDownloadJournal *)journalWithTotalLength:(int64_t)totalLength {
+  FIRStorageDownloadJournal *journal =
+      [[FIRStorageDownloadJournal alloc] initWithFileURL:self.fileURL
+                                             totalLength:totalLength
+                                           segmentLength:10
+                                               entityTag:@"\"etag\""];
+  [[NSFileManager defaultManager] createFileAtPath:journal.partialFileURL.path
+                                          contents:[NSMutableData dataWithLength:totalLength]
+                                        attributes:nil];
+  return journal;
+}
+
+- (void)testSegments {
+  FIRStorageDownloadJournal *journal = [self journalWithTotalLength:25];
+  XCTAssertEqual(journal.segmentCount, 3);
+  XCTAssertEqual([journal offsetOfSegment:2], 20);
+  XCTAssertEqual([journal lengthOfSegment:0], 10);
+  XCTAssertEqual([journal lengthOfSegment:2], 5);
+  XCTAssertEqual(journal.completedLength, 0);
+  XCTAssertFalse(journal.isComplete);
+}
+
+- (void)testCompletingSegments {
+  FIRStorageDownloadJournal *journal = [self journalWithTotalLength:25];
+  XCTAssertTrue([journal markSegmentCompleted:2 error:NULL]);
+  XCTAssertTrue([journal isSegmentCompleted:2]);
+  XCTAssertFalse([journal isSegmentCompleted:1]);
+  XCTAssertEqual(journal.completedLength, 5);
+
+  XCTAssertTrue([journal markSegmentCompleted:0 error:NULL]);
+  XCTAssertTrue([journal markSegmentCompleted:1 error:NULL]);
+  XCTAssertEqual(journal.completedLength, 25);
+  XCTAssertTrue(journal.isComplete);
+}
+
+- (void)testLoadingSavedJournal {
+  FIRStorageDownloadJournal *journal = [self journalWithTotalLength:25];
+  XCTAssertTrue([journal markSegmentCompleted:1 error:NULL]);
+
+  FIRStorageDownloadJournal *loaded = [FIRStorageDownloadJournal journalForFileURL:self.fileURL];
+  XCTAssertNotNil(loaded);
+  XCTAssertEqual(loaded.totalLength, 25);
+  XCTAssertEqual(loaded.segmentLength, 10);
+  XCTAssertEqualObjects(loaded.entityTag, @"\"etag\"");
+  XCTAssertTrue([loaded isSegmentCompleted:1]);
+  XCTAssertFalse([loaded isSegmentCompleted:0]);
+}
+
+- (void)testLoadingJournalWithMismatchedPartialFile {
+  FIRStorageDownloadJournal *journal = [self journalWithTotalLength:25];
+  XCTAssertTrue([journal save:NULL]);
+  [[NSFileManager defaultManager] createFileAtPath:journal.partialFileURL.path
+                                          contents:[NSData data]
+                                        attributes:nil];
+  XCTAssertNil([FIRStorageDownloadJournal journalForFileURL:self.fileURL]);
+}
+
+- (void)testRemovingJournal {
+  FIRStorageDownloadJournal *journal = [self journalWithTotalLength:25];
+  XCTAssertTrue([journal save:NULL]);
+  [journal removeWithPartialFile:NO];
+  XCTAssertNil([FIRStorageDownloadJournal journalForFileURL:self.fileURL]);
+  XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:journal.partialFileURL.path]);
+
+  [journal removeWithPartialFile:YES];
+  XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:journal.partialFileURL.path]);
+}
+
+@end
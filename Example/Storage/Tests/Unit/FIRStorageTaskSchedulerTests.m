@@ -0,0 +1,172 @@
+// Copyright 2019 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "FIRStorageTaskScheduler.h"
+
+@interface FIRStorageFakeTask : NSObject <FIRStorageScheduledTask>
+
+@property(nonatomic) FIRStorageTaskPriority priority;
+@property(nonatomic) NSUInteger startCount;
+@property(nonatomic) NSUInteger suspendCount;
+
+@end
+
+@implementation FIRStorageFakeTask
+
+- (instancetype)initWithPriority:(FIRStorageTaskPriority)priority {
+  self = [super init];
+  if (self) {
+    _priority = priority;
+  }
+  return self;
+}
+
+- (void)startTransfer {
+  self.startCount++;
+}
+
+- (void)suspendTransfer {
+  self.suspendCount++;
+}
+
+@end
+
+@interface FIRStorageTaskSchedulerTests : XCTestCase
+
+@property(strong, nonatomic) FIRStorageTaskScheduler *scheduler;
+
+@end
+
+@implementation FIRStorageTaskSchedulerTests
+
+- (void)setUp {
+  [super setUp];
+  self.scheduler = [[FIRStorageTaskScheduler alloc] initWithMaxConcurrentTransfers:2];
+}
+
+- (FIRStorageFakeTask *)scheduleTaskWithPriority:(FIRStorageTaskPriority)priority {
+  FIRStorageFakeTask *task = [[FIRStorageFakeTask alloc] initWithPriority:priority];
+  [self.scheduler scheduleTask:task];
+  return task;
+}
+
+- (void)testRunsAtMostMaxConcurrentTransfers {
+  FIRStorageFakeTask *task1 = [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+  FIRStorageFakeTask *task2 = [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+  FIRStorageFakeTask *task3 = [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+
+  XCTAssertEqual(self.scheduler.runningTaskCount, 2u);
+  XCTAssertTrue([self.scheduler isTaskRunning:task1]);
+  XCTAssertTrue([self.scheduler isTaskRunning:task2]);
+  XCTAssertFalse([self.scheduler isTaskRunning:task3]);
+  XCTAssertEqual(task3.startCount, 0u);
+}
+
+- (void)testSchedulingTwiceStartsOnce {
+  FIRStorageFakeTask *task = [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+  [self.scheduler scheduleTask:task];
+
+  XCTAssertEqual(task.startCount, 1u);
+  XCTAssertEqual(self.scheduler.runningTaskCount, 1u);
+}
+
+- (void)testRemovingTaskStartsNextTask {
+  FIRStorageFakeTask *task1 = [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+  [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+  FIRStorageFakeTask *task3 = [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+
+  [self.scheduler removeTask:task1];
+
+  XCTAssertTrue([self.scheduler isTaskRunning:task3]);
+  XCTAssertEqual(task3.startCount, 1u);
+  XCTAssertEqual(task1.suspendCount, 0u);
+}
+
+- (void)testQueuedTasksStartByPriority {
+  FIRStorageFakeTask *task1 = [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+  FIRStorageFakeTask *task2 = [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+  FIRStorageFakeTask *lowTask = [self scheduleTaskWithPriority:FIRStorageTaskPriorityLow];
+  FIRStorageFakeTask *defaultTask = [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+
+  [self.scheduler removeTask:task1];
+
+  XCTAssertTrue([self.scheduler isTaskRunning:defaultTask]);
+  XCTAssertFalse([self.scheduler isTaskRunning:lowTask]);
+
+  [self.scheduler removeTask:task2];
+
+  XCTAssertTrue([self.scheduler isTaskRunning:lowTask]);
+}
+
+- (void)testHighPriorityTaskSuspendsLatestLowerPriorityTask {
+  FIRStorageFakeTask *task1 = [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+  FIRStorageFakeTask *task2 = [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+  FIRStorageFakeTask *highTask = [self scheduleTaskWithPriority:FIRStorageTaskPriorityHigh];
+
+  XCTAssertTrue([self.scheduler isTaskRunning:highTask]);
+  XCTAssertTrue([self.scheduler isTaskRunning:task1]);
+  XCTAssertFalse([self.scheduler isTaskRunning:task2]);
+  XCTAssertEqual(task2.suspendCount, 1u);
+
+  [self.scheduler removeTask:highTask];
+
+  XCTAssertTrue([self.scheduler isTaskRunning:task2]);
+  XCTAssertEqual(task2.startCount, 2u);
+}
+
+- (void)testLowPriorityTasksWaitForHighPriorityTasks {
+  FIRStorageFakeTask *lowTask = [self scheduleTaskWithPriority:FIRStorageTaskPriorityLow];
+  XCTAssertTrue([self.scheduler isTaskRunning:lowTask]);
+
+  FIRStorageFakeTask *highTask = [self scheduleTaskWithPriority:FIRStorageTaskPriorityHigh];
+
+  // There is a free transfer, but the low priority task would take bandwidth from the other one.
+  XCTAssertFalse([self.scheduler isTaskRunning:lowTask]);
+  XCTAssertEqual(lowTask.suspendCount, 1u);
+
+  [self.scheduler removeTask:highTask];
+
+  XCTAssertTrue([self.scheduler isTaskRunning:lowTask]);
+}
+
+- (void)testChangingPriorityReordersTasks {
+  FIRStorageFakeTask *task1 = [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+  [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+  FIRStorageFakeTask *task3 = [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+
+  task3.priority = FIRStorageTaskPriorityHigh;
+  [self.scheduler taskDidChangePriority:task3];
+
+  XCTAssertTrue([self.scheduler isTaskRunning:task3]);
+  XCTAssertTrue([self.scheduler isTaskRunning:task1]);
+  XCTAssertEqual(self.scheduler.runningTaskCount, 2u);
+}
+
+- (void)testRaisingMaxConcurrentTransfersStartsQueuedTasks {
+  [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+  [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+  FIRStorageFakeTask *task3 = [self scheduleTaskWithPriority:FIRStorageTaskPriorityDefault];
+
+  self.scheduler.maxConcurrentTransfers = 3;
+
+  XCTAssertTrue([self.scheduler isTaskRunning:task3]);
+
+  self.scheduler.maxConcurrentTransfers = 0;
+
+  XCTAssertEqual(self.scheduler.runningTaskCount, 1u);
+}
+
+@end
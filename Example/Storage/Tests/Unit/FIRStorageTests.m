@@ -16,6 +16,7 @@
 
 #import "FIRComponentTestUtilities.h"
 #import "FIRStorageComponent.h"
+#import "FIRStorageDownloadCache.h"
 #import "FIRStorageReference.h"
 #import "FIRStorageReference_Private.h"
 #import "FIRStorage_Private.h"
@@ -212,4 +213,17 @@
   XCTAssertEqual([storage hash], [copy hash]);
 }
 
+- (void)testDownloadCacheIsOptIn {
+  FIRStorage *storage = [FIRStorage storageForApp:self.app URL:@"gs://foo-bar.appspot.com"];
+  XCTAssertEqual(storage.maxDownloadCacheSize, 0);
+  XCTAssertNil(storage.downloadCache);
+
+  storage.maxDownloadCacheSize = 1024;
+  XCTAssertNotNil(storage.downloadCache);
+  XCTAssertEqual(storage.downloadCache.maxSize, 1024);
+
+  storage.maxDownloadCacheSize = 0;
+  XCTAssertNil(storage.downloadCache);
+}
+
 @end
@@ -0,0 +1,81 @@
+// Copyright 2019 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import "FIRStorageUploadStream.h"
+
+@interface FIRStorageUploadStreamTests : XCTestCase
+
+@end
+
+@implementation FIRStorageUploadStreamTests
+
+- (FIRStorageUploadStream *)uploadStreamWithString:(NSString *)string {
+  NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+  return [[FIRStorageUploadStream alloc]
+      initWithInputStream:[NSInputStream inputStreamWithData:data]];
+}
+
+- (NSString *)stringWithData:(NSData *)data {
+  return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+}
+
+- (void)testReadingInChunks {
+  FIRStorageUploadStream *stream = [self uploadStreamWithString:@"hello world"];
+
+  NSData *chunk = [stream dataAtOffset:0 length:6 error:NULL];
+  XCTAssertEqualObjects([self stringWithData:chunk], @"hello ");
+  XCTAssertNil(stream.MD5Hash);
+
+  chunk = [stream dataAtOffset:6 length:6 error:NULL];
+  XCTAssertEqualObjects([self stringWithData:chunk], @"world");
+  XCTAssertTrue(stream.atEnd);
+  XCTAssertEqual(stream.readLength, 11);
+  XCTAssertEqualObjects(stream.MD5Hash, @"XrY7u+Ae7tCTyyK7j1rNww==");
+
+  chunk = [stream dataAtOffset:11 length:6 error:NULL];
+  XCTAssertEqual(chunk.length, 0);
+}
+
+- (void)testSendingAChunkAgain {
+  FIRStorageUploadStream *stream = [self uploadStreamWithString:@"hello world"];
+  XCTAssertNotNil([stream dataAtOffset:0 length:6 error:NULL]);
+
+  // The server only committed part of the chunk.
+  NSData *chunk = [stream dataAtOffset:2 length:6 error:NULL];
+  XCTAssertEqualObjects([self stringWithData:chunk], @"llo wo");
+  chunk = [stream dataAtOffset:8 length:6 error:NULL];
+  XCTAssertEqualObjects([self stringWithData:chunk], @"rld");
+  XCTAssertEqualObjects(stream.MD5Hash, @"XrY7u+Ae7tCTyyK7j1rNww==");
+}
+
+- (void)testCannotRewindPastCommittedBytes {
+  FIRStorageUploadStream *stream = [self uploadStreamWithString:@"hello world"];
+  XCTAssertNotNil([stream dataAtOffset:0 length:6 error:NULL]);
+  XCTAssertNotNil([stream dataAtOffset:6 length:6 error:NULL]);
+
+  NSError *error;
+  XCTAssertNil([stream dataAtOffset:0 length:6 error:&error]);
+  XCTAssertNotNil(error);
+}
+
+- (void)testCannotSkipAhead {
+  FIRStorageUploadStream *stream = [self uploadStreamWithString:@"hello world"];
+  NSError *error;
+  XCTAssertNil([stream dataAtOffset:4 length:6 error:&error]);
+  XCTAssertNotNil(error);
+}
+
+@end
@@ -122,4 +122,25 @@
   XCTAssertEqualObjects(encodedURL, @"/v0/b/bucket/o");
 }
 
+- (void)testUploadChunkSizeWithUnknownThroughput {
+  XCTAssertEqual([FIRStorageUtils uploadChunkSizeForThroughput:0 roundTripTime:0],
+                 8 * 1024 * 1024);
+}
+
+- (void)testUploadChunkSizeGrowsWithThroughput {
+  // 2 MB/s for 5 seconds, rounded down to a multiple of 256 KiB.
+  XCTAssertEqual([FIRStorageUtils uploadChunkSizeForThroughput:2000000 roundTripTime:0.05],
+                 38 * 256 * 1024);
+  XCTAssertEqual([FIRStorageUtils uploadChunkSizeForThroughput:100000 roundTripTime:0.05],
+                 1024 * 1024);
+  XCTAssertEqual([FIRStorageUtils uploadChunkSizeForThroughput:100000000 roundTripTime:0.05],
+                 64 * 1024 * 1024);
+}
+
+- (void)testUploadChunkSizeGrowsWithRoundTripTime {
+  // 1 MB/s for 50 round trips of 200ms.
+  XCTAssertEqual([FIRStorageUtils uploadChunkSizeForThroughput:1000000 roundTripTime:0.2],
+                 38 * 256 * 1024);
+}
+
 @end
@@ -106,6 +106,13 @@ static NSTimeInterval kMaxWaitTimeForBackoff = 16 * 60;
  */
 NSTimeInterval kTokenRefreshHeadStart  = 5 * 60;
 
+/** @var kTokenRefreshMaxJitter
+    @brief The maximum amount of time, on top of @c kTokenRefreshHeadStart, by which proactive
+        refresh is randomly moved earlier, so that the token is still valid while it is being
+        refreshed and clients sharing a clock do not all refresh at the same moment.
+ */
+static const uint32_t kTokenRefreshMaxJitter = 5 * 60;
+
 /** @var kUserKey
     @brief Key of user stored in the keychain. Prefixed with a Firebase app name.
  */
@@ -281,6 +288,13 @@ static NSMutableDictionary *gKeychainServiceNameForAppName;
    */
   FIRAuthKeychain *_keychain;
 
+  /** @var _keychainUpdateScheduled
+      @brief Whether saving the current user to the keychain has been scheduled by
+          @c scheduleKeychainUpdateWithUser: and has not happened yet.
+      @remarks Accessed only on the global work queue.
+   */
+  BOOL _keychainUpdateScheduled;
+
   /** @var _lastNotifiedUserToken
       @brief The user access (ID) token used last time for posting auth state changed notification.
    */
@@ -393,6 +407,9 @@ static NSMutableDictionary *gKeychainServiceNameForAppName;
           [FIRAuth keychainServiceNameForAppName:strongSelf->_firebaseAppName];
       if (keychainServiceName) {
         strongSelf->_keychain = [[FIRAuthKeychain alloc] initWithService:keychainServiceName];
+        // The user and the app credentials are both read below; read them from the keychain at
+        // once. Should this fail, they are read one by one instead.
+        [strongSelf->_keychain prefetchAllData:NULL];
         strongSelf.storedUserManager =
             [[FIRAuthStoredUserManager alloc] initWithServiceName:keychainServiceName];
       }
@@ -1564,6 +1581,35 @@ didReceiveRemoteNotification:(NSDictionary *)userInfo {
   return NO;
 }
 
+- (void)scheduleKeychainUpdateWithUser:(FIRUser *)user {
+  if (user != _currentUser) {
+    // No-op if the user is no longer signed in, as in updateKeychainWithUser:error:.
+    return;
+  }
+  [self possiblyPostAuthStateChangeNotification];
+  if (_keychainUpdateScheduled) {
+    return;
+  }
+  _keychainUpdateScheduled = YES;
+  __weak FIRAuth *weakSelf = self;
+  dispatch_async(FIRAuthGlobalWorkQueue(), ^{
+    FIRAuth *strongSelf = weakSelf;
+    if (!strongSelf) {
+      return;
+    }
+    strongSelf->_keychainUpdateScheduled = NO;
+    // A user that signed out or was replaced has already been saved or removed.
+    if (user != strongSelf->_currentUser) {
+      return;
+    }
+    NSError *error;
+    if (![strongSelf saveUser:user error:&error]) {
+      FIRLogWarning(kFIRLoggerAuth, @"I-AUT000017",
+                    @"Error saving the refreshed tokens of the user: %@", error);
+    }
+  });
+}
+
 /** @fn setKeychainServiceNameForApp
     @brief Sets the keychain service name global data for the particular app.
     @param app The Firebase app to set keychain service name for.
@@ -1597,12 +1643,13 @@ didReceiveRemoteNotification:(NSDictionary *)userInfo {
 
 /** @fn scheduleAutoTokenRefreshWithDelay:
     @brief Schedules a task to automatically refresh tokens on the current user. The token refresh
-        is scheduled 5 minutes before the  scheduled expiration time.
-    @remarks If the token expires in less than 5 minutes, schedule the token refresh immediately.
+        is scheduled between 5 and 10 minutes before the scheduled expiration time.
+    @remarks If the token expires before then, schedule the token refresh immediately.
  */
 - (void)scheduleAutoTokenRefresh {
   NSTimeInterval tokenExpirationInterval =
-      [_currentUser.accessTokenExpirationDate timeIntervalSinceNow] - kTokenRefreshHeadStart;
+      [_currentUser.accessTokenExpirationDate timeIntervalSinceNow] - kTokenRefreshHeadStart -
+      arc4random_uniform(kTokenRefreshMaxJitter);
   [self scheduleAutoTokenRefreshWithDelay:MAX(tokenExpirationInterval, 0) retry:NO];
 }
 
@@ -86,6 +86,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BOOL)updateKeychainWithUser:(FIRUser *)user error:(NSError *_Nullable *_Nullable)error;
 
+/** @fn scheduleKeychainUpdateWithUser:
+    @brief Updates the keychain for the given user after the current task on the global work queue,
+        along with any other update scheduled in the meantime.
+    @param user The user to be updated.
+    @remarks Called by @c FIRUser when its tokens are refreshed. Errors are only logged, as tokens
+        that could not be saved are simply refreshed again at next launch.
+ */
+- (void)scheduleKeychainUpdateWithUser:(FIRUser *)user;
+
 /** @fn internalSignInWithCredential:callback:
     @brief Convenience method for @c internalSignInAndRetrieveDataWithCredential:callback:
         This method doesn't return additional identity provider data.
@@ -63,9 +63,19 @@ NS_ASSUME_NONNULL_BEGIN
 
 /** @class FIRAuthKeychain
     @brief The utility class to manipulate data in iOS Keychain.
+    @remarks Data read or written through the @c FIRAuthStorage methods is cached in memory, so that
+        only its first read hits the keychain.
  */
 @interface FIRAuthKeychain : NSObject <FIRAuthStorage>
 
+/** @fn prefetchAllData:
+    @brief Reads all the items of the service from the keychain in a single query and caches them,
+        so that subsequent calls to @c dataForKey:error: are served from memory.
+    @param error The address to store any error that occurs during the process, if not NULL.
+    @return Whether the operation succeeded or not.
+ */
+- (BOOL)prefetchAllData:(NSError **_Nullable)error;
+
 /** @fn getItemWithQuery:error:
     @brief Get the item from keychain by given query.
     @param query The query to query the keychain.
@@ -41,6 +41,17 @@ NS_ASSUME_NONNULL_BEGIN
       @remarks This dictionary is to avoid unecessary keychain operations against legacy items.
    */
   NSMutableDictionary *_legacyEntryDeletedForKey;
+
+  /** @var _cachedDataForKey
+      @brief The data known to be in the keychain for each key, or @c NSNull if there is none.
+      @remarks This dictionary is to avoid reading the keychain more than once for the same key.
+   */
+  NSMutableDictionary<NSString *, id> *_cachedDataForKey;
+
+  /** @var _allDataPrefetched
+      @brief Indicates whether or not all the items of the service are in @c _cachedDataForKey.
+   */
+  BOOL _allDataPrefetched;
 }
 
 - (id<FIRAuthStorage>)initWithService:(NSString *)service {
@@ -49,25 +60,70 @@ NS_ASSUME_NONNULL_BEGIN
   if (self) {
     _service = [service copy];
     _legacyEntryDeletedForKey = [[NSMutableDictionary alloc] init];
+    _cachedDataForKey = [[NSMutableDictionary alloc] init];
   }
   return self;
 }
 
+- (BOOL)prefetchAllData:(NSError **_Nullable)error {
+  NSDictionary *query = @{
+    (__bridge id)kSecClass : (__bridge id)kSecClassGenericPassword,
+    (__bridge id)kSecAttrService : _service,
+    (__bridge id)kSecReturnData : @YES,
+    (__bridge id)kSecReturnAttributes : @YES,
+    (__bridge id)kSecMatchLimit : (__bridge id)kSecMatchLimitAll,
+  };
+  CFArrayRef result = NULL;
+  OSStatus status = SecItemCopyMatching((__bridge CFDictionaryRef)query, (CFTypeRef *)&result);
+  if (status != noErr && status != errSecItemNotFound) {
+    if (error) {
+      *error = [FIRAuthErrorUtils keychainErrorWithFunction:@"SecItemCopyMatching" status:status];
+    }
+    return NO;
+  }
+  NSArray *items = (__bridge_transfer NSArray *)result;
+  for (NSDictionary *item in items) {
+    NSString *account = item[(__bridge id)kSecAttrAccount];
+    NSData *data = item[(__bridge id)kSecValueData];
+    if (![account hasPrefix:kAccountPrefix] || !data) {
+      continue;
+    }
+    _cachedDataForKey[[account substringFromIndex:kAccountPrefix.length]] = data;
+  }
+  _allDataPrefetched = YES;
+  if (error) {
+    *error = nil;
+  }
+  return YES;
+}
+
 - (nullable NSData *)dataForKey:(NSString *)key error:(NSError **_Nullable)error {
   if (!key.length) {
     [NSException raise:NSInvalidArgumentException
                 format:@"%@", @"The key cannot be nil or empty."];
     return nil;
   }
-  NSData *data = [self itemWithQuery:[self genericPasswordQueryWithKey:key] error:error];
-  if (error && *error) {
-    return nil;
+  id cachedData = _cachedDataForKey[key];
+  if (cachedData) {
+    if (error) {
+      *error = nil;
+    }
+    return cachedData == [NSNull null] ? nil : cachedData;
+  }
+  NSData *data;
+  if (!_allDataPrefetched) {
+    data = [self itemWithQuery:[self genericPasswordQueryWithKey:key] error:error];
+    if (error && *error) {
+      return nil;
+    }
   }
   if (data) {
+    _cachedDataForKey[key] = data;
     return data;
   }
   // Check for legacy form.
   if (_legacyEntryDeletedForKey[key]) {
+    _cachedDataForKey[key] = [NSNull null];
     return nil;
   }
   data = [self itemWithQuery:[self legacyGenericPasswordQueryWithKey:key] error:error];
@@ -77,6 +133,7 @@ NS_ASSUME_NONNULL_BEGIN
   if (!data) {
     // Mark legacy data as non-existing so we don't have to query it again.
     _legacyEntryDeletedForKey[key] = @YES;
+    _cachedDataForKey[key] = [NSNull null];
     return nil;
   }
   // Move the data to current form.
@@ -93,13 +150,26 @@ NS_ASSUME_NONNULL_BEGIN
                 format:@"%@", @"The key cannot be nil or empty."];
     return NO;
   }
+  // Writing the same data again, e.g. when a user is saved without any change, is skipped.
+  if ([_cachedDataForKey[key] isEqual:data]) {
+    if (error) {
+      *error = nil;
+    }
+    return YES;
+  }
   NSDictionary *attributes = @{
     (__bridge id)kSecValueData : data,
     (__bridge id)kSecAttrAccessible : (__bridge id)kSecAttrAccessibleAfterFirstUnlockThisDeviceOnly,
   };
-  return [self setItemWithQuery:[self genericPasswordQueryWithKey:key]
-                     attributes:attributes
-                          error:error];
+  // The cached data is no longer known to match the keychain until the write succeeds.
+  [_cachedDataForKey removeObjectForKey:key];
+  if (![self setItemWithQuery:[self genericPasswordQueryWithKey:key]
+                   attributes:attributes
+                        error:error]) {
+    return NO;
+  }
+  _cachedDataForKey[key] = [data copy];
+  return YES;
 }
 
 - (BOOL)removeDataForKey:(NSString *)key error:(NSError **_Nullable)error {
@@ -108,12 +178,14 @@ NS_ASSUME_NONNULL_BEGIN
                 format:@"%@", @"The key cannot be nil or empty."];
     return NO;
   }
+  [_cachedDataForKey removeObjectForKey:key];
   if (![self deleteItemWithQuery:[self genericPasswordQueryWithKey:key] error:error]) {
     return NO;
   }
   // Legacy form item, if exists, also needs to be removed, otherwise it will be exposed when
   // current form item is removed, leading to incorrect semantics.
   [self deleteLegacyItemWithKey:key];
+  _cachedDataForKey[key] = [NSNull null];
   return YES;
 }
 
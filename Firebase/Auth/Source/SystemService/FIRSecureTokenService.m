@@ -17,6 +17,7 @@
 #import "FIRSecureTokenService.h"
 
 #import "FIRAuth.h"
+#import "FIRAuthGlobalWorkQueue.h"
 #import "FIRAuthKeychain.h"
 #import "FIRAuthSerialTaskQueue.h"
 #import "FIRAuthBackend.h"
@@ -70,8 +71,18 @@ static const NSTimeInterval kFiveMinutes = 5 * 60;
       @brief The currently cached access token. Or |nil| if no token is currently cached.
    */
   NSString *_Nullable _accessToken;
+
+  /** @var _pendingRefreshCallbacks
+      @brief The callbacks waiting for the request for an access token in flight, or |nil| if
+          there is none.
+   */
+  NSMutableArray<FIRFetchAccessTokenCallback> *_Nullable _pendingRefreshCallbacks;
 }
 
+// The tokens are read and written under @synchronized, so their getters are implemented below.
+@synthesize refreshToken = _refreshToken;
+@synthesize accessTokenExpirationDate = _accessTokenExpirationDate;
+
 - (instancetype)init {
   self = [super init];
   if (self) {
@@ -106,23 +117,58 @@ static const NSTimeInterval kFiveMinutes = 5 * 60;
 
 - (void)fetchAccessTokenForcingRefresh:(BOOL)forceRefresh
                               callback:(FIRFetchAccessTokenCallback)callback {
-  [_taskQueue enqueueTask:^(FIRAuthSerialTaskCompletionBlock complete) {
+  FIRFetchAccessTokenCallback refreshCallback = [callback copy];
+  @synchronized(self) {
+    // A valid token is handed out right away, even while a refresh is in flight, rather than
+    // waiting in the task queue behind the refresh.
     if (!forceRefresh && [self hasValidAccessToken]) {
-      complete();
-      callback(self->_accessToken, nil, NO);
-    } else {
-      [self requestAccessToken:^(NSString *_Nullable token,
-                                 NSError *_Nullable error,
-                                 BOOL tokenUpdated) {
-        complete();
-        callback(token, error, tokenUpdated);
-      }];
+      NSString *accessToken = _accessToken;
+      dispatch_async(FIRAuthGlobalWorkQueue(), ^{
+        refreshCallback(accessToken, nil, NO);
+      });
+      return;
     }
+    // Concurrent callers share a single request rather than each making their own.
+    if (_pendingRefreshCallbacks) {
+      [_pendingRefreshCallbacks addObject:refreshCallback];
+      return;
+    }
+    _pendingRefreshCallbacks = [NSMutableArray arrayWithObject:refreshCallback];
+  }
+
+  [_taskQueue enqueueTask:^(FIRAuthSerialTaskCompletionBlock complete) {
+    [self requestAccessToken:^(NSString *_Nullable token,
+                               NSError *_Nullable error,
+                               BOOL tokenUpdated) {
+      NSArray<FIRFetchAccessTokenCallback> *callbacks;
+      @synchronized(self) {
+        callbacks = self->_pendingRefreshCallbacks;
+        self->_pendingRefreshCallbacks = nil;
+      }
+      complete();
+      for (FIRFetchAccessTokenCallback pendingCallback in callbacks) {
+        pendingCallback(token, error, tokenUpdated);
+      }
+    }];
   }];
 }
 
 - (NSString *)rawAccessToken {
-  return _accessToken;
+  @synchronized(self) {
+    return _accessToken;
+  }
+}
+
+- (nullable NSDate *)accessTokenExpirationDate {
+  @synchronized(self) {
+    return _accessTokenExpirationDate;
+  }
+}
+
+- (nullable NSString *)refreshToken {
+  @synchronized(self) {
+    return _refreshToken;
+  }
 }
 
 #pragma mark - NSSecureCoding
@@ -153,9 +199,11 @@ static const NSTimeInterval kFiveMinutes = 5 * 60;
   // of the library.
   [aCoder encodeObject:_requestConfiguration.APIKey forKey:kAPIKeyCodingKey];
   // Authorization code is not encoded because it is not long-lived.
-  [aCoder encodeObject:_refreshToken forKey:kRefreshTokenKey];
-  [aCoder encodeObject:_accessToken forKey:kAccessTokenKey];
-  [aCoder encodeObject:_accessTokenExpirationDate forKey:kAccessTokenExpirationDateKey];
+  @synchronized(self) {
+    [aCoder encodeObject:_refreshToken forKey:kRefreshTokenKey];
+    [aCoder encodeObject:_accessToken forKey:kAccessTokenKey];
+    [aCoder encodeObject:_accessTokenExpirationDate forKey:kAccessTokenExpirationDateKey];
+  }
 }
 
 #pragma mark - Private methods
@@ -167,15 +215,15 @@ static const NSTimeInterval kFiveMinutes = 5 * 60;
         a @c _taskQueue task.
     @param callback Called when the fetch is complete. Invoked asynchronously on the main thread in
         the future.
-    @remarks Because this method is guaranteed to only be called from tasks enqueued in
-        @c _taskQueue, we do not need any @synchronized guards around access to _accessToken/etc.
-        since only one of those tasks is ever running at a time, and those tasks are the only
-        access to and mutation of these instance variables.
+    @remarks This method is guaranteed to only be called from tasks enqueued in @c _taskQueue,
+        so only one request is ever in flight. The tokens are still updated under @synchronized
+        since cached tokens are read without going through @c _taskQueue.
  */
 - (void)requestAccessToken:(FIRFetchAccessTokenCallback)callback {
   FIRSecureTokenRequest *request;
-  if (_refreshToken.length) {
-    request = [FIRSecureTokenRequest refreshRequestWithRefreshToken:_refreshToken
+  NSString *refreshToken = self.refreshToken;
+  if (refreshToken.length) {
+    request = [FIRSecureTokenRequest refreshRequestWithRefreshToken:refreshToken
                                                requestConfiguration:_requestConfiguration];
   } else {
     request = [FIRSecureTokenRequest authCodeRequestWithCode:_authorizationCode
@@ -186,21 +234,26 @@ static const NSTimeInterval kFiveMinutes = 5 * 60;
                                 NSError *_Nullable error) {
     BOOL tokenUpdated = NO;
     NSString *newAccessToken = response.accessToken;
-                       if (newAccessToken.length && ![newAccessToken isEqualToString:self->_accessToken]) {
-                         self->_accessToken = [newAccessToken copy];
-                         self->_accessTokenExpirationDate = response.approximateExpirationDate;
-      tokenUpdated = YES;
-    }
     NSString *newRefreshToken = response.refreshToken;
-                       if (newRefreshToken.length &&
-                           ![newRefreshToken isEqualToString:self->_refreshToken]) {
-                         self->_refreshToken = [newRefreshToken copy];
-      tokenUpdated = YES;
+    @synchronized(self) {
+      if (newAccessToken.length && ![newAccessToken isEqualToString:self->_accessToken]) {
+        self->_accessToken = [newAccessToken copy];
+        self->_accessTokenExpirationDate = response.approximateExpirationDate;
+        tokenUpdated = YES;
+      }
+      if (newRefreshToken.length && ![newRefreshToken isEqualToString:self->_refreshToken]) {
+        self->_refreshToken = [newRefreshToken copy];
+        tokenUpdated = YES;
+      }
     }
     callback(newAccessToken, error, tokenUpdated);
   }];
 }
 
+/** @fn hasValidAccessToken
+    @brief Whether the cached access token is valid for at least five more minutes.
+    @remarks Must be called in a @c @synchronized(self) block.
+ */
 - (BOOL)hasValidAccessToken {
   return _accessToken && [_accessTokenExpirationDate timeIntervalSinceNow] > kFiveMinutes;
 }
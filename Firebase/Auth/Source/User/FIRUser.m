@@ -962,10 +962,8 @@ static void callInMainThreadWithAuthDataResultAndError(
       return;
     }
     if (tokenUpdated) {
-      if (![self updateKeychain:&error]) {
-        callback(nil, error);
-        return;
-      }
+      // Saving the new tokens is kept off the path of the caller waiting for them.
+      [self->_auth scheduleKeychainUpdateWithUser:self];
     }
     callback(token, nil);
   }];
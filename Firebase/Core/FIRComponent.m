@@ -24,6 +24,7 @@
 - (instancetype)initWithProtocol:(Protocol *)protocol
              instantiationTiming:(FIRInstantiationTiming)instantiationTiming
                     dependencies:(NSArray<FIRDependency *> *)dependencies
+              requiresMainThread:(BOOL)requiresMainThread
                    creationBlock:(FIRComponentCreationBlock)creationBlock;
 
 @end
@@ -35,6 +36,7 @@
   return [[FIRComponent alloc] initWithProtocol:protocol
                             instantiationTiming:FIRInstantiationTimingLazy
                                    dependencies:@[]
+                             requiresMainThread:YES
                                   creationBlock:creationBlock];
 }
 
@@ -45,12 +47,26 @@
   return [[FIRComponent alloc] initWithProtocol:protocol
                             instantiationTiming:instantiationTiming
                                    dependencies:dependencies
+                             requiresMainThread:YES
+                                  creationBlock:creationBlock];
+}
+
++ (instancetype)componentWithProtocol:(Protocol *)protocol
+                  instantiationTiming:(FIRInstantiationTiming)instantiationTiming
+                         dependencies:(NSArray<FIRDependency *> *)dependencies
+                   requiresMainThread:(BOOL)requiresMainThread
+                        creationBlock:(FIRComponentCreationBlock)creationBlock {
+  return [[FIRComponent alloc] initWithProtocol:protocol
+                            instantiationTiming:instantiationTiming
+                                   dependencies:dependencies
+                             requiresMainThread:requiresMainThread
                                   creationBlock:creationBlock];
 }
 
 - (instancetype)initWithProtocol:(Protocol *)protocol
              instantiationTiming:(FIRInstantiationTiming)instantiationTiming
                     dependencies:(NSArray<FIRDependency *> *)dependencies
+              requiresMainThread:(BOOL)requiresMainThread
                    creationBlock:(FIRComponentCreationBlock)creationBlock {
   self = [super init];
   if (self) {
@@ -58,6 +74,7 @@
     _instantiationTiming = instantiationTiming;
     _dependencies = [dependencies copy];
     _creationBlock = creationBlock;
+    _requiresMainThread = requiresMainThread;
   }
   return self;
 }
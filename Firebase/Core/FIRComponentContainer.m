@@ -29,9 +29,15 @@ NS_ASSUME_NONNULL_BEGIN
 /// of the protocol.
 @property(nonatomic, strong) NSMutableDictionary<NSString *, FIRComponentCreationBlock> *components;
 
-/// Cached instances of components that requested to be cached.
+/// Cached instances of components that requested to be cached. Guarded by `@synchronized(self)`
+/// since eager components may be instantiated on a background queue.
 @property(nonatomic, strong) NSMutableDictionary<NSString *, id> *cachedInstances;
 
+/// Groups that complete once the background instantiation of an eager component is done, keyed by
+/// the protocol name. Guarded by `@synchronized(self)`.
+@property(nonatomic, strong)
+    NSMutableDictionary<NSString *, dispatch_group_t> *pendingInstantiations;
+
 @end
 
 @implementation FIRComponentContainer
@@ -67,6 +73,7 @@ static NSMutableSet<Class> *sFIRComponentRegistrants;
     _app = app;
     _cachedInstances = [NSMutableDictionary<NSString *, id> dictionary];
     _components = [NSMutableDictionary<NSString *, FIRComponentCreationBlock> dictionary];
+    _pendingInstantiations = [NSMutableDictionary<NSString *, dispatch_group_t> dictionary];
 
     [self populateComponentsFromRegisteredClasses:allRegistrants forApp:app];
   }
@@ -74,6 +81,9 @@ static NSMutableSet<Class> *sFIRComponentRegistrants;
 }
 
 - (void)populateComponentsFromRegisteredClasses:(NSSet<Class> *)classes forApp:(FIRApp *)app {
+  NSMutableArray<FIRComponent *> *mainThreadEagerComponents = [NSMutableArray array];
+  NSMutableArray<FIRComponent *> *backgroundEagerComponents = [NSMutableArray array];
+
   // Loop through the verified component registrants and populate the components array.
   for (Class<FIRLibrary> klass in classes) {
     // Loop through all the components being registered and store them as appropriate.
@@ -92,21 +102,65 @@ static NSMutableSet<Class> *sFIRComponentRegistrants;
       // Store the creation block for later usage.
       self.components[protocolName] = component.creationBlock;
 
-      // Instantiate the
+      // Instantiate the component now if it's eager, once all components are known.
       BOOL shouldInstantiateEager =
           (component.instantiationTiming == FIRInstantiationTimingAlwaysEager);
       BOOL shouldInstantiateDefaultEager =
           (component.instantiationTiming == FIRInstantiationTimingEagerInDefaultApp &&
            [app isDefaultApp]);
       if (shouldInstantiateEager || shouldInstantiateDefaultEager) {
-        [self instantiateInstanceForProtocol:component.protocol withBlock:component.creationBlock];
+        if (component.requiresMainThread) {
+          [mainThreadEagerComponents addObject:component];
+        } else {
+          [backgroundEagerComponents addObject:component];
+        }
       }
     }
   }
+
+  // Start the background instantiations first so that they overlap with the ones on this thread.
+  // All of them are marked as pending before any starts, so a component that depends on another
+  // eager one waits for it instead of creating a second instance.
+  [self instantiateInBackgroundComponents:backgroundEagerComponents];
+  for (FIRComponent *component in mainThreadEagerComponents) {
+    [self instantiateInstanceForProtocol:component.protocol withBlock:component.creationBlock];
+  }
 }
 
 #pragma mark - Instance Creation
 
+/// Instantiate the given components concurrently on a background queue. Each protocol is marked as
+/// pending until its instance is created, so `instanceForProtocol:` only waits for the instance it
+/// was asked for.
+- (void)instantiateInBackgroundComponents:(NSArray<FIRComponent *> *)components {
+  if (components.count == 0) {
+    return;
+  }
+
+  NSMutableArray<dispatch_group_t> *groups = [NSMutableArray arrayWithCapacity:components.count];
+  @synchronized(self) {
+    for (FIRComponent *component in components) {
+      dispatch_group_t group = dispatch_group_create();
+      // Enter before the group is visible to others so waiting on it can't return too early.
+      dispatch_group_enter(group);
+      self.pendingInstantiations[NSStringFromProtocol(component.protocol)] = group;
+      [groups addObject:group];
+    }
+  }
+
+  dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+  [components enumerateObjectsUsingBlock:^(FIRComponent *component, NSUInteger idx, BOOL *stop) {
+    dispatch_group_t group = groups[idx];
+    dispatch_async(queue, ^{
+      [self instantiateInstanceForProtocol:component.protocol withBlock:component.creationBlock];
+      @synchronized(self) {
+        [self.pendingInstantiations removeObjectForKey:NSStringFromProtocol(component.protocol)];
+      }
+      dispatch_group_leave(group);
+    });
+  }];
+}
+
 /// Instantiate an instance of a class that conforms to the specified protocol.
 /// This will:
 ///   - Call the block to create an instance if possible,
@@ -135,8 +189,15 @@ static NSMutableSet<Class> *sFIRComponentRegistrants;
   }
 
   // The instance is ready to be returned, but check if it should be cached first before returning.
+  // If another thread cached an instance in the meantime, return that one so there's only ever one.
   if (shouldCache) {
-    self.cachedInstances[protocolName] = instance;
+    @synchronized(self) {
+      id cachedInstance = self.cachedInstances[protocolName];
+      if (cachedInstance) {
+        return cachedInstance;
+      }
+      self.cachedInstances[protocolName] = instance;
+    }
   }
 
   return instance;
@@ -145,9 +206,23 @@ static NSMutableSet<Class> *sFIRComponentRegistrants;
 #pragma mark - Internal Retrieval
 
 - (nullable id)instanceForProtocol:(Protocol *)protocol {
-  // Check if there is a cached instance, and return it if so.
   NSString *protocolName = NSStringFromProtocol(protocol);
-  id cachedInstance = self.cachedInstances[protocolName];
+
+  // If the instance is being created on a background queue, wait for it rather than creating
+  // another one.
+  dispatch_group_t pendingInstantiation;
+  @synchronized(self) {
+    pendingInstantiation = self.pendingInstantiations[protocolName];
+  }
+  if (pendingInstantiation) {
+    dispatch_group_wait(pendingInstantiation, DISPATCH_TIME_FOREVER);
+  }
+
+  // Check if there is a cached instance, and return it if so.
+  id cachedInstance;
+  @synchronized(self) {
+    cachedInstance = self.cachedInstances[protocolName];
+  }
   if (cachedInstance) {
     return cachedInstance;
   }
@@ -160,15 +235,28 @@ static NSMutableSet<Class> *sFIRComponentRegistrants;
 #pragma mark - Lifecycle
 
 - (void)removeAllCachedInstances {
+  // Let the background instantiations finish so none of them caches an instance after this.
+  NSArray<dispatch_group_t> *pendingInstantiations;
+  @synchronized(self) {
+    pendingInstantiations = self.pendingInstantiations.allValues;
+  }
+  for (dispatch_group_t group in pendingInstantiations) {
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+  }
+
+  NSArray *instances;
+  @synchronized(self) {
+    instances = self.cachedInstances.allValues;
+    [self.cachedInstances removeAllObjects];
+  }
+
   // Loop through the cache and notify each instance that is a maintainer to clean up after itself.
-  for (id instance in self.cachedInstances.allValues) {
+  for (id instance in instances) {
     if ([instance conformsToProtocol:@protocol(FIRComponentLifecycleMaintainer)] &&
         [instance respondsToSelector:@selector(appWillBeDeleted:)]) {
       [instance appWillBeDeleted:self.app];
     }
   }
-
-  [self.cachedInstances removeAllObjects];
 }
 
 @end
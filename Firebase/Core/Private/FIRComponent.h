@@ -58,6 +58,11 @@ NS_SWIFT_NAME(Component)
 /// A block to instantiate an instance of the component with the appropriate dependencies.
 @property(nonatomic, copy, readonly) FIRComponentCreationBlock creationBlock;
 
+/// Whether an eager component has to be instantiated on the main thread. Eager components that
+/// don't are instantiated concurrently on a background queue while the app is configured; asking
+/// the container for one of them only waits until that particular instance is ready.
+@property(nonatomic, readonly) BOOL requiresMainThread;
+
 // There's an issue with long NS_SWIFT_NAMES that causes compilation to fail, disable clang-format
 // for the next two methods.
 // clang-format off
@@ -81,6 +86,23 @@ NS_SWIFT_NAME(init(_:creationBlock:));
                         creationBlock:(FIRComponentCreationBlock)creationBlock
 NS_SWIFT_NAME(init(_:instantiationTiming:dependencies:creationBlock:));
 
+/// Creates a component to be registered with the component container.
+///
+/// @param protocol - The protocol describing functionality provided by the component.
+/// @param instantiationTiming - When the component should be initialized. Use .lazy unless there's
+///                              a good reason to be instantiated earlier.
+/// @param dependencies - Any dependencies the `implementingClass` has, optional or required.
+/// @param requiresMainThread - Whether an eager instance has to be created on the main thread. Pass
+///                             NO only if `creationBlock` and its dependencies are thread safe.
+/// @param creationBlock - A block to instantiate the component with a container, and if
+/// @return A component that can be registered with the component container.
++ (instancetype)componentWithProtocol:(Protocol *)protocol
+                  instantiationTiming:(FIRInstantiationTiming)instantiationTiming
+                         dependencies:(NSArray<FIRDependency *> *)dependencies
+                   requiresMainThread:(BOOL)requiresMainThread
+                        creationBlock:(FIRComponentCreationBlock)creationBlock
+NS_SWIFT_NAME(init(_:instantiationTiming:dependencies:requiresMainThread:creationBlock:));
+
 // clang-format on
 
 /// Unavailable.
@@ -125,6 +125,33 @@ extern void FIRLogDebug(FIRLoggerService service, NSString *messageCode, NSStrin
 }  // extern "C"
 #endif  // __cplusplus
 
+/**
+ * The following macros take the same parameters as the functions above, but check the level before
+ * anything else, so the arguments aren't evaluated and the message isn't formatted unless it's
+ * going to be logged. Prefer them on hot paths.
+ * Example usage:
+ * FIR_LOG_DEBUG(kFIRLoggerCore, @"I-COR000001", @"Loaded %@.", [object expensiveDescription]);
+ */
+#define FIR_LOG_IF_LOGGABLE(level, service, messageCode, ...)                          \
+  do {                                                                                 \
+    FIRLoggerService fir_log_service = (service);                                      \
+    if (FIRIsLoggableLevel(FIRLoggerLevel##level,                                      \
+                           [kFIRLoggerAnalytics isEqualToString:fir_log_service])) {   \
+      FIRLog##level(fir_log_service, (messageCode), __VA_ARGS__);                      \
+    }                                                                                  \
+  } while (0)
+
+#define FIR_LOG_ERROR(service, messageCode, ...) \
+  FIR_LOG_IF_LOGGABLE(Error, service, messageCode, __VA_ARGS__)
+#define FIR_LOG_WARNING(service, messageCode, ...) \
+  FIR_LOG_IF_LOGGABLE(Warning, service, messageCode, __VA_ARGS__)
+#define FIR_LOG_NOTICE(service, messageCode, ...) \
+  FIR_LOG_IF_LOGGABLE(Notice, service, messageCode, __VA_ARGS__)
+#define FIR_LOG_INFO(service, messageCode, ...) \
+  FIR_LOG_IF_LOGGABLE(Info, service, messageCode, __VA_ARGS__)
+#define FIR_LOG_DEBUG(service, messageCode, ...) \
+  FIR_LOG_IF_LOGGABLE(Debug, service, messageCode, __VA_ARGS__)
+
 @interface FIRLoggerWrapper : NSObject
 
 /**
@@ -168,6 +168,17 @@ static const char *FIREBASE_SEMVER = (const char *)STR(FIRDatabase_VERSION);
     });
 }
 
+- (void)getStatisticsWithCompletion:(void (^)(FIRDatabaseStatistics *statistics))completion {
+    [self ensureRepo];
+
+    dispatch_async([FIRDatabaseQuery sharedQueue], ^{
+        FIRDatabaseStatistics *statistics = [self.repo statistics];
+        dispatch_async(self.callbackQueue, ^{
+            completion(statistics);
+        });
+    });
+}
+
 - (void)setPersistenceEnabled:(BOOL)persistenceEnabled {
     [self assertUnfrozen:@"setPersistenceEnabled"];
     self->_config.persistenceEnabled = persistenceEnabled;
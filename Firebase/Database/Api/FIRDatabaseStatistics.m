@@ -0,0 +1,54 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FIRDatabaseStatistics.h"
+#import "FIRDatabaseStatistics_Private.h"
+
+@implementation FIRDatabaseStatistics
+
+- (instancetype)initWithPendingWriteCount:(NSUInteger)pendingWriteCount
+                        trackedQueryCount:(NSUInteger)trackedQueryCount
+                persistenceCacheSizeBytes:(NSUInteger)persistenceCacheSizeBytes
+                               eventCount:(NSUInteger)eventCount
+                        totalEventLatency:(NSTimeInterval)totalEventLatency
+                          maxEventLatency:(NSTimeInterval)maxEventLatency
+                    persistenceWriteCount:(NSUInteger)persistenceWriteCount
+                 persistenceWriteDuration:(NSTimeInterval)persistenceWriteDuration {
+    self = [super init];
+    if (self != nil) {
+        self->_pendingWriteCount = pendingWriteCount;
+        self->_trackedQueryCount = trackedQueryCount;
+        self->_persistenceCacheSizeBytes = persistenceCacheSizeBytes;
+        self->_eventCount = eventCount;
+        self->_averageEventLatency = eventCount > 0 ? totalEventLatency / eventCount : 0;
+        self->_maxEventLatency = maxEventLatency;
+        self->_persistenceWriteCount = persistenceWriteCount;
+        self->_persistenceWriteDuration = persistenceWriteDuration;
+    }
+    return self;
+}
+
+- (NSString *) description {
+    return [NSString stringWithFormat:@"FIRDatabaseStatistics pendingWrites=%lu trackedQueries=%lu cacheSize=%lu "
+                                      @"events=%lu averageEventLatency=%fms maxEventLatency=%fms "
+                                      @"persistenceWrites=%lu persistenceWriteDuration=%fms",
+                                      (unsigned long)self.pendingWriteCount, (unsigned long)self.trackedQueryCount,
+                                      (unsigned long)self.persistenceCacheSizeBytes, (unsigned long)self.eventCount,
+                                      self.averageEventLatency * 1000, self.maxEventLatency * 1000,
+                                      (unsigned long)self.persistenceWriteCount, self.persistenceWriteDuration * 1000];
+}
+
+@end
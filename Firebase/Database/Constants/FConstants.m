@@ -100,6 +100,7 @@ NSString *const kWebsocketServerKillPacket = @"kill";
 const int kWebsocketMaxFrameSize = 16384;
 NSUInteger const kWebsocketKeepaliveInterval = 45;
 NSUInteger const kWebsocketConnectTimeout = 30;
+NSUInteger const kWebsocketCompressionThreshold = 1024;
 
 float const kPersistentConnReconnectMinDelay = 1.0;
 float const kPersistentConnReconnectMaxDelay = 30.0;
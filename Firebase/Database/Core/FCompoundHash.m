@@ -205,7 +205,17 @@
 }
 
 + (FCompoundHash *)fromNode:(id<FNode>)node {
-    return [FCompoundHash fromNode:node splitStrategy:[FCompoundHash simpleSizeSplitStrategyForNode:node]];
+    if (![node isKindOfClass:[FChildrenNode class]]) {
+        return [FCompoundHash fromNode:node splitStrategy:[FCompoundHash simpleSizeSplitStrategyForNode:node]];
+    }
+    // The server cache of a listen is usually unchanged between reconnects, so keep the hash with the node rather
+    // than hash the whole tree again.
+    FChildrenNode *childrenNode = (FChildrenNode *)node;
+    if (childrenNode.lazyCompoundHash == nil) {
+        childrenNode.lazyCompoundHash = [FCompoundHash fromNode:node
+                                                  splitStrategy:[FCompoundHash simpleSizeSplitStrategyForNode:node]];
+    }
+    return childrenNode.lazyCompoundHash;
 }
 
 + (FCompoundHash *)fromNode:(id<FNode>)node splitStrategy:(FCompoundHashSplitStrategy)strategy {
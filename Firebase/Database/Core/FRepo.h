@@ -28,6 +28,7 @@
 @class FCompoundWrite;
 @protocol FClock;
 @class FIRDatabase;
+@class FIRDatabaseStatistics;
 
 @interface FRepo : NSObject <FPersistentConnectionDelegate>
 
@@ -65,6 +66,9 @@
                      onComplete:(fbt_void_nserror_bool_datasnapshot)onComplete
                 withLocalEvents:(BOOL)applyLocally;
 
+// Must be called on the database queue.
+- (FIRDatabaseStatistics *) statistics;
+
 // Testing methods
 - (NSDictionary *) dumpListens;
 - (void) dispose;
@@ -52,6 +52,7 @@
 #import "FIRDataSnapshot_Private.h"
 #import "FValueEventRegistration.h"
 #import "FEmptyNode.h"
+#import "FIRDatabaseStatistics_Private.h"
 
 #if TARGET_OS_IOS || TARGET_OS_TV
 #import <UIKit/UIKit.h>
@@ -595,6 +596,17 @@
     return [self.connection dumpListens];
 }
 
+- (FIRDatabaseStatistics *) statistics {
+    return [[FIRDatabaseStatistics alloc] initWithPendingWriteCount:[self.serverSyncTree numberOfPendingWrites]
+                                                  trackedQueryCount:[self.persistenceManager numberOfTrackedQueries]
+                                          persistenceCacheSizeBytes:[self.persistenceManager serverCacheEstimatedSizeInBytes]
+                                                         eventCount:self.eventRaiser.numberOfRaisedEvents
+                                                  totalEventLatency:self.eventRaiser.totalEventLatency
+                                                    maxEventLatency:self.eventRaiser.maxEventLatency
+                                              persistenceWriteCount:self.persistenceManager.numberOfStorageWrites
+                                           persistenceWriteDuration:self.persistenceManager.storageWriteDuration];
+}
+
 #pragma mark -
 #pragma mark Transactions
 
@@ -55,6 +55,7 @@
 - (NSArray *) removeEventRegistration:(id <FEventRegistration>)eventRegistration forQuery:(FQuerySpec *)query cancelError:(NSError *)cancelError;
 - (void)keepQuery:(FQuerySpec *)query synced:(BOOL)keepSynced;
 - (NSArray *) removeAllWrites;
+- (NSUInteger) numberOfPendingWrites;
 
 - (id<FNode>) calcCompleteEventCacheAtPath:(FPath *)path excludeWriteIds:(NSArray *)writeIdsToExclude;
 
@@ -294,6 +294,10 @@ static const NSUInteger kFSizeThresholdForCompoundHash = 1024;
     }
 }
 
+- (NSUInteger) numberOfPendingWrites {
+    return [self.pendingWriteTree numberOfWrites];
+}
+
 /**
 * Internal helper method to apply tagged operation
 */
@@ -34,6 +34,7 @@
 - (BOOL) removeWriteId:(NSInteger)writeId;
 - (NSArray *) removeAllWrites;
 - (FWriteRecord *)writeForId:(NSInteger)writeId;
+- (NSUInteger) numberOfWrites;
 
 - (id<FNode>) calculateCompleteEventCacheAtPath:(FPath *)treePath
                             completeServerCache:(id<FNode>)completeServerCache
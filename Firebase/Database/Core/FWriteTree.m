@@ -107,6 +107,10 @@
     return (index == NSNotFound) ? nil : self.allWrites[index];
 }
 
+- (NSUInteger) numberOfWrites {
+    return self.allWrites.count;
+}
+
 /**
 * Remove a write (either an overwrite or merge) that has been successfully acknowledged by the server. Recalculates the
 * tree if necessary. We return the path of the write and whether it may have been visible, meaning views need to
@@ -136,7 +140,8 @@
             if (i >= index && [self record:currentWrite containsPath:writeToRemove.path]) {
                 // The removed write was completely shadowed by a subsequent write.
                 removedWriteWasVisible = NO;
-            } else if ([writeToRemove.path contains:currentWrite.path]) {
+            } else if ([writeToRemove.path contains:currentWrite.path] ||
+                       [currentWrite.path contains:writeToRemove.path]) {
                 // Either we're covering some writes or they're covering part of us (depending on which came first).
                 removedWriteOverlapsWithOtherWrites = YES;
             }
@@ -147,8 +152,9 @@
     if (!removedWriteWasVisible) {
         return NO;
     } else if (removedWriteOverlapsWithOtherWrites) {
-        // There's some shadowing going on. Just rebuild the visible writes from scratch.
-        [self resetTree];
+        // There's some shadowing going on. Rebuild the visible writes under the removed write, leaving the rest of
+        // the tree alone.
+        [self resetTreeAtPath:writeToRemove.path];
         return YES;
     } else {
         // There's no shadowing.  We can safely just remove the write(s) from visibleWrites.
@@ -381,10 +387,17 @@
 }
 
 /**
-* Re-layer the writes and merges into a tree so we can efficiently calculate event snapshots
+* Re-layer the writes and merges that overlap the given path into the tree so we can efficiently calculate event
+* snapshots. Writes there are folded into the write at the shallowest path on the way, so the subtree of that write is
+* rebuilt; the rest of the tree is left as is.
 */
-- (void) resetTree {
-    self.visibleWrites = [FWriteTree layerTreeFromWrites:self.allWrites filter:[FWriteTree defaultFilter] treeRoot:[FPath empty]];
+- (void) resetTreeAtPath:(FPath *)path {
+    FPath *root = [self.visibleWrites rootMostWritePathOnPath:path];
+    if (root == nil) {
+        root = path;
+    }
+    FCompoundWrite *layered = [FWriteTree layerTreeFromWrites:self.allWrites filter:[FWriteTree defaultFilter] treeRoot:root];
+    self.visibleWrites = [[self.visibleWrites removeWriteAtPath:root] addCompoundWrite:layered atPath:root];
     if ([self.allWrites count] > 0) {
         FWriteRecord *lastRecord = self.allWrites[[self.allWrites count] - 1];
         self.lastWriteId = lastRecord.writeId;
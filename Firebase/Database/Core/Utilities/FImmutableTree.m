@@ -118,11 +118,20 @@
 - (id) rootMostValueOnPath:(FPath *)path matching:(BOOL (^)(id))predicate {
     if (self.value != nil && predicate(self.value)) {
         return self.value;
-    } else if (path.isEmpty) {
-        return nil;
-    } else {
-        return [[self.children get:path.getFront] rootMostValueOnPath:[path popFront] matching:predicate];
     }
+    // Walks the path's components in place rather than popping a new path off at every level.
+    __block FImmutableTree *tree = self;
+    __block id found = nil;
+    [path enumerateComponentsUsingBlock:^(NSString *key, BOOL *stop) {
+        tree = [tree.children get:key];
+        if (tree == nil) {
+            *stop = YES;
+        } else if (tree.value != nil && predicate(tree.value)) {
+            found = tree.value;
+            *stop = YES;
+        }
+    }];
+    return found;
 }
 
 - (id) leafMostValueOnPath:(FPath *)path {
@@ -162,17 +171,12 @@
 }
 
 - (FImmutableTree *) subtreeAtPath:(FPath *)relativePath {
-    if ([relativePath isEmpty]) {
-        return self;
-    } else {
-        NSString *front = [relativePath getFront];
-        FImmutableTree *childTree = [self.children get:front];
-        if (childTree != nil) {
-            return [childTree subtreeAtPath:[relativePath popFront]];
-        } else {
-            return [FImmutableTree empty];
-        }
-    }
+    __block FImmutableTree *tree = self;
+    [relativePath enumerateComponentsUsingBlock:^(NSString *key, BOOL *stop) {
+        tree = [tree.children get:key];
+        *stop = tree == nil;
+    }];
+    return tree != nil ? tree : [FImmutableTree empty];
 }
 
 /**
@@ -229,17 +233,7 @@
 * Gets a value from the tree
 */
 - (id) valueAtPath:(FPath *)relativePath {
-    if ([relativePath isEmpty]) {
-        return self.value;
-    } else {
-        NSString *front = [relativePath getFront];
-        FImmutableTree *child = [self.children get:front];
-        if (child) {
-            return [child valueAtPath:[relativePath popFront]];
-        } else {
-            return nil;
-        }
-    }
+    return [self subtreeAtPath:relativePath].value;
 }
 
 /**
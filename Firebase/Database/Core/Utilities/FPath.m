@@ -21,11 +21,16 @@
 @interface FPath()
 
 @property (nonatomic, readwrite, assign) NSInteger pieceNum;
+@property (nonatomic, readwrite, assign) NSInteger pieceEnd;
 @property (nonatomic, strong) NSArray * pieces;
 
 @end
 
-@implementation FPath
+@implementation FPath {
+    // Zero until computed. Paths are immutable and used as dictionary keys by the sync tree and
+    // write tree, so the hash is only computed once.
+    NSUInteger _hash;
+}
 
 #pragma mark -
 #pragma mark Initializers
@@ -62,15 +67,25 @@
 
         self.pieces = newPieces;
         self.pieceNum = 0;
+        self.pieceEnd = newPieces.count;
     }
     return self;
 }
 
 - (id)initWithPieces:(NSArray *)somePieces andPieceNum:(NSInteger)aPieceNum {
+    return [self initWithPieces:somePieces from:aPieceNum to:somePieces.count];
+}
+
+/**
+* Creates the path made of pieces[start..<end]. The pieces array is shared rather than copied, so
+* paths derived by popFront and parent never allocate a new one.
+*/
+- (id)initWithPieces:(NSArray *)somePieces from:(NSInteger)start to:(NSInteger)end {
     self = [super init];
     if (self) {
-        self.pieceNum = aPieceNum;
         self.pieces = somePieces;
+        self.pieceNum = MIN(start, end);
+        self.pieceEnd = end;
     }
     return self;
 }
@@ -89,7 +104,7 @@
 #pragma mark Public methods
 
 - (NSString *) getFront {
-    if(self.pieceNum >= self.pieces.count) {
+    if(self.pieceNum >= self.pieceEnd) {
         return nil;
     }
     return [self.pieces objectAtIndex:self.pieceNum];
@@ -99,20 +114,20 @@
 * @return The number of segments in this path
 */
 - (NSUInteger) length {
-    return self.pieces.count - self.pieceNum;
+    return self.pieceEnd - self.pieceNum;
 }
 
 - (FPath *) popFront {
     NSInteger newPieceNum = self.pieceNum;
-    if (newPieceNum < self.pieces.count) {
+    if (newPieceNum < self.pieceEnd) {
         newPieceNum++;
     }
-    return [[FPath alloc] initWithPieces:self.pieces andPieceNum:newPieceNum];
+    return [[FPath alloc] initWithPieces:self.pieces from:newPieceNum to:self.pieceEnd];
 }
 
 - (NSString *) getBack {
-    if(self.pieceNum < self.pieces.count) {
-        return [self.pieces lastObject];
+    if(self.pieceNum < self.pieceEnd) {
+        return [self.pieces objectAtIndex:self.pieceEnd - 1];
     }
     else {
         return nil;
@@ -129,7 +144,7 @@
 
 - (NSString *) toStringWithTrailingSlash:(BOOL)trailingSlash {
     NSMutableString* pathString = [[NSMutableString alloc] init];
-    for(NSInteger i = self.pieceNum; i < self.pieces.count; i++) {
+    for(NSInteger i = self.pieceNum; i < self.pieceEnd; i++) {
         [pathString appendString:@"/"];
         [pathString appendString:[self.pieces objectAtIndex:i]];
     }
@@ -148,7 +163,7 @@
         return @"/";
     } else {
         NSMutableString* pathString = [[NSMutableString alloc] init];
-        for (NSInteger i = self.pieceNum; i < self.pieces.count; i++) {
+        for (NSInteger i = self.pieceNum; i < self.pieceEnd; i++) {
             if (i > self.pieceNum) {
                 [pathString appendString:@"/"];
             }
@@ -159,36 +174,42 @@
 }
 
 - (FPath *) parent {
-    if(self.pieceNum >= self.pieces.count) {
+    if(self.pieceNum >= self.pieceEnd) {
         return nil;
     } else {
-        NSMutableArray* newPieces = [[NSMutableArray alloc] init];
-        for (NSInteger i = self.pieceNum; i < self.pieces.count - 1; i++) {
-            [newPieces addObject:[self.pieces objectAtIndex:i]];
-        }
-        return [[FPath alloc] initWithPieces:newPieces andPieceNum:0];
+        return [[FPath alloc] initWithPieces:self.pieces from:self.pieceNum to:self.pieceEnd - 1];
     }
 }
 
-- (FPath *) child:(FPath *)childPathObj {
-    NSMutableArray* newPieces = [[NSMutableArray alloc] init];
-    for (NSInteger i = self.pieceNum; i < self.pieces.count; i++) {
-        [newPieces addObject:[self.pieces objectAtIndex:i]];
-    }
+/**
+* @return A new array holding the pieces of this path, with room for `extra` more.
+*/
+- (NSMutableArray *) mutablePiecesWithCapacityForExtra:(NSUInteger)extra {
+    NSMutableArray* newPieces = [[NSMutableArray alloc] initWithCapacity:self.length + extra];
+    [newPieces addObjectsFromArray:[self.pieces subarrayWithRange:NSMakeRange(self.pieceNum, self.length)]];
+    return newPieces;
+}
 
-    for (NSInteger i = childPathObj.pieceNum; i < childPathObj.pieces.count; i++) {
-        [newPieces addObject:[childPathObj.pieces objectAtIndex:i]];
+- (FPath *) child:(FPath *)childPathObj {
+    if (childPathObj.isEmpty) {
+        return self;
+    } else if (self.isEmpty) {
+        return childPathObj;
     }
-
+    NSMutableArray* newPieces = [self mutablePiecesWithCapacityForExtra:childPathObj.length];
+    [newPieces addObjectsFromArray:[childPathObj.pieces subarrayWithRange:NSMakeRange(childPathObj.pieceNum, childPathObj.length)]];
     return [[FPath alloc] initWithPieces:newPieces andPieceNum:0];
 }
 
 - (FPath *)childFromString:(NSString *)childPath {
-    NSMutableArray* newPieces = [[NSMutableArray alloc] init];
-    for (NSInteger i = self.pieceNum; i < self.pieces.count; i++) {
-        [newPieces addObject:[self.pieces objectAtIndex:i]];
+    if (childPath.length > 0 && [childPath rangeOfString:@"/"].location == NSNotFound) {
+        // A single key, which is how the trees build the paths they visit.
+        NSMutableArray* newPieces = [self mutablePiecesWithCapacityForExtra:1];
+        [newPieces addObject:childPath];
+        return [[FPath alloc] initWithPieces:newPieces andPieceNum:0];
     }
 
+    NSMutableArray* newPieces = [self mutablePiecesWithCapacityForExtra:0];
     NSArray *pathPieces = [childPath componentsSeparatedByString:@"/"];
     for (unsigned int i = 0; i < pathPieces.count; i++) {
         NSString *piece = [pathPieces objectAtIndex:i];
@@ -204,7 +225,7 @@
 * @return True if there are no segments in this path
 */
 - (BOOL) isEmpty {
-    return self.pieceNum >= self.pieces.count;
+    return self.pieceNum >= self.pieceEnd;
 }
 
 /**
@@ -226,7 +247,7 @@
 
     NSInteger i = self.pieceNum;
     NSInteger j = other.pieceNum;
-    while (i < self.pieces.count) {
+    while (i < self.pieceEnd) {
         NSString* thisSeg = [self.pieces objectAtIndex:i];
         NSString* otherSeg = [other.pieces objectAtIndex:j];
         if (![thisSeg isEqualToString:otherSeg]) {
@@ -240,14 +261,14 @@
 
 - (void) enumerateComponentsUsingBlock:(void (^)(NSString *, BOOL *))block {
     BOOL stop = NO;
-    for (NSInteger i = self.pieceNum; !stop && i < self.pieces.count; i++) {
+    for (NSInteger i = self.pieceNum; !stop && i < self.pieceEnd; i++) {
         block(self.pieces[i], &stop);
     }
 }
 
 - (NSComparisonResult) compare:(FPath *)other {
-    NSInteger myCount = self.pieces.count;
-    NSInteger otherCount = other.pieces.count;
+    NSInteger myCount = self.pieceEnd;
+    NSInteger otherCount = other.pieceEnd;
     for (NSInteger i = self.pieceNum, j = other.pieceNum; i < myCount && j < otherCount; i++, j++) {
         NSComparisonResult comparison = [FUtilities compareKey:self.pieces[i] toKey:other.pieces[j]];
         if (comparison != NSOrderedSame) {
@@ -279,7 +300,10 @@
     if (self.length != otherPath.length) {
         return NO;
     }
-    for (NSUInteger i = self.pieceNum, j = otherPath.pieceNum; i < self.pieces.count; i++, j++) {
+    if (_hash != 0 && otherPath->_hash != 0 && _hash != otherPath->_hash) {
+        return NO;
+    }
+    for (NSInteger i = self.pieceNum, j = otherPath.pieceNum; i < self.pieceEnd; i++, j++) {
         if (![self.pieces[i] isEqualToString:otherPath.pieces[j]]) {
             return NO;
         }
@@ -288,11 +312,15 @@
 }
 
 - (NSUInteger) hash {
-    NSUInteger hashCode = 0;
-    for (NSInteger i = self.pieceNum; i < self.pieces.count; i++) {
-        hashCode = hashCode * 37 + [self.pieces[i] hash];
+    if (_hash == 0) {
+        NSUInteger hashCode = 0;
+        for (NSInteger i = self.pieceNum; i < self.pieceEnd; i++) {
+            hashCode = hashCode * 37 + [self.pieces[i] hash];
+        }
+        // Zero marks a hash that isn't computed yet; racing threads store the same value.
+        _hash = hashCode == 0 ? 1 : hashCode;
     }
-    return hashCode;
+    return _hash;
 }
 
 @end
@@ -32,4 +32,12 @@
 - (void) raiseCallback:(fbt_void_void)callback;
 - (void) raiseCallbacks:(NSArray *)callbackList;
 
+/**
+* The number of events raised so far, and how long they took in total from being raised on the database queue until
+* the callback queue got to the end of their batch. On a concurrent callback queue the latter only covers dispatching.
+*/
+@property (nonatomic, readonly) NSUInteger numberOfRaisedEvents;
+@property (nonatomic, readonly) NSTimeInterval totalEventLatency;
+@property (nonatomic, readonly) NSTimeInterval maxEventLatency;
+
 @end
@@ -25,6 +25,9 @@
 @interface FEventRaiser ()
 
 @property (nonatomic, strong) dispatch_queue_t queue;
+@property (nonatomic, readwrite) NSUInteger numberOfRaisedEvents;
+@property (nonatomic, readwrite) NSTimeInterval totalEventLatency;
+@property (nonatomic, readwrite) NSTimeInterval maxEventLatency;
 
 @end
 
@@ -48,9 +51,44 @@
 }
 
 - (void) raiseEvents:(NSArray *)eventDataList {
+    if (eventDataList.count == 0) {
+        return;
+    }
+    NSDate *start = [NSDate date];
     for (id<FEvent> event in eventDataList) {
         [event fireEventOnQueue:self.queue];
     }
+    NSUInteger count = eventDataList.count;
+    dispatch_async(self.queue, ^{
+        [self recordEvents:count raisedAt:start];
+    });
+}
+
+- (void) recordEvents:(NSUInteger)count raisedAt:(NSDate *)start {
+    NSTimeInterval latency = [start timeIntervalSinceNow] * -1;
+    @synchronized(self) {
+        self->_numberOfRaisedEvents += count;
+        self->_totalEventLatency += latency * count;
+        self->_maxEventLatency = MAX(self->_maxEventLatency, latency);
+    }
+}
+
+- (NSUInteger) numberOfRaisedEvents {
+    @synchronized(self) {
+        return self->_numberOfRaisedEvents;
+    }
+}
+
+- (NSTimeInterval) totalEventLatency {
+    @synchronized(self) {
+        return self->_totalEventLatency;
+    }
+}
+
+- (NSTimeInterval) maxEventLatency {
+    @synchronized(self) {
+        return self->_maxEventLatency;
+    }
 }
 
 - (void) raiseCallback:(fbt_void_void)callback {
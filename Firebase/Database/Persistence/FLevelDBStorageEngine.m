@@ -25,8 +25,11 @@
 #import "FTrackedQuery.h"
 #import "FQueryParams.h"
 #import "FEmptyNode.h"
+#import "FMaxNode.h"
 #import "FPruneForest.h"
 #import "FUtilities.h"
+#import "FConstants.h"
+#import "FIRDatabaseQuery_Private.h"
 #import "FPendingPut.h" // For legacy migration
 
 @interface FLevelDBStorageEngine ()
@@ -35,6 +38,121 @@
 @property (nonatomic, strong) APLevelDB *writesDB;
 @property (nonatomic, strong) APLevelDB *serverCacheDB;
 
+// The number of bytes of server cache values, measured once and then kept up to date by every server cache
+// batch, or nil if not measured yet.
+@property (nonatomic, strong) NSNumber *serverCacheSize;
+
+// User writes that have not been committed yet. Writes are grouped into a single batch until the database queue
+// gets around to committing it, or until the writes are read or removed.
+@property (nonatomic, strong) id<APLevelDBWriteBatch> pendingUserWrites;
+@property (nonatomic) NSUInteger pendingUserWriteCount;
+
+// The valid indexes on the server cache, see FServerCacheIndex.
+@property (nonatomic, strong) NSMutableArray *serverCacheIndexes;
+@property (nonatomic) NSUInteger nextServerCacheIndexId;
+
+@end
+
+/**
+ * An index of the children at a location of the server cache, ordered by the value at a child path like an
+ * FPathIndex orders them, so that ordered and limited queries can find their children without loading all of them.
+ *
+ * Each child has an order row, whose key sorts like the child does in the index and whose value is the child key,
+ * and a row mapping the child key back to the key of its order row.
+ */
+@interface FServerCacheIndex : NSObject
+
+@property (nonatomic) NSUInteger indexId;
+@property (nonatomic, strong) FPath *path;
+@property (nonatomic, strong) FPath *childPath;
+
+@end
+
+@implementation FServerCacheIndex
+@end
+
+/**
+ * A write batch on the server cache that keeps track of how many bytes of values it adds and removes, so the size
+ * of the cache can be kept without scanning it. Keys are expected to be removed before they are set again.
+ */
+@interface FServerCacheWriteBatch : NSObject <APLevelDBWriteBatch>
+
+- (id)initWithDatabase:(APLevelDB *)database;
+
+/** Removes a row whose value is already known, without reading it again. */
+- (void)removeKey:(NSString *)key withValue:(NSData *)value;
+
+/** Removes all rows whose key starts with prefix, reading their sizes in the same scan. */
+- (void)removeAllWithPrefix:(NSString *)prefix;
+
+/** Sets a row that is not part of the server cache, like an index definition, without counting it. */
+- (void)setUncountedData:(NSData *)data forKey:(NSString *)key;
+
+/** The number of bytes added minus the number of bytes removed so far. */
+@property (nonatomic, readonly) NSInteger sizeDelta;
+
+@end
+
+@implementation FServerCacheWriteBatch {
+    APLevelDB *_database;
+    id<APLevelDBWriteBatch> _batch;
+    NSMutableSet *_removedKeys;
+}
+
+- (id)initWithDatabase:(APLevelDB *)database {
+    self = [super init];
+    if (self) {
+        _database = database;
+        _batch = [database beginWriteBatch];
+        _removedKeys = [NSMutableSet set];
+    }
+    return self;
+}
+
+- (void)setData:(NSData *)data forKey:(NSString *)key {
+    _sizeDelta += (NSInteger)data.length;
+    [_batch setData:data forKey:key];
+}
+
+- (void)setString:(NSString *)str forKey:(NSString *)key {
+    [self setData:[str dataUsingEncoding:NSUTF8StringEncoding] forKey:key];
+}
+
+- (void)setUncountedData:(NSData *)data forKey:(NSString *)key {
+    [_batch setData:data forKey:key];
+}
+
+- (void)removeKey:(NSString *)key {
+    if (![_removedKeys containsObject:key]) {
+        [self removeKey:key withValue:[_database dataForKey:key]];
+    }
+}
+
+- (void)removeKey:(NSString *)key withValue:(NSData *)value {
+    if ([_removedKeys containsObject:key]) {
+        return;
+    }
+    [_removedKeys addObject:key];
+    _sizeDelta -= (NSInteger)value.length;
+    [_batch removeKey:key];
+}
+
+- (void)removeAllWithPrefix:(NSString *)prefix {
+    [_database enumerateKeysWithPrefix:prefix asData:^(NSString *key, NSData *value, BOOL *stop) {
+        [self removeKey:key withValue:value];
+    }];
+}
+
+- (void)clear {
+    [_batch clear];
+    [_removedKeys removeAllObjects];
+    _sizeDelta = 0;
+}
+
+- (BOOL)commit {
+    return [_batch commit];
+}
+
 @end
 
 // WARNING: If you change this, you need to write a migration script
@@ -61,10 +179,26 @@ static NSString * const kFServerCachePrefix = @"/server_cache/";
 static NSString * const kFServerCacheRangeEnd = @"/server_cache~";
 static NSString * const kFTrackedQueriesPrefix = @"/tracked_queries/";
 static NSString * const kFTrackedQueryKeysPrefix = @"/tracked_query_keys/";
+static NSString * const kFServerCacheIndexesPrefix = @"/cache_index_defs/";
+static NSString * const kFServerCacheIndexRowsPrefix = @"/cache_indexes/";
+
+static NSString * const kFServerCacheIndexPath = @"path";
+static NSString * const kFServerCacheIndexChildPath = @"child";
+static NSString * const kFServerCacheIndexIsValid = @"valid";
 
 // Failed to load JSON because a valid JSON turns out to be NaN while deserializing
 static const NSInteger kFNanFailureCode = 3840;
 
+// Server cache leaves are stored as a type tag followed by the value, rather than as JSON. The tags are control
+// characters, which cannot start a JSON value, so leaves written as JSON by earlier versions can still be read.
+typedef NS_ENUM(uint8_t, FLeafTag) {
+    FLeafTagString = 0x01,  // followed by the UTF-8 bytes, up to the end of the row
+    FLeafTagInteger = 0x02, // followed by a little-endian int64_t
+    FLeafTagDouble = 0x03,  // followed by the little-endian bits of a double
+    FLeafTagTrue = 0x04,
+    FLeafTagFalse = 0x05,
+};
+
 static NSString* writeRecordKey(NSUInteger writeId) {
     return [NSString stringWithFormat:@"%lu", (unsigned long)(writeId)];
 }
@@ -85,6 +219,91 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     return [NSString stringWithFormat:@"%@%lu/%@", kFTrackedQueryKeysPrefix, (unsigned long)trackedQueryId, key];
 }
 
+static NSString* serverCacheIndexKey(NSUInteger indexId) {
+    return [NSString stringWithFormat:@"%@%lu", kFServerCacheIndexesPrefix, (unsigned long)indexId];
+}
+
+static NSString* serverCacheIndexRowsPrefix(NSUInteger indexId) {
+    return [NSString stringWithFormat:@"%@%lu/", kFServerCacheIndexRowsPrefix, (unsigned long)indexId];
+}
+
+static NSString* serverCacheIndexOrderPrefix(NSUInteger indexId) {
+    return [NSString stringWithFormat:@"%@%lu/o/", kFServerCacheIndexRowsPrefix, (unsigned long)indexId];
+}
+
+static NSString* serverCacheIndexChildKey(NSUInteger indexId, NSString *childKey) {
+    return [NSString stringWithFormat:@"%@%lu/k/%@", kFServerCacheIndexRowsPrefix, (unsigned long)indexId, childKey];
+}
+
+// Appends each UTF-16 code unit as four hex digits, which sort like NSLiteralSearch compares the strings.
+static void appendSortableString(NSMutableString *sortKey, NSString *string) {
+    NSUInteger length = string.length;
+    unichar *characters = malloc(sizeof(unichar) * length);
+    char *hex = malloc(4 * length + 1);
+    [string getCharacters:characters range:NSMakeRange(0, length)];
+    for (NSUInteger i = 0; i < length; i++) {
+        snprintf(hex + 4 * i, 5, "%04x", characters[i]);
+    }
+    hex[4 * length] = '\0';
+    [sortKey appendString:[NSString stringWithUTF8String:hex]];
+    free(hex);
+    free(characters);
+}
+
+/**
+ * Returns a string that sorts (bytewise, like LevelDB keys) the same way FPathIndex sorts children with the given
+ * value at the index path and the given key. The value sorts empty < server values < booleans < numbers < strings
+ * < objects like FNode compare:, and is ended by '!', which is less than any character used to encode it. The key
+ * then sorts integer keys before other keys like FUtilities compareKey:toKey:. Numbers are compared as doubles, so
+ * integers beyond 2^53 that round to the same double sort by key.
+ */
+static NSString* serverCacheIndexSortKey(id<FNode> value, NSString *key) {
+    NSMutableString *sortKey = [NSMutableString string];
+    if (value == [FMaxNode maxNode]) {
+        [sortKey appendString:@"g"];
+    } else if (value.isEmpty) {
+        [sortKey appendString:@"a"];
+    } else if (!value.isLeafNode) {
+        [sortKey appendString:@"f"];
+    } else {
+        id val = value.val;
+        NSString *type = [FUtilities getJavascriptType:val];
+        if (type == kJavaScriptBoolean) {
+            [sortKey appendString:[val boolValue] ? @"c1" : @"c0"];
+        } else if (type == kJavaScriptNumber) {
+            // Flip the sign bit of positive numbers and all bits of negative ones, so the bits sort like the numbers.
+            double number = [val doubleValue];
+            if (number == 0) {
+                number = 0; // Sort -0 like 0.
+            }
+            uint64_t bits;
+            memcpy(&bits, &number, sizeof(bits));
+            bits = (bits & (1ULL << 63)) ? ~bits : bits | (1ULL << 63);
+            [sortKey appendFormat:@"d%016llx", (unsigned long long)bits];
+        } else if (type == kJavaScriptString) {
+            [sortKey appendString:@"e"];
+            appendSortableString(sortKey, val);
+        } else {
+            [sortKey appendString:@"b"];
+        }
+    }
+    [sortKey appendString:@"!"];
+
+    NSInteger intKey;
+    if (key == [FUtilities minName]) {
+        // Sorts before everything.
+    } else if (key == [FUtilities maxName]) {
+        [sortKey appendString:@"~"];
+    } else if ([FUtilities tryParseKey:key asInt:&intKey]) {
+        // Integer keys sort by value, then by length (e.g. "-0" after "0").
+        [sortKey appendFormat:@"i%08x%x", (uint32_t)((int64_t)intKey - INT32_MIN), (unsigned)key.length];
+    } else {
+        [sortKey appendString:@"s"];
+        appendSortableString(sortKey, key);
+    }
+    return sortKey;
+}
+
 @implementation FLevelDBStorageEngine
 #pragma mark - Constructors
 
@@ -178,6 +397,7 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 - (void)openDatabases {
     self.serverCacheDB = [self createDB:kFServerDBPath];
     self.writesDB = [self createDB:kFWritesDBPath];
+    [self loadServerCacheIndexes];
 }
 
 - (void)purgeDatabase:(NSString*) dbPath {
@@ -201,6 +421,9 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 }
 
 - (void)close {
+    [self commitPendingUserWrites];
+    self.serverCacheSize = nil;
+    self.serverCacheIndexes = nil;
     // autoreleasepool will cause deallocation which will close the DB
     @autoreleasepool {
         [self.serverCacheDB close];
@@ -251,7 +474,7 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     NSError *error = nil;
     NSData *data = [NSJSONSerialization dataWithJSONObject:write options:0 error:&error];
     NSAssert(data, @"Failed to serialize user overwrite: %@, (Error: %@)", write, error);
-    [self.writesDB setData:data forKey:writeRecordKey(writeId)];
+    [self saveUserWrite:data writeId:writeId];
 }
 
 - (void)saveUserMerge:(FCompoundWrite *)merge atPath:(FPath *)path writeId:(NSUInteger)writeId {
@@ -262,14 +485,46 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     NSError *error = nil;
     NSData *data = [NSJSONSerialization dataWithJSONObject:write options:0 error:&error];
     NSAssert(data, @"Failed to serialize user merge: %@ (Error: %@)", write, error);
-    [self.writesDB setData:data forKey:writeRecordKey(writeId)];
+    [self saveUserWrite:data writeId:writeId];
+}
+
+- (void)saveUserWrite:(NSData *)data writeId:(NSUInteger)writeId {
+    @synchronized(self) {
+        if (self.pendingUserWrites == nil) {
+            self.pendingUserWrites = [self.writesDB beginWriteBatch];
+            // Writes issued in a burst are all queued by the time this runs, so they end up in one batch.
+            dispatch_async([FIRDatabaseQuery sharedQueue], ^{
+                [self commitPendingUserWrites];
+            });
+        }
+        [self.pendingUserWrites setData:data forKey:writeRecordKey(writeId)];
+        self.pendingUserWriteCount++;
+    }
+}
+
+- (void)commitPendingUserWrites {
+    @synchronized(self) {
+        if (self.pendingUserWrites == nil) {
+            return;
+        }
+        BOOL success = [self.pendingUserWrites commit];
+        if (!success) {
+            FFWarn(@"I-RDB076038", @"Failed to save %lu user writes on disk!", (unsigned long)self.pendingUserWriteCount);
+        } else {
+            FFDebug(@"I-RDB076039", @"Saved %lu user writes", (unsigned long)self.pendingUserWriteCount);
+        }
+        self.pendingUserWrites = nil;
+        self.pendingUserWriteCount = 0;
+    }
 }
 
 - (void)removeUserWrite:(NSUInteger)writeId {
+    [self commitPendingUserWrites];
     [self.writesDB removeKey:writeRecordKey(writeId)];
 }
 
 - (void)removeAllUserWrites {
+    [self commitPendingUserWrites];
     __block NSUInteger count = 0;
     NSDate *start = [NSDate date];
     id<APLevelDBWriteBatch> batch = [self.writesDB beginWriteBatch];
@@ -286,6 +541,7 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 }
 
 - (NSArray *)userWrites {
+    [self commitPendingUserWrites];
     NSDate *date = [NSDate date];
     NSMutableArray *writes = [NSMutableArray array];
     [self.writesDB enumerateKeysAndValuesAsData:^(NSString *key, NSData *data, BOOL *stop) {
@@ -351,48 +607,86 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     return node;
 }
 
+- (NSDictionary *)serverCacheChildrenAtPath:(FPath *)path valuesAtChildPath:(FPath *)childPath {
+    NSDate *start = [NSDate date];
+    NSString *baseKey = serverCacheKey(path);
+    NSMutableDictionary *children = [NSMutableDictionary dictionary];
+    @autoreleasepool {
+        APLevelDBIterator *iter = [APLevelDBIterator iteratorWithLevelDB:self.serverCacheDB];
+        [iter seekToKey:baseKey];
+        NSString *key = iter.key;
+        while (key != nil && [key hasPrefix:baseKey] && key.length > baseKey.length) {
+            NSRange rest = NSMakeRange(baseKey.length, key.length - baseKey.length);
+            NSRange slash = [key rangeOfString:@"/" options:NSLiteralSearch range:rest];
+            assert(slash.location != NSNotFound);
+            NSString *childName = [key substringWithRange:NSMakeRange(rest.location, slash.location - rest.location)];
+            if (childPath != nil) {
+                id data = [self internalNestedDataForPath:[[path childFromString:childName] child:childPath]];
+                children[childName] = [FSnapshotUtilities nodeFrom:data];
+            } else {
+                children[childName] = [FEmptyNode emptyNode];
+            }
+
+            // Skip the remaining rows of the child: '0' is the character right after '/'.
+            [iter seekToKey:[NSString stringWithFormat:@"%@%@0", baseKey, childName]];
+            key = iter.key;
+        }
+    }
+    FFDebug(@"I-RDB076037", @"Loaded index values of %lu children at %@ in %fms", (unsigned long)children.count, path, [start timeIntervalSinceNow]*-1000);
+    return children;
+}
+
 - (void)updateServerCache:(id<FNode>)node atPath:(FPath *)path merge:(BOOL)merge {
     NSDate *start = [NSDate date];
-    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    FServerCacheWriteBatch *batch = [[FServerCacheWriteBatch alloc] initWithDatabase:self.serverCacheDB];
     // Remove any leaf nodes that might be higher up
     [self removeAllLeafNodesOnPath:path batch:batch];
     __block NSUInteger counter = 0;
+    NSMutableArray *writtenPaths = [NSMutableArray array];
     if (merge) {
         // remove any children that exist
         [node enumerateChildrenUsingBlock:^(NSString *childKey, id<FNode> childNode, BOOL *stop) {
             FPath *childPath = [path childFromString:childKey];
-            [self removeAllWithPrefix:serverCacheKey(childPath) batch:batch database:self.serverCacheDB];
+            [batch removeAllWithPrefix:serverCacheKey(childPath)];
             [self saveNodeInternal:childNode atPath:childPath batch:batch counter:&counter];
+            [writtenPaths addObject:childPath];
         }];
     } else {
         // remove everything
-        [self removeAllWithPrefix:serverCacheKey(path) batch:batch database:self.serverCacheDB];
+        [batch removeAllWithPrefix:serverCacheKey(path)];
         [self saveNodeInternal:node atPath:path batch:batch counter:&counter];
+        [writtenPaths addObject:path];
     }
-    BOOL success = [batch commit];
+    NSMapTable *indexChanges = [self serverCacheIndexChangesForWritesAtPaths:writtenPaths batch:batch];
+    BOOL success = [self commitServerCacheBatch:batch];
     if (!success) {
         FFWarn(@"I-RDB076017", @"Failed to update server cache on disk!");
     } else {
         FFDebug(@"I-RDB076018", @"Saved %lu leaf nodes for overwrite in %fms", (unsigned long)counter, [start timeIntervalSinceNow]*-1000);
+        [self applyServerCacheIndexChanges:indexChanges];
     }
 }
 
 - (void)updateServerCacheWithMerge:(FCompoundWrite *)merge atPath:(FPath *)path {
     NSDate *start = [NSDate date];
     __block NSUInteger counter = 0;
-    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    FServerCacheWriteBatch *batch = [[FServerCacheWriteBatch alloc] initWithDatabase:self.serverCacheDB];
     // Remove any leaf nodes that might be higher up
     [self removeAllLeafNodesOnPath:path batch:batch];
+    NSMutableArray *writtenPaths = [NSMutableArray array];
     [merge enumerateWrites:^(FPath *relativePath, id<FNode> node, BOOL *stop) {
         FPath *childPath = [path child:relativePath];
-        [self removeAllWithPrefix:serverCacheKey(childPath) batch:batch database:self.serverCacheDB];
+        [batch removeAllWithPrefix:serverCacheKey(childPath)];
         [self saveNodeInternal:node atPath:childPath batch:batch counter:&counter];
+        [writtenPaths addObject:childPath];
     }];
-    BOOL success = [batch commit];
+    NSMapTable *indexChanges = [self serverCacheIndexChangesForWritesAtPaths:writtenPaths batch:batch];
+    BOOL success = [self commitServerCacheBatch:batch];
     if (!success) {
         FFWarn(@"I-RDB076019", @"Failed to update server cache on disk!");
     } else {
         FFDebug(@"I-RDB076020", @"Saved %lu leaf nodes for merge in %fms", (unsigned long)counter, [start timeIntervalSinceNow]*-1000);
+        [self applyServerCacheIndexChanges:indexChanges];
     }
 }
 
@@ -404,37 +698,281 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 }
 
 - (NSUInteger)serverCacheEstimatedSizeInBytes {
-    // Use the exact size, because for pruning the approximate size can lead to weird situations where we prune everything
-    // because no compaction is ever run
-    return [self.serverCacheDB exactSizeFrom:kFServerCachePrefix to:kFServerCacheRangeEnd];
+    if (self.serverCacheSize == nil) {
+        // Use the exact size, because for pruning the approximate size can lead to weird situations where we prune
+        // everything because no compaction is ever run. Measure it only once, the batches keep it up to date.
+        self.serverCacheSize = @([self.serverCacheDB exactSizeFrom:kFServerCachePrefix to:kFServerCacheRangeEnd]);
+    }
+    return self.serverCacheSize.unsignedIntegerValue;
 }
 
-- (void)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)path {
-    // TODO: be more intelligent, don't scan entire database...
+- (BOOL)commitServerCacheBatch:(FServerCacheWriteBatch *)batch {
+    BOOL success = [batch commit];
+    if (success && self.serverCacheSize != nil) {
+        NSInteger size = (NSInteger)self.serverCacheSize.unsignedIntegerValue + batch.sizeDelta;
+        self.serverCacheSize = @((NSUInteger)MAX(size, 0));
+    } else if (!success) {
+        // Don't guess what made it to disk.
+        self.serverCacheSize = nil;
+    }
+    return success;
+}
 
+- (void)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)path {
     __block NSUInteger pruned = 0;
     __block NSUInteger kept = 0;
     NSDate *start = [NSDate date];
 
     NSString *prefix = serverCacheKey(path);
-    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
-
-    [self.serverCacheDB enumerateKeysWithPrefix:prefix usingBlock:^(NSString *dbKey, BOOL *stop) {
-        NSString *pathStr = [dbKey substringFromIndex:prefix.length];
-        FPath *relativePath = [[FPath alloc] initWith:pathStr];
-        if ([pruneForest shouldPruneUnkeptDescendantsAtPath:relativePath]) {
-            pruned++;
-            [batch removeKey:dbKey];
-        } else {
-            kept++;
-        }
+    FServerCacheWriteBatch *batch = [[FServerCacheWriteBatch alloc] initWithDatabase:self.serverCacheDB];
+
+    // Only scan the subtrees that are pruned, rather than the whole cache.
+    NSMutableArray *prunedPaths = [NSMutableArray array];
+    [pruneForest enumeratePrunedPathsUsingBlock:^(FPath *prunedPath) {
+        [prunedPaths addObject:[path child:prunedPath]];
+        NSString *prunedPrefix = serverCacheKey([path child:prunedPath]);
+        [self.serverCacheDB enumerateKeysWithPrefix:prunedPrefix asData:^(NSString *dbKey, NSData *value, BOOL *stop) {
+            NSString *pathStr = [dbKey substringFromIndex:prefix.length];
+            FPath *relativePath = [[FPath alloc] initWith:pathStr];
+            if ([pruneForest shouldPruneUnkeptDescendantsAtPath:relativePath]) {
+                pruned++;
+                [batch removeKey:dbKey withValue:value];
+            } else {
+                kept++;
+            }
+        }];
     }];
-    BOOL success = [batch commit];
+    // Indexes of pruned locations aren't worth keeping up to date, they are recreated when they are needed again.
+    NSMapTable *indexChanges = [self serverCacheIndexChangesForWritesAtPaths:prunedPaths batch:batch];
+    BOOL success = [self commitServerCacheBatch:batch];
     if (!success) {
         FFWarn(@"I-RDB076021", @"Failed to prune cache on disk!");
     } else {
         FFDebug(@"I-RDB076022", @"Pruned %lu paths, kept %lu paths in %fms", (unsigned long)pruned, (unsigned long)kept, [start timeIntervalSinceNow]*-1000);
+        for (FServerCacheIndex *index in indexChanges) {
+            [self removeServerCacheIndex:index];
+        }
+    }
+}
+
+#pragma mark - Server Cache Indexes
+
+- (void)loadServerCacheIndexes {
+    NSMutableArray *indexes = [NSMutableArray array];
+    __block NSUInteger nextIndexId = 0;
+    NSMutableArray *invalidIds = [NSMutableArray array];
+    [self.serverCacheDB enumerateKeysWithPrefix:kFServerCacheIndexesPrefix asData:^(NSString *key, NSData *data, BOOL *stop) {
+        NSUInteger indexId = (NSUInteger)[[key substringFromIndex:kFServerCacheIndexesPrefix.length] integerValue];
+        nextIndexId = MAX(nextIndexId, indexId + 1);
+        NSDictionary *indexJSON = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+        if ([indexJSON[kFServerCacheIndexIsValid] boolValue]) {
+            FServerCacheIndex *index = [[FServerCacheIndex alloc] init];
+            index.indexId = indexId;
+            index.path = [FPath pathWithString:indexJSON[kFServerCacheIndexPath]];
+            index.childPath = [FPath pathWithString:indexJSON[kFServerCacheIndexChildPath]];
+            [indexes addObject:index];
+        } else {
+            // A previous update did not get to bring the index up to date.
+            [invalidIds addObject:@(indexId)];
+        }
+    }];
+    self.serverCacheIndexes = indexes;
+    self.nextServerCacheIndexId = nextIndexId;
+
+    for (NSNumber *indexId in invalidIds) {
+        FServerCacheIndex *index = [[FServerCacheIndex alloc] init];
+        index.indexId = indexId.unsignedIntegerValue;
+        [self removeServerCacheIndex:index];
+    }
+    FFDebug(@"I-RDB076040", @"Loaded %lu server cache indexes, dropped %lu invalid ones", (unsigned long)indexes.count, (unsigned long)invalidIds.count);
+}
+
+- (NSData *)serverCacheIndexData:(FServerCacheIndex *)index isValid:(BOOL)isValid {
+    NSDictionary *indexJSON = @{
+        kFServerCacheIndexPath: [index.path toStringWithTrailingSlash],
+        kFServerCacheIndexChildPath: [index.childPath toStringWithTrailingSlash],
+        kFServerCacheIndexIsValid: @(isValid)
+    };
+    NSError *error = nil;
+    NSData *data = [NSJSONSerialization dataWithJSONObject:indexJSON options:0 error:&error];
+    NSAssert(data, @"Failed to serialize server cache index (Error: %@)", error);
+    return data;
+}
+
+- (void)removeServerCacheIndex:(FServerCacheIndex *)index {
+    [self.serverCacheIndexes removeObject:index];
+    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    [batch removeKey:serverCacheIndexKey(index.indexId)];
+    [self removeAllWithPrefix:serverCacheIndexRowsPrefix(index.indexId) batch:batch database:self.serverCacheDB];
+    if (![batch commit]) {
+        FFWarn(@"I-RDB076041", @"Failed to remove server cache index on disk!");
+    }
+}
+
+/**
+ * Finds the indexes affected by writes at the given paths, and marks them as invalid in the given batch until
+ * applyServerCacheIndexChanges: brings them up to date, in case the app is killed in between. Returns a map from an
+ * affected index to the set of child keys it needs to update, or to NSNull if it needs to be rebuilt.
+ */
+- (NSMapTable *)serverCacheIndexChangesForWritesAtPaths:(NSArray *)paths batch:(FServerCacheWriteBatch *)batch {
+    NSMapTable *changes = [NSMapTable strongToStrongObjectsMapTable];
+    for (FServerCacheIndex *index in self.serverCacheIndexes) {
+        for (FPath *path in paths) {
+            if ([path contains:index.path]) {
+                [changes setObject:[NSNull null] forKey:index];
+                break;
+            } else if ([index.path contains:path]) {
+                NSMutableSet *childKeys = [changes objectForKey:index] ?: [NSMutableSet set];
+                [childKeys addObject:[[FPath relativePathFrom:index.path to:path] getFront]];
+                [changes setObject:childKeys forKey:index];
+            }
+        }
+        if ([changes objectForKey:index] != nil) {
+            [batch setUncountedData:[self serverCacheIndexData:index isValid:NO] forKey:serverCacheIndexKey(index.indexId)];
+        }
+    }
+    return changes;
+}
+
+- (void)applyServerCacheIndexChanges:(NSMapTable *)changes {
+    if (changes.count == 0) {
+        return;
+    }
+    NSDate *start = [NSDate date];
+    __block NSUInteger updated = 0;
+    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    for (FServerCacheIndex *index in changes) {
+        id childKeys = [changes objectForKey:index];
+        if (childKeys == [NSNull null]) {
+            [self removeAllWithPrefix:serverCacheIndexRowsPrefix(index.indexId) batch:batch database:self.serverCacheDB];
+            NSDictionary *values = [self serverCacheChildrenAtPath:index.path valuesAtChildPath:index.childPath];
+            [values enumerateKeysAndObjectsUsingBlock:^(NSString *childKey, id<FNode> value, BOOL *stop) {
+                [self setServerCacheIndex:index value:value forChild:childKey previousSortKey:nil batch:batch];
+                updated++;
+            }];
+        } else {
+            for (NSString *childKey in childKeys) {
+                [self updateServerCacheIndex:index forChild:childKey batch:batch];
+                updated++;
+            }
+        }
+        [batch setData:[self serverCacheIndexData:index isValid:YES] forKey:serverCacheIndexKey(index.indexId)];
+    }
+    if (![batch commit]) {
+        FFWarn(@"I-RDB076042", @"Failed to update server cache indexes on disk!");
+        // They are still marked as invalid on disk.
+        for (FServerCacheIndex *index in changes) {
+            [self.serverCacheIndexes removeObject:index];
+        }
+    } else {
+        FFDebug(@"I-RDB076043", @"Updated %lu server cache index entries in %fms", (unsigned long)updated, [start timeIntervalSinceNow]*-1000);
+    }
+}
+
+- (void)updateServerCacheIndex:(FServerCacheIndex *)index forChild:(NSString *)childKey batch:(id<APLevelDBWriteBatch>)batch {
+    NSString *previousSortKey = [self.serverCacheDB stringForKey:serverCacheIndexChildKey(index.indexId, childKey)];
+    FPath *childPath = [index.path childFromString:childKey];
+    NSString *childPrefix = serverCacheKey(childPath);
+    BOOL childExists;
+    @autoreleasepool {
+        APLevelDBIterator *iter = [APLevelDBIterator iteratorWithLevelDB:self.serverCacheDB];
+        [iter seekToKey:childPrefix];
+        childExists = iter.key != nil && [iter.key hasPrefix:childPrefix];
+    }
+
+    if (childExists) {
+        id data = [self internalNestedDataForPath:[childPath child:index.childPath]];
+        [self setServerCacheIndex:index
+                            value:[FSnapshotUtilities nodeFrom:data]
+                         forChild:childKey
+                  previousSortKey:previousSortKey
+                            batch:batch];
+    } else if (previousSortKey != nil) {
+        [batch removeKey:[serverCacheIndexOrderPrefix(index.indexId) stringByAppendingString:previousSortKey]];
+        [batch removeKey:serverCacheIndexChildKey(index.indexId, childKey)];
+    }
+}
+
+- (void)setServerCacheIndex:(FServerCacheIndex *)index
+                      value:(id<FNode>)value
+                   forChild:(NSString *)childKey
+            previousSortKey:(NSString *)previousSortKey
+                      batch:(id<APLevelDBWriteBatch>)batch {
+    NSString *orderPrefix = serverCacheIndexOrderPrefix(index.indexId);
+    NSString *sortKey = serverCacheIndexSortKey(value, childKey);
+    if (previousSortKey != nil && ![previousSortKey isEqualToString:sortKey]) {
+        [batch removeKey:[orderPrefix stringByAppendingString:previousSortKey]];
+    }
+    [batch setString:childKey forKey:[orderPrefix stringByAppendingString:sortKey]];
+    [batch setString:sortKey forKey:serverCacheIndexChildKey(index.indexId, childKey)];
+}
+
+- (FServerCacheIndex *)createServerCacheIndexAtPath:(FPath *)path childPath:(FPath *)childPath {
+    NSDate *start = [NSDate date];
+    FServerCacheIndex *index = [[FServerCacheIndex alloc] init];
+    index.indexId = self.nextServerCacheIndexId++;
+    index.path = path;
+    index.childPath = childPath;
+
+    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    NSDictionary *values = [self serverCacheChildrenAtPath:path valuesAtChildPath:childPath];
+    [values enumerateKeysAndObjectsUsingBlock:^(NSString *childKey, id<FNode> value, BOOL *stop) {
+        [self setServerCacheIndex:index value:value forChild:childKey previousSortKey:nil batch:batch];
+    }];
+    [batch setData:[self serverCacheIndexData:index isValid:YES] forKey:serverCacheIndexKey(index.indexId)];
+    if (![batch commit]) {
+        FFWarn(@"I-RDB076044", @"Failed to save server cache index on disk!");
+        return nil;
+    }
+    [self.serverCacheIndexes addObject:index];
+    FFDebug(@"I-RDB076045", @"Indexed %lu children at %@ by %@ in %fms", (unsigned long)values.count, path, childPath, [start timeIntervalSinceNow]*-1000);
+    return index;
+}
+
+- (NSArray *)serverCacheKeysAtPath:(FPath *)path orderedByChild:(FPath *)childPath params:(FQueryParams *)params {
+    FServerCacheIndex *index = nil;
+    for (FServerCacheIndex *existing in self.serverCacheIndexes) {
+        if ([existing.path isEqual:path] && [existing.childPath isEqual:childPath]) {
+            index = existing;
+            break;
+        }
+    }
+    if (index == nil) {
+        index = [self createServerCacheIndexAtPath:path childPath:childPath];
+        if (index == nil) {
+            return nil;
+        }
+    }
+
+    NSDate *start = [NSDate date];
+    NSString *orderPrefix = serverCacheIndexOrderPrefix(index.indexId);
+    NSString *startKey = params.hasStart ? serverCacheIndexSortKey(params.indexStartValue, params.indexStartKey) : @"";
+    NSString *endKey = params.hasEnd ? serverCacheIndexSortKey(params.indexEndValue, params.indexEndKey) : nil;
+    NSUInteger limit = params.limitSet ? (NSUInteger)params.limit : NSUIntegerMax;
+    BOOL fromLeft = [params isViewFromLeft];
+
+    NSMutableArray *keys = [NSMutableArray array];
+    @autoreleasepool {
+        APLevelDBIterator *iter = [APLevelDBIterator iteratorWithLevelDB:self.serverCacheDB];
+        [iter seekToKey:[orderPrefix stringByAppendingString:startKey]];
+        NSString *key = iter.key;
+        while (key != nil && [key hasPrefix:orderPrefix]) {
+            NSString *sortKey = [key substringFromIndex:orderPrefix.length];
+            if (endKey != nil && [sortKey compare:endKey options:NSLiteralSearch] == NSOrderedDescending) {
+                break;
+            }
+            [keys addObject:iter.valueAsString];
+            if (keys.count > limit) {
+                // Only a view from the right gets here, it keeps the last children in range.
+                [keys removeObjectAtIndex:0];
+            } else if (fromLeft && keys.count == limit) {
+                break;
+            }
+            key = [iter nextKey];
+        }
     }
+    FFDebug(@"I-RDB076046", @"Read %lu indexed keys at %@ in %fms", (unsigned long)keys.count, path, [start timeIntervalSinceNow]*-1000);
+    return keys;
 }
 
 #pragma mark - Tracked Queries
@@ -647,10 +1185,11 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     } else {
         NSMutableDictionary *dict = [[NSMutableDictionary alloc] init];
         while (key != nil && [key hasPrefix:prefix]) {
-            NSString *relativePath = [key substringFromIndex:prefix.length];
-            NSArray* pathPieces = [relativePath componentsSeparatedByString:@"/"];
-            assert(pathPieces.count > 0);
-            NSString *childName = pathPieces[0];
+            // Keys always end with a slash, so the child name is everything up to the next one.
+            NSRange rest = NSMakeRange(prefix.length, key.length - prefix.length);
+            NSRange slash = [key rangeOfString:@"/" options:NSLiteralSearch range:rest];
+            assert(slash.location != NSNotFound);
+            NSString *childName = [key substringWithRange:NSMakeRange(rest.location, slash.location - rest.location)];
             NSString *childPath = [NSString stringWithFormat:@"%@%@/", prefix, childName];
             id childValue = [self internalNestedDataFromIterator:iterator andKeyPrefix:childPath];
             [dict setValue:childValue forKey:childName];
@@ -663,13 +1202,67 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 
 
 - (NSData*) serializePrimitive:(id)value {
-    // HACK: The built-in serialization only works on dicts and arrays.  So we create an array and then strip off
-    // the leading / trailing byte (the [ and ]).
-    NSError *error = nil;
-    NSData *data = [NSJSONSerialization dataWithJSONObject:@[value] options:0 error:&error];
-    NSAssert(data, @"Failed to serialize primitive: %@", error);
+    if ([value isKindOfClass:[NSString class]]) {
+        NSString *string = value;
+        NSMutableData *data = [NSMutableData dataWithCapacity:1 + [string lengthOfBytesUsingEncoding:NSUTF8StringEncoding]];
+        uint8_t tag = FLeafTagString;
+        [data appendBytes:&tag length:1];
+        [data appendData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+        return data;
+    }
+
+    NSAssert([value isKindOfClass:[NSNumber class]], @"Failed to serialize primitive of type %@", [value class]);
+    NSNumber *number = value;
+    const char *type = [number objCType];
+    if ([[FUtilities getJavascriptType:number] isEqualToString:kJavaScriptBoolean]) {
+        uint8_t tag = [number boolValue] ? FLeafTagTrue : FLeafTagFalse;
+        return [NSData dataWithBytes:&tag length:1];
+    } else if (strcmp(type, @encode(double)) == 0 || strcmp(type, @encode(float)) == 0 ||
+               (strcmp(type, @encode(unsigned long long)) == 0 && [number unsignedLongLongValue] > INT64_MAX)) {
+        uint8_t bytes[1 + sizeof(double)] = {FLeafTagDouble};
+        double doubleValue = [number doubleValue];
+        uint64_t littleEndian;
+        memcpy(&littleEndian, &doubleValue, sizeof(littleEndian));
+        littleEndian = CFSwapInt64HostToLittle(littleEndian);
+        memcpy(bytes + 1, &littleEndian, sizeof(littleEndian));
+        return [NSData dataWithBytes:bytes length:sizeof(bytes)];
+    } else {
+        uint8_t bytes[1 + sizeof(int64_t)] = {FLeafTagInteger};
+        uint64_t littleEndian = CFSwapInt64HostToLittle((uint64_t)[number longLongValue]);
+        memcpy(bytes + 1, &littleEndian, sizeof(littleEndian));
+        return [NSData dataWithBytes:bytes length:sizeof(bytes)];
+    }
+}
 
-    return [data subdataWithRange:NSMakeRange(1, data.length - 2)];
+/** Decodes a leaf written by serializePrimitive:, or returns nil if it was written as JSON. */
+- (id) deserializeTaggedPrimitive:(NSData *)data {
+    if (data.length == 0) {
+        return nil;
+    }
+    const uint8_t *bytes = data.bytes;
+    uint64_t littleEndian = 0;
+    switch (bytes[0]) {
+        case FLeafTagString:
+            return [[NSString alloc] initWithBytes:bytes + 1 length:data.length - 1 encoding:NSUTF8StringEncoding];
+        case FLeafTagInteger:
+            NSAssert(data.length == 1 + sizeof(int64_t), @"Invalid integer leaf");
+            memcpy(&littleEndian, bytes + 1, sizeof(littleEndian));
+            return [NSNumber numberWithLongLong:(int64_t)CFSwapInt64LittleToHost(littleEndian)];
+        case FLeafTagDouble: {
+            NSAssert(data.length == 1 + sizeof(double), @"Invalid double leaf");
+            memcpy(&littleEndian, bytes + 1, sizeof(littleEndian));
+            littleEndian = CFSwapInt64LittleToHost(littleEndian);
+            double doubleValue;
+            memcpy(&doubleValue, &littleEndian, sizeof(doubleValue));
+            return [NSNumber numberWithDouble:doubleValue];
+        }
+        case FLeafTagTrue:
+            return @YES;
+        case FLeafTagFalse:
+            return @NO;
+        default:
+            return nil;
+    }
 }
 
 - (id)fixDoubleParsing:(id)value __attribute__((no_sanitize("float-cast-overflow"))) {
@@ -695,6 +1288,11 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 }
 
 - (id) deserializePrimitive:(NSData*)data {
+    id tagged = [self deserializeTaggedPrimitive:data];
+    if (tagged != nil) {
+        return tagged;
+    }
+
     NSError *error = nil;
     id result = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:&error];
     if (result != nil) {
@@ -49,4 +49,11 @@
 - (void)setTrackedQueryKeys:(NSSet *)keys forQuery:(FQuerySpec *)query;
 - (void)updateTrackedQueryKeysWithAddedKeys:(NSSet *)added removedKeys:(NSSet *)removed forQuery:(FQuerySpec *)query;
 
+- (NSUInteger)serverCacheEstimatedSizeInBytes;
+- (NSUInteger)numberOfTrackedQueries;
+
+/** The number of writes handed to the storage engine, and the time the database queue spent on them. */
+@property (nonatomic, readonly) NSUInteger numberOfStorageWrites;
+@property (nonatomic, readonly) NSTimeInterval storageWriteDuration;
+
 @end
@@ -24,6 +24,13 @@
 #import "FUtilities.h"
 #import "FPruneForest.h"
 #import "FClock.h"
+#import "FEmptyNode.h"
+#import "FLeafNode.h"
+#import "FNamedNode.h"
+#import "FKeyIndex.h"
+#import "FPathIndex.h"
+#import "FPriorityIndex.h"
+#import "FRangedFilter.h"
 
 @interface FPersistenceManager ()
 
@@ -31,6 +38,8 @@
 @property (nonatomic, strong) id<FCachePolicy> cachePolicy;
 @property (nonatomic, strong) FTrackedQueryManager *trackedQueryManager;
 @property (nonatomic) NSUInteger serverCacheUpdatesSinceLastPruneCheck;
+@property (nonatomic, readwrite) NSUInteger numberOfStorageWrites;
+@property (nonatomic, readwrite) NSTimeInterval storageWriteDuration;
 
 @end
 
@@ -54,25 +63,46 @@
 }
 
 - (void)saveUserOverwrite:(id<FNode>)node atPath:(FPath *)path writeId:(NSUInteger)writeId {
+    NSDate *start = [NSDate date];
     [self.storageEngine saveUserOverwrite:node atPath:path writeId:writeId];
+    [self recordStorageWriteSince:start];
 }
 
 - (void)saveUserMerge:(FCompoundWrite *)merge atPath:(FPath *)path writeId:(NSUInteger)writeId {
+    NSDate *start = [NSDate date];
     [self.storageEngine saveUserMerge:merge atPath:path writeId:writeId];
+    [self recordStorageWriteSince:start];
 }
 
 - (void)removeUserWrite:(NSUInteger)writeId {
+    NSDate *start = [NSDate date];
     [self.storageEngine removeUserWrite:writeId];
+    [self recordStorageWriteSince:start];
 }
 
 - (void)removeAllUserWrites {
+    NSDate *start = [NSDate date];
     [self.storageEngine removeAllUserWrites];
+    [self recordStorageWriteSince:start];
 }
 
 - (NSArray *)userWrites {
     return [self.storageEngine userWrites];
 }
 
+- (NSUInteger)serverCacheEstimatedSizeInBytes {
+    return [self.storageEngine serverCacheEstimatedSizeInBytes];
+}
+
+- (NSUInteger)numberOfTrackedQueries {
+    return [self.trackedQueryManager numberOfTrackedQueries];
+}
+
+- (void)recordStorageWriteSince:(NSDate *)start {
+    self.numberOfStorageWrites++;
+    self.storageWriteDuration += [start timeIntervalSinceNow] * -1;
+}
+
 - (FCacheNode *)serverCacheForQuery:(FQuerySpec *)query {
     NSSet *trackedKeys;
     BOOL complete;
@@ -90,6 +120,12 @@
         trackedKeys = [self.trackedQueryManager knownCompleteChildrenAtPath:query.path];
     }
 
+    if (complete && trackedKeys == nil && !query.loadsAllData) {
+        // The location is complete but this query only shows part of it. Rather than load all the children, find
+        // the ones the query shows from their index values alone and load only those.
+        trackedKeys = [self keysShownByQuery:query];
+    }
+
     id<FNode> node;
     if (trackedKeys != nil) {
         node = [self.storageEngine serverCacheForKeys:trackedKeys atPath:query.path];
@@ -101,15 +137,78 @@
     return [[FCacheNode alloc] initWithIndexedNode:indexedNode isFullyInitialized:complete isFiltered:(trackedKeys != nil)];
 }
 
+/**
+ * Returns the keys of the cached children shown by a filtered query, reading only the values the children are
+ * ordered by, or nil if the whole location needs to be loaded to tell.
+ */
+- (NSSet *)keysShownByQuery:(FQuerySpec *)query {
+    id<FIndex> index = query.index;
+    FPath *indexedPath;
+    if ([index isKindOfClass:[FKeyIndex class]]) {
+        indexedPath = nil;
+    } else if ([index isKindOfClass:[FPriorityIndex class]]) {
+        indexedPath = [FPath pathWithString:@".priority"];
+    } else if ([index isKindOfClass:[FPathIndex class]]) {
+        indexedPath = ((FPathIndex *)index).path;
+        NSArray *orderedKeys = [self.storageEngine serverCacheKeysAtPath:query.path
+                                                          orderedByChild:indexedPath
+                                                                  params:query.params];
+        if (orderedKeys != nil) {
+            return [NSSet setWithArray:orderedKeys];
+        }
+    } else {
+        // Ordering by value needs the whole value of each child anyway.
+        return nil;
+    }
+
+    NSDictionary *values = [self.storageEngine serverCacheChildrenAtPath:query.path valuesAtChildPath:indexedPath];
+    FRangedFilter *range = [[FRangedFilter alloc] initWithQueryParams:query.params];
+    NSMutableArray *shown = [NSMutableArray arrayWithCapacity:values.count];
+    [values enumerateKeysAndObjectsUsingBlock:^(NSString *key, id<FNode> value, BOOL *stop) {
+        // Rebuild just enough of the child for the index to compare it.
+        id<FNode> child;
+        if ([index isKindOfClass:[FPriorityIndex class]]) {
+            child = [[FLeafNode alloc] initWithValue:@YES withPriority:value];
+        } else if (indexedPath != nil) {
+            child = [[FEmptyNode emptyNode] updateChild:indexedPath withNewChild:value];
+        } else {
+            child = [FEmptyNode emptyNode];
+        }
+        if ([range matchesKey:key andNode:child]) {
+            [shown addObject:[FNamedNode nodeWithName:key node:child]];
+        }
+    }];
+
+    if (query.params.limitSet && shown.count > (NSUInteger)query.params.limit) {
+        [shown sortUsingComparator:^NSComparisonResult(FNamedNode *left, FNamedNode *right) {
+            return [index compareNamedNode:left toNamedNode:right];
+        }];
+        NSUInteger limit = (NSUInteger)query.params.limit;
+        NSRange kept = [query.params isViewFromLeft] ? NSMakeRange(0, limit)
+                                                     : NSMakeRange(shown.count - limit, limit);
+        [shown setArray:[shown subarrayWithRange:kept]];
+    }
+
+    NSMutableSet *keys = [NSMutableSet setWithCapacity:shown.count];
+    for (FNamedNode *child in shown) {
+        [keys addObject:child.name];
+    }
+    return keys;
+}
+
 - (void)updateServerCacheWithNode:(id<FNode>)node forQuery:(FQuerySpec *)query {
     BOOL merge = !query.loadsAllData;
+    NSDate *start = [NSDate date];
     [self.storageEngine updateServerCache:node atPath:query.path merge:merge];
+    [self recordStorageWriteSince:start];
     [self setQueryComplete:query];
     [self doPruneCheckAfterServerUpdate];
 }
 
 - (void)updateServerCacheWithMerge:(FCompoundWrite *)merge atPath:(FPath *)path {
+    NSDate *start = [NSDate date];
     [self.storageEngine updateServerCacheWithMerge:merge atPath:path];
+    [self recordStorageWriteSince:start];
     [self doPruneCheckAfterServerUpdate];
 }
 
@@ -129,7 +228,9 @@
     // that we wrote a ServerValue.TIMESTAMP and the server resolved it to a different value).
     // TODO[offline]: Consider reworking.
     if (![self.trackedQueryManager hasActiveDefaultQueryAtPath:path]) {
+        NSDate *start = [NSDate date];
         [self.storageEngine updateServerCache:write atPath:path merge:NO];
+        [self recordStorageWriteSince:start];
         [self.trackedQueryManager ensureCompleteTrackedQueryAtPath:path];
     }
 }
@@ -163,7 +264,9 @@
                                                numberOfTrackedQueries:self.trackedQueryManager.numberOfPrunableQueries]) {
             FPruneForest *pruneForest = [self.trackedQueryManager pruneOldQueries:self.cachePolicy];
             if (pruneForest.prunesAnything) {
+                NSDate *start = [NSDate date];
                 [self.storageEngine pruneCache:pruneForest atPath:[FPath empty]];
+                [self recordStorageWriteSince:start];
             } else {
                 canPrune = NO;
             }
@@ -178,14 +281,18 @@
     NSAssert(!query.loadsAllData, @"We should only track keys for filtered queries");
     FTrackedQuery *trackedQuery = [self.trackedQueryManager findTrackedQuery:query];
     NSAssert(trackedQuery.isActive, @"We only expect tracked keys for currently-active queries.");
+    NSDate *start = [NSDate date];
     [self.storageEngine setTrackedQueryKeys:keys forQueryId:trackedQuery.queryId];
+    [self recordStorageWriteSince:start];
 }
 
 - (void)updateTrackedQueryKeysWithAddedKeys:(NSSet *)added removedKeys:(NSSet *)removed forQuery:(FQuerySpec *)query {
     NSAssert(!query.loadsAllData, @"We should only track keys for filtered queries");
     FTrackedQuery *trackedQuery = [self.trackedQueryManager findTrackedQuery:query];
     NSAssert(trackedQuery.isActive, @"We only expect tracked keys for currently-active queries.");
+    NSDate *start = [NSDate date];
     [self.storageEngine updateTrackedQueryKeysWithAddedKeys:added removedKeys:removed forQueryId:trackedQuery.queryId];
+    [self recordStorageWriteSince:start];
 }
 
 @end
@@ -34,5 +34,7 @@
 - (FPruneForest *)pruneAll:(NSSet *)children atPath:(FPath *)path;
 
 - (void)enumarateKeptNodesUsingBlock:(void (^)(FPath *path))block;
+/** Enumerates the root-most paths whose unkept descendants are pruned. */
+- (void)enumeratePrunedPathsUsingBlock:(void (^)(FPath *path))block;
 
 @end
@@ -166,6 +166,15 @@ static BOOL (^kFKeepPredicate)(id) = ^BOOL(NSNumber *pruneValue) {
     return [[FPruneForest alloc] initWithForest:[self.pruneForest setTree:newSubtree atPath:path]];
 }
 
+- (void)enumeratePrunedPathsUsingBlock:(void (^)(FPath *))block {
+    [self.pruneForest forEach:^(FPath *path, id value) {
+        if (value != nil && [value boolValue] &&
+            [[self.pruneForest findRootMostMatchingPath:path predicate:kFPrunePredicate].path isEqual:path]) {
+            block(path);
+        }
+    }];
+}
+
 - (void)enumarateKeptNodesUsingBlock:(void (^)(FPath *))block {
     [self.pruneForest forEach:^(FPath *path, id value) {
         if (value != nil && ![value boolValue]) {
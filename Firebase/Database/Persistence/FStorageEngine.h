@@ -22,6 +22,7 @@
 @class FCompoundWrite;
 @class FQuerySpec;
 @class FTrackedQuery;
+@class FQueryParams;
 
 @protocol FStorageEngine <NSObject>
 
@@ -35,6 +36,17 @@
 
 - (id<FNode>)serverCacheAtPath:(FPath *)path;
 - (id<FNode>)serverCacheForKeys:(NSSet *)keys atPath:(FPath *)path;
+/**
+ * Returns the node at childPath (nil for none) of each child at path, keyed by child name, without loading the
+ * rest of the children. Children without data at childPath map to the empty node.
+ */
+- (NSDictionary *)serverCacheChildrenAtPath:(FPath *)path valuesAtChildPath:(FPath *)childPath;
+/**
+ * Returns the keys of the children at path that are within the range and limit of params when ordered by the value
+ * at childPath, in that order, or nil if the engine can't tell without loading the children. The engine may keep
+ * an index of the location for subsequent calls.
+ */
+- (NSArray *)serverCacheKeysAtPath:(FPath *)path orderedByChild:(FPath *)childPath params:(FQueryParams *)params;
 - (void)updateServerCache:(id<FNode>)node atPath:(FPath *)path merge:(BOOL)merge;
 - (void)updateServerCacheWithMerge:(FCompoundWrite *)merge atPath:(FPath *)path;
 - (NSUInteger)serverCacheEstimatedSizeInBytes;
@@ -43,6 +43,7 @@
 
 - (FPruneForest *)pruneOldQueries:(id<FCachePolicy>)cachePolicy;
 - (NSUInteger)numberOfPrunableQueries;
+- (NSUInteger)numberOfTrackedQueries;
 - (NSSet *)knownCompleteChildrenAtPath:(FPath *)path;
 
 // For testing
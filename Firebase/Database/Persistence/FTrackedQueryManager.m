@@ -259,6 +259,14 @@
     return count;
 }
 
+- (NSUInteger)numberOfTrackedQueries {
+    __block NSUInteger count = 0;
+    [self.trackedQueryTree forEach:^(FPath *path, NSDictionary *trackedQueries) {
+        count += trackedQueries.count;
+    }];
+    return count;
+}
+
 - (NSSet *)filteredQueryIdsAtPath:(FPath *)path {
     NSDictionary *queries = [self.trackedQueryTree valueAtPath:path];
     if (queries) {
@@ -16,6 +16,7 @@
 
 #import <Foundation/Foundation.h>
 #import "FIRDatabaseReference.h"
+#import "FIRDatabaseStatistics.h"
 
 @class FIRApp;
 
@@ -120,6 +121,15 @@ NS_SWIFT_NAME(Database)
  */
 - (void)goOnline;
 
+/**
+ * Retrieves statistics about the pending writes, the persistent cache and the events raised by this FIRDatabase
+ * instance, e.g. to monitor how an app's usage of the database performs.
+ *
+ * @param completion A block that receives the statistics. It is called on the callbackQueue.
+ */
+- (void)getStatisticsWithCompletion:(void (^)(FIRDatabaseStatistics *statistics))completion
+    NS_SWIFT_NAME(getStatistics(completion:));
+
 /**
  * The Firebase Database client will cache synchronized data and keep track of all writes you've
  * initiated while your application is running. It seamlessly handles intermittent network
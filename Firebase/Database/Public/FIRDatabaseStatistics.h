@@ -0,0 +1,56 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A snapshot of the work a FIRDatabase instance has done and has outstanding, as returned by
+ * [FIRDatabase getStatisticsWithCompletion:]. Durations are in seconds.
+ */
+NS_SWIFT_NAME(DatabaseStatistics)
+@interface FIRDatabaseStatistics : NSObject
+
+/** :nodoc: */
+- (instancetype)init __attribute__((unavailable("FIRDatabaseStatistics cannot be created directly.")));
+
+/** The number of writes that have not been acknowledged by the Firebase Database backend yet. */
+@property (nonatomic, readonly) NSUInteger pendingWriteCount;
+
+/** The number of queries tracked in the persistent cache, or 0 if persistence is disabled. */
+@property (nonatomic, readonly) NSUInteger trackedQueryCount;
+
+/** The estimated size of the persistent cache, or 0 if persistence is disabled. */
+@property (nonatomic, readonly) NSUInteger persistenceCacheSizeBytes;
+
+/** The number of events raised to listeners. */
+@property (nonatomic, readonly) NSUInteger eventCount;
+
+/**
+ * The mean and the longest time from an event being raised to the callback queue getting to it and the events raised
+ * along with it.
+ */
+@property (nonatomic, readonly) NSTimeInterval averageEventLatency;
+@property (nonatomic, readonly) NSTimeInterval maxEventLatency;
+
+/** The number of writes to the persistent cache, and the total time spent on them. */
+@property (nonatomic, readonly) NSUInteger persistenceWriteCount;
+@property (nonatomic, readonly) NSTimeInterval persistenceWriteDuration;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -20,6 +20,7 @@
 #import "FIRDatabase.h"
 #import "FIRDatabaseQuery.h"
 #import "FIRDatabaseReference.h"
+#import "FIRDatabaseStatistics.h"
 #import "FIRDataEventType.h"
 #import "FIRDataSnapshot.h"
 #import "FIRMutableData.h"
@@ -30,7 +30,8 @@
 #endif
 
 @interface FWebSocketConnection () {
-    NSMutableString* frame;
+    // The UTF-8 bytes of the frames of the message being received.
+    NSMutableData* frame;
     BOOL everConnected;
     BOOL isClosed;
     NSTimer* keepAlive;
@@ -46,6 +47,8 @@
 @property (nonatomic, readonly) BOOL buffering;
 @property (nonatomic, readonly) NSString* userAgent;
 @property (nonatomic) dispatch_queue_t dispatchQueue;
+// Complete frames are decoded here, off the dispatch queue. It is serial, so messages are still delivered in order.
+@property (nonatomic) dispatch_queue_t parseQueue;
 
 - (void)nop:(NSTimer *)timer;
 
@@ -65,6 +68,7 @@
         self.connectionId = [FUtilities LUIDGenerator];
         self.totalFrames = 0;
         self.dispatchQueue = queue;
+        self.parseQueue = dispatch_queue_create("FirebaseFrameParser", DISPATCH_QUEUE_SERIAL);
         frame = nil;
 
         NSString* connectionUrl = [repoInfo connectionURLWithLastSessionID:lastSessionID];
@@ -73,6 +77,9 @@
 
         NSURLRequest* req = [[NSURLRequest alloc] initWithURL:[[NSURL alloc] initWithString:connectionUrl]];
         self.webSocket = [[FSRWebSocket alloc] initWithURLRequest:req queue:queue andUserAgent:ua];
+        // Messages are verbose JSON, so compress them if the server supports it. Small ones aren't worth it.
+        self.webSocket.requestsPerMessageDeflate = YES;
+        self.webSocket.compressionThreshold = kWebsocketCompressionThreshold;
         [self.webSocket setDelegateDispatchQueue:queue];
         self.webSocket.delegate = self;
     }
@@ -176,7 +183,7 @@
 
 - (void) handleNewFrameCount:(int) numFrames {
     self.totalFrames = numFrames;
-    frame = [[NSMutableString alloc] initWithString:@""];
+    frame = [[NSMutableData alloc] init];
     FFLog(@"I-RDB083006", @"(wsc:%@) handleNewFrameCount: %d", self.connectionId, self.totalFrames);
 }
 
@@ -193,23 +200,64 @@
 }
 
 - (void) appendFrame:(NSString *) message {
-    [frame appendString:message];
+    NSUInteger length = [message lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    if (frame.length == 0 && self.totalFrames > 1) {
+        // The server splits messages into frames of the same size, so make room for all of them at once rather than
+        // growing the buffer as they come in.
+        frame = [[NSMutableData alloc] initWithCapacity:length * self.totalFrames];
+    }
+
+    // Encode the frame straight into the buffer, which is all the JSON parser needs.
+    NSUInteger offset = frame.length;
+    NSUInteger used = 0;
+    NSRange remaining = NSMakeRange(0, 0);
+    [frame increaseLengthBy:length];
+    BOOL encoded = [message getBytes:(char *)frame.mutableBytes + offset
+                           maxLength:length
+                          usedLength:&used
+                            encoding:NSUTF8StringEncoding
+                             options:0
+                               range:NSMakeRange(0, message.length)
+                      remainingRange:&remaining];
+    if (!encoded || used != length || remaining.length > 0) {
+        // Only a string that isn't valid Unicode, such as one with an unpaired surrogate, can't be encoded. The rest of
+        // the message can't be parsed then, so give up on the connection rather than deliver it truncated.
+        FFWarn(@"I-RDB083015", @"(wsc:%@) Closing websocket on a frame that can't be encoded as UTF-8", self.connectionId);
+        frame = nil;
+        self.totalFrames = 0;
+        [self.webSocket close];
+        return;
+    }
     self.totalFrames = self.totalFrames - 1;
 
     if (self.totalFrames == 0) {
-        // Call delegate and pass an immutable version of the frame
-        NSDictionary* json = [NSJSONSerialization JSONObjectWithData:[frame dataUsingEncoding:NSUTF8StringEncoding]
-                                                             options:kNilOptions
-                                                               error:nil];
+        NSData *completeFrame = frame;
         frame = nil;
         FFLog(@"I-RDB083007", @"(wsc:%@) handleIncomingFrame sending complete frame: %d", self.connectionId, self.totalFrames);
 
-        @autoreleasepool {
-            [self.delegate onMessage:self withMessage:json];
-        }
+        // Large frames take a while to decode, so don't hold up the dispatch queue (and every listener) meanwhile.
+        dispatch_async(self.parseQueue, ^{
+            NSDictionary* json;
+            @autoreleasepool {
+                json = [NSJSONSerialization JSONObjectWithData:completeFrame options:kNilOptions error:nil];
+            }
+            dispatch_async(self.dispatchQueue, ^{
+                // Call delegate and pass an immutable version of the frame
+                @autoreleasepool {
+                    [self.delegate onMessage:self withMessage:json];
+                }
+            });
+        });
     }
 }
 
+/** Runs block on the dispatch queue once all messages received so far have been delivered. */
+- (void) afterPendingMessages:(void (^)(void))block {
+    dispatch_async(self.parseQueue, ^{
+        dispatch_async(self.dispatchQueue, block);
+    });
+}
+
 - (void) handleIncomingFrame:(NSString *) message {
     [self resetKeepAlive];
     if (self.buffering) {
@@ -248,13 +296,17 @@
 - (void)webSocket:(FSRWebSocket *)webSocket didFailWithError:(NSError *)error
 {
     FFLog(@"I-RDB083010", @"(wsc:%@) didFailWithError didFailWithError: %@", self.connectionId, [error description]);
-    [self onClosed];
+    [self afterPendingMessages:^{
+        [self onClosed];
+    }];
 }
 
 - (void)webSocket:(FSRWebSocket *)webSocket didCloseWithCode:(NSInteger)code reason:(NSString *)reason wasClean:(BOOL)wasClean
 {
     FFLog(@"I-RDB083011", @"(wsc:%@) didCloseWithCode: %ld %@", self.connectionId, (long)code, reason);
-    [self onClosed];
+    [self afterPendingMessages:^{
+        [self onClosed];
+    }];
 }
 
 #pragma mark -
@@ -21,6 +21,7 @@
 #import "FImmutableSortedDictionary.h"
 
 @class FNamedNode;
+@class FCompoundHash;
 
 @interface FChildrenNode : NSObject <FNode>
 
@@ -37,4 +38,9 @@
 @property (nonatomic, strong) FImmutableSortedDictionary* children;
 @property (nonatomic, strong) id<FNode> priorityNode;
 
+// Computed on demand by FSnapshotUtilities and FCompoundHash. Nodes are immutable, so these stay valid for as long
+// as the node is in use, and unchanged subtrees of an updated tree keep theirs.
+@property (nonatomic, strong) NSNumber *lazySerializedSize;
+@property (nonatomic, strong) FCompoundHash *lazyCompoundHash;
+
 @end
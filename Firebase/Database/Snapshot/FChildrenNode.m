@@ -162,7 +162,7 @@
     __block NSInteger maxKey = 0;
     __block BOOL allIntegerKeys = YES;
 
-    NSMutableDictionary* obj = [[NSMutableDictionary alloc] initWithCapacity:[self.children count]];
+    NSMutableDictionary* obj = [[NSMutableDictionary alloc] initWithCapacity:[self numChildren]];
     [self enumerateChildrenUsingBlock:^(NSString *key, id<FNode> childNode, BOOL *stop) {
         [obj setObject:[childNode valForExport:exp] forKey:key];
 
@@ -290,7 +290,7 @@
         FChildrenNode *otherChildrenNode = other;
         if (![self.getPriority isEqual:other.getPriority]) {
             return NO;
-        } else if (self.children.count == otherChildrenNode.children.count) {
+        } else if (self.numChildren == otherChildrenNode.numChildren) {
             __block BOOL equal = YES;
             [self enumerateChildrenUsingBlock:^(NSString *key, id<FNode> node, BOOL *stop) {
                 id<FNode> child = [otherChildrenNode getImmediateChild:key];
@@ -47,6 +47,7 @@
 - (FCompoundWrite *) removeWriteAtPath:(FPath *)path;
 - (id<FNode>)rootWrite;
 - (BOOL) hasCompleteWriteAtPath:(FPath *)path;
+- (FPath *) rootMostWritePathOnPath:(FPath *)path;
 - (id<FNode>) completeNodeAtPath:(FPath *)path;
 - (NSArray *) completeChildren;
 - (NSDictionary *)childCompoundWrites;
@@ -117,6 +117,16 @@
     return [self completeNodeAtPath:path] != nil;
 }
 
+/**
+* Returns the shallowest path on the way to the given path, the given path included, that holds a write. Any write
+* to the given path or deeper is folded into the write at that path.
+* @param path The path to check for
+* @return The path of the write, or nil if there is no write on the way to the given path.
+*/
+- (FPath *) rootMostWritePathOnPath:(FPath *)path {
+    return [self.writeTree findRootMostValueAndPath:path].path;
+}
+
 /**
 * Returns a node for a path if and only if the node is a "complete" overwrite at that path. This will not aggregate
 * writes from depeer paths, but will return child nodes from a more shallow path.
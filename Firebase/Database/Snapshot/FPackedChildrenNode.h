@@ -0,0 +1,36 @@
+/*
+ * Copyright 2017 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import "FChildrenNode.h"
+
+/**
+ * A children node whose children are all leaves without a priority, the common case for lists of scalars.
+ *
+ * The children are kept in a single sorted array of keys and leaf values instead of a tree of leaf nodes, which
+ * saves a few objects per child. Leaf nodes are created as children are read, and the first structural change
+ * (setting a child or the priority) returns a regular FChildrenNode.
+ */
+@interface FPackedChildrenNode : FChildrenNode
+
+/**
+ * Returns YES if all the given children are leaf nodes without priority, so that they can be packed.
+ */
++ (BOOL) canPackChildren:(NSDictionary *)someChildren;
+
+- (id)initWithPriority:(id<FNode>)aPriority leaves:(NSDictionary *)someLeaves;
+
+@end
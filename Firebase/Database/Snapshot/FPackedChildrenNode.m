@@ -0,0 +1,190 @@
+/*
+ * Copyright 2017 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FPackedChildrenNode.h"
+#import "FLeafNode.h"
+#import "FEmptyNode.h"
+#import "FNamedNode.h"
+#import "FUtilities.h"
+#import "FImmutableSortedDictionary.h"
+
+typedef struct {
+    // Both are retained by the node.
+    CFStringRef key;
+    CFTypeRef value;
+} FPackedLeaf;
+
+@interface FPackedChildrenEnumerator : NSEnumerator
+- (id)initWithNode:(FPackedChildrenNode *)node;
+@end
+
+@interface FPackedChildrenNode ()
+- (NSString *) keyAtIndex:(int)index;
+- (FLeafNode *) leafAtIndex:(int)index;
+@end
+
+@implementation FPackedChildrenNode {
+    FPackedLeaf *leaves;
+    int count;
+}
+
++ (BOOL) canPackChildren:(NSDictionary *)someChildren {
+    for (NSString *key in someChildren) {
+        id<FNode> child = someChildren[key];
+        if (!child.isLeafNode || !child.getPriority.isEmpty) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (id)initWithPriority:(id<FNode>)aPriority leaves:(NSDictionary *)someLeaves {
+    NSAssert(someLeaves.count > 0, @"Can't pack an empty node.");
+    NSAssert([FPackedChildrenNode canPackChildren:someLeaves], @"Can only pack leaves without priority.");
+    self = [super initWithPriority:aPriority children:nil];
+    if (self) {
+        NSArray *keys = [someLeaves.allKeys sortedArrayUsingComparator:[FUtilities keyComparator]];
+        count = (int)keys.count;
+        leaves = malloc(sizeof(FPackedLeaf) * count);
+        for (int i = 0; i < count; i++) {
+            FLeafNode *leaf = someLeaves[keys[i]];
+            leaves[i].key = (CFStringRef)CFBridgingRetain(keys[i]);
+            leaves[i].value = CFBridgingRetain(leaf.value);
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    for (int i = 0; i < count; i++) {
+        CFRelease(leaves[i].key);
+        CFRelease(leaves[i].value);
+    }
+    free(leaves);
+}
+
+- (NSString *) keyAtIndex:(int)index {
+    return (__bridge NSString *)leaves[index].key;
+}
+
+- (FLeafNode *) leafAtIndex:(int)index {
+    return [[FLeafNode alloc] initWithValue:(__bridge id)leaves[index].value];
+}
+
+/**
+ * Returns the index of the given key, or -1 if there is no child with that key.
+ */
+- (int) indexOfKey:(NSString *)key {
+    int low = 0;
+    int high = count - 1;
+    while (low <= high) {
+        int middle = low + (high - low) / 2;
+        NSComparisonResult result = [FUtilities compareKey:[self keyAtIndex:middle] toKey:key];
+        if (result == NSOrderedSame) {
+            return middle;
+        } else if (result == NSOrderedAscending) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return -1;
+}
+
+#pragma mark -
+#pragma mark FChildrenNode methods
+
+// Anything that changes the structure of the node works on the general form, so the result is a regular
+// FChildrenNode.
+- (FImmutableSortedDictionary *) children {
+    NSMutableDictionary *children = [[NSMutableDictionary alloc] initWithCapacity:count];
+    for (int i = 0; i < count; i++) {
+        children[[self keyAtIndex:i]] = [self leafAtIndex:i];
+    }
+    return [FImmutableSortedDictionary fromDictionary:children withComparator:[FUtilities keyComparator]];
+}
+
+- (id<FNode>) getImmediateChild:(NSString *)childName {
+    if ([childName isEqualToString:@".priority"]) {
+        return [self getPriority];
+    }
+    int index = [self indexOfKey:childName];
+    return (index < 0) ? [FEmptyNode emptyNode] : [self leafAtIndex:index];
+}
+
+- (BOOL) isEmpty {
+    return count == 0;
+}
+
+- (int) numChildren {
+    return count;
+}
+
+- (void) enumerateChildrenUsingBlock:(void (^)(NSString *, id<FNode>, BOOL *))block {
+    [self enumerateChildrenReverse:NO usingBlock:block];
+}
+
+- (void) enumerateChildrenReverse:(BOOL)reverse usingBlock:(void (^)(NSString *, id<FNode>, BOOL *))block {
+    BOOL stop = NO;
+    for (int i = 0; i < count && !stop; i++) {
+        int index = reverse ? count - 1 - i : i;
+        block([self keyAtIndex:index], [self leafAtIndex:index], &stop);
+    }
+}
+
+- (NSEnumerator *) childEnumerator {
+    return [[FPackedChildrenEnumerator alloc] initWithNode:self];
+}
+
+- (NSString *) predecessorChildKey:(NSString *)childKey {
+    int index = [self indexOfKey:childKey];
+    return (index > 0) ? [self keyAtIndex:index - 1] : nil;
+}
+
+- (FNamedNode *) firstChild {
+    return (count == 0) ? nil : [FNamedNode nodeWithName:[self keyAtIndex:0] node:[self leafAtIndex:0]];
+}
+
+- (FNamedNode *) lastChild {
+    return (count == 0) ? nil : [FNamedNode nodeWithName:[self keyAtIndex:count - 1] node:[self leafAtIndex:count - 1]];
+}
+
+@end
+
+@implementation FPackedChildrenEnumerator {
+    FPackedChildrenNode *node;
+    int index;
+}
+
+- (id)initWithNode:(FPackedChildrenNode *)aNode {
+    self = [super init];
+    if (self) {
+        node = aNode;
+        index = 0;
+    }
+    return self;
+}
+
+- (id)nextObject {
+    if (index >= node.numChildren) {
+        return nil;
+    }
+    FNamedNode *next = [FNamedNode nodeWithName:[node keyAtIndex:index] node:[node leafAtIndex:index]];
+    index++;
+    return next;
+}
+
+@end
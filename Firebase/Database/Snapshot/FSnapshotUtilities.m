@@ -20,6 +20,7 @@
 #import "FConstants.h"
 #import "FUtilities.h"
 #import "FChildrenNode.h"
+#import "FPackedChildrenNode.h"
 #import "FLLRBValueNode.h"
 #import "FValidation.h"
 #import "FMaxNode.h"
@@ -126,9 +127,7 @@
         if ([children count] == 0) {
             return [FEmptyNode emptyNode];
         } else {
-            FImmutableSortedDictionary *childrenDict = [FImmutableSortedDictionary fromDictionary:children
-                                                                                   withComparator:[FUtilities keyComparator]];
-            return [[FChildrenNode alloc] initWithPriority:priority children:childrenDict];
+            return [FSnapshotUtilities childrenNodeWithPriority:priority children:children];
         }
     } else if([value isKindOfClass:[NSArray class]]) {
         NSArray* aval = (NSArray *)value;
@@ -148,9 +147,7 @@
         if ([children count] == 0) {
             return [FEmptyNode emptyNode];
         } else {
-            FImmutableSortedDictionary *childrenDict = [FImmutableSortedDictionary fromDictionary:children
-                                                                                   withComparator:[FUtilities keyComparator]];
-            return [[FChildrenNode alloc] initWithPriority:priority children:childrenDict];
+            return [FSnapshotUtilities childrenNodeWithPriority:priority children:children];
         }
     } else {
         NSRange range;
@@ -165,6 +162,16 @@
     }
 }
 
++ (id<FNode>) childrenNodeWithPriority:(id<FNode>)priority children:(NSDictionary *)children {
+    if ([FPackedChildrenNode canPackChildren:children]) {
+        return [[FPackedChildrenNode alloc] initWithPriority:priority leaves:children];
+    } else {
+        FImmutableSortedDictionary *childrenDict = [FImmutableSortedDictionary fromDictionary:children
+                                                                               withComparator:[FUtilities keyComparator]];
+        return [[FChildrenNode alloc] initWithPriority:priority children:childrenDict];
+    }
+}
+
 + (FCompoundWrite *) compoundWriteFromDictionary:(NSDictionary *)values withValidationFrom:(NSString *)fn {
     FCompoundWrite *compoundWrite = [FCompoundWrite emptyWrite];
 
@@ -288,13 +295,17 @@
         return [FSnapshotUtilities estimateLeafNodeSize:node];
     } else {
         NSAssert([node isKindOfClass:[FChildrenNode class]], @"Unexpected node type: %@", [node class]);
-        __block NSUInteger sum = 1; // opening brackets
-        [((FChildrenNode *)node) enumerateChildrenAndPriorityUsingBlock:^(NSString *key, id<FNode>child, BOOL *stop) {
-            sum += key.length;
-            sum += 4; // quotes around key and colon and (comma or closing bracket)
-            sum += [FSnapshotUtilities estimateSerializedNodeSize:child];
-        }];
-        return sum;
+        FChildrenNode *childrenNode = (FChildrenNode *)node;
+        if (childrenNode.lazySerializedSize == nil) {
+            __block NSUInteger sum = 1; // opening brackets
+            [childrenNode enumerateChildrenAndPriorityUsingBlock:^(NSString *key, id<FNode>child, BOOL *stop) {
+                sum += key.length;
+                sum += 4; // quotes around key and colon and (comma or closing bracket)
+                sum += [FSnapshotUtilities estimateSerializedNodeSize:child];
+            }];
+            childrenNode.lazySerializedSize = @(sum);
+        }
+        return childrenNode.lazySerializedSize.unsignedIntegerValue;
     }
 }
 
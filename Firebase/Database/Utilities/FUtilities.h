@@ -34,6 +34,8 @@
 + (NSString*) minName;
 + (NSString*) maxName;
 + (NSComparisonResult) compareKey:(NSString *)a toKey:(NSString *)b;
+// Returns YES for keys that compareKey:toKey: orders as 32-bit integers, setting integer to their value.
++ (BOOL) tryParseKey:(NSString *)key asInt:(NSInteger *)integer;
 + (NSComparator) stringComparator;
 + (NSComparator) keyComparator;
 
@@ -56,7 +58,7 @@ FOUNDATION_EXPORT NSString *const kFPersistenceLogTag;
 
 #define FFDebug(code, format, ...) do { \
   if (FFIsLoggingEnabled(FLogLevelDebug)) { \
-    FIRLogDebug(kFIRLoggerDatabase, (code), (format), ##__VA_ARGS__); \
+    FIR_LOG_DEBUG(kFIRLoggerDatabase, (code), (format), ##__VA_ARGS__); \
   } \
 } while(0)
 
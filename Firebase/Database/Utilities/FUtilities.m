@@ -371,6 +371,10 @@ static inline BOOL tryParseStringToInt(__unsafe_unretained NSString* str, NSInte
     }
 }
 
++ (BOOL) tryParseKey:(NSString *)key asInt:(NSInteger *)integer {
+    return tryParseStringToInt(key, integer);
+}
+
 + (NSComparator) keyComparator {
     return ^NSComparisonResult(__unsafe_unretained NSString *a, __unsafe_unretained NSString *b) {
         return [FUtilities compareKey:a toKey:b];
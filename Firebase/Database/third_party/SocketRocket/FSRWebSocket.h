@@ -42,6 +42,17 @@ extern NSString *const FSRWebSocketErrorDomain;
 // It will be niluntil after the handshake completes.
 @property (nonatomic, readonly, copy) NSString *protocol;
 
+// Whether to offer the permessage-deflate extension (RFC 7692) in the handshake. Set it before calling open.
+@property (nonatomic) BOOL requestsPerMessageDeflate;
+
+// Once permessage-deflate is negotiated, outgoing messages at least this many bytes long are compressed. Shorter
+// ones don't shrink enough to be worth it. Defaults to 1024.
+@property (nonatomic) NSUInteger compressionThreshold;
+
+// Whether the server accepted permessage-deflate.
+// It will be NO until after the handshake completes.
+@property (nonatomic, readonly) BOOL perMessageDeflateNegotiated;
+
 // Protocols should be an array of strings that turn into Sec-WebSocket-Protocol
 - (id)initWithURLRequest:(NSURLRequest *)request protocols:(NSArray *)protocols queue:(dispatch_queue_t)queue andUserAgent:(NSString *)userAgent;
 - (id)initWithURLRequest:(NSURLRequest *)request protocols:(NSArray *)protocols;
@@ -36,6 +36,7 @@
 
 #import <CommonCrypto/CommonDigest.h>
 #import <Security/SecRandom.h>
+#import <zlib.h>
 #import "fbase64.h"
 #import "NSData+SRB64Additions.h"
 
@@ -207,10 +208,20 @@ typedef void (^data_callback)(FSRWebSocket *webSocket,  NSData *data);
 - (void)_readUntilHeaderCompleteWithCallback:(data_callback)dataHandler;
 
 - (void)_sendFrameWithOpcode:(FSROpCode)opcode data:(id)data;
+- (void)_sendFrameWithOpcode:(FSROpCode)opcode data:(id)data compressed:(BOOL)compressed;
+- (void)_sendMessageWithOpcode:(FSROpCode)opcode data:(NSData *)data;
 
 - (BOOL)_checkHandshake:(CFHTTPMessageRef)httpMessage;
+- (BOOL)_negotiateExtensions:(NSString *)extensions;
+- (NSData *)_inflateMessage:(NSData *)data;
+- (NSData *)_deflateMessage:(NSData *)data;
 - (void)_SR_commonInit;
 
+// For tests only
+- (BOOL)_openWithExtensions:(NSString *)extensions;
+- (void)_receiveData:(NSData *)data;
+- (NSData *)_compressedMessage:(NSData *)data;
+
 - (void)_initializeStreams;
 - (void)_connect;
 
@@ -279,12 +290,26 @@ typedef void (^data_callback)(FSRWebSocket *webSocket,  NSData *data);
 
     NSArray *_requestedProtocols;
     FSRIOConsumerPool *_consumerPool;
+
+    // permessage-deflate parameters accepted by the server, and the compression contexts. Only used on the work
+    // queue; the contexts are created with the first message that needs them.
+    BOOL _serverNoContextTakeover;
+    BOOL _clientNoContextTakeover;
+    int _clientMaxWindowBits;
+    BOOL _currentMessageCompressed;
+    z_stream _inflater;
+    BOOL _inflaterInitialized;
+    z_stream _deflater;
+    BOOL _deflaterInitialized;
 }
 
 @synthesize delegate = _delegate;
 @synthesize url = _url;
 @synthesize readyState = _readyState;
 @synthesize protocol = _protocol;
+@synthesize requestsPerMessageDeflate = _requestsPerMessageDeflate;
+@synthesize compressionThreshold = _compressionThreshold;
+@synthesize perMessageDeflateNegotiated = _perMessageDeflateNegotiated;
 
 static __strong NSData *CRLFCRLF;
 
@@ -357,6 +382,8 @@ static __strong NSData *CRLFCRLF;
 
     _webSocketVersion = 13;
 
+    _compressionThreshold = 1024;
+
     _workQueue = dispatch_queue_create(NULL, DISPATCH_QUEUE_SERIAL);
 
     // Going to set a specific on the queue so we can validate we're on the work queue
@@ -401,6 +428,13 @@ static __strong NSData *CRLFCRLF;
         _receivedHTTPHeaders = NULL;
     }
 
+    if (_inflaterInitialized) {
+        inflateEnd(&_inflater);
+    }
+    if (_deflaterInitialized) {
+        deflateEnd(&_deflater);
+    }
+
     if (_delegateDispatchQueue) {
         sr_dispatch_release(_delegateDispatchQueue);
         _delegateDispatchQueue = NULL;
@@ -467,6 +501,84 @@ static __strong NSData *CRLFCRLF;
     return [acceptHeader isEqualToString:expectedAccept];
 }
 
+// Accepts the server's response to our permessage-deflate offer. Anything else is an extension we never asked for.
+- (BOOL)_negotiateExtensions:(NSString *)extensions;
+{
+    NSCharacterSet *whitespace = [NSCharacterSet whitespaceCharacterSet];
+    NSArray *params = [extensions componentsSeparatedByString:@";"];
+    NSString *name = [params[0] stringByTrimmingCharactersInSet:whitespace];
+    if (!_requestsPerMessageDeflate || ![name isEqualToString:@"permessage-deflate"] ||
+        [extensions rangeOfString:@","].location != NSNotFound) {
+        return NO;
+    }
+
+    _clientMaxWindowBits = MAX_WBITS;
+    for (NSUInteger i = 1; i < params.count; i++) {
+        NSArray *pair = [params[i] componentsSeparatedByString:@"="];
+        NSString *key = [pair[0] stringByTrimmingCharactersInSet:whitespace];
+        NSString *value = nil;
+        if (pair.count > 1) {
+            value = [[pair[1] stringByTrimmingCharactersInSet:whitespace] stringByTrimmingCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@"\""]];
+        }
+
+        if ([key isEqualToString:@"server_no_context_takeover"]) {
+            _serverNoContextTakeover = YES;
+        } else if ([key isEqualToString:@"client_no_context_takeover"]) {
+            _clientNoContextTakeover = YES;
+        } else if ([key isEqualToString:@"client_max_window_bits"] && value) {
+            _clientMaxWindowBits = value.intValue;
+            if (_clientMaxWindowBits < 8 || _clientMaxWindowBits > MAX_WBITS) {
+                return NO;
+            }
+        } else if ([key isEqualToString:@"server_max_window_bits"] && value) {
+            // Inflating with the largest window handles messages compressed with any smaller one, as long as the server
+            // picked a size the extension allows.
+            int serverMaxWindowBits = value.intValue;
+            if (serverMaxWindowBits < 8 || serverMaxWindowBits > MAX_WBITS) {
+                return NO;
+            }
+        } else {
+            return NO;
+        }
+    }
+
+    _perMessageDeflateNegotiated = YES;
+    return YES;
+}
+
+// Opens the socket as though the server had accepted the given extensions, without connecting to it.
+- (BOOL)_openWithExtensions:(NSString *)extensions;
+{
+    __block BOOL accepted = NO;
+    dispatch_sync(_workQueue, ^{
+        accepted = !extensions || [self _negotiateExtensions:extensions];
+        if (accepted) {
+            self.readyState = SR_OPEN;
+            [self _readFrameNew];
+        }
+    });
+    return accepted;
+}
+
+// Reads data as though it had come from the server.
+- (void)_receiveData:(NSData *)data;
+{
+    dispatch_sync(_workQueue, ^{
+        [self->_readBuffer appendData:data];
+        [self _pumpScanner];
+    });
+}
+
+// Returns a message as it would be sent, or nil if it would be sent uncompressed.
+- (NSData *)_compressedMessage:(NSData *)data;
+{
+    __block NSData *compressed = nil;
+    dispatch_sync(_workQueue, ^{
+        compressed = [self _deflateMessage:data];
+    });
+    return compressed;
+}
+
 - (void)_HTTPHeadersDidFinish;
 {
     NSInteger responseCode = CFHTTPMessageGetResponseStatusCode(_receivedHTTPHeaders);
@@ -494,6 +606,12 @@ static __strong NSData *CRLFCRLF;
         _protocol = negotiatedProtocol;
     }
 
+    NSString *negotiatedExtensions = CFBridgingRelease(CFHTTPMessageCopyHeaderFieldValue(_receivedHTTPHeaders, CFSTR("Sec-WebSocket-Extensions")));
+    if (negotiatedExtensions && ![self _negotiateExtensions:negotiatedExtensions]) {
+        [self _failWithError:[NSError errorWithDomain:FSRWebSocketErrorDomain code:2133 userInfo:[NSDictionary dictionaryWithObject:[NSString stringWithFormat:@"Server specified Sec-WebSocket-Extensions that weren't requested"] forKey:NSLocalizedDescriptionKey]]];
+        return;
+    }
+
     self.readyState = SR_OPEN;
 
     if (!_didFail) {
@@ -557,6 +675,11 @@ static __strong NSData *CRLFCRLF;
         CFHTTPMessageSetHeaderFieldValue(request, CFSTR("Sec-WebSocket-Protocol"), (__bridge CFStringRef)[_requestedProtocols componentsJoinedByString:@", "]);
     }
 
+    if (_requestsPerMessageDeflate) {
+        // Let the server pick the window we compress with; we always inflate with the largest one.
+        CFHTTPMessageSetHeaderFieldValue(request, CFSTR("Sec-WebSocket-Extensions"), CFSTR("permessage-deflate; client_max_window_bits"));
+    }
+
     [_urlRequest.allHTTPHeaderFields enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
         CFHTTPMessageSetHeaderFieldValue(request, (__bridge CFStringRef)key, (__bridge CFStringRef)obj);
     }];
@@ -743,9 +866,9 @@ static __strong NSData *CRLFCRLF;
     data = [data copy];
     dispatch_async(_workQueue, ^{
         if ([data isKindOfClass:[NSString class]]) {
-            [self _sendFrameWithOpcode:SROpCodeTextFrame data:[(NSString *)data dataUsingEncoding:NSUTF8StringEncoding]];
+            [self _sendMessageWithOpcode:SROpCodeTextFrame data:[(NSString *)data dataUsingEncoding:NSUTF8StringEncoding]];
         } else if ([data isKindOfClass:[NSData class]]) {
-            [self _sendFrameWithOpcode:SROpCodeBinaryFrame data:data];
+            [self _sendMessageWithOpcode:SROpCodeBinaryFrame data:data];
         } else if (data == nil) {
             [self _sendFrameWithOpcode:SROpCodeTextFrame data:data];
         } else {
@@ -866,6 +989,14 @@ static inline BOOL closeCodeIsValid(int closeCode) {
     // Check that the current data is valid UTF8
 
     BOOL isControlFrame = (opcode == SROpCodePing || opcode == SROpCodePong || opcode == SROpCodeConnectionClose);
+    if (!isControlFrame && _currentMessageCompressed) {
+        frameData = [self _inflateMessage:frameData];
+        if (frameData == nil) {
+            [self _closeWithProtocolError:@"Invalid compressed message"];
+            return;
+        }
+    }
+
     if (!isControlFrame) {
         [self _readFrameNew];
     } else {
@@ -986,6 +1117,7 @@ static inline BOOL closeCodeIsValid(int closeCode) {
 static const uint8_t SRFinMask          = 0x80;
 static const uint8_t SROpCodeMask       = 0x0F;
 static const uint8_t SRRsvMask          = 0x70;
+static const uint8_t SRRsv1Mask         = 0x40;
 static const uint8_t SRMaskMask         = 0x80;
 static const uint8_t SRPayloadLenMask   = 0x7F;
 
@@ -1000,15 +1132,18 @@ static const uint8_t SRPayloadLenMask   = 0x7F;
         const uint8_t *headerBuffer = data.bytes;
         assert(data.length >= 2);
 
-        if (headerBuffer[0] & SRRsvMask) {
-            [self _closeWithProtocolError:@"Server used RSV bits"];
-            return;
-        }
-
         uint8_t receivedOpcode = (SROpCodeMask & headerBuffer[0]);
 
         BOOL isControlFrame = (receivedOpcode == SROpCodePing || receivedOpcode == SROpCodePong || receivedOpcode == SROpCodeConnectionClose);
 
+        // permessage-deflate marks compressed messages with RSV1 on their first frame only.
+        uint8_t rsv = headerBuffer[0] & SRRsvMask;
+        BOOL compressed = rsv == SRRsv1Mask && self->_perMessageDeflateNegotiated && !isControlFrame && receivedOpcode != 0;
+        if (rsv && !compressed) {
+            [self _closeWithProtocolError:@"Server used RSV bits"];
+            return;
+        }
+
         if (!isControlFrame && receivedOpcode != 0 && self->_currentFrameCount > 0) {
             [self _closeWithProtocolError:@"all data frames after the initial data frame must have opcode 0"];
             return;
@@ -1019,6 +1154,10 @@ static const uint8_t SRPayloadLenMask   = 0x7F;
             return;
         }
 
+        if (receivedOpcode != 0 && !isControlFrame) {
+            self->_currentMessageCompressed = compressed;
+        }
+
         header.opcode = receivedOpcode == 0 ? self->_currentFrameOpcode : receivedOpcode;
 
         header.fin = !!(SRFinMask & headerBuffer[0]);
@@ -1350,7 +1489,131 @@ static const char CRLFCRLFBytes[] = {'\r', '\n', '\r', '\n'};
 
 static const size_t SRFrameHeaderOverhead = 32;
 
+// The bytes deflate ends a flushed block with. permessage-deflate leaves them out of each message.
+static const uint8_t SRDeflateTail[] = {0x00, 0x00, 0xff, 0xff};
+
+// Inflates length bytes into output, growing it as needed. Returns NO if the data is corrupt.
+static BOOL SRInflate(z_stream *stream, const uint8_t *bytes, size_t length, NSMutableData *output, size_t *outputLength, BOOL *ended) {
+    stream->next_in = (Bytef *)bytes;
+    stream->avail_in = (uInt)length;
+    do {
+        if (*outputLength == output.length) {
+            output.length = MAX(output.length * 2, 1024);
+        }
+        stream->next_out = (Bytef *)output.mutableBytes + *outputLength;
+        stream->avail_out = (uInt)(output.length - *outputLength);
+        int status = inflate(stream, Z_SYNC_FLUSH);
+        *outputLength = output.length - stream->avail_out;
+        if (status == Z_STREAM_END) {
+            // The server may end a message with a final block. Whatever follows it starts a new stream, like the next
+            // message does.
+            if (inflateReset(stream) != Z_OK) {
+                return NO;
+            }
+            *ended = stream->avail_in == 0;
+            if (*ended) {
+                return YES;
+            }
+        } else if (status == Z_BUF_ERROR && stream->avail_in == 0) {
+            break;
+        } else if (status != Z_OK) {
+            return NO;
+        }
+    } while (stream->avail_in > 0 || stream->avail_out == 0);
+    return YES;
+}
+
+- (NSData *)_inflateMessage:(NSData *)data;
+{
+    [self assertOnWorkQueue];
+
+    if (!_inflaterInitialized) {
+        memset(&_inflater, 0, sizeof(_inflater));
+        if (inflateInit2(&_inflater, -MAX_WBITS) != Z_OK) {
+            return nil;
+        }
+        _inflaterInitialized = YES;
+    }
+
+    NSMutableData *output = [[NSMutableData alloc] initWithLength:MAX(data.length * 4, 1024)];
+    size_t outputLength = 0;
+    BOOL ended = NO;
+    if (!SRInflate(&_inflater, data.bytes, data.length, output, &outputLength, &ended) ||
+        (!ended && !SRInflate(&_inflater, SRDeflateTail, sizeof(SRDeflateTail), output, &outputLength, &ended))) {
+        return nil;
+    }
+    if (_serverNoContextTakeover && !ended) {
+        inflateReset(&_inflater);
+    }
+    output.length = outputLength;
+    return output;
+}
+
+// Returns the compressed payload of a message, or nil if it should be sent as is.
+- (NSData *)_deflateMessage:(NSData *)data;
+{
+    [self assertOnWorkQueue];
+
+    if (!_deflaterInitialized) {
+        // zlib can't produce raw deflate streams that stay within a 256 byte window.
+        if (_clientMaxWindowBits < 9) {
+            return nil;
+        }
+        memset(&_deflater, 0, sizeof(_deflater));
+        if (deflateInit2(&_deflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -_clientMaxWindowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return nil;
+        }
+        _deflaterInitialized = YES;
+    }
+
+    NSMutableData *output = [[NSMutableData alloc] initWithLength:deflateBound(&_deflater, data.length) + sizeof(SRDeflateTail)];
+    size_t outputLength = 0;
+    _deflater.next_in = (Bytef *)data.bytes;
+    _deflater.avail_in = (uInt)data.length;
+    do {
+        if (outputLength == output.length) {
+            output.length *= 2;
+        }
+        _deflater.next_out = (Bytef *)output.mutableBytes + outputLength;
+        _deflater.avail_out = (uInt)(output.length - outputLength);
+        int status = deflate(&_deflater, Z_SYNC_FLUSH);
+        outputLength = output.length - _deflater.avail_out;
+        if (status != Z_OK && status != Z_BUF_ERROR) {
+            // Start over with the next message. The server never saw this one, so it can't be referenced.
+            deflateEnd(&_deflater);
+            _deflaterInitialized = NO;
+            return nil;
+        }
+    } while (_deflater.avail_out == 0);
+
+    assert(outputLength >= sizeof(SRDeflateTail) && memcmp((uint8_t *)output.bytes + outputLength - sizeof(SRDeflateTail), SRDeflateTail, sizeof(SRDeflateTail)) == 0);
+    output.length = outputLength - sizeof(SRDeflateTail);
+    if (_clientNoContextTakeover) {
+        deflateReset(&_deflater);
+    }
+    return output;
+}
+
+- (void)_sendMessageWithOpcode:(FSROpCode)opcode data:(NSData *)data;
+{
+    [self assertOnWorkQueue];
+
+    if (_perMessageDeflateNegotiated && data.length >= _compressionThreshold) {
+        NSData *compressed = [self _deflateMessage:data];
+        if (compressed) {
+            [self _sendFrameWithOpcode:opcode data:compressed compressed:YES];
+            return;
+        }
+    }
+    [self _sendFrameWithOpcode:opcode data:data compressed:NO];
+}
+
 - (void)_sendFrameWithOpcode:(FSROpCode)opcode data:(id)data;
+{
+    [self _sendFrameWithOpcode:opcode data:data compressed:NO];
+}
+
+- (void)_sendFrameWithOpcode:(FSROpCode)opcode data:(id)data compressed:(BOOL)compressed;
 {
     [self assertOnWorkQueue];
 
@@ -1369,8 +1632,8 @@ static const size_t SRFrameHeaderOverhead = 32;
     }
     uint8_t *frame_buffer = (uint8_t *)[frame mutableBytes];
 
-    // set fin
-    frame_buffer[0] = SRFinMask | opcode;
+    // set fin, and RSV1 for a compressed message
+    frame_buffer[0] = SRFinMask | opcode | (compressed ? SRRsv1Mask : 0);
 
     BOOL useMask = YES;
 #ifdef NOMASK
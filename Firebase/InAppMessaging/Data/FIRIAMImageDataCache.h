@@ -0,0 +1,47 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+/**
+ * A bounded two level cache for message image data keyed by image url. Recently used data is
+ * kept in memory and everything is also written to a directory under Caches so that an image
+ * fetched ahead of time is still there when the message is rendered after an app restart.
+ * Once the directory grows over its size limit, the least recently used files are removed first.
+ */
+@interface FIRIAMImageDataCache : NSObject
+
+// the cache shared by all the messages, backed by a directory under the app's Caches directory
++ (instancetype)sharedCache;
+
+- (instancetype)init NS_UNAVAILABLE;
+/**
+ * @param directoryPath the directory to keep cached image files in. It's created if needed.
+ * @param memoryLimit the max bytes of image data to keep in memory.
+ * @param diskLimit the max bytes of image files to keep in directoryPath.
+ */
+- (instancetype)initWithDirectoryPath:(NSString *)directoryPath
+               memoryCostLimitInBytes:(NSUInteger)memoryLimit
+                 diskSizeLimitInBytes:(NSUInteger)diskLimit NS_DESIGNATED_INITIALIZER;
+
+// returns nil if there is no data cached for the url
+- (nullable NSData *)imageDataForURL:(NSURL *)url;
+
+// the disk write and the trimming of the directory happen in the background
+- (void)storeImageData:(NSData *)imageData forURL:(NSURL *)url;
+@end
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <CommonCrypto/CommonDigest.h>
+#import <FirebaseCore/FIRLogger.h>
+
+#import "FIRCore+InAppMessaging.h"
+#import "FIRIAMImageDataCache.h"
+
+static NSUInteger const kSharedCacheMemoryLimitInBytes = 10 * 1024 * 1024;
+static NSUInteger const kSharedCacheDiskLimitInBytes = 20 * 1024 * 1024;
+
+@interface FIRIAMImageDataCache ()
+@property(nonatomic, readonly, copy) NSString *directoryPath;
+@property(nonatomic, readonly) NSUInteger diskLimit;
+@property(nonatomic, readonly) NSCache<NSString *, NSData *> *memoryCache;
+// serializes all the file operations on directoryPath
+@property(nonatomic, readonly) dispatch_queue_t diskQueue;
+@end
+
+@implementation FIRIAMImageDataCache
+
++ (instancetype)sharedCache {
+  static FIRIAMImageDataCache *sharedCache;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSString *cachePath =
+        NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES)[0];
+    NSString *directoryPath =
+        [cachePath stringByAppendingPathComponent:@"firebase-iam-image-data-cache"];
+    sharedCache = [[FIRIAMImageDataCache alloc] initWithDirectoryPath:directoryPath
+                                               memoryCostLimitInBytes:kSharedCacheMemoryLimitInBytes
+                                                 diskSizeLimitInBytes:kSharedCacheDiskLimitInBytes];
+  });
+  return sharedCache;
+}
+
+- (instancetype)initWithDirectoryPath:(NSString *)directoryPath
+               memoryCostLimitInBytes:(NSUInteger)memoryLimit
+                 diskSizeLimitInBytes:(NSUInteger)diskLimit {
+  if (self = [super init]) {
+    _directoryPath = [directoryPath copy];
+    _diskLimit = diskLimit;
+    _memoryCache = [[NSCache alloc] init];
+    _memoryCache.totalCostLimit = memoryLimit;
+    _diskQueue = dispatch_queue_create("com.google.firebase.inappmessaging.imagecache",
+                                       DISPATCH_QUEUE_SERIAL);
+  }
+  return self;
+}
+
+// image urls can be long and contain characters not allowed in file names, so files are named
+// after a digest of the url
+- (NSString *)cacheKeyForURL:(NSURL *)url {
+  NSData *urlData = [url.absoluteString dataUsingEncoding:NSUTF8StringEncoding];
+  unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+  CC_SHA1(urlData.bytes, (CC_LONG)urlData.length, digest);
+
+  NSMutableString *key = [NSMutableString stringWithCapacity:CC_SHA1_DIGEST_LENGTH * 2];
+  for (int i = 0; i < CC_SHA1_DIGEST_LENGTH; i++) {
+    [key appendFormat:@"%02x", digest[i]];
+  }
+  return key;
+}
+
+- (NSString *)filePathForKey:(NSString *)key {
+  return [self.directoryPath stringByAppendingPathComponent:key];
+}
+
+- (nullable NSData *)imageDataForURL:(NSURL *)url {
+  NSString *key = [self cacheKeyForURL:url];
+  NSData *imageData = [self.memoryCache objectForKey:key];
+  if (imageData) {
+    return imageData;
+  }
+
+  __block NSData *diskData;
+  dispatch_sync(self.diskQueue, ^{
+    NSString *filePath = [self filePathForKey:key];
+    diskData = [NSData dataWithContentsOfFile:filePath];
+    if (diskData) {
+      // bump the modification date so that the trimming treats this file as recently used
+      [[NSFileManager defaultManager] setAttributes:@{NSFileModificationDate : [NSDate date]}
+                                       ofItemAtPath:filePath
+                                              error:nil];
+    }
+  });
+
+  if (diskData) {
+    FIRLogDebug(kFIRLoggerInAppMessaging, @"I-IAM000005",
+                @"Image data for url %@ is read from the disk cache.", url);
+    [self.memoryCache setObject:diskData forKey:key cost:diskData.length];
+  }
+  return diskData;
+}
+
+- (void)storeImageData:(NSData *)imageData forURL:(NSURL *)url {
+  NSString *key = [self cacheKeyForURL:url];
+  [self.memoryCache setObject:imageData forKey:key cost:imageData.length];
+
+  dispatch_async(self.diskQueue, ^{
+    NSError *error;
+    if (![[NSFileManager defaultManager] createDirectoryAtPath:self.directoryPath
+                                   withIntermediateDirectories:YES
+                                                    attributes:nil
+                                                         error:&error] ||
+        ![imageData writeToFile:[self filePathForKey:key]
+                        options:NSDataWritingAtomic
+                          error:&error]) {
+      FIRLogWarning(kFIRLoggerInAppMessaging, @"I-IAM000006",
+                    @"Failed to write image data for url %@ to the disk cache: %@", url, error);
+      return;
+    }
+    [self trimDiskCache];
+  });
+}
+
+// must be called on diskQueue
+- (void)trimDiskCache {
+  NSArray<NSURLResourceKey> *resourceKeys =
+      @[ NSURLContentModificationDateKey, NSURLFileSizeKey ];
+  NSArray<NSURL *> *fileURLs = [[NSFileManager defaultManager]
+        contentsOfDirectoryAtURL:[NSURL fileURLWithPath:self.directoryPath isDirectory:YES]
+      includingPropertiesForKeys:resourceKeys
+                         options:NSDirectoryEnumerationSkipsHiddenFiles
+                           error:nil];
+
+  NSMutableDictionary<NSURL *, NSDictionary<NSURLResourceKey, id> *> *fileAttributes =
+      [NSMutableDictionary dictionaryWithCapacity:fileURLs.count];
+  NSUInteger totalSize = 0;
+  for (NSURL *fileURL in fileURLs) {
+    NSDictionary<NSURLResourceKey, id> *attributes = [fileURL resourceValuesForKeys:resourceKeys
+                                                                              error:nil];
+    if (attributes) {
+      fileAttributes[fileURL] = attributes;
+      totalSize += [attributes[NSURLFileSizeKey] unsignedIntegerValue];
+    }
+  }
+
+  if (totalSize <= self.diskLimit) {
+    return;
+  }
+
+  NSArray<NSURL *> *leastRecentlyUsedFirst = [fileAttributes
+      keysSortedByValueUsingComparator:^NSComparisonResult(NSDictionary *lhs, NSDictionary *rhs) {
+        return [lhs[NSURLContentModificationDateKey] compare:rhs[NSURLContentModificationDateKey]];
+      }];
+  for (NSURL *fileURL in leastRecentlyUsedFirst) {
+    if (totalSize <= self.diskLimit) {
+      break;
+    }
+    if ([[NSFileManager defaultManager] removeItemAtURL:fileURL error:nil]) {
+      totalSize -= [fileAttributes[fileURL][NSURLFileSizeKey] unsignedIntegerValue];
+    }
+  }
+  FIRLogDebug(kFIRLoggerInAppMessaging, @"I-IAM000007",
+              @"Image disk cache is trimmed down to %lu bytes.", (unsigned long)totalSize);
+}
+@end
@@ -18,6 +18,8 @@
 
 #import "FIRIAMMessageContentData.h"
 
+@class FIRIAMImageDataCache;
+
 NS_ASSUME_NONNULL_BEGIN
 /**
  * An implementation for protocol FIRIAMMessageContentData. This class takes a image url
@@ -25,7 +27,8 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @interface FIRIAMMessageContentDataWithImageURL : NSObject <FIRIAMMessageContentData>
 /**
- * Create an instance which uses NSURLSession to do the image data fetching.
+ * Create an instance which uses NSURLSession to do the image data fetching and keeps the
+ * fetched image data in the shared FIRIAMImageDataCache.
  *
  * @param title Message title text.
  * @param body Message body text.
@@ -43,5 +46,17 @@ NS_ASSUME_NONNULL_BEGIN
                            actionURL:(nullable NSURL *)actionURL
                             imageURL:(nullable NSURL *)imageURL
                      usingURLSession:(nullable NSURLSession *)URLSession;
+
+/**
+ * Same as above except that the image data is cached in imageDataCache instead of the shared
+ * cache. Image data is not cached at all if imageDataCache is nil.
+ */
+- (instancetype)initWithMessageTitle:(NSString *)title
+                         messageBody:(NSString *)body
+                    actionButtonText:(nullable NSString *)actionButtonText
+                           actionURL:(nullable NSURL *)actionURL
+                            imageURL:(nullable NSURL *)imageURL
+                     usingURLSession:(nullable NSURLSession *)URLSession
+                      imageDataCache:(nullable FIRIAMImageDataCache *)imageDataCache;
 @end
 NS_ASSUME_NONNULL_END
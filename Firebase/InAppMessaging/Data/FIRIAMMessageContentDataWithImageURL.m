@@ -18,6 +18,7 @@
 #import <FirebaseCore/FIRLogger.h>
 
 #import "FIRCore+InAppMessaging.h"
+#import "FIRIAMImageDataCache.h"
 #import "FIRIAMMessageContentData.h"
 #import "FIRIAMMessageContentDataWithImageURL.h"
 #import "FIRIAMSDKRuntimeErrorCodes.h"
@@ -31,6 +32,7 @@ static NSInteger const SuccessHTTPStatusCode = 200;
 @property(nonatomic, copy, nullable) NSURL *actionURL;
 @property(nonatomic, nullable, copy) NSURL *imageURL;
 @property(readonly) NSURLSession *URLSession;
+@property(nonatomic, nullable, readonly) FIRIAMImageDataCache *imageDataCache;
 @end
 
 @implementation FIRIAMMessageContentDataWithImageURL
@@ -40,6 +42,22 @@ static NSInteger const SuccessHTTPStatusCode = 200;
                            actionURL:(nullable NSURL *)actionURL
                             imageURL:(nullable NSURL *)imageURL
                      usingURLSession:(nullable NSURLSession *)URLSession {
+  return [self initWithMessageTitle:title
+                        messageBody:body
+                   actionButtonText:actionButtonText
+                          actionURL:actionURL
+                           imageURL:imageURL
+                    usingURLSession:URLSession
+                     imageDataCache:[FIRIAMImageDataCache sharedCache]];
+}
+
+- (instancetype)initWithMessageTitle:(NSString *)title
+                         messageBody:(NSString *)body
+                    actionButtonText:(nullable NSString *)actionButtonText
+                           actionURL:(nullable NSURL *)actionURL
+                            imageURL:(nullable NSURL *)imageURL
+                     usingURLSession:(nullable NSURLSession *)URLSession
+                      imageDataCache:(nullable FIRIAMImageDataCache *)imageDataCache {
   if (self = [super init]) {
     _titleText = title;
     _bodyText = body;
@@ -49,6 +67,7 @@ static NSInteger const SuccessHTTPStatusCode = 200;
 
     if (imageURL) {
       _URLSession = URLSession ? URLSession : [NSURLSession sharedSession];
+      _imageDataCache = imageDataCache;
     }
   }
   return self;
@@ -84,55 +103,73 @@ static NSInteger const SuccessHTTPStatusCode = 200;
   if (!_imageURL) {
     // no image data since image url is nil
     block(nil, nil);
+  } else if (self.imageDataCache) {
+    // the cache may have to read from disk, which should not happen on the caller's thread
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0ul), ^{
+      NSData *cachedData = [self.imageDataCache imageDataForURL:self.imageURL];
+      if (cachedData) {
+        block(cachedData, nil);
+      } else {
+        [self fetchImageDataWithBlock:block];
+      }
+    });
   } else {
-    NSURLRequest *imageDataRequest = [NSURLRequest requestWithURL:_imageURL];
-    NSURLSessionDataTask *task = [_URLSession
-        dataTaskWithRequest:imageDataRequest
-          completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
-            if (error) {
-              FIRLogWarning(kFIRLoggerInAppMessaging, @"I-IAM000003",
-                            @"Error in fetching image: %@", error);
-              block(nil, error);
-            } else {
-              if ([response isKindOfClass:[NSHTTPURLResponse class]]) {
-                NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse *)response;
-                if (httpResponse.statusCode == SuccessHTTPStatusCode) {
-                  if (httpResponse.MIMEType == nil || ![httpResponse.MIMEType hasPrefix:@"image"]) {
-                    NSString *errorDesc =
-                        [NSString stringWithFormat:@"None image MIME type %@"
-                                                    " detected for url %@",
-                                                   httpResponse.MIMEType, self.imageURL];
-                    FIRLogWarning(kFIRLoggerInAppMessaging, @"I-IAM000004", @"%@", errorDesc);
-
-                    NSError *error =
-                        [NSError errorWithDomain:kFirebaseInAppMessagingErrorDomain
-                                            code:FIRIAMSDKRuntimeErrorNonImageMimetypeFromImageURL
-                                        userInfo:@{NSLocalizedDescriptionKey : errorDesc}];
-                    block(nil, error);
-                  } else {
-                    block(data, nil);
-                  }
-                } else {
+    [self fetchImageDataWithBlock:block];
+  }
+}
+
+- (void)fetchImageDataWithBlock:(void (^)(NSData *_Nullable imageData,
+                                          NSError *_Nullable error))block {
+  NSURLRequest *imageDataRequest = [NSURLRequest requestWithURL:_imageURL];
+  NSURLSessionDataTask *task = [_URLSession
+      dataTaskWithRequest:imageDataRequest
+        completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+          if (error) {
+            FIRLogWarning(kFIRLoggerInAppMessaging, @"I-IAM000003",
+                          @"Error in fetching image: %@", error);
+            block(nil, error);
+          } else {
+            if ([response isKindOfClass:[NSHTTPURLResponse class]]) {
+              NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse *)response;
+              if (httpResponse.statusCode == SuccessHTTPStatusCode) {
+                if (httpResponse.MIMEType == nil || ![httpResponse.MIMEType hasPrefix:@"image"]) {
                   NSString *errorDesc =
-                      [NSString stringWithFormat:@"Failed HTTP request to crawl image %@: "
-                                                  "HTTP status code as %ld",
-                                                 self->_imageURL, (long)httpResponse.statusCode];
-                  FIRLogWarning(kFIRLoggerInAppMessaging, @"I-IAM000001", @"%@", errorDesc);
+                      [NSString stringWithFormat:@"None image MIME type %@"
+                                                  " detected for url %@",
+                                                 httpResponse.MIMEType, self.imageURL];
+                  FIRLogWarning(kFIRLoggerInAppMessaging, @"I-IAM000004", @"%@", errorDesc);
+
                   NSError *error =
-                      [NSError errorWithDomain:NSURLErrorDomain
-                                          code:httpResponse.statusCode
+                      [NSError errorWithDomain:kFirebaseInAppMessagingErrorDomain
+                                          code:FIRIAMSDKRuntimeErrorNonImageMimetypeFromImageURL
                                       userInfo:@{NSLocalizedDescriptionKey : errorDesc}];
                   block(nil, error);
+                } else {
+                  if (data) {
+                    [self.imageDataCache storeImageData:data forURL:self.imageURL];
+                  }
+                  block(data, nil);
                 }
               } else {
-                FIRLogWarning(kFIRLoggerInAppMessaging, @"I-IAM000002",
-                              @"Internal error: got a non http response from fetching image for "
-                              @"image url as %@",
-                              self->_imageURL);
+                NSString *errorDesc =
+                    [NSString stringWithFormat:@"Failed HTTP request to crawl image %@: "
+                                                "HTTP status code as %ld",
+                                               self->_imageURL, (long)httpResponse.statusCode];
+                FIRLogWarning(kFIRLoggerInAppMessaging, @"I-IAM000001", @"%@", errorDesc);
+                NSError *error =
+                    [NSError errorWithDomain:NSURLErrorDomain
+                                        code:httpResponse.statusCode
+                                    userInfo:@{NSLocalizedDescriptionKey : errorDesc}];
+                block(nil, error);
               }
+            } else {
+              FIRLogWarning(kFIRLoggerInAppMessaging, @"I-IAM000002",
+                            @"Internal error: got a non http response from fetching image for "
+                            @"image url as %@",
+                            self->_imageURL);
             }
-          }];
-    [task resume];
-  }
+          }
+        }];
+  [task resume];
 }
 @end
@@ -88,6 +88,29 @@ NSString *const kFIRIAMFetchIsDoneNotification = @"FIRIAMFetchIsDoneNotification
                                                       object:self];
 }
 
+// Downloads the image data of the messages that could be rendered from now on, so that
+// rendering them later on does not have to wait for the network. The data is kept in the
+// image data cache of each message's content data.
+- (void)prefetchImagesForMessages:(NSArray<FIRIAMMessageDefinition *> *)messages {
+  NSSet<NSString *> *impressedMessageIDs =
+      [NSSet setWithArray:[self.fetchBookKeeper getMessageIDsFromImpressions]];
+
+  NSUInteger prefetchCount = 0;
+  for (FIRIAMMessageDefinition *next in messages) {
+    if ([impressedMessageIDs containsObject:next.renderData.messageID] ||
+        [next messageHasExpired]) {
+      continue;
+    }
+    prefetchCount++;
+    [next.renderData.contentData
+        loadImageDataWithBlock:^(NSData *_Nullable imageData, NSError *_Nullable error){
+            // nothing to do here: the image data is cached as a side effect of loading it
+        }];
+  }
+  FIRLogDebug(kFIRLoggerInAppMessaging, @"I-IAM700009", @"Prefetching images for %lu messages.",
+              (unsigned long)prefetchCount);
+}
+
 - (void)handleSuccessullyFetchedMessages:(NSArray<FIRIAMMessageDefinition *> *)messagesInResponse
                        withFetchWaitTime:(NSNumber *_Nullable)fetchWaitTime
                       requestImpressions:(NSArray<FIRIAMImpressionRecord *> *)requestImpressions {
@@ -117,6 +140,7 @@ NSString *const kFIRIAMFetchIsDoneNotification = @"FIRIAMFetchIsDoneNotification
 
   [self.fetchBookKeeper clearImpressionsWithMessageList:[idIntersection allObjects]];
   [self.messageCache setMessageData:messagesInResponse];
+  [self prefetchImagesForMessages:messagesInResponse];
 
   [self.sdkModeManager registerOneMoreFetch];
   [self.fetchBookKeeper recordNewFetchWithFetchCount:messagesInResponse.count
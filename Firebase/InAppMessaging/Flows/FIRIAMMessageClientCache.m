@@ -31,6 +31,12 @@
 @property(nonatomic) NSMutableArray<FIRIAMMessageDefinition *> *testMessages;
 @property(nonatomic, weak) id<FIRIAMCacheDataObserver> observer;
 @property(nonatomic) NSMutableSet<NSString *> *firebaseAnalyticEventsToWatch;
+// indexes of regularMessages by trigger, rebuilt whenever regularMessages changes, so that
+// finding a message for a trigger does not scan all the messages and their triggers. Messages
+// keep their relative order from regularMessages, which is their display priority
+@property(nonatomic) NSMutableDictionary<NSString *, NSMutableArray<FIRIAMMessageDefinition *> *>
+    *messagesByFirebaseAnalyticEvent;
+@property(nonatomic) NSMutableArray<FIRIAMMessageDefinition *> *appForegroundMessages;
 @property(nonatomic) id<FIRIAMBookKeeper> bookKeeper;
 @property(readonly, nonatomic) FIRIAMFetchResponseParser *responseParser;
 
@@ -92,18 +98,39 @@
   [self.observer dataChanged];
 }
 
-// triggered after self.messages are updated so that we can correctly enable/disable listening
-// on analytics event based on current fiam message set
-- (void)setupAnalyticsEventListening {
-  self.firebaseAnalyticEventsToWatch = [[NSMutableSet alloc] init];
+// rebuild the trigger indexes from self.regularMessages
+- (void)rebuildTriggerIndexes {
+  self.messagesByFirebaseAnalyticEvent = [[NSMutableDictionary alloc] init];
+  self.appForegroundMessages = [[NSMutableArray alloc] init];
   for (FIRIAMMessageDefinition *nextMessage in self.regularMessages) {
-    // if it's event based triggering, add it to the watch set
     for (FIRIAMDisplayTriggerDefinition *nextTrigger in nextMessage.renderTriggers) {
       if (nextTrigger.triggerType == FIRIAMRenderTriggerOnFirebaseAnalyticsEvent) {
-        [self.firebaseAnalyticEventsToWatch addObject:nextTrigger.firebaseEventName];
+        NSString *eventName = nextTrigger.firebaseEventName;
+        NSMutableArray<FIRIAMMessageDefinition *> *eventMessages =
+            self.messagesByFirebaseAnalyticEvent[eventName];
+        if (!eventMessages) {
+          eventMessages = [[NSMutableArray alloc] init];
+          self.messagesByFirebaseAnalyticEvent[eventName] = eventMessages;
+        }
+        // a message may have several triggers on the same event
+        if (eventMessages.lastObject != nextMessage) {
+          [eventMessages addObject:nextMessage];
+        }
+      } else if (nextTrigger.triggerType == FIRIAMRenderTriggerOnAppForeground &&
+                 self.appForegroundMessages.lastObject != nextMessage) {
+        [self.appForegroundMessages addObject:nextMessage];
       }
     }
   }
+}
+
+// triggered after self.messages are updated so that we can correctly enable/disable listening
+// on analytics event based on current fiam message set
+- (void)setupAnalyticsEventListening {
+  [self rebuildTriggerIndexes];
+  // every event with event based triggering messages is in the watch set
+  self.firebaseAnalyticEventsToWatch =
+      [NSMutableSet setWithArray:self.messagesByFirebaseAnalyticEvent.allKeys];
 
   if (self.analycisEventDislayCheckFlow) {
     if ([self.firebaseAnalyticEventsToWatch count] > 0) {
@@ -144,11 +171,10 @@
       return testMessage;
     }
 
-    for (FIRIAMMessageDefinition *next in self.regularMessages) {
+    for (FIRIAMMessageDefinition *next in self.appForegroundMessages) {
       // message being active and message not impressed yet
       if ([next messageHasStarted] && ![next messageHasExpired] &&
-          ![impressionSet containsObject:next.renderData.messageID] &&
-          [next messageRenderedOnAppForegroundEvent]) {
+          ![impressionSet containsObject:next.renderData.messageID]) {
         return next;
       }
     }
@@ -168,12 +194,11 @@
   NSSet<NSString *> *impressionSet =
       [NSSet setWithArray:[self.bookKeeper getMessageIDsFromImpressions]];
   @synchronized(self) {
-    for (FIRIAMMessageDefinition *next in self.regularMessages) {
-      // message being active and message not impressed yet and the contextual trigger condition
-      // match
+    // only the messages whose contextual trigger condition match are indexed under eventName
+    for (FIRIAMMessageDefinition *next in self.messagesByFirebaseAnalyticEvent[eventName]) {
+      // message being active and message not impressed yet
       if ([next messageHasStarted] && ![next messageHasExpired] &&
-          ![impressionSet containsObject:next.renderData.messageID] &&
-          [next messageRenderedOnAnalyticsEvent:eventName]) {
+          ![impressionSet containsObject:next.renderData.messageID]) {
         return next;
       }
     }
@@ -121,6 +121,7 @@ typedef NS_ENUM(NSInteger, FIRInstanceIDMessageCode) {
   kFIRInstanceIDMessageCodeTokenManagerAPNSChanged = 14010,
   kFIRInstanceIDMessageCodeTokenManagerAPNSChangedTokenInvalidated = 14011,
   kFIRInstanceIDMessageCodeTokenManagerInvalidateStaleToken = 14012,
+  kFIRInstanceIDMessageCodeTokenManagerFetchInProgress = 14013,
   // FIRInstanceIDTokenStore.m
   // DO NOT USE 15002 - 15013
   kFIRInstanceIDMessageCodeTokenStore000 = 15000,
@@ -121,6 +121,9 @@ NSString *FIRInstanceIDCreationTimeKeyWithSubtype(NSString *subtype) {
 @property(nonatomic, readwrite, strong) FIRInstanceIDBackupExcludedPlist *plist;
 @property(nonatomic, readwrite, strong) FIRInstanceIDKeyPair *keyPair;
 @property(nonatomic, readwrite, assign) NSInteger keychainEntitlementsErrorCount;
+// Whether the legacy key pair still has to be looked for and migrated. Only accessed within
+// @synchronized(self).
+@property(nonatomic, readwrite, assign) BOOL needsKeyPairMigration;
 
 @end
 
@@ -149,11 +152,27 @@ NSString *FIRInstanceIDCreationTimeKeyWithSubtype(NSString *subtype) {
     [self deleteSavedKeyPairWithSubtype:kFIRInstanceIDKeyPairSubType handler:nil];
     return YES;
   }
-  // Not a fresh install, perform migration at early state.
-  [self migrateKeyPairCacheIfNeededWithHandler:nil];
+  // Not a fresh install, perform migration at early state. Looking for the legacy key pair reads
+  // the Keychain, so it is done in the background; loading the key pair first waits for it.
+  @synchronized(self) {
+    self.needsKeyPairMigration = YES;
+  }
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    [self migrateKeyPairCacheIfPending];
+  });
   return NO;
 }
 
+- (void)migrateKeyPairCacheIfPending {
+  @synchronized(self) {
+    if (!self.needsKeyPairMigration) {
+      return;
+    }
+    self.needsKeyPairMigration = NO;
+    [self migrateKeyPairCacheIfNeededWithHandler:nil];
+  }
+}
+
 - (BOOL)hasCachedKeyPairs {
   NSError *error;
   if ([self cachedKeyPairWithSubtype:kFIRInstanceIDKeyPairSubType error:&error] == nil) {
@@ -198,6 +217,8 @@ NSString *FIRInstanceIDCreationTimeKeyWithSubtype(NSString *subtype) {
   // keyPair multiple times. Once we have a keyPair in the cache it would mostly be used
   // from there.
   @synchronized(self) {
+    // A legacy key pair must be migrated rather than replaced by a newly generated one.
+    [self migrateKeyPairCacheIfPending];
     if ([self.keyPair isValid]) {
       return self.keyPair;
     }
@@ -44,6 +44,8 @@ static NSString *const kFIRInstanceIDLibraryVersion = @"GMSInstanceID-version";
                   subDirectoryName:kFIRInstanceIDSubDirectoryName];
 
   FIRInstanceIDTokenStore *tokenStore = [FIRInstanceIDTokenStore defaultStore];
+  // The default token is asked for as soon as InstanceID is configured.
+  [tokenStore prefetchTokenInfos];
 
   return [self initWithCheckinStore:checkinStore tokenStore:tokenStore delegate:delegate];
 }
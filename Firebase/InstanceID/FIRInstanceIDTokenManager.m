@@ -19,6 +19,7 @@
 #import "FIRInstanceIDAuthKeyChain.h"
 #import "FIRInstanceIDAuthService.h"
 #import "FIRInstanceIDCheckinPreferences.h"
+#import "FIRInstanceIDCombinedHandler.h"
 #import "FIRInstanceIDConstants.h"
 #import "FIRInstanceIDDefines.h"
 #import "FIRInstanceIDLogger.h"
@@ -37,6 +38,14 @@
 
 @property(nonatomic, readwrite, strong) FIRInstanceIDAPNSInfo *currentAPNSInfo;
 
+// The handlers and the options of the token fetches in flight, keyed by authorized entity and
+// scope. Only accessed within @synchronized(self).
+@property(nonatomic, readonly, strong)
+    NSMutableDictionary<NSString *, FIRInstanceIDCombinedHandler<NSString *> *>
+        *pendingFetchHandlers;
+@property(nonatomic, readonly, strong)
+    NSMutableDictionary<NSString *, NSDictionary *> *pendingFetchOptions;
+
 @end
 
 @implementation FIRInstanceIDTokenManager
@@ -46,6 +55,8 @@
   if (self) {
     _instanceIDStore = [[FIRInstanceIDStore alloc] initWithDelegate:self];
     _authService = [[FIRInstanceIDAuthService alloc] initWithStore:_instanceIDStore];
+    _pendingFetchHandlers = [NSMutableDictionary dictionary];
+    _pendingFetchOptions = [NSMutableDictionary dictionary];
     [self configureTokenOperations];
   }
   return self;
@@ -77,18 +88,49 @@
   FIRInstanceIDLoggerDebug(kFIRInstanceIDMessageCodeTokenManager000,
                            @"Fetch new token for authorizedEntity: %@, scope: %@", authorizedEntity,
                            scope);
+  // A fetch for the same token with the same options, e.g. the same APNs token, that is already in
+  // flight is joined rather than sent again.
+  NSString *fetchKey = [NSString stringWithFormat:@"%@:%@", authorizedEntity, scope];
+  FIRInstanceIDCombinedHandler<NSString *> *fetchHandlers;
+  @synchronized(self) {
+    fetchHandlers = self.pendingFetchHandlers[fetchKey];
+    if (fetchHandlers && [self.pendingFetchOptions[fetchKey] isEqualToDictionary:options ?: @{}]) {
+      FIRInstanceIDLoggerDebug(kFIRInstanceIDMessageCodeTokenManagerFetchInProgress,
+                               @"Token fetch already in progress for authorizedEntity: %@, "
+                               @"scope: %@",
+                               authorizedEntity, scope);
+      [fetchHandlers addHandler:handler];
+      return;
+    }
+    fetchHandlers = [[FIRInstanceIDCombinedHandler<NSString *> alloc] init];
+    [fetchHandlers addHandler:handler];
+    self.pendingFetchHandlers[fetchKey] = fetchHandlers;
+    self.pendingFetchOptions[fetchKey] = [options copy] ?: @{};
+  }
+  FIRInstanceID_WEAKIFY(self);
+  FIRInstanceIDTokenHandler fetchHandler = ^(NSString *token, NSError *error) {
+    FIRInstanceID_STRONGIFY(self);
+    @synchronized(self) {
+      // A newer fetch with other options may have taken the place of this one.
+      if (self.pendingFetchHandlers[fetchKey] == fetchHandlers) {
+        [self.pendingFetchHandlers removeObjectForKey:fetchKey];
+        [self.pendingFetchOptions removeObjectForKey:fetchKey];
+      }
+    }
+    fetchHandlers.combinedHandler(token, error);
+  };
+
   FIRInstanceIDTokenFetchOperation *operation =
       [self createFetchOperationWithAuthorizedEntity:authorizedEntity
                                                scope:scope
                                              options:options
                                              keyPair:keyPair];
-  FIRInstanceID_WEAKIFY(self);
   FIRInstanceIDTokenOperationCompletion completion =
       ^(FIRInstanceIDTokenOperationResult result, NSString *_Nullable token,
         NSError *_Nullable error) {
         FIRInstanceID_STRONGIFY(self);
         if (error) {
-          handler(nil, error);
+          fetchHandler(nil, error);
           return;
         }
         NSString *firebaseAppID = options[kFIRInstanceIDTokenOptionsFirebaseAppIDKey];
@@ -116,13 +158,9 @@
                           @"Token fetch successful, token: %@, authorizedEntity: %@, scope:%@",
                           token, authorizedEntity, scope);
 
-                      if (handler) {
-                        handler(token, nil);
-                      }
+                      fetchHandler(token, nil);
                     } else {
-                      if (handler) {
-                        handler(nil, error);
-                      }
+                      fetchHandler(nil, error);
                     }
                   }];
       };
@@ -51,6 +51,13 @@ NS_ASSUME_NONNULL_BEGIN
 
 #pragma mark - Get
 
+/**
+ *  Start loading all the token infos from the Keychain in the background, in a single query, so
+ *  that they are in memory by the time they are asked for. Token infos are otherwise loaded the
+ *  first time any of them is asked for.
+ */
+- (void)prefetchTokenInfos;
+
 /**
  *  Get the cached token from the Keychain.
  *
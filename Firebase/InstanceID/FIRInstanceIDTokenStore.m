@@ -27,6 +27,11 @@ static NSString *const kFIRInstanceIDTokenKeychainId = @"com.google.iid-tokens";
 @interface FIRInstanceIDTokenStore ()
 
 @property(nonatomic, readwrite, strong) FIRInstanceIDAuthKeychain *keychain;
+// The token infos in the keychain keyed by service key, loaded with a single keychain query the
+// first time any of them is needed. Only accessed within @synchronized(self), which also guards
+// all access to the keychain.
+@property(nonatomic, readwrite, strong)
+    NSMutableDictionary<NSString *, FIRInstanceIDTokenInfo *> *tokenInfoSnapshot;
 
 @end
 
@@ -52,32 +57,49 @@ static NSString *const kFIRInstanceIDTokenKeychainId = @"com.google.iid-tokens";
   return [NSString stringWithFormat:@"%@:%@", authorizedEntity, scope];
 }
 
-- (nullable FIRInstanceIDTokenInfo *)tokenInfoWithAuthorizedEntity:(NSString *)authorizedEntity
-                                                             scope:(NSString *)scope {
-  NSString *account = FIRInstanceIDAppIdentifier();
-  NSString *service = [[self class] serviceKeyForAuthorizedEntity:authorizedEntity scope:scope];
-  NSData *item = [self.keychain dataForService:service account:account];
-  if (!item) {
-    return nil;
-  }
-  // Token infos created from legacy storage don't have appVersion, firebaseAppID, or APNSInfo.
-  FIRInstanceIDTokenInfo *tokenInfo = [[self class] tokenInfoFromKeychainItem:item];
-  return tokenInfo;
+- (void)prefetchTokenInfos {
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    @synchronized(self) {
+      [self loadTokenInfoSnapshotIfNeeded];
+    }
+  });
 }
 
-- (NSArray<FIRInstanceIDTokenInfo *> *)cachedTokenInfos {
+// Must be called within @synchronized(self).
+- (void)loadTokenInfoSnapshotIfNeeded {
+  if (self.tokenInfoSnapshot) {
+    return;
+  }
   NSString *account = FIRInstanceIDAppIdentifier();
   NSArray<NSData *> *items =
       [self.keychain itemsMatchingService:kFIRInstanceIDKeychainWildcardIdentifier account:account];
-  NSMutableArray<FIRInstanceIDTokenInfo *> *tokenInfos =
-      [NSMutableArray arrayWithCapacity:items.count];
+  self.tokenInfoSnapshot = [NSMutableDictionary dictionaryWithCapacity:items.count];
   for (NSData *item in items) {
+    // Token infos created from legacy storage don't have appVersion, firebaseAppID, or APNSInfo.
     FIRInstanceIDTokenInfo *tokenInfo = [[self class] tokenInfoFromKeychainItem:item];
-    if (tokenInfo) {
-      [tokenInfos addObject:tokenInfo];
+    if (!tokenInfo) {
+      continue;
     }
+    NSString *service = [[self class] serviceKeyForAuthorizedEntity:tokenInfo.authorizedEntity
+                                                              scope:tokenInfo.scope];
+    self.tokenInfoSnapshot[service] = tokenInfo;
+  }
+}
+
+- (nullable FIRInstanceIDTokenInfo *)tokenInfoWithAuthorizedEntity:(NSString *)authorizedEntity
+                                                             scope:(NSString *)scope {
+  NSString *service = [[self class] serviceKeyForAuthorizedEntity:authorizedEntity scope:scope];
+  @synchronized(self) {
+    [self loadTokenInfoSnapshotIfNeeded];
+    return self.tokenInfoSnapshot[service];
+  }
+}
+
+- (NSArray<FIRInstanceIDTokenInfo *> *)cachedTokenInfos {
+  @synchronized(self) {
+    [self loadTokenInfoSnapshotIfNeeded];
+    return self.tokenInfoSnapshot.allValues;
   }
-  return tokenInfos;
 }
 
 + (nullable FIRInstanceIDTokenInfo *)tokenInfoFromKeychainItem:(NSData *)item {
@@ -111,11 +133,27 @@ static NSString *const kFIRInstanceIDTokenKeychainId = @"com.google.iid-tokens";
   NSString *account = FIRInstanceIDAppIdentifier();
   NSString *service = [[self class] serviceKeyForAuthorizedEntity:tokenInfo.authorizedEntity
                                                             scope:tokenInfo.scope];
-  [self.keychain setData:tokenInfoData
-              forService:service
-           accessibility:NULL
-                 account:account
-                 handler:handler];
+  @synchronized(self) {
+    [self loadTokenInfoSnapshotIfNeeded];
+    self.tokenInfoSnapshot[service] = tokenInfo;
+    [self.keychain setData:tokenInfoData
+                forService:service
+             accessibility:NULL
+                   account:account
+                   handler:^(NSError *error) {
+                     if (error) {
+                       // The token info did not make it to the keychain, so forget about it too.
+                       @synchronized(self) {
+                         if (self.tokenInfoSnapshot[service] == tokenInfo) {
+                           [self.tokenInfoSnapshot removeObjectForKey:service];
+                         }
+                       }
+                     }
+                     if (handler) {
+                       handler(error);
+                     }
+                   }];
+  }
 }
 
 #pragma mark - Delete
@@ -124,14 +162,20 @@ static NSString *const kFIRInstanceIDTokenKeychainId = @"com.google.iid-tokens";
                                   scope:(nonnull NSString *)scope {
   NSString *account = FIRInstanceIDAppIdentifier();
   NSString *service = [[self class] serviceKeyForAuthorizedEntity:authorizedEntity scope:scope];
-  [self.keychain removeItemsMatchingService:service account:account handler:nil];
+  @synchronized(self) {
+    [self.tokenInfoSnapshot removeObjectForKey:service];
+    [self.keychain removeItemsMatchingService:service account:account handler:nil];
+  }
 }
 
 - (void)removeAllTokensWithHandler:(void (^)(NSError *error))handler {
   NSString *account = FIRInstanceIDAppIdentifier();
-  [self.keychain removeItemsMatchingService:kFIRInstanceIDKeychainWildcardIdentifier
-                                    account:account
-                                    handler:handler];
+  @synchronized(self) {
+    self.tokenInfoSnapshot = [NSMutableDictionary dictionary];
+    [self.keychain removeItemsMatchingService:kFIRInstanceIDKeychainWildcardIdentifier
+                                      account:account
+                                      handler:handler];
+  }
 }
 
 @end
@@ -60,6 +60,7 @@ typedef NS_ENUM(NSInteger, FIRMessagingMessageCode) {
   kFIRMessagingMessageCodeClient009 = 4009,  // I-FCM004009
   kFIRMessagingMessageCodeClient010 = 4010,  // I-FCM004010
   kFIRMessagingMessageCodeClient011 = 4011,  // I-FCM004011
+  kFIRMessagingMessageCodeClient012 = 4012,  // I-FCM004012
   // FIRMessagingConnection.m
   kFIRMessagingMessageCodeConnection000 = 5000,  // I-FCM005000
   kFIRMessagingMessageCodeConnection001 = 5001,  // I-FCM005001
@@ -85,6 +86,7 @@ typedef NS_ENUM(NSInteger, FIRMessagingMessageCode) {
   kFIRMessagingMessageCodeConnection021 = 5021,  // I-FCM005021
   kFIRMessagingMessageCodeConnection022 = 5022,  // I-FCM005022
   kFIRMessagingMessageCodeConnection023 = 5023,  // I-FCM005023
+  kFIRMessagingMessageCodeConnection024 = 5024,  // I-FCM005024
   // FIRMessagingContextManagerService.m
   kFIRMessagingMessageCodeContextManagerService000 = 6000,  // I-FCM006000
   kFIRMessagingMessageCodeContextManagerService001 = 6001,  // I-FCM006001
@@ -139,6 +141,8 @@ typedef NS_ENUM(NSInteger, FIRMessagingMessageCode) {
   kFIRMessagingMessageCodeRmq2PersistentStoreErrorOpeningDatabase = 13008,  // I-FCM013008
   kFIRMessagingMessageCodeRmq2PersistentStoreInvalidRmqDirectory = 13009,  // I-FCM013009
   kFIRMessagingMessageCodeRmq2PersistentStoreErrorCreatingTable = 13010,  // I-FCM013010
+  kFIRMessagingMessageCodeRmq2PersistentStore007 = 13011,  // I-FCM013011
+  kFIRMessagingMessageCodeRmq2PersistentStore008 = 13012,  // I-FCM013012
   // FIRMessagingRmqManager.m
   kFIRMessagingMessageCodeRmqManager000 = 14000,  // I-FCM014000
   // FIRMessagingSecureSocket.m
@@ -87,6 +87,13 @@ static NSUInteger FIRMessagingServerPort() {
 @property(nonatomic, readwrite, assign) int64_t lastConnectedTimestamp;
 @property(nonatomic, readwrite, assign) int64_t lastDisconnectedTimestamp;
 @property(nonatomic, readwrite, assign) NSUInteger connectRetryCount;
+// When the backoff after the last failed connection attempt ends, in milliseconds, or 0 if the
+// last attempt succeeded. Kept across disconnects, so that reconnecting on every foreground or
+// reachability callback doesn't bypass the backoff.
+@property(nonatomic, readwrite, assign) int64_t connectRetryTimestamp;
+// The reachability status the last failed connection attempt was made on. The backoff only
+// applies while the device stays on that network.
+@property(nonatomic, readwrite, assign) GULReachabilityStatus connectRetryReachabilityStatus;
 
 // Should we stay connected to MCS or not. Should be YES throughout the lifetime
 // of a MCS connection. If set to NO it signifies that an existing MCS connection
@@ -240,7 +247,7 @@ static NSUInteger FIRMessagingServerPort() {
   if (immediately) {
     FIRMessagingLoggerDebug(kFIRMessagingMessageCodeClient007,
                             @"Try to connect to MCS immediately");
-    [self tryToConnect];
+    [self tryToConnectAfterBackoff];
   } else {
     FIRMessagingLoggerDebug(kFIRMessagingMessageCodeClient008, @"Try to connect to MCS lazily");
     // Avoid all the other logic that we have in other clients, since this would always happen
@@ -276,9 +283,6 @@ static NSUInteger FIRMessagingServerPort() {
 }
 
 - (void)connect {
-  // reset retry counts
-  self.connectRetryCount = 0;
-
   if (self.isConnected) {
     return;
   }
@@ -296,7 +300,8 @@ static NSUInteger FIRMessagingServerPort() {
     // |kFIRMessagingCheckinFetchedNotification| will be fired.
     return;
   }
-  [self setupConnectionAndConnect];
+  [self setupConnection];
+  [self tryToConnectAfterBackoff];
 }
 
 - (void)disconnect {
@@ -373,7 +378,7 @@ static NSUInteger FIRMessagingServerPort() {
   [NSObject cancelPreviousPerformRequestsWithTarget:self
                                            selector:@selector(didConnectTimeout)
                                              object:nil];
-  self.connectRetryCount = 0;
+  [self resetConnectRetries];
   self.lastConnectedTimestamp = FIRMessagingCurrentTimestampInMilliseconds();
 
 
@@ -413,11 +418,6 @@ static NSUInteger FIRMessagingServerPort() {
 
 #pragma mark - Private
 
-- (void)setupConnectionAndConnect {
-  [self setupConnection];
-  [self tryToConnect];
-}
-
 - (void)setupConnection {
   NSString *host = FIRMessagingServerHost();
   NSUInteger port = FIRMessagingServerPort();
@@ -465,6 +465,37 @@ static NSUInteger FIRMessagingServerPort() {
   [self.connection signIn];
 }
 
+/**
+ *  Connects right away, unless a previous attempt failed on the current network less than its
+ *  backoff ago. In that case the connection is made once the backoff ends, coalescing all the
+ *  requests made in the meantime into a single attempt.
+ */
+- (void)tryToConnectAfterBackoff {
+  if (self.connectRetryTimestamp != 0 &&
+      self.reachability.reachabilityStatus != self.connectRetryReachabilityStatus) {
+    // The failures happened on another network, they say nothing about this one.
+    [self resetConnectRetries];
+  }
+  int64_t remaining = self.connectRetryTimestamp - FIRMessagingCurrentTimestampInMilliseconds();
+  if (remaining <= 0) {
+    [self tryToConnect];
+    return;
+  }
+  FIRMessagingLoggerDebug(kFIRMessagingMessageCodeClient012,
+                          @"Backing off, connect to MCS in %lld milliseconds", remaining);
+  [NSObject cancelPreviousPerformRequestsWithTarget:self
+                                           selector:@selector(tryToConnect)
+                                             object:nil];
+  [self performSelector:@selector(tryToConnect)
+             withObject:nil
+             afterDelay:remaining / 1000.0];
+}
+
+- (void)resetConnectRetries {
+  self.connectRetryCount = 0;
+  self.connectRetryTimestamp = 0;
+}
+
 - (void)didConnectTimeout {
   _FIRMessagingDevAssert(self.connection.state != kFIRMessagingConnectionSignedIn,
                 @"Invalid state for MCS connection");
@@ -499,6 +530,9 @@ static NSUInteger FIRMessagingServerPort() {
   }
 
   NSUInteger retryInterval = [self nextRetryInterval];
+  self.connectRetryTimestamp =
+      FIRMessagingCurrentTimestampInMilliseconds() + (int64_t)retryInterval * 1000;
+  self.connectRetryReachabilityStatus = status;
 
   FIRMessagingLoggerDebug(kFIRMessagingMessageCodeClient011,
                           @"Failed to sign in to MCS, retry in %lu seconds",
@@ -25,4 +25,10 @@
 - (BOOL)readLength:(int32_t *)length;
 - (NSData *)readDataWithLength:(uint32_t)length;
 
+/**
+ *  Reads the next |length| bytes without copying them. The returned data points into the bytes of
+ *  the data the stream was initialized with, so it must not outlive them.
+ */
+- (NSData *)readDataNoCopyWithLength:(uint32_t)length;
+
 @end
@@ -139,4 +139,14 @@ static BOOL ReadRawVarInt32(BufferState *state, int32_t *output) {
   return result;
 }
 
+- (NSData *)readDataNoCopyWithLength:(uint32_t)length {
+  if (!CheckSize(&_state, length)) {
+    return nil;
+  }
+  void *bytesToRead = (void *)(_state.bytes + _state.bufferPos);
+  NSData *result = [NSData dataWithBytesNoCopy:bytesToRead length:length freeWhenDone:NO];
+  _state.bufferPos += length;
+  return result;
+}
+
 @end
@@ -22,6 +22,7 @@
 #import "FIRMessaging.h"
 #import "FIRMessagingDataMessageManager.h"
 #import "FIRMessagingDefines.h"
+#import "FIRMessagingHeartbeatInterval.h"
 #import "FIRMessagingLogger.h"
 #import "FIRMessagingRmqManager.h"
 #import "FIRMessagingSecureSocket.h"
@@ -29,13 +30,14 @@
 #import "FIRMessagingVersionUtilities.h"
 #import "FIRMessaging_Private.h"
 
+#import <GoogleUtilities/GULUserDefaults.h>
+
 static NSInteger const kIqSelectiveAck = 12;
 static NSInteger const kIqStreamAck = 13;
 static int const kInvalidStreamId = -1;
 // Threshold for number of messages removed that we will ack, for short lived connections
 static int const kMessageRemoveAckThresholdCount = 5;
 
-static NSTimeInterval const kHeartbeatInterval = 30.0;
 static NSTimeInterval const kConnectionTimeout = 20.0;
 static int32_t const kAckingInterval = 10;
 
@@ -104,6 +106,14 @@ static NSString *const kRemoteFromAddress = @"from";
 
 @property(nonatomic, readwrite, strong) NSRunLoop *runLoop;
 
+@property(nonatomic, readwrite, strong) FIRMessagingHeartbeatInterval *heartbeatIntervals;
+// When the last proto was received, in milliseconds. Heartbeats are only sent after silence.
+@property(nonatomic, readwrite, assign) int64_t lastReceiveTimestamp;
+// How long the connection had been idle when the outstanding heartbeat ping was sent, and on
+// which network type.
+@property(nonatomic, readwrite, assign) NSTimeInterval heartbeatIdleInterval;
+@property(nonatomic, readwrite, assign) int32_t heartbeatNetworkType;
+
 @end
 
 
@@ -131,6 +141,8 @@ static NSString *const kRemoteFromAddress = @"from";
     _unackedS2dIds = [NSMutableArray arrayWithArray:[_rmq2Manager unackedS2dRmqIds]];
     _ackedS2dMap = [NSMutableDictionary dictionary];
     _sendOnConnectMessages = [NSMutableArray array];
+    _heartbeatIntervals = [[FIRMessagingHeartbeatInterval alloc]
+        initWithUserDefaults:[GULUserDefaults standardUserDefaults]];
   }
   return self;
 }
@@ -239,9 +251,10 @@ static NSString *const kRemoteFromAddress = @"from";
 
   // If traffic is received after a heartbeat it is safe to assume the connection is healthy.
   [self cancelConnectionTimeoutTask];
+  self.lastReceiveTimestamp = FIRMessagingCurrentTimestampInMilliseconds();
   [self performSelector:@selector(sendHeartbeatPing)
              withObject:nil
-             afterDelay:kHeartbeatInterval];
+             afterDelay:[self heartbeatInterval]];
 
   [self willProcessProto:proto];
   switch (tag) {
@@ -269,6 +282,16 @@ static NSString *const kRemoteFromAddress = @"from";
   }
 }
 
+- (void)secureSocketWillReceiveDataBurst:(FIRMessagingSecureSocket *)socket {
+  // Saving a burst of received RMQ ids (and deleting the ones the server has confirmed) in one
+  // transaction syncs the store once instead of once per message.
+  [self.rmq2Manager beginBatchedWrites];
+}
+
+- (void)secureSocketDidReceiveDataBurst:(FIRMessagingSecureSocket *)socket {
+  [self.rmq2Manager endBatchedWrites];
+}
+
 // Called from secure socket once we have send the proto with given rmqId over the wire
 // since we are mostly concerned with user facing messages which certainly have a rmqId
 // we can retrieve them from the Rmq if necessary to look at stuff but for now we just
@@ -389,9 +412,16 @@ static NSString *const kRemoteFromAddress = @"from";
                                            selector:@selector(sendHeartbeatPing)
                                              object:nil];
   [self scheduleConnectionTimeoutTask];
+  self.heartbeatIdleInterval =
+      (FIRMessagingCurrentTimestampInMilliseconds() - self.lastReceiveTimestamp) / 1000.0;
+  self.heartbeatNetworkType = [[self class] currentNetworkType];
   [self sendProto:[[GtalkHeartbeatPing alloc] init]];
 }
 
+- (NSTimeInterval)heartbeatInterval {
+  return [self.heartbeatIntervals intervalForNetworkType:[[self class] currentNetworkType]];
+}
+
 + (GtalkIqStanza *)createStreamAck {
   GtalkIqStanza *iq = [[GtalkIqStanza alloc] init];
   iq.type = GtalkIqStanza_IqType_Set;
@@ -460,6 +490,12 @@ static NSString *const kRemoteFromAddress = @"from";
 }
 
 - (void)didReceiveHeartbeatAck:(GtalkHeartbeatAck *)heartbeatAck {
+  // The connection survived being idle for that long, so the next heartbeat may wait longer.
+  [self.heartbeatIntervals didReceiveAckAfterIdleInterval:self.heartbeatIdleInterval
+                                              networkType:self.heartbeatNetworkType];
+  FIRMessagingLoggerDebug(kFIRMessagingMessageCodeConnection024,
+                          @"Heartbeat acked after %.0f idle seconds, next one in %.0f seconds",
+                          self.heartbeatIdleInterval, [self heartbeatInterval]);
 }
 
 - (void)didReceiveDataMessageStanza:(GtalkDataMessageStanza *)dataMessageStanza {
@@ -675,6 +711,8 @@ static NSString *const kRemoteFromAddress = @"from";
 - (void)connectionTimedOut {
   FIRMessagingLoggerDebug(kFIRMessagingMessageCodeConnection022,
                           @"Connection to FIRMessaging service timed out.");
+  [self.heartbeatIntervals didTimeOutAfterIdleInterval:self.heartbeatIdleInterval
+                                           networkType:self.heartbeatNetworkType];
   [self disconnect];
   [self.delegate connection:self didCloseForReason:kFIRMessagingConnectionCloseReasonTimeout];
 }
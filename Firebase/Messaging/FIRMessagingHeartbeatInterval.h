@@ -0,0 +1,62 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class GULUserDefaults;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ *  Discovers how long an MCS connection can stay idle on each network type before a NAT or
+ *  firewall on the way drops it, so that heartbeats are sent no more often than needed.
+ *
+ *  Every network type starts at the minimum interval, which is always assumed to be safe. Each
+ *  heartbeat acked after a full idle interval proves that interval and doubles the next one, up
+ *  to the maximum. The first heartbeat that times out after an unproven interval settles the
+ *  network back on the last proven one. A timeout after a proven interval means the network now
+ *  drops connections sooner, so the interval is halved. Intervals are persisted across launches.
+ *
+ *  The network types are the ones sent in the login request: 1 for Wi-Fi, 0 for cellular and -1
+ *  if unknown. Nothing is learned for unknown networks, which always use the minimum interval.
+ */
+@interface FIRMessagingHeartbeatInterval : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithUserDefaults:(GULUserDefaults *)userDefaults NS_DESIGNATED_INITIALIZER;
+
+/**
+ *  The time to wait on an idle connection before sending a heartbeat ping on the given network.
+ */
+- (NSTimeInterval)intervalForNetworkType:(int32_t)networkType;
+
+/**
+ *  Records that a heartbeat ping, sent after the connection was idle for @c idleInterval, was
+ *  acked.
+ */
+- (void)didReceiveAckAfterIdleInterval:(NSTimeInterval)idleInterval
+                           networkType:(int32_t)networkType;
+
+/**
+ *  Records that a heartbeat ping, sent after the connection was idle for @c idleInterval, was
+ *  never acked.
+ */
+- (void)didTimeOutAfterIdleInterval:(NSTimeInterval)idleInterval
+                        networkType:(int32_t)networkType;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FIRMessagingHeartbeatInterval.h"
+
+#import <GoogleUtilities/GULUserDefaults.h>
+
+static NSTimeInterval const kMinHeartbeatInterval = 30.0;
+static NSTimeInterval const kMaxHeartbeatInterval = 8 * 60.0;  // 8 minutes
+
+// Timers may fire a little early, so an idle interval this close to the target still counts.
+static double const kIdleIntervalTolerance = 0.9;
+
+static NSString *const kHeartbeatIntervalsKey = @"com.firebase.messaging.heartbeat-intervals";
+static NSString *const kIntervalKey = @"interval";
+static NSString *const kProvenIntervalKey = @"proven";
+static NSString *const kSettledKey = @"settled";
+
+@interface FIRMessagingHeartbeatInterval ()
+
+@property(nonatomic, readonly, strong) GULUserDefaults *userDefaults;
+// Network type (as a string) -> {interval, proven interval, settled}.
+@property(nonatomic, readonly, strong) NSMutableDictionary<NSString *, NSDictionary *> *intervals;
+
+@end
+
+@implementation FIRMessagingHeartbeatInterval
+
+- (instancetype)initWithUserDefaults:(GULUserDefaults *)userDefaults {
+  self = [super init];
+  if (self) {
+    _userDefaults = userDefaults;
+    NSDictionary *persisted = [userDefaults dictionaryForKey:kHeartbeatIntervalsKey];
+    _intervals = persisted ? [persisted mutableCopy] : [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+
+- (NSTimeInterval)intervalForNetworkType:(int32_t)networkType {
+  if (networkType < 0) {
+    return kMinHeartbeatInterval;
+  }
+  return [[self entryForNetworkType:networkType][kIntervalKey] doubleValue];
+}
+
+- (void)didReceiveAckAfterIdleInterval:(NSTimeInterval)idleInterval
+                           networkType:(int32_t)networkType {
+  if (networkType < 0) {
+    return;
+  }
+  NSDictionary *entry = [self entryForNetworkType:networkType];
+  NSTimeInterval interval = [entry[kIntervalKey] doubleValue];
+  if ([entry[kSettledKey] boolValue] || idleInterval < interval * kIdleIntervalTolerance) {
+    // Either there is nothing left to probe, or the ping wasn't sent after a full idle interval
+    // (e.g. the ping right after login) and proves nothing.
+    return;
+  }
+  BOOL settled = interval >= kMaxHeartbeatInterval;
+  [self setInterval:MIN(interval * 2, kMaxHeartbeatInterval)
+      provenInterval:interval
+             settled:settled
+      forNetworkType:networkType];
+}
+
+- (void)didTimeOutAfterIdleInterval:(NSTimeInterval)idleInterval
+                        networkType:(int32_t)networkType {
+  if (networkType < 0 || idleInterval < kMinHeartbeatInterval * kIdleIntervalTolerance) {
+    // The connection went silent right after some traffic, which isn't caused by the idle time.
+    return;
+  }
+  NSDictionary *entry = [self entryForNetworkType:networkType];
+  NSTimeInterval proven = [entry[kProvenIntervalKey] doubleValue];
+  if (![entry[kSettledKey] boolValue] && idleInterval > proven) {
+    // The probe went past what the network allows; stay on the last interval that worked.
+    [self setInterval:proven provenInterval:proven settled:YES forNetworkType:networkType];
+  } else {
+    proven = MAX(kMinHeartbeatInterval, proven / 2);
+    [self setInterval:proven provenInterval:proven settled:YES forNetworkType:networkType];
+  }
+}
+
+#pragma mark - Private
+
+- (NSDictionary *)entryForNetworkType:(int32_t)networkType {
+  NSDictionary *entry = self.intervals[[self keyForNetworkType:networkType]];
+  if (!entry) {
+    entry = @{
+      kIntervalKey : @(kMinHeartbeatInterval),
+      kProvenIntervalKey : @(kMinHeartbeatInterval),
+      kSettledKey : @NO,
+    };
+  }
+  return entry;
+}
+
+- (void)setInterval:(NSTimeInterval)interval
+     provenInterval:(NSTimeInterval)provenInterval
+            settled:(BOOL)settled
+     forNetworkType:(int32_t)networkType {
+  self.intervals[[self keyForNetworkType:networkType]] = @{
+    kIntervalKey : @(interval),
+    kProvenIntervalKey : @(provenInterval),
+    kSettledKey : @(settled),
+  };
+  [self.userDefaults setObject:[self.intervals copy] forKey:kHeartbeatIntervalsKey];
+}
+
+- (NSString *)keyForNetworkType:(int32_t)networkType {
+  return [NSString stringWithFormat:@"%d", networkType];
+}
+
+@end
@@ -83,6 +83,19 @@ NS_ASSUME_NONNULL_BEGIN
  *  An app can subscribe and unsubscribe from many topics, and this class helps persist the pending
  *  topics and perform the operation safely and correctly.
  *
+ *  Adding an operation for a topic supersedes the operations for the same topic that haven't
+ *  started yet, since only the last action determines whether the topic ends up subscribed. For
+ *  example, subscribing to [A], unsubscribing from [B], subscribing to [C] and then subscribing to
+ *  [B] leaves a single batch, subscribe to [A, B, C]: unsubscribing from B is cancelled, which makes
+ *  the batches of A and C adjacent so they are merged. The pair can't simply cancel out, as B may
+ *  have been subscribed before. The completion handlers of a superseded operation are called with
+ *  a cancellation error, unless it had the same action as the one replacing it, in which case they
+ *  are called when that one completes. An operation with the same action as the latest pending
+ *  operation for its topic waits for that one.
+ *
+ *  At most `maxConcurrentTopicUpdates` topics of the current batch are requested at a time, which
+ *  leaves the others open to being superseded.
+ *
  *  When a topic fails to subscribe or unsubscribe due to a network error, it is considered a
  *  recoverable error, and so it remains in the current batch until it is succesfully completed.
  *  Topic updates are completed when they either (a) succeed, (b) are cancelled, or (c) result in an
@@ -107,6 +120,10 @@ NS_ASSUME_NONNULL_BEGIN
 @property(nonatomic, readonly, strong, nullable) NSDate *archiveDate;
 @property(nonatomic, readonly) NSUInteger numberOfBatches;
 
+/// The maximum number of topic updates requested from the delegate at a time. Defaults to 10, the
+/// number of topic operations FIRMessagingPubSubRegistrar runs concurrently.
+@property(nonatomic, assign) NSUInteger maxConcurrentTopicUpdates;
+
 
 - (instancetype)init NS_DESIGNATED_INITIALIZER;
 - (void)addOperationForTopic:(NSString *)topic
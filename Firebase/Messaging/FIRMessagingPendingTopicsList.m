@@ -21,6 +21,7 @@
 #import "FIRMessagingPubSub.h"
 
 #import "FIRMessagingDefines.h"
+#import "NSError+FIRMessaging.h"
 
 NSString *const kPendingTopicBatchActionKey = @"action";
 NSString *const kPendingTopicBatchTopicsKey = @"topics";
@@ -28,6 +29,8 @@ NSString *const kPendingTopicBatchTopicsKey = @"topics";
 NSString *const kPendingBatchesEncodingKey = @"batches";
 NSString *const kPendingTopicsTimestampEncodingKey = @"ts";
 
+static const NSUInteger kDefaultMaxConcurrentTopicUpdates = 10;
+
 #pragma mark - FIRMessagingTopicBatch
 
 @interface FIRMessagingTopicBatch ()
@@ -94,19 +97,83 @@ NSString *const kPendingTopicsTimestampEncodingKey = @"ts";
   if (self = [super init]) {
     _topicBatches = [NSMutableArray array];
     _topicsInFlight = [NSMutableSet set];
+    _maxConcurrentTopicUpdates = kDefaultMaxConcurrentTopicUpdates;
   }
   return self;
 }
 
 + (void)pruneTopicBatches:(NSMutableArray <FIRMessagingTopicBatch *> *)topicBatches {
-  // For now, just remove empty batches. In the future we can use this to make the subscriptions
-  // more efficient, by actually pruning topic actions that cancel each other out, for example.
+  // Remove empty batches, then merge the batches that end up next to a batch with the same action.
+  // Operations with the same action can run in any order, so merging them changes nothing but the
+  // number of batches to wait on.
   for (NSInteger i = topicBatches.count-1; i >= 0; i--) {
     FIRMessagingTopicBatch *batch = topicBatches[i];
     if (batch.topics.count == 0) {
       [topicBatches removeObjectAtIndex:i];
     }
   }
+  for (NSInteger i = topicBatches.count-1; i > 0; i--) {
+    FIRMessagingTopicBatch *previousBatch = topicBatches[i-1];
+    FIRMessagingTopicBatch *batch = topicBatches[i];
+    if (previousBatch.action != batch.action) {
+      continue;
+    }
+    [previousBatch.topics unionSet:batch.topics];
+    [batch.topicHandlers enumerateKeysAndObjectsUsingBlock:^(NSString *topic,
+                                                             NSMutableArray *handlers,
+                                                             BOOL *stop) {
+      NSMutableArray *previousHandlers = previousBatch.topicHandlers[topic];
+      if (previousHandlers) {
+        [previousHandlers addObjectsFromArray:handlers];
+      } else {
+        previousBatch.topicHandlers[topic] = handlers;
+      }
+    }];
+    [topicBatches removeObjectAtIndex:i];
+  }
+}
+
+/**
+ *  Removes the operations for a topic that haven't started yet, because a new operation for the
+ *  topic is about to be added. Must be called while synchronized on self.
+ *
+ *  @param topic            The topic of the new operation.
+ *  @param action           The action of the new operation.
+ *  @param carriedHandlers  Collects the handlers of removed operations with the same action, which
+ *                          complete along with the new operation.
+ *  @param cancelledHandlers Collects the handlers of removed operations with the other action.
+ *
+ *  @return YES if any operation was removed.
+ */
+- (BOOL)supersedeOperationsForTopic:(NSString *)topic
+                             action:(FIRMessagingTopicAction)action
+                    carriedHandlers:(NSMutableArray *)carriedHandlers
+                  cancelledHandlers:(NSMutableArray *)cancelledHandlers {
+  BOOL didSupersede = NO;
+  for (FIRMessagingTopicBatch *batch in self.topicBatches) {
+    if (![batch.topics member:topic]) {
+      continue;
+    }
+    if (batch == self.currentBatch && [self.topicsInFlight member:topic]) {
+      // Already requested, so it can't be taken back.
+      continue;
+    }
+    NSMutableArray *handlers = batch.topicHandlers[topic];
+    if (handlers.count) {
+      [(batch.action == action ? carriedHandlers : cancelledHandlers) addObjectsFromArray:handlers];
+    }
+    [batch.topics removeObject:topic];
+    [batch.topicHandlers removeObjectForKey:topic];
+    didSupersede = YES;
+  }
+  if (didSupersede) {
+    [FIRMessagingPendingTopicsList pruneTopicBatches:self.topicBatches];
+    if (self.currentBatch && ![self.topicBatches containsObject:self.currentBatch]) {
+      // The current batch was emptied, or merged into the batch before it.
+      self.currentBatch = nil;
+    }
+  }
+  return didSupersede;
 }
 
 #pragma mark NSCoding
@@ -143,33 +210,65 @@ NSString *const kPendingTopicsTimestampEncodingKey = @"ts";
                   completion:(nullable FIRMessagingTopicOperationCompletion)completion {
 
   FIRMessagingTopicBatch *lastBatch = nil;
+  NSMutableArray *handlersToAdd = [NSMutableArray array];
+  NSMutableArray *cancelledHandlers = [NSMutableArray array];
+  if (completion) {
+    [handlersToAdd addObject:completion];
+  }
   @synchronized (self) {
-    lastBatch = self.topicBatches.lastObject;
-    if (!lastBatch || lastBatch.action != action) {
-      // There either was no last batch, or our last batch's action was not the same, so we have to
-      // create a new batch
-      lastBatch = [[FIRMessagingTopicBatch alloc] initWithAction:action];
-      [self.topicBatches addObject:lastBatch];
+    // If the latest operation for this topic already has the same action, it has the same outcome
+    // as the new one, which just waits for it to complete
+    FIRMessagingTopicBatch *latestBatchForTopic = nil;
+    for (FIRMessagingTopicBatch *batch in self.topicBatches) {
+      if ([batch.topics member:topic]) {
+        latestBatchForTopic = batch;
+      }
     }
-    BOOL topicExistedBefore = ([lastBatch.topics member:topic] != nil);
-    if (!topicExistedBefore) {
+    BOOL topicExistedBefore = (latestBatchForTopic && latestBatchForTopic.action == action);
+    BOOL didSupersede = NO;
+    if (topicExistedBefore) {
+      lastBatch = latestBatchForTopic;
+    } else {
+      didSupersede = [self supersedeOperationsForTopic:topic
+                                                action:action
+                                       carriedHandlers:handlersToAdd
+                                     cancelledHandlers:cancelledHandlers];
+      lastBatch = self.topicBatches.lastObject;
+      if (!lastBatch || lastBatch.action != action) {
+        // There either was no last batch, or our last batch's action was not the same, so we have
+        // to create a new batch
+        lastBatch = [[FIRMessagingTopicBatch alloc] initWithAction:action];
+        [self.topicBatches addObject:lastBatch];
+      }
       [lastBatch.topics addObject:topic];
       [self.delegate pendingTopicsListDidUpdate:self];
     }
-    // Add the completion handler to the batch
-    if (completion) {
+    // Add the completion handlers to the batch
+    if (handlersToAdd.count) {
       NSMutableArray *handlers = lastBatch.topicHandlers[topic];
       if (!handlers) {
         handlers = [[NSMutableArray alloc] init];
       }
-      [handlers addObject:completion];
+      [handlers addObjectsFromArray:handlersToAdd];
       lastBatch.topicHandlers[topic] = handlers;
     }
-    if (!self.currentBatch) {
-      self.currentBatch = lastBatch;
+    if (cancelledHandlers.count) {
+      NSError *error =
+          [NSError errorWithFCMErrorCode:kFIRMessagingErrorCodePubSubOperationIsCancelled];
+      dispatch_async(dispatch_get_main_queue(), ^{
+        for (FIRMessagingTopicOperationCompletion handler in cancelledHandlers) {
+          handler(error);
+        }
+      });
     }
-    // This may have been the first topic added, or was added to an ongoing batch
-    if (self.currentBatch == lastBatch && !topicExistedBefore) {
+    BOOL hadCurrentBatch = (self.currentBatch != nil);
+    if (!hadCurrentBatch) {
+      self.currentBatch = self.topicBatches.firstObject;
+    }
+    // This may have been the first topic added, or was added to an ongoing batch, or superseding
+    // the topic's pending operations may have merged more topics into the current batch
+    if ((self.currentBatch == lastBatch && !topicExistedBefore) || didSupersede ||
+        !hadCurrentBatch) {
       // Add this topic to our ongoing operations
       FIRMessaging_WEAKIFY(self);
       dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
@@ -198,6 +297,10 @@ NSString *const kPendingTopicsTimestampEncodingKey = @"ts";
       return;
     }
     for (NSString *topic in self.currentBatch.topics) {
+      if (self.topicsInFlight.count >= self.maxConcurrentTopicUpdates) {
+        // The remaining topics are requested as the ones in flight complete
+        break;
+      }
       if ([self.topicsInFlight member:topic]) {
         // This topic is already active, so skip
         continue;
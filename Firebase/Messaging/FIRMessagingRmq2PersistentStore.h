@@ -77,6 +77,20 @@ extern NSString *const kTableS2DRmqIds;
  */
 - (BOOL)updateLastOutgoingRmqId:(int64_t)rmqID;
 
+#pragma mark - Batched Writes
+
+/**
+ *  Start a batch of writes. All the writes until the matching `endBatchedWrites` are committed
+ *  to disk in a single transaction. Batches can be nested, in which case the outermost batch
+ *  commits.
+ */
+- (void)beginBatchedWrites;
+
+/**
+ *  End the batch of writes started by the matching `beginBatchedWrites`.
+ */
+- (void)endBatchedWrites;
+
 #pragma mark - Query
 
 /**
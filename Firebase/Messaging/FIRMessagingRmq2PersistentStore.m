@@ -80,9 +80,27 @@ static NSString *const kCreateTableSyncMessages =
     @"apns_recv INTEGER, "
     @"mcs_recv INTEGER)";
 
+// Sync messages are looked up by rmq_id on every received message, and purged by expiration_ts.
+static NSString *const kCreateIndexesSyncMessages =
+    @"create INDEX IF NOT EXISTS %1$@%2$@_rmq_id ON %1$@%2$@ (rmq_id); "
+    @"create INDEX IF NOT EXISTS %1$@%2$@_expiration_ts ON %1$@%2$@ (expiration_ts)";
+
+// The most sync messages deleted in one transaction when purging expired messages, so that the
+// database isn't locked for long when a large backlog is purged.
+static const int kMaxExpiredSyncMessagesDeletedPerBatch = 500;
+
 static NSString *const kDropTableCommand =
     @"drop TABLE if exists %@%@";
 
+// With a write-ahead log a commit appends to the log instead of rewriting and syncing the database
+// file, and with synchronous=NORMAL the log is only synced at checkpoints.
+static NSString *const kEnableWriteAheadLogCommand =
+    @"PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL";
+
+// The files sqlite keeps next to the database while it is in WAL mode.
+static NSString *const kWriteAheadLogSuffix = @"-wal";
+static NSString *const kSharedMemorySuffix = @"-shm";
+
 // table infos
 static NSString *const kRmqIdColumn = @"rmq_id";
 static NSString *const kDataColumn = @"data";
@@ -113,6 +131,11 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
 
 @interface FIRMessagingRmq2PersistentStore () {
   sqlite3 *_database;
+  // Statements prepared once and reused for the inserts done for every message.
+  sqlite3_stmt *_insertOutgoingMessageStatement;
+  sqlite3_stmt *_insertS2dRmqIdStatement;
+  // Number of nested batches of writes, the outermost one owns the transaction.
+  NSUInteger _batchedWritesDepth;
 }
 
 @property(nonatomic, readwrite, strong) NSString *databaseName;
@@ -143,6 +166,8 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
 }
 
 - (void)dealloc {
+  sqlite3_finalize(_insertOutgoingMessageStatement);
+  sqlite3_finalize(_insertS2dRmqIdStatement);
   sqlite3_close(_database);
 }
 
@@ -260,7 +285,7 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
 - (void)removeDatabase {
   NSString *path = [[self class] pathForDatabase:self.databaseName
                                      inDirectory:self.currentDirectory];
-  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+  [[self class] removeDatabaseAtPath:path];
 }
 
 + (void)removeDatabase:(NSString *)dbName {
@@ -268,8 +293,16 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
                                          inDirectory:FIRMessagingRmqDirectoryDocuments];
   NSString *standardDirPath =
       [self pathForDatabase:dbName inDirectory:FIRMessagingRmqDirectoryApplicationSupport];
-  [[NSFileManager defaultManager] removeItemAtPath:documentsDirPath error:nil];
-  [[NSFileManager defaultManager] removeItemAtPath:standardDirPath error:nil];
+  [self removeDatabaseAtPath:documentsDirPath];
+  [self removeDatabaseAtPath:standardDirPath];
+}
+
++ (void)removeDatabaseAtPath:(NSString *)path {
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  [fileManager removeItemAtPath:path error:nil];
+  // A log left behind would be replayed into a new database created at the same path.
+  [fileManager removeItemAtPath:[path stringByAppendingString:kWriteAheadLogSuffix] error:nil];
+  [fileManager removeItemAtPath:[path stringByAppendingString:kSharedMemorySuffix] error:nil];
 }
 
 - (void)openDatabase:(NSString *)dbName {
@@ -317,7 +350,33 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
   }
 
   if (didOpenDatabase) {
+    [self enableWriteAheadLog];
     [self createTableWithName:kTableSyncMessages command:kCreateTableSyncMessages];
+    [self createSyncMessagesIndexes];
+  }
+}
+
+- (void)createSyncMessagesIndexes {
+  char *error;
+  NSString *createIndexes =
+      [NSString stringWithFormat:kCreateIndexesSyncMessages, kTablePrefix, kTableSyncMessages];
+  if (sqlite3_exec(_database, [createIndexes UTF8String], NULL, NULL, &error) != SQLITE_OK) {
+    // Lookups still work without the indexes, they just scan the table.
+    FIRMessagingLoggerError(kFIRMessagingMessageCodeRmq2PersistentStore008,
+                            @"%@ Failed to create the sync message indexes: %s", kFCMRmqStoreTag,
+                            error);
+    sqlite3_free(error);
+  }
+}
+
+- (void)enableWriteAheadLog {
+  char *error;
+  if (sqlite3_exec(_database, [kEnableWriteAheadLogCommand UTF8String], NULL, NULL, &error) !=
+      SQLITE_OK) {
+    // Still usable with the default rollback journal, every commit just costs more.
+    FIRMessagingLoggerError(kFIRMessagingMessageCodeRmq2PersistentStore007,
+                            @"%@ Failed to enable the write-ahead log: %s", kFCMRmqStoreTag, error);
+    sqlite3_free(error);
   }
 }
 
@@ -326,29 +385,58 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
   [self dropTableWithName:kOldTableS2DRmqIds];
 }
 
+#pragma mark - Batched Writes
+
+- (void)beginBatchedWrites {
+  if (_batchedWritesDepth++ > 0) {
+    return;
+  }
+  if (sqlite3_exec(_database, "BEGIN TRANSACTION", NULL, NULL, NULL) != SQLITE_OK) {
+    // The writes still happen, each in its own implicit transaction.
+    [self logError];
+  }
+}
+
+- (void)endBatchedWrites {
+  _FIRMessagingDevAssert(_batchedWritesDepth > 0, @"%@ Unbalanced end of batched writes",
+                         kFCMRmqStoreTag);
+  if (_batchedWritesDepth == 0 || --_batchedWritesDepth > 0) {
+    return;
+  }
+  if (sqlite3_get_autocommit(_database)) {
+    // BEGIN failed, or sqlite rolled the transaction back after an error.
+    return;
+  }
+  if (sqlite3_exec(_database, "COMMIT TRANSACTION", NULL, NULL, NULL) != SQLITE_OK) {
+    [self logError];
+    sqlite3_exec(_database, "ROLLBACK TRANSACTION", NULL, NULL, NULL);
+  }
+}
+
 #pragma mark - Insert
 
 - (BOOL)saveUnackedS2dMessageWithRmqId:(NSString *)rmqId {
-  NSString *insertFormat = @"INSERT INTO %@ (%@) VALUES (?)";
-  NSString *insertSQL = [NSString stringWithFormat:insertFormat,
-                         kTableS2DRmqIds,
-                         kRmqIdColumn];
-  sqlite3_stmt *insert_statement;
-  if (sqlite3_prepare_v2(_database, [insertSQL UTF8String], -1, &insert_statement, NULL)
-      != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+  if (!_insertS2dRmqIdStatement) {
+    NSString *insertFormat = @"INSERT INTO %@ (%@) VALUES (?)";
+    NSString *insertSQL = [NSString stringWithFormat:insertFormat,
+                           kTableS2DRmqIds,
+                           kRmqIdColumn];
+    if (![self prepareStatement:&_insertS2dRmqIdStatement withSQL:insertSQL]) {
+      return NO;
+    }
   }
+  sqlite3_stmt *insert_statement = _insertS2dRmqIdStatement;
   if (sqlite3_bind_text(insert_statement,
                         1,
                         [rmqId UTF8String],
                         (int)[rmqId length],
                         SQLITE_STATIC) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+    return [self logErrorAndResetStatement:insert_statement];
   }
   if (sqlite3_step(insert_statement) != SQLITE_DONE) {
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+    return [self logErrorAndResetStatement:insert_statement];
   }
-  sqlite3_finalize(insert_statement);
+  [self resetStatement:insert_statement];
   return YES;
 }
 
@@ -356,34 +444,35 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
                          tag:(int8_t)tag
                         data:(NSData *)data
                        error:(NSError **)error {
-  NSString *insertFormat = @"INSERT INTO %@ (%@, %@, %@) VALUES (?, ?, ?)";
-  NSString *insertSQL = [NSString stringWithFormat:insertFormat,
-                         kTableOutgoingRmqMessages, // table
-                         kRmqIdColumn, kProtobufTagColumn, kDataColumn /* columns */];
-  sqlite3_stmt *insert_statement;
-  if (sqlite3_prepare_v2(_database, [insertSQL UTF8String], -1, &insert_statement, NULL)
-      != SQLITE_OK) {
-    if (error) {
-      *error = [NSError errorWithDomain:[NSString stringWithFormat:@"%s", sqlite3_errmsg(_database)]
-                                   code:sqlite3_errcode(_database)
-                               userInfo:nil];
+  if (!_insertOutgoingMessageStatement) {
+    NSString *insertFormat = @"INSERT INTO %@ (%@, %@, %@) VALUES (?, ?, ?)";
+    NSString *insertSQL = [NSString stringWithFormat:insertFormat,
+                           kTableOutgoingRmqMessages, // table
+                           kRmqIdColumn, kProtobufTagColumn, kDataColumn /* columns */];
+    if (![self prepareStatement:&_insertOutgoingMessageStatement withSQL:insertSQL]) {
+      if (error) {
+        *error = [NSError errorWithDomain:[self lastErrorMessage]
+                                     code:[self lastErrorCode]
+                                 userInfo:nil];
+      }
+      return NO;
     }
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
   }
+  sqlite3_stmt *insert_statement = _insertOutgoingMessageStatement;
   if (sqlite3_bind_int64(insert_statement, 1, rmqId) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+    return [self logErrorAndResetStatement:insert_statement];
   }
   if (sqlite3_bind_int(insert_statement, 2, tag) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+    return [self logErrorAndResetStatement:insert_statement];
   }
   if (sqlite3_bind_blob(insert_statement, 3, [data bytes], (int)[data length], NULL) != SQLITE_OK) {
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+    return [self logErrorAndResetStatement:insert_statement];
   }
   if (sqlite3_step(insert_statement) != SQLITE_DONE) {
-    _FIRMessagingRmqLogAndExit(insert_statement, NO);
+    return [self logErrorAndResetStatement:insert_statement];
   }
 
-  sqlite3_finalize(insert_statement);
+  [self resetStatement:insert_statement];
   return YES;
 }
 
@@ -413,6 +502,9 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
   int maxBatchSize = 100;
   int start = 0;
   int deleteCount = 0;
+  BOOL didFail = NO;
+  // All the chunks are deleted in a single transaction, so that they are synced to disk once.
+  [self beginBatchedWrites];
   while (start < toDelete) {
 
     // construct the WHERE argument
@@ -431,7 +523,9 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
     sqlite3_stmt *delete_statement;
     if (sqlite3_prepare_v2(_database, [deleteQuery UTF8String],
                            -1, &delete_statement, NULL) != SQLITE_OK) {
-      _FIRMessagingRmqLogAndExit(delete_statement, 0);
+      [self logErrorAndFinalizeStatement:delete_statement];
+      didFail = YES;
+      break;
     }
 
     // bind values
@@ -463,12 +557,18 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
       rmqIndex++;
     }
     if (sqlite3_step(delete_statement) != SQLITE_DONE) {
-      _FIRMessagingRmqLogAndExit(delete_statement, deleteCount);
+      [self logErrorAndFinalizeStatement:delete_statement];
+      didFail = YES;
+      break;
     }
     sqlite3_finalize(delete_statement);
     deleteCount += sqlite3_changes(_database);
     start = end;
   }
+  [self endBatchedWrites];
+  if (didFail) {
+    return deleteCount;
+  }
 
   // if we are here all of our sqlite queries should have succeeded
   FIRMessagingLoggerDebug(kFIRMessagingMessageCodeRmq2PersistentStore004,
@@ -600,12 +700,11 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
 - (FIRMessagingPersistentSyncMessage *)querySyncMessageWithRmqID:(NSString *)rmqID {
   _FIRMessagingDevAssert([rmqID length], @"Invalid rmqID key %@ to search in SYNC_RMQ", rmqID);
 
-  NSString *queryFormat = @"SELECT %@ FROM %@ WHERE %@ = '%@'";
+  NSString *queryFormat = @"SELECT %@ FROM %@ WHERE %@ = ?";
   NSString *query = [NSString stringWithFormat:queryFormat,
                      kSyncMessagesColumns, // SELECT (rmq_id, expiration_ts, apns_recv, mcs_recv)
                      kTableSyncMessages,   // FROM sync_rmq
-                     kRmqIdColumn,         // WHERE rmq_id
-                     rmqID];
+                     kRmqIdColumn];        // WHERE rmq_id
 
   sqlite3_stmt *stmt;
   if (sqlite3_prepare_v2(_database, [query UTF8String], -1, &stmt, NULL) != SQLITE_OK) {
@@ -613,6 +712,9 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
     sqlite3_finalize(stmt);
     return nil;
   }
+  if (sqlite3_bind_text(stmt, 1, [rmqID UTF8String], -1, SQLITE_TRANSIENT) != SQLITE_OK) {
+    _FIRMessagingRmqLogAndExit(stmt, nil);
+  }
 
   const int rmqIDColumn = 0;
   const int expirationTimestampColumn = 1;
@@ -650,15 +752,21 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
 
 - (int)deleteExpiredOrFinishedSyncMessages:(NSError *__autoreleasing *)error {
   int64_t now = FIRMessagingCurrentTimestampInSeconds();
-  NSString *deleteSQL = @"DELETE FROM %@ "
+  NSString *deleteSQL = @"DELETE FROM %@ WHERE %@ IN "
+                        @"(SELECT %@ FROM %@ "
                         @"WHERE %@ < %lld OR "  // expirationTime < now
-                        @"(%@ = 1 AND %@ = 1)";  // apns_received = 1 AND mcs_received = 1
+                        @"(%@ = 1 AND %@ = 1) "  // apns_received = 1 AND mcs_received = 1
+                        @"LIMIT %d)";
   NSString *query = [NSString stringWithFormat:deleteSQL,
+                     kTableSyncMessages,
+                     kIdColumn,
+                     kIdColumn,
                      kTableSyncMessages,
                      kSyncMessageExpirationTimestampColumn,
                      now,
                      kSyncMessageAPNSReceivedColumn,
-                     kSyncMessageMCSReceivedColumn];
+                     kSyncMessageMCSReceivedColumn,
+                     kMaxExpiredSyncMessagesDeletedPerBatch];
 
   NSString *errorReason = @"Failed to save delete expired sync messages from store.";
 
@@ -671,16 +779,26 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
     _FIRMessagingRmqLogAndExit(stmt, 0);
   }
 
-  if (sqlite3_step(stmt) != SQLITE_DONE) {
-    if (error) {
-      *error = [NSError fcm_errorWithCode:sqlite3_errcode(_database)
-                                 userInfo:@{ @"error" : errorReason }];
+  // Delete in batches until a batch comes up short, each batch in its own transaction.
+  int deleteCount = 0;
+  int batchDeleteCount = 0;
+  do {
+    [self beginBatchedWrites];
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+      [self endBatchedWrites];
+      if (error) {
+        *error = [NSError fcm_errorWithCode:sqlite3_errcode(_database)
+                                   userInfo:@{ @"error" : errorReason }];
+      }
+      _FIRMessagingRmqLogAndExit(stmt, deleteCount);
     }
-    _FIRMessagingRmqLogAndExit(stmt, 0);
-  }
+    batchDeleteCount = sqlite3_changes(_database);
+    [self endBatchedWrites];
+    deleteCount += batchDeleteCount;
+    sqlite3_reset(stmt);
+  } while (batchDeleteCount == kMaxExpiredSyncMessagesDeletedPerBatch);
 
   sqlite3_finalize(stmt);
-  int deleteCount = sqlite3_changes(_database);
   return deleteCount;
 }
 
@@ -808,4 +926,26 @@ NSString * _Nonnull FIRMessagingStringFromSQLiteResult(int result) {
   sqlite3_finalize(stmt);
 }
 
+- (BOOL)prepareStatement:(sqlite3_stmt **)stmt withSQL:(NSString *)sql {
+  if (sqlite3_prepare_v2(_database, [sql UTF8String], -1, stmt, NULL) != SQLITE_OK) {
+    [self logErrorAndFinalizeStatement:*stmt];
+    *stmt = NULL;
+    return NO;
+  }
+  return YES;
+}
+
+// Readies a reused statement for its next use. The bindings are cleared right away since they may
+// point to bytes that don't outlive the call.
+- (void)resetStatement:(sqlite3_stmt *)stmt {
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+}
+
+- (BOOL)logErrorAndResetStatement:(sqlite3_stmt *)stmt {
+  [self logError];
+  [self resetStatement:stmt];
+  return NO;
+}
+
 @end
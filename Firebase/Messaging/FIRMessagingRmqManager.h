@@ -83,6 +83,17 @@ typedef void(^FIRMessagingDataMessageHandler)(int64_t rmqId, GtalkDataMessageSta
  */
 - (BOOL)saveS2dMessageWithRmqId:(NSString *)rmqID;
 
+/**
+ *  Commit every write to RMQ until the matching `endBatchedWrites` in a single transaction,
+ *  instead of a transaction per message. Batches can be nested.
+ */
+- (void)beginBatchedWrites;
+
+/**
+ *  End the batch of writes started by the matching `beginBatchedWrites`.
+ */
+- (void)endBatchedWrites;
+
 /**
  *  A list of all unacked Server to device RMQ IDs.
  *
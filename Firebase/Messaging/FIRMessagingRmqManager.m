@@ -134,6 +134,14 @@ static NSString *const kFCMRmqTag = @"FIRMessagingRmq:";
   return [self.rmq2Store saveUnackedS2dMessageWithRmqId:rmqID];
 }
 
+- (void)beginBatchedWrites {
+  [self.rmq2Store beginBatchedWrites];
+}
+
+- (void)endBatchedWrites {
+  [self.rmq2Store endBatchedWrites];
+}
+
 #pragma mark - Query
 
 - (int64_t)queryHighestRmqId {
@@ -203,10 +211,14 @@ static NSString *const kFCMRmqTag = @"FIRMessagingRmq:";
     }
   }
   maxRmqId++;
+  [self beginBatchedWrites];
   if (maxRmqId >= self.rmqId) {
     [self saveLastOutgoingRmqId:maxRmqId];
   }
-  return [self.rmq2Store deleteMessagesFromTable:kTableOutgoingRmqMessages withRmqIds:rmqIds];
+  int deleteCount =
+      [self.rmq2Store deleteMessagesFromTable:kTableOutgoingRmqMessages withRmqIds:rmqIds];
+  [self endBatchedWrites];
+  return deleteCount;
 }
 
 - (void)removeS2dIds:(NSArray *)s2dIds {
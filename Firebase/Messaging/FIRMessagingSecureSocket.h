@@ -29,6 +29,8 @@ typedef NS_ENUM(NSUInteger, FIRMessagingSecureSocketState){
 
 @protocol FIRMessagingSecureSocketDelegate<NSObject>
 
+// |data| points into the input buffer of the socket and is only valid until this method returns.
+// Copy it to keep it around.
 - (void)secureSocket:(FIRMessagingSecureSocket *)socket
       didReceiveData:(NSData *)data
              withTag:(int8_t)tag;
@@ -38,6 +40,12 @@ typedef NS_ENUM(NSUInteger, FIRMessagingSecureSocketState){
 - (void)secureSocketDidConnect:(FIRMessagingSecureSocket *)socket;
 - (void)didDisconnectWithSecureSocket:(FIRMessagingSecureSocket *)socket;
 
+@optional
+// Bracket the |secureSocket:didReceiveData:withTag:| calls for all the frames that arrived in a
+// single read from the stream, so that a burst of messages can be handled as one.
+- (void)secureSocketWillReceiveDataBurst:(FIRMessagingSecureSocket *)socket;
+- (void)secureSocketDidReceiveDataBurst:(FIRMessagingSecureSocket *)socket;
+
 @end
 
 /**
@@ -309,8 +309,57 @@ static NSUInteger SerializedSize(int32_t value) {
     // did successfully read some more data
     self.inputBufferLength += (NSUInteger)bytesRead;
 
+    // Parse the frames in place. Each one is handed to the delegate without copying it out of the
+    // input buffer, and the buffer is only shifted once all the complete frames are processed.
+    NSUInteger processedLength = 0;
+    id<FIRMessagingSecureSocketDelegate> delegate = self.delegate;
+    BOOL notifiesBursts = [delegate respondsToSelector:@selector(secureSocketWillReceiveDataBurst:)]
+        && [delegate respondsToSelector:@selector(secureSocketDidReceiveDataBurst:)];
+    if (notifiesBursts) {
+      [delegate secureSocketWillReceiveDataBurst:self];
+    }
+    FIRMessagingSecureSocketReadResult readResult = kFIRMessagingSecureSocketReadResultNone;
+    while (processedLength < self.inputBufferLength) {
+      _FIRMessagingDevAssert([self.inputBuffer length] >= self.inputBufferLength,
+                             @"Buffer longer than length");
+      uint8_t *unprocessedBytes = (uint8_t *)self.inputBuffer.mutableBytes + processedLength;
+      NSData *unprocessedData =
+          [NSData dataWithBytesNoCopy:unprocessedBytes
+                               length:self.inputBufferLength - processedLength
+                         freeWhenDone:NO];
+      size_t protoBytes = 0;
+      // read the actual proto data coming in
+      readResult = [self processCurrentInputBuffer:unprocessedData outOffset:&protoBytes];
+      // Stop at corrupt data, or at incomplete data to load more from the stream.
+      if (readResult == kFIRMessagingSecureSocketReadResultCorrupt ||
+          readResult == kFIRMessagingSecureSocketReadResultIncomplete) {
+        break;
+      }
+      _FIRMessagingDevAssert(self.inputBufferLength - processedLength >= protoBytes,
+                             @"More bytes than buffer can handle");
+      processedLength += protoBytes;
+    }
+    if (notifiesBursts) {
+      [delegate secureSocketDidReceiveDataBurst:self];
+    }
+    // Corrupt data encountered, stop processing.
+    if (readResult == kFIRMessagingSecureSocketReadResultCorrupt) {
+      return NO;
+    }
+
+    // we have read (0, processedLength) of data in the inputBuffer
+    if (processedLength == self.inputBufferLength) {
+      // did completely read the buffer data can be reset for further processing
+      self.inputBufferLength = 0;
+    } else if (processedLength > 0) {
+      // move the incomplete frame to the front of the buffer, keeping the buffer size.
+      uint8_t *bufferBytes = (uint8_t *)self.inputBuffer.mutableBytes;
+      memmove(bufferBytes, bufferBytes + processedLength, self.inputBufferLength - processedLength);
+      self.inputBufferLength -= processedLength;
+    }
+
     if ([self.inputBuffer length] <= self.inputBufferLength) {
-      // shouldn't be reading more than 1MB of data in one go
+      // the incomplete frame fills the buffer. shouldn't be reading more than 1MB of data in one go
       if ([self.inputBuffer length] + kBufferLengthIncrement > kMaxBufferLength) {
         FIRMessagingLoggerDebug(kFIRMessagingMessageCodeSecureSocket013,
                                 @"Input buffer exceed 1M, disconnect socket");
@@ -325,44 +374,6 @@ static NSUInteger SerializedSize(int32_t value) {
       [self.inputBuffer increaseLengthBy:kBufferLengthIncrement];
       _FIRMessagingDevAssert([self.inputBuffer length] > self.inputBufferLength, @"Invalid buffer size");
     }
-
-    while (self.inputBufferLength > 0 && [self.inputBuffer length] > 0) {
-      _FIRMessagingDevAssert([self.inputBuffer length] >= self.inputBufferLength,
-                             @"Buffer longer than length");
-      NSRange inputRange = NSMakeRange(0, self.inputBufferLength);
-      size_t protoBytes = 0;
-      // read the actual proto data coming in
-      FIRMessagingSecureSocketReadResult readResult =
-          [self processCurrentInputBuffer:[self.inputBuffer subdataWithRange:inputRange]
-                                outOffset:&protoBytes];
-      // Corrupt data encountered, stop processing.
-      if (readResult == kFIRMessagingSecureSocketReadResultCorrupt) {
-        return NO;
-        // Incomplete data, keep trying to read by loading more from the stream.
-      } else if (readResult == kFIRMessagingSecureSocketReadResultIncomplete) {
-        break;
-      }
-      _FIRMessagingDevAssert(self.inputBufferLength >= protoBytes, @"More bytes than buffer can handle");
-      // we have read (0, protoBytes) of data in the inputBuffer
-      if (protoBytes == self.inputBufferLength) {
-        // did completely read the buffer data can be reset for further processing
-        self.inputBufferLength = 0;
-      } else {
-        // delete processed bytes while maintaining the buffer size.
-        NSUInteger prevLength __unused = [self.inputBuffer length];
-        // delete the processed bytes
-        [self.inputBuffer replaceBytesInRange:NSMakeRange(0, protoBytes) withBytes:NULL length:0];
-        // reallocate more data
-        [self.inputBuffer increaseLengthBy:protoBytes];
-        _FIRMessagingDevAssert([self.inputBuffer length] == prevLength,
-                               @"Invalid input buffer size %lu. Used bytes length %lu, "
-                               @"buffer content: %@",
-                               _FIRMessaging_UL([self.inputBuffer length]),
-                               _FIRMessaging_UL(self.inputBufferLength),
-                               self.inputBuffer);
-        self.inputBufferLength -= protoBytes;
-      }
-    }
   }
   return YES;
 }
@@ -386,7 +397,7 @@ static NSUInteger SerializedSize(int32_t value) {
     FIRMessagingLoggerDebug(kFIRMessagingMessageCodeSecureSocket015, @"Buffer data corrupted.");
     return kFIRMessagingSecureSocketReadResultCorrupt;
   }
-  NSData *data = [input readDataWithLength:(uint32_t)length];
+  NSData *data = [input readDataNoCopyWithLength:(uint32_t)length];
   if (data == nil) {
     FIRMessagingLoggerDebug(kFIRMessagingMessageCodeSecureSocket016,
                             @"Incomplete data, buffered data length %ld, expected length %d",
@@ -34,7 +34,7 @@
 
 /**
  *  Remove expired sync message from persistent store. Also removes messages that have
- *  been received both via APNS and MCS.
+ *  been received both via APNS and MCS. This is also done every 100 new sync messages.
  */
 - (void)removeExpiredSyncMessages;
 
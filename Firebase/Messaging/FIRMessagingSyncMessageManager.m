@@ -26,10 +26,21 @@
 static const int64_t kDefaultSyncMessageTTL = 4 * 7 * 24 * 60 * 60;  // 4 weeks
 // 4 MB of free space is required to persist Sync messages
 static const uint64_t kMinFreeDiskSpaceInMB = 1;
+// Number of recently received sync messages kept in memory. A message usually arrives via the
+// other channel shortly after the first one, so this catches most duplicates without a query.
+static const NSUInteger kMaxCachedSyncMessages = 100;
+// Number of sync messages saved between two purges of the expired or finished ones.
+static const NSUInteger kSyncMessagesSavedBetweenPurges = 100;
 
 @interface FIRMessagingSyncMessageManager()
 
 @property(nonatomic, readwrite, strong) FIRMessagingRmqManager *rmqManager;
+// Recently received sync messages by rmqID, mirroring their state in the store.
+@property(nonatomic, readwrite, strong)
+    NSMutableDictionary<NSString *, FIRMessagingPersistentSyncMessage *> *cachedSyncMessages;
+// The rmqIDs of the cached sync messages, least recently used first.
+@property(nonatomic, readwrite, strong) NSMutableOrderedSet<NSString *> *cachedSyncMessageIDs;
+@property(nonatomic, readwrite, assign) NSUInteger syncMessagesSavedSincePurge;
 
 @end
 
@@ -44,11 +55,18 @@ static const uint64_t kMinFreeDiskSpaceInMB = 1;
   self = [super init];
   if (self) {
     _rmqManager = rmqManager;
+    _cachedSyncMessages = [NSMutableDictionary dictionary];
+    _cachedSyncMessageIDs = [NSMutableOrderedSet orderedSet];
   }
   return self;
 }
 
 - (void)removeExpiredSyncMessages {
+  self.syncMessagesSavedSincePurge = 0;
+  // The purged messages may be cached, start over.
+  [self.cachedSyncMessages removeAllObjects];
+  [self.cachedSyncMessageIDs removeAllObjects];
+
   NSError *error;
   int deleteCount = [self.rmqManager deleteExpiredOrFinishedSyncMessages:&error];
   if (error) {
@@ -79,8 +97,13 @@ static const uint64_t kMinFreeDiskSpaceInMB = 1;
     return NO;
   }
 
-  FIRMessagingPersistentSyncMessage *persistentMessage =
-      [self.rmqManager querySyncMessageWithRmqID:rmqID];
+  FIRMessagingPersistentSyncMessage *persistentMessage = [self cachedSyncMessageWithRmqID:rmqID];
+  if (!persistentMessage) {
+    persistentMessage = [self.rmqManager querySyncMessageWithRmqID:rmqID];
+    if (persistentMessage) {
+      [self cacheSyncMessage:persistentMessage];
+    }
+  }
 
   NSError *error;
   if (!persistentMessage) {
@@ -102,6 +125,16 @@ static const uint64_t kMinFreeDiskSpaceInMB = 1;
     } else {
       FIRMessagingLoggerInfo(kFIRMessagingMessageCodeSyncMessageManager004,
                              @"Added sync message to cache: %@", rmqID);
+      FIRMessagingPersistentSyncMessage *savedMessage =
+          [[FIRMessagingPersistentSyncMessage alloc] initWithRMQID:rmqID
+                                                     expirationTime:expirationTime];
+      savedMessage.apnsReceived = viaAPNS;
+      savedMessage.mcsReceived = viaMCS;
+      [self cacheSyncMessage:savedMessage];
+      // Purge as messages come in, rather than only once per launch.
+      if (++self.syncMessagesSavedSincePurge >= kSyncMessagesSavedBetweenPurges) {
+        [self removeExpiredSyncMessages];
+      }
     }
     return NO;
   }
@@ -122,6 +155,8 @@ static const uint64_t kMinFreeDiskSpaceInMB = 1;
 
   // Received message via both ways we can safely delete it.
   if (persistentMessage.apnsReceived && persistentMessage.mcsReceived) {
+    [self.cachedSyncMessages removeObjectForKey:rmqID];
+    [self.cachedSyncMessageIDs removeObject:rmqID];
     if (![self.rmqManager deleteSyncMessageWithRmqID:rmqID]) {
       FIRMessagingLoggerError(kFIRMessagingMessageCodeSyncMessageManager007,
                               @"Failed to delete sync message %@", rmqID);
@@ -135,6 +170,28 @@ static const uint64_t kMinFreeDiskSpaceInMB = 1;
   return YES;
 }
 
+#pragma mark - Cache
+
+- (FIRMessagingPersistentSyncMessage *)cachedSyncMessageWithRmqID:(NSString *)rmqID {
+  FIRMessagingPersistentSyncMessage *message = self.cachedSyncMessages[rmqID];
+  if (message) {
+    // Mark as most recently used.
+    [self.cachedSyncMessageIDs removeObject:rmqID];
+    [self.cachedSyncMessageIDs addObject:rmqID];
+  }
+  return message;
+}
+
+- (void)cacheSyncMessage:(FIRMessagingPersistentSyncMessage *)message {
+  if (self.cachedSyncMessageIDs.count >= kMaxCachedSyncMessages) {
+    NSString *leastRecentlyUsedID = self.cachedSyncMessageIDs.firstObject;
+    [self.cachedSyncMessageIDs removeObjectAtIndex:0];
+    [self.cachedSyncMessages removeObjectForKey:leastRecentlyUsedID];
+  }
+  self.cachedSyncMessages[message.rmqID] = message;
+  [self.cachedSyncMessageIDs addObject:message.rmqID];
+}
+
 + (int64_t)expirationTimeForSyncMessage:(NSDictionary *)message {
   int64_t ttl = kDefaultSyncMessageTTL;
   if (message[kFIRMessagingMessageSyncMessageTTLKey]) {
@@ -16,8 +16,10 @@
 
 #import "FIRStorageComponent.h"
 #import "FIRStorageConstants_Private.h"
+#import "FIRStorageDownloadCache.h"
 #import "FIRStoragePath.h"
 #import "FIRStorageReference_Private.h"
+#import "FIRStorageTaskScheduler.h"
 #import "FIRStorageTokenAuthorizer.h"
 #import "FIRStorageUtils.h"
 #import "FIRStorage_Private.h"
@@ -36,9 +38,13 @@ static NSMutableDictionary<
     NSMutableDictionary<NSString * /* bucket */, GTMSessionFetcherService *> *> *_fetcherServiceMap;
 static GTMSessionFetcherRetryBlock _retryWhenOffline;
 
+static const NSInteger kFIRStorageDefaultMaxConcurrentTransfers = 4;
+
 @interface FIRStorage () {
   /// Stored Auth reference, if it exists. This needs to be stored for `copyWithZone:`.
   id<FIRAuthInterop> _Nullable _auth;
+  int64_t _maxDownloadCacheSize;
+  NSInteger _maxConcurrentTransfers;
 }
 @end
 
@@ -154,6 +160,9 @@ static GTMSessionFetcherRetryBlock _retryWhenOffline;
     _maxDownloadRetryTime = 600.0;
     _maxOperationRetryTime = 120.0;
     _maxUploadRetryTime = 600.0;
+    _maxConcurrentTransfers = kFIRStorageDefaultMaxConcurrentTransfers;
+    _taskScheduler = [[FIRStorageTaskScheduler alloc]
+        initWithMaxConcurrentTransfers:kFIRStorageDefaultMaxConcurrentTransfers];
   }
   return self;
 }
@@ -234,6 +243,49 @@ static GTMSessionFetcherRetryBlock _retryWhenOffline;
   _fetcherServiceForApp.callbackQueue = callbackQueue;
 }
 
+- (int64_t)maxDownloadCacheSize {
+  @synchronized(self) {
+    return _maxDownloadCacheSize;
+  }
+}
+
+- (void)setMaxDownloadCacheSize:(int64_t)maxDownloadCacheSize {
+  @synchronized(self) {
+    _maxDownloadCacheSize = MAX(maxDownloadCacheSize, 0);
+    if (_maxDownloadCacheSize == 0) {
+      [_downloadCache removeAllObjects];
+      _downloadCache = nil;
+    } else if (_downloadCache) {
+      _downloadCache.maxSize = _maxDownloadCacheSize;
+    } else {
+      // Instances for the same bucket share their cached objects.
+      NSURL *cachesURL = [[[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory
+                                                                 inDomains:NSUserDomainMask]
+          firstObject];
+      NSURL *directoryURL = [[cachesURL URLByAppendingPathComponent:kFIRStorageBundleIdentifier]
+          URLByAppendingPathComponent:[FIRStorageUtils GCSEscapedString:_storageBucket]];
+      _downloadCache = [[FIRStorageDownloadCache alloc] initWithDirectoryURL:directoryURL
+                                                                     maxSize:_maxDownloadCacheSize];
+    }
+  }
+}
+
+- (NSInteger)maxConcurrentTransfers {
+  @synchronized(self) {
+    return _maxConcurrentTransfers;
+  }
+}
+
+- (void)setMaxConcurrentTransfers:(NSInteger)maxConcurrentTransfers {
+  @synchronized(self) {
+    _maxConcurrentTransfers = MAX(maxConcurrentTransfers, 1);
+  }
+  NSUInteger schedulerMax = (NSUInteger)MAX(maxConcurrentTransfers, 1);
+  dispatch_async(_dispatchQueue, ^{
+    self->_taskScheduler.maxConcurrentTransfers = schedulerMax;
+  });
+}
+
 #pragma mark - Background tasks
 
 + (void)enableBackgroundTasks:(BOOL)isEnabled {
@@ -0,0 +1,269 @@
+// Copyright 2019 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "FIRStorageDownloadCache.h"
+
+#import <CommonCrypto/CommonDigest.h>
+
+#import "FIRStoragePath.h"
+#import "FIRStorageUtils.h"
+
+static NSString *const kDataFileExtension = @"data";
+static NSString *const kEntryFileExtension = @"json";
+
+static NSString *const kEntryBucket = @"bucket";
+static NSString *const kEntryObject = @"object";
+static NSString *const kEntryEntityTag = @"entityTag";
+static NSString *const kEntryGeneration = @"generation";
+
+@implementation FIRStorageDownloadCache {
+  NSURL *_directoryURL;
+  int64_t _maxSize;
+}
+
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL maxSize:(int64_t)maxSize {
+  self = [super init];
+  if (self) {
+    _directoryURL = [directoryURL copy];
+    _maxSize = maxSize;
+    [[NSFileManager defaultManager] createDirectoryAtURL:_directoryURL
+                             withIntermediateDirectories:YES
+                                              attributes:nil
+                                                   error:NULL];
+  }
+  return self;
+}
+
+- (void)setMaxSize:(int64_t)maxSize {
+  @synchronized(self) {
+    _maxSize = maxSize;
+    [self trimToSize:maxSize];
+  }
+}
+
+- (int64_t)maxSize {
+  @synchronized(self) {
+    return _maxSize;
+  }
+}
+
+#pragma mark - Lookups
+
+- (nullable NSString *)entityTagForPath:(FIRStoragePath *)path {
+  @synchronized(self) {
+    return [self entryForPath:path][kEntryEntityTag];
+  }
+}
+
+- (nullable NSString *)generationForPath:(FIRStoragePath *)path {
+  @synchronized(self) {
+    return [self entryForPath:path][kEntryGeneration];
+  }
+}
+
+- (nullable NSURL *)fileURLForPath:(FIRStoragePath *)path {
+  @synchronized(self) {
+    if (![self entryForPath:path]) {
+      return nil;
+    }
+    NSURL *dataURL = [self dataURLForPath:path];
+    if (![dataURL setResourceValue:[NSDate date]
+                            forKey:NSURLContentModificationDateKey
+                             error:NULL]) {
+      // The data file is gone.
+      return nil;
+    }
+    return dataURL;
+  }
+}
+
+- (nullable NSData *)dataForPath:(FIRStoragePath *)path {
+  @synchronized(self) {
+    NSURL *dataURL = [self fileURLForPath:path];
+    return dataURL ? [NSData dataWithContentsOfURL:dataURL] : nil;
+  }
+}
+
+// Returns the entry of a cached object, or nil if it is not cached. Must be called synchronized.
+- (nullable NSDictionary *)entryForPath:(FIRStoragePath *)path {
+  NSData *data = [NSData dataWithContentsOfURL:[self entryURLForPath:path]];
+  NSDictionary *entry = [NSDictionary frs_dictionaryFromJSONData:data];
+  // Guard against two paths with the same digest.
+  if (![entry[kEntryBucket] isEqual:path.bucket] || ![entry[kEntryObject] isEqual:path.object ?: @""] ||
+      ![entry[kEntryEntityTag] isKindOfClass:[NSString class]]) {
+    return nil;
+  }
+  return entry;
+}
+
+#pragma mark - Updates
+
+- (void)storeData:(NSData *)data
+          forPath:(FIRStoragePath *)path
+        entityTag:(nullable NSString *)entityTag
+       generation:(nullable NSString *)generation {
+  @synchronized(self) {
+    if (![self shouldStoreObjectOfSize:(int64_t)data.length entityTag:entityTag]) {
+      [self removeObjectForPath:path];
+      return;
+    }
+    if ([data writeToURL:[self dataURLForPath:path] options:NSDataWritingAtomic error:NULL]) {
+      [self storeEntryForPath:path entityTag:entityTag generation:generation];
+    }
+  }
+}
+
+- (void)storeFileAtURL:(NSURL *)fileURL
+               forPath:(FIRStoragePath *)path
+             entityTag:(nullable NSString *)entityTag
+            generation:(nullable NSString *)generation {
+  @synchronized(self) {
+    NSNumber *fileSize;
+    [fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:NULL];
+    if (!fileSize || ![self shouldStoreObjectOfSize:fileSize.longLongValue entityTag:entityTag]) {
+      [self removeObjectForPath:path];
+      return;
+    }
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSURL *dataURL = [self dataURLForPath:path];
+    [fileManager removeItemAtURL:dataURL error:NULL];
+    if ([fileManager copyItemAtURL:fileURL toURL:dataURL error:NULL]) {
+      [dataURL setResourceValue:[NSDate date] forKey:NSURLContentModificationDateKey error:NULL];
+      [self storeEntryForPath:path entityTag:entityTag generation:generation];
+    }
+  }
+}
+
+- (BOOL)shouldStoreObjectOfSize:(int64_t)size entityTag:(nullable NSString *)entityTag {
+  // Without an ETag a cached copy could never be revalidated.
+  return entityTag.length > 0 && size <= _maxSize;
+}
+
+- (void)storeEntryForPath:(FIRStoragePath *)path
+                entityTag:(NSString *)entityTag
+               generation:(nullable NSString *)generation {
+  NSMutableDictionary *entry = [@{
+    kEntryBucket : path.bucket,
+    kEntryObject : path.object ?: @"",
+    kEntryEntityTag : entityTag,
+  } mutableCopy];
+  entry[kEntryGeneration] = generation;
+  NSData *entryData = [NSData frs_dataFromJSONDictionary:entry];
+  if (![entryData writeToURL:[self entryURLForPath:path] options:NSDataWritingAtomic error:NULL]) {
+    [self removeObjectForPath:path];
+    return;
+  }
+  [self trimToSize:_maxSize];
+}
+
+- (void)removeObjectForPath:(FIRStoragePath *)path {
+  @synchronized(self) {
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    [fileManager removeItemAtURL:[self entryURLForPath:path] error:NULL];
+    [fileManager removeItemAtURL:[self dataURLForPath:path] error:NULL];
+  }
+}
+
+- (void)removeAllObjects {
+  @synchronized(self) {
+    [self trimToSize:0];
+  }
+}
+
+#pragma mark - Eviction
+
+- (int64_t)totalSize {
+  @synchronized(self) {
+    int64_t totalSize = 0;
+    for (NSURL *dataURL in [self dataURLsLeastRecentlyUsedFirst]) {
+      NSNumber *fileSize;
+      [dataURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:NULL];
+      totalSize += fileSize.longLongValue;
+    }
+    return totalSize;
+  }
+}
+
+// Evicts the least recently used objects until the cache fits in size. Must be called
+// synchronized.
+- (void)trimToSize:(int64_t)size {
+  NSArray<NSURL *> *dataURLs = [self dataURLsLeastRecentlyUsedFirst];
+  int64_t totalSize = 0;
+  for (NSURL *dataURL in dataURLs) {
+    NSNumber *fileSize;
+    [dataURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:NULL];
+    totalSize += fileSize.longLongValue;
+  }
+
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  for (NSURL *dataURL in dataURLs) {
+    if (totalSize <= size && size > 0) {
+      break;
+    }
+    NSNumber *fileSize;
+    [dataURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:NULL];
+    NSURL *entryURL =
+        [[dataURL URLByDeletingPathExtension] URLByAppendingPathExtension:kEntryFileExtension];
+    [fileManager removeItemAtURL:entryURL error:NULL];
+    [fileManager removeItemAtURL:dataURL error:NULL];
+    totalSize -= fileSize.longLongValue;
+  }
+}
+
+- (NSArray<NSURL *> *)dataURLsLeastRecentlyUsedFirst {
+  NSArray<NSURLResourceKey> *keys = @[ NSURLFileSizeKey, NSURLContentModificationDateKey ];
+  NSArray<NSURL *> *contents =
+      [[NSFileManager defaultManager] contentsOfDirectoryAtURL:_directoryURL
+                                    includingPropertiesForKeys:keys
+                                                       options:0
+                                                         error:NULL];
+  NSPredicate *isDataFile = [NSPredicate predicateWithBlock:^BOOL(NSURL *URL, NSDictionary *b) {
+    return [URL.pathExtension isEqualToString:kDataFileExtension];
+  }];
+  return [[contents filteredArrayUsingPredicate:isDataFile]
+      sortedArrayUsingComparator:^NSComparisonResult(NSURL *lhs, NSURL *rhs) {
+        NSDate *lhsDate;
+        NSDate *rhsDate;
+        [lhs getResourceValue:&lhsDate forKey:NSURLContentModificationDateKey error:NULL];
+        [rhs getResourceValue:&rhsDate forKey:NSURLContentModificationDateKey error:NULL];
+        return [lhsDate ?: [NSDate distantPast] compare:rhsDate ?: [NSDate distantPast]];
+      }];
+}
+
+#pragma mark - Files
+
+- (NSURL *)dataURLForPath:(FIRStoragePath *)path {
+  return [[self baseURLForPath:path] URLByAppendingPathExtension:kDataFileExtension];
+}
+
+- (NSURL *)entryURLForPath:(FIRStoragePath *)path {
+  return [[self baseURLForPath:path] URLByAppendingPathExtension:kEntryFileExtension];
+}
+
+// Object names can be up to 1024 bytes long, more than a file name can hold, so files are named
+// after a digest of the bucket and object.
+- (NSURL *)baseURLForPath:(FIRStoragePath *)path {
+  NSString *key = [NSString stringWithFormat:@"%@/%@", path.bucket, path.object ?: @""];
+  NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+  unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+  CC_SHA1(keyData.bytes, (CC_LONG)keyData.length, digest);
+
+  NSMutableString *fileName = [NSMutableString stringWithCapacity:CC_SHA1_DIGEST_LENGTH * 2];
+  for (int i = 0; i < CC_SHA1_DIGEST_LENGTH; i++) {
+    [fileName appendFormat:@"%02x", digest[i]];
+  }
+  return [_directoryURL URLByAppendingPathComponent:fileName];
+}
+
+@end
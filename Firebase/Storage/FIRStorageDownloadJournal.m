@@ -0,0 +1,149 @@
+// Copyright 2019 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "FIRStorageDownloadJournal.h"
+
+#import "FIRStorageUtils.h"
+
+static NSString *const kPartialFileExtension = @"partial";
+static NSString *const kJournalFileExtension = @"journal";
+
+static NSString *const kJournalTotalLength = @"totalLength";
+static NSString *const kJournalSegmentLength = @"segmentLength";
+static NSString *const kJournalEntityTag = @"entityTag";
+static NSString *const kJournalCompletedSegments = @"completedSegments";
+
+@implementation FIRStorageDownloadJournal {
+  NSMutableIndexSet *_completedSegments;
+}
+
+- (instancetype)initWithFileURL:(NSURL *)fileURL
+                    totalLength:(int64_t)totalLength
+                  segmentLength:(int64_t)segmentLength
+                      entityTag:(nullable NSString *)entityTag {
+  self = [super init];
+  if (self) {
+    _partialFileURL = [fileURL URLByAppendingPathExtension:kPartialFileExtension];
+    _totalLength = MAX(totalLength, 0);
+    _segmentLength = MAX(segmentLength, 1);
+    _entityTag = [entityTag copy];
+    _segmentCount = (NSUInteger)((_totalLength + _segmentLength - 1) / _segmentLength);
+    _completedSegments = [NSMutableIndexSet indexSet];
+  }
+  return self;
+}
+
++ (nullable instancetype)journalForFileURL:(NSURL *)fileURL {
+  NSURL *partialFileURL = [fileURL URLByAppendingPathExtension:kPartialFileExtension];
+  NSURL *journalURL = [partialFileURL URLByAppendingPathExtension:kJournalFileExtension];
+  NSData *data = [NSData dataWithContentsOfURL:journalURL];
+  NSDictionary *dictionary = [NSDictionary frs_dictionaryFromJSONData:data];
+  NSNumber *totalLength = dictionary[kJournalTotalLength];
+  NSNumber *segmentLength = dictionary[kJournalSegmentLength];
+  NSArray *completedSegments = dictionary[kJournalCompletedSegments];
+  if (![totalLength isKindOfClass:[NSNumber class]] ||
+      ![segmentLength isKindOfClass:[NSNumber class]] ||
+      ![completedSegments isKindOfClass:[NSArray class]]) {
+    return nil;
+  }
+
+  // A partial file of the wrong size was not written by this journal's download.
+  NSNumber *partialFileSize;
+  [partialFileURL getResourceValue:&partialFileSize forKey:NSURLFileSizeKey error:NULL];
+  if (partialFileSize.longLongValue != totalLength.longLongValue) {
+    return nil;
+  }
+
+  NSString *entityTag = dictionary[kJournalEntityTag];
+  FIRStorageDownloadJournal *journal =
+      [[self alloc] initWithFileURL:fileURL
+                        totalLength:totalLength.longLongValue
+                      segmentLength:segmentLength.longLongValue
+                          entityTag:[entityTag isKindOfClass:[NSString class]] ? entityTag : nil];
+  for (NSNumber *segment in completedSegments) {
+    if ([segment isKindOfClass:[NSNumber class]] &&
+        segment.unsignedIntegerValue < journal.segmentCount) {
+      [journal->_completedSegments addIndex:segment.unsignedIntegerValue];
+    }
+  }
+  return journal;
+}
+
+- (int64_t)offsetOfSegment:(NSUInteger)segment {
+  return (int64_t)segment * _segmentLength;
+}
+
+- (int64_t)lengthOfSegment:(NSUInteger)segment {
+  int64_t offset = [self offsetOfSegment:segment];
+  return MAX(MIN(_segmentLength, _totalLength - offset), 0);
+}
+
+- (BOOL)isSegmentCompleted:(NSUInteger)segment {
+  return [_completedSegments containsIndex:segment];
+}
+
+- (int64_t)completedLength {
+  __block int64_t completedLength = 0;
+  [_completedSegments enumerateIndexesUsingBlock:^(NSUInteger segment, BOOL *stop) {
+    completedLength += [self lengthOfSegment:segment];
+  }];
+  return completedLength;
+}
+
+- (BOOL)isComplete {
+  return _completedSegments.count == _segmentCount;
+}
+
+- (BOOL)markSegmentCompleted:(NSUInteger)segment error:(NSError **)error {
+  if (segment >= _segmentCount) {
+    return YES;
+  }
+  [_completedSegments addIndex:segment];
+  if (![self save:error]) {
+    [_completedSegments removeIndex:segment];
+    return NO;
+  }
+  return YES;
+}
+
+- (BOOL)save:(NSError **)error {
+  NSMutableArray<NSNumber *> *completedSegments =
+      [NSMutableArray arrayWithCapacity:_completedSegments.count];
+  [_completedSegments enumerateIndexesUsingBlock:^(NSUInteger segment, BOOL *stop) {
+    [completedSegments addObject:@(segment)];
+  }];
+  NSMutableDictionary *dictionary = [@{
+    kJournalTotalLength : @(_totalLength),
+    kJournalSegmentLength : @(_segmentLength),
+    kJournalCompletedSegments : completedSegments,
+  } mutableCopy];
+  dictionary[kJournalEntityTag] = _entityTag;
+
+  NSData *data = [NSData frs_dataFromJSONDictionary:dictionary];
+  return [data writeToURL:[self journalURL] options:NSDataWritingAtomic error:error];
+}
+
+- (void)removeWithPartialFile:(BOOL)removePartialFile {
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  [fileManager removeItemAtURL:[self journalURL] error:NULL];
+  if (removePartialFile) {
+    [fileManager removeItemAtURL:_partialFileURL error:NULL];
+  }
+}
+
+- (NSURL *)journalURL {
+  return [_partialFileURL URLByAppendingPathExtension:kJournalFileExtension];
+}
+
+@end
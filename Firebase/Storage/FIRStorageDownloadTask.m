@@ -15,11 +15,30 @@
 #import "FIRStorageDownloadTask.h"
 
 #import "FIRStorageConstants_Private.h"
+#import "FIRStorageDownloadCache.h"
+#import "FIRStorageDownloadJournal.h"
 #import "FIRStorageDownloadTask_Private.h"
 #import "FIRStorageObservableTask_Private.h"
+#import "FIRStorageTaskScheduler.h"
 #import "FIRStorageTask_Private.h"
+#import "FIRStorage_Private.h"
 
-@implementation FIRStorageDownloadTask
+// File downloads are fetched in ranges of this size, written into a partial file as they arrive.
+static const int64_t kFIRStorageDownloadSegmentLength = 4 * 1024 * 1024;
+static const NSUInteger kFIRStorageMaxConcurrentSegments = 4;
+
+// A download revalidating a cached object fails with this status when the object did not change.
+static BOOL FIRStorageIsNotModifiedError(NSError *_Nullable error) {
+  return [error.domain isEqualToString:kGTMSessionFetcherStatusDomain] && error.code == 304;
+}
+
+@implementation FIRStorageDownloadTask {
+  // The segments of a file download written so far, nil until the size of the object is known.
+  FIRStorageDownloadJournal *_journal;
+  NSMutableDictionary<NSNumber *, GTMSessionFetcher *> *_segmentFetchers;
+  // The generation of the object sent with the first segment, if any.
+  NSString *_generation;
+}
 
 @synthesize progress = _progress;
 @synthesize fetcher = _fetcher;
@@ -33,19 +52,17 @@
   if (self) {
     _fileURL = [fileURL copy];
     _progress = [NSProgress progressWithTotalUnitCount:0];
+    _segmentFetchers = [NSMutableDictionary dictionary];
   }
   return self;
 }
 
 - (void)dealloc {
   [_fetcher stopFetching];
+  [self stopSegmentFetchers];
 }
 
 - (void)enqueue {
-  [self enqueueWithData:nil];
-}
-
-- (void)enqueueWithData:(nullable NSData *)resumeData {
   __weak FIRStorageDownloadTask *weakSelf = self;
 
   [self dispatchAsync:^() {
@@ -55,94 +72,431 @@
       return;
     }
 
+    // The download starts once the other transfers leave it room.
     strongSelf.state = FIRStorageTaskStateQueueing;
-    NSMutableURLRequest *request = [strongSelf.baseRequest mutableCopy];
-    request.HTTPMethod = @"GET";
-    request.timeoutInterval = strongSelf.reference.storage.maxDownloadRetryTime;
-    NSURLComponents *components = [NSURLComponents componentsWithURL:request.URL
-                                             resolvingAgainstBaseURL:NO];
-    [components setQuery:@"alt=media"];
-    request.URL = components.URL;
-
-    GTMSessionFetcher *fetcher;
-    if (resumeData) {
-      fetcher = [GTMSessionFetcher fetcherWithDownloadResumeData:resumeData];
-      fetcher.comment = @"Resuming DownloadTask";
-    } else {
-      fetcher = [strongSelf.fetcherService fetcherWithRequest:request];
-      fetcher.comment = @"Starting DownloadTask";
-    }
+    [strongSelf.reference.storage.taskScheduler scheduleTask:strongSelf];
+  }];
+}
 
-    [fetcher setResumeDataBlock:^(NSData *data) {
-      FIRStorageDownloadTask *strong = weakSelf;
-      if (strong && data) {
-        strong->_downloadData = data;
-      }
-    }];
+#pragma mark - FIRStorageScheduledTask
 
-    fetcher.maxRetryInterval = strongSelf.reference.storage.maxDownloadRetryTime;
-
-    if (strongSelf->_fileURL) {
-      // Handle file downloads
-      [fetcher setDestinationFileURL:strongSelf->_fileURL];
-      [fetcher setDownloadProgressBlock:^(int64_t bytesWritten, int64_t totalBytesWritten,
-                                          int64_t totalBytesExpectedToWrite) {
-        weakSelf.state = FIRStorageTaskStateProgress;
-        weakSelf.progress.completedUnitCount = totalBytesWritten;
-        weakSelf.progress.totalUnitCount = totalBytesExpectedToWrite;
-        FIRStorageTaskSnapshot *snapshot = weakSelf.snapshot;
-        [weakSelf fireHandlersForStatus:FIRStorageTaskStatusProgress snapshot:snapshot];
-        weakSelf.state = FIRStorageTaskStateRunning;
-      }];
-    } else {
-      // Handle data downloads
-      [fetcher setReceivedProgressBlock:^(int64_t bytesWritten, int64_t totalBytesWritten) {
-        weakSelf.state = FIRStorageTaskStateProgress;
-        weakSelf.progress.completedUnitCount = totalBytesWritten;
-        int64_t totalLength = [[weakSelf.fetcher response] expectedContentLength];
-        weakSelf.progress.totalUnitCount = totalLength;
-        FIRStorageTaskSnapshot *snapshot = weakSelf.snapshot;
-        [weakSelf fireHandlersForStatus:FIRStorageTaskStatusProgress snapshot:snapshot];
-        weakSelf.state = FIRStorageTaskStateRunning;
-      }];
+- (void)startTransfer {
+  [self transferDidStart];
+  if (_fileURL) {
+    [self enqueueSegmentedDownload];
+  } else {
+    [self fetchWithResumeData:self.downloadData];
+  }
+}
+
+- (void)suspendTransfer {
+  [self transferDidStop];
+  [self.fetcher stopFetching];
+  [self pauseSegmentedDownload];
+  // Give the resume data block a chance to run
+  [self.fetcher waitForCompletionWithTimeout:0.001];
+  self.state = FIRStorageTaskStateQueueing;
+}
+
+#pragma mark - In-Memory Downloads
+
+// Runs on the dispatch queue.
+- (void)fetchWithResumeData:(nullable NSData *)resumeData {
+  __weak FIRStorageDownloadTask *weakSelf = self;
+  NSMutableURLRequest *request = [self mediaRequest];
+  FIRStorageDownloadCache *cache = self.reference.storage.downloadCache;
+  NSString *cachedEntityTag = resumeData ? nil : [cache entityTagForPath:self.reference.path];
+  if (cachedEntityTag) {
+    [request setValue:cachedEntityTag forHTTPHeaderField:@"If-None-Match"];
+  }
+
+  GTMSessionFetcher *fetcher;
+  if (resumeData) {
+    fetcher = [GTMSessionFetcher fetcherWithDownloadResumeData:resumeData];
+    fetcher.comment = @"Resuming DownloadTask";
+  } else {
+    fetcher = [self.fetcherService fetcherWithRequest:request];
+    fetcher.comment = @"Starting DownloadTask";
+  }
+
+  [fetcher setResumeDataBlock:^(NSData *data) {
+    FIRStorageDownloadTask *strong = weakSelf;
+    if (strong && data) {
+      strong->_downloadData = data;
     }
+  }];
+
+  fetcher.maxRetryInterval = self.reference.storage.maxDownloadRetryTime;
+
+  [fetcher setReceivedProgressBlock:^(int64_t bytesWritten, int64_t totalBytesWritten) {
+    [weakSelf transferDidMoveBytes:bytesWritten];
+    weakSelf.state = FIRStorageTaskStateProgress;
+    weakSelf.progress.completedUnitCount = totalBytesWritten;
+    int64_t totalLength = [[weakSelf.fetcher response] expectedContentLength];
+    weakSelf.progress.totalUnitCount = totalLength;
+    FIRStorageTaskSnapshot *snapshot = weakSelf.snapshot;
+    [weakSelf fireHandlersForStatus:FIRStorageTaskStatusProgress snapshot:snapshot];
+    weakSelf.state = FIRStorageTaskStateRunning;
+  }];
 
-    strongSelf->_fetcher = fetcher;
+  self->_fetcher = fetcher;
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Warc-retain-cycles"
-    strongSelf->_fetcherCompletion = ^(NSData *data, NSError *error) {
-      // Fire last progress updates
-      [self fireHandlersForStatus:FIRStorageTaskStatusProgress snapshot:self.snapshot];
-
-      // Handle potential issues with download
-      if (error) {
-        self.state = FIRStorageTaskStateFailed;
-        self.error = [FIRStorageErrors errorWithServerError:error reference:self.reference];
-        [self fireHandlersForStatus:FIRStorageTaskStatusFailure snapshot:self.snapshot];
-        [self removeAllObservers];
-        self->_fetcherCompletion = nil;
-        return;
-      }
-
-      // Download completed successfully, fire completion callbacks
-      self.state = FIRStorageTaskStateSuccess;
+  self->_fetcherCompletion = ^(NSData *data, NSError *error) {
+    // Fetcher callbacks don't run on the dispatch queue.
+    [self dispatchAsync:^() {
+      [self releaseTransfer];
+    }];
 
-      if (data) {
-        self->_downloadData = data;
+    BOOL isCached = NO;
+    if (cachedEntityTag && FIRStorageIsNotModifiedError(error)) {
+      NSData *cachedData = [cache dataForPath:self.reference.path];
+      if (cachedData) {
+        data = cachedData;
+        error = nil;
+        isCached = YES;
+        self.progress.totalUnitCount = (int64_t)data.length;
+        self.progress.completedUnitCount = (int64_t)data.length;
       }
+    }
 
-      [self fireHandlersForStatus:FIRStorageTaskStatusSuccess snapshot:self.snapshot];
+    // Fire last progress updates
+    [self fireHandlersForStatus:FIRStorageTaskStatusProgress snapshot:self.snapshot];
+
+    // Handle potential issues with download
+    if (error) {
+      self.state = FIRStorageTaskStateFailed;
+      self.error = [FIRStorageErrors errorWithServerError:error reference:self.reference];
+      [self fireHandlersForStatus:FIRStorageTaskStatusFailure snapshot:self.snapshot];
       [self removeAllObservers];
       self->_fetcherCompletion = nil;
-    };
+      return;
+    }
+
+    // Download completed successfully, fire completion callbacks
+    self.state = FIRStorageTaskStateSuccess;
+
+    if (data) {
+      self->_downloadData = data;
+      if (!isCached) {
+        NSHTTPURLResponse *response = (NSHTTPURLResponse *)self.fetcher.response;
+        [cache storeData:data
+                 forPath:self.reference.path
+               entityTag:response.allHeaderFields[@"ETag"]
+              generation:response.allHeaderFields[@"x-goog-generation"]];
+      }
+    }
+
+    [self fireHandlersForStatus:FIRStorageTaskStatusSuccess snapshot:self.snapshot];
+    [self removeAllObservers];
+    self->_fetcherCompletion = nil;
+  };
 #pragma clang diagnostic pop
 
-    strongSelf.state = FIRStorageTaskStateRunning;
-    [strongSelf.fetcher beginFetchWithCompletionHandler:^(NSData *data, NSError *error) {
-      weakSelf.fetcherCompletion(data, error);
+  self.state = FIRStorageTaskStateRunning;
+  [self.fetcher beginFetchWithCompletionHandler:^(NSData *data, NSError *error) {
+    weakSelf.fetcherCompletion(data, error);
+  }];
+}
+
+- (NSMutableURLRequest *)mediaRequest {
+  NSMutableURLRequest *request = [self.baseRequest mutableCopy];
+  request.HTTPMethod = @"GET";
+  request.timeoutInterval = self.reference.storage.maxDownloadRetryTime;
+  NSURLComponents *components = [NSURLComponents componentsWithURL:request.URL
+                                           resolvingAgainstBaseURL:NO];
+  [components setQuery:@"alt=media"];
+  request.URL = components.URL;
+  return request;
+}
+
+#pragma mark - Segmented File Downloads
+
+// File downloads fetch the object in ranges, several at a time, and keep a journal of the ranges
+// written so far. Resuming after a pause, or downloading to the same file after a failure, only
+// fetches the ranges that are missing. Runs on the dispatch queue.
+- (void)enqueueSegmentedDownload {
+  if (!_journal) {
+    _journal = [FIRStorageDownloadJournal journalForFileURL:_fileURL];
+  }
+
+  self.state = FIRStorageTaskStateRunning;
+  if (_journal) {
+    self.progress.totalUnitCount = _journal.totalLength;
+    self.progress.completedUnitCount = _journal.completedLength;
+    [self fetchPendingSegments];
+  } else {
+    // The size of the object is learned from the response to its first range.
+    self.progress.completedUnitCount = 0;
+    [self fetchSegment:0];
+  }
+}
+
+- (void)fetchPendingSegments {
+  // Running transfers share the connections, so a download doesn't crowd out the others.
+  NSUInteger runningTaskCount = self.reference.storage.taskScheduler.runningTaskCount;
+  NSUInteger maxSegmentFetchers =
+      MAX(1, kFIRStorageMaxConcurrentSegments / MAX(1, runningTaskCount));
+  for (NSUInteger segment = 0;
+       segment < _journal.segmentCount && _segmentFetchers.count < maxSegmentFetchers;
+       segment++) {
+    if (![_journal isSegmentCompleted:segment] && !_segmentFetchers[@(segment)]) {
+      [self fetchSegment:segment];
+    }
+  }
+}
+
+- (void)fetchSegment:(NSUInteger)segment {
+  int64_t offset = (int64_t)segment * kFIRStorageDownloadSegmentLength;
+  int64_t length = _journal ? [_journal lengthOfSegment:segment] : kFIRStorageDownloadSegmentLength;
+
+  NSMutableURLRequest *request = [self mediaRequest];
+  NSString *range = [NSString stringWithFormat:@"bytes=%lld-%lld", offset, offset + length - 1];
+  [request setValue:range forHTTPHeaderField:@"Range"];
+  if (_journal.entityTag) {
+    // A changed object is sent whole rather than mixed with the ranges already written.
+    [request setValue:_journal.entityTag forHTTPHeaderField:@"If-Range"];
+  } else if (!_journal) {
+    NSString *cachedEntityTag = [self.reference.storage.downloadCache
+        entityTagForPath:self.reference.path];
+    if (cachedEntityTag) {
+      [request setValue:cachedEntityTag forHTTPHeaderField:@"If-None-Match"];
+    }
+  }
+
+  GTMSessionFetcher *fetcher = [self.fetcherService fetcherWithRequest:request];
+  fetcher.comment = @"Segment DownloadTask";
+  fetcher.maxRetryInterval = self.reference.storage.maxDownloadRetryTime;
+
+  __weak FIRStorageDownloadTask *weakSelf = self;
+  [fetcher setReceivedProgressBlock:^(int64_t bytesWritten, int64_t totalBytesWritten) {
+    [weakSelf dispatchAsync:^() {
+      [weakSelf segmentReceivedBytes:bytesWritten];
     }];
   }];
+
+  _segmentFetchers[@(segment)] = fetcher;
+  self.fetcher = fetcher;
+  [fetcher beginFetchWithCompletionHandler:^(NSData *data, NSError *error) {
+    [weakSelf dispatchAsync:^() {
+      [weakSelf segment:segment fetcher:fetcher didFinishWithData:data error:error];
+    }];
+  }];
+}
+
+- (void)segmentReceivedBytes:(int64_t)bytesReceived {
+  if (self.state != FIRStorageTaskStateRunning) {
+    return;
+  }
+  [self transferDidMoveBytes:bytesReceived];
+  self.state = FIRStorageTaskStateProgress;
+  self.progress.completedUnitCount += bytesReceived;
+  [self fireHandlersForStatus:FIRStorageTaskStatusProgress snapshot:self.snapshot];
+  self.state = FIRStorageTaskStateRunning;
+}
+
+- (void)segment:(NSUInteger)segment
+              fetcher:(GTMSessionFetcher *)fetcher
+    didFinishWithData:(NSData *)data
+                error:(NSError *)error {
+  if (_segmentFetchers[@(segment)] != fetcher) {
+    return;
+  }
+  [_segmentFetchers removeObjectForKey:@(segment)];
+  if (self.state != FIRStorageTaskStateRunning) {
+    // Paused or cancelled while the response was on its way.
+    return;
+  }
+
+  if (error) {
+    if (!_journal && FIRStorageIsNotModifiedError(error) && [self copyCachedObjectToFile]) {
+      [self finishSegmentedDownloadWithError:nil];
+    } else {
+      [self finishSegmentedDownloadWithError:error];
+    }
+    return;
+  }
+
+  FIRStorageDownloadCache *cache = self.reference.storage.downloadCache;
+  NSHTTPURLResponse *response = (NSHTTPURLResponse *)fetcher.response;
+  if (response.statusCode != 206) {
+    // The server sent the whole object, because it changed since the download started or because
+    // it does not support ranges.
+    [self stopSegmentFetchers];
+    [_journal removeWithPartialFile:YES];
+    _journal = nil;
+    NSError *writeError;
+    if (![data writeToURL:_fileURL options:NSDataWritingAtomic error:&writeError]) {
+      [self finishSegmentedDownloadWithError:writeError];
+      return;
+    }
+    self.progress.totalUnitCount = (int64_t)data.length;
+    self.progress.completedUnitCount = (int64_t)data.length;
+    [cache storeData:data
+             forPath:self.reference.path
+           entityTag:response.allHeaderFields[@"ETag"]
+          generation:response.allHeaderFields[@"x-goog-generation"]];
+    [self finishSegmentedDownloadWithError:nil];
+    return;
+  }
+
+  if (!_journal) {
+    NSError *journalError;
+    if (![self createJournalWithResponse:response error:&journalError]) {
+      [self finishSegmentedDownloadWithError:journalError];
+      return;
+    }
+  }
+
+  NSError *writeError;
+  if (![self writeSegmentData:data atOffset:[_journal offsetOfSegment:segment] error:&writeError] ||
+      ![_journal markSegmentCompleted:segment error:&writeError]) {
+    [self stopSegmentFetchers];
+    [self finishSegmentedDownloadWithError:writeError];
+    return;
+  }
+
+  if (!_journal.isComplete) {
+    [self fetchPendingSegments];
+    return;
+  }
+
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  [fileManager removeItemAtURL:_fileURL error:NULL];
+  NSError *moveError;
+  if (![fileManager moveItemAtURL:_journal.partialFileURL toURL:_fileURL error:&moveError]) {
+    [self finishSegmentedDownloadWithError:moveError];
+    return;
+  }
+  [cache storeFileAtURL:_fileURL
+               forPath:self.reference.path
+             entityTag:_journal.entityTag
+            generation:_generation];
+  [_journal removeWithPartialFile:NO];
+  _journal = nil;
+  [self finishSegmentedDownloadWithError:nil];
+}
+
+- (BOOL)copyCachedObjectToFile {
+  NSURL *cachedFileURL = [self.reference.storage.downloadCache fileURLForPath:self.reference.path];
+  if (!cachedFileURL) {
+    return NO;
+  }
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  [fileManager removeItemAtURL:_fileURL error:NULL];
+  if (![fileManager copyItemAtURL:cachedFileURL toURL:_fileURL error:NULL]) {
+    return NO;
+  }
+  NSNumber *fileSize;
+  [_fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:NULL];
+  self.progress.totalUnitCount = fileSize.longLongValue;
+  self.progress.completedUnitCount = fileSize.longLongValue;
+  return YES;
+}
+
+- (BOOL)createJournalWithResponse:(NSHTTPURLResponse *)response error:(NSError **)error {
+  // Content-Range: bytes <first>-<last>/<total>
+  NSString *contentRange = response.allHeaderFields[@"Content-Range"];
+  NSRange slash = [contentRange rangeOfString:@"/" options:NSBackwardsSearch];
+  int64_t totalLength = 0;
+  if (slash.location != NSNotFound) {
+    totalLength = [contentRange substringFromIndex:NSMaxRange(slash)].longLongValue;
+  }
+  if (totalLength <= 0) {
+    if (error) {
+      *error = [FIRStorageErrors errorWithCode:FIRStorageErrorCodeUnknown];
+    }
+    return NO;
+  }
+
+  FIRStorageDownloadJournal *journal =
+      [[FIRStorageDownloadJournal alloc] initWithFileURL:_fileURL
+                                             totalLength:totalLength
+                                           segmentLength:kFIRStorageDownloadSegmentLength
+                                               entityTag:response.allHeaderFields[@"ETag"]];
+
+  // Allocate the whole file up front so that segments can be written where they belong.
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  if (![fileManager createFileAtPath:journal.partialFileURL.path contents:nil attributes:nil]) {
+    if (error) {
+      *error = [FIRStorageErrors errorWithCode:FIRStorageErrorCodeUnknown];
+    }
+    return NO;
+  }
+  NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingToURL:journal.partialFileURL
+                                                               error:error];
+  if (!fileHandle) {
+    return NO;
+  }
+  [fileHandle truncateFileAtOffset:(unsigned long long)totalLength];
+  [fileHandle closeFile];
+
+  if (![journal save:error]) {
+    return NO;
+  }
+  _journal = journal;
+  _generation = response.allHeaderFields[@"x-goog-generation"];
+  self.progress.totalUnitCount = totalLength;
+  return YES;
+}
+
+- (BOOL)writeSegmentData:(NSData *)data atOffset:(int64_t)offset error:(NSError **)error {
+  NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingToURL:_journal.partialFileURL
+                                                               error:error];
+  if (!fileHandle) {
+    return NO;
+  }
+  @try {
+    [fileHandle seekToFileOffset:(unsigned long long)offset];
+    [fileHandle writeData:data];
+  } @catch (NSException *exception) {
+    if (error) {
+      *error = [FIRStorageErrors errorWithCode:FIRStorageErrorCodeUnknown];
+    }
+    return NO;
+  } @finally {
+    [fileHandle closeFile];
+  }
+  return YES;
+}
+
+- (void)finishSegmentedDownloadWithError:(nullable NSError *)error {
+  [self releaseTransfer];
+  [self fireHandlersForStatus:FIRStorageTaskStatusProgress snapshot:self.snapshot];
+
+  if (error) {
+    // The journal is kept, so that downloading to the same file again continues from it.
+    [self stopSegmentFetchers];
+    self.state = FIRStorageTaskStateFailed;
+    self.error = [FIRStorageErrors errorWithServerError:error reference:self.reference];
+    [self fireHandlersForStatus:FIRStorageTaskStatusFailure snapshot:self.snapshot];
+  } else {
+    self.state = FIRStorageTaskStateSuccess;
+    [self fireHandlersForStatus:FIRStorageTaskStatusSuccess snapshot:self.snapshot];
+  }
+  [self removeAllObservers];
+}
+
+- (void)pauseSegmentedDownload {
+  [self stopSegmentFetchers];
+  // Segments that were in flight are fetched again on resume.
+  if (_journal) {
+    self.progress.completedUnitCount = _journal.completedLength;
+  }
+}
+
+- (void)cancelSegmentedDownload {
+  [self stopSegmentFetchers];
+  [_journal removeWithPartialFile:YES];
+  _journal = nil;
+}
+
+- (void)stopSegmentFetchers {
+  for (GTMSessionFetcher *fetcher in _segmentFetchers.allValues) {
+    [fetcher stopFetching];
+  }
+  [_segmentFetchers removeAllObjects];
 }
 
 #pragma mark - Download Management
@@ -157,6 +511,8 @@
   [self dispatchAsync:^() {
     weakSelf.state = FIRStorageTaskStateCancelled;
     [weakSelf.fetcher stopFetching];
+    [weakSelf cancelSegmentedDownload];
+    [weakSelf releaseTransfer];
     weakSelf.error = error;
     [weakSelf fireHandlersForStatus:FIRStorageTaskStatusFailure snapshot:weakSelf.snapshot];
   }];
@@ -167,9 +523,11 @@
   [self dispatchAsync:^() {
     weakSelf.state = FIRStorageTaskStatePausing;
     [weakSelf.fetcher stopFetching];
+    [weakSelf pauseSegmentedDownload];
     // Give the resume callback a chance to run (if scheduled)
     [weakSelf.fetcher waitForCompletionWithTimeout:0.001];
     weakSelf.state = FIRStorageTaskStatePaused;
+    [weakSelf releaseTransfer];
     FIRStorageTaskSnapshot *snapshot = weakSelf.snapshot;
     [weakSelf fireHandlersForStatus:FIRStorageTaskStatusPause snapshot:snapshot];
   }];
@@ -181,8 +539,11 @@
     weakSelf.state = FIRStorageTaskStateResuming;
     FIRStorageTaskSnapshot *snapshot = weakSelf.snapshot;
     [weakSelf fireHandlersForStatus:FIRStorageTaskStatusResume snapshot:snapshot];
-    weakSelf.state = FIRStorageTaskStateRunning;
-    [weakSelf enqueueWithData:weakSelf.downloadData];
+    // The fetch continues once the other transfers leave it room.
+    FIRStorageTaskScheduler *scheduler = weakSelf.reference.storage.taskScheduler;
+    weakSelf.state = [scheduler isTaskRunning:weakSelf] ? FIRStorageTaskStateRunning
+                                                        : FIRStorageTaskStateQueueing;
+    [scheduler scheduleTask:weakSelf];
   }];
 }
 
@@ -89,12 +89,14 @@
       break;
 
     case FIRStorageErrorCodeNonMatchingChecksum: {
-      // TODO: replace with actual checksum strings when we choose to implement.
       NSString *const kChecksumFailedErrorFormat =
           @"Uploaded/downloaded object %@ has checksum: %@ "
           @"which does not match server checksum: %@. Please retry the upload/download.";
-      errorMessage = [NSString stringWithFormat:kChecksumFailedErrorFormat, @"object",
-                                                @"client checksum", @"server checksum"];
+      NSString *object = errorDictionary[@"object"] ?: @"object";
+      NSString *clientChecksum = errorDictionary[@"clientChecksum"] ?: @"client checksum";
+      NSString *serverChecksum = errorDictionary[@"serverChecksum"] ?: @"server checksum";
+      errorMessage = [NSString
+          stringWithFormat:kChecksumFailedErrorFormat, object, clientChecksum, serverChecksum];
       break;
     }
 
@@ -14,7 +14,9 @@
 
 #import "FIRStorageObservableTask.h"
 #import "FIRStorageObservableTask_Private.h"
+#import "FIRStorageTaskScheduler.h"
 #import "FIRStorageTask_Private.h"
+#import "FIRStorage_Private.h"
 
 @implementation FIRStorageObservableTask {
  @private
@@ -26,6 +28,7 @@
   NSMutableDictionary<NSString *, FIRStorageVoidSnapshot> *_failureHandlers;
   // Reverse map of fetcher handles to status types
   NSMutableDictionary<NSString *, NSNumber *> *_handleToStatusMap;
+  FIRStorageTaskPriority _priority;
 }
 
 @synthesize state = _state;
@@ -45,6 +48,34 @@
   return self;
 }
 
+#pragma mark - Priority
+
+- (FIRStorageTaskPriority)priority {
+  @synchronized(self) {
+    return _priority;
+  }
+}
+
+- (void)setPriority:(FIRStorageTaskPriority)priority {
+  @synchronized(self) {
+    _priority = priority;
+  }
+  if ([self conformsToProtocol:@protocol(FIRStorageScheduledTask)]) {
+    __weak FIRStorageObservableTask *weakSelf = self;
+    [self dispatchAsync:^() {
+      FIRStorageObservableTask<FIRStorageScheduledTask> *strongSelf = (id)weakSelf;
+      [strongSelf.reference.storage.taskScheduler taskDidChangePriority:strongSelf];
+    }];
+  }
+}
+
+- (void)releaseTransfer {
+  [self transferDidStop];
+  if ([self conformsToProtocol:@protocol(FIRStorageScheduledTask)]) {
+    [self.reference.storage.taskScheduler removeTask:(id<FIRStorageScheduledTask>)self];
+  }
+}
+
 #pragma mark - Observers
 
 - (FIRStorageHandle)observeStatus:(FIRStorageTaskStatus)status
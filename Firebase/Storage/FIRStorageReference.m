@@ -242,6 +242,45 @@
   return task;
 }
 
+- (FIRStorageUploadTask *)putStream:(NSInputStream *)inputStream
+                           metadata:(nullable FIRStorageMetadata *)metadata
+                         completion:(nullable FIRStorageVoidMetadataError)completion {
+  if (!metadata) {
+    metadata = [[FIRStorageMetadata alloc] init];
+  }
+
+  metadata.path = _path.object;
+  metadata.name = [_path.object lastPathComponent];
+  FIRStorageUploadTask *task =
+      [[FIRStorageUploadTask alloc] initWithReference:self
+                                       fetcherService:_storage.fetcherServiceForApp
+                                        dispatchQueue:_storage.dispatchQueue
+                                               stream:inputStream
+                                             metadata:metadata];
+
+  if (completion) {
+    dispatch_queue_t callbackQueue = _storage.fetcherServiceForApp.callbackQueue;
+    if (!callbackQueue) {
+      callbackQueue = dispatch_get_main_queue();
+    }
+
+    [task observeStatus:FIRStorageTaskStatusSuccess
+                handler:^(FIRStorageTaskSnapshot *_Nonnull snapshot) {
+                  dispatch_async(callbackQueue, ^{
+                    completion(snapshot.metadata, nil);
+                  });
+                }];
+    [task observeStatus:FIRStorageTaskStatusFailure
+                handler:^(FIRStorageTaskSnapshot *_Nonnull snapshot) {
+                  dispatch_async(callbackQueue, ^{
+                    completion(nil, snapshot.error);
+                  });
+                }];
+  }
+  [task enqueue];
+  return task;
+}
+
 #pragma mark - Downloads
 
 - (FIRStorageDownloadTask *)dataWithMaxSize:(int64_t)size
@@ -24,7 +24,13 @@
 
 #import <GTMSessionFetcher/GTMSessionFetcherService.h>
 
-@implementation FIRStorageTask
+@implementation FIRStorageTask {
+  // The throughput of the transfer: the bytes moved over the time spent transferring, which is
+  // the time until _transferStartDate plus the time since, if set.
+  int64_t _transferredBytes;
+  NSTimeInterval _transferDuration;
+  NSDate *_transferStartDate;
+}
 
 - (instancetype)init {
   @throw [NSException exceptionWithName:@"Attempt to call unavailable initializer."
@@ -57,6 +63,7 @@
                                            reference:self.reference
                                             progress:progress
                                                error:[self.error copy]];
+    snapshot.bytesPerSecond = [self bytesPerSecond];
     return snapshot;
   }
 }
@@ -65,4 +72,39 @@
   dispatch_async(self.dispatchQueue, block);
 }
 
+#pragma mark - Throughput
+
+- (void)transferDidStart {
+  @synchronized(self) {
+    if (!_transferStartDate) {
+      _transferStartDate = [NSDate date];
+    }
+  }
+}
+
+- (void)transferDidStop {
+  @synchronized(self) {
+    if (_transferStartDate) {
+      _transferDuration += -[_transferStartDate timeIntervalSinceNow];
+      _transferStartDate = nil;
+    }
+  }
+}
+
+- (void)transferDidMoveBytes:(int64_t)bytes {
+  @synchronized(self) {
+    _transferredBytes += MAX(bytes, 0);
+  }
+}
+
+- (double)bytesPerSecond {
+  @synchronized(self) {
+    NSTimeInterval duration = _transferDuration;
+    if (_transferStartDate) {
+      duration += -[_transferStartDate timeIntervalSinceNow];
+    }
+    return duration > 0 ? _transferredBytes / duration : 0;
+  }
+}
+
 @end
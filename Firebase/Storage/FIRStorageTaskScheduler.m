@@ -0,0 +1,129 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FIRStorageTaskScheduler.h"
+
+@implementation FIRStorageTaskScheduler {
+  // All the scheduled tasks, running or not, in the order they were scheduled.
+  NSMutableArray<id<FIRStorageScheduledTask>> *_tasks;
+  NSMutableArray<id<FIRStorageScheduledTask>> *_runningTasks;
+  // Starting or suspending a task may call back into the scheduler.
+  BOOL _isUpdating;
+  BOOL _needsUpdate;
+}
+
+- (instancetype)initWithMaxConcurrentTransfers:(NSUInteger)maxConcurrentTransfers {
+  self = [super init];
+  if (self) {
+    _maxConcurrentTransfers = MAX(maxConcurrentTransfers, 1);
+    _tasks = [NSMutableArray array];
+    _runningTasks = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (void)setMaxConcurrentTransfers:(NSUInteger)maxConcurrentTransfers {
+  _maxConcurrentTransfers = MAX(maxConcurrentTransfers, 1);
+  [self updateRunningTasks];
+}
+
+- (NSUInteger)runningTaskCount {
+  return _runningTasks.count;
+}
+
+- (void)scheduleTask:(id<FIRStorageScheduledTask>)task {
+  if ([_tasks indexOfObjectIdenticalTo:task] != NSNotFound) {
+    return;
+  }
+  [_tasks addObject:task];
+  [self updateRunningTasks];
+}
+
+- (void)removeTask:(id<FIRStorageScheduledTask>)task {
+  if ([_tasks indexOfObjectIdenticalTo:task] == NSNotFound) {
+    return;
+  }
+  [_tasks removeObjectIdenticalTo:task];
+  [_runningTasks removeObjectIdenticalTo:task];
+  [self updateRunningTasks];
+}
+
+- (void)taskDidChangePriority:(id<FIRStorageScheduledTask>)task {
+  if ([_tasks indexOfObjectIdenticalTo:task] != NSNotFound) {
+    [self updateRunningTasks];
+  }
+}
+
+- (BOOL)isTaskRunning:(id<FIRStorageScheduledTask>)task {
+  return [_runningTasks indexOfObjectIdenticalTo:task] != NSNotFound;
+}
+
+#pragma mark - Private
+
+- (void)updateRunningTasks {
+  if (_isUpdating) {
+    _needsUpdate = YES;
+    return;
+  }
+  _isUpdating = YES;
+  do {
+    _needsUpdate = NO;
+    [self startAndSuspendTasks];
+  } while (_needsUpdate);
+  _isUpdating = NO;
+}
+
+- (void)startAndSuspendTasks {
+  BOOL hasHighPriorityTask = NO;
+  for (id<FIRStorageScheduledTask> task in _tasks) {
+    hasHighPriorityTask = hasHighPriorityTask || task.priority >= FIRStorageTaskPriorityHigh;
+  }
+
+  // Higher priorities first, in the order they were scheduled within a priority.
+  NSArray<id<FIRStorageScheduledTask>> *orderedTasks = [_tasks
+      sortedArrayWithOptions:NSSortStable
+             usingComparator:^NSComparisonResult(id<FIRStorageScheduledTask> task1,
+                                                 id<FIRStorageScheduledTask> task2) {
+               if (task1.priority == task2.priority) {
+                 return NSOrderedSame;
+               }
+               return task1.priority > task2.priority ? NSOrderedAscending : NSOrderedDescending;
+             }];
+  NSMutableArray<id<FIRStorageScheduledTask>> *tasksToRun = [NSMutableArray array];
+  for (id<FIRStorageScheduledTask> task in orderedTasks) {
+    if (tasksToRun.count >= _maxConcurrentTransfers ||
+        (hasHighPriorityTask && task.priority <= FIRStorageTaskPriorityLow)) {
+      break;
+    }
+    [tasksToRun addObject:task];
+  }
+
+  // Suspend first, so that there are never more transfers than allowed.
+  for (id<FIRStorageScheduledTask> task in [_runningTasks copy]) {
+    if ([tasksToRun indexOfObjectIdenticalTo:task] == NSNotFound) {
+      [_runningTasks removeObjectIdenticalTo:task];
+      [task suspendTransfer];
+    }
+  }
+  for (id<FIRStorageScheduledTask> task in tasksToRun) {
+    if ([_runningTasks indexOfObjectIdenticalTo:task] == NSNotFound) {
+      [_runningTasks addObject:task];
+      [task startTransfer];
+    }
+  }
+}
+
+@end
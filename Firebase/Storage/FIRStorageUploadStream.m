@@ -0,0 +1,108 @@
+// Copyright 2019 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "FIRStorageUploadStream.h"
+
+#import <CommonCrypto/CommonDigest.h>
+
+#import "FIRStorageErrors.h"
+
+// Size of the reads from the input stream.
+static const NSUInteger kReadLength = 64 * 1024;
+
+@implementation FIRStorageUploadStream {
+  NSInputStream *_inputStream;
+  CC_MD5_CTX _MD5Context;
+  // The bytes read from the input stream but not yet dropped, starting at _bufferOffset.
+  NSMutableData *_buffer;
+  int64_t _bufferOffset;
+}
+
+- (instancetype)initWithInputStream:(NSInputStream *)inputStream {
+  self = [super init];
+  if (self) {
+    _inputStream = inputStream;
+    _buffer = [NSMutableData data];
+    CC_MD5_Init(&_MD5Context);
+  }
+  return self;
+}
+
+- (void)dealloc {
+  [self close];
+}
+
+- (nullable NSData *)dataAtOffset:(int64_t)offset
+                           length:(int64_t)length
+                            error:(NSError **)error {
+  if (offset < _bufferOffset || offset > _readLength) {
+    if (error) {
+      NSString *message =
+          [NSString stringWithFormat:@"Upload stream cannot rewind to offset %lld.", offset];
+      *error = [FIRStorageErrors errorWithCustomMessage:message];
+    }
+    return nil;
+  }
+
+  // The bytes before the offset have been committed, they are never asked for again.
+  NSUInteger committed = (NSUInteger)(offset - _bufferOffset);
+  [_buffer replaceBytesInRange:NSMakeRange(0, committed) withBytes:NULL length:0];
+  _bufferOffset = offset;
+
+  while ((int64_t)_buffer.length < length && !_atEnd) {
+    if (![self readWithError:error]) {
+      return nil;
+    }
+  }
+
+  NSUInteger returnedLength = (NSUInteger)MIN((int64_t)_buffer.length, length);
+  return [_buffer subdataWithRange:NSMakeRange(0, returnedLength)];
+}
+
+- (BOOL)readWithError:(NSError **)error {
+  if (_inputStream.streamStatus == NSStreamStatusNotOpen) {
+    [_inputStream open];
+  }
+
+  uint8_t bytes[kReadLength];
+  NSInteger readLength = [_inputStream read:bytes maxLength:kReadLength];
+  if (readLength < 0) {
+    if (error) {
+      *error = _inputStream.streamError
+                   ?: [FIRStorageErrors errorWithCustomMessage:@"Upload stream could not be read."];
+    }
+    return NO;
+  }
+
+  if (readLength == 0) {
+    _atEnd = YES;
+    unsigned char digest[CC_MD5_DIGEST_LENGTH];
+    CC_MD5_Final(digest, &_MD5Context);
+    _MD5Hash = [[NSData dataWithBytes:digest length:CC_MD5_DIGEST_LENGTH]
+        base64EncodedStringWithOptions:0];
+    [self close];
+    return YES;
+  }
+
+  CC_MD5_Update(&_MD5Context, bytes, (CC_LONG)readLength);
+  [_buffer appendBytes:bytes length:(NSUInteger)readLength];
+  _readLength += readLength;
+  return YES;
+}
+
+- (void)close {
+  [_inputStream close];
+}
+
+@end
@@ -17,12 +17,31 @@
 #import "FIRStorageConstants_Private.h"
 #import "FIRStorageMetadata_Private.h"
 #import "FIRStorageObservableTask_Private.h"
+#import "FIRStorageTaskScheduler.h"
 #import "FIRStorageTask_Private.h"
+#import "FIRStorageUploadStream.h"
 #import "FIRStorageUploadTask_Private.h"
 
 #import <GTMSessionFetcher/GTMSessionUploadFetcher.h>
 
-@implementation FIRStorageUploadTask
+// Uploads at least this large are sent in chunks sized from the measured throughput, smaller
+// ones in a single request.
+static const int64_t kFIRStorageAdaptiveChunkingThreshold = 32 * 1024 * 1024;
+// Minimum time between two throughput samples.
+static const NSTimeInterval kFIRStorageThroughputSampleInterval = 1;
+// Weight of the latest sample in the throughput estimate.
+static const double kFIRStorageThroughputSampleWeight = 0.3;
+
+@implementation FIRStorageUploadTask {
+  BOOL _adaptsChunkSize;
+  NSDate *_uploadStartDate;
+  NSTimeInterval _roundTripTime;
+  double _bytesPerSecond;
+  NSDate *_throughputSampleDate;
+  int64_t _throughputSampleBytes;
+  // Reads the chunks of a stream upload, which blocks until the stream produces them.
+  dispatch_queue_t _streamQueue;
+}
 
 @synthesize progress = _progress;
 @synthesize fetcherCompletion = _fetcherCompletion;
@@ -65,6 +84,26 @@
   return self;
 }
 
+- (instancetype)initWithReference:(FIRStorageReference *)reference
+                   fetcherService:(GTMSessionFetcherService *)service
+                    dispatchQueue:(dispatch_queue_t)queue
+                           stream:(NSInputStream *)inputStream
+                         metadata:(FIRStorageMetadata *)metadata {
+  self = [super initWithReference:reference fetcherService:service dispatchQueue:queue];
+  if (self) {
+    _uploadMetadata = [metadata copy];
+    _uploadStream = [[FIRStorageUploadStream alloc] initWithInputStream:inputStream];
+    _streamQueue = dispatch_queue_create("com.google.firebase.storage.upload-stream",
+                                         DISPATCH_QUEUE_SERIAL);
+    _progress = [NSProgress progressWithTotalUnitCount:-1];
+
+    if (!_uploadMetadata.contentType) {
+      _uploadMetadata.contentType = @"application/octet-stream";
+    }
+  }
+  return self;
+}
+
 - (void)dealloc {
   [_uploadFetcher stopFetching];
 }
@@ -110,10 +149,19 @@
     [components setPercentEncodedQuery:[FIRStorageUtils queryStringForDictionary:queryParams]];
     request.URL = components.URL;
 
+    // The standard chunk size sends everything in one request, which is fine for small uploads
+    // but makes a large one start over from its last committed byte after any failure, without
+    // bounding how much of it is kept in memory.
+    // The size of a stream is not known up front, and it must not be buffered whole.
+    strongSelf->_adaptsChunkSize = strongSelf->_uploadStream ||
+                                   [strongSelf uploadSize] >= kFIRStorageAdaptiveChunkingThreshold;
+    int64_t chunkSize = strongSelf->_adaptsChunkSize
+                            ? [FIRStorageUtils uploadChunkSizeForThroughput:0 roundTripTime:0]
+                            : kGTMSessionUploadFetcherStandardChunkSize;
     GTMSessionUploadFetcher *uploadFetcher =
         [GTMSessionUploadFetcher uploadFetcherWithRequest:request
                                            uploadMIMEType:strongSelf->_uploadMetadata.contentType
-                                                chunkSize:kGTMSessionUploadFetcherStandardChunkSize
+                                                chunkSize:chunkSize
                                            fetcherService:self.fetcherService];
 
     if (strongSelf->_uploadData) {
@@ -122,6 +170,25 @@
     } else if (strongSelf->_fileURL) {
       [uploadFetcher setUploadFileURL:strongSelf->_fileURL];
       uploadFetcher.comment = @"File UploadTask";
+    } else if (strongSelf->_uploadStream) {
+      FIRStorageUploadStream *uploadStream = strongSelf->_uploadStream;
+      dispatch_queue_t streamQueue = strongSelf->_streamQueue;
+      [uploadFetcher
+          setUploadDataLength:kGTMSessionUploadFetcherUnknownFileSize
+                     provider:^(int64_t offset, int64_t length,
+                                GTMSessionUploadFetcherDataProviderResponse response) {
+                       dispatch_async(streamQueue, ^{
+                         NSError *streamError;
+                         NSData *chunk = [uploadStream dataAtOffset:offset
+                                                             length:length
+                                                              error:&streamError];
+                         int64_t fullLength = uploadStream.atEnd
+                                                  ? uploadStream.readLength
+                                                  : kGTMSessionUploadFetcherUnknownFileSize;
+                         response(chunk, fullLength, streamError);
+                       });
+                     }];
+      uploadFetcher.comment = @"Stream UploadTask";
     }
 
     uploadFetcher.maxRetryInterval = self.reference.storage.maxUploadRetryTime;
@@ -134,13 +201,12 @@
       weakSelf.metadata = self->_uploadMetadata;
       [weakSelf fireHandlersForStatus:FIRStorageTaskStatusProgress snapshot:weakSelf.snapshot];
       weakSelf.state = FIRStorageTaskStateRunning;
+      [weakSelf transferDidMoveBytes:bytesSent];
+      [weakSelf updateChunkSizeWithTotalBytesSent:totalBytesSent];
     }];
 
     strongSelf->_uploadFetcher = uploadFetcher;
 
-    // Process fetches
-    strongSelf.state = FIRStorageTaskStateRunning;
-
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Warc-retain-cycles"
     strongSelf->_fetcherCompletion = ^(NSData *_Nullable data, NSError *_Nullable error) {
@@ -166,6 +232,14 @@
             [[FIRStorageMetadata alloc] initWithDictionary:responseDictionary];
         [metadata setType:FIRStorageMetadataTypeFile];
         self.metadata = metadata;
+
+        NSError *checksumError = [self checksumErrorForMetadata:metadata];
+        if (checksumError) {
+          self.state = FIRStorageTaskStateFailed;
+          self.error = checksumError;
+          [self finishTaskWithStatus:FIRStorageTaskStatusFailure snapshot:self.snapshot];
+          return;
+        }
       } else {
         self.error = [FIRStorageErrors errorWithInvalidRequest:data];
       }
@@ -174,18 +248,75 @@
     };
 #pragma clang diagnostic pop
 
-    [strongSelf->_uploadFetcher
-        beginFetchWithCompletionHandler:^(NSData *_Nullable data, NSError *_Nullable error) {
-          weakSelf.fetcherCompletion(data, error);
-        }];
+    // The upload starts once the other transfers leave it room.
+    [strongSelf.reference.storage.taskScheduler scheduleTask:strongSelf];
   }];
 }
 
+#pragma mark - FIRStorageScheduledTask
+
+- (void)startTransfer {
+  self.state = FIRStorageTaskStateRunning;
+  [self transferDidStart];
+  if (_uploadStartDate) {
+    // Time spent suspended says nothing about the throughput.
+    [self resetThroughputSample];
+    [self.uploadFetcher resumeFetching];
+    return;
+  }
+
+  _uploadStartDate = [NSDate date];
+  __weak FIRStorageUploadTask *weakSelf = self;
+  [self.uploadFetcher
+      beginFetchWithCompletionHandler:^(NSData *_Nullable data, NSError *_Nullable error) {
+        weakSelf.fetcherCompletion(data, error);
+      }];
+}
+
+- (void)suspendTransfer {
+  [self transferDidStop];
+  [self.uploadFetcher pauseFetching];
+  self.state = FIRStorageTaskStateQueueing;
+}
+
 - (void)finishTaskWithStatus:(FIRStorageTaskStatus)status
                     snapshot:(FIRStorageTaskSnapshot *)snapshot {
+  // Fetcher callbacks don't run on the dispatch queue.
+  [self dispatchAsync:^() {
+    [self releaseTransfer];
+  }];
   [self fireHandlersForStatus:status snapshot:self.snapshot];
   [self removeAllObservers];
   self->_fetcherCompletion = nil;
+
+  if (_uploadStream) {
+    FIRStorageUploadStream *uploadStream = _uploadStream;
+    dispatch_async(_streamQueue, ^{
+      [uploadStream close];
+    });
+  }
+}
+
+// Stream uploads are hashed as they are read, so that what the server stored can be checked
+// without reading the content again.
+- (nullable NSError *)checksumErrorForMetadata:(FIRStorageMetadata *)metadata {
+  if (!_uploadStream || !metadata.md5Hash) {
+    return nil;
+  }
+  __block NSString *clientChecksum;
+  dispatch_sync(_streamQueue, ^{
+    clientChecksum = self->_uploadStream.MD5Hash;
+  });
+  if ([clientChecksum isEqualToString:metadata.md5Hash]) {
+    return nil;
+  }
+  NSDictionary *infoDictionary = @{
+    @"object" : _uploadMetadata.path ?: @"",
+    @"clientChecksum" : clientChecksum ?: @"",
+    @"serverChecksum" : metadata.md5Hash,
+  };
+  return [FIRStorageErrors errorWithCode:FIRStorageErrorCodeNonMatchingChecksum
+                          infoDictionary:infoDictionary];
 }
 
 - (BOOL)isContentToUploadValid:(NSError **)outError {
@@ -193,6 +324,10 @@
     return YES;
   }
 
+  if (_uploadStream != nil) {
+    return YES;
+  }
+
   NSError *fileReachabilityError;
   if (![_fileURL checkResourceIsReachableAndReturnError:&fileReachabilityError]) {
     if (outError != NULL) {
@@ -215,6 +350,53 @@
   return YES;
 }
 
+- (int64_t)uploadSize {
+  if (_uploadData) {
+    return (int64_t)_uploadData.length;
+  }
+  NSNumber *fileSize;
+  [_fileURL getResourceValue:&fileSize forKey:NSURLFileSizeKey error:NULL];
+  return fileSize.longLongValue;
+}
+
+- (void)resetThroughputSample {
+  _throughputSampleDate = nil;
+}
+
+- (void)updateChunkSizeWithTotalBytesSent:(int64_t)totalBytesSent {
+  if (!_adaptsChunkSize) {
+    return;
+  }
+
+  NSDate *now = [NSDate date];
+  if (!_throughputSampleDate) {
+    // The first bytes are sent once the upload session has been created, which takes a round trip.
+    if (_roundTripTime == 0 && _uploadStartDate) {
+      _roundTripTime = [now timeIntervalSinceDate:_uploadStartDate];
+    }
+    _throughputSampleDate = now;
+    _throughputSampleBytes = totalBytesSent;
+    return;
+  }
+
+  NSTimeInterval elapsed = [now timeIntervalSinceDate:_throughputSampleDate];
+  if (elapsed < kFIRStorageThroughputSampleInterval || totalBytesSent < _throughputSampleBytes) {
+    return;
+  }
+  double sample = (totalBytesSent - _throughputSampleBytes) / elapsed;
+  if (_bytesPerSecond == 0) {
+    _bytesPerSecond = sample;
+  } else {
+    _bytesPerSecond += kFIRStorageThroughputSampleWeight * (sample - _bytesPerSecond);
+  }
+  _throughputSampleDate = now;
+  _throughputSampleBytes = totalBytesSent;
+
+  // Takes effect from the next chunk on.
+  self.uploadFetcher.chunkSize = [FIRStorageUtils uploadChunkSizeForThroughput:_bytesPerSecond
+                                                                 roundTripTime:_roundTripTime];
+}
+
 #pragma mark - Upload Management
 
 - (void)cancel {
@@ -223,6 +405,7 @@
   [self dispatchAsync:^() {
     weakSelf.state = FIRStorageTaskStateCancelled;
     [weakSelf.uploadFetcher stopFetching];
+    [weakSelf releaseTransfer];
     if (weakSelf.state != FIRStorageTaskStateSuccess) {
       weakSelf.metadata = weakSelf.uploadMetadata;
     }
@@ -235,8 +418,12 @@
   __weak FIRStorageUploadTask *weakSelf = self;
 
   [self dispatchAsync:^() {
+    FIRStorageUploadTask *strongSelf = weakSelf;
+    if (strongSelf && strongSelf->_uploadStartDate) {
+      [strongSelf.uploadFetcher pauseFetching];
+    }
     weakSelf.state = FIRStorageTaskStatePaused;
-    [weakSelf.uploadFetcher pauseFetching];
+    [weakSelf releaseTransfer];
     if (weakSelf.state != FIRStorageTaskStateSuccess) {
       weakSelf.metadata = weakSelf.uploadMetadata;
     }
@@ -249,12 +436,15 @@
 
   [self dispatchAsync:^() {
     weakSelf.state = FIRStorageTaskStateResuming;
-    [weakSelf.uploadFetcher resumeFetching];
     if (weakSelf.state != FIRStorageTaskStateSuccess) {
       weakSelf.metadata = weakSelf.uploadMetadata;
     }
     [weakSelf fireHandlersForStatus:FIRStorageTaskStatusResume snapshot:weakSelf.snapshot];
-    weakSelf.state = FIRStorageTaskStateRunning;
+    // The fetch continues once the other transfers leave it room.
+    FIRStorageTaskScheduler *scheduler = weakSelf.reference.storage.taskScheduler;
+    weakSelf.state = [scheduler isTaskRunning:weakSelf] ? FIRStorageTaskStateRunning
+                                                        : FIRStorageTaskStateQueueing;
+    [scheduler scheduleTask:weakSelf];
   }];
 }
 
@@ -33,6 +33,16 @@
 NSString *const kGCSObjectAllowedCharacterSet =
     @"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-._~!$'()*,=:@";
 
+// GCS requires every chunk of a resumable upload but the last to be a multiple of 256 KiB.
+static const int64_t kUploadChunkGranularity = 256 * 1024;
+static const int64_t kUploadInitialChunkSize = 8 * 1024 * 1024;
+static const int64_t kUploadMinChunkSize = 1024 * 1024;
+// Chunks are held in memory while they are sent.
+static const int64_t kUploadMaxChunkSize = 64 * 1024 * 1024;
+static const NSTimeInterval kUploadMinChunkDuration = 5;
+// Sending a chunk takes this many round trips, so waiting for its response costs at most 2%.
+static const double kUploadChunkRoundTrips = 50;
+
 @implementation FIRStorageUtils
 
 + (nullable NSString *)GCSEscapedString:(NSString *)string {
@@ -100,6 +110,19 @@ NSString *const kGCSObjectAllowedCharacterSet =
   return [@"/" stringByAppendingString:[kFIRStorageVersionPath stringByAppendingString:urlPath]];
 }
 
++ (int64_t)uploadChunkSizeForThroughput:(double)bytesPerSecond
+                          roundTripTime:(NSTimeInterval)roundTripTime {
+  if (bytesPerSecond <= 0) {
+    return kUploadInitialChunkSize;
+  }
+
+  NSTimeInterval chunkDuration =
+      MAX(kUploadMinChunkDuration, kUploadChunkRoundTrips * roundTripTime);
+  double chunkSize = MIN(bytesPerSecond * chunkDuration, (double)kUploadMaxChunkSize);
+  chunkSize = MAX(chunkSize, (double)kUploadMinChunkSize);
+  return (int64_t)chunkSize / kUploadChunkGranularity * kUploadChunkGranularity;
+}
+
 @end
 
 @implementation NSDictionary (FIRStorageNSDictionaryJSONHelpers)
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class FIRStoragePath;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * FIRStorageDownloadCache keeps the most recently downloaded objects on disk, together with the
+ * ETag and generation they were sent with, so that downloading them again only needs a
+ * conditional request answered with 304 Not Modified when they did not change.
+ *
+ * Objects which are not used are evicted first once the cache grows past its maximum size.
+ * Safe to use from any thread.
+ */
+@interface FIRStorageDownloadCache : NSObject
+
+/**
+ * The maximum size of the cached objects in bytes. Lowering it evicts objects right away.
+ */
+@property(atomic) int64_t maxSize;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Creates a cache of the objects stored in a directory, which is created if needed.
+ * @param directoryURL The directory to keep the cached objects in.
+ * @param maxSize The maximum size of the cached objects in bytes.
+ */
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL
+                             maxSize:(int64_t)maxSize NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Returns the ETag of the cached copy of an object, to revalidate it with If-None-Match.
+ * @return The ETag, or nil if the object is not cached.
+ */
+- (nullable NSString *)entityTagForPath:(FIRStoragePath *)path;
+
+/**
+ * Returns the generation of the cached copy of an object, if the server sent one.
+ */
+- (nullable NSString *)generationForPath:(FIRStoragePath *)path;
+
+/**
+ * Returns the file holding the cached copy of an object, and marks the object as recently used.
+ */
+- (nullable NSURL *)fileURLForPath:(FIRStoragePath *)path;
+
+/**
+ * Returns the cached copy of an object, and marks the object as recently used.
+ */
+- (nullable NSData *)dataForPath:(FIRStoragePath *)path;
+
+/**
+ * Caches an object from the response it was downloaded with. Objects sent without an ETag, or
+ * larger than the cache, are not cached.
+ */
+- (void)storeData:(NSData *)data
+          forPath:(FIRStoragePath *)path
+        entityTag:(nullable NSString *)entityTag
+       generation:(nullable NSString *)generation;
+
+/**
+ * Caches a copy of a downloaded file. Objects sent without an ETag, or larger than the cache, are
+ * not cached.
+ */
+- (void)storeFileAtURL:(NSURL *)fileURL
+               forPath:(FIRStoragePath *)path
+             entityTag:(nullable NSString *)entityTag
+            generation:(nullable NSString *)generation;
+
+/**
+ * Removes the cached copy of an object, if any.
+ */
+- (void)removeObjectForPath:(FIRStoragePath *)path;
+
+/**
+ * Removes all of the cached objects.
+ */
+- (void)removeAllObjects;
+
+/**
+ * The total size of the cached objects in bytes.
+ */
+- (int64_t)totalSize;
+
+@end
+
+NS_ASSUME_NONNULL_END
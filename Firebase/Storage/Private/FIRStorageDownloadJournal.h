@@ -0,0 +1,120 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * FIRStorageDownloadJournal records which segments of a file download have been written to its
+ * partial file, so that a download interrupted by a failure, a pause or the app being terminated
+ * continues from the segments it already has.
+ *
+ * The partial file and the journal live next to the destination file until the download completes.
+ */
+@interface FIRStorageDownloadJournal : NSObject
+
+/**
+ * The file the object is downloaded into until all of its segments have been written.
+ */
+@property(readonly, copy, nonatomic) NSURL *partialFileURL;
+
+/**
+ * The size of the downloaded object in bytes.
+ */
+@property(readonly, nonatomic) int64_t totalLength;
+
+/**
+ * The size of every segment in bytes, except for the last one which may be shorter.
+ */
+@property(readonly, nonatomic) int64_t segmentLength;
+
+/**
+ * The ETag of the object when the download started, or nil if the server did not send one.
+ * Sent as If-Range so that a changed object is downloaded again from the start.
+ */
+@property(readonly, copy, nonatomic, nullable) NSString *entityTag;
+
+/**
+ * The number of segments of the object.
+ */
+@property(readonly, nonatomic) NSUInteger segmentCount;
+
+/**
+ * The number of bytes in completed segments.
+ */
+@property(readonly, nonatomic) int64_t completedLength;
+
+/**
+ * Whether all of the segments have been completed.
+ */
+@property(readonly, nonatomic, getter=isComplete) BOOL complete;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Creates a journal with no completed segments for a download into fileURL.
+ * @param fileURL The destination of the download.
+ * @param totalLength The size of the downloaded object.
+ * @param segmentLength The size of the segments the object is downloaded in.
+ * @param entityTag The ETag of the object, if any.
+ */
+- (instancetype)initWithFileURL:(NSURL *)fileURL
+                    totalLength:(int64_t)totalLength
+                  segmentLength:(int64_t)segmentLength
+                      entityTag:(nullable NSString *)entityTag NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Loads the journal of an earlier download into fileURL.
+ * @return The journal, or nil if there is none or it does not match its partial file.
+ */
++ (nullable instancetype)journalForFileURL:(NSURL *)fileURL;
+
+/**
+ * Returns the offset of the first byte of a segment in the object.
+ */
+- (int64_t)offsetOfSegment:(NSUInteger)segment;
+
+/**
+ * Returns the size of a segment, taking into account that the last one may be shorter.
+ */
+- (int64_t)lengthOfSegment:(NSUInteger)segment;
+
+/**
+ * Returns whether a segment has been written to the partial file.
+ */
+- (BOOL)isSegmentCompleted:(NSUInteger)segment;
+
+/**
+ * Records that a segment has been written to the partial file and saves the journal.
+ * @return NO if the journal could not be saved, in which case the segment is downloaded again
+ * by the next attempt.
+ */
+- (BOOL)markSegmentCompleted:(NSUInteger)segment error:(NSError **)error;
+
+/**
+ * Saves the journal next to the partial file.
+ */
+- (BOOL)save:(NSError **)error;
+
+/**
+ * Deletes the journal and, if removePartialFile is YES, the partial file.
+ */
+- (void)removeWithPartialFile:(BOOL)removePartialFile;
+
+@end
+
+NS_ASSUME_NONNULL_END
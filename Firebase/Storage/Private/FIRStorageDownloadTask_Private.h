@@ -17,13 +17,14 @@
 #import <Foundation/Foundation.h>
 
 #import "FIRStorageDownloadTask.h"
+#import "FIRStorageTaskScheduler.h"
 
 @class FIRStorageReference;
 @class GTMSessionFetcherService;
 
 NS_ASSUME_NONNULL_BEGIN
 
-@interface FIRStorageDownloadTask ()
+@interface FIRStorageDownloadTask () <FIRStorageScheduledTask>
 
 /**
  * Bytes which have been downloaded so far.
@@ -46,6 +46,12 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)fireHandlersForStatus:(FIRStorageTaskStatus)status
                      snapshot:(FIRStorageTaskSnapshot *)snapshot;
 
+/**
+ * Gives the place of a transfer to the other tasks of the FIRStorage instance once it finishes,
+ * fails, is cancelled or is paused. Must be called on the dispatch queue.
+ */
+- (void)releaseTransfer;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "FIRStorageConstants.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A transfer whose fetches are started and suspended by a FIRStorageTaskScheduler.
+ */
+@protocol FIRStorageScheduledTask <NSObject>
+
+@property(readonly) FIRStorageTaskPriority priority;
+
+/**
+ * Starts the transfer, or continues it after -suspendTransfer.
+ */
+- (void)startTransfer;
+
+/**
+ * Stops the transfer, so that a later -startTransfer continues it. Unlike a pause, this isn't
+ * reported to the task's observers.
+ */
+- (void)suspendTransfer;
+
+@end
+
+/**
+ * Decides which of the uploads and downloads of a FIRStorage instance transfer at any time.
+ *
+ * At most maxConcurrentTransfers tasks run at once. Higher priority tasks run first, and tasks of
+ * the same priority run in the order they were scheduled. A task that is scheduled when all the
+ * transfers are taken suspends the most recently scheduled running task of a lower priority, if
+ * any. Low priority tasks are also suspended as long as a high priority task is scheduled, so
+ * that they don't take bandwidth from it. Suspended tasks are started again, ahead of the tasks
+ * scheduled after them, once they can run.
+ *
+ * Must only be used on the dispatch queue of the FIRStorage instance that owns it.
+ */
+@interface FIRStorageTaskScheduler : NSObject
+
+/**
+ * The maximum number of tasks that transfer at once. Must be at least 1.
+ */
+@property(nonatomic) NSUInteger maxConcurrentTransfers;
+
+/**
+ * The number of tasks currently transferring.
+ */
+@property(nonatomic, readonly) NSUInteger runningTaskCount;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+- (instancetype)initWithMaxConcurrentTransfers:(NSUInteger)maxConcurrentTransfers
+    NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Adds a task that is ready to transfer, after it is enqueued or resumed. The task is started
+ * right away if it can run, or later otherwise.
+ */
+- (void)scheduleTask:(id<FIRStorageScheduledTask>)task;
+
+/**
+ * Removes a task that finished, failed, was cancelled or was paused, and starts the tasks that
+ * can run in its place. Does nothing if the task isn't scheduled.
+ */
+- (void)removeTask:(id<FIRStorageScheduledTask>)task;
+
+/**
+ * Starts and suspends tasks after the priority of a scheduled task changed.
+ */
+- (void)taskDidChangePriority:(id<FIRStorageScheduledTask>)task;
+
+/**
+ * Whether the task is currently transferring.
+ */
+- (BOOL)isTaskRunning:(id<FIRStorageScheduledTask>)task;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -33,6 +33,7 @@ NS_ASSUME_NONNULL_BEGIN
 @property(readwrite, copy, nonatomic) FIRStorageReference *reference;
 @property(readwrite, strong, nonatomic) NSProgress *progress;
 @property(readwrite, copy, nonatomic) NSError *error;
+@property(readwrite, nonatomic) double bytesPerSecond;
 
 /**
  * Creates a new task snapshot from the given properties.
@@ -86,6 +86,22 @@ NS_ASSUME_NONNULL_BEGIN
 /** Dispatches a block on the shared Storage queue. */
 - (void)dispatchAsync:(void (^)(void))block;
 
+/**
+ * Starts counting time towards the throughput reported in snapshots, when a transfer starts or
+ * continues.
+ */
+- (void)transferDidStart;
+
+/**
+ * Stops counting time towards the throughput, when a transfer is paused, suspended or finishes.
+ */
+- (void)transferDidStop;
+
+/**
+ * Counts bytes sent or received towards the throughput.
+ */
+- (void)transferDidMoveBytes:(int64_t)bytes;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * FIRStorageUploadStream serves the chunks of a resumable upload from an NSInputStream, so that
+ * content which is generated as it is uploaded never has to be held in memory as a whole.
+ *
+ * Only the bytes from the oldest requested offset on are kept, so that a chunk can be sent again
+ * after a failure. The MD5 hash of the content is computed as it is read.
+ * Not thread safe: the stream is read synchronously by the caller.
+ */
+@interface FIRStorageUploadStream : NSObject
+
+/**
+ * The number of bytes read from the input stream so far: the length of the content once atEnd.
+ */
+@property(readonly, nonatomic) int64_t readLength;
+
+/**
+ * Whether the whole input stream has been read.
+ */
+@property(readonly, nonatomic) BOOL atEnd;
+
+/**
+ * The base64 encoded MD5 hash of the content, in the format of FIRStorageMetadata's md5Hash.
+ * Nil until atEnd.
+ */
+@property(readonly, copy, nonatomic, nullable) NSString *MD5Hash;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ * Creates an upload stream reading from an input stream, which is opened on the first read.
+ */
+- (instancetype)initWithInputStream:(NSInputStream *)inputStream NS_DESIGNATED_INITIALIZER;
+
+/**
+ * Returns the bytes of the content from an offset, reading from the input stream as needed.
+ * Bytes before the offset are dropped, so a later call cannot ask for them.
+ * @param offset The offset of the first byte, no lower than the offset of an earlier call.
+ * @param length The maximum number of bytes to return. Fewer are returned at the end.
+ * @param error Set if the input stream failed or the offset was dropped already.
+ * @return The bytes, or nil on error.
+ */
+- (nullable NSData *)dataAtOffset:(int64_t)offset
+                           length:(int64_t)length
+                            error:(NSError **)error;
+
+/**
+ * Closes the input stream.
+ */
+- (void)close;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -14,11 +14,14 @@
  * limitations under the License.
  */
 
+#import "FIRStorageTaskScheduler.h"
+
+@class FIRStorageUploadStream;
 @class GTMSessionUploadFetcher;
 
 NS_ASSUME_NONNULL_BEGIN
 
-@interface FIRStorageUploadTask ()
+@interface FIRStorageUploadTask () <FIRStorageScheduledTask>
 
 /**
  * The data to be uploaded (if uploading bytes).
@@ -30,6 +33,11 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(readonly, copy, nonatomic, nullable) NSURL *fileURL;
 
+/**
+ * The stream to be uploaded (if uploading from a stream).
+ */
+@property(readonly, strong, nonatomic, nullable) FIRStorageUploadStream *uploadStream;
+
 /**
  * The FIRStorageMetadata about the object being uploaded.
  */
@@ -68,6 +76,20 @@ NS_ASSUME_NONNULL_BEGIN
                              file:(NSURL *)fileURL
                          metadata:(FIRStorageMetadata *)metadata;
 
+/**
+ * Initializes an upload task with a base FIRStorageReference and GTMSessionFetcherService.
+ * @param reference The base FIRStorageReference which fetchers use for configuration.
+ * @param service The GTMSessionFetcherService which will create fetchers.
+ * @param queue The shared queue to use for all Storage operations.
+ * @param inputStream The unopened stream to upload the content of.
+ * @return Returns an instance of FIRStorageUploadTask.
+ */
+- (instancetype)initWithReference:(FIRStorageReference *)reference
+                   fetcherService:(GTMSessionFetcherService *)service
+                    dispatchQueue:(dispatch_queue_t)queue
+                           stream:(NSInputStream *)inputStream
+                         metadata:(FIRStorageMetadata *)metadata;
+
 @end
 
 NS_ASSUME_NONNULL_END
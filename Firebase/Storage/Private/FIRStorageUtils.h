@@ -66,6 +66,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (NSString *)encodedURLForPath:(FIRStoragePath *)path;
 
+/**
+ * Returns the size of the next chunk of a chunked upload, so that sending it takes long enough
+ * for the round trip that follows each chunk to be small in comparison.
+ * @param bytesPerSecond The measured upload throughput, or 0 if it is not known yet.
+ * @param roundTripTime The measured time for a request to the server to be answered.
+ * @return A chunk size in bytes that is a multiple of 256 KiB, as required by GCS.
+ */
++ (int64_t)uploadChunkSizeForThroughput:(double)bytesPerSecond
+                          roundTripTime:(NSTimeInterval)roundTripTime;
+
 @end
 
 @interface NSDictionary (FIRStorageNSDictionaryJSONHelpers)
@@ -15,6 +15,8 @@
  */
 
 @class FIRApp;
+@class FIRStorageDownloadCache;
+@class FIRStorageTaskScheduler;
 @class GTMSessionFetcherService;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -29,6 +31,16 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(strong, nonatomic) NSString *storageBucket;
 
+/**
+ * The cache of downloaded objects, or nil if maxDownloadCacheSize is 0.
+ */
+@property(strong, atomic, readonly, nullable) FIRStorageDownloadCache *downloadCache;
+
+/**
+ * Decides which uploads and downloads transfer. Only used on the dispatch queue.
+ */
+@property(strong, nonatomic, readonly) FIRStorageTaskScheduler *taskScheduler;
+
 /**
  * Enables/disables GTMSessionFetcher HTTP logging
  * @param isLoggingEnabled Boolean passed through to enable/disable GTMSessionFetcher logging
@@ -92,6 +92,20 @@ NS_SWIFT_NAME(Storage)
  */
 @property NSTimeInterval maxOperationRetryTime;
 
+/**
+ * Maximum size in bytes of the on-disk cache of downloaded objects. Downloading a cached object
+ * again only asks the server whether it changed and transfers it again if it did.
+ * Defaults to 0, which disables the cache.
+ */
+@property int64_t maxDownloadCacheSize;
+
+/**
+ * Maximum number of uploads and downloads that transfer at the same time. Tasks started beyond it
+ * wait for a running one to finish or pause, higher FIRStorageTaskPriority tasks first.
+ * Defaults to 4. Values below 1 are treated as 1.
+ */
+@property NSInteger maxConcurrentTransfers;
+
 /**
  * Queue that all developer callbacks are fired on. Defaults to the main queue.
  */
@@ -109,6 +109,27 @@ typedef NS_ENUM(NSInteger, FIRStorageTaskStatus) {
   FIRStorageTaskStatusFailure
 } NS_SWIFT_NAME(StorageTaskStatus);
 
+/**
+ * Enum representing the priority of an upload or download task, which decides which transfers
+ * FIRStorage runs first when more are started than FIRStorage#maxConcurrentTransfers.
+ */
+typedef NS_ENUM(NSInteger, FIRStorageTaskPriority) {
+  /**
+   * Task only runs while no high priority task is waiting or running.
+   */
+  FIRStorageTaskPriorityLow = -1,
+
+  /**
+   * Default task priority.
+   */
+  FIRStorageTaskPriorityDefault = 0,
+
+  /**
+   * Task runs before all other tasks, pausing them if needed.
+   */
+  FIRStorageTaskPriorityHigh = 1
+} NS_SWIFT_NAME(StorageTaskPriority);
+
 /**
  * Firebase Storage error domain.
  */
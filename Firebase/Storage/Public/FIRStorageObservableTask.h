@@ -30,6 +30,13 @@ NS_ASSUME_NONNULL_BEGIN
 NS_SWIFT_NAME(StorageObservableTask)
 @interface FIRStorageObservableTask : FIRStorageTask
 
+/**
+ * The priority of the transfer, relative to the other uploads and downloads of the same
+ * FIRStorage instance. Can be changed while the task is running.
+ * Defaults to FIRStorageTaskPriorityDefault.
+ */
+@property FIRStorageTaskPriority priority;
+
 /**
  * Observes changes in the upload status: Resume, Pause, Progress, Success, and Failure.
  * @param status The FIRStorageTaskStatus change to observe.
@@ -171,6 +171,27 @@ NS_SWIFT_NAME(putData(_:metadata:));
            NS_SWIFT_NAME(putFile(from:metadata:completion:));
 // clang-format on
 
+/**
+ * Asynchronously uploads the content of a stream to the currently specified FIRStorageReference,
+ * such as media being recorded or an archive being written. The stream is read in chunks as they
+ * are uploaded, so the content is never held in memory as a whole, and the MD5 hash of the uploaded
+ * content is checked against the one computed by the server.
+ * @param inputStream An unopened NSInputStream providing the content to upload. It is read on a
+ * background queue and closed when the upload ends.
+ * @param metadata FIRStorageMetadata containing additional information (MIME type, etc.)
+ * about the object being uploaded.
+ * @param completion A completion block that either returns the object metadata on success,
+ * or an error on failure.
+ * @return An instance of FIRStorageUploadTask, which can be used to monitor or manage the upload.
+ */
+// clang-format off
+- (FIRStorageUploadTask *)putStream:(NSInputStream *)inputStream
+                           metadata:(nullable FIRStorageMetadata *)metadata
+                         completion:(nullable void (^)(FIRStorageMetadata *_Nullable metadata,
+                                                       NSError *_Nullable error))completion
+           NS_SWIFT_NAME(putStream(_:metadata:completion:));
+// clang-format on
+
 #pragma mark - Downloads
 
 /**
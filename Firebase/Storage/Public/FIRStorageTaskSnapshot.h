@@ -62,6 +62,13 @@ NS_SWIFT_NAME(StorageTaskSnapshot)
  */
 @property(readonly, nonatomic) FIRStorageTaskStatus status;
 
+/**
+ * Average number of bytes an upload or download transferred per second while it was running, not
+ * counting the time it was paused or waiting for other transfers. 0 for other tasks, or before any
+ * bytes were transferred.
+ */
+@property(readonly, nonatomic) double bytesPerSecond;
+
 @end
 
 NS_ASSUME_NONNULL_END
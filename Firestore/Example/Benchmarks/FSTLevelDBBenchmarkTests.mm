@@ -29,9 +29,11 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/util/string_format.h"
+#include "Firestore/core/test/firebase/firestore/benchmarks/allocation_reporter.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+using firebase::firestore::benchmarks::AllocationReporter;
 using firebase::firestore::local::LevelDbRemoteDocumentKey;
 using firebase::firestore::local::LevelDbTargetDocumentKey;
 using firebase::firestore::local::LevelDbTransaction;
@@ -136,6 +138,7 @@ BENCHMARK_DEFINE_F(LevelDBFixture, RemoteEvent)(benchmark::State &state) {
   int64_t documentSize = state.range(1);
   int64_t docsToUpdate = state.range(2);
   std::string documentUpdate = UpdatedDocumentData(documentSize);
+  AllocationReporter allocations{state};
   for (const auto &_ : state) {
     LevelDbTransaction txn(db_.ptr, "benchmark");
     for (int i = 0; i < docsToUpdate; i++) {
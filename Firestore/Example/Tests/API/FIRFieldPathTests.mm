@@ -44,6 +44,18 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertNotEqual([foo hash], [bar hash]);
 }
 
+- (void)testDotSeparatedStringsAreParsedOnce {
+  FIRFieldPath *first = [FIRFieldPath pathWithDotSeparatedString:@"foo.bar"];
+  FIRFieldPath *second =
+      [FIRFieldPath pathWithDotSeparatedString:[NSMutableString stringWithString:@"foo.bar"]];
+  XCTAssertEqual(first, second);
+  XCTAssertTrue(first.internalValue == testutil::Field("foo.bar"));
+
+  // Invalid paths are not cached and keep throwing.
+  XCTAssertThrows([FIRFieldPath pathWithDotSeparatedString:@"foo..bar"]);
+  XCTAssertThrows([FIRFieldPath pathWithDotSeparatedString:@"foo..bar"]);
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
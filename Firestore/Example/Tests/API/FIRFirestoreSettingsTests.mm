@@ -0,0 +1,179 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <FirebaseFirestore/FIRFirestoreSettings.h>
+
+#import <XCTest/XCTest.h>
+
+#import "Firestore/Source/API/FIRFirestoreSettings+Internal.h"
+
+#include "Firestore/core/src/firebase/firestore/api/settings.h"
+
+namespace api = firebase::firestore::api;
+
+using api::PersistenceSettings;
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void (^FSTSettingsChange)(FIRFirestoreSettings *settings);
+
+@interface FIRFirestoreSettingsTests : XCTestCase
+@end
+
+@implementation FIRFirestoreSettingsTests
+
+/** Changes that each set one persistence setting to something other than its default. */
+- (NSArray<FSTSettingsChange> *)persistenceChanges {
+  return @[
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceBlockCacheSizeBytes = 1024;
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceWriteBufferSizeBytes = 1024;
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceCompressionEnabled = NO;
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceBloomFilterBitsPerKey = 0;
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceChecksumVerificationEnabled = NO;
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceNativeSerializationEnabled = YES;
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceRemoteDocumentBatchSize = 100;
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceBackgroundMigrationsEnabled = YES;
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceWarmSnapshotTargetCount = 5;
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceCompactTargetDocumentsEnabled = YES;
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceValueCompressionEnabled = YES;
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceSyncWritesEnabled = YES;
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceSyncIntervalMs = 50;
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceGroupCommitDelayMs = 5;
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceExportDirectory = @"/tmp/firestore-export";
+    },
+    ^(FIRFirestoreSettings *settings) {
+      settings.persistenceExportReadOnly = YES;
+    },
+  ];
+}
+
+- (void)testPersistenceDefaults {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertEqual(settings.persistenceBlockCacheSizeBytes,
+                 PersistenceSettings::DefaultBlockCacheSizeBytes);
+  XCTAssertEqual(settings.persistenceWriteBufferSizeBytes,
+                 PersistenceSettings::DefaultWriteBufferSizeBytes);
+  XCTAssertEqual(settings.isPersistenceCompressionEnabled,
+                 PersistenceSettings::DefaultCompressionEnabled);
+  XCTAssertEqual(settings.persistenceBloomFilterBitsPerKey,
+                 PersistenceSettings::DefaultBloomFilterBitsPerKey);
+  XCTAssertEqual(settings.isPersistenceChecksumVerificationEnabled,
+                 PersistenceSettings::DefaultVerifyChecksums);
+  XCTAssertEqual(settings.isPersistenceNativeSerializationEnabled,
+                 PersistenceSettings::DefaultNativeSerializationEnabled);
+  XCTAssertEqual(settings.persistenceRemoteDocumentBatchSize,
+                 PersistenceSettings::DefaultRemoteDocumentBatchSize);
+  XCTAssertEqual(settings.isPersistenceBackgroundMigrationsEnabled,
+                 PersistenceSettings::DefaultBackgroundMigrationsEnabled);
+  XCTAssertEqual(settings.persistenceWarmSnapshotTargetCount,
+                 PersistenceSettings::DefaultWarmSnapshotTargetCount);
+  XCTAssertEqual(settings.isPersistenceCompactTargetDocumentsEnabled,
+                 PersistenceSettings::DefaultCompactTargetDocumentsEnabled);
+  XCTAssertEqual(settings.isPersistenceValueCompressionEnabled,
+                 PersistenceSettings::DefaultValueCompressionEnabled);
+  XCTAssertEqual(settings.isPersistenceSyncWritesEnabled, PersistenceSettings::DefaultSyncWrites);
+  XCTAssertEqual(settings.persistenceSyncIntervalMs, PersistenceSettings::DefaultSyncIntervalMs);
+  XCTAssertEqual(settings.persistenceGroupCommitDelayMs,
+                 PersistenceSettings::DefaultGroupCommitDelayMs);
+  XCTAssertNil(settings.persistenceExportDirectory);
+  XCTAssertEqual(settings.isPersistenceExportReadOnly, PersistenceSettings::DefaultExportReadOnly);
+
+  XCTAssertTrue([settings internalSettings].persistence_settings() == PersistenceSettings());
+}
+
+- (void)testPersistenceSettingsAreCopied {
+  NSArray<FSTSettingsChange> *changes = [self persistenceChanges];
+  for (NSUInteger i = 0; i < changes.count; i++) {
+    FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+    changes[i](settings);
+    FIRFirestoreSettings *copy = [settings copy];
+
+    XCTAssertEqualObjects(copy, settings, @"change %lu", (unsigned long)i);
+    XCTAssertEqual([copy hash], [settings hash], @"change %lu", (unsigned long)i);
+    XCTAssertTrue([copy internalSettings] == [settings internalSettings], @"change %lu",
+                  (unsigned long)i);
+  }
+}
+
+- (void)testPersistenceSettingsArePartOfEquality {
+  FIRFirestoreSettings *defaults = [[FIRFirestoreSettings alloc] init];
+  api::Settings defaultInternalSettings = [defaults internalSettings];
+
+  NSArray<FSTSettingsChange> *changes = [self persistenceChanges];
+  for (NSUInteger i = 0; i < changes.count; i++) {
+    FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+    changes[i](settings);
+    FIRFirestoreSettings *same = [[FIRFirestoreSettings alloc] init];
+    changes[i](same);
+
+    XCTAssertEqualObjects(settings, same, @"change %lu", (unsigned long)i);
+    XCTAssertEqual([settings hash], [same hash], @"change %lu", (unsigned long)i);
+    XCTAssertNotEqualObjects(settings, defaults, @"change %lu", (unsigned long)i);
+    XCTAssertNotEqual([settings hash], [defaults hash], @"change %lu", (unsigned long)i);
+
+    api::Settings internalSettings = [settings internalSettings];
+    XCTAssertFalse(internalSettings == defaultInternalSettings, @"change %lu", (unsigned long)i);
+    XCTAssertFalse(internalSettings.persistence_settings() ==
+                       defaultInternalSettings.persistence_settings(),
+                   @"change %lu", (unsigned long)i);
+    XCTAssertNotEqual(internalSettings.persistence_settings().Hash(),
+                      defaultInternalSettings.persistence_settings().Hash(), @"change %lu",
+                      (unsigned long)i);
+  }
+}
+
+- (void)testPersistenceSettingsValidation {
+  FIRFirestoreSettings *settings = [[FIRFirestoreSettings alloc] init];
+  XCTAssertThrows(settings.persistenceBlockCacheSizeBytes = -1);
+  XCTAssertThrows(settings.persistenceWriteBufferSizeBytes = 0);
+  XCTAssertThrows(settings.persistenceBloomFilterBitsPerKey = -1);
+
+  settings.persistenceBlockCacheSizeBytes = 0;
+  XCTAssertEqual(settings.persistenceBlockCacheSizeBytes, 0);
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
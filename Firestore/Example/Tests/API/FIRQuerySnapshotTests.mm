@@ -124,6 +124,38 @@ NS_ASSUME_NONNULL_BEGIN
   ];
   XCTAssertEqualObjects([snapshot documentChangesWithIncludeMetadataChanges:YES],
                         changesWithMetadata);
+
+  NSMutableArray<FIRDocumentChange *> *enumerated = [NSMutableArray array];
+  [snapshot enumerateDocumentChangesWithIncludeMetadataChanges:YES
+                                                    usingBlock:^(FIRDocumentChange *change,
+                                                                 BOOL *stop) {
+                                                      [enumerated addObject:change];
+                                                    }];
+  XCTAssertEqualObjects(enumerated, changesWithMetadata);
+}
+
+- (void)testEnumerateDocuments {
+  FIRQuerySnapshot *snapshot = FSTTestQuerySnapshot(
+      "foo", @{}, @{@"a" : @{@"a" : @1}, @"b" : @{@"b" : @2}, @"c" : @{@"c" : @3}}, false, false);
+
+  NSMutableArray<FIRQueryDocumentSnapshot *> *enumerated = [NSMutableArray array];
+  [snapshot enumerateDocumentsUsingBlock:^(FIRQueryDocumentSnapshot *document, NSUInteger idx,
+                                           BOOL *stop) {
+    XCTAssertEqual(idx, enumerated.count);
+    [enumerated addObject:document];
+  }];
+  XCTAssertEqualObjects(enumerated, snapshot.documents);
+
+  // A new snapshot, so that the documents aren't cached yet.
+  snapshot = FSTTestQuerySnapshot(
+      "foo", @{}, @{@"a" : @{@"a" : @1}, @"b" : @{@"b" : @2}, @"c" : @{@"c" : @3}}, false, false);
+  NSMutableArray<NSString *> *visited = [NSMutableArray array];
+  [snapshot enumerateDocumentsUsingBlock:^(FIRQueryDocumentSnapshot *document, NSUInteger idx,
+                                           BOOL *stop) {
+    [visited addObject:document.documentID];
+    *stop = idx == 1;
+  }];
+  XCTAssertEqualObjects(visited, (@[ @"a", @"b" ]));
 }
 
 @end
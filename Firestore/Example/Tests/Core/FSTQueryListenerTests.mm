@@ -16,6 +16,7 @@
 
 #import <XCTest/XCTest.h>
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <utility>
 #include <vector>
@@ -56,6 +57,7 @@ using firebase::firestore::util::ExecutorLibdispatch;
 using firebase::firestore::util::Status;
 using firebase::firestore::util::StatusOr;
 using testing::ElementsAre;
+using testing::Eq;
 using testing::IsEmpty;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -365,6 +367,31 @@ ViewSnapshot::Listener Accumulating(std::vector<ViewSnapshot> *values) {
   XC_ASSERT_THAT(filteredAccum, ElementsAre(ExcludingMetadataChanges(snap1), expectedSnap2));
 }
 
+- (void)testExcludingMetadataChangesSharesChangesWhenNothingIsFiltered {
+  FSTQuery *query = FSTTestQuery("rooms");
+  FSTDocument *doc1 =
+      FSTTestDoc("rooms/Eros", 1, @{@"name" : @"Eros"}, FSTDocumentStateLocalMutations);
+  FSTDocument *doc1Prime =
+      FSTTestDoc("rooms/Eros", 1, @{@"name" : @"Eros"}, FSTDocumentStateSynced);
+
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
+  ViewSnapshot snap1 = FSTTestApplyChanges(view, @[ doc1 ], absl::nullopt).value();
+  ViewSnapshot snap2 = FSTTestApplyChanges(view, @[ doc1Prime ], absl::nullopt).value();
+
+  // Nothing to remove: the changes are shared.
+  ViewSnapshot excluded1 = snap1.ExcludingMetadataChanges();
+  XCTAssertTrue(excluded1.excludes_metadata_changes());
+  XCTAssertEqual(&excluded1.document_changes(), &snap1.document_changes());
+  XCTAssertTrue(excluded1 == ExcludingMetadataChanges(snap1));
+
+  // Only metadata changes: nothing is left.
+  XCTAssertEqual(snap2.document_changes().size(), 1);
+  ViewSnapshot excluded2 = snap2.ExcludingMetadataChanges();
+  XCTAssertTrue(excluded2.document_changes().empty());
+  XCTAssertFalse(excluded2.has_pending_writes());
+  XCTAssertTrue(excluded2.documents() == snap2.documents());
+}
+
 - (void)testWillWaitForSyncIfOnline {
   std::vector<ViewSnapshot> events;
 
@@ -498,6 +525,81 @@ ViewSnapshot::Listener Accumulating(std::vector<ViewSnapshot> *values) {
   XC_ASSERT_THAT(events, ElementsAre(expectedSnap));
 }
 
+- (void)testCoalescesSnapshotsUntilFlushed {
+  std::vector<ViewSnapshot> events;
+
+  FSTQuery *query = FSTTestQuery("rooms");
+  FSTDocument *doc1 = FSTTestDoc("rooms/Eros", 1, @{@"name" : @"Eros"}, FSTDocumentStateSynced);
+  FSTDocument *doc2 = FSTTestDoc("rooms/Hades", 2, @{@"name" : @"Hades"}, FSTDocumentStateSynced);
+  FSTDocument *doc2prime = FSTTestDoc("rooms/Hades", 3, @{@"name" : @"Hades", @"owner" : @"Jonny"},
+                                      FSTDocumentStateSynced);
+  FSTDocument *doc3 = FSTTestDoc("rooms/Other", 4, @{@"name" : @"Other"}, FSTDocumentStateSynced);
+
+  ListenOptions options =
+      ListenOptions::DefaultOptions().WithCoalescingWindow(std::chrono::milliseconds(16));
+  auto listener = QueryListener::Create(query, options, Accumulating(&events));
+
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
+  ViewSnapshot snap1 = FSTTestApplyChanges(view, @[ doc1, doc2 ], absl::nullopt).value();
+  ViewSnapshot snap2 = FSTTestApplyChanges(view, @[ doc2prime ], absl::nullopt).value();
+  ViewSnapshot snap3 = FSTTestApplyChanges(view, @[ doc3 ], absl::nullopt).value();
+  ViewSnapshot snap4 =
+      FSTTestApplyChanges(view, @[ FSTTestDeletedDoc("rooms/Eros", 5, NO) ], absl::nullopt)
+          .value();
+
+  listener->OnViewSnapshot(snap1);  // The initial event is raised right away.
+  XCTAssertFalse(listener->has_pending_snapshot());
+
+  listener->OnViewSnapshot(snap2);
+  listener->OnViewSnapshot(snap3);
+  listener->OnViewSnapshot(snap4);
+  XCTAssertTrue(listener->has_pending_snapshot());
+  XCTAssertEqual(events.size(), 1);
+
+  listener->FlushPendingSnapshot();
+  XCTAssertFalse(listener->has_pending_snapshot());
+
+  ViewSnapshot expectedSnap{query,
+                            /*documents=*/snap4.documents(),
+                            /*old_documents=*/snap1.documents(),
+                            /*document_changes=*/
+                            {DocumentViewChange{doc1, DocumentViewChange::Type::kRemoved},
+                             DocumentViewChange{doc3, DocumentViewChange::Type::kAdded},
+                             DocumentViewChange{doc2prime, DocumentViewChange::Type::kModified}},
+                            snap4.mutated_keys(),
+                            /*from_cache=*/true,
+                            /*sync_state_changed=*/false,
+                            /*excludes_metadata_changes=*/true};
+  XCTAssertEqual(events.size(), 2);
+  XC_ASSERT_THAT(events[1], Eq(expectedSnap));
+}
+
+- (void)testDoesNotRaiseCoalescedSnapshotsWhoseChangesCancelOut {
+  std::vector<ViewSnapshot> events;
+
+  FSTQuery *query = FSTTestQuery("rooms");
+  FSTDocument *doc1 = FSTTestDoc("rooms/Eros", 1, @{@"name" : @"Eros"}, FSTDocumentStateSynced);
+  FSTDocument *doc2 = FSTTestDoc("rooms/Hades", 2, @{@"name" : @"Hades"}, FSTDocumentStateSynced);
+
+  ListenOptions options =
+      ListenOptions::DefaultOptions().WithCoalescingWindow(std::chrono::milliseconds(16));
+  auto listener = QueryListener::Create(query, options, Accumulating(&events));
+
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
+  ViewSnapshot snap1 = FSTTestApplyChanges(view, @[ doc1 ], absl::nullopt).value();
+  ViewSnapshot snap2 = FSTTestApplyChanges(view, @[ doc2 ], absl::nullopt).value();
+  ViewSnapshot snap3 =
+      FSTTestApplyChanges(view, @[ FSTTestDeletedDoc("rooms/Hades", 3, NO) ], absl::nullopt)
+          .value();
+
+  listener->OnViewSnapshot(snap1);
+  listener->OnViewSnapshot(snap2);
+  listener->OnViewSnapshot(snap3);
+  listener->FlushPendingSnapshot();
+
+  XCTAssertEqual(events.size(), 1);
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
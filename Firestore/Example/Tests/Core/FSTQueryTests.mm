@@ -23,7 +23,10 @@
 
 #import "Firestore/Example/Tests/Util/FSTHelpers.h"
 
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
@@ -34,6 +37,7 @@ namespace testutil = firebase::firestore::testutil;
 namespace util = firebase::firestore::util;
 using firebase::firestore::model::DatabaseId;
 using firebase::firestore::model::DocumentComparator;
+using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::util::ComparisonResult;
@@ -444,6 +448,29 @@ NS_ASSUME_NONNULL_BEGIN
   [self assertCorrectComparisonsWithArray:docs comparator:query.comparator];
 }
 
+- (void)testSortsDocumentsByKeyBeforeOtherFields {
+  FSTQuery *query = FSTTestQuery("collection");
+  query = [query queryByAddingSortOrder:FSTTestOrderBy(FieldPath::kDocumentKeyPath, @"desc")];
+  query = [query queryByAddingSortOrder:FSTTestOrderBy("sort", @"asc")];
+
+  // clang-format off
+  NSArray<FSTDocument *> *docs =
+      @[FSTTestDoc("collection/3", 0, @{@"sort": @1}, FSTDocumentStateSynced),
+        FSTTestDoc("collection/2", 0, @{@"sort": @3}, FSTDocumentStateSynced),
+        FSTTestDoc("collection/1", 0, @{@"sort": @2}, FSTDocumentStateSynced),
+        ];
+  // clang-format on
+
+  [self assertCorrectComparisonsWithArray:docs comparator:query.comparator];
+}
+
+- (void)testComparatorIsBuiltOnce {
+  FSTQuery *query = FSTTestQuery("collection");
+  query = [query queryByAddingSortOrder:FSTTestOrderBy("sort", @"asc")];
+
+  XCTAssertEqual(&query.comparator, &query.comparator);
+}
+
 - (void)testEquality {
   FSTQuery *q11 = FSTTestQuery("foo");
   q11 = [q11 queryByAddingFilter:FSTTestFilter("i1", @"<", @(2))];
@@ -509,6 +536,28 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertNotEqualObjects(q51, q61);
 }
 
+- (void)testContainment {
+  FSTQuery *all = FSTTestQuery("foo");
+  all = [all queryByAddingFilter:FSTTestFilter("a", @"==", @(1))];
+  all = [all queryByAddingSortBy:"b" ascending:YES];
+  FSTQuery *limit10 = [all queryBySettingLimit:10];
+  FSTQuery *limit20 = [all queryBySettingLimit:20];
+
+  XCTAssertTrue([all isContainedInQuery:all]);
+  XCTAssertTrue([limit10 isContainedInQuery:all]);
+  XCTAssertTrue([limit10 isContainedInQuery:limit20]);
+  XCTAssertFalse([limit20 isContainedInQuery:limit10]);
+  XCTAssertFalse([all isContainedInQuery:limit20]);
+
+  FSTQuery *otherOrder = [[[FSTTestQuery("foo") queryByAddingFilter:FSTTestFilter("a", @"==", @(1))]
+      queryByAddingSortBy:"b" ascending:NO] queryBySettingLimit:10];
+  XCTAssertFalse([otherOrder isContainedInQuery:all]);
+
+  FSTQuery *otherFilter = [[all queryByAddingFilter:FSTTestFilter("c", @"==", @(2))]
+      queryBySettingLimit:10];
+  XCTAssertFalse([otherFilter isContainedInQuery:all]);
+}
+
 - (void)testUniqueIds {
   FSTQuery *q11 = FSTTestQuery("foo");
   q11 = [q11 queryByAddingFilter:FSTTestFilter("i1", @"<", @(2))];
@@ -572,6 +621,12 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqual(q51.hash, q52.hash);
   XCTAssertNotEqual(q51.hash, q53Diff.hash);
   XCTAssertNotEqual(q51.hash, q61.hash);
+
+  // Equal queries hash the same without building their canonical IDs.
+  XCTAssertEqualObjects(q51, q52);
+  XCTAssertEqual(FSTTestFilter("foo", @">", @(2)).hash, FSTTestFilter("foo", @">", @(2)).hash);
+  XCTAssertEqual(FSTTestOrderBy("foo", @"asc").hash, FSTTestOrderBy("foo", @"asc").hash);
+  XCTAssertNotEqual(FSTTestOrderBy("foo", @"asc").hash, FSTTestOrderBy("foo", @"desc").hash);
 }
 
 - (void)testImplicitOrderBy {
@@ -627,6 +682,76 @@ NS_ASSUME_NONNULL_BEGIN
                         ]));
 }
 
+- (void)testProjectionIncludesFilteredAndSortedFields {
+  FSTQuery *query = FSTTestQuery("foo");
+  query = [query queryByAddingFilter:FSTTestFilter("a", @"==", @1)];
+  query = [query queryByAddingSortBy:"b" ascending:YES];
+  query = [query queryBySettingProjection:{testutil::Field("title"), testutil::Field("a"),
+                                           testutil::Field("title")}];
+
+  std::vector<FieldPath> expected{testutil::Field("a"), testutil::Field("b"),
+                                  testutil::Field("title")};
+  XCTAssertTrue(query.hasProjection);
+  XCTAssertTrue(query.projection == expected);
+
+  // Selecting the key is implied.
+  FSTQuery *keysOnly = [FSTTestQuery("foo") queryBySettingProjection:{FieldPath::KeyFieldPath()}];
+  XCTAssertFalse(keysOnly.hasProjection);
+}
+
+- (void)testProjectionIsPartOfIdentity {
+  FSTQuery *allFields = FSTTestQuery("foo");
+  FSTQuery *titles = [allFields queryBySettingProjection:{testutil::Field("title")}];
+  FSTQuery *titlesAgain = [allFields queryBySettingProjection:{testutil::Field("title")}];
+  FSTQuery *dates = [allFields queryBySettingProjection:{testutil::Field("date")}];
+
+  XCTAssertFalse(allFields.hasProjection);
+  XCTAssertNotEqualObjects(allFields, titles);
+  XCTAssertNotEqualObjects(allFields.canonicalID, titles.canonicalID);
+  XCTAssertNotEqualObjects(titles, dates);
+  XCTAssertEqualObjects(titles, titlesAgain);
+  XCTAssertEqualObjects(titles.canonicalID, titlesAgain.canonicalID);
+
+  // The projection is kept by further refinements.
+  XCTAssertTrue([titles queryBySettingLimit:10].hasProjection);
+  XCTAssertFalse([allFields isContainedInQuery:titles]);
+}
+
+- (void)testDocumentKeysQueryMatchesOnlyItsDocuments {
+  FSTQuery *query = [FSTQuery queryWithDocumentKeys:DocumentKeySet{testutil::Key("rooms/a"),
+                                                                   testutil::Key("rooms/b")}];
+  XCTAssertTrue([query isDocumentKeysQuery]);
+  XCTAssertFalse([query isDocumentQuery]);
+
+  XCTAssertTrue([query matchesDocument:FSTTestDoc("rooms/a", 0, @{}, FSTDocumentStateSynced)]);
+  XCTAssertTrue([query matchesDocument:FSTTestDoc("rooms/b", 0, @{}, FSTDocumentStateSynced)]);
+  XCTAssertFalse([query matchesDocument:FSTTestDoc("rooms/c", 0, @{}, FSTDocumentStateSynced)]);
+  XCTAssertFalse(
+      [query matchesDocument:FSTTestDoc("rooms/a/messages/1", 0, @{}, FSTDocumentStateSynced)]);
+}
+
+- (void)testDocumentKeysAreCanonicalized {
+  FSTQuery *ab = [FSTQuery
+      queryWithDocumentKeys:DocumentKeySet{testutil::Key("rooms/a"), testutil::Key("rooms/b")}];
+  FSTQuery *ba = [FSTQuery
+      queryWithDocumentKeys:DocumentKeySet{testutil::Key("rooms/b"), testutil::Key("rooms/a")}];
+  FSTQuery *ac = [FSTQuery
+      queryWithDocumentKeys:DocumentKeySet{testutil::Key("rooms/a"), testutil::Key("rooms/c")}];
+
+  XCTAssertEqualObjects(ab, ba);
+  XCTAssertEqualObjects(ab.canonicalID, ba.canonicalID);
+  XCTAssertNotEqualObjects(ab, ac);
+  XCTAssertNotEqualObjects(ab.canonicalID, ac.canonicalID);
+  XCTAssertNotEqualObjects(ab, [FSTQuery queryWithPath:ResourcePath::Empty()]);
+}
+
+- (void)testSingleDocumentKeyIsDocumentQuery {
+  FSTQuery *query = [FSTQuery queryWithDocumentKeys:DocumentKeySet{testutil::Key("rooms/a")}];
+  XCTAssertTrue([query isDocumentQuery]);
+  XCTAssertFalse([query isDocumentKeysQuery]);
+  XCTAssertEqualObjects(query, FSTTestQuery("rooms/a"));
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -23,15 +23,24 @@
 
 #import "Firestore/Example/Tests/Util/FSTHelpers.h"
 
+#include "Firestore/core/src/firebase/firestore/core/aggregate.h"
+#include "Firestore/core/src/firebase/firestore/core/field_column.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 
+namespace testutil = firebase::firestore::testutil;
+using firebase::firestore::core::AggregateAccumulator;
+using firebase::firestore::core::AggregateField;
+using firebase::firestore::core::AggregateSnapshot;
 using firebase::firestore::core::DocumentViewChange;
 using firebase::firestore::core::DocumentViewChangeSet;
+using firebase::firestore::core::FieldColumn;
 using firebase::firestore::core::ViewSnapshot;
 using firebase::firestore::model::DocumentComparator;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentSet;
+using firebase::firestore::model::FieldValue;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -100,6 +109,43 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqual(changes[6].type(), DocumentViewChange::Type::kModified);
 }
 
+- (void)testGetChangesInViewOrder {
+  FSTQuery *query = [FSTTestQuery("c") queryByAddingSortOrder:FSTTestOrderBy("order", @"asc")];
+
+  FSTDocument *removedLast = FSTTestDoc("c/a", 1, @{@"order" : @5}, FSTDocumentStateSynced);
+  FSTDocument *removedFirst = FSTTestDoc("c/b", 1, @{@"order" : @0}, FSTDocumentStateSynced);
+  FSTDocument *addedLast = FSTTestDoc("c/c", 1, @{@"order" : @3}, FSTDocumentStateSynced);
+  FSTDocument *addedFirst = FSTTestDoc("c/d", 1, @{@"order" : @1}, FSTDocumentStateSynced);
+  FSTDocument *modified = FSTTestDoc("c/e", 2, @{@"order" : @2}, FSTDocumentStateSynced);
+
+  DocumentSet oldDocuments = FSTTestDocSet(query.comparator, @[ removedLast, removedFirst ]);
+  DocumentSet newDocuments = FSTTestDocSet(query.comparator, @[ addedLast, addedFirst, modified ]);
+  // Enough unchanged documents that the additions get sorted rather than picked out of the
+  // documents in order.
+  for (int i = 0; i < 20; ++i) {
+    NSString *path = [NSString stringWithFormat:@"c/unchanged%d", i];
+    newDocuments = newDocuments.insert(
+        FSTTestDoc(path.UTF8String, 1, @{@"order" : @(10 + i)}, FSTDocumentStateSynced));
+  }
+
+  DocumentViewChangeSet set;
+  set.AddChange(DocumentViewChange{modified, DocumentViewChange::Type::kModified});
+  set.AddChange(DocumentViewChange{addedLast, DocumentViewChange::Type::kAdded});
+  set.AddChange(DocumentViewChange{removedLast, DocumentViewChange::Type::kRemoved});
+  set.AddChange(DocumentViewChange{addedFirst, DocumentViewChange::Type::kAdded});
+  set.AddChange(DocumentViewChange{removedFirst, DocumentViewChange::Type::kRemoved});
+
+  std::vector<DocumentViewChange> changes =
+      set.GetChangesInViewOrder(oldDocuments, newDocuments, query.comparator);
+  std::vector<DocumentViewChange> expected{
+      DocumentViewChange{removedFirst, DocumentViewChange::Type::kRemoved},
+      DocumentViewChange{removedLast, DocumentViewChange::Type::kRemoved},
+      DocumentViewChange{addedFirst, DocumentViewChange::Type::kAdded},
+      DocumentViewChange{addedLast, DocumentViewChange::Type::kAdded},
+      DocumentViewChange{modified, DocumentViewChange::Type::kModified}};
+  XCTAssertEqual(changes, expected);
+}
+
 - (void)testViewSnapshotConstructor {
   FSTQuery *query = FSTTestQuery("a");
   DocumentSet documents = DocumentSet{DocumentComparator::ByKey()};
@@ -130,6 +176,91 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqual(snapshot.sync_state_changed(), syncStateChanged);
 }
 
+- (void)testFieldColumn {
+  DocumentSet documents = FSTTestDocSet(DocumentComparator::ByKey(), @[
+    FSTTestDoc("c/a", 1, @{@"v" : @1}, FSTDocumentStateSynced),
+    FSTTestDoc("c/b", 1, @{@"v" : @2.5}, FSTDocumentStateSynced),
+    FSTTestDoc("c/c", 1, @{@"v" : @"foo"}, FSTDocumentStateSynced),
+    FSTTestDoc("c/d", 1, @{}, FSTDocumentStateSynced),
+    FSTTestDoc("c/e", 1, @{@"v" : @YES}, FSTDocumentStateSynced),
+    FSTTestDoc("c/f", 1, @{@"v" : @"barbaz"}, FSTDocumentStateSynced)
+  ]);
+
+  FieldColumn column{documents, testutil::Field("v")};
+
+  XCTAssertEqual(column.size(), 6);
+  XCTAssertTrue(column.keys()[0] == testutil::Key("c/a"));
+  XCTAssertTrue(column.keys()[5] == testutil::Key("c/f"));
+
+  std::vector<FieldColumn::Type> expectedTypes{
+      FieldColumn::Type::kInteger, FieldColumn::Type::kDouble, FieldColumn::Type::kString,
+      FieldColumn::Type::kMissing, FieldColumn::Type::kOther,  FieldColumn::Type::kString};
+  XCTAssertTrue(column.types() == expectedTypes);
+  XCTAssertTrue(column.integer_values() == (std::vector<int64_t>{1, 0, 0, 0, 0, 0}));
+  XCTAssertTrue(column.double_values() == (std::vector<double>{0, 2.5, 0, 0, 0, 0}));
+  XCTAssertTrue(column.string_value(0) == "");
+  XCTAssertTrue(column.string_value(2) == "foo");
+  XCTAssertTrue(column.string_value(5) == "barbaz");
+}
+
+- (void)testAggregateAccumulatorAppliesDocumentChanges {
+  FSTQuery *query = FSTTestQuery("c");
+  DocumentSet documents = FSTTestDocSet(DocumentComparator::ByKey(), @[
+    FSTTestDoc("c/a", 1, @{@"v" : @1}, FSTDocumentStateSynced),
+    FSTTestDoc("c/b", 1, @{@"v" : @2.5}, FSTDocumentStateSynced),
+    FSTTestDoc("c/c", 1, @{@"v" : @"foo"}, FSTDocumentStateSynced),
+    FSTTestDoc("c/d", 1, @{}, FSTDocumentStateSynced)
+  ]);
+
+  AggregateAccumulator accumulator{{AggregateField::Count(),
+                                    AggregateField::Sum(testutil::Field("v")),
+                                    AggregateField::Average(testutil::Field("v"))}};
+  accumulator.Apply(ViewSnapshot::FromInitialDocuments(query, documents, DocumentKeySet{},
+                                                       /*from_cache=*/true,
+                                                       /*excludes_metadata_changes=*/false));
+
+  AggregateSnapshot initial = accumulator.ToSnapshot(/*from_cache=*/true,
+                                                     /*has_pending_writes=*/false);
+  XCTAssertEqual(initial.count(), 4);
+  XCTAssertTrue(initial.values()[0] == FieldValue::FromInteger(4));
+  XCTAssertTrue(initial.values()[1] == FieldValue::FromDouble(3.5));
+  XCTAssertEqual(initial.values()[1].type(), FieldValue::Type::Double);
+  XCTAssertTrue(initial.values()[2] == FieldValue::FromDouble(1.75));
+  XCTAssertTrue(initial.from_cache());
+
+  // Modifying c/a and removing the only double leaves an exact integer sum.
+  FSTDocument *modified = FSTTestDoc("c/a", 2, @{@"v" : @4}, FSTDocumentStateSynced);
+  FSTDocument *removed = FSTTestDoc("c/b", 1, @{@"v" : @2.5}, FSTDocumentStateSynced);
+  DocumentSet newDocuments = documents.insert(modified).erase(removed.key);
+  std::vector<DocumentViewChange> changes{
+      DocumentViewChange{removed, DocumentViewChange::Type::kRemoved},
+      DocumentViewChange{modified, DocumentViewChange::Type::kModified}};
+  accumulator.Apply(ViewSnapshot{query, newDocuments, documents, std::move(changes),
+                                 DocumentKeySet{},
+                                 /*from_cache=*/false,
+                                 /*sync_state_changed=*/true,
+                                 /*excludes_metadata_changes=*/false});
+
+  AggregateSnapshot updated = accumulator.ToSnapshot(/*from_cache=*/false,
+                                                     /*has_pending_writes=*/false);
+  XCTAssertEqual(updated.count(), 3);
+  XCTAssertTrue(updated.values()[0] == FieldValue::FromInteger(3));
+  XCTAssertTrue(updated.values()[1] == FieldValue::FromInteger(4));
+  XCTAssertEqual(updated.values()[1].type(), FieldValue::Type::Integer);
+  XCTAssertTrue(updated.values()[2] == FieldValue::FromDouble(4));
+}
+
+- (void)testAggregateAverageOfNoNumbersIsNull {
+  AggregateAccumulator accumulator{{AggregateField::Sum(testutil::Field("v")),
+                                    AggregateField::Average(testutil::Field("v"))}};
+
+  AggregateSnapshot snapshot = accumulator.ToSnapshot(/*from_cache=*/true,
+                                                      /*has_pending_writes=*/false);
+  XCTAssertEqual(snapshot.count(), 0);
+  XCTAssertTrue(snapshot.values()[0] == FieldValue::FromInteger(0));
+  XCTAssertTrue(snapshot.values()[1] == FieldValue::Null());
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -19,6 +19,7 @@
 #import <XCTest/XCTest.h>
 
 #include <initializer_list>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -396,6 +397,33 @@ inline ContainsDocsMatcherP<std::vector<FSTDocument *>> ContainsDocs(
   XCTAssertEqualObjects(change.limboChanges, @[]);
 }
 
+- (void)testRepeatedCurrentTargetChangesKeepLimboDocuments {
+  FSTQuery *query = [self queryForMessages];
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
+
+  FSTDocument *doc1 = FSTTestDoc("rooms/eros/messages/0", 0, @{}, FSTDocumentStateSynced);
+  [view applyChangesToDocuments:[view computeChangesWithDocuments:FSTTestDocUpdates(@[ doc1 ])]];
+
+  FSTViewChange *change =
+      [view applyChangesToDocuments:[view computeChangesWithDocuments:FSTTestDocUpdates(@[])]
+                       targetChange:FSTTestTargetChangeMarkCurrent()];
+  XCTAssertEqualObjects(change.limboChanges,
+                        @[ [FSTLimboDocumentChange changeWithType:FSTLimboDocumentChangeTypeAdded
+                                                              key:doc1.key] ]);
+
+  // E.g., the target being acknowledged again after the watch stream reconnects.
+  change = [view applyChangesToDocuments:[view computeChangesWithDocuments:FSTTestDocUpdates(@[])]
+                            targetChange:FSTTestTargetChangeMarkCurrent()];
+  XCTAssertEqualObjects(change.limboChanges, @[]);
+  XCTAssertFalse(change.snapshot.has_value());
+
+  change = [view applyChangesToDocuments:[view computeChangesWithDocuments:FSTTestDocUpdates(@[])]
+                            targetChange:FSTTestTargetChangeAckDocuments({doc1.key})];
+  XCTAssertEqualObjects(change.limboChanges,
+                        @[ [FSTLimboDocumentChange changeWithType:FSTLimboDocumentChangeTypeRemoved
+                                                              key:doc1.key] ]);
+}
+
 - (void)testReturnsNeedsRefillOnDeleteInLimitQuery {
   FSTQuery *query = [[self queryForMessages] queryBySettingLimit:2];
   FSTDocument *doc1 = FSTTestDoc("rooms/eros/messages/0", 0, @{}, FSTDocumentStateSynced);
@@ -461,6 +489,66 @@ inline ContainsDocsMatcherP<std::vector<FSTDocument *>> ContainsDocs(
   [view applyChangesToDocuments:changes];
 }
 
+- (void)testRefillsFromOverflowOnDeleteInLimitQuery {
+  FSTQuery *query = [[self queryForMessages] queryBySettingLimit:2];
+  FSTDocument *doc1 = FSTTestDoc("rooms/eros/messages/0", 0, @{}, FSTDocumentStateSynced);
+  FSTDocument *doc2 = FSTTestDoc("rooms/eros/messages/1", 0, @{}, FSTDocumentStateSynced);
+  FSTDocument *doc3 = FSTTestDoc("rooms/eros/messages/2", 0, @{}, FSTDocumentStateSynced);
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
+
+  // Start with a full view and one doc past the limit.
+  FSTViewDocumentChanges *changes =
+      [view computeChangesWithDocuments:FSTTestDocUpdates(@[ doc1, doc2, doc3 ])];
+  XC_ASSERT_THAT(changes.documentSet, ContainsDocs({doc1, doc2}));
+  [view applyChangesToDocuments:changes];
+
+  // Remove one of the docs in the view.
+  changes = [view computeChangesWithDocuments:FSTTestDocUpdates(@[ FSTTestDeletedDoc(
+                                                  "rooms/eros/messages/0", 0, NO) ])];
+  XCTAssertTrue(changes.needsRefill);
+
+  // The doc past the limit takes its place without going back to the local cache.
+  FSTViewDocumentChanges *refilled = [view refillChangesFromOverflow:changes];
+  XCTAssertNotNil(refilled);
+  XC_ASSERT_THAT(refilled.documentSet, ContainsDocs({doc2, doc3}));
+  XCTAssertFalse(refilled.needsRefill);
+  XCTAssertEqual(2, refilled.changeSet.GetChanges().size());
+  [view applyChangesToDocuments:refilled];
+
+  // Nothing is left past the limit, but since the view knows that, it can still refill.
+  changes = [view computeChangesWithDocuments:FSTTestDocUpdates(@[ FSTTestDeletedDoc(
+                                                  "rooms/eros/messages/1", 0, NO) ])];
+  XCTAssertTrue(changes.needsRefill);
+  refilled = [view refillChangesFromOverflow:changes];
+  XCTAssertNotNil(refilled);
+  XC_ASSERT_THAT(refilled.documentSet, ContainsDocs({doc3}));
+}
+
+- (void)testDoesntRefillFromOverflowPastTheDocsItKeeps {
+  FSTQuery *query = [[self queryForMessages] queryBySettingLimit:2];
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
+
+  // More docs past the limit than the view keeps.
+  NSMutableArray<FSTDocument *> *docs = [NSMutableArray array];
+  for (char c = 'a'; c <= 'z'; ++c) {
+    std::string path = std::string{"rooms/eros/messages/"} + c;
+    [docs addObject:FSTTestDoc(path, 0, @{}, FSTDocumentStateSynced)];
+  }
+  FSTViewDocumentChanges *changes = [view computeChangesWithDocuments:FSTTestDocUpdates(docs)];
+  [view applyChangesToDocuments:changes];
+
+  // Remove every doc in the view and every doc kept past the limit. The view can't know which of
+  // the remaining docs come next.
+  NSMutableArray<FSTMaybeDocument *> *deletes = [NSMutableArray array];
+  for (NSUInteger i = 0; i < docs.count / 2; ++i) {
+    std::string path = docs[i].key.ToString();
+    [deletes addObject:FSTTestDeletedDoc(path, 0, NO)];
+  }
+  changes = [view computeChangesWithDocuments:FSTTestDocUpdates(deletes)];
+  XCTAssertTrue(changes.needsRefill);
+  XCTAssertNil([view refillChangesFromOverflow:changes]);
+}
+
 - (void)testDoesntNeedRefillOnReorderWithinLimit {
   FSTQuery *query = [self queryForMessages];
   query =
@@ -18,6 +18,7 @@
 
 #import <XCTest/XCTest.h>
 
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -220,7 +221,20 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (FSTDocument *)cacheADocumentInTransaction {
   FSTDocument *doc = [self nextTestDocument];
-  _documentCache->Add(doc);
+  _documentCache->Add(doc, doc.version);
+  return doc;
+}
+
+/** Like `cacheADocumentInTransaction`, but places the document in the given collection. */
+- (FSTDocument *)cacheADocumentInTransactionInCollection:(const std::string &)collection
+                                                   value:(FSTObjectValue *)value {
+  DocumentKey key = testutil::Key(collection + "/doc_" + std::to_string(++_previousDocNum));
+  FSTTestSnapshotVersion version = 2;
+  FSTDocument *doc = [FSTDocument documentWithData:value
+                                               key:key
+                                           version:testutil::Version(version)
+                                             state:FSTDocumentStateSynced];
+  _documentCache->Add(doc, doc.version);
   return doc;
 }
 
@@ -628,7 +642,7 @@ NS_ASSUME_NONNULL_BEGIN
                                                  key:middleDocToUpdate
                                              version:testutil::Version(version)
                                                state:FSTDocumentStateSynced];
-    _documentCache->Add(doc);
+    _documentCache->Add(doc, doc.version);
     [self updateTargetInTransaction:middleTarget];
   });
 
@@ -768,6 +782,182 @@ NS_ASSUME_NONNULL_BEGIN
   [_persistence shutdown];
 }
 
+- (void)testSampledGCRan {
+  if ([self isTestBaseClass]) return;
+
+  LruParams params = LruParams::Default();
+  params.minBytesThreshold = 100;
+  // Sample fewer sequence numbers than we add so that the cutoff is only an estimate.
+  params.sampleSize = 50;
+  [self newTestResourcesWithLruParams:params];
+
+  // Add 100 targets and 10 documents to each, each target with its own sequence number.
+  for (int i = 0; i < 100; i++) {
+    _persistence.run("Add a target and some documents", [&]() {
+      FSTQueryData *queryData = [self addNextQueryInTransaction];
+      for (int j = 0; j < 10; j++) {
+        FSTDocument *doc = [self cacheADocumentInTransaction];
+        [self addDocument:doc.key toTarget:queryData.targetID];
+      }
+    });
+  }
+
+  LruResults results =
+      _persistence.run("GC", [&]() -> LruResults { return [_gc collectWithLiveTargets:{}]; });
+
+  // The number of sequence numbers to collect is still exact, but the cutoff is estimated from the
+  // sample, so we may collect somewhat more or fewer than 10 targets.
+  XCTAssertTrue(results.didRun);
+  XCTAssertEqual(10, results.sequenceNumbersCollected);
+  XCTAssertGreaterThan(results.targetsRemoved, 0);
+  XCTAssertLessThanOrEqual(results.targetsRemoved, 20);
+  XCTAssertEqual(10 * results.targetsRemoved, results.documentsRemoved);
+  [_persistence shutdown];
+}
+
+- (void)testIncrementalGCRan {
+  if ([self isTestBaseClass]) return;
+
+  LruParams params = LruParams::Default();
+  params.minBytesThreshold = 100;
+  params.maximumDocumentsRemovedPerStep = 30;
+  [self newTestResourcesWithLruParams:params];
+
+  // Add 100 targets and 10 documents to each, each target with its own sequence number.
+  for (int i = 0; i < 100; i++) {
+    _persistence.run("Add a target and some documents", [&]() {
+      FSTQueryData *queryData = [self addNextQueryInTransaction];
+      for (int j = 0; j < 10; j++) {
+        FSTDocument *doc = [self cacheADocumentInTransaction];
+        [self addDocument:doc.key toTarget:queryData.targetID];
+      }
+    });
+  }
+
+  // The first step removes the targets and as many documents as it is allowed to.
+  LruResults results =
+      _persistence.run("GC", [&]() -> LruResults { return [_gc collectWithLiveTargets:{}]; });
+  XCTAssertTrue(results.didRun);
+  XCTAssertTrue(results.hasMoreToCollect);
+  XCTAssertEqual(10, results.targetsRemoved);
+  XCTAssertEqual(30, results.documentsRemoved);
+
+  // Later steps pick up the remaining documents of the same collection.
+  int documentsRemoved = results.documentsRemoved;
+  int steps = 1;
+  while (results.hasMoreToCollect) {
+    results =
+        _persistence.run("GC", [&]() -> LruResults { return [_gc collectWithLiveTargets:{}]; });
+    XCTAssertTrue(results.didRun);
+    XCTAssertEqual(0, results.targetsRemoved);
+    documentsRemoved += results.documentsRemoved;
+    steps++;
+  }
+  XCTAssertEqual(100, documentsRemoved);
+  XCTAssertEqual(4, steps);
+  [_persistence shutdown];
+}
+
+- (void)testPinnedCollectionGroupsAreNotCollected {
+  if ([self isTestBaseClass]) return;
+
+  LruParams params = LruParams::Default();
+  params.minBytesThreshold = 100;
+  params.percentileToCollect = 100;
+  params.pinnedCollectionGroups = {"pinned"};
+  [self newTestResourcesWithLruParams:params];
+
+  std::vector<DocumentKey> collected;
+  std::vector<DocumentKey> pinned;
+  for (int i = 0; i < 10; i++) {
+    _persistence.run("Add orphaned documents", [&]() {
+      FSTDocument *doc = [self cacheADocumentInTransaction];
+      [self markDocumentEligibleForGCInTransaction:doc.key];
+      collected.push_back(doc.key);
+
+      doc = [self cacheADocumentInTransactionInCollection:"pinned" value:_testValue];
+      [self markDocumentEligibleForGCInTransaction:doc.key];
+      pinned.push_back(doc.key);
+    });
+  }
+
+  LruResults results =
+      _persistence.run("GC", [&]() -> LruResults { return [_gc collectWithLiveTargets:{}]; });
+  XCTAssertTrue(results.didRun);
+  XCTAssertEqual(10, results.documentsRemoved);
+
+  _persistence.run("verify results", [&]() {
+    for (const DocumentKey &key : collected) {
+      XCTAssertNil(_documentCache->Get(key));
+    }
+    for (const DocumentKey &key : pinned) {
+      XCTAssertNotNil(_documentCache->Get(key));
+    }
+  });
+  [_persistence shutdown];
+}
+
+- (void)testCollectionGroupBudgets {
+  if ([self isTestBaseClass]) return;
+
+  LruParams params = LruParams::Default();
+  params.minBytesThreshold = 100;
+  // Don't collect anything because of its age alone.
+  params.percentileToCollect = 0;
+  params.collectionGroupByteBudgets = {{"big", 20000}};
+  [self newTestResourcesWithLruParams:params];
+
+  // Add 10 orphaned documents of about 4KB each to the group with a budget, and some small ones to
+  // a group without one.
+  std::vector<DocumentKey> big;
+  std::vector<DocumentKey> small;
+  for (int i = 0; i < 10; i++) {
+    _persistence.run("Add orphaned documents", [&]() {
+      FSTDocument *doc = [self cacheADocumentInTransactionInCollection:"big"
+                                                                 value:_bigObjectValue];
+      [self markDocumentEligibleForGCInTransaction:doc.key];
+      big.push_back(doc.key);
+
+      doc = [self cacheADocumentInTransaction];
+      [self markDocumentEligibleForGCInTransaction:doc.key];
+      small.push_back(doc.key);
+    });
+  }
+  int64_t initialSize = _persistence.run("size", [&]() -> int64_t {
+    return [_lruDelegate byteSizeForCollectionGroup:"big"];
+  });
+  XCTAssertGreaterThan(initialSize, 40000);
+
+  LruResults results =
+      _persistence.run("GC", [&]() -> LruResults { return [_gc collectWithLiveTargets:{}]; });
+  XCTAssertTrue(results.didRun);
+  XCTAssertEqual(0, results.sequenceNumbersCollected);
+
+  // The group now fits its budget, but no more was removed than necessary.
+  int64_t finalSize = _persistence.run("size", [&]() -> int64_t {
+    return [_lruDelegate byteSizeForCollectionGroup:"big"];
+  });
+  XCTAssertLessThanOrEqual(finalSize, 20000);
+  XCTAssertGreaterThan(finalSize, 20000 - 5000);
+
+  // The least recently used documents went first.
+  _persistence.run("verify results", [&]() {
+    int removed = results.documentsRemoved;
+    XCTAssertGreaterThan(removed, 0);
+    for (int i = 0; i < 10; i++) {
+      if (i < removed) {
+        XCTAssertNil(_documentCache->Get(big[i]));
+      } else {
+        XCTAssertNotNil(_documentCache->Get(big[i]));
+      }
+    }
+    for (const DocumentKey &key : small) {
+      XCTAssertNotNil(_documentCache->Get(key));
+    }
+  });
+  [_persistence shutdown];
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -15,6 +15,7 @@
  */
 
 #include <string>
+#include <vector>
 
 #import "Firestore/Example/Tests/Local/FSTLRUGarbageCollectorTests.h"
 
@@ -22,10 +23,16 @@
 #import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 
+namespace testutil = firebase::firestore::testutil;
 using firebase::firestore::local::LevelDbDocumentTargetKey;
+using firebase::firestore::local::ReferenceSet;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::ListenSequenceNumber;
 
 using firebase::firestore::local::LruParams;
 
@@ -47,6 +54,95 @@ NS_ASSUME_NONNULL_BEGIN
   return !db.currentTransaction->Get(sentinelKey, &unusedValue).IsNotFound();
 }
 
+- (void)testWritesSentinelsWhenTheTransactionCommits {
+  FSTLevelDB *db = [FSTPersistenceTestHelpers levelDBPersistence];
+  ReferenceSet additionalReferences;
+  [db.referenceDelegate addInMemoryPins:&additionalReferences];
+  DocumentKey key = testutil::Key("docs/a");
+  DocumentKey removedKey = testutil::Key("docs/b");
+  std::string sentinelKey = LevelDbDocumentTargetKey::SentinelKey(key);
+  std::string encoded;
+
+  ListenSequenceNumber sequenceNumber =
+      db.run("add references", [&]() -> ListenSequenceNumber {
+        [db.referenceDelegate addReference:key];
+        [db.referenceDelegate removeReference:key];
+        [db.referenceDelegate addReference:removedKey];
+        [db.referenceDelegate removeOrphanedDocument:removedKey
+                                      sequenceNumber:db.currentSequenceNumber];
+        XCTAssertTrue(db.currentTransaction->Get(sentinelKey, &encoded).IsNotFound());
+        return db.currentSequenceNumber;
+      });
+
+  db.run("verify sentinels", [&]() {
+    XCTAssertTrue(db.currentTransaction->Get(sentinelKey, &encoded).ok());
+    XCTAssertEqual(LevelDbDocumentTargetKey::DecodeSentinelValue(encoded), sequenceNumber);
+    std::string unusedValue;
+    XCTAssertTrue(db.currentTransaction->Get(LevelDbDocumentTargetKey::SentinelKey(removedKey),
+                                             &unusedValue)
+                      .IsNotFound());
+  });
+  [db shutdown];
+}
+
+- (void)testBoundedStepsContinueWhereThePreviousStepStopped {
+  FSTLevelDB *db = [FSTPersistenceTestHelpers levelDBPersistence];
+  ReferenceSet additionalReferences;
+  [db.referenceDelegate addInMemoryPins:&additionalReferences];
+  id<FSTLRUDelegate> delegate = (id<FSTLRUDelegate>)db.referenceDelegate;
+
+  std::vector<DocumentKey> keys;
+  for (char c = 'a'; c <= 'j'; c++) {
+    keys.push_back(testutil::Key(std::string("docs/") + c));
+  }
+  ListenSequenceNumber upperBound = db.run("orphan documents", [&]() -> ListenSequenceNumber {
+    for (const DocumentKey &key : keys) {
+      [db.referenceDelegate addReference:key];
+      [db.referenceDelegate removeReference:key];
+    }
+    return db.currentSequenceNumber;
+  });
+  auto removeStep = [&]() -> int {
+    return db.run("gc step", [&]() -> int {
+      return [delegate removeOrphanedDocumentsThroughSequenceNumber:upperBound limit:3];
+    });
+  };
+  auto sentinelExists = [&](const DocumentKey &key) -> bool {
+    return db.run("check sentinel", [&]() -> bool {
+      std::string unusedValue;
+      return db.currentTransaction->Get(LevelDbDocumentTargetKey::SentinelKey(key), &unusedValue)
+          .ok();
+    });
+  };
+
+  // docs/a and docs/b are skipped by the first step.
+  additionalReferences.AddReference(keys[0], 1);
+  additionalReferences.AddReference(keys[1], 1);
+  XCTAssertEqual(removeStep(), 3);
+  XCTAssertTrue(sentinelExists(keys[0]));
+  XCTAssertTrue(sentinelExists(keys[1]));
+  XCTAssertFalse(sentinelExists(keys[4]));
+  XCTAssertTrue(sentinelExists(keys[5]));
+
+  // The next step picks up after docs/e instead of scanning from the start again, so it doesn't
+  // see that docs/a can now be removed.
+  additionalReferences.RemoveReference(keys[0], 1);
+  XCTAssertEqual(removeStep(), 3);
+  XCTAssertTrue(sentinelExists(keys[0]));
+  XCTAssertFalse(sentinelExists(keys[7]));
+  XCTAssertTrue(sentinelExists(keys[8]));
+
+  // The last step of the pass reaches the end of the documents.
+  XCTAssertEqual(removeStep(), 2);
+  XCTAssertFalse(sentinelExists(keys[9]));
+
+  // The next pass starts from the beginning again.
+  XCTAssertEqual(removeStep(), 1);
+  XCTAssertFalse(sentinelExists(keys[0]));
+  XCTAssertTrue(sentinelExists(keys[1]));
+  [db shutdown];
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
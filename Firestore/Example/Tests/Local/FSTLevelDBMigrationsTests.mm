@@ -38,15 +38,22 @@
 NS_ASSUME_NONNULL_BEGIN
 
 using firebase::firestore::FirestoreErrorCode;
+using firebase::firestore::local::LevelDbCollectionGroupDocumentKey;
+using firebase::firestore::local::LevelDbCollectionGroupSizeKey;
+using firebase::firestore::local::LevelDbCollectionMutationKey;
 using firebase::firestore::local::LevelDbCollectionParentKey;
 using firebase::firestore::local::LevelDbDocumentMutationKey;
+using firebase::firestore::local::LevelDbDocumentReadTimeKey;
 using firebase::firestore::local::LevelDbDocumentTargetKey;
+using firebase::firestore::local::LevelDbFieldIndexKey;
+using firebase::firestore::local::LevelDbIndexedCollectionKey;
 using firebase::firestore::local::LevelDbMigrations;
 using firebase::firestore::local::LevelDbMutationKey;
 using firebase::firestore::local::LevelDbMutationQueueKey;
 using firebase::firestore::local::LevelDbQueryCache;
 using firebase::firestore::local::LevelDbQueryTargetKey;
 using firebase::firestore::local::LevelDbRemoteDocumentKey;
+using firebase::firestore::local::LevelDbRemoteDocumentReadTimeKey;
 using firebase::firestore::local::LevelDbTargetDocumentKey;
 using firebase::firestore::local::LevelDbTargetGlobalKey;
 using firebase::firestore::local::LevelDbTargetKey;
@@ -54,8 +61,11 @@ using firebase::firestore::local::LevelDbTransaction;
 using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::ListenSequenceNumber;
+using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::testutil::Field;
 using firebase::firestore::testutil::Key;
+using firebase::firestore::testutil::Resource;
 using firebase::firestore::util::OrderedCode;
 using firebase::firestore::util::Path;
 using leveldb::DB;
@@ -64,6 +74,20 @@ using leveldb::Status;
 
 using SchemaVersion = LevelDbMigrations::SchemaVersion;
 
+namespace {
+
+/**
+ * Returns the legacy form of `key`, which spells out the table name where current keys have the
+ * table tag.
+ */
+std::string LegacyKey(const std::string &key,
+                      const std::string &prefix,
+                      const std::string &legacyPrefix) {
+  return legacyPrefix + key.substr(prefix.size());
+}
+
+}  // namespace
+
 @interface FSTLevelDBMigrationsTests : XCTestCase
 @end
 
@@ -415,6 +439,425 @@ using SchemaVersion = LevelDbMigrations::SchemaVersion;
   }
 }
 
+- (void)testClearsFieldIndex {
+  std::string empty_buffer;
+  DocumentKey key = Key("coll/doc");
+  std::string index_key = LevelDbFieldIndexKey::Key(Field("a"), "1", key);
+  std::string collection_key = LevelDbIndexedCollectionKey::Key(key.path().PopLast());
+
+  LevelDbMigrations::RunMigrations(_db.get(), 6);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write field index");
+    transaction.Put(index_key, empty_buffer);
+    transaction.Put(collection_key, empty_buffer);
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 7);
+  {
+    LevelDbTransaction transaction(_db.get(), "Verify");
+    std::string buffer;
+    XCTAssertTrue(transaction.Get(index_key, &buffer).IsNotFound());
+    XCTAssertTrue(transaction.Get(collection_key, &buffer).IsNotFound());
+  }
+}
+
+- (void)testIndexesMutationsByCollection {
+  std::string empty_buffer;
+  DocumentKey fooBar = Key("foo/bar");
+  DocumentKey fooBarSub = Key("foo/bar/sub/doc");
+  std::string staleKey = LevelDbCollectionMutationKey::Key("foo", Key("foo/stale"), 1);
+
+  LevelDbMigrations::RunMigrations(_db.get(), 7);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write mutations");
+    // As for the collection parents migration, only the document-mutation
+    // index entries are needed.
+    transaction.Put(LevelDbDocumentMutationKey::Key("foo", fooBar, 1), empty_buffer);
+    transaction.Put(LevelDbDocumentMutationKey::Key("foo", fooBarSub, 2), empty_buffer);
+    transaction.Put(LevelDbDocumentMutationKey::Key("bar", fooBar, 3), empty_buffer);
+    transaction.Put(staleKey, empty_buffer);
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 8);
+  {
+    LevelDbTransaction transaction(_db.get(), "Verify");
+    std::string buffer;
+    XCTAssertTrue(
+        transaction.Get(LevelDbCollectionMutationKey::Key("foo", fooBar, 1), &buffer).ok());
+    XCTAssertTrue(
+        transaction.Get(LevelDbCollectionMutationKey::Key("foo", fooBarSub, 2), &buffer).ok());
+    XCTAssertTrue(
+        transaction.Get(LevelDbCollectionMutationKey::Key("bar", fooBar, 3), &buffer).ok());
+    XCTAssertTrue(transaction.Get(staleKey, &buffer).IsNotFound());
+  }
+}
+
+- (void)testCountsCachedBytes {
+  std::string documentKey = LevelDbRemoteDocumentKey::Key(Key("foo/bar"));
+  std::string targetKey = LevelDbTargetKey::Key(1);
+  std::string mutationKey = LevelDbMutationKey::Key("user", 1);
+  // Index rows aren't counted.
+  std::string empty_buffer;
+  std::string indexKey = LevelDbDocumentMutationKey::Key("user", Key("foo/bar"), 1);
+
+  LevelDbMigrations::RunMigrations(_db.get(), 8);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write rows");
+    transaction.Put(documentKey, std::string(100, 'd'));
+    transaction.Put(targetKey, std::string(10, 't'));
+    transaction.Put(mutationKey, std::string(1, 'm'));
+    transaction.Put(indexKey, empty_buffer);
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 9);
+  FSTPBTargetGlobal *metadata = LevelDbQueryCache::ReadMetadata(_db.get());
+  size_t expected = documentKey.size() + 100 + targetKey.size() + 10 + mutationKey.size() + 1;
+  XCTAssertEqual(metadata.byteSize, static_cast<int64_t>(expected));
+}
+
+- (void)testCountsCollectionGroupBytes {
+  std::string fooKey = LevelDbRemoteDocumentKey::Key(Key("foo/bar"));
+  std::string nestedFooKey = LevelDbRemoteDocumentKey::Key(Key("baz/qux/foo/bar"));
+  std::string bazKey = LevelDbRemoteDocumentKey::Key(Key("baz/qux"));
+
+  LevelDbMigrations::RunMigrations(_db.get(), 9);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write rows");
+    transaction.Put(fooKey, std::string(100, 'f'));
+    transaction.Put(nestedFooKey, std::string(10, 'f'));
+    transaction.Put(bazKey, std::string(1, 'b'));
+    // A stale row, as left behind by an SDK that doesn't maintain the table.
+    transaction.Put(LevelDbCollectionGroupSizeKey::Key("stale"),
+                    LevelDbCollectionGroupSizeKey::EncodeSize(42));
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 10);
+  LevelDbTransaction transaction(_db.get(), "Verify");
+  std::map<std::string, int64_t> sizes;
+  std::string prefix = LevelDbCollectionGroupSizeKey::KeyPrefix();
+  auto it = transaction.NewIterator();
+  LevelDbCollectionGroupSizeKey key;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix); it->Next()) {
+    XCTAssertTrue(key.Decode(it->key()));
+    sizes[key.collection_id()] = LevelDbCollectionGroupSizeKey::DecodeSize(it->value());
+  }
+
+  std::map<std::string, int64_t> expected{
+      {"foo", static_cast<int64_t>(fooKey.size() + 100 + nestedFooKey.size() + 10)},
+      {"baz", static_cast<int64_t>(bazKey.size() + 1)}};
+  XCTAssertTrue(sizes == expected);
+}
+
+- (void)testIndexesDocumentsByCollectionGroup {
+  std::string staleKey = LevelDbCollectionGroupDocumentKey::Key(Key("foo/removed"));
+
+  LevelDbMigrations::RunMigrations(_db.get(), 10);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write rows");
+    transaction.Put(LevelDbRemoteDocumentKey::Key(Key("foo/bar")), "f");
+    transaction.Put(LevelDbRemoteDocumentKey::Key(Key("baz/qux/foo/bar")), "f");
+    transaction.Put(LevelDbRemoteDocumentKey::Key(Key("baz/qux")), "b");
+    // A stale row, as left behind by an SDK that doesn't maintain the index.
+    std::string empty_buffer;
+    transaction.Put(staleKey, empty_buffer);
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 11);
+  LevelDbTransaction transaction(_db.get(), "Verify");
+  std::vector<DocumentKey> fooDocuments;
+  std::string prefix = LevelDbCollectionGroupDocumentKey::KeyPrefix("foo");
+  auto it = transaction.NewIterator();
+  LevelDbCollectionGroupDocumentKey key;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix); it->Next()) {
+    XCTAssertTrue(key.Decode(it->key()));
+    fooDocuments.push_back(key.document_key());
+  }
+
+  std::vector<DocumentKey> expected{Key("baz/qux/foo/bar"), Key("foo/bar")};
+  XCTAssertTrue(fooDocuments == expected);
+
+  std::string buffer;
+  XCTAssertTrue(
+      transaction.Get(LevelDbCollectionGroupDocumentKey::Key(Key("baz/qux")), &buffer).ok());
+  XCTAssertTrue(transaction.Get(staleKey, &buffer).IsNotFound());
+}
+
+- (void)testIndexesDocumentsByReadTime {
+  std::string empty_buffer;
+  SnapshotVersion staleReadTime{firebase::Timestamp{5, 0}};
+  std::string staleKey = LevelDbRemoteDocumentReadTimeKey::Key(Key("foo/removed"), staleReadTime);
+
+  LevelDbMigrations::RunMigrations(_db.get(), 11);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write rows");
+    // Documents that predate the index are assumed to have been read by the last remote event.
+    FSTPBTargetGlobal *metadata = LevelDbQueryCache::ReadMetadata(_db.get());
+    metadata.lastRemoteSnapshotVersion = [GPBTimestamp message];
+    metadata.lastRemoteSnapshotVersion.seconds = 100;
+    transaction.Put(LevelDbTargetGlobalKey::Key(), metadata);
+
+    transaction.Put(LevelDbRemoteDocumentKey::Key(Key("foo/a")), empty_buffer);
+    transaction.Put(LevelDbRemoteDocumentKey::Key(Key("foo/b")), empty_buffer);
+    // A stale row, as left behind by an SDK that doesn't maintain the index.
+    transaction.Put(staleKey, empty_buffer);
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 12);
+  LevelDbTransaction transaction(_db.get(), "Verify");
+  SnapshotVersion expectedReadTime{firebase::Timestamp{100, 0}};
+  std::vector<DocumentKey> fooDocuments;
+  std::string prefix = LevelDbRemoteDocumentReadTimeKey::KeyPrefix(Resource("foo"));
+  auto it = transaction.NewIterator();
+  LevelDbRemoteDocumentReadTimeKey key;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix); it->Next()) {
+    XCTAssertTrue(key.Decode(it->key()));
+    XCTAssertTrue(key.read_time() == expectedReadTime);
+    fooDocuments.push_back(key.document_key());
+  }
+
+  std::vector<DocumentKey> expected{Key("foo/a"), Key("foo/b")};
+  XCTAssertTrue(fooDocuments == expected);
+
+  std::string buffer;
+  XCTAssertTrue(transaction.Get(LevelDbDocumentReadTimeKey::Key(Key("foo/a")), &buffer).ok());
+  SnapshotVersion readTime;
+  XCTAssertTrue(LevelDbDocumentReadTimeKey::DecodeReadTime(buffer, &readTime));
+  XCTAssertTrue(readTime == expectedReadTime);
+  XCTAssertTrue(transaction.Get(staleKey, &buffer).IsNotFound());
+}
+
+- (void)testRewritesKeysWithTableTags {
+  std::string documentKey = LevelDbRemoteDocumentKey::Key(Key("foo/a"));
+  std::string sentinelKey = LevelDbDocumentTargetKey::SentinelKey(Key("foo/a"));
+  std::string empty_buffer;
+
+  LevelDbMigrations::RunMigrations(_db.get(), 12);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write rows");
+    // Left behind before a downgrade; the legacy row written since replaces it.
+    transaction.Put(documentKey, "stale");
+    transaction.Put(LegacyKey(documentKey, LevelDbRemoteDocumentKey::KeyPrefix(),
+                              LevelDbRemoteDocumentKey::LegacyKeyPrefix()),
+                    "document");
+    transaction.Put(LegacyKey(sentinelKey, LevelDbDocumentTargetKey::KeyPrefix(),
+                              LevelDbDocumentTargetKey::LegacyKeyPrefix()),
+                    "sentinel");
+    // Enough rows to take several transactions.
+    for (TargetId targetId = 1; targetId <= 1500; targetId++) {
+      std::string key = LevelDbTargetDocumentKey::Key(targetId, Key("foo/a"));
+      transaction.Put(LegacyKey(key, LevelDbTargetDocumentKey::KeyPrefix(),
+                                LevelDbTargetDocumentKey::LegacyKeyPrefix()),
+                      empty_buffer);
+    }
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 13);
+  XCTAssertEqual(13, LevelDbMigrations::ReadSchemaVersion(_db.get()));
+
+  LevelDbTransaction transaction(_db.get(), "Verify");
+  std::string buffer;
+  XCTAssertTrue(transaction.Get(documentKey, &buffer).ok());
+  XCTAssertEqual(buffer, "document");
+  XCTAssertTrue(transaction.Get(sentinelKey, &buffer).ok());
+  XCTAssertEqual(buffer, "sentinel");
+  for (TargetId targetId = 1; targetId <= 1500; targetId++) {
+    ASSERT_FOUND(transaction, LevelDbTargetDocumentKey::Key(targetId, Key("foo/a")));
+  }
+
+  auto it = transaction.NewIterator();
+  for (const std::string &prefix :
+       {LevelDbRemoteDocumentKey::LegacyKeyPrefix(), LevelDbDocumentTargetKey::LegacyKeyPrefix(),
+        LevelDbTargetDocumentKey::LegacyKeyPrefix()}) {
+    it->Seek(prefix);
+    XCTAssertFalse(it->Valid() && absl::StartsWith(it->key(), prefix));
+  }
+
+  FSTPBTargetGlobal *metadata = LevelDbQueryCache::ReadMetadata(_db.get());
+  XCTAssertEqual(metadata.byteSize, static_cast<int64_t>(documentKey.size() + 8));
+}
+
+- (void)testRewriteAfterDowngradeDropsRowsWrittenBeforeTheDowngrade {
+  std::string documentKeyA = LevelDbRemoteDocumentKey::Key(Key("foo/a"));
+  std::string documentKeyB = LevelDbRemoteDocumentKey::Key(Key("foo/b"));
+  std::string sentinelKeyA = LevelDbDocumentTargetKey::SentinelKey(Key("foo/a"));
+  std::string sentinelKeyB = LevelDbDocumentTargetKey::SentinelKey(Key("foo/b"));
+  TargetId targetID = 2;
+
+  LevelDbMigrations::RunMigrations(_db.get());
+  {
+    LevelDbTransaction transaction(_db.get(), "Write rows before the downgrade");
+    FSTPBTarget *target = [FSTPBTarget message];
+    target.targetId = targetID;
+    target.resumeToken = [@"token" dataUsingEncoding:NSUTF8StringEncoding];
+    transaction.Put(LevelDbTargetKey::Key(targetID), target);
+    transaction.Put(documentKeyA, "a");
+    transaction.Put(sentinelKeyA, "sentinel");
+    transaction.Put(documentKeyB, "b");
+    transaction.Put(sentinelKeyB, "sentinel");
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 12);
+  {
+    // The older SDK only sees the legacy tables: it doesn't know about foo/a, it writes foo/b
+    // again, and it gets a new resume token.
+    LevelDbTransaction transaction(_db.get(), "Write rows after the downgrade");
+    FSTPBTarget *target = [FSTPBTarget message];
+    target.targetId = targetID;
+    target.resumeToken = [@"older token" dataUsingEncoding:NSUTF8StringEncoding];
+    transaction.Put(LevelDbTargetKey::Key(targetID), target);
+    transaction.Put(LegacyKey(documentKeyB, LevelDbRemoteDocumentKey::KeyPrefix(),
+                              LevelDbRemoteDocumentKey::LegacyKeyPrefix()),
+                    "b updated");
+    transaction.Put(LegacyKey(sentinelKeyB, LevelDbDocumentTargetKey::KeyPrefix(),
+                              LevelDbDocumentTargetKey::LegacyKeyPrefix()),
+                    "sentinel updated");
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get());
+  XCTAssertEqual(13, LevelDbMigrations::ReadSchemaVersion(_db.get()));
+
+  LevelDbTransaction transaction(_db.get(), "Verify");
+  ASSERT_NOT_FOUND(transaction, documentKeyA);
+  ASSERT_NOT_FOUND(transaction, sentinelKeyA);
+  std::string buffer;
+  XCTAssertTrue(transaction.Get(documentKeyB, &buffer).ok());
+  XCTAssertEqual(buffer, "b updated");
+  XCTAssertTrue(transaction.Get(sentinelKeyB, &buffer).ok());
+  XCTAssertEqual(buffer, "sentinel updated");
+
+  // The target re-listens to its full result set.
+  FSTPBTarget *target = [self targetWithID:targetID transaction:&transaction];
+  XCTAssertEqual(target.targetId, targetID);
+  XCTAssertEqual(target.resumeToken.length, 0);
+}
+
+- (void)testDowngradeDropsResumeTokens {
+  std::string documentKey = LevelDbRemoteDocumentKey::Key(Key("foo/a"));
+  TargetId targetID = 2;
+
+  LevelDbMigrations::RunMigrations(_db.get());
+  {
+    LevelDbTransaction transaction(_db.get(), "Write rows before the downgrade");
+    FSTPBTarget *target = [FSTPBTarget message];
+    target.targetId = targetID;
+    target.resumeToken = [@"token" dataUsingEncoding:NSUTF8StringEncoding];
+    transaction.Put(LevelDbTargetKey::Key(targetID), target);
+    transaction.Put(documentKey, "a");
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 12);
+  XCTAssertEqual(12, LevelDbMigrations::ReadSchemaVersion(_db.get()));
+  {
+    // The older SDK doesn't find foo/a in its remote document table, so its target must not resume
+    // from a token that covers it.
+    LevelDbTransaction transaction(_db.get(), "Open after the downgrade");
+    ASSERT_NOT_FOUND(transaction, LegacyKey(documentKey, LevelDbRemoteDocumentKey::KeyPrefix(),
+                                            LevelDbRemoteDocumentKey::LegacyKeyPrefix()));
+    FSTPBTarget *target = [self targetWithID:targetID transaction:&transaction];
+    XCTAssertEqual(target.targetId, targetID);
+    XCTAssertEqual(target.resumeToken.length, 0);
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get());
+  XCTAssertEqual(13, LevelDbMigrations::ReadSchemaVersion(_db.get()));
+  LevelDbTransaction transaction(_db.get(), "Open after upgrading again");
+  FSTPBTarget *target = [self targetWithID:targetID transaction:&transaction];
+  XCTAssertEqual(target.targetId, targetID);
+  XCTAssertEqual(target.resumeToken.length, 0);
+}
+
+- (FSTPBTarget *)targetWithID:(TargetId)targetID transaction:(LevelDbTransaction *)transaction {
+  std::string buffer;
+  XCTAssertTrue(transaction->Get(LevelDbTargetKey::Key(targetID), &buffer).ok());
+  NSData *data = [[NSData alloc] initWithBytesNoCopy:(void *)buffer.data()
+                                              length:buffer.size()
+                                        freeWhenDone:NO];
+  NSError *error;
+  FSTPBTarget *target = [FSTPBTarget parseFromData:data error:&error];
+  XCTAssertNil(error);
+  return target;
+}
+
+- (void)testDefersBackfillsToBackgroundSteps {
+  std::string empty_buffer;
+  LevelDbMigrations::RunMigrations(_db.get(), 3);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write rows");
+    for (int i = 0; i < 5; i++) {
+      transaction.Put(LevelDbRemoteDocumentKey::Key(Key("docs/" + std::to_string(i))),
+                      empty_buffer);
+    }
+    transaction.Put(LevelDbDocumentMutationKey::Key("user", Key("rooms/a/messages/m"), 1),
+                    empty_buffer);
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 6, /*defer_backfills=*/true);
+  XCTAssertEqual(6, LevelDbMigrations::ReadSchemaVersion(_db.get()));
+  {
+    LevelDbTransaction transaction(_db.get(), "Verify pending");
+    XCTAssertTrue(LevelDbMigrations::IsBackfillPending(&transaction, 4));
+    XCTAssertTrue(LevelDbMigrations::IsBackfillPending(
+        &transaction, LevelDbMigrations::kCollectionParentsMigration));
+    ASSERT_NOT_FOUND(transaction, LevelDbDocumentTargetKey::SentinelKey(Key("docs/0")));
+    ASSERT_NOT_FOUND(transaction, LevelDbCollectionParentKey::Key("docs", {}));
+  }
+
+  std::vector<SchemaVersion> finished;
+  int steps = 0;
+  auto progress = [&finished](SchemaVersion version, int64_t, bool done) {
+    if (done) finished.push_back(version);
+  };
+  while (LevelDbMigrations::RunBackfillStep(_db.get(), 2, progress)) {
+    steps++;
+  }
+  steps++;
+
+  // Five documents take three steps, then six rows (documents and mutations) take three more.
+  XCTAssertEqual(6, steps);
+  XCTAssertTrue((finished == std::vector<SchemaVersion>{4, 6}));
+
+  LevelDbTransaction transaction(_db.get(), "Verify backfill");
+  XCTAssertFalse(LevelDbMigrations::IsBackfillPending(&transaction, 4));
+  XCTAssertFalse(LevelDbMigrations::IsBackfillPending(
+      &transaction, LevelDbMigrations::kCollectionParentsMigration));
+  for (int i = 0; i < 5; i++) {
+    ASSERT_FOUND(transaction,
+                 LevelDbDocumentTargetKey::SentinelKey(Key("docs/" + std::to_string(i))));
+  }
+  ASSERT_FOUND(transaction, LevelDbCollectionParentKey::Key("docs", {}));
+  ASSERT_FOUND(transaction,
+               LevelDbCollectionParentKey::Key("messages", Key("rooms/a").path()));
+}
+
+- (void)testBlockingMigrationsCompletePendingBackfills {
+  std::string empty_buffer;
+  LevelDbMigrations::RunMigrations(_db.get(), 5);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write rows");
+    transaction.Put(LevelDbRemoteDocumentKey::Key(Key("docs/a")), empty_buffer);
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 6, /*defer_backfills=*/true);
+  LevelDbMigrations::RunMigrations(_db.get());
+
+  LevelDbTransaction transaction(_db.get(), "Verify");
+  XCTAssertFalse(LevelDbMigrations::IsBackfillPending(
+      &transaction, LevelDbMigrations::kCollectionParentsMigration));
+  ASSERT_FOUND(transaction, LevelDbCollectionParentKey::Key("docs", {}));
+}
+
 - (void)testCanDowngrade {
   // First, run all of the migrations
   LevelDbMigrations::RunMigrations(_db.get());
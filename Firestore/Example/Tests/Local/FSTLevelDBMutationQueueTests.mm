@@ -14,21 +14,28 @@
  * limitations under the License.
  */
 
+#import <FirebaseFirestore/FIRTimestamp.h>
 #import <XCTest/XCTest.h>
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #import "Firestore/Example/Tests/Local/FSTMutationQueueTests.h"
 #import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
 #import "Firestore/Protos/objc/firestore/local/Mutation.pbobjc.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTMutationBatch.h"
 
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_mutation_queue.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_snapshot_reader.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "absl/strings/string_view.h"
 #include "leveldb/db.h"
 
@@ -37,15 +44,19 @@ NS_ASSUME_NONNULL_BEGIN
 using firebase::firestore::auth::User;
 using firebase::firestore::local::LevelDbMutationKey;
 using firebase::firestore::local::LevelDbMutationQueue;
+using firebase::firestore::local::LevelDbSnapshotReader;
 using firebase::firestore::local::LoadNextBatchIdFromDb;
 using firebase::firestore::local::ReferenceSet;
 using firebase::firestore::model::BatchId;
+using firebase::firestore::model::DocumentMap;
 using firebase::firestore::util::OrderedCode;
 using leveldb::DB;
 using leveldb::Slice;
 using leveldb::Status;
 using leveldb::WriteOptions;
 
+namespace testutil = firebase::firestore::testutil;
+
 // A dummy mutation value, useful for testing code that's known to examine only mutation keys.
 static const char *kDummy = "1";
 
@@ -158,6 +169,35 @@ std::string MutationLikeKey(absl::string_view table, absl::string_view userID, B
   XCTAssertEqualObjects(parsedMessage.lastStreamToken, defaultMessage.lastStreamToken);
 }
 
+- (void)testSnapshotReaderIgnoresLaterWrites {
+  FSTDocument *doc = FSTTestDoc("foo/bar", 1, @{@"a" : @1}, FSTDocumentStateSynced);
+  FSTMutationBatch *batch;
+  std::unique_ptr<LevelDbSnapshotReader> reader;
+  self.persistence.run("testSnapshotReaderIgnoresLaterWrites setup", [&]() {
+    _db.remoteDocumentCache->Add(doc, doc.version);
+    batch = self.mutationQueue->AddMutationBatch(
+        [FIRTimestamp timestamp], {}, {FSTTestPatchMutation("foo/bar", @{@"b" : @2}, {})});
+    reader = [_db newSnapshotReader];
+  });
+
+  self.persistence.run("testSnapshotReaderIgnoresLaterWrites write", [&]() {
+    self.mutationQueue->RemoveMutationBatch(batch);
+    _db.remoteDocumentCache->Add(FSTTestDoc("foo/bar", 2, @{@"a" : @3}, FSTDocumentStateSynced),
+                                 testutil::Version(2));
+    _db.remoteDocumentCache->Add(FSTTestDoc("foo/baz", 2, @{@"a" : @4}, FSTDocumentStateSynced),
+                                 testutil::Version(2));
+  });
+
+  FSTDocument *expected = FSTTestDoc("foo/bar", 1, @{@"a" : @1, @"b" : @2},
+                                     FSTDocumentStateLocalMutations);
+  XCTAssertEqualObjects(reader->GetDocument(FSTTestDocKey(@"foo/bar")), expected);
+
+  DocumentMap docs = reader->GetDocumentsMatchingQuery(FSTTestQuery("foo"));
+  XCTAssertEqual(docs.size(), 1);
+  XCTAssertEqualObjects(docs.underlying_map().find(FSTTestDocKey(@"foo/bar"))->second, expected);
+  reader.reset();
+}
+
 - (void)setDummyValueForKey:(const std::string &)key {
   _db.ptr->Put(WriteOptions(), key, kDummy);
 }
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <string>
+
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
@@ -26,6 +28,7 @@
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
@@ -36,6 +39,7 @@ using firebase::firestore::local::LevelDbQueryCache;
 using firebase::firestore::local::ReferenceSet;
 using firebase::firestore::model::DatabaseId;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::model::SnapshotVersion;
@@ -146,6 +150,45 @@ NS_ASSUME_NONNULL_BEGIN
   });
 }
 
+- (void)testCompactTargetDocuments {
+  self.persistence.run("testCompactTargetDocuments", [&]() {
+    LevelDbQueryCache *cache = [self getCache:self.persistence];
+    cache->set_compact_target_documents_enabled(true);
+
+    // Enough keys to be split across several blocks.
+    DocumentKeySet keys;
+    for (int i = 0; i < 2000; i++) {
+      keys = keys.insert(testutil::Key("rooms/" + std::to_string(i)));
+    }
+    DocumentKeySet odd;
+    for (int i = 1; i < 2000; i += 2) {
+      odd = odd.insert(testutil::Key("rooms/" + std::to_string(i)));
+    }
+    cache->AddMatchingKeys(keys, 1);
+    cache->AddMatchingKeys(DocumentKeySet{testutil::Key("rooms/other")}, 2);
+    XCTAssertEqual(cache->GetMatchingKeys(1), keys);
+
+    cache->RemoveMatchingKeys(odd, 1);
+    DocumentKeySet even = keys;
+    for (const DocumentKey &key : odd) {
+      even = even.erase(key);
+    }
+    XCTAssertEqual(cache->GetMatchingKeys(1), even);
+    XCTAssertFalse(cache->Contains(testutil::Key("rooms/1")));
+    XCTAssertTrue(cache->Contains(testutil::Key("rooms/2")));
+
+    // Keys stored one per row are read alongside the blocks.
+    cache->set_compact_target_documents_enabled(false);
+    cache->AddMatchingKeys(DocumentKeySet{testutil::Key("rooms/1"), testutil::Key("rooms/2")}, 1);
+    XCTAssertEqual(cache->GetMatchingKeys(1), even.insert(testutil::Key("rooms/1")));
+
+    cache->RemoveAllKeysForTarget(1);
+    XCTAssertEqual(cache->GetMatchingKeys(1), DocumentKeySet{});
+    XCTAssertFalse(cache->Contains(testutil::Key("rooms/2")));
+    XCTAssertEqual(cache->GetMatchingKeys(2), DocumentKeySet{testutil::Key("rooms/other")});
+  });
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -17,23 +17,43 @@
 #include <memory>
 #include <string>
 
+#import <FirebaseFirestore/FIRTimestamp.h>
+
 #import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
 #import "Firestore/Example/Tests/Local/FSTRemoteDocumentCacheTests.h"
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_document_compressor.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "absl/memory/memory.h"
 #include "leveldb/db.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+using leveldb::ReadOptions;
+using leveldb::Status;
 using leveldb::WriteOptions;
+using firebase::firestore::local::LevelDbDocumentCompressor;
 using firebase::firestore::local::LevelDbRemoteDocumentCache;
+using firebase::firestore::local::LevelDbRemoteDocumentKey;
 using firebase::firestore::local::RemoteDocumentCache;
+using firebase::firestore::model::Document;
+using firebase::firestore::model::DocumentKeySet;
+using firebase::firestore::model::FieldValue;
+using firebase::firestore::model::MaybeDocument;
+using firebase::firestore::model::SnapshotVersion;
+using firebase::firestore::testutil::Field;
+using firebase::firestore::testutil::Key;
 using firebase::firestore::util::OrderedCode;
 
+namespace testutil = firebase::firestore::testutil;
+
 // A dummy document value, useful for testing code that's known to examine only document keys.
 static const char *kDummy = "1";
 
@@ -75,6 +95,144 @@ static const char *kDummy = "1";
   _db = nil;
 }
 
+- (void)testGetAllModels {
+  SnapshotVersion readTime = testutil::Version(42);
+  self.persistence.run("testGetAllModels", [&]() {
+    _cache->Add(FSTTestDoc("a/1", 42, @{@"x" : @1}, FSTDocumentStateSynced), readTime);
+    _cache->Add(FSTTestDeletedDoc("a/2", 42, NO), readTime);
+
+    LevelDbRemoteDocumentCache::ModelMaybeDocumentMap results =
+        _cache->GetAllModels(DocumentKeySet{Key("a/1"), Key("a/2"), Key("a/3")});
+    XCTAssertEqual(results.size(), 3);
+
+    const auto &doc = results[Key("a/1")];
+    XCTAssertEqual(doc->type(), MaybeDocument::Type::Document);
+    XCTAssertTrue(*static_cast<Document *>(doc.get())->field(Field("x")) ==
+                  FieldValue::FromInteger(1));
+    XCTAssertEqual(results[Key("a/2")]->type(), MaybeDocument::Type::NoDocument);
+    XCTAssertTrue(results[Key("a/3")] == nullptr);
+  });
+}
+
+- (void)testGetMatchingModels {
+  SnapshotVersion readTime = testutil::Version(42);
+  self.persistence.run("testGetMatchingModels", [&]() {
+    _cache->Add(FSTTestDoc("a/1", 42, @{@"x" : @1}, FSTDocumentStateSynced), readTime);
+    _cache->Add(FSTTestDoc("a/2", 42, @{@"x" : @2}, FSTDocumentStateSynced), readTime);
+    _cache->Add(FSTTestDoc("a/1/b/1", 42, @{@"x" : @1}, FSTDocumentStateSynced), readTime);
+    _cache->Add(FSTTestDoc("c/1", 42, @{@"x" : @1}, FSTDocumentStateSynced), readTime);
+    _cache->Add(FSTTestDeletedDoc("a/3", 42, NO), readTime);
+
+    LevelDbRemoteDocumentCache::ModelDocumentMap results = _cache->GetMatchingModels(
+        testutil::Query("a").Filter(testutil::Filter("x", "==", 1)));
+    XCTAssertEqual(results.size(), 1);
+    XCTAssertTrue(results.begin()->first == Key("a/1"));
+  });
+}
+
+- (void)testCachesDecodedDocuments {
+  SnapshotVersion readTime = testutil::Version(42);
+  self.persistence.run("testCachesDecodedDocuments", [&]() {
+    FSTMaybeDocument *doc = FSTTestDoc("a/1", 42, @{@"x" : @1}, FSTDocumentStateSynced);
+    _cache->Add(doc, readTime);
+
+    FSTMaybeDocument *first = _cache->Get(Key("a/1"));
+    XCTAssertEqualObjects(first, doc);
+    XCTAssertEqual(_cache->decoded_cache_misses(), 1);
+    XCTAssertEqual(_cache->decoded_cache_hits(), 0);
+
+    XCTAssertEqual(_cache->Get(Key("a/1")), first);
+    _cache->GetAll(DocumentKeySet{Key("a/1")});
+    XCTAssertEqual(_cache->decoded_cache_misses(), 1);
+    XCTAssertEqual(_cache->decoded_cache_hits(), 2);
+
+    FSTMaybeDocument *updated = FSTTestDoc("a/1", 43, @{@"x" : @2}, FSTDocumentStateSynced);
+    _cache->Add(updated, testutil::Version(43));
+    XCTAssertEqualObjects(_cache->Get(Key("a/1")), updated);
+    XCTAssertEqual(_cache->decoded_cache_misses(), 2);
+
+    _cache->Remove(Key("a/1"));
+    XCTAssertNil(_cache->Get(Key("a/1")));
+  });
+}
+
+- (void)testNativeSerializationMatchesObjectiveCSerialization {
+  LevelDbRemoteDocumentCache nativeCache(_db, _db.serializer);
+  nativeCache.set_native_serialization_enabled(true);
+
+  NSDictionary<NSString *, id> *data = @{
+    @"null" : [NSNull null],
+    @"bool" : @YES,
+    @"integer" : @1,
+    @"double" : @1.5,
+    @"string" : @"a",
+    @"timestamp" : [FIRTimestamp timestampWithSeconds:1 nanoseconds:2],
+    @"blob" : FSTTestData(1, 2, 3, -1),
+    @"geoPoint" : FSTTestGeoPoint(1.5, 2.5),
+    @"array" : @[ @1, @"b", @[ @2 ] ],
+    @"map" : @{@"nested" : @{@"c" : @3}},
+  };
+  NSArray<FSTMaybeDocument *> *docs = @[
+    FSTTestDoc("a/synced", 42, data, FSTDocumentStateSynced),
+    FSTTestDoc("a/committed", 42, data, FSTDocumentStateCommittedMutations),
+    // References aren't supported natively yet, so these fall back to the protos.
+    FSTTestDoc("a/reference", 42, @{@"ref" : FSTTestRef("p", "d", @"b/1")},
+               FSTDocumentStateSynced),
+    FSTTestDeletedDoc("a/deleted", 42, NO),
+    FSTTestDeletedDoc("a/deletedCommitted", 42, YES),
+    FSTTestUnknownDoc("a/unknown", 42),
+  ];
+
+  self.persistence.run("testNativeSerializationMatchesObjectiveCSerialization", [&]() {
+    for (FSTMaybeDocument *doc in docs) {
+      nativeCache.Add(doc, doc.version);
+      XCTAssertEqualObjects(_cache->Get(doc.key), doc);
+
+      _cache->Add(doc, doc.version);
+      XCTAssertEqualObjects(nativeCache.Get(doc.key), doc);
+    }
+  });
+}
+
+- (void)testCompressedDocumentsReadBack {
+  _cache->set_value_compression_enabled(true);
+  NSMutableArray<FSTMaybeDocument *> *docs = [NSMutableArray array];
+  NSString *description = [@"" stringByPaddingToLength:300
+                                             withString:@"lorem ipsum "
+                                        startingAtIndex:0];
+  for (int i = 0; i < 12; ++i) {
+    std::string path = "coll/doc" + std::to_string(i);
+    [docs addObject:FSTTestDoc(path, 42, @{@"description" : description, @"index" : @(i)},
+                               FSTDocumentStateSynced)];
+  }
+
+  self.persistence.run("testCompressedDocumentsReadBack", [&]() {
+    for (FSTMaybeDocument *doc in docs) {
+      _cache->Add(doc, doc.version);
+    }
+  });
+
+  // The first documents of a collection are sampled to train its dictionary and stay raw.
+  std::string value;
+  Status status =
+      _db.ptr->Get(ReadOptions(), LevelDbRemoteDocumentKey::Key(Key("coll/doc0")), &value);
+  XCTAssertTrue(status.ok());
+  XCTAssertFalse(LevelDbDocumentCompressor::IsCompressed(value));
+  status = _db.ptr->Get(ReadOptions(), LevelDbRemoteDocumentKey::Key(Key("coll/doc11")), &value);
+  XCTAssertTrue(status.ok());
+  XCTAssertTrue(LevelDbDocumentCompressor::IsCompressed(value));
+
+  // Reads don't depend on the setting, nor on the state of the instance that wrote them.
+  LevelDbRemoteDocumentCache otherCache(_db, _db.serializer);
+  self.persistence.run("testCompressedDocumentsReadBack", [&]() {
+    for (FSTMaybeDocument *doc in docs) {
+      XCTAssertEqualObjects(otherCache.Get(doc.key), doc);
+    }
+    XCTAssertEqual(otherCache.GetMatching(FSTTestQuery("coll"), nullptr).size(), docs.count);
+    XCTAssertEqual(otherCache.GetMatchingModels(testutil::Query("coll")).size(), docs.count);
+  });
+}
+
 - (void)writeDummyRowWithSegments:(NSArray<NSString *> *)segments {
   std::string key;
   for (NSString *segment in segments) {
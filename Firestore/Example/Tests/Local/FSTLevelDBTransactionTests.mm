@@ -18,6 +18,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 // This is out of order to satisfy the linter, which doesn't realize this is
 // the header corresponding to this test.
@@ -25,15 +26,19 @@
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
 
 #import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
+#import "Firestore/Source/Local/FSTLevelDB.h"
 #import "Firestore/Protos/objc/firestore/local/Mutation.pbobjc.h"
 #import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
 
+#include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
 #include "absl/strings/string_view.h"
 #include "leveldb/db.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+using firebase::firestore::api::PersistenceSettings;
 using firebase::firestore::local::LevelDbMutationKey;
 using firebase::firestore::local::LevelDbTransaction;
 using firebase::firestore::util::Path;
@@ -282,6 +287,139 @@ using leveldb::WriteOptions;
   XCTAssertFalse(it->Valid());
 }
 
+- (void)testMaintenanceIteratorMergesPendingChanges {
+  for (int i = 0; i < 3; ++i) {
+    Status status = _db->Put(LevelDbTransaction::DefaultWriteOptions(), "key_" + std::to_string(i),
+                             "value_" + std::to_string(i));
+    XCTAssertTrue(status.ok());
+  }
+
+  LevelDbTransaction transaction(_db.get(), "testMaintenanceIteratorMergesPendingChanges");
+  transaction.Delete("key_1");
+  transaction.Put("key_3", "value_3");
+
+  std::vector<std::string> keys;
+  auto it = transaction.NewMaintenanceIterator();
+  for (it->Seek("key_0"); it->Valid(); it->Next()) {
+    keys.emplace_back(it->key());
+  }
+  XCTAssertEqual(keys, (std::vector<std::string>{"key_0", "key_2", "key_3"}));
+}
+
+- (void)testPutOverwritesPendingValue {
+  LevelDbTransaction transaction(_db.get(), "testPutOverwritesPendingValue");
+  transaction.Put("key", "value1");
+  transaction.Put("key", "value2");
+
+  std::string value;
+  Status status = transaction.Get("key", &value);
+  XCTAssertTrue(status.ok());
+  XCTAssertEqual(value, "value2");
+  XCTAssertEqual(transaction.changed_keys(), 1);
+
+  transaction.Commit();
+  status = _db->Get(LevelDbTransaction::DefaultReadOptions(), "key", &value);
+  XCTAssertTrue(status.ok());
+  XCTAssertEqual(value, "value2");
+}
+
+- (void)testCommitsManyLargeChanges {
+  // Write enough data to span several of the transaction's internal blocks, including values
+  // larger than a single block.
+  LevelDbTransaction transaction(_db.get(), "testCommitsManyLargeChanges");
+  for (int i = 0; i < 1000; ++i) {
+    transaction.Put("key_" + std::to_string(i), std::string(static_cast<size_t>(i) * 200, 'v'));
+  }
+  transaction.Commit();
+
+  for (int i = 0; i < 1000; ++i) {
+    std::string value;
+    Status status =
+        _db->Get(LevelDbTransaction::DefaultReadOptions(), "key_" + std::to_string(i), &value);
+    XCTAssertTrue(status.ok());
+    XCTAssertEqual(value.size(), static_cast<size_t>(i) * 200);
+  }
+}
+
+- (void)testGroupCommitHoldsBackSmallCommits {
+  _db.reset();
+  PersistenceSettings settings;
+  settings.group_commit_delay_ms = 100;
+  FSTLevelDB *ldb;
+  XCTAssertTrue([FSTLevelDB dbWithDirectory:[FSTPersistenceTestHelpers levelDBDir]
+                                 serializer:[FSTPersistenceTestHelpers localSerializer]
+                                  lruParams:firebase::firestore::local::LruParams::Default()
+                        persistenceSettings:settings
+                                        ptr:&ldb]
+                    .ok());
+  __block int groups = 0;
+  ldb.groupCommitHandler = ^{
+    ++groups;
+  };
+
+  // Small commits are held back, but read by the transactions that follow them.
+  ldb.run("first", [&] { ldb.currentTransaction->Put("key1", "value1"); });
+  ldb.run("second", [&] {
+    std::string value;
+    XCTAssertTrue(ldb.currentTransaction->Get("key1", &value).ok());
+    XCTAssertEqual(value, "value1");
+    ldb.currentTransaction->Put("key2", "value2");
+  });
+  XCTAssertEqual(groups, 1);
+
+  // Getting the database flushes them.
+  std::string value;
+  XCTAssertTrue(ldb.ptr->Get(LevelDbTransaction::DefaultReadOptions(), "key2", &value).ok());
+  XCTAssertEqual(value, "value2");
+
+  // Large commits are written right away, along with the commits held back before them.
+  ldb.run("third", [&] { ldb.currentTransaction->Put("key3", "value3"); });
+  XCTAssertEqual(groups, 2);
+  ldb.run("large", [&] {
+    for (int i = 0; i < 1000; ++i) {
+      ldb.currentTransaction->Put("large_" + std::to_string(i), "value");
+    }
+  });
+  ldb.run("fourth", [&] { ldb.currentTransaction->Put("key4", "value4"); });
+  XCTAssertEqual(groups, 3);
+  XCTAssertTrue(ldb.ptr->Get(LevelDbTransaction::DefaultReadOptions(), "large_0", &value).ok());
+  XCTAssertTrue(ldb.ptr->Get(LevelDbTransaction::DefaultReadOptions(), "key4", &value).ok());
+  [ldb shutdown];
+}
+
+- (void)testCopiesOfExportedSnapshotsCanBeOpened {
+  _db.reset();
+  Path dir = [FSTPersistenceTestHelpers levelDBDir];
+  Path exportDir = Path::FromUtf8(dir.ToUtf8String() + "-export");
+  Path copyDir = Path::FromUtf8(dir.ToUtf8String() + "-copy");
+  XCTAssertTrue(firebase::firestore::util::RecursivelyDelete(exportDir).ok());
+
+  // Without an export there is nothing to copy, so the copy starts out empty.
+  XCTAssertTrue([FSTLevelDB copyLatestExportFromDirectory:exportDir toDirectory:copyDir].ok());
+
+  FSTLevelDB *ldb;
+  XCTAssertTrue([FSTLevelDB dbWithDirectory:dir
+                                 serializer:[FSTPersistenceTestHelpers localSerializer]
+                                  lruParams:firebase::firestore::local::LruParams::Default()
+                        persistenceSettings:PersistenceSettings{}
+                                        ptr:&ldb]
+                    .ok());
+  ldb.run("exported", [&] { ldb.currentTransaction->Put("key1", "value1"); });
+  [ldb exportSnapshotToDirectory:exportDir];
+  ldb.run("not exported", [&] { ldb.currentTransaction->Put("key2", "value2"); });
+  // Waits for the export to finish.
+  [ldb shutdown];
+
+  XCTAssertTrue([FSTLevelDB copyLatestExportFromDirectory:exportDir toDirectory:copyDir].ok());
+  DB *db;
+  XCTAssertTrue(DB::Open(Options(), copyDir.ToUtf8String(), &db).ok());
+  _db.reset(db);
+  std::string value;
+  XCTAssertTrue(_db->Get(ReadOptions(), "key1", &value).ok());
+  XCTAssertEqual(value, "value1");
+  XCTAssertTrue(_db->Get(ReadOptions(), "key2", &value).IsNotFound());
+}
+
 - (void)testToString {
   std::string key = LevelDbMutationKey::Key("user1", 42);
   FSTPBWriteBatch *message = [FSTPBWriteBatch message];
@@ -19,11 +19,13 @@
 #import <FirebaseFirestore/FIRTimestamp.h>
 #import <XCTest/XCTest.h>
 
+#include <string>
 #include <utility>
 #include <vector>
 
 #import "Firestore/Source/API/FIRFieldValue+Internal.h"
 #import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Local/FSTLocalViewChanges.h"
 #import "Firestore/Source/Local/FSTLocalWriteResult.h"
 #import "Firestore/Source/Local/FSTPersistence.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
@@ -38,22 +40,33 @@
 #import "Firestore/third_party/Immutable/Tests/FSTImmutableSortedSet+Testing.h"
 
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/memory_stats.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 
 namespace testutil = firebase::firestore::testutil;
 using firebase::firestore::auth::User;
+using firebase::firestore::core::DocumentSizer;
+using firebase::firestore::core::MemoryStats;
+using firebase::firestore::local::QueryAccessPath;
+using firebase::firestore::local::QueryExecutionStats;
+using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::DocumentMap;
+using firebase::firestore::model::kBatchIdUnknown;
 using firebase::firestore::model::MaybeDocumentMap;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::remote::DocumentWatchChange;
 using firebase::firestore::remote::RemoteEvent;
 using firebase::firestore::remote::TestTargetMetadataProvider;
 using firebase::firestore::remote::WatchChangeAggregator;
@@ -61,6 +74,11 @@ using firebase::firestore::remote::WatchTargetChange;
 using firebase::firestore::remote::WatchTargetChangeState;
 using firebase::firestore::util::Status;
 
+/** Returns the path of the document with the given index, padded so that paths sort by index. */
+static std::string FSTTestPaddedPath(absl::string_view collection, int index) {
+  return absl::StrCat(collection, "/", absl::Dec(index, absl::kZeroPad3));
+}
+
 static NSArray<FSTDocument *> *docMapToArray(const DocumentMap &docs) {
   NSMutableArray<FSTDocument *> *result = [NSMutableArray array];
   for (const auto &kv : docs.underlying_map()) {
@@ -174,6 +192,19 @@ NS_ASSUME_NONNULL_BEGIN
   _lastChanges = [self.localStore rejectBatchID:batch.batchID];
 }
 
+/** Applies a remote event that updates the given documents in the given target. */
+- (void)applyRemoteEventWithDocuments:(NSArray<FSTMaybeDocument *> *)docs
+                             targetID:(TargetId)targetID
+                              version:(FSTTestSnapshotVersion)version {
+  auto metadataProvider =
+      TestTargetMetadataProvider::CreateEmptyResultProvider(docs[0].key, {targetID});
+  WatchChangeAggregator aggregator{&metadataProvider};
+  for (FSTMaybeDocument *doc in docs) {
+    aggregator.HandleDocumentChange(DocumentWatchChange{{targetID}, {}, doc.key, doc});
+  }
+  [self applyRemoteEvent:aggregator.CreateRemoteEvent(testutil::Version(version))];
+}
+
 - (TargetId)allocateQuery:(FSTQuery *)query {
   FSTQueryData *queryData = [self.localStore allocateQuery:query];
   self.lastTargetID = queryData.targetID;
@@ -885,6 +916,28 @@ NS_ASSUME_NONNULL_BEGIN
       ]));
 }
 
+- (void)testCanExecuteCollectionGroupQueriesAcrossManyParents {
+  if ([self isTestBaseClass]) return;
+
+  std::vector<FSTMutation *> mutations;
+  NSMutableArray<FSTDocument *> *expected = [NSMutableArray array];
+  for (int i = 0; i < 10; ++i) {
+    std::string path = "a/" + std::to_string(i) + "/b/doc";
+    mutations.push_back(FSTTestSetMutation(@(path.c_str()), @{@"i" : @(i)}));
+    if (i != 3) {
+      [expected addObject:FSTTestDoc(path, 0, @{@"i" : @(i)}, FSTDocumentStateLocalMutations)];
+    }
+  }
+  mutations.push_back(FSTTestSetMutation(@"a/0/bb/doc", @{@"i" : @0}));
+  mutations.push_back(FSTTestDeleteMutation(@"a/3/b/doc"));
+  [self.localStore locallyWriteMutations:std::move(mutations)];
+
+  FSTQuery *query = [FSTQuery queryWithPath:firebase::firestore::model::ResourcePath{}
+                            collectionGroup:@"b"];
+  DocumentMap docs = [self.localStore executeQuery:query];
+  XCTAssertEqualObjects(docMapToArray(docs), expected);
+}
+
 - (void)testCanExecuteMixedCollectionQueries {
   if ([self isTestBaseClass]) return;
 
@@ -909,6 +962,260 @@ NS_ASSUME_NONNULL_BEGIN
                         ]));
 }
 
+- (void)testCollectionQueriesReflectRemoteChangesUnderPendingMutations {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery("foo");
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/bar", 1, @{@"a" : @1}, FSTDocumentStateSynced), {2},
+                             {})];
+  [self writeMutation:FSTTestPatchMutation("foo/bar", @{@"b" : @2}, {})];
+
+  DocumentMap docs = [self.localStore executeQuery:query];
+  XCTAssertEqualObjects(docMapToArray(docs), @[ FSTTestDoc("foo/bar", 1, @{@"a" : @1, @"b" : @2},
+                                                           FSTDocumentStateLocalMutations) ]);
+
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/bar", 2, @{@"a" : @3}, FSTDocumentStateSynced), {2},
+                             {})];
+  docs = [self.localStore executeQuery:query];
+  XCTAssertEqualObjects(docMapToArray(docs), @[ FSTTestDoc("foo/bar", 2, @{@"a" : @3, @"b" : @2},
+                                                           FSTDocumentStateLocalMutations) ]);
+
+  [self rejectMutation];
+  docs = [self.localStore executeQuery:query];
+  XCTAssertEqualObjects(docMapToArray(docs),
+                        @[ FSTTestDoc("foo/bar", 2, @{@"a" : @3}, FSTDocumentStateSynced) ]);
+}
+
+- (void)testCollectionQueriesApplyDeleteThenPatchToDocumentsOutsideTheRemoteResults {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = [FSTTestQuery("foo") queryByAddingFilter:FSTTestFilter("matches", @"==", @YES)];
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  // foo/bar is cached but doesn't match remotely, so the remote document cache may skip it. foo/baz
+  // isn't cached at all.
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/bar", 1, @{@"matches" : @NO}, FSTDocumentStateSynced),
+                             {2}, {})];
+  [self writeMutation:FSTTestDeleteMutation(@"foo/bar")];
+  [self writeMutation:FSTTestPatchMutation("foo/bar", @{@"matches" : @YES}, {})];
+  [self writeMutation:FSTTestDeleteMutation(@"foo/baz")];
+  [self writeMutation:FSTTestPatchMutation("foo/baz", @{@"matches" : @YES}, {})];
+
+  // The patches apply to the deleted documents, so their preconditions fail.
+  DocumentMap docs = [self.localStore executeQuery:query];
+  XCTAssertEqual(docs.size(), 0);
+}
+
+- (void)testReadsDenseAndSparseRunsOfChangedDocuments {
+  if ([self isTestBaseClass]) return;
+
+  TargetId targetID = [self allocateQuery:FSTTestQuery("foo")];
+
+  // Reading back the documents of a remote event sweeps through their collection, and only seeks
+  // when the next document is more than 16 rows ahead.
+  NSMutableArray<FSTMaybeDocument *> *dense = [NSMutableArray array];
+  for (int i = 0; i < 100; ++i) {
+    [dense addObject:FSTTestDoc(FSTTestPaddedPath("foo", i), 1, @{@"n" : @(i)},
+                                FSTDocumentStateSynced)];
+  }
+  [self applyRemoteEventWithDocuments:dense targetID:targetID version:1];
+  FSTAssertChanged(dense);
+
+  // These are 15, 16 and 17 rows apart, and the last one is new.
+  NSMutableArray<FSTMaybeDocument *> *sparse = [NSMutableArray array];
+  for (int i : {0, 15, 31, 48, 64, 99, 100}) {
+    [sparse addObject:FSTTestDoc(FSTTestPaddedPath("foo", i), 2, @{@"n" : @(-i)},
+                                 FSTDocumentStateSynced)];
+  }
+  [self applyRemoteEventWithDocuments:sparse targetID:targetID version:2];
+  FSTAssertChanged(sparse);
+
+  for (FSTMaybeDocument *doc in sparse) {
+    FSTAssertContains(doc);
+  }
+  for (int i : {1, 16, 47, 49, 98}) {
+    FSTAssertContains(FSTTestDoc(FSTTestPaddedPath("foo", i), 1, @{@"n" : @(i)},
+                                 FSTDocumentStateSynced));
+  }
+}
+
+- (void)testCollectionQueriesReadDenseAndSparseRunsOfMutatedDocuments {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = [FSTTestQuery("foo") queryByAddingFilter:FSTTestFilter("matches", @"==", @YES)];
+  TargetId targetID = [self allocateQuery:query];
+
+  NSMutableArray<FSTMaybeDocument *> *docs = [NSMutableArray array];
+  for (int i = 0; i < 100; ++i) {
+    [docs addObject:FSTTestDoc(FSTTestPaddedPath("foo", i), 1, @{@"n" : @(i), @"matches" : @NO},
+                               FSTDocumentStateSynced)];
+  }
+  [self applyRemoteEventWithDocuments:docs targetID:targetID version:1];
+  // Once the LevelDB cache has indexed the collection, it skips documents that don't match.
+  XCTAssertEqual([self.localStore executeQuery:query].size(), 0);
+
+  // None of the documents match remotely, so the query reads the ones that match locally in one
+  // batch: a dense run of 20 documents, then documents 16 and 17 rows apart, the last one and one
+  // that isn't cached.
+  std::vector<int> patched;
+  for (int i = 0; i < 20; ++i) {
+    patched.push_back(i);
+  }
+  for (int i : {35, 52, 99}) {
+    patched.push_back(i);
+  }
+  std::vector<FSTMutation *> mutations;
+  NSMutableArray<FSTDocument *> *expected = [NSMutableArray array];
+  for (int i : patched) {
+    std::string path = FSTTestPaddedPath("foo", i);
+    mutations.push_back(FSTTestPatchMutation(path, @{@"matches" : @YES}, {}));
+    [expected addObject:FSTTestDoc(path, 1, @{@"n" : @(i), @"matches" : @YES},
+                                   FSTDocumentStateLocalMutations)];
+  }
+  mutations.push_back(FSTTestSetMutation(@"foo/100", @{@"matches" : @YES}));
+  [expected addObject:FSTTestDoc("foo/100", 0, @{@"matches" : @YES},
+                                 FSTDocumentStateLocalMutations)];
+  [self writeMutations:std::move(mutations)];
+  // Without the cached local views, the query reads the mutated documents itself.
+  [self.localStore releaseRebuildableMemory];
+
+  DocumentMap results = [self.localStore executeQuery:query];
+  XCTAssertEqualObjects(docMapToArray(results), expected);
+}
+
+- (void)testLimitQueriesOnlyReadTheFirstDocuments {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery("foo");
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  for (int i = 0; i < 30; ++i) {
+    std::string path = "foo/" + std::to_string(i);
+    [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                               FSTTestDoc(path, 10, @{@"i" : @(i)}, FSTDocumentStateSynced), {2},
+                               {})];
+  }
+  // Moves the last document to the front, and the first one to the back.
+  [self writeMutation:FSTTestPatchMutation("foo/29", @{@"i" : @-1}, {})];
+  [self writeMutation:FSTTestPatchMutation("foo/0", @{@"i" : @100}, {})];
+
+  FSTQuery *limitQuery =
+      [[query queryByAddingSortOrder:FSTTestOrderBy("i", @"asc")] queryBySettingLimit:2];
+  DocumentMap docs = [self.localStore executeQuery:limitQuery];
+  XCTAssertLessThan(docs.size(), 30);
+  NSArray<FSTDocument *> *results = docMapToArray(docs);
+  XCTAssertTrue([results containsObject:FSTTestDoc("foo/29", 10, @{@"i" : @-1},
+                                                   FSTDocumentStateLocalMutations)]);
+  XCTAssertTrue([results containsObject:FSTTestDoc("foo/1", 10, @{@"i" : @1},
+                                                   FSTDocumentStateSynced)]);
+
+  // Queries without a limit still read every document.
+  docs = [self.localStore executeQuery:[query queryByAddingSortOrder:FSTTestOrderBy("i", @"asc")]];
+  XCTAssertEqual(docs.size(), 30);
+}
+
+- (void)testReportsHowQueriesAreExecuted {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery("foo");
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/bar", 10, @{@"a" : @"b"}, FSTDocumentStateSynced), {2},
+                             {})];
+  [self.localStore locallyWriteMutations:{ FSTTestSetMutation(@"foo/bonk", @{@"a" : @"b"}) }];
+
+  QueryExecutionStats stats;
+  DocumentMap docs = [self.localStore executeQuery:query stats:&stats];
+  XCTAssertEqual(docs.size(), 2);
+  XCTAssertEqual(stats.access_path, QueryAccessPath::CollectionScan);
+  XCTAssertEqual(stats.mutation_batches_read, 1);
+  XCTAssertEqual(stats.documents_overlaid, 1);
+  XCTAssertEqual(stats.overlays_reused, 0);
+  XCTAssertEqual(stats.documents_returned, 2);
+
+  // The local view of the mutated document is reused by the next execution.
+  QueryExecutionStats second_stats;
+  [self.localStore executeQuery:query stats:&second_stats];
+  XCTAssertEqual(second_stats.documents_overlaid, 0);
+  XCTAssertEqual(second_stats.overlays_reused, 1);
+  XCTAssertEqual(second_stats.documents_returned, 2);
+}
+
+- (void)testQueriesOnlyMatchDocumentsUpdatedSinceTargetWasInSync {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery("foo");
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+  [self allocateQuery:FSTTestQuery("foo/b")];
+  FSTAssertTargetID(4);
+  [self allocateQuery:FSTTestQuery("foo/c")];
+  FSTAssertTargetID(6);
+
+  [self applyRemoteEvent:FSTTestAddedRemoteEvent(
+                             FSTTestDoc("foo/a", 10, @{@"a" : @"b"}, FSTDocumentStateSynced), {2})];
+  [self applyRemoteEvent:FSTTestAddedRemoteEvent(
+                             FSTTestDoc("foo/c", 15, @{@"a" : @"b"}, FSTDocumentStateSynced), {6})];
+
+  // Target 2 is in sync as of version 20.
+  WatchTargetChange watchChange{WatchTargetChangeState::Current, {2},
+                                FSTTestResumeTokenFromSnapshotVersion(20)};
+  auto metadataProvider = TestTargetMetadataProvider::CreateSingleResultProvider(
+      testutil::Key("foo/a"), std::vector<TargetId>{2});
+  WatchChangeAggregator aggregator{&metadataProvider};
+  aggregator.HandleTargetChange(watchChange);
+  [self applyRemoteEvent:aggregator.CreateRemoteEvent(testutil::Version(20))];
+  [self notifyLocalViewChanges:[FSTLocalViewChanges changesForTarget:2
+                                                           addedKeys:{testutil::Key("foo/a")}
+                                                         removedKeys:{}
+                                                           fromCache:NO]];
+
+  [self applyRemoteEvent:FSTTestAddedRemoteEvent(
+                             FSTTestDoc("foo/b", 30, @{@"a" : @"b"}, FSTDocumentStateSynced), {4})];
+  [self.localStore locallyWriteMutations:{ FSTTestSetMutation(@"foo/d", @{@"a" : @"b"}) }];
+
+  // foo/c didn't change since target 2 was in sync, so it isn't matched against the query.
+  QueryExecutionStats stats;
+  DocumentMap docs = [self.localStore executeQuery:query stats:&stats];
+  XCTAssertEqual(stats.access_path, QueryAccessPath::TargetKeys);
+  XCTAssertEqualObjects(docMapToArray(docs), (@[
+                          FSTTestDoc("foo/a", 10, @{@"a" : @"b"}, FSTDocumentStateSynced),
+                          FSTTestDoc("foo/b", 30, @{@"a" : @"b"}, FSTDocumentStateSynced),
+                          FSTTestDoc("foo/d", 0, @{@"a" : @"b"}, FSTDocumentStateLocalMutations)
+                        ]));
+}
+
+- (void)testReleasesLocalViewOverlays {
+  if ([self isTestBaseClass]) return;
+
+  DocumentSizer sizer = [](FSTMaybeDocument *) -> size_t { return 100; };
+
+  [self.localStore locallyWriteMutations:{ FSTTestSetMutation(@"foo/bar", @{@"a" : @"b"}) }];
+  [self.localStore readDocument:FSTTestDocKey(@"foo/bar")];
+
+  MemoryStats stats;
+  [self.localStore collectMemoryStats:&stats documentSizer:sizer];
+  XCTAssertEqual(stats.local_view_overlay_bytes, 100);
+
+  [self.localStore releaseRebuildableMemory];
+  MemoryStats released;
+  [self.localStore collectMemoryStats:&released documentSizer:sizer];
+  XCTAssertEqual(released.local_view_overlay_bytes, 0);
+
+  // The local view is rebuilt from the mutation queue.
+  FSTAssertContains(FSTTestDoc("foo/bar", 0, @{@"a" : @"b"}, FSTDocumentStateLocalMutations));
+}
+
 - (void)testPersistsResumeTokens {
   if ([self isTestBaseClass]) return;
   // This test only works in the absence of the FSTEagerGarbageCollector.
@@ -940,6 +1247,47 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertGreaterThan(newSequenceNumber, initialSequenceNumber);
 }
 
+- (void)testThrottlesWritesOfResumeTokensWithoutDocumentChanges {
+  if ([self isTestBaseClass]) return;
+  // Released targets are only kept in the absence of the FSTEagerGarbageCollector.
+  if ([self gcIsEager]) return;
+
+  FSTQuery *query = FSTTestQuery("foo");
+  FSTQueryData *queryData = [self.localStore allocateQuery:query];
+  TargetId targetID = queryData.targetID;
+  auto persistedSnapshotVersion = [&]() {
+    return self.localStorePersistence.run("Read target", [&]() -> SnapshotVersion {
+      return self.localStorePersistence.queryCache->GetTarget(query).snapshotVersion;
+    });
+  };
+
+  // Versions are in microseconds, so events are 100 seconds apart.
+  const int64_t interval = 100 * 1000 * 1000;
+  TestTargetMetadataProvider metadataProvider;
+  metadataProvider.SetSyncedKeys(DocumentKeySet{}, queryData);
+  auto applyResumeToken = [&](int64_t version) {
+    WatchChangeAggregator aggregator{&metadataProvider};
+    NSData *resumeToken = FSTTestResumeTokenFromSnapshotVersion(version);
+    aggregator.HandleTargetChange(
+        WatchTargetChange{WatchTargetChangeState::Current, {targetID}, resumeToken});
+    [self applyRemoteEvent:aggregator.CreateRemoteEvent(testutil::Version(version))];
+  };
+
+  for (int64_t version = interval; version <= 4 * interval; version += interval) {
+    applyResumeToken(version);
+
+    // The first token is written right away, then only once five minutes have passed since.
+    SnapshotVersion expected = testutil::Version(version < 4 * interval ? interval : version);
+    XCTAssertEqual(persistedSnapshotVersion(), expected);
+  }
+
+  // Releasing the target writes the last token.
+  applyResumeToken(5 * interval);
+  XCTAssertEqual(persistedSnapshotVersion(), testutil::Version(4 * interval));
+  [self.localStore releaseQuery:query];
+  XCTAssertEqual(persistedSnapshotVersion(), testutil::Version(5 * interval));
+}
+
 - (void)testRemoteDocumentKeysForTarget {
   if ([self isTestBaseClass]) return;
 
@@ -964,6 +1312,175 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqual(keys, (DocumentKeySet{testutil::Key("foo/bar"), testutil::Key("foo/baz")}));
 }
 
+- (void)testAppliesRemoteEventsInBatches {
+  if ([self isTestBaseClass]) return;
+
+  self.localStore.remoteDocumentBatchSize = 2;
+  FSTQueryData *queryData = [self.localStore allocateQuery:FSTTestQuery("foo")];
+  TargetId targetID = queryData.targetID;
+
+  NSArray<FSTMaybeDocument *> *docs = @[
+    FSTTestDoc("foo/a", 1000, @{@"n" : @1}, FSTDocumentStateSynced),
+    FSTTestDoc("foo/b", 1000, @{@"n" : @2}, FSTDocumentStateSynced),
+    FSTTestDoc("foo/c", 1000, @{@"n" : @3}, FSTDocumentStateSynced),
+    FSTTestDoc("foo/d", 1000, @{@"n" : @4}, FSTDocumentStateSynced),
+    FSTTestDoc("foo/e", 1000, @{@"n" : @5}, FSTDocumentStateSynced),
+  ];
+  auto metadataProvider =
+      TestTargetMetadataProvider::CreateEmptyResultProvider(testutil::Key("foo/a"), {targetID});
+  WatchChangeAggregator aggregator{&metadataProvider};
+  for (FSTMaybeDocument *doc in docs) {
+    aggregator.HandleDocumentChange(DocumentWatchChange{{targetID}, {}, doc.key, doc});
+  }
+  aggregator.HandleTargetChange(WatchTargetChange{
+      WatchTargetChangeState::Current, {targetID}, FSTTestResumeTokenFromSnapshotVersion(1000)});
+  [self applyRemoteEvent:aggregator.CreateRemoteEvent(testutil::Version(1000))];
+
+  FSTAssertChanged(docs);
+  for (FSTMaybeDocument *doc in docs) {
+    FSTAssertContains(doc);
+  }
+  XCTAssertEqual([self.localStore remoteDocumentKeysForTarget:targetID].size(), docs.count);
+  XCTAssertTrue(self.localStore.lastRemoteSnapshotVersion == testutil::Version(1000));
+}
+
+- (void)testKeepsProjectedDocumentsOutOfRemoteDocumentCache {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = [FSTTestQuery("foo") queryBySettingProjection:{testutil::Field("title")}];
+  FSTQueryData *queryData = [self.localStore allocateQuery:query];
+  TargetId targetID = queryData.targetID;
+
+  FSTDocument *doc = FSTTestDoc("foo/a", 1000, @{@"title" : @"a"}, FSTDocumentStateSynced);
+  TestTargetMetadataProvider metadataProvider;
+  metadataProvider.SetSyncedKeys(DocumentKeySet{}, queryData);
+  WatchChangeAggregator aggregator{&metadataProvider};
+  aggregator.HandleDocumentChange(DocumentWatchChange{{targetID}, {}, doc.key, doc});
+  aggregator.HandleTargetChange(WatchTargetChange{
+      WatchTargetChangeState::Current, {targetID}, FSTTestResumeTokenFromSnapshotVersion(1000)});
+  [self applyRemoteEvent:aggregator.CreateRemoteEvent(testutil::Version(1000))];
+
+  // The partial document is only served to its own query.
+  FSTAssertNotContains(@"foo/a");
+  XCTAssertEqual([self.localStore executeQuery:FSTTestQuery("foo")].size(), 0);
+  DocumentMap docs = [self.localStore executeQuery:query];
+  XCTAssertEqual(docs.size(), 1);
+  XCTAssertEqualObjects(docs.underlying_map().find(doc.key)->second, doc);
+  XCTAssertEqual([self.localStore remoteDocumentKeysForTarget:targetID].size(), 1);
+
+  [self.localStore releaseQuery:query];
+  MemoryStats stats;
+  [self.localStore collectMemoryStats:&stats
+                        documentSizer:[](FSTMaybeDocument *) -> size_t { return 100; }];
+  XCTAssertEqual(stats.projected_document_bytes, 0);
+}
+
+- (void)testLoadsBundleDocumentsAndResumableTarget {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery("foo");
+  NSData *resumeToken = FSTTestResumeTokenFromSnapshotVersion(1000);
+  FSTDocument *doc = FSTTestDoc("foo/a", 1000, @{@"n" : @1}, FSTDocumentStateSynced);
+  FSTDeletedDocument *deleted = FSTTestDeletedDoc("foo/b", 1000, NO);
+  FSTQueryData *bundle = [[FSTQueryData alloc] initWithQuery:query
+                                                    targetID:0
+                                        listenSequenceNumber:0
+                                                     purpose:FSTQueryPurposeListen
+                                             snapshotVersion:testutil::Version(1000)
+                                                 resumeToken:resumeToken];
+  MaybeDocumentMap changes = [self.localStore loadBundleDocuments:{doc, deleted} queryData:bundle];
+  XCTAssertEqual(changes.size(), 2);
+  FSTAssertContains(doc);
+  FSTAssertContains(deleted);
+
+  // An older bundle neither replaces the documents nor the target.
+  FSTDocument *olderDoc = FSTTestDoc("foo/a", 500, @{@"n" : @0}, FSTDocumentStateSynced);
+  FSTQueryData *olderBundle = [[FSTQueryData alloc] initWithQuery:query
+                                                         targetID:0
+                                             listenSequenceNumber:0
+                                                          purpose:FSTQueryPurposeListen
+                                                  snapshotVersion:testutil::Version(500)
+                                                      resumeToken:[NSData data]];
+  [self.localStore loadBundleDocuments:{olderDoc} queryData:olderBundle];
+  FSTAssertContains(doc);
+
+  FSTQueryData *queryData = [self.localStore allocateQuery:query];
+  XCTAssertEqualObjects(queryData.resumeToken, resumeToken);
+  XCTAssertEqual(queryData.snapshotVersion, testutil::Version(1000));
+  XCTAssertEqual([self.localStore remoteDocumentKeysForTarget:queryData.targetID],
+                 (DocumentKeySet{doc.key}));
+}
+
+- (void)testSavesWarmSnapshotsOfMostRecentTargets {
+  if ([self isTestBaseClass]) return;
+
+  self.localStore.warmSnapshotTargetCount = 2;
+  TargetId targetID = [self allocateQuery:FSTTestQuery("foo")];
+  FSTDocument *doc1 = FSTTestDoc("foo/a", 1000, @{@"n" : @1}, FSTDocumentStateSynced);
+  FSTDocument *doc2 = FSTTestDoc("foo/b", 1000, @{@"n" : @2}, FSTDocumentStateSynced);
+  [self applyRemoteEvent:FSTTestAddedRemoteEvent(doc1, {targetID})];
+  [self applyRemoteEvent:FSTTestAddedRemoteEvent(doc2, {targetID})];
+  DocumentKeySet keys{doc1.key, doc2.key};
+
+  XCTAssertFalse([self.localStore warmSnapshotForTarget:2].has_value());
+  [self.localStore saveWarmSnapshotOfDocumentsWithKeys:keys forTarget:2];
+  [self.localStore saveWarmSnapshotOfDocumentsWithKeys:DocumentKeySet{} forTarget:4];
+
+  absl::optional<DocumentMap> snapshot = [self.localStore warmSnapshotForTarget:2];
+  XCTAssertTrue(snapshot.has_value());
+  XCTAssertEqual(snapshot->size(), 2);
+  XCTAssertEqualObjects(snapshot->underlying_map().find(doc1.key)->second, doc1);
+  XCTAssertEqualObjects(snapshot->underlying_map().find(doc2.key)->second, doc2);
+  XCTAssertTrue([self.localStore warmSnapshotForTarget:4].has_value());
+
+  // Saving a third target evicts the least recently saved one.
+  [self.localStore saveWarmSnapshotOfDocumentsWithKeys:keys forTarget:6];
+  XCTAssertFalse([self.localStore warmSnapshotForTarget:2].has_value());
+  XCTAssertTrue([self.localStore warmSnapshotForTarget:4].has_value());
+  XCTAssertTrue([self.localStore warmSnapshotForTarget:6].has_value());
+
+  // Warm snapshots are ignored while disabled.
+  self.localStore.warmSnapshotTargetCount = 0;
+  XCTAssertFalse([self.localStore warmSnapshotForTarget:6].has_value());
+}
+
+- (void)testWarmSnapshotsDontContainLocalMutations {
+  if ([self isTestBaseClass]) return;
+
+  self.localStore.warmSnapshotTargetCount = 1;
+  TargetId targetID = [self allocateQuery:FSTTestQuery("foo")];
+  FSTDocument *doc = FSTTestDoc("foo/a", 1000, @{@"n" : @1}, FSTDocumentStateSynced);
+  [self applyRemoteEvent:FSTTestAddedRemoteEvent(doc, {targetID})];
+  [self writeMutation:FSTTestSetMutation(@"foo/a", @{@"n" : @2})];
+  [self writeMutation:FSTTestSetMutation(@"foo/b", @{@"n" : @3})];
+
+  DocumentKeySet keys{doc.key, testutil::Key("foo/b")};
+  [self.localStore saveWarmSnapshotOfDocumentsWithKeys:keys forTarget:targetID];
+
+  absl::optional<DocumentMap> snapshot = [self.localStore warmSnapshotForTarget:targetID];
+  XCTAssertTrue(snapshot.has_value());
+  XCTAssertEqual(snapshot->size(), 1);
+  XCTAssertEqualObjects(snapshot->underlying_map().find(doc.key)->second, doc);
+}
+
+- (void)testUserChangeRemovesWarmSnapshots {
+  if ([self isTestBaseClass]) return;
+
+  self.localStore.warmSnapshotTargetCount = 1;
+  TargetId targetID = [self allocateQuery:FSTTestQuery("foo")];
+  FSTDocument *doc = FSTTestDoc("foo/a", 1000, @{@"n" : @1}, FSTDocumentStateSynced);
+  [self applyRemoteEvent:FSTTestAddedRemoteEvent(doc, {targetID})];
+  [self.localStore saveWarmSnapshotOfDocumentsWithKeys:DocumentKeySet{doc.key} forTarget:targetID];
+  XCTAssertTrue([self.localStore warmSnapshotForTarget:targetID].has_value());
+
+  [self.localStore userDidChange:User("other")];
+  XCTAssertFalse([self.localStore warmSnapshotForTarget:targetID].has_value());
+
+  // The new user's results are saved right away rather than being throttled.
+  [self.localStore saveWarmSnapshotOfDocumentsWithKeys:DocumentKeySet{doc.key} forTarget:targetID];
+  XCTAssertTrue([self.localStore warmSnapshotForTarget:targetID].has_value());
+}
+
 // TODO(mrschmidt): The FieldValue.increment() field transform tests below would probably be
 // better implemented as spec tests but currently they don't support transforms.
 
@@ -1160,6 +1677,89 @@ NS_ASSUME_NONNULL_BEGIN
   FSTAssertChanged(@[ FSTTestDoc("foo/bar", 1, @{@"sum" : @1}, FSTDocumentStateLocalMutations) ]);
 }
 
+- (void)testCoalescesTransformsOfUnsentBatches {
+  if ([self isTestBaseClass]) return;
+
+  [self writeMutation:FSTTestSetMutation(@"foo/bar", @{@"sum" : @0, @"tags" : @[ @"a" ]})];
+  BatchId setBatchID = [self.batches lastObject].batchID;
+
+  [self writeMutations:{
+    FSTTestPatchMutation("foo/bar", @{}, {}),
+        FSTTestTransformMutation(@"foo/bar", @{
+          @"sum" : [FIRFieldValue fieldValueForIntegerIncrement:1],
+          @"tags" : [FIRFieldValue fieldValueForArrayUnion:@[ @"b" ]]
+        })
+  }];
+  BatchId transformBatchID = [self.batches lastObject].batchID;
+  XCTAssertNotEqual(transformBatchID, setBatchID);
+
+  [self writeMutations:{
+    FSTTestPatchMutation("foo/bar", @{}, {}),
+        FSTTestTransformMutation(@"foo/bar", @{
+          @"sum" : [FIRFieldValue fieldValueForIntegerIncrement:2],
+          @"tags" : [FIRFieldValue fieldValueForArrayUnion:@[ @"c" ]]
+        })
+  }];
+  XCTAssertEqual([self.batches lastObject].batchID, transformBatchID);
+  FSTAssertContains(FSTTestDoc("foo/bar", 0, (@{@"sum" : @3, @"tags" : @[ @"a", @"b", @"c" ]}),
+                               FSTDocumentStateLocalMutations));
+  FSTAssertChanged(@[ FSTTestDoc("foo/bar", 0, (@{@"sum" : @3, @"tags" : @[ @"a", @"b", @"c" ]}),
+                                 FSTDocumentStateLocalMutations) ]);
+
+  FSTMutationBatch *transformBatch = [self.localStore nextMutationBatchAfterBatchID:setBatchID];
+  XCTAssertEqual(transformBatch.batchID, transformBatchID);
+  XCTAssertEqualObjects(transformBatch.mutations[1],
+                        FSTTestTransformMutation(@"foo/bar", @{
+                          @"sum" : [FIRFieldValue fieldValueForIntegerIncrement:3],
+                          @"tags" : [FIRFieldValue fieldValueForArrayUnion:@[ @"b", @"c" ]]
+                        }));
+
+  // Once the batch may have been sent, later transforms get a batch of their own.
+  [self writeMutations:{
+    FSTTestPatchMutation("foo/bar", @{}, {}),
+        FSTTestTransformMutation(@"foo/bar",
+                                 @{@"sum" : [FIRFieldValue fieldValueForIntegerIncrement:4]})
+  }];
+  XCTAssertNotEqual([self.batches lastObject].batchID, transformBatchID);
+  FSTAssertContains(FSTTestDoc("foo/bar", 0, (@{@"sum" : @7, @"tags" : @[ @"a", @"b", @"c" ]}),
+                               FSTDocumentStateLocalMutations));
+}
+
+- (void)testRemovesPendingSetsOverwrittenByLaterSets {
+  if ([self isTestBaseClass]) return;
+
+  self.localStore.pendingWriteCompactionEnabled = YES;
+
+  FSTLocalWriteResult *first =
+      [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/bar", @{@"n" : @1})}];
+  FSTLocalWriteResult *other =
+      [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/baz", @{@"n" : @1})}];
+  FSTLocalWriteResult *second =
+      [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/bar", @{@"n" : @2})}];
+  XCTAssertEqual(first.compactedBatchIDs.size(), 0);
+  XCTAssertEqual(other.compactedBatchIDs.size(), 0);
+  XCTAssertEqual(second.compactedBatchIDs.size(), 1);
+  XCTAssertEqual(second.compactedBatchIDs[0], first.batchID);
+  FSTAssertContains(FSTTestDoc("foo/bar", 0, @{@"n" : @2}, FSTDocumentStateLocalMutations));
+
+  FSTMutationBatch *next = [self.localStore nextMutationBatchAfterBatchID:kBatchIdUnknown];
+  XCTAssertEqual(next.batchID, other.batchID);
+  next = [self.localStore nextMutationBatchAfterBatchID:next.batchID];
+  XCTAssertEqual(next.batchID, second.batchID);
+
+  // A batch that may have been sent is never removed.
+  FSTLocalWriteResult *third =
+      [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/bar", @{@"n" : @3})}];
+  XCTAssertEqual(third.compactedBatchIDs.size(), 0);
+
+  // Nor is one whose document another batch wrote since, or one that doesn't only set documents.
+  [self.localStore locallyWriteMutations:{FSTTestPatchMutation("foo/bar", @{@"m" : @1}, {})}];
+  FSTLocalWriteResult *fourth =
+      [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/bar", @{@"n" : @4})}];
+  XCTAssertEqual(fourth.compactedBatchIDs.size(), 0);
+  FSTAssertContains(FSTTestDoc("foo/bar", 0, @{@"n" : @4}, FSTDocumentStateLocalMutations));
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
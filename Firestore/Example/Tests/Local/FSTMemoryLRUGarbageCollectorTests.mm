@@ -19,11 +19,17 @@
 #import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
 #import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
 #import "Firestore/Source/Local/FSTMemoryPersistence.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
+
+#include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 
 using firebase::firestore::model::DocumentKey;
 
 using firebase::firestore::local::LruParams;
+using firebase::firestore::local::RemoteDocumentCache;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -42,6 +48,46 @@ NS_ASSUME_NONNULL_BEGIN
   return [delegate isPinnedAtSequenceNumber:0 document:key];
 }
 
+- (void)testTracksByteSizeOfDocumentChanges {
+  FSTMemoryPersistence *persistence = [FSTPersistenceTestHelpers lruMemoryPersistence];
+  FSTMemoryLRUReferenceDelegate *delegate =
+      (FSTMemoryLRUReferenceDelegate *)persistence.referenceDelegate;
+  RemoteDocumentCache *cache = persistence.remoteDocumentCache;
+  size_t initialSize = [delegate byteSize];
+
+  persistence.run("add", [&]() {
+    for (FSTDocument *doc in @[
+           FSTTestDoc("coll/a", 1, @{@"value" : @"small"}, FSTDocumentStateSynced),
+           FSTTestDoc("other/b", 1, @{@"value" : @"small"}, FSTDocumentStateSynced)
+         ]) {
+      cache->Add(doc, doc.version);
+    }
+  });
+  size_t twoDocumentsSize = [delegate byteSize];
+  XCTAssertGreaterThan(twoDocumentsSize, initialSize);
+  XCTAssertEqual([delegate byteSizeForCollectionGroup:"coll"],
+                 [delegate byteSizeForCollectionGroup:"other"]);
+
+  // Replacing a document only counts its new version.
+  persistence.run("update", [&]() {
+    FSTDocument *doc =
+        FSTTestDoc("coll/a", 2, @{@"value" : @"a much larger value"}, FSTDocumentStateSynced);
+    cache->Add(doc, doc.version);
+  });
+  XCTAssertGreaterThan([delegate byteSize], twoDocumentsSize);
+  XCTAssertGreaterThan([delegate byteSizeForCollectionGroup:"coll"],
+                       [delegate byteSizeForCollectionGroup:"other"]);
+
+  persistence.run("remove", [&]() {
+    cache->Remove(FSTTestDocKey(@"coll/a"));
+    cache->Remove(FSTTestDocKey(@"other/b"));
+  });
+  XCTAssertEqual([delegate byteSize], initialSize);
+  XCTAssertEqual([delegate byteSizeForCollectionGroup:"coll"], 0);
+
+  [persistence shutdown];
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
\ No newline at end of file
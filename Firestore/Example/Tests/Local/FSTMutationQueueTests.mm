@@ -213,6 +213,32 @@ NS_ASSUME_NONNULL_BEGIN
   });
 }
 
+- (void)testAllMutationBatchesAffectingDocumentKeyTracksAddsAndRemoves {
+  if ([self isTestBaseClass]) return;
+
+  self.persistence.run("testAllMutationBatchesAffectingDocumentKeyTracksAddsAndRemoves", [&]() {
+    FSTMutationBatch *batch1 = [self addMutationBatchWithKey:@"foo/bar"];
+    FSTMutationBatch *batch2 = [self addMutationBatchWithKey:@"foo/baz"];
+
+    std::vector<FSTMutationBatch *> expected{batch1};
+    std::vector<FSTMutationBatch *> matches =
+        self.mutationQueue->AllMutationBatchesAffectingDocumentKey(testutil::Key("foo/bar"));
+    FSTAssertEqualVectors(matches, expected);
+
+    FSTMutationBatch *batch3 = [self addMutationBatchWithKey:@"foo/bar"];
+    self.mutationQueue->RemoveMutationBatch(batch1);
+
+    expected = {batch3};
+    matches = self.mutationQueue->AllMutationBatchesAffectingDocumentKey(testutil::Key("foo/bar"));
+    FSTAssertEqualVectors(matches, expected);
+    XCTAssertNil(self.mutationQueue->LookupMutationBatch(batch1.batchID));
+
+    self.mutationQueue->RemoveMutationBatch(batch2);
+    matches = self.mutationQueue->AllMutationBatchesAffectingDocumentKey(testutil::Key("foo/baz"));
+    XCTAssertEqual(matches.size(), 0);
+  });
+}
+
 - (void)testAllMutationBatchesAffectingDocumentKeys {
   if ([self isTestBaseClass]) return;
 
@@ -306,6 +332,30 @@ NS_ASSUME_NONNULL_BEGIN
   });
 }
 
+- (void)testAllMutationBatchesAffectingQueryDedupesBatches {
+  if ([self isTestBaseClass]) return;
+
+  self.persistence.run("testAllMutationBatchesAffectingQueryDedupesBatches", [&]() {
+    FSTMutationBatch *batch1 = self.mutationQueue->AddMutationBatch(
+        [FIRTimestamp timestamp], {},
+        {FSTTestSetMutation(@"foo/bar", @{@"a" : @1}),
+         FSTTestSetMutation(@"foo/baz", @{@"a" : @1})});
+    self.mutationQueue->AddMutationBatch([FIRTimestamp timestamp], {},
+                                         {FSTTestSetMutation(@"fob/bar", @{@"a" : @1})});
+    FSTMutationBatch *batch3 = self.mutationQueue->AddMutationBatch(
+        [FIRTimestamp timestamp], {},
+        {FSTTestSetMutation(@"foo/baz/sub/doc", @{@"a" : @1}),
+         FSTTestPatchMutation("foo/bar", @{@"b" : @1}, {})});
+
+    std::vector<FSTMutationBatch *> expected = {batch1, batch3};
+    FSTQuery *query = FSTTestQuery("foo");
+    std::vector<FSTMutationBatch *> matches =
+        self.mutationQueue->AllMutationBatchesAffectingQuery(query);
+
+    FSTAssertEqualVectors(matches, expected);
+  });
+}
+
 - (void)testRemoveMutationBatches {
   if ([self isTestBaseClass]) return;
 
@@ -363,6 +413,32 @@ NS_ASSUME_NONNULL_BEGIN
   });
 }
 
+- (void)testRemoveMutationBatchesFromTheMiddle {
+  if ([self isTestBaseClass]) return;
+
+  self.persistence.run("testRemoveMutationBatchesFromTheMiddle", [&]() {
+    std::vector<FSTMutationBatch *> batches = [self createBatches:5];
+
+    self.mutationQueue->RemoveMutationBatch(batches[1]);
+    self.mutationQueue->RemoveMutationBatch(batches[3]);
+    XCTAssertEqual([self batchCount], 3);
+
+    XCTAssertNil(self.mutationQueue->LookupMutationBatch(batches[1].batchID));
+    XCTAssertNil(self.mutationQueue->LookupMutationBatch(batches[3].batchID));
+    XCTAssertEqual(self.mutationQueue->LookupMutationBatch(batches[2].batchID).batchID,
+                   batches[2].batchID);
+
+    FSTMutationBatch *found = self.mutationQueue->NextMutationBatchAfterBatchId(batches[0].batchID);
+    XCTAssertEqual(found.batchID, batches[2].batchID);
+    found = self.mutationQueue->NextMutationBatchAfterBatchId(batches[2].batchID);
+    XCTAssertEqual(found.batchID, batches[4].batchID);
+
+    std::vector<FSTMutationBatch *> expected = {batches[0], batches[2], batches[4]};
+    std::vector<FSTMutationBatch *> all = self.mutationQueue->AllMutationBatches();
+    FSTAssertEqualVectors(all, expected);
+  });
+}
+
 - (void)testStreamToken {
   if ([self isTestBaseClass]) return;
 
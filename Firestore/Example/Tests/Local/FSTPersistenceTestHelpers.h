@@ -20,6 +20,7 @@
 #include "Firestore/core/src/firebase/firestore/util/path.h"
 
 @class FSTLevelDB;
+@class FSTLocalSerializer;
 @class FSTMemoryPersistence;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -32,6 +33,9 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (firebase::firestore::util::Path)levelDBDir;
 
+/** Creates a serializer for a database with a fixed project and database ID. */
++ (FSTLocalSerializer *)localSerializer;
+
 /**
  * Creates and starts a new FSTLevelDB instance for testing, destroying any previous contents
  * if they existed.
@@ -24,6 +24,7 @@
 #import "Firestore/Source/Local/FSTMemoryPersistence.h"
 #import "Firestore/Source/Remote/FSTSerializerBeta.h"
 
+#include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/util/filesystem.h"
 #include "Firestore/core/src/firebase/firestore/util/path.h"
@@ -31,6 +32,7 @@
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 
 namespace util = firebase::firestore::util;
+using firebase::firestore::api::PersistenceSettings;
 using firebase::firestore::local::LruParams;
 using firebase::firestore::model::DatabaseId;
 using firebase::firestore::util::Path;
@@ -72,6 +74,7 @@ NS_ASSUME_NONNULL_BEGIN
   util::Status status = [FSTLevelDB dbWithDirectory:std::move(dir)
                                          serializer:serializer
                                           lruParams:params
+                                persistenceSettings:PersistenceSettings{}
                                                 ptr:&ldb];
   if (!status.ok()) {
     [NSException raise:NSInternalInconsistencyException
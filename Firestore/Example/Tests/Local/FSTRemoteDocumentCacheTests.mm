@@ -17,6 +17,8 @@
 #import "Firestore/Example/Tests/Local/FSTRemoteDocumentCacheTests.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTPersistence.h"
@@ -31,6 +33,7 @@
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 
 namespace testutil = firebase::firestore::testutil;
@@ -115,6 +118,93 @@ static const int kVersion = 42;
   });
 }
 
+- (void)testSetAndReadDocumentsInterleavedWithMissingDocuments {
+  if (!self.remoteDocumentCache) return;
+
+  self.persistence.run("testSetAndReadDocumentsInterleavedWithMissingDocuments", [=]() {
+    NSArray<FSTDocument *> *written = @[
+      [self setTestDocumentAtPath:"a/2"], [self setTestDocumentAtPath:"a/4"],
+      [self setTestDocumentAtPath:"c/1"]
+    ];
+    MaybeDocumentMap read = self.remoteDocumentCache->GetAll(DocumentKeySet{
+        testutil::Key("a/1"),
+        testutil::Key("a/2"),
+        testutil::Key("a/3"),
+        testutil::Key("a/4"),
+        testutil::Key("b/1"),
+        testutil::Key("c/1"),
+        testutil::Key("d/1"),
+    });
+    XCTAssertEqual(read.size(), 7);
+    [self expectMap:read hasDocsInArray:written exactly:NO];
+    for (const char *path : {"a/1", "a/3", "b/1", "d/1"}) {
+      auto found = read.find(testutil::Key(path));
+      XCTAssertTrue(found != read.end());
+      XCTAssertNil(found->second);
+    }
+  });
+}
+
+- (void)testSetAndReadDenseRunOfDocuments {
+  if (!self.remoteDocumentCache) return;
+
+  self.persistence.run("testSetAndReadDenseRunOfDocuments", [=]() {
+    NSMutableArray<FSTDocument *> *written = [NSMutableArray array];
+    DocumentKeySet keys;
+    for (int i = 0; i < 40; ++i) {
+      std::string path = [self pathInCollection:"a" atIndex:i];
+      [written addObject:[self setTestDocumentAtPath:path]];
+      keys = keys.insert(testutil::Key(path));
+    }
+    // Documents in a subcollection sort in between the ones of the run, and those of the next
+    // collection after them.
+    [self setTestDocumentAtPath:"a/010/b/1"];
+    [self setTestDocumentAtPath:"a/010/b/2"];
+    [self setTestDocumentAtPath:"b/000"];
+
+    MaybeDocumentMap read = self.remoteDocumentCache->GetAll(keys);
+    [self expectMap:read hasDocsInArray:written exactly:YES];
+  });
+}
+
+- (void)testSetAndReadSparseDocumentsAcrossSweepBoundary {
+  if (!self.remoteDocumentCache) return;
+
+  self.persistence.run("testSetAndReadSparseDocumentsAcrossSweepBoundary", [=]() {
+    for (int i = 0; i < 100; ++i) {
+      [self setTestDocumentAtPath:[self pathInCollection:"a" atIndex:i]];
+    }
+
+    // The LevelDB cache steps through the rows in between the keys of a run, but seeks once the
+    // next key is more than 16 rows ahead. These documents are 15, 16 and 17 rows apart, and the
+    // missing ones sort 16 rows ahead, in between two rows and after the last row.
+    std::vector<std::string> existing;
+    for (int i : {0, 15, 31, 48, 64, 99}) {
+      existing.push_back([self pathInCollection:"a" atIndex:i]);
+    }
+    std::vector<std::string> missing{"a/048a", "a/080a", "a/100", "a/101"};
+
+    DocumentKeySet keys;
+    NSMutableArray<FSTDocument *> *expected = [NSMutableArray array];
+    for (const std::string &path : existing) {
+      keys = keys.insert(testutil::Key(path));
+      [expected addObject:FSTTestDoc(path, kVersion, _kDocData, FSTDocumentStateSynced)];
+    }
+    for (const std::string &path : missing) {
+      keys = keys.insert(testutil::Key(path));
+    }
+
+    MaybeDocumentMap read = self.remoteDocumentCache->GetAll(keys);
+    XCTAssertEqual(read.size(), existing.size() + missing.size());
+    [self expectMap:read hasDocsInArray:expected exactly:NO];
+    for (const std::string &path : missing) {
+      auto found = read.find(testutil::Key(path));
+      XCTAssertTrue(found != read.end());
+      XCTAssertNil(found->second);
+    }
+  });
+}
+
 - (void)testSetAndReadADocumentAtDeepPath {
   if (!self.remoteDocumentCache) return;
 
@@ -126,7 +216,7 @@ static const int kVersion = 42;
 
   self.persistence.run("testSetAndReadDeletedDocument", [&]() {
     FSTDeletedDocument *deletedDoc = FSTTestDeletedDoc(kDocPath, kVersion, NO);
-    self.remoteDocumentCache->Add(deletedDoc);
+    self.remoteDocumentCache->Add(deletedDoc, testutil::Version(kVersion));
 
     XCTAssertEqualObjects(self.remoteDocumentCache->Get(testutil::Key(kDocPath)), deletedDoc);
   });
@@ -138,7 +228,7 @@ static const int kVersion = 42;
   self.persistence.run("testSetDocumentToNewValue", [&]() {
     [self setTestDocumentAtPath:kDocPath];
     FSTDocument *newDoc = FSTTestDoc(kDocPath, kVersion, @{@"data" : @2}, FSTDocumentStateSynced);
-    self.remoteDocumentCache->Add(newDoc);
+    self.remoteDocumentCache->Add(newDoc, testutil::Version(kVersion));
     XCTAssertEqualObjects(self.remoteDocumentCache->Get(testutil::Key(kDocPath)), newDoc);
   });
 }
@@ -177,7 +267,7 @@ static const int kVersion = 42;
     [self setTestDocumentAtPath:"c/1"];
 
     FSTQuery *query = FSTTestQuery("b");
-    DocumentMap results = self.remoteDocumentCache->GetMatching(query);
+    DocumentMap results = self.remoteDocumentCache->GetMatching(query, nullptr);
     [self expectMap:results.underlying_map()
         hasDocsInArray:@[
           FSTTestDoc("b/1", kVersion, _kDocData, FSTDocumentStateSynced),
@@ -187,10 +277,100 @@ static const int kVersion = 42;
   });
 }
 
+- (void)testFirstDocumentsMatchingQuery {
+  if (!self.remoteDocumentCache) return;
+
+  self.persistence.run("testFirstDocumentsMatchingQuery", [&]() {
+    NSArray<FSTDocument *> *docs = @[
+      FSTTestDoc("b/1", kVersion, @{@"sort" : @3}, FSTDocumentStateSynced),
+      FSTTestDoc("b/2", kVersion, @{@"sort" : @5}, FSTDocumentStateSynced),
+      FSTTestDoc("b/3", kVersion, @{@"sort" : @1}, FSTDocumentStateSynced),
+      FSTTestDoc("b/4", kVersion, @{@"sort" : @4}, FSTDocumentStateSynced),
+      FSTTestDoc("b/5", kVersion, @{@"sort" : @2}, FSTDocumentStateSynced),
+      FSTTestDoc("b/5/z/1", kVersion, @{@"sort" : @9}, FSTDocumentStateSynced),
+      FSTTestDoc("c/1", kVersion, @{@"sort" : @9}, FSTDocumentStateSynced)
+    ];
+    for (FSTDocument *doc in docs) {
+      self.remoteDocumentCache->Add(doc, testutil::Version(kVersion));
+    }
+
+    FSTQuery *query = [[FSTTestQuery("b") queryByAddingSortOrder:FSTTestOrderBy("sort", @"desc")]
+        queryByAddingFilter:FSTTestFilter("sort", @"<", @5)];
+    DocumentMap results = self.remoteDocumentCache->GetFirstMatching(query, 2, nullptr);
+    [self expectMap:results.underlying_map() hasDocsInArray:@[ docs[0], docs[3] ] exactly:YES];
+
+    results = self.remoteDocumentCache->GetFirstMatching(query, 10, nullptr);
+    [self expectMap:results.underlying_map()
+        hasDocsInArray:@[ docs[0], docs[2], docs[3], docs[4] ]
+               exactly:YES];
+  });
+}
+
+- (void)testDocumentsMatchingQuerySinceReadTime {
+  if (!self.remoteDocumentCache) return;
+
+  self.persistence.run("testDocumentsMatchingQuerySinceReadTime", [&]() {
+    [self setTestDocumentAtPath:"b/1" readTime:10];
+    [self setTestDocumentAtPath:"b/2" readTime:20];
+    [self setTestDocumentAtPath:"b/3" readTime:30];
+    [self setTestDocumentAtPath:"b/3/z/1" readTime:40];
+    [self setTestDocumentAtPath:"c/1" readTime:40];
+    // Reading a document again moves it to its new read time.
+    [self setTestDocumentAtPath:"b/1" readTime:50];
+    [self setTestDocumentAtPath:"b/4" readTime:60];
+    self.remoteDocumentCache->Remove(testutil::Key("b/4"));
+
+    FSTQuery *query = FSTTestQuery("b");
+    DocumentMap results =
+        self.remoteDocumentCache->GetMatching(query, testutil::Version(20), nullptr);
+    [self expectMap:results.underlying_map()
+        hasDocsInArray:@[
+          FSTTestDoc("b/1", kVersion, _kDocData, FSTDocumentStateSynced),
+          FSTTestDoc("b/3", kVersion, _kDocData, FSTDocumentStateSynced)
+        ]
+               exactly:YES];
+  });
+}
+
+- (void)testDocumentsInCollectionGroup {
+  if (!self.remoteDocumentCache) return;
+
+  self.persistence.run("testDocumentsInCollectionGroup", [&]() {
+    [self setTestDocumentAtPath:"b/1"];
+    [self setTestDocumentAtPath:"a/1/b/1"];
+    [self setTestDocumentAtPath:"a/1/b/1/c/1"];
+    [self setTestDocumentAtPath:"a/2/b/1"];
+    [self setTestDocumentAtPath:"a/2/bb/1"];
+    [self setTestDocumentAtPath:"a/3/b/1"];
+    self.remoteDocumentCache->Add(FSTTestDeletedDoc("a/4/b/1", kVersion, NO),
+                                  testutil::Version(kVersion));
+    self.remoteDocumentCache->Remove(testutil::Key("a/3/b/1"));
+
+    DocumentMap results = self.remoteDocumentCache->GetAllInCollectionGroup("b", nullptr);
+    [self expectMap:results.underlying_map()
+        hasDocsInArray:@[
+          FSTTestDoc("a/1/b/1", kVersion, _kDocData, FSTDocumentStateSynced),
+          FSTTestDoc("a/2/b/1", kVersion, _kDocData, FSTDocumentStateSynced),
+          FSTTestDoc("b/1", kVersion, _kDocData, FSTDocumentStateSynced)
+        ]
+               exactly:YES];
+  });
+}
+
 #pragma mark - Helpers
+
+/** Returns the path of the document with the given index, padded so that paths sort by index. */
+- (std::string)pathInCollection:(const absl::string_view)collection atIndex:(int)index {
+  return absl::StrCat(collection, "/", absl::Dec(index, absl::kZeroPad3));
+}
+
 - (FSTDocument *)setTestDocumentAtPath:(const absl::string_view)path {
+  return [self setTestDocumentAtPath:path readTime:kVersion];
+}
+
+- (FSTDocument *)setTestDocumentAtPath:(const absl::string_view)path readTime:(int)readTime {
   FSTDocument *doc = FSTTestDoc(path, kVersion, _kDocData, FSTDocumentStateSynced);
-  self.remoteDocumentCache->Add(doc);
+  self.remoteDocumentCache->Add(doc, testutil::Version(readTime));
   return doc;
 }
 
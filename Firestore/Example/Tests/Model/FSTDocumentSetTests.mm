@@ -114,6 +114,22 @@ NS_ASSUME_NONNULL_BEGIN
   XC_ASSERT_THAT(set, ElementsAre(_doc3, _doc1, doc2Prime));
 }
 
+- (void)testUpdatesLeaveTheOriginalUnchanged {
+  DocumentSet set = FSTTestDocSet(*_comp, @[ _doc1, _doc2, _doc3 ]);
+
+  FSTDocument *doc1Prime = FSTTestDoc("docs/1", 1, @{@"sort" : @2}, FSTDocumentStateSynced);
+  FSTDocument *doc3Prime = FSTTestDoc("docs/3", 1, @{@"sort" : @9}, FSTDocumentStateSynced);
+
+  DocumentSet updated = set.insert(doc1Prime).insert(doc3Prime);
+  XC_ASSERT_THAT(updated, ElementsAre(doc1Prime, _doc2, doc3Prime));
+  XCTAssertEqual(updated.IndexOf(_doc1.key), 0);
+  XCTAssertEqual(updated.IndexOf(_doc3.key), 2);
+
+  XC_ASSERT_THAT(set, ElementsAre(_doc3, _doc1, _doc2));
+  XCTAssertEqualObjects(set.GetDocument(_doc1.key), _doc1);
+  XCTAssertEqual(set.IndexOf(_doc3.key), 0);
+}
+
 - (void)testAddsDocsWithEqualComparisonValues {
   FSTDocument *doc4 = FSTTestDoc("docs/4", 0, @{@"sort" : @2}, FSTDocumentStateSynced);
 
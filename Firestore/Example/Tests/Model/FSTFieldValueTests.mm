@@ -20,6 +20,8 @@
 #import <FirebaseFirestore/FIRTimestamp.h>
 #import <XCTest/XCTest.h>
 
+#include <vector>
+
 #import "Firestore/Source/API/FIRFirestore+Internal.h"
 #import "Firestore/Source/API/FSTUserDataConverter.h"
 
@@ -307,6 +309,16 @@ union DoubleBits {
   XCTAssertEqual(actual.type, FieldValue::Type::Object);
 }
 
+- (void)testOrdersFieldsByTheirUTF8Encoding {
+  // U+FF61 sorts before U+1F600 in UTF-8 but after its UTF-16 surrogates.
+  FSTObjectValue *object = FSTTestObjectValue(@{@"\U0001F600" : @1, @"\uFF61" : @2, @"a" : @3});
+  NSMutableArray<NSString *> *names = [NSMutableArray array];
+  for (const auto &entry : object.internalValue) {
+    [names addObject:entry.first];
+  }
+  XCTAssertEqualObjects(names, (@[ @"a", @"\uFF61", @"\U0001F600" ]));
+}
+
 - (void)testExtractsFields {
   FSTObjectValue *obj = FSTTestObjectValue(@{@"foo" : @{@"a" : @YES, @"b" : @"string"}});
   FSTAssertIsKindOfClass(obj, FSTObjectValue);
@@ -422,6 +434,44 @@ union DoubleBits {
   XCTAssertEqualObjects(mod, FSTTestFieldValue(@{}));
 }
 
+- (void)testAppliesUpdatesInOrder {
+  FSTObjectValue *old = FSTTestObjectValue(@{@"a" : @{@"b" : @1, @"c" : @2}, @"d" : @3});
+  std::vector<FSTFieldUpdate> updates{
+      {testutil::Field("a.b"), nil},
+      {testutil::Field("a.e"), FSTTestFieldValue(@4)},
+      {testutil::Field("d.f"), FSTTestFieldValue(@5)},
+      {testutil::Field("g.h"), nil},
+      {testutil::Field("i"), FSTTestFieldValue(@6)},
+  };
+  FSTObjectValue *mod = [old objectByApplyingUpdates:updates];
+  XCTAssertEqualObjects(old, FSTTestFieldValue(@{@"a" : @{@"b" : @1, @"c" : @2}, @"d" : @3}));
+  XCTAssertEqualObjects(
+      mod, FSTTestFieldValue(@{@"a" : @{@"c" : @2, @"e" : @4}, @"d" : @{@"f" : @5}, @"i" : @6}));
+
+  FSTObjectValue *sequential = old;
+  for (const FSTFieldUpdate &update : updates) {
+    sequential = update.value ? [sequential objectBySettingValue:update.value forPath:update.path]
+                              : [sequential objectByDeletingPath:update.path];
+  }
+  XCTAssertEqualObjects(mod, sequential);
+}
+
+- (void)testAppliesValuesToPrecomputedPaths {
+  FSTFieldUpdatePaths paths({testutil::Field("a.b"), testutil::Field("a.c"), testutil::Field("d")});
+  std::vector<FSTFieldValue *> values{FSTTestFieldValue(@1), nil, FSTTestFieldValue(@2)};
+
+  // The same paths can be applied to any number of objects.
+  FSTObjectValue *first = FSTTestObjectValue(@{@"a" : @{@"c" : @3}});
+  XCTAssertEqualObjects([first objectByApplyingValues:values toPaths:paths],
+                        FSTTestFieldValue(@{@"a" : @{@"b" : @1}, @"d" : @2}));
+  FSTObjectValue *second = FSTTestObjectValue(@{@"a" : @4, @"e" : @5});
+  XCTAssertEqualObjects([second objectByApplyingValues:values toPaths:paths],
+                        FSTTestFieldValue(@{@"a" : @{@"b" : @1}, @"d" : @2, @"e" : @5}));
+
+  std::vector<FSTFieldValue *> noValues;
+  XCTAssertEqual([first objectByApplyingValues:noValues toPaths:FSTFieldUpdatePaths()], first);
+}
+
 - (void)testArrays {
   FSTArrayValue *expected = [[FSTArrayValue alloc]
       initWithValueNoCopy:@[ FieldValue::FromString("value").Wrap(), FieldValue::True().Wrap() ]];
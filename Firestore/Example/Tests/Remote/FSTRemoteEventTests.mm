@@ -27,9 +27,13 @@
 
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
+#include "Firestore/core/src/firebase/firestore/remote/decode_pool.h"
 #include "Firestore/core/src/firebase/firestore/remote/existence_filter.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
 
 #import "Firestore/Example/Tests/Util/FSTHelpers.h"
 
@@ -41,6 +45,8 @@ using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::remote::BloomFilter;
+using firebase::firestore::remote::DecodePool;
 using firebase::firestore::remote::DocumentWatchChange;
 using firebase::firestore::remote::ExistenceFilter;
 using firebase::firestore::remote::ExistenceFilterWatchChange;
@@ -52,8 +58,11 @@ using firebase::firestore::remote::WatchChangeAggregator;
 using firebase::firestore::remote::WatchTargetChange;
 using firebase::firestore::remote::WatchTargetChangeState;
 using firebase::firestore::testutil::VectorOfUniquePtrs;
+using firebase::firestore::util::Executor;
+using firebase::firestore::util::ExecutorLibdispatch;
 using firebase::firestore::util::MakeString;
 using firebase::firestore::util::Status;
+using firebase::firestore::util::StringFormat;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -593,6 +602,57 @@ std::unique_ptr<WatchTargetChange> MakeTargetChange(WatchTargetChangeState state
   XCTAssertTrue(event.target_changes().at(1) == targetChange1);
 }
 
+- (void)testExistenceFilterWithBloomFilterRemovesOnlyMissingDocuments {
+  std::unordered_map<TargetId, FSTQueryData *> targetMap{[self queryDataForTargets:{1}]};
+
+  DocumentKey key1 = testutil::Key("docs/1");
+  DocumentKey key2 = testutil::Key("docs/2");
+  WatchChangeAggregator aggregator = [self aggregatorWithTargetMap:targetMap
+                                              outstandingResponses:_noOutstandingResponses
+                                                      existingKeys:DocumentKeySet{key1, key2}
+                                                           changes:{}];
+
+  // A bloom filter that (only) contains
+  // "projects/test-project/databases/(default)/documents/docs/1".
+  BloomFilter unchangedNames = BloomFilter::Create({0x40, 0x40}, 0, 3).ValueOrDie();
+  ExistenceFilterWatchChange existenceFilter{ExistenceFilter{1, unchangedNames}, 1};
+  aggregator.HandleExistenceFilter(existenceFilter);
+
+  RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(3));
+
+  // The deleted document is removed from the target without resetting it.
+  XCTAssertEqual(event.target_mismatches().size(), 0);
+  XCTAssertEqual(event.document_updates().size(), 0);
+  XCTAssertEqual(event.target_changes().size(), 1);
+
+  TargetChange targetChange{[NSData data], false, DocumentKeySet{}, DocumentKeySet{},
+                            DocumentKeySet{key2}};
+  XCTAssertTrue(event.target_changes().at(1) == targetChange);
+}
+
+- (void)testExistenceFilterWithUnreconciledBloomFilterClearsTarget {
+  std::unordered_map<TargetId, FSTQueryData *> targetMap{[self queryDataForTargets:{1}]};
+
+  DocumentKey key1 = testutil::Key("docs/1");
+  DocumentKey key2 = testutil::Key("docs/2");
+  WatchChangeAggregator aggregator = [self aggregatorWithTargetMap:targetMap
+                                              outstandingResponses:_noOutstandingResponses
+                                                      existingKeys:DocumentKeySet{key1, key2}
+                                                           changes:{}];
+
+  // The filter still contains "docs/1", so it can't explain an empty result set.
+  BloomFilter unchangedNames = BloomFilter::Create({0x40, 0x40}, 0, 3).ValueOrDie();
+  ExistenceFilterWatchChange existenceFilter{ExistenceFilter{0, unchangedNames}, 1};
+  aggregator.HandleExistenceFilter(existenceFilter);
+
+  RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(3));
+
+  XCTAssertEqual(event.target_mismatches().size(), 1);
+  TargetChange targetChange{[NSData data], false, DocumentKeySet{}, DocumentKeySet{},
+                            DocumentKeySet{key1, key2}};
+  XCTAssertTrue(event.target_changes().at(1) == targetChange);
+}
+
 - (void)testDocumentUpdate {
   std::unordered_map<TargetId, FSTQueryData *> targetMap{[self queryDataForTargets:{1}]};
 
@@ -820,6 +880,44 @@ std::unique_ptr<WatchTargetChange> MakeTargetChange(WatchTargetChangeState state
   XCTAssertFalse(limboDocChanges.contains(doc3.key));
 }
 
+- (void)testComputesTargetChangesInParallel {
+  std::vector<std::unique_ptr<Executor>> executors;
+  for (int i = 0; i < 2; ++i) {
+    executors.push_back(absl::make_unique<ExecutorLibdispatch>(
+        dispatch_queue_create("FSTRemoteEventTests", DISPATCH_QUEUE_SERIAL)));
+  }
+  DecodePool pool{std::move(executors)};
+
+  std::vector<TargetId> targetIDs;
+  for (TargetId targetID = 1; targetID <= 20; ++targetID) {
+    targetIDs.push_back(targetID);
+    FSTQueryData *queryData = [[FSTQueryData alloc] initWithQuery:FSTTestQuery("coll")
+                                                         targetID:targetID
+                                             listenSequenceNumber:0
+                                                          purpose:FSTQueryPurposeListen];
+    _targetMetadataProvider.SetSyncedKeys(DocumentKeySet{}, queryData);
+  }
+
+  WatchChangeAggregator serial{&_targetMetadataProvider};
+  WatchChangeAggregator parallel{&_targetMetadataProvider, &pool};
+  for (WatchChangeAggregator *aggregator : {&serial, &parallel}) {
+    // Enough changed documents for the work to be split up.
+    for (int i = 0; i < 2000; ++i) {
+      FSTDocument *doc =
+          FSTTestDoc(StringFormat("docs/%s", i), 1, @{@"value" : @(i)}, FSTDocumentStateSynced);
+      aggregator->HandleDocumentChange(DocumentWatchChange{{i % 20 + 1}, {}, doc.key, doc});
+    }
+    aggregator->HandleTargetChange(
+        WatchTargetChange{WatchTargetChangeState::Current, targetIDs, _resumeToken1});
+  }
+
+  RemoteEvent expected = serial.CreateRemoteEvent(testutil::Version(3));
+  RemoteEvent actual = parallel.CreateRemoteEvent(testutil::Version(3));
+  XCTAssertEqual(actual.target_changes().size(), 20);
+  XCTAssertTrue(actual.target_changes() == expected.target_changes());
+  XCTAssertEqual(actual.document_updates().size(), 2000);
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
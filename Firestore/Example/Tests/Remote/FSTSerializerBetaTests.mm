@@ -21,6 +21,8 @@
 #import <FirebaseFirestore/FIRFirestoreErrors.h>
 #import <FirebaseFirestore/FIRGeoPoint.h>
 #import <FirebaseFirestore/FIRTimestamp.h>
+#import <Protobuf/GPBUnknownField.h>
+#import <Protobuf/GPBUnknownFieldSet.h>
 #import <XCTest/XCTest.h>
 
 #include <memory>
@@ -52,11 +54,13 @@
 #include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/field_transform.h"
 #include "Firestore/core/src/firebase/firestore/model/precondition.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "grpcpp/support/byte_buffer.h"
 
 namespace testutil = firebase::firestore::testutil;
 namespace util = firebase::firestore::util;
@@ -73,6 +77,7 @@ using firebase::firestore::remote::ExistenceFilterWatchChange;
 using firebase::firestore::remote::WatchChange;
 using firebase::firestore::remote::WatchTargetChange;
 using firebase::firestore::remote::WatchTargetChangeState;
+using firebase::firestore::remote::bridge::WatchStreamSerializer;
 using firebase::firestore::util::Status;
 
 namespace {
@@ -99,6 +104,12 @@ bool IsWatchChangeEqual(const WatchChange &lhs, const WatchChange &rhs) {
   UNREACHABLE();
 }
 
+grpc::ByteBuffer ToByteBuffer(GCFSListenResponse *response) {
+  NSData *data = [response data];
+  grpc::Slice slice{[data bytes], [data length]};
+  return grpc::ByteBuffer{&slice, 1};
+}
+
 }  // namespace
 
 NS_ASSUME_NONNULL_BEGIN
@@ -719,6 +730,28 @@ NS_ASSUME_NONNULL_BEGIN
   [self assertRoundTripForQueryData:model proto:expected];
 }
 
+- (void)testEncodesProjection {
+  FSTQuery *q = [FSTTestQuery("docs")
+      queryBySettingProjection:{testutil::Field("title"), testutil::Field("meta.date")}];
+  FSTQueryData *model = [self queryDataForQuery:q];
+
+  GCFSTarget *expected = [GCFSTarget message];
+  expected.query.parent = @"projects/p/databases/d/documents";
+  GCFSStructuredQuery_CollectionSelector *from = [GCFSStructuredQuery_CollectionSelector message];
+  from.collectionId = @"docs";
+  [expected.query.structuredQuery.fromArray addObject:from];
+  for (NSString *field in @[ @"meta.date", @"title" ]) {
+    GCFSStructuredQuery_FieldReference *ref = [GCFSStructuredQuery_FieldReference message];
+    ref.fieldPath = field;
+    [expected.query.structuredQuery.select.fieldsArray addObject:ref];
+  }
+  [expected.query.structuredQuery.orderByArray
+      addObject:[GCFSStructuredQuery_Order messageWithProperty:kDocumentKeyPath ascending:YES]];
+  expected.targetId = 1;
+
+  [self assertRoundTripForQueryData:model proto:expected];
+}
+
 - (void)testEncodesSortOrdersDescending {
   FSTQuery *q = [FSTTestQuery("rooms/1/messages/10/attachments")
       queryByAddingSortOrder:[FSTSortOrder sortOrderWithFieldPath:testutil::Field("prop")
@@ -778,6 +811,27 @@ NS_ASSUME_NONNULL_BEGIN
   [self assertRoundTripForQueryData:model proto:expected];
 }
 
+- (void)testEncodesExpectedCount {
+  FSTQueryData *model = [[FSTQueryData alloc] initWithQuery:FSTTestQuery("docs")
+                                                   targetID:1
+                                       listenSequenceNumber:0
+                                                    purpose:FSTQueryPurposeListen
+                                            snapshotVersion:SnapshotVersion::None()
+                                                resumeToken:FSTTestData(1, 2, 3, -1)];
+
+  // Without a count there is nothing beyond the known fields.
+  XCTAssertNil([self.serializer encodedTarget:model expectedCount:absl::nullopt].unknownFields);
+
+  // expected_count is field 12, an Int32Value whose `value` is field 1.
+  GCFSTarget *actual = [self.serializer encodedTarget:model expectedCount:2];
+  GPBUnknownField *field = [actual.unknownFields getField:12];
+  XCTAssertNotNil(field);
+  XCTAssertEqual(field.lengthDelimitedList.count, 1);
+  const uint8_t expectedBytes[] = {0x08, 0x02};
+  XCTAssertEqualObjects(field.lengthDelimitedList[0], [NSData dataWithBytes:expectedBytes
+                                                                     length:sizeof(expectedBytes)]);
+}
+
 - (FSTQueryData *)queryDataForQuery:(FSTQuery *)query {
   return [[FSTQueryData alloc] initWithQuery:query
                                     targetID:1
@@ -906,6 +960,62 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertTrue(IsWatchChangeEqual(*actual, expected));
 }
 
+- (void)testNanopbDecodingMatchesObjectiveCDecoding {
+  NSString *name = @"projects/p/databases/d/documents/coll/1";
+  NSMutableArray<GCFSListenResponse *> *responses = [NSMutableArray array];
+
+  GCFSListenResponse *targetChange = [GCFSListenResponse message];
+  targetChange.targetChange.targetChangeType = GCFSTargetChange_TargetChangeType_Remove;
+  targetChange.targetChange.cause.code = FIRFirestoreErrorCodePermissionDenied;
+  targetChange.targetChange.cause.message = @"Error message";
+  targetChange.targetChange.resumeToken = FSTTestData(0, 1, 2, -1);
+  [targetChange.targetChange.targetIdsArray addValue:1];
+  [responses addObject:targetChange];
+
+  GCFSListenResponse *globalSnapshot = [GCFSListenResponse message];
+  globalSnapshot.targetChange.targetChangeType = GCFSTargetChange_TargetChangeType_NoChange;
+  globalSnapshot.targetChange.readTime.seconds = 42;
+  [responses addObject:globalSnapshot];
+
+  GCFSListenResponse *documentChange = [GCFSListenResponse message];
+  documentChange.documentChange.document.name = name;
+  documentChange.documentChange.document.updateTime.nanos = 5000;
+  documentChange.documentChange.document.fields[@"foo"] = [self.serializer encodedString:@"bar"];
+  documentChange.documentChange.document.fields[@"n"] = [self.serializer encodedInteger:7];
+  [documentChange.documentChange.targetIdsArray addValue:2];
+  [documentChange.documentChange.removedTargetIdsArray addValue:1];
+  [responses addObject:documentChange];
+
+  GCFSListenResponse *documentDelete = [GCFSListenResponse message];
+  documentDelete.documentDelete.document = name;
+  documentDelete.documentDelete.readTime.nanos = 5000;
+  [documentDelete.documentDelete.removedTargetIdsArray addValue:1];
+  [responses addObject:documentDelete];
+
+  GCFSListenResponse *documentRemove = [GCFSListenResponse message];
+  documentRemove.documentRemove.document = name;
+  [documentRemove.documentRemove.removedTargetIdsArray addValue:1];
+  [responses addObject:documentRemove];
+
+  WatchStreamSerializer bridge{self.serializer};
+  for (GCFSListenResponse *response in responses) {
+    std::unique_ptr<WatchChange> change;
+    SnapshotVersion version;
+    XCTAssertTrue(bridge.DecodeResponse(ToByteBuffer(response), &change, &version));
+    XCTAssertTrue(IsWatchChangeEqual(*change, *[self.serializer decodedWatchChange:response]));
+    XCTAssertEqual(version, [self.serializer versionFromListenResponse:response]);
+  }
+
+  // Existence filters are left to the Objective-C protos.
+  GCFSListenResponse *filter = [GCFSListenResponse message];
+  filter.filter.targetId = 1;
+  filter.filter.count = 2;
+  std::unique_ptr<WatchChange> change;
+  SnapshotVersion version;
+  XCTAssertFalse(bridge.DecodeResponse(ToByteBuffer(filter), &change, &version));
+  XCTAssertFalse(change);
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
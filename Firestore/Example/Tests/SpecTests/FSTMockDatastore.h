@@ -16,6 +16,7 @@
 
 #import <Foundation/Foundation.h>
 
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -72,6 +73,11 @@ class MockDatastore : public Datastore {
 
   /** Returns the set of active targets on the watch stream. */
   const std::unordered_map<model::TargetId, FSTQueryData*>& ActiveTargets() const;
+  /**
+   * Returns the expected counts sent along with the active targets on the watch stream, for the
+   * targets that had one.
+   */
+  const std::unordered_map<model::TargetId, int32_t>& ExpectedCounts() const;
   /** Helper method to expose watch stream state to verify in tests. */
   bool IsWatchStreamOpen() const;
 
@@ -88,6 +94,12 @@ class MockDatastore : public Datastore {
   /** Injects a stream failure as though it had come from the backend. */
   void FailWrite(const util::Status& error);
 
+  /** Injects the response to a resumed handshake as though it had come from the backend. */
+  void AckWriteHandshake();
+
+  /** Whether the last handshake of the write stream resumed an earlier stream. */
+  bool LastWriteHandshakeResumed() const;
+
  private:
   // These are all passed to the base class; however, making `MockDatastore` store the pointers
   // reduces the number of test-only methods in `Datastore`.
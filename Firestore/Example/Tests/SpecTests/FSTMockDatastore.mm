@@ -16,11 +16,13 @@
 
 #import "Firestore/Example/Tests/SpecTests/FSTMockDatastore.h"
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <queue>
 #include <utility>
 
+#import "Firestore/Protos/objc/google/firestore/v1/Firestore.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Model/FSTMutation.h"
@@ -39,6 +41,7 @@
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "Firestore/core/test/firebase/firestore/util/create_noop_connectivity_monitor.h"
 #include "absl/memory/memory.h"
+#include "absl/types/optional.h"
 #include "grpcpp/completion_queue.h"
 
 NS_ASSUME_NONNULL_BEGIN
@@ -80,6 +83,10 @@ class MockWatchStream : public WatchStream {
     return active_targets_;
   }
 
+  const std::unordered_map<TargetId, int32_t>& ExpectedCounts() const {
+    return expected_counts_;
+  }
+
   void Start() override {
     HARD_ASSERT(!open_, "Trying to start already started watch stream");
     open_ = true;
@@ -90,6 +97,7 @@ class MockWatchStream : public WatchStream {
     WatchStream::Stop();
     open_ = false;
     active_targets_.clear();
+    expected_counts_.clear();
   }
 
   bool IsStarted() const override {
@@ -99,7 +107,7 @@ class MockWatchStream : public WatchStream {
     return open_;
   }
 
-  void WatchQuery(FSTQueryData* query) override {
+  void WatchQuery(FSTQueryData* query, absl::optional<int32_t> expected_count) override {
     LOG_DEBUG("WatchQuery: %s: %s, %s", query.targetID, query.query, query.resumeToken);
 
     // Snapshot version is ignored on the wire
@@ -108,11 +116,17 @@ class MockWatchStream : public WatchStream {
                                                               sequenceNumber:query.sequenceNumber];
     datastore_->IncrementWatchStreamRequests();
     active_targets_[query.targetID] = sentQueryData;
+    if (expected_count) {
+      expected_counts_[query.targetID] = *expected_count;
+    } else {
+      expected_counts_.erase(query.targetID);
+    }
   }
 
   void UnwatchTargetId(model::TargetId target_id) override {
     LOG_DEBUG("UnwatchTargetId: %s", target_id);
     active_targets_.erase(target_id);
+    expected_counts_.erase(target_id);
   }
 
   void FailStream(const Status& error) {
@@ -134,6 +148,7 @@ class MockWatchStream : public WatchStream {
           }
 
           active_targets_.erase(found);
+          expected_counts_.erase(target_id);
         }
       }
 
@@ -150,6 +165,7 @@ class MockWatchStream : public WatchStream {
  private:
   bool open_ = false;
   std::unordered_map<TargetId, FSTQueryData*> active_targets_;
+  std::unordered_map<TargetId, int32_t> expected_counts_;
   MockDatastore* datastore_ = nullptr;
   WatchStreamCallback* callback_ = nullptr;
 };
@@ -171,6 +187,7 @@ class MockWriteStream : public WriteStream {
     HARD_ASSERT(!open_, "Trying to start already started write stream");
     open_ = true;
     sent_mutations_ = {};
+    SetHandshakeComplete(false);
     callback_->OnWriteStreamOpen();
   }
 
@@ -192,10 +209,38 @@ class MockWriteStream : public WriteStream {
 
   void WriteHandshake() override {
     datastore_->IncrementWriteStreamRequests();
+    GCFSWriteRequest* handshake = CreateHandshake();
+    last_handshake_resumed_ = handshake.streamId.length > 0;
+
+    // The backend accepts writes behind a resumed handshake before responding to it, so its
+    // response is only delivered by `AckHandshake` or along with the first write ack.
+    if (!last_handshake_resumed_) {
+      AckHandshake();
+    }
+  }
+
+  /** Injects the response to the handshake as though it had come from the backend. */
+  void AckHandshake() {
+    HARD_ASSERT(!handshake_complete(), "Handshake already completed");
+    if (resumption_enabled()) {
+      // Only a new stream gets an ID, which later handshakes can then resume.
+      GCFSWriteResponse* response = [GCFSWriteResponse message];
+      ++stream_token_count_;
+      response.streamToken = [[NSString stringWithFormat:@"token-%d", stream_token_count_]
+          dataUsingEncoding:NSUTF8StringEncoding];
+      if (!last_handshake_resumed_) {
+        response.streamId = [NSString stringWithFormat:@"stream-%d", stream_token_count_];
+      }
+      UpdateLastStreamToken(response);
+    }
     SetHandshakeComplete();
     callback_->OnWriteStreamHandshakeComplete();
   }
 
+  bool last_handshake_resumed() const {
+    return last_handshake_resumed_;
+  }
+
   void WriteMutations(const std::vector<FSTMutation*>& mutations) override {
     datastore_->IncrementWriteStreamRequests();
     sent_mutations_.push(mutations);
@@ -203,6 +248,10 @@ class MockWriteStream : public WriteStream {
 
   /** Injects a write ack as though it had come from the backend in response to a write. */
   void AckWrite(const SnapshotVersion& commitVersion, std::vector<FSTMutationResult*> results) {
+    // The backend responds to the handshake before it responds to the writes behind it.
+    if (!handshake_complete()) {
+      AckHandshake();
+    }
     callback_->OnWriteStreamMutationResult(commitVersion, std::move(results));
   }
 
@@ -234,6 +283,8 @@ class MockWriteStream : public WriteStream {
  private:
   bool open_ = false;
   std::queue<std::vector<FSTMutation*>> sent_mutations_;
+  bool last_handshake_resumed_ = false;
+  int stream_token_count_ = 0;
   MockDatastore* datastore_ = nullptr;
   WriteStreamCallback* callback_ = nullptr;
 };
@@ -277,6 +328,10 @@ const std::unordered_map<TargetId, FSTQueryData*>& MockDatastore::ActiveTargets(
   return watch_stream_->ActiveTargets();
 }
 
+const std::unordered_map<TargetId, int32_t>& MockDatastore::ExpectedCounts() const {
+  return watch_stream_->ExpectedCounts();
+}
+
 bool MockDatastore::IsWatchStreamOpen() const {
   return watch_stream_->IsOpen();
 }
@@ -298,6 +353,14 @@ void MockDatastore::FailWrite(const Status& error) {
   write_stream_->FailStream(error);
 }
 
+void MockDatastore::AckWriteHandshake() {
+  write_stream_->AckHandshake();
+}
+
+bool MockDatastore::LastWriteHandshakeResumed() const {
+  return write_stream_->last_handshake_resumed();
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
@@ -18,6 +18,7 @@
 
 #import <FirebaseFirestore/FIRFirestoreErrors.h>
 
+#include <limits>
 #include <map>
 #include <unordered_map>
 #include <utility>
@@ -43,12 +44,14 @@
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/objc/objc_compatibility.h"
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
 #include "Firestore/core/src/firebase/firestore/remote/existence_filter.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 
@@ -63,6 +66,7 @@ using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::remote::BloomFilter;
 using firebase::firestore::remote::ExistenceFilter;
 using firebase::firestore::remote::DocumentWatchChange;
 using firebase::firestore::remote::ExistenceFilterWatchChange;
@@ -70,6 +74,7 @@ using firebase::firestore::remote::WatchTargetChange;
 using firebase::firestore::remote::WatchTargetChangeState;
 using firebase::firestore::util::MakeString;
 using firebase::firestore::util::Status;
+using firebase::firestore::util::StatusOr;
 using firebase::firestore::util::TimerId;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -122,6 +127,9 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
 @implementation FSTSpecTests {
   BOOL _gcEnabled;
   BOOL _networkEnabled;
+  size_t _maxConcurrentLimboResolutions;
+  int _maxBatchesPerWriteRequest;
+  BOOL _resumeWriteStream;
 }
 
 - (id<FSTPersistence>)persistenceWithGCEnabled:(BOOL)GCEnabled {
@@ -147,8 +155,23 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
   if (numClients) {
     XCTAssertEqualObjects(numClients, @1, @"The iOS client does not support multi-client tests");
   }
+  // Store the limit on concurrent limbo resolutions so we can re-use it in doRestart.
+  NSNumber *maxConcurrentLimboResolutions = config[@"maxConcurrentLimboResolutions"];
+  _maxConcurrentLimboResolutions = maxConcurrentLimboResolutions
+                                       ? [maxConcurrentLimboResolutions unsignedLongValue]
+                                       : std::numeric_limits<size_t>::max();
+  // Likewise for the number of mutation batches the RemoteStore may merge into one request.
+  NSNumber *maxBatchesPerWriteRequest = config[@"maxBatchesPerWriteRequest"];
+  _maxBatchesPerWriteRequest = maxBatchesPerWriteRequest ? [maxBatchesPerWriteRequest intValue] : 1;
+  _resumeWriteStream = [config[@"resumeWriteStream"] boolValue];
   id<FSTPersistence> persistence = [self persistenceWithGCEnabled:_gcEnabled];
-  self.driver = [[FSTSyncEngineTestDriver alloc] initWithPersistence:persistence];
+  self.driver =
+      [[FSTSyncEngineTestDriver alloc] initWithPersistence:persistence
+                                               initialUser:User::Unauthenticated()
+                                         outstandingWrites:{}
+                             maxConcurrentLimboResolutions:_maxConcurrentLimboResolutions
+                                 maxBatchesPerWriteRequest:_maxBatchesPerWriteRequest
+                                         resumeWriteStream:_resumeWriteStream];
   [self.driver start];
 }
 
@@ -322,13 +345,37 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
   }
 }
 
-- (void)doWatchFilter:(NSArray *)watchFilter {
-  NSArray<NSNumber *> *targets = watchFilter[0];
+/**
+ * Sends an existence filter. The filter is either an array of the target IDs followed by the keys
+ * that match them, or a dictionary with "targetIds", "keys" and an optional "bloomFilter" of the
+ * form `{"bits": {"bitmap": <base64>, "padding": <int>}, "hashCount": <int>}`.
+ */
+- (void)doWatchFilter:(id)watchFilter {
+  NSArray<NSNumber *> *targets;
+  int keyCount;
+  absl::optional<BloomFilter> bloomFilter;
+  if ([watchFilter isKindOfClass:[NSDictionary class]]) {
+    targets = watchFilter[@"targetIds"];
+    keyCount = (int)[watchFilter[@"keys"] count];
+    NSDictionary *bloomFilterSpec = watchFilter[@"bloomFilter"];
+    if (bloomFilterSpec) {
+      NSDictionary *bits = bloomFilterSpec[@"bits"];
+      NSData *bitmap = [[NSData alloc] initWithBase64EncodedString:bits[@"bitmap"] options:0];
+      const auto *bytes = static_cast<const uint8_t *>(bitmap.bytes);
+      StatusOr<BloomFilter> maybeFilter = BloomFilter::Create(
+          std::vector<uint8_t>(bytes, bytes + bitmap.length), [bits[@"padding"] intValue],
+          [bloomFilterSpec[@"hashCount"] intValue]);
+      HARD_ASSERT(maybeFilter.ok(), "Invalid bloom filter in spec: %s",
+                  maybeFilter.status().ToString());
+      bloomFilter = std::move(maybeFilter).ValueOrDie();
+    }
+  } else {
+    targets = watchFilter[0];
+    keyCount = [watchFilter count] == 0 ? 0 : (int)[watchFilter count] - 1;
+  }
   HARD_ASSERT(targets.count == 1, "ExistenceFilters currently support exactly one target only.");
 
-  int keyCount = watchFilter.count == 0 ? 0 : (int)watchFilter.count - 1;
-
-  ExistenceFilter filter{keyCount};
+  ExistenceFilter filter{keyCount, std::move(bloomFilter)};
   ExistenceFilterWatchChange change{filter, targets[0].intValue};
   [self.driver receiveWatchChange:change snapshotVersion:SnapshotVersion::None()];
 }
@@ -368,17 +415,31 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
                 @"'keepInQueue=true' is not supported on iOS and should only be set in "
                 @"multi-client tests");
 
-  FSTMutationResult *mutationResult = [[FSTMutationResult alloc] initWithVersion:version
-                                                                transformResults:nil];
-  [self.driver receiveWriteAckWithVersion:version mutationResults:{mutationResult}];
+  // A request that merged several writes is acknowledged with one result for each of them.
+  NSNumber *batchCount = spec[@"batchCount"];
+  std::vector<FSTMutationResult *> mutationResults;
+  for (int i = 0; i < (batchCount ? batchCount.intValue : 1); ++i) {
+    mutationResults.push_back([[FSTMutationResult alloc] initWithVersion:version
+                                                        transformResults:nil]);
+  }
+  [self.driver receiveWriteAckWithVersion:version mutationResults:std::move(mutationResults)];
 }
 
 - (void)doFailWrite:(NSDictionary *)spec {
   NSDictionary *errorSpec = spec[@"error"];
   NSNumber *keepInQueue = spec[@"keepInQueue"];
 
+  NSNumber *batchCount = spec[@"batchCount"];
+
   int code = ((NSNumber *)(errorSpec[@"code"])).intValue;
-  [self.driver receiveWriteError:code userInfo:errorSpec keepInQueue:keepInQueue.boolValue];
+  [self.driver receiveWriteError:code
+                        userInfo:errorSpec
+                     keepInQueue:keepInQueue.boolValue
+                      batchCount:batchCount ? batchCount.intValue : 1];
+}
+
+- (void)doWriteHandshakeAck {
+  [self.driver receiveWriteHandshakeAck];
 }
 
 - (void)doDrainQueue {
@@ -432,9 +493,13 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
   [self.driver shutdown];
 
   id<FSTPersistence> persistence = [self persistenceWithGCEnabled:_gcEnabled];
-  self.driver = [[FSTSyncEngineTestDriver alloc] initWithPersistence:persistence
-                                                         initialUser:currentUser
-                                                   outstandingWrites:outstandingWrites];
+  self.driver =
+      [[FSTSyncEngineTestDriver alloc] initWithPersistence:persistence
+                                               initialUser:currentUser
+                                         outstandingWrites:outstandingWrites
+                             maxConcurrentLimboResolutions:_maxConcurrentLimboResolutions
+                                 maxBatchesPerWriteRequest:_maxBatchesPerWriteRequest
+                                         resumeWriteStream:_resumeWriteStream];
   [self.driver start];
 }
 
@@ -477,6 +542,8 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
     [self doWriteAck:step[@"writeAck"]];
   } else if (step[@"failWrite"]) {
     [self doFailWrite:step[@"failWrite"]];
+  } else if (step[@"writeHandshakeAck"]) {
+    [self doWriteHandshakeAck];
   } else if (step[@"runTimer"]) {
     [self doRunTimer:step[@"runTimer"]];
   } else if (step[@"enableNetwork"]) {
@@ -584,6 +651,10 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
       XCTAssertEqual([self.driver writeStreamRequestCount],
                      [expected[@"writeStreamRequestCount"] intValue]);
     }
+    if (expected[@"writeStreamResumed"]) {
+      XCTAssertEqual([self.driver lastWriteHandshakeResumed],
+                     [expected[@"writeStreamResumed"] boolValue]);
+    }
     if (expected[@"watchStreamRequestCount"]) {
       XCTAssertEqual([self.driver watchStreamRequestCount],
                      [expected[@"watchStreamRequestCount"] intValue]);
@@ -597,14 +668,26 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
       // Update the expected limbo documents
       [self.driver setExpectedLimboDocuments:std::move(expectedLimboDocuments)];
     }
+    if (expected[@"enqueuedLimboDocs"]) {
+      std::vector<DocumentKey> expectedEnqueuedLimboDocuments;
+      NSArray *docNames = expected[@"enqueuedLimboDocs"];
+      for (NSString *name in docNames) {
+        expectedEnqueuedLimboDocuments.push_back(FSTTestDocKey(name));
+      }
+      [self.driver setExpectedEnqueuedLimboDocuments:std::move(expectedEnqueuedLimboDocuments)];
+    }
     if (expected[@"activeTargets"]) {
       __block std::unordered_map<TargetId, FSTQueryData *> expectedActiveTargets;
+      __block std::unordered_map<TargetId, int32_t> expectedCounts;
       [expected[@"activeTargets"] enumerateKeysAndObjectsUsingBlock:^(NSString *targetIDString,
                                                                       NSDictionary *queryData,
                                                                       BOOL *stop) {
         TargetId targetID = [targetIDString intValue];
         FSTQuery *query = [self parseQuery:queryData[@"query"]];
         NSData *resumeToken = [queryData[@"resumeToken"] dataUsingEncoding:NSUTF8StringEncoding];
+        if (queryData[@"expectedCount"]) {
+          expectedCounts[targetID] = [queryData[@"expectedCount"] intValue];
+        }
         // TODO(mcg): populate the purpose of the target once it's possible to encode that in the
         // spec tests. For now, hard-code that it's a listen despite the fact that it's not always
         // the right value.
@@ -617,6 +700,7 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
                                     resumeToken:resumeToken];
       }];
       [self.driver setExpectedActiveTargets:expectedActiveTargets];
+      [self.driver setExpectedActiveTargetExpectedCounts:expectedCounts];
     }
   }
 
@@ -624,6 +708,8 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
   [self validateUserCallbacks:expected];
   // Always validate that the expected limbo docs match the actual limbo docs.
   [self validateLimboDocuments];
+  // Always validate that the expected enqueued limbo docs match the actual ones.
+  [self validateEnqueuedLimboDocuments];
   // Always validate that the expected active targets match the actual active targets.
   [self validateActiveTargets];
 }
@@ -664,6 +750,20 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
                 actualLimboDocs.begin()->second);
 }
 
+- (void)validateEnqueuedLimboDocuments {
+  std::vector<DocumentKey> actualEnqueuedLimboDocs = [self.driver enqueuedLimboDocuments];
+  const std::vector<DocumentKey> &expectedEnqueuedLimboDocs =
+      [self.driver expectedEnqueuedLimboDocuments];
+  XCTAssertEqual(actualEnqueuedLimboDocs.size(), expectedEnqueuedLimboDocs.size(),
+                 @"Unexpected number of enqueued limbo docs");
+  for (size_t i = 0; i < actualEnqueuedLimboDocs.size() && i < expectedEnqueuedLimboDocs.size();
+       i++) {
+    XCTAssertTrue(actualEnqueuedLimboDocs[i] == expectedEnqueuedLimboDocs[i],
+                  @"Expected doc to be enqueued at position %zu: %s", i,
+                  expectedEnqueuedLimboDocs[i].ToString().c_str());
+  }
+}
+
 - (void)validateActiveTargets {
   if (!_networkEnabled) {
     return;
@@ -695,6 +795,18 @@ std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *from) {
 
   XCTAssertTrue(actualTargets.empty(), "Unexpected active targets: %@",
                 objc::Description(actualTargets));
+
+  const std::unordered_map<TargetId, int32_t> &actualCounts =
+      [self.driver activeTargetExpectedCounts];
+  for (const auto &kv : [self.driver expectedActiveTargetExpectedCounts]) {
+    auto found = actualCounts.find(kv.first);
+    XCTAssertTrue(found != actualCounts.end(), @"Target %d was sent without an expected count",
+                  kv.first);
+    if (found != actualCounts.end()) {
+      XCTAssertEqual(found->second, kv.second, @"Unexpected expected count for target %d",
+                     kv.first);
+    }
+  }
 }
 
 - (void)runSpecTestSteps:(NSArray *)steps config:(NSDictionary *)config {
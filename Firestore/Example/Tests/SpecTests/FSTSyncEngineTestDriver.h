@@ -101,10 +101,39 @@ typedef std::unordered_map<firebase::firestore::auth::User,
  * a set of existing outstandingWrites (useful when your FSTPersistence object has
  * persisted mutation queues).
  */
+- (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
+                        initialUser:(const firebase::firestore::auth::User &)initialUser
+                  outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites;
+
+/**
+ * Initializes the underlying FSTSyncEngine like the initializer above, limiting the number of limbo
+ * documents that are resolved at the same time to maxConcurrentLimboResolutions.
+ */
+- (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
+                        initialUser:(const firebase::firestore::auth::User &)initialUser
+                  outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites
+      maxConcurrentLimboResolutions:(size_t)maxConcurrentLimboResolutions;
+
+/**
+ * Initializes the underlying FSTSyncEngine like the initializer above, letting the `RemoteStore`
+ * merge up to maxBatchesPerWriteRequest consecutive mutation batches into a single write request.
+ */
 - (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
                         initialUser:(const firebase::firestore::auth::User &)initialUser
                   outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites
-    NS_DESIGNATED_INITIALIZER;
+      maxConcurrentLimboResolutions:(size_t)maxConcurrentLimboResolutions
+          maxBatchesPerWriteRequest:(int)maxBatchesPerWriteRequest;
+
+/**
+ * Initializes the underlying FSTSyncEngine like the initializer above, letting the `RemoteStore`
+ * resume the write stream when it restarts if resumeWriteStream is set.
+ */
+- (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
+                        initialUser:(const firebase::firestore::auth::User &)initialUser
+                  outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites
+      maxConcurrentLimboResolutions:(size_t)maxConcurrentLimboResolutions
+          maxBatchesPerWriteRequest:(int)maxBatchesPerWriteRequest
+                  resumeWriteStream:(BOOL)resumeWriteStream NS_DESIGNATED_INITIALIZER;
 
 - (instancetype)init NS_UNAVAILABLE;
 
@@ -189,18 +218,39 @@ typedef std::unordered_map<firebase::firestore::auth::User,
                                   userInfo:(NSDictionary<NSString *, id> *)userInfo
                                keepInQueue:(BOOL)keepInQueue;
 
+/**
+ * Like receiveWriteError:userInfo:keepInQueue:, but for a request that merged batchCount
+ * consecutive writes. A failed merged request doesn't reject any of them, so keepInQueue must be
+ * set if batchCount is greater than 1.
+ */
+- (FSTOutstandingWrite *)receiveWriteError:(int)errorCode
+                                  userInfo:(NSDictionary<NSString *, id> *)userInfo
+                               keepInQueue:(BOOL)keepInQueue
+                                batchCount:(int)batchCount;
+
 /**
  * Delivers a write acknowledgement as if the Streaming Write backend has acknowledged a write with
  * the snapshot version at which the write was committed.
  *
  * @param commitVersion The snapshot version at which the simulated server has committed
  *     the mutation. Snapshot versions must be monotonically increasing.
- * @param mutationResults The mutation results for the write that is being acked.
+ * @param mutationResults The mutation results for the write that is being acked. If the request
+ *     merged several writes, there is one result for each of them, and they are all acknowledged.
  */
 - (FSTOutstandingWrite *)
     receiveWriteAckWithVersion:(const firebase::firestore::model::SnapshotVersion &)commitVersion
                mutationResults:(std::vector<FSTMutationResult *>)mutationResults;
 
+/**
+ * Delivers the response to a resumed write stream handshake as if the Streaming Write backend had
+ * sent it. Writes are sent behind a resumed handshake before its response, which otherwise only
+ * arrives along with the first write acknowledgement.
+ */
+- (void)receiveWriteHandshakeAck;
+
+/** Whether the last write stream handshake resumed an earlier stream. */
+@property(nonatomic, readonly) BOOL lastWriteHandshakeResumed;
+
 /**
  * A count of the mutations written to the write stream by the FSTSyncEngine, but not yet
  * acknowledged via receiveWriteError: or receiveWriteAckWithVersion:mutationResults.
@@ -274,6 +324,16 @@ typedef std::unordered_map<firebase::firestore::auth::User,
 /** Sets the expected set of documents in limbo. */
 - (void)setExpectedLimboDocuments:(firebase::firestore::model::DocumentKeySet)docs;
 
+/** The documents in limbo whose resolution has not started yet, in the order they'll start. */
+- (std::vector<firebase::firestore::model::DocumentKey>)enqueuedLimboDocuments;
+
+/** The expected documents in limbo whose resolution has not started yet. */
+- (const std::vector<firebase::firestore::model::DocumentKey> &)expectedEnqueuedLimboDocuments;
+
+/** Sets the expected documents in limbo whose resolution has not started yet. */
+- (void)setExpectedEnqueuedLimboDocuments:
+    (std::vector<firebase::firestore::model::DocumentKey>)docs;
+
 /**
  * The writes that have been sent to the FSTSyncEngine via writeUserMutation: but not yet
  * acknowledged by calling receiveWriteAck/Error:. They are tracked per-user.
@@ -305,6 +365,23 @@ typedef std::unordered_map<firebase::firestore::auth::User,
 - (void)setExpectedActiveTargets:
     (const std::unordered_map<firebase::firestore::model::TargetId, FSTQueryData *> &)targets;
 
+/**
+ * The expected counts sent along with the active targets on the watch stream, for the targets that
+ * had one.
+ */
+- (const std::unordered_map<firebase::firestore::model::TargetId, int32_t> &)
+    activeTargetExpectedCounts;
+
+/**
+ * The expected counts that the active targets are expected to have been sent with. Only the
+ * targets listed are checked.
+ */
+- (const std::unordered_map<firebase::firestore::model::TargetId, int32_t> &)
+    expectedActiveTargetExpectedCounts;
+
+- (void)setExpectedActiveTargetExpectedCounts:
+    (const std::unordered_map<firebase::firestore::model::TargetId, int32_t> &)counts;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -18,6 +18,7 @@
 
 #import <FirebaseFirestore/FIRFirestoreErrors.h>
 
+#include <limits>
 #include <map>
 #include <memory>
 #include <string>
@@ -72,6 +73,7 @@ using firebase::firestore::model::TargetId;
 using firebase::firestore::remote::MockDatastore;
 using firebase::firestore::remote::RemoteStore;
 using firebase::firestore::remote::WatchChange;
+using firebase::firestore::remote::WritePipelineOptions;
 using firebase::firestore::util::AsyncQueue;
 using firebase::firestore::util::TimerId;
 using firebase::firestore::util::ExecutorLibdispatch;
@@ -140,10 +142,12 @@ NS_ASSUME_NONNULL_BEGIN
   std::unique_ptr<RemoteStore> _remoteStore;
 
   std::unordered_map<TargetId, FSTQueryData *> _expectedActiveTargets;
+  std::unordered_map<TargetId, int32_t> _expectedActiveTargetExpectedCounts;
 
   // ivar is declared as mutable.
   std::unordered_map<User, NSMutableArray<FSTOutstandingWrite *> *, HashUser> _outstandingWrites;
   DocumentKeySet _expectedLimboDocuments;
+  std::vector<DocumentKey> _expectedEnqueuedLimboDocuments;
 
   /** A dictionary for tracking the listens on queries. */
   objc::unordered_map<FSTQuery *, std::shared_ptr<QueryListener>> _queryListeners;
@@ -164,6 +168,42 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
                         initialUser:(const User &)initialUser
                   outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites {
+  return [self initWithPersistence:persistence
+                        initialUser:initialUser
+                  outstandingWrites:outstandingWrites
+      maxConcurrentLimboResolutions:std::numeric_limits<size_t>::max()];
+}
+
+- (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
+                        initialUser:(const User &)initialUser
+                  outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites
+      maxConcurrentLimboResolutions:(size_t)maxConcurrentLimboResolutions {
+  return [self initWithPersistence:persistence
+                        initialUser:initialUser
+                  outstandingWrites:outstandingWrites
+      maxConcurrentLimboResolutions:maxConcurrentLimboResolutions
+          maxBatchesPerWriteRequest:1];
+}
+
+- (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
+                        initialUser:(const User &)initialUser
+                  outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites
+      maxConcurrentLimboResolutions:(size_t)maxConcurrentLimboResolutions
+          maxBatchesPerWriteRequest:(int)maxBatchesPerWriteRequest {
+  return [self initWithPersistence:persistence
+                        initialUser:initialUser
+                  outstandingWrites:outstandingWrites
+      maxConcurrentLimboResolutions:maxConcurrentLimboResolutions
+          maxBatchesPerWriteRequest:maxBatchesPerWriteRequest
+                  resumeWriteStream:NO];
+}
+
+- (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
+                        initialUser:(const User &)initialUser
+                  outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites
+      maxConcurrentLimboResolutions:(size_t)maxConcurrentLimboResolutions
+          maxBatchesPerWriteRequest:(int)maxBatchesPerWriteRequest
+                  resumeWriteStream:(BOOL)resumeWriteStream {
   if (self = [super init]) {
     // Do a deep copy.
     for (const auto &pair : outstandingWrites) {
@@ -183,16 +223,21 @@ NS_ASSUME_NONNULL_BEGIN
 
     _datastore =
         std::make_shared<MockDatastore>(_databaseInfo, _workerQueue.get(), &_credentialProvider);
+    WritePipelineOptions writePipelineOptions;
+    writePipelineOptions.max_batches_per_request = maxBatchesPerWriteRequest;
+    writePipelineOptions.resume_write_stream = resumeWriteStream;
     _remoteStore = absl::make_unique<RemoteStore>(
-        _localStore, _datastore, _workerQueue.get(), [self](OnlineState onlineState) {
+        _localStore, _datastore, _workerQueue.get(),
+        [self](OnlineState onlineState) {
           [self.syncEngine applyChangedOnlineState:onlineState];
           [self.eventManager applyChangedOnlineState:onlineState];
-        });
-    ;
+        },
+        writePipelineOptions);
 
     _syncEngine = [[FSTSyncEngine alloc] initWithLocalStore:_localStore
-                                                remoteStore:_remoteStore.get()
-                                                initialUser:initialUser];
+                                                  remoteStore:_remoteStore.get()
+                                                  initialUser:initialUser
+                                maxConcurrentLimboResolutions:maxConcurrentLimboResolutions];
     _remoteStore->set_sync_engine(_syncEngine);
     _eventManager = [FSTEventManager eventManagerWithSyncEngine:_syncEngine];
 
@@ -224,6 +269,14 @@ NS_ASSUME_NONNULL_BEGIN
   _expectedLimboDocuments = std::move(docs);
 }
 
+- (const std::vector<DocumentKey> &)expectedEnqueuedLimboDocuments {
+  return _expectedEnqueuedLimboDocuments;
+}
+
+- (void)setExpectedEnqueuedLimboDocuments:(std::vector<DocumentKey>)docs {
+  _expectedEnqueuedLimboDocuments = std::move(docs);
+}
+
 - (void)drainQueue {
   _workerQueue->EnqueueBlocking([] {});
 }
@@ -252,15 +305,36 @@ NS_ASSUME_NONNULL_BEGIN
   });
 }
 
-- (void)validateNextWriteSent:(FSTMutation *)expectedWrite {
+/**
+ * Validates that the next request sent to the mock datastore holds the first `count` outstanding
+ * writes. Each write is a batch of a single mutation, so a merged request holds one mutation per
+ * batch.
+ */
+- (void)validateNextWritesSent:(NSUInteger)count {
   std::vector<FSTMutation *> request = _datastore->NextSentWrite();
-  // Make sure the write went through the pipe like we expected it to.
-  HARD_ASSERT(request.size() == 1, "Only single mutation requests are supported at the moment");
-  FSTMutation *actualWrite = request[0];
-  HARD_ASSERT([actualWrite isEqual:expectedWrite],
-              "Mock datastore received write %s but first outstanding mutation was %s", actualWrite,
-              expectedWrite);
-  LOG_DEBUG("A write was sent: %s", actualWrite);
+  // Make sure the writes went through the pipe like we expected them to.
+  HARD_ASSERT(request.size() == count, "Mock datastore received a request of %s mutations, not %s",
+              request.size(), count);
+  NSArray<FSTOutstandingWrite *> *outstandingWrites = [self currentOutstandingWrites];
+  HARD_ASSERT(outstandingWrites.count >= count,
+              "Got a request for %s writes but only %s are queued", count,
+              outstandingWrites.count);
+  for (NSUInteger i = 0; i < count; ++i) {
+    FSTMutation *actualWrite = request[i];
+    FSTMutation *expectedWrite = outstandingWrites[i].write;
+    HARD_ASSERT([actualWrite isEqual:expectedWrite],
+                "Mock datastore received write %s but the outstanding mutation was %s",
+                actualWrite, expectedWrite);
+    LOG_DEBUG("A write was sent: %s", actualWrite);
+  }
+}
+
+- (void)receiveWriteHandshakeAck {
+  _workerQueue->EnqueueBlocking([&] { _datastore->AckWriteHandshake(); });
+}
+
+- (BOOL)lastWriteHandshakeResumed {
+  return _datastore->LastWriteHandshakeResumed();
 }
 
 - (int)sentWritesCount {
@@ -300,9 +374,10 @@ NS_ASSUME_NONNULL_BEGIN
 - (FSTOutstandingWrite *)receiveWriteAckWithVersion:(const SnapshotVersion &)commitVersion
                                     mutationResults:
                                         (std::vector<FSTMutationResult *>)mutationResults {
+  NSUInteger batchCount = mutationResults.size();
+  [self validateNextWritesSent:batchCount];
   FSTOutstandingWrite *write = [self currentOutstandingWrites].firstObject;
-  [[self currentOutstandingWrites] removeObjectAtIndex:0];
-  [self validateNextWriteSent:write.write];
+  [[self currentOutstandingWrites] removeObjectsInRange:NSMakeRange(0, batchCount)];
 
   _workerQueue->EnqueueBlocking(
       [&] { _datastore->AckWrite(commitVersion, std::move(mutationResults)); });
@@ -313,10 +388,18 @@ NS_ASSUME_NONNULL_BEGIN
 - (FSTOutstandingWrite *)receiveWriteError:(int)errorCode
                                   userInfo:(NSDictionary<NSString *, id> *)userInfo
                                keepInQueue:(BOOL)keepInQueue {
+  return [self receiveWriteError:errorCode userInfo:userInfo keepInQueue:keepInQueue batchCount:1];
+}
+
+- (FSTOutstandingWrite *)receiveWriteError:(int)errorCode
+                                  userInfo:(NSDictionary<NSString *, id> *)userInfo
+                               keepInQueue:(BOOL)keepInQueue
+                                batchCount:(int)batchCount {
+  HARD_ASSERT(batchCount == 1 || keepInQueue, "A failed merged request doesn't reject its writes");
   Status error{static_cast<FirestoreErrorCode>(errorCode), MakeString([userInfo description])};
 
   FSTOutstandingWrite *write = [self currentOutstandingWrites].firstObject;
-  [self validateNextWriteSent:write.write];
+  [self validateNextWritesSent:batchCount];
 
   // If this is a permanent error, the mutation is not expected to be sent again so we remove it
   // from currentOutstandingWrites.
@@ -425,6 +508,10 @@ NS_ASSUME_NONNULL_BEGIN
   return [self.syncEngine currentLimboDocuments];
 }
 
+- (std::vector<DocumentKey>)enqueuedLimboDocuments {
+  return [self.syncEngine enqueuedLimboDocuments];
+}
+
 - (const std::unordered_map<TargetId, FSTQueryData *> &)activeTargets {
   return _datastore->ActiveTargets();
 }
@@ -437,6 +524,19 @@ NS_ASSUME_NONNULL_BEGIN
   _expectedActiveTargets = targets;
 }
 
+- (const std::unordered_map<TargetId, int32_t> &)activeTargetExpectedCounts {
+  return _datastore->ExpectedCounts();
+}
+
+- (const std::unordered_map<TargetId, int32_t> &)expectedActiveTargetExpectedCounts {
+  return _expectedActiveTargetExpectedCounts;
+}
+
+- (void)setExpectedActiveTargetExpectedCounts:
+    (const std::unordered_map<TargetId, int32_t> &)counts {
+  _expectedActiveTargetExpectedCounts = counts;
+}
+
 #pragma mark - Helper Methods
 
 - (NSMutableArray<FSTOutstandingWrite *> *)currentOutstandingWrites {
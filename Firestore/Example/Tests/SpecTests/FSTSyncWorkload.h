@@ -0,0 +1,122 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#include <cstdint>
+
+@protocol FSTPersistence;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** The knobs of a synthetic sync workload. */
+@interface FSTSyncWorkloadConfig : NSObject
+
+/** The number of queries that are listened to. Defaults to 10. */
+@property(nonatomic, assign) int targetCount;
+
+/** The number of documents in the result of each query. Defaults to 100. */
+@property(nonatomic, assign) int documentsPerTarget;
+
+/**
+ * The sizes (in bytes) of the payloads of generated documents. Each document picks one of them
+ * at random, so repeating a size makes it more likely. Defaults to @[ 256, 1024, 4096 ].
+ */
+@property(nonatomic, copy) NSArray<NSNumber *> *documentSizes;
+
+/** The fraction of the documents of each target that change per churn round. Defaults to 0.1. */
+@property(nonatomic, assign) double churnRate;
+
+/** The number of remote snapshots that update existing documents. Defaults to 10. */
+@property(nonatomic, assign) int churnRounds;
+
+/** The number of writes made while the network is disabled. Defaults to 100. */
+@property(nonatomic, assign) int offlineWriteCount;
+
+/** Seeds the random choices so that runs are reproducible. */
+@property(nonatomic, assign) uint32_t seed;
+
+@end
+
+/**
+ * A named sequence of steps. Steps use the format of the spec tests (e.g. `userListen`,
+ * `watchEntity` or `writeAck`); expectations on the steps are ignored.
+ */
+@interface FSTSyncWorkloadPhase : NSObject
+
+- (instancetype)initWithName:(NSString *)name steps:(NSArray<NSDictionary *> *)steps;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property(nonatomic, copy, readonly) NSString *name;
+@property(nonatomic, copy, readonly) NSArray<NSDictionary *> *steps;
+
+@end
+
+/** What it took to run one phase. All durations are in seconds. */
+@interface FSTSyncWorkloadPhaseResult : NSObject
+
+@property(nonatomic, copy, readonly) NSString *name;
+@property(nonatomic, assign, readonly) NSUInteger stepCount;
+
+/** The number of query events raised while running the phase. */
+@property(nonatomic, assign, readonly) NSUInteger eventCount;
+
+@property(nonatomic, assign, readonly) double totalDuration;
+@property(nonatomic, assign, readonly) double stepsPerSecond;
+@property(nonatomic, assign, readonly) double p50;
+@property(nonatomic, assign, readonly) double p90;
+@property(nonatomic, assign, readonly) double p99;
+
+@end
+
+/**
+ * Replays workloads against an FSTSyncEngine and an FSTLocalStore, using the scripted datastore
+ * of the spec tests in place of the backend, and measures how long every step takes.
+ *
+ * Workloads are either generated from an FSTSyncWorkloadConfig or replayed from recorded
+ * traffic; see +phasesWithJSONData:error:.
+ */
+@interface FSTSyncWorkload : NSObject
+
+/**
+ * Generates a workload with four phases:
+ *
+ * + "listen": listens to every target and delivers its initial result.
+ * + "churn": delivers remote snapshots that update some of the listened documents.
+ * + "offline writes": disables the network and writes documents locally.
+ * + "write acks": enables the network and acknowledges the offline writes.
+ */
++ (NSArray<FSTSyncWorkloadPhase *> *)phasesWithConfig:(FSTSyncWorkloadConfig *)config;
+
+/**
+ * Parses recorded traffic, which is either a spec test (a dictionary with `steps`), replayed as
+ * a single phase, or a dictionary with a list of `phases`, each with a `name` and `steps`.
+ */
++ (nullable NSArray<FSTSyncWorkloadPhase *> *)phasesWithJSONData:(NSData *)data
+                                                           error:(NSError **)error;
+
+/** Creates a workload that runs against the given (empty) persistence. */
+- (instancetype)initWithPersistence:(id<FSTPersistence>)persistence NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/** Runs the phases in order on a freshly started client and shuts it down afterwards. */
+- (NSArray<FSTSyncWorkloadPhaseResult *> *)runPhases:(NSArray<FSTSyncWorkloadPhase *> *)phases;
+
+@end
+
+NS_ASSUME_NONNULL_END
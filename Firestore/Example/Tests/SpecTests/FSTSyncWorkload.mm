@@ -0,0 +1,396 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Example/Tests/SpecTests/FSTSyncWorkload.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cmath>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Local/FSTPersistence.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
+#import "Firestore/Source/Model/FSTMutation.h"
+
+#import "Firestore/Example/Tests/SpecTests/FSTSyncEngineTestDriver.h"
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+
+namespace testutil = firebase::firestore::testutil;
+namespace util = firebase::firestore::util;
+using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::SnapshotVersion;
+using firebase::firestore::model::TargetId;
+using firebase::firestore::remote::DocumentWatchChange;
+using firebase::firestore::remote::WatchTargetChange;
+using firebase::firestore::remote::WatchTargetChangeState;
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<TargetId> ConvertTargetsArray(NSArray<NSNumber *> *_Nullable from) {
+  std::vector<TargetId> result;
+  for (NSNumber *targetID in from) {
+    result.push_back(targetID.intValue);
+  }
+  return result;
+}
+
+SnapshotVersion ParseVersion(NSNumber *_Nullable version) {
+  return testutil::Version(version.longLongValue);
+}
+
+NSData *_Nullable ParseResumeToken(NSString *_Nullable token) {
+  return [token dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+/** Returns the nearest-rank percentile of the given sorted durations. */
+double Percentile(const std::vector<double> &sorted, double percentile) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  auto rank = static_cast<size_t>(std::ceil(percentile * sorted.size()));
+  return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+}  // namespace
+
+@implementation FSTSyncWorkloadConfig
+
+- (instancetype)init {
+  if (self = [super init]) {
+    _targetCount = 10;
+    _documentsPerTarget = 100;
+    _documentSizes = @[ @256, @1024, @4096 ];
+    _churnRate = 0.1;
+    _churnRounds = 10;
+    _offlineWriteCount = 100;
+    _seed = 42;
+  }
+  return self;
+}
+
+@end
+
+@implementation FSTSyncWorkloadPhase
+
+- (instancetype)initWithName:(NSString *)name steps:(NSArray<NSDictionary *> *)steps {
+  if (self = [super init]) {
+    _name = [name copy];
+    _steps = [steps copy];
+  }
+  return self;
+}
+
+@end
+
+@implementation FSTSyncWorkloadPhaseResult
+
+- (instancetype)initWithName:(NSString *)name
+                  eventCount:(NSUInteger)eventCount
+                   durations:(std::vector<double>)durations {
+  if (self = [super init]) {
+    _name = [name copy];
+    _stepCount = durations.size();
+    _eventCount = eventCount;
+    std::sort(durations.begin(), durations.end());
+    for (double duration : durations) {
+      _totalDuration += duration;
+    }
+    _stepsPerSecond = _totalDuration > 0 ? _stepCount / _totalDuration : 0;
+    _p50 = Percentile(durations, 0.5);
+    _p90 = Percentile(durations, 0.9);
+    _p99 = Percentile(durations, 0.99);
+  }
+  return self;
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<FSTSyncWorkloadPhaseResult: %@: %lu steps, %lu events, "
+                                    @"%.3fs, %.1f steps/s, p50=%.3fms p90=%.3fms p99=%.3fms>",
+                                    self.name, (unsigned long)self.stepCount,
+                                    (unsigned long)self.eventCount, self.totalDuration,
+                                    self.stepsPerSecond, self.p50 * 1000, self.p90 * 1000,
+                                    self.p99 * 1000];
+}
+
+@end
+
+@implementation FSTSyncWorkload {
+  id<FSTPersistence> _persistence;
+  FSTSyncEngineTestDriver *_driver;
+}
+
+#pragma mark - Generating workloads
+
++ (NSArray<FSTSyncWorkloadPhase *> *)phasesWithConfig:(FSTSyncWorkloadConfig *)config {
+  HARD_ASSERT(config.documentSizes.count > 0, "A workload needs at least one document size");
+
+  std::mt19937 random{config.seed};
+  std::vector<int> sizes;
+  for (NSNumber *size in config.documentSizes) {
+    sizes.push_back(size.intValue);
+  }
+  std::uniform_int_distribution<size_t> pickSize{0, sizes.size() - 1};
+
+  int64_t version = 1000;
+  auto documentValue = [&](int index) -> NSDictionary * {
+    NSString *payload = [@"" stringByPaddingToLength:sizes[pickSize(random)]
+                                          withString:@"x"
+                                     startingAtIndex:0];
+    return @{@"index" : @(index), @"payload" : payload};
+  };
+  auto document = [&](int target, int index) -> NSDictionary * {
+    return @{
+      @"key" : [NSString stringWithFormat:@"collection%d/doc%d", target, index],
+      @"version" : @(++version),
+      @"value" : documentValue(index)
+    };
+  };
+  auto snapshot = [&]() -> NSDictionary * {
+    return @{@"watchSnapshot" : @{@"version" : @(++version), @"targetIds" : @[]}};
+  };
+
+  // Queries get the target IDs 2, 4, 6 and so on.
+  NSMutableArray<NSDictionary *> *listen = [NSMutableArray array];
+  for (int target = 0; target < config.targetCount; target++) {
+    NSNumber *targetID = @(2 * (target + 1));
+    NSString *path = [NSString stringWithFormat:@"collection%d", target];
+    NSMutableArray<NSDictionary *> *docs = [NSMutableArray array];
+    for (int index = 0; index < config.documentsPerTarget; index++) {
+      [docs addObject:document(target, index)];
+    }
+    [listen addObject:@{@"userListen" : @[ targetID, path ]}];
+    [listen addObject:@{@"watchAck" : @[ targetID ]}];
+    [listen addObject:@{@"watchEntity" : @{@"docs" : docs, @"targets" : @[ targetID ]}}];
+    [listen addObject:@{
+      @"watchCurrent" : @[ @[ targetID ], [NSString stringWithFormat:@"resume-token-%d", target] ]
+    }];
+    [listen addObject:snapshot()];
+  }
+
+  auto changedPerTarget =
+      static_cast<int>(std::lround(config.churnRate * config.documentsPerTarget));
+  std::uniform_int_distribution<int> pickDocument{0, std::max(config.documentsPerTarget - 1, 0)};
+  NSMutableArray<NSDictionary *> *churn = [NSMutableArray array];
+  for (int round = 0; round < config.churnRounds && changedPerTarget > 0; round++) {
+    for (int target = 0; target < config.targetCount; target++) {
+      NSMutableArray<NSDictionary *> *docs = [NSMutableArray array];
+      for (int i = 0; i < changedPerTarget; i++) {
+        [docs addObject:document(target, pickDocument(random))];
+      }
+      [churn addObject:@{
+        @"watchEntity" : @{@"docs" : docs, @"targets" : @[ @(2 * (target + 1)) ]}
+      }];
+    }
+    [churn addObject:snapshot()];
+  }
+
+  NSMutableArray<NSDictionary *> *offline = [NSMutableArray array];
+  [offline addObject:@{@"enableNetwork" : @NO}];
+  for (int index = 0; index < config.offlineWriteCount; index++) {
+    NSString *path = [NSString stringWithFormat:@"writes/doc%d", index];
+    [offline addObject:@{@"userSet" : @[ path, documentValue(index) ]}];
+  }
+
+  NSMutableArray<NSDictionary *> *acks = [NSMutableArray array];
+  [acks addObject:@{@"enableNetwork" : @YES}];
+  for (int index = 0; index < config.offlineWriteCount; index++) {
+    [acks addObject:@{@"writeAck" : @{@"version" : @(++version)}}];
+  }
+
+  return @[
+    [[FSTSyncWorkloadPhase alloc] initWithName:@"listen" steps:listen],
+    [[FSTSyncWorkloadPhase alloc] initWithName:@"churn" steps:churn],
+    [[FSTSyncWorkloadPhase alloc] initWithName:@"offline writes" steps:offline],
+    [[FSTSyncWorkloadPhase alloc] initWithName:@"write acks" steps:acks],
+  ];
+}
+
++ (nullable NSArray<FSTSyncWorkloadPhase *> *)phasesWithJSONData:(NSData *)data
+                                                           error:(NSError **)error {
+  id _Nullable parsed = [NSJSONSerialization JSONObjectWithData:data options:0 error:error];
+  if (!parsed) {
+    return nil;
+  }
+  HARD_ASSERT([parsed isKindOfClass:[NSDictionary class]],
+              "Recorded traffic must be a JSON object");
+  NSDictionary *recording = (NSDictionary *)parsed;
+
+  if (recording[@"steps"]) {
+    NSString *name = recording[@"itName"] ?: @"replay";
+    return @[ [[FSTSyncWorkloadPhase alloc] initWithName:name steps:recording[@"steps"]] ];
+  }
+
+  NSMutableArray<FSTSyncWorkloadPhase *> *phases = [NSMutableArray array];
+  for (NSDictionary *phase in recording[@"phases"]) {
+    [phases addObject:[[FSTSyncWorkloadPhase alloc] initWithName:phase[@"name"]
+                                                           steps:phase[@"steps"]]];
+  }
+  return phases;
+}
+
+#pragma mark - Running workloads
+
+- (instancetype)initWithPersistence:(id<FSTPersistence>)persistence {
+  if (self = [super init]) {
+    _persistence = persistence;
+  }
+  return self;
+}
+
+- (NSArray<FSTSyncWorkloadPhaseResult *> *)runPhases:(NSArray<FSTSyncWorkloadPhase *> *)phases {
+  HARD_ASSERT(!_driver, "A workload can only be run once");
+  _driver = [[FSTSyncEngineTestDriver alloc] initWithPersistence:_persistence];
+  [_driver start];
+
+  NSMutableArray<FSTSyncWorkloadPhaseResult *> *results = [NSMutableArray array];
+  @try {
+    for (FSTSyncWorkloadPhase *phase in phases) {
+      std::vector<double> durations;
+      NSUInteger eventCount = 0;
+      for (NSDictionary *step in phase.steps) {
+        Clock::time_point start = Clock::now();
+        [self doStep:step];
+        std::chrono::duration<double> duration = Clock::now() - start;
+        durations.push_back(duration.count());
+
+        eventCount += [_driver capturedEventsSinceLastCall].count;
+      }
+      [results addObject:[[FSTSyncWorkloadPhaseResult alloc] initWithName:phase.name
+                                                               eventCount:eventCount
+                                                                durations:std::move(durations)]];
+    }
+  } @finally {
+    // Release the persistence (and with it the LevelDB lock) even if a step failed.
+    [_driver shutdown];
+  }
+  return results;
+}
+
+/** Applies one step, supporting the subset of spec test steps that makes sense in a workload. */
+- (void)doStep:(NSDictionary *)step {
+  if (step[@"userListen"]) {
+    NSArray *listenSpec = step[@"userListen"];
+    TargetId targetID = [_driver addUserListenerWithQuery:[self parseQuery:listenSpec[1]]];
+    HARD_ASSERT(targetID == [listenSpec[0] intValue], "Expected target ID %s, got %s",
+                [listenSpec[0] intValue], targetID);
+  } else if (step[@"userUnlisten"]) {
+    [_driver removeUserListenerWithQuery:[self parseQuery:step[@"userUnlisten"][1]]];
+  } else if (step[@"userSet"]) {
+    NSArray *setSpec = step[@"userSet"];
+    [_driver writeUserMutation:FSTTestSetMutation(setSpec[0], setSpec[1])];
+  } else if (step[@"userPatch"]) {
+    NSArray *patchSpec = step[@"userPatch"];
+    [_driver
+        writeUserMutation:FSTTestPatchMutation(util::MakeString(patchSpec[0]), patchSpec[1], {})];
+  } else if (step[@"userDelete"]) {
+    [_driver writeUserMutation:FSTTestDeleteMutation(step[@"userDelete"])];
+  } else if (step[@"drainQueue"]) {
+    [_driver drainQueue];
+  } else if (step[@"watchAck"]) {
+    WatchTargetChange change{WatchTargetChangeState::Added,
+                             ConvertTargetsArray(step[@"watchAck"])};
+    [_driver receiveWatchChange:change snapshotVersion:SnapshotVersion::None()];
+  } else if (step[@"watchCurrent"]) {
+    NSArray *currentSpec = step[@"watchCurrent"];
+    WatchTargetChange change{WatchTargetChangeState::Current, ConvertTargetsArray(currentSpec[0]),
+                             ParseResumeToken(currentSpec[1])};
+    [_driver receiveWatchChange:change snapshotVersion:SnapshotVersion::None()];
+  } else if (step[@"watchEntity"]) {
+    [self doWatchEntity:step[@"watchEntity"]];
+  } else if (step[@"watchSnapshot"]) {
+    NSDictionary *snapshotSpec = step[@"watchSnapshot"];
+    WatchTargetChange change{WatchTargetChangeState::NoChange,
+                             ConvertTargetsArray(snapshotSpec[@"targetIds"]),
+                             ParseResumeToken(snapshotSpec[@"resumeToken"])};
+    [_driver receiveWatchChange:change snapshotVersion:ParseVersion(snapshotSpec[@"version"])];
+  } else if (step[@"enableNetwork"]) {
+    if ([step[@"enableNetwork"] boolValue]) {
+      [_driver enableNetwork];
+    } else {
+      [_driver disableNetwork];
+    }
+  } else if (step[@"writeAck"]) {
+    SnapshotVersion version = ParseVersion(step[@"writeAck"][@"version"]);
+    FSTMutationResult *mutationResult = [[FSTMutationResult alloc] initWithVersion:version
+                                                                  transformResults:nil];
+    [_driver receiveWriteAckWithVersion:version mutationResults:{mutationResult}];
+  } else {
+    HARD_FAIL("Unsupported workload step: %s", step);
+  }
+}
+
+- (void)doWatchEntity:(NSDictionary *)watchEntity {
+  std::vector<TargetId> targets = ConvertTargetsArray(watchEntity[@"targets"]);
+  std::vector<TargetId> removedTargets = ConvertTargetsArray(watchEntity[@"removedTargets"]);
+
+  NSArray<NSDictionary *> *docs = watchEntity[@"docs"];
+  if (watchEntity[@"doc"]) {
+    docs = @[ watchEntity[@"doc"] ];
+  }
+  if (docs) {
+    for (NSDictionary *docSpec in docs) {
+      DocumentKey key = FSTTestDocKey(docSpec[@"key"]);
+      SnapshotVersion version = ParseVersion(docSpec[@"version"]);
+      FSTMaybeDocument *doc =
+          [docSpec[@"value"] isKindOfClass:[NSNull class]]
+              ? [FSTDeletedDocument documentWithKey:key
+                                            version:std::move(version)
+                              hasCommittedMutations:NO]
+              : [FSTDocument documentWithData:FSTTestObjectValue(docSpec[@"value"])
+                                          key:key
+                                      version:std::move(version)
+                                        state:FSTDocumentStateSynced];
+      DocumentWatchChange change{targets, removedTargets, doc.key, doc};
+      [_driver receiveWatchChange:change snapshotVersion:SnapshotVersion::None()];
+    }
+  } else if (watchEntity[@"key"]) {
+    DocumentWatchChange change{{}, removedTargets, FSTTestDocKey(watchEntity[@"key"]), nil};
+    [_driver receiveWatchChange:change snapshotVersion:SnapshotVersion::None()];
+  } else {
+    HARD_FAIL("Either key, doc or docs must be set.");
+  }
+}
+
+- (FSTQuery *)parseQuery:(id)querySpec {
+  if ([querySpec isKindOfClass:[NSDictionary class]]) {
+    NSDictionary *queryDict = (NSDictionary *)querySpec;
+    HARD_ASSERT(!queryDict[@"filters"] && !queryDict[@"orderBys"] && !queryDict[@"limit"],
+                "Workloads only support queries of whole collections");
+    querySpec = queryDict[@"path"];
+  }
+  return FSTTestQuery(util::MakeString((NSString *)querySpec));
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "Firestore/Example/Tests/SpecTests/FSTSyncWorkload.h"
+
+#import <XCTest/XCTest.h>
+
+#import "Firestore/Source/Local/FSTLevelDB.h"
+#import "Firestore/Source/Local/FSTMemoryPersistence.h"
+
+#import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface FSTSyncWorkloadTests : XCTestCase
+@end
+
+@implementation FSTSyncWorkloadTests
+
+- (FSTSyncWorkloadConfig *)smallConfig {
+  FSTSyncWorkloadConfig *config = [[FSTSyncWorkloadConfig alloc] init];
+  config.targetCount = 3;
+  config.documentsPerTarget = 20;
+  config.churnRate = 0.25;
+  config.churnRounds = 2;
+  config.offlineWriteCount = 15;
+  return config;
+}
+
+- (void)assertResults:(NSArray<FSTSyncWorkloadPhaseResult *> *)results
+    matchSmallConfigPhases:(NSArray<FSTSyncWorkloadPhase *> *)phases {
+  XCTAssertEqual(results.count, 4);
+  for (NSUInteger i = 0; i < results.count; i++) {
+    XCTAssertEqualObjects(results[i].name, phases[i].name);
+    XCTAssertEqual(results[i].stepCount, phases[i].steps.count);
+    XCTAssertLessThanOrEqual(results[i].p50, results[i].p90);
+    XCTAssertLessThanOrEqual(results[i].p90, results[i].p99);
+  }
+
+  // Every target raises its initial snapshot and one snapshot per churn round.
+  XCTAssertEqual(results[0].stepCount, 3 * 5);
+  XCTAssertEqual(results[0].eventCount, 3);
+  XCTAssertEqual(results[1].eventCount, 3 * 2);
+
+  XCTAssertEqual(results[2].stepCount, 1 + 15);
+  XCTAssertEqual(results[3].stepCount, 1 + 15);
+}
+
+- (void)testRunsGeneratedWorkloadInMemory {
+  NSArray<FSTSyncWorkloadPhase *> *phases =
+      [FSTSyncWorkload phasesWithConfig:[self smallConfig]];
+  FSTSyncWorkload *workload =
+      [[FSTSyncWorkload alloc] initWithPersistence:[FSTPersistenceTestHelpers
+                                                       eagerGCMemoryPersistence]];
+  [self assertResults:[workload runPhases:phases] matchSmallConfigPhases:phases];
+}
+
+- (void)testRunsGeneratedWorkloadOnLevelDB {
+  NSArray<FSTSyncWorkloadPhase *> *phases =
+      [FSTSyncWorkload phasesWithConfig:[self smallConfig]];
+  FSTSyncWorkload *workload =
+      [[FSTSyncWorkload alloc] initWithPersistence:[FSTPersistenceTestHelpers levelDBPersistence]];
+  [self assertResults:[workload runPhases:phases] matchSmallConfigPhases:phases];
+}
+
+- (void)testGeneratedWorkloadsAreReproducible {
+  FSTSyncWorkloadConfig *config = [self smallConfig];
+  NSArray<FSTSyncWorkloadPhase *> *first = [FSTSyncWorkload phasesWithConfig:config];
+  NSArray<FSTSyncWorkloadPhase *> *second = [FSTSyncWorkload phasesWithConfig:config];
+  for (NSUInteger i = 0; i < first.count; i++) {
+    XCTAssertEqualObjects(first[i].steps, second[i].steps);
+  }
+}
+
+- (void)testReplaysRecordedTraffic {
+  NSString *json = @"{\"phases\": [{\"name\": \"recorded\", \"steps\": ["
+                   @"{\"userListen\": [2, \"collection\"]},"
+                   @"{\"watchAck\": [2]},"
+                   @"{\"watchEntity\": {\"docs\": [{\"key\": \"collection/a\", \"version\": 1000,"
+                   @"  \"value\": {\"v\": 1}}], \"targets\": [2]}},"
+                   @"{\"watchCurrent\": [[2], \"resume-token-1000\"]},"
+                   @"{\"watchSnapshot\": {\"version\": 1000, \"targetIds\": []}},"
+                   @"{\"userSet\": [\"collection/b\", {\"v\": 2}]},"
+                   @"{\"writeAck\": {\"version\": 1001}}"
+                   @"]}]}";
+  NSError *error = nil;
+  NSArray<FSTSyncWorkloadPhase *> *phases =
+      [FSTSyncWorkload phasesWithJSONData:[json dataUsingEncoding:NSUTF8StringEncoding]
+                                    error:&error];
+  XCTAssertNil(error);
+  XCTAssertEqual(phases.count, 1);
+
+  FSTSyncWorkload *workload =
+      [[FSTSyncWorkload alloc] initWithPersistence:[FSTPersistenceTestHelpers
+                                                       eagerGCMemoryPersistence]];
+  NSArray<FSTSyncWorkloadPhaseResult *> *results = [workload runPhases:phases];
+  XCTAssertEqual(results.count, 1);
+  XCTAssertEqualObjects(results[0].name, @"recorded");
+  XCTAssertEqual(results[0].stepCount, 7);
+  // At least the initial snapshot and the latency-compensated write.
+  XCTAssertGreaterThanOrEqual(results[0].eventCount, 2);
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -195,8 +195,10 @@ class TestTargetMetadataProvider : public TargetMetadataProvider {
 
   model::DocumentKeySet GetRemoteKeysForTarget(model::TargetId target_id) const override;
   FSTQueryData *GetQueryDataForTarget(model::TargetId target_id) const override;
+  const model::DatabaseId &GetDatabaseId() const override;
 
  private:
+  model::DatabaseId database_id_{"test-project", "(default)"};
   std::unordered_map<model::TargetId, model::DocumentKeySet> synced_keys_;
   std::unordered_map<model::TargetId, FSTQueryData *> query_data_;
 };
@@ -378,6 +378,10 @@ FSTQueryData *TestTargetMetadataProvider::GetQueryDataForTarget(TargetId target_
   return it->second;
 }
 
+const DatabaseId &TestTargetMetadataProvider::GetDatabaseId() const {
+  return database_id_;
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
@@ -39,11 +39,12 @@ const pb_field_t firestore_client_Target_fields[7] = {
     PB_LAST_FIELD
 };
 
-const pb_field_t firestore_client_TargetGlobal_fields[5] = {
+const pb_field_t firestore_client_TargetGlobal_fields[6] = {
     PB_FIELD(  1, INT32   , SINGULAR, STATIC  , FIRST, firestore_client_TargetGlobal, highest_target_id, highest_target_id, 0),
     PB_FIELD(  2, INT64   , SINGULAR, STATIC  , OTHER, firestore_client_TargetGlobal, highest_listen_sequence_number, highest_target_id, 0),
     PB_FIELD(  3, MESSAGE , SINGULAR, STATIC  , OTHER, firestore_client_TargetGlobal, last_remote_snapshot_version, highest_listen_sequence_number, &google_protobuf_Timestamp_fields),
     PB_FIELD(  4, INT32   , SINGULAR, STATIC  , OTHER, firestore_client_TargetGlobal, target_count, last_remote_snapshot_version, 0),
+    PB_FIELD(  5, INT64   , SINGULAR, STATIC  , OTHER, firestore_client_TargetGlobal, byte_size, target_count, 0),
     PB_LAST_FIELD
 };
 
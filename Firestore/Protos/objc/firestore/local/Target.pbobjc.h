@@ -163,6 +163,7 @@ typedef GPB_ENUM(FSTPBTargetGlobal_FieldNumber) {
   FSTPBTargetGlobal_FieldNumber_HighestListenSequenceNumber = 2,
   FSTPBTargetGlobal_FieldNumber_LastRemoteSnapshotVersion = 3,
   FSTPBTargetGlobal_FieldNumber_TargetCount = 4,
+  FSTPBTargetGlobal_FieldNumber_ByteSize = 5,
 };
 
 /**
@@ -203,6 +204,14 @@ typedef GPB_ENUM(FSTPBTargetGlobal_FieldNumber) {
 /** On platforms that need it, holds the number of targets persisted. */
 @property(nonatomic, readwrite) int32_t targetCount;
 
+/**
+ * On platforms that need it, holds the approximate number of bytes used by
+ * the persisted remote documents, targets and mutation batches. This is
+ * maintained incrementally so that LRU garbage collection can check the
+ * cache size without measuring it.
+ **/
+@property(nonatomic, readwrite) int64_t byteSize;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -184,6 +184,7 @@ void FSTPBTarget_ClearTargetTypeOneOfCase(FSTPBTarget *message) {
 @dynamic highestListenSequenceNumber;
 @dynamic hasLastRemoteSnapshotVersion, lastRemoteSnapshotVersion;
 @dynamic targetCount;
+@dynamic byteSize;
 
 typedef struct FSTPBTargetGlobal__storage_ {
   uint32_t _has_storage_[1];
@@ -191,6 +192,7 @@ typedef struct FSTPBTargetGlobal__storage_ {
   int32_t targetCount;
   GPBTimestamp *lastRemoteSnapshotVersion;
   int64_t highestListenSequenceNumber;
+  int64_t byteSize;
 } FSTPBTargetGlobal__storage_;
 
 // This method is threadsafe because it is initially called
@@ -235,6 +237,15 @@ typedef struct FSTPBTargetGlobal__storage_ {
         .flags = GPBFieldOptional,
         .dataType = GPBDataTypeInt32,
       },
+      {
+        .name = "byteSize",
+        .dataTypeSpecific.className = NULL,
+        .number = FSTPBTargetGlobal_FieldNumber_ByteSize,
+        .hasIndex = 4,
+        .offset = (uint32_t)offsetof(FSTPBTargetGlobal__storage_, byteSize),
+        .flags = GPBFieldOptional,
+        .dataType = GPBDataTypeInt64,
+      },
     };
     GPBDescriptor *localDescriptor =
         [GPBDescriptor allocDescriptorForClass:[FSTPBTargetGlobal class]
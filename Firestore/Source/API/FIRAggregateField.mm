@@ -0,0 +1,87 @@
+/*
+ * Copyright 2017 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FIRAggregateField.h"
+
+#include <utility>
+
+#import "Firestore/Source/API/FIRAggregateField+Internal.h"
+#import "Firestore/Source/API/FIRFieldPath+Internal.h"
+
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+
+namespace util = firebase::firestore::util;
+
+using firebase::firestore::core::AggregateField;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation FIRAggregateField {
+  AggregateField _field;
+}
+
+- (instancetype)initWithAggregateField:(AggregateField)field {
+  if (self = [super init]) {
+    _field = std::move(field);
+  }
+  return self;
+}
+
++ (instancetype)aggregateFieldForCount {
+  return [[self alloc] initWithAggregateField:AggregateField::Count()];
+}
+
++ (instancetype)aggregateFieldForSumOfField:(NSString *)field {
+  return [self aggregateFieldForSumOfFieldPath:[FIRFieldPath pathWithDotSeparatedString:field]];
+}
+
++ (instancetype)aggregateFieldForSumOfFieldPath:(FIRFieldPath *)path {
+  return [[self alloc] initWithAggregateField:AggregateField::Sum(path.internalValue)];
+}
+
++ (instancetype)aggregateFieldForAverageOfField:(NSString *)field {
+  return
+      [self aggregateFieldForAverageOfFieldPath:[FIRFieldPath pathWithDotSeparatedString:field]];
+}
+
++ (instancetype)aggregateFieldForAverageOfFieldPath:(FIRFieldPath *)path {
+  return [[self alloc] initWithAggregateField:AggregateField::Average(path.internalValue)];
+}
+
+- (const AggregateField &)internalValue {
+  return _field;
+}
+
+// NSObject Methods
+- (BOOL)isEqual:(nullable id)other {
+  if (other == self) return YES;
+  if (![other isKindOfClass:[FIRAggregateField class]]) return NO;
+
+  FIRAggregateField *otherField = other;
+  return _field == otherField->_field;
+}
+
+- (NSUInteger)hash {
+  return _field.Hash();
+}
+
+- (NSString *)description {
+  return util::WrapNSString(_field.ToString());
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
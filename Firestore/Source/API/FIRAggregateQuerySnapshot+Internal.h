@@ -0,0 +1,39 @@
+/*
+ * Copyright 2017 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FIRAggregateQuerySnapshot.h"
+
+#include "Firestore/core/src/firebase/firestore/core/aggregate.h"
+
+@class FIRAggregateField;
+
+namespace core = firebase::firestore::core;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface FIRAggregateQuerySnapshot (/* Init */)
+
+/**
+ * Wraps the values of `fields`, which must be in the order the fields were passed to the
+ * `core::AggregateAccumulator` that produced `snapshot`.
+ */
+- (instancetype)initWithQuery:(FIRQuery *)query
+                       fields:(NSArray<FIRAggregateField *> *)fields
+                     snapshot:(core::AggregateSnapshot)snapshot NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
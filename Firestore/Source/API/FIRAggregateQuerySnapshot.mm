@@ -0,0 +1,81 @@
+/*
+ * Copyright 2017 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FIRAggregateQuerySnapshot.h"
+
+#include <utility>
+
+#import "Firestore/Source/API/FIRAggregateField+Internal.h"
+#import "Firestore/Source/API/FIRAggregateQuerySnapshot+Internal.h"
+#import "Firestore/Source/API/FIRSnapshotMetadata+Internal.h"
+
+#include "Firestore/core/src/firebase/firestore/api/input_validation.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+using firebase::firestore::api::ThrowInvalidArgument;
+using firebase::firestore::core::AggregateSnapshot;
+using firebase::firestore::model::FieldValue;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation FIRAggregateQuerySnapshot {
+  NSArray<FIRAggregateField *> *_fields;
+  AggregateSnapshot _snapshot;
+}
+
+- (instancetype)initWithQuery:(FIRQuery *)query
+                       fields:(NSArray<FIRAggregateField *> *)fields
+                     snapshot:(AggregateSnapshot)snapshot {
+  if (self = [super init]) {
+    HARD_ASSERT(fields.count == snapshot.values().size(),
+                "Expected a value for each of the %s aggregate fields", fields.count);
+    _query = query;
+    _fields = [fields copy];
+    _snapshot = std::move(snapshot);
+    _metadata = [[FIRSnapshotMetadata alloc] initWithPendingWrites:_snapshot.has_pending_writes()
+                                                         fromCache:_snapshot.from_cache()];
+  }
+  return self;
+}
+
+- (NSNumber *)count {
+  return @(_snapshot.count());
+}
+
+- (nullable NSNumber *)valueForAggregateField:(FIRAggregateField *)field {
+  NSUInteger index = [_fields indexOfObject:field];
+  if (index == NSNotFound) {
+    ThrowInvalidArgument("Aggregate field %s was not requested for this snapshot.",
+                         field.internalValue.ToString());
+  }
+
+  const FieldValue &value = _snapshot.values()[index];
+  switch (value.type()) {
+    case FieldValue::Type::Integer:
+      return @(value.integer_value());
+    case FieldValue::Type::Double:
+      return @(value.double_value());
+    case FieldValue::Type::Null:
+      return nil;
+    default:
+      HARD_FAIL("Unexpected aggregate value type %s", static_cast<int>(value.type()));
+  }
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -44,6 +44,7 @@
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor_callback.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "Firestore/core/src/firebase/firestore/util/trace_span.h"
 
 namespace util = firebase::firestore::util;
 using firebase::firestore::api::DocumentReference;
@@ -62,6 +63,7 @@ using firebase::firestore::model::ResourcePath;
 using firebase::firestore::util::Status;
 using firebase::firestore::util::StatusOr;
 using firebase::firestore::util::StatusOrCallback;
+using firebase::firestore::util::TraceSpan;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -157,17 +159,21 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)setData:(NSDictionary<NSString *, id> *)documentData
           merge:(BOOL)merge
      completion:(nullable void (^)(NSError *_Nullable error))completion {
+  TraceSpan parseSpan{"Parsing user data"};
   auto dataConverter = self.firestore.dataConverter;
   ParsedSetData parsed = merge ? [dataConverter parsedMergeData:documentData fieldMask:nil]
                                : [dataConverter parsedSetData:documentData];
+  parseSpan.End();
   _documentReference.SetData(std::move(parsed), util::MakeCallback(completion));
 }
 
 - (void)setData:(NSDictionary<NSString *, id> *)documentData
     mergeFields:(NSArray<id> *)mergeFields
      completion:(nullable void (^)(NSError *_Nullable error))completion {
+  TraceSpan parseSpan{"Parsing user data"};
   ParsedSetData parsed = [self.firestore.dataConverter parsedMergeData:documentData
                                                              fieldMask:mergeFields];
+  parseSpan.End();
   _documentReference.SetData(std::move(parsed), util::MakeCallback(completion));
 }
 
@@ -177,7 +183,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)updateData:(NSDictionary<id, id> *)fields
         completion:(nullable void (^)(NSError *_Nullable error))completion {
+  TraceSpan parseSpan{"Parsing user data"};
   ParsedUpdateData parsed = [self.firestore.dataConverter parsedUpdateData:fields];
+  parseSpan.End();
   _documentReference.UpdateData(std::move(parsed), util::MakeCallback(completion));
 }
 
@@ -214,11 +214,11 @@ ServerTimestampBehavior InternalServerTimestampBehavior(FIRServerTimestampBehavi
 
 - (NSDictionary<NSString *, id> *)convertedObject:(FSTObjectValue *)objectValue
                                           options:(FSTFieldValueOptions *)options {
-  NSMutableDictionary *result = [NSMutableDictionary dictionary];
-  [objectValue.internalValue
-      enumerateKeysAndObjectsUsingBlock:^(NSString *key, FSTFieldValue *value, BOOL *stop) {
-        result[key] = [self convertedValue:value options:options];
-      }];
+  const FSTObjectValueMap &fields = objectValue.internalValue;
+  NSMutableDictionary *result = [NSMutableDictionary dictionaryWithCapacity:fields.size()];
+  for (const auto &entry : fields) {
+    result[entry.first] = [self convertedValue:entry.second options:options];
+  }
   return result;
 }
 
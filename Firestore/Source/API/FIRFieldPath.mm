@@ -69,8 +69,31 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 + (instancetype)pathWithDotSeparatedString:(NSString *)path {
-  return
+  NSCache<NSString *, FIRFieldPath *> *cache = [self parsedPathCache];
+  FIRFieldPath *cached = [cache objectForKey:path];
+  if (cached) {
+    return cached;
+  }
+
+  FIRFieldPath *parsed =
       [[FIRFieldPath alloc] initPrivate:FieldPath::FromDotSeparatedString(util::MakeString(path))];
+  [cache setObject:parsed forKey:[path copy]];
+  return parsed;
+}
+
+/**
+ * Field paths parsed from dot-separated strings, by string. Queries and updates built in a loop
+ * tend to name the same few fields over and over, and since field paths are immutable the parsed
+ * (and validated) result can be shared. Only valid paths are cached, so invalid ones keep throwing.
+ */
++ (NSCache<NSString *, FIRFieldPath *> *)parsedPathCache {
+  static NSCache<NSString *, FIRFieldPath *> *cache = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    cache = [[NSCache alloc] init];
+    cache.countLimit = 1000;
+  });
+  return cache;
 }
 
 /** Matches any characters in a field path string that are reserved. */
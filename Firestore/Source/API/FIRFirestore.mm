@@ -29,6 +29,7 @@
 
 #import "Firestore/Source/API/FIRDocumentReference+Internal.h"
 #import "Firestore/Source/API/FIRFirestore+Internal.h"
+#import "Firestore/Source/API/FIRRPCStatistics+Internal.h"
 #import "Firestore/Source/API/FIRTransaction+Internal.h"
 #import "Firestore/Source/API/FIRWriteBatch+Internal.h"
 #import "Firestore/Source/API/FSTFirestoreComponent.h"
@@ -39,8 +40,11 @@
 #include "Firestore/core/src/firebase/firestore/api/write_batch.h"
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/core/memory_stats.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/remote/rpc_metrics.h"
+#include "Firestore/core/src/firebase/firestore/util/allocation_counters.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
@@ -54,7 +58,10 @@ using firebase::firestore::api::Firestore;
 using firebase::firestore::api::ThrowIllegalState;
 using firebase::firestore::api::ThrowInvalidArgument;
 using firebase::firestore::auth::CredentialsProvider;
+using firebase::firestore::core::MemoryStats;
 using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::DocumentKeySet;
+using firebase::firestore::remote::RpcStatsMap;
 using firebase::firestore::util::AsyncQueue;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -184,6 +191,21 @@ NS_ASSUME_NONNULL_BEGIN
   return _firestore->GetCollectionGroup(collectionID);
 }
 
+- (FIRQuery *)queryForDocuments:(NSArray<FIRDocumentReference *> *)documents {
+  if (documents.count == 0) {
+    ThrowInvalidArgument("Invalid query. At least one document must be given.");
+  }
+
+  DocumentKeySet keys;
+  for (FIRDocumentReference *document in documents) {
+    if (document.firestore != self) {
+      ThrowInvalidArgument("Provided document reference is from a different Firestore instance.");
+    }
+    keys = keys.insert(document.key);
+  }
+  return _firestore->GetDocumentsQuery(std::move(keys));
+}
+
 - (FIRWriteBatch *)batch {
   return [FIRWriteBatch writeBatchWithDataConverter:self.dataConverter
                                          writeBatch:_firestore->GetBatch()];
@@ -265,6 +287,66 @@ NS_ASSUME_NONNULL_BEGIN
   _firestore->DisableNetwork(util::MakeCallback(completion));
 }
 
+- (void)warmUpConnection {
+  _firestore->WarmUpConnection();
+}
+
+- (void)getNetworkStatisticsWithCompletion:
+    (void (^)(NSDictionary<NSString *, FIRRPCStatistics *> *statistics))completion {
+  if (!completion) {
+    ThrowInvalidArgument("Completion block must not be nil.");
+  }
+  _firestore->GetRpcStats([completion](RpcStatsMap stats) {
+    NSMutableDictionary<NSString *, FIRRPCStatistics *> *result = [NSMutableDictionary dictionary];
+    for (const auto &kv : stats) {
+      result[util::WrapNSString(kv.first)] = [[FIRRPCStatistics alloc] initWithStats:kv.second];
+    }
+    completion(result);
+  });
+}
+
+- (void)getMemoryStatisticsWithCompletion:
+    (void (^)(NSDictionary<NSString *, NSNumber *> *statistics))completion {
+  if (!completion) {
+    ThrowInvalidArgument("Completion block must not be nil.");
+  }
+  _firestore->GetMemoryStats([completion](MemoryStats stats) {
+    NSMutableDictionary<NSString *, NSNumber *> *statistics = [@{
+      @"views" : @(stats.view_bytes),
+      @"localViewOverlay" : @(stats.local_view_overlay_bytes),
+      @"remoteDocumentCache" : @(stats.memory_remote_document_cache_bytes),
+      @"projectedDocuments" : @(stats.projected_document_bytes),
+      @"pendingWatchChanges" : @(stats.pending_watch_change_bytes),
+      @"streamBuffers" : @(stats.stream_buffered_bytes),
+      @"leveldbBlockCache" : @(stats.leveldb_block_cache_bytes),
+      @"leveldbMemtables" : @(stats.leveldb_memtable_bytes),
+      @"total" : @(stats.total_bytes()),
+    } mutableCopy];
+    if (util::kAllocationCountingEnabled) {
+      for (int i = 0; i < util::kAllocationSubsystemCount; ++i) {
+        auto subsystem = static_cast<util::AllocationSubsystem>(i);
+        util::AllocationCounts counts = util::GetAllocationCounts(subsystem);
+        NSString *name = util::WrapNSString(util::AllocationSubsystemName(subsystem));
+        statistics[[@"allocations." stringByAppendingString:name]] = @(counts.allocations);
+        statistics[[@"allocatedBytes." stringByAppendingString:name]] = @(counts.bytes);
+      }
+    }
+    completion(statistics);
+  });
+}
+
+- (void)releaseMemoryWithCompletion:(nullable void (^)(NSError *_Nullable error))completion {
+  _firestore->ReleaseMemory(util::MakeCallback(completion));
+}
+
+- (void)loadBundle:(NSData *)bundle
+        completion:(nullable void (^)(NSError *_Nullable error))completion {
+  if (!bundle) {
+    ThrowInvalidArgument("Bundle must not be nil.");
+  }
+  _firestore->LoadBundle(bundle, util::MakeCallback(completion));
+}
+
 @end
 
 @implementation FIRFirestore (Internal)
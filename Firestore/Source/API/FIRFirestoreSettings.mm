@@ -27,8 +27,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 namespace api = firebase::firestore::api;
 namespace util = firebase::firestore::util;
+using api::PersistenceSettings;
 using api::Settings;
 using api::ThrowInvalidArgument;
+using firebase::firestore::core::MessageCompression;
 
 // Public constant
 ABSL_CONST_INIT extern "C" const int64_t kFIRFirestoreCacheSizeUnlimited =
@@ -44,6 +46,28 @@ ABSL_CONST_INIT extern "C" const int64_t kFIRFirestoreCacheSizeUnlimited =
     _persistenceEnabled = Settings::DefaultPersistenceEnabled;
     _timestampsInSnapshotsEnabled = Settings::DefaultTimestampsInSnapshotsEnabled;
     _cacheSizeBytes = Settings::DefaultCacheSizeBytes;
+    _memoryCacheSizeBytes = Settings::CacheSizeUnlimited;
+    _persistenceBlockCacheSizeBytes = PersistenceSettings::DefaultBlockCacheSizeBytes;
+    _persistenceWriteBufferSizeBytes = PersistenceSettings::DefaultWriteBufferSizeBytes;
+    _persistenceCompressionEnabled = PersistenceSettings::DefaultCompressionEnabled;
+    _persistenceBloomFilterBitsPerKey = PersistenceSettings::DefaultBloomFilterBitsPerKey;
+    _persistenceChecksumVerificationEnabled = PersistenceSettings::DefaultVerifyChecksums;
+    _persistenceNativeSerializationEnabled =
+        PersistenceSettings::DefaultNativeSerializationEnabled;
+    _persistenceRemoteDocumentBatchSize = PersistenceSettings::DefaultRemoteDocumentBatchSize;
+    _persistenceBackgroundMigrationsEnabled =
+        PersistenceSettings::DefaultBackgroundMigrationsEnabled;
+    _persistenceWarmSnapshotTargetCount = PersistenceSettings::DefaultWarmSnapshotTargetCount;
+    _persistenceCompactTargetDocumentsEnabled =
+        PersistenceSettings::DefaultCompactTargetDocumentsEnabled;
+    _persistenceValueCompressionEnabled = PersistenceSettings::DefaultValueCompressionEnabled;
+    _persistenceSyncWritesEnabled = PersistenceSettings::DefaultSyncWrites;
+    _persistenceSyncIntervalMs = PersistenceSettings::DefaultSyncIntervalMs;
+    _persistenceGroupCommitDelayMs = PersistenceSettings::DefaultGroupCommitDelayMs;
+    _persistenceExportReadOnly = PersistenceSettings::DefaultExportReadOnly;
+    _channelCount = Settings::DefaultChannelCount;
+    _compressionEnabled = Settings::DefaultCompression != MessageCompression::None;
+    _pendingWriteCompactionEnabled = Settings::DefaultPendingWriteCompactionEnabled;
   }
   return self;
 }
@@ -62,7 +86,35 @@ ABSL_CONST_INIT extern "C" const int64_t kFIRFirestoreCacheSizeUnlimited =
          self.dispatchQueue == otherSettings.dispatchQueue &&
          self.isPersistenceEnabled == otherSettings.isPersistenceEnabled &&
          self.timestampsInSnapshotsEnabled == otherSettings.timestampsInSnapshotsEnabled &&
-         self.cacheSizeBytes == otherSettings.cacheSizeBytes;
+         self.cacheSizeBytes == otherSettings.cacheSizeBytes &&
+         self.memoryCacheSizeBytes == otherSettings.memoryCacheSizeBytes &&
+         self.persistenceBlockCacheSizeBytes == otherSettings.persistenceBlockCacheSizeBytes &&
+         self.persistenceWriteBufferSizeBytes == otherSettings.persistenceWriteBufferSizeBytes &&
+         self.isPersistenceCompressionEnabled == otherSettings.isPersistenceCompressionEnabled &&
+         self.persistenceBloomFilterBitsPerKey == otherSettings.persistenceBloomFilterBitsPerKey &&
+         self.isPersistenceChecksumVerificationEnabled ==
+             otherSettings.isPersistenceChecksumVerificationEnabled &&
+         self.isPersistenceNativeSerializationEnabled ==
+             otherSettings.isPersistenceNativeSerializationEnabled &&
+         self.persistenceRemoteDocumentBatchSize ==
+             otherSettings.persistenceRemoteDocumentBatchSize &&
+         self.isPersistenceBackgroundMigrationsEnabled ==
+             otherSettings.isPersistenceBackgroundMigrationsEnabled &&
+         self.persistenceWarmSnapshotTargetCount ==
+             otherSettings.persistenceWarmSnapshotTargetCount &&
+         self.isPersistenceCompactTargetDocumentsEnabled ==
+             otherSettings.isPersistenceCompactTargetDocumentsEnabled &&
+         self.isPersistenceValueCompressionEnabled ==
+             otherSettings.isPersistenceValueCompressionEnabled &&
+         self.isPersistenceSyncWritesEnabled == otherSettings.isPersistenceSyncWritesEnabled &&
+         self.persistenceSyncIntervalMs == otherSettings.persistenceSyncIntervalMs &&
+         self.persistenceGroupCommitDelayMs == otherSettings.persistenceGroupCommitDelayMs &&
+         (self.persistenceExportDirectory == otherSettings.persistenceExportDirectory ||
+          [self.persistenceExportDirectory isEqual:otherSettings.persistenceExportDirectory]) &&
+         self.isPersistenceExportReadOnly == otherSettings.isPersistenceExportReadOnly &&
+         self.channelCount == otherSettings.channelCount &&
+         self.isCompressionEnabled == otherSettings.isCompressionEnabled &&
+         self.isPendingWriteCompactionEnabled == otherSettings.isPendingWriteCompactionEnabled;
   SUPPRESS_END()
 }
 
@@ -75,6 +127,26 @@ ABSL_CONST_INIT extern "C" const int64_t kFIRFirestoreCacheSizeUnlimited =
   result = 31 * result + (self.timestampsInSnapshotsEnabled ? 1231 : 1237);
   SUPPRESS_END()
   result = 31 * result + (NSUInteger)self.cacheSizeBytes;
+  result = 31 * result + (NSUInteger)self.memoryCacheSizeBytes;
+  result = 31 * result + (NSUInteger)self.persistenceBlockCacheSizeBytes;
+  result = 31 * result + (NSUInteger)self.persistenceWriteBufferSizeBytes;
+  result = 31 * result + (self.isPersistenceCompressionEnabled ? 1231 : 1237);
+  result = 31 * result + (NSUInteger)self.persistenceBloomFilterBitsPerKey;
+  result = 31 * result + (self.isPersistenceChecksumVerificationEnabled ? 1231 : 1237);
+  result = 31 * result + (self.isPersistenceNativeSerializationEnabled ? 1231 : 1237);
+  result = 31 * result + (NSUInteger)self.persistenceRemoteDocumentBatchSize;
+  result = 31 * result + (self.isPersistenceBackgroundMigrationsEnabled ? 1231 : 1237);
+  result = 31 * result + (NSUInteger)self.persistenceWarmSnapshotTargetCount;
+  result = 31 * result + (self.isPersistenceCompactTargetDocumentsEnabled ? 1231 : 1237);
+  result = 31 * result + (self.isPersistenceValueCompressionEnabled ? 1231 : 1237);
+  result = 31 * result + (self.isPersistenceSyncWritesEnabled ? 1231 : 1237);
+  result = 31 * result + (NSUInteger)self.persistenceSyncIntervalMs;
+  result = 31 * result + (NSUInteger)self.persistenceGroupCommitDelayMs;
+  result = 31 * result + [self.persistenceExportDirectory hash];
+  result = 31 * result + (self.isPersistenceExportReadOnly ? 1231 : 1237);
+  result = 31 * result + (NSUInteger)self.channelCount;
+  result = 31 * result + (self.isCompressionEnabled ? 1231 : 1237);
+  result = 31 * result + (self.isPendingWriteCompactionEnabled ? 1231 : 1237);
   return result;
 }
 
@@ -88,6 +160,26 @@ ABSL_CONST_INIT extern "C" const int64_t kFIRFirestoreCacheSizeUnlimited =
   copy.timestampsInSnapshotsEnabled = _timestampsInSnapshotsEnabled;
   SUPPRESS_END()
   copy.cacheSizeBytes = _cacheSizeBytes;
+  copy.memoryCacheSizeBytes = _memoryCacheSizeBytes;
+  copy.persistenceBlockCacheSizeBytes = _persistenceBlockCacheSizeBytes;
+  copy.persistenceWriteBufferSizeBytes = _persistenceWriteBufferSizeBytes;
+  copy.persistenceCompressionEnabled = _persistenceCompressionEnabled;
+  copy.persistenceBloomFilterBitsPerKey = _persistenceBloomFilterBitsPerKey;
+  copy.persistenceChecksumVerificationEnabled = _persistenceChecksumVerificationEnabled;
+  copy.persistenceNativeSerializationEnabled = _persistenceNativeSerializationEnabled;
+  copy.persistenceRemoteDocumentBatchSize = _persistenceRemoteDocumentBatchSize;
+  copy.persistenceBackgroundMigrationsEnabled = _persistenceBackgroundMigrationsEnabled;
+  copy.persistenceWarmSnapshotTargetCount = _persistenceWarmSnapshotTargetCount;
+  copy.persistenceCompactTargetDocumentsEnabled = _persistenceCompactTargetDocumentsEnabled;
+  copy.persistenceValueCompressionEnabled = _persistenceValueCompressionEnabled;
+  copy.persistenceSyncWritesEnabled = _persistenceSyncWritesEnabled;
+  copy.persistenceSyncIntervalMs = _persistenceSyncIntervalMs;
+  copy.persistenceGroupCommitDelayMs = _persistenceGroupCommitDelayMs;
+  copy.persistenceExportDirectory = _persistenceExportDirectory;
+  copy.persistenceExportReadOnly = _persistenceExportReadOnly;
+  copy.channelCount = _channelCount;
+  copy.compressionEnabled = _compressionEnabled;
+  copy.pendingWriteCompactionEnabled = _pendingWriteCompactionEnabled;
   return copy;
 }
 
@@ -119,6 +211,71 @@ ABSL_CONST_INIT extern "C" const int64_t kFIRFirestoreCacheSizeUnlimited =
   _cacheSizeBytes = cacheSizeBytes;
 }
 
+- (void)setMemoryCacheSizeBytes:(int64_t)memoryCacheSizeBytes {
+  if (memoryCacheSizeBytes != kFIRFirestoreCacheSizeUnlimited &&
+      memoryCacheSizeBytes < Settings::MinimumCacheSizeBytes) {
+    ThrowInvalidArgument("Memory cache size must be set to at least %s bytes",
+                         Settings::MinimumCacheSizeBytes);
+  }
+  _memoryCacheSizeBytes = memoryCacheSizeBytes;
+}
+
+- (void)setPersistenceBlockCacheSizeBytes:(int64_t)persistenceBlockCacheSizeBytes {
+  if (persistenceBlockCacheSizeBytes < 0) {
+    ThrowInvalidArgument("Persistence block cache size may not be negative");
+  }
+  _persistenceBlockCacheSizeBytes = persistenceBlockCacheSizeBytes;
+}
+
+- (void)setPersistenceWriteBufferSizeBytes:(int64_t)persistenceWriteBufferSizeBytes {
+  if (persistenceWriteBufferSizeBytes <= 0) {
+    ThrowInvalidArgument("Persistence write buffer size must be positive");
+  }
+  _persistenceWriteBufferSizeBytes = persistenceWriteBufferSizeBytes;
+}
+
+- (void)setPersistenceBloomFilterBitsPerKey:(int)persistenceBloomFilterBitsPerKey {
+  if (persistenceBloomFilterBitsPerKey < 0) {
+    ThrowInvalidArgument("Persistence bloom filter bits per key may not be negative");
+  }
+  _persistenceBloomFilterBitsPerKey = persistenceBloomFilterBitsPerKey;
+}
+
+- (void)setPersistenceRemoteDocumentBatchSize:(int)persistenceRemoteDocumentBatchSize {
+  if (persistenceRemoteDocumentBatchSize < 0) {
+    ThrowInvalidArgument("Persistence remote document batch size may not be negative");
+  }
+  _persistenceRemoteDocumentBatchSize = persistenceRemoteDocumentBatchSize;
+}
+
+- (void)setPersistenceWarmSnapshotTargetCount:(int)persistenceWarmSnapshotTargetCount {
+  if (persistenceWarmSnapshotTargetCount < 0) {
+    ThrowInvalidArgument("Persistence warm snapshot target count may not be negative");
+  }
+  _persistenceWarmSnapshotTargetCount = persistenceWarmSnapshotTargetCount;
+}
+
+- (void)setPersistenceSyncIntervalMs:(int)persistenceSyncIntervalMs {
+  if (persistenceSyncIntervalMs < 0) {
+    ThrowInvalidArgument("Persistence sync interval may not be negative");
+  }
+  _persistenceSyncIntervalMs = persistenceSyncIntervalMs;
+}
+
+- (void)setPersistenceGroupCommitDelayMs:(int)persistenceGroupCommitDelayMs {
+  if (persistenceGroupCommitDelayMs < 0) {
+    ThrowInvalidArgument("Persistence group commit delay may not be negative");
+  }
+  _persistenceGroupCommitDelayMs = persistenceGroupCommitDelayMs;
+}
+
+- (void)setChannelCount:(int)channelCount {
+  if (channelCount < 1) {
+    ThrowInvalidArgument("Channel count must be at least 1");
+  }
+  _channelCount = channelCount;
+}
+
 - (api::Settings)internalSettings {
   api::Settings settings;
   settings.set_host(util::MakeString(_host));
@@ -126,6 +283,32 @@ ABSL_CONST_INIT extern "C" const int64_t kFIRFirestoreCacheSizeUnlimited =
   settings.set_persistence_enabled(_persistenceEnabled);
   settings.set_timestamps_in_snapshots_enabled(_timestampsInSnapshotsEnabled);
   settings.set_cache_size_bytes(_cacheSizeBytes);
+  settings.set_memory_cache_size_bytes(_memoryCacheSizeBytes);
+  settings.set_channel_count(_channelCount);
+  settings.set_compression(_compressionEnabled ? MessageCompression::Gzip
+                                               : MessageCompression::None);
+  settings.set_pending_write_compaction_enabled(_pendingWriteCompactionEnabled);
+
+  PersistenceSettings persistenceSettings;
+  persistenceSettings.block_cache_size_bytes = _persistenceBlockCacheSizeBytes;
+  persistenceSettings.write_buffer_size_bytes = _persistenceWriteBufferSizeBytes;
+  persistenceSettings.compression_enabled = _persistenceCompressionEnabled;
+  persistenceSettings.bloom_filter_bits_per_key = _persistenceBloomFilterBitsPerKey;
+  persistenceSettings.verify_checksums = _persistenceChecksumVerificationEnabled;
+  persistenceSettings.native_serialization_enabled = _persistenceNativeSerializationEnabled;
+  persistenceSettings.remote_document_batch_size = _persistenceRemoteDocumentBatchSize;
+  persistenceSettings.background_migrations_enabled = _persistenceBackgroundMigrationsEnabled;
+  persistenceSettings.warm_snapshot_target_count = _persistenceWarmSnapshotTargetCount;
+  persistenceSettings.compact_target_documents_enabled = _persistenceCompactTargetDocumentsEnabled;
+  persistenceSettings.value_compression_enabled = _persistenceValueCompressionEnabled;
+  persistenceSettings.sync_writes = _persistenceSyncWritesEnabled;
+  persistenceSettings.sync_interval_ms = _persistenceSyncIntervalMs;
+  persistenceSettings.group_commit_delay_ms = _persistenceGroupCommitDelayMs;
+  if (_persistenceExportDirectory) {
+    persistenceSettings.export_directory = util::MakeString(_persistenceExportDirectory);
+  }
+  persistenceSettings.export_read_only = _persistenceExportReadOnly;
+  settings.set_persistence_settings(persistenceSettings);
   return settings;
 }
 
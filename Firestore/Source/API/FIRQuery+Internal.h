@@ -26,6 +26,16 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(nonatomic, strong, readonly) FSTQuery *query;
 
+/**
+ * Runs this query against the local cache and reports how it was executed, in the manner of a
+ * database's EXPLAIN output. The statistics are keyed by `accessPath` (a string),
+ * `documentsScanned`, `documentsDecoded`, `mutationBatchesRead`, `documentsOverlaid`,
+ * `overlaysReused`, `documentsReturned`, `remoteDocumentsMicros`, `mutationsMicros` and
+ * `totalMicros`. Meant for debugging the performance of queries served from the cache.
+ */
+- (void)explainLocalExecutionWithCompletion:
+    (void (^)(NSDictionary<NSString *, id> *stats))completion;
+
 @end
 
 NS_ASSUME_NONNULL_END
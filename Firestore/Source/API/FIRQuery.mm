@@ -18,9 +18,12 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #import "FIRDocumentReference.h"
 #import "FIRFirestoreErrors.h"
+#import "Firestore/Source/API/FIRAggregateField+Internal.h"
+#import "Firestore/Source/API/FIRAggregateQuerySnapshot+Internal.h"
 #import "Firestore/Source/API/FIRDocumentReference+Internal.h"
 #import "Firestore/Source/API/FIRDocumentSnapshot+Internal.h"
 #import "Firestore/Source/API/FIRFieldPath+Internal.h"
@@ -40,7 +43,9 @@
 #import "Firestore/Source/Model/FSTFieldValue.h"
 
 #include "Firestore/core/src/firebase/firestore/api/input_validation.h"
+#include "Firestore/core/src/firebase/firestore/core/aggregate.h"
 #include "Firestore/core/src/firebase/firestore/core/filter.h"
+#include "Firestore/core/src/firebase/firestore/local/query_execution_stats.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
@@ -56,12 +61,16 @@ using firebase::firestore::api::ListenerRegistration;
 using firebase::firestore::api::SnapshotMetadata;
 using firebase::firestore::api::Source;
 using firebase::firestore::api::ThrowInvalidArgument;
+using firebase::firestore::core::AggregateAccumulator;
+using firebase::firestore::core::AggregateField;
+using firebase::firestore::core::AggregateSnapshot;
 using firebase::firestore::core::AsyncEventListener;
 using firebase::firestore::core::EventListener;
 using firebase::firestore::core::Filter;
 using firebase::firestore::core::ListenOptions;
 using firebase::firestore::core::QueryListener;
 using firebase::firestore::core::ViewSnapshot;
+using firebase::firestore::local::QueryExecutionStats;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::FieldValue;
@@ -79,6 +88,29 @@ NS_ASSUME_NONNULL_BEGIN
 + (instancetype)referenceWithQuery:(FSTQuery *)query firestore:(FIRFirestore *)firestore {
   return [[FIRQuery alloc] initWithQuery:query firestore:firestore];
 }
+
+- (void)explainLocalExecutionWithCompletion:
+    (void (^)(NSDictionary<NSString *, id> *stats))completion {
+  [self.firestore.wrapped->client()
+      explainLocalExecutionOfQuery:self.query
+                          callback:[completion](QueryExecutionStats stats) {
+                            if (!completion) {
+                              return;
+                            }
+                            completion(@{
+                              @"accessPath" : @(ToString(stats.access_path)),
+                              @"documentsScanned" : @(stats.documents_scanned),
+                              @"documentsDecoded" : @(stats.documents_decoded),
+                              @"mutationBatchesRead" : @(stats.mutation_batches_read),
+                              @"documentsOverlaid" : @(stats.documents_overlaid),
+                              @"overlaysReused" : @(stats.overlays_reused),
+                              @"documentsReturned" : @(stats.documents_returned),
+                              @"remoteDocumentsMicros" : @(stats.remote_documents_time.count()),
+                              @"mutationsMicros" : @(stats.mutations_time.count()),
+                              @"totalMicros" : @(stats.total_time.count()),
+                            });
+                          }];
+}
 @end
 
 @implementation FIRQuery
@@ -204,18 +236,93 @@ NS_ASSUME_NONNULL_BEGIN
                  nil);
       });
 
+  return [self addViewSnapshotListenerWithOptions:internalOptions
+                                         listener:std::move(view_listener)];
+}
+
+- (id<FIRListenerRegistration>)
+    addViewSnapshotListenerWithOptions:(ListenOptions)options
+                              listener:(std::unique_ptr<EventListener<ViewSnapshot>>)viewListener {
+  std::shared_ptr<Firestore> firestore = self.firestore.wrapped;
+
   // Call the view_listener on the user Executor.
   auto async_listener = AsyncEventListener<ViewSnapshot>::Create(firestore->client().userExecutor,
-                                                                 std::move(view_listener));
+                                                                 std::move(viewListener));
 
   std::shared_ptr<QueryListener> query_listener =
-      [firestore->client() listenToQuery:query options:internalOptions listener:async_listener];
+      [firestore->client() listenToQuery:self.query options:options listener:async_listener];
 
   return [[FSTListenerRegistration alloc]
       initWithRegistration:ListenerRegistration(firestore->client(), std::move(async_listener),
                                                 std::move(query_listener))];
 }
 
+- (void)getAggregateFromCacheForFields:(NSArray<FIRAggregateField *> *)fields
+                            completion:(FIRAggregateQuerySnapshotBlock)completion {
+  std::vector<AggregateField> internalFields = [self internalAggregateFields:fields];
+  NSArray<FIRAggregateField *> *requestedFields = [fields copy];
+  FIRQuery *query = self;
+  [self.firestore.wrapped->client()
+      getAggregateFromLocalCache:self.query
+                          fields:std::move(internalFields)
+                        callback:[query, requestedFields, completion](AggregateSnapshot snapshot) {
+                          if (!completion) {
+                            return;
+                          }
+                          completion([[FIRAggregateQuerySnapshot alloc]
+                                         initWithQuery:query
+                                                fields:requestedFields
+                                              snapshot:std::move(snapshot)],
+                                     nil);
+                        }];
+}
+
+- (id<FIRListenerRegistration>)addAggregateListenerForFields:(NSArray<FIRAggregateField *> *)fields
+                                                    listener:
+                                                        (FIRAggregateQuerySnapshotBlock)listener {
+  auto accumulator = std::make_shared<AggregateAccumulator>([self internalAggregateFields:fields]);
+  NSArray<FIRAggregateField *> *requestedFields = [fields copy];
+  FIRQuery *query = self;
+
+  // Fold each ViewSnapshot into the aggregates, so that only their values are handed to the
+  // listener. Events arrive one at a time on the user Executor, so the accumulator needs no lock.
+  auto view_listener = EventListener<ViewSnapshot>::Create(
+      [listener, accumulator, query, requestedFields](StatusOr<ViewSnapshot> maybe_snapshot) {
+        if (!maybe_snapshot.status().ok()) {
+          listener(nil, MakeNSError(maybe_snapshot.status()));
+          return;
+        }
+
+        const ViewSnapshot &snapshot = maybe_snapshot.ValueOrDie();
+        accumulator->Apply(snapshot);
+        listener([[FIRAggregateQuerySnapshot alloc]
+                     initWithQuery:query
+                            fields:requestedFields
+                          snapshot:accumulator->ToSnapshot(snapshot.from_cache(),
+                                                           snapshot.has_pending_writes())],
+                 nil);
+      });
+
+  return [self addViewSnapshotListenerWithOptions:ListenOptions::DefaultOptions()
+                                         listener:std::move(view_listener)];
+}
+
+- (std::vector<AggregateField>)internalAggregateFields:(NSArray<FIRAggregateField *> *)fields {
+  if (fields.count == 0) {
+    ThrowInvalidArgument("Invalid aggregation. At least one aggregate field must be given.");
+  }
+  std::vector<AggregateField> result;
+  result.reserve(fields.count);
+  for (id field in fields) {
+    if (![field isKindOfClass:[FIRAggregateField class]]) {
+      ThrowInvalidArgument("Invalid aggregation. Aggregate fields must be given as "
+                           "FIRAggregateField.");
+    }
+    result.push_back(((FIRAggregateField *)field).internalValue);
+  }
+  return result;
+}
+
 - (FIRQuery *)queryWhereField:(NSString *)field isEqualTo:(id)value {
   return [self queryWithFilterOperator:Filter::Operator::Equal field:field value:value];
 }
@@ -376,6 +483,7 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (FIRQuery *)queryOrderedByFieldPath:(FIRFieldPath *)fieldPath descending:(BOOL)descending {
+  [self validateCanRefine];
   [self validateNewOrderByPath:fieldPath.internalValue];
   if (self.query.startAt) {
     ThrowInvalidArgument(
@@ -392,6 +500,7 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (FIRQuery *)queryLimitedTo:(NSInteger)limit {
+  [self validateCanRefine];
   if (limit <= 0) {
     ThrowInvalidArgument("Invalid Query. Query limit (%s) is invalid. Limit must be positive.",
                          limit);
@@ -399,6 +508,28 @@ NS_ASSUME_NONNULL_BEGIN
   return [FIRQuery referenceWithQuery:[self.query queryBySettingLimit:limit] firestore:_firestore];
 }
 
+- (FIRQuery *)queryBySelectingFields:(NSArray<id> *)fields {
+  [self validateCanRefine];
+  if (fields.count == 0) {
+    ThrowInvalidArgument("Invalid Query. At least one field must be selected.");
+  }
+  std::vector<FieldPath> projection;
+  projection.reserve(fields.count);
+  for (id field in fields) {
+    if ([field isKindOfClass:[NSString class]]) {
+      projection.push_back(
+          [FIRFieldPath pathWithDotSeparatedString:(NSString *)field].internalValue);
+    } else if ([field isKindOfClass:[FIRFieldPath class]]) {
+      projection.push_back(((FIRFieldPath *)field).internalValue);
+    } else {
+      ThrowInvalidArgument("Invalid Query. Selected fields must be given as NSString or "
+                           "FIRFieldPath.");
+    }
+  }
+  return [FIRQuery referenceWithQuery:[self.query queryBySettingProjection:std::move(projection)]
+                            firestore:self.firestore];
+}
+
 - (FIRQuery *)queryStartingAtDocument:(FIRDocumentSnapshot *)snapshot {
   FSTBound *bound = [self boundFromSnapshot:snapshot isBefore:YES];
   return [FIRQuery referenceWithQuery:[self.query queryByAddingStartAt:bound]
@@ -461,6 +592,7 @@ NS_ASSUME_NONNULL_BEGIN
 - (FIRQuery *)queryWithFilterOperator:(Filter::Operator)filterOperator
                                  path:(const FieldPath &)fieldPath
                                 value:(id)value {
+  [self validateCanRefine];
   FSTFieldValue *fieldValue;
   if (fieldPath.IsKeyFieldPath()) {
     if (filterOperator == Filter::Operator::ArrayContains) {
@@ -514,6 +646,14 @@ NS_ASSUME_NONNULL_BEGIN
                             firestore:self.firestore];
 }
 
+/** Throws if the query is over a fixed set of documents and so cannot be refined. */
+- (void)validateCanRefine {
+  if ([self.query isDocumentKeysQuery]) {
+    ThrowInvalidArgument("Invalid query. A query for a set of documents cannot be filtered, "
+                         "ordered, limited or projected.");
+  }
+}
+
 - (void)validateNewRelationFilter:(FSTRelationFilter *)filter {
   if ([filter isInequality]) {
     const FieldPath *existingField = [self.query inequalityFilterField];
@@ -569,6 +709,7 @@ NS_ASSUME_NONNULL_BEGIN
  * timestamp.
  */
 - (FSTBound *)boundFromSnapshot:(FIRDocumentSnapshot *)snapshot isBefore:(BOOL)isBefore {
+  [self validateCanRefine];
   if (![snapshot exists]) {
     ThrowInvalidArgument("Invalid query. You are trying to start or end a query using a document "
                          "that doesn't exist.");
@@ -610,6 +751,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 /** Converts a list of field values to an FSTBound. */
 - (FSTBound *)boundFromFieldValues:(NSArray<id> *)fieldValues isBefore:(BOOL)isBefore {
+  [self validateCanRefine];
   // Use explicit sort order because it has to match the query the user made
   NSArray<FSTSortOrder *> *explicitSortOrders = self.query.explicitSortOrders;
   if (fieldValues.count > explicitSortOrders.count) {
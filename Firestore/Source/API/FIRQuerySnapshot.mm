@@ -33,8 +33,9 @@
 #include "Firestore/core/src/firebase/firestore/util/delayed_constructor.h"
 
 using firebase::firestore::api::DocumentChange;
-using firebase::firestore::api::DocumentSnapshot;
+using firebase::firestore::api::DocumentChangeView;
 using firebase::firestore::api::Firestore;
+using firebase::firestore::api::QueryDocumentView;
 using firebase::firestore::api::QuerySnapshot;
 using firebase::firestore::api::SnapshotMetadata;
 using firebase::firestore::api::ThrowInvalidArgument;
@@ -110,16 +111,33 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (NSArray<FIRQueryDocumentSnapshot *> *)documents {
   if (!_documents) {
-    NSMutableArray<FIRQueryDocumentSnapshot *> *result = [NSMutableArray array];
-    _snapshot->ForEachDocument([&result](DocumentSnapshot snapshot) {
-      [result addObject:[[FIRQueryDocumentSnapshot alloc] initWithSnapshot:std::move(snapshot)]];
-    });
+    NSMutableArray<FIRQueryDocumentSnapshot *> *result =
+        [NSMutableArray arrayWithCapacity:_snapshot->size()];
+    for (const QueryDocumentView &document : _snapshot->documents()) {
+      [result addObject:[[FIRQueryDocumentSnapshot alloc] initWithSnapshot:document.ToSnapshot()]];
+    }
 
     _documents = result;
   }
   return _documents;
 }
 
+- (void)enumerateDocumentsUsingBlock:
+    (void (^)(FIRQueryDocumentSnapshot *document, NSUInteger idx, BOOL *stop))block {
+  if (_documents) {
+    [_documents enumerateObjectsUsingBlock:block];
+    return;
+  }
+
+  BOOL stop = NO;
+  NSUInteger index = 0;
+  for (const QueryDocumentView &document : _snapshot->documents()) {
+    block([[FIRQueryDocumentSnapshot alloc] initWithSnapshot:document.ToSnapshot()], index++,
+          &stop);
+    if (stop) break;
+  }
+}
+
 - (NSArray<FIRDocumentChange *> *)documentChanges {
   return [self documentChangesWithIncludeMetadataChanges:NO];
 }
@@ -140,6 +158,29 @@ NS_ASSUME_NONNULL_BEGIN
   return _documentChanges;
 }
 
+- (void)enumerateDocumentChangesWithIncludeMetadataChanges:(BOOL)includeMetadataChanges
+                                                usingBlock:(void (^)(FIRDocumentChange *change,
+                                                                     BOOL *stop))block {
+  if (_documentChanges && _documentChangesIncludeMetadataChanges == includeMetadataChanges) {
+    [_documentChanges
+        enumerateObjectsUsingBlock:^(FIRDocumentChange *change, NSUInteger idx, BOOL *stop) {
+          block(change, stop);
+        }];
+    return;
+  }
+
+  // The index of each change depends on the changes before it, so the remaining changes are
+  // still visited after the block stops the enumeration, just without creating wrappers for them.
+  BOOL stop = NO;
+  _snapshot->ForEachChangeView(static_cast<bool>(includeMetadataChanges),
+                               [&stop, block](const DocumentChangeView &change) {
+                                 if (stop) return;
+                                 block([[FIRDocumentChange alloc]
+                                           initWithDocumentChange:change.ToChange()],
+                                       &stop);
+                               });
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
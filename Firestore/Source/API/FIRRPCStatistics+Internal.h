@@ -0,0 +1,33 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FIRRPCStatistics.h"
+
+#import <Foundation/Foundation.h>
+
+#include "Firestore/core/src/firebase/firestore/remote/rpc_metrics.h"
+
+namespace remote = firebase::firestore::remote;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface FIRRPCStatistics (/* Init */)
+
+- (instancetype)initWithStats:(const remote::RpcStats &)stats NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
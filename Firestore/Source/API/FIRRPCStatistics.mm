@@ -0,0 +1,71 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FIRRPCStatistics.h"
+
+#include <cstdint>
+#include <vector>
+
+#import "Firestore/Source/API/FIRRPCStatistics+Internal.h"
+
+#include "Firestore/core/src/firebase/firestore/remote/rpc_metrics.h"
+#include "Firestore/core/src/firebase/firestore/util/latency_histogram.h"
+
+using firebase::firestore::remote::RpcStats;
+using firebase::firestore::util::LatencyHistogram;
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace {
+
+NSArray<NSNumber *> *ToNumbers(const std::vector<int64_t> &values) {
+  NSMutableArray<NSNumber *> *result = [NSMutableArray arrayWithCapacity:values.size()];
+  for (int64_t value : values) {
+    [result addObject:@(value)];
+  }
+  return result;
+}
+
+}  // namespace
+
+@implementation FIRRPCStatistics
+
+- (instancetype)initWithStats:(const RpcStats &)stats {
+  if (self = [super init]) {
+    _messagesSent = stats.messages_sent;
+    _messagesReceived = stats.messages_received;
+    _bytesSent = stats.bytes_sent;
+    _bytesReceived = stats.bytes_received;
+    _startCount = stats.starts;
+    _backoffCount = stats.backoffs;
+    _totalBackoffDuration = stats.total_backoff.count() / 1000.0;
+    _latencyCount = stats.latency.count();
+    _latencyBucketUpperBounds = ToNumbers(LatencyHistogram::BucketUpperBoundsMs());
+    _latencyBucketCounts = ToNumbers(stats.latency.bucket_counts());
+  }
+  return self;
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<FIRRPCStatistics: sent=%lld/%lldB received=%lld/%lldB "
+                                    @"starts=%lld backoffs=%lld latencies=%lld>",
+                                    _messagesSent, _bytesSent, _messagesReceived, _bytesReceived,
+                                    _startCount, _backoffCount, _latencyCount];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -21,6 +21,7 @@
 #include "Firestore/core/src/firebase/firestore/core/query_listener.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 
 @class FSTQuery;
@@ -28,6 +29,7 @@
 
 namespace core = firebase::firestore::core;
 namespace model = firebase::firestore::model;
+namespace util = firebase::firestore::util;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -41,6 +43,14 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (instancetype)eventManagerWithSyncEngine:(FSTSyncEngine *)syncEngine;
 
+/**
+ * Creates an event manager that raises the events of listeners that coalesce snapshots after their
+ * coalescing window, on the given worker queue. Without a worker queue, such listeners raise their
+ * events at the end of each batch of view snapshots.
+ */
++ (instancetype)eventManagerWithSyncEngine:(FSTSyncEngine *)syncEngine
+                               workerQueue:(nullable util::AsyncQueue *)workerQueue;
+
 - (instancetype)init NS_UNAVAILABLE;
 
 - (model::TargetId)addListener:(std::shared_ptr<core::QueryListener>)listener;
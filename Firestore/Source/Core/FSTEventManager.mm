@@ -16,6 +16,7 @@
 
 #import "Firestore/Source/Core/FSTEventManager.h"
 
+#include <algorithm>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -23,6 +24,7 @@
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Core/FSTSyncEngine.h"
 
+#include "Firestore/core/src/firebase/firestore/core/event_batch.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/objc/objc_compatibility.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
@@ -35,10 +37,13 @@ NS_ASSUME_NONNULL_BEGIN
 
 namespace objc = firebase::firestore::objc;
 using firebase::firestore::core::DocumentViewChange;
+using firebase::firestore::core::EventBatch;
 using firebase::firestore::core::QueryListener;
 using firebase::firestore::core::ViewSnapshot;
 using firebase::firestore::model::OnlineState;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::util::AsyncQueue;
+using firebase::firestore::util::DelayedOperation;
 using firebase::firestore::util::MakeStatus;
 using firebase::firestore::util::Status;
 
@@ -81,7 +86,8 @@ struct QueryListenersInfo {
 
 @interface FSTEventManager () <FSTSyncEngineDelegate>
 
-- (instancetype)initWithSyncEngine:(FSTSyncEngine *)syncEngine NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithSyncEngine:(FSTSyncEngine *)syncEngine
+                       workerQueue:(nullable AsyncQueue *)workerQueue NS_DESIGNATED_INITIALIZER;
 
 @property(nonatomic, strong, readonly) FSTSyncEngine *syncEngine;
 @property(nonatomic, assign) OnlineState onlineState;
@@ -90,15 +96,27 @@ struct QueryListenersInfo {
 
 @implementation FSTEventManager {
   objc::unordered_map<FSTQuery *, QueryListenersInfo> _queries;
+
+  AsyncQueue *_Nullable _workerQueue;
+
+  /** Raises the events held by listeners that coalesce snapshots, while any of them holds one. */
+  DelayedOperation _coalescedSnapshotsFlush;
 }
 
 + (instancetype)eventManagerWithSyncEngine:(FSTSyncEngine *)syncEngine {
-  return [[FSTEventManager alloc] initWithSyncEngine:syncEngine];
+  return [[FSTEventManager alloc] initWithSyncEngine:syncEngine workerQueue:nullptr];
+}
+
++ (instancetype)eventManagerWithSyncEngine:(FSTSyncEngine *)syncEngine
+                               workerQueue:(nullable AsyncQueue *)workerQueue {
+  return [[FSTEventManager alloc] initWithSyncEngine:syncEngine workerQueue:workerQueue];
 }
 
-- (instancetype)initWithSyncEngine:(FSTSyncEngine *)syncEngine {
+- (instancetype)initWithSyncEngine:(FSTSyncEngine *)syncEngine
+                       workerQueue:(nullable AsyncQueue *)workerQueue {
   if (self = [super init]) {
     _syncEngine = syncEngine;
+    _workerQueue = workerQueue;
     _syncEngine.syncEngineDelegate = self;
   }
   return self;
@@ -143,6 +161,8 @@ struct QueryListenersInfo {
 }
 
 - (void)handleViewSnapshots:(std::vector<ViewSnapshot> &&)viewSnapshots {
+  // Listeners updated together raise their events in a single operation on each user executor.
+  EventBatch batch;
   for (ViewSnapshot &viewSnapshot : viewSnapshots) {
     FSTQuery *query = viewSnapshot.query();
     auto found_iter = _queries.find(query);
@@ -154,6 +174,52 @@ struct QueryListenersInfo {
       query_info.set_view_snapshot(std::move(viewSnapshot));
     }
   }
+
+  [self scheduleCoalescedSnapshotsFlush];
+}
+
+/**
+ * Makes sure that listeners holding coalesced snapshots raise their events. They all do so
+ * together, once the shortest coalescing window among the listeners that started holding a
+ * snapshot has passed, so that the events of one "frame" are raised at once.
+ */
+- (void)scheduleCoalescedSnapshotsFlush {
+  if (_coalescedSnapshotsFlush) {
+    return;
+  }
+
+  absl::optional<AsyncQueue::Milliseconds> delay;
+  for (const auto &kv : _queries) {
+    for (const auto &listener : kv.second.listeners) {
+      if (listener->has_pending_snapshot()) {
+        AsyncQueue::Milliseconds window = listener->options().coalescing_window();
+        delay = delay.has_value() ? std::min(*delay, window) : window;
+      }
+    }
+  }
+  if (!delay.has_value()) {
+    return;
+  }
+
+  if (!_workerQueue) {
+    [self flushCoalescedSnapshots];
+    return;
+  }
+
+  _coalescedSnapshotsFlush =
+      _workerQueue->EnqueueAfterDelay(*delay, util::TimerId::CoalescedSnapshotsDelay, [self] {
+        self->_coalescedSnapshotsFlush = {};
+        [self flushCoalescedSnapshots];
+      });
+}
+
+- (void)flushCoalescedSnapshots {
+  EventBatch batch;
+  for (const auto &kv : _queries) {
+    for (const auto &listener : kv.second.listeners) {
+      listener->FlushPendingSnapshot();
+    }
+  }
 }
 
 - (void)handleError:(NSError *)error forQuery:(FSTQuery *)query {
@@ -173,6 +239,7 @@ struct QueryListenersInfo {
 - (void)applyChangedOnlineState:(OnlineState)onlineState {
   self.onlineState = onlineState;
 
+  EventBatch batch;
   for (auto &&kv : _queries) {
     QueryListenersInfo &info = kv.second;
     for (auto &&listener : info.listeners) {
@@ -16,6 +16,7 @@
 
 #import <Foundation/Foundation.h>
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -25,12 +26,16 @@
 #include "Firestore/core/src/firebase/firestore/api/document_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
+#include "Firestore/core/src/firebase/firestore/core/aggregate.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
 #include "Firestore/core/src/firebase/firestore/core/listen_options.h"
+#include "Firestore/core/src/firebase/firestore/core/memory_stats.h"
 #include "Firestore/core/src/firebase/firestore/core/query_listener.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/local/query_execution_stats.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/remote/rpc_metrics.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor_callback.h"
@@ -49,7 +54,9 @@
 namespace api = firebase::firestore::api;
 namespace auth = firebase::firestore::auth;
 namespace core = firebase::firestore::core;
+namespace local = firebase::firestore::local;
 namespace model = firebase::firestore::model;
+namespace remote = firebase::firestore::remote;
 namespace util = firebase::firestore::util;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -84,6 +91,24 @@ NS_ASSUME_NONNULL_BEGIN
 /** Enables the network connection and requeues all pending operations. */
 - (void)enableNetworkWithCallback:(util::StatusCallback)callback;
 
+/**
+ * Connects to the backend ahead of the first listen or write. Also done automatically when the
+ * first listener is added.
+ */
+- (void)warmUpConnection;
+
+/** Retrieves the traffic statistics of the RPCs made by this client so far. */
+- (void)getRpcStatsWithCallback:(remote::RpcStatsCallback)callback;
+
+/** Estimates the memory held by the caches and in-flight state of this client. */
+- (void)getMemoryStatsWithCallback:(core::MemoryStatsCallback)callback;
+
+/**
+ * Drops the caches that can be rebuilt from disk or from the server, e.g. in response to a low
+ * memory warning. Active listeners are unaffected.
+ */
+- (void)releaseRebuildableMemoryWithCallback:(util::StatusCallback)callback;
+
 /** Starts listening to a query. */
 - (std::shared_ptr<core::QueryListener>)listenToQuery:(FSTQuery *)query
                                               options:(core::ListenOptions)options
@@ -108,6 +133,27 @@ NS_ASSUME_NONNULL_BEGIN
                         completion:(void (^)(FIRQuerySnapshot *_Nullable query,
                                              NSError *_Nullable error))completion;
 
+/**
+ * Computes the given aggregate fields over the documents in the local cache that match the query.
+ * The documents themselves never leave the worker queue.
+ */
+- (void)getAggregateFromLocalCache:(FSTQuery *)query
+                            fields:(std::vector<core::AggregateField>)fields
+                          callback:(std::function<void(core::AggregateSnapshot)>)callback;
+
+/**
+ * Runs the given query against the local cache without returning its results, and reports how
+ * it was executed. Meant for debugging slow local queries.
+ */
+- (void)explainLocalExecutionOfQuery:(FSTQuery *)query
+                            callback:(std::function<void(local::QueryExecutionStats)>)callback;
+
+/**
+ * Loads a bundle (see -[FSTLocalSerializer decodedBundle:documents:error:]) into the local cache.
+ * The callback is notified once the documents are cached and raised to the active listeners.
+ */
+- (void)loadBundle:(NSData *)bundle callback:(util::StatusCallback)callback;
+
 /** Write mutations. callback will be notified when it's written to the backend. */
 - (void)writeMutations:(std::vector<FSTMutation *> &&)mutations
               callback:(util::StatusCallback)callback;
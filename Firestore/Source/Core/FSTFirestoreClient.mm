@@ -22,6 +22,7 @@
 #include <utility>
 
 #import "FIRFirestoreErrors.h"
+#import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
 #import "Firestore/Source/API/FIRDocumentReference+Internal.h"
 #import "Firestore/Source/API/FIRDocumentSnapshot+Internal.h"
 #import "Firestore/Source/API/FIRFirestore+Internal.h"
@@ -37,6 +38,7 @@
 #import "Firestore/Source/Local/FSTLocalSerializer.h"
 #import "Firestore/Source/Local/FSTLocalStore.h"
 #import "Firestore/Source/Local/FSTMemoryPersistence.h"
+#import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Remote/FSTSerializerBeta.h"
 #import "Firestore/Source/Util/FSTClasses.h"
@@ -44,32 +46,50 @@
 #include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/core/document_sizer.h"
+#include "Firestore/core/src/firebase/firestore/core/memory_stats.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_snapshot_reader.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/remote/datastore.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_store.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "Firestore/core/src/firebase/firestore/util/trace_span.h"
 #include "absl/memory/memory.h"
+#include "absl/types/optional.h"
 
 namespace util = firebase::firestore::util;
 using firebase::firestore::FirestoreErrorCode;
 using firebase::firestore::api::DocumentReference;
 using firebase::firestore::api::DocumentSnapshot;
+using firebase::firestore::api::PersistenceSettings;
 using firebase::firestore::api::Settings;
 using firebase::firestore::api::SnapshotMetadata;
 using firebase::firestore::api::ThrowIllegalState;
 using firebase::firestore::auth::CredentialsProvider;
 using firebase::firestore::auth::User;
+using firebase::firestore::core::AggregateAccumulator;
+using firebase::firestore::core::AggregateField;
+using firebase::firestore::core::AggregateSnapshot;
 using firebase::firestore::core::DatabaseInfo;
+using firebase::firestore::core::DocumentKeyByteSize;
+using firebase::firestore::core::DocumentSizer;
+using firebase::firestore::core::EventListener;
 using firebase::firestore::core::ListenOptions;
+using firebase::firestore::core::MemoryStats;
+using firebase::firestore::core::MemoryStatsCallback;
 using firebase::firestore::core::QueryListener;
 using firebase::firestore::core::ViewSnapshot;
+using firebase::firestore::local::LevelDbSnapshotReader;
 using firebase::firestore::local::LruParams;
+using firebase::firestore::local::LruResults;
+using firebase::firestore::local::QueryExecutionStats;
 using firebase::firestore::model::DatabaseId;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
@@ -77,14 +97,19 @@ using firebase::firestore::model::MaybeDocumentMap;
 using firebase::firestore::model::OnlineState;
 using firebase::firestore::remote::Datastore;
 using firebase::firestore::remote::RemoteStore;
+using firebase::firestore::remote::RpcStatsCallback;
+using firebase::firestore::remote::RpcStatsMap;
+using firebase::firestore::remote::WritePipelineOptions;
 using firebase::firestore::util::Path;
 using firebase::firestore::util::AsyncQueue;
 using firebase::firestore::util::DelayedOperation;
 using firebase::firestore::util::Executor;
+using firebase::firestore::util::ExecutorLibdispatch;
 using firebase::firestore::util::Status;
 using firebase::firestore::util::StatusOr;
 using firebase::firestore::util::StatusOrCallback;
 using firebase::firestore::util::TimerId;
+using firebase::firestore::util::TraceSpan;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -92,6 +117,12 @@ NS_ASSUME_NONNULL_BEGIN
 static const std::chrono::milliseconds FSTLruGcInitialDelay = std::chrono::minutes(1);
 /** Minimum amount of time between GC checks, after the first one. */
 static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minutes(5);
+/** How often a snapshot of the cache is exported for read-only instances in other processes. */
+static const std::chrono::milliseconds FSTSnapshotExportInterval = std::chrono::minutes(1);
+/** The maximum number of mutation batches sent to the backend and not yet acknowledged. */
+static const int FSTMaxPendingWrites = 100;
+/** The maximum number of consecutive mutation batches sent in a single write request. */
+static const int FSTMaxBatchesPerWriteRequest = 20;
 
 @interface FSTFirestoreClient () {
   DatabaseInfo _databaseInfo;
@@ -127,12 +158,27 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
   std::unique_ptr<RemoteStore> _remoteStore;
 
   std::unique_ptr<Executor> _userExecutor;
+
+  /**
+   * Concurrent executor for reads from LevelDB snapshots, which don't need the worker queue once
+   * the snapshot has been taken.
+   */
+  std::unique_ptr<Executor> _cacheReadExecutor;
+
   std::chrono::milliseconds _initialGcDelay;
   std::chrono::milliseconds _regularGcDelay;
   bool _gcHasRun;
   std::atomic<bool> _isShutdown;
   _Nullable id<FSTLRUDelegate> _lruDelegate;
   DelayedOperation _lruCallback;
+  DelayedOperation _groupCommitCallback;
+  DelayedOperation _snapshotExportCallback;
+
+  /** Used to persist documents, and to estimate the memory they take up. */
+  FSTLocalSerializer *_serializer;
+
+  /** Whether the connection has been warmed up already. Only accessed on the worker queue. */
+  bool _connectionWarmedUp;
 }
 
 - (Executor *)userExecutor {
@@ -167,6 +213,8 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
     _credentialsProvider = credentialsProvider;
     _userExecutor = std::move(userExecutor);
     _workerQueue = std::move(workerQueue);
+    _cacheReadExecutor = absl::make_unique<ExecutorLibdispatch>(dispatch_queue_create(
+        "com.google.firebase.firestore.cacheReads", DISPATCH_QUEUE_CONCURRENT));
     _gcHasRun = false;
     _isShutdown = false;
     _initialGcDelay = FSTLruGcInitialDelay;
@@ -206,23 +254,44 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
   // Do all of our initialization on our own dispatch queue.
   _workerQueue->VerifyIsCurrentQueue();
   LOG_DEBUG("Initializing. Current user: %s", user.uid());
+  TraceSpan span{"Initializing FSTFirestoreClient"};
 
   // Note: The initialization work must all be synchronous (we can't dispatch more work) since
   // external write/listen operations could get queued to run before that subsequent work
   // completes.
+  FSTSerializerBeta *remoteSerializer =
+      [[FSTSerializerBeta alloc] initWithDatabaseID:&self.databaseInfo->database_id()];
+  _serializer = [[FSTLocalSerializer alloc] initWithRemoteSerializer:remoteSerializer];
+
+  const PersistenceSettings &persistenceSettings = settings.persistence_settings();
+  bool exportReadOnly = settings.persistence_enabled() && persistenceSettings.export_read_only &&
+                        !persistenceSettings.export_directory.empty();
   if (settings.persistence_enabled()) {
     Path dir = [FSTLevelDB storageDirectoryForDatabaseInfo:*self.databaseInfo
                                         documentsDirectory:[FSTLevelDB documentsDirectory]];
+    absl::optional<Path> exportDir;
+    if (!persistenceSettings.export_directory.empty()) {
+      exportDir = [FSTLevelDB
+          storageDirectoryForDatabaseInfo:*self.databaseInfo
+                       documentsDirectory:Path::FromUtf8(persistenceSettings.export_directory)];
+    }
+    if (exportReadOnly) {
+      // The process that owns the cache keeps it open, so this instance works on a private copy of
+      // the latest snapshot it exported instead. Anything written to the copy is discarded the
+      // next time it's opened.
+      Status copyStatus = [FSTLevelDB copyLatestExportFromDirectory:*exportDir toDirectory:dir];
+      if (!copyStatus.ok()) {
+        [NSException raise:NSInternalInconsistencyException
+                    format:@"Failed to copy the exported DB: %s", copyStatus.ToString().c_str()];
+      }
+    }
 
-    FSTSerializerBeta *remoteSerializer =
-        [[FSTSerializerBeta alloc] initWithDatabaseID:&self.databaseInfo->database_id()];
-    FSTLocalSerializer *serializer =
-        [[FSTLocalSerializer alloc] initWithRemoteSerializer:remoteSerializer];
     FSTLevelDB *ldb;
     Status levelDbStatus =
         [FSTLevelDB dbWithDirectory:std::move(dir)
-                         serializer:serializer
+                         serializer:_serializer
                           lruParams:LruParams::WithCacheSize(settings.cache_size_bytes())
+                persistenceSettings:settings.persistence_settings()
                                 ptr:&ldb];
     if (!levelDbStatus.ok()) {
       // If leveldb fails to start then just throw up our hands: the error is unrecoverable.
@@ -234,27 +303,55 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
     }
     _lruDelegate = ldb.referenceDelegate;
     _persistence = ldb;
-    if (settings.gc_enabled()) {
+    if (settings.gc_enabled() && !exportReadOnly) {
       [self scheduleLruGarbageCollection];
     }
+    if (exportDir && !exportReadOnly) {
+      [self scheduleSnapshotExportForLevelDB:ldb toDirectory:*exportDir];
+    }
+    if (settings.persistence_settings().background_migrations_enabled) {
+      [self runMigrationBackfillForLevelDB:ldb];
+    }
+    int groupCommitDelayMs = settings.persistence_settings().group_commit_delay_ms;
+    if (groupCommitDelayMs > 0) {
+      [self scheduleGroupCommitForLevelDB:ldb delay:std::chrono::milliseconds(groupCommitDelayMs)];
+    }
+  } else if (settings.memory_lru_gc_enabled()) {
+    FSTMemoryPersistence *memory = [FSTMemoryPersistence
+        persistenceWithLruParams:LruParams::WithCacheSize(settings.memory_cache_size_bytes())
+                      serializer:_serializer];
+    _lruDelegate = (FSTMemoryLRUReferenceDelegate *)memory.referenceDelegate;
+    _persistence = memory;
+    [self scheduleLruGarbageCollection];
   } else {
     _persistence = [FSTMemoryPersistence persistenceWithEagerGC];
   }
 
   _localStore = [[FSTLocalStore alloc] initWithPersistence:_persistence initialUser:user];
+  _localStore.remoteDocumentBatchSize =
+      static_cast<size_t>(settings.persistence_settings().remote_document_batch_size);
+  _localStore.warmSnapshotTargetCount =
+      static_cast<size_t>(settings.persistence_settings().warm_snapshot_target_count);
+  _localStore.pendingWriteCompactionEnabled = settings.pending_write_compaction_enabled();
 
   auto datastore =
       std::make_shared<Datastore>(*self.databaseInfo, _workerQueue.get(), _credentialsProvider);
 
+  WritePipelineOptions writePipelineOptions;
+  writePipelineOptions.max_pending_writes = FSTMaxPendingWrites;
+  writePipelineOptions.max_batches_per_request = FSTMaxBatchesPerWriteRequest;
+
   _remoteStore = absl::make_unique<RemoteStore>(
       _localStore, std::move(datastore), _workerQueue.get(),
-      [self](OnlineState onlineState) { [self.syncEngine applyChangedOnlineState:onlineState]; });
+      [self](OnlineState onlineState) { [self.syncEngine applyChangedOnlineState:onlineState]; },
+      writePipelineOptions);
 
   _syncEngine = [[FSTSyncEngine alloc] initWithLocalStore:_localStore
                                               remoteStore:_remoteStore.get()
                                               initialUser:user];
 
-  _eventManager = [FSTEventManager eventManagerWithSyncEngine:_syncEngine];
+  _eventManager = [FSTEventManager eventManagerWithSyncEngine:_syncEngine
+                                                  workerQueue:_workerQueue.get()];
 
   // Setup wiring for remote store.
   _remoteStore->set_sync_engine(_syncEngine);
@@ -263,6 +360,55 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
   // queue, etc.) so must be started after LocalStore.
   [_localStore start];
   _remoteStore->Start();
+  if (exportReadOnly) {
+    // Read-only instances only serve what the owning process already cached.
+    _remoteStore->DisableNetwork();
+  }
+}
+
+/**
+ * Completes the schema migrations that opening the database deferred. Each step commits its own
+ * transaction and runs in the background, so that user-visible work isn't held up.
+ */
+- (void)runMigrationBackfillForLevelDB:(FSTLevelDB *)ldb {
+  AsyncQueue::Step backfillStep = [self, ldb] {
+    if (self->_isShutdown) return false;
+    return static_cast<bool>([ldb runMigrationBackfillStep]);
+  };
+  _workerQueue->EnqueueBackgroundSteps(backfillStep, "MigrationBackfill");
+}
+
+/**
+ * Flushes the commits that the LevelDB persistence holds back for group commit at most `delay`
+ * after the first of them.
+ */
+- (void)scheduleGroupCommitForLevelDB:(FSTLevelDB *)ldb delay:(std::chrono::milliseconds)delay {
+  // The persistence owns the handler, so neither it nor the client may be retained by it.
+  __weak __typeof__(self) weakSelf = self;
+  __weak FSTLevelDB *weakDb = ldb;
+  ldb.groupCommitHandler = ^{
+    __typeof__(self) strongSelf = weakSelf;
+    if (!strongSelf) return;
+    strongSelf->_groupCommitCallback.Cancel();
+    strongSelf->_groupCommitCallback = strongSelf->_workerQueue->EnqueueAfterDelay(
+        delay, TimerId::GroupCommitDelay, [strongSelf, weakDb] {
+          if (strongSelf->_isShutdown) return;
+          [weakDb flushGroupCommit];
+        });
+  };
+}
+
+/**
+ * Exports a snapshot of the cache to `directory` every `FSTSnapshotExportInterval`, for read-only
+ * instances in other processes to open. Reschedules itself.
+ */
+- (void)scheduleSnapshotExportForLevelDB:(FSTLevelDB *)ldb toDirectory:(const Path &)directory {
+  _snapshotExportCallback = _workerQueue->EnqueueAfterDelay(
+      FSTSnapshotExportInterval, TimerId::SnapshotExportDelay, [self, ldb, directory] {
+        if (self->_isShutdown) return;
+        [ldb exportSnapshotToDirectory:directory];
+        [self scheduleSnapshotExportForLevelDB:ldb toDirectory:directory];
+      });
 }
 
 /**
@@ -271,10 +417,24 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
  */
 - (void)scheduleLruGarbageCollection {
   std::chrono::milliseconds delay = _gcHasRun ? _regularGcDelay : _initialGcDelay;
+  [self scheduleLruGarbageCollectionAfterDelay:delay];
+}
+
+- (void)scheduleLruGarbageCollectionAfterDelay:(std::chrono::milliseconds)delay {
   _lruCallback = _workerQueue->EnqueueAfterDelay(delay, TimerId::GarbageCollectionDelay, [self]() {
-    [self->_localStore collectGarbage:self->_lruDelegate.gc];
-    self->_gcHasRun = true;
-    [self scheduleLruGarbageCollection];
+    // Each step commits its own transaction; run them in the background so that user-visible work
+    // enqueued in the meantime is not held up by a long collection.
+    AsyncQueue::Step collectStep = [self] {
+      if (self->_isShutdown) return false;
+
+      LruResults results = [self->_localStore collectGarbage:self->_lruDelegate.gc];
+      self->_gcHasRun = true;
+      if (results.hasMoreToCollect) return true;
+
+      [self scheduleLruGarbageCollection];
+      return false;
+    };
+    self->_workerQueue->EnqueueBackgroundSteps(collectStep, "GarbageCollection");
   });
 }
 
@@ -305,6 +465,54 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
   });
 }
 
+- (void)warmUpConnection {
+  [self verifyNotShutdown];
+  _workerQueue->Enqueue([self] { [self warmUpConnectionOnQueue]; });
+}
+
+- (void)warmUpConnectionOnQueue {
+  if (!_connectionWarmedUp) {
+    _connectionWarmedUp = true;
+    _remoteStore->WarmUpConnection();
+  }
+}
+
+- (void)getRpcStatsWithCallback:(RpcStatsCallback)callback {
+  [self verifyNotShutdown];
+  _workerQueue->Enqueue([self, callback] {
+    RpcStatsMap stats = _remoteStore->GetRpcStats();
+    self->_userExecutor->Execute([=] { callback(stats); });
+  });
+}
+
+- (void)getMemoryStatsWithCallback:(MemoryStatsCallback)callback {
+  [self verifyNotShutdown];
+  _workerQueue->Enqueue([self, callback] {
+    // Documents are estimated by the size of their serialized form, which tracks the size of their
+    // contents without walking the object graph of each field value.
+    FSTLocalSerializer *serializer = self->_serializer;
+    DocumentSizer sizer = [serializer](FSTMaybeDocument *doc) -> size_t {
+      return DocumentKeyByteSize(doc.key) + [[serializer encodedMaybeDocument:doc] serializedSize];
+    };
+
+    MemoryStats stats;
+    stats.view_bytes = [self.syncEngine viewByteSizeWithDocumentSizer:sizer];
+    [self.localStore collectMemoryStats:&stats documentSizer:sizer];
+    _remoteStore->CollectMemoryStats(&stats, sizer);
+    self->_userExecutor->Execute([=] { callback(stats); });
+  });
+}
+
+- (void)releaseRebuildableMemoryWithCallback:(util::StatusCallback)callback {
+  [self verifyNotShutdown];
+  _workerQueue->Enqueue([self, callback] {
+    [self.localStore releaseRebuildableMemory];
+    if (callback) {
+      self->_userExecutor->Execute([=] { callback(Status::OK()); });
+    }
+  });
+}
+
 - (void)shutdownWithCallback:(util::StatusCallback)callback {
   _workerQueue->Enqueue([self, callback] {
     if (!_isShutdown) {
@@ -314,6 +522,8 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
       if (self->_lruCallback) {
         self->_lruCallback.Cancel();
       }
+      self->_groupCommitCallback.Cancel();
+      self->_snapshotExportCallback.Cancel();
       _remoteStore->Shutdown();
       [self.persistence shutdown];
       self->_isShutdown = true;
@@ -335,7 +545,17 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
                                        listener:(ViewSnapshot::SharedListener &&)listener {
   auto query_listener = QueryListener::Create(query, std::move(options), std::move(listener));
 
-  _workerQueue->Enqueue([self, query_listener] { [self.eventManager addListener:query_listener]; });
+  _workerQueue->Enqueue([self, query_listener] {
+    // Connect while the query runs against the local store, rather than only once the watch
+    // stream is started behind it.
+    [self warmUpConnectionOnQueue];
+    [self.eventManager addListener:query_listener];
+    if (self.localStore.warmSnapshotTargetCount > 0) {
+      // Reconciling behind the listens enqueued in the meantime lets all of them deliver their warm
+      // snapshots before any of their queries run against the local store.
+      self->_workerQueue->EnqueueRelaxed([self] { [self.syncEngine reconcileWarmStartedQueries]; });
+    }
+  });
 
   return query_listener;
 }
@@ -345,61 +565,179 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
   _workerQueue->Enqueue([self, listener] { [self.eventManager removeListener:listener]; });
 }
 
+/**
+ * Takes a snapshot of the LevelDB persistence on the worker queue, so that the read reflects every
+ * earlier write, or returns nullptr if the persistence doesn't support snapshot reads.
+ */
+- (std::shared_ptr<LevelDbSnapshotReader>)newSnapshotReader {
+  _workerQueue->VerifyIsCurrentQueue();
+  if (![self.persistence isKindOfClass:[FSTLevelDB class]]) {
+    return nullptr;
+  }
+  return [(FSTLevelDB *)self.persistence newSnapshotReader];
+}
+
 - (void)getDocumentFromLocalCache:(const DocumentReference &)doc
                          callback:(DocumentSnapshot::Listener &&)callback {
   [self verifyNotShutdown];
   auto shared_callback = absl::ShareUniquePtr(std::move(callback));
   _workerQueue->Enqueue([self, doc, shared_callback] {
-    FSTMaybeDocument *maybeDoc = [self.localStore readDocument:doc.key()];
-    StatusOr<DocumentSnapshot> maybe_snapshot;
-
-    if ([maybeDoc isKindOfClass:[FSTDocument class]]) {
-      FSTDocument *document = (FSTDocument *)maybeDoc;
-      maybe_snapshot = DocumentSnapshot{doc.firestore(), doc.key(), document,
-                                        /*from_cache=*/true,
-                                        /*has_pending_writes=*/document.hasLocalMutations};
-    } else if ([maybeDoc isKindOfClass:[FSTDeletedDocument class]]) {
-      maybe_snapshot = DocumentSnapshot{doc.firestore(), doc.key(), nil,
-                                        /*from_cache=*/true,
-                                        /*has_pending_writes=*/false};
+    std::shared_ptr<LevelDbSnapshotReader> reader = [self newSnapshotReader];
+    if (reader) {
+      self->_cacheReadExecutor->Execute([self, doc, shared_callback, reader] {
+        [self deliverDocument:reader->GetDocument(doc.key())
+                 forReference:doc
+                     callback:shared_callback];
+      });
     } else {
-      maybe_snapshot = Status{FirestoreErrorCode::Unavailable,
-                              "Failed to get document from cache. (However, this document "
-                              "may exist on the server. Run again without setting source to "
-                              "FirestoreSourceCache to attempt to retrieve the document "};
-    }
-
-    if (shared_callback) {
-      self->_userExecutor->Execute([=] { shared_callback->OnEvent(std::move(maybe_snapshot)); });
+      [self deliverDocument:[self.localStore readDocument:doc.key()]
+               forReference:doc
+                   callback:shared_callback];
     }
   });
 }
 
+- (void)deliverDocument:(nullable FSTMaybeDocument *)maybeDoc
+           forReference:(const DocumentReference &)doc
+               callback:(const std::shared_ptr<EventListener<DocumentSnapshot>> &)shared_callback {
+  StatusOr<DocumentSnapshot> maybe_snapshot;
+
+  if ([maybeDoc isKindOfClass:[FSTDocument class]]) {
+    FSTDocument *document = (FSTDocument *)maybeDoc;
+    maybe_snapshot = DocumentSnapshot{doc.firestore(), doc.key(), document,
+                                      /*from_cache=*/true,
+                                      /*has_pending_writes=*/document.hasLocalMutations};
+  } else if ([maybeDoc isKindOfClass:[FSTDeletedDocument class]]) {
+    maybe_snapshot = DocumentSnapshot{doc.firestore(), doc.key(), nil,
+                                      /*from_cache=*/true,
+                                      /*has_pending_writes=*/false};
+  } else {
+    maybe_snapshot = Status{FirestoreErrorCode::Unavailable,
+                            "Failed to get document from cache. (However, this document "
+                            "may exist on the server. Run again without setting source to "
+                            "FirestoreSourceCache to attempt to retrieve the document "};
+  }
+
+  if (shared_callback) {
+    _userExecutor->Execute([=] { shared_callback->OnEvent(std::move(maybe_snapshot)); });
+  }
+}
+
 - (void)getDocumentsFromLocalCache:(FIRQuery *)query
                         completion:(void (^)(FIRQuerySnapshot *_Nullable query,
                                              NSError *_Nullable error))completion {
   [self verifyNotShutdown];
   _workerQueue->Enqueue([self, query, completion] {
-    DocumentMap docs = [self.localStore executeQuery:query.query];
+    // Projection queries are served from memory and collection group queries depend on indexes
+    // that may still be backfilling, so both stay on the worker queue.
+    std::shared_ptr<LevelDbSnapshotReader> reader;
+    if (![query.query hasProjection] && ![query.query isCollectionGroupQuery]) {
+      reader = [self newSnapshotReader];
+    }
+    if (reader) {
+      self->_cacheReadExecutor->Execute([self, query, completion, reader] {
+        [self deliverDocuments:reader->GetDocumentsMatchingQuery(query.query)
+                      forQuery:query
+                    completion:completion];
+      });
+    } else {
+      [self deliverDocuments:[self.localStore executeQuery:query.query]
+                    forQuery:query
+                  completion:completion];
+    }
+  });
+}
+
+- (void)deliverDocuments:(const DocumentMap &)docs
+                forQuery:(FIRQuery *)query
+              completion:(void (^)(FIRQuerySnapshot *_Nullable query,
+                                   NSError *_Nullable error))completion {
+  FSTView *view = [[FSTView alloc] initWithQuery:query.query remoteDocuments:DocumentKeySet{}];
+  FSTViewDocumentChanges *viewDocChanges =
+      [view computeChangesWithDocuments:docs.underlying_map()];
+  FSTViewChange *viewChange = [view applyChangesToDocuments:viewDocChanges];
+  HARD_ASSERT(viewChange.limboChanges.count == 0,
+              "View returned limbo documents during local-only query execution.");
+  HARD_ASSERT(viewChange.snapshot.has_value(), "Expected a snapshot");
+
+  ViewSnapshot snapshot = std::move(viewChange.snapshot).value();
+  SnapshotMetadata metadata(snapshot.has_pending_writes(), snapshot.from_cache());
+
+  FIRQuerySnapshot *result = [[FIRQuerySnapshot alloc] initWithFirestore:query.firestore.wrapped
+                                                           originalQuery:query.query
+                                                                snapshot:std::move(snapshot)
+                                                                metadata:std::move(metadata)];
+
+  if (completion) {
+    _userExecutor->Execute([=] { completion(result, nil); });
+  }
+}
+
+- (void)getAggregateFromLocalCache:(FSTQuery *)query
+                            fields:(std::vector<AggregateField>)fields
+                          callback:(std::function<void(AggregateSnapshot)>)callback {
+  [self verifyNotShutdown];
+  _workerQueue->Enqueue([self, query, fields, callback] {
+    DocumentMap docs = [self.localStore executeQuery:query];
 
-    FSTView *view = [[FSTView alloc] initWithQuery:query.query remoteDocuments:DocumentKeySet{}];
+    // Run the documents through a view so that the aggregates respect the order and limit of the
+    // query, just like the documents a listener would see.
+    FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
     FSTViewDocumentChanges *viewDocChanges =
         [view computeChangesWithDocuments:docs.underlying_map()];
     FSTViewChange *viewChange = [view applyChangesToDocuments:viewDocChanges];
-    HARD_ASSERT(viewChange.limboChanges.count == 0,
-                "View returned limbo documents during local-only query execution.");
     HARD_ASSERT(viewChange.snapshot.has_value(), "Expected a snapshot");
 
     ViewSnapshot snapshot = std::move(viewChange.snapshot).value();
-    SnapshotMetadata metadata(snapshot.has_pending_writes(), snapshot.from_cache());
+    AggregateAccumulator accumulator{fields};
+    accumulator.Apply(snapshot);
+    AggregateSnapshot result =
+        accumulator.ToSnapshot(snapshot.from_cache(), snapshot.has_pending_writes());
 
-    FIRQuerySnapshot *result = [[FIRQuerySnapshot alloc] initWithFirestore:query.firestore.wrapped
-                                                             originalQuery:query.query
-                                                                  snapshot:std::move(snapshot)
-                                                                  metadata:std::move(metadata)];
+    if (callback) {
+      self->_userExecutor->Execute([=] { callback(result); });
+    }
+  });
+}
 
-    if (completion) {
-      self->_userExecutor->Execute([=] { completion(result, nil); });
+- (void)loadBundle:(NSData *)bundle callback:(util::StatusCallback)callback {
+  [self verifyNotShutdown];
+  _workerQueue->Enqueue([self, bundle, callback] {
+    Status status = [self decodeAndLoadBundle:bundle];
+    if (callback) {
+      self->_userExecutor->Execute([=] { callback(status); });
+    }
+  });
+}
+
+- (Status)decodeAndLoadBundle:(NSData *)bundle {
+  std::vector<FSTMaybeDocument *> documents;
+  NSError *error;
+  FSTQueryData *queryData = [_serializer decodedBundle:bundle documents:&documents error:&error];
+  if (!queryData) {
+    return Status{FirestoreErrorCode::InvalidArgument, "Malformed bundle"}.CausedBy(
+        Status::FromNSError(error));
+  }
+  if ([queryData.query hasProjection]) {
+    // The partial documents of a projection never go into the remote document cache.
+    return Status{FirestoreErrorCode::InvalidArgument,
+                  "Bundles of queries with selected fields are not supported"};
+  }
+
+  TraceSpan span{"Loading bundle"};
+  [self.syncEngine loadBundleDocuments:documents queryData:queryData];
+  return Status::OK();
+}
+
+- (void)explainLocalExecutionOfQuery:(FSTQuery *)query
+                            callback:(std::function<void(QueryExecutionStats)>)callback {
+  [self verifyNotShutdown];
+  _workerQueue->Enqueue([self, query, callback] {
+    QueryExecutionStats stats;
+    [self.localStore executeQuery:query stats:&stats];
+
+    if (callback) {
+      self->_userExecutor->Execute([=] { callback(stats); });
     }
   });
 }
@@ -407,7 +745,7 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
 - (void)writeMutations:(std::vector<FSTMutation *> &&)mutations
               callback:(util::StatusCallback)callback {
   // TODO(c++14): move `mutations` into lambda (C++14).
-  _workerQueue->Enqueue([self, mutations, callback]() mutable {
+  auto write = [self, mutations, callback]() mutable {
     [self verifyNotShutdown];
     if (mutations.empty()) {
       if (callback) {
@@ -423,7 +761,8 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
                 }
               }];
     }
-  });
+  };
+  _workerQueue->Enqueue(AsyncQueue::Priority::Normal, write, "WriteMutations");
 };
 
 - (void)transactionWithRetries:(int)retries
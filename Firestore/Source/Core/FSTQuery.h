@@ -16,7 +16,10 @@
 
 #import <Foundation/Foundation.h>
 
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/core/filter.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
@@ -170,7 +173,20 @@ NS_ASSUME_NONNULL_BEGIN
                      orderBy:(NSArray<FSTSortOrder *> *)sortOrders
                        limit:(NSInteger)limit
                      startAt:(nullable FSTBound *)startAtBound
-                       endAt:(nullable FSTBound *)endAtBound NS_DESIGNATED_INITIALIZER;
+                       endAt:(nullable FSTBound *)endAtBound;
+
+/**
+ * Initializes a query with all of its components directly, including the fields it selects (or
+ * none to select whole documents).
+ */
+- (instancetype)initWithPath:(model::ResourcePath)path
+             collectionGroup:(nullable NSString *)collectionGroup
+                    filterBy:(NSArray<FSTFilter *> *)filters
+                     orderBy:(NSArray<FSTSortOrder *> *)sortOrders
+                       limit:(NSInteger)limit
+                     startAt:(nullable FSTBound *)startAtBound
+                       endAt:(nullable FSTBound *)endAtBound
+                  projection:(std::vector<model::FieldPath>)projection NS_DESIGNATED_INITIALIZER;
 
 /**
  * Creates and returns a new FSTQuery.
@@ -192,6 +208,16 @@ NS_ASSUME_NONNULL_BEGIN
 + (instancetype)queryWithPath:(model::ResourcePath)path
               collectionGroup:(nullable NSString *)collectionGroup;
 
+/**
+ * Creates and returns a new FSTQuery for the documents with the given keys, which the backend
+ * watches as a single target. The query for a single key is the plain document query for it.
+ * A query for a set of keys can't be filtered, ordered, limited or projected.
+ *
+ * @param keys The keys of the documents to query. Must not be empty.
+ * @return A new instance of FSTQuery.
+ */
++ (instancetype)queryWithDocumentKeys:(model::DocumentKeySet)keys;
+
 /**
  * Returns the list of ordering constraints that were explicitly requested on the query by the
  * user.
@@ -248,6 +274,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (instancetype)queryByAddingEndAt:(FSTBound *)bound;
 
+/**
+ * Returns a new FSTQuery whose results only contain the given fields of each document, or whole
+ * documents if @a fields is empty. See `projection`.
+ */
+- (instancetype)queryBySettingProjection:(std::vector<model::FieldPath>)fields;
+
 /**
  * Helper to convert a collection group query into a collection query at a specific path. This is
  * used when executing collection group queries, since we have to split the query into a set of
@@ -258,14 +290,26 @@ NS_ASSUME_NONNULL_BEGIN
 /** Returns YES if the receiver is query for a specific document. */
 - (BOOL)isDocumentQuery;
 
+/** Returns YES if the receiver is a query for a set of (more than one) documents. */
+- (BOOL)isDocumentKeysQuery;
+
 /** Returns YES if the receiver is a collection group query. */
 - (BOOL)isCollectionGroupQuery;
 
+/**
+ * Returns YES if every result of the receiver is also a result of @a query, i.e. the two queries
+ * only differ in that @a query has no limit or a limit no smaller than the receiver's.
+ */
+- (BOOL)isContainedInQuery:(FSTQuery *)query;
+
 /** Returns YES if the @a document matches the constraints of the receiver. */
 - (BOOL)matchesDocument:(FSTDocument *)document;
 
-/** Returns a comparator that will sort documents according to the receiver's sort order. */
-- (model::DocumentComparator)comparator;
+/**
+ * Returns a comparator that will sort documents according to the receiver's sort order. The
+ * comparator is built on first use and shared by all later callers.
+ */
+- (const model::DocumentComparator &)comparator;
 
 /** Returns the field of the first filter on the receiver that's an inequality, or nullptr if none.
  */
@@ -280,6 +324,19 @@ NS_ASSUME_NONNULL_BEGIN
 /** The base path of the query. */
 - (const model::ResourcePath &)path;
 
+/**
+ * The fields the results of the query are projected to, sorted and without duplicates, or empty if
+ * the query returns whole documents. The fields of the filters and sort orders of a projection
+ * query are always part of its projection, so that its results can be matched and ordered locally.
+ */
+- (const std::vector<model::FieldPath> &)projection;
+
+/** Returns YES if the query returns partial documents. */
+- (BOOL)hasProjection;
+
+/** The keys of the documents of a query for a set of documents, or empty for any other query. */
+- (const model::DocumentKeySet &)documentKeys;
+
 /** The collection group of the query. */
 @property(nonatomic, nullable, strong, readonly) NSString *collectionGroup;
 
@@ -16,9 +16,11 @@
 
 #import "Firestore/Source/Core/FSTQuery.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/API/FIRFirestore+Internal.h"
 #import "Firestore/Source/Model/FSTDocument.h"
@@ -34,6 +36,7 @@
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "absl/types/optional.h"
 
 namespace core = firebase::firestore::core;
 namespace util = firebase::firestore::util;
@@ -41,6 +44,7 @@ using firebase::firestore::api::ThrowInvalidArgument;
 using firebase::firestore::core::Filter;
 using firebase::firestore::model::DocumentComparator;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::FieldValue;
 using firebase::firestore::model::ResourcePath;
@@ -108,6 +112,15 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
 @interface FSTRelationFilter () {
   /** The left hand side of the relation. A path into a document field. */
   firebase::firestore::model::FieldPath _field;
+
+  /** Whether _field is the document key, resolved once rather than on every match. */
+  BOOL _keyFilter;
+
+  /** The type order of _value; only values of the same type order can match. */
+  FSTTypeOrder _valueTypeOrder;
+
+  /** Cached value of the canonicalID property. */
+  NSString *_canonicalID;
 }
 
 /**
@@ -144,6 +157,14 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
     _field = std::move(field);
     _filterOperator = filterOperator;
     _value = value;
+    _keyFilter = _field.IsKeyFieldPath();
+    _valueTypeOrder = value.typeOrder;
+    if (_keyFilter) {
+      HARD_ASSERT(value.type == FieldValue::Type::Reference,
+                  "Comparing on key, but filter value not a FSTReferenceValue.");
+      HARD_ASSERT(filterOperator != Filter::Operator::ArrayContains,
+                  "arrayContains queries don't make sense on document keys.");
+    }
   }
   return self;
 }
@@ -177,27 +198,32 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
   return [self isEqualToFilter:(FSTRelationFilter *)other];
 }
 
+- (NSUInteger)hash {
+  return util::Hash(_field, static_cast<int>(self.filterOperator), [self.value hash]);
+}
+
 #pragma mark - Private methods
 
 - (BOOL)matchesDocument:(FSTDocument *)document {
-  if (_field.IsKeyFieldPath()) {
-    HARD_ASSERT(self.value.type == FieldValue::Type::Reference,
-                "Comparing on key, but filter value not a FSTReferenceValue.");
-    HARD_ASSERT(self.filterOperator != Filter::Operator::ArrayContains,
-                "arrayContains queries don't make sense on document keys.");
-    FSTReferenceValue *refValue = (FSTReferenceValue *)self.value;
+  if (_keyFilter) {
+    FSTReferenceValue *refValue = (FSTReferenceValue *)_value;
     NSComparisonResult comparison = util::WrapCompare(document.key, refValue.value.key);
     return [self matchesComparison:comparison];
   } else {
-    return [self matchesValue:[document fieldForPath:self.field]];
+    return [self matchesValue:[document fieldForPath:_field]];
   }
 }
 
 - (NSString *)canonicalID {
-  // TODO(b/37283291): This should be collision robust and avoid relying on |description| methods.
-  return [NSString stringWithFormat:@"%s%@%@", _field.CanonicalString().c_str(),
-                                    FSTStringFromQueryRelationOperator(self.filterOperator),
-                                    [self.value value]];
+  if (!_canonicalID) {
+    // TODO(b/37283291): This should be collision robust and avoid relying on |description|
+    // methods.
+    _canonicalID =
+        [NSString stringWithFormat:@"%s%@%@", _field.CanonicalString().c_str(),
+                                   FSTStringFromQueryRelationOperator(self.filterOperator),
+                                   [self.value value]];
+  }
+  return _canonicalID;
 }
 
 - (BOOL)isEqualToFilter:(FSTRelationFilter *)other {
@@ -225,8 +251,8 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
   } else {
     // Only perform comparison queries on types with matching backend order (such as double and
     // int).
-    return self.value.typeOrder == other.typeOrder &&
-           [self matchesComparison:[other compare:self.value]];
+    return _valueTypeOrder == other.typeOrder &&
+           [self matchesComparison:[other compare:_value]];
   }
 }
 
@@ -344,8 +370,14 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
 @interface FSTSortOrder () {
   /** The field to sort by. */
   firebase::firestore::model::FieldPath _field;
+
+  /** Cached value of the canonicalID property. */
+  NSString *_canonicalID;
 }
 
+/** Whether the field to sort by is the document key, resolved once at construction. */
+@property(nonatomic, assign, readonly, getter=isKeyOrder) BOOL keyOrder;
+
 /** Creates a new sort order with the given field and direction. */
 - (instancetype)initWithFieldPath:(FieldPath)fieldPath ascending:(BOOL)ascending;
 
@@ -366,6 +398,7 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
   if (self) {
     _field = std::move(fieldPath);
     _ascending = ascending;
+    _keyOrder = _field.IsKeyFieldPath();
   }
   return self;
 }
@@ -378,24 +411,27 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
 
 - (ComparisonResult)compareDocument:(FSTDocument *)document1 toDocument:(FSTDocument *)document2 {
   ComparisonResult result;
-  if (_field == FieldPath::KeyFieldPath()) {
+  if (_keyOrder) {
     result = util::Compare(document1.key, document2.key);
   } else {
-    FSTFieldValue *value1 = [document1 fieldForPath:self.field];
-    FSTFieldValue *value2 = [document2 fieldForPath:self.field];
+    FSTFieldValue *value1 = [document1 fieldForPath:_field];
+    FSTFieldValue *value2 = [document2 fieldForPath:_field];
     HARD_ASSERT(value1 != nil && value2 != nil,
                 "Trying to compare documents on fields that don't exist.");
     result = util::MakeComparisonResult([value1 compare:value2]);
   }
-  if (!self.isAscending) {
+  if (!_ascending) {
     result = util::ReverseOrder(result);
   }
   return result;
 }
 
 - (NSString *)canonicalID {
-  return [NSString stringWithFormat:@"%s%@", _field.CanonicalString().c_str(),
-                                    self.isAscending ? @"asc" : @"desc"];
+  if (!_canonicalID) {
+    _canonicalID = [NSString stringWithFormat:@"%s%@", _field.CanonicalString().c_str(),
+                                              self.isAscending ? @"asc" : @"desc"];
+  }
+  return _canonicalID;
 }
 
 - (BOOL)isEqualToSortOrder:(FSTSortOrder *)other {
@@ -421,7 +457,7 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
 }
 
 - (NSUInteger)hash {
-  return [self.canonicalID hash];
+  return util::Hash(_field, self.isAscending);
 }
 
 - (instancetype)copyWithZone:(nullable NSZone *)zone {
@@ -529,8 +565,16 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
 @interface FSTQuery () {
   // Cached value of the canonicalID property.
   NSString *_canonicalID;
+  // Cached value of the hash property.
+  absl::optional<NSUInteger> _hash;
+  // Cached value of the comparator property.
+  absl::optional<DocumentComparator> _comparator;
   /** The base path of the query. */
   ResourcePath _path;
+  /** The fields the results are projected to, or empty for whole documents. */
+  std::vector<FieldPath> _projection;
+  /** The keys of the documents of a query for a set of documents. */
+  DocumentKeySet _documentKeys;
 }
 
 /** A list of fields given to sort by. This does not include the implicit key sort at the end. */
@@ -560,6 +604,16 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
                                   endAt:nil];
 }
 
++ (instancetype)queryWithDocumentKeys:(DocumentKeySet)keys {
+  HARD_ASSERT(!keys.empty(), "A query for a set of documents needs at least one key");
+  if (keys.size() == 1) {
+    return [FSTQuery queryWithPath:(*keys.begin()).path()];
+  }
+  FSTQuery *query = [FSTQuery queryWithPath:ResourcePath{}];
+  query->_documentKeys = std::move(keys);
+  return query;
+}
+
 - (instancetype)initWithPath:(ResourcePath)path
              collectionGroup:(nullable NSString *)collectionGroup
                     filterBy:(NSArray<FSTFilter *> *)filters
@@ -567,6 +621,24 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
                        limit:(NSInteger)limit
                      startAt:(nullable FSTBound *)startAtBound
                        endAt:(nullable FSTBound *)endAtBound {
+  return [self initWithPath:std::move(path)
+            collectionGroup:collectionGroup
+                   filterBy:filters
+                    orderBy:sortOrders
+                      limit:limit
+                    startAt:startAtBound
+                      endAt:endAtBound
+                 projection:{}];
+}
+
+- (instancetype)initWithPath:(ResourcePath)path
+             collectionGroup:(nullable NSString *)collectionGroup
+                    filterBy:(NSArray<FSTFilter *> *)filters
+                     orderBy:(NSArray<FSTSortOrder *> *)sortOrders
+                       limit:(NSInteger)limit
+                     startAt:(nullable FSTBound *)startAtBound
+                       endAt:(nullable FSTBound *)endAtBound
+                  projection:(std::vector<FieldPath>)projection {
   if (self = [super init]) {
     _path = std::move(path);
     _collectionGroup = collectionGroup;
@@ -575,6 +647,8 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
     _limit = limit;
     _startAt = startAtBound;
     _endAt = endAtBound;
+    _projection = std::move(projection);
+    [self normalizeProjection];
   }
   return self;
 }
@@ -596,7 +670,22 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
 }
 
 - (NSUInteger)hash {
-  return [self.canonicalID hash];
+  // Computed from the components of the query rather than its canonicalID, so that looking up a
+  // newly built query, e.g. in the listeners of the event manager, doesn't build the string.
+  if (!_hash) {
+    size_t result = util::Hash(_path, [self.collectionGroup hash], self.limit);
+    for (FSTFilter *filter in self.filters) {
+      result = 31 * result + [filter hash];
+    }
+    for (FSTSortOrder *sortOrder in self.sortOrders) {
+      result = 31 * result + [sortOrder hash];
+    }
+    result = 31 * result + [self.startAt hash];
+    result = 31 * result + [self.endAt hash];
+    result = 31 * result + util::Hash(_projection);
+    _hash = result;
+  }
+  return *_hash;
 }
 
 - (instancetype)copyWithZone:(nullable NSZone *)zone {
@@ -654,6 +743,7 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
 
 - (instancetype)queryByAddingFilter:(FSTFilter *)filter {
   HARD_ASSERT(![self isDocumentQuery], "No filtering allowed for document query");
+  HARD_ASSERT(![self isDocumentKeysQuery], "No filtering allowed for a set of documents");
 
   const FieldPath *newInequalityField = nullptr;
   if ([filter isKindOfClass:[FSTRelationFilter class]] &&
@@ -671,11 +761,13 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
                                 orderBy:self.explicitSortOrders
                                   limit:self.limit
                                 startAt:self.startAt
-                                  endAt:self.endAt];
+                                  endAt:self.endAt
+                             projection:_projection];
 }
 
 - (instancetype)queryByAddingSortOrder:(FSTSortOrder *)sortOrder {
   HARD_ASSERT(![self isDocumentQuery], "No ordering is allowed for a document query.");
+  HARD_ASSERT(![self isDocumentKeysQuery], "No ordering is allowed for a set of documents.");
 
   // TODO(klimt): Validate that the same key isn't added twice.
   return [[FSTQuery alloc] initWithPath:self.path
@@ -684,37 +776,60 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
                                 orderBy:[self.explicitSortOrders arrayByAddingObject:sortOrder]
                                   limit:self.limit
                                 startAt:self.startAt
-                                  endAt:self.endAt];
+                                  endAt:self.endAt
+                             projection:_projection];
 }
 
 - (instancetype)queryBySettingLimit:(NSInteger)limit {
+  HARD_ASSERT(![self isDocumentKeysQuery], "No limit is allowed for a set of documents.");
+
   return [[FSTQuery alloc] initWithPath:self.path
                         collectionGroup:self.collectionGroup
                                filterBy:self.filters
                                 orderBy:self.explicitSortOrders
                                   limit:limit
                                 startAt:self.startAt
-                                  endAt:self.endAt];
+                                  endAt:self.endAt
+                             projection:_projection];
 }
 
 - (instancetype)queryByAddingStartAt:(FSTBound *)bound {
+  HARD_ASSERT(![self isDocumentKeysQuery], "No bounds are allowed for a set of documents.");
+
   return [[FSTQuery alloc] initWithPath:self.path
                         collectionGroup:self.collectionGroup
                                filterBy:self.filters
                                 orderBy:self.explicitSortOrders
                                   limit:self.limit
                                 startAt:bound
-                                  endAt:self.endAt];
+                                  endAt:self.endAt
+                             projection:_projection];
 }
 
 - (instancetype)queryByAddingEndAt:(FSTBound *)bound {
+  HARD_ASSERT(![self isDocumentKeysQuery], "No bounds are allowed for a set of documents.");
+
+  return [[FSTQuery alloc] initWithPath:self.path
+                        collectionGroup:self.collectionGroup
+                               filterBy:self.filters
+                                orderBy:self.explicitSortOrders
+                                  limit:self.limit
+                                startAt:self.startAt
+                                  endAt:bound
+                             projection:_projection];
+}
+
+- (instancetype)queryBySettingProjection:(std::vector<FieldPath>)fields {
+  HARD_ASSERT(![self isDocumentKeysQuery], "No projection is allowed for a set of documents.");
+
   return [[FSTQuery alloc] initWithPath:self.path
                         collectionGroup:self.collectionGroup
                                filterBy:self.filters
                                 orderBy:self.explicitSortOrders
                                   limit:self.limit
                                 startAt:self.startAt
-                                  endAt:bound];
+                                  endAt:self.endAt
+                             projection:std::move(fields)];
 }
 
 - (instancetype)collectionQueryAtPath:(firebase::firestore::model::ResourcePath)path {
@@ -724,37 +839,58 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
                                 orderBy:self.explicitSortOrders
                                   limit:self.limit
                                 startAt:self.startAt
-                                  endAt:self.endAt];
+                                  endAt:self.endAt
+                             projection:_projection];
 }
 
 - (BOOL)isDocumentQuery {
-  return DocumentKey::IsDocumentKey(_path) && !self.collectionGroup && self.filters.count == 0;
+  return DocumentKey::IsDocumentKey(_path) && !self.collectionGroup && self.filters.count == 0 &&
+         _documentKeys.empty();
+}
+
+- (BOOL)isDocumentKeysQuery {
+  return !_documentKeys.empty();
 }
 
 - (BOOL)isCollectionGroupQuery {
   return self.collectionGroup != nil;
 }
 
+- (BOOL)isContainedInQuery:(FSTQuery *)query {
+  // NSNotFound is NSIntegerMax, so an unlimited query contains all others.
+  if (self.limit > query.limit) {
+    return NO;
+  }
+  return self.limit == query.limit ? [self isEqual:query]
+                                   : [[self queryBySettingLimit:query.limit] isEqual:query];
+}
+
 - (BOOL)matchesDocument:(FSTDocument *)document {
   return [self pathAndCollectionGroupMatchDocument:document] &&
          [self orderByMatchesDocument:document] && [self filtersMatchDocument:document] &&
          [self boundsMatchDocument:document];
 }
 
-- (DocumentComparator)comparator {
+- (const DocumentComparator &)comparator {
+  if (_comparator) {
+    return *_comparator;
+  }
+
   NSArray<FSTSortOrder *> *sortOrders = self.sortOrders;
+  BOOL hasKeyOrder = NO;
+  for (FSTSortOrder *orderBy in sortOrders) {
+    hasKeyOrder = hasKeyOrder || orderBy.isKeyOrder;
+  }
+  HARD_ASSERT(hasKeyOrder, "sortOrder of query did not include key ordering");
 
-  return DocumentComparator([sortOrders](id document1, id document2) {
-    bool didCompareOnKeyField = false;
+  _comparator = DocumentComparator([sortOrders](id document1, id document2) {
     for (FSTSortOrder *orderBy in sortOrders) {
       ComparisonResult comp = [orderBy compareDocument:document1 toDocument:document2];
       if (!util::Same(comp)) return comp;
-
-      didCompareOnKeyField = didCompareOnKeyField || orderBy.field == FieldPath::KeyFieldPath();
     }
-    HARD_ASSERT(didCompareOnKeyField, "sortOrder of query did not include key ordering");
     return ComparisonResult::Same;
   });
+  return *_comparator;
 }
 
 - (nullable const FieldPath *)inequalityFilterField {
@@ -789,6 +925,18 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
   return _path;
 }
 
+- (const std::vector<FieldPath> &)projection {
+  return _projection;
+}
+
+- (BOOL)hasProjection {
+  return !_projection.empty();
+}
+
+- (const DocumentKeySet &)documentKeys {
+  return _documentKeys;
+}
+
 #pragma mark - Private properties
 
 - (NSString *)canonicalID {
@@ -803,6 +951,13 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
     [canonicalID appendFormat:@"|cg:%@", self.collectionGroup];
   }
 
+  if (!_documentKeys.empty()) {
+    [canonicalID appendString:@"|k:"];
+    for (const DocumentKey &key : _documentKeys) {
+      [canonicalID appendFormat:@"%s,", key.ToString().c_str()];
+    }
+  }
+
   // Add filters.
   [canonicalID appendString:@"|f:"];
   for (FSTFilter *predicate in self.filters) {
@@ -828,6 +983,14 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
     [canonicalID appendFormat:@"|ub:%@", self.endAt.canonicalString];
   }
 
+  // Add projection.
+  if (!_projection.empty()) {
+    [canonicalID appendString:@"|s:"];
+    for (const FieldPath &field : _projection) {
+      [canonicalID appendFormat:@"%s,", field.CanonicalString().c_str()];
+    }
+  }
+
   _canonicalID = canonicalID;
   return canonicalID;
 }
@@ -841,13 +1004,38 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
          self.limit == other.limit && [self.filters isEqual:other.filters] &&
          [self.sortOrders isEqual:other.sortOrders] &&
          (self.startAt == other.startAt || [self.startAt isEqual:other.startAt]) &&
-         (self.endAt == other.endAt || [self.endAt isEqual:other.endAt]);
+         (self.endAt == other.endAt || [self.endAt isEqual:other.endAt]) &&
+         _projection == other.projection && _documentKeys == other.documentKeys;
+}
+
+/**
+ * Adds the fields of the filters and sort orders to a non-empty projection and sorts it, so that
+ * the partial documents the backend returns can still be matched and ordered locally.
+ */
+- (void)normalizeProjection {
+  if (_projection.empty()) {
+    return;
+  }
+  for (FSTFilter *filter in _filters) {
+    _projection.push_back(filter.field);
+  }
+  for (FSTSortOrder *sortOrder in _explicitSortOrders) {
+    _projection.push_back(sortOrder.field);
+  }
+  // Every document has a key; selecting it is implied.
+  _projection.erase(std::remove_if(_projection.begin(), _projection.end(),
+                                   [](const FieldPath &field) { return field.IsKeyFieldPath(); }),
+                    _projection.end());
+  std::sort(_projection.begin(), _projection.end());
+  _projection.erase(std::unique(_projection.begin(), _projection.end()), _projection.end());
 }
 
 /* Returns YES if the document matches the path and collection group for the receiver. */
 - (BOOL)pathAndCollectionGroupMatchDocument:(FSTDocument *)document {
   const ResourcePath &documentPath = document.key.path();
-  if (self.collectionGroup) {
+  if (!_documentKeys.empty()) {
+    return _documentKeys.contains(document.key);
+  } else if (self.collectionGroup) {
     // NOTE: self.path is currently always empty since we don't expose Collection Group queries
     // rooted at a document path yet.
     return document.key.HasCollectionId(util::MakeString(self.collectionGroup)) &&
@@ -866,9 +1054,8 @@ NSString *FSTStringFromQueryRelationOperator(Filter::Operator filterOperator) {
  */
 - (BOOL)orderByMatchesDocument:(FSTDocument *)document {
   for (FSTSortOrder *orderBy in self.explicitSortOrders) {
-    const FieldPath &fieldPath = orderBy.field;
     // order by key always matches
-    if (fieldPath != FieldPath::KeyFieldPath() && [document fieldForPath:fieldPath] == nil) {
+    if (!orderBy.isKeyOrder && [document fieldForPath:orderBy.field] == nil) {
       return NO;
     }
   }
@@ -21,6 +21,7 @@
 #import "Firestore/Source/Core/FSTTypes.h"
 
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/document_sizer.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_store.h"
@@ -28,8 +29,10 @@
 #include "Firestore/core/src/firebase/firestore/util/statusor_callback.h"
 
 @class FSTLocalStore;
+@class FSTMaybeDocument;
 @class FSTMutation;
 @class FSTQuery;
+@class FSTQueryData;
 
 namespace auth = firebase::firestore::auth;
 namespace core = firebase::firestore::core;
@@ -70,7 +73,17 @@ NS_ASSUME_NONNULL_BEGIN
 - (instancetype)init NS_UNAVAILABLE;
 - (instancetype)initWithLocalStore:(FSTLocalStore *)localStore
                        remoteStore:(remote::RemoteStore *)remoteStore
-                       initialUser:(const auth::User &)user NS_DESIGNATED_INITIALIZER;
+                       initialUser:(const auth::User &)user;
+
+/**
+ * Initializes the sync engine with a custom limit on the number of limbo documents that are
+ * resolved at the same time. Used by the spec tests to exercise the queue of limbo resolutions.
+ */
+- (instancetype)initWithLocalStore:(FSTLocalStore *)localStore
+                       remoteStore:(remote::RemoteStore *)remoteStore
+                       initialUser:(const auth::User &)user
+     maxConcurrentLimboResolutions:(size_t)maxConcurrentLimboResolutions
+    NS_DESIGNATED_INITIALIZER;
 
 /**
  * A delegate to be notified when queries being listened to produce new view snapshots or errors.
@@ -89,6 +102,13 @@ NS_ASSUME_NONNULL_BEGIN
 /** Stops listening to a query previously listened to via listenToQuery:. */
 - (void)stopListeningToQuery:(FSTQuery *)query;
 
+/**
+ * Re-runs against the FSTLocalStore the queries whose views listenToQuery: initialized from a warm
+ * snapshot, and notifies the FSTSyncEngineDelegate of the resulting view snapshots. Until this is
+ * called, such views may miss documents and local mutations.
+ */
+- (void)reconcileWarmStartedQueries;
+
 /**
  * Initiates the write of local mutation batch which involves adding the writes to the mutation
  * queue, notifying the remote store about new mutations, and raising events for any changes this
@@ -98,6 +118,14 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)writeMutations:(std::vector<FSTMutation *> &&)mutations
             completion:(FSTVoidErrorBlock)completion;
 
+/**
+ * Writes the documents of a bundle into the local store (see
+ * -[FSTLocalStore loadBundleDocuments:queryData:]) and raises events for the active queries whose
+ * results they change.
+ */
+- (void)loadBundleDocuments:(const std::vector<FSTMaybeDocument *> &)documents
+                  queryData:(FSTQueryData *)queryData;
+
 /**
  * Runs the given transaction block up to retries times and then calls completion.
  *
@@ -116,6 +144,13 @@ NS_ASSUME_NONNULL_BEGIN
 /** Applies an OnlineState change to the sync engine and notifies any views of the change. */
 - (void)applyChangedOnlineState:(model::OnlineState)onlineState;
 
+/**
+ * Returns the estimated size of the documents held by the views of all active queries, using
+ * `sizer` to estimate the size of a document. Documents shared by several views are counted once
+ * per view.
+ */
+- (size_t)viewByteSizeWithDocumentSizer:(const core::DocumentSizer &)sizer;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -16,10 +16,13 @@
 
 #import "Firestore/Source/Core/FSTSyncEngine.h"
 
+#include <algorithm>
+#include <deque>
 #include <map>
 #include <memory>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -42,28 +45,33 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/trace_span.h"
 #include "absl/types/optional.h"
 
 using firebase::firestore::FirestoreErrorCode;
 using firebase::firestore::auth::HashUser;
 using firebase::firestore::auth::User;
+using firebase::firestore::core::DocumentSizer;
 using firebase::firestore::core::TargetIdGenerator;
 using firebase::firestore::core::Transaction;
 using firebase::firestore::core::ViewSnapshot;
 using firebase::firestore::local::ReferenceSet;
 using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentKeyHash;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
 using firebase::firestore::model::MaybeDocumentMap;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::OnlineState;
+using firebase::firestore::model::ResourcePath;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
 using firebase::firestore::remote::RemoteEvent;
@@ -72,6 +80,7 @@ using firebase::firestore::remote::TargetChange;
 using firebase::firestore::util::AsyncQueue;
 using firebase::firestore::util::MakeNSError;
 using firebase::firestore::util::Status;
+using firebase::firestore::util::TraceSpan;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -79,6 +88,41 @@ NS_ASSUME_NONNULL_BEGIN
 // real sequence numbers.
 static const ListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
+/**
+ * The maximum number of limbo documents that are resolved at the same time. Each resolution is a
+ * target of its own on the watch stream, so after a long time offline resolving all limbo
+ * documents at once could flood the stream with hundreds of targets and hold back the snapshots of
+ * the actual queries. The remaining documents wait in line until a resolution finishes.
+ */
+static const size_t kMaxConcurrentLimboResolutions = 100;
+
+/**
+ * The number of active queries from which on the views compute their changes in parallel. Below
+ * that, dispatching the work to other threads costs more than it saves.
+ */
+static const size_t kMinQueryViewsForParallelRecomputation = 4;
+
+/**
+ * Returns the part of `changes` that could affect the results of `query`, given the same changes
+ * grouped by the path of their collection. A document in any other collection can neither match
+ * the query nor have matched it before.
+ */
+static const MaybeDocumentMap &ChangesForQuery(
+    FSTQuery *query,
+    const MaybeDocumentMap &changes,
+    const std::map<ResourcePath, MaybeDocumentMap> &changesByCollection) {
+  static const MaybeDocumentMap *const kNoChanges = new MaybeDocumentMap();
+
+  // Collection group queries span collections, and queries for a set of keys may too.
+  if (changesByCollection.empty() || query.collectionGroup || !query.documentKeys.empty()) {
+    return changes;
+  }
+
+  const ResourcePath &path = query.path;
+  auto found = changesByCollection.find([query isDocumentQuery] ? path.PopLast() : path);
+  return found != changesByCollection.end() ? found->second : *kNoChanges;
+}
+
 #pragma mark - FSTQueryView
 
 /**
@@ -100,6 +144,13 @@ static const ListenSequenceNumber kIrrelevantSequenceNumber = -1;
 /** The targetID created by the client that is used in the watch stream to identify this query. */
 @property(nonatomic, assign, readonly) TargetId targetID;
 
+/**
+ * The target whose watch changes keep the view in sync with the server. This is usually targetID,
+ * but a query whose results are contained in those of another active query shares that query's
+ * target instead of listening to one of its own.
+ */
+@property(nonatomic, assign) TargetId sourceTargetID;
+
 /**
  * An identifier from the datastore backend that indicates the last state of the results that
  * was received. This can be used to indicate where to continue receiving new doc changes for the
@@ -125,6 +176,7 @@ static const ListenSequenceNumber kIrrelevantSequenceNumber = -1;
   if (self = [super init]) {
     _query = query;
     _targetID = targetID;
+    _sourceTargetID = targetID;
     _resumeToken = resumeToken;
     _view = view;
   }
@@ -181,6 +233,15 @@ class LimboResolution {
   /** FSTQueryViews for all active queries, indexed by target ID. */
   std::unordered_map<TargetId, FSTQueryView *> _queryViewsByTarget;
 
+  /** The query data of the active queries that share another query's target, by target ID. */
+  std::unordered_map<TargetId, FSTQueryData *> _derivedQueryDataByTarget;
+
+  /**
+   * The keys of the documents that the views of active queries were initialized with from a warm
+   * snapshot, by target ID, until the views are reconciled with the local store.
+   */
+  std::unordered_map<TargetId, DocumentKeySet> _warmStartedKeysByTarget;
+
   /**
    * When a document is in limbo, we create a special listen to resolve it. This maps the
    * DocumentKey of each limbo document to the TargetId of the listen resolving it.
@@ -193,6 +254,19 @@ class LimboResolution {
    */
   std::map<TargetId, LimboResolution> _limboResolutionsByTarget;
 
+  /**
+   * The keys of the limbo documents waiting for a resolution to start, in the order they entered
+   * limbo. See kMaxConcurrentLimboResolutions.
+   *
+   * Keys that left limbo before their resolution started stay in the deque until they reach the
+   * front (or the deque is compacted); _enqueuedLimboKeys is the authoritative set of keys that
+   * are still waiting.
+   */
+  std::deque<DocumentKey> _enqueuedLimboResolutions;
+  std::unordered_set<DocumentKey, DocumentKeyHash> _enqueuedLimboKeys;
+
+  size_t _maxConcurrentLimboResolutions;
+
   User _currentUser;
 
   /** Used to track any documents that are currently in limbo. */
@@ -202,6 +276,16 @@ class LimboResolution {
 - (instancetype)initWithLocalStore:(FSTLocalStore *)localStore
                        remoteStore:(RemoteStore *)remoteStore
                        initialUser:(const User &)initialUser {
+  return [self initWithLocalStore:localStore
+                          remoteStore:remoteStore
+                          initialUser:initialUser
+        maxConcurrentLimboResolutions:kMaxConcurrentLimboResolutions];
+}
+
+- (instancetype)initWithLocalStore:(FSTLocalStore *)localStore
+                       remoteStore:(RemoteStore *)remoteStore
+                       initialUser:(const User &)initialUser
+     maxConcurrentLimboResolutions:(size_t)maxConcurrentLimboResolutions {
   if (self = [super init]) {
     _localStore = localStore;
     _remoteStore = remoteStore;
@@ -210,6 +294,7 @@ class LimboResolution {
 
     _targetIdGenerator = TargetIdGenerator::SyncEngineTargetIdGenerator();
     _currentUser = initialUser;
+    _maxConcurrentLimboResolutions = maxConcurrentLimboResolutions;
   }
   return self;
 }
@@ -219,28 +304,121 @@ class LimboResolution {
   HARD_ASSERT(self.queryViewsByQuery[query] == nil, "We already listen to query: %s", query);
 
   FSTQueryData *queryData = [self.localStore allocateQuery:query];
-  ViewSnapshot viewSnapshot = [self initializeViewAndComputeSnapshotForQueryData:queryData];
+  FSTQueryView *sourceView = [self sourceQueryViewForQuery:query];
+  ViewSnapshot viewSnapshot = [self initializeViewAndComputeSnapshotForQueryData:queryData
+                                                                      sourceView:sourceView];
   [self.syncEngineDelegate handleViewSnapshots:{viewSnapshot}];
 
-  _remoteStore->Listen(queryData);
+  if (sourceView) {
+    // The results are derived locally from those of the containing query, so there's no need for
+    // another target on the server.
+    _derivedQueryDataByTarget[queryData.targetID] = queryData;
+  } else {
+    _remoteStore->Listen(queryData);
+  }
   return queryData.targetID;
 }
 
-- (ViewSnapshot)initializeViewAndComputeSnapshotForQueryData:(FSTQueryData *)queryData {
-  DocumentMap docs = [self.localStore executeQuery:queryData.query];
+/**
+ * Returns the view of an active query with a target of its own whose results contain all results
+ * of the given query, or nil if there is none.
+ */
+- (nullable FSTQueryView *)sourceQueryViewForQuery:(FSTQuery *)query {
+  // The partial documents of a projection query are only kept for its own target, so it can't
+  // derive its results from another one.
+  if ([query hasProjection]) {
+    return nil;
+  }
+  for (FSTQuery *activeQuery in self.queryViewsByQuery) {
+    FSTQueryView *queryView = self.queryViewsByQuery[activeQuery];
+    if (queryView.sourceTargetID == queryView.targetID && [query isContainedInQuery:activeQuery]) {
+      return queryView;
+    }
+  }
+  return nil;
+}
+
+/**
+ * Returns the views of the active queries that share the given target, widest queries first so
+ * that, when they need a new target, narrower ones can share the target of a wider one.
+ */
+- (NSArray<FSTQueryView *> *)queryViewsDerivedFromTarget:(TargetId)targetID {
+  NSMutableArray<FSTQueryView *> *derivedViews = [NSMutableArray array];
+  for (FSTQueryView *queryView in [self.queryViewsByQuery objectEnumerator]) {
+    if (queryView.sourceTargetID == targetID && queryView.targetID != targetID) {
+      [derivedViews addObject:queryView];
+    }
+  }
+  [derivedViews sortUsingComparator:^NSComparisonResult(FSTQueryView *lhs, FSTQueryView *rhs) {
+    // NSNotFound (no limit) is the largest limit.
+    if (lhs.query.limit == rhs.query.limit) {
+      return NSOrderedSame;
+    }
+    return lhs.query.limit > rhs.query.limit ? NSOrderedAscending : NSOrderedDescending;
+  }];
+  return derivedViews;
+}
+
+/**
+ * Returns a target change that replaces the synced documents of `view` with `remoteDocuments`, as
+ * if they came from the target that now keeps the view in sync.
+ */
+- (TargetChange)targetChangeForView:(FSTView *)view
+                  resettingToRemoteDocuments:(const DocumentKeySet &)remoteDocuments
+                                     current:(BOOL)current {
+  return TargetChange{[NSData data], static_cast<bool>(current), remoteDocuments, DocumentKeySet{},
+                      view.syncedDocuments.difference_with(remoteDocuments)};
+}
+
+- (ViewSnapshot)initializeViewAndComputeSnapshotForQueryData:(FSTQueryData *)queryData
+                                                  sourceView:(nullable FSTQueryView *)sourceView {
+  // A view with a source view is derived from results that are already in memory, which is faster
+  // than reading a warm snapshot.
+  absl::optional<DocumentMap> warmDocs;
+  if (!sourceView && ![queryData.query hasProjection]) {
+    warmDocs = [self.localStore warmSnapshotForTarget:queryData.targetID];
+  }
+
+  DocumentMap docs;
+  if (warmDocs.has_value()) {
+    docs = std::move(warmDocs).value();
+    DocumentKeySet warmKeys;
+    for (const auto &kv : docs.underlying_map()) {
+      warmKeys = std::move(warmKeys).insert(kv.first);
+    }
+    _warmStartedKeysByTarget[queryData.targetID] = std::move(warmKeys);
+  } else {
+    docs = [self.localStore executeQuery:queryData.query];
+  }
+
   DocumentKeySet remoteKeys = [self.localStore remoteDocumentKeysForTarget:queryData.targetID];
 
   FSTView *view = [[FSTView alloc] initWithQuery:queryData.query
                                  remoteDocuments:std::move(remoteKeys)];
   FSTViewDocumentChanges *viewDocChanges = [view computeChangesWithDocuments:docs.underlying_map()];
-  FSTViewChange *viewChange = [view applyChangesToDocuments:viewDocChanges];
-  HARD_ASSERT(viewChange.limboChanges.count == 0,
-              "View returned limbo docs before target ack from the server.");
+  FSTViewChange *viewChange;
+  if (sourceView) {
+    // Start out exactly as in sync with the server as the query whose target this one shares.
+    TargetChange targetChange =
+        [self targetChangeForView:view
+            resettingToRemoteDocuments:sourceView.view.syncedDocuments
+                               current:sourceView.view.isCurrent];
+    viewChange = [view applyChangesToDocuments:viewDocChanges targetChange:targetChange];
+    [self updateTrackedLimboDocumentsWithChanges:viewChange.limboChanges
+                                        targetID:queryData.targetID];
+  } else {
+    viewChange = [view applyChangesToDocuments:viewDocChanges];
+    HARD_ASSERT(viewChange.limboChanges.count == 0,
+                "View returned limbo docs before target ack from the server.");
+  }
 
   FSTQueryView *queryView = [[FSTQueryView alloc] initWithQuery:queryData.query
                                                        targetID:queryData.targetID
                                                     resumeToken:queryData.resumeToken
                                                            view:view];
+  if (sourceView) {
+    queryView.sourceTargetID = sourceView.targetID;
+  }
   self.queryViewsByQuery[queryData.query] = queryView;
   _queryViewsByTarget[queryData.targetID] = queryView;
 
@@ -249,6 +427,41 @@ class LimboResolution {
   return viewChange.snapshot.value();
 }
 
+- (void)reconcileWarmStartedQueries {
+  std::unordered_map<TargetId, DocumentKeySet> warmStartedKeysByTarget;
+  std::swap(warmStartedKeysByTarget, _warmStartedKeysByTarget);
+
+  std::vector<ViewSnapshot> newSnapshots;
+  for (const auto &entry : warmStartedKeysByTarget) {
+    auto found = _queryViewsByTarget.find(entry.first);
+    if (found == _queryViewsByTarget.end()) {
+      // The query was stopped before it could be reconciled.
+      continue;
+    }
+    FSTQueryView *queryView = found->second;
+
+    // Documents of the warm snapshot that no longer match must be removed from the view.
+    MaybeDocumentMap docs = [self.localStore executeQuery:queryView.query].underlying_map();
+    for (const DocumentKey &key : entry.second) {
+      if (docs.find(key) == docs.end()) {
+        docs = docs.insert(key, [FSTDeletedDocument documentWithKey:key
+                                                            version:SnapshotVersion::None()
+                                              hasCommittedMutations:false]);
+      }
+    }
+
+    FSTViewDocumentChanges *viewDocChanges = [queryView.view computeChangesWithDocuments:docs];
+    FSTViewChange *viewChange = [queryView.view applyChangesToDocuments:viewDocChanges];
+    [self updateTrackedLimboDocumentsWithChanges:viewChange.limboChanges
+                                        targetID:queryView.targetID];
+    if (viewChange.snapshot.has_value()) {
+      newSnapshots.push_back(viewChange.snapshot.value());
+    }
+  }
+
+  [self.syncEngineDelegate handleViewSnapshots:std::move(newSnapshots)];
+}
+
 - (void)stopListeningToQuery:(FSTQuery *)query {
   [self assertDelegateExistsForSelector:_cmd];
 
@@ -256,21 +469,88 @@ class LimboResolution {
   HARD_ASSERT(queryView, "Trying to stop listening to a query not found");
 
   [self.localStore releaseQuery:query];
-  _remoteStore->StopListening(queryView.targetID);
-  [self removeAndCleanupQuery:queryView];
+  if (queryView.sourceTargetID == queryView.targetID) {
+    _remoteStore->StopListening(queryView.targetID);
+    [self removeAndCleanupQuery:queryView];
+    [self reassignQueriesDerivedFromTarget:queryView.targetID];
+  } else {
+    [self removeAndCleanupQuery:queryView];
+  }
+}
+
+/**
+ * Keeps the queries that shared a target which is no longer listened to in sync, either through
+ * another active query that contains them or through a target of their own.
+ */
+- (void)reassignQueriesDerivedFromTarget:(TargetId)targetID {
+  std::vector<ViewSnapshot> newSnapshots;
+  for (FSTQueryView *queryView in [self queryViewsDerivedFromTarget:targetID]) {
+    FSTView *view = queryView.view;
+    TargetChange targetChange;
+    FSTQueryView *sourceView = [self sourceQueryViewForQuery:queryView.query];
+    if (sourceView) {
+      queryView.sourceTargetID = sourceView.targetID;
+      targetChange = [self targetChangeForView:view
+                    resettingToRemoteDocuments:sourceView.view.syncedDocuments
+                                       current:sourceView.view.isCurrent];
+    } else {
+      auto found = _derivedQueryDataByTarget.find(queryView.targetID);
+      HARD_ASSERT(found != _derivedQueryDataByTarget.end(), "Unknown derived targetId: %s",
+                  queryView.targetID);
+      FSTQueryData *queryData = found->second;
+      _derivedQueryDataByTarget.erase(found);
+
+      // Until its own target is current, the view only knows what's in the local cache.
+      queryView.sourceTargetID = queryView.targetID;
+      targetChange =
+          [self targetChangeForView:view
+              resettingToRemoteDocuments:[self.localStore
+                                             remoteDocumentKeysForTarget:queryView.targetID]
+                                 current:NO];
+      _remoteStore->Listen(queryData);
+    }
+
+    FSTViewChange *viewChange =
+        [view applyChangesToDocuments:[view computeChangesWithDocuments:MaybeDocumentMap{}]
+                         targetChange:targetChange];
+    [self updateTrackedLimboDocumentsWithChanges:viewChange.limboChanges
+                                        targetID:queryView.targetID];
+    if (viewChange.snapshot.has_value()) {
+      newSnapshots.push_back(std::move(viewChange.snapshot.value()));
+    }
+  }
+  [self.syncEngineDelegate handleViewSnapshots:std::move(newSnapshots)];
 }
 
 - (void)writeMutations:(std::vector<FSTMutation *> &&)mutations
             completion:(FSTVoidErrorBlock)completion {
   [self assertDelegateExistsForSelector:_cmd];
 
+  TraceSpan writeSpan{"Writing mutation batch locally"};
   FSTLocalWriteResult *result = [self.localStore locallyWriteMutations:std::move(mutations)];
+  writeSpan.set_correlation_id(result.batchID);
+  writeSpan.End();
+  // Batches the write made redundant complete along with it, before its own completion.
+  for (BatchId compactedBatchID : result.compactedBatchIDs) {
+    [self moveMutationCompletionBlockFromBatchID:compactedBatchID toBatchID:result.batchID];
+  }
   [self addMutationCompletionBlock:completion batchID:result.batchID];
 
-  [self emitNewSnapshotsAndNotifyLocalStoreWithChanges:result.changes remoteEvent:absl::nullopt];
+  {
+    TraceSpan viewSpan{"Raising snapshots of local write", result.batchID};
+    [self emitNewSnapshotsAndNotifyLocalStoreWithChanges:result.changes remoteEvent:absl::nullopt];
+  }
   _remoteStore->FillWritePipeline();
 }
 
+- (void)loadBundleDocuments:(const std::vector<FSTMaybeDocument *> &)documents
+                  queryData:(FSTQueryData *)queryData {
+  [self assertDelegateExistsForSelector:_cmd];
+
+  MaybeDocumentMap changes = [self.localStore loadBundleDocuments:documents queryData:queryData];
+  [self emitNewSnapshotsAndNotifyLocalStoreWithChanges:changes remoteEvent:absl::nullopt];
+}
+
 - (void)addMutationCompletionBlock:(FSTVoidErrorBlock)completion batchID:(BatchId)batchID {
   NSMutableDictionary<NSNumber *, FSTVoidErrorBlock> *completionBlocks =
       _mutationCompletionBlocks[_currentUser];
@@ -278,9 +558,29 @@ class LimboResolution {
     completionBlocks = [NSMutableDictionary dictionary];
     _mutationCompletionBlocks[_currentUser] = completionBlocks;
   }
+  // A write may have been folded into a batch that already has a completion block, in which case
+  // both complete together.
+  FSTVoidErrorBlock existing = completionBlocks[@(batchID)];
+  if (existing) {
+    FSTVoidErrorBlock newCompletion = completion;
+    completion = ^(NSError *_Nullable error) {
+      existing(error);
+      newCompletion(error);
+    };
+  }
   [completionBlocks setObject:completion forKey:@(batchID)];
 }
 
+- (void)moveMutationCompletionBlockFromBatchID:(BatchId)fromBatchID toBatchID:(BatchId)toBatchID {
+  NSMutableDictionary<NSNumber *, FSTVoidErrorBlock> *completionBlocks =
+      _mutationCompletionBlocks[_currentUser];
+  FSTVoidErrorBlock completion = completionBlocks[@(fromBatchID)];
+  if (completion) {
+    [completionBlocks removeObjectForKey:@(fromBatchID)];
+    [self addMutationCompletionBlock:completion batchID:toBatchID];
+  }
+}
+
 /**
  * Takes an updateCallback in which a set of reads and writes can be performed atomically. In the
  * updateCallback, user code can read and write values using a transaction object. After the
@@ -297,10 +597,28 @@ class LimboResolution {
                    workerQueue:(AsyncQueue *)workerQueue
                 updateCallback:(core::TransactionUpdateCallback)updateCallback
                 resultCallback:(core::TransactionResultCallback)resultCallback {
+  [self transactionWithRetries:retries
+                   workerQueue:workerQueue
+                  prefetchKeys:std::vector<DocumentKey>{}
+                updateCallback:std::move(updateCallback)
+                resultCallback:std::move(resultCallback)];
+}
+
+/**
+ * Runs a transaction attempt, having it prefetch the given documents, which the previous attempt
+ * read: a retry usually reads the same documents, and fetching them all up front saves the round
+ * trips of reading them one at a time.
+ */
+- (void)transactionWithRetries:(int)retries
+                   workerQueue:(AsyncQueue *)workerQueue
+                  prefetchKeys:(const std::vector<DocumentKey> &)prefetchKeys
+                updateCallback:(core::TransactionUpdateCallback)updateCallback
+                resultCallback:(core::TransactionResultCallback)resultCallback {
   workerQueue->VerifyIsCurrentQueue();
   HARD_ASSERT(retries >= 0, "Got negative number of retries for transaction");
 
   std::shared_ptr<Transaction> transaction = _remoteStore->CreateTransaction();
+  transaction->Prefetch(prefetchKeys);
   updateCallback(transaction, [=](util::StatusOr<absl::any> maybe_result) {
     workerQueue->Enqueue(
         [self, retries, workerQueue, updateCallback, resultCallback, transaction, maybe_result] {
@@ -309,8 +627,9 @@ class LimboResolution {
             return;
           }
 
+          std::vector<DocumentKey> readKeys = transaction->read_keys();
           transaction->Commit([self, retries, workerQueue, updateCallback, resultCallback,
-                               maybe_result](Status status) {
+                               maybe_result, readKeys](Status status) {
             if (status.ok()) {
               resultCallback(std::move(maybe_result));
               return;
@@ -327,6 +646,7 @@ class LimboResolution {
             workerQueue->VerifyIsCurrentQueue();
             return [self transactionWithRetries:(retries - 1)
                                     workerQueue:workerQueue
+                                   prefetchKeys:readKeys
                                  updateCallback:updateCallback
                                  resultCallback:resultCallback];
           });
@@ -386,6 +706,16 @@ class LimboResolution {
   [self.syncEngineDelegate applyChangedOnlineState:onlineState];
 }
 
+- (size_t)viewByteSizeWithDocumentSizer:(const DocumentSizer &)sizer {
+  size_t size = 0;
+  for (FSTQueryView *queryView in [self.queryViewsByQuery objectEnumerator]) {
+    for (FSTDocument *doc : queryView.view.documentSet) {
+      size += sizer(doc);
+    }
+  }
+  return size;
+}
+
 - (void)rejectListenWithTargetID:(const TargetId)targetID error:(NSError *)error {
   [self assertDelegateExistsForSelector:_cmd];
 
@@ -396,6 +726,7 @@ class LimboResolution {
     // So go ahead and remove it from bookkeeping.
     _limboTargetsByKey.erase(limboKey);
     _limboResolutionsByTarget.erase(targetID);
+    [self pumpEnqueuedLimboResolutions];
 
     // TODO(dimond): Retry on transient errors?
 
@@ -421,6 +752,14 @@ class LimboResolution {
                error.localizedDescription);
     }
     [self.syncEngineDelegate handleError:error forQuery:query];
+
+    // The queries that shared the target only differ from the failed one in their limit, so they
+    // fail the same way.
+    for (FSTQueryView *derivedView in [self queryViewsDerivedFromTarget:targetID]) {
+      [self.localStore releaseQuery:derivedView.query];
+      [self removeAndCleanupQuery:derivedView];
+      [self.syncEngineDelegate handleError:error forQuery:derivedView.query];
+    }
   }
 }
 
@@ -432,6 +771,7 @@ class LimboResolution {
   // consistently happen before listen events.
   [self processUserCallbacksForBatchID:batchResult.batch.batchID error:nil];
 
+  TraceSpan span{"Acknowledging mutation batch", batchResult.batch.batchID};
   MaybeDocumentMap changes = [self.localStore acknowledgeBatchWithResult:batchResult];
   [self emitNewSnapshotsAndNotifyLocalStoreWithChanges:changes remoteEvent:absl::nullopt];
 }
@@ -477,6 +817,8 @@ class LimboResolution {
 - (void)removeAndCleanupQuery:(FSTQueryView *)queryView {
   [self.queryViewsByQuery removeObjectForKey:queryView.query];
   _queryViewsByTarget.erase(queryView.targetID);
+  _derivedQueryDataByTarget.erase(queryView.targetID);
+  _warmStartedKeysByTarget.erase(queryView.targetID);
 
   DocumentKeySet limboKeys = _limboDocumentRefs.ReferencedKeys(queryView.targetID);
   _limboDocumentRefs.RemoveReferences(queryView.targetID);
@@ -494,49 +836,135 @@ class LimboResolution {
 - (void)emitNewSnapshotsAndNotifyLocalStoreWithChanges:(const MaybeDocumentMap &)changes
                                            remoteEvent:(const absl::optional<RemoteEvent> &)
                                                            maybeRemoteEvent {
-  __block std::vector<ViewSnapshot> newSnapshots;
+  std::vector<ViewSnapshot> newSnapshots;
   NSMutableArray<FSTLocalViewChanges *> *documentChangesInAllViews = [NSMutableArray array];
 
-  [self.queryViewsByQuery
-      enumerateKeysAndObjectsUsingBlock:^(FSTQuery *query, FSTQueryView *queryView, BOOL *stop) {
-        FSTView *view = queryView.view;
-        FSTViewDocumentChanges *viewDocChanges = [view computeChangesWithDocuments:changes];
-        if (viewDocChanges.needsRefill) {
-          // The query has a limit and some docs were removed/updated, so we need to re-run the
-          // query against the local store to make sure we didn't lose any good docs that had been
-          // past the limit.
-          DocumentMap docs = [self.localStore executeQuery:queryView.query];
-          viewDocChanges = [view computeChangesWithDocuments:docs.underlying_map()
-                                             previousChanges:viewDocChanges];
-        }
+  NSArray<FSTQueryView *> *queryViews = [self.queryViewsByQuery allValues];
+  size_t count = queryViews.count;
+
+  // Most changes only concern a few of the active queries. Rather than have every view sift
+  // through all of them, group the changes by collection once so that each view only looks at the
+  // documents that could possibly match its query.
+  std::map<ResourcePath, MaybeDocumentMap> changesByCollection;
+  if (count > 1) {
+    for (const auto &kv : changes) {
+      MaybeDocumentMap &collectionChanges = changesByCollection[kv.first.path().PopLast()];
+      collectionChanges = std::move(collectionChanges).insert(kv.first, kv.second);
+    }
+  }
 
-        absl::optional<TargetChange> targetChange;
-        if (maybeRemoteEvent.has_value()) {
-          const RemoteEvent &remoteEvent = maybeRemoteEvent.value();
-          auto it = remoteEvent.target_changes().find(queryView.targetID);
-          if (it != remoteEvent.target_changes().end()) {
-            targetChange = it->second;
-          }
-        }
-        FSTViewChange *viewChange = [queryView.view applyChangesToDocuments:viewDocChanges
-                                                               targetChange:targetChange];
+  // Computing the changes of a view only reads the view and the changed documents, neither of which
+  // changes meanwhile, so the views compute their changes concurrently. Everything else touches
+  // shared state (the local store, limbo tracking) and happens afterwards, in order.
+  std::vector<FSTViewDocumentChanges *> allViewDocChanges(count);
+  FSTViewDocumentChanges *__strong *results = allViewDocChanges.data();
+  const MaybeDocumentMap *allChanges = &changes;
+  const std::map<ResourcePath, MaybeDocumentMap> *routedChanges = &changesByCollection;
+  const absl::optional<RemoteEvent> *optionalRemoteEvent = &maybeRemoteEvent;
+  void (^computeChanges)(size_t) = ^(size_t i) {
+    FSTQueryView *queryView = queryViews[i];
+    if ([queryView.query hasProjection]) {
+      MaybeDocumentMap projectedChanges = [self projectedChangesForTarget:queryView.targetID
+                                                              remoteEvent:*optionalRemoteEvent];
+      results[i] = [queryView.view computeChangesWithDocuments:projectedChanges];
+    } else {
+      results[i] = [queryView.view
+          computeChangesWithDocuments:ChangesForQuery(queryView.query, *allChanges,
+                                                      *routedChanges)];
+    }
+  };
+  if (count >= kMinQueryViewsForParallelRecomputation) {
+    dispatch_apply(count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), computeChanges);
+  } else {
+    for (size_t i = 0; i < count; ++i) {
+      computeChanges(i);
+    }
+  }
 
-        [self updateTrackedLimboDocumentsWithChanges:viewChange.limboChanges
-                                            targetID:queryView.targetID];
+  for (size_t i = 0; i < count; ++i) {
+    FSTQueryView *queryView = queryViews[i];
+    FSTQuery *query = queryView.query;
+    FSTView *view = queryView.view;
+    FSTViewDocumentChanges *viewDocChanges = allViewDocChanges[i];
+    if (viewDocChanges.needsRefill) {
+      // The query has a limit and some docs were removed/updated. The view can usually refill
+      // itself from the docs it keeps past the limit; if not, we need to re-run the query
+      // against the local store to make sure we didn't lose any good docs that had been past
+      // the limit.
+      FSTViewDocumentChanges *refilled = [view refillChangesFromOverflow:viewDocChanges];
+      if (refilled) {
+        viewDocChanges = refilled;
+      } else {
+        DocumentMap docs = [self.localStore executeQuery:queryView.query];
+        viewDocChanges = [view computeChangesWithDocuments:docs.underlying_map()
+                                           previousChanges:viewDocChanges];
+      }
+    }
 
-        if (viewChange.snapshot.has_value()) {
-          newSnapshots.push_back(viewChange.snapshot.value());
-          FSTLocalViewChanges *docChanges =
-              [FSTLocalViewChanges changesForViewSnapshot:viewChange.snapshot.value()
-                                             withTargetID:queryView.targetID];
-          [documentChangesInAllViews addObject:docChanges];
-        }
-      }];
+    absl::optional<TargetChange> targetChange;
+    if (maybeRemoteEvent.has_value()) {
+      const RemoteEvent &remoteEvent = maybeRemoteEvent.value();
+      auto it = remoteEvent.target_changes().find(queryView.sourceTargetID);
+      if (it != remoteEvent.target_changes().end()) {
+        targetChange = it->second;
+      }
+    }
+    FSTViewChange *viewChange = [queryView.view applyChangesToDocuments:viewDocChanges
+                                                           targetChange:targetChange];
+
+    [self updateTrackedLimboDocumentsWithChanges:viewChange.limboChanges
+                                        targetID:queryView.targetID];
+
+    if (viewChange.snapshot.has_value()) {
+      if (!viewChange.snapshot.value().from_cache() && ![query hasProjection]) {
+        [self.localStore saveWarmSnapshotOfDocumentsWithKeys:queryView.view.syncedDocuments
+                                                   forTarget:queryView.targetID];
+      }
+      newSnapshots.push_back(viewChange.snapshot.value());
+      FSTLocalViewChanges *docChanges =
+          [FSTLocalViewChanges changesForViewSnapshot:viewChange.snapshot.value()
+                                         withTargetID:queryView.targetID];
+      [documentChangesInAllViews addObject:docChanges];
+    }
+  }
 
   [self.syncEngineDelegate handleViewSnapshots:std::move(newSnapshots)];
   [self.localStore notifyLocalViewChanges:documentChangesInAllViews];
 }
 
+/**
+ * Returns the changes to the partial documents of a target whose query has a projection. Only the
+ * target itself can change them, so the changes of other targets and of local writes never apply.
+ */
+- (MaybeDocumentMap)projectedChangesForTarget:(TargetId)targetID
+                                  remoteEvent:
+                                      (const absl::optional<RemoteEvent> &)maybeRemoteEvent {
+  MaybeDocumentMap changes;
+  if (!maybeRemoteEvent.has_value()) {
+    return changes;
+  }
+  const RemoteEvent &remoteEvent = maybeRemoteEvent.value();
+
+  auto targetChange = remoteEvent.target_changes().find(targetID);
+  if (targetChange != remoteEvent.target_changes().end()) {
+    // Documents that left the target are gone from its results, whether or not they still exist.
+    const SnapshotVersion &version = remoteEvent.snapshot_version();
+    for (const DocumentKey &key : targetChange->second.removed_documents()) {
+      changes = changes.insert(key, [FSTDeletedDocument documentWithKey:key
+                                                                version:version
+                                                  hasCommittedMutations:NO]);
+    }
+  }
+
+  auto updates = remoteEvent.projected_document_updates().find(targetID);
+  if (updates != remoteEvent.projected_document_updates().end()) {
+    for (const auto &kv : updates->second) {
+      changes = changes.insert(kv.first, kv.second);
+    }
+  }
+  return changes;
+}
+
 /** Updates the limbo document state for the given targetID. */
 - (void)updateTrackedLimboDocumentsWithChanges:(NSArray<FSTLimboDocumentChange *> *)limboChanges
                                       targetID:(TargetId)targetID {
@@ -565,8 +993,25 @@ class LimboResolution {
 - (void)trackLimboChange:(FSTLimboDocumentChange *)limboChange {
   DocumentKey key{limboChange.key};
 
-  if (_limboTargetsByKey.find(key) == _limboTargetsByKey.end()) {
+  if (_limboTargetsByKey.find(key) == _limboTargetsByKey.end() &&
+      _enqueuedLimboKeys.insert(key).second) {
     LOG_DEBUG("New document in limbo: %s", key.ToString());
+    _enqueuedLimboResolutions.push_back(key);
+    [self pumpEnqueuedLimboResolutions];
+  }
+}
+
+/** Starts listens for enqueued limbo documents until _maxConcurrentLimboResolutions is reached. */
+- (void)pumpEnqueuedLimboResolutions {
+  while (!_enqueuedLimboResolutions.empty() &&
+         _limboTargetsByKey.size() < _maxConcurrentLimboResolutions) {
+    DocumentKey key = _enqueuedLimboResolutions.front();
+    _enqueuedLimboResolutions.pop_front();
+    if (_enqueuedLimboKeys.erase(key) == 0) {
+      // The document left limbo before its resolution started.
+      continue;
+    }
+
     TargetId limboTargetID = _targetIdGenerator.NextId();
     FSTQuery *query = [FSTQuery queryWithPath:key.path()];
     FSTQueryData *queryData = [[FSTQueryData alloc] initWithQuery:query
@@ -580,6 +1025,20 @@ class LimboResolution {
 }
 
 - (void)removeLimboTargetForKey:(const DocumentKey &)key {
+  if (_enqueuedLimboKeys.erase(key) > 0) {
+    // The resolution never started. The key is skipped once it reaches the front of the deque;
+    // compact the deque only when most of it is made of such skipped keys.
+    if (_enqueuedLimboResolutions.size() > 2 * _enqueuedLimboKeys.size()) {
+      _enqueuedLimboResolutions.erase(
+          std::remove_if(_enqueuedLimboResolutions.begin(), _enqueuedLimboResolutions.end(),
+                         [&](const DocumentKey &enqueuedKey) {
+                           return _enqueuedLimboKeys.find(enqueuedKey) == _enqueuedLimboKeys.end();
+                         }),
+          _enqueuedLimboResolutions.end());
+    }
+    return;
+  }
+
   const auto iter = _limboTargetsByKey.find(key);
   if (iter == _limboTargetsByKey.end()) {
     // This target already got removed, because the query failed.
@@ -589,6 +1048,7 @@ class LimboResolution {
   _remoteStore->StopListening(limboTargetID);
   _limboTargetsByKey.erase(key);
   _limboResolutionsByTarget.erase(limboTargetID);
+  [self pumpEnqueuedLimboResolutions];
 }
 
 // Used for testing
@@ -597,6 +1057,18 @@ class LimboResolution {
   return _limboTargetsByKey;
 }
 
+// Used for testing
+- (std::vector<DocumentKey>)enqueuedLimboDocuments {
+  std::vector<DocumentKey> result;
+  std::unordered_set<DocumentKey, DocumentKeyHash> remaining = _enqueuedLimboKeys;
+  for (const DocumentKey &key : _enqueuedLimboResolutions) {
+    if (remaining.erase(key) > 0) {
+      result.push_back(key);
+    }
+  }
+  return result;
+}
+
 - (void)credentialDidChangeWithUser:(const firebase::firestore::auth::User &)user {
   BOOL userChanged = (_currentUser != user);
   _currentUser = user;
@@ -132,6 +132,16 @@ typedef NS_ENUM(NSInteger, FSTLimboDocumentChangeType) {
                                         previousChanges:
                                             (nullable FSTViewDocumentChanges *)previousChanges;
 
+/**
+ * Refills a limit query that lost documents in `docChanges` from the documents this view keeps
+ * past its limit, rather than from the local cache. Does not make any changes to the view.
+ *
+ * @param docChanges Changes computed by this view that need a refill.
+ * @return Changes that no longer need a refill, or nil if the documents kept past the limit are not
+ *     enough to determine the new results, in which case the local cache must be re-queried.
+ */
+- (nullable FSTViewDocumentChanges *)refillChangesFromOverflow:(FSTViewDocumentChanges *)docChanges;
+
 /**
  * Updates the view with the given ViewDocumentChanges.
  *
@@ -164,6 +174,9 @@ typedef NS_ENUM(NSInteger, FSTLimboDocumentChangeType) {
  */
 - (const model::DocumentKeySet &)syncedDocuments;
 
+/** Whether the view is current with the backend, see `TargetChange::current`. */
+@property(nonatomic, assign, readonly, getter=isCurrent) BOOL current;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -16,7 +16,6 @@
 
 #import "Firestore/Source/Core/FSTView.h"
 
-#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -50,22 +49,11 @@ NS_ASSUME_NONNULL_BEGIN
 
 namespace {
 
-int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
-  switch (changeType) {
-    case DocumentViewChange::Type::kRemoved:
-      return 0;
-    case DocumentViewChange::Type::kAdded:
-      return 1;
-    case DocumentViewChange::Type::kModified:
-      return 2;
-    case DocumentViewChange::Type::kMetadata:
-      // A metadata change is converted to a modified change at the public API layer. Since we sort
-      // by document key and then change type, metadata and modified changes must be sorted
-      // equivalently.
-      return 2;
-  }
-  HARD_FAIL("Unknown DocumentViewChange::Type %s", changeType);
-}
+/**
+ * The number of documents past the limit of a limit query that a view keeps so that it can refill
+ * itself when documents leave it, without re-running the query against the local cache.
+ */
+const size_t kMaxOverflowDocuments = 10;
 
 }  // namespace
 
@@ -77,7 +65,22 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
 - (instancetype)initWithDocumentSet:(DocumentSet)documentSet
                           changeSet:(DocumentViewChangeSet &&)changeSet
                         needsRefill:(BOOL)needsRefill
-                        mutatedKeys:(DocumentKeySet)mutatedKeys NS_DESIGNATED_INITIALIZER;
+                        mutatedKeys:(DocumentKeySet)mutatedKeys
+                           overflow:(DocumentSet)overflow
+                   overflowBoundary:(nullable FSTDocument *)overflowBoundary
+    NS_DESIGNATED_INITIALIZER;
+
+/**
+ * For limit queries, the documents matching the query that sort right after the new set of docs,
+ * in order. Holds at most kMaxOverflowDocuments documents.
+ */
+- (const DocumentSet &)overflow;
+
+/**
+ * Every document matching the query that sorts at or before this document is either in
+ * `documentSet` or in `overflow`. If nil, that holds for every matching document.
+ */
+@property(nonatomic, strong, readonly, nullable) FSTDocument *overflowBoundary;
 
 @end
 
@@ -85,18 +88,23 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
   DelayedConstructor<DocumentSet> _documentSet;
   DocumentKeySet _mutatedKeys;
   DocumentViewChangeSet _changeSet;
+  DelayedConstructor<DocumentSet> _overflow;
 }
 
 - (instancetype)initWithDocumentSet:(DocumentSet)documentSet
                           changeSet:(DocumentViewChangeSet &&)changeSet
                         needsRefill:(BOOL)needsRefill
-                        mutatedKeys:(DocumentKeySet)mutatedKeys {
+                        mutatedKeys:(DocumentKeySet)mutatedKeys
+                           overflow:(DocumentSet)overflow
+                   overflowBoundary:(nullable FSTDocument *)overflowBoundary {
   self = [super init];
   if (self) {
     _documentSet.Init(std::move(documentSet));
     _changeSet = std::move(changeSet);
     _needsRefill = needsRefill;
     _mutatedKeys = std::move(mutatedKeys);
+    _overflow.Init(std::move(overflow));
+    _overflowBoundary = overflowBoundary;
   }
   return self;
 }
@@ -113,6 +121,10 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
   return _changeSet;
 }
 
+- (const DocumentSet &)overflow {
+  return *_overflow;
+}
+
 @end
 
 #pragma mark - FSTLimboDocumentChange
@@ -232,6 +244,12 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
 
   /** Document Keys that have local changes. */
   DocumentKeySet _mutatedKeys;
+
+  /** For limit queries, the matching documents that sort right after the ones in the view. */
+  DelayedConstructor<DocumentSet> _overflow;
+
+  /** See `FSTViewDocumentChanges.overflowBoundary`. */
+  FSTDocument *_Nullable _overflowBoundary;
 }
 
 - (instancetype)initWithQuery:(FSTQuery *)query remoteDocuments:(DocumentKeySet)remoteDocuments {
@@ -239,6 +257,7 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
   if (self) {
     _query = query;
     _documentSet.Init(query.comparator);
+    _overflow.Init(query.comparator);
     _syncedDocuments = std::move(remoteDocuments);
   }
   return self;
@@ -259,6 +278,47 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
 - (FSTViewDocumentChanges *)computeChangesWithDocuments:(const MaybeDocumentMap &)docChanges
                                         previousChanges:
                                             (nullable FSTViewDocumentChanges *)previousChanges {
+  // A refill passes in every document in the local cache that matches the query.
+  return [self computeChangesWithDocuments:docChanges
+                           previousChanges:previousChanges
+                     docChangesAreComplete:previousChanges != nil];
+}
+
+- (nullable FSTViewDocumentChanges *)refillChangesFromOverflow:
+    (FSTViewDocumentChanges *)docChanges {
+  HARD_ASSERT(docChanges.needsRefill, "Only changes that need a refill can be refilled");
+
+  MaybeDocumentMap overflowDocs;
+  for (FSTDocument *doc : docChanges.overflow) {
+    overflowDocs = std::move(overflowDocs).insert(doc.key, doc);
+  }
+  FSTViewDocumentChanges *refilled = [self computeChangesWithDocuments:overflowDocs
+                                                       previousChanges:docChanges
+                                                 docChangesAreComplete:NO];
+
+  // Matching documents past the boundary are unknown, so the refilled view is only right if it's
+  // full of documents that sort at or before the boundary.
+  FSTDocument *_Nullable boundary = refilled.overflowBoundary;
+  if (boundary) {
+    const DocumentSet &documents = refilled.documentSet;
+    if (documents.size() < self.query.limit ||
+        util::Descending([self compare:documents.GetLastDocument() with:boundary])) {
+      return nil;
+    }
+  }
+  return refilled;
+}
+
+/**
+ * Computes changes as described in the public methods above.
+ *
+ * @param docChangesAreComplete Whether docChanges contains every document that matches the query,
+ *     as opposed to just the ones that changed.
+ */
+- (FSTViewDocumentChanges *)computeChangesWithDocuments:(const MaybeDocumentMap &)docChanges
+                                        previousChanges:
+                                            (nullable FSTViewDocumentChanges *)previousChanges
+                                  docChangesAreComplete:(BOOL)docChangesAreComplete {
   DocumentViewChangeSet changeSet;
   if (previousChanges) {
     changeSet = previousChanges.changeSet;
@@ -346,13 +406,31 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
       if (newDoc) {
         newDocumentSet = newDocumentSet.insert(newDoc);
         if (newDoc.hasLocalMutations) {
-          newMutatedKeys = newMutatedKeys.insert(key);
+          newMutatedKeys = std::move(newMutatedKeys).insert(key);
         } else {
-          newMutatedKeys = newMutatedKeys.erase(key);
+          newMutatedKeys = std::move(newMutatedKeys).erase(key);
         }
       } else {
         newDocumentSet = newDocumentSet.erase(key);
-        newMutatedKeys = newMutatedKeys.erase(key);
+        newMutatedKeys = std::move(newMutatedKeys).erase(key);
+      }
+    }
+  }
+
+  // Documents pushed past the limit become the start of the overflow, ahead of any documents it
+  // already held.
+  DocumentSet newOverflow = previousChanges ? previousChanges.overflow : *_overflow;
+  FSTDocument *_Nullable overflowBoundary =
+      previousChanges ? previousChanges.overflowBoundary : _overflowBoundary;
+  if (self.query.limit != NSNotFound) {
+    if (docChangesAreComplete) {
+      newOverflow = DocumentSet{self.query.comparator};
+      overflowBoundary = nil;
+    } else {
+      for (const auto &kv : docChanges) {
+        if (newOverflow.ContainsKey(kv.first)) {
+          newOverflow = newOverflow.erase(kv.first);
+        }
       }
     }
   }
@@ -361,8 +439,17 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
     for (size_t i = newDocumentSet.size() - self.query.limit; i > 0; --i) {
       FSTDocument *oldDoc = newDocumentSet.GetLastDocument();
       newDocumentSet = newDocumentSet.erase(oldDoc.key);
-      newMutatedKeys = newMutatedKeys.erase(oldDoc.key);
+      newMutatedKeys = std::move(newMutatedKeys).erase(oldDoc.key);
       changeSet.AddChange(DocumentViewChange{oldDoc, DocumentViewChange::Type::kRemoved});
+
+      if (!overflowBoundary || !util::Descending([self compare:oldDoc with:overflowBoundary])) {
+        newOverflow = newOverflow.insert(oldDoc);
+      }
+    }
+
+    while (newOverflow.size() > kMaxOverflowDocuments) {
+      newOverflow = newOverflow.erase(newOverflow.GetLastDocument().key);
+      overflowBoundary = newOverflow.GetLastDocument();
     }
   }
 
@@ -372,7 +459,9 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
   return [[FSTViewDocumentChanges alloc] initWithDocumentSet:std::move(newDocumentSet)
                                                    changeSet:std::move(changeSet)
                                                  needsRefill:needsRefill
-                                                 mutatedKeys:newMutatedKeys];
+                                                 mutatedKeys:newMutatedKeys
+                                                    overflow:std::move(newOverflow)
+                                            overflowBoundary:overflowBoundary];
 }
 
 - (BOOL)shouldWaitForSyncedDocument:(FSTDocument *)newDoc oldDocument:(FSTDocument *)oldDoc {
@@ -396,21 +485,25 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
   DocumentSet oldDocuments = *_documentSet;
   *_documentSet = docChanges.documentSet;
   _mutatedKeys = docChanges.mutatedKeys;
-
-  // Sort changes based on type and query comparator.
-  std::vector<DocumentViewChange> changes = docChanges.changeSet.GetChanges();
-  std::sort(changes.begin(), changes.end(),
-            [self](const DocumentViewChange &lhs, const DocumentViewChange &rhs) {
-              int pos1 = GetDocumentViewChangeTypePosition(lhs.type());
-              int pos2 = GetDocumentViewChangeTypePosition(rhs.type());
-              if (pos1 != pos2) {
-                return pos1 < pos2;
-              }
-              return util::Ascending([self compare:lhs.document() with:rhs.document()]);
-            });
-
-  [self applyTargetChange:targetChange];
-  NSArray<FSTLimboDocumentChange *> *limboChanges = [self updateLimboDocuments];
+  *_overflow = docChanges.overflow;
+  _overflowBoundary = docChanges.overflowBoundary;
+
+  // Order changes based on type and query comparator.
+  std::vector<DocumentViewChange> changes = docChanges.changeSet.GetChangesInViewOrder(
+      oldDocuments, *_documentSet, self.query.comparator);
+
+  BOOL wasCurrent = self.isCurrent;
+  BOOL syncedDocumentsChanged = [self applyTargetChange:targetChange];
+
+  // Limbo documents only depend on the documents in the view (and their local mutations) and on
+  // which of them are synced. If none of these changed while the view stayed current, the limbo
+  // documents are still up to date. This keeps target changes that carry no documents (e.g. the
+  // ones acknowledging resumed targets whenever the watch stream reconnects) from scanning every
+  // document in every view.
+  NSArray<FSTLimboDocumentChange *> *limboChanges = @[];
+  if (!wasCurrent || !changes.empty() || syncedDocumentsChanged) {
+    limboChanges = [self updateLimboDocuments];
+  }
   BOOL synced = _limboDocuments.empty() && self.isCurrent;
   SyncState newSyncState = synced ? SyncState::Synced : SyncState::Local;
   bool syncStateChanged = newSyncState != self.syncState;
@@ -443,7 +536,9 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
                                              initWithDocumentSet:*_documentSet
                                                        changeSet:DocumentViewChangeSet {}
                                                      needsRefill:NO
-                                                     mutatedKeys:_mutatedKeys]];
+                                                     mutatedKeys:_mutatedKeys
+                                                        overflow:*_overflow
+                                                overflowBoundary:_overflowBoundary]];
   } else {
     // No effect, just return a no-op FSTViewChange.
     return [[FSTViewChange alloc] initWithSnapshot:absl::nullopt limboChanges:@[]];
@@ -474,25 +569,26 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
 }
 
 /**
- * Updates syncedDocuments and current based on the given change.
+ * Updates syncedDocuments and current based on the given change. Returns whether syncedDocuments
+ * may have changed.
  */
-- (void)applyTargetChange:(const absl::optional<TargetChange> &)maybeTargetChange {
+- (BOOL)applyTargetChange:(const absl::optional<TargetChange> &)maybeTargetChange {
+  BOOL syncedDocumentsChanged = NO;
   if (maybeTargetChange.has_value()) {
     const TargetChange &target_change = maybeTargetChange.value();
+    syncedDocumentsChanged =
+        !target_change.added_documents().empty() || !target_change.removed_documents().empty();
 
-    for (const DocumentKey &key : target_change.added_documents()) {
-      _syncedDocuments = _syncedDocuments.insert(key);
-    }
+    _syncedDocuments = _syncedDocuments.union_with(target_change.added_documents());
     for (const DocumentKey &key : target_change.modified_documents()) {
       HARD_ASSERT(_syncedDocuments.find(key) != _syncedDocuments.end(),
                   "Modified document %s not found in view.", key.ToString());
     }
-    for (const DocumentKey &key : target_change.removed_documents()) {
-      _syncedDocuments = _syncedDocuments.erase(key);
-    }
+    _syncedDocuments = _syncedDocuments.difference_with(target_change.removed_documents());
 
     self.current = target_change.current();
   }
+  return syncedDocumentsChanged;
 }
 
 /** Updates limboDocuments and returns any changes as FSTLimboDocumentChanges. */
@@ -507,7 +603,7 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
   _limboDocuments = DocumentKeySet{};
   for (FSTDocument *doc : *_documentSet) {
     if ([self shouldBeLimboDocumentKey:doc.key]) {
-      _limboDocuments = _limboDocuments.insert(doc.key);
+      _limboDocuments = std::move(_limboDocuments).insert(doc.key);
     }
   }
 
@@ -16,6 +16,8 @@
 
 #import <Foundation/Foundation.h>
 
+#include <map>
+#include <set>
 #include <string>
 #include <unordered_map>
 
@@ -38,11 +40,11 @@ namespace local {
 
 struct LruParams {
   static LruParams Default() {
-    return LruParams{100 * 1024 * 1024, 10, 1000};
+    return LruParams{100 * 1024 * 1024, 10, 1000, 10000, 1000, {}, {}};
   }
 
   static LruParams Disabled() {
-    return LruParams{api::Settings::CacheSizeUnlimited, 0, 0};
+    return LruParams{api::Settings::CacheSizeUnlimited, 0, 0, 0, 0, {}, {}};
   }
 
   static LruParams WithCacheSize(int64_t cacheSize) {
@@ -54,17 +56,50 @@ struct LruParams {
   int64_t minBytesThreshold;
   int percentileToCollect;
   int maximumSequenceNumbersToCollect;
+
+  /**
+   * The number of sequence numbers sampled to estimate the collection cutoff. The estimate is exact
+   * when the cache holds no more sequence numbers than this. Set to 0 to always compute the
+   * cutoff exactly.
+   */
+  int sampleSize;
+
+  /**
+   * The maximum number of orphaned documents removed by a single collection step. A collection
+   * that would remove more documents stops after this many and continues from where it left off
+   * on the next call to `collectWithLiveTargets:`. Set to 0 to remove everything in one step.
+   */
+  int maximumDocumentsRemovedPerStep;
+
+  /**
+   * Collection IDs whose cached documents are never collected, no matter how long ago they were
+   * last used. A document belongs to the collection group named by its parent collection's ID.
+   */
+  std::set<std::string> pinnedCollectionGroups;
+
+  /**
+   * The maximum number of bytes the cached documents of each listed collection group may use.
+   * Whenever garbage collection runs, groups over their budget have their least recently used
+   * orphaned documents removed until they fit, independently of `percentileToCollect`.
+   */
+  std::map<std::string, int64_t> collectionGroupByteBudgets;
 };
 
 struct LruResults {
   static LruResults DidNotRun() {
-    return LruResults{/* didRun= */ false, 0, 0, 0};
+    return LruResults{/* didRun= */ false, 0, 0, 0, /* hasMoreToCollect= */ false};
   }
 
   bool didRun;
   int sequenceNumbersCollected;
   int targetsRemoved;
   int documentsRemoved;
+
+  /**
+   * Whether the collection stopped early because it reached the per-step document limit. If so,
+   * the caller should call `collectWithLiveTargets:` again, in a new transaction, to finish it.
+   */
+  bool hasMoreToCollect;
 };
 
 }  // namespace local
@@ -91,10 +126,13 @@ namespace local = firebase::firestore::local;
 - (void)enumerateMutationsUsingCallback:(const local::OrphanedDocumentCallback &)callback;
 
 /**
- * Removes all unreferenced documents from the cache that have a sequence number less than or equal
- * to the given sequence number. Returns the number of documents removed.
+ * Removes unreferenced documents from the cache that have a sequence number less than or equal to
+ * the given sequence number, stopping after `limit` documents if `limit` is positive. Returns the
+ * number of documents removed. Implementations may continue a stopped call with the same sequence
+ * number from where it stopped.
  */
-- (int)removeOrphanedDocumentsThroughSequenceNumber:(model::ListenSequenceNumber)sequenceNumber;
+- (int)removeOrphanedDocumentsThroughSequenceNumber:(model::ListenSequenceNumber)sequenceNumber
+                                              limit:(int)limit;
 
 /**
  * Removes all targets that are not currently being listened to and have a sequence number less than
@@ -105,8 +143,18 @@ namespace local = firebase::firestore::local;
                                   (const std::unordered_map<model::TargetId, FSTQueryData *> &)
                                       liveQueries;
 
+/**
+ * Removes a single document, as reported by `enumerateMutationsUsingCallback:`, unless it is
+ * pinned. Returns whether the document was removed.
+ */
+- (BOOL)removeOrphanedDocument:(const model::DocumentKey &)key
+                sequenceNumber:(model::ListenSequenceNumber)sequenceNumber;
+
 - (size_t)byteSize;
 
+/** Returns the number of bytes used by the cached documents of the given collection group. */
+- (int64_t)byteSizeForCollectionGroup:(const std::string &)collectionGroup;
+
 /** Returns the number of targets and orphaned documents cached. */
 - (size_t)sequenceNumberCount;
 
@@ -155,6 +203,19 @@ namespace local = firebase::firestore::local;
 
 - (size_t)byteSize;
 
+/** Returns whether the document belongs to a collection group that must never be collected. */
+- (BOOL)isInPinnedCollectionGroup:(const model::DocumentKey &)key;
+
+/**
+ * Removes the least recently used orphaned documents of each collection group that is over its
+ * byte budget until it fits. Returns the number of documents removed.
+ */
+- (int)removeDocumentsOverCollectionGroupBudgets;
+
+/**
+ * Runs a step of garbage collection. If the previous step stopped early (see
+ * `LruResults::hasMoreToCollect`), this continues that collection rather than starting a new one.
+ */
 - (local::LruResults)collectWithLiveTargets:
     (const std::unordered_map<model::TargetId, FSTQueryData *> &)liveTargets;
 
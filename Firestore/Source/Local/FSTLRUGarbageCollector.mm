@@ -16,14 +16,20 @@
 
 #import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
 
+#include <algorithm>
 #include <chrono>  //NOLINT(build/c++11)
+#include <map>
 #include <queue>
+#include <random>
+#include <string>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/Local/FSTPersistence.h"
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 
 namespace api = firebase::firestore::api;
@@ -34,6 +40,7 @@ using firebase::firestore::local::LruResults;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::util::LogIsDebugEnabled;
 
 const ListenSequenceNumber kFSTListenSequenceNumberInvalid = -1;
 
@@ -82,11 +89,84 @@ class RollingSequenceNumberBuffer {
   const size_t max_elements_;
 };
 
+/**
+ * SequenceNumberSample keeps a uniform random sample of bounded size from a series of sequence
+ * numbers (a reservoir sample), from which it can estimate the nth sequence number in the series.
+ *
+ * The sample is seeded with a constant, so the same series always produces the same estimate.
+ */
+class SequenceNumberSample {
+ public:
+  explicit SequenceNumberSample(size_t max_elements)
+      : max_elements_(max_elements), random_(kSeed) {
+    sample_.reserve(max_elements);
+  }
+
+  SequenceNumberSample(const SequenceNumberSample &other) = delete;
+
+  SequenceNumberSample &operator=(const SequenceNumberSample &other) = delete;
+
+  void AddElement(ListenSequenceNumber sequence_number) {
+    count_++;
+    if (sample_.size() < max_elements_) {
+      sample_.push_back(sequence_number);
+    } else {
+      // Replace a random element such that each element seen so far is equally likely to be in the
+      // sample.
+      uint64_t slot = random_() % count_;
+      if (slot < max_elements_) {
+        sample_[slot] = sequence_number;
+      }
+    }
+  }
+
+  /** The number of elements added, as opposed to the number kept in the sample. */
+  size_t count() const {
+    return count_;
+  }
+
+  /**
+   * Estimates the nth (1-based) smallest sequence number added, by picking the element at the
+   * same relative position in the sample.
+   */
+  ListenSequenceNumber EstimateNthValue(size_t n) {
+    HARD_ASSERT(n > 0 && n <= count_, "Cannot estimate element %s of %s", n, count_);
+    size_t position = (n * sample_.size() + count_ - 1) / count_;
+    auto nth = sample_.begin() + (position - 1);
+    std::nth_element(sample_.begin(), nth, sample_.end());
+    return *nth;
+  }
+
+ private:
+  static constexpr uint64_t kSeed = 5489;
+
+  std::vector<ListenSequenceNumber> sample_;
+  const size_t max_elements_;
+  size_t count_ = 0;
+  std::mt19937_64 random_;
+};
+
+/** Returns the ID of the collection the document belongs to. */
+const std::string &CollectionGroup(const DocumentKey &key) {
+  return key.path()[key.path().size() - 2];
+}
+
+int CappedQueryCount(const LruParams &params, size_t total) {
+  int count = (int)((params.percentileToCollect / 100.0f) * total);
+  return std::min(count, params.maximumSequenceNumbersToCollect);
+}
+
 }  // namespace
 
 @implementation FSTLRUGarbageCollector {
   __weak id<FSTLRUDelegate> _delegate;
   LruParams _params;
+
+  /**
+   * The upper bound of a collection that stopped early and still has documents to remove, or
+   * kFSTListenSequenceNumberInvalid if there is none.
+   */
+  ListenSequenceNumber _pendingUpperBound;
 }
 
 - (instancetype)initWithDelegate:(id<FSTLRUDelegate>)delegate params:(LruParams)params {
@@ -94,6 +174,7 @@ class RollingSequenceNumberBuffer {
   if (self) {
     _delegate = delegate;
     _params = std::move(params);
+    _pendingUpperBound = kFSTListenSequenceNumberInvalid;
   }
   return self;
 }
@@ -105,6 +186,10 @@ class RollingSequenceNumberBuffer {
     return LruResults::DidNotRun();
   }
 
+  if (_pendingUpperBound != kFSTListenSequenceNumberInvalid) {
+    return [self continueGC];
+  }
+
   size_t currentSize = [self byteSize];
   if (currentSize < _params.minBytesThreshold) {
     // Not enough on disk to warrant collection. Wait another timeout cycle.
@@ -120,37 +205,89 @@ class RollingSequenceNumberBuffer {
 - (LruResults)runGCWithLiveTargets:
     (const std::unordered_map<TargetId, FSTQueryData *> &)liveTargets {
   Timestamp start = Timestamp::Now();
-  int sequenceNumbers = [self queryCountForPercentile:_params.percentileToCollect];
-  // Cap at the configured max
-  if (sequenceNumbers > _params.maximumSequenceNumbersToCollect) {
-    sequenceNumbers = _params.maximumSequenceNumbersToCollect;
-  }
-  Timestamp countedTargets = Timestamp::Now();
+  int numDocumentsOverBudget = [self removeDocumentsOverCollectionGroupBudgets];
+  Timestamp enforcedBudgets = Timestamp::Now();
+
+  int sequenceNumbers;
+  ListenSequenceNumber upperBound;
+  Timestamp countedTargets;
+  if (_params.sampleSize > 0) {
+    // Count and sample the sequence numbers in a single pass rather than enumerating everything
+    // once to count it and again to find the cutoff.
+    SequenceNumberSample sample(_params.sampleSize);
+    [_delegate enumerateTargetsUsingCallback:[&sample](FSTQueryData *queryData) {
+      sample.AddElement(queryData.sequenceNumber);
+    }];
+    [_delegate enumerateMutationsUsingCallback:[&sample](const DocumentKey &docKey,
+                                                         ListenSequenceNumber sequenceNumber) {
+      sample.AddElement(sequenceNumber);
+    }];
+    sequenceNumbers = CappedQueryCount(_params, sample.count());
+    countedTargets = Timestamp::Now();
+
+    upperBound = sequenceNumbers == 0 ? kFSTListenSequenceNumberInvalid
+                                      : sample.EstimateNthValue(sequenceNumbers);
+  } else {
+    sequenceNumbers = CappedQueryCount(_params, [_delegate sequenceNumberCount]);
+    countedTargets = Timestamp::Now();
 
-  ListenSequenceNumber upperBound = [self sequenceNumberForQueryCount:sequenceNumbers];
+    upperBound = [self sequenceNumberForQueryCount:sequenceNumbers];
+  }
   Timestamp foundUpperBound = Timestamp::Now();
 
   int numTargetsRemoved = [self removeQueriesUpThroughSequenceNumber:upperBound
                                                          liveQueries:liveTargets];
   Timestamp removedTargets = Timestamp::Now();
 
-  int numDocumentsRemoved = [self removeOrphanedDocumentsThroughSequenceNumber:upperBound];
+  int limit = _params.maximumDocumentsRemovedPerStep;
+  int numDocumentsRemoved = [_delegate removeOrphanedDocumentsThroughSequenceNumber:upperBound
+                                                                              limit:limit];
+  bool hasMore = limit > 0 && numDocumentsRemoved >= limit;
+  if (hasMore) {
+    _pendingUpperBound = upperBound;
+  }
   Timestamp removedDocuments = Timestamp::Now();
 
-  std::string desc = "LRU Garbage Collection:\n";
-  absl::StrAppend(&desc, "\tCounted targets in ", millisecondsBetween(start, countedTargets),
-                  "ms\n");
-  absl::StrAppend(&desc, "\tDetermined least recently used ", sequenceNumbers,
-                  " sequence numbers in ", millisecondsBetween(countedTargets, foundUpperBound),
-                  "ms\n");
-  absl::StrAppend(&desc, "\tRemoved ", numTargetsRemoved, " targets in ",
-                  millisecondsBetween(foundUpperBound, removedTargets), "ms\n");
-  absl::StrAppend(&desc, "\tRemoved ", numDocumentsRemoved, " documents in ",
-                  millisecondsBetween(removedTargets, removedDocuments), "ms\n");
-  absl::StrAppend(&desc, "Total duration: ", millisecondsBetween(start, removedDocuments), "ms");
-  LOG_DEBUG(desc.c_str());
-
-  return LruResults{/* didRun= */ true, sequenceNumbers, numTargetsRemoved, numDocumentsRemoved};
+  if (LogIsDebugEnabled()) {
+    std::string desc = "LRU Garbage Collection:\n";
+    absl::StrAppend(&desc, "\tRemoved ", numDocumentsOverBudget,
+                    " documents over collection group budgets in ",
+                    millisecondsBetween(start, enforcedBudgets), "ms\n");
+    absl::StrAppend(&desc, "\tCounted targets in ",
+                    millisecondsBetween(enforcedBudgets, countedTargets), "ms\n");
+    absl::StrAppend(&desc, "\tDetermined least recently used ", sequenceNumbers,
+                    " sequence numbers in ", millisecondsBetween(countedTargets, foundUpperBound),
+                    "ms\n");
+    absl::StrAppend(&desc, "\tRemoved ", numTargetsRemoved, " targets in ",
+                    millisecondsBetween(foundUpperBound, removedTargets), "ms\n");
+    absl::StrAppend(&desc, "\tRemoved ", numDocumentsRemoved, " documents in ",
+                    millisecondsBetween(removedTargets, removedDocuments), "ms\n");
+    absl::StrAppend(&desc, "Total duration: ", millisecondsBetween(start, removedDocuments), "ms");
+    LOG_DEBUG("%s", desc);
+  }
+
+  return LruResults{/* didRun= */ true, sequenceNumbers, numTargetsRemoved,
+                    numDocumentsOverBudget + numDocumentsRemoved, hasMore};
+}
+
+/**
+ * Removes the next chunk of orphaned documents for a collection that stopped early. Targets were
+ * already removed by the first step, and any document orphaned since then has a newer sequence
+ * number than the pending upper bound, so only documents remain to be collected.
+ */
+- (LruResults)continueGC {
+  Timestamp start = Timestamp::Now();
+  int limit = _params.maximumDocumentsRemovedPerStep;
+  int numDocumentsRemoved =
+      [_delegate removeOrphanedDocumentsThroughSequenceNumber:_pendingUpperBound limit:limit];
+  bool hasMore = limit > 0 && numDocumentsRemoved >= limit;
+  if (!hasMore) {
+    _pendingUpperBound = kFSTListenSequenceNumberInvalid;
+  }
+  LOG_DEBUG("LRU Garbage Collection: Removed %s more documents in %sms", numDocumentsRemoved,
+            millisecondsBetween(start, Timestamp::Now()));
+
+  return LruResults{/* didRun= */ true, 0, 0, numDocumentsRemoved, hasMore};
 }
 
 - (int)queryCountForPercentile:(NSUInteger)percentile {
@@ -182,7 +319,51 @@ class RollingSequenceNumberBuffer {
 }
 
 - (int)removeOrphanedDocumentsThroughSequenceNumber:(ListenSequenceNumber)sequenceNumber {
-  return [_delegate removeOrphanedDocumentsThroughSequenceNumber:sequenceNumber];
+  return [_delegate removeOrphanedDocumentsThroughSequenceNumber:sequenceNumber limit:0];
+}
+
+- (BOOL)isInPinnedCollectionGroup:(const DocumentKey &)key {
+  return _params.pinnedCollectionGroups.count(CollectionGroup(key)) > 0;
+}
+
+- (int)removeDocumentsOverCollectionGroupBudgets {
+  using Candidate = std::pair<ListenSequenceNumber, DocumentKey>;
+  std::map<std::string, std::vector<Candidate>> candidates;
+  for (const auto &entry : _params.collectionGroupByteBudgets) {
+    if ([_delegate byteSizeForCollectionGroup:entry.first] > entry.second) {
+      candidates[entry.first];
+    }
+  }
+  if (candidates.empty()) {
+    return 0;
+  }
+
+  [_delegate enumerateMutationsUsingCallback:[&candidates](const DocumentKey &docKey,
+                                                           ListenSequenceNumber sequenceNumber) {
+    auto found = candidates.find(CollectionGroup(docKey));
+    if (found != candidates.end()) {
+      found->second.emplace_back(sequenceNumber, docKey);
+    }
+  }];
+
+  int removed = 0;
+  for (auto &entry : candidates) {
+    const std::string &collectionGroup = entry.first;
+    int64_t budget = _params.collectionGroupByteBudgets.at(collectionGroup);
+    std::vector<Candidate> &docs = entry.second;
+    std::sort(docs.begin(), docs.end(), [](const Candidate &lhs, const Candidate &rhs) {
+      return lhs.first < rhs.first;
+    });
+    for (const Candidate &doc : docs) {
+      if ([_delegate byteSizeForCollectionGroup:collectionGroup] <= budget) {
+        break;
+      }
+      if ([_delegate removeOrphanedDocument:doc.second sequenceNumber:doc.first]) {
+        removed++;
+      }
+    }
+  }
+  return removed;
 }
 
 - (size_t)byteSize {
@@ -22,7 +22,9 @@
 
 #import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
 #import "Firestore/Source/Local/FSTPersistence.h"
+#include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_snapshot_reader.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
 #include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
@@ -31,6 +33,7 @@
 
 @class FSTLocalSerializer;
 
+namespace api = firebase::firestore::api;
 namespace core = firebase::firestore::core;
 namespace local = firebase::firestore::local;
 namespace util = firebase::firestore::util;
@@ -53,6 +56,7 @@ NS_ASSUME_NONNULL_BEGIN
 + (util::Status)dbWithDirectory:(util::Path)directory
                      serializer:(FSTLocalSerializer *)serializer
                       lruParams:(local::LruParams)lruParams
+            persistenceSettings:(const api::PersistenceSettings &)persistenceSettings
                             ptr:(FSTLevelDB *_Nullable *_Nonnull)ptr;
 
 - (instancetype)init NS_UNAVAILABLE;
@@ -76,7 +80,66 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (const leveldb::ReadOptions)standardReadOptions;
 
-/** The native db pointer, allocated during start. */
+/**
+ * Runs a bounded step of the schema migrations that were deferred to the background because
+ * `background_migrations_enabled` was set, in a transaction of its own.
+ *
+ * @return YES if more steps are needed.
+ */
+- (BOOL)runMigrationBackfillStep;
+
+/**
+ * Returns a human-readable summary of LevelDB's statistics for this instance: the files and
+ * compaction activity at each level, and the approximate memory used by the memtables and the
+ * block cache.
+ */
+- (std::string)statistics;
+
+/**
+ * Records that the persisted remote documents, targets or mutation batches grew by `delta` bytes
+ * (or shrank, if negative) in the current transaction. The running total is what the LRU garbage
+ * collector sees as the size of the cache.
+ */
+- (void)adjustByteSize:(int64_t)delta;
+
+/**
+ * Takes a snapshot of the database, through which the local view of documents can be read on any
+ * thread without blocking the worker queue. Must be called on the worker queue, so that the
+ * snapshot includes every write made before. Shutting down waits for the returned reader to be
+ * destroyed.
+ */
+- (std::unique_ptr<local::LevelDbSnapshotReader>)newSnapshotReader;
+
+/**
+ * Exports a consistent snapshot of the database to `directory` in the background, as a database of
+ * its own that instances in other processes copy and open when `export_read_only` is set. Does
+ * nothing if no transaction was written since the last export, or while the last one still runs.
+ */
+- (void)exportSnapshotToDirectory:(const util::Path &)directory;
+
+/**
+ * Replaces `directory` with a copy of the latest snapshot exported to `exportDirectory`, or with
+ * an empty directory if there is none, so that it can be opened like any database.
+ */
++ (util::Status)copyLatestExportFromDirectory:(const util::Path &)exportDirectory
+                                  toDirectory:(const util::Path &)directory;
+
+/**
+ * Writes the commits held back because `group_commit_delay_ms` was set, if any, in a single batch.
+ * Must not be called inside a transaction.
+ */
+- (void)flushGroupCommit;
+
+/**
+ * Called when a commit is held back and no others were, from inside `commitTransaction`. The
+ * handler must arrange for `flushGroupCommit` to be called once the group commit delay has passed.
+ */
+@property(nonatomic, copy, nullable) void (^groupCommitHandler)(void);
+
+/**
+ * The native db pointer, allocated during start. Outside of a transaction, getting it flushes the
+ * commits held back, so that they can be read from it.
+ */
 @property(nonatomic, assign, readonly) leveldb::DB *ptr;
 
 @property(nonatomic, readonly) local::LevelDbTransaction *currentTransaction;
@@ -16,9 +16,15 @@
 
 #import "Firestore/Source/Local/FSTLevelDB.h"
 
+#include <atomic>
+#include <cerrno>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdio>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #import "FIRFirestoreErrors.h"
 #import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
@@ -34,8 +40,10 @@
 #include "Firestore/core/src/firebase/firestore/local/leveldb_mutation_queue.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_query_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_snapshot_reader.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_util.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_warm_snapshot_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/listen_sequence.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
@@ -45,21 +53,31 @@
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/util/filesystem.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/string_util.h"
+#include "Firestore/core/src/firebase/firestore/util/trace_span.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
+#include "leveldb/cache.h"
 #include "leveldb/db.h"
+#include "leveldb/filter_policy.h"
+#include "leveldb/write_batch.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 namespace util = firebase::firestore::util;
 using firebase::firestore::FirestoreErrorCode;
+using firebase::firestore::api::PersistenceSettings;
 using firebase::firestore::auth::User;
 using firebase::firestore::core::DatabaseInfo;
+using firebase::firestore::core::DocumentSizer;
+using firebase::firestore::core::MemoryStats;
 using firebase::firestore::local::ConvertStatus;
 using firebase::firestore::local::IndexManager;
 using firebase::firestore::local::LevelDbDocumentMutationKey;
@@ -70,7 +88,11 @@ using firebase::firestore::local::LevelDbMutationKey;
 using firebase::firestore::local::LevelDbMutationQueue;
 using firebase::firestore::local::LevelDbQueryCache;
 using firebase::firestore::local::LevelDbRemoteDocumentCache;
+using firebase::firestore::local::LevelDbRemoteDocumentKey;
+using firebase::firestore::local::LevelDbSnapshotReader;
+using firebase::firestore::local::LevelDbSnapshotReaderCount;
 using firebase::firestore::local::LevelDbTransaction;
+using firebase::firestore::local::LevelDbWarmSnapshotCache;
 using firebase::firestore::local::ListenSequence;
 using firebase::firestore::local::LruParams;
 using firebase::firestore::local::OrphanedDocumentCallback;
@@ -79,6 +101,7 @@ using firebase::firestore::local::RemoteDocumentCache;
 using firebase::firestore::local::TargetCallback;
 using firebase::firestore::model::DatabaseId;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentKeyHash;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::model::TargetId;
@@ -87,6 +110,7 @@ using firebase::firestore::util::Path;
 using firebase::firestore::util::Status;
 using firebase::firestore::util::StatusOr;
 using firebase::firestore::util::StringFormat;
+using firebase::firestore::util::TraceSpan;
 using leveldb::DB;
 using leveldb::Options;
 using leveldb::ReadOptions;
@@ -94,6 +118,92 @@ using leveldb::WriteOptions;
 
 static const char *kReservedPathComponent = "firestore";
 
+/** The number of rows processed by each step of a migration running in the background. */
+static const int kMigrationBackfillRowsPerStep = 1000;
+
+/**
+ * The number of documents garbage collection must remove in one transaction before the key ranges
+ * they were in are compacted, so that later scans don't have to skip over their tombstones.
+ */
+static const int kCompactionRemovedDocumentThreshold = 1000;
+
+/**
+ * Commits held back for group commit are written right away once they change this many rows
+ * between them, so that large transactions aren't delayed and groups stay small.
+ */
+static const size_t kGroupCommitMaxChangedKeys = 1000;
+
+/** The file in an export directory that holds the name of the latest export. */
+static const char *kLatestExportFile = "LATEST";
+
+/** The prefix of the name of each export in an export directory. */
+static const char *kExportPrefix = "export-";
+
+/** The approximate size of the batches in which rows are copied to an export. */
+static const size_t kExportBatchSizeBytes = 1024 * 1024;
+
+/**
+ * Copies the rows visible in `snapshot` to a new database, then publishes it as the latest export
+ * in `directory`. The export before it is kept, in case another process is still copying it, and
+ * older ones are deleted.
+ */
+static Status ExportSnapshot(DB *db, const leveldb::Snapshot *snapshot, const Path &directory) {
+  Status status = util::RecursivelyCreateDir(directory);
+  if (!status.ok()) return status;
+
+  Path staging = directory.AppendUtf8("staging");
+  status = util::RecursivelyDelete(staging);
+  if (!status.ok()) return status;
+
+  Options options;
+  options.create_if_missing = true;
+  options.error_if_exists = true;
+  DB *rawExport;
+  leveldb::Status leveldbStatus = DB::Open(options, staging.ToUtf8String(), &rawExport);
+  if (!leveldbStatus.ok()) return ConvertStatus(leveldbStatus);
+  std::unique_ptr<DB> exported(rawExport);
+
+  ReadOptions readOptions;
+  readOptions.snapshot = snapshot;
+  readOptions.fill_cache = false;
+  std::unique_ptr<leveldb::Iterator> it(db->NewIterator(readOptions));
+  leveldb::WriteBatch batch;
+  for (it->SeekToFirst(); it->Valid() && leveldbStatus.ok(); it->Next()) {
+    batch.Put(it->key(), it->value());
+    if (batch.ApproximateSize() >= kExportBatchSizeBytes) {
+      leveldbStatus = exported->Write(WriteOptions(), &batch);
+      batch.Clear();
+    }
+  }
+  if (leveldbStatus.ok()) leveldbStatus = it->status();
+  if (leveldbStatus.ok()) leveldbStatus = exported->Write(WriteOptions(), &batch);
+  if (!leveldbStatus.ok()) return ConvertStatus(leveldbStatus);
+  exported.reset();
+
+  auto now = std::chrono::system_clock::now().time_since_epoch();
+  std::string name = absl::StrCat(
+      kExportPrefix, std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+  if (std::rename(staging.c_str(), directory.AppendUtf8(name).c_str()) != 0) {
+    return Status::FromErrno(errno, StringFormat("Failed to publish export %s", name));
+  }
+
+  Path latestFile = directory.AppendUtf8(kLatestExportFile);
+  StatusOr<std::string> previous = util::ReadFile(latestFile);
+  status = util::WriteFileAtomically(latestFile, name);
+  if (!status.ok()) return status;
+
+  NSArray<NSString *> *entries =
+      [[NSFileManager defaultManager] contentsOfDirectoryAtPath:directory.ToNSString() error:nil];
+  for (NSString *entry in entries) {
+    std::string entryName = util::MakeString(entry);
+    if (absl::StartsWith(entryName, kExportPrefix) && entryName != name &&
+        !(previous.ok() && entryName == previous.ValueOrDie())) {
+      util::RecursivelyDelete(directory.AppendUtf8(entryName)).IgnoreError();
+    }
+  }
+  return Status::OK();
+}
+
 @interface FSTLevelDB ()
 
 - (size_t)byteSize;
@@ -102,8 +212,16 @@ static const char *kReservedPathComponent = "firestore";
 
 - (LevelDbQueryCache *)queryCache;
 
+- (LevelDbRemoteDocumentCache *)remoteDocumentCache;
+
 - (LevelDbMutationQueue *)mutationQueueForUser:(const User &)user;
 
+/**
+ * Compacts the rows of the documents between `first` and `last`, inclusive, on a background
+ * queue.
+ */
+- (void)compactDocumentsFrom:(const DocumentKey &)first through:(const DocumentKey &)last;
+
 @end
 
 /**
@@ -118,6 +236,8 @@ static const char *kReservedPathComponent = "firestore";
 
 - (void)transactionWillCommit;
 
+- (void)transactionDidCommit;
+
 - (void)start;
 
 @end
@@ -129,6 +249,18 @@ static const char *kReservedPathComponent = "firestore";
   __weak FSTLevelDB *_db;
   ReferenceSet *_additionalReferences;
   ListenSequenceNumber _currentSequenceNumber;
+  // Keys touched by the current transaction. Their sentinel rows all carry the same sequence
+  // number, so they are written once per key, when the transaction commits.
+  std::unordered_set<DocumentKey, DocumentKeyHash> _pendingSentinelKeys;
+  // The number of documents removed by garbage collection in the current transaction, and the
+  // first and last of them in key order.
+  int _removedDocumentCount;
+  DocumentKey _firstRemovedKey;
+  DocumentKey _lastRemovedKey;
+  // Where the next bounded step of orphaned document removal picks up the scan, and the upper
+  // bound of the collection it belongs to. Empty when no scan is in progress.
+  DocumentKey _orphanScanResumeKey;
+  ListenSequenceNumber _orphanScanUpperBound;
   // PORTING NOTE: doesn't need to be a pointer once this class is ported to C++.
   std::unique_ptr<ListenSequence> _listenSequence;
 }
@@ -138,6 +270,7 @@ static const char *kReservedPathComponent = "firestore";
     _gc = [[FSTLRUGarbageCollector alloc] initWithDelegate:self params:lruParams];
     _db = persistence;
     _currentSequenceNumber = kFSTListenSequenceNumberInvalid;
+    _orphanScanUpperBound = kFSTListenSequenceNumberInvalid;
   }
   return self;
 }
@@ -151,12 +284,22 @@ static const char *kReservedPathComponent = "firestore";
   HARD_ASSERT(_currentSequenceNumber == kFSTListenSequenceNumberInvalid,
               "Previous sequence number is still in effect");
   _currentSequenceNumber = _listenSequence->Next();
+  _pendingSentinelKeys.clear();
+  _removedDocumentCount = 0;
 }
 
 - (void)transactionWillCommit {
+  [self writePendingSentinels];
   _currentSequenceNumber = kFSTListenSequenceNumberInvalid;
 }
 
+- (void)transactionDidCommit {
+  if (_removedDocumentCount >= kCompactionRemovedDocumentThreshold) {
+    [_db compactDocumentsFrom:_firstRemovedKey through:_lastRemovedKey];
+  }
+  _removedDocumentCount = 0;
+}
+
 - (ListenSequenceNumber)currentSequenceNumber {
   HARD_ASSERT(_currentSequenceNumber != kFSTListenSequenceNumberInvalid,
               "Asking for a sequence number outside of a transaction");
@@ -203,6 +346,9 @@ static const char *kReservedPathComponent = "firestore";
 }
 
 - (BOOL)isPinned:(const DocumentKey &)docKey {
+  if ([_gc isInPinnedCollectionGroup:docKey]) {
+    return YES;
+  }
   if (_additionalReferences->ContainsKey(docKey)) {
     return YES;
   }
@@ -217,25 +363,73 @@ static const char *kReservedPathComponent = "firestore";
 }
 
 - (void)enumerateMutationsUsingCallback:(const OrphanedDocumentCallback &)callback {
+  [self writePendingSentinels];
   _db.queryCache->EnumerateOrphanedDocuments(callback);
 }
 
-- (int)removeOrphanedDocumentsThroughSequenceNumber:(ListenSequenceNumber)upperBound {
+- (int)removeOrphanedDocumentsThroughSequenceNumber:(ListenSequenceNumber)upperBound
+                                              limit:(int)limit {
   int count = 0;
-  _db.queryCache->EnumerateOrphanedDocuments(
-      [&count, self, upperBound](const DocumentKey &docKey, ListenSequenceNumber sequenceNumber) {
+  // Orphaned documents are found by their sentinel rows, so those must be up to date.
+  [self writePendingSentinels];
+
+  // A step of the same collection continues after the documents the previous steps looked at,
+  // rather than reading past them again. Documents orphaned since then have newer sequence
+  // numbers than the upper bound, so they couldn't be removed anyway.
+  DocumentKey startKey = DocumentKey::Empty();
+  if (limit > 0 && upperBound == _orphanScanUpperBound) {
+    startKey = _orphanScanResumeKey;
+  }
+  DocumentKey stoppedAt = _db.queryCache->EnumerateOrphanedDocuments(
+      startKey, [&count, self, upperBound, limit](const DocumentKey &docKey,
+                                                  ListenSequenceNumber sequenceNumber) {
+        if (limit > 0 && count >= limit) {
+          return false;
+        }
         if (sequenceNumber <= upperBound) {
           if (![self isPinned:docKey]) {
             count++;
             self->_db.remoteDocumentCache->Remove(docKey);
             [self removeSentinel:docKey];
+            [self recordRemovedDocument:docKey];
           }
         }
+        return true;
       });
+
+  if (stoppedAt.path().empty()) {
+    _orphanScanResumeKey = DocumentKey::Empty();
+    _orphanScanUpperBound = kFSTListenSequenceNumberInvalid;
+  } else {
+    _orphanScanResumeKey = stoppedAt;
+    _orphanScanUpperBound = upperBound;
+  }
   return count;
 }
 
+- (BOOL)removeOrphanedDocument:(const DocumentKey &)key
+                sequenceNumber:(ListenSequenceNumber)sequenceNumber {
+  if ([self isPinned:key]) {
+    return NO;
+  }
+  _db.remoteDocumentCache->Remove(key);
+  [self removeSentinel:key];
+  [self recordRemovedDocument:key];
+  return YES;
+}
+
+- (void)recordRemovedDocument:(const DocumentKey &)key {
+  if (_removedDocumentCount == 0 || key < _firstRemovedKey) {
+    _firstRemovedKey = key;
+  }
+  if (_removedDocumentCount == 0 || _lastRemovedKey < key) {
+    _lastRemovedKey = key;
+  }
+  _removedDocumentCount++;
+}
+
 - (void)removeSentinel:(const DocumentKey &)key {
+  _pendingSentinelKeys.erase(key);
   _db.currentTransaction->Delete(LevelDbDocumentTargetKey::SentinelKey(key));
 }
 
@@ -259,10 +453,22 @@ static const char *kReservedPathComponent = "firestore";
 }
 
 - (void)writeSentinelForKey:(const DocumentKey &)key {
-  std::string sentinelKey = LevelDbDocumentTargetKey::SentinelKey(key);
+  HARD_ASSERT(_currentSequenceNumber != kFSTListenSequenceNumberInvalid,
+              "Writing a sentinel outside of a transaction");
+  _pendingSentinelKeys.insert(key);
+}
+
+/** Writes the sentinel rows of the keys touched since the last write, and forgets the keys. */
+- (void)writePendingSentinels {
+  if (_pendingSentinelKeys.empty()) {
+    return;
+  }
   std::string encodedSequenceNumber =
       LevelDbDocumentTargetKey::EncodeSentinelValue([self currentSequenceNumber]);
-  _db.currentTransaction->Put(sentinelKey, encodedSequenceNumber);
+  for (const DocumentKey &key : _pendingSentinelKeys) {
+    _db.currentTransaction->Put(LevelDbDocumentTargetKey::SentinelKey(key), encodedSequenceNumber);
+  }
+  _pendingSentinelKeys.clear();
 }
 
 - (void)removeMutationReference:(const DocumentKey &)key {
@@ -277,19 +483,49 @@ static const char *kReservedPathComponent = "firestore";
   return [_db byteSize];
 }
 
+- (int64_t)byteSizeForCollectionGroup:(const std::string &)collectionGroup {
+  return _db.remoteDocumentCache->GetCollectionGroupByteSize(collectionGroup);
+}
+
 @end
 
 @implementation FSTLevelDB {
   Path _directory;
   std::unique_ptr<LevelDbTransaction> _transaction;
+  // The block cache and filter policy are referenced by the DB, so they must be declared before
+  // _ptr in order to be destroyed after it.
+  std::unique_ptr<leveldb::Cache> _blockCache;
+  std::unique_ptr<const leveldb::FilterPolicy> _filterPolicy;
   std::unique_ptr<leveldb::DB> _ptr;
+  ReadOptions _readOptions;
+  BOOL _syncWrites;
+  std::chrono::milliseconds _syncInterval;
+  std::chrono::steady_clock::time_point _lastSyncTime;
+  BOOL _groupCommitEnabled;
+  // The commits held back until the group is flushed. Between transactions, they are kept here;
+  // the next transaction then continues from them, so that it reads what they wrote.
+  std::unique_ptr<LevelDbTransaction> _groupCommit;
+  // Whether any commits are held back, either in _groupCommit or in the current transaction.
+  BOOL _groupCommitPending;
+  // The number of transactions written so far, and when the last export started, if any did.
+  uint64_t _writtenTransactionCount;
+  absl::optional<uint64_t> _exportedTransactionCount;
+  // Set while an export runs in the background.
+  std::shared_ptr<std::atomic<bool>> _exporting;
   std::unique_ptr<LevelDbRemoteDocumentCache> _documentCache;
   std::unique_ptr<LevelDbIndexManager> _indexManager;
+  std::unique_ptr<LevelDbWarmSnapshotCache> _warmSnapshotCache;
   FSTTransactionRunner _transactionRunner;
   FSTLevelDBLRUDelegate *_referenceDelegate;
   std::unique_ptr<LevelDbQueryCache> _queryCache;
+  // The users with pending mutations, collected on first use since only garbage collection needs
+  // them. Until then, holds the users whose mutation queue has been opened.
   std::set<std::string> _users;
+  BOOL _usersCollected;
   std::unique_ptr<LevelDbMutationQueue> _currentMutationQueue;
+  // The normalized ID of the user of the current mutation queue.
+  std::string _currentUserID;
+  std::shared_ptr<LevelDbSnapshotReaderCount> _snapshotReaders;
 }
 
 /**
@@ -305,7 +541,7 @@ static const char *kReservedPathComponent = "firestore";
   std::set<std::string> users;
 
   std::string tablePrefix = LevelDbMutationKey::KeyPrefix();
-  auto it = transaction->NewIterator();
+  auto it = transaction->NewMaintenanceIterator();
   it->Seek(tablePrefix);
   LevelDbMutationKey rowKey;
   while (it->Valid() && absl::StartsWith(it->key(), tablePrefix) && rowKey.Decode(it->key())) {
@@ -322,46 +558,81 @@ static const char *kReservedPathComponent = "firestore";
                                           serializer:(FSTLocalSerializer *)serializer
                                            lruParams:
                                                (firebase::firestore::local::LruParams)lruParams
+                                 persistenceSettings:
+                                     (const PersistenceSettings &)persistenceSettings
                                                  ptr:(FSTLevelDB **)ptr {
   Status status = [self ensureDirectory:directory];
   if (!status.ok()) return status;
 
-  StatusOr<std::unique_ptr<DB>> database = [self createDBWithDirectory:directory];
+  std::unique_ptr<leveldb::Cache> blockCache(
+      leveldb::NewLRUCache(static_cast<size_t>(persistenceSettings.block_cache_size_bytes)));
+  std::unique_ptr<const leveldb::FilterPolicy> filterPolicy;
+  if (persistenceSettings.bloom_filter_bits_per_key > 0) {
+    filterPolicy.reset(
+        leveldb::NewBloomFilterPolicy(persistenceSettings.bloom_filter_bits_per_key));
+  }
+
+  Options options;
+  options.create_if_missing = true;
+  options.block_cache = blockCache.get();
+  options.filter_policy = filterPolicy.get();
+  options.write_buffer_size = static_cast<size_t>(persistenceSettings.write_buffer_size_bytes);
+  options.compression = persistenceSettings.compression_enabled ? leveldb::kSnappyCompression
+                                                                : leveldb::kNoCompression;
+
+  TraceSpan openSpan{"Opening LevelDB"};
+  StatusOr<std::unique_ptr<DB>> database = [self createDBWithDirectory:directory options:options];
   if (!database.status().ok()) {
     return database.status();
   }
+  openSpan.End();
 
   std::unique_ptr<DB> ldb = std::move(database.ValueOrDie());
-  LevelDbMigrations::RunMigrations(ldb.get());
-  LevelDbTransaction transaction(ldb.get(), "Start LevelDB");
-  std::set<std::string> users = [self collectUserSet:&transaction];
-  transaction.Commit();
+  TraceSpan migrationsSpan{"Running LevelDB migrations"};
+  LevelDbMigrations::RunMigrations(ldb.get(), LevelDbMigrations::CurrentSchemaVersion(),
+                                   persistenceSettings.background_migrations_enabled);
+  migrationsSpan.End();
+
+  TraceSpan startSpan{"Starting LevelDB persistence"};
   FSTLevelDB *db = [[self alloc] initWithLevelDB:std::move(ldb)
-                                           users:users
                                        directory:directory
                                       serializer:serializer
                                        lruParams:lruParams];
+  db->_blockCache = std::move(blockCache);
+  db->_filterPolicy = std::move(filterPolicy);
+  db->_readOptions.verify_checksums = persistenceSettings.verify_checksums;
+  db->_syncWrites = persistenceSettings.sync_writes;
+  db->_syncInterval = std::chrono::milliseconds(persistenceSettings.sync_interval_ms);
+  db->_groupCommitEnabled = persistenceSettings.group_commit_delay_ms > 0;
+  db->_documentCache->set_native_serialization_enabled(
+      persistenceSettings.native_serialization_enabled);
+  db->_documentCache->set_value_compression_enabled(
+      persistenceSettings.value_compression_enabled);
+  db->_queryCache->set_compact_target_documents_enabled(
+      persistenceSettings.compact_target_documents_enabled);
   *ptr = db;
   return Status::OK();
 }
 
 - (instancetype)initWithLevelDB:(std::unique_ptr<leveldb::DB>)db
-                          users:(std::set<std::string>)users
                       directory:(firebase::firestore::util::Path)directory
                      serializer:(FSTLocalSerializer *)serializer
                       lruParams:(firebase::firestore::local::LruParams)lruParams {
   if (self = [super init]) {
     self.started = YES;
     _ptr = std::move(db);
+    _readOptions = [FSTLevelDB standardReadOptions];
+    _snapshotReaders = std::make_shared<LevelDbSnapshotReaderCount>();
+    _exporting = std::make_shared<std::atomic<bool>>(false);
     _directory = std::move(directory);
     _serializer = serializer;
     _queryCache = absl::make_unique<LevelDbQueryCache>(self, _serializer);
     _documentCache = absl::make_unique<LevelDbRemoteDocumentCache>(self, _serializer);
     _indexManager = absl::make_unique<LevelDbIndexManager>(self);
+    _warmSnapshotCache = absl::make_unique<LevelDbWarmSnapshotCache>(self, _serializer);
     _referenceDelegate = [[FSTLevelDBLRUDelegate alloc] initWithPersistence:self
                                                                   lruParams:lruParams];
     _transactionRunner.SetBackingPersistence(self);
-    _users = std::move(users);
     // TODO(gsoltis): set up a leveldb transaction for these operations.
     _queryCache->Start();
     [_referenceDelegate start];
@@ -370,23 +641,74 @@ static const char *kReservedPathComponent = "firestore";
 }
 
 - (size_t)byteSize {
-  int64_t count = 0;
-  auto iter = util::DirectoryIterator::Create(_directory);
-  for (; iter->Valid(); iter->Next()) {
-    int64_t fileSize = util::FileSize(iter->file()).ValueOrDie();
-    count += fileSize;
-  }
-  HARD_ASSERT(iter->status().ok(), "Failed to iterate leveldb directory: %s",
-              iter->status().error_message().c_str());
-  HARD_ASSERT(count >= 0 && count <= SIZE_MAX, "Overflowed counting bytes cached");
+  int64_t count = _queryCache->byte_size();
+  HARD_ASSERT(count >= 0 && count <= SIZE_MAX, "Invalid count of bytes cached: %s", count);
   return static_cast<size_t>(count);
 }
 
+- (void)adjustByteSize:(int64_t)delta {
+  _queryCache->AdjustByteSize(delta);
+}
+
+- (BOOL)runMigrationBackfillStep {
+  HARD_ASSERT(_transaction == nullptr, "Running a migration step inside a transaction");
+  [self flushGroupCommit];
+  return LevelDbMigrations::RunBackfillStep(
+      _ptr.get(), kMigrationBackfillRowsPerStep,
+      [](LevelDbMigrations::SchemaVersion version, int64_t rows, bool done) {
+        LOG_DEBUG("Migration %s backfilled %s rows%s", version, rows, done ? ", done" : "");
+      });
+}
+
+- (std::string)statistics {
+  std::string stats;
+  _ptr->GetProperty("leveldb.stats", &stats);
+
+  std::string memoryUsage;
+  if (_ptr->GetProperty("leveldb.approximate-memory-usage", &memoryUsage)) {
+    absl::StrAppend(&stats, "Approximate memory usage: ", memoryUsage, "\n");
+  }
+  if (_blockCache) {
+    absl::StrAppend(&stats, "Block cache usage: ", _blockCache->TotalCharge(), "\n");
+  }
+  return stats;
+}
+
+- (void)collectMemoryStats:(MemoryStats *)stats documentSizer:(const DocumentSizer &)sizer {
+  size_t blockCacheBytes = _blockCache ? _blockCache->TotalCharge() : 0;
+  stats->leveldb_block_cache_bytes += blockCacheBytes;
+
+  // The approximate memory usage of LevelDB covers its block cache and memtables.
+  std::string memoryUsage;
+  size_t totalBytes = 0;
+  if (_ptr->GetProperty("leveldb.approximate-memory-usage", &memoryUsage) &&
+      absl::SimpleAtoi(memoryUsage, &totalBytes) && totalBytes > blockCacheBytes) {
+    stats->leveldb_memtable_bytes += totalBytes - blockCacheBytes;
+  }
+}
+
+- (void)releaseRebuildableMemory {
+  if (_blockCache) {
+    _blockCache->Prune();
+  }
+}
+
 - (const std::set<std::string> &)users {
+  if (!_usersCollected) {
+    LevelDbTransaction transaction(_ptr.get(), "Collect users");
+    std::set<std::string> users = [FSTLevelDB collectUserSet:&transaction];
+    _users.insert(users.begin(), users.end());
+    _usersCollected = YES;
+  }
   return _users;
 }
 
 - (leveldb::DB *)ptr {
+  // Callers read the database directly, so they must see the commits held back. Inside a
+  // transaction, those are only visible through it.
+  if (_transaction == nullptr) {
+    [self flushGroupCommit];
+  }
   return _ptr.get();
 }
 
@@ -455,10 +777,8 @@ static const char *kReservedPathComponent = "firestore";
 }
 
 /** Opens the database within the given directory. */
-+ (StatusOr<std::unique_ptr<DB>>)createDBWithDirectory:(const Path &)directory {
-  Options options;
-  options.create_if_missing = true;
-
++ (StatusOr<std::unique_ptr<DB>>)createDBWithDirectory:(const Path &)directory
+                                               options:(const Options &)options {
   DB *database = nullptr;
   leveldb::Status status = DB::Open(options, directory.ToUtf8String(), &database);
   if (!status.ok()) {
@@ -478,16 +798,27 @@ static const char *kReservedPathComponent = "firestore";
 #pragma mark - Persistence Factory methods
 
 - (LevelDbMutationQueue *)mutationQueueForUser:(const User &)user {
+  // The new queue reads the next batch ID directly from the database.
+  [self flushGroupCommit];
   _users.insert(user.uid());
+  _currentUserID = user.is_authenticated() ? user.uid() : "";
   _currentMutationQueue.reset(new LevelDbMutationQueue(user, self, self.serializer));
   return _currentMutationQueue.get();
 }
 
+- (std::unique_ptr<LevelDbSnapshotReader>)newSnapshotReader {
+  HARD_ASSERT(self.isStarted, "Can't read from a snapshot of a shut down FSTLevelDB");
+  HARD_ASSERT(_currentMutationQueue, "Snapshot reader created before the mutation queue");
+  [self flushGroupCommit];
+  return absl::make_unique<LevelDbSnapshotReader>(_ptr.get(), _readOptions, _serializer,
+                                                  _currentUserID, _snapshotReaders);
+}
+
 - (LevelDbQueryCache *)queryCache {
   return _queryCache.get();
 }
 
-- (RemoteDocumentCache *)remoteDocumentCache {
+- (LevelDbRemoteDocumentCache *)remoteDocumentCache {
   return _documentCache.get();
 }
 
@@ -495,22 +826,141 @@ static const char *kReservedPathComponent = "firestore";
   return _indexManager.get();
 }
 
+- (LevelDbWarmSnapshotCache *)warmSnapshotCache {
+  return _warmSnapshotCache.get();
+}
+
 - (void)startTransaction:(absl::string_view)label {
   HARD_ASSERT(_transaction == nullptr, "Starting a transaction while one is already outstanding");
-  _transaction = absl::make_unique<LevelDbTransaction>(_ptr.get(), label);
+  if (_groupCommit) {
+    _transaction = std::move(_groupCommit);
+  } else {
+    _transaction = absl::make_unique<LevelDbTransaction>(_ptr.get(), label, _readOptions);
+  }
   [_referenceDelegate transactionWillStart];
 }
 
 - (void)commitTransaction {
   HARD_ASSERT(_transaction != nullptr, "Committing a transaction before one is started");
   [_referenceDelegate transactionWillCommit];
-  _transaction->Commit();
-  _transaction.reset();
+  if (_groupCommitEnabled && _transaction->changed_keys() < kGroupCommitMaxChangedKeys) {
+    BOOL groupStarted = !_groupCommitPending;
+    _groupCommit = std::move(_transaction);
+    _groupCommitPending = YES;
+    if (groupStarted && self.groupCommitHandler) {
+      self.groupCommitHandler();
+    }
+  } else {
+    [self writeTransaction:_transaction.get()];
+    _transaction.reset();
+    _groupCommitPending = NO;
+  }
+  [_referenceDelegate transactionDidCommit];
+}
+
+- (void)flushGroupCommit {
+  HARD_ASSERT(_transaction == nullptr, "Flushing the group commit inside a transaction");
+  if (_groupCommit) {
+    [self writeTransaction:_groupCommit.get()];
+    _groupCommit.reset();
+  }
+  _groupCommitPending = NO;
+}
+
+/** Writes the changes of the given transaction, synced if the durability settings call for it. */
+- (void)writeTransaction:(LevelDbTransaction *)transaction {
+  auto now = std::chrono::steady_clock::now();
+  WriteOptions options;
+  options.sync = _syncWrites ||
+                 (_syncInterval.count() > 0 && now - _lastSyncTime >= _syncInterval);
+  transaction->Commit(options);
+  ++_writtenTransactionCount;
+  if (options.sync) {
+    _lastSyncTime = now;
+  }
+}
+
+- (void)compactDocumentsFrom:(const DocumentKey &)first through:(const DocumentKey &)last {
+  const std::vector<std::pair<std::string, std::string>> ranges{
+      {LevelDbRemoteDocumentKey::Key(first), LevelDbRemoteDocumentKey::Key(last)},
+      {LevelDbDocumentTargetKey::SentinelKey(first), LevelDbDocumentTargetKey::SentinelKey(last)},
+  };
+  DB *db = _ptr.get();
+  // Counted like a snapshot reader, so that shutdown waits for the compaction to finish.
+  std::shared_ptr<LevelDbSnapshotReaderCount> users = _snapshotReaders;
+  users->Acquire();
+  dispatch_async(dispatch_get_global_queue(QOS_CLASS_BACKGROUND, 0), ^{
+    for (const auto &range : ranges) {
+      leveldb::Slice begin = range.first;
+      leveldb::Slice end = range.second;
+      db->CompactRange(&begin, &end);
+    }
+    users->Release();
+  });
+}
+
+- (void)exportSnapshotToDirectory:(const Path &)directory {
+  HARD_ASSERT(self.isStarted, "Can't export a shut down FSTLevelDB");
+  if (_transaction == nullptr) {
+    [self flushGroupCommit];
+  }
+  if (_exportedTransactionCount == _writtenTransactionCount || _exporting->exchange(true)) {
+    return;
+  }
+  _exportedTransactionCount = _writtenTransactionCount;
+
+  DB *db = _ptr.get();
+  const leveldb::Snapshot *snapshot = db->GetSnapshot();
+  Path exportDirectory = directory;
+  std::shared_ptr<std::atomic<bool>> exporting = _exporting;
+  // Counted like a snapshot reader, so that shutdown waits for the export to finish.
+  std::shared_ptr<LevelDbSnapshotReaderCount> users = _snapshotReaders;
+  users->Acquire();
+  dispatch_async(dispatch_get_global_queue(QOS_CLASS_BACKGROUND, 0), ^{
+    TraceSpan span{"Exporting LevelDB snapshot"};
+    Status status = ExportSnapshot(db, snapshot, exportDirectory);
+    if (!status.ok()) {
+      LOG_WARN("Failed to export the local cache to %s: %s", exportDirectory.ToUtf8String(),
+               status.ToString());
+    }
+    db->ReleaseSnapshot(snapshot);
+    exporting->store(false);
+    users->Release();
+  });
+}
+
++ (Status)copyLatestExportFromDirectory:(const Path &)exportDirectory
+                            toDirectory:(const Path &)directory {
+  Status status = util::RecursivelyDelete(directory);
+  if (!status.ok()) return status;
+
+  StatusOr<std::string> latest = util::ReadFile(exportDirectory.AppendUtf8(kLatestExportFile));
+  if (!latest.ok()) {
+    // Nothing was exported yet; start from an empty cache.
+    return [self ensureDirectory:directory];
+  }
+
+  status = util::RecursivelyCreateDir(directory.Dirname());
+  if (!status.ok()) return status;
+  Path source = exportDirectory.AppendUtf8(latest.ValueOrDie());
+  NSError *error;
+  if (![[NSFileManager defaultManager] copyItemAtPath:source.ToNSString()
+                                               toPath:directory.ToNSString()
+                                                error:&error]) {
+    return Status{FirestoreErrorCode::Internal,
+                  StringFormat("Failed to copy the export at %s", source.ToUtf8String())}
+        .CausedBy(Status::FromNSError(error));
+  }
+  return [self ensureDirectory:directory];
 }
 
 - (void)shutdown {
   HARD_ASSERT(self.isStarted, "FSTLevelDB shutdown without start!");
   self.started = NO;
+  LOG_DEBUG("Shutting down LevelDB. Statistics:\n%s", [self statistics]);
+  [self flushGroupCommit];
+  // Readers of snapshots and compactions may still be running on other threads.
+  _snapshotReaders->WaitForReaders();
   _ptr.reset();
 }
 
@@ -16,6 +16,8 @@
 
 #import <Foundation/Foundation.h>
 
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 
 @class FSTMaybeDocument;
@@ -46,6 +48,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)init NS_UNAVAILABLE;
 
+/** The serializer for the Firestore v1 RPC protocol that this serializer delegates to. */
+@property(nonatomic, strong, readonly) FSTSerializerBeta *remoteSerializer;
+
 /** Encodes an FSTMaybeDocument model to the equivalent protocol buffer for local storage. */
 - (FSTPBMaybeDocument *)encodedMaybeDocument:(FSTMaybeDocument *)document;
 
@@ -70,6 +75,18 @@ NS_ASSUME_NONNULL_BEGIN
 /** Decodes a GPBTimestamp proto into a SnapshotVersion model. */
 - (model::SnapshotVersion)decodedVersion:(GPBTimestamp *)version;
 
+/**
+ * Decodes a bundle: a length-delimited `Target` describing the query whose results the bundle
+ * holds, followed by any number of length-delimited `MaybeDocument`s. The `targetId` and
+ * `lastListenSequenceNumber` of the target are ignored by the local store.
+ *
+ * @return The decoded target, with its documents appended to `documents`, or nil (setting `error`)
+ *     if the bundle is malformed.
+ */
+- (nullable FSTQueryData *)decodedBundle:(NSData *)bundle
+                               documents:(std::vector<FSTMaybeDocument *> *)documents
+                                   error:(NSError **)error;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -20,6 +20,8 @@
 #include <utility>
 #include <vector>
 
+#import <Protobuf/GPBCodedInputStream.h>
+
 #import "FIRTimestamp.h"
 #import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
 #import "Firestore/Protos/objc/firestore/local/Mutation.pbobjc.h"
@@ -32,22 +34,20 @@
 #import "Firestore/Source/Model/FSTMutationBatch.h"
 #import "Firestore/Source/Remote/FSTSerializerBeta.h"
 
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 
 using firebase::Timestamp;
+using firebase::firestore::FirestoreErrorCode;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
-
-@interface FSTLocalSerializer ()
-
-@property(nonatomic, strong, readonly) FSTSerializerBeta *remoteSerializer;
-
-@end
+using firebase::firestore::util::MakeNSError;
 
 /** Serializer for values stored in the LocalStore. */
 @implementation FSTLocalSerializer
@@ -232,7 +232,7 @@ using firebase::firestore::model::TargetId;
   proto.resumeToken = queryData.resumeToken;
 
   FSTQuery *query = queryData.query;
-  if ([query isDocumentQuery]) {
+  if ([query isDocumentQuery] || [query isDocumentKeysQuery]) {
     proto.documents = [remoteSerializer encodedDocumentsTarget:query];
   } else {
     proto.query = [remoteSerializer encodedQueryTarget:query];
@@ -279,4 +279,43 @@ using firebase::firestore::model::TargetId;
   return [self.remoteSerializer decodedVersion:version];
 }
 
+- (nullable FSTQueryData *)decodedBundle:(NSData *)bundle
+                               documents:(std::vector<FSTMaybeDocument *> *)documents
+                                   error:(NSError **)error {
+  GPBCodedInputStream *input = [GPBCodedInputStream streamWithData:bundle];
+
+  FSTPBTarget *target = [FSTPBTarget parseDelimitedFromCodedInputStream:input
+                                                      extensionRegistry:nil
+                                                                  error:error];
+  if (!target) {
+    return nil;
+  }
+  if (target.targetTypeOneOfCase == FSTPBTarget_TargetType_OneOfCase_GPBUnsetOneOfCase) {
+    if (error) {
+      *error = MakeNSError(FirestoreErrorCode::InvalidArgument, "Bundle target has no query");
+    }
+    return nil;
+  }
+
+  while (![input isAtEnd]) {
+    FSTPBMaybeDocument *proto = [FSTPBMaybeDocument parseDelimitedFromCodedInputStream:input
+                                                                     extensionRegistry:nil
+                                                                                 error:error];
+    if (!proto) {
+      return nil;
+    }
+    if (proto.documentTypeOneOfCase ==
+        FSTPBMaybeDocument_DocumentType_OneOfCase_GPBUnsetOneOfCase) {
+      if (error) {
+        *error = MakeNSError(FirestoreErrorCode::InvalidArgument,
+                             "Bundle contains a document of unknown type");
+      }
+      return nil;
+    }
+    documents->push_back([self decodedMaybeDocument:proto]);
+  }
+
+  return [self decodedQueryData:target];
+}
+
 @end
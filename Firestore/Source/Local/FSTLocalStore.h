@@ -21,11 +21,16 @@
 #import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
 
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/document_sizer.h"
+#include "Firestore/core/src/firebase/firestore/core/memory_stats.h"
+#include "Firestore/core/src/firebase/firestore/local/query_execution_stats.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -39,6 +44,7 @@ class RemoteEvent;
 
 @class FSTLocalViewChanges;
 @class FSTLocalWriteResult;
+@class FSTMaybeDocument;
 @class FSTMutation;
 @class FSTMutationBatch;
 @class FSTMutationBatchResult;
@@ -47,6 +53,7 @@ class RemoteEvent;
 @protocol FSTPersistence;
 
 namespace auth = firebase::firestore::auth;
+namespace core = firebase::firestore::core;
 namespace local = firebase::firestore::local;
 namespace model = firebase::firestore::model;
 namespace remote = firebase::firestore::remote;
@@ -96,6 +103,28 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)init NS_UNAVAILABLE;
 
+/**
+ * The maximum number of document updates of a remote event that are committed in one transaction,
+ * or 0 (the default) to apply each remote event in a single transaction. Large events, such as the
+ * initial sync of a big query, are otherwise buffered in memory in their entirety until they are
+ * committed. The target metadata of an event is always committed atomically, after its documents.
+ */
+@property(nonatomic, assign) size_t remoteDocumentBatchSize;
+
+/**
+ * The number of most recently active targets whose last synced results are kept as warm snapshots,
+ * or 0 (the default) to keep none. See `warmSnapshotForTarget:`.
+ */
+@property(nonatomic, assign) size_t warmSnapshotTargetCount;
+
+/**
+ * Whether writes that overwrite documents remove earlier pending batches they make redundant: a
+ * batch of sets that hasn't been handed to the remote store yet is dropped when a later batch sets
+ * every document it writes, and no other batch wrote those documents in between. The dropped batch
+ * completes with the outcome of the batch that overwrote it. Defaults to NO.
+ */
+@property(nonatomic, assign) BOOL pendingWriteCompactionEnabled;
+
 /** Performs any initial startup actions required by the local store. */
 - (void)start;
 
@@ -107,7 +136,11 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (model::MaybeDocumentMap)userDidChange:(const auth::User &)user;
 
-/** Accepts locally generated Mutations and commits them to storage. */
+/**
+ * Accepts locally generated Mutations and commits them to storage. Mutations that only transform
+ * fields may be folded into the previous batch if it hasn't been sent yet, in which case the
+ * result carries that batch's ID.
+ */
 - (FSTLocalWriteResult *)locallyWriteMutations:(std::vector<FSTMutation *> &&)mutations;
 
 /** Returns the current value of a document with a given key, or nil if not found. */
@@ -161,6 +194,20 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (model::MaybeDocumentMap)applyRemoteEvent:(const remote::RemoteEvent &)remoteEvent;
 
+/**
+ * Writes the documents of a bundle (see -[FSTLocalSerializer decodedBundle:documents:error:])
+ * straight into the remote document cache, skipping documents the cache has newer versions of.
+ *
+ * The bundle's query becomes an inactive target that matches the bundle's documents and resumes
+ * from the bundle's read time and resume token, so that listening to it afterwards only fetches
+ * what changed since the bundle was built. A target that is active or already more recent than the
+ * bundle keeps its state.
+ *
+ * @return The local view of the documents that changed, as with applyRemoteEvent.
+ */
+- (model::MaybeDocumentMap)loadBundleDocuments:(const std::vector<FSTMaybeDocument *> &)documents
+                                     queryData:(FSTQueryData *)bundleQueryData;
+
 /**
  * Returns the keys of the documents that are associated with the given targetID in the remote
  * table.
@@ -179,9 +226,31 @@ NS_ASSUME_NONNULL_BEGIN
 /** Runs @a query against all the documents in the local store and returns the results. */
 - (model::DocumentMap)executeQuery:(FSTQuery *)query;
 
+/**
+ * Runs @a query like `executeQuery:`, and adds to @a stats how the query was executed.
+ */
+- (model::DocumentMap)executeQuery:(FSTQuery *)query
+                             stats:(nullable local::QueryExecutionStats *)stats;
+
 /** Notify the local store of the changed views to locally pin / unpin documents. */
 - (void)notifyLocalViewChanges:(NSArray<FSTLocalViewChanges *> *)viewChanges;
 
+/**
+ * Saves the remote documents with the given keys, the results of the target that are in sync with
+ * the backend, as the warm snapshot of the target. Saves of a target are throttled, so the saved
+ * snapshot may lag behind.
+ */
+- (void)saveWarmSnapshotOfDocumentsWithKeys:(const model::DocumentKeySet &)keys
+                                  forTarget:(model::TargetId)targetID;
+
+/**
+ * Returns the documents last saved as the warm snapshot of the target, or nullopt if there are
+ * none. Unlike the results of `executeQuery:`, these may be out of date and don't reflect local
+ * mutations, but they are read from a single row, which makes them a fast first approximation of
+ * the results of a query after a restart.
+ */
+- (absl::optional<model::DocumentMap>)warmSnapshotForTarget:(model::TargetId)targetID;
+
 /**
  * Gets the mutation batch after the passed in batchId in the mutation queue or nil if empty.
  *
@@ -192,6 +261,19 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (local::LruResults)collectGarbage:(FSTLRUGarbageCollector *)garbageCollector;
 
+/**
+ * Adds the estimated sizes of the local documents overlay and of the caches of the persistence
+ * layer to `stats`, using `sizer` to estimate the size of a document.
+ */
+- (void)collectMemoryStats:(core::MemoryStats *)stats
+             documentSizer:(const core::DocumentSizer &)sizer;
+
+/**
+ * Drops the local documents overlay and the caches of the persistence layer that can be rebuilt
+ * from disk, e.g. in response to a low memory warning.
+ */
+- (void)releaseRebuildableMemory;
+
 @end
 
 NS_ASSUME_NONNULL_END
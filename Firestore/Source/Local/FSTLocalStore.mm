@@ -16,6 +16,8 @@
 
 #import "Firestore/Source/Local/FSTLocalStore.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <set>
 #include <unordered_map>
@@ -38,32 +40,45 @@
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
 #include "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
+#include "Firestore/core/src/firebase/firestore/local/projected_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/query_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/warm_snapshot_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/trace_span.h"
 #include "absl/memory/memory.h"
 
 using firebase::firestore::auth::User;
+using firebase::firestore::core::DocumentSizer;
+using firebase::firestore::core::MemoryStats;
 using firebase::firestore::core::TargetIdGenerator;
 using firebase::firestore::local::LocalDocumentsView;
 using firebase::firestore::local::LruResults;
 using firebase::firestore::local::MutationQueue;
+using firebase::firestore::local::ProjectedDocumentCache;
 using firebase::firestore::local::QueryCache;
+using firebase::firestore::local::QueryExecutionStats;
 using firebase::firestore::local::ReferenceSet;
 using firebase::firestore::local::RemoteDocumentCache;
+using firebase::firestore::local::WarmSnapshotCache;
 using firebase::firestore::model::BatchId;
+using firebase::firestore::model::DocumentComparator;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentKeyHash;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
+using firebase::firestore::model::DocumentSet;
 using firebase::firestore::model::DocumentVersionMap;
 using firebase::firestore::model::FieldMask;
 using firebase::firestore::model::FieldPath;
+using firebase::firestore::model::kBatchIdUnknown;
 using firebase::firestore::model::MaybeDocumentMap;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::Precondition;
@@ -71,6 +86,7 @@ using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
 using firebase::firestore::remote::RemoteEvent;
 using firebase::firestore::remote::TargetChange;
+using firebase::firestore::util::TraceSpan;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -82,6 +98,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 
+/**
+ * The minimum time between two saves of the warm snapshot of a target. Each save encodes all of
+ * the target's results, so saving on every change would be too costly for large, busy queries.
+ */
+static const int64_t kWarmSnapshotMinSaveIntervalSeconds = 30;
+
+/** Iterates over the document updates of a RemoteEvent. */
+using DocumentUpdateIterator =
+    std::unordered_map<DocumentKey, FSTMaybeDocument *, DocumentKeyHash>::const_iterator;
+
 @interface FSTLocalStore ()
 
 /** Manages our in-memory or durable persistence. */
@@ -109,6 +135,47 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 
   /** Maps a targetID to data about its query. */
   std::unordered_map<TargetId, FSTQueryData *> _targetIDs;
+
+  /**
+   * For the targets whose views were last in sync with the server with no documents in limbo, the
+   * snapshot version as of which their matching keys were exactly the results of their queries.
+   * Queries of these targets only need to look at the documents updated since. Kept in memory
+   * only, so queries scan their collections again after a restart.
+   */
+  std::unordered_map<TargetId, SnapshotVersion> _limboFreeSnapshotVersions;
+
+  /**
+   * The snapshot version of the metadata last written for each active target. Writes of resume
+   * tokens are throttled (see shouldPersistQueryData), so this can lag behind `_targetIDs`.
+   */
+  std::unordered_map<TargetId, SnapshotVersion> _persistedSnapshotVersions;
+
+  /** The warm snapshots of recently active targets. */
+  WarmSnapshotCache *_warmSnapshotCache;
+
+  /** When the warm snapshot of each active target was last saved. */
+  std::unordered_map<TargetId, std::chrono::steady_clock::time_point> _warmSnapshotSaveTimes;
+
+  /** The partial documents of active targets whose queries have a projection. */
+  ProjectedDocumentCache _projectedDocuments;
+
+  /**
+   * The most recently written batch, while it's the last one in the mutation queue and hasn't been
+   * handed to the remote store yet. Transforms written right after it can be folded into it.
+   */
+  FSTMutationBatch *_Nullable _lastUnsentBatch;
+
+  /**
+   * When pending writes are compacted, the last batch written in this session that wrote each
+   * document, unless the remote store may have retrieved it already.
+   */
+  std::unordered_map<DocumentKey, BatchId, DocumentKeyHash> _lastBatchIDsByKey;
+
+  /** The highest batch ID the remote store retrieved since the mutation queue was switched. */
+  BatchId _lastRetrievedBatchID;
+
+  /** The ID of the last batch written since the mutation queue was switched. */
+  BatchId _lastWrittenBatchID;
 }
 
 - (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
@@ -118,16 +185,20 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
     _mutationQueue = [persistence mutationQueueForUser:initialUser];
     _remoteDocumentCache = [persistence remoteDocumentCache];
     _queryCache = [persistence queryCache];
+    _warmSnapshotCache = [persistence warmSnapshotCache];
     _localDocuments = absl::make_unique<LocalDocumentsView>(_remoteDocumentCache, _mutationQueue,
                                                             [_persistence indexManager]);
     [_persistence.referenceDelegate addInMemoryPins:&_localViewReferences];
 
     _targetIDGenerator = TargetIdGenerator::QueryCacheTargetIdGenerator(0);
+    _lastRetrievedBatchID = kBatchIdUnknown;
+    _lastWrittenBatchID = kBatchIdUnknown;
   }
   return self;
 }
 
 - (void)start {
+  TraceSpan span{"Starting FSTLocalStore"};
   [self startMutationQueue];
   TargetId targetID = _queryCache->highest_target_id();
   _targetIDGenerator = TargetIdGenerator::QueryCacheTargetIdGenerator(targetID);
@@ -145,8 +216,16 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 
   // The old one has a reference to the mutation queue, so nil it out first.
   _localDocuments.reset();
+  _lastUnsentBatch = nil;
+  _lastBatchIDsByKey.clear();
+  _lastRetrievedBatchID = kBatchIdUnknown;
+  _lastWrittenBatchID = kBatchIdUnknown;
   _mutationQueue = [self.persistence mutationQueueForUser:user];
 
+  // The new user may not be allowed to read the documents in the warm snapshots.
+  _warmSnapshotSaveTimes.clear();
+  self.persistence.run("Clear warm snapshots", [&]() { _warmSnapshotCache->RemoveAll(); });
+
   [self startMutationQueue];
 
   return self.persistence.run("NewBatches", [&]() -> MaybeDocumentMap {
@@ -161,7 +240,7 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
     for (const std::vector<FSTMutationBatch *> &batches : {oldBatches, newBatches}) {
       for (FSTMutationBatch *batch : batches) {
         for (FSTMutation *mutation : [batch mutations]) {
-          changedKeys = changedKeys.insert(mutation.key);
+          changedKeys = std::move(changedKeys).insert(mutation.key);
         }
       }
     }
@@ -175,7 +254,7 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   FIRTimestamp *localWriteTime = [FIRTimestamp timestamp];
   DocumentKeySet keys;
   for (FSTMutation *mutation : mutations) {
-    keys = keys.insert(mutation.key);
+    keys = std::move(keys).insert(mutation.key);
   }
 
   return self.persistence.run("Locally write mutations", [&]() -> FSTLocalWriteResult * {
@@ -183,6 +262,23 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
     // all non-idempotent transforms before applying any additional user-provided writes.
     MaybeDocumentMap existingDocuments = _localDocuments->GetDocuments(keys);
 
+    FSTMutationBatch *coalescedBatch = [self coalesceMutationsIntoLastUnsentBatch:mutations];
+    if (coalescedBatch) {
+      _lastUnsentBatch = coalescedBatch;
+      _localDocuments->InvalidateOverlays(keys);
+      // The existing documents already include the batch's earlier transforms, so only the new
+      // ones are applied on top of them.
+      std::vector<FSTMutation *> noBaseMutations;
+      FSTMutationBatch *newMutations =
+          [[FSTMutationBatch alloc] initWithBatchID:coalescedBatch.batchID
+                                     localWriteTime:localWriteTime
+                                      baseMutations:std::move(noBaseMutations)
+                                          mutations:std::move(mutations)];
+      MaybeDocumentMap changedDocuments = [newMutations applyToLocalDocumentSet:existingDocuments];
+      return [FSTLocalWriteResult resultForBatchID:coalescedBatch.batchID
+                                           changes:std::move(changedDocuments)];
+    }
+
     // For non-idempotent mutations (such as `FieldValue.increment()`), we record the base
     // state in a separate patch mutation. This is later used to guarantee consistent values
     // and prevents flicker even if the backend sends us an update that already includes our
@@ -217,10 +313,27 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
       }
     }
 
+    std::vector<BatchId> compactedBatchIDs;
+    if (self.pendingWriteCompactionEnabled) {
+      compactedBatchIDs = [self removeBatchesOverwrittenByMutations:mutations];
+    }
+
     FSTMutationBatch *batch = _mutationQueue->AddMutationBatch(
         localWriteTime, std::move(baseMutations), std::move(mutations));
+    _lastUnsentBatch = batch;
+    _lastWrittenBatchID = batch.batchID;
+    if (self.pendingWriteCompactionEnabled) {
+      for (const DocumentKey &key : keys) {
+        _lastBatchIDsByKey[key] = batch.batchID;
+      }
+    }
+    _localDocuments->InvalidateOverlays(keys);
+    // The existing documents still include the removed batches, but the new batch sets those
+    // documents before anything else, so the changes are the same.
     MaybeDocumentMap changedDocuments = [batch applyToLocalDocumentSet:existingDocuments];
-    return [FSTLocalWriteResult resultForBatchID:batch.batchID changes:std::move(changedDocuments)];
+    return [FSTLocalWriteResult resultForBatchID:batch.batchID
+                                         changes:std::move(changedDocuments)
+                               compactedBatchIDs:std::move(compactedBatchIDs)];
   });
 }
 
@@ -230,6 +343,7 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
     _mutationQueue->AcknowledgeBatch(batch, batchResult.streamToken);
     [self applyBatchResult:batchResult];
     _mutationQueue->PerformConsistencyCheck();
+    _localDocuments->InvalidateOverlays(batch.keys);
 
     return _localDocuments->GetDocuments(batch.keys);
   });
@@ -242,13 +356,16 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 
     _mutationQueue->RemoveMutationBatch(toReject);
     _mutationQueue->PerformConsistencyCheck();
+    _localDocuments->InvalidateOverlays(toReject.keys);
 
     return _localDocuments->GetDocuments(toReject.keys);
   });
 }
 
 - (nullable NSData *)lastStreamToken {
-  return _mutationQueue->GetLastStreamToken();
+  // The mutation queue may read its metadata on first use, which needs a transaction.
+  return self.persistence.run("Get last stream token",
+                              [&]() -> NSData * { return _mutationQueue->GetLastStreamToken(); });
 }
 
 - (void)setLastStreamToken:(nullable NSData *)streamToken {
@@ -261,109 +378,286 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 }
 
 - (MaybeDocumentMap)applyRemoteEvent:(const RemoteEvent &)remoteEvent {
-  return self.persistence.run("Apply remote event", [&]() -> MaybeDocumentMap {
-    // TODO(gsoltis): move the sequence number into the reference delegate.
-    ListenSequenceNumber sequenceNumber = self.persistence.currentSequenceNumber;
+  const auto &documentUpdates = remoteEvent.document_updates();
+  if (_remoteDocumentBatchSize == 0 || documentUpdates.size() <= _remoteDocumentBatchSize) {
+    return self.persistence.run("Apply remote event", [&]() -> MaybeDocumentMap {
+      DocumentKeySet authoritativeUpdates = [self authoritativeUpdatesInRemoteEvent:remoteEvent];
+      [self applyTargetChangesInRemoteEvent:remoteEvent];
+      MaybeDocumentMap changedDocs = [self applyDocumentUpdatesInRemoteEvent:remoteEvent
+                                                                       from:documentUpdates.begin()
+                                                                         to:documentUpdates.end()
+                                                       authoritativeUpdates:authoritativeUpdates
+                                                                changedDocs:MaybeDocumentMap{}];
+      return _localDocuments->GetLocalViewOfDocuments(changedDocs);
+    });
+  }
 
-    DocumentKeySet authoritativeUpdates;
-    for (const auto &entry : remoteEvent.target_changes()) {
-      TargetId targetID = entry.first;
-      const TargetChange &change = entry.second;
+  // Commit the documents in bounded batches, so that a large event (e.g. an initial sync) doesn't
+  // have to be buffered in a single transaction. The target metadata is only written once all of
+  // them are committed: if the process dies in between, the targets resume from their previous
+  // tokens and the documents are sent again.
+  DocumentKeySet authoritativeUpdates = [self authoritativeUpdatesInRemoteEvent:remoteEvent];
+  MaybeDocumentMap changedDocs;
+  auto batchBegin = documentUpdates.begin();
+  while (batchBegin != documentUpdates.end()) {
+    auto batchEnd = batchBegin;
+    for (size_t i = 0; i < _remoteDocumentBatchSize && batchEnd != documentUpdates.end(); ++i) {
+      ++batchEnd;
+    }
+    changedDocs = self.persistence.run("Apply remote event documents", [&]() -> MaybeDocumentMap {
+      return [self applyDocumentUpdatesInRemoteEvent:remoteEvent
+                                                from:batchBegin
+                                                  to:batchEnd
+                                authoritativeUpdates:authoritativeUpdates
+                                         changedDocs:std::move(changedDocs)];
+    });
+    batchBegin = batchEnd;
+  }
 
-      // Do not ref/unref unassigned targetIDs - it may lead to leaks.
-      auto found = _targetIDs.find(targetID);
-      if (found == _targetIDs.end()) {
-        continue;
-      }
-      FSTQueryData *queryData = found->second;
-
-      // When a global snapshot contains updates (either add or modify) we can completely trust
-      // these updates as authoritative and blindly apply them to our cache (as a defensive measure
-      // to promote self-healing in the unfortunate case that our cache is ever somehow corrupted /
-      // out-of-sync).
-      //
-      // If the document is only updated while removing it from a target then watch isn't obligated
-      // to send the absolute latest version: it can send the first version that caused the document
-      // not to match.
-      for (const DocumentKey &key : change.added_documents()) {
-        authoritativeUpdates = authoritativeUpdates.insert(key);
-      }
-      for (const DocumentKey &key : change.modified_documents()) {
-        authoritativeUpdates = authoritativeUpdates.insert(key);
+  return self.persistence.run("Apply remote event targets", [&]() -> MaybeDocumentMap {
+    [self applyTargetChangesInRemoteEvent:remoteEvent];
+    return _localDocuments->GetLocalViewOfDocuments(changedDocs);
+  });
+}
+
+/**
+ * Returns the keys of the documents in the remote event that can be trusted to be the latest
+ * version, for the targets this store knows about.
+ */
+- (DocumentKeySet)authoritativeUpdatesInRemoteEvent:(const RemoteEvent &)remoteEvent {
+  DocumentKeySet authoritativeUpdates;
+  for (const auto &entry : remoteEvent.target_changes()) {
+    // Do not ref/unref unassigned targetIDs - it may lead to leaks.
+    if (_targetIDs.find(entry.first) == _targetIDs.end()) {
+      continue;
+    }
+    const TargetChange &change = entry.second;
+
+    // When a global snapshot contains updates (either add or modify) we can completely trust
+    // these updates as authoritative and blindly apply them to our cache (as a defensive measure
+    // to promote self-healing in the unfortunate case that our cache is ever somehow corrupted /
+    // out-of-sync).
+    //
+    // If the document is only updated while removing it from a target then watch isn't obligated
+    // to send the absolute latest version: it can send the first version that caused the document
+    // not to match.
+    for (const DocumentKey &key : change.added_documents()) {
+      authoritativeUpdates = std::move(authoritativeUpdates).insert(key);
+    }
+    for (const DocumentKey &key : change.modified_documents()) {
+      authoritativeUpdates = std::move(authoritativeUpdates).insert(key);
+    }
+  }
+  return authoritativeUpdates;
+}
+
+/**
+ * Updates the target metadata (matching keys, resume tokens and the last remote snapshot version)
+ * from the remote event. Must be called in a transaction.
+ */
+- (void)applyTargetChangesInRemoteEvent:(const RemoteEvent &)remoteEvent {
+  // TODO(gsoltis): move the sequence number into the reference delegate.
+  ListenSequenceNumber sequenceNumber = self.persistence.currentSequenceNumber;
+
+  for (const auto &entry : remoteEvent.target_changes()) {
+    TargetId targetID = entry.first;
+    const TargetChange &change = entry.second;
+
+    // Do not ref/unref unassigned targetIDs - it may lead to leaks.
+    auto found = _targetIDs.find(targetID);
+    if (found == _targetIDs.end()) {
+      continue;
+    }
+    FSTQueryData *queryData = found->second;
+
+    if ([queryData.query hasProjection]) {
+      [self applyProjectedTargetChange:change
+                              toTarget:targetID
+                           remoteEvent:remoteEvent
+                        sequenceNumber:sequenceNumber];
+      continue;
+    }
+
+    _queryCache->RemoveMatchingKeys(change.removed_documents(), targetID);
+    _queryCache->AddMatchingKeys(change.added_documents(), targetID);
+    for (const DocumentKey &key : change.removed_documents()) {
+      if (remoteEvent.document_updates().find(key) == remoteEvent.document_updates().end()) {
+        // The document was dropped from the target without changing, e.g. because the target was
+        // reset: its matching keys are no longer a superset of its old results.
+        _limboFreeSnapshotVersions.erase(targetID);
+        break;
       }
+    }
 
-      _queryCache->RemoveMatchingKeys(change.removed_documents(), targetID);
-      _queryCache->AddMatchingKeys(change.added_documents(), targetID);
-
-      // Update the resume token if the change includes one. Don't clear any preexisting value.
-      // Bump the sequence number as well, so that documents being removed now are ordered later
-      // than documents that were previously removed from this target.
-      NSData *resumeToken = change.resume_token();
-      if (resumeToken.length > 0) {
-        FSTQueryData *oldQueryData = queryData;
-        queryData = [queryData queryDataByReplacingSnapshotVersion:remoteEvent.snapshot_version()
-                                                       resumeToken:resumeToken
-                                                    sequenceNumber:sequenceNumber];
-        _targetIDs[targetID] = queryData;
-
-        if ([self shouldPersistQueryData:queryData oldQueryData:oldQueryData change:change]) {
-          _queryCache->UpdateTarget(queryData);
-        }
+    // Update the resume token if the change includes one. Don't clear any preexisting value.
+    // Bump the sequence number as well, so that documents being removed now are ordered later
+    // than documents that were previously removed from this target.
+    NSData *resumeToken = change.resume_token();
+    if (resumeToken.length > 0) {
+      FSTQueryData *oldQueryData = queryData;
+      queryData = [queryData queryDataByReplacingSnapshotVersion:remoteEvent.snapshot_version()
+                                                     resumeToken:resumeToken
+                                                  sequenceNumber:sequenceNumber];
+      _targetIDs[targetID] = queryData;
+
+      if ([self shouldPersistQueryData:queryData
+                          oldQueryData:oldQueryData
+              persistedSnapshotVersion:_persistedSnapshotVersions[targetID]
+                                change:change]) {
+        _queryCache->UpdateTarget(queryData);
+        _persistedSnapshotVersions[targetID] = queryData.snapshotVersion;
       }
     }
+  }
+
+  // HACK: The only reason we allow omitting snapshot version is so we can synthesize remote
+  // events when we get permission denied errors while trying to resolve the state of a locally
+  // cached document that is in limbo.
+  const SnapshotVersion &lastRemoteVersion = _queryCache->GetLastRemoteSnapshotVersion();
+  const SnapshotVersion &remoteVersion = remoteEvent.snapshot_version();
+  if (remoteVersion != SnapshotVersion::None()) {
+    HARD_ASSERT(remoteVersion >= lastRemoteVersion,
+                "Watch stream reverted to previous snapshot?? (%s < %s)",
+                remoteVersion.timestamp().ToString(), lastRemoteVersion.timestamp().ToString());
+    _queryCache->SetLastRemoteSnapshotVersion(remoteVersion);
+  }
+}
 
-    MaybeDocumentMap changedDocs;
-    const DocumentKeySet &limboDocuments = remoteEvent.limbo_document_changes();
-    DocumentKeySet updatedKeys;
-    for (const auto &kv : remoteEvent.document_updates()) {
-      updatedKeys = updatedKeys.insert(kv.first);
+/**
+ * Applies the document updates in [begin, end) of the remote event to the remote document cache,
+ * adding the ones that were applied to changedDocs. Must be called in a transaction.
+ */
+- (MaybeDocumentMap)applyDocumentUpdatesInRemoteEvent:(const RemoteEvent &)remoteEvent
+                                                 from:(DocumentUpdateIterator)begin
+                                                   to:(DocumentUpdateIterator)end
+                                 authoritativeUpdates:(const DocumentKeySet &)authoritativeUpdates
+                                          changedDocs:(MaybeDocumentMap)changedDocs {
+  const DocumentKeySet &limboDocuments = remoteEvent.limbo_document_changes();
+  DocumentKeySet updatedKeys;
+  for (auto it = begin; it != end; ++it) {
+    updatedKeys = std::move(updatedKeys).insert(it->first);
+  }
+  // Each loop iteration only affects its "own" doc, so it's safe to get all the remote
+  // documents in advance in a single call.
+  MaybeDocumentMap existingDocs = _remoteDocumentCache->GetAll(updatedKeys);
+
+  for (auto it = begin; it != end; ++it) {
+    const DocumentKey &key = it->first;
+    FSTMaybeDocument *doc = it->second;
+    FSTMaybeDocument *existingDoc = nil;
+    auto foundExisting = existingDocs.find(key);
+    if (foundExisting != existingDocs.end()) {
+      existingDoc = foundExisting->second;
     }
-    // Each loop iteration only affects its "own" doc, so it's safe to get all the remote
-    // documents in advance in a single call.
-    MaybeDocumentMap existingDocs = _remoteDocumentCache->GetAll(updatedKeys);
 
-    for (const auto &kv : remoteEvent.document_updates()) {
-      const DocumentKey &key = kv.first;
-      FSTMaybeDocument *doc = kv.second;
-      FSTMaybeDocument *existingDoc = nil;
-      auto foundExisting = existingDocs.find(key);
-      if (foundExisting != existingDocs.end()) {
-        existingDoc = foundExisting->second;
-      }
+    // If a document update isn't authoritative, make sure we don't apply an old document version
+    // to the remote cache. We make an exception for SnapshotVersion.MIN which can happen for
+    // manufactured events (e.g. in the case of a limbo document resolution failing).
+    if (!existingDoc || doc.version == SnapshotVersion::None() ||
+        (authoritativeUpdates.contains(doc.key) && !existingDoc.hasPendingWrites) ||
+        doc.version >= existingDoc.version) {
+      _remoteDocumentCache->Add(doc, remoteEvent.snapshot_version());
+      changedDocs = std::move(changedDocs).insert(key, doc);
+    } else {
+      LOG_DEBUG("FSTLocalStore Ignoring outdated watch update for %s. "
+                "Current version: %s  Watch version: %s",
+                key.ToString(), existingDoc.version.timestamp().ToString(),
+                doc.version.timestamp().ToString());
+    }
 
-      // If a document update isn't authoritative, make sure we don't apply an old document version
-      // to the remote cache. We make an exception for SnapshotVersion.MIN which can happen for
-      // manufactured events (e.g. in the case of a limbo document resolution failing).
-      if (!existingDoc || doc.version == SnapshotVersion::None() ||
-          (authoritativeUpdates.contains(doc.key) && !existingDoc.hasPendingWrites) ||
-          doc.version >= existingDoc.version) {
-        _remoteDocumentCache->Add(doc);
-        changedDocs = changedDocs.insert(key, doc);
-      } else {
-        LOG_DEBUG("FSTLocalStore Ignoring outdated watch update for %s. "
-                  "Current version: %s  Watch version: %s",
-                  key.ToString(), existingDoc.version.timestamp().ToString(),
-                  doc.version.timestamp().ToString());
+    // If this was a limbo resolution, make sure we mark when it was accessed.
+    if (limboDocuments.contains(key)) {
+      [self.persistence.referenceDelegate limboDocumentUpdated:key];
+    }
+  }
+  return changedDocs;
+}
+
+/**
+ * Applies a change to a target whose query has a projection. The partial documents of such a
+ * target are only kept in memory, so neither its matching keys nor its resume token are persisted:
+ * after a restart, the target has to be synced from scratch to fill its documents again.
+ */
+- (void)applyProjectedTargetChange:(const TargetChange &)change
+                          toTarget:(TargetId)targetID
+                       remoteEvent:(const RemoteEvent &)remoteEvent
+                    sequenceNumber:(ListenSequenceNumber)sequenceNumber {
+  _projectedDocuments.Remove(targetID, change.removed_documents());
+  auto updates = remoteEvent.projected_document_updates().find(targetID);
+  if (updates != remoteEvent.projected_document_updates().end()) {
+    _projectedDocuments.Apply(targetID, updates->second);
+  }
+
+  // Keep the resume token in memory, so that the target can be resumed while this client runs.
+  NSData *resumeToken = change.resume_token();
+  if (resumeToken.length > 0) {
+    _targetIDs[targetID] =
+        [_targetIDs[targetID] queryDataByReplacingSnapshotVersion:remoteEvent.snapshot_version()
+                                                      resumeToken:resumeToken
+                                                   sequenceNumber:sequenceNumber];
+  }
+}
+
+- (MaybeDocumentMap)loadBundleDocuments:(const std::vector<FSTMaybeDocument *> &)documents
+                              queryData:(FSTQueryData *)bundleQueryData {
+  // Commit the documents in bounded batches, like a large remote event, and the target only once
+  // all of them are in: if the process dies in between, the query is fetched from scratch.
+  size_t batchSize = _remoteDocumentBatchSize == 0 ? documents.size() : _remoteDocumentBatchSize;
+  MaybeDocumentMap changedDocs;
+  DocumentKeySet matchingKeys;
+  auto batchBegin = documents.begin();
+  while (batchBegin != documents.end()) {
+    auto batchEnd =
+        batchBegin + std::min(batchSize, static_cast<size_t>(documents.end() - batchBegin));
+    changedDocs = self.persistence.run("Load bundle documents", [&]() -> MaybeDocumentMap {
+      DocumentKeySet keys;
+      for (auto it = batchBegin; it != batchEnd; ++it) {
+        keys = std::move(keys).insert((*it).key);
       }
+      MaybeDocumentMap existingDocs = _remoteDocumentCache->GetAll(keys);
+
+      MaybeDocumentMap result = std::move(changedDocs);
+      for (auto it = batchBegin; it != batchEnd; ++it) {
+        FSTMaybeDocument *doc = *it;
+        if ([doc isKindOfClass:[FSTDocument class]]) {
+          matchingKeys = std::move(matchingKeys).insert(doc.key);
+        }
 
-      // If this was a limbo resolution, make sure we mark when it was accessed.
-      if (limboDocuments.contains(key)) {
-        [self.persistence.referenceDelegate limboDocumentUpdated:key];
+        auto foundExisting = existingDocs.find(doc.key);
+        FSTMaybeDocument *existingDoc =
+            foundExisting != existingDocs.end() ? foundExisting->second : nil;
+        if (!existingDoc || doc.version >= existingDoc.version) {
+          _remoteDocumentCache->Add(doc, bundleQueryData.snapshotVersion);
+          result = std::move(result).insert(doc.key, doc);
+        }
       }
-    }
+      return result;
+    });
+    batchBegin = batchEnd;
+  }
 
-    // HACK: The only reason we allow omitting snapshot version is so we can synthesize remote
-    // events when we get permission denied errors while trying to resolve the state of a locally
-    // cached document that is in limbo.
-    const SnapshotVersion &lastRemoteVersion = _queryCache->GetLastRemoteSnapshotVersion();
-    const SnapshotVersion &remoteVersion = remoteEvent.snapshot_version();
-    if (remoteVersion != SnapshotVersion::None()) {
-      HARD_ASSERT(remoteVersion >= lastRemoteVersion,
-                  "Watch stream reverted to previous snapshot?? (%s < %s)",
-                  remoteVersion.timestamp().ToString(), lastRemoteVersion.timestamp().ToString());
-      _queryCache->SetLastRemoteSnapshotVersion(remoteVersion);
+  return self.persistence.run("Load bundle target", [&]() -> MaybeDocumentMap {
+    ListenSequenceNumber sequenceNumber = self.persistence.currentSequenceNumber;
+    FSTQueryData *queryData = _queryCache->GetTarget(bundleQueryData.query);
+    if (!queryData) {
+      queryData = [[FSTQueryData alloc] initWithQuery:bundleQueryData.query
+                                             targetID:_targetIDGenerator.NextId()
+                                 listenSequenceNumber:sequenceNumber
+                                              purpose:FSTQueryPurposeListen];
+      _queryCache->AddTarget(queryData);
     }
 
+    TargetId targetID = queryData.targetID;
+    if (_targetIDs.find(targetID) == _targetIDs.end() &&
+        bundleQueryData.snapshotVersion > queryData.snapshotVersion) {
+      // The bundle holds the complete results of the query as of its read time.
+      _queryCache->RemoveMatchingKeys(_queryCache->GetMatchingKeys(targetID), targetID);
+      _queryCache->AddMatchingKeys(matchingKeys, targetID);
+      _queryCache->UpdateTarget(
+          [queryData queryDataByReplacingSnapshotVersion:bundleQueryData.snapshotVersion
+                                             resumeToken:bundleQueryData.resumeToken
+                                          sequenceNumber:sequenceNumber]);
+    }
     return _localDocuments->GetLocalViewOfDocuments(changedDocs);
   });
 }
@@ -380,6 +674,7 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
  */
 - (BOOL)shouldPersistQueryData:(FSTQueryData *)newQueryData
                   oldQueryData:(FSTQueryData *)oldQueryData
+      persistedSnapshotVersion:(const SnapshotVersion &)persistedSnapshotVersion
                         change:(const TargetChange &)change {
   // Avoid clearing any existing value
   if (newQueryData.resumeToken.length == 0) return NO;
@@ -390,9 +685,10 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   // Don't allow resume token changes to be buffered indefinitely. This allows us to be reasonably
   // up-to-date after a crash and avoids needing to loop over all active queries on shutdown.
   // Especially in the browser we may not get time to do anything interesting while the current
-  // tab is closing.
+  // tab is closing. The age is measured from the last write rather than the last update, which
+  // happens on every event.
   int64_t newSeconds = newQueryData.snapshotVersion.timestamp().seconds();
-  int64_t oldSeconds = oldQueryData.snapshotVersion.timestamp().seconds();
+  int64_t oldSeconds = persistedSnapshotVersion.timestamp().seconds();
   int64_t timeDelta = newSeconds - oldSeconds;
   if (timeDelta >= kResumeTokenMaxAgeSeconds) return YES;
 
@@ -413,6 +709,12 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
       }
       _localViewReferences.AddReferences(viewChange.addedKeys, viewChange.targetID);
       _localViewReferences.AddReferences(viewChange.removedKeys, viewChange.targetID);
+
+      auto found = _targetIDs.find(viewChange.targetID);
+      if (!viewChange.fromCache && found != _targetIDs.end() &&
+          found->second.snapshotVersion != SnapshotVersion::None()) {
+        _limboFreeSnapshotVersions[viewChange.targetID] = found->second.snapshotVersion;
+      }
     }
   });
 }
@@ -422,9 +724,118 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
       self.persistence.run("NextMutationBatchAfterBatchID", [&]() -> FSTMutationBatch * {
         return _mutationQueue->NextMutationBatchAfterBatchId(batchID);
       });
+  if (result && _lastUnsentBatch && result.batchID >= _lastUnsentBatch.batchID) {
+    // The remote store may send the batch from now on, so it must no longer change.
+    _lastUnsentBatch = nil;
+  }
+  if (result) {
+    _lastRetrievedBatchID = std::max(_lastRetrievedBatchID, result.batchID);
+    if (_lastRetrievedBatchID >= _lastWrittenBatchID) {
+      // Nothing written so far can be compacted anymore.
+      _lastBatchIDsByKey.clear();
+    }
+  }
   return result;
 }
 
+/**
+ * Removes the pending batches that `mutations` make redundant. A batch is redundant if it only sets
+ * documents, was written in this session, hasn't been retrieved by the remote store, was the last
+ * batch to write each of its documents, and `mutations` set all of those documents unconditionally
+ * before doing anything else to them. The outcome of the new batch then doesn't depend on whether
+ * the removed ones were applied first.
+ *
+ * @return The IDs of the removed batches.
+ */
+- (std::vector<BatchId>)removeBatchesOverwrittenByMutations:
+    (const std::vector<FSTMutation *> &)mutations {
+  std::vector<BatchId> removedBatchIDs;
+  if (_lastBatchIDsByKey.empty()) {
+    return removedBatchIDs;
+  }
+
+  DocumentKeySet overwrittenKeys;
+  DocumentKeySet mutatedKeys;
+  for (FSTMutation *mutation : mutations) {
+    if (!mutatedKeys.contains(mutation.key) && [mutation isKindOfClass:[FSTSetMutation class]] &&
+        mutation.precondition.IsNone()) {
+      overwrittenKeys = overwrittenKeys.insert(mutation.key);
+    }
+    mutatedKeys = mutatedKeys.insert(mutation.key);
+  }
+
+  std::set<BatchId> candidateBatchIDs;
+  for (const DocumentKey &key : overwrittenKeys) {
+    auto found = _lastBatchIDsByKey.find(key);
+    if (found != _lastBatchIDsByKey.end() && found->second > _lastRetrievedBatchID) {
+      candidateBatchIDs.insert(found->second);
+    }
+  }
+
+  for (BatchId batchID : candidateBatchIDs) {
+    FSTMutationBatch *batch = _mutationQueue->LookupMutationBatch(batchID);
+    if (!batch) {
+      continue;
+    }
+    bool overwritten = true;
+    for (FSTMutation *mutation : batch.mutations) {
+      auto found = _lastBatchIDsByKey.find(mutation.key);
+      if (![mutation isKindOfClass:[FSTSetMutation class]] ||
+          !overwrittenKeys.contains(mutation.key) || found == _lastBatchIDsByKey.end() ||
+          found->second != batchID) {
+        overwritten = false;
+        break;
+      }
+    }
+    if (overwritten) {
+      _mutationQueue->RemoveMutationBatch(batch);
+      removedBatchIDs.push_back(batchID);
+    }
+  }
+  return removedBatchIDs;
+}
+
+/**
+ * Folds a write that only transforms fields of a document into the last batch written, if that
+ * batch transforms the same fields of the same document, hasn't been handed to the remote store
+ * yet and no other write came after it. This keeps repeated offline increments and array updates
+ * of a document in a single batch instead of queueing (and later uploading) one batch per write.
+ *
+ * The batch keeps its ID and base mutations, so its base values remain those from before its first
+ * transform.
+ *
+ * @return The replaced batch, or nil if the mutations need a batch of their own.
+ */
+- (nullable FSTMutationBatch *)coalesceMutationsIntoLastUnsentBatch:
+    (const std::vector<FSTMutation *> &)mutations {
+  if (!_lastUnsentBatch) {
+    return nil;
+  }
+
+  // Updates and merges that only transform fields are written as an empty patch followed by the
+  // transform.
+  auto onlyTransforms = [](const std::vector<FSTMutation *> &batchMutations) {
+    return batchMutations.size() == 2 &&
+           [batchMutations[0] isKindOfClass:[FSTPatchMutation class]] &&
+           batchMutations[0].fieldMask->size() == 0 &&
+           [batchMutations[1] isKindOfClass:[FSTTransformMutation class]];
+  };
+  const std::vector<FSTMutation *> &lastMutations = _lastUnsentBatch.mutations;
+  if (!onlyTransforms(lastMutations) || !onlyTransforms(mutations) ||
+      lastMutations[0].key != mutations[0].key ||
+      !(lastMutations[0].precondition == mutations[0].precondition)) {
+    return nil;
+  }
+
+  FSTTransformMutation *lastTransform = (FSTTransformMutation *)lastMutations[1];
+  FSTTransformMutation *coalesced = [lastTransform
+      transformMutationByCoalescingMutation:(FSTTransformMutation *)mutations[1]];
+  if (!coalesced) {
+    return nil;
+  }
+  return _mutationQueue->ReplaceMutationBatch(_lastUnsentBatch, {lastMutations[0], coalesced});
+}
+
 - (nullable FSTMaybeDocument *)readDocument:(const DocumentKey &)key {
   return self.persistence.run("ReadDocument", [&]() -> FSTMaybeDocument *_Nullable {
     return _localDocuments->GetDocument(key);
@@ -449,6 +860,7 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   HARD_ASSERT(_targetIDs.find(targetID) == _targetIDs.end(),
               "Tried to allocate an already allocated query: %s", query);
   _targetIDs[targetID] = queryData;
+  _persistedSnapshotVersions[targetID] = queryData.snapshotVersion;
   return queryData;
 }
 
@@ -461,7 +873,10 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 
     auto found = _targetIDs.find(targetID);
     FSTQueryData *cachedQueryData = found != _targetIDs.end() ? found->second : nil;
-    if (cachedQueryData.snapshotVersion > queryData.snapshotVersion) {
+    if ([query hasProjection]) {
+      // The documents of the target are gone with it, so its resume token must not survive it.
+      _projectedDocuments.RemoveTarget(targetID);
+    } else if (cachedQueryData.snapshotVersion > queryData.snapshotVersion) {
       // If we've been avoiding persisting the resumeToken (see shouldPersistQueryData for
       // conditions and rationale) we need to persist the token now because there will no
       // longer be an in-memory version to fall back on.
@@ -478,17 +893,84 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
       [self.persistence.referenceDelegate removeReference:key];
     }
     _targetIDs.erase(targetID);
+    _persistedSnapshotVersions.erase(targetID);
+    _warmSnapshotSaveTimes.erase(targetID);
     [self.persistence.referenceDelegate removeTarget:queryData];
   });
 }
 
 - (DocumentMap)executeQuery:(FSTQuery *)query {
+  return [self executeQuery:query stats:nullptr];
+}
+
+- (DocumentMap)executeQuery:(FSTQuery *)query stats:(nullable QueryExecutionStats *)stats {
+  if ([query hasProjection]) {
+    // A projection query can only be served by the partial documents of its own target.
+    FSTQueryData *queryData =
+        self.persistence.run("ExecuteProjectionQuery",
+                             [&]() -> FSTQueryData * { return _queryCache->GetTarget(query); });
+    if (!queryData) {
+      return DocumentMap{};
+    }
+    return _projectedDocuments.GetMatching(queryData.targetID, query);
+  }
   return self.persistence.run("ExecuteQuery", [&]() -> DocumentMap {
-    return _localDocuments->GetDocumentsMatchingQuery(query);
+    if (!_limboFreeSnapshotVersions.empty()) {
+      // Start from the documents of the query's target if we know which of them matched.
+      FSTQueryData *queryData = _queryCache->GetTarget(query);
+      if (queryData) {
+        auto found = _limboFreeSnapshotVersions.find(queryData.targetID);
+        if (found != _limboFreeSnapshotVersions.end()) {
+          return _localDocuments->GetDocumentsMatchingQuery(
+              query, _queryCache->GetMatchingKeys(queryData.targetID), found->second, stats);
+        }
+      }
+    }
+    return _localDocuments->GetDocumentsMatchingQuery(query, stats);
+  });
+}
+
+- (void)saveWarmSnapshotOfDocumentsWithKeys:(const DocumentKeySet &)keys
+                                  forTarget:(TargetId)targetID {
+  if (self.warmSnapshotTargetCount == 0) {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  auto lastSave = _warmSnapshotSaveTimes.find(targetID);
+  if (lastSave != _warmSnapshotSaveTimes.end() &&
+      now - lastSave->second < std::chrono::seconds(kWarmSnapshotMinSaveIntervalSeconds)) {
+    return;
+  }
+  _warmSnapshotSaveTimes[targetID] = now;
+
+  self.persistence.run("Save warm snapshot", [&]() {
+    // Read the documents from the remote document cache rather than the local view, so that the
+    // snapshot never contains local mutations, which may still be rejected by the backend.
+    DocumentSet documents{DocumentComparator::ByKey()};
+    for (const auto &kv : _remoteDocumentCache->GetAll(keys)) {
+      if ([kv.second isKindOfClass:[FSTDocument class]]) {
+        documents = documents.insert(static_cast<FSTDocument *>(kv.second));
+      }
+    }
+    _warmSnapshotCache->Save(targetID, documents, self.warmSnapshotTargetCount);
+  });
+}
+
+- (absl::optional<DocumentMap>)warmSnapshotForTarget:(TargetId)targetID {
+  if (self.warmSnapshotTargetCount == 0) {
+    return absl::nullopt;
+  }
+  return self.persistence.run("Read warm snapshot", [&]() -> absl::optional<DocumentMap> {
+    return _warmSnapshotCache->Get(targetID);
   });
 }
 
 - (DocumentKeySet)remoteDocumentKeysForTarget:(TargetId)targetID {
+  auto found = _targetIDs.find(targetID);
+  if (found != _targetIDs.end() && [found->second.query hasProjection]) {
+    return _projectedDocuments.GetKeys(targetID);
+  }
   return self.persistence.run("RemoteDocumentKeysForTarget", [&]() -> DocumentKeySet {
     return _queryCache->GetMatchingKeys(targetID);
   });
@@ -512,7 +994,7 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
         HARD_ASSERT(!remoteDoc, "Mutation batch %s applied to document %s resulted in nil.", batch,
                     remoteDoc);
       } else {
-        _remoteDocumentCache->Add(doc);
+        _remoteDocumentCache->Add(doc, batchResult.commitVersion);
       }
     }
   }
@@ -526,6 +1008,17 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   });
 }
 
+- (void)collectMemoryStats:(MemoryStats *)stats documentSizer:(const DocumentSizer &)sizer {
+  stats->local_view_overlay_bytes += _localDocuments->EstimateOverlayByteSize(sizer);
+  stats->projected_document_bytes += _projectedDocuments.EstimateByteSize(sizer);
+  [self.persistence collectMemoryStats:stats documentSizer:sizer];
+}
+
+- (void)releaseRebuildableMemory {
+  _localDocuments->DropOverlays();
+  [self.persistence releaseRebuildableMemory];
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
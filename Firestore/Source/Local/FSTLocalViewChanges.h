@@ -39,6 +39,11 @@ NS_ASSUME_NONNULL_BEGIN
                        addedKeys:(model::DocumentKeySet)addedKeys
                      removedKeys:(model::DocumentKeySet)removedKeys;
 
++ (instancetype)changesForTarget:(model::TargetId)targetID
+                       addedKeys:(model::DocumentKeySet)addedKeys
+                     removedKeys:(model::DocumentKeySet)removedKeys
+                       fromCache:(BOOL)fromCache;
+
 + (instancetype)changesForViewSnapshot:(const core::ViewSnapshot &)viewSnapshot
                           withTargetID:(model::TargetId)targetID;
 
@@ -46,6 +51,12 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property(readonly) model::TargetId targetID;
 
+/**
+ * Whether the view was out of sync with the server, or had documents in limbo. Views built with
+ * `changesForTarget:addedKeys:removedKeys:` are assumed to be.
+ */
+@property(readonly) BOOL fromCache;
+
 - (const model::DocumentKeySet &)addedKeys;
 - (const model::DocumentKeySet &)removedKeys;
 
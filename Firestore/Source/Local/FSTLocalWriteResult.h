@@ -16,6 +16,8 @@
 
 #import <Foundation/Foundation.h>
 
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 
@@ -29,10 +31,20 @@ NS_ASSUME_NONNULL_BEGIN
 + (instancetype)resultForBatchID:(model::BatchId)batchID
                          changes:(model::MaybeDocumentMap &&)changes;
 
++ (instancetype)resultForBatchID:(model::BatchId)batchID
+                         changes:(model::MaybeDocumentMap &&)changes
+               compactedBatchIDs:(std::vector<model::BatchId> &&)compactedBatchIDs;
+
 - (id)init __attribute__((unavailable("Use resultForBatchID:changes:")));
 
 - (const model::MaybeDocumentMap &)changes;
 
+/**
+ * The earlier, unsent batches this write made redundant and that were removed from the mutation
+ * queue. They complete along with this write's batch.
+ */
+- (const std::vector<model::BatchId> &)compactedBatchIDs;
+
 @property(nonatomic, assign, readonly) model::BatchId batchID;
 
 @end
@@ -17,6 +17,7 @@
 #import "Firestore/Source/Local/FSTLocalWriteResult.h"
 
 #include <utility>
+#include <vector>
 
 using firebase::firestore::model::BatchId;
 using firebase::firestore::model::MaybeDocumentMap;
@@ -25,26 +26,44 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface FSTLocalWriteResult ()
 - (instancetype)initWithBatchID:(BatchId)batchID
-                        changes:(MaybeDocumentMap &&)changes NS_DESIGNATED_INITIALIZER;
+                        changes:(MaybeDocumentMap &&)changes
+              compactedBatchIDs:(std::vector<BatchId> &&)compactedBatchIDs
+    NS_DESIGNATED_INITIALIZER;
 @end
 
 @implementation FSTLocalWriteResult {
   MaybeDocumentMap _changes;
+  std::vector<BatchId> _compactedBatchIDs;
 }
 
 - (const MaybeDocumentMap &)changes {
   return _changes;
 }
 
+- (const std::vector<BatchId> &)compactedBatchIDs {
+  return _compactedBatchIDs;
+}
+
 + (instancetype)resultForBatchID:(BatchId)batchID changes:(MaybeDocumentMap &&)changes {
-  return [[FSTLocalWriteResult alloc] initWithBatchID:batchID changes:std::move(changes)];
+  return [self resultForBatchID:batchID changes:std::move(changes) compactedBatchIDs:{}];
 }
 
-- (instancetype)initWithBatchID:(BatchId)batchID changes:(MaybeDocumentMap &&)changes {
++ (instancetype)resultForBatchID:(BatchId)batchID
+                         changes:(MaybeDocumentMap &&)changes
+               compactedBatchIDs:(std::vector<BatchId> &&)compactedBatchIDs {
+  return [[FSTLocalWriteResult alloc] initWithBatchID:batchID
+                                              changes:std::move(changes)
+                                    compactedBatchIDs:std::move(compactedBatchIDs)];
+}
+
+- (instancetype)initWithBatchID:(BatchId)batchID
+                        changes:(MaybeDocumentMap &&)changes
+              compactedBatchIDs:(std::vector<BatchId> &&)compactedBatchIDs {
   self = [super init];
   if (self) {
     _batchID = batchID;
     _changes = std::move(changes);
+    _compactedBatchIDs = std::move(compactedBatchIDs);
   }
   return self;
 }
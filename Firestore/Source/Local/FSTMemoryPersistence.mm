@@ -28,6 +28,7 @@
 #include "Firestore/core/src/firebase/firestore/local/memory_mutation_queue.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_query_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_warm_snapshot_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -35,12 +36,15 @@
 
 using firebase::firestore::auth::HashUser;
 using firebase::firestore::auth::User;
+using firebase::firestore::core::DocumentSizer;
+using firebase::firestore::core::MemoryStats;
 using firebase::firestore::local::ListenSequence;
 using firebase::firestore::local::LruParams;
 using firebase::firestore::local::MemoryIndexManager;
 using firebase::firestore::local::MemoryMutationQueue;
 using firebase::firestore::local::MemoryQueryCache;
 using firebase::firestore::local::MemoryRemoteDocumentCache;
+using firebase::firestore::local::MemoryWarmSnapshotCache;
 using firebase::firestore::local::ReferenceSet;
 using firebase::firestore::local::TargetCallback;
 using firebase::firestore::model::DocumentKey;
@@ -61,6 +65,8 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (MemoryIndexManager *)indexManager;
 
+- (MemoryWarmSnapshotCache *)warmSnapshotCache;
+
 - (MemoryMutationQueue *)mutationQueueForUser:(const User &)user;
 
 @property(nonatomic, readonly) MutationQueues &mutationQueues;
@@ -88,6 +94,8 @@ NS_ASSUME_NONNULL_BEGIN
 
   MemoryIndexManager _indexManager;
 
+  MemoryWarmSnapshotCache _warmSnapshotCache;
+
   FSTTransactionRunner _transactionRunner;
 
   id<FSTReferenceDelegate> _referenceDelegate;
@@ -167,6 +175,18 @@ NS_ASSUME_NONNULL_BEGIN
   return &_indexManager;
 }
 
+- (MemoryWarmSnapshotCache *)warmSnapshotCache {
+  return &_warmSnapshotCache;
+}
+
+- (void)collectMemoryStats:(MemoryStats *)stats documentSizer:(const DocumentSizer &)sizer {
+  stats->memory_remote_document_cache_bytes += _remoteDocumentCache->EstimateByteSize(sizer);
+}
+
+- (void)releaseRebuildableMemory {
+  // Everything memory persistence holds is the only copy of the data.
+}
+
 @end
 
 @implementation FSTMemoryLRUReferenceDelegate {
@@ -196,6 +216,10 @@ NS_ASSUME_NONNULL_BEGIN
         _persistence.queryCache->highest_listen_sequence_number();
     _listenSequence = absl::make_unique<ListenSequence>(highestSequenceNumber);
     _serializer = serializer;
+    // Keep running totals, so that checking the size against the cache budget
+    // doesn't have to serialize the whole cache every time.
+    _persistence.queryCache->StartTrackingByteSize(serializer);
+    _persistence.remoteDocumentCache->StartTrackingByteSize(serializer);
   }
   return self;
 }
@@ -267,15 +291,26 @@ NS_ASSUME_NONNULL_BEGIN
   return totalCount;
 }
 
-- (int)removeOrphanedDocumentsThroughSequenceNumber:(ListenSequenceNumber)upperBound {
+- (int)removeOrphanedDocumentsThroughSequenceNumber:(ListenSequenceNumber)upperBound
+                                              limit:(int)limit {
   std::vector<DocumentKey> removed =
-      _persistence.remoteDocumentCache->RemoveOrphanedDocuments(self, upperBound);
+      _persistence.remoteDocumentCache->RemoveOrphanedDocuments(self, upperBound, limit);
   for (const auto &key : removed) {
     _sequenceNumbers.erase(key);
   }
   return static_cast<int>(removed.size());
 }
 
+- (BOOL)removeOrphanedDocument:(const DocumentKey &)key
+                sequenceNumber:(ListenSequenceNumber)sequenceNumber {
+  if ([self isPinnedAtSequenceNumber:sequenceNumber document:key]) {
+    return NO;
+  }
+  _persistence.remoteDocumentCache->Remove(key);
+  _sequenceNumbers.erase(key);
+  return YES;
+}
+
 - (void)addReference:(const DocumentKey &)key {
   _sequenceNumbers[key] = self.currentSequenceNumber;
 }
@@ -300,6 +335,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (BOOL)isPinnedAtSequenceNumber:(ListenSequenceNumber)upperBound
                         document:(const DocumentKey &)key {
+  if ([_gc isInPinnedCollectionGroup:key]) {
+    return YES;
+  }
   if ([self mutationQueuesContainKey:key]) {
     return YES;
   }
@@ -317,12 +355,12 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (size_t)byteSize {
-  // Note that this method is only used for testing because this delegate is only
-  // used for testing. The algorithm here (loop through everything, serialize it
-  // and count bytes) is inefficient and inexact, but won't run in production.
+  // The sizes of the caches are estimates, based on the size of each entry once
+  // serialized. Mutation queues are small and short-lived, so they are still
+  // serialized in full.
   size_t count = 0;
-  count += _persistence.queryCache->CalculateByteSize(_serializer);
-  count += _persistence.remoteDocumentCache->CalculateByteSize(_serializer);
+  count += _persistence.queryCache->byte_size();
+  count += _persistence.remoteDocumentCache->byte_size();
   const MutationQueues &queues = [_persistence mutationQueues];
   for (const auto &entry : queues) {
     count += entry.second->CalculateByteSize(_serializer);
@@ -330,6 +368,11 @@ NS_ASSUME_NONNULL_BEGIN
   return count;
 }
 
+- (int64_t)byteSizeForCollectionGroup:(const std::string &)collectionGroup {
+  return static_cast<int64_t>(
+      _persistence.remoteDocumentCache->GetCollectionGroupByteSize(collectionGroup));
+}
+
 @end
 
 @implementation FSTMemoryEagerReferenceDelegate {
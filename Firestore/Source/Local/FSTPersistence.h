@@ -17,11 +17,14 @@
 #import <Foundation/Foundation.h>
 
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/document_sizer.h"
+#include "Firestore/core/src/firebase/firestore/core/memory_stats.h"
 #include "Firestore/core/src/firebase/firestore/local/index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
 #include "Firestore/core/src/firebase/firestore/local/query_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/warm_snapshot_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -31,6 +34,7 @@
 @protocol FSTReferenceDelegate;
 
 namespace auth = firebase::firestore::auth;
+namespace core = firebase::firestore::core;
 namespace local = firebase::firestore::local;
 namespace model = firebase::firestore::model;
 
@@ -92,6 +96,19 @@ NS_ASSUME_NONNULL_BEGIN
 /** Creates an IndexManager that manages our persisted query indexes. */
 - (local::IndexManager *)indexManager;
 
+/** Creates a WarmSnapshotCache representing the persisted warm snapshots of targets. */
+- (local::WarmSnapshotCache *)warmSnapshotCache;
+
+/**
+ * Adds the memory held by the persistence layer to `stats`, using `sizer` to estimate the size of
+ * cached documents.
+ */
+- (void)collectMemoryStats:(core::MemoryStats *)stats
+             documentSizer:(const core::DocumentSizer &)sizer;
+
+/** Drops in-memory caches that are rebuilt on demand, e.g. in response to a memory warning. */
+- (void)releaseRebuildableMemory;
+
 @property(nonatomic, readonly, assign) const FSTTransactionRunner &run;
 
 /**
@@ -16,9 +16,12 @@
 
 #import <Foundation/Foundation.h>
 
+#include <memory>
+#include <vector>
+
 #import "Firestore/Source/Model/FSTDocumentKey.h"
-#import "Firestore/third_party/Immutable/FSTImmutableSortedDictionary.h"
 
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
@@ -201,6 +204,52 @@ enum class ServerTimestampBehavior { None, Estimate, Previous };
 @property(nonatomic, assign, readonly) const model::DatabaseId *databaseID;
 @end
 
+/**
+ * A single update for `-[FSTObjectValue objectByApplyingUpdates:]`: sets the field at `path` to
+ * `value`, or deletes it if `value` is nil.
+ */
+struct FSTFieldUpdate {
+  model::FieldPath path;
+  FSTFieldValue *_Nullable value;
+};
+
+/**
+ * The paths of a list of updates grouped by field into a trie, so that updates to the same paths
+ * can be applied to many objects without grouping them again each time, see
+ * `-[FSTObjectValue objectByApplyingValues:toPaths:]`. Mutations build it once for their fields.
+ */
+class FSTFieldUpdatePaths {
+ public:
+  /** A level of the trie, defined in FSTFieldValue.mm. */
+  struct Node;
+
+  /** Creates an empty trie, for which no values are applied. */
+  FSTFieldUpdatePaths() = default;
+
+  /** Builds the trie for updates to the given non-empty paths, in order. */
+  explicit FSTFieldUpdatePaths(const std::vector<model::FieldPath> &paths);
+
+  /** The number of updates, which is the number of values that have to be applied. */
+  size_t size() const {
+    return size_;
+  }
+
+  const Node &root() const {
+    return *root_;
+  }
+
+ private:
+  // Shared since the trie never changes once built, so copies don't need their own.
+  std::shared_ptr<const Node> root_;
+  size_t size_ = 0;
+};
+
+/**
+ * The fields of an FSTObjectValue, ordered by the UTF-8 encoding of their names like the backend
+ * orders them.
+ */
+typedef firebase::firestore::immutable::SortedMap<NSString *, FSTFieldValue *> FSTObjectValueMap;
+
 /**
  * A structured object value stored in Firestore.
  */
@@ -219,12 +268,11 @@ enum class ServerTimestampBehavior { None, Estimate, Previous };
 - (instancetype)initWithDictionary:(NSDictionary<NSString *, FSTFieldValue *> *)value;
 
 /**
- * Initializes this FSTObjectValue with the given immutable dictionary.
+ * Initializes this FSTObjectValue with the given fields.
  */
-- (instancetype)initWithImmutableDictionary:
-    (FSTImmutableSortedDictionary<NSString *, FSTFieldValue *> *)value NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithMap:(FSTObjectValueMap)value NS_DESIGNATED_INITIALIZER;
 
-- (FSTImmutableSortedDictionary<NSString *, FSTFieldValue *> *)internalValue;
+- (const FSTObjectValueMap &)internalValue;
 
 /** Returns the value at the given path if it exists. Returns nil otherwise. */
 - (nullable FSTFieldValue *)valueForPath:(const model::FieldPath &)fieldPath;
@@ -242,6 +290,20 @@ enum class ServerTimestampBehavior { None, Estimate, Previous };
  */
 - (FSTObjectValue *)objectByDeletingPath:(const model::FieldPath &)fieldPath;
 
+/**
+ * Returns a new object with all the given updates applied, in order. The result is the same as
+ * calling `objectBySettingValue:forPath:` or `objectByDeletingPath:` for each update, but every
+ * nested object along the updated paths is rebuilt only once. This object remains unmodified.
+ */
+- (FSTObjectValue *)objectByApplyingUpdates:(const std::vector<FSTFieldUpdate> &)updates;
+
+/**
+ * Like `objectByApplyingUpdates:`, for updates whose paths were grouped ahead of time. `values`
+ * holds the value of each update in the order of the paths, nil deleting the field.
+ */
+- (FSTObjectValue *)objectByApplyingValues:(const std::vector<FSTFieldValue *> &)values
+                                   toPaths:(const FSTFieldUpdatePaths &)paths;
+
 /**
  * Applies this field mask to the provided object value and returns an object that only contains
  * fields that are specified in both the input object and this field mask.
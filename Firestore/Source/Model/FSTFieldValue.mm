@@ -16,8 +16,12 @@
 
 #import "Firestore/Source/Model/FSTFieldValue.h"
 
+#include <atomic>
 #include <functional>
+#include <map>
+#include <string>
 #include <utility>
+#include <vector>
 
 #import "FIRDocumentSnapshot.h"
 #import "FIRTimestamp.h"
@@ -630,62 +634,150 @@ static NSComparisonResult CompareBytes(NSData *left, NSData *right) {
 
 #pragma mark - FSTObjectValue
 
+#pragma mark - FSTFieldUpdatePaths
+
 /**
- * Specialization of Comparator for NSStrings.
+ * The updates to the fields of an object. Updates to different fields are independent, so they are
+ * grouped by field while keeping the order of updates to the same field.
  */
-static const NSComparator StringComparator = ^NSComparisonResult(NSString *left, NSString *right) {
-  return WrapCompare(left, right);
+struct FSTFieldUpdatePaths::Node {
+  /** Either an update replacing the whole field, or a run of consecutive updates to subfields. */
+  struct Step {
+    /** The index of the value the field is set to, if `nested` is null. */
+    size_t index = 0;
+
+    /** The updates to subfields, applied at once. */
+    std::unique_ptr<const Node> nested;
+
+    /** The indexes of the values of the updates to subfields. */
+    std::vector<size_t> nestedIndexes;
+  };
+
+  struct Field {
+    NSString *name;
+    std::vector<Step> steps;
+  };
+
+  std::vector<Field> fields;
 };
 
-@interface FSTObjectValue ()
-@property(nonatomic, strong, readonly)
-    FSTImmutableSortedDictionary<NSString *, FSTFieldValue *> *internalValue;
-@end
+namespace {
+
+/** Builds the node for the given updates, whose paths all share their first `depth` segments. */
+std::unique_ptr<const FSTFieldUpdatePaths::Node> FSTBuildFieldUpdateNode(
+    const std::vector<FieldPath> &paths, const std::vector<size_t> &indexes, size_t depth) {
+  std::map<std::string, std::vector<size_t>> indexesByField;
+  for (size_t index : indexes) {
+    indexesByField[paths[index][depth]].push_back(index);
+  }
 
-@implementation FSTObjectValue
+  std::unique_ptr<FSTFieldUpdatePaths::Node> node{new FSTFieldUpdatePaths::Node()};
+  node->fields.reserve(indexesByField.size());
+  for (const auto &entry : indexesByField) {
+    FSTFieldUpdatePaths::Node::Field field;
+    field.name = util::WrapNSString(entry.first);
+
+    const std::vector<size_t> &fieldIndexes = entry.second;
+    size_t i = 0;
+    while (i < fieldIndexes.size()) {
+      FSTFieldUpdatePaths::Node::Step step;
+      if (paths[fieldIndexes[i]].size() == depth + 1) {
+        step.index = fieldIndexes[i];
+        ++i;
+      } else {
+        for (; i < fieldIndexes.size() && paths[fieldIndexes[i]].size() > depth + 1; ++i) {
+          step.nestedIndexes.push_back(fieldIndexes[i]);
+        }
+        step.nested = FSTBuildFieldUpdateNode(paths, step.nestedIndexes, depth + 1);
+      }
+      field.steps.push_back(std::move(step));
+    }
+    node->fields.push_back(std::move(field));
+  }
+  return std::move(node);
+}
+
+/** Returns the value of the named field, or nil if there is no such field. */
+FSTFieldValue *_Nullable FSTObjectValueGet(const FSTObjectValueMap &map, NSString *field) {
+  auto found = map.find(field);
+  return found == map.end() ? nil : found->second;
+}
+
+/** Returns whether any of the values at the given indexes sets a field rather than deleting it. */
+bool FSTAnyValueSet(const std::vector<FSTFieldValue *> &values,
+                    const std::vector<size_t> &indexes) {
+  for (size_t index : indexes) {
+    if (values[index]) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+FSTFieldUpdatePaths::FSTFieldUpdatePaths(const std::vector<FieldPath> &paths)
+    : size_(paths.size()) {
+  std::vector<size_t> indexes;
+  indexes.reserve(paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    HARD_ASSERT(!paths[i].empty(), "Cannot update an empty path");
+    indexes.push_back(i);
+  }
+  root_ = FSTBuildFieldUpdateNode(paths, indexes, 0);
+}
+
+@implementation FSTObjectValue {
+  FSTObjectValueMap _internalValue;
+
+  // The hash of the (immutable) contents, zero until computed. Objects are compared often, e.g.
+  // when checking whether a re-delivered document changed, so the hash is remembered to let
+  // `isEqual:` rule out most differences without walking both objects.
+  std::atomic<NSUInteger> _hash;
+}
 
 + (instancetype)objectValue {
   static FSTObjectValue *sharedEmptyInstance = nil;
   static dispatch_once_t onceToken;
 
   dispatch_once(&onceToken, ^{
-    FSTImmutableSortedDictionary<NSString *, FSTFieldValue *> *empty =
-        [FSTImmutableSortedDictionary dictionaryWithComparator:StringComparator];
-    sharedEmptyInstance = [[FSTObjectValue alloc] initWithImmutableDictionary:empty];
+    sharedEmptyInstance = [[FSTObjectValue alloc] initWithMap:FSTObjectValueMap{}];
   });
   return sharedEmptyInstance;
 }
 
-- (instancetype)initWithImmutableDictionary:
-    (FSTImmutableSortedDictionary<NSString *, FSTFieldValue *> *)value {
+- (instancetype)initWithMap:(FSTObjectValueMap)value {
   self = [super init];
   if (self) {
-    _internalValue = value;  // FSTImmutableSortedDictionary is immutable.
+    _internalValue = std::move(value);  // FSTObjectValueMap is immutable.
+    _hash = 0;
   }
   return self;
 }
 
 - (id)initWithDictionary:(NSDictionary<NSString *, FSTFieldValue *> *)value {
-  FSTImmutableSortedDictionary<NSString *, FSTFieldValue *> *dictionary =
-      [FSTImmutableSortedDictionary dictionaryWithDictionary:value comparator:StringComparator];
-  return [self initWithImmutableDictionary:dictionary];
+  __block FSTObjectValueMap map;
+  [value enumerateKeysAndObjectsUsingBlock:^(NSString *key, FSTFieldValue *obj, BOOL *stop) {
+    map = map.insert(key, obj);
+  }];
+  return [self initWithMap:std::move(map)];
+}
+
+- (const FSTObjectValueMap &)internalValue {
+  return _internalValue;
 }
 
 - (id)value {
-  NSMutableDictionary *result = [NSMutableDictionary dictionary];
-  [self.internalValue
-      enumerateKeysAndObjectsUsingBlock:^(NSString *key, FSTFieldValue *obj, BOOL *stop) {
-        result[key] = [obj value];
-      }];
+  NSMutableDictionary *result = [NSMutableDictionary dictionaryWithCapacity:_internalValue.size()];
+  for (const auto &entry : _internalValue) {
+    result[entry.first] = [entry.second value];
+  }
   return result;
 }
 
 - (id)valueWithOptions:(FSTFieldValueOptions *)options {
-  NSMutableDictionary *result = [NSMutableDictionary dictionary];
-  [self.internalValue
-      enumerateKeysAndObjectsUsingBlock:^(NSString *key, FSTFieldValue *obj, BOOL *stop) {
-        result[key] = [obj valueWithOptions:options];
-      }];
+  NSMutableDictionary *result = [NSMutableDictionary dictionaryWithCapacity:_internalValue.size()];
+  for (const auto &entry : _internalValue) {
+    result[entry.first] = [entry.second valueWithOptions:options];
+  }
   return result;
 }
 
@@ -707,35 +799,54 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
   }
 
   FSTObjectValue *otherObj = other;
-  return [self.internalValue isEqual:otherObj.internalValue];
+  if (self.hash != otherObj.hash) {
+    return NO;
+  }
+  const FSTObjectValueMap &otherMap = otherObj->_internalValue;
+  if (_internalValue.size() != otherMap.size()) {
+    return NO;
+  }
+  // Both maps are ordered by the same comparator, so equal maps line up entry by entry.
+  auto otherIter = otherMap.begin();
+  for (const auto &entry : _internalValue) {
+    if (![entry.first isEqualToString:otherIter->first] ||
+        !(entry.second == otherIter->second || [entry.second isEqual:otherIter->second])) {
+      return NO;
+    }
+    ++otherIter;
+  }
+  return YES;
 }
 
 - (NSUInteger)hash {
-  return [self.internalValue hash];
+  NSUInteger hash = _hash.load(std::memory_order_relaxed);
+  if (hash == 0) {
+    // Racing threads compute the same value, so the last store wins harmlessly.
+    for (const auto &entry : _internalValue) {
+      hash = (hash * 31 + [entry.first hash]) * 17 + [entry.second hash];
+    }
+    _hash.store(hash, std::memory_order_relaxed);
+  }
+  return hash;
 }
 
 - (NSComparisonResult)compare:(FSTFieldValue *)other {
   if (other.type == FieldValue::Type::Object) {
-    FSTImmutableSortedDictionary *selfDict = self.internalValue;
-    FSTImmutableSortedDictionary *otherDict = ((FSTObjectValue *)other).internalValue;
-    NSEnumerator *enumerator1 = [selfDict keyEnumerator];
-    NSEnumerator *enumerator2 = [otherDict keyEnumerator];
-    NSString *key1 = [enumerator1 nextObject];
-    NSString *key2 = [enumerator2 nextObject];
-    while (key1 && key2) {
-      NSComparisonResult keyCompare = [key1 compare:key2];
+    const FSTObjectValueMap &otherMap = ((FSTObjectValue *)other)->_internalValue;
+    auto iter1 = _internalValue.begin();
+    auto iter2 = otherMap.begin();
+    for (; iter1 != _internalValue.end() && iter2 != otherMap.end(); ++iter1, ++iter2) {
+      NSComparisonResult keyCompare = WrapCompare(iter1->first, iter2->first);
       if (keyCompare != NSOrderedSame) {
         return keyCompare;
       }
-      NSComparisonResult valueCompare = [selfDict[key1] compare:otherDict[key2]];
+      NSComparisonResult valueCompare = [iter1->second compare:iter2->second];
       if (valueCompare != NSOrderedSame) {
         return valueCompare;
       }
-      key1 = [enumerator1 nextObject];
-      key2 = [enumerator2 nextObject];
     }
-    // Only equal if both enumerators are exhausted.
-    return WrapCompare(key1 != nil, key2 != nil);
+    // Only equal if both maps are exhausted.
+    return WrapCompare(iter1 != _internalValue.end(), iter2 != otherMap.end());
   } else {
     return [self defaultCompare:other];
   }
@@ -749,7 +860,7 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
     }
 
     NSString *fieldName = util::WrapNSStringNoCopy(fieldPath[i]);
-    value = ((FSTObjectValue *)value).internalValue[fieldName];
+    value = FSTObjectValueGet(((FSTObjectValue *)value)->_internalValue, fieldName);
   }
 
   return value;
@@ -766,7 +877,7 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
   } else {
     // Nested path. Recursively generate a new sub-object and then wrap a new FSTObjectValue
     // around the result.
-    FSTFieldValue *child = [_internalValue objectForKey:childName];
+    FSTFieldValue *child = FSTObjectValueGet(_internalValue, childName);
     FSTObjectValue *childObject;
     if (child.type == FieldValue::Type::Object) {
       childObject = (FSTObjectValue *)child;
@@ -784,10 +895,9 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
   HARD_ASSERT(fieldPath.size() > 0, "Cannot delete an empty path");
   NSString *childName = util::WrapNSString(fieldPath.first_segment());
   if (fieldPath.size() == 1) {
-    return [[FSTObjectValue alloc]
-        initWithImmutableDictionary:[_internalValue dictionaryByRemovingObjectForKey:childName]];
+    return [[FSTObjectValue alloc] initWithMap:_internalValue.erase(childName)];
   } else {
-    FSTFieldValue *child = _internalValue[childName];
+    FSTFieldValue *child = FSTObjectValueGet(_internalValue, childName);
     if (child.type == FieldValue::Type::Object) {
       FSTObjectValue *newChild =
           [((FSTObjectValue *)child) objectByDeletingPath:fieldPath.PopFirst()];
@@ -799,9 +909,62 @@ static const NSComparator StringComparator = ^NSComparisonResult(NSString *left,
   }
 }
 
+- (FSTObjectValue *)objectByApplyingUpdates:(const std::vector<FSTFieldUpdate> &)updates {
+  std::vector<FieldPath> paths;
+  std::vector<FSTFieldValue *> values;
+  paths.reserve(updates.size());
+  values.reserve(updates.size());
+  for (const FSTFieldUpdate &update : updates) {
+    paths.push_back(update.path);
+    values.push_back(update.value);
+  }
+  return [self objectByApplyingValues:values toPaths:FSTFieldUpdatePaths(paths)];
+}
+
+- (FSTObjectValue *)objectByApplyingValues:(const std::vector<FSTFieldValue *> &)values
+                                   toPaths:(const FSTFieldUpdatePaths &)paths {
+  HARD_ASSERT(values.size() == paths.size(), "Expected %s values for the paths, got %s",
+              paths.size(), values.size());
+  if (paths.size() == 0) return self;
+
+  return [self objectByApplyingValues:values node:paths.root()];
+}
+
+/**
+ * Applies the updates under the given node of the trie, whose paths all start with the path of
+ * this object.
+ */
+- (FSTObjectValue *)objectByApplyingValues:(const std::vector<FSTFieldValue *> &)values
+                                      node:(const FSTFieldUpdatePaths::Node &)node {
+  FSTObjectValueMap result = _internalValue;
+  for (const FSTFieldUpdatePaths::Node::Field &field : node.fields) {
+    FSTFieldValue *child = FSTObjectValueGet(result, field.name);
+    for (const FSTFieldUpdatePaths::Node::Step &step : field.steps) {
+      if (!step.nested) {
+        child = values[step.index];
+        continue;
+      }
+
+      if (child.type == FieldValue::Type::Object) {
+        child = [(FSTObjectValue *)child objectByApplyingValues:values node:*step.nested];
+      } else if (FSTAnyValueSet(values, step.nestedIndexes)) {
+        // Like `objectBySettingValue:forPath:`, pretend that an empty object lives in place of a
+        // missing or primitive value. Deletes alone leave it unchanged.
+        child = [[FSTObjectValue objectValue] objectByApplyingValues:values node:*step.nested];
+      }
+    }
+
+    if (child) {
+      result = std::move(result).insert(field.name, child);
+    } else {
+      result = std::move(result).erase(field.name);
+    }
+  }
+  return [[FSTObjectValue alloc] initWithMap:std::move(result)];
+}
+
 - (FSTObjectValue *)objectBySettingValue:(FSTFieldValue *)value forField:(NSString *)field {
-  return [[FSTObjectValue alloc]
-      initWithImmutableDictionary:[_internalValue dictionaryBySettingObject:value forKey:field]];
+  return [[FSTObjectValue alloc] initWithMap:_internalValue.insert(field, value)];
 }
 
 - (FSTObjectValue *)objectByApplyingFieldMask:(const FieldMask &)fieldMask {
@@ -269,6 +269,14 @@ NS_ASSUME_NONNULL_BEGIN
 /** The field transforms to use when transforming the document. */
 - (const std::vector<model::FieldTransform> &)fieldTransforms;
 
+/**
+ * Returns a transform mutation with the same effect as applying this mutation and then `next`, or
+ * nil if `next` transforms a field this mutation doesn't, or two of the transforms can't be
+ * combined into one.
+ */
+- (nullable FSTTransformMutation *)transformMutationByCoalescingMutation:
+    (FSTTransformMutation *)next;
+
 @end
 
 #pragma mark - FSTDeleteMutation
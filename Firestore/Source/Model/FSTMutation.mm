@@ -16,6 +16,7 @@
 
 #import "Firestore/Source/Model/FSTMutation.h"
 
+#include <algorithm>
 #include <memory>
 #include <set>
 #include <string>
@@ -209,6 +210,12 @@ NS_ASSUME_NONNULL_BEGIN
 
 @implementation FSTPatchMutation {
   FieldMask _fieldMask;
+
+  /** The non-empty paths of the field mask, grouped once for every document this is applied to. */
+  FSTFieldUpdatePaths _updatePaths;
+
+  /** The value of each path in `_updatePaths`, nil for fields to delete. */
+  std::vector<FSTFieldValue *> _updateValues;
 }
 
 - (instancetype)initWithKey:(DocumentKey)key
@@ -219,6 +226,16 @@ NS_ASSUME_NONNULL_BEGIN
   if (self) {
     _fieldMask = std::move(fieldMask);
     _value = value;
+
+    std::vector<FieldPath> updatePaths;
+    for (const FieldPath &fieldPath : _fieldMask) {
+      if (!fieldPath.empty()) {
+        updatePaths.push_back(fieldPath);
+        // A nil value deletes the field.
+        _updateValues.push_back([value valueForPath:fieldPath]);
+      }
+    }
+    _updatePaths = FSTFieldUpdatePaths(updatePaths);
   }
   return self;
 }
@@ -305,18 +322,7 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (FSTObjectValue *)patchObjectValue:(FSTObjectValue *)objectValue {
-  FSTObjectValue *result = objectValue;
-  for (const FieldPath &fieldPath : _fieldMask) {
-    if (!fieldPath.empty()) {
-      FSTFieldValue *newValue = [self.value valueForPath:fieldPath];
-      if (newValue) {
-        result = [result objectBySettingValue:newValue forPath:fieldPath];
-      } else {
-        result = [result objectByDeletingPath:fieldPath];
-      }
-    }
-  }
-  return result;
+  return [objectValue objectByApplyingValues:_updateValues toPaths:_updatePaths];
 }
 
 - (BOOL)idempotent {
@@ -329,6 +335,9 @@ NS_ASSUME_NONNULL_BEGIN
   /** The field transforms to use when transforming the document. */
   std::vector<FieldTransform> _fieldTransforms;
   FieldMask _fieldMask;
+
+  /** The paths of the field transforms, grouped once for every document this is applied to. */
+  FSTFieldUpdatePaths _transformPaths;
 }
 
 - (instancetype)initWithKey:(DocumentKey)key
@@ -340,11 +349,14 @@ NS_ASSUME_NONNULL_BEGIN
     _fieldTransforms = std::move(fieldTransforms);
 
     std::set<FieldPath> fields;
+    std::vector<FieldPath> transformPaths;
     for (const auto &transform : _fieldTransforms) {
       fields.insert(transform.path());
+      transformPaths.push_back(transform.path());
     }
 
     _fieldMask = FieldMask(std::move(fields));
+    _transformPaths = FSTFieldUpdatePaths(transformPaths);
   }
   return self;
 }
@@ -353,6 +365,36 @@ NS_ASSUME_NONNULL_BEGIN
   return _fieldTransforms;
 }
 
+- (nullable FSTTransformMutation *)transformMutationByCoalescingMutation:
+    (FSTTransformMutation *)next {
+  // Every transform of a mutation reads the field as it was before the mutation, so a field that
+  // is transformed twice in the same mutation can't be combined with anything.
+  const std::vector<FieldTransform> &nextTransforms = next.fieldTransforms;
+  if (self.key != next.key || _fieldMask.size() != _fieldTransforms.size() ||
+      next.fieldMask->size() != nextTransforms.size()) {
+    return nil;
+  }
+
+  std::vector<FieldTransform> fieldTransforms = _fieldTransforms;
+  for (const FieldTransform &nextTransform : nextTransforms) {
+    auto found = std::find_if(fieldTransforms.begin(), fieldTransforms.end(),
+                              [&](const FieldTransform &transform) {
+                                return transform.path() == nextTransform.path();
+                              });
+    if (found == fieldTransforms.end()) {
+      return nil;
+    }
+    std::unique_ptr<TransformOperation> coalesced =
+        found->transformation().CoalescedWith(nextTransform.transformation());
+    if (!coalesced) {
+      return nil;
+    }
+    *found = FieldTransform(found->path(), std::move(coalesced));
+  }
+  return [[FSTTransformMutation alloc] initWithKey:self.key
+                                   fieldTransforms:std::move(fieldTransforms)];
+}
+
 - (BOOL)isEqual:(id)other {
   if (other == self) {
     return YES;
@@ -504,12 +546,12 @@ NS_ASSUME_NONNULL_BEGIN
   HARD_ASSERT(transformResults.count == self.fieldTransforms.size(),
               "Transform results length mismatch.");
 
-  for (size_t i = 0; i < self.fieldTransforms.size(); i++) {
-    const FieldTransform &fieldTransform = self.fieldTransforms[i];
-    const FieldPath &fieldPath = fieldTransform.path();
-    objectValue = [objectValue objectBySettingValue:transformResults[i] forPath:fieldPath];
+  std::vector<FSTFieldValue *> values;
+  values.reserve(transformResults.count);
+  for (FSTFieldValue *transformResult in transformResults) {
+    values.push_back(transformResult);
   }
-  return objectValue;
+  return [objectValue objectByApplyingValues:values toPaths:_transformPaths];
 }
 
 - (const FieldMask *)fieldMask {
@@ -164,7 +164,7 @@ NS_ASSUME_NONNULL_BEGIN
         applyToLocalDocument:(maybeDocument != mutatedDocuments.end() ? maybeDocument->second : nil)
                  documentKey:key];
     if (mutatedDocument) {
-      mutatedDocuments = mutatedDocuments.insert(key, mutatedDocument);
+      mutatedDocuments = std::move(mutatedDocuments).insert(key, mutatedDocument);
     }
   }
   return mutatedDocuments;
@@ -173,7 +173,7 @@ NS_ASSUME_NONNULL_BEGIN
 - (DocumentKeySet)keys {
   DocumentKeySet set;
   for (FSTMutation *mutation : _mutations) {
-    set = set.insert(mutation.key);
+    set = std::move(set).insert(mutation.key);
   }
   return set;
 }
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2017 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class FIRFieldPath;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A value computed over all the documents matching a query, such as their number or the sum of
+ * one of their fields. Pass aggregate fields to
+ * `-[FIRQuery addAggregateListenerForFields:listener:]` to only receive the computed values rather
+ * than the documents themselves.
+ */
+NS_SWIFT_NAME(AggregateField)
+@interface FIRAggregateField : NSObject
+
+/** :nodoc: */
+- (instancetype)init NS_UNAVAILABLE;
+
+/** The number of documents that match the query. */
++ (instancetype)aggregateFieldForCount NS_SWIFT_NAME(count());
+
+/**
+ * The sum of the given field over the documents that match the query. Documents whose field is
+ * missing or not a number are skipped. The sum is an integer if all the values summed are integers.
+ */
++ (instancetype)aggregateFieldForSumOfField:(NSString *)field NS_SWIFT_NAME(sum(_:));
++ (instancetype)aggregateFieldForSumOfFieldPath:(FIRFieldPath *)path NS_SWIFT_NAME(sum(_:));
+
+/**
+ * The average of the given field over the documents that match the query. Documents whose field is
+ * missing or not a number are skipped; the average of no numbers is `nil`.
+ */
++ (instancetype)aggregateFieldForAverageOfField:(NSString *)field NS_SWIFT_NAME(average(_:));
++ (instancetype)aggregateFieldForAverageOfFieldPath:(FIRFieldPath *)path
+    NS_SWIFT_NAME(average(_:));
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2017 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class FIRAggregateField;
+@class FIRQuery;
+@class FIRSnapshotMetadata;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** The values of the aggregate fields of a query, taken from a listener or the local cache. */
+NS_SWIFT_NAME(AggregateQuerySnapshot)
+@interface FIRAggregateQuerySnapshot : NSObject
+
+/** :nodoc: */
+- (instancetype)init NS_UNAVAILABLE;
+
+/** The query the aggregate fields were computed over. */
+@property(nonatomic, strong, readonly) FIRQuery *query;
+
+/** Metadata about this snapshot, concerning its source and if it has local modifications. */
+@property(nonatomic, strong, readonly) FIRSnapshotMetadata *metadata;
+
+/** The number of documents that match the query, whether or not a count was requested. */
+@property(nonatomic, strong, readonly) NSNumber *count;
+
+/**
+ * Returns the value of one of the aggregate fields the snapshot was requested for, or `nil` for
+ * the average of no numbers.
+ *
+ * @param field An aggregate field equal to one that was requested.
+ */
+- (nullable NSNumber *)valueForAggregateField:(FIRAggregateField *)field NS_SWIFT_NAME(get(_:));
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -21,6 +21,7 @@
 @class FIRDocumentReference;
 @class FIRFirestoreSettings;
 @class FIRQuery;
+@class FIRRPCStatistics;
 @class FIRTransaction;
 @class FIRWriteBatch;
 
@@ -104,6 +105,20 @@ NS_SWIFT_NAME(Firestore)
  */
 - (FIRQuery *)collectionGroupWithID:(NSString *)collectionID NS_SWIFT_NAME(collectionGroup(_:));
 
+/**
+ * Creates and returns a new `Query` that includes exactly the given documents, so that they can be
+ * fetched or listened to together. Listening to the query uses a single watch target, rather than
+ * one per document, and raises a single snapshot for all changes.
+ *
+ * A documents query cannot be filtered, ordered, limited or projected.
+ *
+ * @param documents The documents to include. Must not be empty, and all documents must belong to
+ *     this Firestore instance.
+ * @return The created `Query`.
+ */
+- (FIRQuery *)queryForDocuments:(NSArray<FIRDocumentReference *> *)documents
+    NS_SWIFT_NAME(query(forDocuments:));
+
 #pragma mark - Transactions and Write Batches
 
 /**
@@ -176,6 +191,70 @@ NS_SWIFT_NAME(Firestore)
  */
 - (void)disableNetworkWithCompletion:(nullable void (^)(NSError *_Nullable error))completion;
 
+/**
+ * Starts connecting to the backend, so that the first listen or write doesn't have to wait for
+ * DNS resolution and the TLS handshake. This is done automatically when the first listener is
+ * added; call it earlier, e.g. on launch or when the app comes to the foreground, to start even
+ * sooner. Does nothing if the network is disabled or after the connection has been warmed up once.
+ */
+- (void)warmUpConnection NS_SWIFT_NAME(warmUpConnection());
+
+/**
+ * Retrieves statistics about the network traffic of this Firestore instance since it was started,
+ * keyed by backend RPC name (e.g. "Listen", "Write" or "Commit"). RPCs that haven't been made yet
+ * are absent from the dictionary. The completion block is called on the dispatch queue
+ * configured in `FIRFirestoreSettings`.
+ */
+- (void)getNetworkStatisticsWithCompletion:
+    (void (^)(NSDictionary<NSString *, FIRRPCStatistics *> *statistics))completion
+    NS_SWIFT_NAME(getNetworkStatistics(completion:));
+
+/**
+ * Retrieves an estimate of the memory in bytes held by the caches and in-flight state of this
+ * Firestore instance, keyed by:
+ *
+ *   - "views": the documents in the results of active listeners.
+ *   - "localViewOverlay": the local views of documents with pending writes.
+ *   - "remoteDocumentCache": the in-memory document cache, if persistence is disabled.
+ *   - "projectedDocuments": the partial documents of queries that select only some fields.
+ *   - "pendingWatchChanges": documents received but not yet raised in a snapshot.
+ *   - "streamBuffers": messages waiting to be sent to the backend.
+ *   - "leveldbBlockCache" and "leveldbMemtables": LevelDB, if persistence is enabled.
+ *   - "total": the sum of the above.
+ *
+ * Builds with `FIRESTORE_COUNT_ALLOCATIONS` defined also report the allocations the core has made
+ * since the app started, and their total size, as "allocations.<subsystem>" and
+ * "allocatedBytes.<subsystem>" for the "immutable", "model", "nanopb" and "local" subsystems.
+ * These are shared by all Firestore instances and aren't part of the total.
+ *
+ * The completion block is called on the dispatch queue configured in `FIRFirestoreSettings`.
+ */
+- (void)getMemoryStatisticsWithCompletion:
+    (void (^)(NSDictionary<NSString *, NSNumber *> *statistics))completion
+    NS_SWIFT_NAME(getMemoryStatistics(completion:));
+
+/**
+ * Drops the caches of this Firestore instance that can be rebuilt from disk, such as the LevelDB
+ * block cache. Call this in response to a low memory warning. Active listeners and pending writes
+ * are unaffected. The completion block, if provided, is called once the caches have been dropped.
+ */
+- (void)releaseMemoryWithCompletion:(nullable void (^)(NSError *_Nullable error))completion;
+
+/**
+ * Loads a bundle of precomputed query results into the local cache, which is much faster than
+ * fetching a large result for the first time. The bundle holds a length-delimited
+ * `firestore.client.Target` describing the query, its read time and resume token, followed by the
+ * length-delimited `firestore.client.MaybeDocument`s that matched the query at that time.
+ *
+ * Documents the cache holds more recent versions of are left unchanged. Listening to the query
+ * afterwards serves the bundled documents from the cache and only fetches the changes since the
+ * bundle's read time. The completion block, if provided, is called once the bundle has been loaded,
+ * or with an error if it is malformed.
+ */
+- (void)loadBundle:(NSData *)bundle
+        completion:(nullable void (^)(NSError *_Nullable error))completion
+    NS_SWIFT_NAME(loadBundle(_:completion:));
+
 @end
 
 NS_ASSUME_NONNULL_END
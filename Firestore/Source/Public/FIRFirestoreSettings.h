@@ -77,6 +77,162 @@ NS_SWIFT_NAME(FirestoreSettings)
  */
 @property(nonatomic, assign) int64_t cacheSizeBytes;
 
+/**
+ * Sets the cache size threshold used when persistence is disabled. When set, documents stay in
+ * memory after they are no longer listened to, and least-recently-used documents are collected
+ * once the cache exceeds the given size. Cannot be set lower than 1MB.
+ *
+ * Defaults to kFIRFirestoreCacheSizeUnlimited, which drops documents from memory as soon as they
+ * are no longer needed.
+ */
+@property(nonatomic, assign) int64_t memoryCacheSizeBytes;
+
+/**
+ * The size of the in-memory cache of blocks read from local persistent storage. Larger values
+ * trade memory for fewer disk reads. Defaults to 8MB.
+ */
+@property(nonatomic, assign) int64_t persistenceBlockCacheSizeBytes;
+
+/**
+ * The amount of written data local persistent storage buffers in memory before flushing it to
+ * disk. Larger values speed up bulk writes at the cost of memory and longer startup when the
+ * buffer has to be recovered. Defaults to 4MB.
+ */
+@property(nonatomic, assign) int64_t persistenceWriteBufferSizeBytes;
+
+/** Whether local persistent storage compresses data on disk. Defaults to true. */
+@property(nonatomic, getter=isPersistenceCompressionEnabled) BOOL persistenceCompressionEnabled;
+
+/**
+ * The number of bits per key used by the bloom filters that let local persistent storage skip
+ * disk reads for keys that don't exist. Set to 0 to disable bloom filters. Defaults to 10.
+ */
+@property(nonatomic, assign) int persistenceBloomFilterBitsPerKey;
+
+/**
+ * Whether data read from local persistent storage is verified against its checksum. Defaults to
+ * true.
+ */
+@property(nonatomic, getter=isPersistenceChecksumVerificationEnabled)
+    BOOL persistenceChecksumVerificationEnabled;
+
+/**
+ * Whether documents are read from and written to local persistent storage by the native C++
+ * serializer, which avoids creating intermediate Objective-C objects. The stored format is the
+ * same either way. Defaults to false.
+ */
+@property(nonatomic, getter=isPersistenceNativeSerializationEnabled)
+    BOOL persistenceNativeSerializationEnabled;
+
+/**
+ * The maximum number of documents received from the backend that are written to local persistent
+ * storage in one transaction. Smaller values bound the memory used to apply large snapshots, such
+ * as the initial results of a big query. Set to 0 to write each snapshot in a single transaction.
+ * Defaults to 0.
+ */
+@property(nonatomic, assign) int persistenceRemoteDocumentBatchSize;
+
+/**
+ * Whether upgrading the format of local persistent storage may finish in the background. Some
+ * upgrades scan every cached document, which delays the first operation after an app update when
+ * the cache is large. If enabled, those upgrades run in small steps after Firestore starts and
+ * queries use slower fallbacks until they complete. Defaults to false.
+ *
+ * Don't enable this if the app may be downgraded to an SDK version without this setting: such a
+ * version doesn't know that an upgrade is incomplete, and its collection group queries may then
+ * miss documents.
+ */
+@property(nonatomic, getter=isPersistenceBackgroundMigrationsEnabled)
+    BOOL persistenceBackgroundMigrationsEnabled;
+
+/**
+ * The number of most recently active queries whose last results are kept in local persistent
+ * storage so that, the next time they are listened to, the results can be delivered right away
+ * (as a snapshot from the cache) while the query runs against the cache. Set to 0 to disable.
+ * Defaults to 0.
+ */
+@property(nonatomic, assign) int persistenceWarmSnapshotTargetCount;
+
+/**
+ * Whether the documents matching each cached query are recorded in local persistent storage in
+ * compressed blocks rather than one entry per document, which takes less space and is faster to
+ * read for queries with many results. Both forms are read, so this can be changed at any time.
+ * Defaults to false.
+ */
+@property(nonatomic, getter=isPersistenceCompactTargetDocumentsEnabled)
+    BOOL persistenceCompactTargetDocumentsEnabled;
+
+/**
+ * Whether cached documents are compressed in local persistent storage, using a dictionary built
+ * from the first documents cached in each collection. This takes less space for collections of
+ * similar documents, at some CPU cost on every read and write. Both forms are read, so this can be
+ * changed at any time. Defaults to false.
+ */
+@property(nonatomic, getter=isPersistenceValueCompressionEnabled)
+    BOOL persistenceValueCompressionEnabled;
+
+/**
+ * Whether every write to local persistent storage waits until the data reaches the disk. Otherwise
+ * writes survive the app crashing, but the most recent ones may be lost if the device loses power.
+ * Defaults to false.
+ */
+@property(nonatomic, getter=isPersistenceSyncWritesEnabled) BOOL persistenceSyncWritesEnabled;
+
+/**
+ * If `persistenceSyncWritesEnabled` is false, the minimum number of milliseconds between writes to
+ * local persistent storage that wait for the disk anyway, which bounds how much is lost if the
+ * device loses power. Set to 0 to never wait. Defaults to 0.
+ */
+@property(nonatomic, assign) int persistenceSyncIntervalMs;
+
+/**
+ * The longest, in milliseconds, that small writes to local persistent storage are held back so that
+ * they are made together. Each write made separately has a fixed cost, which adds up when e.g. many
+ * writes are acknowledged at once. Writes held back are lost if the app crashes, but only whole
+ * and in order, so the cache is left as it was after some earlier write. Set to 0 to make every
+ * write right away. Defaults to 0.
+ */
+@property(nonatomic, assign) int persistenceGroupCommitDelayMs;
+
+/**
+ * A directory, such as one in an app group container, where a consistent copy of local persistent
+ * storage is periodically exported so that other processes can read it. App extensions can't open
+ * the app's local persistent storage while the app is running; instead, they can set this to the
+ * same directory and enable `persistenceExportReadOnly`. Defaults to nil, which exports nothing.
+ */
+@property(nonatomic, copy, nullable) NSString *persistenceExportDirectory;
+
+/**
+ * Whether this instance reads the latest copy of local persistent storage exported by another
+ * process to `persistenceExportDirectory`, rather than having its own. The copy is taken when
+ * Firestore starts. Such an instance serves reads from the cache only: it doesn't connect to the
+ * backend, and anything written to it is discarded the next time it starts. Defaults to false.
+ */
+@property(nonatomic, getter=isPersistenceExportReadOnly) BOOL persistenceExportReadOnly;
+
+/**
+ * The number of separate connections opened to the backend. Listen, write and other traffic each
+ * get their own connection (as long as there are enough), so that e.g. downloading a large query
+ * result doesn't delay a transaction. Must be at least 1. Defaults to 3.
+ */
+@property(nonatomic, assign) int channelCount;
+
+/**
+ * Whether messages sent to and received from the backend on the listen and write streams are
+ * compressed with gzip. Compression trades CPU time for bandwidth, which usually pays off when
+ * syncing document-heavy payloads over cellular networks. Small messages are never compressed.
+ * Defaults to false.
+ */
+@property(nonatomic, getter=isCompressionEnabled) BOOL compressionEnabled;
+
+/**
+ * Whether writes made while offline (or while earlier writes are still being sent) replace earlier
+ * pending writes they overwrite completely, instead of queueing both. For example, when a document
+ * is set 100 times while offline, only the last write is kept and uploaded, and the completion
+ * blocks of the others are called with its outcome. Defaults to false.
+ */
+@property(nonatomic, getter=isPendingWriteCompactionEnabled) BOOL pendingWriteCompactionEnabled;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -19,6 +19,8 @@
 #import "FIRFirestoreSource.h"
 #import "FIRListenerRegistration.h"
 
+@class FIRAggregateField;
+@class FIRAggregateQuerySnapshot;
 @class FIRFieldPath;
 @class FIRFirestore;
 @class FIRQuerySnapshot;
@@ -29,6 +31,9 @@ NS_ASSUME_NONNULL_BEGIN
 typedef void (^FIRQuerySnapshotBlock)(FIRQuerySnapshot *_Nullable snapshot,
                                       NSError *_Nullable error);
 
+typedef void (^FIRAggregateQuerySnapshotBlock)(FIRAggregateQuerySnapshot *_Nullable snapshot,
+                                               NSError *_Nullable error);
+
 /**
  * A `FIRQuery` refers to a Query which you can read or listen to. You can also construct
  * refined `FIRQuery` objects by adding filters and ordering.
@@ -97,6 +102,33 @@ addSnapshotListenerWithIncludeMetadataChanges:(BOOL)includeMetadataChanges
     NS_SWIFT_NAME(addSnapshotListener(includeMetadataChanges:listener:));
 // clang-format on
 
+/**
+ * Computes the given aggregate fields over the documents in the local cache that match this
+ * query, without reading the documents into memory on the calling thread or contacting the
+ * backend.
+ *
+ * @param fields The aggregate fields to compute. At least one field must be given.
+ * @param completion a block to execute once the aggregates have been computed.
+ */
+- (void)getAggregateFromCacheForFields:(NSArray<FIRAggregateField *> *)fields
+                            completion:(FIRAggregateQuerySnapshotBlock)completion
+    NS_SWIFT_NAME(getAggregateFromCache(fields:completion:));
+
+/**
+ * Attaches a listener for the given aggregate fields of this query, e.g. the number of matching
+ * documents. The aggregates are kept up to date from the changes to the query's results, so the
+ * listener only receives their values and never the documents themselves.
+ *
+ * @param fields The aggregate fields to compute. At least one field must be given.
+ * @param listener The listener to attach.
+ *
+ * @return A FIRListenerRegistration that can be used to remove this listener.
+ */
+- (id<FIRListenerRegistration>)addAggregateListenerForFields:(NSArray<FIRAggregateField *> *)fields
+                                                    listener:
+                                                        (FIRAggregateQuerySnapshotBlock)listener
+    NS_SWIFT_NAME(addAggregateListener(fields:listener:));
+
 #pragma mark - Filtering Data
 /**
  * Creates and returns a new `FIRQuery` with the additional filter that documents must
@@ -341,6 +373,23 @@ addSnapshotListenerWithIncludeMetadataChanges:(BOOL)includeMetadataChanges
  */
 - (FIRQuery *)queryLimitedTo:(NSInteger)limit NS_SWIFT_NAME(limit(to:));
 
+#pragma mark - Selecting Fields
+/**
+ * Creates and returns a new `FIRQuery` whose results only contain the specified fields of each
+ * document, which reduces the data transferred and cached for queries that don't need whole
+ * documents. The fields the query filters and sorts on are always included.
+ *
+ * Documents returned by a query with selected fields are partial: they contain no other fields,
+ * are never served to queries for whole documents, and don't reflect local writes until the
+ * backend has acknowledged them.
+ *
+ * @param fields An array of `NSString` or `FIRFieldPath` objects naming the fields to return. At
+ *     least one field must be given.
+ *
+ * @return The created `FIRQuery`.
+ */
+- (FIRQuery *)queryBySelectingFields:(NSArray<id> *)fields NS_SWIFT_NAME(select(_:));
+
 #pragma mark - Choosing Endpoints
 /**
  * Creates and returns a new `FIRQuery` that starts at the provided document (inclusive). The
@@ -68,6 +68,32 @@ NS_SWIFT_NAME(QuerySnapshot)
 - (NSArray<FIRDocumentChange *> *)documentChangesWithIncludeMetadataChanges:
     (BOOL)includeMetadataChanges NS_SWIFT_NAME(documentChanges(includeMetadataChanges:));
 
+/**
+ * Calls the given block with each of the `FIRDocumentSnapshots` that make up this snapshot, in the
+ * same order as `documents`. Unlike `documents`, this creates each `FIRQueryDocumentSnapshot` only
+ * when it is passed to the block, so stopping early or dropping documents as they are visited
+ * avoids creating wrappers for the whole result up front.
+ *
+ * @param block The block to call. Set `*stop` to YES to stop the enumeration.
+ */
+- (void)enumerateDocumentsUsingBlock:
+    (void (^)(FIRQueryDocumentSnapshot *document, NSUInteger idx, BOOL *stop))block
+    NS_SWIFT_NAME(enumerateDocuments(_:));
+
+/**
+ * Calls the given block with each of the documents that changed since the last snapshot, in the
+ * same order as `documentChangesWithIncludeMetadataChanges:`, creating each `FIRDocumentChange`
+ * only when it is passed to the block.
+ *
+ * @param includeMetadataChanges Whether metadata-only changes (i.e. only
+ *     `FIRDocumentSnapshot.metadata` changed) should be included.
+ * @param block The block to call. Set `*stop` to YES to stop the enumeration.
+ */
+- (void)enumerateDocumentChangesWithIncludeMetadataChanges:(BOOL)includeMetadataChanges
+                                                usingBlock:(void (^)(FIRDocumentChange *change,
+                                                                     BOOL *stop))block
+    NS_SWIFT_NAME(enumerateDocumentChanges(includeMetadataChanges:_:));
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A snapshot of the network traffic of a single backend RPC (e.g. "Listen" or "Commit") made by a
+ * Firestore instance since it was started.
+ */
+NS_SWIFT_NAME(RPCStatistics)
+@interface FIRRPCStatistics : NSObject
+
+/** :nodoc: */
+- (instancetype)init NS_UNAVAILABLE;
+
+/** The number of messages sent to the backend. */
+@property(nonatomic, assign, readonly) int64_t messagesSent;
+
+/** The number of messages received from the backend. */
+@property(nonatomic, assign, readonly) int64_t messagesReceived;
+
+/** The serialized size of all messages sent to the backend, in bytes. */
+@property(nonatomic, assign, readonly) int64_t bytesSent;
+
+/** The serialized size of all messages received from the backend, in bytes. */
+@property(nonatomic, assign, readonly) int64_t bytesReceived;
+
+/** How many times the call (or, for streams, the stream) was started. */
+@property(nonatomic, assign, readonly) int64_t startCount;
+
+/** How many times the stream waited before reconnecting after an error. */
+@property(nonatomic, assign, readonly) int64_t backoffCount;
+
+/** The overall time the stream spent waiting before reconnecting, in seconds. */
+@property(nonatomic, assign, readonly) NSTimeInterval totalBackoffDuration;
+
+/** The number of request/response round trips recorded in the latency histogram. */
+@property(nonatomic, assign, readonly) int64_t latencyCount;
+
+/**
+ * The inclusive upper bound of each latency histogram bucket, in milliseconds. The histogram has
+ * one more bucket than there are bounds; the last bucket counts all latencies above the last bound.
+ */
+@property(nonatomic, strong, readonly) NSArray<NSNumber *> *latencyBucketUpperBounds;
+
+/** The number of round trips that fell into each latency histogram bucket. */
+@property(nonatomic, strong, readonly) NSArray<NSNumber *> *latencyBucketCounts;
+
+@end
+
+NS_ASSUME_NONNULL_END
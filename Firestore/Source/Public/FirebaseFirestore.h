@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#import "FIRAggregateField.h"
+#import "FIRAggregateQuerySnapshot.h"
 #import "FIRCollectionReference.h"
 #import "FIRDocumentChange.h"
 #import "FIRDocumentReference.h"
@@ -27,6 +29,7 @@
 #import "FIRListenerRegistration.h"
 #import "FIRQuery.h"
 #import "FIRQuerySnapshot.h"
+#import "FIRRPCStatistics.h"
 #import "FIRSnapshotMetadata.h"
 #import "FIRTimestamp.h"
 #import "FIRTransaction.h"
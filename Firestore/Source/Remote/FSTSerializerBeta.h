@@ -16,6 +16,7 @@
 
 #import <Foundation/Foundation.h>
 
+#include <cstdint>
 #include <memory>
 
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
@@ -23,6 +24,7 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "absl/types/optional.h"
 
 @class FSTFieldValue;
 @class FSTMaybeDocument;
@@ -65,6 +67,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)initWithDatabaseID:(const model::DatabaseId *)databaseID NS_DESIGNATED_INITIALIZER;
 
+/** The database this serializer encodes for. Not owned by the serializer. */
+@property(nonatomic, assign, readonly) const model::DatabaseId *databaseID;
+
 - (GPBTimestamp *)encodedTimestamp:(const firebase::Timestamp &)timestamp;
 - (firebase::Timestamp)decodedTimestamp:(GPBTimestamp *)timestamp;
 
@@ -95,6 +100,14 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (GCFSTarget *)encodedTarget:(FSTQueryData *)queryData;
 
+/**
+ * Encodes the target of the given query data. If given, `expectedCount` is the number of documents
+ * that the client last knew to match the target, which lets the backend send a bloom filter of the
+ * documents that still match when the count has changed since the resume token.
+ */
+- (GCFSTarget *)encodedTarget:(FSTQueryData *)queryData
+                expectedCount:(absl::optional<int32_t>)expectedCount;
+
 - (GCFSTarget_DocumentsTarget *)encodedDocumentsTarget:(FSTQuery *)query;
 - (FSTQuery *)decodedQueryFromDocumentsTarget:(GCFSTarget_DocumentsTarget *)target;
 
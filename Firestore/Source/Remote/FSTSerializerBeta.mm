@@ -29,6 +29,11 @@
 #import "Firestore/Protos/objc/google/firestore/v1/Write.pbobjc.h"
 #import "Firestore/Protos/objc/google/rpc/Status.pbobjc.h"
 #import "Firestore/Protos/objc/google/type/Latlng.pbobjc.h"
+#import <Protobuf/GPBCodedInputStream.h>
+#import <Protobuf/GPBCodedOutputStream.h>
+#import <Protobuf/GPBUnknownField.h>
+#import <Protobuf/GPBUnknownFieldSet.h>
+#import <Protobuf/GPBWireFormat.h>
 
 #import "FIRFirestoreErrors.h"
 #import "FIRGeoPoint.h"
@@ -50,10 +55,13 @@
 #include "Firestore/core/src/firebase/firestore/model/precondition.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/transform_operations.h"
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
 #include "Firestore/core/src/firebase/firestore/remote/existence_filter.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "absl/memory/memory.h"
 #include "absl/types/optional.h"
@@ -65,6 +73,7 @@ using firebase::firestore::core::Filter;
 using firebase::firestore::model::ArrayTransform;
 using firebase::firestore::model::DatabaseId;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::FieldMask;
 using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::FieldTransform;
@@ -76,6 +85,7 @@ using firebase::firestore::model::ServerTimestampTransform;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
 using firebase::firestore::model::TransformOperation;
+using firebase::firestore::remote::BloomFilter;
 using firebase::firestore::remote::DocumentWatchChange;
 using firebase::firestore::remote::ExistenceFilter;
 using firebase::firestore::remote::ExistenceFilterWatchChange;
@@ -85,11 +95,6 @@ using firebase::firestore::remote::WatchTargetChangeState;
 
 NS_ASSUME_NONNULL_BEGIN
 
-@interface FSTSerializerBeta ()
-// Does not own this DatabaseId.
-@property(nonatomic, assign, readonly) const DatabaseId *databaseID;
-@end
-
 @implementation FSTSerializerBeta
 
 - (instancetype)initWithDatabaseID:(const DatabaseId *)databaseID {
@@ -146,7 +151,7 @@ NS_ASSUME_NONNULL_BEGIN
               "Tried to deserialize key from different project.");
   HARD_ASSERT(path[3] == self.databaseID->database_id(),
               "Tried to deserialize key from different datbase.");
-  return DocumentKey{[self localResourcePathForQualifiedResourcePath:path]};
+  return DocumentKey::Interned([self localResourcePathForQualifiedResourcePath:path]);
 }
 
 - (NSString *)encodedResourcePathForDatabaseID:(const DatabaseId *)databaseID
@@ -397,12 +402,12 @@ NS_ASSUME_NONNULL_BEGIN
  * @return a new dictionary that can be assigned to a field in another proto.
  */
 - (NSMutableDictionary<NSString *, GCFSValue *> *)encodedFields:(FSTObjectValue *)value {
-  FSTImmutableSortedDictionary<NSString *, FSTFieldValue *> *fields = value.internalValue;
-  NSMutableDictionary<NSString *, GCFSValue *> *result = [NSMutableDictionary dictionary];
-  [fields enumerateKeysAndObjectsUsingBlock:^(NSString *key, FSTFieldValue *obj, BOOL *stop) {
-    GCFSValue *converted = [self encodedFieldValue:obj];
-    result[key] = converted;
-  }];
+  const FSTObjectValueMap &fields = value.internalValue;
+  NSMutableDictionary<NSString *, GCFSValue *> *result =
+      [NSMutableDictionary dictionaryWithCapacity:fields.size()];
+  for (const auto &entry : fields) {
+    result[entry.first] = [self encodedFieldValue:entry.second];
+  }
   return result;
 }
 
@@ -740,10 +745,15 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (GCFSTarget *)encodedTarget:(FSTQueryData *)queryData {
+  return [self encodedTarget:queryData expectedCount:absl::nullopt];
+}
+
+- (GCFSTarget *)encodedTarget:(FSTQueryData *)queryData
+                expectedCount:(absl::optional<int32_t>)expectedCount {
   GCFSTarget *result = [GCFSTarget message];
   FSTQuery *query = queryData.query;
 
-  if ([query isDocumentQuery]) {
+  if ([query isDocumentQuery] || [query isDocumentKeysQuery]) {
     result.documents = [self encodedDocumentsTarget:query];
   } else {
     result.query = [self encodedQueryTarget:query];
@@ -753,24 +763,55 @@ NS_ASSUME_NONNULL_BEGIN
   if (queryData.resumeToken.length > 0) {
     result.resumeToken = queryData.resumeToken;
   }
+  if (expectedCount) {
+    [self encodeExpectedCount:*expectedCount inTarget:result];
+  }
 
   return result;
 }
 
+/**
+ * Adds `expected_count` to the given target.
+ *
+ * The checked-in protos predate the field, so it is written as unknown field 12 holding a
+ * `google.protobuf.Int32Value { int32 value = 1; }` message.
+ */
+- (void)encodeExpectedCount:(int32_t)expectedCount inTarget:(GCFSTarget *)target {
+  static const int32_t kExpectedCountFieldNumber = 12;
+  NSMutableData *value = [NSMutableData data];
+  GPBCodedOutputStream *output = [GPBCodedOutputStream streamWithData:value];
+  [output writeInt32:1 value:expectedCount];
+  [output flush];
+
+  GPBUnknownField *field = [[GPBUnknownField alloc] initWithNumber:kExpectedCountFieldNumber];
+  [field addLengthDelimited:value];
+  GPBUnknownFieldSet *fields = [[GPBUnknownFieldSet alloc] init];
+  [fields addField:field];
+  target.unknownFields = fields;
+}
+
 - (GCFSTarget_DocumentsTarget *)encodedDocumentsTarget:(FSTQuery *)query {
   GCFSTarget_DocumentsTarget *result = [GCFSTarget_DocumentsTarget message];
   NSMutableArray<NSString *> *docs = result.documentsArray;
-  [docs addObject:[self encodedQueryPath:query.path]];
+  if ([query isDocumentKeysQuery]) {
+    for (const DocumentKey &key : query.documentKeys) {
+      [docs addObject:[self encodedQueryPath:key.path()]];
+    }
+  } else {
+    [docs addObject:[self encodedQueryPath:query.path]];
+  }
   return result;
 }
 
 - (FSTQuery *)decodedQueryFromDocumentsTarget:(GCFSTarget_DocumentsTarget *)target {
   NSArray<NSString *> *documents = target.documentsArray;
-  HARD_ASSERT(documents.count == 1, "DocumentsTarget contained other than 1 document %s",
-              (unsigned long)documents.count);
+  HARD_ASSERT(documents.count > 0, "DocumentsTarget contained no documents");
 
-  NSString *name = documents[0];
-  return [FSTQuery queryWithPath:[self decodedQueryPath:name]];
+  DocumentKeySet keys;
+  for (NSString *name in documents) {
+    keys = keys.insert(DocumentKey{[self decodedQueryPath:name]});
+  }
+  return [FSTQuery queryWithDocumentKeys:std::move(keys)];
 }
 
 - (GCFSTarget_QueryTarget *)encodedQueryTarget:(FSTQuery *)query {
@@ -793,6 +834,11 @@ NS_ASSUME_NONNULL_BEGIN
     [queryTarget.structuredQuery.fromArray addObject:from];
   }
 
+  // Encode the projection.
+  for (const FieldPath &field : query.projection) {
+    [queryTarget.structuredQuery.select.fieldsArray addObject:[self encodedFieldPath:field]];
+  }
+
   // Encode the filters.
   GCFSStructuredQuery_Filter *_Nullable where = [self encodedFilters:query.filters];
   if (where) {
@@ -866,13 +912,21 @@ NS_ASSUME_NONNULL_BEGIN
     endAt = [self decodedBound:query.endAt];
   }
 
+  std::vector<FieldPath> projection;
+  if (query.hasSelect) {
+    for (GCFSStructuredQuery_FieldReference *field in query.select.fieldsArray) {
+      projection.push_back(FieldPath::FromServerFormat(util::MakeString(field.fieldPath)));
+    }
+  }
+
   return [[FSTQuery alloc] initWithPath:path
                         collectionGroup:collectionGroup
                                filterBy:filterBy
                                 orderBy:orderBy
                                   limit:limit
                                 startAt:startAt
-                                  endAt:endAt];
+                                  endAt:endAt
+                             projection:std::move(projection)];
 }
 
 #pragma mark Filters
@@ -1216,11 +1270,70 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (std::unique_ptr<WatchChange>)decodedExistenceFilterWatchChange:(GCFSExistenceFilter *)filter {
-  ExistenceFilter existenceFilter{filter.count};
+  ExistenceFilter existenceFilter{filter.count, [self decodedUnchangedNames:filter]};
   TargetId targetID = filter.targetId;
   return absl::make_unique<ExistenceFilterWatchChange>(existenceFilter, targetID);
 }
 
+/**
+ * Decodes the optional `unchanged_names` bloom filter of an existence filter.
+ *
+ * The checked-in protos predate the field, so it arrives as unknown field 3 holding a
+ * `BloomFilter { BitSequence bits = 1; int32 hash_count = 2; }` message, where
+ * `BitSequence { bytes bitmap = 1; int32 padding = 2; }`. A malformed filter is ignored, which
+ * makes a count mismatch fall back to resetting the target.
+ */
+- (absl::optional<BloomFilter>)decodedUnchangedNames:(GCFSExistenceFilter *)filter {
+  static const int32_t kUnchangedNamesFieldNumber = 3;
+  NSData *encoded =
+      [[filter.unknownFields getField:kUnchangedNamesFieldNumber] lengthDelimitedList].firstObject;
+  if (!encoded) {
+    return absl::nullopt;
+  }
+
+  NSData *bitmap = [NSData data];
+  int32_t padding = 0;
+  int32_t hashCount = 0;
+  @try {
+    GPBCodedInputStream *bloomFilter = [GPBCodedInputStream streamWithData:encoded];
+    for (int32_t tag = [bloomFilter readTag]; tag != 0; tag = [bloomFilter readTag]) {
+      int32_t fieldNumber = GPBWireFormatGetTagFieldNumber(tag);
+      if (fieldNumber == 1 && GPBWireFormatGetTagWireType(tag) == GPBWireFormatLengthDelimited) {
+        GPBCodedInputStream *bits = [GPBCodedInputStream streamWithData:[bloomFilter readBytes]];
+        for (int32_t bitsTag = [bits readTag]; bitsTag != 0; bitsTag = [bits readTag]) {
+          int32_t bitsFieldNumber = GPBWireFormatGetTagFieldNumber(bitsTag);
+          if (bitsFieldNumber == 1 &&
+              GPBWireFormatGetTagWireType(bitsTag) == GPBWireFormatLengthDelimited) {
+            bitmap = [bits readBytes];
+          } else if (bitsFieldNumber == 2 &&
+                     GPBWireFormatGetTagWireType(bitsTag) == GPBWireFormatVarint) {
+            padding = [bits readInt32];
+          } else if (![bits skipField:bitsTag]) {
+            break;
+          }
+        }
+      } else if (fieldNumber == 2 && GPBWireFormatGetTagWireType(tag) == GPBWireFormatVarint) {
+        hashCount = [bloomFilter readInt32];
+      } else if (![bloomFilter skipField:tag]) {
+        break;
+      }
+    }
+  } @catch (NSException *exception) {
+    LOG_WARN("Ignoring malformed bloom filter in existence filter: %s", exception.reason);
+    return absl::nullopt;
+  }
+
+  const auto *bytes = static_cast<const uint8_t *>(bitmap.bytes);
+  util::StatusOr<BloomFilter> maybeFilter = BloomFilter::Create(
+      std::vector<uint8_t>(bytes, bytes + bitmap.length), padding, hashCount);
+  if (!maybeFilter.ok()) {
+    LOG_WARN("Ignoring invalid bloom filter in existence filter: %s",
+             maybeFilter.status().ToString());
+    return absl::nullopt;
+  }
+  return std::move(maybeFilter).ValueOrDie();
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
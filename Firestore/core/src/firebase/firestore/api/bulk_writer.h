@@ -0,0 +1,197 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_BULK_WRITER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_BULK_WRITER_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/api/document_reference.h"
+#include "Firestore/core/src/firebase/firestore/objc/objc_class.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+OBJC_CLASS(FSTMutation);
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+class ParsedSetData;
+class ParsedUpdateData;
+
+}  // namespace core
+
+namespace api {
+
+class Firestore;
+
+/** Tuning parameters for a `BulkWriter`. */
+struct BulkWriterOptions {
+  /**
+   * The maximum number of mutations committed in one batch. The backend
+   * rejects commits of more than 500 writes.
+   */
+  int max_mutations_per_batch = 500;
+
+  /**
+   * The maximum number of batches that have been committed but not yet
+   * acknowledged. The default matches the number of batches `RemoteStore` keeps
+   * in its write pipeline, so that the pipeline stays full without batches
+   * piling up in the mutation queue.
+   */
+  int max_pending_batches = 10;
+};
+
+/** Progress of a `BulkWriter`. */
+struct BulkWriterStats {
+  /** The number of documents whose write was acknowledged by the backend. */
+  int64_t documents_written = 0;
+
+  /** The number of documents whose write failed. */
+  int64_t documents_failed = 0;
+
+  /** The number of batches acknowledged by the backend, including retries. */
+  int64_t batches_committed = 0;
+
+  /**
+   * The time from the creation of the writer until now, or until all its
+   * writes completed if it has been closed.
+   */
+  std::chrono::milliseconds elapsed{0};
+
+  /** The average number of documents written per second. */
+  double documents_per_second() const;
+};
+
+/**
+ * Writes a large number of documents as fast as the backend accepts them.
+ *
+ * Unlike a `WriteBatch`, the writes are not atomic: they are chunked into
+ * batches of up to `max_mutations_per_batch` mutations, up to
+ * `max_pending_batches` of which are committed at a time. Further batches wait
+ * in memory until earlier ones are acknowledged, which keeps the mutation
+ * queue (where every committed batch is persisted and applied to local views)
+ * from growing without bound.
+ *
+ * A batch that is rejected with a permanent error is retried one document at a
+ * time, so that a single bad write only fails itself.
+ *
+ * This class is thread safe. Callbacks are invoked on the user executor of the
+ * Firestore client.
+ */
+class BulkWriter : public std::enable_shared_from_this<BulkWriter> {
+ public:
+  using StatsCallback = std::function<void(BulkWriterStats)>;
+
+  /** Commits the given mutations as one batch and reports its result. */
+  using CommitFunction =
+      std::function<void(std::vector<FSTMutation*>, util::StatusCallback)>;
+
+  /** Creates a writer that commits its batches through the client. */
+  BulkWriter(std::shared_ptr<Firestore> firestore, BulkWriterOptions options);
+
+  /**
+   * Creates a writer that commits its batches with `commit`. Exposed for
+   * testing.
+   */
+  BulkWriter(std::shared_ptr<Firestore> firestore,
+             BulkWriterOptions options,
+             CommitFunction commit);
+
+  /**
+   * Adds the given writes, calling `callback` (if any) with the result of
+   * writing the document.
+   */
+  void SetData(const DocumentReference& reference,
+               core::ParsedSetData&& set_data,
+               util::StatusCallback callback = nullptr);
+  void UpdateData(const DocumentReference& reference,
+                  core::ParsedUpdateData&& update_data,
+                  util::StatusCallback callback = nullptr);
+  void DeleteData(const DocumentReference& reference,
+                  util::StatusCallback callback = nullptr);
+
+  /** Commits the writes added so far, even if they don't fill a batch. */
+  void Flush();
+
+  /**
+   * Commits all writes added so far and calls `callback` once they have all
+   * completed. No writes may be added after closing.
+   */
+  void Close(StatsCallback callback);
+
+  BulkWriterStats stats() const;
+
+ private:
+  struct Write {
+    std::vector<FSTMutation*> mutations;
+    util::StatusCallback callback;
+  };
+  using Batch = std::vector<Write>;
+  using Clock = std::chrono::steady_clock;
+
+  void AddWrite(const DocumentReference& reference,
+                std::vector<FSTMutation*>&& mutations,
+                util::StatusCallback&& callback);
+
+  void FlushLocked();
+  void CommitPendingBatchesLocked();
+  void OnBatchCompleted(const std::shared_ptr<Batch>& batch,
+                        const util::Status& status);
+
+  bool IsFinishedLocked() const;
+  BulkWriterStats StatsLocked() const;
+
+  std::shared_ptr<Firestore> firestore_;
+  BulkWriterOptions options_;
+  CommitFunction commit_;
+
+  mutable std::mutex mutex_;
+
+  /** The batch being filled. */
+  Batch current_batch_;
+  int current_batch_mutations_ = 0;
+
+  /** Batches that are full but wait for earlier ones to be acknowledged. */
+  std::deque<Batch> queued_batches_;
+  int pending_batches_ = 0;
+
+  bool closed_ = false;
+  StatsCallback close_callback_;
+
+  int64_t documents_written_ = 0;
+  int64_t documents_failed_ = 0;
+  int64_t batches_committed_ = 0;
+  Clock::time_point start_time_;
+  Clock::time_point finish_time_;
+};
+
+}  // namespace api
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_BULK_WRITER_H_
@@ -0,0 +1,264 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/api/bulk_writer.h"
+
+#include <algorithm>
+#include <iterator>
+
+#import "Firestore/Source/Core/FSTFirestoreClient.h"
+#import "Firestore/Source/Model/FSTMutation.h"
+
+#include "Firestore/core/src/firebase/firestore/api/firestore.h"
+#include "Firestore/core/src/firebase/firestore/api/input_validation.h"
+#include "Firestore/core/src/firebase/firestore/core/user_data.h"
+#include "Firestore/core/src/firebase/firestore/remote/datastore.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace api {
+
+using remote::Datastore;
+using util::Status;
+using util::StatusCallback;
+
+namespace {
+
+BulkWriter::CommitFunction CommitThroughClient(Firestore* firestore) {
+  return [firestore](std::vector<FSTMutation*> mutations,
+                     StatusCallback callback) {
+    [firestore->client() writeMutations:std::move(mutations)
+                                callback:std::move(callback)];
+  };
+}
+
+}  // namespace
+
+double BulkWriterStats::documents_per_second() const {
+  if (elapsed.count() <= 0) {
+    return 0;
+  }
+  return documents_written * 1000.0 / elapsed.count();
+}
+
+BulkWriter::BulkWriter(std::shared_ptr<Firestore> firestore,
+                       BulkWriterOptions options)
+    : BulkWriter{firestore, options, CommitThroughClient(firestore.get())} {
+}
+
+BulkWriter::BulkWriter(std::shared_ptr<Firestore> firestore,
+                       BulkWriterOptions options,
+                       CommitFunction commit)
+    : firestore_{std::move(firestore)},
+      options_{options},
+      commit_{std::move(commit)},
+      start_time_{Clock::now()} {
+  HARD_ASSERT(options_.max_mutations_per_batch > 0 &&
+                  options_.max_pending_batches > 0,
+              "BulkWriter needs room for at least one pending mutation");
+}
+
+void BulkWriter::SetData(const DocumentReference& reference,
+                         core::ParsedSetData&& set_data,
+                         StatusCallback callback) {
+  AddWrite(reference,
+           std::move(set_data).ToMutations(reference.key(),
+                                           model::Precondition::None()),
+           std::move(callback));
+}
+
+void BulkWriter::UpdateData(const DocumentReference& reference,
+                            core::ParsedUpdateData&& update_data,
+                            StatusCallback callback) {
+  AddWrite(reference,
+           std::move(update_data)
+               .ToMutations(reference.key(), model::Precondition::Exists(true)),
+           std::move(callback));
+}
+
+void BulkWriter::DeleteData(const DocumentReference& reference,
+                            StatusCallback callback) {
+  std::vector<FSTMutation*> mutations{[[FSTDeleteMutation alloc]
+       initWithKey:reference.key()
+      precondition:model::Precondition::None()]};
+  AddWrite(reference, std::move(mutations), std::move(callback));
+}
+
+void BulkWriter::AddWrite(const DocumentReference& reference,
+                          std::vector<FSTMutation*>&& mutations,
+                          StatusCallback&& callback) {
+  if (reference.firestore() != firestore_) {
+    ThrowInvalidArgument("Provided document reference is from a different "
+                         "Firestore instance.");
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (closed_) {
+    ThrowIllegalState(
+        "A bulk writer can no longer be used after close has been called.");
+  }
+
+  // Keep all the mutations of a document (e.g. a set and its transforms) in
+  // one batch, so that they are applied atomically.
+  int count = static_cast<int>(mutations.size());
+  if (current_batch_mutations_ > 0 &&
+      current_batch_mutations_ + count > options_.max_mutations_per_batch) {
+    FlushLocked();
+  }
+
+  current_batch_.push_back(Write{std::move(mutations), std::move(callback)});
+  current_batch_mutations_ += count;
+  if (current_batch_mutations_ >= options_.max_mutations_per_batch) {
+    FlushLocked();
+  }
+}
+
+void BulkWriter::Flush() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  FlushLocked();
+}
+
+void BulkWriter::Close(StatsCallback callback) {
+  StatsCallback close_callback;
+  BulkWriterStats stats;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (closed_) {
+      ThrowIllegalState("A bulk writer can only be closed once.");
+    }
+    closed_ = true;
+    close_callback_ = std::move(callback);
+    FlushLocked();
+    if (!IsFinishedLocked()) {
+      return;
+    }
+    finish_time_ = Clock::now();
+    close_callback = std::move(close_callback_);
+    stats = StatsLocked();
+  }
+
+  // Nothing was pending. Committing no mutations still reports back on the
+  // user executor, like the other callbacks.
+  if (close_callback) {
+    commit_({}, [close_callback, stats](Status) { close_callback(stats); });
+  }
+}
+
+BulkWriterStats BulkWriter::stats() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return StatsLocked();
+}
+
+void BulkWriter::FlushLocked() {
+  if (!current_batch_.empty()) {
+    queued_batches_.push_back(std::move(current_batch_));
+    current_batch_.clear();
+    current_batch_mutations_ = 0;
+  }
+  CommitPendingBatchesLocked();
+}
+
+void BulkWriter::CommitPendingBatchesLocked() {
+  while (pending_batches_ < options_.max_pending_batches &&
+         !queued_batches_.empty()) {
+    auto batch = std::make_shared<Batch>(std::move(queued_batches_.front()));
+    queued_batches_.pop_front();
+    ++pending_batches_;
+
+    std::vector<FSTMutation*> mutations;
+    for (const Write& write : *batch) {
+      std::copy(write.mutations.begin(), write.mutations.end(),
+                std::back_inserter(mutations));
+    }
+
+    std::shared_ptr<BulkWriter> shared_this = shared_from_this();
+    commit_(std::move(mutations), [shared_this, batch](Status status) {
+      shared_this->OnBatchCompleted(batch, status);
+    });
+  }
+}
+
+void BulkWriter::OnBatchCompleted(const std::shared_ptr<Batch>& batch,
+                                  const Status& status) {
+  std::vector<StatusCallback> to_notify;
+  StatsCallback close_callback;
+  BulkWriterStats stats;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    --pending_batches_;
+
+    if (status.ok()) {
+      documents_written_ += static_cast<int64_t>(batch->size());
+      ++batches_committed_;
+    } else if (batch->size() > 1 && Datastore::IsPermanentWriteError(status)) {
+      // The batch was rejected as a whole. Retry each document on its own
+      // ahead of the batches that are still queued.
+      for (auto it = batch->rbegin(); it != batch->rend(); ++it) {
+        queued_batches_.push_front(Batch{});
+        queued_batches_.front().push_back(std::move(*it));
+      }
+      batch->clear();
+    } else {
+      documents_failed_ += static_cast<int64_t>(batch->size());
+    }
+
+    for (Write& write : *batch) {
+      if (write.callback) {
+        to_notify.push_back(std::move(write.callback));
+      }
+    }
+
+    CommitPendingBatchesLocked();
+
+    if (IsFinishedLocked()) {
+      finish_time_ = Clock::now();
+      close_callback = std::move(close_callback_);
+      stats = StatsLocked();
+    }
+  }
+
+  for (const StatusCallback& callback : to_notify) {
+    callback(status);
+  }
+  if (close_callback) {
+    close_callback(stats);
+  }
+}
+
+bool BulkWriter::IsFinishedLocked() const {
+  return closed_ && current_batch_.empty() && queued_batches_.empty() &&
+         pending_batches_ == 0;
+}
+
+BulkWriterStats BulkWriter::StatsLocked() const {
+  BulkWriterStats stats;
+  stats.documents_written = documents_written_;
+  stats.documents_failed = documents_failed_;
+  stats.batches_committed = batches_committed_;
+  Clock::time_point end = IsFinishedLocked() ? finish_time_ : Clock::now();
+  stats.elapsed =
+      std::chrono::duration_cast<std::chrono::milliseconds>(end - start_time_);
+  return stats;
+}
+
+}  // namespace api
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
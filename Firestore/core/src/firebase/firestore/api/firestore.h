@@ -24,11 +24,15 @@
 #include <string>
 #include <utility>
 
+#include "Firestore/core/src/firebase/firestore/api/bulk_writer.h"
 #include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
+#include "Firestore/core/src/firebase/firestore/core/memory_stats.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/objc/objc_class.h"
+#include "Firestore/core/src/firebase/firestore/remote/rpc_metrics.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor_callback.h"
@@ -40,6 +44,7 @@ OBJC_CLASS(FIRCollectionReference);
 OBJC_CLASS(FIRQuery);
 OBJC_CLASS(FIRTransaction);
 OBJC_CLASS(FSTFirestoreClient);
+OBJC_CLASS(NSData);
 OBJC_CLASS(NSString);
 
 namespace firebase {
@@ -84,7 +89,9 @@ class Firestore : public std::enable_shared_from_this<Firestore> {
   FIRCollectionReference* GetCollection(absl::string_view collection_path);
   DocumentReference GetDocument(absl::string_view document_path);
   WriteBatch GetBatch();
+  std::shared_ptr<BulkWriter> GetBulkWriter(BulkWriterOptions options = {});
   FIRQuery* GetCollectionGroup(NSString* collection_id);
+  FIRQuery* GetDocumentsQuery(model::DocumentKeySet keys);
 
   void RunTransaction(core::TransactionUpdateCallback update_callback,
                       core::TransactionResultCallback result_callback);
@@ -94,6 +101,28 @@ class Firestore : public std::enable_shared_from_this<Firestore> {
   void EnableNetwork(util::StatusCallback callback);
   void DisableNetwork(util::StatusCallback callback);
 
+  /** Connects to the backend ahead of the first listen or write. */
+  void WarmUpConnection();
+
+  void GetRpcStats(remote::RpcStatsCallback callback);
+
+  /** Estimates the memory held by the caches and in-flight state. */
+  void GetMemoryStats(core::MemoryStatsCallback callback);
+
+  /** Drops the caches that can be rebuilt, e.g. on a low memory warning. */
+  void ReleaseMemory(util::StatusCallback callback);
+
+  /**
+   * Writes a bundle of precomputed query results straight into the local
+   * cache, e.g. to seed it on first launch without fetching each document
+   * through the watch stream. A bundle is a length-delimited
+   * `firestore.client.Target` (the query, its read time and resume token)
+   * followed by the length-delimited `firestore.client.MaybeDocument`s that
+   * matched it. Listening to the query afterwards resumes from the bundle's
+   * resume token.
+   */
+  void LoadBundle(NSData* bundle, util::StatusCallback callback);
+
  private:
   void EnsureClientConfigured();
 
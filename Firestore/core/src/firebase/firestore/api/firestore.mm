@@ -45,6 +45,7 @@ using auth::CredentialsProvider;
 using core::DatabaseInfo;
 using core::Transaction;
 using model::DocumentKey;
+using model::DocumentKeySet;
 using model::ResourcePath;
 using util::AsyncQueue;
 using util::Executor;
@@ -118,6 +119,12 @@ WriteBatch Firestore::GetBatch() {
   return WriteBatch(shared_from_this());
 }
 
+std::shared_ptr<BulkWriter> Firestore::GetBulkWriter(
+    BulkWriterOptions options) {
+  EnsureClientConfigured();
+  return std::make_shared<BulkWriter>(shared_from_this(), options);
+}
+
 FIRQuery* Firestore::GetCollectionGroup(NSString* collection_id) {
   EnsureClientConfigured();
   FIRFirestore* wrapper =
@@ -129,6 +136,16 @@ FIRQuery* Firestore::GetCollectionGroup(NSString* collection_id) {
                          firestore:wrapper];
 }
 
+FIRQuery* Firestore::GetDocumentsQuery(DocumentKeySet keys) {
+  EnsureClientConfigured();
+  FIRFirestore* wrapper =
+      [FIRFirestore recoverFromFirestore:shared_from_this()];
+
+  return [FIRQuery
+      referenceWithQuery:[FSTQuery queryWithDocumentKeys:std::move(keys)]
+               firestore:wrapper];
+}
+
 void Firestore::RunTransaction(
     core::TransactionUpdateCallback update_callback,
     core::TransactionResultCallback result_callback) {
@@ -156,12 +173,40 @@ void Firestore::DisableNetwork(util::StatusCallback callback) {
   [client_ disableNetworkWithCallback:std::move(callback)];
 }
 
+void Firestore::WarmUpConnection() {
+  EnsureClientConfigured();
+  [client_ warmUpConnection];
+}
+
+void Firestore::GetRpcStats(remote::RpcStatsCallback callback) {
+  EnsureClientConfigured();
+  [client_ getRpcStatsWithCallback:std::move(callback)];
+}
+
+void Firestore::GetMemoryStats(core::MemoryStatsCallback callback) {
+  EnsureClientConfigured();
+  [client_ getMemoryStatsWithCallback:std::move(callback)];
+}
+
+void Firestore::ReleaseMemory(util::StatusCallback callback) {
+  EnsureClientConfigured();
+  [client_ releaseRebuildableMemoryWithCallback:std::move(callback)];
+}
+
+void Firestore::LoadBundle(NSData* bundle, util::StatusCallback callback) {
+  EnsureClientConfigured();
+  [client_ loadBundle:bundle callback:std::move(callback)];
+}
+
 void Firestore::EnsureClientConfigured() {
   std::lock_guard<std::mutex> lock{mutex_};
 
   if (!client_) {
     DatabaseInfo database_info(database_id_, persistence_key_, settings_.host(),
-                               settings_.ssl_enabled());
+                               settings_.ssl_enabled(),
+                               settings_.channel_count(),
+                               settings_.compression(),
+                               settings_.compression_threshold_bytes());
 
     HARD_ASSERT(worker_queue_, "Expected non-null worker queue");
     client_ =
@@ -17,25 +17,181 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_QUERY_SNAPSHOT_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_QUERY_SNAPSHOT_H_
 
+#include <cstddef>
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/api/document_change.h"
 #include "Firestore/core/src/firebase/firestore/api/document_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/api/snapshot_metadata.h"
+#include "Firestore/core/src/firebase/firestore/core/field_column.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/objc/objc_class.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+OBJC_CLASS(FSTDocument);
 OBJC_CLASS(FSTQuery);
 
 namespace firebase {
 namespace firestore {
 namespace api {
 
+class QuerySnapshot;
+
+/**
+ * A document of a `QuerySnapshot`, borrowed from the snapshot instead of being
+ * wrapped in a `DocumentSnapshot`. A view is only valid as long as the
+ * snapshot it came from; call `ToSnapshot` to get a `DocumentSnapshot` that
+ * can outlive it.
+ */
+class QueryDocumentView {
+ public:
+  FSTDocument* document() const;
+
+  const model::DocumentKey& key() const;
+
+  bool has_pending_writes() const;
+
+  DocumentSnapshot ToSnapshot() const;
+
+ private:
+  friend class QueryDocumentRange;
+  friend class QuerySnapshot;
+
+  QueryDocumentView(const QuerySnapshot* snapshot, FSTDocument* document);
+
+  const QuerySnapshot* snapshot_;
+  objc::Handle<FSTDocument> document_;
+};
+
+/**
+ * A change to a document of a `QuerySnapshot`, like a `DocumentChange` but
+ * holding a borrowed `QueryDocumentView` of the document.
+ */
+class DocumentChangeView {
+ public:
+  DocumentChange::Type type() const {
+    return type_;
+  }
+
+  const QueryDocumentView& document() const {
+    return document_;
+  }
+
+  size_t old_index() const {
+    return old_index_;
+  }
+
+  size_t new_index() const {
+    return new_index_;
+  }
+
+  DocumentChange ToChange() const {
+    return DocumentChange(type_, document_.ToSnapshot(), old_index_,
+                          new_index_);
+  }
+
+ private:
+  friend class QuerySnapshot;
+
+  DocumentChangeView(DocumentChange::Type type,
+                     QueryDocumentView document,
+                     size_t old_index,
+                     size_t new_index)
+      : type_{type},
+        document_{document},
+        old_index_{old_index},
+        new_index_{new_index} {
+  }
+
+  DocumentChange::Type type_;
+  QueryDocumentView document_;
+  size_t old_index_;
+  size_t new_index_;
+};
+
+/**
+ * The documents of a `QuerySnapshot`, in query order, as a range of
+ * `QueryDocumentView`s. Iterating over the range allocates nothing.
+ */
+class QueryDocumentRange {
+ public:
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = QueryDocumentView;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const QueryDocumentView*;
+    using reference = QueryDocumentView;
+
+    QueryDocumentView operator*() const;
+
+    const_iterator& operator++() {
+      ++iter_;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator result = *this;
+      ++iter_;
+      return result;
+    }
+
+    friend bool operator==(const const_iterator& lhs,
+                           const const_iterator& rhs) {
+      return lhs.iter_ == rhs.iter_;
+    }
+
+    friend bool operator!=(const const_iterator& lhs,
+                           const const_iterator& rhs) {
+      return !(lhs == rhs);
+    }
+
+   private:
+    friend class QueryDocumentRange;
+
+    const_iterator(const QuerySnapshot* snapshot,
+                   model::DocumentSet::const_iterator iter)
+        : snapshot_{snapshot}, iter_{iter} {
+    }
+
+    const QuerySnapshot* snapshot_;
+    model::DocumentSet::const_iterator iter_;
+  };
+
+  const_iterator begin() const {
+    return const_iterator{snapshot_, documents_->begin()};
+  }
+
+  const_iterator end() const {
+    return const_iterator{snapshot_, documents_->end()};
+  }
+
+  size_t size() const {
+    return documents_->size();
+  }
+
+  bool empty() const {
+    return documents_->empty();
+  }
+
+ private:
+  friend class QuerySnapshot;
+
+  QueryDocumentRange(const QuerySnapshot* snapshot,
+                     const model::DocumentSet* documents)
+      : snapshot_{snapshot}, documents_{documents} {
+  }
+
+  const QuerySnapshot* snapshot_;
+  const model::DocumentSet* documents_;
+};
+
 /**
  * A `QuerySnapshot` contains zero or more `DocumentSnapshot` objects.
  */
@@ -78,6 +234,16 @@ class QuerySnapshot {
   void ForEachDocument(
       const std::function<void(DocumentSnapshot)>& callback) const;
 
+  /**
+   * The documents that make up this query snapshot, as borrowed views. Unlike
+   * `ForEachDocument`, this doesn't create a `DocumentSnapshot` (and copy
+   * a `shared_ptr<Firestore>`) per document, so prefer it for large results
+   * of which only some documents are handed out.
+   */
+  QueryDocumentRange documents() const {
+    return QueryDocumentRange{this, &snapshot_.documents()};
+  }
+
   /**
    * Iterates over the `DocumentChanges` representing the changes between
    * the prior snapshot and this one.
@@ -85,9 +251,29 @@ class QuerySnapshot {
   void ForEachChange(bool include_metadata_changes,
                      const std::function<void(DocumentChange)>& callback) const;
 
+  /**
+   * Like `ForEachChange`, but yields borrowed views of the changed documents
+   * instead of `DocumentSnapshot`s.
+   */
+  void ForEachChangeView(
+      bool include_metadata_changes,
+      const std::function<void(const DocumentChangeView&)>& callback) const;
+
+  /**
+   * Extracts the given field from every document in this snapshot into a
+   * column, in the same order as `ForEachDocument`. Building a column visits
+   * each document once; prefer it over `ForEachDocument` when only a single
+   * field of a large result is needed.
+   */
+  core::FieldColumn Column(const model::FieldPath& field) const {
+    return core::FieldColumn{snapshot_.documents(), field};
+  }
+
   friend bool operator==(const QuerySnapshot& lhs, const QuerySnapshot& rhs);
 
  private:
+  friend class QueryDocumentView;
+
   std::shared_ptr<Firestore> firestore_;
   objc::Handle<FSTQuery> internal_query_;
   core::ViewSnapshot snapshot_;
@@ -67,16 +67,37 @@ size_t QuerySnapshot::Hash() const {
   return util::Hash(firestore_.get(), internal_query_, snapshot_, metadata_);
 }
 
+QueryDocumentView::QueryDocumentView(const QuerySnapshot* snapshot,
+                                     FSTDocument* document)
+    : snapshot_{snapshot}, document_{document} {
+}
+
+FSTDocument* QueryDocumentView::document() const {
+  return document_;
+}
+
+const model::DocumentKey& QueryDocumentView::key() const {
+  return document().key;
+}
+
+bool QueryDocumentView::has_pending_writes() const {
+  return snapshot_->snapshot_.mutated_keys().contains(key());
+}
+
+DocumentSnapshot QueryDocumentView::ToSnapshot() const {
+  return DocumentSnapshot(snapshot_->firestore_, key(), document(),
+                          snapshot_->metadata_.from_cache(),
+                          has_pending_writes());
+}
+
+QueryDocumentView QueryDocumentRange::const_iterator::operator*() const {
+  return QueryDocumentView{snapshot_, *iter_};
+}
+
 void QuerySnapshot::ForEachDocument(
     const std::function<void(DocumentSnapshot)>& callback) const {
-  DocumentSet documentSet = snapshot_.documents();
-  bool from_cache = metadata_.from_cache();
-
-  for (FSTDocument* document : documentSet) {
-    bool has_pending_writes = snapshot_.mutated_keys().contains(document.key);
-    DocumentSnapshot snap(firestore_, document.key, document, from_cache,
-                          has_pending_writes);
-    callback(std::move(snap));
+  for (const QueryDocumentView& document : documents()) {
+    callback(document.ToSnapshot());
   }
 }
 
@@ -98,6 +119,15 @@ static DocumentChange::Type DocumentChangeTypeForChange(
 void QuerySnapshot::ForEachChange(
     bool include_metadata_changes,
     const std::function<void(DocumentChange)>& callback) const {
+  ForEachChangeView(include_metadata_changes,
+                    [&callback](const DocumentChangeView& change) {
+                      callback(change.ToChange());
+                    });
+}
+
+void QuerySnapshot::ForEachChangeView(
+    bool include_metadata_changes,
+    const std::function<void(const DocumentChangeView&)>& callback) const {
   if (include_metadata_changes && snapshot_.excludes_metadata_changes()) {
     ThrowInvalidArgument("To include metadata changes with your document "
                          "changes, you must call "
@@ -111,12 +141,6 @@ void QuerySnapshot::ForEachChange(
     FSTDocument* last_document = nil;
     size_t index = 0;
     for (const DocumentViewChange& change : snapshot_.document_changes()) {
-      FSTDocument* doc = change.document();
-      SnapshotMetadata metadata(
-          /*pending_writes=*/snapshot_.mutated_keys().contains(doc.key),
-          /*from_cache=*/snapshot_.from_cache());
-      DocumentSnapshot document(firestore_, doc.key, doc, metadata);
-
       HARD_ASSERT(change.type() == DocumentViewChange::Type::kAdded,
                   "Invalid event type for first snapshot");
       HARD_ASSERT(!last_document ||
@@ -124,8 +148,9 @@ void QuerySnapshot::ForEachChange(
                           last_document, change.document())),
                   "Got added events in wrong order");
 
-      callback(DocumentChange(DocumentChange::Type::Added, std::move(document),
-                              DocumentChange::npos, index++));
+      callback(DocumentChangeView(DocumentChange::Type::Added,
+                                  QueryDocumentView{this, change.document()},
+                                  DocumentChange::npos, index++));
     }
 
   } else {
@@ -138,12 +163,6 @@ void QuerySnapshot::ForEachChange(
         continue;
       }
 
-      FSTDocument* doc = change.document();
-      SnapshotMetadata metadata(
-          /*pending_writes=*/snapshot_.mutated_keys().contains(doc.key),
-          /*from_cache=*/snapshot_.from_cache());
-      DocumentSnapshot document(firestore_, doc.key, doc, metadata);
-
       size_t old_index = DocumentChange::npos;
       size_t new_index = DocumentChange::npos;
       if (change.type() != DocumentViewChange::Type::kAdded) {
@@ -158,7 +177,9 @@ void QuerySnapshot::ForEachChange(
       }
 
       DocumentChange::Type type = DocumentChangeTypeForChange(change);
-      callback(DocumentChange(type, std::move(document), old_index, new_index));
+      callback(DocumentChangeView(type,
+                                  QueryDocumentView{this, change.document()},
+                                  old_index, new_index));
     }
   }
 }
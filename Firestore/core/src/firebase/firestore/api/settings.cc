@@ -22,16 +22,75 @@ namespace firebase {
 namespace firestore {
 namespace api {
 
+constexpr int64_t PersistenceSettings::DefaultBlockCacheSizeBytes;
+constexpr int64_t PersistenceSettings::DefaultWriteBufferSizeBytes;
+constexpr bool PersistenceSettings::DefaultCompressionEnabled;
+constexpr int PersistenceSettings::DefaultBloomFilterBitsPerKey;
+constexpr bool PersistenceSettings::DefaultVerifyChecksums;
+constexpr bool PersistenceSettings::DefaultNativeSerializationEnabled;
+constexpr int PersistenceSettings::DefaultRemoteDocumentBatchSize;
+constexpr bool PersistenceSettings::DefaultBackgroundMigrationsEnabled;
+constexpr int PersistenceSettings::DefaultWarmSnapshotTargetCount;
+constexpr bool PersistenceSettings::DefaultCompactTargetDocumentsEnabled;
+constexpr bool PersistenceSettings::DefaultValueCompressionEnabled;
+constexpr bool PersistenceSettings::DefaultSyncWrites;
+constexpr int PersistenceSettings::DefaultSyncIntervalMs;
+constexpr int PersistenceSettings::DefaultGroupCommitDelayMs;
+constexpr bool PersistenceSettings::DefaultExportReadOnly;
+
+size_t PersistenceSettings::Hash() const {
+  return util::Hash(block_cache_size_bytes, write_buffer_size_bytes,
+                    compression_enabled, bloom_filter_bits_per_key,
+                    verify_checksums, native_serialization_enabled,
+                    remote_document_batch_size, background_migrations_enabled,
+                    warm_snapshot_target_count,
+                    compact_target_documents_enabled,
+                    value_compression_enabled, sync_writes, sync_interval_ms,
+                    group_commit_delay_ms, export_directory, export_read_only);
+}
+
+bool operator==(const PersistenceSettings& lhs,
+                const PersistenceSettings& rhs) {
+  return lhs.block_cache_size_bytes == rhs.block_cache_size_bytes &&
+         lhs.write_buffer_size_bytes == rhs.write_buffer_size_bytes &&
+         lhs.compression_enabled == rhs.compression_enabled &&
+         lhs.bloom_filter_bits_per_key == rhs.bloom_filter_bits_per_key &&
+         lhs.verify_checksums == rhs.verify_checksums &&
+         lhs.native_serialization_enabled ==
+             rhs.native_serialization_enabled &&
+         lhs.remote_document_batch_size == rhs.remote_document_batch_size &&
+         lhs.background_migrations_enabled ==
+             rhs.background_migrations_enabled &&
+         lhs.warm_snapshot_target_count == rhs.warm_snapshot_target_count &&
+         lhs.compact_target_documents_enabled ==
+             rhs.compact_target_documents_enabled &&
+         lhs.value_compression_enabled == rhs.value_compression_enabled &&
+         lhs.sync_writes == rhs.sync_writes &&
+         lhs.sync_interval_ms == rhs.sync_interval_ms &&
+         lhs.group_commit_delay_ms == rhs.group_commit_delay_ms &&
+         lhs.export_directory == rhs.export_directory &&
+         lhs.export_read_only == rhs.export_read_only;
+}
+
 constexpr char Settings::DefaultHost[];
 constexpr bool Settings::DefaultSslEnabled;
 constexpr bool Settings::DefaultPersistenceEnabled;
 constexpr int64_t Settings::DefaultCacheSizeBytes;
 constexpr int64_t Settings::MinimumCacheSizeBytes;
 constexpr bool Settings::DefaultTimestampsInSnapshotsEnabled;
+constexpr int Settings::DefaultChannelCount;
+constexpr core::MessageCompression Settings::DefaultCompression;
+constexpr size_t Settings::DefaultCompressionThresholdBytes;
+constexpr bool Settings::DefaultPendingWriteCompactionEnabled;
 
 size_t Settings::Hash() const {
   return util::Hash(host_, ssl_enabled_, persistence_enabled_,
-                    timestamps_in_snapshots_enabled_, cache_size_bytes_);
+                    timestamps_in_snapshots_enabled_, cache_size_bytes_,
+                    memory_cache_size_bytes_, channel_count_,
+                    static_cast<int>(compression_),
+                    compression_threshold_bytes_,
+                    pending_write_compaction_enabled_,
+                    persistence_settings_.Hash());
 }
 
 bool operator==(const Settings& lhs, const Settings& rhs) {
@@ -39,7 +98,14 @@ bool operator==(const Settings& lhs, const Settings& rhs) {
          lhs.persistence_enabled_ == rhs.persistence_enabled_ &&
          lhs.timestamps_in_snapshots_enabled_ ==
              rhs.timestamps_in_snapshots_enabled_ &&
-         lhs.cache_size_bytes_ == rhs.cache_size_bytes_;
+         lhs.cache_size_bytes_ == rhs.cache_size_bytes_ &&
+         lhs.memory_cache_size_bytes_ == rhs.memory_cache_size_bytes_ &&
+         lhs.channel_count_ == rhs.channel_count_ &&
+         lhs.compression_ == rhs.compression_ &&
+         lhs.compression_threshold_bytes_ == rhs.compression_threshold_bytes_ &&
+         lhs.pending_write_compaction_enabled_ ==
+             rhs.pending_write_compaction_enabled_ &&
+         lhs.persistence_settings_ == rhs.persistence_settings_;
 }
 
 }  // namespace api
@@ -18,12 +18,150 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_SETTINGS_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_SETTINGS_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
+#include "Firestore/core/src/firebase/firestore/core/database_info.h"
+
 namespace firebase {
 namespace firestore {
 namespace api {
 
+/**
+ * Tuning parameters for the LevelDB instance that backs local persistence.
+ *
+ * The defaults match LevelDB's own defaults, except that checksums are
+ * verified on every read and bloom filters are enabled. Many point lookups
+ * miss (limbo checks, for example), and the filters let LevelDB answer those
+ * without reading a block from each level.
+ */
+struct PersistenceSettings {
+  static constexpr int64_t DefaultBlockCacheSizeBytes = 8 * 1024 * 1024;
+  static constexpr int64_t DefaultWriteBufferSizeBytes = 4 * 1024 * 1024;
+  static constexpr bool DefaultCompressionEnabled = true;
+  static constexpr int DefaultBloomFilterBitsPerKey = 10;
+  static constexpr bool DefaultVerifyChecksums = true;
+  static constexpr bool DefaultNativeSerializationEnabled = false;
+  static constexpr int DefaultRemoteDocumentBatchSize = 0;
+  static constexpr bool DefaultBackgroundMigrationsEnabled = false;
+  static constexpr int DefaultWarmSnapshotTargetCount = 0;
+  static constexpr bool DefaultCompactTargetDocumentsEnabled = false;
+  static constexpr bool DefaultValueCompressionEnabled = false;
+  static constexpr bool DefaultSyncWrites = false;
+  static constexpr int DefaultSyncIntervalMs = 0;
+  static constexpr int DefaultGroupCommitDelayMs = 0;
+  static constexpr bool DefaultExportReadOnly = false;
+
+  /** The size of the cache of uncompressed blocks read from disk. */
+  int64_t block_cache_size_bytes = DefaultBlockCacheSizeBytes;
+
+  /**
+   * The amount of data to buffer in memory before it is written to a sorted
+   * on-disk file.
+   */
+  int64_t write_buffer_size_bytes = DefaultWriteBufferSizeBytes;
+
+  /** Whether blocks are compressed with Snappy before being written. */
+  bool compression_enabled = DefaultCompressionEnabled;
+
+  /**
+   * The number of bits per key used by the bloom filter attached to each
+   * on-disk file, or zero to disable bloom filters.
+   */
+  int bloom_filter_bits_per_key = DefaultBloomFilterBitsPerKey;
+
+  /** Whether data read from disk is verified against its checksum. */
+  bool verify_checksums = DefaultVerifyChecksums;
+
+  /**
+   * Whether cached remote documents are encoded and decoded by the C++
+   * nanopb serializer instead of the Objective-C protos. Both produce the same
+   * bytes, so this can be toggled on an existing cache.
+   */
+  bool native_serialization_enabled = DefaultNativeSerializationEnabled;
+
+  /**
+   * The maximum number of documents of a remote event committed in one
+   * transaction, or zero to commit each remote event in a single transaction.
+   */
+  int remote_document_batch_size = DefaultRemoteDocumentBatchSize;
+
+  /**
+   * Whether schema migrations that backfill data by scanning the whole cache
+   * run in the background after the database is opened, instead of delaying
+   * the first operation until they complete.
+   */
+  bool background_migrations_enabled = DefaultBackgroundMigrationsEnabled;
+
+  /**
+   * The number of most recently active targets whose last snapshot is kept
+   * so that it can be delivered again, before the query runs against the local
+   * cache, the next time the target is listened to. Zero disables warm
+   * snapshots.
+   */
+  int warm_snapshot_target_count = DefaultWarmSnapshotTargetCount;
+
+  /**
+   * Whether the documents matching each target are stored in blocks of
+   * prefix-compressed keys rather than one row per document. Both forms are
+   * read, so this can be toggled on an existing cache.
+   */
+  bool compact_target_documents_enabled = DefaultCompactTargetDocumentsEnabled;
+
+  /**
+   * Whether cached remote documents are compressed with a dictionary shared by
+   * the documents of their collection. Compressed and uncompressed documents
+   * are both read, so this can be toggled on an existing cache.
+   */
+  bool value_compression_enabled = DefaultValueCompressionEnabled;
+
+  /**
+   * Whether every commit waits for its writes to reach the disk. Otherwise a
+   * commit only hands its writes to the OS: they survive the app crashing, but
+   * may be lost if the OS crashes or the device loses power.
+   */
+  bool sync_writes = DefaultSyncWrites;
+
+  /**
+   * When writes aren't synced, the minimum time between commits that are
+   * synced anyway, which bounds how much an OS crash can lose. Zero never syncs
+   * them.
+   */
+  int sync_interval_ms = DefaultSyncIntervalMs;
+
+  /**
+   * The longest small commits are held back so that they are written to
+   * LevelDB together, in a single batch, or zero to write every commit right
+   * away. Held back commits are lost if the app crashes, but always whole and
+   * after the ones written before them, so the cache is left as it was after
+   * some earlier commit.
+   */
+  int group_commit_delay_ms = DefaultGroupCommitDelayMs;
+
+  /**
+   * The directory where consistent snapshots of the cache are periodically
+   * exported, for read-only instances in other processes (such as app
+   * extensions, which can't open the cache while the app holds its lock), or
+   * empty to not export any.
+   */
+  std::string export_directory;
+
+  /**
+   * Whether this instance reads the latest snapshot exported to
+   * `export_directory` by another process instead of having a cache of its
+   * own. The snapshot is copied when the instance starts; the instance doesn't
+   * connect to the backend nor collect garbage, and anything written to it is
+   * discarded the next time it starts.
+   */
+  bool export_read_only = DefaultExportReadOnly;
+
+  friend bool operator==(const PersistenceSettings& lhs,
+                         const PersistenceSettings& rhs);
+
+  size_t Hash() const;
+};
+
 /**
  * Represents settings associated with a FirestoreClient.
  *
@@ -39,6 +177,11 @@ class Settings {
   static constexpr int64_t MinimumCacheSizeBytes = 1 * 1024 * 1024;
   static constexpr int64_t CacheSizeUnlimited = -1;
   static constexpr bool DefaultTimestampsInSnapshotsEnabled = true;
+  static constexpr int DefaultChannelCount = 3;
+  static constexpr core::MessageCompression DefaultCompression =
+      core::MessageCompression::None;
+  static constexpr size_t DefaultCompressionThresholdBytes = 1024;
+  static constexpr bool DefaultPendingWriteCompactionEnabled = false;
 
   Settings() = default;
 
@@ -80,6 +223,73 @@ class Settings {
     return cache_size_bytes_ != CacheSizeUnlimited;
   }
 
+  /**
+   * The cache size threshold used when persistence is disabled. If set, the
+   * in-memory cache keeps documents that are no longer listened to and evicts
+   * the least recently used ones once it grows beyond the threshold. If
+   * unlimited (the default), documents are dropped as soon as nothing refers
+   * to them anymore.
+   */
+  void set_memory_cache_size_bytes(int64_t value) {
+    memory_cache_size_bytes_ = value;
+  }
+  int64_t memory_cache_size_bytes() const {
+    return memory_cache_size_bytes_;
+  }
+  bool memory_lru_gc_enabled() const {
+    return memory_cache_size_bytes_ != CacheSizeUnlimited;
+  }
+
+  /**
+   * The number of separate HTTP/2 connections to the backend. The watch
+   * stream, the write stream and unary calls (like transactional reads) are
+   * spread across them, so that a large watch response doesn't delay the
+   * others.
+   */
+  void set_channel_count(int value) {
+    channel_count_ = value;
+  }
+  int channel_count() const {
+    return channel_count_;
+  }
+
+  /**
+   * The compression applied to messages sent on the watch and write streams.
+   * Off by default; when enabled, the backend may compress responses as well.
+   */
+  void set_compression(core::MessageCompression value) {
+    compression_ = value;
+  }
+  core::MessageCompression compression() const {
+    return compression_;
+  }
+
+  /** Messages smaller than this are sent uncompressed. */
+  void set_compression_threshold_bytes(size_t value) {
+    compression_threshold_bytes_ = value;
+  }
+  size_t compression_threshold_bytes() const {
+    return compression_threshold_bytes_;
+  }
+
+  /**
+   * Whether pending writes that haven't been sent yet are removed from the
+   * mutation queue when a later write overwrites all the documents they write.
+   */
+  void set_pending_write_compaction_enabled(bool value) {
+    pending_write_compaction_enabled_ = value;
+  }
+  bool pending_write_compaction_enabled() const {
+    return pending_write_compaction_enabled_;
+  }
+
+  void set_persistence_settings(const PersistenceSettings& value) {
+    persistence_settings_ = value;
+  }
+  const PersistenceSettings& persistence_settings() const {
+    return persistence_settings_;
+  }
+
   friend bool operator==(const Settings& lhs, const Settings& rhs);
 
   size_t Hash() const;
@@ -90,6 +300,12 @@ class Settings {
   bool persistence_enabled_ = DefaultPersistenceEnabled;
   bool timestamps_in_snapshots_enabled_ = DefaultTimestampsInSnapshotsEnabled;
   int64_t cache_size_bytes_ = DefaultCacheSizeBytes;
+  int64_t memory_cache_size_bytes_ = CacheSizeUnlimited;
+  int channel_count_ = DefaultChannelCount;
+  core::MessageCompression compression_ = DefaultCompression;
+  size_t compression_threshold_bytes_ = DefaultCompressionThresholdBytes;
+  bool pending_write_compaction_enabled_ = DefaultPendingWriteCompactionEnabled;
+  PersistenceSettings persistence_settings_;
 };
 
 }  // namespace api
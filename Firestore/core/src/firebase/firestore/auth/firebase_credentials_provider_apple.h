@@ -105,8 +105,37 @@ class FirebaseCredentialsProvider : public CredentialsProvider {
     std::mutex mutex;
 
     bool force_refresh = false;
+
+    /**
+     * The last token received from Auth, reused by GetToken() without asking
+     * Auth again while it's far enough from its expiration. Only valid while
+     * `cached_token_counter` matches `token_counter`.
+     */
+    NSString* cached_token = nil;
+
+    /** The expiration time of `cached_token`, in seconds since the epoch. */
+    NSTimeInterval cached_token_expiration = 0;
+
+    int cached_token_counter = -1;
+
+    /** Whether a refresh of `cached_token` ahead of its expiry is running. */
+    bool refresh_in_flight = false;
   };
 
+  /**
+   * Remembers `token` as the current token unless the user changed since the
+   * request for it was made. Must be called with `contents->mutex` held.
+   */
+  static void CacheToken(Contents* contents,
+                         NSString* token,
+                         int request_token_counter);
+
+  /**
+   * Asks Auth for a new token (which Auth refreshes when the current one is
+   * close to expiring) without making anyone wait for it.
+   */
+  void RefreshTokenInBackground();
+
   /**
    * Handle used to stop receiving auth changes once userChangeListener is
    * removed.
@@ -29,6 +29,60 @@
 namespace firebase {
 namespace firestore {
 namespace auth {
+namespace {
+
+/**
+ * A cached token is handed out without asking Auth as long as it's valid for
+ * at least this long, which leaves room for clock skew and the RPC itself.
+ */
+const NSTimeInterval kMinTokenLifetime = 60;
+
+/**
+ * Once a cached token gets this close to its expiration, it's refreshed in
+ * the background. This matches the window in which Auth itself refreshes.
+ */
+const NSTimeInterval kRefreshAheadOfExpiry = 5 * 60;
+
+/**
+ * Returns the expiration time in the `exp` claim of the given JWT, in seconds
+ * since the epoch, or 0 if the token can't be parsed.
+ */
+NSTimeInterval ExpirationOf(NSString* token) {
+  NSArray<NSString*>* parts = [token componentsSeparatedByString:@"."];
+  if (parts.count != 3) {
+    return 0;
+  }
+
+  // The payload is base64url encoded without padding.
+  NSMutableString* payload = [parts[1] mutableCopy];
+  [payload replaceOccurrencesOfString:@"-"
+                           withString:@"+"
+                              options:0
+                                range:NSMakeRange(0, payload.length)];
+  [payload replaceOccurrencesOfString:@"_"
+                           withString:@"/"
+                              options:0
+                                range:NSMakeRange(0, payload.length)];
+  while (payload.length % 4 != 0) {
+    [payload appendString:@"="];
+  }
+
+  NSData* data = [[NSData alloc] initWithBase64EncodedString:payload options:0];
+  if (!data) {
+    return 0;
+  }
+  id claims = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+  if (![claims isKindOfClass:[NSDictionary class]]) {
+    return 0;
+  }
+  id expiration = claims[@"exp"];
+  if (![expiration isKindOfClass:[NSNumber class]]) {
+    return 0;
+  }
+  return [expiration doubleValue];
+}
+
+}  // namespace
 
 FirebaseCredentialsProvider::FirebaseCredentialsProvider(
     FIRApp* app, id<FIRAuthInterop> auth) {
@@ -60,6 +114,7 @@ FirebaseCredentialsProvider::FirebaseCredentialsProvider(
                     user_info[FIRAuthStateDidChangeInternalNotificationUIDKey];
                 contents->current_user = User::FromUid(user_id);
                 contents->token_counter++;
+                contents->cached_token = nil;
                 CredentialChangeListener listener = change_listener_;
                 if (listener) {
                   listener(contents->current_user);
@@ -80,9 +135,36 @@ void FirebaseCredentialsProvider::GetToken(TokenListener completion) {
   HARD_ASSERT(auth_listener_handle_,
               "GetToken cannot be called after listener removed.");
 
+  std::unique_lock<std::mutex> cache_lock(contents_->mutex);
+  if (!contents_->force_refresh && contents_->cached_token &&
+      contents_->cached_token_counter == contents_->token_counter) {
+    NSTimeInterval lifetime = contents_->cached_token_expiration -
+                              [[NSDate date] timeIntervalSince1970];
+    if (lifetime > kMinTokenLifetime) {
+      // Fast path: complete right away instead of bouncing through Auth.
+      Token token{util::MakeString(contents_->cached_token),
+                  contents_->current_user};
+      bool refresh =
+          lifetime < kRefreshAheadOfExpiry && !contents_->refresh_in_flight;
+      if (refresh) {
+        contents_->refresh_in_flight = true;
+      }
+      cache_lock.unlock();
+
+      completion(std::move(token));
+      if (refresh) {
+        RefreshTokenInBackground();
+      }
+      return;
+    }
+  }
+
   // Take note of the current value of the tokenCounter so that this method can
   // fail if there is a token change while the request is outstanding.
   int initial_token_counter = contents_->token_counter;
+  bool force_refresh = contents_->force_refresh;
+  contents_->force_refresh = false;
+  cache_lock.unlock();
 
   std::weak_ptr<Contents> weak_contents = contents_;
   void (^get_token_callback)(NSString*, NSError*) = ^(
@@ -102,6 +184,7 @@ void FirebaseCredentialsProvider::GetToken(TokenListener completion) {
     } else {
       if (error == nil) {
         if (token != nil) {
+          CacheToken(contents.get(), token, initial_token_counter);
           completion(Token{util::MakeString(token), contents->current_user});
         } else {
           completion(Token::Unauthenticated());
@@ -119,18 +202,57 @@ void FirebaseCredentialsProvider::GetToken(TokenListener completion) {
 
   // TODO(wilhuff): Need a better abstraction over a missing auth provider.
   if (contents_->auth) {
-    [contents_->auth getTokenForcingRefresh:contents_->force_refresh
+    [contents_->auth getTokenForcingRefresh:force_refresh
                                withCallback:get_token_callback];
   } else {
     // If there's no Auth provider, call back immediately with a nil
     // (unauthenticated) token.
     get_token_callback(nil, nil);
   }
-  contents_->force_refresh = false;
+}
+
+void FirebaseCredentialsProvider::CacheToken(Contents* contents,
+                                             NSString* token,
+                                             int request_token_counter) {
+  if (request_token_counter != contents->token_counter) {
+    return;
+  }
+  contents->cached_token = token;
+  contents->cached_token_expiration = token ? ExpirationOf(token) : 0;
+  contents->cached_token_counter = request_token_counter;
+}
+
+void FirebaseCredentialsProvider::RefreshTokenInBackground() {
+  int initial_token_counter;
+  {
+    std::unique_lock<std::mutex> lock(contents_->mutex);
+    initial_token_counter = contents_->token_counter;
+  }
+
+  std::weak_ptr<Contents> weak_contents = contents_;
+  [contents_->auth
+      getTokenForcingRefresh:NO
+                withCallback:^(NSString* _Nullable token,
+                               NSError* _Nullable error) {
+                  std::shared_ptr<Contents> contents = weak_contents.lock();
+                  if (!contents) {
+                    return;
+                  }
+
+                  std::unique_lock<std::mutex> lock(contents->mutex);
+                  contents->refresh_in_flight = false;
+                  // On failure keep the current token; the next GetToken()
+                  // past its lifetime goes to Auth and reports the error.
+                  if (error == nil && token != nil) {
+                    CacheToken(contents.get(), token, initial_token_counter);
+                  }
+                }];
 }
 
 void FirebaseCredentialsProvider::InvalidateToken() {
+  std::unique_lock<std::mutex> lock(contents_->mutex);
   contents_->force_refresh = true;
+  contents_->cached_token = nil;
 }
 
 void FirebaseCredentialsProvider::SetCredentialChangeListener(
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_AGGREGATE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_AGGREGATE_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/** A value computed over all the documents matching a query. */
+class AggregateField {
+ public:
+  enum class Kind {
+    /** The number of matching documents. */
+    kCount,
+    /** The sum of the numeric values of a field. */
+    kSum,
+    /** The mean of the numeric values of a field. */
+    kAverage,
+  };
+
+  static AggregateField Count() {
+    return AggregateField{Kind::kCount, model::FieldPath::EmptyPath()};
+  }
+  static AggregateField Sum(model::FieldPath field) {
+    return AggregateField{Kind::kSum, std::move(field)};
+  }
+  static AggregateField Average(model::FieldPath field) {
+    return AggregateField{Kind::kAverage, std::move(field)};
+  }
+
+  Kind kind() const {
+    return kind_;
+  }
+
+  /** The field aggregated over; empty for a count. */
+  const model::FieldPath& field() const {
+    return field_;
+  }
+
+  std::string ToString() const;
+  size_t Hash() const;
+
+  friend bool operator==(const AggregateField& lhs, const AggregateField& rhs);
+
+ private:
+  AggregateField(Kind kind, model::FieldPath field)
+      : kind_{kind}, field_{std::move(field)} {
+  }
+
+  Kind kind_;
+  model::FieldPath field_;
+};
+
+inline bool operator!=(const AggregateField& lhs, const AggregateField& rhs) {
+  return !(lhs == rhs);
+}
+
+/** The values of a list of aggregate fields at one point in time. */
+class AggregateSnapshot {
+ public:
+  AggregateSnapshot() = default;
+
+  AggregateSnapshot(std::vector<model::FieldValue> values,
+                    int64_t count,
+                    bool from_cache,
+                    bool has_pending_writes)
+      : values_{std::move(values)},
+        count_{count},
+        from_cache_{from_cache},
+        has_pending_writes_{has_pending_writes} {
+  }
+
+  /**
+   * The value of each requested aggregate field, in order. Counts and sums of
+   * integers are integers, other sums and averages are doubles. An average
+   * over no numeric values is null.
+   */
+  const std::vector<model::FieldValue>& values() const {
+    return values_;
+  }
+
+  /** The number of matching documents, whether requested or not. */
+  int64_t count() const {
+    return count_;
+  }
+
+  bool from_cache() const {
+    return from_cache_;
+  }
+  bool has_pending_writes() const {
+    return has_pending_writes_;
+  }
+
+ private:
+  std::vector<model::FieldValue> values_;
+  int64_t count_ = 0;
+  bool from_cache_ = false;
+  bool has_pending_writes_ = false;
+};
+
+/**
+ * Maintains aggregate values over the documents of a view.
+ *
+ * Rather than recomputing the aggregates over all the documents of each
+ * snapshot, the accumulator remembers what each document contributed and
+ * only applies the `document_changes()` of a snapshot, so updating it is
+ * proportional to the number of documents that changed.
+ *
+ * Integers are summed separately from doubles, so a sum of integers stays
+ * exact (up to 2^53) no matter how often documents are added and removed.
+ */
+class AggregateAccumulator {
+ public:
+  explicit AggregateAccumulator(std::vector<AggregateField> fields);
+
+  /** Applies the changes of the next snapshot of the view. */
+  void Apply(const ViewSnapshot& snapshot);
+
+  /** Returns the current values of the aggregate fields. */
+  AggregateSnapshot ToSnapshot(bool from_cache, bool has_pending_writes) const;
+
+  int64_t count() const {
+    return static_cast<int64_t>(contributions_.size());
+  }
+
+ private:
+  /** What a single document adds to the total of a single field. */
+  struct Contribution {
+    enum class Type { kNone, kInteger, kDouble };
+
+    Type type = Type::kNone;
+    double value = 0;
+  };
+
+  /** The running total of a single field. */
+  struct Total {
+    double integer_sum = 0;
+    double double_sum = 0;
+    int64_t integer_count = 0;
+    int64_t double_count = 0;
+  };
+
+  void Add(FSTDocument* document);
+  void Remove(const model::DocumentKey& key);
+  static void AddToTotal(Total* total,
+                         const Contribution& contribution,
+                         int sign);
+
+  model::FieldValue ValueOf(const AggregateField& field,
+                            const Total& total) const;
+
+  std::vector<AggregateField> fields_;
+  std::vector<Total> totals_;
+
+  // The contribution of each document to each field in `fields_`, in order.
+  std::unordered_map<model::DocumentKey,
+                     std::vector<Contribution>,
+                     model::DocumentKeyHash>
+      contributions_;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_AGGREGATE_H_
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/aggregate.h"
+
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/hashing.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::DocumentKey;
+using model::FieldValue;
+
+std::string AggregateField::ToString() const {
+  switch (kind_) {
+    case Kind::kCount:
+      return "count()";
+    case Kind::kSum:
+      return "sum(" + field_.CanonicalString() + ")";
+    case Kind::kAverage:
+      return "avg(" + field_.CanonicalString() + ")";
+  }
+  UNREACHABLE();
+}
+
+size_t AggregateField::Hash() const {
+  return util::Hash(static_cast<int>(kind_), field_.CanonicalString());
+}
+
+bool operator==(const AggregateField& lhs, const AggregateField& rhs) {
+  return lhs.kind_ == rhs.kind_ && lhs.field_ == rhs.field_;
+}
+
+AggregateAccumulator::AggregateAccumulator(std::vector<AggregateField> fields)
+    : fields_{std::move(fields)}, totals_(fields_.size()) {
+}
+
+void AggregateAccumulator::Apply(const ViewSnapshot& snapshot) {
+  for (const DocumentViewChange& change : snapshot.document_changes()) {
+    switch (change.type()) {
+      case DocumentViewChange::Type::kRemoved:
+        Remove(change.document().key);
+        break;
+      case DocumentViewChange::Type::kAdded:
+      case DocumentViewChange::Type::kModified:
+        Add(change.document());
+        break;
+      case DocumentViewChange::Type::kMetadata:
+        // The contents of the document did not change.
+        break;
+    }
+  }
+}
+
+void AggregateAccumulator::Add(FSTDocument* document) {
+  // A modified document replaces what it contributed before.
+  Remove(document.key);
+
+  std::vector<Contribution> contributions(fields_.size());
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    const AggregateField& field = fields_[i];
+    if (field.kind() == AggregateField::Kind::kCount) continue;
+
+    FSTFieldValue* value = [document fieldForPath:field.field()];
+    Contribution& contribution = contributions[i];
+    if (value.type == FieldValue::Type::Integer) {
+      contribution.type = Contribution::Type::kInteger;
+      contribution.value = static_cast<double>(
+          static_cast<FSTIntegerValue*>(value).internalValue);
+    } else if (value.type == FieldValue::Type::Double) {
+      contribution.type = Contribution::Type::kDouble;
+      contribution.value = static_cast<FSTDoubleValue*>(value).internalValue;
+    }
+    AddToTotal(&totals_[i], contribution, 1);
+  }
+  contributions_.emplace(document.key, std::move(contributions));
+}
+
+void AggregateAccumulator::Remove(const DocumentKey& key) {
+  auto found = contributions_.find(key);
+  if (found == contributions_.end()) return;
+
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    AddToTotal(&totals_[i], found->second[i], -1);
+  }
+  contributions_.erase(found);
+}
+
+void AggregateAccumulator::AddToTotal(Total* total,
+                                      const Contribution& contribution,
+                                      int sign) {
+  switch (contribution.type) {
+    case Contribution::Type::kNone:
+      break;
+    case Contribution::Type::kInteger:
+      total->integer_sum += sign * contribution.value;
+      total->integer_count += sign;
+      break;
+    case Contribution::Type::kDouble:
+      total->double_count += sign;
+      // Start over once the last double is gone rather than keep the rounding
+      // errors of all the additions and subtractions that led up to it.
+      if (total->double_count == 0) {
+        total->double_sum = 0;
+      } else {
+        total->double_sum += sign * contribution.value;
+      }
+      break;
+  }
+}
+
+AggregateSnapshot AggregateAccumulator::ToSnapshot(
+    bool from_cache, bool has_pending_writes) const {
+  std::vector<FieldValue> values;
+  values.reserve(fields_.size());
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    values.push_back(ValueOf(fields_[i], totals_[i]));
+  }
+  return AggregateSnapshot{std::move(values), count(), from_cache,
+                           has_pending_writes};
+}
+
+FieldValue AggregateAccumulator::ValueOf(const AggregateField& field,
+                                         const Total& total) const {
+  switch (field.kind()) {
+    case AggregateField::Kind::kCount:
+      return FieldValue::FromInteger(count());
+
+    case AggregateField::Kind::kSum:
+      if (total.double_count == 0) {
+        return FieldValue::FromInteger(static_cast<int64_t>(total.integer_sum));
+      }
+      return FieldValue::FromDouble(total.integer_sum + total.double_sum);
+
+    case AggregateField::Kind::kAverage: {
+      int64_t numbers = total.integer_count + total.double_count;
+      if (numbers == 0) {
+        return FieldValue::Null();
+      }
+      return FieldValue::FromDouble((total.integer_sum + total.double_sum) /
+                                    static_cast<double>(numbers));
+    }
+  }
+  UNREACHABLE();
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
@@ -18,6 +18,8 @@
 
 #include <utility>
 
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
 namespace firebase {
 namespace firestore {
 namespace core {
@@ -26,11 +28,18 @@ DatabaseInfo::DatabaseInfo(
     const firebase::firestore::model::DatabaseId& database_id,
     std::string persistence_key,
     std::string host,
-    bool ssl_enabled)
+    bool ssl_enabled,
+    int channel_count,
+    MessageCompression compression,
+    size_t compression_threshold_bytes)
     : database_id_{database_id},
       persistence_key_{std::move(persistence_key)},
       host_{std::move(host)},
-      ssl_enabled_{ssl_enabled} {
+      ssl_enabled_{ssl_enabled},
+      channel_count_{channel_count},
+      compression_{compression},
+      compression_threshold_bytes_{compression_threshold_bytes} {
+  HARD_ASSERT(channel_count_ > 0, "Invalid channel count %s", channel_count_);
 }
 
 }  // namespace core
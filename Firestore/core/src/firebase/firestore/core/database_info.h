@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_DATABASE_INFO_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_DATABASE_INFO_H_
 
+#include <cstddef>
 #include <string>
 
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
@@ -25,6 +26,16 @@ namespace firebase {
 namespace firestore {
 namespace core {
 
+/**
+ * The compression applied to messages sent on the watch and write streams.
+ * Responses may be compressed by the backend using any of these.
+ */
+enum class MessageCompression {
+  None,
+  Deflate,
+  Gzip,
+};
+
 /** DatabaseInfo contains data about the database. */
 class DatabaseInfo {
  public:
@@ -42,11 +53,20 @@ class DatabaseInfo {
    *        storage. Usually derived from -[FIRApp appName].
    * @param host The hostname of the Firestore backend.
    * @param ssl_enabled Whether to use SSL when connecting.
+   * @param channel_count The number of separate connections to open to the
+   *        backend; watch, write and unary traffic each get their own
+   *        connection, as long as there are enough.
+   * @param compression The compression to apply to outgoing stream messages.
+   * @param compression_threshold_bytes Stream messages smaller than this are
+   *        sent uncompressed, since compressing them isn't worth the CPU time.
    */
   DatabaseInfo(const firebase::firestore::model::DatabaseId& database_id,
                std::string persistence_key,
                std::string host,
-               bool ssl_enabled);
+               bool ssl_enabled,
+               int channel_count = 1,
+               MessageCompression compression = MessageCompression::None,
+               size_t compression_threshold_bytes = 0);
 
   const firebase::firestore::model::DatabaseId& database_id() const {
     return database_id_;
@@ -64,11 +84,26 @@ class DatabaseInfo {
     return ssl_enabled_;
   }
 
+  int channel_count() const {
+    return channel_count_;
+  }
+
+  MessageCompression compression() const {
+    return compression_;
+  }
+
+  size_t compression_threshold_bytes() const {
+    return compression_threshold_bytes_;
+  }
+
  private:
   firebase::firestore::model::DatabaseId database_id_;
   std::string persistence_key_;
   std::string host_;
   bool ssl_enabled_;
+  int channel_count_ = 1;
+  MessageCompression compression_ = MessageCompression::None;
+  size_t compression_threshold_bytes_ = 0;
 };
 
 }  // namespace core
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_DOCUMENT_SIZER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_DOCUMENT_SIZER_H_
+
+#if !defined(__OBJC__)
+#error "This header only supports Objective-C++"
+#endif  // !defined(__OBJC__)
+
+#include <cstddef>
+#include <functional>
+
+#include "Firestore/core/src/firebase/firestore/objc/objc_class.h"
+
+OBJC_CLASS(FSTMaybeDocument);
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/** Returns the estimated number of bytes a document takes up in memory. */
+using DocumentSizer = std::function<size_t(FSTMaybeDocument*)>;
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_DOCUMENT_SIZER_H_
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/event_batch.h"
+
+#include <memory>
+
+#include "absl/base/config.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using util::Executor;
+
+namespace {
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+EventBatch*& CurrentBatch() {
+  static thread_local EventBatch* current_batch = nullptr;
+  return current_batch;
+}
+#endif
+
+}  // namespace
+
+EventBatch::EventBatch() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  previous_ = CurrentBatch();
+  CurrentBatch() = this;
+#endif
+}
+
+EventBatch::~EventBatch() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  CurrentBatch() = previous_;
+#endif
+
+  for (Group& group : groups_) {
+    if (group.second.size() == 1) {
+      group.first->Execute(std::move(group.second.front()));
+      continue;
+    }
+
+    // Operations can't be copied, and neither can whatever holds them.
+    auto operations = std::make_shared<std::vector<Executor::Operation>>(
+        std::move(group.second));
+    group.first->Execute([operations] {
+      for (Executor::Operation& operation : *operations) {
+        operation();
+      }
+    });
+  }
+}
+
+EventBatch* EventBatch::Current() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  return CurrentBatch();
+#else
+  return nullptr;
+#endif
+}
+
+void EventBatch::Add(Executor* executor, Executor::Operation&& operation) {
+  for (Group& group : groups_) {
+    if (group.first == executor) {
+      group.second.push_back(std::move(operation));
+      return;
+    }
+  }
+  groups_.emplace_back(executor, std::vector<Executor::Operation>{});
+  groups_.back().second.push_back(std::move(operation));
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_EVENT_BATCH_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_EVENT_BATCH_H_
+
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * Groups the events raised by `AsyncEventListener`s on the current thread
+ * while the batch is alive, so that each executor gets a single operation
+ * that raises all of its events in order, rather than one operation per
+ * event. When many listeners are updated at once, on the main queue for
+ * instance, this saves a wakeup of the executor's thread for each of them.
+ *
+ * The operations are handed to their executors when the batch is destroyed.
+ * Batches may be nested; events then go to the innermost one.
+ *
+ * On platforms without `thread_local` (notably iOS 8), batches do nothing
+ * and every event gets its own operation.
+ */
+class EventBatch {
+ public:
+  EventBatch();
+  ~EventBatch();
+
+  EventBatch(const EventBatch& other) = delete;
+  EventBatch& operator=(const EventBatch& other) = delete;
+
+  /**
+   * Returns the innermost batch alive on the current thread, or null if there
+   * is none.
+   */
+  static EventBatch* Current();
+
+  /**
+   * Adds `operation` to the operations that will be run on `executor`, after
+   * those already added for it.
+   */
+  void Add(util::Executor* executor, util::Executor::Operation&& operation);
+
+ private:
+  using Group =
+      std::pair<util::Executor*, std::vector<util::Executor::Operation>>;
+
+  // Few executors are ever involved, so they're looked up linearly.
+  std::vector<Group> groups_;
+
+  EventBatch* previous_ = nullptr;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_EVENT_BATCH_H_
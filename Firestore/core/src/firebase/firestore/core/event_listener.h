@@ -21,6 +21,7 @@
 #include <memory>
 #include <utility>
 
+#include "Firestore/core/src/firebase/firestore/core/event_batch.h"
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor_callback.h"
@@ -53,6 +54,9 @@ class EventListener {
 
 /**
  * A wrapper around another EventListener that dispatches events asynchronously.
+ *
+ * Events raised while an `EventBatch` is alive on the current thread are
+ * dispatched along with the other events of the batch.
  */
 template <typename T>
 class AsyncEventListener
@@ -130,11 +134,18 @@ void AsyncEventListener<T>::OnEvent(util::StatusOr<T> maybe_value) {
   // until the executor gets around to calling.
   std::shared_ptr<AsyncEventListener<T>> shared_this = this->shared_from_this();
 
-  executor_->Execute([shared_this, maybe_value]() {
+  util::Executor::Operation operation = [shared_this, maybe_value]() {
     if (!shared_this->muted_) {
       shared_this->delegate_->OnEvent(std::move(maybe_value));
     }
-  });
+  };
+
+  EventBatch* batch = EventBatch::Current();
+  if (batch) {
+    batch->Add(executor_, std::move(operation));
+  } else {
+    executor_->Execute(std::move(operation));
+  }
 }
 
 }  // namespace core
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_FIELD_COLUMN_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_FIELD_COLUMN_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * A columnar copy of a single field across the documents of a snapshot.
+ *
+ * Row `i` describes the `i`th document in snapshot order. Numeric and string
+ * values are stored in dense, typed vectors so that aggregating a field over
+ * a large result is a loop over contiguous memory rather than a field lookup
+ * per document. Rows whose value is not of a given type hold zero (or an empty
+ * string) in that type's vector; check `types()` to tell them apart.
+ */
+class FieldColumn {
+ public:
+  /** The kind of value stored in a row. */
+  enum class Type {
+    /** The document has no value for the field. */
+    kMissing,
+    kInteger,
+    kDouble,
+    kString,
+    /** Any value that has no typed storage in the column. */
+    kOther,
+  };
+
+  FieldColumn() = default;
+
+  /** Extracts `field` from each of `documents`, in order. */
+  FieldColumn(const model::DocumentSet& documents,
+              const model::FieldPath& field);
+
+  const model::FieldPath& field() const {
+    return field_;
+  }
+
+  /** The number of rows, equal to the number of documents. */
+  size_t size() const {
+    return keys_.size();
+  }
+
+  /** The key of the document each row was taken from. */
+  const std::vector<model::DocumentKey>& keys() const {
+    return keys_;
+  }
+
+  const std::vector<Type>& types() const {
+    return types_;
+  }
+
+  /** The value of each integer row; zero for any other row. */
+  const std::vector<int64_t>& integer_values() const {
+    return integer_values_;
+  }
+
+  /** The value of each double row; zero for any other row. */
+  const std::vector<double>& double_values() const {
+    return double_values_;
+  }
+
+  /** Returns the value of the given row if it is a string, or empty if not. */
+  absl::string_view string_value(size_t row) const {
+    return absl::string_view{string_data_}.substr(
+        string_offsets_[row], string_offsets_[row + 1] - string_offsets_[row]);
+  }
+
+ private:
+  model::FieldPath field_;
+  std::vector<model::DocumentKey> keys_;
+  std::vector<Type> types_;
+  std::vector<int64_t> integer_values_;
+  std::vector<double> double_values_;
+
+  // The string value of row `i` is the range
+  // [string_offsets_[i], string_offsets_[i + 1]) of string_data_.
+  std::vector<size_t> string_offsets_{0};
+  std::string string_data_;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_FIELD_COLUMN_H_
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/field_column.h"
+
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
+
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::DocumentSet;
+using model::FieldPath;
+using model::FieldValue;
+
+FieldColumn::FieldColumn(const DocumentSet& documents, const FieldPath& field)
+    : field_{field} {
+  size_t rows = documents.size();
+  keys_.reserve(rows);
+  types_.reserve(rows);
+  integer_values_.reserve(rows);
+  double_values_.reserve(rows);
+  string_offsets_.reserve(rows + 1);
+
+  for (FSTDocument* document : documents) {
+    FSTFieldValue* value = [document fieldForPath:field];
+
+    Type type = Type::kOther;
+    int64_t integer_value = 0;
+    double double_value = 0;
+    if (value == nil) {
+      type = Type::kMissing;
+    } else if (value.type == FieldValue::Type::Integer) {
+      type = Type::kInteger;
+      integer_value = static_cast<FSTIntegerValue*>(value).internalValue;
+    } else if (value.type == FieldValue::Type::Double) {
+      type = Type::kDouble;
+      double_value = static_cast<FSTDoubleValue*>(value).internalValue;
+    } else if (value.type == FieldValue::Type::String) {
+      type = Type::kString;
+      string_data_ +=
+          static_cast<FSTDelegateValue*>(value).internalValue.string_value();
+    }
+
+    keys_.push_back(document.key);
+    types_.push_back(type);
+    integer_values_.push_back(integer_value);
+    double_values_.push_back(double_value);
+    string_offsets_.push_back(string_data_.size());
+  }
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_LISTEN_OPTIONS_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_LISTEN_OPTIONS_H_
 
+#include <chrono>  // NOLINT(build/c++11)
+
 namespace firebase {
 namespace firestore {
 namespace core {
@@ -78,10 +80,35 @@ class ListenOptions {
     return wait_for_sync_when_online_;
   }
 
+  /**
+   * Returns a copy of these options that coalesces snapshots: rather than
+   * raising an event for every snapshot, the listener holds on to the first
+   * one it would raise for at most `window` and merges any snapshots that
+   * arrive in the meantime into it, so that the event carries the net change.
+   *
+   * A zero window (the default) raises every event as soon as possible. The
+   * first event of a listener is never delayed.
+   */
+  ListenOptions WithCoalescingWindow(std::chrono::milliseconds window) const {
+    ListenOptions result = *this;
+    result.coalescing_window_ = window;
+    return result;
+  }
+
+  std::chrono::milliseconds coalescing_window() const {
+    return coalescing_window_;
+  }
+
+  /** Whether snapshots are coalesced before raising events. */
+  bool coalesces_snapshots() const {
+    return coalescing_window_.count() > 0;
+  }
+
  private:
   bool include_query_metadata_changes_ = false;
   bool include_document_metadata_changes_ = false;
   bool wait_for_sync_when_online_ = false;
+  std::chrono::milliseconds coalescing_window_{0};
 };
 
 }  // namespace core
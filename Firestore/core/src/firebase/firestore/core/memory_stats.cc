@@ -0,0 +1,40 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/memory_stats.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+size_t MemoryStats::total_bytes() const {
+  return view_bytes + local_view_overlay_bytes +
+         memory_remote_document_cache_bytes + projected_document_bytes +
+         pending_watch_change_bytes + stream_buffered_bytes +
+         leveldb_block_cache_bytes + leveldb_memtable_bytes;
+}
+
+size_t DocumentKeyByteSize(const model::DocumentKey& key) {
+  size_t count = 0;
+  for (const auto& segment : key.path()) {
+    count += segment.size();
+  }
+  return count;
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_MEMORY_STATS_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_MEMORY_STATS_H_
+
+#include <cstddef>
+#include <functional>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * The approximate number of bytes held by the caches and in-flight structures
+ * of a Firestore client. Documents are counted by the size of their key and
+ * their serialized form, so the numbers are estimates rather than the exact
+ * amount of memory allocated.
+ */
+struct MemoryStats {
+  /** The documents in the views of listened-to queries. */
+  size_t view_bytes = 0;
+
+  /** The cached local views of documents with pending mutations. */
+  size_t local_view_overlay_bytes = 0;
+
+  /** The documents cached by memory persistence. */
+  size_t memory_remote_document_cache_bytes = 0;
+
+  /** The partial documents of queries that select only some fields. */
+  size_t projected_document_bytes = 0;
+
+  /** Watch changes that haven't been raised in a remote event yet. */
+  size_t pending_watch_change_bytes = 0;
+
+  /** Messages queued in the buffered writers of the gRPC streams. */
+  size_t stream_buffered_bytes = 0;
+
+  /** The LevelDB block cache. */
+  size_t leveldb_block_cache_bytes = 0;
+
+  /** The LevelDB memtables (that is, writes not yet flushed to disk). */
+  size_t leveldb_memtable_bytes = 0;
+
+  size_t total_bytes() const;
+};
+
+using MemoryStatsCallback = std::function<void(MemoryStats)>;
+
+/**
+ * Returns an estimate of the number of bytes used to store the given document
+ * key in memory: the size of the segments of its path, but not any object
+ * overhead or path separators.
+ */
+size_t DocumentKeyByteSize(const model::DocumentKey& key);
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_MEMORY_STATS_H_
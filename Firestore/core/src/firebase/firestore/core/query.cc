@@ -17,6 +17,7 @@
 #include "Firestore/core/src/firebase/firestore/core/query.h"
 
 #include <algorithm>
+#include <utility>
 
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
@@ -29,8 +30,18 @@ namespace core {
 
 using model::Document;
 using model::DocumentKey;
+using model::FieldPath;
 using model::ResourcePath;
 
+Query::Query(ResourcePath path,
+             std::vector<std::shared_ptr<core::Filter>> filters,
+             std::vector<FieldPath> projection)
+    : path_(std::move(path)),
+      filters_(std::move(filters)),
+      projection_(std::move(projection)) {
+  NormalizeProjection();
+}
+
 bool Query::Matches(const Document& doc) const {
   return MatchesPath(doc) && MatchesOrderBy(doc) && MatchesFilters(doc) &&
          MatchesBounds(doc);
@@ -71,7 +82,33 @@ Query Query::Filter(std::shared_ptr<core::Filter> filter) const {
 
   std::vector<std::shared_ptr<core::Filter>> updated_filters = filters_;
   updated_filters.push_back(std::move(filter));
-  return Query(path_, std::move(updated_filters));
+  return Query(path_, std::move(updated_filters), projection_);
+}
+
+Query Query::Select(std::vector<FieldPath> fields) const {
+  return Query(path_, filters_, std::move(fields));
+}
+
+void Query::NormalizeProjection() {
+  if (projection_.empty()) {
+    return;
+  }
+
+  // The partial documents must still be matchable locally, so a projection
+  // always includes the fields that are filtered on. Every document has a key,
+  // so selecting it is implied.
+  for (const std::shared_ptr<core::Filter>& filter : filters_) {
+    projection_.push_back(filter->field());
+  }
+  projection_.erase(
+      std::remove_if(projection_.begin(), projection_.end(),
+                     [](const FieldPath& field) {
+                       return field.IsKeyFieldPath();
+                     }),
+      projection_.end());
+  std::sort(projection_.begin(), projection_.end());
+  projection_.erase(std::unique(projection_.begin(), projection_.end()),
+                    projection_.end());
 }
 
 }  // namespace core
@@ -23,6 +23,7 @@
 
 #include "Firestore/core/src/firebase/firestore/core/filter.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 
 namespace firebase {
@@ -56,6 +57,14 @@ class Query {
       : path_(std::move(path)), filters_(std::move(filters)) {
   }
 
+  /**
+   * Initializes a query with all of its components directly, including the
+   * fields its results are projected to.
+   */
+  Query(model::ResourcePath path,
+        std::vector<std::shared_ptr<core::Filter>> filters,
+        std::vector<model::FieldPath> projection);
+
   /** The base path of the query. */
   const model::ResourcePath& path() const {
     return path_;
@@ -66,6 +75,20 @@ class Query {
     return filters_;
   }
 
+  /**
+   * The fields the results of the query are projected to, sorted and without
+   * duplicates, or empty if the query returns whole documents. The fields of
+   * the filters of a projection query are always part of its projection.
+   */
+  const std::vector<model::FieldPath>& projection() const {
+    return projection_;
+  }
+
+  /** Returns true if the query returns partial documents. */
+  bool HasProjection() const {
+    return !projection_.empty();
+  }
+
   /** Returns true if the document matches the constraints of this query. */
   bool Matches(const model::Document& doc) const;
 
@@ -79,12 +102,20 @@ class Query {
    */
   Query Filter(std::shared_ptr<core::Filter> filter) const;
 
+  /**
+   * Returns a copy of this Query object that only returns the given fields of
+   * each document, or whole documents if `fields` is empty.
+   */
+  Query Select(std::vector<model::FieldPath> fields) const;
+
  private:
   bool MatchesPath(const model::Document& doc) const;
   bool MatchesFilters(const model::Document& doc) const;
   bool MatchesOrderBy(const model::Document& doc) const;
   bool MatchesBounds(const model::Document& doc) const;
 
+  void NormalizeProjection();
+
   model::ResourcePath path_;
 
   // Filters are shared across related Query instance. i.e. when you call
@@ -93,6 +124,8 @@ class Query {
   // immutable.) Filters are not shared across unrelated Query instances.
   std::vector<std::shared_ptr<core::Filter>> filters_;
 
+  std::vector<model::FieldPath> projection_;
+
   // TODO(rsgowman): Port collection group queries logic.
 };
 
@@ -101,7 +134,8 @@ inline bool operator==(const Query& lhs, const Query& rhs) {
   // TODO(rsgowman): check orderby (once it exists)
   // TODO(rsgowman): check startat (once it exists)
   // TODO(rsgowman): check endat (once it exists)
-  return lhs.path() == rhs.path() && lhs.filters() == rhs.filters();
+  return lhs.path() == rhs.path() && lhs.filters() == rhs.filters() &&
+         lhs.projection() == rhs.projection();
 }
 
 inline bool operator!=(const Query& lhs, const Query& rhs) {
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/query_builder.h"
+
+#include <utility>
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::FieldValue;
+
+const model::FieldPath& QueryBuilder::ParseField(
+    absl::string_view field_name) {
+  std::string key{field_name};
+  auto found = parsed_fields_.find(key);
+  if (found != parsed_fields_.end()) {
+    return found->second;
+  }
+
+  // Parse before inserting, so that a name that throws isn't kept.
+  model::FieldPath parsed =
+      model::FieldPath::FromDotSeparatedString(field_name);
+  auto inserted = parsed_fields_.emplace(std::move(key), std::move(parsed));
+  return inserted.first->second;
+}
+
+Query QueryBuilder::Where(const Query& query,
+                          absl::string_view field_name,
+                          Filter::Operator op,
+                          FieldValue value) {
+  return query.Filter(
+      Filter::Create(ParseField(field_name), op, std::move(value)));
+}
+
+Query QueryBuilder::Select(const Query& query,
+                           const std::vector<std::string>& field_names) {
+  std::vector<model::FieldPath> fields;
+  fields.reserve(field_names.size());
+  for (const std::string& field_name : field_names) {
+    fields.push_back(ParseField(field_name));
+  }
+  return query.Select(std::move(fields));
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
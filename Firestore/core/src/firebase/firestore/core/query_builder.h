@@ -0,0 +1,82 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_BUILDER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_BUILDER_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/filter.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * Builds Queries from field names in the dot-separated form the public API
+ * takes them in.
+ *
+ * Each field name is parsed and validated the first time it is used, and the
+ * parsed FieldPath is kept for the lifetime of the builder. Building the same
+ * queries over and over, e.g. every time a UI list is reconfigured, only looks
+ * the field names up instead of splitting and validating them again.
+ *
+ * Not thread-safe.
+ */
+class QueryBuilder {
+ public:
+  /**
+   * Returns the parsed form of a dot-separated field name.
+   *
+   * Throws an invalid argument error, like FieldPath::FromDotSeparatedString,
+   * if the name isn't a valid field path. Invalid names aren't kept.
+   */
+  const model::FieldPath& ParseField(absl::string_view field_name);
+
+  /**
+   * Returns a copy of `query` with an additional filter on the given field.
+   */
+  Query Where(const Query& query,
+              absl::string_view field_name,
+              Filter::Operator op,
+              model::FieldValue value);
+
+  /**
+   * Returns a copy of `query` that only returns the given fields of each
+   * document, or whole documents if `field_names` is empty.
+   */
+  Query Select(const Query& query, const std::vector<std::string>& field_names);
+
+  /** The number of distinct field names parsed so far. */
+  size_t parsed_field_count() const {
+    return parsed_fields_.size();
+  }
+
+ private:
+  std::unordered_map<std::string, model::FieldPath> parsed_fields_;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_BUILDER_H_
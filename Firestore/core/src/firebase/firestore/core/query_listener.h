@@ -78,6 +78,10 @@ class QueryListener {
 
   FSTQuery* query() const;
 
+  const ListenOptions& options() const {
+    return options_;
+  }
+
   /** The last received view snapshot. */
   const absl::optional<ViewSnapshot>& snapshot() const {
     return snapshot_;
@@ -87,6 +91,20 @@ class QueryListener {
   virtual void OnError(util::Status error);
   virtual void OnOnlineStateChanged(model::OnlineState online_state);
 
+  /**
+   * Whether this listener coalesces snapshots and holds one that it has yet
+   * to raise an event for.
+   */
+  bool has_pending_snapshot() const {
+    return pending_snapshot_.has_value();
+  }
+
+  /**
+   * Raises the event for the pending snapshot, if there is one and its net
+   * change is still worth raising.
+   */
+  void FlushPendingSnapshot();
+
  private:
   bool ShouldRaiseInitialEvent(const ViewSnapshot& snapshot,
                                model::OnlineState online_state) const;
@@ -113,6 +131,15 @@ class QueryListener {
   model::OnlineState online_state_ = model::OnlineState::Unknown;
 
   absl::optional<ViewSnapshot> snapshot_;
+
+  /**
+   * When coalescing, the snapshots received since the last raised event,
+   * merged into one.
+   */
+  absl::optional<ViewSnapshot> pending_snapshot_;
+
+  /** Whether the last snapshot before `pending_snapshot_` had local writes. */
+  bool had_pending_writes_before_pending_snapshot_ = false;
 };
 
 }  // namespace core
@@ -17,7 +17,6 @@
 #import "Firestore/core/src/firebase/firestore/core/query_listener.h"
 
 #include <utility>
-#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
@@ -54,36 +53,54 @@ void QueryListener::OnViewSnapshot(ViewSnapshot snapshot) {
       "We got a new snapshot with no changes?");
 
   if (!options_.include_document_metadata_changes()) {
-    // Remove the metadata-only changes.
-    std::vector<DocumentViewChange> changes;
-    for (const DocumentViewChange& change : snapshot.document_changes()) {
-      if (change.type() != DocumentViewChange::Type::kMetadata) {
-        changes.push_back(change);
-      }
-    }
-
-    snapshot = ViewSnapshot{snapshot.query(),
-                            snapshot.documents(),
-                            snapshot.old_documents(),
-                            std::move(changes),
-                            snapshot.mutated_keys(),
-                            snapshot.from_cache(),
-                            snapshot.sync_state_changed(),
-                            /*excludes_metadata_changes=*/true};
+    // Remove the metadata-only changes. Snapshots that only change metadata
+    // come out with no changes at all, without allocating.
+    snapshot = snapshot.ExcludingMetadataChanges();
   }
 
   if (!raised_initial_event_) {
     if (ShouldRaiseInitialEvent(snapshot, online_state_)) {
       RaiseInitialEvent(snapshot);
     }
+  } else if (pending_snapshot_.has_value()) {
+    // Even a snapshot that would not raise an event on its own has to be
+    // merged, so that the pending one ends up with the latest documents.
+    pending_snapshot_ = ViewSnapshot::Coalesce(*pending_snapshot_, snapshot);
   } else if (ShouldRaiseEvent(snapshot)) {
-    listener_->OnEvent(snapshot);
+    if (options_.coalesces_snapshots()) {
+      had_pending_writes_before_pending_snapshot_ =
+          snapshot_.has_value() && snapshot_->has_pending_writes();
+      pending_snapshot_ = snapshot;
+    } else {
+      listener_->OnEvent(snapshot);
+    }
   }
 
   snapshot_ = std::move(snapshot);
 }
 
+void QueryListener::FlushPendingSnapshot() {
+  if (!pending_snapshot_.has_value()) {
+    return;
+  }
+
+  ViewSnapshot snapshot = std::move(*pending_snapshot_);
+  pending_snapshot_.reset();
+
+  // The merged changes may cancel out (e.g. a document that was added and
+  // then removed again), leaving only metadata to report.
+  bool has_pending_writes_changed =
+      had_pending_writes_before_pending_snapshot_ !=
+      snapshot.has_pending_writes();
+  if (!snapshot.document_changes().empty() ||
+      ((snapshot.sync_state_changed() || has_pending_writes_changed) &&
+       options_.include_query_metadata_changes())) {
+    listener_->OnEvent(std::move(snapshot));
+  }
+}
+
 void QueryListener::OnError(Status error) {
+  FlushPendingSnapshot();
   listener_->OnEvent(std::move(error));
 }
 
@@ -19,6 +19,7 @@
 
 #include <functional>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <unordered_map>
 #include <vector>
 
@@ -26,6 +27,7 @@
 #include "Firestore/core/src/firebase/firestore/model/precondition.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/objc/objc_class.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor_callback.h"
@@ -50,7 +52,11 @@ namespace core {
 class ParsedSetData;
 class ParsedUpdateData;
 
-class Transaction {
+/**
+ * Must be owned by a `shared_ptr`: lookups keep the transaction alive while
+ * they are in flight.
+ */
+class Transaction : public std::enable_shared_from_this<Transaction> {
  public:
   // TODO(varconst): once `FSTMaybeDocument` is replaced with a C++ equivalent,
   // this function could take a single `StatusOr` parameter.
@@ -58,15 +64,31 @@ class Transaction {
       const std::vector<FSTMaybeDocument*>&, const util::Status&)>;
 
   Transaction() = default;
-  explicit Transaction(remote::Datastore* transaction);
+  Transaction(remote::Datastore* datastore, util::AsyncQueue* worker_queue);
 
   /**
    * Takes a set of keys and asynchronously attempts to fetch all the documents
    * from the backend, ignoring any local changes.
+   *
+   * Lookups issued before the worker queue gets to the first of them are
+   * merged into a single request to the backend.
    */
   void Lookup(const std::vector<model::DocumentKey>& keys,
               LookupCallback&& callback);
 
+  /**
+   * Starts fetching the given documents right away, so that later lookups of
+   * any of them don't have to wait for a round trip to the backend. Documents
+   * only count as read in this transaction once they have been looked up.
+   *
+   * This is meant for retries, which usually read what the failed attempt
+   * read (see `read_keys`).
+   */
+  void Prefetch(const std::vector<model::DocumentKey>& keys);
+
+  /** Returns the keys of all documents read in this transaction so far. */
+  std::vector<model::DocumentKey> read_keys() const;
+
   /**
    * Stores mutation for the given key and set data, to be committed when
    * `Commit` is called.
@@ -119,10 +141,41 @@ class Transaction {
 
   void EnsureCommitNotCalled();
 
+  struct PendingLookup {
+    std::vector<model::DocumentKey> keys;
+    LookupCallback callback;
+  };
+
+  /** Schedules a flush of the pending lookups, unless one is on the way. */
+  void ScheduleLookupsLocked();
+
+  /**
+   * Sends the pending lookups as one request for the documents that haven't
+   * been prefetched, then passes each lookup its documents.
+   */
+  void FlushLookups();
+
+  using FetchedDocuments = util::StatusOr<std::vector<FSTMaybeDocument*>>;
+
+  void FinishLookups(std::vector<PendingLookup>&& lookups,
+                     const FetchedDocuments& fetched);
+
   absl::optional<model::SnapshotVersion> GetVersion(
       const model::DocumentKey& key) const;
 
   remote::Datastore* datastore_ = nullptr;
+  util::AsyncQueue* worker_queue_ = nullptr;
+
+  // Guards the lookup state below, which is modified both by the user's
+  // update callback and on the worker queue.
+  std::mutex lookup_mutex_;
+  std::vector<PendingLookup> pending_lookups_;
+  bool lookups_scheduled_ = false;
+  bool prefetching_ = false;
+  std::unordered_map<model::DocumentKey,
+                     FSTMaybeDocument*,
+                     model::DocumentKeyHash>
+      prefetched_documents_;
 
   std::vector<FSTMutation*> mutations_;
   bool committed_ = false;
@@ -17,8 +17,12 @@
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 
 #include <algorithm>
+#include <functional>
+#include <memory>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTMutation.h"
@@ -27,6 +31,7 @@
 #include "Firestore/core/src/firebase/firestore/core/user_data.h"
 #include "Firestore/core/src/firebase/firestore/remote/datastore.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/task.h"
 
 using firebase::firestore::FirestoreErrorCode;
 using firebase::firestore::core::ParsedSetData;
@@ -36,6 +41,8 @@ using firebase::firestore::model::DocumentKeyHash;
 using firebase::firestore::model::Precondition;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::remote::Datastore;
+using firebase::firestore::util::AsyncQueue;
+using firebase::firestore::util::Promise;
 using firebase::firestore::util::Status;
 using firebase::firestore::util::StatusOr;
 
@@ -43,8 +50,8 @@ namespace firebase {
 namespace firestore {
 namespace core {
 
-Transaction::Transaction(Datastore* datastore)
-    : datastore_{NOT_NULL(datastore)} {
+Transaction::Transaction(Datastore* datastore, AsyncQueue* worker_queue)
+    : datastore_{NOT_NULL(datastore)}, worker_queue_{NOT_NULL(worker_queue)} {
 }
 
 Status Transaction::RecordVersion(FSTMaybeDocument* doc) {
@@ -82,26 +89,162 @@ void Transaction::Lookup(const std::vector<DocumentKey>& keys,
   HARD_ASSERT(mutations_.empty(),
               "Transactions lookups are invalid after writes.");
 
+  std::lock_guard<std::mutex> lock{lookup_mutex_};
+  pending_lookups_.push_back(PendingLookup{keys, std::move(callback)});
+  ScheduleLookupsLocked();
+}
+
+void Transaction::Prefetch(const std::vector<DocumentKey>& keys) {
+  if (keys.empty()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{lookup_mutex_};
+    HARD_ASSERT(!prefetching_ && prefetched_documents_.empty(),
+                "A transaction can only prefetch once");
+    prefetching_ = true;
+  }
+
+  // The transaction may be done before the prefetch is, in which case there
+  // is no one left to use the prefetched documents.
+  std::weak_ptr<Transaction> weak_this = shared_from_this();
   datastore_->LookupDocuments(
-      keys, [this, callback](const std::vector<FSTMaybeDocument*>& documents,
-                             const Status& status) {
-        if (!status.ok()) {
-          callback({}, status);
+      keys, [weak_this](const std::vector<FSTMaybeDocument*>& documents,
+                        const Status& status) {
+        std::shared_ptr<Transaction> strong_this = weak_this.lock();
+        if (!strong_this) {
           return;
         }
 
-        for (FSTMaybeDocument* doc : documents) {
-          Status record_error = RecordVersion(doc);
-          if (!record_error.ok()) {
-            callback({}, record_error);
-            return;
+        std::lock_guard<std::mutex> lock{strong_this->lookup_mutex_};
+        strong_this->prefetching_ = false;
+        // If prefetching failed, lookups simply fetch what they need.
+        if (status.ok()) {
+          for (FSTMaybeDocument* doc : documents) {
+            strong_this->prefetched_documents_[doc.key] = doc;
           }
         }
+        strong_this->ScheduleLookupsLocked();
+      });
+}
+
+std::vector<DocumentKey> Transaction::read_keys() const {
+  std::vector<DocumentKey> keys;
+  keys.reserve(read_versions_.size());
+  for (const auto& kv : read_versions_) {
+    keys.push_back(kv.first);
+  }
+  return keys;
+}
+
+void Transaction::ScheduleLookupsLocked() {
+  // While prefetching, wait for the prefetched documents rather than fetch
+  // them a second time.
+  if (lookups_scheduled_ || prefetching_ || pending_lookups_.empty()) {
+    return;
+  }
 
-        callback(documents, Status::OK());
+  lookups_scheduled_ = true;
+  // Lookups may be issued from the user's update callback as well as from the
+  // callbacks of earlier lookups, which run on the worker queue.
+  auto self = shared_from_this();
+  worker_queue_->EnqueueRelaxed([self] { self->FlushLookups(); });
+}
+
+void Transaction::FlushLookups() {
+  std::vector<PendingLookup> lookups;
+  std::vector<DocumentKey> missing_keys;
+  {
+    std::lock_guard<std::mutex> lock{lookup_mutex_};
+    lookups_scheduled_ = false;
+    lookups.swap(pending_lookups_);
+
+    std::unordered_set<DocumentKey, DocumentKeyHash> requested;
+    for (const PendingLookup& lookup : lookups) {
+      for (const DocumentKey& key : lookup.keys) {
+        if (prefetched_documents_.find(key) == prefetched_documents_.end() &&
+            requested.insert(key).second) {
+          missing_keys.push_back(key);
+        }
+      }
+    }
+  }
+
+  if (missing_keys.empty()) {
+    FinishLookups(std::move(lookups), std::vector<FSTMaybeDocument*>{});
+    return;
+  }
+
+  // The datastore copies its callback, so it only gets the promise; the
+  // lookups wait on the task.
+  Promise<FetchedDocuments> fetched;
+  auto self = shared_from_this();
+  // TODO(c++14): move `lookups` into lambda instead of binding it.
+  fetched.GetTask().Then(std::bind(
+      [self](std::vector<PendingLookup>& bound_lookups,
+             const FetchedDocuments& documents) {
+        self->FinishLookups(std::move(bound_lookups), documents);
+      },
+      std::move(lookups), std::placeholders::_1));
+
+  datastore_->LookupDocuments(
+      missing_keys, [fetched](const std::vector<FSTMaybeDocument*>& documents,
+                              const Status& status) {
+        if (status.ok()) {
+          fetched.SetValue(documents);
+        } else {
+          fetched.SetValue(status);
+        }
       });
 }
 
+void Transaction::FinishLookups(std::vector<PendingLookup>&& lookups,
+                                const FetchedDocuments& fetched) {
+  if (!fetched.ok()) {
+    for (const PendingLookup& lookup : lookups) {
+      lookup.callback({}, fetched.status());
+    }
+    return;
+  }
+
+  std::unordered_map<DocumentKey, FSTMaybeDocument*, DocumentKeyHash>
+      documents;
+  {
+    std::lock_guard<std::mutex> lock{lookup_mutex_};
+    documents = prefetched_documents_;
+  }
+  for (FSTMaybeDocument* doc : fetched.ValueOrDie()) {
+    documents[doc.key] = doc;
+  }
+
+  for (const PendingLookup& lookup : lookups) {
+    std::vector<FSTMaybeDocument*> result;
+    Status lookup_status;
+    for (const DocumentKey& key : lookup.keys) {
+      auto found = documents.find(key);
+      if (found == documents.end()) {
+        lookup_status = Status{FirestoreErrorCode::Internal,
+                               "The backend did not return a looked up "
+                               "document."};
+        break;
+      }
+
+      lookup_status = RecordVersion(found->second);
+      if (!lookup_status.ok()) {
+        break;
+      }
+      result.push_back(found->second);
+    }
+
+    if (lookup_status.ok()) {
+      lookup.callback(result, Status::OK());
+    } else {
+      lookup.callback({}, lookup_status);
+    }
+  }
+}
+
 void Transaction::WriteMutations(std::vector<FSTMutation*>&& mutations) {
   EnsureCommitNotCalled();
   // `move` will become appropriate once `FSTMutation` is replaced by the C++
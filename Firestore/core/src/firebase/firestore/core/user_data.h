@@ -100,12 +100,13 @@ class ParseAccumulator {
 
   /**
    * Returns `true` if the given `field_path` was encountered in the current
-   * document.
+   * document. Only meaningful for merges and updates.
    */
   bool Contains(const model::FieldPath& field_path) const;
 
   /**
-   * Adds the given `field_path` to the accumulated FieldMask.
+   * Adds the given `field_path` to the accumulated FieldMask. Only merges and
+   * updates accumulate a field mask; for other data sources this is a no-op.
    */
   void AddToFieldMask(model::FieldPath field_path);
 
@@ -59,7 +59,12 @@ bool ParseAccumulator::Contains(const FieldPath& field_path) const {
 }
 
 void ParseAccumulator::AddToFieldMask(FieldPath field_path) {
-  field_mask_.insert(std::move(field_path));
+  // Only merges and updates write the field mask out, so don't spend a set
+  // insertion on every parsed value of other writes, such as large sets.
+  if (data_source_ == UserDataSource::MergeSet ||
+      data_source_ == UserDataSource::Update) {
+    field_mask_.insert(std::move(field_path));
+  }
 }
 
 void ParseAccumulator::AddToFieldTransforms(
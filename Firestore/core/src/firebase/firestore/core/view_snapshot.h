@@ -88,6 +88,18 @@ class DocumentViewChangeSet {
   /** Returns the set of all changes tracked in this set. */
   std::vector<DocumentViewChange> GetChanges() const;
 
+  /**
+   * Returns all changes tracked in this set in the order a view raises them:
+   * by type (removals, then additions, then modifications), then in the order
+   * `comparator` puts their documents in. Removed documents must be in
+   * `old_documents` and all others in `new_documents`, both sorted by
+   * `comparator`.
+   */
+  std::vector<DocumentViewChange> GetChangesInViewOrder(
+      const model::DocumentSet& old_documents,
+      const model::DocumentSet& new_documents,
+      const model::DocumentComparator& comparator) const;
+
   std::string ToString() const;
 
  private:
@@ -123,6 +135,24 @@ class ViewSnapshot {
                                            bool from_cache,
                                            bool excludes_metadata_changes);
 
+  /**
+   * Returns a single snapshot describing the net result of `first` followed
+   * by `second`, two consecutive snapshots of the same query: the documents
+   * and metadata of `second`, the old documents of `first` and the
+   * composition of both sets of changes.
+   */
+  static ViewSnapshot Coalesce(const ViewSnapshot& first,
+                               const ViewSnapshot& second);
+
+  /**
+   * Returns a copy of this snapshot without its metadata-only document
+   * changes. Unless it has to filter a mix of changes, the copy shares its
+   * list of changes instead of allocating one, so that snapshots that only
+   * change metadata, e.g. when pending writes are acknowledged, are cheap to
+   * hand to listeners that aren't interested in them.
+   */
+  ViewSnapshot ExcludingMetadataChanges() const;
+
   /** The query this view is tracking the results for. */
   FSTQuery* query() const;
 
@@ -138,7 +168,7 @@ class ViewSnapshot {
 
   /** The set of changes that have been applied to the documents. */
   const std::vector<DocumentViewChange>& document_changes() const {
-    return document_changes_;
+    return *document_changes_;
   }
 
   /** Whether any document in the snapshot was served from the local cache. */
@@ -171,11 +201,23 @@ class ViewSnapshot {
   size_t Hash() const;
 
  private:
+  using SharedChanges = std::shared_ptr<const std::vector<DocumentViewChange>>;
+
+  ViewSnapshot(FSTQuery* query,
+               model::DocumentSet documents,
+               model::DocumentSet old_documents,
+               SharedChanges document_changes,
+               model::DocumentKeySet mutated_keys,
+               bool from_cache,
+               bool sync_state_changed,
+               bool excludes_metadata_changes);
+
   objc::Handle<FSTQuery> query_;
 
   model::DocumentSet documents_;
   model::DocumentSet old_documents_;
-  std::vector<DocumentViewChange> document_changes_;
+  // Never modified, so copies of a snapshot share it.
+  SharedChanges document_changes_;
   model::DocumentKeySet mutated_keys_;
 
   bool from_cache_ = false;
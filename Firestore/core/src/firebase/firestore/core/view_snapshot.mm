@@ -16,13 +16,19 @@
 
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 
+#include <algorithm>
+#include <memory>
 #include <ostream>
+#include <utility>
+#include <vector>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/objc/objc_compatibility.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
 #include "Firestore/core/src/firebase/firestore/util/string_format.h"
 #include "Firestore/core/src/firebase/firestore/util/to_string.h"
@@ -31,11 +37,82 @@ namespace firebase {
 namespace firestore {
 namespace core {
 
+using immutable::SortedMap;
+using model::DocumentComparator;
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::DocumentSet;
 using util::StringFormat;
 
+namespace {
+
+/**
+ * Returns the position of changes of the given type in a snapshot. Metadata
+ * changes are raised as modifications, so they sort equivalently.
+ */
+int GetTypePosition(DocumentViewChange::Type type) {
+  switch (type) {
+    case DocumentViewChange::Type::kRemoved:
+      return 0;
+    case DocumentViewChange::Type::kAdded:
+      return 1;
+    case DocumentViewChange::Type::kModified:
+    case DocumentViewChange::Type::kMetadata:
+      return 2;
+  }
+  UNREACHABLE();
+}
+
+/**
+ * When the changes of one type apply to at least 1/kMinChangesToWalkRatio of
+ * the documents they are ordered by, it is cheaper to pick them out while
+ * walking the documents in order than to sort them: sorting costs about
+ * n log n calls to the query comparator, each of which may compare several
+ * document fields, whereas the walk only looks up keys.
+ */
+const size_t kMinChangesToWalkRatio = 4;
+
+/**
+ * Orders `changes`, all of which have the given type position and apply to
+ * documents in `documents`, the way `documents` orders them.
+ */
+void OrderLike(const DocumentSet& documents,
+               const DocumentComparator& comparator,
+               const SortedMap<DocumentKey, DocumentViewChange>& change_map,
+               int position,
+               std::vector<DocumentViewChange>* changes) {
+  if (changes->size() < 2) {
+    return;
+  }
+
+  if (changes->size() * kMinChangesToWalkRatio >= documents.size()) {
+    std::vector<DocumentViewChange> ordered;
+    ordered.reserve(changes->size());
+    for (FSTDocument* document : documents) {
+      auto found = change_map.find(document.key);
+      if (found != change_map.end() &&
+          GetTypePosition(found->second.type()) == position) {
+        ordered.push_back(found->second);
+      }
+    }
+    // Every change should have been found, but fall back to sorting rather
+    // than drop one if not.
+    if (ordered.size() == changes->size()) {
+      *changes = std::move(ordered);
+      return;
+    }
+  }
+
+  std::sort(changes->begin(), changes->end(),
+            [&comparator](const DocumentViewChange& lhs,
+                          const DocumentViewChange& rhs) {
+              return util::Ascending(
+                  comparator.Compare(lhs.document(), rhs.document()));
+            });
+}
+
+}  // namespace
+
 // DocumentViewChange
 
 DocumentViewChange::DocumentViewChange(FSTDocument* document, Type type)
@@ -67,7 +144,7 @@ void DocumentViewChangeSet::AddChange(DocumentViewChange&& change) {
   const DocumentKey& key = change.document().key;
   auto old_change_iter = change_map_.find(key);
   if (old_change_iter == change_map_.end()) {
-    change_map_ = change_map_.insert(key, change);
+    change_map_ = std::move(change_map_).insert(key, change);
     return;
   }
 
@@ -78,40 +155,40 @@ void DocumentViewChangeSet::AddChange(DocumentViewChange&& change) {
   // Merge the new change with the existing change.
   if (new_type != DocumentViewChange::Type::kAdded &&
       old_type == DocumentViewChange::Type::kMetadata) {
-    change_map_ = change_map_.insert(key, change);
+    change_map_ = std::move(change_map_).insert(key, change);
 
   } else if (new_type == DocumentViewChange::Type::kMetadata &&
              old_type != DocumentViewChange::Type::kRemoved) {
     DocumentViewChange new_change{change.document(), old_type};
-    change_map_ = change_map_.insert(key, new_change);
+    change_map_ = std::move(change_map_).insert(key, new_change);
 
   } else if (new_type == DocumentViewChange::Type::kModified &&
              old_type == DocumentViewChange::Type::kModified) {
     DocumentViewChange new_change{change.document(),
                                   DocumentViewChange::Type::kModified};
-    change_map_ = change_map_.insert(key, new_change);
+    change_map_ = std::move(change_map_).insert(key, new_change);
 
   } else if (new_type == DocumentViewChange::Type::kModified &&
              old_type == DocumentViewChange::Type::kAdded) {
     DocumentViewChange new_change{change.document(),
                                   DocumentViewChange::Type::kAdded};
-    change_map_ = change_map_.insert(key, new_change);
+    change_map_ = std::move(change_map_).insert(key, new_change);
 
   } else if (new_type == DocumentViewChange::Type::kRemoved &&
              old_type == DocumentViewChange::Type::kAdded) {
-    change_map_ = change_map_.erase(key);
+    change_map_ = std::move(change_map_).erase(key);
 
   } else if (new_type == DocumentViewChange::Type::kRemoved &&
              old_type == DocumentViewChange::Type::kModified) {
     DocumentViewChange new_change{old.document(),
                                   DocumentViewChange::Type::kRemoved};
-    change_map_ = change_map_.insert(key, new_change);
+    change_map_ = std::move(change_map_).insert(key, new_change);
 
   } else if (new_type == DocumentViewChange::Type::kAdded &&
              old_type == DocumentViewChange::Type::kRemoved) {
     DocumentViewChange new_change{change.document(),
                                   DocumentViewChange::Type::kModified};
-    change_map_ = change_map_.insert(key, new_change);
+    change_map_ = std::move(change_map_).insert(key, new_change);
 
   } else {
     // This includes these cases, which don't make sense:
@@ -135,6 +212,31 @@ std::vector<DocumentViewChange> DocumentViewChangeSet::GetChanges() const {
   return changes;
 }
 
+std::vector<DocumentViewChange> DocumentViewChangeSet::GetChangesInViewOrder(
+    const DocumentSet& old_documents,
+    const DocumentSet& new_documents,
+    const DocumentComparator& comparator) const {
+  // The map keeps changes in key order, so split them by type position here;
+  // then only each group needs to be put in query order.
+  std::vector<DocumentViewChange> groups[3];
+  for (const auto& kv : change_map_) {
+    const DocumentViewChange& change = kv.second;
+    groups[GetTypePosition(change.type())].push_back(change);
+  }
+
+  std::vector<DocumentViewChange> changes;
+  changes.reserve(change_map_.size());
+  for (int position = 0; position < 3; ++position) {
+    // Removed documents are no longer in the new documents.
+    const DocumentSet& documents =
+        position == 0 ? old_documents : new_documents;
+    OrderLike(documents, comparator, change_map_, position, &groups[position]);
+    changes.insert(changes.end(), groups[position].begin(),
+                   groups[position].end());
+  }
+  return changes;
+}
+
 std::string DocumentViewChangeSet::ToString() const {
   return util::ToString(change_map_);
 }
@@ -149,6 +251,25 @@ ViewSnapshot::ViewSnapshot(FSTQuery* query,
                            bool from_cache,
                            bool sync_state_changed,
                            bool excludes_metadata_changes)
+    : ViewSnapshot{query,
+                   std::move(documents),
+                   std::move(old_documents),
+                   std::make_shared<const std::vector<DocumentViewChange>>(
+                       std::move(document_changes)),
+                   std::move(mutated_keys),
+                   from_cache,
+                   sync_state_changed,
+                   excludes_metadata_changes} {
+}
+
+ViewSnapshot::ViewSnapshot(FSTQuery* query,
+                           DocumentSet documents,
+                           DocumentSet old_documents,
+                           SharedChanges document_changes,
+                           model::DocumentKeySet mutated_keys,
+                           bool from_cache,
+                           bool sync_state_changed,
+                           bool excludes_metadata_changes)
     : query_{query},
       documents_{std::move(documents)},
       old_documents_{std::move(old_documents)},
@@ -177,6 +298,76 @@ ViewSnapshot ViewSnapshot::FromInitialDocuments(
                       /*sync_state_changed=*/true, excludes_metadata_changes};
 }
 
+ViewSnapshot ViewSnapshot::Coalesce(const ViewSnapshot& first,
+                                    const ViewSnapshot& second) {
+  HARD_ASSERT(objc::Equals(first.query(), second.query()),
+              "Cannot coalesce snapshots of different queries");
+
+  DocumentViewChangeSet change_set;
+  for (const DocumentViewChange& change : first.document_changes()) {
+    change_set.AddChange(DocumentViewChange{change});
+  }
+  for (const DocumentViewChange& change : second.document_changes()) {
+    change_set.AddChange(DocumentViewChange{change});
+  }
+
+  // Keep the order views produce changes in (by type, then by query order),
+  // which the API layer relies on to compute the indexes of changes.
+  FSTQuery* query = second.query();
+  std::vector<DocumentViewChange> changes = change_set.GetChangesInViewOrder(
+      first.old_documents(), second.documents(), query.comparator);
+
+  // The sync state only flips between synced and from cache, so the net
+  // snapshot changed it if it ends up different from where `first` started.
+  bool from_cache_before =
+      first.sync_state_changed() ? !first.from_cache() : first.from_cache();
+
+  return ViewSnapshot{query,
+                      second.documents(),
+                      first.old_documents(),
+                      std::move(changes),
+                      second.mutated_keys(),
+                      second.from_cache(),
+                      second.from_cache() != from_cache_before,
+                      second.excludes_metadata_changes()};
+}
+
+ViewSnapshot ViewSnapshot::ExcludingMetadataChanges() const {
+  size_t metadata_changes = static_cast<size_t>(std::count_if(
+      document_changes_->begin(), document_changes_->end(),
+      [](const DocumentViewChange& change) {
+        return change.type() == DocumentViewChange::Type::kMetadata;
+      }));
+
+  SharedChanges changes;
+  if (metadata_changes == 0) {
+    changes = document_changes_;
+  } else if (metadata_changes == document_changes_->size()) {
+    static const auto* empty_changes = new SharedChanges{
+        std::make_shared<const std::vector<DocumentViewChange>>()};
+    changes = *empty_changes;
+  } else {
+    std::vector<DocumentViewChange> filtered;
+    filtered.reserve(document_changes_->size() - metadata_changes);
+    for (const DocumentViewChange& change : *document_changes_) {
+      if (change.type() != DocumentViewChange::Type::kMetadata) {
+        filtered.push_back(change);
+      }
+    }
+    changes = std::make_shared<const std::vector<DocumentViewChange>>(
+        std::move(filtered));
+  }
+
+  return ViewSnapshot{query_,
+                      documents_,
+                      old_documents_,
+                      std::move(changes),
+                      mutated_keys_,
+                      from_cache_,
+                      sync_state_changed_,
+                      /*excludes_metadata_changes=*/true};
+}
+
 FSTQuery* ViewSnapshot::query() const {
   return query_;
 }
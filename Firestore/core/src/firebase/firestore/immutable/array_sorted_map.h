@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/keys_view.h"
+#include "Firestore/core/src/firebase/firestore/immutable/pool_allocator.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -49,12 +50,13 @@ namespace impl {
  * to a FixedArray.
  *
  * @tparam T The type of an element in the array.
+ * @tparam N The maximum number of elements the array can hold.
  */
-template <typename T>
+template <typename T, SortedMapBase::size_type N = SortedMapBase::kFixedSize>
 class FixedArray {
  public:
   using size_type = SortedMapBase::size_type;
-  using array_type = std::array<T, SortedMapBase::kFixedSize>;
+  using array_type = std::array<T, N>;
   using iterator = typename array_type::iterator;
   using const_iterator = typename array_type::const_iterator;
 
@@ -74,7 +76,7 @@ class FixedArray {
   void append(SourceIterator src_begin, SourceIterator src_end) {
     auto appending = static_cast<size_type>(src_end - src_begin);
     auto new_size = size_ + appending;
-    HARD_ASSERT(new_size <= SortedMapBase::kFixedSize);
+    HARD_ASSERT(new_size <= N);
 
     std::copy(src_begin, src_end, end());
     size_ = new_size;
@@ -85,12 +87,45 @@ class FixedArray {
    */
   void append(T&& value) {
     size_type new_size = size_ + 1;
-    HARD_ASSERT(new_size <= SortedMapBase::kFixedSize);
+    HARD_ASSERT(new_size <= N);
 
     *end() = std::move(value);
     size_ = new_size;
   }
 
+  /**
+   * Inserts a single value before the element at the given index, shifting
+   * the following elements up by one.
+   */
+  void insert(size_type index, T&& value) {
+    size_type new_size = size_ + 1;
+    HARD_ASSERT(index <= size_ && new_size <= N);
+
+    std::move_backward(begin() + index, end(), end() + 1);
+    contents_[index] = std::move(value);
+    size_ = new_size;
+  }
+
+  /** Replaces the element at the given index. */
+  void replace(size_type index, T&& value) {
+    HARD_ASSERT(index < size_);
+    contents_[index] = std::move(value);
+  }
+
+  /**
+   * Removes the element at the given index, shifting the following elements
+   * down by one.
+   */
+  void erase(size_type index) {
+    HARD_ASSERT(index < size_);
+
+    std::move(begin() + index + 1, end(), begin() + index);
+    size_ -= 1;
+
+    // Release whatever the vacated slot still refers to.
+    contents_[size_] = T{};
+  }
+
   const_iterator begin() const {
     return contents_.begin();
   }
@@ -120,7 +155,10 @@ class FixedArray {
  * ArraySortedMap is a value type containing a map. It is immutable, but has
  * methods to efficiently create new maps that are mutations of it.
  */
-template <typename K, typename V, typename C = util::Comparator<K>>
+template <typename K,
+          typename V,
+          typename C = util::Comparator<K>,
+          SortedMapBase::size_type N = SortedMapBase::kFixedSize>
 class ArraySortedMap : public SortedMapBase {
  public:
   /**
@@ -131,7 +169,7 @@ class ArraySortedMap : public SortedMapBase {
   /**
    * The type of the fixed-size array containing entries of value_type.
    */
-  using array_type = FixedArray<value_type>;
+  using array_type = FixedArray<value_type, N>;
   using const_iterator = typename array_type::const_iterator;
   using const_key_iterator = util::iterator_first<const_iterator>;
 
@@ -152,6 +190,22 @@ class ArraySortedMap : public SortedMapBase {
       : array_{SortedArray(entries, comparator)}, comparator_{comparator} {
   }
 
+  /**
+   * Creates an ArraySortedMap from a range of entries that is already sorted by
+   * key and contains no duplicate keys. The range may also contain bare keys,
+   * in which case each is mapped to a default-constructed value.
+   */
+  template <typename Iterator>
+  static ArraySortedMap FromSorted(Iterator begin,
+                                   Iterator end,
+                                   const C& comparator) {
+    auto array = NewArray();
+    for (; begin != end; ++begin) {
+      array->append(MakeEntry(*begin));
+    }
+    return ArraySortedMap{std::move(array), comparator};
+  }
+
   /** Returns true if the map contains no elements. */
   bool empty() const {
     return size() == 0;
@@ -174,7 +228,7 @@ class ArraySortedMap : public SortedMapBase {
    * @param value The value to associate with the key.
    * @return A new dictionary with the added/updated value.
    */
-  ArraySortedMap insert(const K& key, const V& value) const {
+  ArraySortedMap insert(const K& key, const V& value) const& {
     const_iterator current_end = end();
     const_iterator pos = lower_bound(key);
     bool replacing_entry = false;
@@ -191,7 +245,7 @@ class ArraySortedMap : public SortedMapBase {
 
     // Copy the segment before the found position. If not found, this is
     // everything.
-    auto copy = std::make_shared<array_type>(begin(), pos);
+    auto copy = NewArray(begin(), pos);
 
     // Copy the value to be inserted.
     copy->append({key, value});
@@ -205,13 +259,34 @@ class ArraySortedMap : public SortedMapBase {
     return wrap(copy);
   }
 
+  /**
+   * Like `insert` above, but consumes this map. If no other map shares this
+   * map's array, the array is updated in place.
+   */
+  ArraySortedMap insert(K key, V value) && {
+    if (!unique() || size() >= N) {
+      return static_cast<const ArraySortedMap&>(*this).insert(key, value);
+    }
+
+    const_iterator pos = lower_bound(key);
+    auto index = static_cast<size_type>(pos - begin());
+    value_type entry{std::move(key), std::move(value)};
+    if (pos != end() &&
+        util::Same(comparator_.Compare(entry.first, pos->first))) {
+      mutable_array().replace(index, std::move(entry));
+    } else {
+      mutable_array().insert(index, std::move(entry));
+    }
+    return std::move(*this);
+  }
+
   /**
    * Creates a new map identical to this one, but with a key removed from it.
    *
    * @param key The key to remove.
    * @return A new dictionary without that value.
    */
-  ArraySortedMap erase(const K& key) const {
+  ArraySortedMap erase(const K& key) const& {
     const_iterator current_end = end();
     const_iterator pos = find(key);
     if (pos == current_end) {
@@ -221,12 +296,28 @@ class ArraySortedMap : public SortedMapBase {
       // the result empty.
       return wrap(EmptyArray());
     } else {
-      auto copy = std::make_shared<array_type>(begin(), pos);
+      auto copy = NewArray(begin(), pos);
       copy->append(pos + 1, current_end);
       return wrap(copy);
     }
   }
 
+  /**
+   * Like `erase` above, but consumes this map. If no other map shares this
+   * map's array, the array is updated in place.
+   */
+  ArraySortedMap erase(const K& key) && {
+    if (!unique()) {
+      return static_cast<const ArraySortedMap&>(*this).erase(key);
+    }
+
+    const_iterator pos = find(key);
+    if (pos != end()) {
+      mutable_array().erase(static_cast<size_type>(pos - begin()));
+    }
+    return std::move(*this);
+  }
+
   bool contains(const K& key) const {
     return find(key) != end();
   }
@@ -339,13 +430,42 @@ class ArraySortedMap : public SortedMapBase {
         [&comparator](const value_type& lhs, const value_type& rhs) {
           return util::Ascending(comparator.Compare(lhs.first, rhs.first));
         });
-    return std::make_shared<const array_type>(sorted.begin(), sorted.end());
+    return NewArray(sorted.begin(), sorted.end());
   }
 
   ArraySortedMap(const array_pointer& array, const C& comparator) noexcept
       : array_{array}, comparator_{comparator} {
   }
 
+  /**
+   * Returns true if nothing else refers to this map's array, which can then be
+   * modified in place. The shared empty array is never unique.
+   */
+  bool unique() const {
+    return array_.use_count() == 1;
+  }
+
+  /**
+   * Returns the array for modification. Only valid if `unique()`; every array
+   * other than the shared empty one is allocated as non-const.
+   */
+  array_type& mutable_array() {
+    return const_cast<array_type&>(*array_);
+  }
+
+  template <typename... Args>
+  static std::shared_ptr<array_type> NewArray(Args&&... args) {
+    return std::allocate_shared<array_type>(PoolAllocator<array_type>{},
+                                            std::forward<Args>(args)...);
+  }
+
+  static value_type MakeEntry(const value_type& entry) {
+    return entry;
+  }
+  static value_type MakeEntry(const K& key) {
+    return value_type{key, V{}};
+  }
+
   ArraySortedMap wrap(const array_pointer& array) const noexcept {
     return ArraySortedMap{array, comparator_};
   }
@@ -17,10 +17,13 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_H_
 
+#include <cstdint>
+#include <iterator>
 #include <memory>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/immutable/llrb_node_iterator.h"
+#include "Firestore/core/src/firebase/firestore/immutable/pool_allocator.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
 
 namespace firebase {
@@ -57,6 +60,17 @@ class LlrbNode : public SortedMapBase {
   LlrbNode() : LlrbNode{EmptyRep()} {
   }
 
+  /**
+   * Builds a tree from a range of entries that is already sorted by key and
+   * contains no duplicate keys. The range may also contain bare keys, in which
+   * case each is mapped to a default-constructed value.
+   *
+   * Unlike repeated insertion, this allocates exactly one node per entry and
+   * runs in linear time.
+   */
+  template <typename Iterator>
+  static LlrbNode FromSorted(Iterator begin, Iterator end);
+
   /** Returns true if this is an empty node--a leaf node in the tree. */
   bool empty() const {
     return size() == 0;
@@ -95,10 +109,33 @@ class LlrbNode : public SortedMapBase {
   template <typename Comparator>
   LlrbNode insert(const K& key,
                   const V& value,
-                  const Comparator& comparator) const;
+                  const Comparator& comparator) const& {
+    return Insert(LlrbNode{*this}, value_type{key, value}, comparator);
+  }
 
+  /**
+   * Like `insert` above, but consumes this tree: nodes on the insertion path
+   * that nothing else refers to are updated in place rather than copied.
+   */
+  template <typename Comparator>
+  LlrbNode insert(K key, V value, const Comparator& comparator) && {
+    return Insert(std::move(*this),
+                  value_type{std::move(key), std::move(value)}, comparator);
+  }
+
+  template <typename Comparator>
+  LlrbNode erase(const K& key, const Comparator& comparator) const& {
+    return Erase(LlrbNode{*this}, key, comparator);
+  }
+
+  /**
+   * Like `erase` above, but consumes this tree, updating nodes that nothing
+   * else refers to in place.
+   */
   template <typename Comparator>
-  LlrbNode erase(const K& key, const Comparator& comparator) const;
+  LlrbNode erase(const K& key, const Comparator& comparator) && {
+    return Erase(std::move(*this), key, comparator);
+  }
 
   const LlrbNode& min() const {
     const LlrbNode* node = this;
@@ -148,7 +185,8 @@ class LlrbNode : public SortedMapBase {
     LlrbNode right_;
   };
 
-  explicit LlrbNode(Rep rep) : rep_{std::make_shared<Rep>(std::move(rep))} {
+  explicit LlrbNode(Rep rep)
+      : rep_{std::allocate_shared<Rep>(PoolAllocator<Rep>{}, std::move(rep))} {
   }
 
   explicit LlrbNode(const std::shared_ptr<Rep>& rep) : rep_{rep} {
@@ -196,6 +234,9 @@ class LlrbNode : public SortedMapBase {
   void set_value(const V& value) {
     rep_->entry_.second = value;
   }
+  void set_value(V&& value) {
+    rep_->entry_.second = std::move(value);
+  }
   void set_color(size_type color) {
     rep_->color_ = color;
   }
@@ -212,13 +253,58 @@ class LlrbNode : public SortedMapBase {
     rep_->right_ = std::move(right);
   }
 
+  template <typename Iterator>
+  static LlrbNode Build(Iterator* iter, size_type size, int black_height);
+
+  static value_type MakeEntry(const value_type& entry) {
+    return entry;
+  }
+  static value_type MakeEntry(const K& key) {
+    return value_type{key, V{}};
+  }
+
+  /**
+   * Returns a node that is safe to modify: the given node itself if nothing
+   * else refers to it, or a copy of it otherwise.
+   *
+   * A use count of one means the caller holds the only reference, so no other
+   * thread can concurrently acquire a new one.
+   */
+  static LlrbNode Own(LlrbNode&& node) {
+    return node.rep_.use_count() == 1 ? std::move(node) : node.Clone();
+  }
+
+  /**
+   * Moves a child out of this node so that it can be handed to one of the
+   * consuming operations. The child must be replaced before this node is used
+   * again.
+   */
+  LlrbNode TakeLeft() {
+    return std::move(rep_->left_);
+  }
+  LlrbNode TakeRight() {
+    return std::move(rep_->right_);
+  }
+
+  template <typename Comparator>
+  static LlrbNode Insert(LlrbNode root,
+                         value_type&& entry,
+                         const Comparator& comparator);
+
+  template <typename Comparator>
+  static LlrbNode InnerInsert(LlrbNode node,
+                              value_type&& entry,
+                              const Comparator& comparator);
+
   template <typename Comparator>
-  LlrbNode InnerInsert(const K& key,
-                       const V& value,
-                       const Comparator& comparator) const;
+  static LlrbNode Erase(LlrbNode root,
+                        const K& key,
+                        const Comparator& comparator);
 
   template <typename Comparator>
-  LlrbNode InnerErase(const K& key, const Comparator& comparator) const;
+  static LlrbNode InnerErase(LlrbNode node,
+                             const K& key,
+                             const Comparator& comparator);
 
   void FixUp();
   void FixRootColor();
@@ -238,72 +324,147 @@ class LlrbNode : public SortedMapBase {
   std::shared_ptr<Rep> rep_;
 };
 
+template <typename K, typename V>
+template <typename Iterator>
+LlrbNode<K, V> LlrbNode<K, V>::FromSorted(Iterator begin, Iterator end) {
+  auto size = static_cast<size_type>(std::distance(begin, end));
+
+  // A tree made only of black nodes holds 2^h - 1 entries for black height h.
+  // Pick the largest such h that doesn't exceed the size; the remaining
+  // entries are accommodated by red nodes.
+  int black_height = 0;
+  while ((uint64_t{1} << (black_height + 1)) - 1 <= size) {
+    ++black_height;
+  }
+  return Build(&begin, size, black_height);
+}
+
+/**
+ * Builds a tree of the given black height from the next `size` entries of the
+ * input, consuming them in order.
+ *
+ * Viewed as a 2-3 tree, a subtree of black height h holds between 2^h - 1
+ * entries (only 2-nodes) and 3^h - 1 entries (only 3-nodes). The root becomes
+ * a 2-node whenever its two children can absorb the remaining entries and a
+ * 3-node (a black node with a red left child) otherwise, which keeps every
+ * path to a leaf at the same black height.
+ */
+template <typename K, typename V>
+template <typename Iterator>
+LlrbNode<K, V> LlrbNode<K, V>::Build(Iterator* iter,
+                                     size_type size,
+                                     int black_height) {
+  if (size == 0) {
+    return LlrbNode{};
+  }
+
+  uint64_t child_max_size = 1;
+  for (int i = 1; i < black_height; ++i) {
+    child_max_size *= 3;
+  }
+  child_max_size -= 1;
+
+  if (size - 1 <= 2 * child_max_size) {
+    size_type right_size = (size - 1) / 2;
+    size_type left_size = size - 1 - right_size;
+
+    LlrbNode left = Build(iter, left_size, black_height - 1);
+    value_type entry = MakeEntry(**iter);
+    ++*iter;
+    LlrbNode right = Build(iter, right_size, black_height - 1);
+    return LlrbNode{Rep{std::move(entry), Color::Black, std::move(left),
+                        std::move(right)}};
+  }
+
+  size_type remaining = size - 2;
+  size_type right_size = remaining / 3;
+  size_type middle_size = (remaining - right_size) / 2;
+  size_type left_size = remaining - right_size - middle_size;
+
+  LlrbNode left = Build(iter, left_size, black_height - 1);
+  value_type red_entry = MakeEntry(**iter);
+  ++*iter;
+  LlrbNode middle = Build(iter, middle_size, black_height - 1);
+  value_type entry = MakeEntry(**iter);
+  ++*iter;
+  LlrbNode right = Build(iter, right_size, black_height - 1);
+
+  LlrbNode red{Rep{std::move(red_entry), Color::Red, std::move(left),
+                   std::move(middle)}};
+  return LlrbNode{
+      Rep{std::move(entry), Color::Black, std::move(red), std::move(right)}};
+}
+
 template <typename K, typename V>
 template <typename Comparator>
-LlrbNode<K, V> LlrbNode<K, V>::insert(const K& key,
-                                      const V& value,
-                                      const Comparator& comparator) const {
-  LlrbNode root = InnerInsert(key, value, comparator);
+LlrbNode<K, V> LlrbNode<K, V>::Insert(LlrbNode root,
+                                      value_type&& entry,
+                                      const Comparator& comparator) {
+  root = InnerInsert(std::move(root), std::move(entry), comparator);
   root.FixRootColor();
   return root;
 }
 
 template <typename K, typename V>
 template <typename Comparator>
-LlrbNode<K, V> LlrbNode<K, V>::InnerInsert(const K& key,
-                                           const V& value,
-                                           const Comparator& comparator) const {
-  if (empty()) {
-    return LlrbNode{Rep{{key, value}, Color::Red, LlrbNode{}, LlrbNode{}}};
+LlrbNode<K, V> LlrbNode<K, V>::InnerInsert(LlrbNode node,
+                                           value_type&& entry,
+                                           const Comparator& comparator) {
+  if (node.empty()) {
+    return LlrbNode{Rep{std::move(entry), Color::Red, LlrbNode{}, LlrbNode{}}};
   }
 
-  // Inserting is going to result in a copy but we can save some allocations by
+  // Inserting usually results in a copy but we can save some allocations by
   // creating the copy once and fixing that up, rather than copying and
-  // re-copying the result.
-  LlrbNode result = Clone();
+  // re-copying the result. Nodes that nothing else shares aren't copied at
+  // all.
+  LlrbNode result = Own(std::move(node));
 
-  const K& this_key = this->key();
-  util::ComparisonResult cmp = comparator.Compare(this_key, key);
+  util::ComparisonResult cmp = comparator.Compare(result.key(), entry.first);
   if (cmp == util::ComparisonResult::Descending) {
-    result.set_left(result.left().InnerInsert(key, value, comparator));
+    result.set_left(
+        InnerInsert(result.TakeLeft(), std::move(entry), comparator));
     result.FixUp();
 
   } else if (cmp == util::ComparisonResult::Ascending) {
-    result.set_right(result.right().InnerInsert(key, value, comparator));
+    result.set_right(
+        InnerInsert(result.TakeRight(), std::move(entry), comparator));
     result.FixUp();
 
   } else {
     // keys are equal so update the value.
-    result.set_value(value);
+    result.set_value(std::move(entry.second));
   }
   return result;
 }
 
 template <typename K, typename V>
 template <typename Comparator>
-LlrbNode<K, V> LlrbNode<K, V>::erase(const K& key,
-                                     const Comparator& comparator) const {
-  LlrbNode root = InnerErase(key, comparator);
+LlrbNode<K, V> LlrbNode<K, V>::Erase(LlrbNode root,
+                                     const K& key,
+                                     const Comparator& comparator) {
+  root = InnerErase(std::move(root), key, comparator);
   root.FixRootColor();
   return root;
 }
 
 template <typename K, typename V>
 template <typename Comparator>
-LlrbNode<K, V> LlrbNode<K, V>::InnerErase(const K& key,
-                                          const Comparator& comparator) const {
-  if (empty()) {
+LlrbNode<K, V> LlrbNode<K, V>::InnerErase(LlrbNode node,
+                                          const K& key,
+                                          const Comparator& comparator) {
+  if (node.empty()) {
     // Empty node already frozen
     return LlrbNode{};
   }
 
-  LlrbNode n = Clone();
+  LlrbNode n = Own(std::move(node));
 
   if (util::Ascending(comparator.Compare(key, n.key()))) {
     if (!n.left().empty() && !n.left().red() && !n.left().left().red()) {
       n.MoveRedLeft();
     }
-    n.set_left(n.left().InnerErase(key, comparator));
+    n.set_left(InnerErase(n.TakeLeft(), key, comparator));
 
   } else {
     if (n.left().red()) {
@@ -328,7 +489,7 @@ LlrbNode<K, V> LlrbNode<K, V>::InnerErase(const K& key,
         n.set_right(std::move(new_right));
       }
     } else {
-      n.set_right(n.right().InnerErase(key, comparator));
+      n.set_right(InnerErase(n.TakeRight(), key, comparator));
     }
   }
   n.FixUp();
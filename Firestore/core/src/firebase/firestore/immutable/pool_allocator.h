@@ -0,0 +1,171 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_POOL_ALLOCATOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_POOL_ALLOCATOR_H_
+
+#include <cstddef>
+#include <new>
+
+#include "Firestore/core/src/firebase/firestore/util/allocation_counters.h"
+#include "absl/base/config.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A per-thread free list of memory blocks of `Size` bytes.
+ *
+ * Immutable containers allocate and free nodes at a high rate, mostly in
+ * bursts as snapshots are built and discarded. Keeping recently freed blocks
+ * around lets the next burst reuse them without a round trip through the
+ * system allocator. Blocks freed on one thread may be reused on another; each
+ * thread simply keeps whatever it frees.
+ *
+ * Each free list retains at most `kMaxPooledBytes`; anything beyond that is
+ * returned to the system allocator. On platforms without `thread_local`
+ * (notably iOS 8) there is no pooling at all.
+ */
+template <size_t Size>
+class BlockPool {
+ public:
+  static constexpr size_t kMaxPooledBytes = 128 * 1024;
+  static constexpr size_t kMaxPooledBlocks =
+      Size >= kMaxPooledBytes ? 1 : kMaxPooledBytes / Size;
+
+  static void* Allocate() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+    FreeList& free_list = GetFreeList();
+    if (free_list.head != nullptr) {
+      Block* block = free_list.head;
+      free_list.head = block->next;
+      --free_list.size;
+      return block;
+    }
+#endif
+    return ::operator new(Size);
+  }
+
+  static void Deallocate(void* memory) {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+    FreeList& free_list = GetFreeList();
+    if (free_list.size < kMaxPooledBlocks) {
+      auto block = static_cast<Block*>(memory);
+      block->next = free_list.head;
+      free_list.head = block;
+      ++free_list.size;
+      return;
+    }
+#endif
+    ::operator delete(memory);
+  }
+
+ private:
+  struct Block {
+    Block* next;
+  };
+
+  static_assert(Size >= sizeof(Block), "blocks must be able to hold a link");
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  struct FreeList {
+    ~FreeList() {
+      while (head != nullptr) {
+        Block* next = head->next;
+        ::operator delete(head);
+        head = next;
+      }
+
+      // Thread-local destructors run in no particular order, so containers
+      // destroyed after this one on the same thread must bypass the pool.
+      size = kMaxPooledBlocks;
+    }
+
+    Block* head = nullptr;
+    size_t size = 0;
+  };
+
+  static FreeList& GetFreeList() {
+    static thread_local FreeList free_list;
+    return free_list;
+  }
+#endif
+};
+
+template <size_t Size>
+constexpr size_t BlockPool<Size>::kMaxPooledBytes;
+
+template <size_t Size>
+constexpr size_t BlockPool<Size>::kMaxPooledBlocks;
+
+/**
+ * A standard allocator that serves single-object allocations from a
+ * `BlockPool`. Intended for use with `std::allocate_shared`, which rebinds it
+ * to the combined control block and object.
+ */
+template <typename T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+
+  PoolAllocator() = default;
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&) noexcept {  // NOLINT(runtime/explicit)
+  }
+
+  T* allocate(size_t n) {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "over-aligned types are not supported");
+    // Counted whether or not the pool can serve it, so that the counts don't
+    // depend on what earlier work on this thread left in the pool.
+    util::CountAllocation(util::AllocationSubsystem::kImmutable, n * sizeof(T));
+    if (n == 1) {
+      return static_cast<T*>(Pool::Allocate());
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* pointer, size_t n) noexcept {
+    if (n == 1) {
+      Pool::Deallocate(pointer);
+    } else {
+      ::operator delete(pointer);
+    }
+  }
+
+  friend bool operator==(const PoolAllocator&, const PoolAllocator&) {
+    return true;
+  }
+
+  friend bool operator!=(const PoolAllocator&, const PoolAllocator&) {
+    return false;
+  }
+
+ private:
+  // Blocks must be large enough to link them into the free list.
+  using Pool =
+      BlockPool<(sizeof(T) < sizeof(void*) ? sizeof(void*) : sizeof(T))>;
+};
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_POOL_ALLOCATOR_H_
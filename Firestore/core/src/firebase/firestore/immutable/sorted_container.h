@@ -60,7 +60,7 @@ class SortedContainer {
 class SortedMapBase : public SortedContainer {
  public:
   /**
-   * The maximum size of an ArraySortedMap.
+   * The default maximum size of an ArraySortedMap.
    *
    * This is the size threshold where we use a tree backed sorted map instead of
    * an array backed sorted map. This is a more or less arbitrary chosen value,
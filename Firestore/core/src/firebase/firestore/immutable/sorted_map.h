@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_H_
 
+#include <iterator>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
@@ -34,20 +35,28 @@ namespace immutable {
 /**
  * SortedMap is a value type containing a map. It is immutable, but
  * has methods to efficiently create new maps that are mutations of it.
+ *
+ * Maps with up to `N` entries are stored in a flat sorted array; larger maps
+ * are stored in a tree. The default threshold is tuned for document fields;
+ * instantiations whose entries are much cheaper or much more expensive to copy
+ * can pick a threshold of their own.
  */
-template <typename K, typename V, typename C = util::Comparator<K>>
+template <typename K,
+          typename V,
+          typename C = util::Comparator<K>,
+          SortedMapBase::size_type N = SortedMapBase::kFixedSize>
 class SortedMap : public SortedMapBase {
  public:
   using key_type = K;
   using mapped_type = V;
   /** The type of the entries stored in the map. */
   using value_type = std::pair<K, V>;
-  using array_type = impl::ArraySortedMap<K, V, C>;
+  using array_type = impl::ArraySortedMap<K, V, C, N>;
   using tree_type = impl::TreeSortedMap<K, V, C>;
 
   using const_iterator = impl::SortedMapIterator<
       value_type,
-      typename impl::FixedArray<value_type>::const_iterator,
+      typename impl::FixedArray<value_type, N>::const_iterator,
       typename impl::LlrbNode<K, V>::const_iterator>;
 
   using const_key_iterator = util::iterator_first<const_iterator>;
@@ -64,7 +73,7 @@ class SortedMap : public SortedMapBase {
    */
   SortedMap(std::initializer_list<value_type> entries,
             const C& comparator = {}) {
-    if (entries.size() <= kFixedSize) {
+    if (entries.size() <= N) {
       tag_ = Tag::Array;
       new (&array_) array_type{entries, comparator};
     } else {
@@ -72,6 +81,25 @@ class SortedMap : public SortedMapBase {
     }
   }
 
+  /**
+   * Creates a SortedMap from a range of entries that is already sorted by key
+   * and contains no duplicate keys. The range may also contain bare keys, in
+   * which case each is mapped to a default-constructed value.
+   *
+   * This runs in linear time and is much cheaper than inserting the entries
+   * one at a time.
+   */
+  template <typename Iterator>
+  static SortedMap FromSorted(Iterator begin,
+                              Iterator end,
+                              const C& comparator = {}) {
+    if (static_cast<size_type>(std::distance(begin, end)) <= N) {
+      return SortedMap{array_type::FromSorted(begin, end, comparator)};
+    } else {
+      return SortedMap{tree_type::FromSorted(begin, end, comparator)};
+    }
+  }
+
   SortedMap(const SortedMap& other) : tag_{other.tag_} {
     switch (tag_) {
       case Tag::Array:
@@ -169,18 +197,19 @@ class SortedMap : public SortedMapBase {
    * @param value The value to associate with the key.
    * @return A new dictionary with the added/updated value.
    */
-  ABSL_MUST_USE_RESULT SortedMap insert(const K& key, const V& value) const {
+  ABSL_MUST_USE_RESULT SortedMap insert(const K& key, const V& value) const& {
     switch (tag_) {
       case Tag::Array:
-        if (array_.size() >= kFixedSize) {
+        if (array_.size() >= N) {
           // Strictly speaking this conversion is more eager than it needs to
           // be since we could be replacing an existing key. However, the
           // benefit of using the array for small maps doesn't really depend on
           // exactly where this cut-off happens and just unconditionally
           // converting if the next insertion could overflow keeps things
           // simpler.
-          tree_type tree = tree_type::Create(array_, comparator());
-          return SortedMap{tree.insert(key, value)};
+          tree_type tree = tree_type::FromSorted(array_.begin(), array_.end(),
+                                                 comparator());
+          return SortedMap{std::move(tree).insert(key, value)};
         } else {
           return SortedMap{array_.insert(key, value)};
         }
@@ -190,13 +219,41 @@ class SortedMap : public SortedMapBase {
     UNREACHABLE();
   }
 
+  /**
+   * Like `insert` above, but consumes this map. Any parts of the map that no
+   * other map shares are updated in place instead of being copied, so building
+   * up a map with
+   *
+   *     map = std::move(map).insert(key, value);
+   *
+   * allocates far less than copying it on every step.
+   */
+  ABSL_MUST_USE_RESULT SortedMap insert(K key, V value) && {
+    switch (tag_) {
+      case Tag::Array:
+        if (array_.size() >= N) {
+          tree_type tree = tree_type::FromSorted(array_.begin(), array_.end(),
+                                                 comparator());
+          return SortedMap{
+              std::move(tree).insert(std::move(key), std::move(value))};
+        } else {
+          return SortedMap{
+              std::move(array_).insert(std::move(key), std::move(value))};
+        }
+      case Tag::Tree:
+        return SortedMap{
+            std::move(tree_).insert(std::move(key), std::move(value))};
+    }
+    UNREACHABLE();
+  }
+
   /**
    * Creates a new map identical to this one, but with a key removed from it.
    *
    * @param key The key to remove.
    * @return A new map without that value.
    */
-  ABSL_MUST_USE_RESULT SortedMap erase(const K& key) const {
+  ABSL_MUST_USE_RESULT SortedMap erase(const K& key) const& {
     switch (tag_) {
       case Tag::Array:
         return SortedMap{array_.erase(key)};
@@ -211,6 +268,24 @@ class SortedMap : public SortedMapBase {
     UNREACHABLE();
   }
 
+  /**
+   * Like `erase` above, but consumes this map, updating in place any parts of
+   * it that no other map shares.
+   */
+  ABSL_MUST_USE_RESULT SortedMap erase(const K& key) && {
+    switch (tag_) {
+      case Tag::Array:
+        return SortedMap{std::move(array_).erase(key)};
+      case Tag::Tree:
+        tree_type result = std::move(tree_).erase(key);
+        if (result.empty()) {
+          return SortedMap{result.comparator()};
+        }
+        return SortedMap{std::move(result)};
+    }
+    UNREACHABLE();
+  }
+
   bool contains(const K& key) const {
     switch (tag_) {
       case Tag::Array:
@@ -346,15 +421,6 @@ class SortedMap : public SortedMapBase {
     return impl::KeysViewIn(*this, start_key, end_key, comparator());
   }
 
- private:
-  explicit SortedMap(array_type&& array)
-      : tag_{Tag::Array}, array_{std::move(array)} {
-  }
-
-  explicit SortedMap(tree_type&& tree)
-      : tag_{Tag::Tree}, tree_{std::move(tree)} {
-  }
-
   const C& comparator() const {
     switch (tag_) {
       case Tag::Array:
@@ -365,6 +431,15 @@ class SortedMap : public SortedMapBase {
     UNREACHABLE();
   }
 
+ private:
+  explicit SortedMap(array_type&& array)
+      : tag_{Tag::Array}, array_{std::move(array)} {
+  }
+
+  explicit SortedMap(tree_type&& tree)
+      : tag_{Tag::Tree}, tree_{std::move(tree)} {
+  }
+
   enum class Tag {
     Array,
     Tree,
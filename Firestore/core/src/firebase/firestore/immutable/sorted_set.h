@@ -18,7 +18,9 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_SET_H_
 
 #include <algorithm>
+#include <cstdint>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
@@ -65,10 +67,21 @@ class SortedSet : public SortedContainer {
   SortedSet(std::initializer_list<value_type> entries, const C& comparator = {})
       : map_{comparator} {
     for (auto&& value : entries) {
-      map_ = map_.insert(value, {});
+      map_ = std::move(map_).insert(value, {});
     }
   }
 
+  /**
+   * Creates a SortedSet from a range of keys that is already sorted and
+   * contains no duplicates, in linear time.
+   */
+  template <typename Iterator>
+  static SortedSet FromSorted(Iterator begin,
+                              Iterator end,
+                              const C& comparator = {}) {
+    return SortedSet{M::FromSorted(begin, end, comparator)};
+  }
+
   bool empty() const {
     return map_.empty();
   }
@@ -77,14 +90,107 @@ class SortedSet : public SortedContainer {
     return map_.size();
   }
 
-  ABSL_MUST_USE_RESULT SortedSet insert(const K& key) const {
+  ABSL_MUST_USE_RESULT SortedSet insert(const K& key) const& {
     return SortedSet{map_.insert(key, {})};
   }
 
-  ABSL_MUST_USE_RESULT SortedSet erase(const K& key) const {
+  /**
+   * Like `insert` above, but consumes this set, updating in place any parts of
+   * it that no other set shares.
+   */
+  ABSL_MUST_USE_RESULT SortedSet insert(K key) && {
+    return SortedSet{std::move(map_).insert(std::move(key), {})};
+  }
+
+  ABSL_MUST_USE_RESULT SortedSet erase(const K& key) const& {
     return SortedSet{map_.erase(key)};
   }
 
+  /**
+   * Like `erase` above, but consumes this set, updating in place any parts of
+   * it that no other set shares.
+   */
+  ABSL_MUST_USE_RESULT SortedSet erase(const K& key) && {
+    return SortedSet{std::move(map_).erase(key)};
+  }
+
+  /**
+   * Returns a set containing the keys of both this set and `other`.
+   *
+   * When one set is much smaller than the other its keys are inserted into
+   * the larger one; otherwise both are merged in a single linear pass.
+   */
+  ABSL_MUST_USE_RESULT SortedSet union_with(const SortedSet& other) const {
+    const SortedSet& larger = size() >= other.size() ? *this : other;
+    const SortedSet& smaller = size() >= other.size() ? other : *this;
+    if (PreferIncremental(smaller.size(), larger.size())) {
+      SortedSet result = larger;
+      for (const K& key : smaller) {
+        result = std::move(result).insert(key);
+      }
+      return result;
+    }
+
+    const C& comparator = map_.comparator();
+    std::vector<K> merged;
+    merged.reserve(size() + other.size());
+    auto left = begin();
+    auto right = other.begin();
+    while (left != end() && right != other.end()) {
+      util::ComparisonResult cmp = comparator.Compare(*left, *right);
+      if (cmp == util::ComparisonResult::Ascending) {
+        merged.push_back(*left);
+        ++left;
+      } else if (cmp == util::ComparisonResult::Descending) {
+        merged.push_back(*right);
+        ++right;
+      } else {
+        merged.push_back(*left);
+        ++left;
+        ++right;
+      }
+    }
+    merged.insert(merged.end(), left, end());
+    merged.insert(merged.end(), right, other.end());
+    return FromSorted(merged.begin(), merged.end(), comparator);
+  }
+
+  /**
+   * Returns a set containing the keys of this set that are not in `other`.
+   *
+   * When `other` is much smaller than this set its keys are erased one at a
+   * time; otherwise both are walked in a single linear pass.
+   */
+  ABSL_MUST_USE_RESULT SortedSet difference_with(const SortedSet& other) const {
+    if (PreferIncremental(other.size(), size())) {
+      SortedSet result = *this;
+      for (const K& key : other) {
+        result = std::move(result).erase(key);
+      }
+      return result;
+    }
+
+    const C& comparator = map_.comparator();
+    std::vector<K> remaining;
+    remaining.reserve(size());
+    auto left = begin();
+    auto right = other.begin();
+    while (left != end() && right != other.end()) {
+      util::ComparisonResult cmp = comparator.Compare(*left, *right);
+      if (cmp == util::ComparisonResult::Ascending) {
+        remaining.push_back(*left);
+        ++left;
+      } else if (cmp == util::ComparisonResult::Descending) {
+        ++right;
+      } else {
+        ++left;
+        ++right;
+      }
+    }
+    remaining.insert(remaining.end(), left, end());
+    return FromSorted(remaining.begin(), remaining.end(), comparator);
+  }
+
   bool contains(const K& key) const {
     return map_.contains(key);
   }
@@ -143,12 +249,26 @@ class SortedSet : public SortedContainer {
   }
 
  private:
+  /**
+   * Returns true if applying `count` individual updates to a set of `size`
+   * keys is likely cheaper than rebuilding it: each update copies a path of
+   * roughly log2(size) nodes, while a rebuild touches every key once.
+   */
+  static bool PreferIncremental(size_type count, size_type size) {
+    uint64_t depth = 1;
+    for (size_type remaining = size; remaining > 1; remaining >>= 1) {
+      ++depth;
+    }
+    return count * depth < uint64_t{size} + count;
+  }
+
   M map_;
 };
 
-template <typename K, typename C, typename V>
-SortedSet<K, C, V> MakeSortedSet(const SortedMap<K, V, C>& map) {
-  return SortedSet<K, C, V>{map};
+template <typename K, typename C, typename V, SortedMapBase::size_type N>
+SortedSet<K, C, V, SortedMap<K, V, C, N>> MakeSortedSet(
+    const SortedMap<K, V, C, N>& map) {
+  return SortedSet<K, C, V, SortedMap<K, V, C, N>>{map};
 }
 
 }  // namespace immutable
@@ -69,11 +69,22 @@ class TreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
   static TreeSortedMap Create(const Range& range, const C& comparator) {
     node_type node;
     for (auto&& element : range) {
-      node = node.insert(element.first, element.second, comparator);
+      node = std::move(node).insert(element.first, element.second, comparator);
     }
     return TreeSortedMap{std::move(node), comparator};
   }
 
+  /**
+   * Creates a TreeSortedMap from a range of entries that is already sorted by
+   * key and contains no duplicate keys, in linear time.
+   */
+  template <typename Iterator>
+  static TreeSortedMap FromSorted(Iterator begin,
+                                  Iterator end,
+                                  const C& comparator) {
+    return TreeSortedMap{node_type::FromSorted(begin, end), comparator};
+  }
+
   /** Returns true if the map contains no elements. */
   bool empty() const {
     return root_.empty();
@@ -100,22 +111,42 @@ class TreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
    * @param value The value to associate with the key.
    * @return A new dictionary with the added/updated value.
    */
-  TreeSortedMap insert(const K& key, const V& value) const {
+  TreeSortedMap insert(const K& key, const V& value) const& {
     const C& comparator = this->comparator();
     return TreeSortedMap{root_.insert(key, value, comparator), comparator};
   }
 
+  /**
+   * Like `insert` above, but consumes this map, updating in place any nodes
+   * that no other map shares.
+   */
+  TreeSortedMap insert(K key, V value) && {
+    const C& comparator = this->comparator();
+    return TreeSortedMap{
+        std::move(root_).insert(std::move(key), std::move(value), comparator),
+        comparator};
+  }
+
   /**
    * Creates a new map identical to this one, but with a key removed from it.
    *
    * @param key The key to remove.
    * @return A new map without that value.
    */
-  TreeSortedMap erase(const K& key) const {
+  TreeSortedMap erase(const K& key) const& {
     const C& comparator = this->comparator();
     return TreeSortedMap{root_.erase(key, comparator), comparator};
   }
 
+  /**
+   * Like `erase` above, but consumes this map, updating in place any nodes
+   * that no other map shares.
+   */
+  TreeSortedMap erase(const K& key) && {
+    const C& comparator = this->comparator();
+    return TreeSortedMap{std::move(root_).erase(key, comparator), comparator};
+  }
+
   bool contains(const K& key) const {
     // Inline the tree traversal here to avoid building up the stack required
     // to construct a full iterator.
@@ -0,0 +1,269 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_document_compressor.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_set>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::DocumentKey;
+using model::ResourcePath;
+
+namespace {
+
+// A compressed value is the marker byte, the format version, the size of the
+// raw value as a little-endian uint32 and a raw deflate stream.
+constexpr char kCompressedMarker = '\0';
+constexpr char kFormatVersion = 1;
+constexpr size_t kHeaderSize = 6;
+
+// Raw deflate streams, without the zlib header and checksum; LevelDB already
+// checksums its blocks.
+constexpr int kWindowBits = -15;
+constexpr int kMemLevel = 8;
+
+// The length of the byte sequences compared across samples when training a
+// dictionary. Shorter sequences match by accident; longer ones miss short
+// field names.
+constexpr size_t kShingleSize = 8;
+
+const Bytef* ToBytes(absl::string_view bytes) {
+  return reinterpret_cast<const Bytef*>(bytes.data());
+}
+
+}  // namespace
+
+constexpr size_t LevelDbDocumentCompressor::kMinCompressedSize;
+constexpr size_t LevelDbDocumentCompressor::kDictionarySampleCount;
+constexpr size_t LevelDbDocumentCompressor::kMaxDictionarySize;
+
+bool LevelDbDocumentCompressor::IsCompressed(absl::string_view value) {
+  return !value.empty() && value[0] == kCompressedMarker;
+}
+
+std::string LevelDbDocumentCompressor::Compress(absl::string_view raw,
+                                                absl::string_view dictionary) {
+  z_stream stream{};
+  HARD_ASSERT(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                           kWindowBits, kMemLevel, Z_DEFAULT_STRATEGY) == Z_OK,
+              "Failed to initialize deflate");
+  HARD_ASSERT(deflateSetDictionary(&stream, ToBytes(dictionary),
+                                   static_cast<uInt>(dictionary.size())) ==
+                  Z_OK,
+              "Failed to set the compression dictionary");
+
+  auto raw_size = static_cast<uint32_t>(raw.size());
+  std::string result{kCompressedMarker, kFormatVersion};
+  for (int i = 0; i < 4; ++i) {
+    result.push_back(static_cast<char>((raw_size >> (8 * i)) & 0xff));
+  }
+  result.resize(kHeaderSize + deflateBound(&stream, raw.size()));
+
+  stream.next_in = const_cast<Bytef*>(ToBytes(raw));
+  stream.avail_in = static_cast<uInt>(raw.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&result[kHeaderSize]);
+  stream.avail_out = static_cast<uInt>(result.size() - kHeaderSize);
+  HARD_ASSERT(deflate(&stream, Z_FINISH) == Z_STREAM_END,
+              "Failed to compress a document");
+  result.resize(kHeaderSize + stream.total_out);
+  deflateEnd(&stream);
+  return result;
+}
+
+bool LevelDbDocumentCompressor::Decompress(absl::string_view value,
+                                           absl::string_view dictionary,
+                                           std::string* raw) {
+  if (value.size() < kHeaderSize || !IsCompressed(value) ||
+      value[1] != kFormatVersion) {
+    return false;
+  }
+  uint32_t raw_size = 0;
+  for (int i = 0; i < 4; ++i) {
+    raw_size |= static_cast<uint32_t>(static_cast<uint8_t>(value[2 + i]))
+                << (8 * i);
+  }
+  raw->resize(raw_size);
+
+  z_stream stream{};
+  if (inflateInit2(&stream, kWindowBits) != Z_OK) {
+    return false;
+  }
+  // Raw streams don't ask for their dictionary; it's set up front instead.
+  bool ok = inflateSetDictionary(&stream, ToBytes(dictionary),
+                                 static_cast<uInt>(dictionary.size())) == Z_OK;
+  if (ok) {
+    absl::string_view compressed = value.substr(kHeaderSize);
+    stream.next_in = const_cast<Bytef*>(ToBytes(compressed));
+    stream.avail_in = static_cast<uInt>(compressed.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&(*raw)[0]);
+    stream.avail_out = raw_size;
+    ok = inflate(&stream, Z_FINISH) == Z_STREAM_END &&
+         stream.total_out == raw_size;
+  }
+  inflateEnd(&stream);
+  return ok;
+}
+
+std::string LevelDbDocumentCompressor::TrainDictionary(
+    const std::vector<std::string>& samples) {
+  // Only the start of large samples is considered, which is where the field
+  // names of most documents are anyway.
+  auto prefix = [](const std::string& sample) {
+    return absl::string_view{sample}.substr(0, kMaxDictionarySize);
+  };
+
+  // The number of samples each sequence occurs in.
+  std::unordered_map<std::string, int> counts;
+  for (const std::string& sample : samples) {
+    absl::string_view bytes = prefix(sample);
+    std::unordered_set<std::string> seen;
+    for (size_t i = 0; i + kShingleSize <= bytes.size(); ++i) {
+      seen.emplace(bytes.substr(i, kShingleSize));
+    }
+    for (const std::string& shingle : seen) {
+      ++counts[shingle];
+    }
+  }
+
+  // Collect each maximal run of shared sequences once, along with the number
+  // of samples its least shared sequence occurs in.
+  struct Run {
+    std::string bytes;
+    int count;
+  };
+  std::vector<Run> runs;
+  std::unordered_set<std::string> taken;
+  auto is_shared = [&](absl::string_view shingle) {
+    std::string key{shingle};
+    return counts[key] >= 2 && taken.find(key) == taken.end();
+  };
+  for (const std::string& sample : samples) {
+    absl::string_view bytes = prefix(sample);
+    size_t i = 0;
+    while (i + kShingleSize <= bytes.size()) {
+      if (!is_shared(bytes.substr(i, kShingleSize))) {
+        ++i;
+        continue;
+      }
+      size_t start = i;
+      int count = static_cast<int>(samples.size());
+      for (; i + kShingleSize <= bytes.size() &&
+             is_shared(bytes.substr(i, kShingleSize));
+           ++i) {
+        std::string shingle{bytes.substr(i, kShingleSize)};
+        count = std::min(count, counts[shingle]);
+        taken.insert(std::move(shingle));
+      }
+      size_t length = i - start + kShingleSize - 1;
+      runs.push_back(Run{std::string{bytes.substr(start, length)}, count});
+    }
+  }
+
+  std::stable_sort(runs.begin(), runs.end(),
+                   [](const Run& lhs, const Run& rhs) {
+                     return lhs.count < rhs.count;
+                   });
+  std::string dictionary;
+  for (const Run& run : runs) {
+    dictionary += run.bytes;
+  }
+  if (dictionary.empty() && !samples.empty()) {
+    // Nothing is shared; the last sample is still the best guess.
+    dictionary = samples.back();
+  }
+  if (dictionary.size() > kMaxDictionarySize) {
+    dictionary.erase(0, dictionary.size() - kMaxDictionarySize);
+  }
+  return dictionary;
+}
+
+std::string LevelDbDocumentCompressor::Encode(LevelDbTransaction* transaction,
+                                              const DocumentKey& key,
+                                              std::string raw) {
+  if (raw.size() < kMinCompressedSize) {
+    return raw;
+  }
+
+  ResourcePath collection_path = key.path().PopLast();
+  const std::string& dictionary = GetDictionary(transaction, collection_path);
+  if (dictionary.empty()) {
+    std::string collection = collection_path.CanonicalString();
+    std::vector<std::string>& samples = samples_[collection];
+    samples.push_back(raw);
+    if (samples.size() >= kDictionarySampleCount) {
+      std::string trained = TrainDictionary(samples);
+      transaction->Put(LevelDbCompressionDictionaryKey::Key(collection_path),
+                       trained);
+      dictionaries_[collection] = std::move(trained);
+      samples_.erase(collection);
+    }
+    return raw;
+  }
+
+  std::string compressed = Compress(raw, dictionary);
+  return compressed.size() < raw.size() ? compressed : raw;
+}
+
+absl::string_view LevelDbDocumentCompressor::Decode(
+    LevelDbTransaction* transaction,
+    const DocumentKey& key,
+    absl::string_view value,
+    std::string* buffer) {
+  if (!IsCompressed(value)) {
+    return value;
+  }
+
+  const std::string& dictionary =
+      GetDictionary(transaction, key.path().PopLast());
+  HARD_ASSERT(!dictionary.empty(),
+              "Compressed document %s has no dictionary", key.ToString());
+  HARD_ASSERT(Decompress(value, dictionary, buffer),
+              "Failed to decompress document %s", key.ToString());
+  return *buffer;
+}
+
+const std::string& LevelDbDocumentCompressor::GetDictionary(
+    LevelDbTransaction* transaction, const ResourcePath& collection_path) {
+  std::string collection = collection_path.CanonicalString();
+  auto found = dictionaries_.find(collection);
+  if (found != dictionaries_.end()) {
+    return found->second;
+  }
+
+  std::string dictionary;
+  leveldb::Status status = transaction->Get(
+      LevelDbCompressionDictionaryKey::Key(collection_path), &dictionary);
+  HARD_ASSERT(status.ok() || status.IsNotFound(),
+              "Failed to read the compression dictionary of %s: %s",
+              collection, status.ToString());
+  return dictionaries_.emplace(std::move(collection), std::move(dictionary))
+      .first->second;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
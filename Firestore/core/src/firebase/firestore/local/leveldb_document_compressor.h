@@ -0,0 +1,131 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_DOCUMENT_COMPRESSOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_DOCUMENT_COMPRESSOR_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Compresses the values of remote document rows with zlib, using a preset
+ * dictionary for each collection.
+ *
+ * Documents in the same collection tend to repeat the same field names and
+ * many of the same values, which LevelDB's block compression can't exploit
+ * across documents. The first documents written to a collection are sampled
+ * and stored raw; once there are enough samples, a dictionary is trained from
+ * the bytes they have in common and saved, and later documents are compressed
+ * against it.
+ *
+ * A compressed value starts with a zero byte, which never starts an encoded
+ * `MaybeDocument` since protocol buffer field numbers start at one. Raw and
+ * compressed values can therefore be mixed freely, and compression can be
+ * turned on or off on an existing cache without a migration.
+ *
+ * An instance caches dictionaries and samples, so it must only be used by one
+ * thread at a time.
+ */
+class LevelDbDocumentCompressor {
+ public:
+  /** Values smaller than this are always stored raw. */
+  static constexpr size_t kMinCompressedSize = 256;
+
+  /** The number of documents sampled before a dictionary is trained. */
+  static constexpr size_t kDictionarySampleCount = 8;
+
+  /** The maximum size of a trained dictionary. */
+  static constexpr size_t kMaxDictionarySize = 16 * 1024;
+
+  /** Returns true if `value` was produced by `Compress`. */
+  static bool IsCompressed(absl::string_view value);
+
+  /**
+   * Compresses `raw` with the given dictionary, returning the compressed
+   * value, header included.
+   */
+  static std::string Compress(absl::string_view raw,
+                              absl::string_view dictionary);
+
+  /**
+   * Decompresses a value produced by `Compress` into `raw`.
+   *
+   * @return false if the value is corrupt or `dictionary` isn't the one it was
+   *     compressed with.
+   */
+  static bool Decompress(absl::string_view value,
+                         absl::string_view dictionary,
+                         std::string* raw);
+
+  /**
+   * Builds a dictionary out of the byte sequences that occur in at least two
+   * of the given samples, with the most widely shared ones last, where zlib
+   * finds them most cheaply.
+   */
+  static std::string TrainDictionary(const std::vector<std::string>& samples);
+
+  /**
+   * Returns the value to store for the document with the given key and raw
+   * encoding: compressed with the dictionary of the document's collection if
+   * it has one and that makes the value smaller, `raw` otherwise. May train
+   * and write the dictionary of the collection in `transaction`.
+   */
+  std::string Encode(LevelDbTransaction* transaction,
+                     const model::DocumentKey& key,
+                     std::string raw);
+
+  /**
+   * Returns the raw encoding of the document with the given key and stored
+   * `value`. Compressed values are decompressed into `buffer`, which must
+   * outlive the returned view; raw values are returned as is.
+   */
+  absl::string_view Decode(LevelDbTransaction* transaction,
+                           const model::DocumentKey& key,
+                           absl::string_view value,
+                           std::string* buffer);
+
+ private:
+  /**
+   * Returns the dictionary of the given collection, or an empty string if it
+   * doesn't have one yet.
+   */
+  const std::string& GetDictionary(LevelDbTransaction* transaction,
+                                   const model::ResourcePath& collection_path);
+
+  // Keyed by canonical collection path. Collections without a dictionary map
+  // to an empty string, so that they are only looked up once.
+  std::unordered_map<std::string, std::string> dictionaries_;
+
+  // Documents sampled from collections that don't have a dictionary yet,
+  // keyed by canonical collection path.
+  std::unordered_map<std::string, std::vector<std::string>> samples_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_DOCUMENT_COMPRESSOR_H_
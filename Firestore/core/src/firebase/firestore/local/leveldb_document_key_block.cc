@@ -0,0 +1,108 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_document_key_block.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using model::DocumentKey;
+using model::ResourcePath;
+
+void WriteVarint(size_t value, std::string* dest) {
+  while (value >= 0x80) {
+    dest->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  dest->push_back(static_cast<char>(value));
+}
+
+bool ReadVarint(absl::string_view* src, size_t* value) {
+  size_t result = 0;
+  for (int shift = 0; shift < 64 && !src->empty(); shift += 7) {
+    auto byte = static_cast<uint8_t>(src->front());
+    src->remove_prefix(1);
+    result |= static_cast<size_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+std::string LevelDbDocumentKeyBlock::Encode(
+    const std::vector<DocumentKey>& keys) {
+  std::string result;
+  std::string previous;
+  for (const DocumentKey& key : keys) {
+    std::string path = key.path().CanonicalString();
+    size_t max_shared = std::min(previous.size(), path.size());
+    auto mismatch = std::mismatch(path.begin(), path.begin() + max_shared,
+                                  previous.begin());
+    auto shared = static_cast<size_t>(mismatch.first - path.begin());
+
+    WriteVarint(shared, &result);
+    WriteVarint(path.size() - shared, &result);
+    result.append(path, shared, std::string::npos);
+    previous = std::move(path);
+  }
+  return result;
+}
+
+bool LevelDbDocumentKeyBlock::Decode(absl::string_view block,
+                                     std::vector<DocumentKey>* keys) {
+  std::string path;
+  while (!block.empty()) {
+    size_t shared = 0;
+    size_t unshared = 0;
+    if (!ReadVarint(&block, &shared) || !ReadVarint(&block, &unshared) ||
+        shared > path.size() || unshared > block.size()) {
+      return false;
+    }
+
+    path.resize(shared);
+    path.append(block.data(), unshared);
+    block.remove_prefix(unshared);
+
+    if (path.empty() || path.front() == '/' || path.back() == '/' ||
+        path.find("//") != std::string::npos) {
+      return false;
+    }
+    ResourcePath resource_path = ResourcePath::FromString(path);
+    if (!DocumentKey::IsDocumentKey(resource_path)) {
+      return false;
+    }
+    keys->push_back(DocumentKey{std::move(resource_path)});
+  }
+  return true;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
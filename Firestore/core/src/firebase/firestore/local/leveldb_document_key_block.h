@@ -0,0 +1,59 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_DOCUMENT_KEY_BLOCK_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_DOCUMENT_KEY_BLOCK_H_
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Encodes sorted runs of document keys compactly, for storing many keys in a
+ * single LevelDB row.
+ *
+ * Each key is written as the number of leading bytes its path shares with the
+ * previous key, followed by the length and bytes of the rest of its path, as
+ * varints. Keys of the same collection mostly differ in their last segment, so
+ * this stores little more than the document IDs.
+ */
+class LevelDbDocumentKeyBlock {
+ public:
+  /** Encodes the given keys, which should be sorted for best compression. */
+  static std::string Encode(const std::vector<model::DocumentKey>& keys);
+
+  /**
+   * Decodes a block written by `Encode`, appending its keys to `keys`.
+   *
+   * @return true if the block was decoded successfully, false if it was
+   * malformed, in which case the contents of `keys` are unspecified.
+   */
+  static bool Decode(absl::string_view block,
+                     std::vector<model::DocumentKey>* keys);
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_DOCUMENT_KEY_BLOCK_H_
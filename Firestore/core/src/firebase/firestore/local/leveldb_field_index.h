@@ -0,0 +1,117 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_FIELD_INDEX_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_FIELD_INDEX_H_
+
+#if !defined(__OBJC__)
+#error "For now, this file must only be included by ObjC source files."
+#endif  // !defined(__OBJC__)
+
+#import <Foundation/Foundation.h>
+
+#include <set>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+
+@class FSTDocument;
+@class FSTFieldValue;
+@class FSTLevelDB;
+@class FSTQuery;
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * A persistent secondary index over the remote document cache, mapping
+ * (collection, field path, value) to the documents holding that value.
+ *
+ * Values are written in an order-preserving binary encoding so equality
+ * filters become prefix scans and inequality filters become range scans. The
+ * encoding is deliberately lossy in places (integers are widened to doubles,
+ * arrays and objects only record their type and long values are truncated),
+ * so the index may return extra documents but never omits one that could
+ * match. Callers are expected to re-filter the documents they read.
+ *
+ * Collections are indexed lazily: the first query against a collection that
+ * could use the index does a full scan and writes index entries for every
+ * document it visits. From then on the collection is marked as indexed and
+ * its entries are maintained as documents are added and removed.
+ */
+class LevelDbFieldIndex {
+ public:
+  explicit LevelDbFieldIndex(FSTLevelDB* db);
+
+  /**
+   * Returns true if the query has a filter or an explicit order by that the
+   * index can use to narrow down the documents in the query's collection.
+   */
+  static bool CanServeQuery(FSTQuery* query);
+
+  /**
+   * Returns the order-preserving index encoding of the given value. Exposed
+   * for testing.
+   */
+  static std::string EncodeValue(FSTFieldValue* value);
+
+  /**
+   * Returns true if every document in the collection has been written to the
+   * index.
+   */
+  bool IsCollectionIndexed(const model::ResourcePath& collection_path);
+
+  /**
+   * Records that every document in the collection has been written to the
+   * index. From now on, the index must be kept up to date on every change.
+   */
+  void MarkCollectionIndexed(const model::ResourcePath& collection_path);
+
+  /** Writes index entries for all fields of the given document. */
+  void AddEntries(FSTDocument* document);
+
+  /** Deletes the index entries previously written for the given document. */
+  void RemoveEntries(FSTDocument* document);
+
+  /**
+   * Returns the keys of the documents that may match the query, according to
+   * the index. Must only be called if `CanServeQuery(query)` and the query's
+   * collection is indexed.
+   */
+  model::DocumentKeySet GetMatchingKeys(FSTQuery* query);
+
+ private:
+  // This instance is owned by FSTLevelDB; avoid a retain cycle.
+  __weak FSTLevelDB* db_;
+
+  /**
+   * The collections known to be indexed. Collections are never un-indexed
+   * while the SDK is running, so only positive results are cached.
+   */
+  std::set<model::ResourcePath> indexed_collections_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_FIELD_INDEX_H_
@@ -0,0 +1,371 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_field_index.h"
+
+#import <Foundation/Foundation.h>
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#import "FIRGeoPoint.h"
+#import "FIRTimestamp.h"
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Local/FSTLevelDB.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTDocumentKey.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "absl/strings/match.h"
+#include "absl/types/optional.h"
+#include "leveldb/db.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using core::Filter;
+using leveldb::Status;
+using model::DocumentKey;
+using model::DocumentKeySet;
+using model::FieldPath;
+using model::FieldValue;
+using model::ResourcePath;
+using util::OrderedCode;
+
+namespace {
+
+/**
+ * Encoded values longer than this are truncated. Truncating a byte string
+ * preserves (non-strict) ordering, so this can only add candidates, never
+ * drop them.
+ */
+const size_t kMaxIndexValueLength = 512;
+
+const uint64_t kSignBit = 1ULL << 63;
+
+/**
+ * Writes a double such that the encoded bytes sort in numeric order. NaN sorts
+ * before all other numbers, matching Firestore's ordering, and -0.0 is encoded
+ * like 0.0 since the two compare equal.
+ */
+void WriteDouble(std::string* dest, double value) {
+  uint64_t bits = 0;
+  if (!std::isnan(value)) {
+    if (value == 0) {
+      value = 0;
+    }
+    std::memcpy(&bits, &value, sizeof(bits));
+    bits = (bits & kSignBit) ? ~bits : bits | kSignBit;
+  }
+  OrderedCode::WriteNumIncreasing(dest, bits);
+}
+
+void WriteTypeOrder(std::string* dest, FSTTypeOrder type_order) {
+  OrderedCode::WriteSignedNumIncreasing(dest, type_order);
+}
+
+/** A range of encoded values to scan for a single field path. */
+struct IndexRange {
+  FieldPath field_path;
+
+  /** The scan starts at the first entry with a value >= start. */
+  std::string start;
+
+  /** The scan visits values that start with prefix... */
+  std::string prefix;
+
+  /** ... and, if set, are <= end. */
+  absl::optional<std::string> end;
+};
+
+IndexRange EqualityRange(const FieldPath& field_path, FSTFieldValue* value) {
+  std::string encoded = LevelDbFieldIndex::EncodeValue(value);
+  return IndexRange{field_path, encoded, encoded, absl::nullopt};
+}
+
+absl::optional<IndexRange> RangeForFilter(FSTFilter* filter) {
+  if (filter.field.IsKeyFieldPath()) {
+    return absl::nullopt;
+  }
+
+  if ([filter isKindOfClass:[FSTNullFilter class]]) {
+    return EqualityRange(filter.field, [FSTNullValue nullValue]);
+  } else if ([filter isKindOfClass:[FSTNanFilter class]]) {
+    return EqualityRange(filter.field, [FSTDoubleValue nanValue]);
+  } else if (![filter isKindOfClass:[FSTRelationFilter class]]) {
+    return absl::nullopt;
+  }
+
+  auto relation = static_cast<FSTRelationFilter*>(filter);
+  std::string type_prefix;
+  WriteTypeOrder(&type_prefix, relation.value.typeOrder);
+  std::string encoded = LevelDbFieldIndex::EncodeValue(relation.value);
+
+  switch (relation.filterOperator) {
+    case Filter::Operator::Equal:
+      return EqualityRange(relation.field, relation.value);
+
+    // Bounds are always inclusive: the encoding is lossy, so values that
+    // encode equal to the bound may still match.
+    case Filter::Operator::LessThan:
+    case Filter::Operator::LessThanOrEqual:
+      return IndexRange{relation.field, type_prefix, type_prefix, encoded};
+
+    case Filter::Operator::GreaterThan:
+    case Filter::Operator::GreaterThanOrEqual:
+      return IndexRange{relation.field, encoded, type_prefix, absl::nullopt};
+
+    case Filter::Operator::ArrayContains:
+      // Array elements are not indexed.
+      return absl::nullopt;
+  }
+  UNREACHABLE();
+}
+
+/**
+ * Picks the most selective range the index can serve for the query: an
+ * equality filter if there is one, otherwise an inequality filter, otherwise
+ * the first explicit order by (which restricts results to documents that have
+ * the field at all).
+ */
+absl::optional<IndexRange> RangeForQuery(FSTQuery* query) {
+  absl::optional<IndexRange> inequality;
+  for (FSTFilter* filter in query.filters) {
+    absl::optional<IndexRange> range = RangeForFilter(filter);
+    if (!range) {
+      continue;
+    }
+    if (range->prefix == range->start && !range->end) {
+      return range;
+    }
+    if (!inequality) {
+      inequality = std::move(range);
+    }
+  }
+  if (inequality) {
+    return inequality;
+  }
+
+  NSArray<FSTSortOrder*>* sort_orders = query.explicitSortOrders;
+  if (sort_orders.count > 0 && !sort_orders[0].field.IsKeyFieldPath()) {
+    return IndexRange{sort_orders[0].field, "", "", absl::nullopt};
+  }
+  return absl::nullopt;
+}
+
+/**
+ * Collects the encoded value of every field in the object, recursing into
+ * nested objects. Arrays are indexed as a whole but their elements are not.
+ */
+void CollectEntries(FSTObjectValue* object,
+                    const FieldPath& parent,
+                    std::vector<std::pair<FieldPath, std::string>>* entries) {
+  for (const auto& entry : object.internalValue) {
+    FSTFieldValue* value = entry.second;
+    FieldPath field_path = parent.Append(util::MakeString(entry.first));
+    entries->emplace_back(field_path, LevelDbFieldIndex::EncodeValue(value));
+    if (value.type == FieldValue::Type::Object) {
+      CollectEntries(static_cast<FSTObjectValue*>(value), field_path, entries);
+    }
+  }
+}
+
+std::vector<std::pair<FieldPath, std::string>> EntriesForDocument(
+    FSTDocument* document) {
+  std::vector<std::pair<FieldPath, std::string>> entries;
+  CollectEntries(document.data, FieldPath::EmptyPath(), &entries);
+  return entries;
+}
+
+}  // namespace
+
+LevelDbFieldIndex::LevelDbFieldIndex(FSTLevelDB* db) : db_(db) {
+}
+
+bool LevelDbFieldIndex::CanServeQuery(FSTQuery* query) {
+  return RangeForQuery(query).has_value();
+}
+
+std::string LevelDbFieldIndex::EncodeValue(FSTFieldValue* value) {
+  std::string result;
+  WriteTypeOrder(&result, value.typeOrder);
+
+  switch (value.type) {
+    case FieldValue::Type::Null:
+      break;
+
+    case FieldValue::Type::Boolean: {
+      bool boolean_value =
+          static_cast<FSTDelegateValue*>(value).internalValue.boolean_value();
+      OrderedCode::WriteNumIncreasing(&result, boolean_value ? 1 : 0);
+      break;
+    }
+
+    case FieldValue::Type::Integer:
+      // Widening to double keeps the relative order of integers and doubles
+      // at the cost of some precision for integers beyond 2^53.
+      WriteDouble(&result, static_cast<double>(
+                               static_cast<FSTIntegerValue*>(value).internalValue));
+      break;
+
+    case FieldValue::Type::Double:
+      WriteDouble(&result, static_cast<FSTDoubleValue*>(value).internalValue);
+      break;
+
+    case FieldValue::Type::Timestamp: {
+      FIRTimestamp* timestamp = static_cast<FSTTimestampValue*>(value).value;
+      OrderedCode::WriteSignedNumIncreasing(&result, timestamp.seconds);
+      OrderedCode::WriteSignedNumIncreasing(&result, timestamp.nanoseconds);
+      break;
+    }
+
+    case FieldValue::Type::String:
+      OrderedCode::WriteString(
+          &result,
+          static_cast<FSTDelegateValue*>(value).internalValue.string_value());
+      break;
+
+    case FieldValue::Type::Blob: {
+      NSData* data = static_cast<FSTBlobValue*>(value).value;
+      OrderedCode::WriteString(
+          &result, absl::string_view{static_cast<const char*>(data.bytes),
+                                     data.length});
+      break;
+    }
+
+    case FieldValue::Type::Reference: {
+      auto reference = static_cast<FSTReferenceValue*>(value);
+      OrderedCode::WriteString(&result, reference.databaseID->project_id());
+      OrderedCode::WriteString(&result, reference.databaseID->database_id());
+      for (const std::string& segment : reference.value.key.path()) {
+        OrderedCode::WriteString(&result, segment);
+      }
+      break;
+    }
+
+    case FieldValue::Type::GeoPoint: {
+      FIRGeoPoint* geo_point = static_cast<FSTGeoPointValue*>(value).value;
+      WriteDouble(&result, geo_point.latitude);
+      WriteDouble(&result, geo_point.longitude);
+      break;
+    }
+
+    // Server timestamps never reach the remote document cache. Arrays and
+    // objects are only indexed by type: all arrays (and all objects) encode
+    // the same, which is enough to answer filters and order bys on them.
+    case FieldValue::Type::ServerTimestamp:
+    case FieldValue::Type::Array:
+    case FieldValue::Type::Object:
+      break;
+  }
+
+  if (result.size() > kMaxIndexValueLength) {
+    result.resize(kMaxIndexValueLength);
+  }
+  return result;
+}
+
+bool LevelDbFieldIndex::IsCollectionIndexed(
+    const ResourcePath& collection_path) {
+  if (indexed_collections_.find(collection_path) !=
+      indexed_collections_.end()) {
+    return true;
+  }
+
+  std::string key = LevelDbIndexedCollectionKey::Key(collection_path);
+  std::string value;
+  Status status = db_.currentTransaction->Get(key, &value);
+  if (status.IsNotFound()) {
+    return false;
+  } else if (!status.ok()) {
+    HARD_FAIL("Fetch indexed collection (%s) failed with status: %s",
+              collection_path.CanonicalString(), status.ToString());
+  }
+
+  indexed_collections_.insert(collection_path);
+  return true;
+}
+
+void LevelDbFieldIndex::MarkCollectionIndexed(
+    const ResourcePath& collection_path) {
+  std::string empty_buffer;
+  db_.currentTransaction->Put(
+      LevelDbIndexedCollectionKey::Key(collection_path), empty_buffer);
+  indexed_collections_.insert(collection_path);
+}
+
+void LevelDbFieldIndex::AddEntries(FSTDocument* document) {
+  std::string empty_buffer;
+  for (const auto& entry : EntriesForDocument(document)) {
+    db_.currentTransaction->Put(
+        LevelDbFieldIndexKey::Key(entry.first, entry.second, document.key),
+        empty_buffer);
+  }
+}
+
+void LevelDbFieldIndex::RemoveEntries(FSTDocument* document) {
+  for (const auto& entry : EntriesForDocument(document)) {
+    db_.currentTransaction->Delete(
+        LevelDbFieldIndexKey::Key(entry.first, entry.second, document.key));
+  }
+}
+
+DocumentKeySet LevelDbFieldIndex::GetMatchingKeys(FSTQuery* query) {
+  absl::optional<IndexRange> range = RangeForQuery(query);
+  HARD_ASSERT(range.has_value(), "Query %s cannot be served by the index",
+              util::MakeString(query.canonicalID));
+
+  const ResourcePath& collection_path = query.path;
+  std::string field_prefix =
+      LevelDbFieldIndexKey::KeyPrefix(collection_path, range->field_path);
+
+  DocumentKeySet result;
+  auto it = db_.currentTransaction->NewIterator();
+  LevelDbFieldIndexKey row_key;
+  for (it->Seek(LevelDbFieldIndexKey::KeyPrefix(
+           collection_path, range->field_path, range->start));
+       it->Valid() && absl::StartsWith(it->key(), field_prefix); it->Next()) {
+    if (!row_key.Decode(it->key())) {
+      break;
+    }
+
+    const std::string& index_value = row_key.index_value();
+    if (!absl::StartsWith(index_value, range->prefix) ||
+        (range->end && index_value > *range->end)) {
+      break;
+    }
+    result = std::move(result).insert(row_key.document_key());
+  }
+  return result;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
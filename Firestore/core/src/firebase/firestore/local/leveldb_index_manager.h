@@ -48,6 +48,15 @@ class LevelDbIndexManager : public IndexManager {
       const std::string& collection_id) override;
 
  private:
+  /**
+   * Adds to `results` the parents of collections with the given ID that
+   * contain a document or a mutation, for use while the backfill of the
+   * collection parents index is still pending.
+   */
+  void AddUnindexedCollectionParents(
+      const std::string& collection_id,
+      std::vector<model::ResourcePath>* results);
+
   // This instance is owned by FSTLevelDB; avoid a retain cycle.
   __weak FSTLevelDB* db_;
 
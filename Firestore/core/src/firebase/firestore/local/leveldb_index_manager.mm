@@ -16,10 +16,12 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_index_manager.h"
 
+#include <set>
 #include <string>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_index_manager.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -33,8 +35,26 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
+using model::DocumentKey;
 using model::ResourcePath;
 
+namespace {
+
+/**
+ * Adds the parent of the collection containing `key` to `parents` if the
+ * collection has the given ID.
+ */
+void AddParentIfInGroup(const DocumentKey& key,
+                        const std::string& collection_id,
+                        std::set<ResourcePath>* parents) {
+  const ResourcePath& path = key.path();
+  if (path[path.size() - 2] == collection_id) {
+    parents->insert(path.PopLast().PopLast());
+  }
+}
+
+}  // namespace
+
 LevelDbIndexManager::LevelDbIndexManager(FSTLevelDB* db) : db_(db) {
 }
 
@@ -71,9 +91,46 @@ std::vector<ResourcePath> LevelDbIndexManager::GetCollectionParents(
 
     results.push_back(row_key.parent());
   }
+
+  if (LevelDbMigrations::IsBackfillPending(
+          db_.currentTransaction,
+          LevelDbMigrations::kCollectionParentsMigration)) {
+    AddUnindexedCollectionParents(collection_id, &results);
+  }
   return results;
 }
 
+void LevelDbIndexManager::AddUnindexedCollectionParents(
+    const std::string& collection_id, std::vector<ResourcePath>* results) {
+  std::set<ResourcePath> parents(results->begin(), results->end());
+  size_t indexed = parents.size();
+
+  auto it = db_.currentTransaction->NewIterator();
+  std::string documents_prefix = LevelDbRemoteDocumentKey::KeyPrefix();
+  LevelDbRemoteDocumentKey document_key;
+  for (it->Seek(documents_prefix);
+       it->Valid() && absl::StartsWith(it->key(), documents_prefix);
+       it->Next()) {
+    HARD_ASSERT(document_key.Decode(it->key()),
+                "Failed to decode document key");
+    AddParentIfInGroup(document_key.document_key(), collection_id, &parents);
+  }
+
+  std::string mutations_prefix = LevelDbDocumentMutationKey::KeyPrefix();
+  LevelDbDocumentMutationKey mutation_key;
+  for (it->Seek(mutations_prefix);
+       it->Valid() && absl::StartsWith(it->key(), mutations_prefix);
+       it->Next()) {
+    HARD_ASSERT(mutation_key.Decode(it->key()),
+                "Failed to decode document-mutation key");
+    AddParentIfInGroup(mutation_key.document_key(), collection_id, &parents);
+  }
+
+  if (parents.size() > indexed) {
+    results->assign(parents.begin(), parents.end());
+  }
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
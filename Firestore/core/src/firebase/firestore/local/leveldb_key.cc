@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 
+#include <algorithm>
+#include <deque>
 #include <utility>
 #include <vector>
 
@@ -23,10 +25,12 @@
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
 #include "absl/base/attributes.h"
 #include "absl/strings/escaping.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::ResourcePath;
+using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::util::OrderedCode;
 
 namespace firebase {
@@ -38,14 +42,62 @@ namespace {
 const char* kVersionGlobalTable = "version";
 const char* kMutationsTable = "mutation";
 const char* kDocumentMutationsTable = "document_mutation";
+const char* kCollectionMutationsTable = "collection_mutation";
 const char* kMutationQueuesTable = "mutation_queue";
 const char* kTargetGlobalTable = "target_global";
 const char* kTargetsTable = "target";
 const char* kQueryTargetsTable = "query_target";
 const char* kTargetDocumentsTable = "target_document";
+const char* kTargetDocumentBlocksTable = "target_document_block";
 const char* kDocumentTargetsTable = "document_target";
 const char* kRemoteDocumentsTable = "remote_document";
 const char* kCollectionParentsTable = "collection_parent";
+const char* kCollectionGroupDocumentsTable = "collection_group_document";
+const char* kFieldIndexTable = "field_index";
+const char* kIndexedCollectionsTable = "indexed_collection";
+const char* kCollectionGroupSizesTable = "collection_group_size";
+const char* kPendingMigrationsTable = "pending_migration";
+const char* kWarmSnapshotsTable = "warm_snapshot";
+const char* kWarmSnapshotGlobalTable = "warm_snapshot_global";
+const char* kRemoteDocumentReadTimesTable = "remote_document_read_time";
+const char* kDocumentReadTimesTable = "document_read_time";
+const char* kCompressionDictionariesTable = "compression_dictionary";
+
+/**
+ * Short tags that identify the tables with the most rows in place of their
+ * names. Many of these rows have empty values, so the table name used to be
+ * most of their size.
+ */
+enum TaggedTable {
+  RemoteDocuments = 1,
+  DocumentTargets = 2,
+  TargetDocuments = 3,
+};
+
+/** Returns the name of the table with the given tag, or nullptr. */
+const char* TableTagName(int32_t table_tag) {
+  switch (table_tag) {
+    case TaggedTable::RemoteDocuments:
+      return kRemoteDocumentsTable;
+    case TaggedTable::DocumentTargets:
+      return kDocumentTargetsTable;
+    case TaggedTable::TargetDocuments:
+      return kTargetDocumentsTable;
+    default:
+      return nullptr;
+  }
+}
+
+// The range of seconds a Timestamp can represent, 0001-01-01 up to but
+// excluding 10000-01-01.
+constexpr int64_t kMinTimestampSeconds = -62135596800L;
+constexpr int64_t kMaxTimestampSeconds = 253402300800L;
+constexpr int64_t kNanosPerSecond = 1000000000L;
+
+// The kinds of target document blocks. Bounded blocks sort before the
+// unbounded one.
+constexpr int32_t kBoundedBlock = 0;
+constexpr int32_t kUnboundedBlock = 1;
 
 /**
  * Labels for the components of keys. These serve to make keys self-describing.
@@ -96,6 +148,39 @@ enum ComponentLabel {
    */
   CollectionId = 14,
 
+  /** A component containing the canonical form of a field path. */
+  FieldPath = 15,
+
+  /** A component containing an index-encoded field value. */
+  IndexValue = 16,
+
+  /**
+   * A component containing a standalone document ID (e.g. as used by the
+   * field_index table, where the collection path is written separately).
+   */
+  DocumentId = 17,
+
+  /** A component containing the schema version of a migration. */
+  SchemaVersion = 18,
+
+  /**
+   * A component distinguishing the blocks of a target's document keys that are
+   * bounded by a document key from the unbounded block that follows them.
+   */
+  BlockKind = 19,
+
+  /**
+   * A component containing the snapshot version at which a document was read
+   * into the remote document cache, as seconds followed by nanoseconds.
+   */
+  ReadTime = 20,
+
+  /**
+   * A table tag component identifies the logical table by its TaggedTable
+   * value, in place of a table name component.
+   */
+  TableTag = 21,
+
   /**
    * A path segment describes just a single segment in a resource path. Path
    * segments that occur sequentially in a key represent successive segments in
@@ -150,6 +235,23 @@ class Reader {
     }
   }
 
+  /**
+   * Reads the table component of a tagged table, accepting either its tag or,
+   * for keys written before the tag was introduced, its name.
+   */
+  void ReadTableMatching(TaggedTable expected_table,
+                         const char* expected_table_name) {
+    leveldb::Slice saved_position = src_;
+    if (ReadComponentLabelMatching(ComponentLabel::TableTag)) {
+      if (ReadInt32() != expected_table) {
+        Fail();
+      }
+      return;
+    }
+    src_ = saved_position;
+    ReadTableNameMatching(expected_table_name);
+  }
+
   model::BatchId ReadBatchId() {
     return ReadLabeledInt32(ComponentLabel::BatchId);
   }
@@ -170,6 +272,63 @@ class Reader {
     return ReadLabeledString(ComponentLabel::CollectionId);
   }
 
+  std::string ReadFieldPath() {
+    return ReadLabeledString(ComponentLabel::FieldPath);
+  }
+
+  std::string ReadIndexValue() {
+    return ReadLabeledString(ComponentLabel::IndexValue);
+  }
+
+  std::string ReadDocumentId() {
+    return ReadLabeledString(ComponentLabel::DocumentId);
+  }
+
+  int32_t ReadSchemaVersion() {
+    return ReadLabeledInt32(ComponentLabel::SchemaVersion);
+  }
+
+  int32_t ReadBlockKind() {
+    return ReadLabeledInt32(ComponentLabel::BlockKind);
+  }
+
+  int32_t ReadTableTag() {
+    return ReadLabeledInt32(ComponentLabel::TableTag);
+  }
+
+  /**
+   * Reads a component label and a snapshot version from the key and verifies
+   * that the label is ComponentLabel::ReadTime and the version is within the
+   * range of a Timestamp.
+   *
+   * If the read is unsuccessful, returns SnapshotVersion::None() and fails the
+   * Reader.
+   */
+  model::SnapshotVersion ReadReadTime() {
+    if (!ReadComponentLabelMatching(ComponentLabel::ReadTime)) {
+      Fail();
+    }
+    int64_t seconds = ReadSignedNumIncreasing();
+    int64_t nanos = ReadSignedNumIncreasing();
+    if (ok_ && seconds >= kMinTimestampSeconds &&
+        seconds < kMaxTimestampSeconds && nanos >= 0 &&
+        nanos < kNanosPerSecond) {
+      return model::SnapshotVersion{
+          Timestamp{seconds, static_cast<int32_t>(nanos)}};
+    }
+
+    Fail();
+    return model::SnapshotVersion::None();
+  }
+
+  /** Like ReadDocumentId, but skips over the ID without decoding it. */
+  void SkipDocumentId() {
+    if (!ReadComponentLabelMatching(ComponentLabel::DocumentId)) {
+      Fail();
+    }
+    SkipString();
+  }
+
   /**
    * Reads component labels and strings from the key until it finds a component
    * label other than ComponentLabel::PathSegment (or the key is exhausted).
@@ -177,11 +336,20 @@ class Reader {
    */
   ResourcePath ReadResourcePath();
 
+  /**
+   * Like ReadResourcePath, but instead of copying each segment, appends a view
+   * of it in the key to `segments`. Segments containing escaped bytes can't be
+   * viewed in place; those are unescaped into new entries of `unescaped`,
+   * which the views then point into.
+   */
+  void ReadResourcePathViews(std::vector<absl::string_view>* segments,
+                             std::deque<std::string>* unescaped);
+
   /**
    * Reads component labels and strings from the key until it finds a component
    * label other than ComponentLabel::PathSegment (or the key is exhausted).
    * All matched path segments are assembled into a ResourcePath and wrapped in
-   * a DocumentKey.
+   * an interned DocumentKey.
    *
    * If the read is unsuccessful or the document key is invalid, returns a
    * default DocumentKey and fails the Reader.
@@ -237,6 +405,47 @@ class Reader {
     return "";
   }
 
+  /**
+   * Like ReadString, but returns a view of the string in the key if it
+   * contains no escaped bytes, and otherwise a view of its unescaped copy
+   * appended to `unescaped`.
+   */
+  absl::string_view ReadStringView(std::deque<std::string>* unescaped) {
+    if (ok_) {
+      absl::string_view tmp = MakeStringView(src_);
+      if (OrderedCode::ReadString(&tmp, nullptr)) {
+        // The encoded string is followed by a two byte separator, and only
+        // contains special bytes if some of its characters were escaped.
+        absl::string_view result{src_.data(), src_.size() - tmp.size() - 2};
+        if (result.find('\0') != absl::string_view::npos ||
+            result.find('\xff') != absl::string_view::npos) {
+          unescaped->emplace_back();
+          absl::string_view encoded = MakeStringView(src_);
+          OrderedCode::ReadString(&encoded, &unescaped->back());
+          result = unescaped->back();
+        }
+        src_ = MakeSlice(tmp);
+        return result;
+      }
+    }
+
+    Fail();
+    return "";
+  }
+
+  /** Like ReadString, but discards the string. */
+  void SkipString() {
+    if (ok_) {
+      absl::string_view tmp = MakeStringView(src_);
+      if (OrderedCode::ReadString(&tmp, nullptr)) {
+        src_ = MakeSlice(tmp);
+        return;
+      }
+    }
+
+    Fail();
+  }
+
   /**
    * Reads a component label from the key.
    *
@@ -396,12 +605,28 @@ ResourcePath Reader::ReadResourcePath() {
   return ResourcePath{std::move(path_segments)};
 }
 
+void Reader::ReadResourcePathViews(std::vector<absl::string_view>* segments,
+                                   std::deque<std::string>* unescaped) {
+  while (!empty()) {
+    leveldb::Slice saved_position = src_;
+    if (!ReadComponentLabelMatching(ComponentLabel::PathSegment)) {
+      src_ = saved_position;
+      break;
+    }
+
+    absl::string_view segment = ReadStringView(unescaped);
+    if (!ok_) break;
+
+    segments->push_back(segment);
+  }
+}
+
 DocumentKey Reader::ReadDocumentKey() {
   ResourcePath path = ReadResourcePath();
 
   // Avoid assertion failures in DocumentKey if path is invalid.
   if (ok_ && !path.empty() && DocumentKey::IsDocumentKey(path)) {
-    return DocumentKey{std::move(path)};
+    return DocumentKey::Interned(std::move(path));
   }
 
   Fail();
@@ -455,6 +680,14 @@ std::string Reader::Describe() {
         absl::StrAppend(&description, table, ":");
       }
 
+    } else if (label == ComponentLabel::TableTag) {
+      const char* table = TableTagName(ReadTableTag());
+      if (ok_ && table) {
+        absl::StrAppend(&description, table, ":");
+      } else {
+        Fail();
+      }
+
     } else if (label == ComponentLabel::BatchId) {
       model::BatchId batch_id = ReadBatchId();
       if (ok_) {
@@ -485,6 +718,45 @@ std::string Reader::Describe() {
         absl::StrAppend(&description, " collection_id=", collection_id);
       }
 
+    } else if (label == ComponentLabel::FieldPath) {
+      std::string field_path = ReadFieldPath();
+      if (ok_) {
+        absl::StrAppend(&description, " field_path=", field_path);
+      }
+
+    } else if (label == ComponentLabel::IndexValue) {
+      std::string index_value = ReadIndexValue();
+      if (ok_) {
+        absl::StrAppend(&description,
+                        " index_value=", absl::CHexEscape(index_value));
+      }
+
+    } else if (label == ComponentLabel::DocumentId) {
+      std::string document_id = ReadDocumentId();
+      if (ok_) {
+        absl::StrAppend(&description, " document_id=", document_id);
+      }
+
+    } else if (label == ComponentLabel::SchemaVersion) {
+      int32_t schema_version = ReadSchemaVersion();
+      if (ok_) {
+        absl::StrAppend(&description, " schema_version=", schema_version);
+      }
+
+    } else if (label == ComponentLabel::BlockKind) {
+      int32_t block_kind = ReadBlockKind();
+      if (ok_) {
+        absl::StrAppend(&description, " block_kind=", block_kind);
+      }
+
+    } else if (label == ComponentLabel::ReadTime) {
+      model::SnapshotVersion read_time = ReadReadTime();
+      if (ok_) {
+        absl::StrAppend(&description,
+                        " read_time=", read_time.timestamp().seconds(), ".",
+                        read_time.timestamp().nanoseconds());
+      }
+
     } else {
       absl::StrAppend(&description, " unknown label=", static_cast<int>(label));
       Fail();
@@ -504,18 +776,37 @@ std::string Reader::Describe() {
 
 class Writer {
  public:
-  std::string result() const {
-    return dest_;
+  Writer() : dest_{&owned_} {
+  }
+
+  /**
+   * Creates a Writer that writes into `dest`, replacing its contents, so that
+   * callers encoding many keys can reuse a single buffer.
+   */
+  explicit Writer(std::string* dest) : dest_{dest} {
+    dest_->clear();
+  }
+
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  /** Returns the key written by a Writer that owns its buffer. */
+  std::string result() {
+    return std::move(owned_);
   }
 
   void WriteTerminator() {
-    OrderedCode::WriteSignedNumIncreasing(&dest_, ComponentLabel::Terminator);
+    OrderedCode::WriteSignedNumIncreasing(dest_, ComponentLabel::Terminator);
   }
 
   void WriteTableName(const char* table_name) {
     WriteLabeledString(ComponentLabel::TableName, table_name);
   }
 
+  void WriteTableTag(TaggedTable table) {
+    WriteLabeledInt32(ComponentLabel::TableTag, table);
+  }
+
   void WriteBatchId(model::BatchId batch_id) {
     WriteLabeledInt32(ComponentLabel::BatchId, batch_id);
   }
@@ -536,22 +827,57 @@ class Writer {
     WriteLabeledString(ComponentLabel::CollectionId, collection_id);
   }
 
+  void WriteFieldPath(const model::FieldPath& field_path) {
+    WriteLabeledString(ComponentLabel::FieldPath,
+                       field_path.CanonicalString());
+  }
+
+  void WriteIndexValue(absl::string_view index_value) {
+    WriteLabeledString(ComponentLabel::IndexValue, index_value);
+  }
+
+  void WriteDocumentId(absl::string_view document_id) {
+    WriteLabeledString(ComponentLabel::DocumentId, document_id);
+  }
+
+  void WriteSchemaVersion(int32_t schema_version) {
+    WriteLabeledInt32(ComponentLabel::SchemaVersion, schema_version);
+  }
+
+  void WriteBlockKind(int32_t block_kind) {
+    WriteLabeledInt32(ComponentLabel::BlockKind, block_kind);
+  }
+
+  void WriteReadTime(const model::SnapshotVersion& read_time) {
+    WriteComponentLabel(ComponentLabel::ReadTime);
+    OrderedCode::WriteSignedNumIncreasing(dest_,
+                                          read_time.timestamp().seconds());
+    OrderedCode::WriteSignedNumIncreasing(dest_,
+                                          read_time.timestamp().nanoseconds());
+  }
+
   /**
    * For each segment in the given resource path writes a
    * ComponentLabel::PathSegment component label and a string containing the
    * path segment.
    */
   void WriteResourcePath(const ResourcePath& path) {
-    for (const auto& segment : path) {
+    WriteResourcePath(path.begin(), path.end());
+  }
+
+  /** Like the above, but writes only the segments in [begin, end). */
+  void WriteResourcePath(ResourcePath::const_iterator begin,
+                         ResourcePath::const_iterator end) {
+    for (auto it = begin; it != end; ++it) {
       WriteComponentLabel(ComponentLabel::PathSegment);
-      OrderedCode::WriteString(&dest_, segment);
+      OrderedCode::WriteString(dest_, *it);
     }
   }
 
  private:
   /** Writes a component label to the given key destination. */
   void WriteComponentLabel(ComponentLabel label) {
-    OrderedCode::WriteSignedNumIncreasing(&dest_, label);
+    OrderedCode::WriteSignedNumIncreasing(dest_, label);
   }
 
   /**
@@ -559,7 +885,7 @@ class Writer {
    */
   void WriteLabeledInt32(ComponentLabel label, int32_t value) {
     WriteComponentLabel(label);
-    OrderedCode::WriteSignedNumIncreasing(&dest_, value);
+    OrderedCode::WriteSignedNumIncreasing(dest_, value);
   }
 
   /**
@@ -568,10 +894,11 @@ class Writer {
    */
   void WriteLabeledString(ComponentLabel label, absl::string_view value) {
     WriteComponentLabel(label);
-    OrderedCode::WriteString(&dest_, value);
+    OrderedCode::WriteString(dest_, value);
   }
 
-  std::string dest_;
+  std::string owned_;
+  std::string* dest_;
 };
 
 }  // namespace
@@ -657,13 +984,21 @@ std::string LevelDbDocumentMutationKey::KeyPrefix(
 std::string LevelDbDocumentMutationKey::Key(absl::string_view user_id,
                                             const DocumentKey& document_key,
                                             model::BatchId batch_id) {
-  Writer writer;
+  std::string result;
+  Key(user_id, document_key, batch_id, &result);
+  return result;
+}
+
+void LevelDbDocumentMutationKey::Key(absl::string_view user_id,
+                                     const DocumentKey& document_key,
+                                     model::BatchId batch_id,
+                                     std::string* dest) {
+  Writer writer{dest};
   writer.WriteTableName(kDocumentMutationsTable);
   writer.WriteUserId(user_id);
   writer.WriteResourcePath(document_key.path());
   writer.WriteBatchId(batch_id);
   writer.WriteTerminator();
-  return writer.result();
 }
 
 bool LevelDbDocumentMutationKey::Decode(absl::string_view key) {
@@ -676,6 +1011,85 @@ bool LevelDbDocumentMutationKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbCollectionMutationKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::KeyPrefix(
+    absl::string_view user_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::KeyPrefix(
+    absl::string_view user_id, const ResourcePath& collection_path) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  writer.WriteResourcePath(collection_path);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::Key(absl::string_view user_id,
+                                              const DocumentKey& document_key,
+                                              model::BatchId batch_id) {
+  std::string result;
+  Key(user_id, document_key, batch_id, &result);
+  return result;
+}
+
+void LevelDbCollectionMutationKey::Key(absl::string_view user_id,
+                                       const DocumentKey& document_key,
+                                       model::BatchId batch_id,
+                                       std::string* dest) {
+  const ResourcePath& path = document_key.path();
+  Writer writer{dest};
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  writer.WriteResourcePath(path.begin(), path.end() - 1);
+  writer.WriteBatchId(batch_id);
+  writer.WriteDocumentId(path.last_segment());
+  writer.WriteTerminator();
+}
+
+bool LevelDbCollectionMutationKey::DecodeBatchId(absl::string_view key,
+                                                 absl::string_view key_prefix,
+                                                 model::BatchId* batch_id) {
+  if (!absl::StartsWith(key, key_prefix)) {
+    return false;
+  }
+
+  // Rows for documents in subcollections have a path segment where rows for
+  // immediate children have the batch_id, which fails the read.
+  Reader reader{key.substr(key_prefix.size())};
+  *batch_id = reader.ReadBatchId();
+  reader.SkipDocumentId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+bool LevelDbCollectionMutationKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kCollectionMutationsTable);
+  user_id_ = reader.ReadUserId();
+  ResourcePath collection_path = reader.ReadResourcePath();
+  batch_id_ = reader.ReadBatchId();
+  std::string document_id = reader.ReadDocumentId();
+  reader.ReadTerminator();
+
+  // Avoid assertion failures in DocumentKey if the path is invalid.
+  ResourcePath document_path = collection_path.Append(document_id);
+  if (!reader.ok() || !DocumentKey::IsDocumentKey(document_path)) {
+    return false;
+  }
+  document_key_ = DocumentKey::Interned(std::move(document_path));
+  return true;
+}
+
 std::string LevelDbMutationQueueKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kMutationQueuesTable);
@@ -767,6 +1181,12 @@ bool LevelDbQueryTargetKey::Decode(absl::string_view key) {
 }
 
 std::string LevelDbTargetDocumentKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableTag(TaggedTable::TargetDocuments);
+  return writer.result();
+}
+
+std::string LevelDbTargetDocumentKey::LegacyKeyPrefix() {
   Writer writer;
   writer.WriteTableName(kTargetDocumentsTable);
   return writer.result();
@@ -774,7 +1194,7 @@ std::string LevelDbTargetDocumentKey::KeyPrefix() {
 
 std::string LevelDbTargetDocumentKey::KeyPrefix(model::TargetId target_id) {
   Writer writer;
-  writer.WriteTableName(kTargetDocumentsTable);
+  writer.WriteTableTag(TaggedTable::TargetDocuments);
   writer.WriteTargetId(target_id);
   return writer.result();
 }
@@ -782,7 +1202,7 @@ std::string LevelDbTargetDocumentKey::KeyPrefix(model::TargetId target_id) {
 std::string LevelDbTargetDocumentKey::Key(model::TargetId target_id,
                                           const DocumentKey& document_key) {
   Writer writer;
-  writer.WriteTableName(kTargetDocumentsTable);
+  writer.WriteTableTag(TaggedTable::TargetDocuments);
   writer.WriteTargetId(target_id);
   writer.WriteResourcePath(document_key.path());
   writer.WriteTerminator();
@@ -791,14 +1211,73 @@ std::string LevelDbTargetDocumentKey::Key(model::TargetId target_id,
 
 bool LevelDbTargetDocumentKey::Decode(absl::string_view key) {
   Reader reader{key};
-  reader.ReadTableNameMatching(kTargetDocumentsTable);
+  reader.ReadTableMatching(TaggedTable::TargetDocuments, kTargetDocumentsTable);
   target_id_ = reader.ReadTargetId();
   document_key_ = reader.ReadDocumentKey();
   reader.ReadTerminator();
   return reader.ok();
 }
 
+std::string LevelDbTargetDocumentBlockKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kTargetDocumentBlocksTable);
+  return writer.result();
+}
+
+std::string LevelDbTargetDocumentBlockKey::KeyPrefix(
+    model::TargetId target_id) {
+  Writer writer;
+  writer.WriteTableName(kTargetDocumentBlocksTable);
+  writer.WriteTargetId(target_id);
+  return writer.result();
+}
+
+std::string LevelDbTargetDocumentBlockKey::Key(
+    model::TargetId target_id, const DocumentKey& upper_bound) {
+  Writer writer;
+  writer.WriteTableName(kTargetDocumentBlocksTable);
+  writer.WriteTargetId(target_id);
+  writer.WriteBlockKind(kBoundedBlock);
+  writer.WriteResourcePath(upper_bound.path());
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+std::string LevelDbTargetDocumentBlockKey::UnboundedKey(
+    model::TargetId target_id) {
+  Writer writer;
+  writer.WriteTableName(kTargetDocumentBlocksTable);
+  writer.WriteTargetId(target_id);
+  writer.WriteBlockKind(kUnboundedBlock);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbTargetDocumentBlockKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kTargetDocumentBlocksTable);
+  target_id_ = reader.ReadTargetId();
+  int32_t block_kind = reader.ReadBlockKind();
+  if (block_kind == kBoundedBlock) {
+    bounded_ = true;
+    upper_bound_ = reader.ReadDocumentKey();
+  } else if (block_kind == kUnboundedBlock) {
+    bounded_ = false;
+    upper_bound_ = DocumentKey{};
+  } else {
+    return false;
+  }
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 std::string LevelDbDocumentTargetKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableTag(TaggedTable::DocumentTargets);
+  return writer.result();
+}
+
+std::string LevelDbDocumentTargetKey::LegacyKeyPrefix() {
   Writer writer;
   writer.WriteTableName(kDocumentTargetsTable);
   return writer.result();
@@ -807,7 +1286,7 @@ std::string LevelDbDocumentTargetKey::KeyPrefix() {
 std::string LevelDbDocumentTargetKey::KeyPrefix(
     const ResourcePath& resource_path) {
   Writer writer;
-  writer.WriteTableName(kDocumentTargetsTable);
+  writer.WriteTableTag(TaggedTable::DocumentTargets);
   writer.WriteResourcePath(resource_path);
   return writer.result();
 }
@@ -815,7 +1294,7 @@ std::string LevelDbDocumentTargetKey::KeyPrefix(
 std::string LevelDbDocumentTargetKey::Key(const DocumentKey& document_key,
                                           model::TargetId target_id) {
   Writer writer;
-  writer.WriteTableName(kDocumentTargetsTable);
+  writer.WriteTableTag(TaggedTable::DocumentTargets);
   writer.WriteResourcePath(document_key.path());
   writer.WriteTargetId(target_id);
   writer.WriteTerminator();
@@ -845,7 +1324,7 @@ model::ListenSequenceNumber LevelDbDocumentTargetKey::DecodeSentinelValue(
 
 bool LevelDbDocumentTargetKey::Decode(absl::string_view key) {
   Reader reader{key};
-  reader.ReadTableNameMatching(kDocumentTargetsTable);
+  reader.ReadTableMatching(TaggedTable::DocumentTargets, kDocumentTargetsTable);
   document_key_ = reader.ReadDocumentKey();
   target_id_ = reader.ReadTargetId();
   reader.ReadTerminator();
@@ -853,6 +1332,12 @@ bool LevelDbDocumentTargetKey::Decode(absl::string_view key) {
 }
 
 std::string LevelDbRemoteDocumentKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableTag(TaggedTable::RemoteDocuments);
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentKey::LegacyKeyPrefix() {
   Writer writer;
   writer.WriteTableName(kRemoteDocumentsTable);
   return writer.result();
@@ -861,22 +1346,27 @@ std::string LevelDbRemoteDocumentKey::KeyPrefix() {
 std::string LevelDbRemoteDocumentKey::KeyPrefix(
     const ResourcePath& resource_path) {
   Writer writer;
-  writer.WriteTableName(kRemoteDocumentsTable);
+  writer.WriteTableTag(TaggedTable::RemoteDocuments);
   writer.WriteResourcePath(resource_path);
   return writer.result();
 }
 
 std::string LevelDbRemoteDocumentKey::Key(const DocumentKey& key) {
-  Writer writer;
-  writer.WriteTableName(kRemoteDocumentsTable);
+  std::string result;
+  Key(key, &result);
+  return result;
+}
+
+void LevelDbRemoteDocumentKey::Key(const DocumentKey& key, std::string* dest) {
+  Writer writer{dest};
+  writer.WriteTableTag(TaggedTable::RemoteDocuments);
   writer.WriteResourcePath(key.path());
   writer.WriteTerminator();
-  return writer.result();
 }
 
 bool LevelDbRemoteDocumentKey::Decode(absl::string_view key) {
   Reader reader{key};
-  reader.ReadTableNameMatching(kRemoteDocumentsTable);
+  reader.ReadTableMatching(TaggedTable::RemoteDocuments, kRemoteDocumentsTable);
   document_key_ = reader.ReadDocumentKey();
   reader.ReadTerminator();
   return reader.ok();
@@ -906,6 +1396,33 @@ std::string LevelDbCollectionParentKey::Key(absl::string_view collection_id,
   return writer.result();
 }
 
+bool LevelDbRemoteDocumentKeyView::Decode(absl::string_view key) {
+  segments_.clear();
+  unescaped_.clear();
+
+  Reader reader{key};
+  reader.ReadTableMatching(TaggedTable::RemoteDocuments, kRemoteDocumentsTable);
+  reader.ReadResourcePathViews(&segments_, &unescaped_);
+  reader.ReadTerminator();
+  // Like `DocumentKey::IsDocumentKey`.
+  return reader.ok() && !segments_.empty() && segments_.size() % 2 == 0;
+}
+
+bool LevelDbRemoteDocumentKeyView::HasPrefix(const ResourcePath& prefix) const {
+  if (prefix.size() > segments_.size()) {
+    return false;
+  }
+  return std::equal(prefix.begin(), prefix.end(), segments_.begin(),
+                    [](const std::string& lhs, absl::string_view rhs) {
+                      return lhs == rhs;
+                    });
+}
+
+DocumentKey LevelDbRemoteDocumentKeyView::ToDocumentKey() const {
+  return DocumentKey::Interned(
+      ResourcePath{segments_.begin(), segments_.end()});
+}
+
 bool LevelDbCollectionParentKey::Decode(absl::string_view key) {
   Reader reader{key};
   reader.ReadTableNameMatching(kCollectionParentsTable);
@@ -915,6 +1432,377 @@ bool LevelDbCollectionParentKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbCollectionGroupDocumentKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kCollectionGroupDocumentsTable);
+  return writer.result();
+}
+
+std::string LevelDbCollectionGroupDocumentKey::KeyPrefix(
+    absl::string_view collection_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionGroupDocumentsTable);
+  writer.WriteCollectionId(collection_id);
+  return writer.result();
+}
+
+std::string LevelDbCollectionGroupDocumentKey::Key(
+    const DocumentKey& document_key) {
+  const ResourcePath& path = document_key.path();
+  Writer writer;
+  writer.WriteTableName(kCollectionGroupDocumentsTable);
+  writer.WriteCollectionId(path[path.size() - 2]);
+  writer.WriteResourcePath(path);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbCollectionGroupDocumentKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kCollectionGroupDocumentsTable);
+  collection_id_ = reader.ReadCollectionId();
+  document_key_ = reader.ReadDocumentKey();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbFieldIndexKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexTable);
+  return writer.result();
+}
+
+std::string LevelDbFieldIndexKey::KeyPrefix(
+    const ResourcePath& collection_path, const model::FieldPath& field_path) {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexTable);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteFieldPath(field_path);
+  return writer.result();
+}
+
+std::string LevelDbFieldIndexKey::KeyPrefix(
+    const ResourcePath& collection_path,
+    const model::FieldPath& field_path,
+    absl::string_view index_value) {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexTable);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteFieldPath(field_path);
+  writer.WriteIndexValue(index_value);
+  return writer.result();
+}
+
+std::string LevelDbFieldIndexKey::Key(const model::FieldPath& field_path,
+                                      absl::string_view index_value,
+                                      const DocumentKey& document_key) {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexTable);
+  writer.WriteResourcePath(document_key.path().PopLast());
+  writer.WriteFieldPath(field_path);
+  writer.WriteIndexValue(index_value);
+  writer.WriteDocumentId(document_key.path().last_segment());
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbFieldIndexKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kFieldIndexTable);
+  ResourcePath collection_path = reader.ReadResourcePath();
+  field_path_ = reader.ReadFieldPath();
+  index_value_ = reader.ReadIndexValue();
+  std::string document_id = reader.ReadDocumentId();
+  reader.ReadTerminator();
+
+  // Avoid assertion failures in DocumentKey if the path is invalid.
+  ResourcePath document_path = collection_path.Append(document_id);
+  if (!reader.ok() || !DocumentKey::IsDocumentKey(document_path)) {
+    return false;
+  }
+  document_key_ = DocumentKey{std::move(document_path)};
+  return true;
+}
+
+std::string LevelDbIndexedCollectionKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kIndexedCollectionsTable);
+  return writer.result();
+}
+
+std::string LevelDbIndexedCollectionKey::Key(
+    const ResourcePath& collection_path) {
+  Writer writer;
+  writer.WriteTableName(kIndexedCollectionsTable);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbIndexedCollectionKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kIndexedCollectionsTable);
+  collection_path_ = reader.ReadResourcePath();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbCollectionGroupSizeKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kCollectionGroupSizesTable);
+  return writer.result();
+}
+
+std::string LevelDbCollectionGroupSizeKey::Key(
+    absl::string_view collection_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionGroupSizesTable);
+  writer.WriteCollectionId(collection_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+std::string LevelDbCollectionGroupSizeKey::EncodeSize(int64_t size) {
+  std::string encoded;
+  OrderedCode::WriteSignedNumIncreasing(&encoded, size);
+  return encoded;
+}
+
+int64_t LevelDbCollectionGroupSizeKey::DecodeSize(absl::string_view encoded) {
+  int64_t decoded;
+  if (!OrderedCode::ReadSignedNumIncreasing(&encoded, &decoded)) {
+    HARD_FAIL("Failed to read size from a collection group size row");
+  }
+  return decoded;
+}
+
+bool LevelDbCollectionGroupSizeKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kCollectionGroupSizesTable);
+  collection_id_ = reader.ReadCollectionId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbPendingMigrationKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kPendingMigrationsTable);
+  return writer.result();
+}
+
+std::string LevelDbPendingMigrationKey::Key(int32_t schema_version) {
+  Writer writer;
+  writer.WriteTableName(kPendingMigrationsTable);
+  writer.WriteSchemaVersion(schema_version);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+std::string LevelDbPendingMigrationKey::EncodeProgress(
+    int64_t rows_processed, absl::string_view last_key) {
+  std::string encoded;
+  OrderedCode::WriteSignedNumIncreasing(&encoded, rows_processed);
+  OrderedCode::WriteString(&encoded, last_key);
+  return encoded;
+}
+
+bool LevelDbPendingMigrationKey::DecodeProgress(absl::string_view encoded,
+                                                int64_t* rows_processed,
+                                                std::string* last_key) {
+  return OrderedCode::ReadSignedNumIncreasing(&encoded, rows_processed) &&
+         OrderedCode::ReadString(&encoded, last_key) && encoded.empty();
+}
+
+bool LevelDbPendingMigrationKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kPendingMigrationsTable);
+  schema_version_ = reader.ReadSchemaVersion();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbWarmSnapshotKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kWarmSnapshotsTable);
+  return writer.result();
+}
+
+std::string LevelDbWarmSnapshotKey::Key(model::TargetId target_id) {
+  Writer writer;
+  writer.WriteTableName(kWarmSnapshotsTable);
+  writer.WriteTargetId(target_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbWarmSnapshotKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kWarmSnapshotsTable);
+  target_id_ = reader.ReadTargetId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbWarmSnapshotGlobalKey::Key() {
+  Writer writer;
+  writer.WriteTableName(kWarmSnapshotGlobalTable);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+std::string LevelDbWarmSnapshotGlobalKey::EncodeTargetIds(
+    const std::vector<model::TargetId>& target_ids) {
+  std::string encoded;
+  for (model::TargetId target_id : target_ids) {
+    OrderedCode::WriteSignedNumIncreasing(&encoded, target_id);
+  }
+  return encoded;
+}
+
+bool LevelDbWarmSnapshotGlobalKey::DecodeTargetIds(
+    absl::string_view encoded, std::vector<model::TargetId>* target_ids) {
+  target_ids->clear();
+  while (!encoded.empty()) {
+    int64_t target_id;
+    if (!OrderedCode::ReadSignedNumIncreasing(&encoded, &target_id)) {
+      return false;
+    }
+    target_ids->push_back(static_cast<model::TargetId>(target_id));
+  }
+  return true;
+}
+
+bool LevelDbWarmSnapshotGlobalKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kWarmSnapshotGlobalTable);
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbRemoteDocumentReadTimeKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentReadTimesTable);
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentReadTimeKey::KeyPrefix(
+    const ResourcePath& collection_path) {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentReadTimesTable);
+  writer.WriteResourcePath(collection_path);
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentReadTimeKey::KeyPrefix(
+    const ResourcePath& collection_path, const SnapshotVersion& read_time) {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentReadTimesTable);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteReadTime(read_time);
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentReadTimeKey::Key(
+    const DocumentKey& document_key, const SnapshotVersion& read_time) {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentReadTimesTable);
+  writer.WriteResourcePath(document_key.path().PopLast());
+  writer.WriteReadTime(read_time);
+  writer.WriteDocumentId(document_key.path().last_segment());
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbRemoteDocumentReadTimeKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kRemoteDocumentReadTimesTable);
+  ResourcePath collection_path = reader.ReadResourcePath();
+  read_time_ = reader.ReadReadTime();
+  std::string document_id = reader.ReadDocumentId();
+  reader.ReadTerminator();
+
+  // Avoid assertion failures in DocumentKey if the path is invalid.
+  ResourcePath document_path = collection_path.Append(document_id);
+  if (!reader.ok() || !DocumentKey::IsDocumentKey(document_path)) {
+    return false;
+  }
+  document_key_ = DocumentKey{std::move(document_path)};
+  return true;
+}
+
+std::string LevelDbDocumentReadTimeKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kDocumentReadTimesTable);
+  return writer.result();
+}
+
+std::string LevelDbDocumentReadTimeKey::Key(const DocumentKey& document_key) {
+  Writer writer;
+  writer.WriteTableName(kDocumentReadTimesTable);
+  writer.WriteResourcePath(document_key.path());
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+std::string LevelDbDocumentReadTimeKey::EncodeReadTime(
+    const SnapshotVersion& read_time) {
+  std::string encoded;
+  OrderedCode::WriteSignedNumIncreasing(&encoded,
+                                        read_time.timestamp().seconds());
+  OrderedCode::WriteSignedNumIncreasing(&encoded,
+                                        read_time.timestamp().nanoseconds());
+  return encoded;
+}
+
+bool LevelDbDocumentReadTimeKey::DecodeReadTime(absl::string_view encoded,
+                                                SnapshotVersion* read_time) {
+  int64_t seconds;
+  int64_t nanos;
+  if (!OrderedCode::ReadSignedNumIncreasing(&encoded, &seconds) ||
+      !OrderedCode::ReadSignedNumIncreasing(&encoded, &nanos) ||
+      !encoded.empty()) {
+    return false;
+  }
+  if (seconds < kMinTimestampSeconds || seconds >= kMaxTimestampSeconds ||
+      nanos < 0 || nanos >= kNanosPerSecond) {
+    return false;
+  }
+  *read_time =
+      SnapshotVersion{Timestamp{seconds, static_cast<int32_t>(nanos)}};
+  return true;
+}
+
+bool LevelDbDocumentReadTimeKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kDocumentReadTimesTable);
+  document_key_ = reader.ReadDocumentKey();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbCompressionDictionaryKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kCompressionDictionariesTable);
+  return writer.result();
+}
+
+std::string LevelDbCompressionDictionaryKey::Key(
+    const ResourcePath& collection_path) {
+  Writer writer;
+  writer.WriteTableName(kCompressionDictionariesTable);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbCompressionDictionaryKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kCompressionDictionariesTable);
+  collection_path_ = reader.ReadResourcePath();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -17,10 +17,14 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_KEY_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_KEY_H_
 
+#include <deque>
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "absl/strings/string_view.h"
 #include "leveldb/slice.h"
@@ -48,6 +52,13 @@ namespace local {
 //   - path: ResourcePath
 //   - batch_id: model::BatchId
 //
+// collection_mutations:
+//   - table_name: string = "collection_mutation"
+//   - user_id: string
+//   - collection: ResourcePath
+//   - batch_id: model::BatchId
+//   - document_id: string
+//
 // mutation_queues:
 //   - table_name: string = "mutation_queue"
 //   - user_id: string
@@ -65,23 +76,73 @@ namespace local {
 //   - target_id: model::TargetId
 //
 // target_documents:
-//   - table_name: string = "target_document"
+//   - table_tag: int32_t = 3, or table_name: string = "target_document"
+//     before schema version 13
 //   - target_id: model::TargetId
 //   - path: ResourcePath
 //
+// target_document_blocks:
+//   - table_name: string = "target_document_block"
+//   - target_id: model::TargetId
+//   - block_kind: int32_t
+//   - upper_bound: ResourcePath, only for bounded blocks
+//
 // document_targets:
-//   - table_name: string = "document_target"
+//   - table_tag: int32_t = 2, or table_name: string = "document_target"
+//     before schema version 13
 //   - path: ResourcePath
 //   - target_id: model::TargetId
 //
 // remote_documents:
-//   - table_name: string = "remote_document"
+//   - table_tag: int32_t = 1, or table_name: string = "remote_document"
+//     before schema version 13
 //   - path: ResourcePath
 //
 // collection_parents:
 //   - table_name: string = "collection_parent"
 //   - collectionId: string
 //   - parent: ResourcePath
+//
+// collection_group_documents:
+//   - table_name: string = "collection_group_document"
+//   - collectionId: string
+//   - path: ResourcePath
+//
+// field_index:
+//   - table_name: string = "field_index"
+//   - collection: ResourcePath
+//   - field_path: string
+//   - index_value: string
+//   - document_id: string
+//
+// indexed_collections:
+//   - table_name: string = "indexed_collection"
+//   - collection: ResourcePath
+//
+// warm_snapshots:
+//   - table_name: string = "warm_snapshot"
+//   - target_id: model::TargetId
+//
+// warm_snapshot_globals:
+//   - table_name: string = "warm_snapshot_global"
+//
+// remote_document_read_times:
+//   - table_name: string = "remote_document_read_time"
+//   - collection: ResourcePath
+//   - read_time: model::SnapshotVersion
+//   - document_id: string
+//
+// document_read_times:
+//   - table_name: string = "document_read_time"
+//   - path: ResourcePath
+//
+// compression_dictionaries:
+//   - table_name: string = "compression_dictionary"
+//   - collection: ResourcePath
+//
+// The tables with the most rows, whose keys would otherwise be mostly table
+// name, are identified by a short numeric tag instead. Decode() accepts keys
+// in either format, so that rows can be migrated in place.
 
 /**
  * Parses the given key and returns a human readable description of its
@@ -182,6 +243,88 @@ class LevelDbDocumentMutationKey {
                          const model::DocumentKey& document_key,
                          model::BatchId batch_id);
 
+  /** Like `Key()`, but replaces the contents of `dest` with the key. */
+  static void Key(absl::string_view user_id,
+                  const model::DocumentKey& document_key,
+                  model::BatchId batch_id,
+                  std::string* dest);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The user that owns the mutation batches. */
+  const std::string& user_id() const {
+    return user_id_;
+  }
+
+  /** The path to the document, as encoded in the key. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+  /** The batch_id in which the document participates. */
+  model::BatchId batch_id() const {
+    return batch_id_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  std::string user_id_;
+  model::DocumentKey document_key_;
+  model::BatchId batch_id_;
+};
+
+/**
+ * A key in the collection mutations index, which stores the batches in which
+ * the immediate children of a collection are mutated.
+ *
+ * Unlike the document mutations index, rows for documents in subcollections
+ * are not stored under their ancestor collections, so a scan over a collection
+ * only visits its direct children. Rows are ordered by batch_id within a
+ * collection.
+ */
+class LevelDbCollectionMutationKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * user_id.
+   */
+  static std::string KeyPrefix(absl::string_view user_id);
+
+  /**
+   * Creates a key prefix that points just before the first key for the user_id
+   * and the collection containing the documents.
+   */
+  static std::string KeyPrefix(absl::string_view user_id,
+                               const model::ResourcePath& collection_path);
+
+  /**
+   * Creates a complete key that points to a specific user_id, document key,
+   * and batch_id.
+   */
+  static std::string Key(absl::string_view user_id,
+                         const model::DocumentKey& document_key,
+                         model::BatchId batch_id);
+
+  /** Like `Key()`, but replaces the contents of `dest` with the key. */
+  static void Key(absl::string_view user_id,
+                  const model::DocumentKey& document_key,
+                  model::BatchId batch_id,
+                  std::string* dest);
+
   /**
    * Decodes the given complete key, storing the decoded values in this
    * instance.
@@ -193,6 +336,19 @@ class LevelDbDocumentMutationKey {
   ABSL_MUST_USE_RESULT
   bool Decode(absl::string_view key);
 
+  /**
+   * Decodes just the batch_id of `key`, which must start with `key_prefix`,
+   * the result of `KeyPrefix(user_id, collection_path)`. Unlike `Decode()`, it
+   * doesn't copy the path or user_id out of the key.
+   *
+   * @return true if `key` is a complete key for an immediate child of the
+   * collection, false otherwise (including for documents in subcollections).
+   */
+  ABSL_MUST_USE_RESULT
+  static bool DecodeBatchId(absl::string_view key,
+                            absl::string_view key_prefix,
+                            model::BatchId* batch_id);
+
   /** The user that owns the mutation batches. */
   const std::string& user_id() const {
     return user_id_;
@@ -363,6 +519,12 @@ class LevelDbTargetDocumentKey {
    */
   static std::string KeyPrefix();
 
+  /**
+   * Creates a key prefix that points just before the first key of the table
+   * as written before schema version 13, which spelled out the table name.
+   */
+  static std::string LegacyKeyPrefix();
+
   /**
    * Creates a key that points to the first target-document association for a
    * target_id.
@@ -400,6 +562,70 @@ class LevelDbTargetDocumentKey {
   model::DocumentKey document_key_;
 };
 
+/**
+ * A key in the target document blocks table, an alternative to the target
+ * documents table that stores the document keys of a target in blocks of many
+ * keys each, encoded by `LevelDbDocumentKeyBlock`.
+ *
+ * The blocks of a target cover consecutive ranges of document keys. Each
+ * bounded block is keyed by the largest key it may contain, and holds the
+ * keys after the bound of the previous block up to its own. The unbounded
+ * block, which sorts after all bounded ones, holds the keys after the last
+ * bound. Seeking to `Key(target_id, document_key)` therefore finds the block
+ * that `document_key` belongs in, unless it belongs in a missing unbounded
+ * block.
+ */
+class LevelDbTargetDocumentBlockKey {
+ public:
+  /**
+   * Creates a key that contains just the target document blocks table prefix
+   * and points just before the first key.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a key that points to the first block of a target_id. */
+  static std::string KeyPrefix(model::TargetId target_id);
+
+  /** Creates a key that points to the block bounded by `upper_bound`. */
+  static std::string Key(model::TargetId target_id,
+                         const model::DocumentKey& upper_bound);
+
+  /** Creates a key that points to the unbounded block of a target_id. */
+  static std::string UnboundedKey(model::TargetId target_id);
+
+  /**
+   * Decodes the contents of a target document block key, storing the decoded
+   * values in this instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The target_id identifying a target. */
+  model::TargetId target_id() const {
+    return target_id_;
+  }
+
+  /** Whether the block is bounded by `upper_bound()`. */
+  bool bounded() const {
+    return bounded_;
+  }
+
+  /** The largest document key the block may contain, if it is bounded. */
+  const model::DocumentKey& upper_bound() const {
+    return upper_bound_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::TargetId target_id_;
+  bool bounded_;
+  model::DocumentKey upper_bound_;
+};
+
 /**
  * A key in the document targets table, an index from documents to the targets
  * that contain them.
@@ -412,6 +638,12 @@ class LevelDbDocumentTargetKey {
    */
   static std::string KeyPrefix();
 
+  /**
+   * Creates a key prefix that points just before the first key of the table
+   * as written before schema version 13, which spelled out the table name.
+   */
+  static std::string LegacyKeyPrefix();
+
   /**
    * Creates a key that points to the first document-target association for
    * document.
@@ -488,12 +720,21 @@ class LevelDbRemoteDocumentKey {
    */
   static std::string KeyPrefix();
 
+  /**
+   * Creates a key prefix that points just before the first key of the table
+   * as written before schema version 13, which spelled out the table name.
+   */
+  static std::string LegacyKeyPrefix();
+
   /**
    * Creates a complete key that points to a specific document. The document_key
    * must have an even number of path segments.
    */
   static std::string Key(const model::DocumentKey& document_key);
 
+  /** Like `Key()`, but replaces the contents of `dest` with the key. */
+  static void Key(const model::DocumentKey& document_key, std::string* dest);
+
   /**
    * Creates a key prefix that contains a part of a document path. Odd numbers
    * of segments create a collection key prefix, while an even number of
@@ -525,6 +766,42 @@ class LevelDbRemoteDocumentKey {
   model::DocumentKey document_key_;
 };
 
+/**
+ * A decoder for keys in the remote documents table that, unlike
+ * LevelDbRemoteDocumentKey, doesn't copy the path out of the key: its segments
+ * are views of the encoded key. Scans that skip most rows based on the path
+ * can decode every row into the same instance without allocating.
+ *
+ * The segments are valid until the next call to `Decode()`, and only as long
+ * as the encoded key they were decoded from.
+ */
+class LevelDbRemoteDocumentKeyView {
+ public:
+  /**
+   * Decodes the given complete key, as LevelDbRemoteDocumentKey::Decode()
+   * does.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The segments of the path to the document, as encoded in the key. */
+  const std::vector<absl::string_view>& segments() const {
+    return segments_;
+  }
+
+  /** Returns true if the path to the document starts with `prefix`. */
+  bool HasPrefix(const model::ResourcePath& prefix) const;
+
+  /** Copies the path out of the key. */
+  model::DocumentKey ToDocumentKey() const;
+
+ private:
+  std::vector<absl::string_view> segments_;
+  // Segments containing escaped bytes; a deque so that views into its
+  // elements remain valid as more are added.
+  std::deque<std::string> unescaped_;
+};
+
 /**
  * A key in the collection parents index, which stores an association between a
  * Collection ID (e.g. 'messages') to a parent path (e.g. '/chats/123') that
@@ -578,6 +855,476 @@ class LevelDbCollectionParentKey {
   model::ResourcePath parent_;
 };
 
+/**
+ * A key in the collection group documents index, which associates a Collection
+ * ID (e.g. 'messages') with every document in the remote document cache whose
+ * parent collection has that ID (e.g. '/chats/123/messages/abc'). This lets a
+ * Collection Group query read all candidate documents with a single scan,
+ * however many parents the collection group has.
+ */
+class LevelDbCollectionGroupDocumentKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection_id.
+   */
+  static std::string KeyPrefix(absl::string_view collection_id);
+
+  /**
+   * Creates a complete key that points to the given document. The collection_id
+   * is the ID of the document's parent collection.
+   */
+  static std::string Key(const model::DocumentKey& document_key);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection_id, as encoded in the key. */
+  const std::string& collection_id() const {
+    return collection_id_;
+  }
+
+  /** The document, as encoded in the key. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  std::string collection_id_;
+  model::DocumentKey document_key_;
+};
+
+/**
+ * A key in the field index, which maps a (collection, field path, value)
+ * triple to the documents in the remote document cache that contain that value
+ * at that field path. The value is stored in an order-preserving encoding (see
+ * LevelDbFieldIndex) so that equality and range filters can be answered with a
+ * prefix or range scan instead of reading the whole collection.
+ */
+class LevelDbFieldIndexKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection and field path.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection_path,
+                               const model::FieldPath& field_path);
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection, field path and encoded value. All documents whose field has
+   * exactly this encoded value share this prefix.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection_path,
+                               const model::FieldPath& field_path,
+                               absl::string_view index_value);
+
+  /**
+   * Creates a complete key that points to a specific field path, encoded value
+   * and document. The collection is the parent of the document_key.
+   */
+  static std::string Key(const model::FieldPath& field_path,
+                         absl::string_view index_value,
+                         const model::DocumentKey& document_key);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The canonical form of the indexed field path, as encoded in the key. */
+  const std::string& field_path() const {
+    return field_path_;
+  }
+
+  /** The encoded field value, as encoded in the key. */
+  const std::string& index_value() const {
+    return index_value_;
+  }
+
+  /** The document containing the value. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  std::string field_path_;
+  std::string index_value_;
+  model::DocumentKey document_key_;
+};
+
+/**
+ * A key in the indexed collections table, which records the collections whose
+ * documents have all been written to the field index. Collections are indexed
+ * lazily, the first time a query against them can make use of the index.
+ */
+class LevelDbIndexedCollectionKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a complete key that points to the given collection. */
+  static std::string Key(const model::ResourcePath& collection_path);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection path, as encoded in the key. */
+  const model::ResourcePath& collection_path() const {
+    return collection_path_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::ResourcePath collection_path_;
+};
+
+/**
+ * A key in the collection group sizes table, which records the number of bytes
+ * used by the remote documents of each collection group (all collections with
+ * the same collection ID). The LRU garbage collector uses these to enforce
+ * per-collection group byte budgets.
+ */
+class LevelDbCollectionGroupSizeKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a complete key that points to the given collection group. */
+  static std::string Key(absl::string_view collection_id);
+
+  /** Encodes a byte size as the value of a row in this table. */
+  static std::string EncodeSize(int64_t size);
+
+  /** Decodes the byte size stored in a row of this table. */
+  static int64_t DecodeSize(absl::string_view encoded);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection_id, as encoded in the key. */
+  const std::string& collection_id() const {
+    return collection_id_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  std::string collection_id_;
+};
+
+/**
+ * A key in the pending migrations table, which records the schema migrations
+ * whose data backfill has been deferred to run in the background. The value of
+ * each row records how far the backfill has progressed.
+ */
+class LevelDbPendingMigrationKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a complete key that points to the given schema version. */
+  static std::string Key(int32_t schema_version);
+
+  /**
+   * Encodes the progress of a backfill as the value of a row in this table:
+   * the number of rows processed so far and the last key processed, from which
+   * the backfill resumes.
+   */
+  static std::string EncodeProgress(int64_t rows_processed,
+                                    absl::string_view last_key);
+
+  /**
+   * Decodes the progress stored in a row of this table.
+   *
+   * @return true if the value successfully decoded, false otherwise.
+   */
+  ABSL_MUST_USE_RESULT
+  static bool DecodeProgress(absl::string_view encoded,
+                             int64_t* rows_processed,
+                             std::string* last_key);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The schema version, as encoded in the key. */
+  int32_t schema_version() const {
+    return schema_version_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  int32_t schema_version_;
+};
+
+/**
+ * A key in the warm snapshots table, which keeps the documents last delivered
+ * to the listeners of a target so that they can be shown again as soon as the
+ * target is listened to after a restart. The value of each row is a
+ * contiguous sequence of length-delimited MaybeDocument protos.
+ */
+class LevelDbWarmSnapshotKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a complete key that points to the snapshot of a target. */
+  static std::string Key(model::TargetId target_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The target_id, as encoded in the key. */
+  model::TargetId target_id() const {
+    return target_id_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::TargetId target_id_;
+};
+
+/**
+ * A key for the singleton row that lists the targets in the warm snapshots
+ * table, from the most to the least recently saved.
+ */
+class LevelDbWarmSnapshotGlobalKey {
+ public:
+  /** Creates a key that points to the single warm snapshot global row. */
+  static std::string Key();
+
+  /** Encodes a list of target IDs as the value of the global row. */
+  static std::string EncodeTargetIds(
+      const std::vector<model::TargetId>& target_ids);
+
+  /**
+   * Decodes the list of target IDs stored in the global row.
+   *
+   * @return true if the value successfully decoded, false otherwise.
+   */
+  ABSL_MUST_USE_RESULT
+  static bool DecodeTargetIds(absl::string_view encoded,
+                              std::vector<model::TargetId>* target_ids);
+
+  /**
+   * Decodes the contents of a warm snapshot global key, essentially just
+   * verifying that the key has the correct table name.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+};
+
+/**
+ * A key in the read time index, which orders the documents of each collection
+ * in the remote document cache by the snapshot version at which they were last
+ * written to it. This lets the documents updated since a given version be
+ * found without reading the whole collection.
+ */
+class LevelDbRemoteDocumentReadTimeKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection. Keys of its subcollections share this prefix, but sort after
+   * those of the collection itself.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection_path);
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection and read time.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection_path,
+                               const model::SnapshotVersion& read_time);
+
+  /**
+   * Creates a complete key that points to a specific document and read time.
+   * The collection is the parent of the document_key.
+   */
+  static std::string Key(const model::DocumentKey& document_key,
+                         const model::SnapshotVersion& read_time);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The read time, as encoded in the key. */
+  const model::SnapshotVersion& read_time() const {
+    return read_time_;
+  }
+
+  /** The document that was written at the read time. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::SnapshotVersion read_time_;
+  model::DocumentKey document_key_;
+};
+
+/**
+ * A key in the document read times table, which records the read time of each
+ * document in the remote document cache, so that its row in the read time
+ * index can be found when the document is written again or removed.
+ */
+class LevelDbDocumentReadTimeKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a complete key that points to the given document. */
+  static std::string Key(const model::DocumentKey& document_key);
+
+  /** Encodes a read time as the value of a row in this table. */
+  static std::string EncodeReadTime(const model::SnapshotVersion& read_time);
+
+  /**
+   * Decodes the read time stored in a row of this table.
+   *
+   * @return true if the value successfully decoded, false otherwise.
+   */
+  ABSL_MUST_USE_RESULT
+  static bool DecodeReadTime(absl::string_view encoded,
+                             model::SnapshotVersion* read_time);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The document key, as encoded in the key. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::DocumentKey document_key_;
+};
+
+/**
+ * A key in the compression dictionaries table, which holds the dictionary the
+ * compressed remote documents of each collection were compressed with. A
+ * collection's dictionary is never replaced once written, since the documents
+ * compressed with it can't be read without it.
+ */
+class LevelDbCompressionDictionaryKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a complete key that points to the given collection. */
+  static std::string Key(const model::ResourcePath& collection_path);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection path, as encoded in the key. */
+  const model::ResourcePath& collection_path() const {
+    return collection_path_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::ResourcePath collection_path_;
+};
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -16,14 +16,23 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
 #include "Firestore/Protos/nanopb/firestore/local/mutation.nanopb.h"
 #include "Firestore/Protos/nanopb/firestore/local/target.nanopb.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_document_compressor.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_index_manager.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
@@ -39,9 +48,12 @@ using leveldb::Status;
 using leveldb::WriteOptions;
 using model::DocumentKey;
 using model::ResourcePath;
+using model::SnapshotVersion;
 using nanopb::Reader;
 using nanopb::Writer;
 
+using SchemaVersion = LevelDbMigrations::SchemaVersion;
+
 namespace {
 
 /**
@@ -61,11 +73,39 @@ namespace {
  *     related to limbo resolution. Addresses
  *     https://github.com/firebase/firebase-ios-sdk/issues/1548.
  *   * Migration 4 ensures that every document in the remote document cache
- *     has a sentinel row with a sequence number.
+ *     has a sentinel row with a sequence number. Its backfill may be
+ *     deferred: documents without a sentinel row just aren't collected by the
+ *     LRU garbage collector until it completes.
  *   * Migration 5 drops held write acks.
- *   * Migration 6 populates the collection_parents index.
+ *   * Migration 6 populates the collection_parents index. Its backfill may be
+ *     deferred, in which case LevelDbIndexManager falls back to scanning the
+ *     remote document cache and the mutation queue until it completes.
+ *   * Migration 7 clears the field index. The index is populated lazily, so
+ *     this only matters when an older SDK that doesn't maintain the index has
+ *     written to the remote document cache in between.
+ *   * Migration 8 populates the collection_mutations index.
+ *   * Migration 9 counts the bytes used by remote documents, targets and
+ *     mutation batches into the target_global row.
+ *   * Migration 10 populates the collection_group_size table.
+ *   * Migration 11 populates the collection_group_documents index.
+ *   * Migration 12 populates the remote_document_read_time index. Its backfill
+ *     may be deferred, in which case LevelDbRemoteDocumentCache falls back to
+ *     reading whole collections for queries of documents changed since a
+ *     given read time until it completes.
+ *   * Migration 13 rewrites the keys of the remote_document, document_target
+ *     and target_document tables to start with a short table tag instead of
+ *     the table name, and recounts the bytes used by remote documents. The
+ *     rewrite runs before every other migration, since they read and write
+ *     these tables in their current format. It also drops the resume tokens
+ *     of all targets, so that the next listen fetches the full result set.
  */
-const LevelDbMigrations::SchemaVersion kSchemaVersion = 6;
+const LevelDbMigrations::SchemaVersion kSchemaVersion = 13;
+
+/** The migration that ensures sentinel rows exist. */
+const LevelDbMigrations::SchemaVersion kSentinelRowsMigration = 4;
+
+/** The number of rows processed by each step of a blocking backfill. */
+const int kBlockingBackfillRowsPerStep = 1000;
 
 /**
  * Save the given version number as the current version of the schema of the
@@ -84,7 +124,7 @@ void DeleteEverythingWithPrefix(const std::string& prefix, leveldb::DB* db) {
   bool more_deletes = true;
   while (more_deletes) {
     LevelDbTransaction transaction(db, "Delete everything with prefix");
-    auto it = transaction.NewIterator();
+    auto it = transaction.NewMaintenanceIterator();
 
     more_deletes = false;
     for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
@@ -133,7 +173,7 @@ void RemoveMutationDocuments(LevelDbTransaction* transaction,
   LevelDbDocumentMutationKey doc_key;
   std::string prefix = LevelDbDocumentMutationKey::KeyPrefix(user_id);
 
-  auto it = transaction->NewIterator();
+  auto it = transaction->NewMaintenanceIterator();
   it->Seek(prefix);
   for (; it->Valid() && absl::StartsWith(it->key(), prefix); it->Next()) {
     HARD_ASSERT(doc_key.Decode(it->key()),
@@ -154,7 +194,7 @@ void RemoveMutationBatches(LevelDbTransaction* transaction,
   std::string mutations_key = LevelDbMutationKey::KeyPrefix(user_id);
   std::string last_key =
       LevelDbMutationKey::Key(user_id, last_acknowledged_batch_id);
-  auto it = transaction->NewIterator();
+  auto it = transaction->NewMaintenanceIterator();
   it->Seek(mutations_key);
   for (; it->Valid() && it->key() <= last_key; it->Next()) {
     transaction->Delete(it->key());
@@ -168,7 +208,7 @@ void RemoveAcknowledgedMutations(leveldb::DB* db) {
 
   LevelDbMutationQueueKey key;
 
-  auto it = transaction.NewIterator();
+  auto it = transaction.NewMaintenanceIterator();
   it->Seek(mutation_queue_start);
   for (; it->Valid() && absl::StartsWith(it->key(), mutation_queue_start);
        it->Next()) {
@@ -203,6 +243,52 @@ model::ListenSequenceNumber GetHighestSequenceNumber(
   return target_global.highest_listen_sequence_number;
 }
 
+/**
+ * Reads the version of the last remote event from the target global row.
+ */
+SnapshotVersion GetLastRemoteSnapshotVersion(LevelDbTransaction* transaction) {
+  std::string bytes;
+  transaction->Get(LevelDbTargetGlobalKey::Key(), &bytes);
+
+  firestore_client_TargetGlobal target_global{};
+  Reader reader = Reader::Wrap(bytes);
+  reader.ReadNanopbMessage(firestore_client_TargetGlobal_fields,
+                           &target_global);
+  const google_protobuf_Timestamp& version =
+      target_global.last_remote_snapshot_version;
+  return SnapshotVersion{Timestamp{version.seconds, version.nanos}};
+}
+
+/**
+ * Reads the version of the given encoded remote document.
+ */
+SnapshotVersion DecodeDocumentVersion(absl::string_view encoded) {
+  firestore_client_MaybeDocument maybe_document{};
+  Reader reader = Reader::Wrap(encoded);
+  reader.ReadNanopbMessage(firestore_client_MaybeDocument_fields,
+                           &maybe_document);
+  HARD_ASSERT(reader.status().ok(), "Failed to deserialize MaybeDocument");
+
+  const google_protobuf_Timestamp* version = nullptr;
+  switch (maybe_document.which_document_type) {
+    case firestore_client_MaybeDocument_no_document_tag:
+      version = &maybe_document.no_document.read_time;
+      break;
+    case firestore_client_MaybeDocument_document_tag:
+      version = &maybe_document.document.update_time;
+      break;
+    case firestore_client_MaybeDocument_unknown_document_tag:
+      version = &maybe_document.unknown_document.version;
+      break;
+  }
+  SnapshotVersion result =
+      version ? SnapshotVersion{Timestamp{version->seconds, version->nanos}}
+              : SnapshotVersion::None();
+  reader.FreeNanopbMessage(firestore_client_MaybeDocument_fields,
+                           &maybe_document);
+  return result;
+}
+
 /**
  * Given a document key, ensure it has a sentinel row. If it doesn't have one,
  * add it with the given value.
@@ -218,33 +304,20 @@ void EnsureSentinelRow(LevelDbTransaction* transaction,
 }
 
 /**
- * Migration 4.
- *
- * Ensure each document in the remote document table has a corresponding
- * sentinel row in the document target index.
+ * Returns the prefixes of the tables scanned by the backfill of the given
+ * migration, in key order.
  */
-void EnsureSentinelRows(leveldb::DB* db) {
-  LevelDbTransaction transaction(db, "Ensure sentinel rows");
-
-  // Get the value we'll use for anything that's missing a row.
-  model::ListenSequenceNumber sequence_number =
-      GetHighestSequenceNumber(&transaction);
-  std::string sentinel_value =
-      LevelDbDocumentTargetKey::EncodeSentinelValue(sequence_number);
-
-  std::string documents_prefix = LevelDbRemoteDocumentKey::KeyPrefix();
-  auto it = transaction.NewIterator();
-  it->Seek(documents_prefix);
-  LevelDbRemoteDocumentKey document_key;
-  for (; it->Valid() && absl::StartsWith(it->key(), documents_prefix);
-       it->Next()) {
-    HARD_ASSERT(document_key.Decode(it->key()),
-                "Failed to decode document key");
-    EnsureSentinelRow(&transaction, document_key.document_key(),
-                      sentinel_value);
+std::vector<std::string> BackfillPrefixes(SchemaVersion version) {
+  std::vector<std::string> prefixes{LevelDbRemoteDocumentKey::KeyPrefix()};
+  if (version == LevelDbMigrations::kCollectionParentsMigration) {
+    prefixes.push_back(LevelDbDocumentMutationKey::KeyPrefix());
+  } else {
+    HARD_ASSERT(version == kSentinelRowsMigration ||
+                    version == LevelDbMigrations::kReadTimeMigration,
+                "No backfill for schema version %s", version);
   }
-  SaveVersion(4, &transaction);
-  transaction.Commit();
+  std::sort(prefixes.begin(), prefixes.end());
+  return prefixes;
 }
 
 // Helper to add an index entry iff we haven't already written it (as determined
@@ -264,6 +337,179 @@ void EnsureCollectionParentRow(LevelDbTransaction* transaction,
   }
 }
 
+/**
+ * Given a document key, ensure it has a row in the read time index. If it
+ * doesn't have one, add it with the later of the given read time and the
+ * version of the encoded document.
+ */
+void EnsureReadTimeRows(LevelDbTransaction* transaction,
+                        const model::DocumentKey& key,
+                        absl::string_view encoded_document,
+                        const SnapshotVersion& read_time) {
+  std::string reverse_key = LevelDbDocumentReadTimeKey::Key(key);
+  std::string unused_value;
+  if (!transaction->Get(reverse_key, &unused_value).IsNotFound()) {
+    return;
+  }
+
+  // Documents written by acknowledged mutations can be newer than the last
+  // remote event.
+  SnapshotVersion document_read_time =
+      std::max(read_time, DecodeDocumentVersion(encoded_document));
+  std::string empty_buffer;
+  transaction->Put(
+      LevelDbRemoteDocumentReadTimeKey::Key(key, document_read_time),
+      empty_buffer);
+  transaction->Put(reverse_key, LevelDbDocumentReadTimeKey::EncodeReadTime(
+                                    document_read_time));
+}
+
+/**
+ * Returns a function that backfills the data of the given migration for one
+ * row of the tables returned by `BackfillPrefixes`, given its key and value.
+ */
+std::function<void(absl::string_view, absl::string_view)> NewBackfillVisitor(
+    LevelDbTransaction* transaction, SchemaVersion version) {
+  if (version == LevelDbMigrations::kReadTimeMigration) {
+    // The time at which documents that predate the index were read isn't
+    // known, but none was read after the last remote event.
+    SnapshotVersion read_time = GetLastRemoteSnapshotVersion(transaction);
+
+    // Documents may have been written compressed since the migration was
+    // deferred.
+    auto compressor = std::make_shared<LevelDbDocumentCompressor>();
+    return [transaction, read_time, compressor](absl::string_view key,
+                                                absl::string_view value) {
+      LevelDbRemoteDocumentKey document_key;
+      HARD_ASSERT(document_key.Decode(key), "Failed to decode document key");
+      std::string decompressed;
+      value = compressor->Decode(transaction, document_key.document_key(),
+                                 value, &decompressed);
+      EnsureReadTimeRows(transaction, document_key.document_key(), value,
+                         read_time);
+    };
+  }
+
+  if (version == kSentinelRowsMigration) {
+    // Get the value we'll use for anything that's missing a row.
+    model::ListenSequenceNumber sequence_number =
+        GetHighestSequenceNumber(transaction);
+    std::string sentinel_value =
+        LevelDbDocumentTargetKey::EncodeSentinelValue(sequence_number);
+
+    return [transaction, sentinel_value](absl::string_view key,
+                                         absl::string_view) {
+      LevelDbRemoteDocumentKey document_key;
+      HARD_ASSERT(document_key.Decode(key), "Failed to decode document key");
+      EnsureSentinelRow(transaction, document_key.document_key(),
+                        sentinel_value);
+    };
+  }
+
+  std::string documents_prefix = LevelDbRemoteDocumentKey::KeyPrefix();
+  auto cache = std::make_shared<MemoryCollectionParentIndex>();
+  return [transaction, documents_prefix, cache](absl::string_view key,
+                                                absl::string_view) {
+    if (absl::StartsWith(key, documents_prefix)) {
+      LevelDbRemoteDocumentKey document_key;
+      HARD_ASSERT(document_key.Decode(key), "Failed to decode document key");
+      EnsureCollectionParentRow(transaction, cache.get(),
+                                document_key.document_key());
+    } else {
+      LevelDbDocumentMutationKey mutation_key;
+      HARD_ASSERT(mutation_key.Decode(key),
+                  "Failed to decode document-mutation key");
+      EnsureCollectionParentRow(transaction, cache.get(),
+                                mutation_key.document_key());
+    }
+  };
+}
+
+struct BackfillResult {
+  /** The number of rows processed. */
+  int64_t rows = 0;
+
+  /** The last key processed, from which to resume. */
+  std::string last_key;
+
+  /** Whether all rows have been processed. */
+  bool done = false;
+};
+
+/**
+ * Backfills the data of the given migration for up to `max_rows` rows that
+ * come after `start_after` (or for all rows from the start, if it's empty).
+ */
+BackfillResult Backfill(LevelDbTransaction* transaction,
+                        SchemaVersion version,
+                        const std::string& start_after,
+                        int64_t max_rows) {
+  std::function<void(absl::string_view, absl::string_view)> visit =
+      NewBackfillVisitor(transaction, version);
+
+  BackfillResult result;
+  result.last_key = start_after;
+  for (const std::string& prefix : BackfillPrefixes(version)) {
+    auto it = transaction->NewMaintenanceIterator();
+    if (start_after < prefix) {
+      it->Seek(prefix);
+    } else {
+      it->Seek(start_after);
+      if (it->Valid() && it->key() == start_after) {
+        it->Next();
+      }
+    }
+
+    for (; it->Valid() && absl::StartsWith(it->key(), prefix); it->Next()) {
+      if (result.rows >= max_rows) {
+        return result;
+      }
+      absl::string_view key = it->key();
+      visit(key, it->value());
+      result.last_key.assign(key.data(), key.size());
+      ++result.rows;
+    }
+  }
+
+  result.done = true;
+  return result;
+}
+
+/**
+ * Records the backfill of the given migration as pending, so that it runs in
+ * the background, and saves its version as the current version.
+ *
+ * Only SDKs that know about the pending_migration table honor the pending
+ * row. An older SDK that opens the database before the backfill completes
+ * trusts the saved version and treats the rows as complete: it doesn't
+ * collect documents that lack a sentinel row, and collection group queries
+ * miss collections that aren't in the collection parents index yet. The
+ * version can't be held back until the backfill completes instead, since
+ * every later migration would then run again on the next start.
+ */
+void DeferBackfill(leveldb::DB* db, SchemaVersion version) {
+  LevelDbTransaction transaction(db, "Defer migration backfill");
+  transaction.Put(LevelDbPendingMigrationKey::Key(version),
+                  LevelDbPendingMigrationKey::EncodeProgress(0, ""));
+  SaveVersion(version, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 4.
+ *
+ * Ensure each document in the remote document table has a corresponding
+ * sentinel row in the document target index.
+ */
+void EnsureSentinelRows(leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Ensure sentinel rows");
+  Backfill(&transaction, kSentinelRowsMigration, "",
+           std::numeric_limits<int64_t>::max());
+  transaction.Delete(LevelDbPendingMigrationKey::Key(kSentinelRowsMigration));
+  SaveVersion(4, &transaction);
+  transaction.Commit();
+}
+
 /**
  * Migration 6.
  *
@@ -272,12 +518,123 @@ void EnsureCollectionParentRow(LevelDbTransaction* transaction,
  */
 void EnsureCollectionParentsIndex(leveldb::DB* db) {
   LevelDbTransaction transaction(db, "Ensure Collection Parents Index");
+  Backfill(&transaction, LevelDbMigrations::kCollectionParentsMigration, "",
+           std::numeric_limits<int64_t>::max());
+  transaction.Delete(LevelDbPendingMigrationKey::Key(
+      LevelDbMigrations::kCollectionParentsMigration));
+  SaveVersion(6, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 7.
+ *
+ * Drops all field index entries along with the record of which collections
+ * have been indexed.
+ */
+void ClearFieldIndex(leveldb::DB* db) {
+  DeleteEverythingWithPrefix(LevelDbFieldIndexKey::KeyPrefix(), db);
+  DeleteEverythingWithPrefix(LevelDbIndexedCollectionKey::KeyPrefix(), db);
+
+  LevelDbTransaction transaction(db, "Clear field index");
+  SaveVersion(7, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 8.
+ *
+ * Rebuilds the collection_mutations index from the document_mutations index.
+ * Any existing rows are dropped first since an older SDK may have added or
+ * removed mutation batches without maintaining them.
+ */
+void EnsureCollectionMutationsIndex(leveldb::DB* db) {
+  DeleteEverythingWithPrefix(LevelDbCollectionMutationKey::KeyPrefix(), db);
+
+  LevelDbTransaction transaction(db, "Index mutations by collection");
+
+  std::string empty_buffer;
+  std::string mutations_prefix = LevelDbDocumentMutationKey::KeyPrefix();
+  auto it = transaction.NewMaintenanceIterator();
+  it->Seek(mutations_prefix);
+  LevelDbDocumentMutationKey key;
+  for (; it->Valid() && absl::StartsWith(it->key(), mutations_prefix);
+       it->Next()) {
+    HARD_ASSERT(key.Decode(it->key()),
+                "Failed to decode document-mutation key");
+
+    transaction.Put(LevelDbCollectionMutationKey::Key(
+                        key.user_id(), key.document_key(), key.batch_id()),
+                    empty_buffer);
+  }
+
+  SaveVersion(8, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Sums the keys and values of every remote document, target and mutation batch
+ * into the byte size recorded in the target global row.
+ */
+void CountByteSize(LevelDbTransaction* transaction) {
+  int64_t byte_size = 0;
+  for (const std::string& prefix :
+       {LevelDbRemoteDocumentKey::KeyPrefix(), LevelDbTargetKey::KeyPrefix(),
+        LevelDbMutationKey::KeyPrefix()}) {
+    auto it = transaction->NewMaintenanceIterator();
+    for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+         it->Next()) {
+      byte_size += it->key().size() + it->value().size();
+    }
+  }
+
+  std::string key = LevelDbTargetGlobalKey::Key();
+  std::string bytes;
+  transaction->Get(key, &bytes);
+
+  firestore_client_TargetGlobal target_global{};
+  Reader reader = Reader::Wrap(bytes);
+  reader.ReadNanopbMessage(firestore_client_TargetGlobal_fields,
+                           &target_global);
+  HARD_ASSERT(reader.status().ok(), "Failed to deserialize TargetGlobal");
+  target_global.byte_size = byte_size;
+
+  std::string updated;
+  Writer writer = Writer::Wrap(&updated);
+  writer.WriteNanopbMessage(firestore_client_TargetGlobal_fields,
+                            &target_global);
+  transaction->Put(key, updated);
+}
+
+/**
+ * Migration 9.
+ *
+ * Recounts the bytes used by remote documents, targets and mutation batches.
+ * This also fixes up the count after an older SDK, which doesn't maintain it,
+ * has written to the database.
+ */
+void EnsureByteSizeCount(leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Count cached bytes");
+  CountByteSize(&transaction);
+  SaveVersion(9, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 10.
+ *
+ * Recomputes the collection_group_size rows from the remote document cache.
+ * Existing rows are dropped first, since an older SDK that doesn't maintain
+ * them may have written to the database in between.
+ */
+void EnsureCollectionGroupSizes(leveldb::DB* db) {
+  DeleteEverythingWithPrefix(LevelDbCollectionGroupSizeKey::KeyPrefix(), db);
 
-  MemoryCollectionParentIndex cache;
+  LevelDbTransaction transaction(db, "Count collection group bytes");
 
-  // Index existing remote documents.
+  std::map<std::string, int64_t> sizes;
   std::string documents_prefix = LevelDbRemoteDocumentKey::KeyPrefix();
-  auto it = transaction.NewIterator();
+  auto it = transaction.NewMaintenanceIterator();
   it->Seek(documents_prefix);
   LevelDbRemoteDocumentKey document_key;
   for (; it->Valid() && absl::StartsWith(it->key(), documents_prefix);
@@ -285,29 +642,222 @@ void EnsureCollectionParentsIndex(leveldb::DB* db) {
     HARD_ASSERT(document_key.Decode(it->key()),
                 "Failed to decode document key");
 
-    EnsureCollectionParentRow(&transaction, &cache,
-                              document_key.document_key());
+    const ResourcePath& path = document_key.document_key().path();
+    sizes[path[path.size() - 2]] += it->key().size() + it->value().size();
   }
 
-  // Index existing mutations.
-  std::string mutations_prefix = LevelDbDocumentMutationKey::KeyPrefix();
-  it = transaction.NewIterator();
-  it->Seek(mutations_prefix);
-  LevelDbDocumentMutationKey key;
-  for (; it->Valid() && absl::StartsWith(it->key(), mutations_prefix);
+  for (const auto& entry : sizes) {
+    transaction.Put(LevelDbCollectionGroupSizeKey::Key(entry.first),
+                    LevelDbCollectionGroupSizeKey::EncodeSize(entry.second));
+  }
+
+  SaveVersion(10, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 11.
+ *
+ * Rebuilds the collection_group_documents index from the remote document
+ * cache. Existing rows are dropped first, since an older SDK that doesn't
+ * maintain them may have added or removed documents in between.
+ */
+void EnsureCollectionGroupDocumentsIndex(leveldb::DB* db) {
+  DeleteEverythingWithPrefix(LevelDbCollectionGroupDocumentKey::KeyPrefix(),
+                             db);
+
+  LevelDbTransaction transaction(db, "Index documents by collection group");
+
+  std::string empty_buffer;
+  std::string documents_prefix = LevelDbRemoteDocumentKey::KeyPrefix();
+  auto it = transaction.NewMaintenanceIterator();
+  it->Seek(documents_prefix);
+  LevelDbRemoteDocumentKey document_key;
+  for (; it->Valid() && absl::StartsWith(it->key(), documents_prefix);
        it->Next()) {
-    HARD_ASSERT(key.Decode(it->key()),
-                "Failed to decode document-mutation key");
+    HARD_ASSERT(document_key.Decode(it->key()),
+                "Failed to decode document key");
 
-    EnsureCollectionParentRow(&transaction, &cache, key.document_key());
+    transaction.Put(
+        LevelDbCollectionGroupDocumentKey::Key(document_key.document_key()),
+        empty_buffer);
   }
 
-  SaveVersion(6, &transaction);
+  SaveVersion(11, &transaction);
   transaction.Commit();
 }
 
+/**
+ * Migration 12, first part.
+ *
+ * Drops the remote_document_read_time index, since an older SDK that doesn't
+ * maintain it may have added or removed documents in between. The index is
+ * then rebuilt by `EnsureReadTimeIndex` or a deferred backfill.
+ */
+void ClearReadTimeIndex(leveldb::DB* db) {
+  DeleteEverythingWithPrefix(LevelDbRemoteDocumentReadTimeKey::KeyPrefix(),
+                             db);
+  DeleteEverythingWithPrefix(LevelDbDocumentReadTimeKey::KeyPrefix(), db);
+}
+
+/**
+ * Migration 12, second part.
+ *
+ * Adds a remote_document_read_time row for every document in the remote
+ * document cache.
+ */
+void EnsureReadTimeIndex(leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Index documents by read time");
+  Backfill(&transaction, LevelDbMigrations::kReadTimeMigration, "",
+           std::numeric_limits<int64_t>::max());
+  transaction.Delete(
+      LevelDbPendingMigrationKey::Key(LevelDbMigrations::kReadTimeMigration));
+  SaveVersion(12, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Moves every row whose key starts with `legacy_prefix` to the key returned by
+ * `rekey`, a thousand rows per transaction.
+ */
+void RewriteLegacyKeys(
+    leveldb::DB* db,
+    const std::string& legacy_prefix,
+    const std::function<std::string(absl::string_view)>& rekey) {
+  bool more_rows = true;
+  while (more_rows) {
+    LevelDbTransaction transaction(db, "Rewrite legacy keys");
+    auto it = transaction.NewMaintenanceIterator();
+
+    more_rows = false;
+    for (it->Seek(legacy_prefix);
+         it->Valid() && absl::StartsWith(it->key(), legacy_prefix);
+         it->Next()) {
+      if (transaction.changed_keys() >= 1000) {
+        more_rows = true;
+        break;
+      }
+      std::string legacy_key{it->key()};
+      transaction.Put(rekey(legacy_key), it->value());
+      transaction.Delete(legacy_key);
+    }
+
+    transaction.Commit();
+  }
+}
+
+/**
+ * Drops the resume token of every target, so that the next listen for each of
+ * them fetches its full result set instead of the changes since the token.
+ */
+void ResetResumeTokens(leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Reset resume tokens");
+  std::string prefix = LevelDbTargetKey::KeyPrefix();
+  auto it = transaction.NewMaintenanceIterator();
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+       it->Next()) {
+    firestore_client_Target target{};
+    Reader reader = Reader::Wrap(it->value());
+    reader.ReadNanopbMessage(firestore_client_Target_fields, &target);
+    HARD_ASSERT(reader.status().ok(), "Failed to deserialize Target");
+
+    // Encode the target without its token, and give the token back afterwards
+    // so that it's freed with the rest of the message.
+    pb_bytes_array_t* resume_token = target.resume_token;
+    target.resume_token = nullptr;
+    std::string updated;
+    Writer writer = Writer::Wrap(&updated);
+    writer.WriteNanopbMessage(firestore_client_Target_fields, &target);
+    target.resume_token = resume_token;
+    reader.FreeNanopbMessage(firestore_client_Target_fields, &target);
+
+    transaction.Put(std::string{it->key()}, std::move(updated));
+  }
+  transaction.Commit();
+}
+
+/**
+ * Migration 13, first part.
+ *
+ * Rewrites the keys of the remote_document, document_target and
+ * target_document tables from the table name to the table tag. This runs
+ * before every other migration, so that they find these rows where they
+ * expect them.
+ *
+ * Rows that are already tagged were written before a downgrade, and the older
+ * SDK that ran since may have removed or replaced them in the legacy tables,
+ * so the tagged tables are cleared before the legacy rows move over. This
+ * also means that an interrupted rewrite starts over, dropping the rows it
+ * already moved.
+ *
+ * Dropping tagged rows can leave targets whose resume tokens cover documents
+ * that are no longer cached. So once the legacy rows have been moved, the
+ * resume tokens of all targets are dropped and every target re-listens to its
+ * full result set, which leaves a client that was downgraded and upgraded
+ * again with a complete cache.
+ */
+void RewriteTaggedTableKeys(leveldb::DB* db) {
+  DeleteEverythingWithPrefix(LevelDbRemoteDocumentKey::KeyPrefix(), db);
+  DeleteEverythingWithPrefix(LevelDbDocumentTargetKey::KeyPrefix(), db);
+  DeleteEverythingWithPrefix(LevelDbTargetDocumentKey::KeyPrefix(), db);
+
+  RewriteLegacyKeys(
+      db, LevelDbRemoteDocumentKey::LegacyKeyPrefix(),
+      [](absl::string_view legacy_key) {
+        LevelDbRemoteDocumentKey key;
+        HARD_ASSERT(key.Decode(legacy_key), "Failed to decode document key");
+        return LevelDbRemoteDocumentKey::Key(key.document_key());
+      });
+  RewriteLegacyKeys(
+      db, LevelDbDocumentTargetKey::LegacyKeyPrefix(),
+      [](absl::string_view legacy_key) {
+        LevelDbDocumentTargetKey key;
+        HARD_ASSERT(key.Decode(legacy_key),
+                    "Failed to decode document-target key");
+        return LevelDbDocumentTargetKey::Key(key.document_key(),
+                                             key.target_id());
+      });
+  RewriteLegacyKeys(
+      db, LevelDbTargetDocumentKey::LegacyKeyPrefix(),
+      [](absl::string_view legacy_key) {
+        LevelDbTargetDocumentKey key;
+        HARD_ASSERT(key.Decode(legacy_key),
+                    "Failed to decode target-document key");
+        return LevelDbTargetDocumentKey::Key(key.target_id(),
+                                             key.document_key());
+      });
+
+  ResetResumeTokens(db);
+}
+
+/**
+ * Migration 13, second part.
+ *
+ * Recounts the bytes used by the cache, since remote document keys just got
+ * shorter.
+ */
+void EnsureTaggedTableByteSizeCount(leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Count cached bytes");
+  CountByteSize(&transaction);
+  SaveVersion(13, &transaction);
+  transaction.Commit();
+}
+
+bool HasPendingBackfill(leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Check for pending backfills");
+  std::string prefix = LevelDbPendingMigrationKey::KeyPrefix();
+  auto it = transaction.NewIterator();
+  it->Seek(prefix);
+  return it->Valid() && absl::StartsWith(it->key(), prefix);
+}
+
 }  // namespace
 
+constexpr LevelDbMigrations::SchemaVersion
+    LevelDbMigrations::kCollectionParentsMigration;
+constexpr LevelDbMigrations::SchemaVersion
+    LevelDbMigrations::kReadTimeMigration;
+
 LevelDbMigrations::SchemaVersion LevelDbMigrations::ReadSchemaVersion(
     leveldb::DB* db) {
   LevelDbTransaction transaction(db, "Read schema version");
@@ -321,23 +871,47 @@ LevelDbMigrations::SchemaVersion LevelDbMigrations::ReadSchemaVersion(
   }
 }
 
+LevelDbMigrations::SchemaVersion LevelDbMigrations::CurrentSchemaVersion() {
+  return kSchemaVersion;
+}
+
 void LevelDbMigrations::RunMigrations(leveldb::DB* db) {
   RunMigrations(db, kSchemaVersion);
 }
 
 void LevelDbMigrations::RunMigrations(leveldb::DB* db,
                                       SchemaVersion to_version) {
+  RunMigrations(db, to_version, /*defer_backfills=*/false);
+}
+
+void LevelDbMigrations::RunMigrations(leveldb::DB* db,
+                                      SchemaVersion to_version,
+                                      bool defer_backfills) {
   SchemaVersion from_version = ReadSchemaVersion(db);
   // If this is a downgrade, just save the downgrade version so we can
   // detect it when we go to upgrade again, allowing us to rerun the
   // data migrations.
   if (from_version > to_version) {
+    // Schemas before 13 don't see the rows that migration 13 moved to tagged
+    // keys, so resume tokens would claim documents that are missing from the
+    // cache. Drop them, so that every target re-listens to its full result
+    // set.
+    if (from_version >= 13 && to_version < 13) {
+      ResetResumeTokens(db);
+    }
+
     LevelDbTransaction transaction(db, "Save downgrade version");
     SaveVersion(to_version, &transaction);
     transaction.Commit();
     return;
   }
 
+  // Runs ahead of the migrations before it, which use the current key format
+  // of the tables it rewrites.
+  if (from_version < 13 && to_version >= 13) {
+    RewriteTaggedTableKeys(db);
+  }
+
   // This must run unconditionally because schema migrations were added to iOS
   // after the first release. There may be clients that have never run any
   // migrations that have existing targets.
@@ -346,7 +920,11 @@ void LevelDbMigrations::RunMigrations(leveldb::DB* db,
   }
 
   if (from_version < 4 && to_version >= 4) {
-    EnsureSentinelRows(db);
+    if (defer_backfills) {
+      DeferBackfill(db, kSentinelRowsMigration);
+    } else {
+      EnsureSentinelRows(db);
+    }
   }
 
   if (from_version < 5 && to_version >= 5) {
@@ -354,8 +932,97 @@ void LevelDbMigrations::RunMigrations(leveldb::DB* db,
   }
 
   if (from_version < 6 && to_version >= 6) {
-    EnsureCollectionParentsIndex(db);
+    if (defer_backfills) {
+      DeferBackfill(db, kCollectionParentsMigration);
+    } else {
+      EnsureCollectionParentsIndex(db);
+    }
   }
+
+  if (from_version < 7 && to_version >= 7) {
+    ClearFieldIndex(db);
+  }
+
+  if (from_version < 8 && to_version >= 8) {
+    EnsureCollectionMutationsIndex(db);
+  }
+
+  if (from_version < 9 && to_version >= 9) {
+    EnsureByteSizeCount(db);
+  }
+
+  if (from_version < 10 && to_version >= 10) {
+    EnsureCollectionGroupSizes(db);
+  }
+
+  if (from_version < 11 && to_version >= 11) {
+    EnsureCollectionGroupDocumentsIndex(db);
+  }
+
+  if (from_version < 12 && to_version >= 12) {
+    ClearReadTimeIndex(db);
+    if (defer_backfills) {
+      DeferBackfill(db, kReadTimeMigration);
+    } else {
+      EnsureReadTimeIndex(db);
+    }
+  }
+
+  if (from_version < 13 && to_version >= 13) {
+    EnsureTaggedTableByteSizeCount(db);
+  }
+
+  if (!defer_backfills) {
+    while (RunBackfillStep(db, kBlockingBackfillRowsPerStep)) {
+    }
+  }
+}
+
+bool LevelDbMigrations::RunBackfillStep(
+    leveldb::DB* db, int max_rows, const BackfillProgressCallback& progress) {
+  HARD_ASSERT(max_rows > 0, "A backfill step must process at least one row");
+
+  LevelDbTransaction transaction(db, "Run migration backfill step");
+  std::string prefix = LevelDbPendingMigrationKey::KeyPrefix();
+  auto it = transaction.NewIterator();
+  it->Seek(prefix);
+  if (!it->Valid() || !absl::StartsWith(it->key(), prefix)) {
+    return false;
+  }
+
+  std::string pending_key{it->key()};
+  LevelDbPendingMigrationKey key;
+  HARD_ASSERT(key.Decode(pending_key),
+              "Failed to decode pending migration key");
+  int64_t rows = 0;
+  std::string last_key;
+  HARD_ASSERT(
+      LevelDbPendingMigrationKey::DecodeProgress(it->value(), &rows, &last_key),
+      "Failed to decode the progress of a pending migration");
+
+  BackfillResult result =
+      Backfill(&transaction, key.schema_version(), last_key, max_rows);
+  rows += result.rows;
+  if (result.done) {
+    transaction.Delete(pending_key);
+  } else {
+    transaction.Put(pending_key, LevelDbPendingMigrationKey::EncodeProgress(
+                                     rows, result.last_key));
+  }
+  transaction.Commit();
+
+  if (progress) {
+    progress(key.schema_version(), rows, result.done);
+  }
+  return !result.done || HasPendingBackfill(db);
+}
+
+bool LevelDbMigrations::IsBackfillPending(LevelDbTransaction* transaction,
+                                          SchemaVersion version) {
+  std::string unused_value;
+  return transaction->Get(LevelDbPendingMigrationKey::Key(version),
+                          &unused_value)
+      .ok();
 }
 
 }  // namespace local
@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_MIGRATIONS_H_
 
 #include <cstdint>
+#include <functional>
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
 #include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
@@ -36,6 +37,12 @@ class LevelDbMigrations {
    */
   static SchemaVersion ReadSchemaVersion(leveldb::DB* db);
 
+  /**
+   * Returns the schema version that migrations bring databases up to by
+   * default.
+   */
+  static SchemaVersion CurrentSchemaVersion();
+
   /**
    * Runs any migrations needed to bring the given database up to the current
    * schema version
@@ -47,6 +54,54 @@ class LevelDbMigrations {
    * schema version
    */
   static void RunMigrations(leveldb::DB* db, SchemaVersion version);
+
+  /**
+   * Like `RunMigrations`, but if `defer_backfills` is true, migrations that
+   * only backfill data derived from the remote document cache and the mutation
+   * queue (sentinel rows and the collection parents index) are recorded as
+   * pending instead of scanning the database. They must then be completed by
+   * calling `RunBackfillStep` until it returns false.
+   *
+   * Pending backfills left over from an earlier run are completed right away
+   * if `defer_backfills` is false.
+   *
+   * The schema version is saved before a deferred backfill completes, so an
+   * older SDK that opens the database in between treats the backfilled rows
+   * as complete. Until then, it may miss results of collection group queries.
+   */
+  static void RunMigrations(leveldb::DB* db,
+                            SchemaVersion version,
+                            bool defer_backfills);
+
+  /**
+   * Receives the progress of a backfill: the migration it belongs to, the
+   * number of rows processed so far and whether the backfill is finished.
+   */
+  using BackfillProgressCallback =
+      std::function<void(SchemaVersion version, int64_t rows, bool done)>;
+
+  /**
+   * Processes up to `max_rows` rows of the first pending backfill in a
+   * transaction of its own, calling `progress` (if any) afterwards.
+   *
+   * @return true if any backfill is still pending.
+   */
+  static bool RunBackfillStep(leveldb::DB* db,
+                              int max_rows,
+                              const BackfillProgressCallback& progress = {});
+
+  /**
+   * Returns whether the backfill of the given migration is still pending, in
+   * which case the data it maintains is incomplete.
+   */
+  static bool IsBackfillPending(LevelDbTransaction* transaction,
+                                SchemaVersion version);
+
+  /** The migration that populates the collection parents index. */
+  static constexpr SchemaVersion kCollectionParentsMigration = 6;
+
+  /** The migration that populates the remote document read time index. */
+  static constexpr SchemaVersion kReadTimeMigration = 12;
 };
 
 }  // namespace local
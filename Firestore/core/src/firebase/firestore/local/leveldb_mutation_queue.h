@@ -23,8 +23,10 @@
 
 #import <Foundation/Foundation.h>
 
+#include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #import "Firestore/Source/Public/FIRTimestamp.h"
@@ -75,6 +77,9 @@ class LevelDbMutationQueue : public MutationQueue {
       std::vector<FSTMutation*>&& base_mutations,
       std::vector<FSTMutation*>&& mutations) override;
 
+  FSTMutationBatch* ReplaceMutationBatch(
+      FSTMutationBatch* batch, std::vector<FSTMutation*>&& mutations) override;
+
   void RemoveMutationBatch(FSTMutationBatch* batch) override;
 
   std::vector<FSTMutationBatch*> AllMutationBatches() override;
@@ -104,9 +109,11 @@ class LevelDbMutationQueue : public MutationQueue {
   /**
    * Constructs a vector of matching batches, sorted by batchID to ensure that
    * multiple mutations affecting the same document key are applied in order.
+   *
+   * @param batch_ids The batch IDs to look up, sorted and without duplicates.
    */
   std::vector<FSTMutationBatch*> AllMutationBatchesWithIds(
-      const std::set<model::BatchId>& batch_ids);
+      const std::vector<model::BatchId>& batch_ids);
 
   std::string mutation_queue_key() {
     return LevelDbMutationQueueKey::Key(user_id_);
@@ -116,11 +123,38 @@ class LevelDbMutationQueue : public MutationQueue {
     return LevelDbMutationKey::Key(user_id_, batch_id);
   }
 
+  /**
+   * Loads the next batch ID and the queue's metadata, unless they have been
+   * loaded since the queue was started. `Start` leaves this to the first
+   * operation that needs them, so that starting doesn't delay reads that don't.
+   */
+  void EnsureLoaded();
+
   /** Parses the MutationQueue metadata from the given LevelDB row contents. */
   FSTPBMutationQueue* _Nullable MetadataForKey(const std::string& key);
 
   FSTMutationBatch* ParseMutationBatch(absl::string_view encoded);
 
+  /**
+   * Returns the decoded batch with the given ID if it's in the batch cache,
+   * otherwise decodes `encoded` and adds the result to the cache.
+   */
+  FSTMutationBatch* DecodeMutationBatch(model::BatchId batch_id,
+                                        absl::string_view encoded);
+
+  /**
+   * Adds a decoded batch to the batch cache, evicting the batch with the
+   * lowest ID if the cache is full.
+   */
+  void CacheMutationBatch(FSTMutationBatch* batch);
+
+  /**
+   * Builds the in-memory document index from this user's document-mutation
+   * rows, unless it has been built since the queue was started. Once built,
+   * the index is kept up to date as batches are added and removed.
+   */
+  void EnsureDocumentIndexLoaded();
+
   // This instance is owned by FSTLevelDB; avoid a retain cycle.
   __weak FSTLevelDB* db_;
 
@@ -142,9 +176,28 @@ class LevelDbMutationQueue : public MutationQueue {
   model::BatchId next_batch_id_;
 
   /**
-   * A write-through cache copy of the metadata describing the current queue.
+   * A write-through cache copy of the metadata describing the current queue,
+   * or nil if it has not been loaded yet.
    */
   FSTPBMutationQueue* _Nullable metadata_;
+
+  /**
+   * Decoded mutation batches by batch ID, so that batches read on every local
+   * document lookup aren't parsed again each time. Bounded by
+   * `kMaxCachedMutationBatches`.
+   */
+  std::map<model::BatchId, FSTMutationBatch*> batch_cache_;
+
+  /**
+   * The IDs of the batches affecting each document key, mirroring the
+   * document-mutation rows of this user. Only valid while
+   * `document_index_loaded_` is true.
+   */
+  std::unordered_map<model::DocumentKey,
+                     std::set<model::BatchId>,
+                     model::DocumentKeyHash>
+      document_index_;
+  bool document_index_loaded_ = false;
 };
 
 }  // namespace local
@@ -17,7 +17,9 @@
 #include "Firestore/core/src/firebase/firestore/local/leveldb_mutation_queue.h"
 
 #include <memory>
+#include <set>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Protos/objc/firestore/local/Mutation.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
@@ -31,6 +33,7 @@
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/string_util.h"
 #include "Firestore/core/src/firebase/firestore/util/to_string.h"
+#include "Firestore/core/src/firebase/firestore/util/trace_span.h"
 #include "absl/strings/match.h"
 
 NS_ASSUME_NONNULL_BEGIN
@@ -49,6 +52,13 @@ using model::DocumentKeySet;
 using model::kBatchIdUnknown;
 using model::ResourcePath;
 
+namespace {
+
+/** The most decoded mutation batches kept in memory by a queue. */
+const size_t kMaxCachedMutationBatches = 1000;
+
+}  // namespace
+
 BatchId LoadNextBatchIdFromDb(DB* db) {
   // TODO(gsoltis): implement Prev() and SeekToLast() on
   // LevelDbTransaction::Iterator, then port this to a transaction.
@@ -127,6 +137,17 @@ LevelDbMutationQueue::LevelDbMutationQueue(const User& user,
 }
 
 void LevelDbMutationQueue::Start() {
+  metadata_ = nil;
+  batch_cache_.clear();
+  document_index_.clear();
+  document_index_loaded_ = false;
+}
+
+void LevelDbMutationQueue::EnsureLoaded() {
+  if (metadata_) {
+    return;
+  }
+
   next_batch_id_ = LoadNextBatchIdFromDb(db_.ptr);
 
   std::string key = mutation_queue_key();
@@ -152,6 +173,8 @@ bool LevelDbMutationQueue::IsEmpty() {
 
 void LevelDbMutationQueue::AcknowledgeBatch(FSTMutationBatch* batch,
                                             NSData* _Nullable stream_token) {
+  // An acknowledged batch is about to be removed, so it won't be read again.
+  batch_cache_.erase(batch.batchID);
   SetLastStreamToken(stream_token);
 }
 
@@ -159,8 +182,10 @@ FSTMutationBatch* LevelDbMutationQueue::AddMutationBatch(
     FIRTimestamp* local_write_time,
     std::vector<FSTMutation*>&& base_mutations,
     std::vector<FSTMutation*>&& mutations) {
+  EnsureLoaded();
   BatchId batch_id = next_batch_id_;
   next_batch_id_++;
+  util::TraceSpan span{"Adding mutation batch to LevelDB", batch_id};
 
   FSTMutationBatch* batch =
       [[FSTMutationBatch alloc] initWithBatchID:batch_id
@@ -168,7 +193,10 @@ FSTMutationBatch* LevelDbMutationQueue::AddMutationBatch(
                                   baseMutations:std::move(base_mutations)
                                       mutations:std::move(mutations)];
   std::string key = mutation_batch_key(batch_id);
-  db_.currentTransaction->Put(key, [serializer_ encodedMutationBatch:batch]);
+  FSTPBWriteBatch* message = [serializer_ encodedMutationBatch:batch];
+  db_.currentTransaction->Put(key, message);
+  [db_ adjustByteSize:static_cast<int64_t>(key.size() +
+                                            [message serializedSize])];
 
   // Store an empty value in the index which is equivalent to serializing a
   // GPBEmpty message. In the future if we wanted to store some other kind of
@@ -177,16 +205,53 @@ FSTMutationBatch* LevelDbMutationQueue::AddMutationBatch(
   std::string empty_buffer;
 
   for (FSTMutation* mutation : [batch mutations]) {
-    key = LevelDbDocumentMutationKey::Key(user_id_, mutation.key, batch_id);
+    LevelDbDocumentMutationKey::Key(user_id_, mutation.key, batch_id, &key);
+    db_.currentTransaction->Put(key, empty_buffer);
+
+    LevelDbCollectionMutationKey::Key(user_id_, mutation.key, batch_id, &key);
     db_.currentTransaction->Put(key, empty_buffer);
 
     db_.indexManager->AddToCollectionParentIndex(mutation.key.path().PopLast());
+
+    if (document_index_loaded_) {
+      document_index_[mutation.key].insert(batch_id);
+    }
   }
 
+  CacheMutationBatch(batch);
   return batch;
 }
 
+FSTMutationBatch* LevelDbMutationQueue::ReplaceMutationBatch(
+    FSTMutationBatch* batch, std::vector<FSTMutation*>&& mutations) {
+  HARD_ASSERT(!mutations.empty(), "Mutation batches should not be empty");
+  BatchId batch_id = batch.batchID;
+  util::TraceSpan span{"Replacing mutation batch in LevelDB", batch_id};
+
+  std::string key = mutation_batch_key(batch_id);
+  std::string old_value;
+  Status status = db_.currentTransaction->Get(key, &old_value);
+  HARD_ASSERT(status.ok(), "Mutation batch %s did not exist", DescribeKey(key));
+
+  // The documents are unchanged, so the document and collection index entries
+  // still hold.
+  std::vector<FSTMutation*> base_mutations = batch.baseMutations;
+  FSTMutationBatch* replacement =
+      [[FSTMutationBatch alloc] initWithBatchID:batch_id
+                                 localWriteTime:batch.localWriteTime
+                                  baseMutations:std::move(base_mutations)
+                                      mutations:std::move(mutations)];
+  FSTPBWriteBatch* message = [serializer_ encodedMutationBatch:replacement];
+  db_.currentTransaction->Put(key, message);
+  [db_ adjustByteSize:static_cast<int64_t>([message serializedSize]) -
+                      static_cast<int64_t>(old_value.size())];
+  batch_cache_.erase(batch_id);
+  CacheMutationBatch(replacement);
+  return replacement;
+}
+
 void LevelDbMutationQueue::RemoveMutationBatch(FSTMutationBatch* batch) {
+  util::TraceSpan span{"Removing mutation batch from LevelDB", batch.batchID};
   auto check_iterator = db_.currentTransaction->NewIterator();
 
   BatchId batch_id = batch.batchID;
@@ -202,10 +267,26 @@ void LevelDbMutationQueue::RemoveMutationBatch(FSTMutationBatch* batch) {
               "Mutation batch %s not found; found %s", DescribeKey(key),
               DescribeKey(check_iterator->key()));
 
+  [db_ adjustByteSize:-static_cast<int64_t>(key.size() +
+                                             check_iterator->value().size())];
   db_.currentTransaction->Delete(key);
+  batch_cache_.erase(batch_id);
 
   for (FSTMutation* mutation : [batch mutations]) {
-    key = LevelDbDocumentMutationKey::Key(user_id_, mutation.key, batch_id);
+    LevelDbDocumentMutationKey::Key(user_id_, mutation.key, batch_id, &key);
+    db_.currentTransaction->Delete(key);
+
+    if (document_index_loaded_) {
+      auto found = document_index_.find(mutation.key);
+      if (found != document_index_.end()) {
+        found->second.erase(batch_id);
+        if (found->second.empty()) {
+          document_index_.erase(found);
+        }
+      }
+    }
+
+    LevelDbCollectionMutationKey::Key(user_id_, mutation.key, batch_id, &key);
     db_.currentTransaction->Delete(key);
     [db_.referenceDelegate removeMutationReference:mutation.key];
   }
@@ -226,40 +307,19 @@ std::vector<FSTMutationBatch*> LevelDbMutationQueue::AllMutationBatches() {
 std::vector<FSTMutationBatch*>
 LevelDbMutationQueue::AllMutationBatchesAffectingDocumentKeys(
     const DocumentKeySet& document_keys) {
-  // Take a pass through the document keys and collect the set of unique
-  // mutation batch_ids that affect them all. Some batches can affect more than
-  // one key.
-  std::set<BatchId> batch_ids;
+  EnsureDocumentIndexLoaded();
 
-  auto index_iterator = db_.currentTransaction->NewIterator();
-  LevelDbDocumentMutationKey row_key;
+  // Collect the set of unique mutation batch_ids that affect the keys. Some
+  // batches can affect more than one key.
+  std::set<BatchId> batch_ids;
   for (const DocumentKey& document_key : document_keys) {
-    std::string index_prefix =
-        LevelDbDocumentMutationKey::KeyPrefix(user_id_, document_key.path());
-    for (index_iterator->Seek(index_prefix); index_iterator->Valid();
-         index_iterator->Next()) {
-      // Only consider rows matching exactly the specific key of interest. Index
-      // rows have this form (with markers in brackets):
-      //
-      // <User>user <Path>collection <Path>doc <BatchId>2 <Terminator>
-      // <User>user <Path>collection <Path>doc <BatchId>3 <Terminator>
-      // <User>user <Path>collection <Path>doc <Path>sub <Path>doc <BatchId>3
-      // <Terminator>
-      //
-      // Note that Path markers sort after BatchId markers so this means that
-      // when searching for collection/doc, all the entries for it will be
-      // contiguous in the table, allowing a break after any mismatch.
-      if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
-          !row_key.Decode(index_iterator->key()) ||
-          row_key.document_key() != document_key) {
-        break;
-      }
-
-      batch_ids.insert(row_key.batch_id());
+    auto found = document_index_.find(document_key);
+    if (found != document_index_.end()) {
+      batch_ids.insert(found->second.begin(), found->second.end());
     }
   }
 
-  return AllMutationBatchesWithIds(batch_ids);
+  return AllMutationBatchesWithIds({batch_ids.begin(), batch_ids.end()});
 }
 
 std::vector<FSTMutationBatch*>
@@ -276,65 +336,44 @@ LevelDbMutationQueue::AllMutationBatchesAffectingQuery(FSTQuery* query) {
       ![query isCollectionGroupQuery],
       "CollectionGroup queries should be handled in LocalDocumentsView");
 
-  const ResourcePath& query_path = query.path;
-  size_t immediate_children_path_length = query_path.size() + 1;
-
-  // TODO(mcg): Actually implement a single-collection query
-  //
-  // This is actually executing an ancestor query, traversing the whole subtree
-  // below the collection which can be horrifically inefficient for some
-  // structures. The right way to solve this is to implement the full value
-  // index, but that's not in the cards in the near future so this is the best
-  // we can do for the moment.
-  //
-  // Since we don't yet index the actual properties in the mutations, our
-  // current approach is to just return all mutation batches that affect
-  // documents in the collection being queried.
-  //
-  // Unlike allMutationBatchesAffectingDocumentKey, this iteration will scan the
-  // document-mutation index for more than a single document so the associated
-  // batchIDs will be neither necessarily unique nor in order. This means an
-  // efficient simultaneous scan isn't possible.
+  // Scan the collection-mutation index, which only contains rows for the
+  // immediate children of the collection. Rows for a single collection are
+  // ordered by batch_id so the resulting batch_ids come out sorted, though a
+  // batch that touches several documents in the collection shows up once per
+  // document.
   std::string index_prefix =
-      LevelDbDocumentMutationKey::KeyPrefix(user_id_, query_path);
+      LevelDbCollectionMutationKey::KeyPrefix(user_id_, query.path);
   auto index_iterator = db_.currentTransaction->NewIterator();
   index_iterator->Seek(index_prefix);
 
-  LevelDbDocumentMutationKey row_key;
-
-  // Collect up unique batchIDs encountered during a scan of the index. Use a
-  // set<BatchId> to accumulate batch IDs so they can be traversed in order in a
-  // scan of the main table.
-  //
-  // This method is faster than performing lookups of the keys with _db->Get and
-  // keeping a hash of batchIDs that have already been looked up. The
-  // performance difference is minor for small numbers of keys but > 30% faster
-  // for larger numbers of keys.
-  std::set<BatchId> unique_batch_ids;
+  std::vector<BatchId> batch_ids;
   for (; index_iterator->Valid(); index_iterator->Next()) {
-    if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
-        !row_key.Decode(index_iterator->key())) {
+    // Rows for subcollections share the collection's path as a prefix, but
+    // Path markers sort after BatchId markers so they all come after the rows
+    // for the collection itself. For example, rows for 'rooms/abc/messages'
+    // follow every row for 'rooms'. Only the batch_id is decoded, so the scan
+    // doesn't copy the path out of every row.
+    BatchId batch_id = 0;
+    if (!LevelDbCollectionMutationKey::DecodeBatchId(
+            index_iterator->key(), index_prefix, &batch_id)) {
       break;
     }
 
-    // Rows with document keys more than one segment longer than the query path
-    // can't be matches. For example, a query on 'rooms' can't match the
-    // document /rooms/abc/messages/xyx.
-    // TODO(mcg): we'll need a different scanner when we implement ancestor
-    // queries.
-    if (row_key.document_key().path().size() !=
-        immediate_children_path_length) {
-      continue;
+    if (batch_ids.empty() || batch_ids.back() != batch_id) {
+      batch_ids.push_back(batch_id);
     }
-
-    unique_batch_ids.insert(row_key.batch_id());
   }
 
-  return AllMutationBatchesWithIds(unique_batch_ids);
+  return AllMutationBatchesWithIds(batch_ids);
 }
 
 FSTMutationBatch* _Nullable LevelDbMutationQueue::LookupMutationBatch(
     model::BatchId batch_id) {
+  auto cached = batch_cache_.find(batch_id);
+  if (cached != batch_cache_.end()) {
+    return cached->second;
+  }
+
   std::string key = mutation_batch_key(batch_id);
 
   std::string value;
@@ -347,7 +386,7 @@ FSTMutationBatch* _Nullable LevelDbMutationQueue::LookupMutationBatch(
               batch_id, status.ToString());
   }
 
-  return ParseMutationBatch(value);
+  return DecodeMutationBatch(batch_id, value);
 }
 
 FSTMutationBatch* _Nullable LevelDbMutationQueue::NextMutationBatchAfterBatchId(
@@ -371,7 +410,7 @@ FSTMutationBatch* _Nullable LevelDbMutationQueue::NextMutationBatchAfterBatchId(
 
   HARD_ASSERT(row_key.batch_id() >= next_batch_id,
               "Should have found mutation after %s", next_batch_id);
-  return ParseMutationBatch(it->value());
+  return DecodeMutationBatch(row_key.batch_id(), it->value());
 }
 
 void LevelDbMutationQueue::PerformConsistencyCheck() {
@@ -379,21 +418,23 @@ void LevelDbMutationQueue::PerformConsistencyCheck() {
     return;
   }
 
-  // Verify that there are no entries in the document-mutation index if the
-  // queue is empty.
-  std::string index_prefix = LevelDbDocumentMutationKey::KeyPrefix(user_id_);
-  auto index_iterator = db_.currentTransaction->NewIterator();
-  index_iterator->Seek(index_prefix);
-
+  // Verify that there are no entries in the document-mutation or
+  // collection-mutation indexes if the queue is empty.
   std::vector<std::string> dangling_mutation_references;
 
-  for (; index_iterator->Valid(); index_iterator->Next()) {
-    // Only consider rows matching this index prefix for the current user.
-    if (!absl::StartsWith(index_iterator->key(), index_prefix)) {
-      break;
-    }
+  auto index_iterator = db_.currentTransaction->NewIterator();
+  for (const std::string& index_prefix :
+       {LevelDbDocumentMutationKey::KeyPrefix(user_id_),
+        LevelDbCollectionMutationKey::KeyPrefix(user_id_)}) {
+    for (index_iterator->Seek(index_prefix); index_iterator->Valid();
+         index_iterator->Next()) {
+      // Only consider rows matching this index prefix for the current user.
+      if (!absl::StartsWith(index_iterator->key(), index_prefix)) {
+        break;
+      }
 
-    dangling_mutation_references.push_back(DescribeKey(index_iterator));
+      dangling_mutation_references.push_back(DescribeKey(index_iterator));
+    }
   }
 
   HARD_ASSERT(
@@ -404,23 +445,31 @@ void LevelDbMutationQueue::PerformConsistencyCheck() {
 }
 
 NSData* _Nullable LevelDbMutationQueue::GetLastStreamToken() {
+  EnsureLoaded();
   return metadata_.lastStreamToken;
 }
 
 void LevelDbMutationQueue::SetLastStreamToken(NSData* _Nullable stream_token) {
+  EnsureLoaded();
   metadata_.lastStreamToken = stream_token;
 
   db_.currentTransaction->Put(mutation_queue_key(), metadata_);
 }
 
 std::vector<FSTMutationBatch*> LevelDbMutationQueue::AllMutationBatchesWithIds(
-    const std::set<BatchId>& batch_ids) {
+    const std::vector<BatchId>& batch_ids) {
   std::vector<FSTMutationBatch*> result;
 
   // Given an ordered set of unique batchIDs perform a skipping scan over the
   // main table to find the mutation batches.
   auto mutation_iterator = db_.currentTransaction->NewIterator();
   for (BatchId batch_id : batch_ids) {
+    auto cached = batch_cache_.find(batch_id);
+    if (cached != batch_cache_.end()) {
+      result.push_back(cached->second);
+      continue;
+    }
+
     std::string mutation_key = mutation_batch_key(batch_id);
     mutation_iterator->Seek(mutation_key);
     if (!mutation_iterator->Valid() ||
@@ -430,7 +479,7 @@ std::vector<FSTMutationBatch*> LevelDbMutationQueue::AllMutationBatchesWithIds(
                 DescribeKey(mutation_key), DescribeKey(mutation_iterator));
     }
 
-    result.push_back(ParseMutationBatch(mutation_iterator->value()));
+    result.push_back(DecodeMutationBatch(batch_id, mutation_iterator->value()));
   }
   return result;
 }
@@ -474,6 +523,44 @@ FSTMutationBatch* LevelDbMutationQueue::ParseMutationBatch(
   return [serializer_ decodedMutationBatch:proto];
 }
 
+FSTMutationBatch* LevelDbMutationQueue::DecodeMutationBatch(
+    BatchId batch_id, absl::string_view encoded) {
+  auto cached = batch_cache_.find(batch_id);
+  if (cached != batch_cache_.end()) {
+    return cached->second;
+  }
+
+  FSTMutationBatch* batch = ParseMutationBatch(encoded);
+  CacheMutationBatch(batch);
+  return batch;
+}
+
+void LevelDbMutationQueue::CacheMutationBatch(FSTMutationBatch* batch) {
+  if (batch_cache_.size() >= kMaxCachedMutationBatches &&
+      batch_cache_.find(batch.batchID) == batch_cache_.end()) {
+    // The lowest batch is the next to be acknowledged and removed.
+    batch_cache_.erase(batch_cache_.begin());
+  }
+  batch_cache_[batch.batchID] = batch;
+}
+
+void LevelDbMutationQueue::EnsureDocumentIndexLoaded() {
+  if (document_index_loaded_) {
+    return;
+  }
+
+  std::string index_prefix = LevelDbDocumentMutationKey::KeyPrefix(user_id_);
+  auto it = db_.currentTransaction->NewIterator();
+  LevelDbDocumentMutationKey row_key;
+  for (it->Seek(index_prefix);
+       it->Valid() && absl::StartsWith(it->key(), index_prefix); it->Next()) {
+    HARD_ASSERT(row_key.Decode(it->key()),
+                "Failed to decode document-mutation key %s", DescribeKey(it));
+    document_index_[row_key.document_key()].insert(row_key.batch_id());
+  }
+  document_index_loaded_ = true;
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -23,7 +23,10 @@
 
 #import <Foundation/Foundation.h>
 
+#include <functional>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
 #include "Firestore/core/src/firebase/firestore/local/query_cache.h"
@@ -118,9 +121,65 @@ class LevelDbQueryCache : public QueryCache {
   // Non-interface methods
   void Start();
 
+  /**
+   * Returns the approximate number of bytes used by the persisted remote
+   * documents, targets and mutation batches, as maintained by
+   * `AdjustByteSize`.
+   */
+  int64_t byte_size() const {
+    return metadata_.byteSize;
+  }
+
+  /**
+   * Records that the rows counted by `byte_size()` grew by `delta` bytes
+   * (or shrank, if negative) in the current transaction.
+   */
+  void AdjustByteSize(int64_t delta);
+
   void EnumerateOrphanedDocuments(const OrphanedDocumentCallback& callback);
 
+  /**
+   * Like `EnumerateOrphanedDocuments(callback)`, but starts at the document
+   * `start_key` (or at the first document if it is empty) and stops without
+   * reading any further as soon as `callback` returns false, so that a scan
+   * can be picked up where it stopped.
+   *
+   * @return The key of the document `callback` returned false for, or
+   *     `DocumentKey::Empty()` if the scan reached the end of the documents.
+   */
+  model::DocumentKey EnumerateOrphanedDocuments(
+      const model::DocumentKey& start_key,
+      const std::function<bool(const model::DocumentKey&,
+                               model::ListenSequenceNumber)>& callback);
+
+  /**
+   * Whether `AddMatchingKeys` stores the keys of a target in blocks of many
+   * keys (see `LevelDbTargetDocumentBlockKey`) rather than one row per key.
+   * Keys stored either way are always read, so this can be changed for an
+   * existing database.
+   */
+  void set_compact_target_documents_enabled(bool enabled) {
+    compact_target_documents_enabled_ = enabled;
+  }
+
  private:
+  /** Adds or removes the given keys from the key blocks of the target. */
+  void UpdateKeyBlocks(model::TargetId target_id,
+                       const model::DocumentKeySet& keys,
+                       bool add);
+
+  /**
+   * Writes the given keys to the block row `block_key`, splitting off blocks
+   * in front of it if there are too many, or deleting it if there are none.
+   */
+  void WriteKeyBlock(model::TargetId target_id,
+                     const std::string& block_key,
+                     const model::DocumentKeySet& keys);
+
+  /** Appends the keys stored in the key blocks of the target to `keys`. */
+  void ReadKeyBlocks(model::TargetId target_id,
+                     std::vector<model::DocumentKey>* keys);
+
   void Save(FSTQueryData* query_data);
   bool UpdateMetadata(FSTQueryData* query_data);
   void SaveMetadata();
@@ -136,6 +195,7 @@ class LevelDbQueryCache : public QueryCache {
   /** A write-through cached copy of the metadata for the query cache. */
   FSTPBTargetGlobal* metadata_;
   model::SnapshotVersion last_remote_snapshot_version_;
+  bool compact_target_documents_enabled_ = false;
 };
 
 }  // namespace local
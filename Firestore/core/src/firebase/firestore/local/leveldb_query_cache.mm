@@ -16,14 +16,18 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_query_cache.h"
 
+#include <algorithm>
+#include <iterator>
 #include <string>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
 #import "Firestore/Source/Local/FSTLocalSerializer.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_document_key_block.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
@@ -42,6 +46,18 @@ using model::TargetId;
 using util::MakeString;
 using leveldb::Status;
 
+namespace {
+
+/**
+ * The number of keys beyond which a key block is split, and the size of the
+ * blocks it is split into. Splitting into smaller blocks leaves room for keys
+ * to be added without splitting again right away.
+ */
+constexpr size_t kMaxKeysPerBlock = 512;
+constexpr size_t kKeysPerSplitBlock = kMaxKeysPerBlock / 2;
+
+}  // namespace
+
 FSTPBTargetGlobal* LevelDbQueryCache::ReadMetadata(leveldb::DB* db) {
   std::string key = LevelDbTargetGlobalKey::Key();
   std::string value;
@@ -112,6 +128,10 @@ void LevelDbQueryCache::RemoveTarget(FSTQueryData* query_data) {
   RemoveAllKeysForTarget(target_id);
 
   std::string key = LevelDbTargetKey::Key(target_id);
+  std::string existing;
+  if (db_.currentTransaction->Get(key, &existing).ok()) {
+    metadata_.byteSize -= static_cast<int64_t>(key.size() + existing.size());
+  }
   db_.currentTransaction->Delete(key);
 
   std::string index_key = LevelDbQueryTargetKey::Key(
@@ -173,7 +193,7 @@ FSTQueryData* _Nullable LevelDbQueryCache::GetTarget(FSTQuery* query) {
 void LevelDbQueryCache::EnumerateTargets(const TargetCallback& callback) {
   // Enumerate all targets, give their sequence numbers.
   std::string target_prefix = LevelDbTargetKey::KeyPrefix();
-  auto it = db_.currentTransaction->NewIterator();
+  auto it = db_.currentTransaction->NewMaintenanceIterator();
   it->Seek(target_prefix);
   for (; it->Valid() && absl::StartsWith(it->key(), target_prefix);
        it->Next()) {
@@ -187,7 +207,7 @@ int LevelDbQueryCache::RemoveTargets(
     const std::unordered_map<model::TargetId, FSTQueryData*>& live_targets) {
   int count = 0;
   std::string target_prefix = LevelDbTargetKey::KeyPrefix();
-  auto it = db_.currentTransaction->NewIterator();
+  auto it = db_.currentTransaction->NewMaintenanceIterator();
   it->Seek(target_prefix);
   for (; it->Valid() && absl::StartsWith(it->key(), target_prefix);
        it->Next()) {
@@ -210,12 +230,20 @@ void LevelDbQueryCache::AddMatchingKeys(const DocumentKeySet& keys,
   std::string empty_buffer;
 
   for (const DocumentKey& key : keys) {
-    db_.currentTransaction->Put(LevelDbTargetDocumentKey::Key(target_id, key),
-                                empty_buffer);
+    if (!compact_target_documents_enabled_) {
+      db_.currentTransaction->Put(
+          LevelDbTargetDocumentKey::Key(target_id, key), empty_buffer);
+    }
+    // The document-target rows are kept in either mode: garbage collection
+    // looks up the targets of a document through them.
     db_.currentTransaction->Put(LevelDbDocumentTargetKey::Key(key, target_id),
                                 empty_buffer);
     [db_.referenceDelegate addReference:key];
   };
+
+  if (compact_target_documents_enabled_) {
+    UpdateKeyBlocks(target_id, keys, /*add=*/true);
+  }
 }
 
 void LevelDbQueryCache::RemoveMatchingKeys(const DocumentKeySet& keys,
@@ -227,9 +255,29 @@ void LevelDbQueryCache::RemoveMatchingKeys(const DocumentKeySet& keys,
         LevelDbDocumentTargetKey::Key(key, target_id));
     [db_.referenceDelegate removeReference:key];
   }
+
+  // The keys may have been added to blocks while compact storage was enabled.
+  UpdateKeyBlocks(target_id, keys, /*add=*/false);
 }
 
 void LevelDbQueryCache::RemoveAllKeysForTarget(TargetId target_id) {
+  std::vector<DocumentKey> block_keys;
+  ReadKeyBlocks(target_id, &block_keys);
+  for (const DocumentKey& document_key : block_keys) {
+    db_.currentTransaction->Delete(
+        LevelDbDocumentTargetKey::Key(document_key, target_id));
+  }
+
+  std::string block_prefix =
+      LevelDbTargetDocumentBlockKey::KeyPrefix(target_id);
+  auto block_iterator = db_.currentTransaction->NewIterator();
+  for (block_iterator->Seek(block_prefix);
+       block_iterator->Valid() &&
+       absl::StartsWith(block_iterator->key(), block_prefix);
+       block_iterator->Next()) {
+    db_.currentTransaction->Delete(block_iterator->key());
+  }
+
   std::string index_prefix = LevelDbTargetDocumentKey::KeyPrefix(target_id);
   auto index_iterator = db_.currentTransaction->NewIterator();
   index_iterator->Seek(index_prefix);
@@ -256,7 +304,9 @@ DocumentKeySet LevelDbQueryCache::GetMatchingKeys(TargetId target_id) {
   auto index_iterator = db_.currentTransaction->NewIterator();
   index_iterator->Seek(index_prefix);
 
-  DocumentKeySet result;
+  // Rows are ordered by document key, so the keys can be collected in order
+  // and built into a set in one pass.
+  std::vector<DocumentKey> result;
   LevelDbTargetDocumentKey row_key;
   for (; index_iterator->Valid(); index_iterator->Next()) {
     // TODO(gsoltis): could we use a StartsWith instead?
@@ -266,10 +316,112 @@ DocumentKeySet LevelDbQueryCache::GetMatchingKeys(TargetId target_id) {
       break;
     }
 
-    result = result.insert(row_key.document_key());
+    result.push_back(row_key.document_key());
+  }
+
+  // Blocks are ordered by key too, but a key may have been stored both ways
+  // if compact storage was toggled.
+  std::vector<DocumentKey> block_keys;
+  ReadKeyBlocks(target_id, &block_keys);
+  if (!block_keys.empty()) {
+    if (result.empty()) {
+      result = std::move(block_keys);
+    } else {
+      std::vector<DocumentKey> merged;
+      merged.reserve(result.size() + block_keys.size());
+      std::set_union(result.begin(), result.end(), block_keys.begin(),
+                     block_keys.end(), std::back_inserter(merged));
+      result = std::move(merged);
+    }
+  }
+
+  return DocumentKeySet::FromSorted(result.begin(), result.end());
+}
+
+void LevelDbQueryCache::UpdateKeyBlocks(TargetId target_id,
+                                        const DocumentKeySet& keys,
+                                        bool add) {
+  std::string block_prefix =
+      LevelDbTargetDocumentBlockKey::KeyPrefix(target_id);
+  auto block_iterator = db_.currentTransaction->NewIterator();
+  LevelDbTargetDocumentBlockKey block_key;
+
+  auto next = keys.begin();
+  while (next != keys.end()) {
+    // A key belongs to the first block whose key sorts at or after it.
+    block_iterator->Seek(LevelDbTargetDocumentBlockKey::Key(target_id, *next));
+
+    std::string row_key;
+    std::vector<DocumentKey> contents;
+    bool bounded = false;
+    if (block_iterator->Valid() &&
+        absl::StartsWith(block_iterator->key(), block_prefix)) {
+      if (!block_key.Decode(block_iterator->key()) ||
+          !LevelDbDocumentKeyBlock::Decode(block_iterator->value(),
+                                           &contents)) {
+        HARD_FAIL("Invalid target document block %s",
+                  DescribeKey(block_iterator));
+      }
+      row_key = std::string{block_iterator->key()};
+      bounded = block_key.bounded();
+    } else if (add) {
+      row_key = LevelDbTargetDocumentBlockKey::UnboundedKey(target_id);
+    } else {
+      // No block holds this key or any key after it.
+      return;
+    }
+
+    // Apply all the changes falling into this block in one rewrite.
+    DocumentKeySet block =
+        DocumentKeySet::FromSorted(contents.begin(), contents.end());
+    for (; next != keys.end() && (!bounded || *next <= block_key.upper_bound());
+         ++next) {
+      block = add ? std::move(block).insert(*next)
+                  : std::move(block).erase(*next);
+    }
+    WriteKeyBlock(target_id, row_key, block);
+  }
+}
+
+void LevelDbQueryCache::WriteKeyBlock(TargetId target_id,
+                                      const std::string& block_key,
+                                      const DocumentKeySet& keys) {
+  if (keys.empty()) {
+    db_.currentTransaction->Delete(block_key);
+    return;
+  }
+
+  // Keys split off into blocks of their own are bounded by the last key of
+  // each; the remaining ones keep the bound of the original block.
+  std::vector<DocumentKey> sorted{keys.begin(), keys.end()};
+  auto begin = sorted.begin();
+  while (static_cast<size_t>(sorted.end() - begin) > kMaxKeysPerBlock) {
+    auto end = begin + kKeysPerSplitBlock;
+    std::vector<DocumentKey> split{begin, end};
+    db_.currentTransaction->Put(
+        LevelDbTargetDocumentBlockKey::Key(target_id, split.back()),
+        LevelDbDocumentKeyBlock::Encode(split));
+    begin = end;
   }
 
-  return result;
+  std::vector<DocumentKey> rest{begin, sorted.end()};
+  db_.currentTransaction->Put(block_key, LevelDbDocumentKeyBlock::Encode(rest));
+}
+
+void LevelDbQueryCache::ReadKeyBlocks(TargetId target_id,
+                                      std::vector<DocumentKey>* keys) {
+  std::string block_prefix =
+      LevelDbTargetDocumentBlockKey::KeyPrefix(target_id);
+  auto block_iterator = db_.currentTransaction->NewIterator();
+  for (block_iterator->Seek(block_prefix);
+       block_iterator->Valid() &&
+       absl::StartsWith(block_iterator->key(), block_prefix);
+       block_iterator->Next()) {
+    if (!LevelDbDocumentKeyBlock::Decode(block_iterator->value(), keys)) {
+      HARD_FAIL("Invalid target document block %s",
+                DescribeKey(block_iterator));
+    }
+  }
 }
 
 bool LevelDbQueryCache::Contains(const DocumentKey& key) {
@@ -306,9 +458,27 @@ void LevelDbQueryCache::SetLastRemoteSnapshotVersion(SnapshotVersion version) {
 
 void LevelDbQueryCache::EnumerateOrphanedDocuments(
     const OrphanedDocumentCallback& callback) {
+  EnumerateOrphanedDocuments(
+      DocumentKey::Empty(),
+      [&callback](const DocumentKey& key,
+                  ListenSequenceNumber sequence_number) {
+        callback(key, sequence_number);
+        return true;
+      });
+}
+
+DocumentKey LevelDbQueryCache::EnumerateOrphanedDocuments(
+    const DocumentKey& start_key,
+    const std::function<bool(const DocumentKey&, ListenSequenceNumber)>&
+        callback) {
   std::string document_target_prefix = LevelDbDocumentTargetKey::KeyPrefix();
-  auto it = db_.currentTransaction->NewIterator();
-  it->Seek(document_target_prefix);
+  auto it = db_.currentTransaction->NewMaintenanceIterator();
+  if (start_key.path().empty()) {
+    it->Seek(document_target_prefix);
+  } else {
+    // The sentinel row sorts before the target rows of its document.
+    it->Seek(LevelDbDocumentTargetKey::SentinelKey(start_key));
+  }
   ListenSequenceNumber next_to_report = 0;
   DocumentKey key_to_report;
   LevelDbDocumentTargetKey key;
@@ -319,8 +489,8 @@ void LevelDbQueryCache::EnumerateOrphanedDocuments(
     if (key.IsSentinel()) {
       // if next_to_report is non-zero, report it, this is a new key so the last
       // one must be not be a member of any targets.
-      if (next_to_report != 0) {
-        callback(key_to_report, next_to_report);
+      if (next_to_report != 0 && !callback(key_to_report, next_to_report)) {
+        return key_to_report;
       }
       // set next_to_report to be this sequence number. It's the next one we
       // might report, if we don't find any targets for this document.
@@ -335,15 +505,25 @@ void LevelDbQueryCache::EnumerateOrphanedDocuments(
   }
   // if next_to_report is non-zero, report it. We didn't find any targets for
   // that document, and we weren't asked to stop.
-  if (next_to_report != 0) {
-    callback(key_to_report, next_to_report);
+  if (next_to_report != 0 && !callback(key_to_report, next_to_report)) {
+    return key_to_report;
   }
+  return DocumentKey::Empty();
 }
 
 void LevelDbQueryCache::Save(FSTQueryData* query_data) {
   TargetId target_id = query_data.targetID;
   std::string key = LevelDbTargetKey::Key(target_id);
-  db_.currentTransaction->Put(key, [serializer_ encodedQueryData:query_data]);
+  FSTPBTarget* target = [serializer_ encodedQueryData:query_data];
+
+  auto delta = static_cast<int64_t>(key.size() + [target serializedSize]);
+  std::string existing;
+  if (db_.currentTransaction->Get(key, &existing).ok()) {
+    delta -= static_cast<int64_t>(key.size() + existing.size());
+  }
+
+  db_.currentTransaction->Put(key, target);
+  AdjustByteSize(delta);
 }
 
 bool LevelDbQueryCache::UpdateMetadata(FSTQueryData* query_data) {
@@ -361,6 +541,13 @@ bool LevelDbQueryCache::UpdateMetadata(FSTQueryData* query_data) {
   return updated;
 }
 
+void LevelDbQueryCache::AdjustByteSize(int64_t delta) {
+  if (delta == 0) return;
+
+  metadata_.byteSize += delta;
+  SaveMetadata();
+}
+
 void LevelDbQueryCache::SaveMetadata() {
   db_.currentTransaction->Put(LevelDbTargetGlobalKey::Key(), metadata_);
 }
@@ -21,13 +21,27 @@
 #error "For now, this file must only be included by ObjC source files."
 #endif  // !defined(__OBJC__)
 
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_document_compressor.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_field_index.h"
+#include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
 #include "absl/strings/string_view.h"
 
 @class FSTLevelDB;
@@ -41,25 +55,214 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
+class TopDocuments;
+
 /** Cached Remote Documents backed by leveldb. */
 class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
  public:
   LevelDbRemoteDocumentCache(FSTLevelDB* db, FSTLocalSerializer* serializer);
 
-  void Add(FSTMaybeDocument* document) override;
+  void Add(FSTMaybeDocument* document,
+           const model::SnapshotVersion& read_time) override;
   void Remove(const model::DocumentKey& key) override;
 
   FSTMaybeDocument* _Nullable Get(const model::DocumentKey& key) override;
   model::MaybeDocumentMap GetAll(const model::DocumentKeySet& keys) override;
-  model::DocumentMap GetMatching(FSTQuery* query) override;
+  model::DocumentMap GetMatching(
+      FSTQuery* query, QueryExecutionStats* _Nullable stats) override;
+  model::DocumentMap GetFirstMatching(
+      FSTQuery* query,
+      size_t count,
+      QueryExecutionStats* _Nullable stats) override;
+  model::DocumentMap GetMatching(
+      FSTQuery* query,
+      const model::SnapshotVersion& since_read_time,
+      QueryExecutionStats* _Nullable stats) override;
+  model::DocumentMap GetAllInCollectionGroup(
+      const std::string& collection_id,
+      QueryExecutionStats* _Nullable stats) override;
+
+  /**
+   * Cached documents decoded straight into the C++ model, keyed by document
+   * key.
+   */
+  using ModelMaybeDocumentMap =
+      std::map<model::DocumentKey, std::unique_ptr<model::MaybeDocument>>;
+  using ModelDocumentMap =
+      std::map<model::DocumentKey, std::unique_ptr<model::Document>>;
+
+  /**
+   * Equivalent to `GetAll`, but decodes entries directly from the bytes
+   * stored in LevelDB into the C++ model, without going through the
+   * Objective-C protos and FSTFieldValue trees.
+   *
+   * @return The cached entries indexed by key. If an entry is not cached, the
+   * corresponding key will be mapped to nullptr.
+   */
+  ModelMaybeDocumentMap GetAllModels(const model::DocumentKeySet& keys);
+
+  /**
+   * Equivalent to `GetMatching`, but decodes entries directly from the bytes
+   * stored in LevelDB into the C++ model. Only documents matching the query
+   * are returned.
+   */
+  ModelDocumentMap GetMatchingModels(const core::Query& query);
+
+  /**
+   * Returns the number of bytes used by the cached documents of all
+   * collections with the given collection ID.
+   */
+  int64_t GetCollectionGroupByteSize(absl::string_view collection_id);
+
+  /**
+   * Sets whether documents are encoded and decoded by `LocalSerializer`
+   * rather than through the Objective-C protos of `FSTLocalSerializer`. Both
+   * produce the same bytes, so documents written either way can be read
+   * either way.
+   */
+  void set_native_serialization_enabled(bool enabled) {
+    native_serialization_enabled_ = enabled;
+  }
+
+  /**
+   * Sets whether document values are compressed with the dictionary of their
+   * collection when written. Compressed and uncompressed values are always
+   * both readable, so this can be changed on an existing cache.
+   */
+  void set_value_compression_enabled(bool enabled) {
+    value_compression_enabled_ = enabled;
+  }
+
+  /**
+   * The number of document reads answered from the cache of decoded
+   * documents, without decoding.
+   */
+  int64_t decoded_cache_hits() const {
+    return decoded_cache_hits_;
+  }
+
+  /** The number of documents decoded because they weren't in the cache. */
+  int64_t decoded_cache_misses() const {
+    return decoded_cache_misses_;
+  }
 
  private:
+  /**
+   * Adds `delta` to the stored byte size of the collection group the given
+   * document belongs to.
+   */
+  void AdjustCollectionGroupByteSize(const model::DocumentKey& key,
+                                     int64_t delta);
+
+  /**
+   * Records the read time of the given document in the read time index,
+   * replacing its previous row if there is one. Index rows are not counted in
+   * the byte size of the cache.
+   */
+  void WriteReadTime(const model::DocumentKey& key,
+                     const model::SnapshotVersion& read_time);
+
+  /** Removes the given document from the read time index. */
+  void DeleteReadTime(const model::DocumentKey& key);
+
+  /**
+   * Implements `GetMatching`, or `GetFirstMatching` if `top` is not null, in
+   * which case the documents read are offered to `top` and only those it
+   * keeps are returned.
+   */
+  model::DocumentMap CollectMatching(FSTQuery* query,
+                                     TopDocuments* _Nullable top,
+                                     QueryExecutionStats* _Nullable stats);
+
+  /**
+   * Returns all documents that are immediate children of the given
+   * collection, optionally writing field index entries for each of them. If
+   * `top` is not null, returns only the documents it keeps instead.
+   */
+  model::DocumentMap GetAllInCollection(
+      const model::ResourcePath& collection_path,
+      bool add_to_field_index,
+      TopDocuments* _Nullable top,
+      QueryExecutionStats* _Nullable stats);
+
+  /**
+   * Returns the documents the field index identifies as candidates for the
+   * query, or only those `top` keeps if it's not null. The query's collection
+   * must already be indexed.
+   */
+  model::DocumentMap GetMatchingFromFieldIndex(
+      FSTQuery* query,
+      TopDocuments* _Nullable top,
+      QueryExecutionStats* _Nullable stats);
+
   FSTMaybeDocument* DecodeMaybeDocument(absl::string_view encoded,
                                         const model::DocumentKey& key);
 
+  /**
+   * Encodes the given document with `LocalSerializer` into `encoded`.
+   * Returns false if the document contains values the C++ serializer doesn't
+   * support yet, in which case it must be encoded by `FSTLocalSerializer`.
+   */
+  bool EncodeMaybeDocumentNatively(FSTMaybeDocument* document,
+                                   std::string* encoded);
+
+  /**
+   * Decodes the given bytes with `LocalSerializer`. Returns nil if they
+   * contain values the C++ serializer doesn't support yet.
+   */
+  FSTMaybeDocument* _Nullable DecodeMaybeDocumentNatively(
+      absl::string_view encoded);
+
+  std::unique_ptr<model::MaybeDocument> DecodeMaybeDocumentModel(
+      absl::string_view encoded, const model::DocumentKey& key);
+
+  /**
+   * Returns the decoded document with the given key from the cache, marking
+   * it as the most recently used, or nil if it isn't cached.
+   */
+  FSTMaybeDocument* _Nullable LookupDecoded(const model::DocumentKey& key);
+
+  /**
+   * Adds a decoded document to the cache, evicting the least recently used
+   * documents until the cache fits in its budget. `byte_size` is the size of
+   * the document's encoded row.
+   */
+  void CacheDecoded(FSTMaybeDocument* document, size_t byte_size);
+
+  /** Drops the decoded document with the given key from the cache. */
+  void UncacheDecoded(const model::DocumentKey& key);
+
+  struct CachedDocument {
+    FSTMaybeDocument* document;
+    size_t byte_size;
+    std::list<model::DocumentKey>::iterator lru_position;
+  };
+
   // This instance is owned by FSTLevelDB; avoid a retain cycle.
   __weak FSTLevelDB* db_;
   FSTLocalSerializer* serializer_;
+  remote::Serializer rpc_serializer_;
+  LocalSerializer local_serializer_;
+  LevelDbFieldIndex field_index_;
+  bool native_serialization_enabled_ = false;
+  LevelDbDocumentCompressor compressor_;
+  bool value_compression_enabled_ = false;
+
+  /**
+   * Recently decoded documents, kept coherent with `Add` and `Remove`. Every
+   * write goes through the transaction of this instance's FSTLevelDB, which
+   * commits every transaction it starts, so there are no aborted writes to
+   * roll back.
+   */
+  std::unordered_map<model::DocumentKey,
+                     CachedDocument,
+                     model::DocumentKeyHash>
+      decoded_cache_;
+  // Keys of the cached documents, from the most to the least recently used.
+  std::list<model::DocumentKey> decoded_lru_;
+  size_t decoded_cache_bytes_ = 0;
+  int64_t decoded_cache_hits_ = 0;
+  int64_t decoded_cache_misses_ = 0;
 };
 
 }  // namespace local
@@ -18,48 +18,393 @@
 
 #import <Foundation/Foundation.h>
 
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
+#import "FIRGeoPoint.h"
+#import "FIRTimestamp.h"
 #import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
 #import "Firestore/Source/Local/FSTLocalSerializer.h"
 #import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTFieldValue.h"
 
+#include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
+#include "Firestore/core/src/firebase/firestore/local/top_documents.h"
+#include "Firestore/core/src/firebase/firestore/model/no_document.h"
+#include "Firestore/core/src/firebase/firestore/model/unknown_document.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/arena.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/match.h"
 #include "leveldb/db.h"
 
+using firebase::firestore::model::Document;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
+using firebase::firestore::model::DocumentState;
+using firebase::firestore::model::FieldValue;
+using firebase::firestore::model::MaybeDocument;
 using firebase::firestore::model::MaybeDocumentMap;
+using firebase::firestore::model::NoDocument;
+using firebase::firestore::model::ObjectValue;
+using firebase::firestore::model::ResourcePath;
+using firebase::firestore::model::SnapshotVersion;
+using firebase::firestore::model::ToFSTObjectValue;
+using firebase::firestore::model::UnknownDocument;
+using firebase::firestore::nanopb::Arena;
+using firebase::firestore::nanopb::Reader;
+using firebase::firestore::nanopb::Writer;
 using leveldb::Status;
 
 namespace firebase {
 namespace firestore {
 namespace local {
 
+namespace {
+
+/**
+ * The number of rows a sweep through a run of sibling documents steps over
+ * before giving up and seeking directly to the next key. Stepping is cheap
+ * while the requested documents are dense in their collection, but a seek is
+ * better when they are far apart.
+ */
+const int kMaxSweepSteps = 16;
+
+/**
+ * The budget of the decoded document cache, in bytes of encoded rows. The
+ * decoded documents take more memory than their rows.
+ */
+const size_t kDecodedDocumentCacheBytes = 4 * 1024 * 1024;
+
+/**
+ * Reads rows of the remote document table for an ascending sequence of
+ * document keys using a single iterator.
+ *
+ * Consecutive keys that share a parent path form a run, which is typical of
+ * the documents in a RemoteEvent. Within a run the iterator sweeps forward
+ * through the collection's rows with Next() instead of seeking for every key;
+ * a seek is only issued at the start of a run or when the next key is too far
+ * ahead.
+ */
+class RemoteDocumentReader {
+ public:
+  explicit RemoteDocumentReader(LevelDbTransaction* transaction)
+      : it_(transaction->NewIterator()) {
+  }
+
+  /**
+   * Positions the reader at the row for the given key, which must sort after
+   * every key previously passed to Find. Returns true if the row exists, in
+   * which case its contents are available from value().
+   */
+  bool Find(const DocumentKey& key) {
+    LevelDbRemoteDocumentKey::Key(key, &ldb_key_);
+    const std::string& ldb_key = ldb_key_;
+    bool in_run = has_run_ && collection_path_.IsImmediateParentOf(key.path());
+
+    if (in_run) {
+      for (int steps = 0; steps < kMaxSweepSteps && it_->Valid() &&
+                          it_->key() < ldb_key;
+           ++steps) {
+        it_->Next();
+      }
+      // Reaching the end of the table within a run means the rest of the run
+      // is missing too.
+      if (!it_->Valid()) return false;
+    } else {
+      has_run_ = true;
+      collection_path_ = key.path().PopLast();
+    }
+
+    if (!it_->Valid() || it_->key() < ldb_key) {
+      it_->Seek(ldb_key);
+    }
+
+    // Keys have a single encoding, so there's no need to decode the row's.
+    return it_->Valid() && it_->key() == ldb_key;
+  }
+
+  absl::string_view value() {
+    return it_->value();
+  }
+
+ private:
+  std::unique_ptr<LevelDbTransaction::Iterator> it_;
+  // Reused to encode every key passed to Find.
+  std::string ldb_key_;
+
+  bool has_run_ = false;
+  ResourcePath collection_path_;
+};
+
+bool ToModelValue(FSTFieldValue* value, FieldValue* result);
+
+bool ToModelMap(FSTObjectValue* object, FieldValue::Map* result) {
+  FieldValue::Map map;
+  for (const auto& entry : object.internalValue) {
+    FieldValue converted;
+    if (!ToModelValue(entry.second, &converted)) {
+      *result = std::move(map);
+      return false;
+    }
+    map = std::move(map).insert(util::MakeString(entry.first),
+                                std::move(converted));
+  }
+  *result = std::move(map);
+  return true;
+}
+
+/**
+ * Converts an FSTFieldValue to the C++ model. Returns false if the value is
+ * or contains a reference, which remote::Serializer can't encode yet.
+ */
+bool ToModelValue(FSTFieldValue* value, FieldValue* result) {
+  switch (value.type) {
+    case FieldValue::Type::Null:
+      *result = FieldValue::Null();
+      return true;
+
+    case FieldValue::Type::Boolean:
+    case FieldValue::Type::String:
+      *result = static_cast<FSTDelegateValue*>(value).internalValue;
+      return true;
+
+    case FieldValue::Type::Integer:
+      *result = FieldValue::FromInteger(
+          static_cast<FSTIntegerValue*>(value).internalValue);
+      return true;
+
+    case FieldValue::Type::Double:
+      *result = FieldValue::FromDouble(
+          static_cast<FSTDoubleValue*>(value).internalValue);
+      return true;
+
+    case FieldValue::Type::Timestamp: {
+      FIRTimestamp* timestamp = static_cast<FIRTimestamp*>([value value]);
+      *result = FieldValue::FromTimestamp(
+          Timestamp{timestamp.seconds, timestamp.nanoseconds});
+      return true;
+    }
+
+    case FieldValue::Type::Blob: {
+      NSData* data = static_cast<NSData*>([value value]);
+      *result = FieldValue::FromBlob(
+          static_cast<const uint8_t*>(data.bytes), data.length);
+      return true;
+    }
+
+    case FieldValue::Type::GeoPoint: {
+      FIRGeoPoint* point = static_cast<FIRGeoPoint*>([value value]);
+      *result =
+          FieldValue::FromGeoPoint(GeoPoint{point.latitude, point.longitude});
+      return true;
+    }
+
+    case FieldValue::Type::Array: {
+      NSArray<FSTFieldValue*>* elements =
+          static_cast<FSTArrayValue*>(value).internalValue;
+      std::vector<FieldValue> array;
+      array.reserve(elements.count);
+      for (FSTFieldValue* element in elements) {
+        FieldValue converted;
+        if (!ToModelValue(element, &converted)) return false;
+        array.push_back(std::move(converted));
+      }
+      *result = FieldValue::FromArray(std::move(array));
+      return true;
+    }
+
+    case FieldValue::Type::Object: {
+      FieldValue::Map map;
+      if (!ToModelMap(static_cast<FSTObjectValue*>(value), &map)) return false;
+      *result = FieldValue::FromMap(std::move(map));
+      return true;
+    }
+
+    case FieldValue::Type::Reference:
+      return false;
+
+    case FieldValue::Type::ServerTimestamp:
+      HARD_FAIL("Unhandled type %s on %s", NSStringFromClass([value class]),
+                value);
+  }
+  UNREACHABLE();
+}
+
+}  // namespace
+
 LevelDbRemoteDocumentCache::LevelDbRemoteDocumentCache(
     FSTLevelDB* db, FSTLocalSerializer* serializer)
-    : db_(db), serializer_(serializer) {
+    : db_(db),
+      serializer_(serializer),
+      rpc_serializer_(*serializer.remoteSerializer.databaseID),
+      local_serializer_(rpc_serializer_),
+      field_index_(db) {
 }
 
-void LevelDbRemoteDocumentCache::Add(FSTMaybeDocument* document) {
+void LevelDbRemoteDocumentCache::Add(FSTMaybeDocument* document,
+                                     const SnapshotVersion& read_time) {
   std::string ldb_key = LevelDbRemoteDocumentKey::Key(document.key);
-  db_.currentTransaction->Put(ldb_key,
-                              [serializer_ encodedMaybeDocument:document]);
+  std::string existing_value;
+  bool exists = db_.currentTransaction->Get(ldb_key, &existing_value).ok();
+
+  if (field_index_.IsCollectionIndexed(document.key.path().PopLast())) {
+    FSTMaybeDocument* existing =
+        exists ? DecodeMaybeDocument(existing_value, document.key) : nil;
+    if ([existing isKindOfClass:[FSTDocument class]]) {
+      field_index_.RemoveEntries(static_cast<FSTDocument*>(existing));
+    }
+    if ([document isKindOfClass:[FSTDocument class]]) {
+      field_index_.AddEntries(static_cast<FSTDocument*>(document));
+    }
+  }
+
+  std::string native_value;
+  FSTPBMaybeDocument* message = nil;
+  bool native = native_serialization_enabled_ &&
+                EncodeMaybeDocumentNatively(document, &native_value);
+  if (!native) {
+    message = [serializer_ encodedMaybeDocument:document];
+  }
+
+  if (value_compression_enabled_) {
+    if (!native) {
+      NSData* data = [message data];
+      native_value.assign(static_cast<const char*>(data.bytes), data.length);
+      message = nil;
+      native = true;
+    }
+    native_value = compressor_.Encode(db_.currentTransaction, document.key,
+                                      std::move(native_value));
+  }
+
+  size_t value_size = native ? native_value.size() : [message serializedSize];
+  auto delta = static_cast<int64_t>(ldb_key.size() + value_size);
+  if (exists) {
+    delta -= static_cast<int64_t>(ldb_key.size() + existing_value.size());
+  }
+
+  if (native) {
+    db_.currentTransaction->Put(ldb_key, native_value);
+  } else {
+    db_.currentTransaction->Put(ldb_key, message);
+  }
+  if (!exists) {
+    std::string empty_buffer;
+    db_.currentTransaction->Put(
+        LevelDbCollectionGroupDocumentKey::Key(document.key), empty_buffer);
+  }
+  [db_ adjustByteSize:delta];
+  AdjustCollectionGroupByteSize(document.key, delta);
+  WriteReadTime(document.key, read_time);
+  UncacheDecoded(document.key);
 
   db_.indexManager->AddToCollectionParentIndex(document.key.path().PopLast());
 }
 
 void LevelDbRemoteDocumentCache::Remove(const DocumentKey& key) {
   std::string ldb_key = LevelDbRemoteDocumentKey::Key(key);
+  std::string existing_value;
+  if (!db_.currentTransaction->Get(ldb_key, &existing_value).ok()) {
+    return;
+  }
+
+  if (field_index_.IsCollectionIndexed(key.path().PopLast())) {
+    FSTMaybeDocument* existing = DecodeMaybeDocument(existing_value, key);
+    if ([existing isKindOfClass:[FSTDocument class]]) {
+      field_index_.RemoveEntries(static_cast<FSTDocument*>(existing));
+    }
+  }
+
   db_.currentTransaction->Delete(ldb_key);
+  db_.currentTransaction->Delete(LevelDbCollectionGroupDocumentKey::Key(key));
+  auto delta = -static_cast<int64_t>(ldb_key.size() + existing_value.size());
+  [db_ adjustByteSize:delta];
+  AdjustCollectionGroupByteSize(key, delta);
+  DeleteReadTime(key);
+  UncacheDecoded(key);
+}
+
+void LevelDbRemoteDocumentCache::WriteReadTime(
+    const DocumentKey& key, const SnapshotVersion& read_time) {
+  std::string reverse_key = LevelDbDocumentReadTimeKey::Key(key);
+  std::string existing_value;
+  SnapshotVersion existing_read_time;
+  if (db_.currentTransaction->Get(reverse_key, &existing_value).ok() &&
+      LevelDbDocumentReadTimeKey::DecodeReadTime(existing_value,
+                                                 &existing_read_time)) {
+    if (existing_read_time == read_time) return;
+    db_.currentTransaction->Delete(
+        LevelDbRemoteDocumentReadTimeKey::Key(key, existing_read_time));
+  }
+
+  std::string empty_buffer;
+  db_.currentTransaction->Put(
+      LevelDbRemoteDocumentReadTimeKey::Key(key, read_time), empty_buffer);
+  db_.currentTransaction->Put(
+      reverse_key, LevelDbDocumentReadTimeKey::EncodeReadTime(read_time));
+}
+
+void LevelDbRemoteDocumentCache::DeleteReadTime(const DocumentKey& key) {
+  std::string reverse_key = LevelDbDocumentReadTimeKey::Key(key);
+  std::string existing_value;
+  if (!db_.currentTransaction->Get(reverse_key, &existing_value).ok()) {
+    return;
+  }
+
+  SnapshotVersion existing_read_time;
+  if (LevelDbDocumentReadTimeKey::DecodeReadTime(existing_value,
+                                                 &existing_read_time)) {
+    db_.currentTransaction->Delete(
+        LevelDbRemoteDocumentReadTimeKey::Key(key, existing_read_time));
+  }
+  db_.currentTransaction->Delete(reverse_key);
+}
+
+int64_t LevelDbRemoteDocumentCache::GetCollectionGroupByteSize(
+    absl::string_view collection_id) {
+  std::string value;
+  Status status = db_.currentTransaction->Get(
+      LevelDbCollectionGroupSizeKey::Key(collection_id), &value);
+  if (status.IsNotFound()) {
+    return 0;
+  } else if (!status.ok()) {
+    HARD_FAIL("Fetch collection group size for %s failed with status: %s",
+              collection_id, status.ToString());
+  }
+  return LevelDbCollectionGroupSizeKey::DecodeSize(value);
+}
+
+void LevelDbRemoteDocumentCache::AdjustCollectionGroupByteSize(
+    const DocumentKey& key, int64_t delta) {
+  if (delta == 0) return;
+
+  const std::string& collection_id = key.path()[key.path().size() - 2];
+  int64_t size = GetCollectionGroupByteSize(collection_id) + delta;
+  db_.currentTransaction->Put(
+      LevelDbCollectionGroupSizeKey::Key(collection_id),
+      LevelDbCollectionGroupSizeKey::EncodeSize(size));
 }
 
 FSTMaybeDocument* _Nullable LevelDbRemoteDocumentCache::Get(
     const DocumentKey& key) {
+  FSTMaybeDocument* cached = LookupDecoded(key);
+  if (cached) {
+    return cached;
+  }
+
   std::string ldb_key = LevelDbRemoteDocumentKey::Key(key);
   std::string value;
   Status status = db_.currentTransaction->Get(ldb_key, &value);
@@ -75,68 +420,343 @@ FSTMaybeDocument* _Nullable LevelDbRemoteDocumentCache::Get(
 
 MaybeDocumentMap LevelDbRemoteDocumentCache::GetAll(
     const DocumentKeySet& keys) {
-  MaybeDocumentMap results;
+  // `keys` is sorted, so the results can be collected in order and built into
+  // a map in one pass.
+  std::vector<MaybeDocumentMap::value_type> results;
+  results.reserve(keys.size());
 
-  LevelDbRemoteDocumentKey currentKey;
-  auto it = db_.currentTransaction->NewIterator();
+  RemoteDocumentReader reader(db_.currentTransaction);
+  for (const DocumentKey& key : keys) {
+    FSTMaybeDocument* cached = LookupDecoded(key);
+    if (cached) {
+      results.emplace_back(key, cached);
+    } else if (reader.Find(key)) {
+      results.emplace_back(key, DecodeMaybeDocument(reader.value(), key));
+    } else {
+      results.emplace_back(key, nil);
+    }
+  }
 
+  return MaybeDocumentMap::FromSorted(results.begin(), results.end());
+}
+
+LevelDbRemoteDocumentCache::ModelMaybeDocumentMap
+LevelDbRemoteDocumentCache::GetAllModels(const DocumentKeySet& keys) {
+  ModelMaybeDocumentMap results;
+
+  RemoteDocumentReader reader(db_.currentTransaction);
   for (const DocumentKey& key : keys) {
-    it->Seek(LevelDbRemoteDocumentKey::Key(key));
-    if (!it->Valid() || !currentKey.Decode(it->key()) ||
-        currentKey.document_key() != key) {
-      results = results.insert(key, nil);
+    if (reader.Find(key)) {
+      results.emplace(key, DecodeMaybeDocumentModel(reader.value(), key));
     } else {
-      results = results.insert(key, DecodeMaybeDocument(it->value(), key));
+      results.emplace(key, nullptr);
+    }
+  }
+
+  return results;
+}
+
+LevelDbRemoteDocumentCache::ModelDocumentMap
+LevelDbRemoteDocumentCache::GetMatchingModels(const core::Query& query) {
+  HARD_ASSERT(!query.IsDocumentQuery(),
+              "Document queries shouldn't go down this path");
+
+  ModelDocumentMap results;
+
+  // Documents are ordered by key, so we can use a prefix scan to narrow down
+  // the documents we need to match the query against.
+  const ResourcePath& query_path = query.path();
+  std::string start_key = LevelDbRemoteDocumentKey::KeyPrefix(query_path);
+  auto it = db_.currentTransaction->NewIterator();
+  it->Seek(start_key);
+
+  // Rows in subcollections are skipped without copying their paths.
+  LevelDbRemoteDocumentKeyView current_key;
+  for (; it->Valid() && current_key.Decode(it->key()); it->Next()) {
+    if (!current_key.HasPrefix(query_path)) {
+      break;
+    }
+    if (current_key.segments().size() != query_path.size() + 1) {
+      continue;
+    }
+    DocumentKey document_key = current_key.ToDocumentKey();
+
+    std::unique_ptr<MaybeDocument> maybe_doc =
+        DecodeMaybeDocumentModel(it->value(), document_key);
+    if (maybe_doc->type() != MaybeDocument::Type::Document) {
+      continue;
+    }
+
+    std::unique_ptr<Document> doc(static_cast<Document*>(maybe_doc.release()));
+    if (query.Matches(*doc)) {
+      results.emplace(document_key, std::move(doc));
     }
   }
 
   return results;
 }
 
-DocumentMap LevelDbRemoteDocumentCache::GetMatching(FSTQuery* query) {
+DocumentMap LevelDbRemoteDocumentCache::GetMatching(
+    FSTQuery* query, QueryExecutionStats* _Nullable stats) {
+  return CollectMatching(query, /* top= */ nullptr, stats);
+}
+
+DocumentMap LevelDbRemoteDocumentCache::GetFirstMatching(
+    FSTQuery* query, size_t count, QueryExecutionStats* _Nullable stats) {
+  TopDocuments top{query, count};
+  return CollectMatching(query, &top, stats);
+}
+
+DocumentMap LevelDbRemoteDocumentCache::CollectMatching(
+    FSTQuery* query,
+    TopDocuments* _Nullable top,
+    QueryExecutionStats* _Nullable stats) {
   HARD_ASSERT(
       ![query isCollectionGroupQuery],
       "CollectionGroup queries should be handled in LocalDocumentsView");
 
+  if (!LevelDbFieldIndex::CanServeQuery(query)) {
+    return GetAllInCollection(query.path, /* add_to_field_index= */ false, top,
+                              stats);
+  }
+
+  if (field_index_.IsCollectionIndexed(query.path)) {
+    return GetMatchingFromFieldIndex(query, top, stats);
+  }
+
+  // This is the first query against the collection that can make use of the
+  // field index. We have to read every document anyway, so populate the index
+  // as we go and use it from now on.
+  DocumentMap results = GetAllInCollection(
+      query.path, /* add_to_field_index= */ true, top, stats);
+  field_index_.MarkCollectionIndexed(query.path);
+  return results;
+}
+
+DocumentMap LevelDbRemoteDocumentCache::GetMatching(
+    FSTQuery* query,
+    const SnapshotVersion& since_read_time,
+    QueryExecutionStats* _Nullable stats) {
+  HARD_ASSERT(
+      ![query isCollectionGroupQuery],
+      "CollectionGroup queries should be handled in LocalDocumentsView");
+
+  // Until the read time index is backfilled, documents written before it
+  // existed can only be found by reading the whole collection.
+  if (LevelDbMigrations::IsBackfillPending(
+          db_.currentTransaction, LevelDbMigrations::kReadTimeMigration)) {
+    return GetMatching(query, stats);
+  }
+
+  // Index rows of the collection's own documents sort by read time, ahead of
+  // those of its subcollections.
+  std::string collection_prefix =
+      LevelDbRemoteDocumentReadTimeKey::KeyPrefix(query.path);
+  auto it = db_.currentTransaction->NewIterator();
+  it->Seek(LevelDbRemoteDocumentReadTimeKey::KeyPrefix(query.path,
+                                                       since_read_time));
+
+  DocumentKeySet keys;
+  LevelDbRemoteDocumentReadTimeKey row_key;
+  int64_t scanned = 0;
+  for (; it->Valid() && absl::StartsWith(it->key(), collection_prefix);
+       it->Next()) {
+    HARD_ASSERT(row_key.Decode(it->key()),
+                "Failed to decode remote document read time key");
+    if (!query.path.IsImmediateParentOf(row_key.document_key().path())) {
+      break;
+    }
+    ++scanned;
+    if (row_key.read_time() > since_read_time) {
+      keys = keys.insert(row_key.document_key());
+    }
+  }
+
+  DocumentMap results;
+  int64_t decoded = 0;
+  RemoteDocumentReader reader(db_.currentTransaction);
+  for (const DocumentKey& key : keys) {
+    if (!reader.Find(key)) {
+      continue;
+    }
+    FSTMaybeDocument* maybe_doc = DecodeMaybeDocument(reader.value(), key);
+    ++decoded;
+    if ([maybe_doc isKindOfClass:[FSTDocument class]]) {
+      results =
+          std::move(results).insert(key, static_cast<FSTDocument*>(maybe_doc));
+    }
+  }
+
+  if (stats) {
+    stats->documents_scanned += scanned;
+    stats->documents_decoded += decoded;
+  }
+  return results;
+}
+
+DocumentMap LevelDbRemoteDocumentCache::GetAllInCollectionGroup(
+    const std::string& collection_id, QueryExecutionStats* _Nullable stats) {
+  // The index rows of a collection group are ordered by document key, so the
+  // documents can be read with a single sweep through the remote documents.
+  std::vector<DocumentKey> keys;
+  std::string index_prefix =
+      LevelDbCollectionGroupDocumentKey::KeyPrefix(collection_id);
+  auto index_iterator = db_.currentTransaction->NewIterator();
+  LevelDbCollectionGroupDocumentKey row_key;
+  for (index_iterator->Seek(index_prefix);
+       index_iterator->Valid() &&
+       absl::StartsWith(index_iterator->key(), index_prefix);
+       index_iterator->Next()) {
+    HARD_ASSERT(row_key.Decode(index_iterator->key()),
+                "Failed to decode collection group document key");
+    keys.push_back(row_key.document_key());
+  }
+
+  DocumentMap results;
+  int64_t decoded = 0;
+  RemoteDocumentReader reader(db_.currentTransaction);
+  for (const DocumentKey& key : keys) {
+    if (!reader.Find(key)) {
+      continue;
+    }
+    FSTMaybeDocument* maybe_doc = DecodeMaybeDocument(reader.value(), key);
+    ++decoded;
+    if ([maybe_doc isKindOfClass:[FSTDocument class]]) {
+      results =
+          std::move(results).insert(key, static_cast<FSTDocument*>(maybe_doc));
+    }
+  }
+
+  if (stats) {
+    stats->access_path = QueryAccessPath::CollectionGroupScan;
+    stats->documents_scanned += static_cast<int64_t>(keys.size());
+    stats->documents_decoded += decoded;
+  }
+  return results;
+}
+
+DocumentMap LevelDbRemoteDocumentCache::GetAllInCollection(
+    const ResourcePath& collection_path,
+    bool add_to_field_index,
+    TopDocuments* _Nullable top,
+    QueryExecutionStats* _Nullable stats) {
   DocumentMap results;
 
-  // Use the query path as a prefix for testing if a document matches the query.
-  const model::ResourcePath& query_path = query.path;
-  size_t immediate_children_path_length = query_path.size() + 1;
+  // Use the collection path as a prefix for testing if a document matches.
+  size_t immediate_children_path_length = collection_path.size() + 1;
 
   // Documents are ordered by key, so we can use a prefix scan to narrow down
   // the documents we need to match the query against.
-  std::string start_key = LevelDbRemoteDocumentKey::KeyPrefix(query_path);
+  std::string start_key = LevelDbRemoteDocumentKey::KeyPrefix(collection_path);
   auto it = db_.currentTransaction->NewIterator();
   it->Seek(start_key);
 
-  LevelDbRemoteDocumentKey current_key;
+  LevelDbRemoteDocumentKeyView current_key;
+  int64_t scanned = 0;
+  int64_t decoded = 0;
   for (; it->Valid() && current_key.Decode(it->key()); it->Next()) {
+    if (!current_key.HasPrefix(collection_path)) {
+      break;
+    }
+    ++scanned;
+
     // The query is actually returning any path that starts with the query path
     // prefix which may include documents in subcollections. For example, a
     // query on 'rooms' will return rooms/abc/messages/xyx but we shouldn't
     // match it. Fix this by discarding rows with document keys more than one
-    // segment longer than the query path.
-    const DocumentKey& document_key = current_key.document_key();
-    if (document_key.path().size() != immediate_children_path_length) {
+    // segment longer than the query path. The view lets these rows be skipped
+    // without copying their paths.
+    if (current_key.segments().size() != immediate_children_path_length) {
       continue;
     }
 
     FSTMaybeDocument* maybe_doc =
-        DecodeMaybeDocument(it->value(), document_key);
-    if (!query_path.IsPrefixOf(maybe_doc.key.path())) {
-      break;
-    } else if ([maybe_doc isKindOfClass:[FSTDocument class]]) {
-      results =
-          results.insert(maybe_doc.key, static_cast<FSTDocument*>(maybe_doc));
+        DecodeMaybeDocument(it->value(), current_key.ToDocumentKey());
+    ++decoded;
+    if ([maybe_doc isKindOfClass:[FSTDocument class]]) {
+      auto doc = static_cast<FSTDocument*>(maybe_doc);
+      if (add_to_field_index) {
+        field_index_.AddEntries(doc);
+      }
+      if (top) {
+        top->Add(doc);
+      } else {
+        results = std::move(results).insert(maybe_doc.key, doc);
+      }
     }
   }
 
-  return results;
+  if (stats) {
+    stats->access_path = QueryAccessPath::CollectionScan;
+    stats->documents_scanned += scanned;
+    stats->documents_decoded += decoded;
+  }
+  return top ? top->ToDocumentMap() : results;
+}
+
+DocumentMap LevelDbRemoteDocumentCache::GetMatchingFromFieldIndex(
+    FSTQuery* query,
+    TopDocuments* _Nullable top,
+    QueryExecutionStats* _Nullable stats) {
+  DocumentMap results;
+
+  // Candidates are only a superset of the matching documents; the caller
+  // re-filters them against the query. They are read one at a time, like in
+  // `GetAll`, so that `top` can drop those it doesn't keep right away.
+  DocumentKeySet candidates = field_index_.GetMatchingKeys(query);
+  int64_t decoded = 0;
+  RemoteDocumentReader reader(db_.currentTransaction);
+  for (const DocumentKey& key : candidates) {
+    FSTMaybeDocument* maybe_doc = LookupDecoded(key);
+    if (!maybe_doc) {
+      if (!reader.Find(key)) {
+        continue;
+      }
+      maybe_doc = DecodeMaybeDocument(reader.value(), key);
+    }
+    ++decoded;
+    if (![maybe_doc isKindOfClass:[FSTDocument class]]) {
+      continue;
+    }
+    auto doc = static_cast<FSTDocument*>(maybe_doc);
+    if (top) {
+      top->Add(doc);
+    } else {
+      results = std::move(results).insert(key, doc);
+    }
+  }
+
+  if (stats) {
+    stats->access_path = QueryAccessPath::FieldIndex;
+    stats->documents_scanned += static_cast<int64_t>(candidates.size());
+    stats->documents_decoded += decoded;
+  }
+  return top ? top->ToDocumentMap() : results;
 }
 
 FSTMaybeDocument* LevelDbRemoteDocumentCache::DecodeMaybeDocument(
     absl::string_view encoded, const DocumentKey& key) {
+  FSTMaybeDocument* cached = LookupDecoded(key);
+  if (cached) {
+    return cached;
+  }
+  ++decoded_cache_misses_;
+
+  std::string decompressed;
+  encoded = compressor_.Decode(db_.currentTransaction, key, encoded,
+                               &decompressed);
+
+  if (native_serialization_enabled_) {
+    FSTMaybeDocument* maybeDocument = DecodeMaybeDocumentNatively(encoded);
+    if (maybeDocument) {
+      HARD_ASSERT(maybeDocument.key == key,
+                  "Read document has key (%s) instead of expected key (%s).",
+                  maybeDocument.key.ToString(), key.ToString());
+      CacheDecoded(maybeDocument, encoded.size());
+      return maybeDocument;
+    }
+  }
+
   NSData* data = [[NSData alloc] initWithBytesNoCopy:(void*)encoded.data()
                                               length:encoded.size()
                                         freeWhenDone:false];
@@ -152,9 +772,163 @@ FSTMaybeDocument* LevelDbRemoteDocumentCache::DecodeMaybeDocument(
   HARD_ASSERT(maybeDocument.key == key,
               "Read document has key (%s) instead of expected key (%s).",
               maybeDocument.key.ToString(), key.ToString());
+  CacheDecoded(maybeDocument, encoded.size());
   return maybeDocument;
 }
 
+FSTMaybeDocument* _Nullable LevelDbRemoteDocumentCache::LookupDecoded(
+    const DocumentKey& key) {
+  auto found = decoded_cache_.find(key);
+  if (found == decoded_cache_.end()) {
+    return nil;
+  }
+
+  CachedDocument& entry = found->second;
+  decoded_lru_.splice(decoded_lru_.begin(), decoded_lru_, entry.lru_position);
+  ++decoded_cache_hits_;
+  return entry.document;
+}
+
+void LevelDbRemoteDocumentCache::CacheDecoded(FSTMaybeDocument* document,
+                                              size_t byte_size) {
+  UncacheDecoded(document.key);
+  if (byte_size > kDecodedDocumentCacheBytes) {
+    return;
+  }
+
+  while (decoded_cache_bytes_ + byte_size > kDecodedDocumentCacheBytes) {
+    DocumentKey least_recent = decoded_lru_.back();
+    UncacheDecoded(least_recent);
+  }
+
+  decoded_lru_.push_front(document.key);
+  decoded_cache_.emplace(
+      document.key, CachedDocument{document, byte_size, decoded_lru_.begin()});
+  decoded_cache_bytes_ += byte_size;
+}
+
+void LevelDbRemoteDocumentCache::UncacheDecoded(const DocumentKey& key) {
+  auto found = decoded_cache_.find(key);
+  if (found == decoded_cache_.end()) {
+    return;
+  }
+
+  decoded_cache_bytes_ -= found->second.byte_size;
+  decoded_lru_.erase(found->second.lru_position);
+  decoded_cache_.erase(found);
+}
+
+bool LevelDbRemoteDocumentCache::EncodeMaybeDocumentNatively(
+    FSTMaybeDocument* document, std::string* encoded) {
+  std::unique_ptr<MaybeDocument> model;
+  if ([document isKindOfClass:[FSTDocument class]]) {
+    FSTDocument* doc = static_cast<FSTDocument*>(document);
+    FieldValue::Map fields;
+    if (!ToModelMap(doc.data, &fields)) return false;
+
+    DocumentState state = DocumentState::kSynced;
+    if (doc.hasCommittedMutations) {
+      state = DocumentState::kCommittedMutations;
+    } else if (doc.hasLocalMutations) {
+      state = DocumentState::kLocalMutations;
+    }
+    model = absl::make_unique<Document>(ObjectValue::FromMap(std::move(fields)),
+                                        doc.key, doc.version, state);
+  } else if ([document isKindOfClass:[FSTDeletedDocument class]]) {
+    FSTDeletedDocument* deleted = static_cast<FSTDeletedDocument*>(document);
+    model = absl::make_unique<NoDocument>(deleted.key, deleted.version,
+                                          deleted.hasCommittedMutations);
+  } else if ([document isKindOfClass:[FSTUnknownDocument class]]) {
+    model = absl::make_unique<UnknownDocument>(document.key, document.version);
+  } else {
+    HARD_FAIL("Unknown document type %s", NSStringFromClass([document class]));
+  }
+
+  firestore_client_MaybeDocument proto =
+      local_serializer_.EncodeMaybeDocument(*model);
+  Writer writer = Writer::Wrap(encoded);
+  writer.WriteNanopbMessage(firestore_client_MaybeDocument_fields, &proto);
+  LocalSerializer::FreeNanopbMessage(firestore_client_MaybeDocument_fields,
+                                     &proto);
+  return true;
+}
+
+FSTMaybeDocument* _Nullable LevelDbRemoteDocumentCache::
+    DecodeMaybeDocumentNatively(absl::string_view encoded) {
+  // Decode eagerly, since all fields are converted right away anyway.
+  Reader reader = Reader::Wrap(encoded);
+  reader.UseArena(std::make_shared<Arena>(
+      std::max(Arena::kDefaultBlockSize, encoded.size())));
+  firestore_client_MaybeDocument proto{};
+  reader.ReadNanopbMessage(firestore_client_MaybeDocument_fields, &proto);
+  std::unique_ptr<MaybeDocument> model =
+      local_serializer_.DecodeMaybeDocument(&reader, proto);
+  reader.FreeNanopbMessage(firestore_client_MaybeDocument_fields, &proto);
+
+  // This includes documents with references, which remote::Serializer can't
+  // decode yet. Genuinely corrupt data fails in the Objective-C fallback.
+  if (!reader.status().ok()) return nil;
+
+  switch (model->type()) {
+    case MaybeDocument::Type::Document: {
+      const auto& doc = static_cast<const Document&>(*model);
+      FSTDocumentState state = FSTDocumentStateSynced;
+      if (doc.HasCommittedMutations()) {
+        state = FSTDocumentStateCommittedMutations;
+      } else if (doc.HasLocalMutations()) {
+        state = FSTDocumentStateLocalMutations;
+      }
+      return [FSTDocument documentWithData:ToFSTObjectValue(doc.data())
+                                       key:doc.key()
+                                   version:doc.version()
+                                     state:state];
+    }
+
+    case MaybeDocument::Type::NoDocument:
+      return [FSTDeletedDocument documentWithKey:model->key()
+                                         version:model->version()
+                           hasCommittedMutations:model->HasPendingWrites()];
+
+    case MaybeDocument::Type::UnknownDocument:
+      return [FSTUnknownDocument documentWithKey:model->key()
+                                         version:model->version()];
+
+    case MaybeDocument::Type::Unknown:
+      break;
+  }
+  UNREACHABLE();
+}
+
+std::unique_ptr<MaybeDocument>
+LevelDbRemoteDocumentCache::DecodeMaybeDocumentModel(absl::string_view encoded,
+                                                     const DocumentKey& key) {
+  // The reader reads directly from the LevelDB value; only the decoded model
+  // owns any new memory. Document fields stay in their nanopb form until
+  // accessed, since callers typically only look at a few of them. They are
+  // decoded into an arena that the model shares, so that the many small
+  // allocations of a large document become a few large ones.
+  std::string decompressed;
+  encoded = compressor_.Decode(db_.currentTransaction, key, encoded,
+                               &decompressed);
+  Reader reader = Reader::Wrap(encoded);
+  reader.UseArena(std::make_shared<Arena>(
+      std::max(Arena::kDefaultBlockSize, encoded.size())));
+  firestore_client_MaybeDocument proto{};
+  reader.ReadNanopbMessage(firestore_client_MaybeDocument_fields, &proto);
+  std::unique_ptr<MaybeDocument> maybe_document =
+      local_serializer_.DecodeMaybeDocumentLazily(&reader, &proto);
+  reader.FreeNanopbMessage(firestore_client_MaybeDocument_fields, &proto);
+
+  if (!reader.status().ok()) {
+    HARD_FAIL("MaybeDocument proto failed to parse: %s",
+              reader.status().ToString());
+  }
+  HARD_ASSERT(maybe_document->key() == key,
+              "Read document has key (%s) instead of expected key (%s).",
+              maybe_document->key().ToString(), key.ToString());
+  return maybe_document;
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_SNAPSHOT_READER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_SNAPSHOT_READER_H_
+
+#if !defined(__OBJC__)
+#error "For now, this file must only be included by ObjC source files."
+#endif  // !defined(__OBJC__)
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/local/index_manager.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
+#include "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
+#include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
+#include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "leveldb/db.h"
+
+@class FSTLocalSerializer;
+@class FSTMaybeDocument;
+@class FSTQuery;
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Counts the snapshot readers of a database, and the other work that uses it
+ * off the worker queue, so that the database isn't closed while they are still
+ * reading from it.
+ */
+class LevelDbSnapshotReaderCount {
+ public:
+  void Acquire();
+  void Release();
+
+  /** Blocks until every acquired reader has been released. */
+  void WaitForReaders();
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable released_;
+  int count_ = 0;
+};
+
+/**
+ * Reads the local view of documents from a LevelDB snapshot.
+ *
+ * A reader is created on the worker queue, so that its snapshot reflects every
+ * write made before it, but it doesn't share any state with the persistence
+ * layer. Reads can then run on any thread, concurrently with the worker queue,
+ * without blocking it or waiting for it. A reader must only be used by one
+ * thread at a time.
+ *
+ * Collection group queries aren't supported, since the indexes they rely on
+ * may still be backfilling.
+ */
+class LevelDbSnapshotReader {
+ public:
+  /**
+   * Takes a snapshot of the given database.
+   *
+   * @param user_id The normalized user ID of the current mutation queue, whose
+   *     pending batches are applied to the documents read.
+   * @param reader_count Released when this reader is destroyed.
+   */
+  LevelDbSnapshotReader(
+      leveldb::DB* db,
+      const leveldb::ReadOptions& read_options,
+      FSTLocalSerializer* serializer,
+      std::string user_id,
+      std::shared_ptr<LevelDbSnapshotReaderCount> reader_count);
+
+  LevelDbSnapshotReader(const LevelDbSnapshotReader& other) = delete;
+  LevelDbSnapshotReader& operator=(const LevelDbSnapshotReader& other) = delete;
+
+  ~LevelDbSnapshotReader();
+
+  /**
+   * Gets the local view of the document identified by `key`, or nil if there
+   * is no cached state for it.
+   */
+  FSTMaybeDocument* _Nullable GetDocument(const model::DocumentKey& key);
+
+  /**
+   * Performs a document or collection query against the local view of all
+   * documents. Like `LocalDocumentsView`, the results may include documents
+   * that don't match the query and must be re-filtered.
+   */
+  model::DocumentMap GetDocumentsMatchingQuery(FSTQuery* query);
+
+ private:
+  leveldb::DB* db_;
+  const leveldb::Snapshot* snapshot_;
+  std::shared_ptr<LevelDbSnapshotReaderCount> reader_count_;
+
+  // Never committed; only used to read from the snapshot.
+  std::unique_ptr<LevelDbTransaction> transaction_;
+
+  std::unique_ptr<RemoteDocumentCache> remote_document_cache_;
+  std::unique_ptr<MutationQueue> mutation_queue_;
+  std::unique_ptr<IndexManager> index_manager_;
+  std::unique_ptr<LocalDocumentsView> local_documents_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_SNAPSHOT_READER_H_
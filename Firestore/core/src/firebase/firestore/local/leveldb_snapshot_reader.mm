@@ -0,0 +1,439 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_snapshot_reader.h"
+
+#include <set>
+#include <utility>
+#include <vector>
+
+#import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
+#import "Firestore/Protos/objc/firestore/local/Mutation.pbobjc.h"
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Local/FSTLocalSerializer.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTMutationBatch.h"
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_document_compressor.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/top_documents.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::BatchId;
+using model::DocumentKey;
+using model::DocumentKeySet;
+using model::DocumentMap;
+using model::MaybeDocumentMap;
+using model::ResourcePath;
+using model::SnapshotVersion;
+
+namespace {
+
+FSTMaybeDocument* DecodeMaybeDocument(FSTLocalSerializer* serializer,
+                                      absl::string_view encoded,
+                                      const DocumentKey& key) {
+  NSData* data = [[NSData alloc] initWithBytesNoCopy:(void*)encoded.data()
+                                              length:encoded.size()
+                                        freeWhenDone:NO];
+
+  NSError* error;
+  FSTPBMaybeDocument* proto = [FSTPBMaybeDocument parseFromData:data
+                                                          error:&error];
+  if (!proto) {
+    HARD_FAIL("FSTPBMaybeDocument failed to parse: %s", error);
+  }
+
+  FSTMaybeDocument* maybe_document = [serializer decodedMaybeDocument:proto];
+  HARD_ASSERT(maybe_document.key == key,
+              "Read document has key (%s) instead of expected key (%s).",
+              maybe_document.key.ToString(), key.ToString());
+  return maybe_document;
+}
+
+FSTMutationBatch* DecodeMutationBatch(FSTLocalSerializer* serializer,
+                                      absl::string_view encoded) {
+  NSData* data = [[NSData alloc] initWithBytesNoCopy:(void*)encoded.data()
+                                              length:encoded.size()
+                                        freeWhenDone:NO];
+
+  NSError* error;
+  FSTPBWriteBatch* proto = [FSTPBWriteBatch parseFromData:data error:&error];
+  if (!proto) {
+    HARD_FAIL("FSTPBMutationBatch failed to parse: %s", error);
+  }
+  return [serializer decodedMutationBatch:proto];
+}
+
+/** The remote documents of a snapshot. */
+class SnapshotRemoteDocumentCache : public RemoteDocumentCache {
+ public:
+  SnapshotRemoteDocumentCache(LevelDbTransaction* transaction,
+                              FSTLocalSerializer* serializer)
+      : transaction_(transaction), serializer_(serializer) {
+  }
+
+  void Add(FSTMaybeDocument*, const SnapshotVersion&) override {
+    HARD_FAIL("Snapshot readers can't write documents");
+  }
+
+  void Remove(const DocumentKey&) override {
+    HARD_FAIL("Snapshot readers can't remove documents");
+  }
+
+  FSTMaybeDocument* _Nullable Get(const DocumentKey& key) override {
+    std::string value;
+    leveldb::Status status =
+        transaction_->Get(LevelDbRemoteDocumentKey::Key(key), &value);
+    if (status.IsNotFound()) {
+      return nil;
+    } else if (!status.ok()) {
+      HARD_FAIL("Fetch document for key (%s) failed with status: %s",
+                key.ToString(), status.ToString());
+    }
+    return Decode(value, key);
+  }
+
+  MaybeDocumentMap GetAll(const DocumentKeySet& keys) override {
+    MaybeDocumentMap results;
+    for (const DocumentKey& key : keys) {
+      results = std::move(results).insert(key, Get(key));
+    }
+    return results;
+  }
+
+  DocumentMap GetMatching(FSTQuery* query,
+                          QueryExecutionStats* _Nullable stats) override {
+    return CollectMatching(query, /* top= */ nullptr);
+  }
+
+  DocumentMap GetFirstMatching(FSTQuery* query,
+                               size_t count,
+                               QueryExecutionStats* _Nullable stats) override {
+    TopDocuments top{query, count};
+    return CollectMatching(query, &top);
+  }
+
+  DocumentMap GetMatching(FSTQuery* query,
+                          const SnapshotVersion&,
+                          QueryExecutionStats* _Nullable stats) override {
+    // Returning documents that didn't change is allowed, and the read time
+    // index may still be backfilling.
+    return GetMatching(query, stats);
+  }
+
+  DocumentMap GetAllInCollectionGroup(const std::string&,
+                                      QueryExecutionStats* _Nullable) override {
+    HARD_FAIL("Snapshot readers don't support collection group queries");
+  }
+
+ private:
+  /**
+   * Returns the documents of the query's collection, or only those `top`
+   * keeps if it's not null.
+   */
+  DocumentMap CollectMatching(FSTQuery* query, TopDocuments* _Nullable top) {
+    DocumentMap results;
+
+    // Rows of subcollections share the prefix but have longer paths.
+    std::string start_key = LevelDbRemoteDocumentKey::KeyPrefix(query.path);
+    auto it = transaction_->NewIterator();
+    LevelDbRemoteDocumentKeyView current_key;
+    for (it->Seek(start_key); it->Valid() && current_key.Decode(it->key());
+         it->Next()) {
+      if (!current_key.HasPrefix(query.path)) {
+        break;
+      }
+      if (current_key.segments().size() != query.path.size() + 1) {
+        continue;
+      }
+
+      FSTMaybeDocument* maybe_doc =
+          Decode(it->value(), current_key.ToDocumentKey());
+      if (![maybe_doc isKindOfClass:[FSTDocument class]]) {
+        continue;
+      }
+      auto doc = static_cast<FSTDocument*>(maybe_doc);
+      if (top) {
+        top->Add(doc);
+      } else {
+        results = std::move(results).insert(maybe_doc.key, doc);
+      }
+    }
+    return top ? top->ToDocumentMap() : results;
+  }
+
+  FSTMaybeDocument* Decode(absl::string_view value, const DocumentKey& key) {
+    std::string decompressed;
+    value = compressor_.Decode(transaction_, key, value, &decompressed);
+    return DecodeMaybeDocument(serializer_, value, key);
+  }
+
+  LevelDbTransaction* transaction_;
+  FSTLocalSerializer* serializer_;
+  LevelDbDocumentCompressor compressor_;
+};
+
+/** The pending mutation batches of one user in a snapshot. */
+class SnapshotMutationQueue : public MutationQueue {
+ public:
+  SnapshotMutationQueue(LevelDbTransaction* transaction,
+                        FSTLocalSerializer* serializer,
+                        std::string user_id)
+      : transaction_(transaction),
+        serializer_(serializer),
+        user_id_(std::move(user_id)) {
+  }
+
+  void Start() override {
+  }
+
+  bool IsEmpty() override {
+    std::string user_key = LevelDbMutationKey::KeyPrefix(user_id_);
+    auto it = transaction_->NewIterator();
+    it->Seek(user_key);
+    return !(it->Valid() && absl::StartsWith(it->key(), user_key));
+  }
+
+  void AcknowledgeBatch(FSTMutationBatch*, NSData* _Nullable) override {
+    HARD_FAIL("Snapshot readers can't acknowledge batches");
+  }
+
+  FSTMutationBatch* AddMutationBatch(FIRTimestamp*,
+                                     std::vector<FSTMutation*>&&,
+                                     std::vector<FSTMutation*>&&) override {
+    HARD_FAIL("Snapshot readers can't add batches");
+  }
+
+  FSTMutationBatch* ReplaceMutationBatch(
+      FSTMutationBatch*, std::vector<FSTMutation*>&&) override {
+    HARD_FAIL("Snapshot readers can't replace batches");
+  }
+
+  void RemoveMutationBatch(FSTMutationBatch*) override {
+    HARD_FAIL("Snapshot readers can't remove batches");
+  }
+
+  std::vector<FSTMutationBatch*> AllMutationBatches() override {
+    std::string user_key = LevelDbMutationKey::KeyPrefix(user_id_);
+    auto it = transaction_->NewIterator();
+    std::vector<FSTMutationBatch*> result;
+    for (it->Seek(user_key);
+         it->Valid() && absl::StartsWith(it->key(), user_key); it->Next()) {
+      result.push_back(DecodeMutationBatch(serializer_, it->value()));
+    }
+    return result;
+  }
+
+  std::vector<FSTMutationBatch*> AllMutationBatchesAffectingDocumentKeys(
+      const DocumentKeySet& document_keys) override {
+    std::set<BatchId> batch_ids;
+    auto it = transaction_->NewIterator();
+    LevelDbDocumentMutationKey row_key;
+    for (const DocumentKey& document_key : document_keys) {
+      std::string index_prefix =
+          LevelDbDocumentMutationKey::KeyPrefix(user_id_, document_key.path());
+      // Rows of documents in subcollections come after those of the document
+      // itself, so the scan can stop at the first mismatch.
+      for (it->Seek(index_prefix); it->Valid(); it->Next()) {
+        if (!absl::StartsWith(it->key(), index_prefix) ||
+            !row_key.Decode(it->key()) ||
+            row_key.document_key() != document_key) {
+          break;
+        }
+        batch_ids.insert(row_key.batch_id());
+      }
+    }
+    return BatchesWithIds({batch_ids.begin(), batch_ids.end()});
+  }
+
+  std::vector<FSTMutationBatch*> AllMutationBatchesAffectingDocumentKey(
+      const DocumentKey& key) override {
+    return AllMutationBatchesAffectingDocumentKeys(DocumentKeySet{key});
+  }
+
+  std::vector<FSTMutationBatch*> AllMutationBatchesAffectingQuery(
+      FSTQuery* query) override {
+    std::string index_prefix =
+        LevelDbCollectionMutationKey::KeyPrefix(user_id_, query.path);
+    auto it = transaction_->NewIterator();
+
+    std::vector<BatchId> batch_ids;
+    for (it->Seek(index_prefix); it->Valid(); it->Next()) {
+      BatchId batch_id = 0;
+      if (!LevelDbCollectionMutationKey::DecodeBatchId(it->key(), index_prefix,
+                                                       &batch_id)) {
+        break;
+      }
+      if (batch_ids.empty() || batch_ids.back() != batch_id) {
+        batch_ids.push_back(batch_id);
+      }
+    }
+    return BatchesWithIds(batch_ids);
+  }
+
+  FSTMutationBatch* _Nullable LookupMutationBatch(BatchId batch_id) override {
+    std::string value;
+    leveldb::Status status =
+        transaction_->Get(LevelDbMutationKey::Key(user_id_, batch_id), &value);
+    if (status.IsNotFound()) {
+      return nil;
+    } else if (!status.ok()) {
+      HARD_FAIL("Lookup mutation batch (%s, %s) failed with status: %s",
+                user_id_, batch_id, status.ToString());
+    }
+    return DecodeMutationBatch(serializer_, value);
+  }
+
+  FSTMutationBatch* _Nullable NextMutationBatchAfterBatchId(
+      BatchId batch_id) override {
+    auto it = transaction_->NewIterator();
+    it->Seek(LevelDbMutationKey::Key(user_id_, batch_id + 1));
+
+    LevelDbMutationKey row_key;
+    if (!it->Valid() || !row_key.Decode(it->key()) ||
+        row_key.user_id() != user_id_) {
+      return nil;
+    }
+    return DecodeMutationBatch(serializer_, it->value());
+  }
+
+  void PerformConsistencyCheck() override {
+  }
+
+  NSData* _Nullable GetLastStreamToken() override {
+    HARD_FAIL("Snapshot readers don't read stream tokens");
+  }
+
+  void SetLastStreamToken(NSData* _Nullable) override {
+    HARD_FAIL("Snapshot readers can't write stream tokens");
+  }
+
+ private:
+  /** Reads the batches with the given sorted, unique IDs. */
+  std::vector<FSTMutationBatch*> BatchesWithIds(
+      const std::vector<BatchId>& batch_ids) {
+    std::vector<FSTMutationBatch*> result;
+    auto it = transaction_->NewIterator();
+    for (BatchId batch_id : batch_ids) {
+      std::string mutation_key = LevelDbMutationKey::Key(user_id_, batch_id);
+      it->Seek(mutation_key);
+      if (!it->Valid() || it->key() != mutation_key) {
+        HARD_FAIL("Dangling document-mutation reference found: "
+                  "Missing batch %s; seeking there found %s",
+                  DescribeKey(mutation_key), DescribeKey(it));
+      }
+      result.push_back(DecodeMutationBatch(serializer_, it->value()));
+    }
+    return result;
+  }
+
+  LevelDbTransaction* transaction_;
+  FSTLocalSerializer* serializer_;
+  std::string user_id_;
+};
+
+/** Stands in for the index manager, which only collection groups need. */
+class SnapshotIndexManager : public IndexManager {
+ public:
+  void AddToCollectionParentIndex(const ResourcePath&) override {
+    HARD_FAIL("Snapshot readers can't write indexes");
+  }
+
+  std::vector<ResourcePath> GetCollectionParents(const std::string&) override {
+    HARD_FAIL("Snapshot readers don't support collection group queries");
+  }
+};
+
+}  // namespace
+
+void LevelDbSnapshotReaderCount::Acquire() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++count_;
+}
+
+void LevelDbSnapshotReaderCount::Release() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  HARD_ASSERT(count_ > 0, "Released more snapshot readers than acquired");
+  --count_;
+  if (count_ == 0) {
+    released_.notify_all();
+  }
+}
+
+void LevelDbSnapshotReaderCount::WaitForReaders() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  released_.wait(lock, [this] { return count_ == 0; });
+}
+
+LevelDbSnapshotReader::LevelDbSnapshotReader(
+    leveldb::DB* db,
+    const leveldb::ReadOptions& read_options,
+    FSTLocalSerializer* serializer,
+    std::string user_id,
+    std::shared_ptr<LevelDbSnapshotReaderCount> reader_count)
+    : db_(db),
+      snapshot_(db->GetSnapshot()),
+      reader_count_(std::move(reader_count)) {
+  reader_count_->Acquire();
+
+  leveldb::ReadOptions snapshot_options = read_options;
+  snapshot_options.snapshot = snapshot_;
+  transaction_ = absl::make_unique<LevelDbTransaction>(
+      db_, "Read from snapshot", snapshot_options);
+
+  remote_document_cache_ = absl::make_unique<SnapshotRemoteDocumentCache>(
+      transaction_.get(), serializer);
+  mutation_queue_ = absl::make_unique<SnapshotMutationQueue>(
+      transaction_.get(), serializer, std::move(user_id));
+  index_manager_ = absl::make_unique<SnapshotIndexManager>();
+  local_documents_ = absl::make_unique<LocalDocumentsView>(
+      remote_document_cache_.get(), mutation_queue_.get(),
+      index_manager_.get());
+}
+
+LevelDbSnapshotReader::~LevelDbSnapshotReader() {
+  // Iterators and reads of the transaction must be done before the snapshot
+  // goes away.
+  local_documents_.reset();
+  transaction_.reset();
+  db_->ReleaseSnapshot(snapshot_);
+  reader_count_->Release();
+}
+
+FSTMaybeDocument* _Nullable LevelDbSnapshotReader::GetDocument(
+    const DocumentKey& key) {
+  return local_documents_->GetDocument(key);
+}
+
+DocumentMap LevelDbSnapshotReader::GetDocumentsMatchingQuery(FSTQuery* query) {
+  HARD_ASSERT(![query isCollectionGroupQuery],
+              "Snapshot readers don't support collection group queries");
+  return local_documents_->GetDocumentsMatchingQuery(query);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
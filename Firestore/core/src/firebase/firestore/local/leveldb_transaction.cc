@@ -16,7 +16,11 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_util.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "absl/memory/memory.h"
@@ -34,8 +38,41 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
+namespace {
+
+/**
+ * The size of each block allocated by a transaction's arena. Values larger
+ * than this get a block of their own.
+ */
+const size_t kArenaBlockSize = 64 * 1024;
+
+}  // namespace
+
+absl::string_view LevelDbTransaction::Arena::Copy(absl::string_view bytes) {
+  if (bytes.empty()) return absl::string_view{};
+
+  if (bytes.size() > remaining_) {
+    size_t block_size = std::max(kArenaBlockSize, bytes.size());
+    util::CountAllocation(util::AllocationSubsystem::kLocal, block_size);
+    blocks_.emplace_back(new char[block_size]);
+    next_ = blocks_.back().get();
+    remaining_ = block_size;
+  }
+
+  char* copy = next_;
+  std::memcpy(copy, bytes.data(), bytes.size());
+  next_ += bytes.size();
+  remaining_ -= bytes.size();
+  return absl::string_view{copy, bytes.size()};
+}
+
 LevelDbTransaction::Iterator::Iterator(LevelDbTransaction* txn)
-    : db_iter_(txn->db_->NewIterator(txn->read_options_)),
+    : Iterator(txn, txn->read_options_) {
+}
+
+LevelDbTransaction::Iterator::Iterator(LevelDbTransaction* txn,
+                                       const ReadOptions& read_options)
+    : db_iter_(txn->db_->NewIterator(read_options)),
       last_version_(txn->version_),
       txn_(txn),
       mutations_iter_(txn->mutations_.begin()),
@@ -60,10 +97,12 @@ void LevelDbTransaction::Iterator::UpdateCurrent() {
       // than the current mutation key, we are looking at a mutation next. It's
       // either sooner in the iteration or directly shadowing the underlying
       // committed value in leveldb.
-      is_mutation_ = db_iter_->key().compare(mutations_iter_->first) >= 0;
+      is_mutation_ =
+          db_iter_->key().compare(MakeSlice(mutations_iter_->first)) >= 0;
     }
     if (is_mutation_) {
-      current_ = *mutations_iter_;
+      current_ = {std::string{mutations_iter_->first},
+                  std::string{mutations_iter_->second}};
     } else {
       current_ = {db_iter_->key().ToString(), db_iter_->value().ToString()};
     }
@@ -94,7 +133,8 @@ absl::string_view LevelDbTransaction::Iterator::value() {
 }
 
 bool LevelDbTransaction::Iterator::IsDeleted(leveldb::Slice slice) {
-  return txn_->deletions_.find(slice.ToString()) != txn_->deletions_.end();
+  return txn_->deletions_.find(MakeStringView(slice)) !=
+         txn_->deletions_.end();
 }
 
 bool LevelDbTransaction::Iterator::SyncToTransaction() {
@@ -124,7 +164,8 @@ void LevelDbTransaction::Iterator::Next() {
   if (!advanced && is_valid_) {
     if (is_mutation_) {
       // A mutation might be shadowing leveldb. If so, advance both.
-      if (db_iter_->Valid() && db_iter_->key() == mutations_iter_->first) {
+      if (db_iter_->Valid() &&
+          db_iter_->key() == MakeSlice(mutations_iter_->first)) {
         AdvanceLDB();
       }
       ++mutations_iter_;
@@ -140,6 +181,7 @@ LevelDbTransaction::LevelDbTransaction(DB* db,
                                        const ReadOptions& read_options,
                                        const WriteOptions& write_options)
     : db_(db),
+      arena_(),
       mutations_(),
       deletions_(),
       read_options_(read_options),
@@ -162,9 +204,14 @@ const WriteOptions& LevelDbTransaction::DefaultWriteOptions() {
   return options;
 }
 
-void LevelDbTransaction::Put(std::string key, std::string value) {
+void LevelDbTransaction::Put(absl::string_view key, absl::string_view value) {
   deletions_.erase(key);
-  mutations_.emplace(std::make_pair(std::move(key), std::move(value)));
+  auto existing = mutations_.find(key);
+  if (existing != mutations_.end()) {
+    existing->second = arena_.Copy(value);
+  } else {
+    mutations_.emplace(arena_.Copy(key), arena_.Copy(value));
+  }
   version_++;
 }
 
@@ -173,41 +220,53 @@ LevelDbTransaction::NewIterator() {
   return absl::make_unique<LevelDbTransaction::Iterator>(this);
 }
 
+std::unique_ptr<LevelDbTransaction::Iterator>
+LevelDbTransaction::NewMaintenanceIterator() {
+  ReadOptions read_options = read_options_;
+  read_options.fill_cache = false;
+  return absl::make_unique<LevelDbTransaction::Iterator>(this, read_options);
+}
+
 Status LevelDbTransaction::Get(absl::string_view key, std::string* value) {
-  std::string key_string(key);
-  if (deletions_.find(key_string) != deletions_.end()) {
-    return Status::NotFound(key_string + " is not present in the transaction");
+  if (deletions_.find(key) != deletions_.end()) {
+    return Status::NotFound(absl::StrCat(
+        key, " is not present in the transaction"));
   } else {
-    Mutations::iterator iter{mutations_.find(key_string)};
+    Mutations::iterator iter{mutations_.find(key)};
     if (iter != mutations_.end()) {
-      *value = iter->second;
+      value->assign(iter->second.data(), iter->second.size());
       return Status::OK();
     } else {
-      return db_->Get(read_options_, key_string, value);
+      return db_->Get(read_options_, MakeSlice(key), value);
     }
   }
 }
 
 void LevelDbTransaction::Delete(absl::string_view key) {
-  std::string to_delete(key);
-  deletions_.insert(to_delete);
-  mutations_.erase(to_delete);
+  if (deletions_.find(key) == deletions_.end()) {
+    deletions_.insert(arena_.Copy(key));
+  }
+  mutations_.erase(key);
   version_++;
 }
 
 void LevelDbTransaction::Commit() {
+  Commit(write_options_);
+}
+
+void LevelDbTransaction::Commit(const WriteOptions& write_options) {
   WriteBatch batch;
   for (const auto& deletion : deletions_) {
-    batch.Delete(deletion);
+    batch.Delete(MakeSlice(deletion));
   }
 
   for (const auto& entry : mutations_) {
-    batch.Put(entry.first, entry.second);
+    batch.Put(MakeSlice(entry.first), MakeSlice(entry.second));
   }
 
   LOG_DEBUG("Committing transaction: %s", ToString());
 
-  Status status = db_->Write(write_options_, &batch);
+  Status status = db_->Write(write_options, &batch);
   HARD_ASSERT(status.ok(), "Failed to commit transaction:\n%s\n Failed: %s",
               ToString(), status.ToString());
 }
@@ -18,12 +18,15 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_TRANSACTION_H_
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "Firestore/core/src/firebase/firestore/util/allocation_counters.h"
 #include "absl/strings/string_view.h"
 #include "leveldb/db.h"
 
@@ -41,8 +44,19 @@ namespace local {
  * changes and committed values.
  */
 class LevelDbTransaction {
-  using Deletions = std::set<std::string>;
-  using Mutations = std::map<std::string, std::string>;
+  // Keys and values are views into the transaction's arena, which owns the
+  // bytes until the transaction is destroyed.
+  template <typename T>
+  using Allocator =
+      util::CountingAllocator<T, util::AllocationSubsystem::kLocal>;
+  using Deletions = std::set<absl::string_view,
+                             std::less<absl::string_view>,
+                             Allocator<absl::string_view>>;
+  using Mutations = std::map<
+      absl::string_view,
+      absl::string_view,
+      std::less<absl::string_view>,
+      Allocator<std::pair<const absl::string_view, absl::string_view>>>;
 
  public:
   /**
@@ -53,6 +67,9 @@ class LevelDbTransaction {
    public:
     explicit Iterator(LevelDbTransaction* txn);
 
+    /** Reads the underlying leveldb instance with the given options. */
+    Iterator(LevelDbTransaction* txn, const leveldb::ReadOptions& read_options);
+
     /**
      * Returns true if this iterator points to an entry
      */
@@ -163,9 +180,8 @@ class LevelDbTransaction {
    */
   void Put(absl::string_view key, GPBMessage* message) {
     NSData* data = [message data];
-    std::string key_string(key);
-    mutations_[key_string] = std::string((const char*)data.bytes, data.length);
-    version_++;
+    Put(key, absl::string_view{static_cast<const char*>(data.bytes),
+                               data.length});
   }
 #endif
 
@@ -173,7 +189,7 @@ class LevelDbTransaction {
    * Schedules the row identified by `key` to be set to `value` when this
    * transaction commits.
    */
-  void Put(std::string key, std::string value);
+  void Put(absl::string_view key, absl::string_view value);
 
   /**
    * Sets the contents of `value` to the latest known value for the given key,
@@ -189,16 +205,50 @@ class LevelDbTransaction {
    */
   std::unique_ptr<Iterator> NewIterator();
 
+  /**
+   * Returns a new Iterator like `NewIterator`, for scans over large key ranges
+   * in garbage collection and migrations. The blocks it reads aren't added to
+   * the block cache, so that the scan doesn't evict the hot working set.
+   */
+  std::unique_ptr<Iterator> NewMaintenanceIterator();
+
   /**
    * Commits the transaction. All pending changes are written. The transaction
    * should not be used after calling this method.
    */
   void Commit();
 
+  /**
+   * Commits the transaction like `Commit()`, but with the given options instead
+   * of the ones it was created with.
+   */
+  void Commit(const leveldb::WriteOptions& write_options);
+
   std::string ToString();
 
  private:
+  /**
+   * An append-only store for the keys and values of pending changes.
+   *
+   * Bytes are copied into large blocks instead of individually allocated
+   * strings, so a transaction that writes thousands of rows only allocates a
+   * handful of times. Nothing is freed until the arena is destroyed, so views
+   * returned by Copy stay valid even after the row they belong to is
+   * overwritten or deleted.
+   */
+  class Arena {
+   public:
+    /** Copies the given bytes into the arena and returns a view of the copy. */
+    absl::string_view Copy(absl::string_view bytes);
+
+   private:
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* next_ = nullptr;
+    size_t remaining_ = 0;
+  };
+
   leveldb::DB* db_;
+  Arena arena_;
   Mutations mutations_;
   Deletions deletions_;
   leveldb::ReadOptions read_options_;
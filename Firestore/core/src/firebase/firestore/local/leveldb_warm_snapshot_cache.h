@@ -0,0 +1,72 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_WARM_SNAPSHOT_CACHE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_WARM_SNAPSHOT_CACHE_H_
+
+#if !defined(__OBJC__)
+#error "For now, this file must only be included by ObjC source files."
+#endif  // !defined(__OBJC__)
+
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/local/warm_snapshot_cache.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/types/optional.h"
+
+@class FSTLevelDB;
+@class FSTLocalSerializer;
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Warm snapshots backed by leveldb. Each snapshot is stored in a single row,
+ * so that loading it takes one read of contiguous bytes.
+ */
+class LevelDbWarmSnapshotCache : public WarmSnapshotCache {
+ public:
+  LevelDbWarmSnapshotCache(FSTLevelDB* db, FSTLocalSerializer* serializer);
+
+  void Save(model::TargetId target_id,
+            const model::DocumentSet& documents,
+            size_t max_targets) override;
+  absl::optional<model::DocumentMap> Get(model::TargetId target_id) override;
+  void RemoveAll() override;
+
+ private:
+  /** Returns the saved targets, from the most to the least recently saved. */
+  std::vector<model::TargetId> ReadTargetIds();
+  void WriteTargetIds(const std::vector<model::TargetId>& target_ids);
+
+  // This instance is owned by FSTLevelDB; avoid a retain cycle.
+  __weak FSTLevelDB* db_;
+  FSTLocalSerializer* serializer_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_WARM_SNAPSHOT_CACHE_H_
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_warm_snapshot_cache.h"
+
+#import <Foundation/Foundation.h>
+#import <Protobuf/GPBCodedInputStream.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
+#import "Firestore/Source/Local/FSTLevelDB.h"
+#import "Firestore/Source/Local/FSTLocalSerializer.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using leveldb::Status;
+using model::DocumentMap;
+using model::DocumentSet;
+using model::TargetId;
+
+LevelDbWarmSnapshotCache::LevelDbWarmSnapshotCache(
+    FSTLevelDB* db, FSTLocalSerializer* serializer)
+    : db_(db), serializer_(serializer) {
+}
+
+void LevelDbWarmSnapshotCache::Save(TargetId target_id,
+                                    const DocumentSet& documents,
+                                    size_t max_targets) {
+  std::vector<TargetId> target_ids = ReadTargetIds();
+  target_ids.erase(
+      std::remove(target_ids.begin(), target_ids.end(), target_id),
+      target_ids.end());
+  target_ids.insert(target_ids.begin(), target_id);
+  while (target_ids.size() > max_targets) {
+    db_.currentTransaction->Delete(
+        LevelDbWarmSnapshotKey::Key(target_ids.back()));
+    target_ids.pop_back();
+  }
+  WriteTargetIds(target_ids);
+  if (target_ids.empty()) {
+    return;
+  }
+
+  NSMutableData* encoded = [NSMutableData data];
+  for (FSTDocument* document : documents) {
+    [encoded appendData:[[serializer_ encodedMaybeDocument:document]
+                            delimitedData]];
+  }
+  db_.currentTransaction->Put(
+      LevelDbWarmSnapshotKey::Key(target_id),
+      absl::string_view{static_cast<const char*>(encoded.bytes),
+                        encoded.length});
+}
+
+absl::optional<DocumentMap> LevelDbWarmSnapshotCache::Get(
+    TargetId target_id) {
+  std::string key = LevelDbWarmSnapshotKey::Key(target_id);
+  std::string value;
+  Status status = db_.currentTransaction->Get(key, &value);
+  if (status.IsNotFound()) {
+    return absl::nullopt;
+  } else if (!status.ok()) {
+    HARD_FAIL("Fetch warm snapshot for target %s failed with status: %s",
+              target_id, status.ToString());
+  }
+
+  NSData* data = [[NSData alloc] initWithBytesNoCopy:(void*)value.data()
+                                              length:value.size()
+                                        freeWhenDone:NO];
+  GPBCodedInputStream* stream = [GPBCodedInputStream streamWithData:data];
+
+  DocumentMap result;
+  while (![stream isAtEnd]) {
+    NSError* error;
+    FSTPBMaybeDocument* proto =
+        [FSTPBMaybeDocument parseDelimitedFromCodedInputStream:stream
+                                             extensionRegistry:nil
+                                                         error:&error];
+    if (!proto) {
+      // The snapshot is only a hint; the query still runs in full.
+      LOG_WARN("Ignoring malformed warm snapshot for target %s: %s", target_id,
+               error);
+      return absl::nullopt;
+    }
+
+    FSTMaybeDocument* document = [serializer_ decodedMaybeDocument:proto];
+    HARD_ASSERT([document isKindOfClass:[FSTDocument class]],
+                "Warm snapshot of target %s contains a missing document: %s",
+                target_id, document);
+    result = std::move(result).insert(document.key,
+                                      static_cast<FSTDocument*>(document));
+  }
+  return result;
+}
+
+void LevelDbWarmSnapshotCache::RemoveAll() {
+  for (TargetId target_id : ReadTargetIds()) {
+    db_.currentTransaction->Delete(LevelDbWarmSnapshotKey::Key(target_id));
+  }
+  db_.currentTransaction->Delete(LevelDbWarmSnapshotGlobalKey::Key());
+}
+
+std::vector<TargetId> LevelDbWarmSnapshotCache::ReadTargetIds() {
+  std::vector<TargetId> target_ids;
+  std::string value;
+  Status status = db_.currentTransaction->Get(
+      LevelDbWarmSnapshotGlobalKey::Key(), &value);
+  if (status.IsNotFound()) {
+    return target_ids;
+  } else if (!status.ok()) {
+    HARD_FAIL("Fetch warm snapshot targets failed with status: %s",
+              status.ToString());
+  }
+
+  if (!LevelDbWarmSnapshotGlobalKey::DecodeTargetIds(value, &target_ids)) {
+    HARD_FAIL("Failed to read the targets of the warm snapshots");
+  }
+  return target_ids;
+}
+
+void LevelDbWarmSnapshotCache::WriteTargetIds(
+    const std::vector<TargetId>& target_ids) {
+  db_.currentTransaction->Put(
+      LevelDbWarmSnapshotGlobalKey::Key(),
+      LevelDbWarmSnapshotGlobalKey::EncodeTargetIds(target_ids));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
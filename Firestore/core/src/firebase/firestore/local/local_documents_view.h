@@ -19,14 +19,18 @@
 
 #import <Foundation/Foundation.h>
 
+#include <unordered_map>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/core/document_sizer.h"
 #include "Firestore/core/src/firebase/firestore/local/index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
+#include "Firestore/core/src/firebase/firestore/local/query_execution_stats.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -43,9 +47,19 @@ namespace local {
  * have a cached version in remoteDocumentCache or local mutations for the
  * document). The view is computed by applying the mutations in the
  * FSTMutationQueue to the FSTRemoteDocumentCache.
+ *
+ * The local views of documents with pending mutations are cached as
+ * "overlays", so that reading them again doesn't replay their mutation batches.
+ * The owner must call `InvalidateOverlays` whenever the mutation batches
+ * affecting a document or its remote version change.
  */
 class LocalDocumentsView {
  public:
+  /** Mutation batches grouped by the documents they affect. */
+  using BatchesByKey = std::unordered_map<model::DocumentKey,
+                                          std::vector<FSTMutationBatch*>,
+                                          model::DocumentKeyHash>;
+
   LocalDocumentsView(RemoteDocumentCache* remote_document_cache,
                      MutationQueue* mutation_queue,
                      IndexManager* index_manager)
@@ -73,22 +87,69 @@ class LocalDocumentsView {
   /**
    * Similar to `documentsForKeys`, but creates the local view from the given
    * `baseDocs` without retrieving documents from the local store.
+   *
+   * `base_docs` must be the current remote versions of the documents. Their
+   * overlays are recomputed from them.
    */
   model::MaybeDocumentMap GetLocalViewOfDocuments(
       const model::MaybeDocumentMap& base_docs);
 
-  /** Performs a query against the local view of all documents. */
-  model::DocumentMap GetDocumentsMatchingQuery(FSTQuery* query);
+  /**
+   * Performs a query against the local view of all documents.
+   *
+   * @param stats If not null, receives how the query was executed. Counters
+   *     are added to rather than reset.
+   */
+  model::DocumentMap GetDocumentsMatchingQuery(
+      FSTQuery* query, QueryExecutionStats* _Nullable stats = nullptr);
+
+  /**
+   * Performs a query against the local view of all documents, starting from
+   * the documents that were its remote results as of `snapshot_version`.
+   * Besides those, only the remote documents read into the cache since then
+   * and the documents with pending mutations are matched against the query.
+   *
+   * Falls back to matching every document if the query isn't a collection
+   * query, or if it has a limit and documents that were beyond the limit may
+   * now be part of the results.
+   *
+   * @param remote_keys The keys of the documents in the query's target, which
+   *     must have been exactly the results of the query, with no documents in
+   *     limbo, as of `snapshot_version`.
+   * @param stats If not null, receives how the query was executed. Counters
+   *     are added to rather than reset.
+   */
+  model::DocumentMap GetDocumentsMatchingQuery(
+      FSTQuery* query,
+      const model::DocumentKeySet& remote_keys,
+      const model::SnapshotVersion& snapshot_version,
+      QueryExecutionStats* _Nullable stats = nullptr);
+
+  /** Drops the cached local views of the documents identified by `keys`. */
+  void InvalidateOverlays(const model::DocumentKeySet& keys);
+
+  /**
+   * Drops all cached local views, e.g. to free memory. They are recomputed
+   * when the documents are read again.
+   */
+  void DropOverlays();
+
+  /** Estimates the number of bytes held by the cached local views. */
+  size_t EstimateOverlayByteSize(const core::DocumentSizer& sizer) const;
 
  private:
-  /** Internal version of GetDocument that allows re-using batches. */
+  /**
+   * Internal version of GetDocument that allows re-using batches. Records the
+   * overlay of the document if any of the batches affect it.
+   */
   FSTMaybeDocument* _Nullable GetDocument(
       const model::DocumentKey& key,
       const std::vector<FSTMutationBatch*>& batches);
 
   /**
    * Returns the view of the given `docs` as they would appear after applying
-   * all mutations in the given `batches`.
+   * all mutations in the given `batches`, and records the overlays of the
+   * documents that any of the batches affect.
    */
   model::MaybeDocumentMap ApplyLocalMutationsToDocuments(
       const model::MaybeDocumentMap& docs,
@@ -96,16 +157,54 @@ class LocalDocumentsView {
 
   /** Performs a simple document lookup for the given path. */
   model::DocumentMap GetDocumentsMatchingDocumentQuery(
-      const model::ResourcePath& doc_path);
+      const model::ResourcePath& doc_path,
+      QueryExecutionStats* _Nullable stats);
+
+  /** Looks up each of the documents of a query for a set of keys. */
+  model::DocumentMap GetDocumentsMatchingDocumentKeysQuery(
+      const model::DocumentKeySet& keys, QueryExecutionStats* _Nullable stats);
 
-  model::DocumentMap GetDocumentsMatchingCollectionGroupQuery(FSTQuery* query);
+  model::DocumentMap GetDocumentsMatchingCollectionGroupQuery(
+      FSTQuery* query, QueryExecutionStats* _Nullable stats);
+
+  /**
+   * Queries the remote documents read after `since_read_time` (or all of
+   * them if it's `SnapshotVersion::None()`) and overlays mutations.
+   *
+   * When reading all documents for a limit query, only the first documents in
+   * the query's order are read, enough for the view to fill the limit and the
+   * overflow it keeps past it.
+   */
+  model::DocumentMap GetDocumentsMatchingCollectionQuery(
+      FSTQuery* query,
+      const model::SnapshotVersion& since_read_time,
+      QueryExecutionStats* _Nullable stats);
 
-  /** Queries the remote documents and overlays mutations. */
-  model::DocumentMap GetDocumentsMatchingCollectionQuery(FSTQuery* query);
+  /**
+   * Replaces the documents in `results` whose local views differ from their
+   * remote versions, then drops those that don't match `query`.
+   *
+   * @param batches_by_key The mutation batches affecting each document the
+   *     query reads, in batch order.
+   */
+  model::DocumentMap ApplyLocalMutationsToQueryResults(
+      FSTQuery* query,
+      model::DocumentMap results,
+      const BatchesByKey& batches_by_key,
+      QueryExecutionStats* _Nullable stats);
 
   RemoteDocumentCache* remote_document_cache_;
   MutationQueue* mutation_queue_;
   IndexManager* index_manager_;
+
+  /**
+   * The local views of documents with pending mutations, keyed by document.
+   * A nil value means that the mutations leave no document behind.
+   */
+  std::unordered_map<model::DocumentKey,
+                     FSTMaybeDocument* _Nullable,
+                     model::DocumentKeyHash>
+      overlays_;
 };
 
 }  // namespace local
@@ -16,13 +16,17 @@
 
 #import "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTMutation.h"
 #import "Firestore/Source/Model/FSTMutationBatch.h"
 
+#include "Firestore/core/src/firebase/firestore/core/memory_stats.h"
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
@@ -45,8 +49,122 @@ using model::ResourcePath;
 using model::SnapshotVersion;
 using util::MakeString;
 
+namespace {
+
+/**
+ * The number of parents from which a Collection Group query reads the whole
+ * collection group at once. Below it, querying each collection is cheaper,
+ * since those queries can use the field index.
+ */
+const size_t kMinParentsToScanCollectionGroup = 8;
+
+/**
+ * The number of documents past its limit that are read for a limit query.
+ * `FSTView` keeps up to 10 documents past the limit to refill itself from, and
+ * needs one more to know that there are documents past those.
+ */
+const size_t kLimitQueryOverflow = 11;
+
+/**
+ * Returns the local view of `maybe_doc`, treating a missing document as
+ * deleted.
+ */
+FSTMaybeDocument* LocalViewOrDeleted(const DocumentKey& key,
+                                     FSTMaybeDocument* _Nullable maybe_doc) {
+  // TODO(http://b/32275378): Don't conflate missing / deleted.
+  if (!maybe_doc) {
+    return [FSTDeletedDocument documentWithKey:key
+                                       version:SnapshotVersion::None()
+                         hasCommittedMutations:NO];
+  }
+  return maybe_doc;
+}
+
+/**
+ * Adds the time between its construction and destruction to `*elapsed`, unless
+ * `elapsed` is null.
+ */
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(std::chrono::microseconds* _Nullable elapsed)
+      : elapsed_{elapsed} {
+    if (elapsed_) {
+      start_ = Clock::now();
+    }
+  }
+
+  ~ScopedTimer() {
+    if (elapsed_) {
+      *elapsed_ += std::chrono::duration_cast<std::chrono::microseconds>(
+          Clock::now() - start_);
+    }
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  std::chrono::microseconds* _Nullable elapsed_;
+  Clock::time_point start_;
+};
+
+/**
+ * Groups the given batches by the documents they affect for which `in_scope`
+ * holds, keeping them in batch order.
+ */
+template <typename Predicate>
+LocalDocumentsView::BatchesByKey GroupBatchesByKey(
+    const std::vector<FSTMutationBatch*>& batches, const Predicate& in_scope) {
+  LocalDocumentsView::BatchesByKey batches_by_key;
+  for (FSTMutationBatch* batch : batches) {
+    for (FSTMutation* mutation : [batch mutations]) {
+      if (!in_scope(mutation.key)) {
+        continue;
+      }
+      std::vector<FSTMutationBatch*>& key_batches =
+          batches_by_key[mutation.key];
+      if (key_batches.empty() || key_batches.back() != batch) {
+        key_batches.push_back(batch);
+      }
+    }
+  }
+  return batches_by_key;
+}
+
+/**
+ * Returns whether the results of a limit query, computed from the documents
+ * that were its remote results as of `snapshot_version`, may lack documents
+ * that were then beyond its limit. That's the case if one of the documents no
+ * longer matches, or if the one at the edge of the limit changed since, since
+ * unchanged documents could now sort before it.
+ */
+bool NeedsRefill(FSTQuery* query,
+                 const DocumentMap& previous_results,
+                 const DocumentKeySet& remote_keys,
+                 const SnapshotVersion& snapshot_version) {
+  if (previous_results.size() != remote_keys.size()) {
+    return true;
+  }
+
+  FSTDocument* edge = nil;
+  for (const auto& kv : previous_results.underlying_map()) {
+    auto* doc = static_cast<FSTDocument*>(kv.second);
+    if (!edge || query.comparator.Compare(doc, edge) ==
+                     util::ComparisonResult::Descending) {
+      edge = doc;
+    }
+  }
+  return edge && (edge.hasPendingWrites || edge.version > snapshot_version);
+}
+
+}  // namespace
+
 FSTMaybeDocument* _Nullable LocalDocumentsView::GetDocument(
     const DocumentKey& key) {
+  auto overlay = overlays_.find(key);
+  if (overlay != overlays_.end()) {
+    return overlay->second;
+  }
+
   std::vector<FSTMutationBatch*> batches =
       mutation_queue_->AllMutationBatchesAffectingDocumentKey(key);
   return GetDocument(key, batches);
@@ -59,28 +177,64 @@ FSTMaybeDocument* _Nullable LocalDocumentsView::GetDocument(
     document = [batch applyToLocalDocument:document documentKey:key];
   }
 
+  if (!batches.empty()) {
+    overlays_[key] = document;
+  }
   return document;
 }
 
 MaybeDocumentMap LocalDocumentsView::ApplyLocalMutationsToDocuments(
     const MaybeDocumentMap& docs,
     const std::vector<FSTMutationBatch*>& batches) {
-  MaybeDocumentMap results;
+  DocumentKeySet mutated_keys;
+  for (FSTMutationBatch* batch : batches) {
+    for (FSTMutation* mutation : [batch mutations]) {
+      mutated_keys = std::move(mutated_keys).insert(mutation.key);
+    }
+  }
 
+  MaybeDocumentMap results;
   for (const auto& kv : docs) {
     const DocumentKey& key = kv.first;
     FSTMaybeDocument* local_view = kv.second;
-    for (FSTMutationBatch* batch : batches) {
-      local_view = [batch applyToLocalDocument:local_view documentKey:key];
+    if (mutated_keys.contains(key)) {
+      for (FSTMutationBatch* batch : batches) {
+        local_view = [batch applyToLocalDocument:local_view documentKey:key];
+      }
+      overlays_[key] = local_view;
+      if (stats) {
+        stats->documents_overlaid++;
+      }
     }
-    results = results.insert(key, local_view);
+    results = std::move(results).insert(key, local_view);
   }
   return results;
 }
 
 MaybeDocumentMap LocalDocumentsView::GetDocuments(const DocumentKeySet& keys) {
-  MaybeDocumentMap docs = remote_document_cache_->GetAll(keys);
-  return GetLocalViewOfDocuments(docs);
+  // Documents with an overlay need neither their remote version nor their
+  // mutation batches.
+  MaybeDocumentMap overlaid;
+  DocumentKeySet remaining_keys;
+  for (const DocumentKey& key : keys) {
+    auto overlay = overlays_.find(key);
+    if (overlay != overlays_.end()) {
+      overlaid = std::move(overlaid).insert(
+          key, LocalViewOrDeleted(key, overlay->second));
+    } else {
+      remaining_keys = std::move(remaining_keys).insert(key);
+    }
+  }
+  if (remaining_keys.empty()) {
+    return overlaid;
+  }
+
+  MaybeDocumentMap docs = remote_document_cache_->GetAll(remaining_keys);
+  MaybeDocumentMap results = GetLocalViewOfDocuments(docs);
+  for (const auto& kv : overlaid) {
+    results = std::move(results).insert(kv.first, kv.second);
+  }
+  return results;
 }
 
 /**
@@ -93,7 +247,7 @@ MaybeDocumentMap LocalDocumentsView::GetLocalViewOfDocuments(
 
   DocumentKeySet all_keys;
   for (const auto& kv : base_docs) {
-    all_keys = all_keys.insert(kv.first);
+    all_keys = std::move(all_keys).insert(kv.first);
   }
   std::vector<FSTMutationBatch*> batches =
       mutation_queue_->AllMutationBatchesAffectingDocumentKeys(all_keys);
@@ -102,43 +256,124 @@ MaybeDocumentMap LocalDocumentsView::GetLocalViewOfDocuments(
 
   for (const auto& kv : docs) {
     const DocumentKey& key = kv.first;
-    FSTMaybeDocument* maybe_doc = kv.second;
+    results =
+        std::move(results).insert(key, LocalViewOrDeleted(key, kv.second));
+  }
 
-    // TODO(http://b/32275378): Don't conflate missing / deleted.
-    if (!maybe_doc) {
-      maybe_doc = [FSTDeletedDocument documentWithKey:key
-                                              version:SnapshotVersion::None()
-                                hasCommittedMutations:NO];
+  return results;
+}
+
+DocumentMap LocalDocumentsView::GetDocumentsMatchingQuery(
+    FSTQuery* query, QueryExecutionStats* _Nullable stats) {
+  DocumentMap results;
+  {
+    ScopedTimer timer{stats ? &stats->total_time : nullptr};
+    if ([query isDocumentQuery]) {
+      results = GetDocumentsMatchingDocumentQuery(query.path, stats);
+    } else if ([query isDocumentKeysQuery]) {
+      results =
+          GetDocumentsMatchingDocumentKeysQuery(query.documentKeys, stats);
+    } else if ([query isCollectionGroupQuery]) {
+      results = GetDocumentsMatchingCollectionGroupQuery(query, stats);
+    } else {
+      results = GetDocumentsMatchingCollectionQuery(
+          query, SnapshotVersion::None(), stats);
     }
-    results = results.insert(key, maybe_doc);
   }
-
+  if (stats) {
+    stats->documents_returned += static_cast<int64_t>(results.size());
+  }
   return results;
 }
 
-DocumentMap LocalDocumentsView::GetDocumentsMatchingQuery(FSTQuery* query) {
-  if ([query isDocumentQuery]) {
-    return GetDocumentsMatchingDocumentQuery(query.path);
-  } else if ([query isCollectionGroupQuery]) {
-    return GetDocumentsMatchingCollectionGroupQuery(query);
-  } else {
-    return GetDocumentsMatchingCollectionQuery(query);
+DocumentMap LocalDocumentsView::GetDocumentsMatchingQuery(
+    FSTQuery* query,
+    const DocumentKeySet& remote_keys,
+    const SnapshotVersion& snapshot_version,
+    QueryExecutionStats* _Nullable stats) {
+  if ([query isDocumentQuery] || [query isDocumentKeysQuery] ||
+      [query isCollectionGroupQuery] ||
+      snapshot_version == SnapshotVersion::None()) {
+    return GetDocumentsMatchingQuery(query, stats);
+  }
+
+  DocumentMap results;
+  {
+    ScopedTimer timer{stats ? &stats->total_time : nullptr};
+    if (stats) {
+      stats->documents_scanned += static_cast<int64_t>(remote_keys.size());
+    }
+    DocumentMap previous_results;
+    for (const auto& kv : GetDocuments(remote_keys)) {
+      FSTMaybeDocument* doc = kv.second;
+      if ([doc isKindOfClass:[FSTDocument class]] &&
+          [query matchesDocument:static_cast<FSTDocument*>(doc)]) {
+        previous_results = std::move(previous_results)
+                               .insert(doc.key, static_cast<FSTDocument*>(doc));
+      }
+    }
+
+    if (query.limit != NSNotFound &&
+        NeedsRefill(query, previous_results, remote_keys, snapshot_version)) {
+      results = GetDocumentsMatchingCollectionQuery(
+          query, SnapshotVersion::None(), stats);
+    } else {
+      results =
+          GetDocumentsMatchingCollectionQuery(query, snapshot_version, stats);
+      for (const auto& kv : previous_results.underlying_map()) {
+        results = std::move(results).insert(
+            kv.first, static_cast<FSTDocument*>(kv.second));
+      }
+      if (stats) {
+        stats->access_path = QueryAccessPath::TargetKeys;
+      }
+    }
   }
+  if (stats) {
+    stats->documents_returned += static_cast<int64_t>(results.size());
+  }
+  return results;
 }
 
 DocumentMap LocalDocumentsView::GetDocumentsMatchingDocumentQuery(
-    const ResourcePath& doc_path) {
+    const ResourcePath& doc_path, QueryExecutionStats* _Nullable stats) {
   DocumentMap result;
+  DocumentKey key{doc_path};
+  if (stats) {
+    stats->access_path = QueryAccessPath::DocumentLookup;
+    if (overlays_.find(key) != overlays_.end()) {
+      stats->overlays_reused++;
+    } else {
+      stats->documents_scanned++;
+    }
+  }
   // Just do a simple document lookup.
-  FSTMaybeDocument* doc = GetDocument(DocumentKey{doc_path});
+  FSTMaybeDocument* doc = GetDocument(key);
   if ([doc isKindOfClass:[FSTDocument class]]) {
-    result = result.insert(doc.key, static_cast<FSTDocument*>(doc));
+    result = std::move(result).insert(doc.key, static_cast<FSTDocument*>(doc));
+  }
+  return result;
+}
+
+DocumentMap LocalDocumentsView::GetDocumentsMatchingDocumentKeysQuery(
+    const DocumentKeySet& keys, QueryExecutionStats* _Nullable stats) {
+  if (stats) {
+    stats->access_path = QueryAccessPath::DocumentLookup;
+    stats->documents_scanned += static_cast<int64_t>(keys.size());
+  }
+  DocumentMap result;
+  for (const auto& kv : GetDocuments(keys)) {
+    FSTMaybeDocument* doc = kv.second;
+    if ([doc isKindOfClass:[FSTDocument class]]) {
+      result =
+          std::move(result).insert(doc.key, static_cast<FSTDocument*>(doc));
+    }
   }
   return result;
 }
 
 model::DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionGroupQuery(
-    FSTQuery* query) {
+    FSTQuery* query, QueryExecutionStats* _Nullable stats) {
   HARD_ASSERT(
       query.path.empty(),
       "Currently we only support collection group queries at the root.");
@@ -146,6 +381,31 @@ model::DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionGroupQuery(
   std::string collection_id = MakeString(query.collectionGroup);
   std::vector<ResourcePath> parents =
       index_manager_->GetCollectionParents(collection_id);
+
+  if (parents.size() >= kMinParentsToScanCollectionGroup) {
+    // Read the whole collection group at once rather than scanning the remote
+    // documents and the mutation queue once per parent.
+    DocumentMap results;
+    {
+      ScopedTimer timer{stats ? &stats->remote_documents_time : nullptr};
+      results = remote_document_cache_->GetAllInCollectionGroup(collection_id,
+                                                                stats);
+    }
+    ScopedTimer timer{stats ? &stats->mutations_time : nullptr};
+    std::vector<FSTMutationBatch*> batches =
+        mutation_queue_->AllMutationBatches();
+    if (stats) {
+      stats->mutation_batches_read += static_cast<int64_t>(batches.size());
+    }
+    BatchesByKey batches_by_key =
+        GroupBatchesByKey(batches, [&](const DocumentKey& key) {
+          const ResourcePath& path = key.path();
+          return path[path.size() - 2] == collection_id;
+        });
+    return ApplyLocalMutationsToQueryResults(query, std::move(results),
+                                             batches_by_key, stats);
+  }
+
   DocumentMap results;
 
   // Perform a collection query against each parent that contains the
@@ -153,49 +413,118 @@ model::DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionGroupQuery(
   for (const ResourcePath& parent : parents) {
     FSTQuery* collection_query =
         [query collectionQueryAtPath:parent.Append(collection_id)];
-    DocumentMap collection_results =
-        GetDocumentsMatchingCollectionQuery(collection_query);
+    DocumentMap collection_results = GetDocumentsMatchingCollectionQuery(
+        collection_query, SnapshotVersion::None(), stats);
     for (const auto& kv : collection_results.underlying_map()) {
       const DocumentKey& key = kv.first;
       FSTDocument* doc = static_cast<FSTDocument*>(kv.second);
-      results = results.insert(key, doc);
+      results = std::move(results).insert(key, doc);
     }
   }
+  if (stats) {
+    stats->access_path = QueryAccessPath::CollectionQueryPerParent;
+  }
   return results;
 }
 
 DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
-    FSTQuery* query) {
-  DocumentMap results = remote_document_cache_->GetMatching(query);
-  // Get locally persisted mutation batches.
-  std::vector<FSTMutationBatch*> matchingBatches =
-      mutation_queue_->AllMutationBatchesAffectingQuery(query);
-
-  for (FSTMutationBatch* batch : matchingBatches) {
-    for (FSTMutation* mutation : [batch mutations]) {
+    FSTQuery* query,
+    const SnapshotVersion& since_read_time,
+    QueryExecutionStats* _Nullable stats) {
+  BatchesByKey batches_by_key;
+  {
+    ScopedTimer timer{stats ? &stats->mutations_time : nullptr};
+    // Get locally persisted mutation batches.
+    std::vector<FSTMutationBatch*> batches =
+        mutation_queue_->AllMutationBatchesAffectingQuery(query);
+    if (stats) {
+      stats->mutation_batches_read += static_cast<int64_t>(batches.size());
+    }
+    batches_by_key = GroupBatchesByKey(batches, [&](const DocumentKey& key) {
       // Only process documents belonging to the collection.
-      if (!query.path.IsImmediateParentOf(mutation.key.path())) {
-        continue;
-      }
+      return query.path.IsImmediateParentOf(key.path());
+    });
+  }
+
+  DocumentMap results;
+  {
+    ScopedTimer timer{stats ? &stats->remote_documents_time : nullptr};
+    if (since_read_time != SnapshotVersion::None()) {
+      results =
+          remote_document_cache_->GetMatching(query, since_read_time, stats);
+    } else if (query.limit != NSNotFound) {
+      // Each mutated document can displace at most one of the remote
+      // documents ahead of the limit, so reading that many more keeps every
+      // document the view ends up with among the results.
+      size_t count = static_cast<size_t>(query.limit) + kLimitQueryOverflow +
+                     batches_by_key.size();
+      results = remote_document_cache_->GetFirstMatching(query, count, stats);
+    } else {
+      results = remote_document_cache_->GetMatching(query, stats);
+    }
+  }
+  ScopedTimer timer{stats ? &stats->mutations_time : nullptr};
+  return ApplyLocalMutationsToQueryResults(query, std::move(results),
+                                           batches_by_key, stats);
+}
+
+DocumentMap LocalDocumentsView::ApplyLocalMutationsToQueryResults(
+    FSTQuery* query,
+    DocumentMap results,
+    const BatchesByKey& batches_by_key,
+    QueryExecutionStats* _Nullable stats) {
+  // The remote document cache may have used an index to skip documents that
+  // don't match the query remotely, but a local mutation can still make them
+  // match. Read those that have no overlay yet in one batch rather than one at
+  // a time.
+  DocumentKeySet missing_keys;
+  for (const auto& kv : batches_by_key) {
+    const DocumentKey& key = kv.first;
+    if (overlays_.find(key) == overlays_.end() &&
+        results.underlying_map().find(key) == results.underlying_map().end()) {
+      missing_keys = std::move(missing_keys).insert(key);
+    }
+  }
+  MaybeDocumentMap missing_docs = remote_document_cache_->GetAll(missing_keys);
 
-      const DocumentKey& key = mutation.key;
-      // base_doc may be nil for the documents that weren't yet written to the
-      // backend.
-      FSTMaybeDocument* base_doc = nil;
+  for (const auto& kv : batches_by_key) {
+    const DocumentKey& key = kv.first;
+    FSTMaybeDocument* _Nullable local_view = nil;
+    auto overlay = overlays_.find(key);
+    if (overlay != overlays_.end()) {
+      local_view = overlay->second;
+      if (stats) {
+        stats->overlays_reused++;
+      }
+    } else {
+      // The remote version may be nil for the documents that weren't yet
+      // written to the backend.
       auto found = results.underlying_map().find(key);
       if (found != results.underlying_map().end()) {
-        base_doc = found->second;
-      }
-      FSTMaybeDocument* mutated_doc =
-          [mutation applyToLocalDocument:base_doc
-                            baseDocument:base_doc
-                          localWriteTime:batch.localWriteTime];
-
-      if ([mutated_doc isKindOfClass:[FSTDocument class]]) {
-        results = results.insert(key, static_cast<FSTDocument*>(mutated_doc));
+        local_view = found->second;
       } else {
-        results = results.erase(key);
+        auto missing = missing_docs.find(key);
+        if (missing != missing_docs.end()) {
+          local_view = missing->second;
+        }
+      }
+      // The base document is read once, before the first mutation, so that
+      // each mutation applies to the result of the previous one: a patch that
+      // follows a delete must see the deleted document, not the remote one.
+      for (FSTMutationBatch* batch : kv.second) {
+        local_view = [batch applyToLocalDocument:local_view documentKey:key];
       }
+      overlays_[key] = local_view;
+      if (stats) {
+        stats->documents_overlaid++;
+      }
+    }
+
+    if ([local_view isKindOfClass:[FSTDocument class]]) {
+      results =
+          std::move(results).insert(key, static_cast<FSTDocument*>(local_view));
+    } else {
+      results = std::move(results).erase(key);
     }
   }
 
@@ -208,13 +537,32 @@ DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
     const DocumentKey& key = kv.first;
     auto* doc = static_cast<FSTDocument*>(kv.second);
     if (![query matchesDocument:doc]) {
-      results = results.erase(key);
+      results = std::move(results).erase(key);
     }
   }
 
   return results;
 }
 
+void LocalDocumentsView::InvalidateOverlays(const DocumentKeySet& keys) {
+  for (const DocumentKey& key : keys) {
+    overlays_.erase(key);
+  }
+}
+
+void LocalDocumentsView::DropOverlays() {
+  overlays_.clear();
+}
+
+size_t LocalDocumentsView::EstimateOverlayByteSize(
+    const core::DocumentSizer& sizer) const {
+  size_t size = 0;
+  for (const auto& kv : overlays_) {
+    size += kv.second ? sizer(kv.second) : core::DocumentKeyByteSize(kv.first);
+  }
+  return size;
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -39,6 +39,7 @@ namespace local {
 
 using core::Query;
 using model::Document;
+using model::DocumentState;
 using model::MaybeDocument;
 using model::Mutation;
 using model::MutationBatch;
@@ -52,34 +53,43 @@ using remote::MakeArray;
 using util::Status;
 using util::StringFormat;
 
+namespace {
+
+DocumentState DecodeDocumentState(const firestore_client_MaybeDocument& proto) {
+  return proto.has_committed_mutations ? DocumentState::kCommittedMutations
+                                       : DocumentState::kSynced;
+}
+
+}  // namespace
+
 firestore_client_MaybeDocument LocalSerializer::EncodeMaybeDocument(
     const MaybeDocument& maybe_doc) const {
   firestore_client_MaybeDocument result{};
 
   switch (maybe_doc.type()) {
-    case MaybeDocument::Type::Document:
+    case MaybeDocument::Type::Document: {
+      const auto& doc = static_cast<const Document&>(maybe_doc);
       result.which_document_type = firestore_client_MaybeDocument_document_tag;
-      result.document = EncodeDocument(static_cast<const Document&>(maybe_doc));
-      // TODO(rsgowman): heldwriteacks:
-      // result.has_committed_mutations = existing_doc.HasCommittedMutations();
+      result.document = EncodeDocument(doc);
+      result.has_committed_mutations = doc.HasCommittedMutations();
       return result;
+    }
 
-    case MaybeDocument::Type::NoDocument:
+    case MaybeDocument::Type::NoDocument: {
+      const auto& no_doc = static_cast<const NoDocument&>(maybe_doc);
       result.which_document_type =
           firestore_client_MaybeDocument_no_document_tag;
-      result.no_document =
-          EncodeNoDocument(static_cast<const NoDocument&>(maybe_doc));
-      // TODO(rsgowman): heldwriteacks:
-      // result.has_committed_mutations = no_doc.HasCommittedMutations();
+      result.no_document = EncodeNoDocument(no_doc);
+      result.has_committed_mutations = no_doc.HasCommittedMutations();
       return result;
+    }
 
     case MaybeDocument::Type::UnknownDocument:
       result.which_document_type =
           firestore_client_MaybeDocument_unknown_document_tag;
       result.unknown_document =
           EncodeUnknownDocument(static_cast<const UnknownDocument&>(maybe_doc));
-      // TODO(rsgowman): heldwriteacks:
-      // result.has_committed_mutations = true;
+      result.has_committed_mutations = true;
       return result;
 
     case MaybeDocument::Type::Unknown:
@@ -96,10 +106,12 @@ std::unique_ptr<MaybeDocument> LocalSerializer::DecodeMaybeDocument(
 
   switch (proto.which_document_type) {
     case firestore_client_MaybeDocument_document_tag:
-      return rpc_serializer_.DecodeDocument(reader, proto.document);
+      return rpc_serializer_.DecodeDocument(
+          reader, proto.document, DecodeDocumentState(proto));
 
     case firestore_client_MaybeDocument_no_document_tag:
-      return DecodeNoDocument(reader, proto.no_document);
+      return DecodeNoDocument(reader, proto.no_document,
+                              proto.has_committed_mutations);
 
     case firestore_client_MaybeDocument_unknown_document_tag:
       return DecodeUnknownDocument(reader, proto.unknown_document);
@@ -117,6 +129,18 @@ std::unique_ptr<MaybeDocument> LocalSerializer::DecodeMaybeDocument(
   UNREACHABLE();
 }
 
+std::unique_ptr<MaybeDocument> LocalSerializer::DecodeMaybeDocumentLazily(
+    Reader* reader, firestore_client_MaybeDocument* proto) const {
+  if (!reader->status().ok()) return nullptr;
+
+  if (proto->which_document_type ==
+      firestore_client_MaybeDocument_document_tag) {
+    return rpc_serializer_.DecodeDocumentLazily(reader, &proto->document,
+                                                DecodeDocumentState(*proto));
+  }
+  return DecodeMaybeDocument(reader, *proto);
+}
+
 google_firestore_v1_Document LocalSerializer::EncodeDocument(
     const Document& doc) const {
   google_firestore_v1_Document result{};
@@ -154,18 +178,16 @@ firestore_client_NoDocument LocalSerializer::EncodeNoDocument(
 }
 
 std::unique_ptr<NoDocument> LocalSerializer::DecodeNoDocument(
-    Reader* reader, const firestore_client_NoDocument& proto) const {
+    Reader* reader,
+    const firestore_client_NoDocument& proto,
+    bool has_committed_mutations) const {
   SnapshotVersion version =
       rpc_serializer_.DecodeSnapshotVersion(reader, proto.read_time);
 
-  // TODO(rsgowman): Fix hardcoding of has_committed_mutations.
-  // Instead, we should grab this from the proto (see other ports). However,
-  // we'll defer until the nanopb-master gets merged to master.
   return absl::make_unique<NoDocument>(
       rpc_serializer_.DecodeKey(reader,
                                 rpc_serializer_.DecodeString(proto.name)),
-      std::move(version),
-      /*has_committed_mutations=*/false);
+      std::move(version), has_committed_mutations);
 }
 
 firestore_client_UnknownDocument LocalSerializer::EncodeUnknownDocument(
@@ -86,6 +86,15 @@ class LocalSerializer {
       nanopb::Reader* reader,
       const firestore_client_MaybeDocument& proto) const;
 
+  /**
+   * @brief Like DecodeMaybeDocument, but the fields of a decoded Document are
+   * moved out of the proto and only decoded as they are accessed.
+   *
+   * The caller still needs to free the remainder of the proto.
+   */
+  std::unique_ptr<model::MaybeDocument> DecodeMaybeDocumentLazily(
+      nanopb::Reader* reader, firestore_client_MaybeDocument* proto) const;
+
   /**
    * @brief Encodes a QueryData to the equivalent nanopb proto, representing a
    * ::firestore::proto::Target, for local storage.
@@ -125,7 +134,9 @@ class LocalSerializer {
       const model::NoDocument& no_doc) const;
 
   std::unique_ptr<model::NoDocument> DecodeNoDocument(
-      nanopb::Reader* reader, const firestore_client_NoDocument& proto) const;
+      nanopb::Reader* reader,
+      const firestore_client_NoDocument& proto,
+      bool has_committed_mutations) const;
 
   firestore_client_UnknownDocument EncodeUnknownDocument(
       const model::UnknownDocument& unknown_doc) const;
@@ -63,6 +63,9 @@ class MemoryMutationQueue : public MutationQueue {
       std::vector<FSTMutation*>&& base_mutations,
       std::vector<FSTMutation*>&& mutations) override;
 
+  FSTMutationBatch* ReplaceMutationBatch(
+      FSTMutationBatch* batch, std::vector<FSTMutation*>&& mutations) override;
+
   void RemoveMutationBatch(FSTMutationBatch* batch) override;
 
   std::vector<FSTMutationBatch*> AllMutationBatches() override {
@@ -101,22 +104,24 @@ class MemoryMutationQueue : public MutationQueue {
       const std::set<model::BatchId>& batch_ids);
 
   /**
-   * Finds the index of the given batchID in the mutation queue. This operation
-   * is O(1).
+   * Finds the index of the given batchID in the mutation queue. Batches that
+   * were compacted away leave gaps in the batch IDs, so this is a binary
+   * search.
    *
-   * @return The computed index of the batch with the given BatchID, based on
-   * the state of the queue. Note this index can negative if the requested
-   * BatchID has already been removed from the queue or past the end of the
-   * queue if the BatchID is larger than the last added batch.
+   * @return The index of the first batch whose BatchID is not less than the
+   * given one, which is past the end of the queue if the BatchID is larger than
+   * the last added batch.
    */
-  int IndexOfBatchId(model::BatchId batch_id);
+  size_t IndexOfBatchId(model::BatchId batch_id);
 
   // This instance is owned by FSTMemoryPersistence; avoid a retain cycle.
   __weak FSTMemoryPersistence* persistence_;
   /**
    * A FIFO queue of all mutations to apply to the backend. Mutations are added
    * to the end of the queue as they're written, and removed from the front of
-   * the queue as the mutations become visible or are rejected.
+   * the queue as the mutations become visible or are rejected. Batches that
+   * haven't been sent yet may also be removed from anywhere in the queue when
+   * later writes make them redundant.
    *
    * When successfully applied, mutations must be acknowledged by the write
    * stream and made visible on the watch stream. It's possible for the watch
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/local/memory_mutation_queue.h"
 
+#include <algorithm>
 #include <utility>
 
 #import "Firestore/Protos/objc/firestore/local/Mutation.pbobjc.h"
@@ -97,7 +98,7 @@ FSTMutationBatch* MemoryMutationQueue::AddMutationBatch(
 
   // Track references by document key and index collection parents.
   for (FSTMutation* mutation : [batch mutations]) {
-    batches_by_document_key_ = batches_by_document_key_.insert(
+    batches_by_document_key_ = std::move(batches_by_document_key_).insert(
         DocumentKeyReference{mutation.key, batch_id});
 
     persistence_.indexManager->AddToCollectionParentIndex(
@@ -107,14 +108,32 @@ FSTMutationBatch* MemoryMutationQueue::AddMutationBatch(
   return batch;
 }
 
+FSTMutationBatch* MemoryMutationQueue::ReplaceMutationBatch(
+    FSTMutationBatch* batch, std::vector<FSTMutation*>&& mutations) {
+  HARD_ASSERT(!mutations.empty(), "Mutation batches should not be empty");
+
+  size_t index = IndexOfBatchId(batch.batchID);
+  HARD_ASSERT(index < queue_.size() && queue_[index].batchID == batch.batchID,
+              "Trying to replace nonexistent batch %s", batch.batchID);
+
+  // The documents are unchanged, so the index by document key still holds.
+  std::vector<FSTMutation*> base_mutations = batch.baseMutations;
+  FSTMutationBatch* replacement =
+      [[FSTMutationBatch alloc] initWithBatchID:batch.batchID
+                                 localWriteTime:batch.localWriteTime
+                                  baseMutations:std::move(base_mutations)
+                                      mutations:std::move(mutations)];
+  queue_[index] = replacement;
+  return replacement;
+}
+
 void MemoryMutationQueue::RemoveMutationBatch(FSTMutationBatch* batch) {
-  // Can only remove the first batch
   HARD_ASSERT(!queue_.empty(), "Trying to remove batch from empty queue");
-  FSTMutationBatch* head = queue_.front();
-  HARD_ASSERT(head.batchID == batch.batchID,
-              "Can only remove the first entry of the mutation queue");
+  size_t index = IndexOfBatchId(batch.batchID);
+  HARD_ASSERT(index < queue_.size() && queue_[index].batchID == batch.batchID,
+              "Trying to remove nonexistent batch %s", batch.batchID);
 
-  queue_.erase(queue_.begin());
+  queue_.erase(queue_.begin() + index);
 
   // Remove entries from the index too.
   for (FSTMutation* mutation : [batch mutations]) {
@@ -122,7 +141,8 @@ void MemoryMutationQueue::RemoveMutationBatch(FSTMutationBatch* batch) {
     [persistence_.referenceDelegate removeMutationReference:key];
 
     DocumentKeyReference reference{key, batch.batchID};
-    batches_by_document_key_ = batches_by_document_key_.erase(reference);
+    batches_by_document_key_ =
+        std::move(batches_by_document_key_).erase(reference);
   }
 }
 
@@ -206,12 +226,7 @@ MemoryMutationQueue::AllMutationBatchesAffectingQuery(FSTQuery* query) {
 
 FSTMutationBatch* _Nullable MemoryMutationQueue::NextMutationBatchAfterBatchId(
     BatchId batch_id) {
-  BatchId next_batch_id = batch_id + 1;
-
-  // The requested batchID may still be out of range so normalize it to the
-  // start of the queue.
-  int raw_index = IndexOfBatchId(next_batch_id);
-  int index = raw_index < 0 ? 0 : raw_index;
+  size_t index = IndexOfBatchId(batch_id + 1);
   return queue_.size() > index ? queue_[index] : nil;
 }
 
@@ -221,14 +236,11 @@ FSTMutationBatch* _Nullable MemoryMutationQueue::LookupMutationBatch(
     return nil;
   }
 
-  int index = IndexOfBatchId(batch_id);
-  if (index < 0 || index >= queue_.size()) {
+  size_t index = IndexOfBatchId(batch_id);
+  if (index >= queue_.size() || queue_[index].batchID != batch_id) {
     return nil;
   }
-
-  FSTMutationBatch* batch = queue_[index];
-  HARD_ASSERT(batch.batchID == batch_id, "If found, batch must match");
-  return batch;
+  return queue_[index];
 }
 
 void MemoryMutationQueue::PerformConsistencyCheck() {
@@ -277,18 +289,13 @@ std::vector<FSTMutationBatch*> MemoryMutationQueue::AllMutationBatchesWithIds(
   return result;
 }
 
-int MemoryMutationQueue::IndexOfBatchId(BatchId batch_id) {
-  if (queue_.empty()) {
-    // As an index this is past the end of the queue
-    return 0;
-  }
-
-  // Examine the front of the queue to figure out the difference between the
-  // batchID and indexes in the array. Note that since the queue is ordered by
-  // batchID, if the first batch has a larger batchID then the requested batchID
-  // doesn't exist in the queue.
-  FSTMutationBatch* first_batch = queue_.front();
-  return batch_id - first_batch.batchID;
+size_t MemoryMutationQueue::IndexOfBatchId(BatchId batch_id) {
+  // The queue is ordered by batchID.
+  auto found = std::lower_bound(queue_.begin(), queue_.end(), batch_id,
+                                [](FSTMutationBatch* batch, BatchId id) {
+                                  return batch.batchID < id;
+                                });
+  return static_cast<size_t>(found - queue_.begin());
 }
 
 }  // namespace local
@@ -76,7 +76,18 @@ class MemoryQueryCache : public QueryCache {
   bool Contains(const model::DocumentKey& key) override;
 
   // Other methods and accessors
-  size_t CalculateByteSize(FSTLocalSerializer* serializer);
+  /**
+   * Starts keeping track of the number of bytes used by the cache, estimated
+   * from the size of each target encoded by `serializer`.
+   */
+  void StartTrackingByteSize(FSTLocalSerializer* serializer);
+
+  /**
+   * The number of bytes used by the cache. Requires `StartTrackingByteSize`.
+   */
+  size_t byte_size() const {
+    return byte_size_;
+  }
 
   size_t size() const override {
     return queries_.size();
@@ -95,6 +106,12 @@ class MemoryQueryCache : public QueryCache {
   void SetLastRemoteSnapshotVersion(model::SnapshotVersion version) override;
 
  private:
+  /** Returns the tracked size of the given target, or zero if untracked. */
+  size_t TargetByteSize(FSTQueryData* query_data) const;
+
+  /** Stops counting the target of the given query, if there is one. */
+  void RemoveTargetByteSize(FSTQuery* query);
+
   // This instance is owned by FSTMemoryPersistence; avoid a retain cycle.
   __weak FSTMemoryPersistence* persistence_;
 
@@ -108,6 +125,10 @@ class MemoryQueryCache : public QueryCache {
   /** Maps a query to the data about that query. */
   objc::unordered_map<FSTQuery*, FSTQueryData*> queries_;
 
+  // Nil until byte sizes are tracked.
+  FSTLocalSerializer* _Nullable serializer_ = nil;
+  size_t byte_size_ = 0;
+
   /**
    * A ordered bidirectional mapping between documents and the remote target
    * IDs.
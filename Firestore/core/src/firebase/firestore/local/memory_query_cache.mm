@@ -48,6 +48,8 @@ MemoryQueryCache::MemoryQueryCache(FSTMemoryPersistence* persistence)
 }
 
 void MemoryQueryCache::AddTarget(FSTQueryData* query_data) {
+  RemoveTargetByteSize(query_data.query);
+  byte_size_ += TargetByteSize(query_data);
   queries_[query_data.query] = query_data;
   if (query_data.targetID > highest_target_id_) {
     highest_target_id_ = query_data.targetID;
@@ -63,6 +65,7 @@ void MemoryQueryCache::UpdateTarget(FSTQueryData* query_data) {
 }
 
 void MemoryQueryCache::RemoveTarget(FSTQueryData* query_data) {
+  RemoveTargetByteSize(query_data.query);
   queries_.erase(query_data.query);
   references_.RemoveReferences(query_data.targetID);
 }
@@ -95,6 +98,7 @@ int MemoryQueryCache::RemoveTargets(
   }
 
   for (FSTQuery* element : to_remove) {
+    RemoveTargetByteSize(element);
     queries_.erase(element);
   }
   return static_cast<int>(to_remove.size());
@@ -124,13 +128,26 @@ bool MemoryQueryCache::Contains(const DocumentKey& key) {
   return references_.ContainsKey(key);
 }
 
-size_t MemoryQueryCache::CalculateByteSize(FSTLocalSerializer* serializer) {
-  size_t count = 0;
+void MemoryQueryCache::StartTrackingByteSize(FSTLocalSerializer* serializer) {
+  serializer_ = serializer;
+  byte_size_ = 0;
   for (const auto& kv : queries_) {
-    FSTQueryData* query_data = kv.second;
-    count += [[serializer encodedQueryData:query_data] serializedSize];
+    byte_size_ += TargetByteSize(kv.second);
+  }
+}
+
+size_t MemoryQueryCache::TargetByteSize(FSTQueryData* query_data) const {
+  if (!serializer_) {
+    return 0;
+  }
+  return [[serializer_ encodedQueryData:query_data] serializedSize];
+}
+
+void MemoryQueryCache::RemoveTargetByteSize(FSTQuery* query) {
+  auto found = queries_.find(query);
+  if (found != queries_.end()) {
+    byte_size_ -= TargetByteSize(found->second);
   }
-  return count;
 }
 
 const SnapshotVersion& MemoryQueryCache::GetLastRemoteSnapshotVersion() const {
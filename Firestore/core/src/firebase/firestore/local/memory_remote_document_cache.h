@@ -21,13 +21,18 @@
 #error "For now, this file must only be included by ObjC source files."
 #endif  // !defined(__OBJC__)
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/core/document_sizer.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/strings/string_view.h"
 
 @class FSTLocalSerializer;
 @class FSTMaybeDocument;
@@ -45,23 +50,87 @@ class MemoryRemoteDocumentCache : public RemoteDocumentCache {
  public:
   explicit MemoryRemoteDocumentCache(FSTMemoryPersistence* persistence);
 
-  void Add(FSTMaybeDocument* document) override;
+  void Add(FSTMaybeDocument* document,
+           const model::SnapshotVersion& read_time) override;
   void Remove(const model::DocumentKey& key) override;
 
   FSTMaybeDocument* _Nullable Get(const model::DocumentKey& key) override;
   model::MaybeDocumentMap GetAll(const model::DocumentKeySet& keys) override;
-  model::DocumentMap GetMatching(FSTQuery* query) override;
-
+  model::DocumentMap GetMatching(
+      FSTQuery* query, QueryExecutionStats* _Nullable stats) override;
+  model::DocumentMap GetFirstMatching(
+      FSTQuery* query,
+      size_t count,
+      QueryExecutionStats* _Nullable stats) override;
+  model::DocumentMap GetMatching(
+      FSTQuery* query,
+      const model::SnapshotVersion& since_read_time,
+      QueryExecutionStats* _Nullable stats) override;
+  model::DocumentMap GetAllInCollectionGroup(
+      const std::string& collection_id,
+      QueryExecutionStats* _Nullable stats) override;
+
+  /**
+   * Removes documents that are not pinned at the given sequence number,
+   * stopping after `limit` documents if `limit` is positive. Returns the keys
+   * of the removed documents.
+   */
   std::vector<model::DocumentKey> RemoveOrphanedDocuments(
       FSTMemoryLRUReferenceDelegate* reference_delegate,
-      model::ListenSequenceNumber upper_bound);
-
-  size_t CalculateByteSize(FSTLocalSerializer* serializer);
+      model::ListenSequenceNumber upper_bound,
+      int limit);
+
+  /**
+   * Starts keeping track of the number of bytes used by the cache, estimated
+   * from the size of each entry encoded by `serializer`. Until then, entries
+   * are not encoded when they change, since only LRU garbage collection needs
+   * their size.
+   */
+  void StartTrackingByteSize(FSTLocalSerializer* serializer);
+
+  /**
+   * The number of bytes used by the cache. Requires `StartTrackingByteSize`.
+   */
+  size_t byte_size() const {
+    return byte_size_;
+  }
+
+  /**
+   * Like `byte_size`, but only counts the documents of collections with the
+   * given collection ID.
+   */
+  size_t GetCollectionGroupByteSize(absl::string_view collection_id) const;
+
+  /**
+   * Estimates the number of bytes used by the cache, with `sizer` unless the
+   * byte size is already tracked (see `StartTrackingByteSize`).
+   */
+  size_t EstimateByteSize(const core::DocumentSizer& sizer) const;
 
  private:
+  /**
+   * Adds the size of the given entry to the byte sizes of the cache and of the
+   * entry's collection group, if they are tracked.
+   */
+  void AddEntryByteSize(FSTMaybeDocument* document);
+
+  /** Undoes `AddEntryByteSize` for an entry removed from the cache. */
+  void RemoveEntryByteSize(FSTMaybeDocument* document);
+
   /** Underlying cache of documents. */
   model::MaybeDocumentMap docs_;
 
+  /** The read time of each entry in `docs_`. */
+  std::unordered_map<model::DocumentKey,
+                     model::SnapshotVersion,
+                     model::DocumentKeyHash>
+      read_times_;
+
+  // Nil until byte sizes are tracked.
+  FSTLocalSerializer* _Nullable serializer_ = nil;
+  size_t byte_size_ = 0;
+  std::unordered_map<std::string, size_t> collection_group_byte_sizes_;
+
   // This instance is owned by FSTMemoryPersistence; avoid a retain cycle.
   __weak FSTMemoryPersistence* persistence_;
 };
@@ -16,36 +16,46 @@
 
 #include "Firestore/core/src/firebase/firestore/local/memory_remote_document_cache.h"
 
+#include <string>
+#include <utility>
+
 #import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTMemoryPersistence.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 
+#include "Firestore/core/src/firebase/firestore/core/memory_stats.h"
+#include "Firestore/core/src/firebase/firestore/local/top_documents.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 
+using firebase::firestore::core::DocumentKeyByteSize;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::MaybeDocumentMap;
+using firebase::firestore::model::ResourcePath;
+using firebase::firestore::model::SnapshotVersion;
 
 namespace firebase {
 namespace firestore {
 namespace local {
 
 namespace {
-/**
- * Returns an estimate of the number of bytes used to store the given
- * document key in memory. This is only an estimate and includes the size
- * of the segments of the path, but not any object overhead or path separators.
- */
-size_t DocumentKeyByteSize(const DocumentKey& key) {
-  size_t count = 0;
-  for (const auto& segment : key.path()) {
-    count += segment.size();
-  }
-  return count;
+
+/** Returns an estimate of the number of bytes used by a cache entry. */
+size_t EntryByteSize(FSTLocalSerializer* serializer,
+                     FSTMaybeDocument* document) {
+  return DocumentKeyByteSize(document.key) +
+         [[serializer encodedMaybeDocument:document] serializedSize];
+}
+
+/** Returns the ID of the collection the given document belongs to. */
+const std::string& CollectionGroup(const DocumentKey& key) {
+  const ResourcePath& path = key.path();
+  return path[path.size() - 2];
 }
+
 }  // namespace
 
 MemoryRemoteDocumentCache::MemoryRemoteDocumentCache(
@@ -53,15 +63,27 @@ MemoryRemoteDocumentCache::MemoryRemoteDocumentCache(
   persistence_ = persistence;
 }
 
-void MemoryRemoteDocumentCache::Add(FSTMaybeDocument* document) {
-  docs_ = docs_.insert(document.key, document);
+void MemoryRemoteDocumentCache::Add(FSTMaybeDocument* document,
+                                    const SnapshotVersion& read_time) {
+  FSTMaybeDocument* existing = Get(document.key);
+  if (existing) {
+    RemoveEntryByteSize(existing);
+  }
+  AddEntryByteSize(document);
+  docs_ = std::move(docs_).insert(document.key, document);
+  read_times_[document.key] = read_time;
 
   persistence_.indexManager->AddToCollectionParentIndex(
       document.key.path().PopLast());
 }
 
 void MemoryRemoteDocumentCache::Remove(const DocumentKey& key) {
-  docs_ = docs_.erase(key);
+  FSTMaybeDocument* existing = Get(key);
+  if (existing) {
+    RemoveEntryByteSize(existing);
+    docs_ = std::move(docs_).erase(key);
+    read_times_.erase(key);
+  }
 }
 
 FSTMaybeDocument* _Nullable MemoryRemoteDocumentCache::Get(
@@ -76,12 +98,13 @@ MaybeDocumentMap MemoryRemoteDocumentCache::GetAll(const DocumentKeySet& keys) {
     // Make sure each key has a corresponding entry, which is null in case the
     // document is not found.
     // TODO(http://b/32275378): Don't conflate missing / deleted.
-    results = results.insert(key, Get(key));
+    results = std::move(results).insert(key, Get(key));
   }
   return results;
 }
 
-DocumentMap MemoryRemoteDocumentCache::GetMatching(FSTQuery* query) {
+DocumentMap MemoryRemoteDocumentCache::GetMatching(
+    FSTQuery* query, QueryExecutionStats* _Nullable stats) {
   HARD_ASSERT(
       ![query isCollectionGroupQuery],
       "CollectionGroup queries should be handled in LocalDocumentsView");
@@ -91,33 +114,147 @@ DocumentMap MemoryRemoteDocumentCache::GetMatching(FSTQuery* query) {
   // Documents are ordered by key, so we can use a prefix scan to narrow down
   // the documents we need to match the query against.
   DocumentKey prefix{query.path.Append("")};
+  int64_t scanned = 0;
+  for (auto it = docs_.lower_bound(prefix); it != docs_.end(); ++it) {
+    const DocumentKey& key = it->first;
+    if (!query.path.IsPrefixOf(key.path())) {
+      break;
+    }
+    ++scanned;
+    FSTMaybeDocument* maybeDoc = it->second;
+    if (![maybeDoc isKindOfClass:[FSTDocument class]]) {
+      continue;
+    }
+    FSTDocument* doc = static_cast<FSTDocument*>(maybeDoc);
+    if ([query matchesDocument:doc]) {
+      results = std::move(results).insert(key, doc);
+    }
+  }
+
+  // Documents are kept in memory, so none has to be decoded.
+  if (stats) {
+    stats->access_path = QueryAccessPath::CollectionScan;
+    stats->documents_scanned += scanned;
+  }
+  return results;
+}
+
+DocumentMap MemoryRemoteDocumentCache::GetFirstMatching(
+    FSTQuery* query, size_t count, QueryExecutionStats* _Nullable stats) {
+  HARD_ASSERT(
+      ![query isCollectionGroupQuery],
+      "CollectionGroup queries should be handled in LocalDocumentsView");
+
+  TopDocuments top{query, count};
+  DocumentKey prefix{query.path.Append("")};
+  int64_t scanned = 0;
+  for (auto it = docs_.lower_bound(prefix); it != docs_.end(); ++it) {
+    if (!query.path.IsPrefixOf(it->first.path())) {
+      break;
+    }
+    ++scanned;
+    FSTMaybeDocument* maybeDoc = it->second;
+    if ([maybeDoc isKindOfClass:[FSTDocument class]]) {
+      top.Add(static_cast<FSTDocument*>(maybeDoc));
+    }
+  }
+
+  if (stats) {
+    stats->access_path = QueryAccessPath::CollectionScan;
+    stats->documents_scanned += scanned;
+  }
+  return top.ToDocumentMap();
+}
+
+DocumentMap MemoryRemoteDocumentCache::GetMatching(
+    FSTQuery* query,
+    const SnapshotVersion& since_read_time,
+    QueryExecutionStats* _Nullable stats) {
+  HARD_ASSERT(
+      ![query isCollectionGroupQuery],
+      "CollectionGroup queries should be handled in LocalDocumentsView");
+
+  // Memory scans are cheap enough that the read times need no index of their
+  // own; only the matching is skipped for older entries.
+  DocumentMap results;
+  DocumentKey prefix{query.path.Append("")};
+  int64_t scanned = 0;
   for (auto it = docs_.lower_bound(prefix); it != docs_.end(); ++it) {
     const DocumentKey& key = it->first;
     if (!query.path.IsPrefixOf(key.path())) {
       break;
     }
+    ++scanned;
     FSTMaybeDocument* maybeDoc = it->second;
     if (![maybeDoc isKindOfClass:[FSTDocument class]]) {
       continue;
     }
+    auto read_time = read_times_.find(key);
+    if (read_time != read_times_.end() &&
+        read_time->second <= since_read_time) {
+      continue;
+    }
     FSTDocument* doc = static_cast<FSTDocument*>(maybeDoc);
     if ([query matchesDocument:doc]) {
-      results = results.insert(key, doc);
+      results = std::move(results).insert(key, doc);
     }
   }
+
+  if (stats) {
+    stats->documents_scanned += scanned;
+  }
+  return results;
+}
+
+DocumentMap MemoryRemoteDocumentCache::GetAllInCollectionGroup(
+    const std::string& collection_id, QueryExecutionStats* _Nullable stats) {
+  DocumentMap results;
+  int64_t scanned = 0;
+
+  // Seeking to each collection of the group is cheap in memory, so there's no
+  // need for a separate index.
+  for (const ResourcePath& parent :
+       persistence_.indexManager->GetCollectionParents(collection_id)) {
+    ResourcePath collection_path = parent.Append(collection_id);
+    DocumentKey prefix{collection_path.Append("")};
+    for (auto it = docs_.lower_bound(prefix); it != docs_.end(); ++it) {
+      const DocumentKey& key = it->first;
+      if (!collection_path.IsPrefixOf(key.path())) {
+        break;
+      }
+      ++scanned;
+      FSTMaybeDocument* maybe_doc = it->second;
+      if (collection_path.IsImmediateParentOf(key.path()) &&
+          [maybe_doc isKindOfClass:[FSTDocument class]]) {
+        results = std::move(results).insert(
+            key, static_cast<FSTDocument*>(maybe_doc));
+      }
+    }
+  }
+
+  if (stats) {
+    stats->access_path = QueryAccessPath::CollectionGroupScan;
+    stats->documents_scanned += scanned;
+  }
   return results;
 }
 
 std::vector<DocumentKey> MemoryRemoteDocumentCache::RemoveOrphanedDocuments(
     FSTMemoryLRUReferenceDelegate* reference_delegate,
-    ListenSequenceNumber upper_bound) {
+    ListenSequenceNumber upper_bound,
+    int limit) {
   std::vector<DocumentKey> removed;
   MaybeDocumentMap updated_docs = docs_;
   for (const auto& kv : docs_) {
+    if (limit > 0 && removed.size() >= static_cast<size_t>(limit)) {
+      break;
+    }
     const DocumentKey& key = kv.first;
     if (![reference_delegate isPinnedAtSequenceNumber:upper_bound
                                              document:key]) {
-      updated_docs = updated_docs.erase(key);
+      updated_docs = std::move(updated_docs).erase(key);
+      read_times_.erase(key);
+      RemoveEntryByteSize(kv.second);
       removed.push_back(key);
     }
   }
@@ -125,14 +262,62 @@ std::vector<DocumentKey> MemoryRemoteDocumentCache::RemoveOrphanedDocuments(
   return removed;
 }
 
-size_t MemoryRemoteDocumentCache::CalculateByteSize(
+void MemoryRemoteDocumentCache::StartTrackingByteSize(
     FSTLocalSerializer* serializer) {
-  size_t count = 0;
+  serializer_ = serializer;
+  byte_size_ = 0;
+  collection_group_byte_sizes_.clear();
+  for (const auto& kv : docs_) {
+    AddEntryByteSize(kv.second);
+  }
+}
+
+size_t MemoryRemoteDocumentCache::GetCollectionGroupByteSize(
+    absl::string_view collection_id) const {
+  auto found = collection_group_byte_sizes_.find(std::string{collection_id});
+  return found != collection_group_byte_sizes_.end() ? found->second : 0;
+}
+
+size_t MemoryRemoteDocumentCache::EstimateByteSize(
+    const core::DocumentSizer& sizer) const {
+  if (serializer_) {
+    return byte_size_;
+  }
+
+  size_t size = 0;
   for (const auto& kv : docs_) {
-    count += DocumentKeyByteSize(kv.first);
-    count += [[serializer encodedMaybeDocument:kv.second] serializedSize];
+    size += sizer(kv.second);
+  }
+  return size;
+}
+
+void MemoryRemoteDocumentCache::AddEntryByteSize(FSTMaybeDocument* document) {
+  if (!serializer_) {
+    return;
+  }
+
+  size_t size = EntryByteSize(serializer_, document);
+  byte_size_ += size;
+  collection_group_byte_sizes_[CollectionGroup(document.key)] += size;
+}
+
+void MemoryRemoteDocumentCache::RemoveEntryByteSize(
+    FSTMaybeDocument* document) {
+  if (!serializer_) {
+    return;
+  }
+
+  size_t size = EntryByteSize(serializer_, document);
+  byte_size_ -= size;
+  auto found = collection_group_byte_sizes_.find(CollectionGroup(document.key));
+  HARD_ASSERT(found != collection_group_byte_sizes_.end() &&
+                  found->second >= size,
+              "Removed more bytes than were added for %s",
+              document.key.ToString());
+  found->second -= size;
+  if (found->second == 0) {
+    collection_group_byte_sizes_.erase(found);
   }
-  return count;
 }
 
 }  // namespace local
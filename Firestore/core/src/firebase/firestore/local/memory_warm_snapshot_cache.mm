@@ -0,0 +1,74 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/local/memory_warm_snapshot_cache.h"
+
+#include <algorithm>
+#include <utility>
+
+#import "Firestore/Source/Model/FSTDocument.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::DocumentMap;
+using model::DocumentSet;
+using model::TargetId;
+
+void MemoryWarmSnapshotCache::Save(TargetId target_id,
+                                   const DocumentSet& documents,
+                                   size_t max_targets) {
+  target_ids_.erase(
+      std::remove(target_ids_.begin(), target_ids_.end(), target_id),
+      target_ids_.end());
+  target_ids_.insert(target_ids_.begin(), target_id);
+  while (target_ids_.size() > max_targets) {
+    snapshots_.erase(target_ids_.back());
+    target_ids_.pop_back();
+  }
+  if (target_ids_.empty()) {
+    return;
+  }
+
+  DocumentMap snapshot;
+  for (FSTDocument* document : documents) {
+    snapshot = std::move(snapshot).insert(document.key, document);
+  }
+  snapshots_[target_id] = std::move(snapshot);
+}
+
+absl::optional<DocumentMap> MemoryWarmSnapshotCache::Get(TargetId target_id) {
+  auto found = snapshots_.find(target_id);
+  if (found == snapshots_.end()) {
+    return absl::nullopt;
+  }
+  return found->second;
+}
+
+void MemoryWarmSnapshotCache::RemoveAll() {
+  snapshots_.clear();
+  target_ids_.clear();
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
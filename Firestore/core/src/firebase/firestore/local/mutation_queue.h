@@ -73,12 +73,24 @@ class MutationQueue {
       std::vector<FSTMutation*>&& base_mutations,
       std::vector<FSTMutation*>&& mutations) = 0;
 
+  /**
+   * Replaces the user-provided mutations of the given batch, keeping its batch
+   * ID, local write time and base mutations. Only batches that haven't been
+   * sent to the backend may be replaced, and the new mutations must affect the
+   * same documents as the old ones.
+   *
+   * @return The batch with the new mutations.
+   */
+  virtual FSTMutationBatch* ReplaceMutationBatch(
+      FSTMutationBatch* batch, std::vector<FSTMutation*>&& mutations) = 0;
+
   /**
    * Removes the given mutation batch from the queue. This is useful in two
    * circumstances:
    *
    * + Removing applied mutations from the head of the queue
    * + Removing rejected mutations from anywhere in the queue
+   * + Removing unsent mutations made redundant by later writes
    */
   virtual void RemoveMutationBatch(FSTMutationBatch* batch) = 0;
 
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_PROJECTED_DOCUMENT_CACHE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_PROJECTED_DOCUMENT_CACHE_H_
+
+#if !defined(__OBJC__)
+#error "For now, this file must only be included by ObjC source files."
+#endif  // !defined(__OBJC__)
+
+#include <unordered_map>
+
+#include "Firestore/core/src/firebase/firestore/core/document_sizer.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
+
+@class FSTQuery;
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Holds the partial documents of targets whose queries select only some fields
+ * of each document.
+ *
+ * A partial document is only meaningful for the target it was received for,
+ * so unlike the `RemoteDocumentCache`, documents are kept per target and are
+ * never shared with other queries. The documents of a target are dropped when
+ * the target is released; they are kept in memory only, since a projection
+ * query is cheap to re-run compared to fetching whole documents.
+ */
+class ProjectedDocumentCache {
+ public:
+  /**
+   * Applies the partial documents received for the given target. Documents
+   * that don't exist anymore are removed from the target.
+   */
+  void Apply(model::TargetId target_id,
+             const remote::RemoteEvent::DocumentUpdateMap& updates);
+
+  /** Removes the documents with the given keys from the given target. */
+  void Remove(model::TargetId target_id, const model::DocumentKeySet& keys);
+
+  /** Drops all documents of the given target. */
+  void RemoveTarget(model::TargetId target_id);
+
+  /** Returns the keys of the documents in the given target. */
+  model::DocumentKeySet GetKeys(model::TargetId target_id) const;
+
+  /**
+   * Returns the documents in the given target that match `query`, which is
+   * expected to be the query of the target.
+   */
+  model::DocumentMap GetMatching(model::TargetId target_id,
+                                 FSTQuery* query) const;
+
+  /** Estimates the number of bytes used by the cache with `sizer`. */
+  size_t EstimateByteSize(const core::DocumentSizer& sizer) const;
+
+ private:
+  std::unordered_map<model::TargetId, model::DocumentMap> documents_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_PROJECTED_DOCUMENT_CACHE_H_
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/projected_document_cache.h"
+
+#include <utility>
+
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::DocumentKey;
+using model::DocumentKeySet;
+using model::DocumentMap;
+using model::TargetId;
+
+void ProjectedDocumentCache::Apply(
+    TargetId target_id, const remote::RemoteEvent::DocumentUpdateMap& updates) {
+  DocumentMap& documents = documents_[target_id];
+  for (const auto& kv : updates) {
+    FSTMaybeDocument* maybe_doc = kv.second;
+    if ([maybe_doc isKindOfClass:[FSTDocument class]]) {
+      documents = std::move(documents).insert(
+          kv.first, static_cast<FSTDocument*>(maybe_doc));
+    } else {
+      documents = std::move(documents).erase(kv.first);
+    }
+  }
+}
+
+void ProjectedDocumentCache::Remove(TargetId target_id,
+                                    const DocumentKeySet& keys) {
+  auto found = documents_.find(target_id);
+  if (found == documents_.end()) {
+    return;
+  }
+  for (const DocumentKey& key : keys) {
+    found->second = std::move(found->second).erase(key);
+  }
+}
+
+void ProjectedDocumentCache::RemoveTarget(TargetId target_id) {
+  documents_.erase(target_id);
+}
+
+DocumentKeySet ProjectedDocumentCache::GetKeys(TargetId target_id) const {
+  DocumentKeySet keys;
+  auto found = documents_.find(target_id);
+  if (found != documents_.end()) {
+    for (const auto& kv : found->second.underlying_map()) {
+      keys = keys.insert(kv.first);
+    }
+  }
+  return keys;
+}
+
+DocumentMap ProjectedDocumentCache::GetMatching(TargetId target_id,
+                                                FSTQuery* query) const {
+  DocumentMap results;
+  auto found = documents_.find(target_id);
+  if (found == documents_.end()) {
+    return results;
+  }
+  for (const auto& kv : found->second.underlying_map()) {
+    FSTDocument* doc = static_cast<FSTDocument*>(kv.second);
+    if ([query matchesDocument:doc]) {
+      results = std::move(results).insert(kv.first, doc);
+    }
+  }
+  return results;
+}
+
+size_t ProjectedDocumentCache::EstimateByteSize(
+    const core::DocumentSizer& sizer) const {
+  size_t size = 0;
+  for (const auto& target : documents_) {
+    for (const auto& kv : target.second.underlying_map()) {
+      size += sizer(kv.second);
+    }
+  }
+  return size;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
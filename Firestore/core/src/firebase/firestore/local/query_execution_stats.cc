@@ -0,0 +1,60 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/query_execution_stats.h"
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+const char* ToString(QueryAccessPath access_path) {
+  switch (access_path) {
+    case QueryAccessPath::None:
+      return "none";
+    case QueryAccessPath::DocumentLookup:
+      return "document_lookup";
+    case QueryAccessPath::CollectionScan:
+      return "collection_scan";
+    case QueryAccessPath::FieldIndex:
+      return "field_index";
+    case QueryAccessPath::CollectionGroupScan:
+      return "collection_group_scan";
+    case QueryAccessPath::CollectionQueryPerParent:
+      return "collection_query_per_parent";
+    case QueryAccessPath::TargetKeys:
+      return "target_keys";
+  }
+  UNREACHABLE();
+}
+
+std::string QueryExecutionStats::ToString() const {
+  return util::StringFormat(
+      "QueryExecutionStats(access_path=%s, documents_scanned=%s, "
+      "documents_decoded=%s, mutation_batches_read=%s, "
+      "documents_overlaid=%s, overlays_reused=%s, documents_returned=%s, "
+      "remote_documents_time=%sus, mutations_time=%sus, total_time=%sus)",
+      local::ToString(access_path), documents_scanned, documents_decoded,
+      mutation_batches_read, documents_overlaid, overlays_reused,
+      documents_returned, remote_documents_time.count(), mutations_time.count(),
+      total_time.count());
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_QUERY_EXECUTION_STATS_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_QUERY_EXECUTION_STATS_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <string>
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/** How the local store found the candidate documents of a query. */
+enum class QueryAccessPath {
+  /** No documents have been read. */
+  None,
+
+  /** The query names a single document, which was looked up by its key. */
+  DocumentLookup,
+
+  /** Every document of the queried collection was read. */
+  CollectionScan,
+
+  /** The candidate documents were found through the field index. */
+  FieldIndex,
+
+  /**
+   * Every document of the queried collection group was read in a single
+   * scan.
+   */
+  CollectionGroupScan,
+
+  /** A collection group query ran one collection query per parent. */
+  CollectionQueryPerParent,
+
+  /**
+   * The documents of the query's target were looked up by key, and only the
+   * documents updated since the target's last consistent snapshot were
+   * matched against the query.
+   */
+  TargetKeys,
+};
+
+/** Returns a human readable name of the given access path. */
+const char* ToString(QueryAccessPath access_path);
+
+/**
+ * Describes how a query was executed against the local store, in the manner of
+ * a database's EXPLAIN output.
+ *
+ * The remote document cache, the mutation queue and the LocalDocumentsView each
+ * add the work they did while executing the query.
+ */
+struct QueryExecutionStats {
+  /**
+   * The strategy used to find candidate documents. For a collection group
+   * query run per parent, the strategies of the collection queries are not
+   * reported.
+   */
+  QueryAccessPath access_path = QueryAccessPath::None;
+
+  /**
+   * The number of rows of the remote document cache (or of an index on it)
+   * that were examined.
+   */
+  int64_t documents_scanned = 0;
+
+  /** The number of remote documents that were deserialized. */
+  int64_t documents_decoded = 0;
+
+  /** The number of mutation batches read from the mutation queue. */
+  int64_t mutation_batches_read = 0;
+
+  /** The number of documents whose mutation batches were replayed. */
+  int64_t documents_overlaid = 0;
+
+  /** The number of documents whose cached local view was reused. */
+  int64_t overlays_reused = 0;
+
+  /** The number of documents that matched the query. */
+  int64_t documents_returned = 0;
+
+  /** The time spent reading the remote document cache. */
+  std::chrono::microseconds remote_documents_time{0};
+
+  /**
+   * The time spent reading the mutation queue and applying mutations to the
+   * remote documents.
+   */
+  std::chrono::microseconds mutations_time{0};
+
+  /** The time spent executing the query overall. */
+  std::chrono::microseconds total_time{0};
+
+  std::string ToString() const;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_QUERY_EXECUTION_STATS_H_
@@ -16,8 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 
-#include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
-#include "Firestore/core/src/firebase/firestore/local/document_key_reference.h"
+#include <utility>
+
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 
 namespace firebase {
@@ -28,19 +28,44 @@ using model::DocumentKey;
 using model::DocumentKeySet;
 
 void ReferenceSet::AddReference(const DocumentKey& key, int id) {
-  DocumentKeyReference reference{key, id};
-  by_key_ = by_key_.insert(reference);
-  by_id_ = by_id_.insert(reference);
+  DocumentKeySet& keys = by_id_[id];
+  if (keys.contains(key)) {
+    return;
+  }
+  keys = std::move(keys).insert(key);
+  ++counts_by_key_[key];
+  ++size_;
 }
 
 void ReferenceSet::AddReferences(const DocumentKeySet& keys, int id) {
+  DocumentKeySet& existing = by_id_[id];
+  if (!existing.empty()) {
+    for (const DocumentKey& key : keys) {
+      AddReference(key, id);
+    }
+    return;
+  }
+
+  // The common case of an Id referencing its documents all at once: share the
+  // given set instead of building a new one.
+  existing = keys;
   for (const DocumentKey& key : keys) {
-    AddReference(key, id);
+    ++counts_by_key_[key];
   }
+  size_ += keys.size();
 }
 
 void ReferenceSet::RemoveReference(const DocumentKey& key, int id) {
-  RemoveReference(DocumentKeyReference{key, id});
+  auto found = by_id_.find(id);
+  if (found == by_id_.end() || !found->second.contains(key)) {
+    return;
+  }
+
+  found->second = std::move(found->second).erase(key);
+  if (found->second.empty()) {
+    by_id_.erase(found);
+  }
+  ReleaseKey(key);
 }
 
 void ReferenceSet::RemoveReferences(
@@ -51,50 +76,40 @@ void ReferenceSet::RemoveReferences(
 }
 
 DocumentKeySet ReferenceSet::RemoveReferences(int id) {
-  DocumentKeyReference start{DocumentKey::Empty(), id};
-  DocumentKeyReference end{DocumentKey::Empty(), id + 1};
-
-  DocumentKeySet removed{};
+  auto found = by_id_.find(id);
+  if (found == by_id_.end()) {
+    return DocumentKeySet{};
+  }
 
-  auto initial = by_id_;
-  for (const auto& reference : initial.values_in(start, end)) {
-    RemoveReference(reference);
-    removed = removed.insert(reference.key());
+  DocumentKeySet removed = std::move(found->second);
+  by_id_.erase(found);
+  for (const DocumentKey& key : removed) {
+    ReleaseKey(key);
   }
   return removed;
 }
 
 void ReferenceSet::RemoveAllReferences() {
-  auto initial = by_key_;
-  for (const DocumentKeyReference& reference : initial) {
-    RemoveReference(reference);
-  }
+  by_id_.clear();
+  counts_by_key_.clear();
+  size_ = 0;
 }
 
-void ReferenceSet::RemoveReference(const DocumentKeyReference& reference) {
-  by_key_ = by_key_.erase(reference);
-  by_id_ = by_id_.erase(reference);
+void ReferenceSet::ReleaseKey(const DocumentKey& key) {
+  auto found = counts_by_key_.find(key);
+  if (--found->second == 0) {
+    counts_by_key_.erase(found);
+  }
+  --size_;
 }
 
 DocumentKeySet ReferenceSet::ReferencedKeys(int id) {
-  DocumentKeyReference start{DocumentKey::Empty(), id};
-  DocumentKeyReference end{DocumentKey::Empty(), id + 1};
-
-  DocumentKeySet keys;
-  for (const auto& reference : by_id_.values_in(start, end)) {
-    keys = keys.insert(reference.key());
-  }
-  return keys;
+  auto found = by_id_.find(id);
+  return found != by_id_.end() ? found->second : DocumentKeySet{};
 }
 
 bool ReferenceSet::ContainsKey(const DocumentKey& key) {
-  // Create a reference with a zero ID as the start position to find any
-  // document reference with this key.
-  DocumentKeyReference start{key, 0};
-
-  auto range = by_key_.values_from(start);
-  auto begin = range.begin();
-  return begin != range.end() && begin->key() == key;
+  return counts_by_key_.find(key) != counts_by_key_.end();
 }
 
 }  // namespace local
@@ -17,8 +17,9 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_REFERENCE_SET_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_REFERENCE_SET_H_
 
-#include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
-#include "Firestore/core/src/firebase/firestore/local/document_key_reference.h"
+#include <cstddef>
+#include <unordered_map>
+
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 
@@ -31,25 +32,21 @@ namespace local {
  * (either a TargetId or BatchId). As references are added to or removed from
  * the set corresponding events are emitted to a registered garbage collector.
  *
- * Each reference is represented by a DocumentKeyReference object. Each of them
- * contains enough information to uniquely identify the reference. They are all
- * stored primarily in a set sorted by key. A document is considered garbage if
- * there's no references in that set (this can be efficiently checked thanks to
- * sorting by key).
- *
- * ReferenceSet also keeps a secondary set that contains references sorted by
- * Id. This one is used to efficiently implement removal of all references by
- * some TargetId.
+ * The references are stored as the set of referenced keys of each Id, which
+ * makes adding and removing all the references of an Id at once cheap: the
+ * key set is shared rather than copied reference by reference. Alongside, a
+ * count of the references to each key makes checking whether a document is
+ * garbage (has no references at all) a hash lookup.
  */
 class ReferenceSet {
  public:
   /** Returns true if the reference set contains no references. */
   bool empty() const {
-    return by_key_.empty();
+    return size_ == 0;
   }
 
   size_t size() const {
-    return by_key_.size();
+    return size_;
   }
 
   /** Adds a reference to the given document key for the given Id. */
@@ -81,11 +78,15 @@ class ReferenceSet {
   bool ContainsKey(const model::DocumentKey& key);
 
  private:
-  void RemoveReference(const DocumentKeyReference& reference);
+  /** Drops one reference from the count of references to `key`. */
+  void ReleaseKey(const model::DocumentKey& key);
+
+  std::unordered_map<int, model::DocumentKeySet> by_id_;
+  std::unordered_map<model::DocumentKey, int, model::DocumentKeyHash>
+      counts_by_key_;
 
-  immutable::SortedSet<DocumentKeyReference, DocumentKeyReference::ByKey>
-      by_key_;
-  immutable::SortedSet<DocumentKeyReference, DocumentKeyReference::ById> by_id_;
+  // The total number of references.
+  size_t size_ = 0;
 };
 
 }  // namespace local
@@ -23,9 +23,13 @@
 
 #import <Foundation/Foundation.h>
 
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/local/query_execution_stats.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 
 @class FSTMaybeDocument;
@@ -57,8 +61,12 @@ class RemoteDocumentCache {
    * entry for the key, it will be replaced.
    *
    * @param document A FSTDocument or FSTDeletedDocument to put in the cache.
+   * @param read_time The snapshot version at which the document was read from
+   *     the backend, which orders the entries for `GetMatching` scans of the
+   *     documents read since a given time.
    */
-  virtual void Add(FSTMaybeDocument* document) = 0;
+  virtual void Add(FSTMaybeDocument* document,
+                   const model::SnapshotVersion& read_time) = 0;
 
   /** Removes the cached entry for the given key (no-op if no entry exists). */
   virtual void Remove(const model::DocumentKey& key) = 0;
@@ -90,9 +98,47 @@ class RemoteDocumentCache {
    * Cached FSTDeletedDocument entries have no bearing on query results.
    *
    * @param query The query to match documents against.
+   * @param stats If not null, receives the access path used and the documents
+   *     scanned and decoded.
    * @return The set of matching documents.
    */
-  virtual model::DocumentMap GetMatching(FSTQuery* query) = 0;
+  virtual model::DocumentMap GetMatching(
+      FSTQuery* query, QueryExecutionStats* _Nullable stats) = 0;
+
+  /**
+   * Like `GetMatching`, but only returns the first `count` matching
+   * documents in the query's sort order. The other documents are dropped as
+   * the collection is scanned, so that a limit query doesn't hold on to every
+   * document of a large collection.
+   *
+   * Unlike `GetMatching`, all returned documents match the query.
+   */
+  virtual model::DocumentMap GetFirstMatching(
+      FSTQuery* query, size_t count, QueryExecutionStats* _Nullable stats) = 0;
+
+  /**
+   * Like `GetMatching`, but only returns the documents that were added to the
+   * cache after `since_read_time`, so that the documents that changed since a
+   * query was last known to be in sync can be found without reading the rest
+   * of the collection.
+   *
+   * @param stats If not null, receives the rows scanned and the documents
+   *     decoded. The access path is left to the caller.
+   */
+  virtual model::DocumentMap GetMatching(
+      FSTQuery* query,
+      const model::SnapshotVersion& since_read_time,
+      QueryExecutionStats* _Nullable stats) = 0;
+
+  /**
+   * Returns all cached FSTDocument entries in collections with the given
+   * collection ID, whatever their parents.
+   *
+   * @param stats If not null, receives the documents scanned and decoded.
+   */
+  virtual model::DocumentMap GetAllInCollectionGroup(
+      const std::string& collection_id,
+      QueryExecutionStats* _Nullable stats) = 0;
 };
 
 }  // namespace local
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_TOP_DOCUMENTS_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_TOP_DOCUMENTS_H_
+
+#if !defined(__OBJC__)
+#error "For now, this file must only be included by ObjC source files."
+#endif  // !defined(__OBJC__)
+
+#include <cstddef>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/document_set.h"
+
+@class FSTDocument;
+@class FSTQuery;
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Keeps the first `capacity` documents matching a query, in the query's sort
+ * order, out of all the documents it is given.
+ *
+ * This lets a limit query be evaluated while scanning a collection without
+ * holding on to every matching document: the documents kept form a max-heap
+ * by the query's comparator, so the worst of them can be replaced in
+ * logarithmic time whenever a better document comes along.
+ */
+class TopDocuments {
+ public:
+  TopDocuments(FSTQuery* query, size_t capacity);
+
+  /**
+   * Offers a document. It is kept if it matches the query and is among the
+   * first `capacity` matching documents seen so far.
+   */
+  void Add(FSTDocument* doc);
+
+  /** The number of documents kept. */
+  size_t size() const {
+    return heap_.size();
+  }
+
+  /** Returns the documents kept, keyed by document key. */
+  model::DocumentMap ToDocumentMap() const;
+
+ private:
+  bool Less(FSTDocument* lhs, FSTDocument* rhs) const;
+
+  FSTQuery* query_;
+  model::DocumentComparator comparator_;
+  size_t capacity_ = 0;
+  std::vector<FSTDocument*> heap_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_TOP_DOCUMENTS_H_
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/top_documents.h"
+
+#include <algorithm>
+#include <utility>
+
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::DocumentMap;
+using util::ComparisonResult;
+
+TopDocuments::TopDocuments(FSTQuery* query, size_t capacity)
+    : query_(query), comparator_([query comparator]), capacity_(capacity) {
+}
+
+void TopDocuments::Add(FSTDocument* doc) {
+  if (capacity_ == 0 || ![query_ matchesDocument:doc]) {
+    return;
+  }
+
+  auto less = [this](FSTDocument* lhs, FSTDocument* rhs) {
+    return Less(lhs, rhs);
+  };
+  if (heap_.size() < capacity_) {
+    heap_.push_back(doc);
+    std::push_heap(heap_.begin(), heap_.end(), less);
+  } else if (Less(doc, heap_.front())) {
+    // Replace the last of the documents kept.
+    std::pop_heap(heap_.begin(), heap_.end(), less);
+    heap_.back() = doc;
+    std::push_heap(heap_.begin(), heap_.end(), less);
+  }
+}
+
+DocumentMap TopDocuments::ToDocumentMap() const {
+  DocumentMap results;
+  for (FSTDocument* doc : heap_) {
+    results = std::move(results).insert(doc.key, doc);
+  }
+  return results;
+}
+
+bool TopDocuments::Less(FSTDocument* lhs, FSTDocument* rhs) const {
+  return comparator_.Compare(lhs, rhs) == ComparisonResult::Ascending;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_WARM_SNAPSHOT_CACHE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_WARM_SNAPSHOT_CACHE_H_
+
+#if !defined(__OBJC__)
+#error "For now, this file must only be included by ObjC source files."
+#endif  // !defined(__OBJC__)
+
+#import <Foundation/Foundation.h>
+
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/types/optional.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Keeps the documents last delivered to the listeners of the most recently
+ * active targets, so that a listener can be shown them again right away on
+ * its next start, before its query has run against the local store.
+ *
+ * A warm snapshot is only a hint: the documents it returns may be out of date,
+ * and don't reflect local mutations. They must be reconciled with the results
+ * of the query as soon as those are available.
+ */
+class WarmSnapshotCache {
+ public:
+  virtual ~WarmSnapshotCache() {
+  }
+
+  /**
+   * Saves the given documents as the warm snapshot of the target, replacing
+   * any previous snapshot of it, and evicts the least recently saved snapshots
+   * beyond the first `max_targets`.
+   */
+  virtual void Save(model::TargetId target_id,
+                    const model::DocumentSet& documents,
+                    size_t max_targets) = 0;
+
+  /**
+   * Returns the warm snapshot of the target, or nullopt if none is saved.
+   */
+  virtual absl::optional<model::DocumentMap> Get(
+      model::TargetId target_id) = 0;
+
+  /** Removes the warm snapshots of all targets. */
+  virtual void RemoveAll() = 0;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_WARM_SNAPSHOT_CACHE_H_
@@ -154,6 +154,15 @@ class BasePath {
     return util::Compare(segments_, rhs.segments_);
   }
 
+  /**
+   * Makes paths hashable with absl::Hash, which mixes segments far more
+   * thoroughly than util::Hash. Prefer it for keys of unordered containers.
+   */
+  template <typename H>
+  friend H AbslHashValue(H state, const BasePath& path) {
+    return H::combine(std::move(state), path.segments_);
+  }
+
  protected:
   BasePath() = default;
   template <typename IterT>
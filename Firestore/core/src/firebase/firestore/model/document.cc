@@ -34,6 +34,31 @@ Document::Document(ObjectValue&& data,
   set_type(Type::Document);
 }
 
+Document::Document(const Document& other)
+    : MaybeDocument(other),
+      data_(other.data_),
+      document_state_(other.document_state_),
+      data_hash_(other.data_hash_.load()) {
+}
+
+Document& Document::operator=(const Document& other) {
+  MaybeDocument::operator=(other);
+  data_ = other.data_;
+  document_state_ = other.document_state_;
+  data_hash_ = other.data_hash_.load();
+  return *this;
+}
+
+size_t Document::data_hash() const {
+  size_t hash = data_hash_.load(std::memory_order_relaxed);
+  if (hash == 0) {
+    // Racing threads compute the same value, so the last store wins harmlessly.
+    hash = data_.Hash();
+    data_hash_.store(hash, std::memory_order_relaxed);
+  }
+  return hash;
+}
+
 bool Document::Equals(const MaybeDocument& other) const {
   if (other.type() != Type::Document) {
     return false;
@@ -41,7 +66,7 @@ bool Document::Equals(const MaybeDocument& other) const {
   auto& other_doc = static_cast<const Document&>(other);
   return MaybeDocument::Equals(other) &&
          document_state_ == other_doc.document_state_ &&
-         data_ == other_doc.data_;
+         data_hash() == other_doc.data_hash() && data_ == other_doc.data_;
 }
 
 }  // namespace model
@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_H_
 
+#include <atomic>
+
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
@@ -57,10 +59,20 @@ class Document : public MaybeDocument {
            SnapshotVersion version,
            DocumentState document_state);
 
+  Document(const Document& other);
+  Document& operator=(const Document& other);
+
   const ObjectValue& data() const {
     return data_;
   }
 
+  /**
+   * Returns the hash of the document's data. It's computed on first use and
+   * then remembered, so that comparing documents can rule out most
+   * differences without comparing their data.
+   */
+  size_t data_hash() const;
+
   absl::optional<FieldValue> field(const FieldPath& path) const {
     return data_.Get(path);
   }
@@ -83,13 +95,16 @@ class Document : public MaybeDocument {
  private:
   ObjectValue data_;
   DocumentState document_state_;
+
+  // Zero until computed. A real hash of zero is simply recomputed every time.
+  mutable std::atomic<size_t> data_hash_{0};
 };
 
 /** Compares against another Document. */
 inline bool operator==(const Document& lhs, const Document& rhs) {
   return lhs.version() == rhs.version() && lhs.key() == rhs.key() &&
          lhs.HasLocalMutations() == rhs.HasLocalMutations() &&
-         lhs.data() == rhs.data();
+         lhs.data_hash() == rhs.data_hash() && lhs.data() == rhs.data();
 }
 
 inline bool operator!=(const Document& lhs, const Document& rhs) {
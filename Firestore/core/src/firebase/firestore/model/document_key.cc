@@ -18,12 +18,17 @@
 
 #include <utility>
 
+#include "Firestore/core/src/firebase/firestore/model/path_interner.h"
+#include "Firestore/core/src/firebase/firestore/util/allocation_counters.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 
 namespace firebase {
 namespace firestore {
 namespace model {
 
+using util::AllocationSubsystem;
+using util::MakeCountedShared;
+
 namespace {
 
 void AssertValidPath(const ResourcePath& path) {
@@ -34,21 +39,34 @@ void AssertValidPath(const ResourcePath& path) {
 }  // namespace
 
 DocumentKey::DocumentKey(const ResourcePath& path)
-    : path_{std::make_shared<ResourcePath>(path)} {
+    : path_{
+          MakeCountedShared<AllocationSubsystem::kModel, ResourcePath>(path)} {
   AssertValidPath(*path_);
 }
 
 DocumentKey::DocumentKey(ResourcePath&& path)
-    : path_{std::make_shared<ResourcePath>(std::move(path))} {
+    : path_{MakeCountedShared<AllocationSubsystem::kModel, ResourcePath>(
+          std::move(path))} {
   AssertValidPath(*path_);
 }
 
+DocumentKey::DocumentKey(std::shared_ptr<const ResourcePath> path)
+    : path_{std::move(path)} {
+}
+
+DocumentKey DocumentKey::Interned(ResourcePath&& path) {
+  AssertValidPath(path);
+  return DocumentKey{PathInterner::Default().Intern(std::move(path))};
+}
+
 const DocumentKey& DocumentKey::Empty() {
   static const DocumentKey empty;
   return empty;
 }
 
 util::ComparisonResult DocumentKey::CompareTo(const DocumentKey& other) const {
+  // Interned keys for the same document share their path.
+  if (path_ == other.path_) return util::ComparisonResult::Same;
   return path().CompareTo(other.path());
 }
 
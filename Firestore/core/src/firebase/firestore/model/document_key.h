@@ -21,10 +21,12 @@
 #include <initializer_list>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
+#include "absl/hash/hash.h"
 #include "absl/strings/string_view.h"
 
 namespace firebase {
@@ -47,11 +49,21 @@ class DocumentKey : public util::Comparable<DocumentKey> {
   explicit DocumentKey(ResourcePath&& path);
 
   /**
-   * Creates and returns a new document key using '/' to split the string into
-   * segments.
+   * Creates a new document key that shares its path with all other live
+   * interned keys for the same document (see `PathInterner`). Comparing such
+   * keys is a pointer comparison.
+   *
+   * Prefer this over the constructors for keys that are likely to be held
+   * many times over, e.g. keys decoded from local storage or the network.
+   */
+  static DocumentKey Interned(ResourcePath&& path);
+
+  /**
+   * Creates and returns a new interned document key using '/' to split the
+   * string into segments.
    */
   static DocumentKey FromPathString(absl::string_view path) {
-    return DocumentKey{ResourcePath::FromString(path)};
+    return Interned(ResourcePath::FromString(path));
   }
 
   /** Creates and returns a new document key with the given segments. */
@@ -73,6 +85,11 @@ class DocumentKey : public util::Comparable<DocumentKey> {
     return util::Hash(ToString());
   }
 
+  template <typename H>
+  friend H AbslHashValue(H state, const DocumentKey& key) {
+    return H::combine(std::move(state), key.path());
+  }
+
   std::string ToString() const {
     return path().CanonicalString();
   }
@@ -89,14 +106,20 @@ class DocumentKey : public util::Comparable<DocumentKey> {
   }
 
  private:
+  explicit DocumentKey(std::shared_ptr<const ResourcePath> path);
+
   // This is an optimization to make passing DocumentKey around cheaper (it's
   // copied often).
   std::shared_ptr<const ResourcePath> path_;
 };
 
+/**
+ * Hashes keys for unordered containers. Unlike `DocumentKey::Hash`, which has
+ * to agree with the Objective-C `-hash`, this is free to use absl::Hash.
+ */
 struct DocumentKeyHash {
   size_t operator()(const DocumentKey& key) const {
-    return util::Hash(key.path());
+    return absl::Hash<DocumentKey>{}(key);
   }
 };
 
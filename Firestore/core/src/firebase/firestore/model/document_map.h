@@ -59,9 +59,12 @@ class DocumentMap {
   DocumentMap() = default;
 
   ABSL_MUST_USE_RESULT DocumentMap insert(const DocumentKey& key,
-                                          FSTDocument* value) const;
+                                          FSTDocument* value) const&;
+  ABSL_MUST_USE_RESULT DocumentMap insert(DocumentKey key,
+                                          FSTDocument* value) &&;
 
-  ABSL_MUST_USE_RESULT DocumentMap erase(const DocumentKey& key) const;
+  ABSL_MUST_USE_RESULT DocumentMap erase(const DocumentKey& key) const&;
+  ABSL_MUST_USE_RESULT DocumentMap erase(const DocumentKey& key) &&;
 
   bool empty() const {
     return map_.empty();
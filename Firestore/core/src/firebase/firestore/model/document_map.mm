@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 
+#include <utility>
+
 #import <Foundation/Foundation.h>
 
 #import "Firestore/Source/Model/FSTDocument.h"
@@ -24,16 +26,25 @@ namespace firebase {
 namespace firestore {
 namespace model {
 
-ABSL_MUST_USE_RESULT DocumentMap DocumentMap::insert(const DocumentKey& key,
-                                                     FSTDocument* value) const {
+ABSL_MUST_USE_RESULT DocumentMap
+DocumentMap::insert(const DocumentKey& key, FSTDocument* value) const& {
   return DocumentMap{map_.insert(key, value)};
 }
 
+ABSL_MUST_USE_RESULT DocumentMap DocumentMap::insert(DocumentKey key,
+                                                     FSTDocument* value) && {
+  return DocumentMap{std::move(map_).insert(std::move(key), value)};
+}
+
 ABSL_MUST_USE_RESULT DocumentMap
-DocumentMap::erase(const DocumentKey& key) const {
+DocumentMap::erase(const DocumentKey& key) const& {
   return DocumentMap{map_.erase(key)};
 }
 
+ABSL_MUST_USE_RESULT DocumentMap DocumentMap::erase(const DocumentKey& key) && {
+  return DocumentMap{std::move(map_).erase(key)};
+}
+
 FSTDocument* GetFSTDocumentOrNil(FSTMaybeDocument* maybeDoc) {
   if ([maybeDoc isKindOfClass:[FSTDocument class]]) {
     return static_cast<FSTDocument*>(maybeDoc);
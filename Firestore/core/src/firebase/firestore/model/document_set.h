@@ -66,7 +66,7 @@ class DocumentSet : public immutable::SortedContainer {
    * Creates a new, empty DocumentSet sorted by the given comparator, then by
    * keys.
    */
-  explicit DocumentSet(DocumentComparator&& comparator);
+  explicit DocumentSet(const DocumentComparator& comparator);
 
   size_t size() const {
     return index_.size();
@@ -40,8 +40,8 @@ DocumentComparator DocumentComparator::ByKey() {
   });
 }
 
-DocumentSet::DocumentSet(DocumentComparator&& comparator)
-    : index_{}, sorted_set_{std::move(comparator)} {
+DocumentSet::DocumentSet(const DocumentComparator& comparator)
+    : index_{}, sorted_set_{comparator} {
 }
 
 bool operator==(const DocumentSet& lhs, const DocumentSet& rhs) {
@@ -99,12 +99,19 @@ DocumentSet DocumentSet::insert(FSTDocument* _Nullable document) const {
     return *this;
   }
 
-  // Remove any prior mapping of the document's key before adding, preventing
-  // sortedSet from accumulating values that aren't in the index.
-  DocumentSet removed = erase(document.key);
+  FSTDocument* existing = GetDocument(document.key);
+  if (existing == document) {
+    return *this;
+  }
 
-  DocumentMap index = removed.index_.insert(document.key, document);
-  SetType set = removed.sorted_set_.insert(document);
+  // Inserting into the index replaces any prior mapping of the key. The sorted
+  // set is keyed by the documents themselves, so the prior document has to be
+  // removed from it explicitly, preventing it from accumulating values that
+  // aren't in the index. Both updates after the first copy of each tree are
+  // made in place.
+  DocumentMap index = index_.insert(document.key, document);
+  SetType set = existing ? sorted_set_.erase(existing) : sorted_set_;
+  set = std::move(set).insert(document);
   return {std::move(index), std::move(set)};
 }
 
@@ -18,12 +18,16 @@
 
 #include <algorithm>
 #include <cmath>
+#include <map>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <new>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/util/allocation_counters.h"
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
@@ -35,9 +39,21 @@ namespace model {
 
 using Type = FieldValue::Type;
 
+using util::AllocationSubsystem;
 using util::Compare;
 using util::ComparisonResult;
 
+namespace {
+
+/** Allocates the box of a value that doesn't fit in a FieldValue itself. */
+template <typename T, typename... Args>
+std::shared_ptr<T> MakeBoxed(Args&&... args) {
+  return util::MakeCountedShared<AllocationSubsystem::kModel, T>(
+      std::forward<Args>(args)...);
+}
+
+}  // namespace
+
 FieldValue::FieldValue(const FieldValue& value) {
   *this = value;
 }
@@ -65,38 +81,29 @@ FieldValue& FieldValue::operator=(const FieldValue& value) {
       double_value_ = value.double_value_;
       break;
     case Type::Timestamp:
-      *timestamp_value_ = *value.timestamp_value_;
+      timestamp_value_ = value.timestamp_value_;
       break;
     case Type::ServerTimestamp:
-      *server_timestamp_value_ = *value.server_timestamp_value_;
+      server_timestamp_value_ = value.server_timestamp_value_;
       break;
     case Type::String:
-      *string_value_ = *value.string_value_;
+      string_value_ = value.string_value_;
       break;
-    case Type::Blob: {
-      // copy-and-swap
-      std::vector<uint8_t> tmp = *value.blob_value_;
-      std::swap(*blob_value_, tmp);
+    case Type::Blob:
+      blob_value_ = value.blob_value_;
       break;
-    }
     case Type::Reference:
-      *reference_value_ = *value.reference_value_;
+      reference_value_ = value.reference_value_;
       break;
     case Type::GeoPoint:
-      *geo_point_value_ = *value.geo_point_value_;
+      geo_point_value_ = value.geo_point_value_;
       break;
-    case Type::Array: {
-      // copy-and-swap
-      std::vector<FieldValue> tmp = *value.array_value_;
-      std::swap(*array_value_, tmp);
+    case Type::Array:
+      array_value_ = value.array_value_;
       break;
-    }
-    case Type::Object: {
-      // copy-and-swap
-      Map tmp = *value.object_value_;
-      std::swap(*object_value_, tmp);
+    case Type::Object:
+      object_value_ = value.object_value_;
       break;
-    }
     default:
       HARD_FAIL("Unsupported type %s", value.type());
   }
@@ -104,32 +111,42 @@ FieldValue& FieldValue::operator=(const FieldValue& value) {
 }
 
 FieldValue& FieldValue::operator=(FieldValue&& value) {
+  if (this == &value) return *this;
+
   switch (value.tag_) {
+    case Type::ServerTimestamp:
+      SwitchTo(Type::ServerTimestamp);
+      server_timestamp_value_ = std::move(value.server_timestamp_value_);
+      break;
     case Type::String:
       SwitchTo(Type::String);
-      string_value_->swap(*value.string_value_);
-      return *this;
+      string_value_ = std::move(value.string_value_);
+      break;
     case Type::Blob:
       SwitchTo(Type::Blob);
-      std::swap(blob_value_, value.blob_value_);
-      return *this;
+      blob_value_ = std::move(value.blob_value_);
+      break;
     case Type::Reference:
       SwitchTo(Type::Reference);
-      std::swap(reference_value_, value.reference_value_);
-      return *this;
+      reference_value_ = std::move(value.reference_value_);
+      break;
     case Type::Array:
       SwitchTo(Type::Array);
-      std::swap(array_value_, value.array_value_);
-      return *this;
+      array_value_ = std::move(value.array_value_);
+      break;
     case Type::Object:
       SwitchTo(Type::Object);
-      std::swap(object_value_, value.object_value_);
-      return *this;
+      object_value_ = std::move(value.object_value_);
+      break;
     default:
       // We just copy over POD union types.
       *this = value;
       return *this;
   }
+
+  // Don't leave the moved-from value with an empty shared pointer.
+  value.SwitchTo(Type::Null);
+  return *this;
 }
 
 bool FieldValue::Comparable(Type lhs, Type rhs) {
@@ -156,13 +173,13 @@ ObjectValue ObjectValue::Set(const FieldPath& field_path,
     return SetChild(child_name, value);
   } else {
     ObjectValue child = ObjectValue::Empty();
-    const auto iter = fv_.object_value_->find(child_name);
-    if (iter != fv_.object_value_->end() &&
-        iter->second.type() == Type::Object) {
+    const FieldValue::Map& fields = GetInternalValue();
+    const auto iter = fields.find(child_name);
+    if (iter != fields.end() && iter->second.type() == Type::Object) {
       child = ObjectValue(iter->second);
     }
     ObjectValue new_child = child.Set(field_path.PopFirst(), value);
-    return SetChild(child_name, new_child.fv_);
+    return SetChild(child_name, new_child.value());
   }
 }
 
@@ -171,15 +188,15 @@ ObjectValue ObjectValue::Delete(const FieldPath& field_path) const {
               "Cannot delete field for empty path on FieldValue");
   // Delete the value by recursively calling on child object.
   const std::string& child_name = field_path.first_segment();
+  const FieldValue::Map& fields = GetInternalValue();
   if (field_path.size() == 1) {
-    return ObjectValue::FromMap(fv_.object_value_->erase(child_name));
+    return ObjectValue::FromMap(fields.erase(child_name));
   } else {
-    const auto iter = fv_.object_value_->find(child_name);
-    if (iter != fv_.object_value_->end() &&
-        iter->second.type() == Type::Object) {
+    const auto iter = fields.find(child_name);
+    if (iter != fields.end() && iter->second.type() == Type::Object) {
       ObjectValue new_child =
           ObjectValue(iter->second).Delete(field_path.PopFirst());
-      return SetChild(child_name, new_child.fv_);
+      return SetChild(child_name, new_child.value());
     } else {
       // If the found value isn't an object, it cannot contain the remaining
       // segments of the path. We don't actually change a primitive value to
@@ -190,12 +207,27 @@ ObjectValue ObjectValue::Delete(const FieldPath& field_path) const {
 }
 
 absl::optional<FieldValue> ObjectValue::Get(const FieldPath& field_path) const {
-  const FieldValue* current = &this->fv_;
-  for (const auto& path : field_path) {
+  auto segment = field_path.begin();
+
+  // Only decode the top-level field that contains the value.
+  absl::optional<FieldValue> top_level;
+  const FieldValue* current;
+  if (lazy_fields_ && segment != field_path.end()) {
+    top_level = lazy_fields_->Get(*segment);
+    if (!top_level) {
+      return absl::nullopt;
+    }
+    current = &*top_level;
+    ++segment;
+  } else {
+    current = &value();
+  }
+
+  for (; segment != field_path.end(); ++segment) {
     if (current->type() != Type::Object) {
       return absl::nullopt;
     }
-    const auto iter = current->object_value_->find(path);
+    const auto iter = current->object_value_->find(*segment);
     if (iter == current->object_value_->end()) {
       return absl::nullopt;
     } else {
@@ -207,7 +239,39 @@ absl::optional<FieldValue> ObjectValue::Get(const FieldPath& field_path) const {
 
 ObjectValue ObjectValue::SetChild(const std::string& child_name,
                                   const FieldValue& value) const {
-  return ObjectValue::FromMap(fv_.object_value_->insert(child_name, value));
+  return ObjectValue::FromMap(GetInternalValue().insert(child_name, value));
+}
+
+absl::optional<FieldValue> ObjectValue::LazyFields::Get(
+    const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (value_) {
+    const FieldValue::Map& fields = *value_->object_value_;
+    const auto iter = fields.find(name);
+    if (iter == fields.end()) {
+      return absl::nullopt;
+    }
+    return iter->second;
+  }
+
+  auto found = fields_.find(name);
+  if (found == fields_.end()) {
+    found = fields_.emplace(name, source_->DecodeField(name)).first;
+  }
+  return found->second;
+}
+
+const FieldValue& ObjectValue::LazyFields::value() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!value_) {
+    value_ = absl::make_unique<FieldValue>(
+        FieldValue::FromMap(source_->DecodeFields()));
+
+    // Individually decoded fields are no longer needed.
+    fields_.clear();
+    source_.reset();
+  }
+  return *value_;
 }
 
 FieldValue FieldValue::Null() {
@@ -251,7 +315,7 @@ FieldValue FieldValue::FromDouble(double value) {
 FieldValue FieldValue::FromTimestamp(const Timestamp& value) {
   FieldValue result;
   result.SwitchTo(Type::Timestamp);
-  *result.timestamp_value_ = value;
+  result.timestamp_value_ = value;
   return result;
 }
 
@@ -259,16 +323,16 @@ FieldValue FieldValue::FromServerTimestamp(const Timestamp& local_write_time,
                                            const Timestamp& previous_value) {
   FieldValue result;
   result.SwitchTo(Type::ServerTimestamp);
-  result.server_timestamp_value_->local_write_time = local_write_time;
-  result.server_timestamp_value_->previous_value = previous_value;
+  result.server_timestamp_value_ = MakeBoxed<ServerTimestamp>(
+      ServerTimestamp{local_write_time, previous_value});
   return result;
 }
 
 FieldValue FieldValue::FromServerTimestamp(const Timestamp& local_write_time) {
   FieldValue result;
   result.SwitchTo(Type::ServerTimestamp);
-  result.server_timestamp_value_->local_write_time = local_write_time;
-  result.server_timestamp_value_->previous_value = absl::nullopt;
+  result.server_timestamp_value_ = MakeBoxed<ServerTimestamp>(
+      ServerTimestamp{local_write_time, absl::nullopt});
   return result;
 }
 
@@ -285,15 +349,14 @@ FieldValue FieldValue::FromString(const std::string& value) {
 FieldValue FieldValue::FromString(std::string&& value) {
   FieldValue result;
   result.SwitchTo(Type::String);
-  result.string_value_->swap(value);
+  result.string_value_ = MakeBoxed<std::string>(std::move(value));
   return result;
 }
 
 FieldValue FieldValue::FromBlob(const uint8_t* source, size_t size) {
   FieldValue result;
   result.SwitchTo(Type::Blob);
-  std::vector<uint8_t> copy(source, source + size);
-  std::swap(*result.blob_value_, copy);
+  result.blob_value_ = MakeBoxed<std::vector<uint8_t>>(source, source + size);
   return result;
 }
 
@@ -302,8 +365,8 @@ FieldValue FieldValue::FromReference(const DocumentKey& value,
                                      const DatabaseId* database_id) {
   FieldValue result;
   result.SwitchTo(Type::Reference);
-  result.reference_value_->reference = value;
-  result.reference_value_->database_id = database_id;
+  result.reference_value_ =
+      MakeBoxed<ReferenceValue>(ReferenceValue{value, database_id});
   return result;
 }
 
@@ -312,15 +375,15 @@ FieldValue FieldValue::FromReference(DocumentKey&& value,
                                      const DatabaseId* database_id) {
   FieldValue result;
   result.SwitchTo(Type::Reference);
-  std::swap(result.reference_value_->reference, value);
-  result.reference_value_->database_id = database_id;
+  result.reference_value_ = MakeBoxed<ReferenceValue>(
+      ReferenceValue{std::move(value), database_id});
   return result;
 }
 
 FieldValue FieldValue::FromGeoPoint(const GeoPoint& value) {
   FieldValue result;
   result.SwitchTo(Type::GeoPoint);
-  *result.geo_point_value_ = value;
+  result.geo_point_value_ = value;
   return result;
 }
 
@@ -332,7 +395,7 @@ FieldValue FieldValue::FromArray(const std::vector<FieldValue>& value) {
 FieldValue FieldValue::FromArray(std::vector<FieldValue>&& value) {
   FieldValue result;
   result.SwitchTo(Type::Array);
-  std::swap(*result.array_value_, value);
+  result.array_value_ = MakeBoxed<std::vector<FieldValue>>(std::move(value));
   return result;
 }
 
@@ -344,38 +407,75 @@ FieldValue FieldValue::FromMap(const FieldValue::Map& value) {
 FieldValue FieldValue::FromMap(FieldValue::Map&& value) {
   FieldValue result;
   result.SwitchTo(Type::Object);
-  std::swap(*result.object_value_, value);
+  result.object_value_ = MakeBoxed<Map>(std::move(value));
   return result;
 }
 
 size_t FieldValue::Hash() const {
   switch (type()) {
-    case FieldValue::Type::Null:
-      HARD_FAIL("TODO(rsgowman): Implement");
-
-    case FieldValue::Type::Boolean:
-      return util::Hash(boolean_value());
-
-    case FieldValue::Type::Integer:
-    case FieldValue::Type::Double:
-    case FieldValue::Type::Timestamp:
-    case FieldValue::Type::ServerTimestamp:
-      HARD_FAIL("TODO(rsgowman): Implement");
-
-    case FieldValue::Type::String:
-      return util::Hash(string_value());
-
-    case FieldValue::Type::Blob:
-    case FieldValue::Type::Reference:
-    case FieldValue::Type::GeoPoint:
-    case FieldValue::Type::Array:
-    case FieldValue::Type::Object:
-      HARD_FAIL("TODO(rsgowman): Implement");
+    case Type::Null:
+      return util::Hash(static_cast<int>(Type::Null));
+
+    case Type::Boolean:
+      return util::Hash(boolean_value_);
+
+    case Type::Integer:
+      // Integers and doubles with the same value compare equal.
+      return HashNumber(static_cast<double>(integer_value_));
+
+    case Type::Double:
+      return HashNumber(double_value_);
+
+    case Type::Timestamp:
+      return util::Hash(timestamp_value_.seconds(),
+                        timestamp_value_.nanoseconds());
+
+    case Type::ServerTimestamp: {
+      // Server timestamps compare by local write time only.
+      const Timestamp& time = server_timestamp_value_->local_write_time;
+      return util::Hash(time.seconds(), time.nanoseconds());
+    }
+
+    case Type::String:
+      return util::Hash(*string_value_);
+
+    case Type::Blob:
+      return util::Hash(*blob_value_);
+
+    case Type::Reference:
+      return util::Hash(reference_value_->database_id,
+                        reference_value_->reference);
+
+    case Type::GeoPoint:
+      return util::Hash(geo_point_value_.latitude(),
+                        geo_point_value_.longitude());
+
+    case Type::Array:
+      return util::Hash(*array_value_);
+
+    case Type::Object: {
+      size_t result = 0;
+      for (const auto& entry : *object_value_) {
+        result = util::Hash(result, entry.first, entry.second);
+      }
+      return util::Hash(result, object_value_->size());
+    }
   }
 
   UNREACHABLE();
 }
 
+size_t FieldValue::HashNumber(double value) {
+  // All NaNs compare equal to each other, as do 0.0 and -0.0.
+  if (std::isnan(value)) {
+    return util::Hash(static_cast<int>(Type::Double));
+  }
+  if (value == 0) {
+    value = 0.0;
+  }
+  return util::Hash(value);
+}
+
 ComparisonResult FieldValue::CompareTo(const FieldValue& rhs) const {
   if (!FieldValue::Comparable(type(), rhs.type())) {
     return Compare(type(), rhs.type());
@@ -402,7 +502,7 @@ ComparisonResult FieldValue::CompareTo(const FieldValue& rhs) const {
       }
     case Type::Timestamp:
       if (rhs.type() == Type::Timestamp) {
-        return Compare(*timestamp_value_, *rhs.timestamp_value_);
+        return Compare(timestamp_value_, rhs.timestamp_value_);
       } else {
         return ComparisonResult::Ascending;
       }
@@ -414,8 +514,10 @@ ComparisonResult FieldValue::CompareTo(const FieldValue& rhs) const {
         return ComparisonResult::Descending;
       }
     case Type::String:
+      if (string_value_ == rhs.string_value_) return ComparisonResult::Same;
       return Compare(*string_value_, *rhs.string_value_);
     case Type::Blob:
+      if (blob_value_ == rhs.blob_value_) return ComparisonResult::Same;
       return Compare(*blob_value_, *rhs.blob_value_);
     case Type::Reference:
       cmp = Compare(reference_value_->database_id,
@@ -425,10 +527,13 @@ ComparisonResult FieldValue::CompareTo(const FieldValue& rhs) const {
       return Compare(reference_value_->reference,
                      rhs.reference_value_->reference);
     case Type::GeoPoint:
-      return Compare(*geo_point_value_, *rhs.geo_point_value_);
+      return Compare(geo_point_value_, rhs.geo_point_value_);
+    // Copies share their contents, so there is no need to compare them.
     case Type::Array:
+      if (array_value_ == rhs.array_value_) return ComparisonResult::Same;
       return CompareContainer(*array_value_, *rhs.array_value_);
     case Type::Object:
+      if (object_value_ == rhs.object_value_) return ComparisonResult::Same;
       return CompareContainer(*object_value_, *rhs.object_value_);
     default:
       HARD_FAIL("Unsupported type %s", type());
@@ -446,65 +551,58 @@ void FieldValue::SwitchTo(const Type type) {
   // Must call destructor explicitly for any non-POD type.
   switch (tag_) {
     case Type::Timestamp:
-      timestamp_value_.~unique_ptr<Timestamp>();
+      timestamp_value_.~Timestamp();
       break;
     case Type::ServerTimestamp:
-      server_timestamp_value_.~unique_ptr<ServerTimestamp>();
+      server_timestamp_value_.~shared_ptr<const ServerTimestamp>();
       break;
     case Type::String:
-      string_value_.~unique_ptr<std::string>();
+      string_value_.~shared_ptr<const std::string>();
       break;
     case Type::Blob:
-      blob_value_.~unique_ptr<std::vector<uint8_t>>();
+      blob_value_.~shared_ptr<const std::vector<uint8_t>>();
       break;
     case Type::Reference:
-      reference_value_.~unique_ptr<ReferenceValue>();
+      reference_value_.~shared_ptr<const ReferenceValue>();
       break;
     case Type::GeoPoint:
-      geo_point_value_.~unique_ptr<GeoPoint>();
+      geo_point_value_.~GeoPoint();
       break;
     case Type::Array:
-      array_value_.~unique_ptr<std::vector<FieldValue>>();
+      array_value_.~shared_ptr<const std::vector<FieldValue>>();
       break;
     case Type::Object:
-      object_value_.~unique_ptr<Map>();
+      object_value_.~shared_ptr<const Map>();
       break;
     default: {}  // The other types where there is nothing to worry about.
   }
   tag_ = type;
-  // Must call constructor explicitly for any non-POD type to initialize.
+  // Must call constructor explicitly for any non-POD type to initialize. Shared
+  // values are left empty; callers are expected to set them right away.
   switch (tag_) {
     case Type::Timestamp:
-      new (&timestamp_value_)
-          std::unique_ptr<Timestamp>(absl::make_unique<Timestamp>(0, 0));
+      new (&timestamp_value_) Timestamp();
       break;
     case Type::ServerTimestamp:
-      new (&server_timestamp_value_) std::unique_ptr<ServerTimestamp>(
-          absl::make_unique<ServerTimestamp>());
+      new (&server_timestamp_value_) std::shared_ptr<const ServerTimestamp>();
       break;
     case Type::String:
-      new (&string_value_)
-          std::unique_ptr<std::string>(absl::make_unique<std::string>());
+      new (&string_value_) std::shared_ptr<const std::string>();
       break;
     case Type::Blob:
-      // Do not even bother to allocate a new array of size 0.
-      new (&blob_value_) std::unique_ptr<std::vector<uint8_t>>(
-          absl::make_unique<std::vector<uint8_t>>());
+      new (&blob_value_) std::shared_ptr<const std::vector<uint8_t>>();
       break;
     case Type::Reference:
-      new (&reference_value_)
-          std::unique_ptr<ReferenceValue>(absl::make_unique<ReferenceValue>());
+      new (&reference_value_) std::shared_ptr<const ReferenceValue>();
       break;
     case Type::GeoPoint:
-      new (&geo_point_value_)
-          std::unique_ptr<GeoPoint>(absl::make_unique<GeoPoint>());
+      new (&geo_point_value_) GeoPoint();
       break;
     case Type::Array:
-      new (&array_value_) std::unique_ptr<std::vector<FieldValue>>(
-          absl::make_unique<std::vector<FieldValue>>());
+      new (&array_value_) std::shared_ptr<const std::vector<FieldValue>>();
       break;
     case Type::Object:
-      new (&object_value_) std::unique_ptr<Map>(absl::make_unique<Map>());
+      new (&object_value_) std::shared_ptr<const Map>();
       break;
     default: {}  // The other types where there is nothing to worry about.
   }
@@ -518,8 +616,98 @@ ObjectValue ObjectValue::FromMap(FieldValue::Map&& value) {
   return ObjectValue(FieldValue::FromMap(std::move(value)));
 }
 
+ObjectValue ObjectValue::FromSource(
+    std::shared_ptr<const ObjectValueSource> source) {
+  return ObjectValue(MakeBoxed<LazyFields>(std::move(source)));
+}
+
 ComparisonResult ObjectValue::CompareTo(const ObjectValue& rhs) const {
-  return fv_.CompareTo(rhs.fv_);
+  return value().CompareTo(rhs.value());
+}
+
+ObjectValueBuilder& ObjectValueBuilder::Set(const FieldPath& field_path,
+                                            FieldValue value) {
+  HARD_ASSERT(!field_path.empty(),
+              "Cannot set field for empty path on FieldValue");
+  updates_.push_back(Update{field_path, std::move(value)});
+  return *this;
+}
+
+ObjectValueBuilder& ObjectValueBuilder::Delete(const FieldPath& field_path) {
+  HARD_ASSERT(!field_path.empty(),
+              "Cannot delete field for empty path on FieldValue");
+  updates_.push_back(Update{field_path, absl::nullopt});
+  return *this;
+}
+
+ObjectValue ObjectValueBuilder::Build() const {
+  if (updates_.empty()) return base_;
+
+  Updates updates;
+  updates.reserve(updates_.size());
+  for (const Update& update : updates_) {
+    updates.push_back(&update);
+  }
+  return ObjectValue::FromMap(Apply(base_.GetInternalValue(), updates, 0));
+}
+
+FieldValue::Map ObjectValueBuilder::Apply(FieldValue::Map fields,
+                                          const Updates& updates,
+                                          size_t depth) {
+  // Updates to different fields are independent, so group them by field while
+  // keeping the order of updates to the same field.
+  std::map<std::string, Updates> updates_by_field;
+  for (const Update* update : updates) {
+    updates_by_field[update->path[depth]].push_back(update);
+  }
+
+  for (const auto& entry : updates_by_field) {
+    const std::string& name = entry.first;
+    const Updates& field_updates = entry.second;
+
+    const auto iter = fields.find(name);
+    const bool existed = iter != fields.end();
+    absl::optional<FieldValue> value;
+    if (existed) {
+      value = iter->second;
+    }
+
+    size_t i = 0;
+    while (i < field_updates.size()) {
+      if (field_updates[i]->path.size() == depth + 1) {
+        value = field_updates[i]->value;
+        ++i;
+        continue;
+      }
+
+      // Apply the whole run of consecutive updates to nested fields at once.
+      Updates nested;
+      bool has_set = false;
+      for (; i < field_updates.size() &&
+             field_updates[i]->path.size() > depth + 1;
+           ++i) {
+        nested.push_back(field_updates[i]);
+        has_set = has_set || field_updates[i]->value.has_value();
+      }
+
+      if (value && value->type() == Type::Object) {
+        value = FieldValue::FromMap(
+            Apply(*value->object_value_, nested, depth + 1));
+      } else if (has_set) {
+        // Like `ObjectValue::Set`, pretend that an empty object lives in place
+        // of a missing or primitive value. Deletes alone leave it unchanged.
+        value =
+            FieldValue::FromMap(Apply(FieldValue::Map{}, nested, depth + 1));
+      }
+    }
+
+    if (value) {
+      fields = std::move(fields).insert(name, *value);
+    } else if (existed) {
+      fields = std::move(fields).erase(name);
+    }
+  }
+  return fields;
 }
 
 }  // namespace model
@@ -19,7 +19,9 @@
 
 #include <cstdint>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -30,10 +32,12 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 
 #if __OBJC__
 @class FSTFieldValue;
+@class FSTObjectValue;
 #endif  // __OBJC__
 
 namespace firebase {
@@ -140,7 +144,7 @@ class FieldValue : public util::Comparable<FieldValue> {
 
   Timestamp timestamp_value() const {
     HARD_ASSERT(tag_ == Type::Timestamp);
-    return *timestamp_value_;
+    return timestamp_value_;
   }
 
   const std::string& string_value() const {
@@ -155,7 +159,7 @@ class FieldValue : public util::Comparable<FieldValue> {
 
   const GeoPoint& geo_point_value() const {
     HARD_ASSERT(tag_ == Type::GeoPoint);
-    return *geo_point_value_;
+    return geo_point_value_;
   }
 
   const std::vector<FieldValue>& array_value() const {
@@ -192,10 +196,20 @@ class FieldValue : public util::Comparable<FieldValue> {
 
   size_t Hash() const;
 
+  /**
+   * Feeds `Hash()` through absl::Hash's mixing so that values which compare
+   * equal (e.g. `1` and `1.0`) still hash alike.
+   */
+  template <typename H>
+  friend H AbslHashValue(H state, const FieldValue& value) {
+    return H::combine(std::move(state), value.Hash());
+  }
+
   util::ComparisonResult CompareTo(const FieldValue& rhs) const;
 
  private:
   friend class ObjectValue;
+  friend class ObjectValueBuilder;
 
   explicit FieldValue(bool value) : tag_(Type::Boolean), boolean_value_(value) {
   }
@@ -205,24 +219,52 @@ class FieldValue : public util::Comparable<FieldValue> {
    */
   void SwitchTo(Type type);
 
+  /** Hashes numbers consistently with how they compare. */
+  static size_t HashNumber(double value);
+
   Type tag_ = Type::Null;
   union {
     // There is no null type as tag_ alone is enough for Null FieldValue.
     bool boolean_value_;
     int64_t integer_value_;
     double double_value_;
-    std::unique_ptr<Timestamp> timestamp_value_;
-    std::unique_ptr<ServerTimestamp> server_timestamp_value_;
-    // TODO(rsgowman): Change unique_ptr<std::string> to nanopb::String?
-    std::unique_ptr<std::string> string_value_;
-    std::unique_ptr<std::vector<uint8_t>> blob_value_;
-    std::unique_ptr<ReferenceValue> reference_value_;
-    std::unique_ptr<GeoPoint> geo_point_value_;
-    std::unique_ptr<std::vector<FieldValue>> array_value_;
-    std::unique_ptr<Map> object_value_;
+    // Small values are stored inline.
+    Timestamp timestamp_value_;
+    GeoPoint geo_point_value_;
+    // Everything else is immutable once created and shared between copies, so
+    // that copying a FieldValue never allocates.
+    std::shared_ptr<const ServerTimestamp> server_timestamp_value_;
+    std::shared_ptr<const std::string> string_value_;
+    std::shared_ptr<const std::vector<uint8_t>> blob_value_;
+    std::shared_ptr<const ReferenceValue> reference_value_;
+    std::shared_ptr<const std::vector<FieldValue>> array_value_;
+    std::shared_ptr<const Map> object_value_;
   };
 };
 
+/**
+ * The still-encoded fields of an ObjectValue, which can be decoded one
+ * top-level field at a time.
+ *
+ * This allows an ObjectValue to defer the cost of building FieldValues until
+ * they are accessed. Implementations are expected to be immutable.
+ */
+class ObjectValueSource {
+ public:
+  virtual ~ObjectValueSource() {
+  }
+
+  /**
+   * Decodes the top-level field with the given name, or returns absl::nullopt
+   * if there is no such field.
+   */
+  virtual absl::optional<FieldValue> DecodeField(
+      absl::string_view name) const = 0;
+
+  /** Decodes all fields. */
+  virtual FieldValue::Map DecodeFields() const = 0;
+};
+
 /** A structured object value stored in Firestore. */
 class ObjectValue : public util::Comparable<ObjectValue> {
  public:
@@ -237,6 +279,15 @@ class ObjectValue : public util::Comparable<ObjectValue> {
   static ObjectValue FromMap(const FieldValue::Map& value);
   static ObjectValue FromMap(FieldValue::Map&& value);
 
+  /**
+   * Creates an ObjectValue whose fields are decoded from the given source as
+   * they are accessed.
+   *
+   * `Get` only decodes the top-level field named by the first segment of the
+   * path. Every other operation decodes all fields, once.
+   */
+  static ObjectValue FromSource(std::shared_ptr<const ObjectValueSource> source);
+
   /**
    * Returns the value at the given path or absl::nullopt. If the path is empty,
    * an identical copy of the FieldValue is returned.
@@ -272,18 +323,117 @@ class ObjectValue : public util::Comparable<ObjectValue> {
   // timestamps) optionally resolved. Do we need the same here?
 
   const FieldValue::Map& GetInternalValue() const {
-    return *fv_.object_value_;
+    return *value().object_value_;
+  }
+
+  size_t Hash() const {
+    return value().Hash();
   }
 
   util::ComparisonResult CompareTo(const ObjectValue& rhs) const;
 
  private:
+  /**
+   * The decoding state for an ObjectValue created from an ObjectValueSource,
+   * shared by all copies of it.
+   */
+  class LazyFields {
+   public:
+    explicit LazyFields(std::shared_ptr<const ObjectValueSource> source)
+        : source_(std::move(source)) {
+    }
+
+    /** Returns the top-level field with the given name, decoding if needed. */
+    absl::optional<FieldValue> Get(const std::string& name);
+
+    /** Returns the whole object, decoding every field the first time. */
+    const FieldValue& value();
+
+   private:
+    std::mutex mutex_;
+    std::shared_ptr<const ObjectValueSource> source_;
+    std::unordered_map<std::string, absl::optional<FieldValue>> fields_;
+    std::unique_ptr<FieldValue> value_;
+  };
+
+  explicit ObjectValue(std::shared_ptr<LazyFields> lazy_fields)
+      : fv_(FieldValue::EmptyObject()), lazy_fields_(std::move(lazy_fields)) {
+  }
+
+  const FieldValue& value() const {
+    return lazy_fields_ ? lazy_fields_->value() : fv_;
+  }
+
   ObjectValue SetChild(const std::string& child_name,
                        const FieldValue& value) const;
 
   FieldValue fv_;
+
+  // Only set if this ObjectValue was created from an ObjectValueSource, in
+  // which case fv_ is unused.
+  std::shared_ptr<LazyFields> lazy_fields_;
+};
+
+/**
+ * Applies a batch of field updates to an ObjectValue in a single pass.
+ *
+ * The result is the same as applying each update in turn with
+ * `ObjectValue::Set` and `ObjectValue::Delete`, but each nested object along
+ * the updated paths is rebuilt only once, no matter how many of its fields
+ * change. Untouched fields are shared with the original object.
+ */
+class ObjectValueBuilder {
+ public:
+  explicit ObjectValueBuilder(ObjectValue base) : base_(std::move(base)) {
+  }
+
+  /**
+   * Sets the field at the given path to the given value. Any absent parent of
+   * the field will also be created accordingly.
+   */
+  ObjectValueBuilder& Set(const FieldPath& field_path, FieldValue value);
+
+  /** Deletes the field at the given path. */
+  ObjectValueBuilder& Delete(const FieldPath& field_path);
+
+  /** Returns the base object with all updates applied, in order. */
+  ObjectValue Build() const;
+
+ private:
+  struct Update {
+    FieldPath path;
+    // Absent for deletes.
+    absl::optional<FieldValue> value;
+  };
+
+  using Updates = std::vector<const Update*>;
+
+  /**
+   * Applies the given updates, whose paths all share their first `depth`
+   * segments and are longer than that, to the fields of the object at that
+   * common prefix.
+   */
+  static FieldValue::Map Apply(FieldValue::Map fields,
+                               const Updates& updates,
+                               size_t depth);
+
+  ObjectValue base_;
+  std::vector<Update> updates_;
 };
 
+#if __OBJC__
+/**
+ * Converts a value decoded by remote::Serializer to the equivalent
+ * FSTFieldValue, for code that still works with the Objective-C model.
+ * remote::Serializer never decodes references or server timestamps, so they
+ * aren't supported.
+ */
+FSTFieldValue* ToFSTFieldValue(const FieldValue& value);
+
+/** Converts an object decoded by remote::Serializer to an FSTObjectValue. */
+FSTObjectValue* ToFSTObjectValue(const ObjectValue& object);
+#endif  // __OBJC__
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
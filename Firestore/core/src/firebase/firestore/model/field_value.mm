@@ -16,8 +16,14 @@
 
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 
+#include <vector>
+
+#import "FIRGeoPoint.h"
+#import "FIRTimestamp.h"
 #import "Firestore/Source/Model/FSTFieldValue.h"
 
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+
 namespace firebase {
 namespace firestore {
 namespace model {
@@ -26,6 +32,74 @@ FSTFieldValue* FieldValue::Wrap() && {
   return [FSTDelegateValue delegateWithValue:std::move(*this)];
 }
 
+FSTFieldValue* ToFSTFieldValue(const FieldValue& value) {
+  switch (value.type()) {
+    case FieldValue::Type::Null:
+      return [FSTNullValue nullValue];
+
+    case FieldValue::Type::Boolean:
+    case FieldValue::Type::String:
+      return FieldValue{value}.Wrap();
+
+    case FieldValue::Type::Integer:
+      return [FSTIntegerValue integerValue:value.integer_value()];
+
+    case FieldValue::Type::Double:
+      return [FSTDoubleValue doubleValue:value.double_value()];
+
+    case FieldValue::Type::Timestamp: {
+      Timestamp timestamp = value.timestamp_value();
+      return [FSTTimestampValue
+          timestampValue:[FIRTimestamp
+                             timestampWithSeconds:timestamp.seconds()
+                                      nanoseconds:timestamp.nanoseconds()]];
+    }
+
+    case FieldValue::Type::Blob: {
+      const std::vector<uint8_t>& blob = value.blob_value();
+      return [FSTBlobValue blobValue:[NSData dataWithBytes:blob.data()
+                                                    length:blob.size()]];
+    }
+
+    case FieldValue::Type::GeoPoint: {
+      const GeoPoint& point = value.geo_point_value();
+      return [FSTGeoPointValue
+          geoPointValue:[[FIRGeoPoint alloc]
+                            initWithLatitude:point.latitude()
+                                   longitude:point.longitude()]];
+    }
+
+    case FieldValue::Type::Array: {
+      const std::vector<FieldValue>& elements = value.array_value();
+      NSMutableArray<FSTFieldValue*>* array =
+          [NSMutableArray arrayWithCapacity:elements.size()];
+      for (const FieldValue& element : elements) {
+        [array addObject:ToFSTFieldValue(element)];
+      }
+      return [[FSTArrayValue alloc] initWithValueNoCopy:array];
+    }
+
+    case FieldValue::Type::Object:
+      return ToFSTObjectValue(ObjectValue(value));
+
+    case FieldValue::Type::Reference:
+    case FieldValue::Type::ServerTimestamp:
+      // remote::Serializer never decodes these.
+      HARD_FAIL("Unhandled type %s", static_cast<int>(value.type()));
+  }
+  UNREACHABLE();
+}
+
+FSTObjectValue* ToFSTObjectValue(const ObjectValue& object) {
+  const FieldValue::Map& fields = object.GetInternalValue();
+  NSMutableDictionary<NSString*, FSTFieldValue*>* dictionary =
+      [NSMutableDictionary dictionaryWithCapacity:fields.size()];
+  for (const auto& kv : fields) {
+    dictionary[util::WrapNSString(kv.first)] = ToFSTFieldValue(kv.second);
+  }
+  return [[FSTObjectValue alloc] initWithDictionary:dictionary];
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
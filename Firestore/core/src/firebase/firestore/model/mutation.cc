@@ -158,17 +158,18 @@ ObjectValue PatchMutation::PatchDocument(const MaybeDocument* maybe_doc) const {
 }
 
 ObjectValue PatchMutation::PatchObject(ObjectValue obj) const {
+  ObjectValueBuilder builder{std::move(obj)};
   for (const FieldPath& path : mask_) {
     if (!path.empty()) {
       absl::optional<FieldValue> new_value = value_.Get(path);
       if (!new_value) {
-        obj = obj.Delete(path);
+        builder.Delete(path);
       } else {
-        obj = obj.Set(path, *new_value);
+        builder.Set(path, *std::move(new_value));
       }
     }
   }
-  return obj;
+  return builder.Build();
 }
 
 bool PatchMutation::equal_to(const Mutation& other) const {
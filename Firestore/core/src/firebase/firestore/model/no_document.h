@@ -30,10 +30,14 @@ class NoDocument : public MaybeDocument {
              SnapshotVersion version,
              bool has_committed_mutations);
 
-  bool HasPendingWrites() const override {
+  bool HasCommittedMutations() const {
     return has_committed_mutations_;
   }
 
+  bool HasPendingWrites() const override {
+    return HasCommittedMutations();
+  }
+
  private:
   bool has_committed_mutations_;
 };
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/path_interner.h"
+
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+struct PathInterner::Node {
+  Node* parent = nullptr;
+
+  // Points into `segments_`; null for the root.
+  const std::string* segment = nullptr;
+
+  // Children are keyed by their interned segment, so lookups hash a pointer
+  // rather than a string.
+  std::unordered_map<const std::string*, std::unique_ptr<Node>> children;
+
+  std::weak_ptr<const ResourcePath> path;
+
+  // The number of paths created for this node that haven't been released yet.
+  // The node can't be removed while any are outstanding, even if `path` has
+  // already expired.
+  int pending_paths = 0;
+};
+
+class PathInterner::Deleter {
+ public:
+  Deleter(PathInterner* interner, Node* node)
+      : interner_{interner}, node_{node} {
+  }
+
+  void operator()(const ResourcePath* path) const {
+    delete path;
+    interner_->Release(node_);
+  }
+
+ private:
+  PathInterner* interner_ = nullptr;
+  Node* node_ = nullptr;
+};
+
+PathInterner::PathInterner() : root_{new Node{}} {
+}
+
+PathInterner::~PathInterner() = default;
+
+PathInterner& PathInterner::Default() {
+  static PathInterner* interner = new PathInterner();
+  return *interner;
+}
+
+std::shared_ptr<const ResourcePath> PathInterner::Intern(ResourcePath&& path) {
+  Guard lock{mutex_};
+
+  Node* node = root_.get();
+  for (const std::string& segment : path) {
+    const std::string* interned = nullptr;
+    auto found_segment = segments_.find(segment);
+    if (found_segment != segments_.end()) {
+      interned = &found_segment->first;
+      auto found_child = node->children.find(interned);
+      if (found_child != node->children.end()) {
+        node = found_child->second.get();
+        continue;
+      }
+      ++found_segment->second;
+    } else {
+      interned = &segments_.emplace(segment, 1).first->first;
+    }
+
+    std::unique_ptr<Node> child{new Node{}};
+    child->parent = node;
+    child->segment = interned;
+    Node* next = child.get();
+    node->children.emplace(interned, std::move(child));
+    ++node_count_;
+    node = next;
+  }
+
+  std::shared_ptr<const ResourcePath> result = node->path.lock();
+  if (!result) {
+    result = std::shared_ptr<const ResourcePath>(
+        new ResourcePath(std::move(path)), Deleter{this, node});
+    node->path = result;
+    ++node->pending_paths;
+  }
+  return result;
+}
+
+void PathInterner::Release(Node* node) {
+  Guard lock{mutex_};
+
+  --node->pending_paths;
+  HARD_ASSERT(node->pending_paths >= 0, "Path released more than once");
+
+  // Remove the node and any ancestors that no longer lead to a live path.
+  while (node != root_.get() && node->pending_paths == 0 &&
+         node->children.empty()) {
+    Node* parent = node->parent;
+    const std::string* segment = node->segment;
+
+    parent->children.erase(segment);  // Deletes `node`.
+    --node_count_;
+
+    auto found_segment = segments_.find(*segment);
+    if (--found_segment->second == 0) {
+      segments_.erase(found_segment);
+    }
+
+    node = parent;
+  }
+}
+
+size_t PathInterner::segment_count() const {
+  Guard lock{mutex_};
+  return segments_.size();
+}
+
+size_t PathInterner::node_count() const {
+  Guard lock{mutex_};
+  return node_count_;
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
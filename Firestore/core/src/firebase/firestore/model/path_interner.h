@@ -0,0 +1,91 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_PATH_INTERNER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_PATH_INTERNER_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+/**
+ * Deduplicates `ResourcePath`s so that all live document keys for the same
+ * document share a single immutable path.
+ *
+ * Paths are indexed by a trie of segments, where every node points to its
+ * parent. The trie stores each distinct segment only once, in a segment table,
+ * so the cost of the index grows with the number of distinct segments rather
+ * than with the number of keys. Nodes are removed once the last path interned
+ * through them is destroyed.
+ *
+ * `PathInterner` is thread-safe.
+ */
+class PathInterner {
+ public:
+  PathInterner();
+  ~PathInterner();
+
+  PathInterner(const PathInterner&) = delete;
+  PathInterner& operator=(const PathInterner&) = delete;
+
+  /**
+   * Returns the interner shared by all `DocumentKey`s. It's never destroyed,
+   * so interned paths may outlive static destruction.
+   */
+  static PathInterner& Default();
+
+  /**
+   * Returns the interned instance of the given path, creating it if no live
+   * path with the same segments exists.
+   */
+  std::shared_ptr<const ResourcePath> Intern(ResourcePath&& path);
+
+  /** The number of distinct segments currently in the segment table. */
+  size_t segment_count() const;
+
+  /** The number of trie nodes currently allocated, excluding the root. */
+  size_t node_count() const;
+
+ private:
+  struct Node;
+  class Deleter;
+
+  /** Called once an interned path created for `node` is destroyed. */
+  void Release(Node* node);
+
+  using Guard = std::lock_guard<std::mutex>;
+
+  mutable std::mutex mutex_;
+
+  // Maps each segment to the number of trie nodes using it.
+  std::unordered_map<std::string, size_t> segments_;
+  std::unique_ptr<Node> root_;
+  size_t node_count_ = 0;
+};
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_PATH_INTERNER_H_
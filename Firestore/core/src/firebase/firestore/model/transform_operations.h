@@ -21,6 +21,7 @@
 #error "This header only supports Objective-C++."
 #endif  // !defined(__OBJC__)
 
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -28,6 +29,7 @@
 
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "absl/memory/memory.h"
 
 namespace firebase {
 namespace firestore {
@@ -72,6 +74,15 @@ class TransformOperation {
   /** Returns whether this field transform is idempotent. */
   virtual bool idempotent() const = 0;
 
+  /**
+   * Returns a single operation with the same effect as applying this operation
+   * and then `next` to a field, or nullptr if the two can't be combined.
+   */
+  virtual std::unique_ptr<TransformOperation> CoalescedWith(
+      const TransformOperation& /* next */) const {
+    return nullptr;
+  }
+
   /** Returns whether the two are equal. */
   virtual bool operator==(const TransformOperation& other) const = 0;
 
@@ -169,6 +180,19 @@ class ArrayTransform : public TransformOperation {
     return true;
   }
 
+  std::unique_ptr<TransformOperation> CoalescedWith(
+      const TransformOperation& next) const override {
+    // Adding (or removing) the elements of one operation and then those of the
+    // next is the same as doing it for all of them in order.
+    if (next.type() != type_) {
+      return nullptr;
+    }
+    std::vector<FSTFieldValue*> elements = elements_;
+    const std::vector<FSTFieldValue*>& next_elements = Elements(next);
+    elements.insert(elements.end(), next_elements.begin(), next_elements.end());
+    return absl::make_unique<ArrayTransform>(type_, std::move(elements));
+  }
+
   bool operator==(const TransformOperation& other) const override {
     if (other.type() != type()) {
       return false;
@@ -295,6 +319,33 @@ class NumericIncrementTransform : public TransformOperation {
     return false;
   }
 
+  /**
+   * Combines two integer increments of the same sign whose sum doesn't
+   * overflow, which are the cases where saturating at LONG_MAX/LONG_MIN gives
+   * the same result for the sum as for the two increments in turn.
+   */
+  std::unique_ptr<TransformOperation> CoalescedWith(
+      const TransformOperation& next) const override {
+    if (next.type() != Type::Increment) {
+      return nullptr;
+    }
+    FSTNumberValue* next_operand =
+        static_cast<const NumericIncrementTransform&>(next).operand_;
+    if (operand_.type != FieldValue::Type::Integer ||
+        next_operand.type != FieldValue::Type::Integer) {
+      return nullptr;
+    }
+
+    int64_t x = (static_cast<FSTIntegerValue*>(operand_)).internalValue;
+    int64_t y = (static_cast<FSTIntegerValue*>(next_operand)).internalValue;
+    if ((x < 0) != (y < 0) || (x > 0 && y > LONG_MAX - x) ||
+        (x < 0 && y < LONG_MIN - x)) {
+      return nullptr;
+    }
+    return absl::make_unique<NumericIncrementTransform>(
+        [FSTIntegerValue integerValue:x + y]);
+  }
+
   bool operator==(const TransformOperation& other) const override {
     if (other.type() != type()) {
       return false;
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/nanopb/arena.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/nanopb_system_header.h"
+#include "Firestore/core/src/firebase/firestore/util/allocation_counters.h"
+#include "absl/base/config.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+namespace {
+
+constexpr size_t kAlignment = alignof(std::max_align_t);
+
+constexpr size_t RoundUp(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+/** Every allocation is preceded by its size, for Reallocate to copy. */
+constexpr size_t kHeaderSize = RoundUp(sizeof(size_t));
+
+size_t& AllocationSize(void* ptr) {
+  return *reinterpret_cast<size_t*>(static_cast<char*>(ptr) - kHeaderSize);
+}
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+Arena*& CurrentArena() {
+  static thread_local Arena* current_arena = nullptr;
+  return current_arena;
+}
+#endif
+
+}  // namespace
+
+constexpr size_t Arena::kDefaultBlockSize;
+
+Arena::Arena(size_t initial_block_size)
+    : next_block_size_{RoundUp(initial_block_size)} {
+}
+
+void* Arena::Allocate(size_t size) {
+  if (size > SIZE_MAX - kHeaderSize - kAlignment) {
+    return nullptr;
+  }
+  size_t needed = kHeaderSize + RoundUp(size);
+  if (blocks_.empty() ||
+      blocks_.back().size - blocks_.back().used < needed) {
+    if (!AddBlock(needed)) {
+      return nullptr;
+    }
+  }
+
+  Block& block = blocks_.back();
+  void* result = block.data.get() + block.used + kHeaderSize;
+  block.used += needed;
+  AllocationSize(result) = size;
+  last_allocation_ = result;
+  return result;
+}
+
+void* Arena::Reallocate(void* ptr, size_t size) {
+  if (ptr == nullptr) {
+    return Allocate(size);
+  }
+
+  size_t old_size = AllocationSize(ptr);
+  if (size <= old_size) {
+    return ptr;
+  }
+
+  if (ptr == last_allocation_ && size <= SIZE_MAX - kAlignment) {
+    // Repeated fields grow one element at a time; extend them in place.
+    Block& block = blocks_.back();
+    size_t extra = RoundUp(size) - RoundUp(old_size);
+    if (block.size - block.used >= extra) {
+      block.used += extra;
+      AllocationSize(ptr) = size;
+      return ptr;
+    }
+  }
+
+  void* result = Allocate(size);
+  if (result != nullptr) {
+    std::memcpy(result, ptr, old_size);
+  }
+  return result;
+}
+
+bool Arena::Owns(const void* ptr) const {
+  auto address = static_cast<const char*>(ptr);
+  for (const Block& block : blocks_) {
+    const char* begin = block.data.get();
+    if (address >= begin && address < begin + block.used) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Arena::AddBlock(size_t min_size) {
+  size_t size = next_block_size_ < min_size ? min_size : next_block_size_;
+  Block block;
+  block.data.reset(new (std::nothrow) char[size]);
+  if (!block.data) {
+    return false;
+  }
+  block.size = size;
+  blocks_.push_back(std::move(block));
+
+  if (next_block_size_ <= SIZE_MAX / 2) {
+    next_block_size_ *= 2;
+  }
+  return true;
+}
+
+ArenaScope::ArenaScope(Arena* arena) {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  previous_ = CurrentArena();
+  CurrentArena() = arena;
+#else
+  (void)arena;
+#endif
+}
+
+ArenaScope::~ArenaScope() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  CurrentArena() = previous_;
+#endif
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+void* firebase_firestore_nanopb_realloc(void* ptr, size_t size) {
+  // Growing an array counts as an allocation of its new size, whether or not
+  // it moves.
+  firebase::firestore::util::CountAllocation(
+      firebase::firestore::util::AllocationSubsystem::kNanopb, size);
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  using firebase::firestore::nanopb::Arena;
+  using firebase::firestore::nanopb::CurrentArena;
+
+  Arena* arena = CurrentArena();
+  if (arena != nullptr && (ptr == nullptr || arena->Owns(ptr))) {
+    return arena->Reallocate(ptr, size);
+  }
+#endif
+  return std::realloc(ptr, size);
+}
+
+void firebase_firestore_nanopb_free(void* ptr) {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  using firebase::firestore::nanopb::Arena;
+  using firebase::firestore::nanopb::CurrentArena;
+
+  // Memory allocated from an arena is only freed with the arena.
+  Arena* arena = CurrentArena();
+  if (arena != nullptr && arena->Owns(ptr)) {
+    return;
+  }
+#endif
+  std::free(ptr);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_ARENA_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+/**
+ * A bump allocator for the memory nanopb allocates while decoding a message.
+ *
+ * With PB_ENABLE_MALLOC, nanopb allocates every string, bytes field and
+ * repeated field of a message separately, and pb_release() walks the whole
+ * message again to free them. Allocations made from an Arena are instead
+ * carved out of a few large blocks (the next one twice the size of the last),
+ * which are all freed at once when the arena is destroyed. Individual
+ * allocations are never freed.
+ *
+ * Arenas are not thread safe.
+ */
+class Arena {
+ public:
+  static constexpr size_t kDefaultBlockSize = 4096;
+
+  explicit Arena(size_t initial_block_size = kDefaultBlockSize);
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /**
+   * Returns `size` bytes of memory aligned for any type, or null if the
+   * memory could not be allocated.
+   */
+  void* Allocate(size_t size);
+
+  /**
+   * Like `realloc`: returns `size` bytes of memory that start with the
+   * contents of `ptr`, which must be null or have been allocated from this
+   * arena. Grows the most recent allocation in place if possible.
+   */
+  void* Reallocate(void* ptr, size_t size);
+
+  /** Returns true if `ptr` points into memory allocated from this arena. */
+  bool Owns(const void* ptr) const;
+
+  /** The number of blocks requested from the system allocator. */
+  size_t block_count() const {
+    return blocks_.size();
+  }
+
+ private:
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t size = 0;
+    size_t used = 0;
+  };
+
+  bool AddBlock(size_t min_size);
+
+  std::vector<Block> blocks_;
+  size_t next_block_size_ = 0;
+
+  /** The most recent allocation, which Reallocate can grow in place. */
+  void* last_allocation_ = nullptr;
+};
+
+/**
+ * Directs the memory nanopb allocates on the current thread to `arena` for the
+ * lifetime of this object. A null arena leaves allocations to malloc.
+ *
+ * This only has an effect if nanopb was built with the allocator hooks in
+ * nanopb_system_header.h, and on platforms with `thread_local` (so not on
+ * iOS 8). Reader::UseArena checks both.
+ */
+class ArenaScope {
+ public:
+  explicit ArenaScope(Arena* arena);
+  ~ArenaScope();
+
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+ private:
+  Arena* previous_ = nullptr;
+};
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_ARENA_H_
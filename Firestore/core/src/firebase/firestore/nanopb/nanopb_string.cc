@@ -20,6 +20,7 @@
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
+#include "Firestore/core/src/firebase/firestore/util/allocation_counters.h"
 
 namespace firebase {
 namespace firestore {
@@ -38,8 +39,9 @@ String::~String() {
   // essentially just to make debugging easier--actual user data can have
   // embedded nulls so we shouldn't be using this as a C string under normal
   // circumstances.
-  auto result = static_cast<pb_bytes_array_t*>(
-      malloc(PB_BYTES_ARRAY_T_ALLOCSIZE(size) + 1));
+  size_t alloc_size = PB_BYTES_ARRAY_T_ALLOCSIZE(size) + 1;
+  util::CountAllocation(util::AllocationSubsystem::kNanopb, alloc_size);
+  auto result = static_cast<pb_bytes_array_t*>(malloc(alloc_size));
   result->size = size;
   memcpy(result->bytes, value.data(), size);
   result->bytes[size] = '\0';
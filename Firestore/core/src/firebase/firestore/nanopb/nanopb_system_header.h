@@ -0,0 +1,47 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_NANOPB_SYSTEM_HEADER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_NANOPB_SYSTEM_HEADER_H_
+
+// nanopb's PB_SYSTEM_HEADER in CMake builds (see the root CMakeLists.txt). It
+// includes the headers pb.h would include on its own, and routes nanopb's
+// allocations through hooks that serve them from the arena of the current
+// ArenaScope, if any.
+//
+// This header is also compiled as C, as part of nanopb itself.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void* firebase_firestore_nanopb_realloc(void* ptr, size_t size);
+void firebase_firestore_nanopb_free(void* ptr);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#define pb_realloc(ptr, size) firebase_firestore_nanopb_realloc(ptr, size)
+#define pb_free(ptr) firebase_firestore_nanopb_free(ptr)
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_NANOPB_SYSTEM_HEADER_H_
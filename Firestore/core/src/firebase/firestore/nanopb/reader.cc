@@ -16,6 +16,10 @@
 
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 
+#include <utility>
+
+#include "absl/base/config.h"
+
 namespace firebase {
 namespace firestore {
 namespace nanopb {
@@ -35,15 +39,27 @@ Reader Reader::Wrap(absl::string_view string_view) {
 void Reader::ReadNanopbMessage(const pb_field_t fields[], void* dest_struct) {
   if (!status_.ok()) return;
 
+  ArenaScope arena_scope{arena_.get()};
   if (!pb_decode(&stream_, fields, dest_struct)) {
     Fail(PB_GET_ERROR(&stream_));
   }
 }
 
 void Reader::FreeNanopbMessage(const pb_field_t fields[], void* dest_struct) {
+  if (arena_) return;
+
   pb_release(fields, dest_struct);
 }
 
+void Reader::UseArena(std::shared_ptr<Arena> arena) {
+#if defined(PB_SYSTEM_HEADER) && defined(ABSL_HAVE_THREAD_LOCAL)
+  arena_ = std::move(arena);
+#else
+  // nanopb allocates with malloc regardless.
+  (void)arena;
+#endif
+}
+
 }  // namespace nanopb
 }  // namespace firestore
 }  // namespace firebase
@@ -20,7 +20,10 @@
 #include <pb.h>
 #include <pb_decode.h>
 
+#include <memory>
+
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/arena.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "absl/strings/string_view.h"
 
@@ -58,6 +61,17 @@ class Reader {
    */
   static Reader Wrap(absl::string_view);
 
+  /**
+   * Creates a new Reader, based on the given nanopb pb_istream_t. Note that
+   * a shallow copy will be taken. (Non-null pointers within this struct must
+   * remain valid for the lifetime of this Reader.)
+   *
+   * This allows reading from input that isn't contiguous in memory, through
+   * the stream's callback.
+   */
+  explicit Reader(pb_istream_t stream) : stream_(stream) {
+  }
+
   /**
    * Reads a nanopb message from the input stream.
    *
@@ -67,6 +81,8 @@ class Reader {
    * Note that this allocates memory. You must call FreeNanopbMessage() (which
    * essentially wraps pb_release()) on the dest_struct in order to avoid memory
    * leaks. (This also implies code that uses this is not exception safe.)
+   *
+   * The memory comes from this Reader's arena, if it has one.
    */
   // TODO(rsgowman): At the moment we rely on the caller to manually free
   // dest_struct via FreeNanopbMessage(). We might instead see if we can
@@ -78,10 +94,30 @@ class Reader {
   /**
    * Release memory allocated by ReadNanopbMessage().
    *
-   * This essentially wraps calls to nanopb's pb_release() method.
+   * This essentially wraps calls to nanopb's pb_release() method. Messages
+   * decoded into an arena are left alone, since their memory is freed with
+   * the arena.
    */
   void FreeNanopbMessage(const pb_field_t fields[], void* dest_struct);
 
+  /**
+   * Makes ReadNanopbMessage() allocate from `arena` rather than with malloc,
+   * which turns the many small allocations of a large message into a few
+   * large ones and makes freeing it nearly free.
+   *
+   * This has no effect unless nanopb was built with the allocator hooks of
+   * nanopb_system_header.h, which CocoaPods builds are not; check arena()
+   * afterwards. Any part of a message decoded into the arena that outlives
+   * this Reader must share ownership of the arena, and must not be released
+   * with pb_release().
+   */
+  void UseArena(std::shared_ptr<Arena> arena);
+
+  /** The arena messages are decoded into, or null if they use malloc. */
+  const std::shared_ptr<Arena>& arena() const {
+    return arena_;
+  }
+
   util::Status status() const {
     return status_;
   }
@@ -103,17 +139,11 @@ class Reader {
   }
 
  private:
-  /**
-   * Creates a new Reader, based on the given nanopb pb_istream_t. Note that
-   * a shallow copy will be taken. (Non-null pointers within this struct must
-   * remain valid for the lifetime of this Reader.)
-   */
-  explicit Reader(pb_istream_t stream) : stream_(stream) {
-  }
-
   util::Status status_ = util::Status::OK();
 
   pb_istream_t stream_;
+
+  std::shared_ptr<Arena> arena_;
 };
 
 }  // namespace nanopb
@@ -29,51 +29,50 @@ namespace {
 const size_t kMaxDocumentSize = 1 * 1024 * 1024 - 4;
 
 /**
- * Creates a pb_ostream_t to the specified STL container. Note that this pointer
- * must remain valid for the lifetime of the stream.
+ * Appends `count` bytes to the specified STL container, which must be a
+ * `Container*`, and returns a pointer to the first of them.
  *
- * (This is roughly equivalent to the nanopb function pb_ostream_from_buffer().)
- *
- * @tparm Container an STL container whose value_type is a char type.
- * @param out_container where the output should be serialized to.
+ * @tparm Container an STL container of a char type with contiguous storage.
  */
 template <typename Container>
-pb_ostream_t WrapContainer(Container* out_container) {
-  // Construct a nanopb output stream.
-  //
-  // Set the max_size to be the max document size (as an upper bound; one would
-  // expect individual FieldValue's to be smaller than this).
-  //
-  // bytes_written is (always) initialized to 0. (NB: nanopb does not know or
-  // care about the underlying output vector, so where we are in the vector
-  // itself is irrelevant. i.e. don't use out_bytes->size())
-  return {/*callback=*/[](pb_ostream_t* stream, const pb_byte_t* buf,
-                          size_t count) -> bool {
-            auto* output = static_cast<Container*>(stream->state);
-            output->insert(output->end(), buf, buf + count);
-            return true;
-          },
-          /*state=*/out_container,
-          /*max_size=*/kMaxDocumentSize,
-          /*bytes_written=*/0,
-          /*errmsg=*/nullptr};
+pb_byte_t* GrowContainer(void* output, size_t count) {
+  auto* container = static_cast<Container*>(output);
+  size_t offset = container->size();
+  container->resize(offset + count);
+  return reinterpret_cast<pb_byte_t*>(&(*container)[0]) + offset;
 }
 
 }  // namespace
 
 Writer Writer::Wrap(std::vector<std::uint8_t>* out_bytes) {
-  return Writer{WrapContainer(out_bytes)};
+  return Writer{out_bytes, GrowContainer<std::vector<std::uint8_t>>};
 }
 
 Writer Writer::Wrap(std::string* out_string) {
-  return Writer{WrapContainer(out_string)};
+  return Writer{out_string, GrowContainer<std::string>};
 }
 
 void Writer::WriteNanopbMessage(const pb_field_t fields[],
                                 const void* src_struct) {
-  if (!pb_encode(&stream_, fields, src_struct)) {
-    HARD_FAIL(PB_GET_ERROR(&stream_));
+  size_t size = 0;
+  if (!pb_get_encoded_size(&size, fields, src_struct)) {
+    HARD_FAIL("Failed to compute the encoded size of a message");
+  }
+
+  // The max document size serves as an upper bound on everything written; one
+  // would expect individual FieldValues to be smaller than this.
+  if (size > kMaxDocumentSize - bytes_written_) {
+    HARD_FAIL("stream full");
+  }
+
+  if (size == 0) {
+    return;
+  }
+  pb_ostream_t stream = pb_ostream_from_buffer(grow_(output_, size), size);
+  if (!pb_encode(&stream, fields, src_struct)) {
+    HARD_FAIL(PB_GET_ERROR(&stream));
   }
+  bytes_written_ += size;
 }
 
 }  // namespace nanopb
@@ -20,6 +20,7 @@
 #include <pb.h>
 #include <pb_encode.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -29,8 +30,12 @@ namespace firestore {
 namespace nanopb {
 
 /**
- * Docs TODO(rsgowman). But currently, this just wraps the underlying nanopb
- * pb_ostream_t. All errors are considered fatal.
+ * Encodes nanopb messages, appending them to a container. All errors are
+ * considered fatal.
+ *
+ * Each message is encoded in two passes: the first computes its size, so that
+ * the container grows exactly once, and the second encodes the message
+ * straight into the new space.
  */
 class Writer {
  public:
@@ -59,22 +64,29 @@ class Writer {
   /**
    * Writes a nanopb message to the output stream.
    *
-   * This essentially wraps calls to nanopb's `pb_encode()` method. If we didn't
-   * use `oneof`s in our protos, this would be the primary way of encoding
-   * messages.
+   * This essentially wraps calls to nanopb's `pb_get_encoded_size()` and
+   * `pb_encode()` methods. If we didn't use `oneof`s in our protos, this would
+   * be the primary way of encoding messages.
    */
-  void WriteNanopbMessage(const pb_field_t fields[], const void* src_struct);
+  /**
+   * Grows the output by `count` bytes and returns a pointer to the first of
+   * them. The returned space only needs to be contiguous within one call.
+   */
+  using GrowFunction = pb_byte_t* (*)(void* output, size_t count);
 
- private:
   /**
-   * Creates a new Writer, based on the given nanopb pb_ostream_t. Note that
-   * a shallow copy will be taken. (Non-null pointers within this struct must
-   * remain valid for the lifetime of this Writer.)
+   * Creates a new Writer that appends to `output` by calling `grow`. Note that
+   * `output` must remain valid for the lifetime of this Writer.
    */
-  explicit Writer(const pb_ostream_t& stream) : stream_(stream) {
+  Writer(void* output, GrowFunction grow) : output_(output), grow_(grow) {
   }
 
-  pb_ostream_t stream_;
+  void WriteNanopbMessage(const pb_field_t fields[], const void* src_struct);
+
+ private:
+  void* output_;
+  GrowFunction grow_;
+  size_t bytes_written_ = 0;
 };
 
 }  // namespace nanopb
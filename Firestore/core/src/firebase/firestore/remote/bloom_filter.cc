@@ -0,0 +1,206 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
+
+#include <array>
+#include <utility>
+
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using util::Status;
+using util::StatusOr;
+using util::StringFormat;
+
+namespace {
+
+using Digest = std::array<uint8_t, 16>;
+
+uint32_t RotateLeft(uint32_t value, int bits) {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+/**
+ * Computes the MD5 digest of the given value (RFC 1321). MD5 is what the
+ * backend uses to populate the filter; it's not used for any security-related
+ * purpose.
+ */
+Digest Md5(absl::string_view value) {
+  static const uint32_t kSines[64] = {
+      0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+      0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+      0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+      0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+      0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+      0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+      0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+      0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+      0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+      0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+      0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+  static const int kShifts[64] = {
+      7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+      5, 9,  14, 20, 5, 9,  14, 20, 5, 9,  14, 20, 5, 9,  14, 20,
+      4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+      6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21};
+
+  // Pad the message with a single set bit, zeros and the original length in
+  // bits, so that the total length is a multiple of 64 bytes.
+  std::vector<uint8_t> message(value.begin(), value.end());
+  uint64_t bit_length = static_cast<uint64_t>(value.size()) * 8;
+  message.push_back(0x80);
+  while (message.size() % 64 != 56) {
+    message.push_back(0);
+  }
+  for (int i = 0; i != 8; ++i) {
+    message.push_back(static_cast<uint8_t>(bit_length >> (8 * i)));
+  }
+
+  uint32_t state[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+  for (size_t offset = 0; offset != message.size(); offset += 64) {
+    uint32_t words[16];
+    for (int i = 0; i != 16; ++i) {
+      const uint8_t* bytes = &message[offset + i * 4];
+      words[i] = static_cast<uint32_t>(bytes[0]) |
+                 static_cast<uint32_t>(bytes[1]) << 8 |
+                 static_cast<uint32_t>(bytes[2]) << 16 |
+                 static_cast<uint32_t>(bytes[3]) << 24;
+    }
+
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+    for (int i = 0; i != 64; ++i) {
+      uint32_t f = 0;
+      int g = 0;
+      if (i < 16) {
+        f = (b & c) | (~b & d);
+        g = i;
+      } else if (i < 32) {
+        f = (d & b) | (~d & c);
+        g = (5 * i + 1) % 16;
+      } else if (i < 48) {
+        f = b ^ c ^ d;
+        g = (3 * i + 5) % 16;
+      } else {
+        f = c ^ (b | ~d);
+        g = (7 * i) % 16;
+      }
+
+      uint32_t rotated = RotateLeft(a + f + kSines[i] + words[g], kShifts[i]);
+      a = d;
+      d = c;
+      c = b;
+      b += rotated;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+  }
+
+  Digest result;
+  for (int i = 0; i != 16; ++i) {
+    result[i] = static_cast<uint8_t>(state[i / 4] >> (8 * (i % 4)));
+  }
+  return result;
+}
+
+uint64_t ReadLittleEndian64(const uint8_t* bytes) {
+  uint64_t result = 0;
+  for (int i = 7; i >= 0; --i) {
+    result = (result << 8) | bytes[i];
+  }
+  return result;
+}
+
+}  // namespace
+
+StatusOr<BloomFilter> BloomFilter::Create(std::vector<uint8_t> bitmap,
+                                          int32_t padding,
+                                          int32_t hash_count) {
+  if (padding < 0 || padding >= 8) {
+    return Status{FirestoreErrorCode::InvalidArgument,
+                  StringFormat("Invalid bloom filter padding: %s", padding)};
+  }
+  if (hash_count < 0) {
+    return Status{
+        FirestoreErrorCode::InvalidArgument,
+        StringFormat("Invalid bloom filter hash count: %s", hash_count)};
+  }
+  if (bitmap.empty() && (padding != 0 || hash_count != 0)) {
+    return Status{FirestoreErrorCode::InvalidArgument,
+                  StringFormat("Empty bloom filter with padding %s and hash "
+                               "count %s",
+                               padding, hash_count)};
+  }
+  if (!bitmap.empty() && hash_count == 0) {
+    return Status{FirestoreErrorCode::InvalidArgument,
+                  "Non-empty bloom filter with a hash count of 0"};
+  }
+
+  auto bit_count = static_cast<int32_t>(bitmap.size() * 8) - padding;
+  return BloomFilter{std::move(bitmap), bit_count, hash_count};
+}
+
+BloomFilter::BloomFilter(std::vector<uint8_t> bitmap,
+                         int32_t bit_count,
+                         int32_t hash_count)
+    : bitmap_{std::move(bitmap)},
+      bit_count_{bit_count},
+      hash_count_{hash_count} {
+}
+
+bool BloomFilter::MightContain(absl::string_view value) const {
+  // An empty filter contains nothing.
+  if (bit_count_ == 0) {
+    return false;
+  }
+
+  Digest digest = Md5(value);
+  uint64_t hash1 = ReadLittleEndian64(&digest[0]);
+  uint64_t hash2 = ReadLittleEndian64(&digest[8]);
+  for (int32_t i = 0; i != hash_count_; ++i) {
+    // Unsigned overflow is well-defined and intended here.
+    uint64_t combined = hash1 + static_cast<uint64_t>(i) * hash2;
+    if (!IsBitSet(combined % static_cast<uint64_t>(bit_count_))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BloomFilter::IsBitSet(uint64_t index) const {
+  uint8_t byte = bitmap_[index / 8];
+  return (byte & (1 << (index % 8))) != 0;
+}
+
+bool operator==(const BloomFilter& lhs, const BloomFilter& rhs) {
+  return lhs.bit_count_ == rhs.bit_count_ &&
+         lhs.hash_count_ == rhs.hash_count_ && lhs.bitmap_ == rhs.bitmap_;
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
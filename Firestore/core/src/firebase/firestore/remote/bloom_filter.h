@@ -0,0 +1,84 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A bloom filter sent by the backend as part of an existence filter, holding
+ * the resource names of the documents that still match the target.
+ *
+ * The `bitmap` is a little-endian bit sequence whose last `padding` bits are
+ * unused. Each value is hashed with MD5, and the two little-endian 64-bit
+ * halves of the digest, `h1` and `h2`, produce the `hash_count` bit indices
+ * `(h1 + i * h2) % bit_count`, for `i` in `[0, hash_count)`.
+ */
+class BloomFilter {
+ public:
+  /**
+   * Creates a `BloomFilter` from the given wire representation, or returns an
+   * error if the representation is inconsistent.
+   */
+  static util::StatusOr<BloomFilter> Create(std::vector<uint8_t> bitmap,
+                                            int32_t padding,
+                                            int32_t hash_count);
+
+  /**
+   * Returns false if the value is definitely not in the filter; true if it
+   * might be (bloom filters have false positives, but no false negatives).
+   */
+  bool MightContain(absl::string_view value) const;
+
+  int32_t bit_count() const {
+    return bit_count_;
+  }
+  int32_t hash_count() const {
+    return hash_count_;
+  }
+
+  friend bool operator==(const BloomFilter& lhs, const BloomFilter& rhs);
+
+ private:
+  BloomFilter(std::vector<uint8_t> bitmap,
+              int32_t bit_count,
+              int32_t hash_count);
+
+  bool IsBitSet(uint64_t index) const;
+
+  std::vector<uint8_t> bitmap_;
+  int32_t bit_count_ = 0;
+  int32_t hash_count_ = 0;
+};
+
+inline bool operator!=(const BloomFilter& lhs, const BloomFilter& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
@@ -40,6 +40,29 @@ void ConnectivityMonitor::MaybeInvokeCallbacks(NetworkStatus new_status) {
   }
 }
 
+void ConnectivityMonitor::UpdateChannelState(size_t channel_index,
+                                             ChannelState new_state) {
+  if (channel_index >= channel_states_.size()) {
+    channel_states_.resize(channel_index + 1);
+  }
+  if (channel_states_[channel_index] == new_state) {
+    return;
+  }
+  channel_states_[channel_index] = new_state;
+
+  for (auto& callback : channel_state_callbacks_) {
+    callback(channel_index, new_state);
+  }
+}
+
+absl::optional<ConnectivityMonitor::ChannelState>
+ConnectivityMonitor::channel_state(size_t channel_index) const {
+  if (channel_index >= channel_states_.size()) {
+    return absl::nullopt;
+  }
+  return channel_states_[channel_index];
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
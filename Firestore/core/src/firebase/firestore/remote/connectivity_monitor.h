@@ -48,6 +48,20 @@ class ConnectivityMonitor {
 
   using Callback = std::function<void(NetworkStatus)>;
 
+  /**
+   * The state of one of the gRPC channels used to talk to the backend, as last
+   * observed by `GrpcConnection`. Mirrors `grpc_connectivity_state`.
+   */
+  enum class ChannelState {
+    Idle,
+    Connecting,
+    Ready,
+    TransientFailure,
+    Shutdown,
+  };
+
+  using ChannelStateCallback = std::function<void(size_t, ChannelState)>;
+
   /** Creates a platform-specific connectivity monitor. */
   static std::unique_ptr<ConnectivityMonitor> Create(
       util::AsyncQueue* worker_queue);
@@ -64,6 +78,34 @@ class ConnectivityMonitor {
   }
   // TODO(varconst): RemoveCallback.
 
+  /**
+   * Registers a callback to be invoked with the channel index and the new
+   * state whenever the state of a gRPC channel changes.
+   */
+  void AddChannelStateCallback(ChannelStateCallback&& callback) {
+    channel_state_callbacks_.push_back(std::move(callback));
+  }
+
+  /**
+   * Records the observed state of the gRPC channel with the given index,
+   * invoking the channel state callbacks if the state changed.
+   */
+  void UpdateChannelState(size_t channel_index, ChannelState new_state);
+
+  /**
+   * Returns the last observed state of the gRPC channel with the given index,
+   * if any.
+   */
+  absl::optional<ChannelState> channel_state(size_t channel_index) const;
+
+  /**
+   * Returns the current network status, or nothing if it hasn't been
+   * determined yet (or the platform doesn't report it).
+   */
+  absl::optional<NetworkStatus> status() const {
+    return status_;
+  }
+
  protected:
   // The status may be retrieved asynchronously.
   void SetInitialStatus(NetworkStatus new_status);
@@ -79,6 +121,9 @@ class ConnectivityMonitor {
   util::AsyncQueue* worker_queue_ = nullptr;
   std::vector<Callback> callbacks_;
   absl::optional<NetworkStatus> status_;
+
+  std::vector<ChannelStateCallback> channel_state_callbacks_;
+  std::vector<absl::optional<ChannelState>> channel_states_;
 };
 
 }  // namespace remote
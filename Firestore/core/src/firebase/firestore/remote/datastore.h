@@ -32,13 +32,16 @@
 #include "Firestore/core/src/firebase/firestore/auth/token.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/remote/decode_pool.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_call.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
+#include "Firestore/core/src/firebase/firestore/remote/rpc_metrics.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
 #include "Firestore/core/src/firebase/firestore/remote/write_stream.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/move_only_function.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "absl/strings/string_view.h"
@@ -81,11 +84,14 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   virtual ~Datastore() {
   }
 
-  /** Starts polling the gRPC completion queue. */
+  /** Starts polling the gRPC completion queues. */
   void Start();
-  /** Cancels any pending gRPC calls and drains the gRPC completion queue. */
+  /** Cancels any pending gRPC calls and drains the gRPC completion queues. */
   void Shutdown();
 
+  /** Connects to the backend ahead of the first RPC. */
+  void WarmUpConnection();
+
   /**
    * Creates a new `WatchStream` that is still unstarted but uses a common
    * shared channel.
@@ -101,8 +107,8 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
 
   void CommitMutations(const std::vector<FSTMutation*>& mutations,
                        CommitCallback&& callback);
-  void LookupDocuments(const std::vector<model::DocumentKey>& keys,
-                       LookupCallback&& callback);
+  virtual void LookupDocuments(const std::vector<model::DocumentKey>& keys,
+                               LookupCallback&& callback);
 
   /** Returns true if the given error is a gRPC ABORTED error. */
   static bool IsAbortedError(const util::Status& status);
@@ -133,6 +139,23 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   static std::string GetWhitelistedHeadersAsString(
       const GrpcCall::Metadata& headers);
 
+  const core::DatabaseInfo& database_info() const {
+    return *database_info_;
+  }
+
+  /**
+   * The traffic statistics of the RPCs made through this `Datastore`. Safe to
+   * read from any thread.
+   */
+  const RpcMetrics& rpc_metrics() const {
+    return rpc_metrics_;
+  }
+
+  /** The executors used to process responses off the worker queue. */
+  DecodePool* decode_pool() {
+    return &decode_pool_;
+  }
+
   Datastore(const Datastore& other) = delete;
   Datastore(Datastore&& other) = delete;
   Datastore& operator=(const Datastore& other) = delete;
@@ -147,7 +170,8 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
 
   /** Test-only method */
   grpc::CompletionQueue* grpc_queue() {
-    return &grpc_queue_;
+    // Unary calls always use the first queue.
+    return grpc_queues_.front().get();
   }
   /** Test-only method */
   GrpcCall* LastCall() {
@@ -160,23 +184,25 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   }
 
  private:
-  void PollGrpcQueue();
-
-  void CommitMutationsWithCredentials(
-      const auth::Token& token,
-      const std::vector<FSTMutation*>& mutations,
-      CommitCallback&& callback);
-
-  void LookupDocumentsWithCredentials(
-      const auth::Token& token,
-      const std::vector<model::DocumentKey>& keys,
-      LookupCallback&& callback);
+  void PollGrpcQueue(size_t index);
+
+  // The request messages are serialized before waiting for the credentials,
+  // so that the continuation only has to carry the (cheaply copied) message
+  // rather than the mutations or keys it was built from.
+  void CommitMutationsWithCredentials(const auth::Token& token,
+                                      grpc::ByteBuffer&& message,
+                                      CommitCallback&& callback);
+
+  void LookupDocumentsWithCredentials(const auth::Token& token,
+                                      grpc::ByteBuffer&& message,
+                                      LookupCallback&& callback);
   void OnLookupDocumentsResponse(
       const util::StatusOr<std::vector<grpc::ByteBuffer>>& result,
       const LookupCallback& callback);
 
-  using OnCredentials = std::function<void(const util::StatusOr<auth::Token>&)>;
-  void ResumeRpcWithCredentials(const OnCredentials& on_token);
+  using OnCredentials =
+      util::MoveOnlyFunction<void(const util::StatusOr<auth::Token>&)>;
+  void ResumeRpcWithCredentials(OnCredentials&& on_credentials);
 
   void HandleCallStatus(const util::Status& status);
 
@@ -189,19 +215,26 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   // down.
   bool is_shut_down_ = false;
 
+  const core::DatabaseInfo* database_info_ = nullptr;
   util::AsyncQueue* worker_queue_ = nullptr;
   auth::CredentialsProvider* credentials_ = nullptr;
 
-  // A separate executor dedicated to polling gRPC completion queue (which is
-  // shared for all spawned gRPC streams and calls).
-  std::unique_ptr<util::Executor> rpc_executor_;
-  grpc::CompletionQueue grpc_queue_;
+  // Separate executors dedicated to polling gRPC completion queues, one per
+  // queue. `GrpcConnection` spreads streams across the queues, so that e.g.
+  // decoding a large watch response doesn't hold up the write stream; unary
+  // calls share the first queue.
+  std::vector<std::unique_ptr<util::Executor>> rpc_executors_;
+  std::vector<std::unique_ptr<grpc::CompletionQueue>> grpc_queues_;
+  // Decodes watch stream responses in parallel, off the polling threads.
+  DecodePool decode_pool_;
   // TODO(varconst): move `ConnectivityMonitor` to `FSTFirestoreClient`.
   std::unique_ptr<ConnectivityMonitor> connectivity_monitor_;
   GrpcConnection grpc_connection_;
 
   std::vector<std::unique_ptr<GrpcCall>> active_calls_;
   bridge::DatastoreSerializer serializer_bridge_;
+
+  RpcMetrics rpc_metrics_;
 };
 
 }  // namespace remote
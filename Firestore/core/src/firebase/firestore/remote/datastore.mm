@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/datastore.h"
 
+#include <chrono>  // NOLINT(build/c++11)
+#include <functional>
 #include <unordered_set>
 #include <utility>
 
@@ -39,6 +41,7 @@
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "Firestore/core/src/firebase/firestore/util/task.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 
@@ -51,6 +54,7 @@ using auth::Token;
 using core::DatabaseInfo;
 using model::DocumentKey;
 using util::AsyncQueue;
+using util::Promise;
 using util::Status;
 using util::StatusOr;
 using util::Executor;
@@ -61,12 +65,54 @@ namespace {
 const auto kRpcNameCommit = "/google.firestore.v1.Firestore/Commit";
 const auto kRpcNameLookup = "/google.firestore.v1.Firestore/BatchGetDocuments";
 
-std::unique_ptr<Executor> CreateExecutor() {
-  auto queue = dispatch_queue_create("com.google.firebase.firestore.rpc",
-                                     DISPATCH_QUEUE_SERIAL);
+// The names under which `RpcMetrics` are recorded.
+const auto kMetricsNameListen = "Listen";
+const auto kMetricsNameWrite = "Write";
+const auto kMetricsNameCommit = "Commit";
+const auto kMetricsNameLookup = "BatchGetDocuments";
+
+// The number of gRPC completion queues, each polled on its own thread.
+const size_t kGrpcPollerCount = 2;
+// The number of threads decoding watch stream responses.
+const size_t kDecodeThreadCount = 2;
+
+std::unique_ptr<Executor> CreateExecutor(const char* label) {
+  auto queue = dispatch_queue_create(label, DISPATCH_QUEUE_SERIAL);
   return absl::make_unique<ExecutorLibdispatch>(queue);
 }
 
+std::vector<std::unique_ptr<Executor>> CreateExecutors(const char* label,
+                                                       size_t count) {
+  std::vector<std::unique_ptr<Executor>> result;
+  for (size_t i = 0; i != count; ++i) {
+    result.push_back(CreateExecutor(label));
+  }
+  return result;
+}
+
+std::vector<std::unique_ptr<grpc::CompletionQueue>> CreateGrpcQueues() {
+  std::vector<std::unique_ptr<grpc::CompletionQueue>> result;
+  for (size_t i = 0; i != kGrpcPollerCount; ++i) {
+    result.push_back(absl::make_unique<grpc::CompletionQueue>());
+  }
+  return result;
+}
+
+std::vector<grpc::CompletionQueue*> GetRawPointers(
+    const std::vector<std::unique_ptr<grpc::CompletionQueue>>& queues) {
+  std::vector<grpc::CompletionQueue*> result;
+  for (const auto& queue : queues) {
+    result.push_back(queue.get());
+  }
+  return result;
+}
+
+std::chrono::milliseconds ElapsedSince(
+    std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+}
+
 std::string MakeString(grpc::string_ref grpc_str) {
   return {grpc_str.begin(), grpc_str.size()};
 }
@@ -100,11 +146,17 @@ Datastore::Datastore(const DatabaseInfo& database_info,
                      AsyncQueue* worker_queue,
                      CredentialsProvider* credentials,
                      std::unique_ptr<ConnectivityMonitor> connectivity_monitor)
-    : worker_queue_{NOT_NULL(worker_queue)},
+    : database_info_{&database_info},
+      worker_queue_{NOT_NULL(worker_queue)},
       credentials_{credentials},
-      rpc_executor_{CreateExecutor()},
+      rpc_executors_{CreateExecutors("com.google.firebase.firestore.rpc",
+                                     kGrpcPollerCount)},
+      grpc_queues_{CreateGrpcQueues()},
+      decode_pool_{CreateExecutors("com.google.firebase.firestore.decode",
+                                   kDecodeThreadCount)},
       connectivity_monitor_{std::move(connectivity_monitor)},
-      grpc_connection_{database_info, worker_queue, &grpc_queue_,
+      grpc_connection_{database_info, worker_queue,
+                       GetRawPointers(grpc_queues_),
                        connectivity_monitor_.get()},
       serializer_bridge_{database_info} {
   if (!database_info.ssl_enabled()) {
@@ -113,7 +165,16 @@ Datastore::Datastore(const DatabaseInfo& database_info,
 }
 
 void Datastore::Start() {
-  rpc_executor_->Execute([this] { PollGrpcQueue(); });
+  for (size_t i = 0; i != rpc_executors_.size(); ++i) {
+    rpc_executors_[i]->Execute([this, i] { PollGrpcQueue(i); });
+  }
+}
+
+void Datastore::WarmUpConnection() {
+  if (is_shut_down_) {
+    return;
+  }
+  grpc_connection_.WarmUp();
 }
 
 void Datastore::Shutdown() {
@@ -126,21 +187,28 @@ void Datastore::Shutdown() {
 
   // `grpc::CompletionQueue::Next` will only return `false` once `Shutdown` has
   // been called and all submitted tags have been extracted. Without this call,
-  // `rpc_executor_` will never finish.
-  grpc_queue_.Shutdown();
-  // Drain the executor to make sure it extracted all the operations from gRPC
-  // completion queue.
-  rpc_executor_->ExecuteBlocking([] {});
+  // `rpc_executors_` will never finish.
+  for (const auto& grpc_queue : grpc_queues_) {
+    grpc_queue->Shutdown();
+  }
+  // Drain the executors to make sure they extracted all the operations from
+  // gRPC completion queues.
+  for (const auto& rpc_executor : rpc_executors_) {
+    rpc_executor->ExecuteBlocking([] {});
+  }
+  // The polling threads may have scheduled more decoding.
+  decode_pool_.Drain();
 }
 
-void Datastore::PollGrpcQueue() {
-  HARD_ASSERT(rpc_executor_->IsCurrentExecutor(),
+void Datastore::PollGrpcQueue(size_t index) {
+  HARD_ASSERT(rpc_executors_[index]->IsCurrentExecutor(),
               "PollGrpcQueue should only be called on the "
               "dedicated Datastore executor");
 
+  grpc::CompletionQueue* grpc_queue = grpc_queues_[index].get();
   void* tag = nullptr;
   bool ok = false;
-  while (grpc_queue_.Next(&tag, &ok)) {
+  while (grpc_queue->Next(&tag, &ok)) {
     auto completion = static_cast<GrpcCompletion*>(tag);
     // While it's valid in principle, we never deliberately pass a null pointer
     // to gRPC completion queue and expect it back. This assertion might be
@@ -152,50 +220,67 @@ void Datastore::PollGrpcQueue() {
 
 std::shared_ptr<WatchStream> Datastore::CreateWatchStream(
     WatchStreamCallback* callback) {
-  return std::make_shared<WatchStream>(worker_queue_, credentials_,
-                                       serializer_bridge_.GetSerializer(),
-                                       &grpc_connection_, callback);
+  auto stream = std::make_shared<WatchStream>(
+      worker_queue_, credentials_, serializer_bridge_.GetSerializer(),
+      &grpc_connection_, callback, &decode_pool_);
+  stream->SetRpcMetrics(&rpc_metrics_, kMetricsNameListen);
+  return stream;
 }
 
 std::shared_ptr<WriteStream> Datastore::CreateWriteStream(
     WriteStreamCallback* callback) {
-  return std::make_shared<WriteStream>(worker_queue_, credentials_,
-                                       serializer_bridge_.GetSerializer(),
-                                       &grpc_connection_, callback);
+  auto stream = std::make_shared<WriteStream>(
+      worker_queue_, credentials_, serializer_bridge_.GetSerializer(),
+      &grpc_connection_, callback);
+  stream->SetRpcMetrics(&rpc_metrics_, kMetricsNameWrite);
+  return stream;
 }
 
 void Datastore::CommitMutations(const std::vector<FSTMutation*>& mutations,
                                 CommitCallback&& callback) {
-  ResumeRpcWithCredentials(
-      // TODO(c++14): move into lambda.
-      [this, mutations,
-       callback](const StatusOr<Token>& maybe_credentials) mutable {
+  grpc::ByteBuffer message = serializer_bridge_.ToByteBuffer(
+      serializer_bridge_.CreateCommitRequest(mutations));
+  // TODO(c++14): move `message` and `callback` into lambda instead of binding
+  // them.
+  ResumeRpcWithCredentials(std::bind(
+      [this](grpc::ByteBuffer& bound_message,
+             CommitCallback& bound_callback,
+             const StatusOr<Token>& maybe_credentials) {
         if (!maybe_credentials.ok()) {
-          callback(maybe_credentials.status());
+          bound_callback(maybe_credentials.status());
           return;
         }
         CommitMutationsWithCredentials(maybe_credentials.ValueOrDie(),
-                                       mutations, std::move(callback));
-      });
+                                       std::move(bound_message),
+                                       std::move(bound_callback));
+      },
+      std::move(message), std::move(callback), std::placeholders::_1));
 }
 
-void Datastore::CommitMutationsWithCredentials(
-    const Token& token,
-    const std::vector<FSTMutation*>& mutations,
-    CommitCallback&& callback) {
-  grpc::ByteBuffer message = serializer_bridge_.ToByteBuffer(
-      serializer_bridge_.CreateCommitRequest(mutations));
+void Datastore::CommitMutationsWithCredentials(const Token& token,
+                                               grpc::ByteBuffer&& message,
+                                               CommitCallback&& callback) {
+  rpc_metrics_.RecordStart(kMetricsNameCommit);
+  rpc_metrics_.RecordMessageSent(kMetricsNameCommit, message.Length());
 
   std::unique_ptr<GrpcUnaryCall> call_owning = grpc_connection_.CreateUnaryCall(
       kRpcNameCommit, token, std::move(message));
   GrpcUnaryCall* call = call_owning.get();
   active_calls_.push_back(std::move(call_owning));
 
+  auto start_time = std::chrono::steady_clock::now();
   call->Start(
       // TODO(c++14): move into lambda.
-      [this, call, callback](const StatusOr<grpc::ByteBuffer>& result) {
+      [this, call, callback,
+       start_time](const StatusOr<grpc::ByteBuffer>& result) {
         LogGrpcCallFinished("CommitRequest", call, result.status());
         HandleCallStatus(result.status());
+        if (result.ok()) {
+          rpc_metrics_.RecordMessageReceived(kMetricsNameCommit,
+                                             result.ValueOrDie().Length());
+          rpc_metrics_.RecordLatency(kMetricsNameCommit,
+                                     ElapsedSince(start_time));
+        }
 
         // Response is deliberately ignored
         callback(result.status());
@@ -206,24 +291,30 @@ void Datastore::CommitMutationsWithCredentials(
 
 void Datastore::LookupDocuments(const std::vector<DocumentKey>& keys,
                                 LookupCallback&& callback) {
-  ResumeRpcWithCredentials(
-      // TODO(c++14): move into lambda.
-      [this, keys, callback](const StatusOr<Token>& maybe_credentials) mutable {
+  grpc::ByteBuffer message = serializer_bridge_.ToByteBuffer(
+      serializer_bridge_.CreateLookupRequest(keys));
+  // TODO(c++14): move `message` and `callback` into lambda instead of binding
+  // them.
+  ResumeRpcWithCredentials(std::bind(
+      [this](grpc::ByteBuffer& bound_message,
+             LookupCallback& bound_callback,
+             const StatusOr<Token>& maybe_credentials) {
         if (!maybe_credentials.ok()) {
-          callback({}, maybe_credentials.status());
+          bound_callback({}, maybe_credentials.status());
           return;
         }
-        LookupDocumentsWithCredentials(maybe_credentials.ValueOrDie(), keys,
-                                       std::move(callback));
-      });
+        LookupDocumentsWithCredentials(maybe_credentials.ValueOrDie(),
+                                       std::move(bound_message),
+                                       std::move(bound_callback));
+      },
+      std::move(message), std::move(callback), std::placeholders::_1));
 }
 
-void Datastore::LookupDocumentsWithCredentials(
-    const Token& token,
-    const std::vector<DocumentKey>& keys,
-    LookupCallback&& callback) {
-  grpc::ByteBuffer message = serializer_bridge_.ToByteBuffer(
-      serializer_bridge_.CreateLookupRequest(keys));
+void Datastore::LookupDocumentsWithCredentials(const Token& token,
+                                               grpc::ByteBuffer&& message,
+                                               LookupCallback&& callback) {
+  rpc_metrics_.RecordStart(kMetricsNameLookup);
+  rpc_metrics_.RecordMessageSent(kMetricsNameLookup, message.Length());
 
   std::unique_ptr<GrpcStreamingReader> call_owning =
       grpc_connection_.CreateStreamingReader(kRpcNameLookup, token,
@@ -231,11 +322,19 @@ void Datastore::LookupDocumentsWithCredentials(
   GrpcStreamingReader* call = call_owning.get();
   active_calls_.push_back(std::move(call_owning));
 
+  auto start_time = std::chrono::steady_clock::now();
   // TODO(c++14): move into lambda.
-  call->Start([this, call, callback](
+  call->Start([this, call, callback, start_time](
                   const StatusOr<std::vector<grpc::ByteBuffer>>& result) {
     LogGrpcCallFinished("BatchGetDocuments", call, result.status());
     HandleCallStatus(result.status());
+    if (result.ok()) {
+      for (const grpc::ByteBuffer& response : result.ValueOrDie()) {
+        rpc_metrics_.RecordMessageReceived(kMetricsNameLookup,
+                                           response.Length());
+      }
+      rpc_metrics_.RecordLatency(kMetricsNameLookup, ElapsedSince(start_time));
+    }
 
     OnLookupDocumentsResponse(result, callback);
 
@@ -258,31 +357,42 @@ void Datastore::OnLookupDocumentsResponse(
   callback(docs, parse_status);
 }
 
-void Datastore::ResumeRpcWithCredentials(const OnCredentials& on_credentials) {
+void Datastore::ResumeRpcWithCredentials(OnCredentials&& on_credentials) {
   // Auth may outlive Firestore
   std::weak_ptr<Datastore> weak_this{shared_from_this()};
 
+  // The credentials provider copies its callback, so it only gets the promise;
+  // `on_credentials`, which owns the request, waits on the task.
+  Promise<StatusOr<Token>> credentials;
+  // TODO(c++14): move `on_credentials` into lambda instead of binding it.
+  credentials.GetTask().Then(
+      worker_queue_,
+      std::bind(
+          [weak_this](const OnCredentials& bound_on_credentials,
+                      const StatusOr<Token>& result) {
+            auto strong_this = weak_this.lock();
+            if (!strong_this) {
+              return;
+            }
+            // In case Auth callback is invoked after Datastore has been shut
+            // down.
+            if (strong_this->is_shut_down_) {
+              return;
+            }
+
+            bound_on_credentials(result);
+          },
+          std::move(on_credentials), std::placeholders::_1));
+
   credentials_->GetToken(
-      [weak_this, on_credentials](const StatusOr<Token>& result) {
+      [weak_this, credentials](const StatusOr<Token>& result) {
+        // The worker queue can only be used while the Datastore is alive.
         auto strong_this = weak_this.lock();
         if (!strong_this) {
           return;
         }
 
-        strong_this->worker_queue_->EnqueueRelaxed(
-            [weak_this, result, on_credentials] {
-              auto strong_this = weak_this.lock();
-              if (!strong_this) {
-                return;
-              }
-              // In case Auth callback is invoked after Datastore has been shut
-              // down.
-              if (strong_this->is_shut_down_) {
-                return;
-              }
-
-              on_credentials(result);
-            });
+        credentials.SetValue(result);
       });
 }
 
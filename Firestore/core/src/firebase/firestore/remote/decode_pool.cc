@@ -0,0 +1,79 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/decode_pool.h"
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <mutex>               // NOLINT(build/c++11)
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using util::Executor;
+
+DecodePool::DecodePool(std::vector<std::unique_ptr<Executor>> executors)
+    : executors_{std::move(executors)} {
+  HARD_ASSERT(!executors_.empty(), "DecodePool requires at least one executor");
+}
+
+void DecodePool::Execute(Executor::Operation&& operation) {
+  size_t index = next_executor_.fetch_add(1) % executors_.size();
+  executors_[index]->Execute(std::move(operation));
+}
+
+void DecodePool::RunAll(std::vector<std::function<void()>>&& operations) {
+  if (operations.empty()) {
+    return;
+  }
+
+  struct Latch {
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t remaining = 0;
+  };
+  auto latch = std::make_shared<Latch>();
+  latch->remaining = operations.size() - 1;
+
+  for (size_t i = 1; i < operations.size(); ++i) {
+    std::function<void()> operation = std::move(operations[i]);
+    Execute([latch, operation] {
+      operation();
+      std::lock_guard<std::mutex> lock{latch->mutex};
+      if (--latch->remaining == 0) {
+        latch->done.notify_one();
+      }
+    });
+  }
+
+  operations.front()();
+
+  std::unique_lock<std::mutex> lock{latch->mutex};
+  latch->done.wait(lock, [&] { return latch->remaining == 0; });
+}
+
+void DecodePool::Drain() {
+  for (const auto& executor : executors_) {
+    executor->ExecuteBlocking([] {});
+  }
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
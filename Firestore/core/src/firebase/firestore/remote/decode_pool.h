@@ -0,0 +1,74 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_DECODE_POOL_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_DECODE_POOL_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A fixed number of executors used to decode messages received from the
+ * server in parallel, off both the worker queue and the gRPC polling threads,
+ * and to split up other CPU-bound processing of them.
+ *
+ * Operations are distributed across the executors in a round-robin fashion,
+ * so consecutive operations may run in parallel and finish in any order;
+ * callers that need to preserve ordering are responsible for reordering the
+ * results.
+ */
+class DecodePool {
+ public:
+  explicit DecodePool(std::vector<std::unique_ptr<util::Executor>> executors);
+
+  /**
+   * Schedules the `operation` to run on one of the executors. May be called
+   * from any thread.
+   */
+  void Execute(util::Executor::Operation&& operation);
+
+  /**
+   * Runs the `operations` in parallel and blocks until all of them have
+   * finished. The calling thread runs the first operation itself rather than
+   * sitting idle. Must not be called from one of the executors.
+   */
+  void RunAll(std::vector<std::function<void()>>&& operations);
+
+  /** Blocks until all previously scheduled operations have finished. */
+  void Drain();
+
+  size_t size() const {
+    return executors_.size();
+  }
+
+ private:
+  std::vector<std::unique_ptr<util::Executor>> executors_;
+  std::atomic<size_t> next_executor_{0};
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_DECODE_POOL_H_
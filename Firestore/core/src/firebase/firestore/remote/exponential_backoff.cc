@@ -17,6 +17,7 @@
 #include "Firestore/core/src/firebase/firestore/remote/exponential_backoff.h"
 
 #include <algorithm>
+#include <functional>
 #include <random>
 #include <utility>
 
@@ -52,7 +53,19 @@ ExponentialBackoff::ExponentialBackoff(AsyncQueue* queue,
               "Initial delay can't be greater than max delay");
 }
 
-void ExponentialBackoff::BackoffAndRun(AsyncQueue::Operation&& operation) {
+ExponentialBackoff::Milliseconds ExponentialBackoff::BackoffAndRun(
+    AsyncQueue::Operation&& operation) {
+  return Schedule(std::move(operation), /*escalate=*/true);
+}
+
+ExponentialBackoff::Milliseconds
+ExponentialBackoff::BackoffWithoutEscalationAndRun(
+    AsyncQueue::Operation&& operation) {
+  return Schedule(std::move(operation), /*escalate=*/false);
+}
+
+ExponentialBackoff::Milliseconds ExponentialBackoff::Schedule(
+    AsyncQueue::Operation&& operation, bool escalate) {
   Cancel();
 
   // First schedule the block using the current base (which may be 0 and should
@@ -76,16 +89,24 @@ void ExponentialBackoff::BackoffAndRun(AsyncQueue::Operation&& operation) {
         desired_delay_with_jitter.count(), delay_so_far.count());
   }
 
-  delayed_operation_ =
-      queue_->EnqueueAfterDelay(remaining_delay, timer_id_, [this, operation] {
-        last_attempt_time_ = chr::steady_clock::now();
-        operation();
-      });
+  // TODO(c++14): move `operation` into lambda instead of binding it.
+  delayed_operation_ = queue_->EnqueueAfterDelay(
+      remaining_delay, timer_id_,
+      std::bind(
+          [this](const AsyncQueue::Operation& bound) {
+            last_attempt_time_ = chr::steady_clock::now();
+            bound();
+          },
+          std::move(operation)));
 
   // Apply backoff factor to determine next delay, but ensure it is within
   // bounds.
-  current_base_ = ClampDelay(
-      chr::duration_cast<Milliseconds>(current_base_ * backoff_factor_));
+  if (escalate) {
+    current_base_ = ClampDelay(
+        chr::duration_cast<Milliseconds>(current_base_ * backoff_factor_));
+  }
+
+  return remaining_delay;
 }
 
 ExponentialBackoff::Milliseconds ExponentialBackoff::GetDelayWithJitter() {
@@ -83,8 +83,19 @@ class ExponentialBackoff {
    * Waits for `current_base` seconds (which may be zero), increases the delay
    * and runs the specified operation. If there was a pending operation waiting
    * to be run already, it will be canceled.
+   *
+   * Returns how long the operation will be delayed.
    */
-  void BackoffAndRun(util::AsyncQueue::Operation&& operation);
+  util::AsyncQueue::Milliseconds BackoffAndRun(
+      util::AsyncQueue::Operation&& operation);
+
+  /**
+   * Like `BackoffAndRun`, but leaves the delay of the following attempts as it
+   * is, e.g. while the network is known to be unavailable and failures don't
+   * say anything about the backend.
+   */
+  util::AsyncQueue::Milliseconds BackoffWithoutEscalationAndRun(
+      util::AsyncQueue::Operation&& operation);
 
   /** Cancels any pending backoff operation scheduled via `BackoffAndRun`. */
   void Cancel() {
@@ -94,6 +105,9 @@ class ExponentialBackoff {
  private:
   using Milliseconds = util::AsyncQueue::Milliseconds;
 
+  Milliseconds Schedule(util::AsyncQueue::Operation&& operation,
+                        bool escalate);
+
   // Returns a random value in the range [-current_base_/2, current_base_/2].
   Milliseconds GetDelayWithJitter();
   Milliseconds ClampDelay(Milliseconds delay) const;
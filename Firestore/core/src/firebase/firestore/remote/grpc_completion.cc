@@ -57,17 +57,26 @@ void GrpcCompletion::EnsureValidFuture() {
 }
 
 void GrpcCompletion::Complete(bool ok) {
+  // Decoding must happen while the completion is still considered to be on the
+  // queue: the decoder may reference the observer of the stream, which is only
+  // guaranteed to be valid until `off_queue_` is signaled.
+  if (ok && decoder_) {
+    decoded_ = decoder_(message_);
+  }
+
   // This mechanism allows `GrpcStream` to know when the completion is off the
   // gRPC completion queue (and thus no longer requires the underlying gRPC
   // objects to be valid).
   off_queue_.set_value();
 
-  worker_queue_->Enqueue([this, ok] {
-    if (callback_) {
-      callback_(ok, this);
-    }
-    delete this;
-  });
+  worker_queue_->Enqueue(AsyncQueue::Priority::Normal,
+                         [this, ok] {
+                           if (callback_) {
+                             callback_(ok, this);
+                           }
+                           delete this;
+                         },
+                         "GrpcCompletion");
 }
 
 }  // namespace remote
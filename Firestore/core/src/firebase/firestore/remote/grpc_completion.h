@@ -24,6 +24,7 @@
 
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "absl/types/any.h"
 #include "grpcpp/support/byte_buffer.h"
 
 namespace firebase {
@@ -47,6 +48,12 @@ namespace remote {
  * operation). The buffer and/or the status may be unused by the corresponding
  * gRPC operation.
  *
+ * Optionally, `GrpcCompletion` can also run a "decoder" function as soon as
+ * it is taken off the gRPC completion queue, on the polling thread. This
+ * allows expensive processing of the received message (like deserialization)
+ * to happen before the callback is scheduled on the worker queue. The result
+ * of decoding is made available to the callback via `decoded()`.
+ *
  * `GrpcCompletion` is "self-owned"; `GrpcCompletion` deletes itself in its
  * `Complete` method.
  *
@@ -70,6 +77,13 @@ class GrpcCompletion {
    */
   using Callback = std::function<void(bool, const GrpcCompletion*)>;
 
+  /**
+   * A function invoked on the gRPC polling thread with the received message,
+   * if the operation finished successfully. Its result is stored in the
+   * `GrpcCompletion` for the callback to use.
+   */
+  using Decoder = std::function<absl::any(const grpc::ByteBuffer&)>;
+
   GrpcCompletion(Type type,
                  util::AsyncQueue* firestore_queue,
                  Callback&& callback);
@@ -88,6 +102,15 @@ class GrpcCompletion {
 
   void Cancel();
 
+  /**
+   * Sets the function to run on the received message before the callback is
+   * scheduled. Must be called before the `GrpcCompletion` is put on the gRPC
+   * completion queue.
+   */
+  void SetDecoder(Decoder&& decoder) {
+    decoder_ = std::move(decoder);
+  }
+
   /**
    * Blocks until the `GrpcCompletion` comes back from the gRPC completion
    * queue. It is important to only call this function when the `GrpcCompletion`
@@ -109,6 +132,14 @@ class GrpcCompletion {
     return &status_;
   }
 
+  /**
+   * The result of running the decoder on the received message; empty if no
+   * decoder was set or the operation failed.
+   */
+  const absl::any& decoded() const {
+    return decoded_;
+  }
+
   Type type() const {
     return type_;
   }
@@ -116,6 +147,7 @@ class GrpcCompletion {
  private:
   util::AsyncQueue* worker_queue_ = nullptr;
   Callback callback_;
+  Decoder decoder_;
 
   void EnsureValidFuture();
 
@@ -126,6 +158,7 @@ class GrpcCompletion {
   // https://github.com/grpc/grpc/issues/13019#issuecomment-336932929, #5).
   grpc::ByteBuffer message_;
   grpc::Status status_;
+  absl::any decoded_;
 
   std::promise<void> off_queue_;
   std::future<void> off_queue_future_;
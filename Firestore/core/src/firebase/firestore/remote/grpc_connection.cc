@@ -17,8 +17,10 @@
 #include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
 
 #include <algorithm>
+#include <functional>
 #include <mutex>  // NOLINT(build/c++11)
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
@@ -31,6 +33,7 @@
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/string_format.h"
 #include "absl/memory/memory.h"
+#include "grpc/grpc_security.h"
 #include "grpcpp/create_channel.h"
 
 namespace firebase {
@@ -50,10 +53,45 @@ namespace {
 const char* const kXGoogAPIClientHeader = "x-goog-api-client";
 const char* const kGoogleCloudResourcePrefix = "google-cloud-resource-prefix";
 
+// gRPC shares connections between channels with identical arguments; an
+// argument unique to each channel in the pool makes it open its own.
+const char* const kChannelIndexArg = "firestore.channel_index";
+
 std::string MakeString(absl::string_view view) {
   return view.data() ? std::string{view.data(), view.size()} : std::string{};
 }
 
+grpc_compression_algorithm ToGrpcCompression(
+    core::MessageCompression compression) {
+  switch (compression) {
+    case core::MessageCompression::None:
+      return GRPC_COMPRESS_NONE;
+    case core::MessageCompression::Deflate:
+      return GRPC_COMPRESS_DEFLATE;
+    case core::MessageCompression::Gzip:
+      return GRPC_COMPRESS_GZIP;
+  }
+  UNREACHABLE();
+}
+
+ConnectivityMonitor::ChannelState ToChannelState(
+    grpc_connectivity_state state) {
+  using ChannelState = ConnectivityMonitor::ChannelState;
+  switch (state) {
+    case GRPC_CHANNEL_IDLE:
+      return ChannelState::Idle;
+    case GRPC_CHANNEL_CONNECTING:
+      return ChannelState::Connecting;
+    case GRPC_CHANNEL_READY:
+      return ChannelState::Ready;
+    case GRPC_CHANNEL_TRANSIENT_FAILURE:
+      return ChannelState::TransientFailure;
+    case GRPC_CHANNEL_SHUTDOWN:
+      return ChannelState::Shutdown;
+  }
+  UNREACHABLE();
+}
+
 std::shared_ptr<grpc::ChannelCredentials> CreateSslCredentials(
     const std::string& certificate) {
   grpc::SslCredentialsOptions options;
@@ -114,19 +152,125 @@ HostConfigMap& Config() {
   return config_by_host_;
 }
 
+/**
+ * The root certificates only have to be found and read once per process, not
+ * each time a channel is (re)created.
+ */
+const std::string& RootCertificate() {
+  static const std::string* root_certificate =
+      new std::string{LoadGrpcRootCertificate()};
+  return *root_certificate;
+}
+
+/**
+ * Makes the channel keep the TLS session tickets it's issued in a cache
+ * shared by all the channels of the process, so that a recreated channel (e.g.
+ * after a network change) resumes a session instead of doing a full handshake.
+ */
+void UseSharedSslSessionCache(grpc::ChannelArguments* args) {
+  // Never destroyed: channels may outlive any particular connection.
+  static grpc_ssl_session_cache* cache =
+      grpc_ssl_session_cache_create_lru(/*capacity=*/0);
+  grpc_arg arg = grpc_ssl_session_cache_create_channel_arg(cache);
+  args->SetPointerWithVtable(arg.key, arg.value.pointer.p,
+                             arg.value.pointer.vtable);
+}
+
+/**
+ * The channels of every `GrpcConnection` in the process, so that Firestore
+ * instances talking to the same host (e.g. for different projects) multiplex
+ * their calls over the same HTTP/2 connections instead of each opening their
+ * own. Nothing about a channel is specific to an instance: each call carries
+ * its own credentials and the database it's for in its metadata, and its own
+ * completion queue.
+ *
+ * Channels are held weakly, so a channel is closed once no connection uses it
+ * anymore.
+ */
+class SharedChannels {
+  using Guard = std::lock_guard<std::mutex>;
+
+ public:
+  /**
+   * Returns the live channel with the given key, or a new one created by
+   * `create` if there is none.
+   */
+  std::shared_ptr<grpc::Channel> Acquire(
+      const std::string& key,
+      const std::function<std::shared_ptr<grpc::Channel>()>& create) {
+    Guard guard{mutex_};
+    std::shared_ptr<grpc::Channel> channel = channels_[key].lock();
+    if (!channel ||
+        channel->GetState(/*try_to_connect=*/false) == GRPC_CHANNEL_SHUTDOWN) {
+      channel = create();
+      channels_[key] = channel;
+    }
+    return channel;
+  }
+
+  /**
+   * Makes the next `Acquire` with the given key create a new channel, unless
+   * some other channel replaced `channel` already.
+   */
+  void Forget(const std::string& key, const grpc::Channel* channel) {
+    Guard guard{mutex_};
+    auto found = channels_.find(key);
+    if (found != channels_.end()) {
+      std::shared_ptr<grpc::Channel> shared = found->second.lock();
+      if (!shared || shared.get() == channel) {
+        channels_.erase(found);
+      }
+    }
+  }
+
+ private:
+  std::unordered_map<std::string, std::weak_ptr<grpc::Channel>> channels_;
+  std::mutex mutex_;
+};
+
+SharedChannels& Channels() {
+  // Never destroyed: connections may be shut down during static destruction.
+  static SharedChannels* channels = new SharedChannels{};
+  return *channels;
+}
+
+std::string ChannelKey(const std::string& host, size_t channel_index) {
+  return StringFormat("%s#%s", host, channel_index);
+}
+
 }  // namespace
 
 GrpcConnection::GrpcConnection(const DatabaseInfo& database_info,
                                util::AsyncQueue* worker_queue,
                                grpc::CompletionQueue* grpc_queue,
                                ConnectivityMonitor* connectivity_monitor)
+    : GrpcConnection{database_info, worker_queue,
+                     std::vector<grpc::CompletionQueue*>{NOT_NULL(grpc_queue)},
+                     connectivity_monitor} {
+}
+
+GrpcConnection::GrpcConnection(const DatabaseInfo& database_info,
+                               util::AsyncQueue* worker_queue,
+                               std::vector<grpc::CompletionQueue*> grpc_queues,
+                               ConnectivityMonitor* connectivity_monitor)
     : database_info_{&database_info},
       worker_queue_{NOT_NULL(worker_queue)},
-      grpc_queue_{NOT_NULL(grpc_queue)},
+      grpc_queues_{std::move(grpc_queues)},
+      channels_(static_cast<size_t>(database_info.channel_count())),
       connectivity_monitor_{NOT_NULL(connectivity_monitor)} {
+  HARD_ASSERT(!grpc_queues_.empty(),
+              "GrpcConnection requires at least one completion queue");
   RegisterConnectivityMonitor();
 }
 
+void GrpcConnection::WarmUp() {
+  for (size_t i = 0; i != channels_.size(); ++i) {
+    EnsureActiveStub(i);
+    channels_[i].channel->GetState(/*try_to_connect=*/true);
+  }
+  LOG_DEBUG("Warming up %s gRPC channels.", channels_.size());
+}
+
 void GrpcConnection::Shutdown() {
   // Fast finish any pending calls. This will not trigger the observers.
   // Calls may unregister themselves on finish, so make a protective copy.
@@ -167,34 +311,55 @@ std::unique_ptr<grpc::ClientContext> GrpcConnection::CreateContext(
   return context;
 }
 
-void GrpcConnection::EnsureActiveStub() {
+grpc::GenericStub* GrpcConnection::EnsureActiveStub(size_t channel_index) {
+  Channel& pooled = channels_[channel_index];
   // TODO(varconst): find out in which cases a gRPC channel might shut down.
   // This might be overkill.
-  if (!grpc_channel_ || grpc_channel_->GetState(/*try_to_connect=*/false) ==
-                            GRPC_CHANNEL_SHUTDOWN) {
-    LOG_DEBUG("Creating Firestore stub.");
-    grpc_channel_ = CreateChannel();
-    grpc_stub_ = absl::make_unique<grpc::GenericStub>(grpc_channel_);
+  if (!pooled.channel || pooled.channel->GetState(/*try_to_connect=*/false) ==
+                             GRPC_CHANNEL_SHUTDOWN) {
+    LOG_DEBUG("Creating Firestore stub for channel %s.", channel_index);
+    pooled.channel =
+        Channels().Acquire(ChannelKey(database_info_->host(), channel_index),
+                           [&] { return CreateChannel(channel_index); });
+    pooled.stub = absl::make_unique<grpc::GenericStub>(pooled.channel);
   }
+  ReportChannelStates();
+  return pooled.stub.get();
 }
 
-std::shared_ptr<grpc::Channel> GrpcConnection::CreateChannel() const {
+void GrpcConnection::ReportChannelStates() {
+  for (size_t i = 0; i != channels_.size(); ++i) {
+    if (channels_[i].channel) {
+      grpc_connectivity_state state =
+          channels_[i].channel->GetState(/*try_to_connect=*/false);
+      connectivity_monitor_->UpdateChannelState(i, ToChannelState(state));
+    }
+  }
+}
+
+std::shared_ptr<grpc::Channel> GrpcConnection::CreateChannel(
+    size_t channel_index) const {
   const std::string& host = database_info_->host();
 
+  grpc::ChannelArguments args;
+  args.SetInt(kChannelIndexArg, static_cast<int>(channel_index));
+
   const HostConfig* host_config = Config().find(host);
   if (!host_config) {
-    std::string root_certificate = LoadGrpcRootCertificate();
-    return grpc::CreateChannel(host, CreateSslCredentials(root_certificate));
+    UseSharedSslSessionCache(&args);
+    return grpc::CreateCustomChannel(
+        host, CreateSslCredentials(RootCertificate()), args);
   }
 
   // For the case when `Settings.sslEnabled == false`.
   if (host_config->use_insecure_channel) {
-    return grpc::CreateChannel(host, grpc::InsecureChannelCredentials());
+    return grpc::CreateCustomChannel(host, grpc::InsecureChannelCredentials(),
+                                     args);
   }
 
   // For tests only
-  grpc::ChannelArguments args;
   args.SetSslTargetNameOverride(host_config->target_name);
+  UseSharedSslSessionCache(&args);
   Path path = host_config->certificate_path;
   StatusOr<std::string> test_certificate = ReadFile(path);
   HARD_ASSERT(test_certificate.ok(),
@@ -210,24 +375,35 @@ std::unique_ptr<GrpcStream> GrpcConnection::CreateStream(
     absl::string_view rpc_name,
     const Token& token,
     GrpcStreamObserver* observer) {
-  EnsureActiveStub();
+  size_t slot = SlotForStream(rpc_name);
+  grpc::GenericStub* stub = EnsureActiveStub(slot % channels_.size());
 
   auto context = CreateContext(token);
-  auto call =
-      grpc_stub_->PrepareCall(context.get(), MakeString(rpc_name), grpc_queue_);
-  return absl::make_unique<GrpcStream>(std::move(context), std::move(call),
-                                       worker_queue_, this, observer);
+  // Only streams are compressed: they carry the bulk of the traffic, and their
+  // messages can be individually exempted from compression when small. gRPC
+  // advertises the same algorithms for the responses.
+  if (database_info_->compression() != core::MessageCompression::None) {
+    context->set_compression_algorithm(
+        ToGrpcCompression(database_info_->compression()));
+  }
+  auto call = stub->PrepareCall(context.get(), MakeString(rpc_name),
+                                grpc_queues_[slot % grpc_queues_.size()]);
+  auto stream = absl::make_unique<GrpcStream>(
+      std::move(context), std::move(call), worker_queue_, this, observer);
+  stream->set_compression_threshold(
+      database_info_->compression_threshold_bytes());
+  return stream;
 }
 
 std::unique_ptr<GrpcUnaryCall> GrpcConnection::CreateUnaryCall(
     absl::string_view rpc_name,
     const Token& token,
     const grpc::ByteBuffer& message) {
-  EnsureActiveStub();
+  grpc::GenericStub* stub = EnsureActiveStub(0);
 
   auto context = CreateContext(token);
-  auto call = grpc_stub_->PrepareUnaryCall(context.get(), MakeString(rpc_name),
-                                           message, grpc_queue_);
+  auto call = stub->PrepareUnaryCall(context.get(), MakeString(rpc_name),
+                                     message, grpc_queues_.front());
   return absl::make_unique<GrpcUnaryCall>(std::move(context), std::move(call),
                                           worker_queue_, this, message);
 }
@@ -236,15 +412,28 @@ std::unique_ptr<GrpcStreamingReader> GrpcConnection::CreateStreamingReader(
     absl::string_view rpc_name,
     const Token& token,
     const grpc::ByteBuffer& message) {
-  EnsureActiveStub();
+  grpc::GenericStub* stub = EnsureActiveStub(0);
 
   auto context = CreateContext(token);
-  auto call =
-      grpc_stub_->PrepareCall(context.get(), MakeString(rpc_name), grpc_queue_);
+  auto call = stub->PrepareCall(context.get(), MakeString(rpc_name),
+                                grpc_queues_.front());
   return absl::make_unique<GrpcStreamingReader>(
       std::move(context), std::move(call), worker_queue_, this, message);
 }
 
+size_t GrpcConnection::SlotForStream(absl::string_view rpc_name) {
+  std::string name = MakeString(rpc_name);
+  auto found = stream_slots_.find(name);
+  if (found != stream_slots_.end()) {
+    return found->second;
+  }
+
+  // Leave the first slot to unary calls.
+  size_t slot = stream_slots_.size() + 1;
+  stream_slots_[name] = slot;
+  return slot;
+}
+
 void GrpcConnection::RegisterConnectivityMonitor() {
   connectivity_monitor_->AddCallback(
       [this](ConnectivityMonitor::NetworkStatus /*ignored*/) {
@@ -259,7 +448,18 @@ void GrpcConnection::RegisterConnectivityMonitor() {
         // connection before eventually failing. Note that gRPC Objective-C
         // client does the same thing:
         // https://github.com/grpc/grpc/blob/fe11db09575f2dfbe1f88cd44bd417acc168e354/src/objective-c/GRPCClient/private/GRPCHost.m#L309-L314
-        grpc_channel_.reset();
+        // Other connections sharing the channel drop it too, as they get
+        // notified of the same change; until then, it must not be handed out
+        // again.
+        for (size_t i = 0; i != channels_.size(); ++i) {
+          Channel& pooled = channels_[i];
+          if (pooled.channel) {
+            Channels().Forget(ChannelKey(database_info_->host(), i),
+                              pooled.channel.get());
+          }
+          pooled.stub.reset();
+          pooled.channel.reset();
+        }
       });
 }
 
@@ -271,6 +471,9 @@ void GrpcConnection::Unregister(GrpcCall* call) {
   auto found = std::find(active_calls_.begin(), active_calls_.end(), call);
   HARD_ASSERT(found != active_calls_.end(), "Missing a gRPC call");
   active_calls_.erase(found);
+
+  // A finished call is a good hint that a channel may have changed state.
+  ReportChannelStates();
 }
 
 /*static*/ void GrpcConnection::UseTestCertificate(
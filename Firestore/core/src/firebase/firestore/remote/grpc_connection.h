@@ -50,8 +50,21 @@ namespace remote {
 // implementations of a `Connection` under a single interface.
 
 /**
- * Creates and owns gRPC objects (channel and stub) necessary to produce a
+ * Creates and owns gRPC objects (channels and stubs) necessary to produce a
  * `GrpcStream`.
+ *
+ * `GrpcConnection` keeps a small pool of channels, as configured by
+ * `DatabaseInfo::channel_count`, each backed by its own HTTP/2 connection.
+ * Like completion queues, channels are assigned per RPC endpoint: unary calls
+ * and streaming readers use the first channel, and each stream endpoint gets
+ * the next one, so that e.g. a large watch response doesn't hold up a
+ * transaction's lookups. The observed state of each channel is reported to the
+ * `ConnectivityMonitor`.
+ *
+ * The channels themselves are shared by all the connections to the same host
+ * in the process, so that e.g. an app using several projects opens a single
+ * pool of HTTP/2 connections rather than one per Firestore instance. Streams
+ * and calls stay specific to each connection.
  */
 class GrpcConnection {
  public:
@@ -60,8 +73,24 @@ class GrpcConnection {
                  grpc::CompletionQueue* grpc_queue,
                  ConnectivityMonitor* connectivity_monitor);
 
+  /**
+   * Spreads streams across the given gRPC completion queues, each of which is
+   * expected to be polled on its own thread. Unary calls and streaming readers
+   * always use the first queue.
+   */
+  GrpcConnection(const core::DatabaseInfo& database_info,
+                 util::AsyncQueue* worker_queue,
+                 std::vector<grpc::CompletionQueue*> grpc_queues,
+                 ConnectivityMonitor* connectivity_monitor);
+
   void Shutdown();
 
+  /**
+   * Creates the channels and makes them connect (DNS, TCP and TLS) ahead of
+   * the first call, so that the call doesn't have to wait for it.
+   */
+  void WarmUp();
+
   /**
    * Creates a stream to the given stream RPC endpoint. The resulting stream
    * needs to be `Start`ed before it can be used.
@@ -85,6 +114,11 @@ class GrpcConnection {
   void Register(GrpcCall* call);
   void Unregister(GrpcCall* call);
 
+  /** The monitor whose network status changes reset this connection. */
+  ConnectivityMonitor* connectivity_monitor() const {
+    return connectivity_monitor_;
+  }
+
   /**
    * Don't use SSL, send all traffic unencrypted. Call before creating any
    * streams or calls.
@@ -102,17 +136,34 @@ class GrpcConnection {
  private:
   std::unique_ptr<grpc::ClientContext> CreateContext(
       const auth::Token& credential) const;
-  std::shared_ptr<grpc::Channel> CreateChannel() const;
-  void EnsureActiveStub();
+  struct Channel {
+    std::shared_ptr<grpc::Channel> channel;
+    std::unique_ptr<grpc::GenericStub> stub;
+  };
+
+  std::shared_ptr<grpc::Channel> CreateChannel(size_t channel_index) const;
+  grpc::GenericStub* EnsureActiveStub(size_t channel_index);
+
+  /** Reports the current state of all open channels to the monitor. */
+  void ReportChannelStates();
 
   void RegisterConnectivityMonitor();
 
+  /**
+   * Returns the index of the slot assigned to streams to the given RPC
+   * endpoint. Slot 0 is reserved for unary calls; each stream endpoint is
+   * assigned the next slot the first time it's used. Slots map onto completion
+   * queues and channels modulo their number, so that e.g. a busy watch stream
+   * doesn't delay the write stream as long as there are enough of them.
+   */
+  size_t SlotForStream(absl::string_view rpc_name);
+
   const core::DatabaseInfo* database_info_ = nullptr;
   util::AsyncQueue* worker_queue_ = nullptr;
-  grpc::CompletionQueue* grpc_queue_ = nullptr;
+  std::vector<grpc::CompletionQueue*> grpc_queues_;
+  std::unordered_map<std::string, size_t> stream_slots_;
 
-  std::shared_ptr<grpc::Channel> grpc_channel_;
-  std::unique_ptr<grpc::GenericStub> grpc_stub_;
+  std::vector<Channel> channels_;
 
   ConnectivityMonitor* connectivity_monitor_ = nullptr;
   std::vector<GrpcCall*> active_calls_;
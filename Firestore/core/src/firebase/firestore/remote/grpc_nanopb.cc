@@ -0,0 +1,101 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_nanopb.h"
+
+#include <grpc/slice.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using nanopb::Reader;
+using nanopb::Writer;
+
+namespace {
+
+pb_istream_t CreateStream(ByteBufferReader* state,
+                          bool (*read)(pb_istream_t*, pb_byte_t*, size_t),
+                          size_t length) {
+  pb_istream_t stream{};
+  stream.callback = read;
+  stream.state = state;
+  stream.bytes_left = length;
+  return stream;
+}
+
+}  // namespace
+
+ByteBufferReader::ByteBufferReader(const grpc::ByteBuffer& buffer)
+    : reader_{CreateStream(this, Read, buffer.Length())} {
+  // `Dump` only takes references to the slices of the buffer.
+  if (!buffer.Dump(&slices_).ok()) {
+    reader_.Fail("Unable to read the received message");
+  }
+}
+
+bool ByteBufferReader::Read(pb_istream_t* stream,
+                            pb_byte_t* out,
+                            size_t count) {
+  auto* self = static_cast<ByteBufferReader*>(stream->state);
+  while (count > 0) {
+    if (self->slice_index_ == self->slices_.size()) {
+      PB_RETURN_ERROR(stream, "end-of-stream");
+    }
+
+    const grpc::Slice& slice = self->slices_[self->slice_index_];
+    size_t n = std::min(count, slice.size() - self->slice_offset_);
+    if (out) {
+      std::memcpy(out, slice.begin() + self->slice_offset_, n);
+      out += n;
+    }
+    count -= n;
+    self->slice_offset_ += n;
+    if (self->slice_offset_ == slice.size()) {
+      ++self->slice_index_;
+      self->slice_offset_ = 0;
+    }
+  }
+  return true;
+}
+
+ByteBufferWriter::ByteBufferWriter() : writer_{&slices_, Grow} {
+}
+
+grpc::ByteBuffer ByteBufferWriter::Release() {
+  // The buffer takes its own references to the slices.
+  grpc::ByteBuffer result{slices_.data(), slices_.size()};
+  slices_.clear();
+  return result;
+}
+
+pb_byte_t* ByteBufferWriter::Grow(void* output, size_t count) {
+  auto* slices = static_cast<std::vector<grpc::Slice>*>(output);
+  // Small slices would otherwise be inlined into the `grpc_slice` struct
+  // itself, which doesn't stay put.
+  grpc_slice slice = grpc_slice_malloc_large(count);
+  pb_byte_t* start = GRPC_SLICE_START_PTR(slice);
+  slices->emplace_back(slice, grpc::Slice::STEAL_REF);
+  return start;
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
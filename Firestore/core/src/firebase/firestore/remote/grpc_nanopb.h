@@ -0,0 +1,100 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_NANOPB_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_NANOPB_H_
+
+#include <pb.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/slice.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * Decodes nanopb messages straight from the slices of a `grpc::ByteBuffer`,
+ * without first flattening them into one contiguous buffer.
+ *
+ * The slices are shared with the buffer rather than copied, so reading a large
+ * message only ever copies the bytes nanopb itself keeps.
+ */
+class ByteBufferReader {
+ public:
+  explicit ByteBufferReader(const grpc::ByteBuffer& buffer);
+
+  ByteBufferReader(const ByteBufferReader& other) = delete;
+  ByteBufferReader& operator=(const ByteBufferReader& other) = delete;
+
+  /**
+   * The reader to decode messages with. Its status is not ok if the buffer
+   * couldn't be read.
+   */
+  nanopb::Reader* reader() {
+    return &reader_;
+  }
+
+ private:
+  static bool Read(pb_istream_t* stream, pb_byte_t* out, size_t count);
+
+  std::vector<grpc::Slice> slices_;
+  size_t slice_index_ = 0;
+  size_t slice_offset_ = 0;
+  nanopb::Reader reader_;
+};
+
+/**
+ * Encodes nanopb messages into a `grpc::ByteBuffer`.
+ *
+ * Each message is encoded into a slice of its own, and the buffer is made out
+ * of those slices, so that the encoded bytes are never copied.
+ */
+class ByteBufferWriter {
+ public:
+  ByteBufferWriter();
+
+  ByteBufferWriter(const ByteBufferWriter& other) = delete;
+  ByteBufferWriter& operator=(const ByteBufferWriter& other) = delete;
+
+  /** The writer to encode messages with. */
+  nanopb::Writer* writer() {
+    return &writer_;
+  }
+
+  /**
+   * Returns a buffer with everything written so far, and empties this
+   * writer.
+   */
+  grpc::ByteBuffer Release();
+
+ private:
+  static pb_byte_t* Grow(void* output, size_t count);
+
+  std::vector<grpc::Slice> slices_;
+  nanopb::Writer writer_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_NANOPB_H_
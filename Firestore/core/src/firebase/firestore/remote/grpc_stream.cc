@@ -57,6 +57,7 @@ namespace internal {
 
 absl::optional<BufferedWrite> BufferedWriter::EnqueueWrite(
     grpc::ByteBuffer&& message, const grpc::WriteOptions& options) {
+  buffered_bytes_ += message.Length();
   queue_.push({std::move(message), options});
   return TryStartWrite();
 }
@@ -69,6 +70,7 @@ absl::optional<BufferedWrite> BufferedWriter::TryStartWrite() {
   has_active_write_ = true;
   BufferedWrite message = std::move(queue_.front());
   queue_.pop();
+  buffered_bytes_ -= message.message.Length();
   return std::move(message);
 }
 
@@ -129,21 +131,38 @@ void GrpcStream::Read() {
 
   GrpcCompletion* completion =
       NewCompletion(Type::Read, [this](const GrpcCompletion* completion) {
-        OnRead(*completion->message());
+        OnRead(*completion->message(), completion->decoded());
       });
+  // The observer is guaranteed to outlive the completion: the stream cannot be
+  // destroyed until all of its completions are off the gRPC completion queue.
+  GrpcStreamObserver* observer = observer_;
+  completion->SetDecoder([observer](const grpc::ByteBuffer& message) {
+    return observer->DecodeStreamRead(message);
+  });
   call_->Read(completion->message(), completion);
 }
 
 void GrpcStream::Write(grpc::ByteBuffer&& message) {
-  MaybeWrite(buffered_writer_.EnqueueWrite(std::move(message)));
+  grpc::WriteOptions options = WriteOptionsFor(message);
+  MaybeWrite(buffered_writer_.EnqueueWrite(std::move(message), options));
 }
 
 void GrpcStream::WriteLast(grpc::ByteBuffer&& message) {
-  grpc::WriteOptions options;
+  grpc::WriteOptions options = WriteOptionsFor(message);
   options.set_last_message();
   MaybeWrite(buffered_writer_.EnqueueWrite(std::move(message), options));
 }
 
+grpc::WriteOptions GrpcStream::WriteOptionsFor(
+    const grpc::ByteBuffer& message) const {
+  grpc::WriteOptions options;
+  // Small messages barely shrink and aren't worth the CPU time.
+  if (message.Length() < compression_threshold_bytes_) {
+    options.set_no_compression();
+  }
+  return options;
+}
+
 void GrpcStream::MaybeWrite(absl::optional<BufferedWrite> maybe_write) {
   if (!maybe_write) {
     return;
@@ -256,8 +275,9 @@ bool GrpcStream::WriteAndFinish(grpc::ByteBuffer&& message) {
 }
 
 bool GrpcStream::TryLastWrite(grpc::ByteBuffer&& message) {
+  grpc::WriteOptions options = WriteOptionsFor(message);
   absl::optional<BufferedWrite> maybe_write =
-      buffered_writer_.EnqueueWrite(std::move(message));
+      buffered_writer_.EnqueueWrite(std::move(message), options);
   // Only bother with the last write if there is no active write at the moment.
   if (!maybe_write) {
     return false;
@@ -266,7 +286,7 @@ bool GrpcStream::TryLastWrite(grpc::ByteBuffer&& message) {
   BufferedWrite last_write = std::move(maybe_write).value();
   GrpcCompletion* completion = NewCompletion(Type::Write, {});
   *completion->message() = last_write.message;
-  call_->WriteLast(*completion->message(), grpc::WriteOptions{}, completion);
+  call_->WriteLast(*completion->message(), last_write.options, completion);
 
   // Empirically, the write normally takes less than a millisecond to finish
   // (both with and without network connection), and never more than several
@@ -285,14 +305,15 @@ GrpcStream::Metadata GrpcStream::GetResponseHeaders() const {
 
 // Callbacks
 
-void GrpcStream::OnRead(const grpc::ByteBuffer& message) {
+void GrpcStream::OnRead(const grpc::ByteBuffer& message,
+                        const absl::any& decoded) {
   if (observer_) {
     // Continue waiting for new messages indefinitely as long as there is an
     // interested observer.
     // Order is important here -- any call to observer can potentially end this
     // stream's lifetime, so call `Read` before notifying.
     Read();
-    observer_->OnStreamRead(message);
+    observer_->OnStreamDecodedRead(message, decoded);
   }
 }
 
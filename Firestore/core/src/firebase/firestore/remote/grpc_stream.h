@@ -87,10 +87,16 @@ class BufferedWriter {
   // queue, or nullptr if the queue was empty.
   absl::optional<BufferedWrite> DequeueNextWrite();
 
+  /** The size of the writes waiting for the active write to finish. */
+  size_t buffered_bytes() const {
+    return buffered_bytes_;
+  }
+
  private:
   absl::optional<BufferedWrite> TryStartWrite();
 
   std::queue<BufferedWrite> queue_;
+  size_t buffered_bytes_ = 0;
   bool has_active_write_ = false;
 };
 
@@ -131,6 +137,15 @@ class GrpcStream : public GrpcCall {
 
   void Start();
 
+  /**
+   * If compression is enabled on the stream's context, messages smaller than
+   * the given number of bytes are still sent uncompressed. Must be called
+   * before any messages are written.
+   */
+  void set_compression_threshold(size_t bytes) {
+    compression_threshold_bytes_ = bytes;
+  }
+
   // Can only be called once the stream has opened.
   void Write(grpc::ByteBuffer&& message);
 
@@ -169,6 +184,11 @@ class GrpcStream : public GrpcCall {
     return observer_ == nullptr;
   }
 
+  /** The size of the messages queued until earlier writes finish. */
+  size_t buffered_bytes() const {
+    return buffered_writer_.buffered_bytes();
+  }
+
   /**
    * Returns the metadata received from the server.
    *
@@ -184,6 +204,7 @@ class GrpcStream : public GrpcCall {
  private:
   void Read();
   void MaybeWrite(absl::optional<internal::BufferedWrite> maybe_write);
+  grpc::WriteOptions WriteOptionsFor(const grpc::ByteBuffer& message) const;
   bool TryLastWrite(grpc::ByteBuffer&& message);
 
   void Shutdown();
@@ -193,7 +214,7 @@ class GrpcStream : public GrpcCall {
   void MaybeUnregister();
 
   void OnStart();
-  void OnRead(const grpc::ByteBuffer& message);
+  void OnRead(const grpc::ByteBuffer& message, const absl::any& decoded);
   void OnWrite();
   void OnOperationFailed();
   void RemoveCompletion(const GrpcCompletion* to_remove);
@@ -234,6 +255,7 @@ class GrpcStream : public GrpcCall {
 
   GrpcStreamObserver* observer_ = nullptr;
   internal::BufferedWriter buffered_writer_;
+  size_t compression_threshold_bytes_ = 0;
 
   std::vector<GrpcCompletion*> completions_;
 
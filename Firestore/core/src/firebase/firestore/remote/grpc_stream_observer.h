@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_STREAM_OBSERVER_H_
 
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "absl/types/any.h"
 #include "grpcpp/support/byte_buffer.h"
 
 namespace firebase {
@@ -36,6 +37,21 @@ class GrpcStreamObserver {
   virtual void OnStreamRead(const grpc::ByteBuffer& message) = 0;
   // Connection has been broken, perhaps by the server.
   virtual void OnStreamFinish(const util::Status& status) = 0;
+
+  // A message has been received from the server. Unlike the other methods,
+  // this is invoked on the gRPC polling thread rather than the worker queue,
+  // which allows expensive decoding to happen in parallel with the worker
+  // queue. The result is passed to `OnStreamDecodedRead`. Must not touch any
+  // state owned by the worker queue.
+  virtual absl::any DecodeStreamRead(const grpc::ByteBuffer& /*message*/) {
+    return {};
+  }
+  // A message has been received from the server; `decoded` is the result of
+  // `DecodeStreamRead`.
+  virtual void OnStreamDecodedRead(const grpc::ByteBuffer& message,
+                                   const absl::any& /*decoded*/) {
+    OnStreamRead(message);
+  }
 };
 
 }  // namespace remote
@@ -25,18 +25,21 @@
 
 #import <Foundation/Foundation.h>
 
-#include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/core/document_sizer.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "absl/container/inlined_vector.h"
 
 @class FSTMaybeDocument;
 @class FSTQueryData;
@@ -47,6 +50,8 @@ namespace firebase {
 namespace firestore {
 namespace remote {
 
+class DecodePool;
+
 /**
  * Interface implemented by `RemoteStore` to expose target metadata to the
  * `WatchChangeAggregator`.
@@ -69,6 +74,12 @@ class TargetMetadataProvider {
    */
   virtual FSTQueryData* GetQueryDataForTarget(
       model::TargetId target_id) const = 0;
+
+  /**
+   * Returns the database the targets belong to, which is needed to compute the
+   * resource names of documents.
+   */
+  virtual const model::DatabaseId& GetDatabaseId() const = 0;
 };
 
 /**
@@ -181,6 +192,11 @@ class TargetState {
     return has_pending_changes_;
   }
 
+  /** The number of documents changed since the last raised snapshot. */
+  size_t pending_document_change_count() const {
+    return document_changes_.size();
+  }
+
   /**
    * Applies the resume token to the `TargetChange`, but only when it has a new
    * value. Empty resume tokens are discarded.
@@ -242,18 +258,23 @@ class TargetState {
  */
 class RemoteEvent {
  public:
+  using DocumentUpdateMap = std::unordered_map<model::DocumentKey,
+                                               FSTMaybeDocument*,
+                                               model::DocumentKeyHash>;
+
   RemoteEvent(model::SnapshotVersion snapshot_version,
               std::unordered_map<model::TargetId, TargetChange> target_changes,
               std::unordered_set<model::TargetId> target_mismatches,
-              std::unordered_map<model::DocumentKey,
-                                 FSTMaybeDocument*,
-                                 model::DocumentKeyHash> document_updates,
-              model::DocumentKeySet limbo_document_changes)
+              DocumentUpdateMap document_updates,
+              model::DocumentKeySet limbo_document_changes,
+              std::unordered_map<model::TargetId, DocumentUpdateMap>
+                  projected_document_updates = {})
       : snapshot_version_{snapshot_version},
         target_changes_{std::move(target_changes)},
         target_mismatches_{std::move(target_mismatches)},
         document_updates_{std::move(document_updates)},
-        limbo_document_changes_{std::move(limbo_document_changes)} {
+        limbo_document_changes_{std::move(limbo_document_changes)},
+        projected_document_updates_{std::move(projected_document_updates)} {
   }
 
   /** The snapshot version this event brings us up to. */
@@ -293,6 +314,16 @@ class RemoteEvent {
     return limbo_document_changes_;
   }
 
+  /**
+   * The partial documents received for targets whose queries select only some
+   * fields, per target. These are never part of `document_updates()`, since
+   * they must not replace whole documents in the remote document cache.
+   */
+  const std::unordered_map<model::TargetId, DocumentUpdateMap>&
+  projected_document_updates() const {
+    return projected_document_updates_;
+  }
+
  private:
   model::SnapshotVersion snapshot_version_;
   std::unordered_map<model::TargetId, TargetChange> target_changes_;
@@ -302,6 +333,8 @@ class RemoteEvent {
                      model::DocumentKeyHash>
       document_updates_;
   model::DocumentKeySet limbo_document_changes_;
+  std::unordered_map<model::TargetId, DocumentUpdateMap>
+      projected_document_updates_;
 };
 
 /**
@@ -310,8 +343,13 @@ class RemoteEvent {
  */
 class WatchChangeAggregator {
  public:
+  /**
+   * Creates an aggregator that, if `pool` is given, uses it to compute the
+   * changes of many targets in parallel.
+   */
   explicit WatchChangeAggregator(
-      TargetMetadataProvider* target_metadata_provider);
+      TargetMetadataProvider* target_metadata_provider,
+      DecodePool* _Nullable pool = nullptr);
 
   /**
    * Processes and adds the `DocumentWatchChange` to the current set of changes.
@@ -325,8 +363,10 @@ class WatchChangeAggregator {
 
   /**
    * Handles existence filters and synthesizes deletes for filter mismatches.
-   * Targets that are invalidated by filter mismatches are added to
-   * `pending_target_resets_`.
+   * If the filter carries a bloom filter of the documents that still match,
+   * only the documents missing from it are removed from the target. Otherwise
+   * (or if that still doesn't reconcile the count), targets invalidated by
+   * filter mismatches are added to `pending_target_resets_`.
    */
   void HandleExistenceFilter(
       const ExistenceFilterWatchChange& existence_filter);
@@ -347,7 +387,20 @@ class WatchChangeAggregator {
    */
   void RecordPendingTargetRequest(model::TargetId target_id);
 
+  /**
+   * Estimates the number of bytes held by the changes accumulated since the
+   * last remote event.
+   */
+  size_t EstimatePendingByteSize(const core::DocumentSizer& sizer) const;
+
  private:
+  /**
+   * Converts the given target states into target changes, in the same order.
+   */
+  std::vector<TargetChange> ToTargetChanges(
+      const std::vector<std::pair<model::TargetId, TargetState*>>& targets)
+      const;
+
   /**
    * Returns all `targetId`s that the watch change applies to: either the
    * `targetId`s explicitly listed in the change or the `targetId`s of all
@@ -374,6 +427,14 @@ class WatchChangeAggregator {
                                 const model::DocumentKey& key,
                                 FSTMaybeDocument* _Nullable updated_document);
 
+  /**
+   * Removes the documents that the target contains according to the local
+   * store but that are definitely not in `unchanged_names`. Returns the
+   * number of removed documents.
+   */
+  int RemoveDocumentsMissingFromFilter(model::TargetId target_id,
+                                       const BloomFilter& unchanged_names);
+
   /**
    * Returns the current count of documents in the target. This includes both
    * the number of documents that the LocalStore considers to be part of the
@@ -415,6 +476,15 @@ class WatchChangeAggregator {
   bool TargetContainsDocument(model::TargetId target_id,
                               const model::DocumentKey& key);
 
+  /**
+   * Synthesizes a delete of the given document if the current target did not
+   * return it and no update for it is pending.
+   */
+  void SynthesizeDeleteIfMissing(
+      model::TargetId target_id,
+      const model::DocumentKey& key,
+      const model::SnapshotVersion& snapshot_version);
+
   /** The internal state of all tracked targets. */
   std::unordered_map<model::TargetId, TargetState> target_states_;
 
@@ -424,10 +494,25 @@ class WatchChangeAggregator {
                      model::DocumentKeyHash>
       pending_document_updates_;
 
+  /**
+   * Keeps track of the partial documents to update since the last raised
+   * snapshot, for targets whose queries have a projection.
+   */
+  std::unordered_map<model::TargetId, RemoteEvent::DocumentUpdateMap>
+      pending_projected_document_updates_;
+
+  /**
+   * A sorted set of target IDs. Most documents belong to only a handful of
+   * targets, so storing them inline avoids allocating a tree node per target
+   * for each changed document.
+   */
+  using TargetIdSet = absl::InlinedVector<model::TargetId, 4>;
+
+  /** Adds `target_id` to `targets` unless it's already there. */
+  static void AddTargetId(TargetIdSet* targets, model::TargetId target_id);
+
   /** A mapping of document keys to their set of target IDs. */
-  std::unordered_map<model::DocumentKey,
-                     std::set<model::TargetId>,
-                     model::DocumentKeyHash>
+  std::unordered_map<model::DocumentKey, TargetIdSet, model::DocumentKeyHash>
       pending_document_target_mappings_;
 
   /**
@@ -438,6 +523,7 @@ class WatchChangeAggregator {
   std::unordered_set<model::TargetId> pending_target_resets_;
 
   TargetMetadataProvider* target_metadata_provider_ = nullptr;
+  DecodePool* _Nullable pool_ = nullptr;
 };
 
 }  // namespace remote
@@ -16,22 +16,42 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 
+#include <algorithm>
+#include <functional>
+#include <string>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 
+#include "Firestore/core/src/firebase/firestore/remote/decode_pool.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+
 using firebase::firestore::core::DocumentViewChange;
+using firebase::firestore::model::DatabaseId;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::util::StringFormat;
 
 namespace firebase {
 namespace firestore {
 namespace remote {
 
+namespace {
+
+/**
+ * The minimum number of document changes worth handing to another thread when
+ * converting target states into target changes. Below this, the hand-off costs
+ * more than it saves.
+ */
+constexpr size_t kMinDocumentChangesPerTask = 512;
+
+}  // namespace
+
 // TargetChange
 
 bool operator==(const TargetChange& lhs, const TargetChange& rhs) {
@@ -55,9 +75,11 @@ void TargetState::UpdateResumeToken(NSData* resume_token) {
 }
 
 TargetChange TargetState::ToTargetChange() const {
-  DocumentKeySet added_documents;
-  DocumentKeySet modified_documents;
-  DocumentKeySet removed_documents;
+  // Sorting the keys up front lets each set be built in one pass rather than
+  // by repeated insertion.
+  std::vector<DocumentKey> added_documents;
+  std::vector<DocumentKey> modified_documents;
+  std::vector<DocumentKey> removed_documents;
 
   for (const auto& entry : document_changes_) {
     const DocumentKey& document_key = entry.first;
@@ -65,22 +87,34 @@ TargetChange TargetState::ToTargetChange() const {
 
     switch (change_type) {
       case DocumentViewChange::Type::kAdded:
-        added_documents = added_documents.insert(document_key);
+        added_documents.push_back(document_key);
         break;
       case DocumentViewChange::Type::kModified:
-        modified_documents = modified_documents.insert(document_key);
+        modified_documents.push_back(document_key);
         break;
       case DocumentViewChange::Type::kRemoved:
-        removed_documents = removed_documents.insert(document_key);
+        removed_documents.push_back(document_key);
         break;
       default:
         HARD_FAIL("Encountered invalid change type: %s", change_type);
     }
   }
 
-  return TargetChange{resume_token(), current(), std::move(added_documents),
-                      std::move(modified_documents),
-                      std::move(removed_documents)};
+  auto less = [](const DocumentKey& lhs, const DocumentKey& rhs) {
+    return util::Ascending(lhs.CompareTo(rhs));
+  };
+  std::sort(added_documents.begin(), added_documents.end(), less);
+  std::sort(modified_documents.begin(), modified_documents.end(), less);
+  std::sort(removed_documents.begin(), removed_documents.end(), less);
+
+  return TargetChange{
+      resume_token(), current(),
+      DocumentKeySet::FromSorted(added_documents.begin(),
+                                 added_documents.end()),
+      DocumentKeySet::FromSorted(modified_documents.begin(),
+                                 modified_documents.end()),
+      DocumentKeySet::FromSorted(removed_documents.begin(),
+                                 removed_documents.end())};
 }
 
 void TargetState::ClearPendingChanges() {
@@ -115,8 +149,9 @@ void TargetState::RemoveDocumentChange(const DocumentKey& document_key) {
 // WatchChangeAggregator
 
 WatchChangeAggregator::WatchChangeAggregator(
-    TargetMetadataProvider* target_metadata_provider)
-    : target_metadata_provider_{NOT_NULL(target_metadata_provider)} {
+    TargetMetadataProvider* target_metadata_provider, DecodePool* pool)
+    : target_metadata_provider_{NOT_NULL(target_metadata_provider)},
+      pool_{pool} {
 }
 
 void WatchChangeAggregator::HandleDocumentChange(
@@ -237,18 +272,49 @@ void WatchChangeAggregator::HandleExistenceFilter(
     } else {
       int current_size = GetCurrentDocumentCountForTarget(target_id);
       if (current_size != expected_count) {
-        // Existence filter mismatch: We reset the mapping and raise a new
+        // Existence filter mismatch. If the filter tells which documents still
+        // match, drop just the ones that don't; this avoids re-downloading
+        // the whole target after e.g. a single concurrent delete.
+        const absl::optional<BloomFilter>& unchanged_names =
+            existence_filter.filter().unchanged_names();
+        if (unchanged_names) {
+          current_size -=
+              RemoveDocumentsMissingFromFilter(target_id, *unchanged_names);
+        }
+
+        // If there was no bloom filter or its false positives kept some
+        // removed documents around, we reset the mapping and raise a new
         // snapshot with `isFromCache:true`.
-        ResetTarget(target_id);
-        pending_target_resets_.insert(target_id);
+        if (current_size != expected_count) {
+          ResetTarget(target_id);
+          pending_target_resets_.insert(target_id);
+        }
       }
     }
   }
 }
 
+void WatchChangeAggregator::SynthesizeDeleteIfMissing(
+    TargetId target_id,
+    const DocumentKey& key,
+    const SnapshotVersion& snapshot_version) {
+  if (pending_document_updates_.find(key) == pending_document_updates_.end() &&
+      !TargetContainsDocument(target_id, key)) {
+    RemoveDocumentFromTarget(
+        target_id, key,
+        [FSTDeletedDocument documentWithKey:key
+                                    version:snapshot_version
+                      hasCommittedMutations:NO]);
+  }
+}
+
 RemoteEvent WatchChangeAggregator::CreateRemoteEvent(
     const SnapshotVersion& snapshot_version) {
-  std::unordered_map<TargetId, TargetChange> target_changes;
+  // Everything that needs the metadata provider happens in this first pass, on
+  // the calling thread. Whether each active target is a limbo resolution is
+  // remembered, so that the documents below don't have to look it up again.
+  std::vector<std::pair<TargetId, TargetState*>> changed_targets;
+  std::unordered_map<TargetId, bool> is_limbo_target;
 
   for (auto& entry : target_states_) {
     TargetId target_id = entry.first;
@@ -256,30 +322,38 @@ RemoteEvent WatchChangeAggregator::CreateRemoteEvent(
 
     FSTQueryData* query_data = QueryDataForActiveTarget(target_id);
     if (query_data) {
+      is_limbo_target[target_id] =
+          query_data.purpose == FSTQueryPurposeLimboResolution;
+
       if (target_state.current() && [query_data.query isDocumentQuery]) {
         // Document queries for document that don't exist can produce an empty
         // result set. To update our local cache, we synthesize a document
         // delete if we have not previously received the document. This resolves
         // the limbo state of the document, removing it from limboDocumentRefs.
-        DocumentKey key{query_data.query.path};
-        if (pending_document_updates_.find(key) ==
-                pending_document_updates_.end() &&
-            !TargetContainsDocument(target_id, key)) {
-          RemoveDocumentFromTarget(
-              target_id, key,
-              [FSTDeletedDocument documentWithKey:key
-                                          version:snapshot_version
-                            hasCommittedMutations:NO]);
+        SynthesizeDeleteIfMissing(target_id, DocumentKey{query_data.query.path},
+                                  snapshot_version);
+      } else if (target_state.current() &&
+                 [query_data.query isDocumentKeysQuery]) {
+        // The same goes for each of the documents of a set.
+        for (const DocumentKey& key : query_data.query.documentKeys) {
+          SynthesizeDeleteIfMissing(target_id, key, snapshot_version);
         }
       }
 
       if (target_state.HasPendingChanges()) {
-        target_changes[target_id] = target_state.ToTargetChange();
-        target_state.ClearPendingChanges();
+        changed_targets.emplace_back(target_id, &target_state);
       }
     }
   }
 
+  std::vector<TargetChange> changes = ToTargetChanges(changed_targets);
+  std::unordered_map<TargetId, TargetChange> target_changes;
+  target_changes.reserve(changed_targets.size());
+  for (size_t i = 0; i != changed_targets.size(); ++i) {
+    target_changes[changed_targets[i].first] = std::move(changes[i]);
+    changed_targets[i].second->ClearPendingChanges();
+  }
+
   DocumentKeySet resolved_limbo_documents;
 
   // We extract the set of limbo-only document updates as the GC logic
@@ -290,32 +364,84 @@ RemoteEvent WatchChangeAggregator::CreateRemoteEvent(
     bool is_only_limbo_target = true;
 
     for (TargetId target_id : entry.second) {
-      FSTQueryData* query_data = QueryDataForActiveTarget(target_id);
-      if (query_data && query_data.purpose != FSTQueryPurposeLimboResolution) {
+      auto found = is_limbo_target.find(target_id);
+      if (found != is_limbo_target.end() && !found->second) {
         is_only_limbo_target = false;
         break;
       }
     }
 
     if (is_only_limbo_target) {
-      resolved_limbo_documents = resolved_limbo_documents.insert(entry.first);
+      resolved_limbo_documents =
+          std::move(resolved_limbo_documents).insert(entry.first);
     }
   }
 
-  RemoteEvent remote_event{snapshot_version, std::move(target_changes),
+  RemoteEvent remote_event{snapshot_version,
+                           std::move(target_changes),
                            std::move(pending_target_resets_),
                            std::move(pending_document_updates_),
-                           std::move(resolved_limbo_documents)};
+                           std::move(resolved_limbo_documents),
+                           std::move(pending_projected_document_updates_)};
 
   // Re-initialize the current state to ensure that we do not modify the
   // generated `RemoteEvent`.
   pending_document_updates_.clear();
+  pending_projected_document_updates_.clear();
   pending_document_target_mappings_.clear();
   pending_target_resets_.clear();
 
   return remote_event;
 }
 
+std::vector<TargetChange> WatchChangeAggregator::ToTargetChanges(
+    const std::vector<std::pair<TargetId, TargetState*>>& targets) const {
+  std::vector<TargetChange> result(targets.size());
+  auto convert = [&targets, &result](size_t begin, size_t end) {
+    for (size_t i = begin; i != end; ++i) {
+      result[i] = targets[i].second->ToTargetChange();
+    }
+  };
+
+  size_t total_changes = 0;
+  for (const auto& target : targets) {
+    total_changes += target.second->pending_document_change_count();
+  }
+
+  // Each task takes a contiguous range of targets with about the same number
+  // of document changes and writes to its own slots of `result`, so the outcome
+  // doesn't depend on which task finishes first.
+  size_t task_count = 1;
+  if (pool_) {
+    // The calling thread runs one of the tasks itself.
+    task_count = std::min(pool_->size() + 1,
+                          total_changes / kMinDocumentChangesPerTask);
+  }
+  if (task_count <= 1) {
+    convert(0, targets.size());
+    return result;
+  }
+
+  std::vector<std::function<void()>> tasks;
+  size_t begin = 0;
+  size_t changes_so_far = 0;
+  size_t next_boundary = 1;
+  for (size_t i = 0; i != targets.size(); ++i) {
+    changes_so_far += targets[i].second->pending_document_change_count();
+    size_t end = i + 1;
+    bool is_last = end == targets.size();
+    if (is_last ||
+        changes_so_far * task_count >= total_changes * next_boundary) {
+      tasks.push_back([convert, begin, end] { convert(begin, end); });
+      begin = end;
+      // A single large target may cover more than one task's share.
+      next_boundary = changes_so_far * task_count / total_changes + 1;
+    }
+  }
+  pool_->RunAll(std::move(tasks));
+  return result;
+}
+
 void WatchChangeAggregator::AddDocumentToTarget(TargetId target_id,
                                                 FSTMaybeDocument* document) {
   if (!IsActiveTarget(target_id)) {
@@ -330,8 +456,13 @@ void WatchChangeAggregator::AddDocumentToTarget(TargetId target_id,
   TargetState& target_state = EnsureTargetState(target_id);
   target_state.AddDocumentChange(document.key, change_type);
 
-  pending_document_updates_[document.key] = document;
-  pending_document_target_mappings_[document.key].insert(target_id);
+  // Partial documents only belong to the target that selected their fields.
+  if ([QueryDataForActiveTarget(target_id).query hasProjection]) {
+    pending_projected_document_updates_[target_id][document.key] = document;
+  } else {
+    pending_document_updates_[document.key] = document;
+  }
+  AddTargetId(&pending_document_target_mappings_[document.key], target_id);
 }
 
 void WatchChangeAggregator::RemoveDocumentFromTarget(
@@ -350,10 +481,30 @@ void WatchChangeAggregator::RemoveDocumentFromTarget(
     // snapshot, so we can just ignore the change.
     target_state.RemoveDocumentChange(key);
   }
-  pending_document_target_mappings_[key].insert(target_id);
+  AddTargetId(&pending_document_target_mappings_[key], target_id);
+
+  auto projected = pending_projected_document_updates_.find(target_id);
+  if (projected != pending_projected_document_updates_.end()) {
+    projected->second.erase(key);
+  }
 
-  if (updated_document) {
-    pending_document_updates_[key] = updated_document;
+  if (!updated_document) {
+    return;
+  }
+  // The documents of a projection target are partial, so one sent along as it
+  // leaves the target must not replace the whole document. Deletes still apply.
+  if ([updated_document isKindOfClass:[FSTDocument class]] &&
+      [QueryDataForActiveTarget(target_id).query hasProjection]) {
+    return;
+  }
+  pending_document_updates_[key] = updated_document;
+}
+
+void WatchChangeAggregator::AddTargetId(TargetIdSet* targets,
+                                        TargetId target_id) {
+  auto pos = std::lower_bound(targets->begin(), targets->end(), target_id);
+  if (pos == targets->end() || *pos != target_id) {
+    targets->insert(pos, target_id);
   }
 }
 
@@ -361,6 +512,31 @@ void WatchChangeAggregator::RemoveTarget(TargetId target_id) {
   target_states_.erase(target_id);
 }
 
+int WatchChangeAggregator::RemoveDocumentsMissingFromFilter(
+    TargetId target_id, const BloomFilter& unchanged_names) {
+  const DatabaseId& database_id = target_metadata_provider_->GetDatabaseId();
+  // Documents already pending removal are not part of the current count.
+  TargetChange pending_changes = EnsureTargetState(target_id).ToTargetChange();
+
+  int removed_count = 0;
+  DocumentKeySet existing_keys =
+      target_metadata_provider_->GetRemoteKeysForTarget(target_id);
+  for (const DocumentKey& key : existing_keys) {
+    if (pending_changes.removed_documents().contains(key)) {
+      continue;
+    }
+
+    std::string resource_name = StringFormat(
+        "projects/%s/databases/%s/documents/%s", database_id.project_id(),
+        database_id.database_id(), key.path().CanonicalString());
+    if (!unchanged_names.MightContain(resource_name)) {
+      RemoveDocumentFromTarget(target_id, key, nil);
+      ++removed_count;
+    }
+  }
+  return removed_count;
+}
+
 int WatchChangeAggregator::GetCurrentDocumentCountForTarget(
     TargetId target_id) {
   TargetState& target_state = EnsureTargetState(target_id);
@@ -376,6 +552,28 @@ void WatchChangeAggregator::RecordPendingTargetRequest(TargetId target_id) {
   target_state.RecordPendingTargetRequest();
 }
 
+size_t WatchChangeAggregator::EstimatePendingByteSize(
+    const core::DocumentSizer& sizer) const {
+  size_t size = 0;
+  for (const auto& kv : pending_document_updates_) {
+    size += sizer(kv.second);
+  }
+  for (const auto& target : pending_projected_document_updates_) {
+    for (const auto& kv : target.second) {
+      size += sizer(kv.second);
+    }
+  }
+
+  // Document keys share their paths, so only count the entries themselves.
+  size += pending_document_target_mappings_.size() *
+          (sizeof(DocumentKey) + sizeof(TargetIdSet));
+  for (const auto& kv : target_states_) {
+    size += kv.second.pending_document_change_count() *
+            (sizeof(DocumentKey) + sizeof(DocumentViewChange::Type));
+  }
+  return size;
+}
+
 TargetState& WatchChangeAggregator::EnsureTargetState(TargetId target_id) {
   return target_states_[target_id];
 }
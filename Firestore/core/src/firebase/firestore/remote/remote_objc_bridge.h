@@ -23,6 +23,7 @@
 
 #import <Foundation/Foundation.h>
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -30,8 +31,10 @@
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "absl/types/optional.h"
 #include "grpcpp/support/byte_buffer.h"
 
 #import "Firestore/Protos/objc/google/firestore/v1/Firestore.pbobjc.h"
@@ -40,6 +43,13 @@
 #import "Firestore/Source/Model/FSTMutation.h"
 #import "Firestore/Source/Remote/FSTSerializerBeta.h"
 
+// Build with -DFIRESTORE_NATIVE_STREAM_SERIALIZATION=1 to decode listen and
+// lookup responses with the nanopb-based `remote::Serializer` rather than into
+// Objective-C protos.
+#ifndef FIRESTORE_NATIVE_STREAM_SERIALIZATION
+#define FIRESTORE_NATIVE_STREAM_SERIALIZATION 0
+#endif
+
 namespace firebase {
 namespace firestore {
 namespace remote {
@@ -65,10 +75,11 @@ bool IsLoggingEnabled();
 class WatchStreamSerializer {
  public:
   explicit WatchStreamSerializer(FSTSerializerBeta* serializer)
-      : serializer_{serializer} {
+      : serializer_{serializer}, nanopb_serializer_{*serializer.databaseID} {
   }
 
-  GCFSListenRequest* CreateWatchRequest(FSTQueryData* query) const;
+  GCFSListenRequest* CreateWatchRequest(
+      FSTQueryData* query, absl::optional<int32_t> expected_count) const;
   GCFSListenRequest* CreateUnwatchRequest(model::TargetId target_id) const;
   static grpc::ByteBuffer ToByteBuffer(GCFSListenRequest* request);
 
@@ -82,12 +93,28 @@ class WatchStreamSerializer {
   std::unique_ptr<WatchChange> ToWatchChange(GCFSListenResponse* proto) const;
   model::SnapshotVersion ToSnapshotVersion(GCFSListenResponse* proto) const;
 
+  /**
+   * Decodes the watch change and snapshot version of a listen response
+   * straight from its bytes with nanopb, without creating any Objective-C
+   * protos.
+   *
+   * Returns false, leaving `change` and `version` untouched, if the response
+   * must go through `ParseResponse` instead: existence filters, whose bloom
+   * filter the nanopb protos don't know about, documents with values
+   * `remote::Serializer` can't decode yet, and malformed responses, whose
+   * errors `ParseResponse` reports.
+   */
+  bool DecodeResponse(const grpc::ByteBuffer& message,
+                      std::unique_ptr<WatchChange>* change,
+                      model::SnapshotVersion* version) const;
+
   /** Creates a pretty-printed description of the proto for debugging. */
   static NSString* Describe(GCFSListenRequest* request);
   static NSString* Describe(GCFSListenResponse* request);
 
  private:
   FSTSerializerBeta* serializer_;
+  Serializer nanopb_serializer_;
 };
 
 /**
@@ -100,15 +127,39 @@ class WriteStreamSerializer {
       : serializer_{serializer} {
   }
 
+  /**
+   * Records the stream token of the response, and the ID of the stream if the
+   * response is the first of a new stream.
+   */
   void UpdateLastStreamToken(GCFSWriteResponse* proto);
+
+  /**
+   * Sets the token the next requests carry. The ID of the stream it came from
+   * is forgotten, so the stream can't be resumed until a new one is created.
+   */
   void SetLastStreamToken(NSData* token) {
     last_stream_token_ = token;
+    last_stream_id_ = nil;
   }
   NSData* GetLastStreamToken() const {
     return last_stream_token_;
   }
 
+  /**
+   * Whether a new RPC can resume the last stream, i.e. whether both its ID and
+   * the token of its last response are known.
+   */
+  bool CanResumeStream() const {
+    return last_stream_id_.length > 0 && last_stream_token_.length > 0;
+  }
+
   GCFSWriteRequest* CreateHandshake() const;
+
+  /**
+   * Creates a handshake that resumes the last stream at its last stream token,
+   * so that the server accepts mutations written right behind it.
+   */
+  GCFSWriteRequest* CreateResumeHandshake() const;
   GCFSWriteRequest* CreateWriteMutationsRequest(
       const std::vector<FSTMutation*>& mutations) const;
   GCFSWriteRequest* CreateEmptyMutationsList() {
@@ -134,6 +185,7 @@ class WriteStreamSerializer {
  private:
   FSTSerializerBeta* serializer_;
   NSData* last_stream_token_;
+  NSString* last_stream_id_;
 };
 
 /**
@@ -168,7 +220,15 @@ class DatastoreSerializer {
   }
 
  private:
+  /**
+   * Decodes a lookup response with nanopb, or returns nil if it must be parsed
+   * into Objective-C protos instead.
+   */
+  FSTMaybeDocument* DecodeLookupResponse(
+      const grpc::ByteBuffer& response) const;
+
   FSTSerializerBeta* serializer_;
+  Serializer nanopb_serializer_;
 };
 
 }  // namespace bridge
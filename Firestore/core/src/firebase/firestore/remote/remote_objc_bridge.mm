@@ -22,11 +22,19 @@
 #include <vector>
 
 #import "Firestore/Source/API/FIRFirestore+Internal.h"
+#import "Firestore/Source/Model/FSTDocument.h"
 
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_nanopb.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "absl/memory/memory.h"
 #include "grpcpp/support/status.h"
 
 namespace firebase {
@@ -35,9 +43,13 @@ namespace remote {
 namespace bridge {
 
 using core::DatabaseInfo;
+using model::Document;
 using model::DocumentKey;
+using model::MaybeDocument;
 using model::TargetId;
 using model::SnapshotVersion;
+using model::ToFSTObjectValue;
+using nanopb::Reader;
 using util::MakeString;
 using util::MakeNSError;
 using util::Status;
@@ -112,6 +124,139 @@ Proto* ToProto(const grpc::ByteBuffer& message, Status* out_status) {
   return nil;
 }
 
+std::vector<TargetId> ToTargetIds(const int32_t* target_ids, pb_size_t count) {
+  return std::vector<TargetId>(target_ids, target_ids + count);
+}
+
+FSTMaybeDocument* ToFSTMaybeDocument(const MaybeDocument& document) {
+  if (document.type() == MaybeDocument::Type::Document) {
+    const auto& doc = static_cast<const Document&>(document);
+    return [FSTDocument documentWithData:ToFSTObjectValue(doc.data())
+                                     key:doc.key()
+                                 version:doc.version()
+                                   state:FSTDocumentStateSynced];
+  }
+  return [FSTDeletedDocument documentWithKey:document.key()
+                                     version:document.version()
+                       hasCommittedMutations:NO];
+}
+
+WatchTargetChangeState ToWatchTargetChangeState(
+    Reader* reader, google_firestore_v1_TargetChange_TargetChangeType state) {
+  switch (state) {
+    case google_firestore_v1_TargetChange_TargetChangeType_NO_CHANGE:
+      return WatchTargetChangeState::NoChange;
+    case google_firestore_v1_TargetChange_TargetChangeType_ADD:
+      return WatchTargetChangeState::Added;
+    case google_firestore_v1_TargetChange_TargetChangeType_REMOVE:
+      return WatchTargetChangeState::Removed;
+    case google_firestore_v1_TargetChange_TargetChangeType_CURRENT:
+      return WatchTargetChangeState::Current;
+    case google_firestore_v1_TargetChange_TargetChangeType_RESET:
+      return WatchTargetChangeState::Reset;
+  }
+  reader->Fail(StringFormat("Unexpected TargetChange.state: %s", state));
+  return WatchTargetChangeState::NoChange;
+}
+
+/**
+ * Converts a listen response decoded by nanopb, mirroring
+ * `-[FSTSerializerBeta decodedWatchChange:]`. Returns nullptr for responses
+ * that must be decoded by `FSTSerializerBeta`.
+ */
+std::unique_ptr<WatchChange> DecodeWatchChange(
+    const Serializer& serializer,
+    Reader* reader,
+    const google_firestore_v1_ListenResponse& proto,
+    SnapshotVersion* version) {
+  switch (proto.which_response_type) {
+    case google_firestore_v1_ListenResponse_target_change_tag: {
+      const google_firestore_v1_TargetChange& change = proto.target_change;
+      WatchTargetChangeState state =
+          ToWatchTargetChangeState(reader, change.target_change_type);
+
+      // Only a read time that applies to all targets is a consistent snapshot
+      // of the whole stream.
+      if (change.target_ids_count == 0) {
+        *version = Serializer::DecodeSnapshotVersion(reader, change.read_time);
+      }
+
+      NSData* resume_token =
+          change.resume_token
+              ? [NSData dataWithBytes:change.resume_token->bytes
+                               length:change.resume_token->size]
+              : [NSData data];
+      Status cause;
+      if (change.cause.code != 0) {
+        cause = Status{static_cast<FirestoreErrorCode>(change.cause.code),
+                       Serializer::DecodeString(change.cause.message)};
+      }
+      return absl::make_unique<WatchTargetChange>(
+          state, ToTargetIds(change.target_ids, change.target_ids_count),
+          resume_token, std::move(cause));
+    }
+
+    case google_firestore_v1_ListenResponse_document_change_tag: {
+      const google_firestore_v1_DocumentChange& change = proto.document_change;
+      std::unique_ptr<Document> document =
+          serializer.DecodeDocument(reader, change.document);
+      if (!reader->status().ok()) {
+        return nullptr;
+      }
+      if (document->version() == SnapshotVersion::None()) {
+        reader->Fail("Got a document change with no snapshot version");
+        return nullptr;
+      }
+      DocumentKey key = document->key();
+      return absl::make_unique<DocumentWatchChange>(
+          ToTargetIds(change.target_ids, change.target_ids_count),
+          ToTargetIds(change.removed_target_ids,
+                      change.removed_target_ids_count),
+          std::move(key), ToFSTMaybeDocument(*document));
+    }
+
+    case google_firestore_v1_ListenResponse_document_delete_tag: {
+      const google_firestore_v1_DocumentDelete& change = proto.document_delete;
+      DocumentKey key = serializer.DecodeKey(
+          reader, Serializer::DecodeString(change.document));
+      // The read time may be unset, in which case it decodes as
+      // SnapshotVersion::None().
+      SnapshotVersion read_time =
+          Serializer::DecodeSnapshotVersion(reader, change.read_time);
+      FSTMaybeDocument* document =
+          [FSTDeletedDocument documentWithKey:key
+                                      version:read_time
+                        hasCommittedMutations:NO];
+      return absl::make_unique<DocumentWatchChange>(
+          std::vector<TargetId>{},
+          ToTargetIds(change.removed_target_ids,
+                      change.removed_target_ids_count),
+          std::move(key), document);
+    }
+
+    case google_firestore_v1_ListenResponse_document_remove_tag: {
+      const google_firestore_v1_DocumentRemove& change = proto.document_remove;
+      DocumentKey key = serializer.DecodeKey(
+          reader, Serializer::DecodeString(change.document));
+      return absl::make_unique<DocumentWatchChange>(
+          std::vector<TargetId>{},
+          ToTargetIds(change.removed_target_ids,
+                      change.removed_target_ids_count),
+          std::move(key), nil);
+    }
+
+    case google_firestore_v1_ListenResponse_filter_tag:
+      // The bloom filter of unchanged names is an unknown field to the
+      // checked-in protos, which only the Objective-C runtime preserves.
+      return nullptr;
+
+    default:
+      reader->Fail(StringFormat("Unknown WatchChange.changeType %s",
+                                proto.which_response_type));
+      return nullptr;
+  }
+}
+
 }  // namespace
 
 bool IsLoggingEnabled() {
@@ -121,10 +266,11 @@ bool IsLoggingEnabled() {
 // WatchStreamSerializer
 
 GCFSListenRequest* WatchStreamSerializer::CreateWatchRequest(
-    FSTQueryData* query) const {
+    FSTQueryData* query, absl::optional<int32_t> expected_count) const {
   GCFSListenRequest* request = [GCFSListenRequest message];
   request.database = [serializer_ encodedDatabaseID];
-  request.addTarget = [serializer_ encodedTarget:query];
+  request.addTarget = [serializer_ encodedTarget:query
+                                   expectedCount:expected_count];
   request.labels = [serializer_ encodedListenRequestLabelsForQueryData:query];
   return request;
 }
@@ -157,6 +303,30 @@ SnapshotVersion WatchStreamSerializer::ToSnapshotVersion(
   return [serializer_ versionFromListenResponse:proto];
 }
 
+bool WatchStreamSerializer::DecodeResponse(
+    const grpc::ByteBuffer& message,
+    std::unique_ptr<WatchChange>* change,
+    SnapshotVersion* version) const {
+  ByteBufferReader buffer_reader{message};
+  Reader* reader = buffer_reader.reader();
+  google_firestore_v1_ListenResponse proto{};
+  reader->ReadNanopbMessage(google_firestore_v1_ListenResponse_fields, &proto);
+  std::unique_ptr<WatchChange> decoded;
+  SnapshotVersion decoded_version = SnapshotVersion::None();
+  if (reader->status().ok()) {
+    decoded =
+        DecodeWatchChange(nanopb_serializer_, reader, proto, &decoded_version);
+  }
+  reader->FreeNanopbMessage(google_firestore_v1_ListenResponse_fields, &proto);
+
+  if (!reader->status().ok() || !decoded) {
+    return false;
+  }
+  *change = std::move(decoded);
+  *version = decoded_version;
+  return true;
+}
+
 NSString* WatchStreamSerializer::Describe(GCFSListenRequest* request) {
   return [request description];
 }
@@ -169,6 +339,10 @@ NSString* WatchStreamSerializer::Describe(GCFSListenResponse* response) {
 
 void WriteStreamSerializer::UpdateLastStreamToken(GCFSWriteResponse* proto) {
   last_stream_token_ = proto.streamToken;
+  // Only the first response of a new stream carries its ID.
+  if (proto.streamId.length > 0) {
+    last_stream_id_ = proto.streamId;
+  }
 }
 
 GCFSWriteRequest* WriteStreamSerializer::CreateHandshake() const {
@@ -178,6 +352,14 @@ GCFSWriteRequest* WriteStreamSerializer::CreateHandshake() const {
   return request;
 }
 
+GCFSWriteRequest* WriteStreamSerializer::CreateResumeHandshake() const {
+  HARD_ASSERT(CanResumeStream(), "No write stream to resume");
+  GCFSWriteRequest* request = CreateHandshake();
+  request.streamId = last_stream_id_;
+  request.streamToken = last_stream_token_;
+  return request;
+}
+
 GCFSWriteRequest* WriteStreamSerializer::CreateWriteMutationsRequest(
     const std::vector<FSTMutation*>& mutations) const {
   NSMutableArray<GCFSWrite*>* protos =
@@ -234,7 +416,8 @@ NSString* WriteStreamSerializer::Describe(GCFSWriteResponse* response) {
 
 DatastoreSerializer::DatastoreSerializer(const DatabaseInfo& database_info)
     : serializer_{[[FSTSerializerBeta alloc]
-          initWithDatabaseID:&database_info.database_id()]} {
+          initWithDatabaseID:&database_info.database_id()]},
+      nanopb_serializer_{database_info.database_id()} {
 }
 
 GCFSCommitRequest* DatastoreSerializer::CreateCommitRequest(
@@ -278,12 +461,20 @@ std::vector<FSTMaybeDocument*> DatastoreSerializer::MergeLookupResponses(
   // Sort by key.
   std::map<DocumentKey, FSTMaybeDocument*> results;
 
+  *out_status = Status::OK();
   for (const auto& response : responses) {
-    auto* proto = ToProto<GCFSBatchGetDocumentsResponse>(response, out_status);
-    if (!out_status->ok()) {
-      return {};
+    FSTMaybeDocument* doc = nil;
+#if FIRESTORE_NATIVE_STREAM_SERIALIZATION
+    doc = DecodeLookupResponse(response);
+#endif  // FIRESTORE_NATIVE_STREAM_SERIALIZATION
+    if (!doc) {
+      auto* proto =
+          ToProto<GCFSBatchGetDocumentsResponse>(response, out_status);
+      if (!out_status->ok()) {
+        return {};
+      }
+      doc = [serializer_ decodedMaybeDocumentFromBatch:proto];
     }
-    FSTMaybeDocument* doc = [serializer_ decodedMaybeDocumentFromBatch:proto];
     results[doc.key] = doc;
   }
 
@@ -300,6 +491,26 @@ FSTMaybeDocument* DatastoreSerializer::ToMaybeDocument(
   return [serializer_ decodedMaybeDocumentFromBatch:response];
 }
 
+FSTMaybeDocument* DatastoreSerializer::DecodeLookupResponse(
+    const grpc::ByteBuffer& response) const {
+  ByteBufferReader buffer_reader{response};
+  Reader* reader = buffer_reader.reader();
+  google_firestore_v1_BatchGetDocumentsResponse proto{};
+  reader->ReadNanopbMessage(
+      google_firestore_v1_BatchGetDocumentsResponse_fields, &proto);
+  std::unique_ptr<MaybeDocument> document;
+  if (reader->status().ok()) {
+    document = nanopb_serializer_.DecodeMaybeDocument(reader, proto);
+  }
+  reader->FreeNanopbMessage(
+      google_firestore_v1_BatchGetDocumentsResponse_fields, &proto);
+
+  if (!reader->status().ok() || !document) {
+    return nil;
+  }
+  return ToFSTMaybeDocument(*document);
+}
+
 }  // namespace bridge
 }  // namespace remote
 }  // namespace firestore
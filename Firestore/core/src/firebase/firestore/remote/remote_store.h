@@ -23,10 +23,13 @@
 
 #import <Foundation/Foundation.h>
 
+#include <deque>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/core/document_sizer.h"
+#include "Firestore/core/src/firebase/firestore/core/memory_stats.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
@@ -34,11 +37,13 @@
 #include "Firestore/core/src/firebase/firestore/remote/datastore.h"
 #include "Firestore/core/src/firebase/firestore/remote/online_state_tracker.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
+#include "Firestore/core/src/firebase/firestore/remote/rpc_metrics.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
 #include "Firestore/core/src/firebase/firestore/remote/write_stream.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/trace_span.h"
 
 @class FSTLocalStore;
 @class FSTMutationBatch;
@@ -109,6 +114,38 @@ namespace firebase {
 namespace firestore {
 namespace remote {
 
+/** Tuning parameters for how `RemoteStore` sends writes to the backend. */
+struct WritePipelineOptions {
+  /**
+   * The maximum number of mutation batches that may have been fetched from
+   * the local store and not yet acknowledged by the backend.
+   */
+  int max_pending_writes = 10;
+
+  /**
+   * The maximum number of consecutive mutation batches merged into a single
+   * `WriteRequest`. The backend commits the writes of a request together and
+   * acknowledges them with a single response, which is then split back into
+   * per-batch results. 1 disables merging.
+   */
+  int max_batches_per_request = 1;
+
+  /**
+   * The maximum number of mutations in a merged request. A single batch that
+   * is larger than this is still sent on its own.
+   */
+  int max_mutations_per_request = 500;
+
+  /**
+   * Whether a restarted write stream resumes the previous one, so that the
+   * pending writes can be sent right behind the handshake instead of after
+   * its response. If the handshake fails, the writes are sent again on the
+   * next stream, which starts from scratch if the error was permanent. Off by
+   * default until the backend's support for resumption is verified.
+   */
+  bool resume_write_stream = false;
+};
+
 class RemoteStore : public TargetMetadataProvider,
                     public WatchStreamCallback,
                     public WriteStreamCallback {
@@ -116,7 +153,8 @@ class RemoteStore : public TargetMetadataProvider,
   RemoteStore(FSTLocalStore* local_store,
               std::shared_ptr<Datastore> datastore,
               util::AsyncQueue* worker_queue,
-              std::function<void(model::OnlineState)> online_state_handler);
+              std::function<void(model::OnlineState)> online_state_handler,
+              WritePipelineOptions write_pipeline_options = {});
 
   void set_sync_engine(id<FSTRemoteSyncer> sync_engine) {
     sync_engine_ = sync_engine;
@@ -146,6 +184,12 @@ class RemoteStore : public TargetMetadataProvider,
    */
   void EnableNetwork();
 
+  /**
+   * Connects to the backend ahead of the first stream or RPC, unless the
+   * network is disabled.
+   */
+  void WarmUpConnection();
+
   /**
    * Tells the `RemoteStore` that the currently authenticated user has changed.
    *
@@ -182,9 +226,20 @@ class RemoteStore : public TargetMetadataProvider,
   // `Transaction` into lambdas.
   std::shared_ptr<core::Transaction> CreateTransaction();
 
+  /** Returns the traffic statistics of the RPCs made so far, by RPC name. */
+  RpcStatsMap GetRpcStats() const;
+
+  /**
+   * Adds the memory held by pending watch changes and by messages queued on
+   * the streams to `stats`.
+   */
+  void CollectMemoryStats(core::MemoryStats* stats,
+                          const core::DocumentSizer& sizer) const;
+
   model::DocumentKeySet GetRemoteKeysForTarget(
       model::TargetId target_id) const override;
   FSTQueryData* GetQueryDataForTarget(model::TargetId target_id) const override;
+  const model::DatabaseId& GetDatabaseId() const override;
 
   void OnWatchStreamOpen() override;
   void OnWatchStreamChange(
@@ -220,6 +275,27 @@ class RemoteStore : public TargetMetadataProvider,
    */
   bool CanAddToWritePipeline() const;
 
+  /**
+   * Sends the writes in the pipeline that haven't been sent on the current
+   * write stream yet, merging consecutive batches into a single request as
+   * allowed by the `WritePipelineOptions`. Does nothing if the write stream
+   * isn't ready.
+   */
+  void SendPendingWrites();
+
+  /**
+   * If tracing is enabled, starts timing the next step (e.g. waiting in the
+   * pipeline) of the batch on its way to the backend.
+   */
+  void StartWriteTrace(model::BatchId batch_id);
+
+  /**
+   * Exports the step of the batch started by the last `StartWriteTrace` or
+   * `EndWriteTrace` as a span named `name`. Starts timing the batch's next
+   * step if `next` is true.
+   */
+  void EndWriteTrace(const char* name, model::BatchId batch_id, bool next);
+
   void StartWriteStream();
 
   /**
@@ -229,7 +305,12 @@ class RemoteStore : public TargetMetadataProvider,
   bool ShouldStartWriteStream() const;
 
   void HandleHandshakeError(const util::Status& status);
-  void HandleWriteError(const util::Status& status);
+
+  /**
+   * Handles the failure of the oldest write request in flight, which merged
+   * `request_batch_count` batches.
+   */
+  void HandleWriteError(const util::Status& status, size_t request_batch_count);
 
   bool CanUseNetwork() const;
 
@@ -254,6 +335,9 @@ class RemoteStore : public TargetMetadataProvider,
   /** The client-side proxy for interacting with the backend. */
   std::shared_ptr<Datastore> datastore_;
 
+  /** The queue that transactions send their lookups from. */
+  util::AsyncQueue* worker_queue_ = nullptr;
+
   /**
    * A mapping of watched targets that the client cares about tracking and the
    * user has explicitly called a 'listen' for this target.
@@ -295,6 +379,34 @@ class RemoteStore : public TargetMetadataProvider,
    * the `write_pipeline_` as we receive responses.
    */
   std::vector<FSTMutationBatch*> write_pipeline_;
+
+  WritePipelineOptions write_pipeline_options_;
+
+  /**
+   * The number of batches at the front of `write_pipeline_` that have been
+   * sent on the current write stream.
+   */
+  size_t sent_batch_count_ = 0;
+
+  /**
+   * For every request sent on the current write stream and not yet
+   * acknowledged, in order, the number of batches it contains.
+   */
+  std::deque<size_t> request_batch_counts_;
+
+  /**
+   * Batches up to and including this ID are sent one per request. Set when a
+   * merged request fails permanently, so that the failing batch can be
+   * identified and rejected on its own when the writes are retried.
+   */
+  model::BatchId unmerged_through_batch_id_ = model::kBatchIdUnknown;
+
+  /**
+   * While tracing is enabled, when the current step of each batch in
+   * `write_pipeline_` started.
+   */
+  std::unordered_map<model::BatchId, util::TraceSpan::Clock::time_point>
+      write_trace_starts_;
 };
 
 }  // namespace remote
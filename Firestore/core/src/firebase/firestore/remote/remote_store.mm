@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/remote_store.h"
 
+#include <cstdint>
 #include <utility>
 
 #import "Firestore/Source/Local/FSTLocalStore.h"
@@ -27,10 +28,13 @@
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/trace_span.h"
 #include "absl/memory/memory.h"
+#include "absl/types/optional.h"
 
 using firebase::firestore::core::Transaction;
 using firebase::firestore::model::BatchId;
+using firebase::firestore::model::DatabaseId;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::OnlineState;
 using firebase::firestore::model::SnapshotVersion;
@@ -49,30 +53,34 @@ using firebase::firestore::remote::WatchTargetChange;
 using firebase::firestore::remote::WatchTargetChangeState;
 using firebase::firestore::util::AsyncQueue;
 using firebase::firestore::util::Status;
+using firebase::firestore::util::TraceSpan;
+using firebase::firestore::util::TraceSpanRecord;
 
 namespace firebase {
 namespace firestore {
 namespace remote {
 
-/**
- * The maximum number of pending writes to allow.
- * TODO(b/35853402): Negotiate this value with the backend.
- */
-constexpr int kMaxPendingWrites = 10;
-
 RemoteStore::RemoteStore(
     FSTLocalStore* local_store,
     std::shared_ptr<Datastore> datastore,
     AsyncQueue* worker_queue,
-    std::function<void(model::OnlineState)> online_state_handler)
+    std::function<void(model::OnlineState)> online_state_handler,
+    WritePipelineOptions write_pipeline_options)
     : local_store_{local_store},
       datastore_{std::move(datastore)},
-      online_state_tracker_{worker_queue, std::move(online_state_handler)} {
+      worker_queue_{worker_queue},
+      online_state_tracker_{worker_queue, std::move(online_state_handler)},
+      write_pipeline_options_{write_pipeline_options} {
+  HARD_ASSERT(write_pipeline_options_.max_pending_writes > 0 &&
+                  write_pipeline_options_.max_batches_per_request > 0,
+              "Invalid write pipeline options");
   datastore_->Start();
 
   // Create streams (but note they're not started yet)
   watch_stream_ = datastore_->CreateWatchStream(this);
   write_stream_ = datastore_->CreateWriteStream(this);
+  write_stream_->set_resumption_enabled(
+      write_pipeline_options_.resume_write_stream);
 }
 
 void RemoteStore::Start() {
@@ -99,6 +107,12 @@ void RemoteStore::EnableNetwork() {
   }
 }
 
+void RemoteStore::WarmUpConnection() {
+  if (CanUseNetwork()) {
+    datastore_->WarmUpConnection();
+  }
+}
+
 void RemoteStore::DisableNetwork() {
   is_network_enabled_ = false;
   DisableNetworkInternal();
@@ -116,6 +130,10 @@ void RemoteStore::DisableNetworkInternal() {
               write_pipeline_.size());
     write_pipeline_.clear();
   }
+  write_trace_starts_.clear();
+  sent_batch_count_ = 0;
+  request_batch_counts_.clear();
+  unmerged_through_batch_id_ = kBatchIdUnknown;
 
   CleanUpWatchStreamState();
 }
@@ -175,7 +193,16 @@ void RemoteStore::SendWatchRequest(FSTQueryData* query_data) {
   // We need to increment the the expected number of pending responses we're due
   // from watch so we wait for the ack to process any messages from this target.
   watch_change_aggregator_->RecordPendingTargetRequest(query_data.targetID);
-  watch_stream_->WatchQuery(query_data);
+
+  // When resuming, tell watch how many documents we know to match the target,
+  // so that it can send a bloom filter of the current ones along with an
+  // existence filter mismatch rather than making us re-listen from scratch.
+  absl::optional<int32_t> expected_count;
+  if (query_data.resumeToken.length > 0) {
+    expected_count = static_cast<int32_t>(
+        GetRemoteKeysForTarget(query_data.targetID).size());
+  }
+  watch_stream_->WatchQuery(query_data, expected_count);
 }
 
 void RemoteStore::SendUnwatchRequest(TargetId target_id) {
@@ -194,7 +221,8 @@ bool RemoteStore::ShouldStartWatchStream() const {
 void RemoteStore::StartWatchStream() {
   HARD_ASSERT(ShouldStartWatchStream(),
               "StartWatchStream called when ShouldStartWatchStream is false.");
-  watch_change_aggregator_ = absl::make_unique<WatchChangeAggregator>(this);
+  watch_change_aggregator_ =
+      absl::make_unique<WatchChangeAggregator>(this, datastore_->decode_pool());
   watch_stream_->Start();
 
   online_state_tracker_.HandleWatchStreamStart();
@@ -366,9 +394,13 @@ void RemoteStore::FillWritePipeline() {
       }
       break;
     }
-    AddToWritePipeline(batch);
+    // Hold off sending until the pipeline is full, so that consecutive
+    // batches can be merged.
+    write_pipeline_.push_back(batch);
+    StartWriteTrace(batch.batchID);
     last_batch_id_retrieved = batch.batchID;
   }
+  SendPendingWrites();
 
   if (ShouldStartWriteStream()) {
     StartWriteStream();
@@ -376,7 +408,9 @@ void RemoteStore::FillWritePipeline() {
 }
 
 bool RemoteStore::CanAddToWritePipeline() const {
-  return CanUseNetwork() && write_pipeline_.size() < kMaxPendingWrites;
+  return CanUseNetwork() &&
+         write_pipeline_.size() <
+             static_cast<size_t>(write_pipeline_options_.max_pending_writes);
 }
 
 void RemoteStore::AddToWritePipeline(FSTMutationBatch* batch) {
@@ -384,9 +418,71 @@ void RemoteStore::AddToWritePipeline(FSTMutationBatch* batch) {
               "AddToWritePipeline called when pipeline is full");
 
   write_pipeline_.push_back(batch);
+  StartWriteTrace(batch.batchID);
+  SendPendingWrites();
+}
+
+void RemoteStore::SendPendingWrites() {
+  if (!write_stream_->IsOpen() || !write_stream_->CanWriteMutations()) {
+    return;
+  }
+
+  const auto max_batches =
+      static_cast<size_t>(write_pipeline_options_.max_batches_per_request);
+  const auto max_mutations =
+      static_cast<size_t>(write_pipeline_options_.max_mutations_per_request);
+  while (sent_batch_count_ < write_pipeline_.size()) {
+    std::vector<FSTMutation*> mutations;
+    size_t batch_count = 0;
+    for (size_t i = sent_batch_count_; i < write_pipeline_.size(); ++i) {
+      FSTMutationBatch* batch = write_pipeline_[i];
+      if (batch_count > 0 &&
+          (batch_count >= max_batches ||
+           mutations.size() + batch.mutations.size() > max_mutations)) {
+        break;
+      }
+      mutations.insert(mutations.end(), batch.mutations.begin(),
+                       batch.mutations.end());
+      ++batch_count;
+      if (batch.batchID <= unmerged_through_batch_id_) {
+        break;
+      }
+    }
+
+    write_stream_->WriteMutations(mutations);
+    for (size_t i = 0; i < batch_count; ++i) {
+      EndWriteTrace("Waiting in the write pipeline",
+                    write_pipeline_[sent_batch_count_ + i].batchID,
+                    /*next=*/true);
+    }
+    request_batch_counts_.push_back(batch_count);
+    sent_batch_count_ += batch_count;
+  }
+}
+
+void RemoteStore::StartWriteTrace(BatchId batch_id) {
+  if (util::IsTracingEnabled()) {
+    write_trace_starts_[batch_id] = TraceSpan::Clock::now();
+  }
+}
+
+void RemoteStore::EndWriteTrace(const char* name, BatchId batch_id, bool next) {
+  auto found = write_trace_starts_.find(batch_id);
+  if (found == write_trace_starts_.end()) {
+    return;
+  }
+
+  TraceSpanRecord span;
+  span.name = name;
+  span.correlation_id = batch_id;
+  span.start = found->second;
+  span.end = TraceSpan::Clock::now();
+  util::ExportTraceSpan(span);
 
-  if (write_stream_->IsOpen() && write_stream_->handshake_complete()) {
-    write_stream_->WriteMutations(batch.mutations);
+  if (next) {
+    found->second = span.end;
+  } else {
+    write_trace_starts_.erase(found);
   }
 }
 
@@ -403,34 +499,69 @@ void RemoteStore::StartWriteStream() {
 
 void RemoteStore::OnWriteStreamOpen() {
   write_stream_->WriteHandshake();
+
+  // A resumed stream takes writes right away. If the handshake fails, they're
+  // sent again on the next stream, like any other writes in flight.
+  SendPendingWrites();
 }
 
 void RemoteStore::OnWriteStreamHandshakeComplete() {
   // Record the stream token.
   [local_store_ setLastStreamToken:write_stream_->GetLastStreamToken()];
 
-  // Send the write pipeline now that the stream is established.
-  for (FSTMutationBatch* write : write_pipeline_) {
-    write_stream_->WriteMutations(write.mutations);
-  }
+  // Send the write pipeline now that the stream is established. Nothing is in
+  // flight from earlier streams, since closing a stream resets the pipeline,
+  // but writes sent behind the handshake of a resumed stream may be.
+  SendPendingWrites();
 }
 
 void RemoteStore::OnWriteStreamMutationResult(
     SnapshotVersion commit_version,
     std::vector<FSTMutationResult*> mutation_results) {
   // This is a response to a write containing mutations and should be correlated
-  // to the first write in our write pipeline.
+  // to the first request in flight, which covers the first write(s) in our
+  // write pipeline.
   HARD_ASSERT(!write_pipeline_.empty(), "Got result for empty write pipeline");
 
-  FSTMutationBatch* batch = write_pipeline_.front();
-  write_pipeline_.erase(write_pipeline_.begin());
+  size_t batch_count = 1;
+  if (!request_batch_counts_.empty()) {
+    batch_count = request_batch_counts_.front();
+    request_batch_counts_.pop_front();
+  }
+  HARD_ASSERT(batch_count <= write_pipeline_.size(),
+              "Got result for %s batches but only %s are pending", batch_count,
+              write_pipeline_.size());
+
+  // Split the results of a merged request back into per-batch results. All
+  // writes of a request are committed at the same version.
+  auto results_begin = mutation_results.begin();
+  for (size_t i = 0; i < batch_count; ++i) {
+    FSTMutationBatch* batch = write_pipeline_.front();
+    write_pipeline_.erase(write_pipeline_.begin());
+    EndWriteTrace("Waiting for the write acknowledgement", batch.batchID,
+                  /*next=*/false);
+    if (sent_batch_count_ > 0) {
+      --sent_batch_count_;
+    }
 
-  FSTMutationBatchResult* batchResult = [FSTMutationBatchResult
-      resultWithBatch:batch
-        commitVersion:commit_version
-      mutationResults:std::move(mutation_results)
-          streamToken:write_stream_->GetLastStreamToken()];
-  [sync_engine_ applySuccessfulWriteWithResult:batchResult];
+    auto remaining =
+        static_cast<size_t>(mutation_results.end() - results_begin);
+    HARD_ASSERT(batch.mutations.size() <= remaining,
+                "Got %s mutation results for a batch of %s mutations",
+                remaining, batch.mutations.size());
+    auto results_end = results_begin + batch.mutations.size();
+    std::vector<FSTMutationResult*> batch_results{results_begin, results_end};
+    results_begin = results_end;
+
+    FSTMutationBatchResult* batchResult = [FSTMutationBatchResult
+        resultWithBatch:batch
+          commitVersion:commit_version
+        mutationResults:std::move(batch_results)
+            streamToken:write_stream_->GetLastStreamToken()];
+    [sync_engine_ applySuccessfulWriteWithResult:batchResult];
+  }
+  HARD_ASSERT(results_begin == mutation_results.end(),
+              "Got more mutation results than mutations sent");
 
   // It's possible that with the completion of this mutation another slot has
   // freed up.
@@ -445,6 +576,14 @@ void RemoteStore::OnWriteStreamClose(const Status& status) {
                 "Write stream was stopped gracefully while still needed.");
   }
 
+  // Anything in flight on the closed stream is re-sent once a new stream is
+  // established. Handling the error below may already start that stream, so
+  // this is reset first.
+  size_t failed_request_batch_count =
+      request_batch_counts_.empty() ? 1 : request_batch_counts_.front();
+  sent_batch_count_ = 0;
+  request_batch_counts_.clear();
+
   // If the write stream closed due to an error, invoke the error callbacks if
   // there are pending writes.
   if (!status.ok() && !write_pipeline_.empty()) {
@@ -452,7 +591,7 @@ void RemoteStore::OnWriteStreamClose(const Status& status) {
     // go/firestore-client-errors
     if (write_stream_->handshake_complete()) {
       // This error affects the actual writes.
-      HandleWriteError(status);
+      HandleWriteError(status, failed_request_batch_count);
     } else {
       // If there was an error before the handshake finished, it's possible that
       // the server is unable to process the stream token we're sending.
@@ -474,6 +613,9 @@ void RemoteStore::HandleHandshakeError(const Status& status) {
   // Reset the token if it's a permanent error, signaling the write stream is
   // no longer valid. Note that the handshake does not count as a write: see
   // comments on `Datastore::IsPermanentWriteError` for details.
+  // This also covers writes sent behind a resumed handshake: if one of them is
+  // rejected, the next stream starts from scratch and the error is then
+  // handled like that of any other write.
   if (Datastore::IsPermanentError(status)) {
     NSString* token =
         [write_stream_->GetLastStreamToken() base64EncodedStringWithOptions:0];
@@ -489,7 +631,8 @@ void RemoteStore::HandleHandshakeError(const Status& status) {
   }
 }
 
-void RemoteStore::HandleWriteError(const Status& status) {
+void RemoteStore::HandleWriteError(const Status& status,
+                                   size_t request_batch_count) {
   HARD_ASSERT(!status.ok(), "Handling write error with status OK.");
 
   // Only handle permanent errors here. If it's transient, just let the retry
@@ -498,10 +641,22 @@ void RemoteStore::HandleWriteError(const Status& status) {
     return;
   }
 
+  // If the failed request merged several batches, there's no telling which of
+  // them was the problem. Retry them one at a time (without backoff, as below)
+  // so that only the bad batch gets rejected.
+  if (request_batch_count > 1) {
+    unmerged_through_batch_id_ =
+        write_pipeline_[request_batch_count - 1].batchID;
+    write_stream_->InhibitBackoff();
+    return;
+  }
+
   // If this was a permanent error, the request itself was the problem so it's
   // not going to succeed if we resend it.
   FSTMutationBatch* batch = write_pipeline_.front();
   write_pipeline_.erase(write_pipeline_.begin());
+  EndWriteTrace("Waiting for the write acknowledgement", batch.batchID,
+                /*next=*/false);
 
   // In this case it's also unlikely that the server itself is melting
   // down--this was just a bad request so inhibit backoff on the next restart.
@@ -522,7 +677,21 @@ bool RemoteStore::CanUseNetwork() const {
 }
 
 std::shared_ptr<Transaction> RemoteStore::CreateTransaction() {
-  return std::make_shared<Transaction>(datastore_.get());
+  return std::make_shared<Transaction>(datastore_.get(), worker_queue_);
+}
+
+RpcStatsMap RemoteStore::GetRpcStats() const {
+  return datastore_->rpc_metrics().Snapshot();
+}
+
+void RemoteStore::CollectMemoryStats(core::MemoryStats* stats,
+                                     const core::DocumentSizer& sizer) const {
+  if (watch_change_aggregator_) {
+    stats->pending_watch_change_bytes +=
+        watch_change_aggregator_->EstimatePendingByteSize(sizer);
+  }
+  stats->stream_buffered_bytes +=
+      watch_stream_->GetBufferedBytes() + write_stream_->GetBufferedBytes();
 }
 
 DocumentKeySet RemoteStore::GetRemoteKeysForTarget(TargetId target_id) const {
@@ -534,6 +703,10 @@ FSTQueryData* RemoteStore::GetQueryDataForTarget(TargetId target_id) const {
   return found != listen_targets_.end() ? found->second : nil;
 }
 
+const DatabaseId& RemoteStore::GetDatabaseId() const {
+  return datastore_->database_info().database_id();
+}
+
 void RemoteStore::HandleCredentialChange() {
   if (CanUseNetwork()) {
     // Tear down and re-create our network streams. This will ensure we get a
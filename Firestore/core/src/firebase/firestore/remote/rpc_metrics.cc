@@ -0,0 +1,67 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/rpc_metrics.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace chr = std::chrono;
+
+void RpcMetrics::RecordStart(const std::string& rpc_name) {
+  Guard guard{mutex_};
+  ++stats_[rpc_name].starts;
+}
+
+void RpcMetrics::RecordMessageSent(const std::string& rpc_name,
+                                   size_t bytes) {
+  Guard guard{mutex_};
+  RpcStats& stats = stats_[rpc_name];
+  ++stats.messages_sent;
+  stats.bytes_sent += static_cast<int64_t>(bytes);
+}
+
+void RpcMetrics::RecordMessageReceived(const std::string& rpc_name,
+                                       size_t bytes) {
+  Guard guard{mutex_};
+  RpcStats& stats = stats_[rpc_name];
+  ++stats.messages_received;
+  stats.bytes_received += static_cast<int64_t>(bytes);
+}
+
+void RpcMetrics::RecordBackoff(const std::string& rpc_name,
+                               chr::milliseconds delay) {
+  Guard guard{mutex_};
+  RpcStats& stats = stats_[rpc_name];
+  ++stats.backoffs;
+  stats.total_backoff += delay;
+}
+
+void RpcMetrics::RecordLatency(const std::string& rpc_name,
+                               chr::milliseconds latency) {
+  Guard guard{mutex_};
+  stats_[rpc_name].latency.Record(latency);
+}
+
+RpcStatsMap RpcMetrics::Snapshot() const {
+  Guard guard{mutex_};
+  return stats_;
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_RPC_METRICS_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_RPC_METRICS_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/util/latency_histogram.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/** Traffic statistics of a single RPC endpoint. */
+struct RpcStats {
+  int64_t messages_sent = 0;
+  int64_t messages_received = 0;
+  int64_t bytes_sent = 0;
+  int64_t bytes_received = 0;
+
+  /** How many times the call (or the stream) was started. */
+  int64_t starts = 0;
+
+  /** How many times, and for how long overall, the stream backed off. */
+  int64_t backoffs = 0;
+  std::chrono::milliseconds total_backoff{0};
+
+  /**
+   * The time from sending a request to receiving its response. For the write
+   * stream, this is the time from sending a write to its acknowledgement.
+   */
+  util::LatencyHistogram latency;
+};
+
+/** Statistics of each RPC endpoint, keyed by endpoint name. */
+using RpcStatsMap = std::map<std::string, RpcStats>;
+
+using RpcStatsCallback = std::function<void(RpcStatsMap)>;
+
+/**
+ * Collects traffic statistics of the RPCs made by `Datastore`, keyed by RPC
+ * endpoint name (e.g. "Listen" or "Commit").
+ *
+ * Statistics are recorded on the worker queue but may be read from any
+ * thread, so all access is synchronized.
+ */
+class RpcMetrics {
+ public:
+  void RecordStart(const std::string& rpc_name);
+  void RecordMessageSent(const std::string& rpc_name, size_t bytes);
+  void RecordMessageReceived(const std::string& rpc_name, size_t bytes);
+  void RecordBackoff(const std::string& rpc_name,
+                     std::chrono::milliseconds delay);
+  void RecordLatency(const std::string& rpc_name,
+                     std::chrono::milliseconds latency);
+
+  /** Returns a copy of the statistics recorded so far. */
+  RpcStatsMap Snapshot() const;
+
+ private:
+  using Guard = std::lock_guard<std::mutex>;
+
+  mutable std::mutex mutex_;
+  RpcStatsMap stats_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_RPC_METRICS_H_
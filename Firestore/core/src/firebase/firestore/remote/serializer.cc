@@ -22,6 +22,7 @@
 #include <functional>
 #include <limits>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <utility>
@@ -35,6 +36,7 @@
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/no_document.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/arena.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
@@ -119,6 +121,7 @@ struct StructuredQuery {
   };
   // TODO(rsgowman): other submessages
 
+  std::vector<FieldPath> select;
   std::vector<CollectionSelector> from;
   // TODO(rsgowman): other fields
 };
@@ -144,12 +147,77 @@ FieldValue::Map DecodeFields(
   FieldValue::Map result;
   for (size_t i = 0; i < count; i++) {
     FieldValue::Map::value_type kv = DecodeFieldsEntry(reader, fields[i]);
-    result = result.insert(std::move(kv.first), std::move(kv.second));
+    result =
+        std::move(result).insert(std::move(kv.first), std::move(kv.second));
   }
 
   return result;
 }
 
+/**
+ * The fields of a Document proto, kept in their nanopb form until they are
+ * accessed through the ObjectValue built on top of them.
+ *
+ * Any decoding errors at that point are fatal since there is no longer a
+ * Reader to report them to.
+ */
+class LazyDocumentFields : public model::ObjectValueSource {
+ public:
+  /**
+   * Takes ownership of the fields of the given proto, which were decoded into
+   * `arena` if it is not null.
+   */
+  LazyDocumentFields(google_firestore_v1_Document* proto,
+                     std::shared_ptr<nanopb::Arena> arena)
+      : arena_{std::move(arena)} {
+    proto_.fields_count = proto->fields_count;
+    proto_.fields = proto->fields;
+    proto->fields_count = 0;
+    proto->fields = nullptr;
+  }
+
+  ~LazyDocumentFields() override {
+    // Fields decoded into an arena are freed with it.
+    if (!arena_) {
+      Serializer::FreeNanopbMessage(google_firestore_v1_Document_fields,
+                                    &proto_);
+    }
+  }
+
+  absl::optional<FieldValue> DecodeField(
+      absl::string_view name) const override {
+    // Later entries take precedence over earlier ones with the same key, as
+    // in DecodeFields.
+    for (size_t i = proto_.fields_count; i > 0; i--) {
+      const google_firestore_v1_Document_FieldsEntry& entry =
+          proto_.fields[i - 1];
+      if (entry.key != nullptr &&
+          absl::string_view(reinterpret_cast<const char*>(entry.key->bytes),
+                            entry.key->size) == name) {
+        Reader reader = Reader::Wrap(nullptr, 0);
+        FieldValue value = Serializer::DecodeFieldValue(&reader, entry.value);
+        HARD_ASSERT(reader.status().ok(), "Failed to decode field %s: %s",
+                    name, reader.status().ToString());
+        return value;
+      }
+    }
+    return absl::nullopt;
+  }
+
+  FieldValue::Map DecodeFields() const override {
+    Reader reader = Reader::Wrap(nullptr, 0);
+    FieldValue::Map result =
+        remote::DecodeFields(&reader, proto_.fields_count, proto_.fields);
+    HARD_ASSERT(reader.status().ok(), "Failed to decode fields: %s",
+                reader.status().ToString());
+    return result;
+  }
+
+ private:
+  google_firestore_v1_Document proto_{};
+  std::shared_ptr<nanopb::Arena> arena_;
+};
+
 google_firestore_v1_MapValue EncodeMapValue(const ObjectValue& object_value) {
   google_firestore_v1_MapValue result{};
 
@@ -177,7 +245,7 @@ FieldValue::Map DecodeMapValue(Reader* reader,
     FieldValue value =
         Serializer::DecodeFieldValue(reader, map_value.fields[i].value);
 
-    result = result.insert(key, value);
+    result = std::move(result).insert(key, value);
   }
 
   return result;
@@ -258,6 +326,11 @@ StructuredQuery DecodeStructuredQuery(
     const google_firestore_v1_StructuredQuery& proto) {
   StructuredQuery query{};
 
+  for (size_t i = 0; i < proto.select.fields_count; i++) {
+    query.select.push_back(FieldPath::FromServerFormat(
+        Serializer::DecodeString(proto.select.fields[i].field_path)));
+  }
+
   for (size_t i = 0; i < proto.from_count; i++) {
     query.from.push_back(DecodeCollectionSelector(proto.from[i]));
   }
@@ -386,9 +459,12 @@ FieldValue Serializer::DecodeFieldValue(Reader* reader,
     }
 
     case google_firestore_v1_Value_reference_value_tag:
-      // TODO(b/74243929): Implement remaining types.
-      HARD_FAIL("Unhandled message field number (tag): %i.",
-                msg.which_value_type);
+      // TODO(b/74243929): Implement remaining types. Until then, fail
+      // recoverably so that callers can fall back to the Objective-C
+      // serializer, which does handle references.
+      reader->Fail(StringFormat("Unhandled message field number (tag): %s.",
+                                msg.which_value_type));
+      return FieldValue::Null();
 
     case google_firestore_v1_Value_geo_point_value_tag:
       return FieldValue::FromGeoPoint(
@@ -443,7 +519,7 @@ DocumentKey Serializer::DecodeKey(Reader* reader,
 
   // Avoid assertion failures in DocumentKey if local_path is invalid.
   if (!reader->status().ok()) return DocumentKey{};
-  return DocumentKey{std::move(local_path)};
+  return DocumentKey::Interned(std::move(local_path));
 }
 
 google_firestore_v1_Document Serializer::EncodeDocument(
@@ -527,16 +603,41 @@ std::unique_ptr<model::NoDocument> Serializer::DecodeMissingDocument(
                                        /*hasCommittedMutations=*/false);
 }
 
+std::unique_ptr<Document> Serializer::DecodeDocumentLazily(
+    Reader* reader,
+    google_firestore_v1_Document* proto,
+    DocumentState state) const {
+  // Validate the keys up front, as DecodeFields would, since the values are
+  // only decoded later.
+  for (size_t i = 0; i < proto->fields_count; i++) {
+    if (DecodeString(proto->fields[i].key).empty()) {
+      reader->Fail(
+          "Invalid message: Empty key while decoding a Map field value.");
+      return nullptr;
+    }
+  }
+
+  SnapshotVersion version = DecodeSnapshotVersion(reader, proto->update_time);
+  DocumentKey key = DecodeKey(reader, DecodeString(proto->name));
+  if (!reader->status().ok()) return nullptr;
+
+  return absl::make_unique<Document>(
+      ObjectValue::FromSource(
+          std::make_shared<LazyDocumentFields>(proto, reader->arena())),
+      std::move(key), std::move(version), state);
+}
+
 std::unique_ptr<Document> Serializer::DecodeDocument(
-    Reader* reader, const google_firestore_v1_Document& proto) const {
+    Reader* reader,
+    const google_firestore_v1_Document& proto,
+    DocumentState state) const {
   FieldValue::Map fields_internal =
       DecodeFields(reader, proto.fields_count, proto.fields);
   SnapshotVersion version = DecodeSnapshotVersion(reader, proto.update_time);
 
   return absl::make_unique<Document>(
       ObjectValue::FromMap(std::move(fields_internal)),
-      DecodeKey(reader, DecodeString(proto.name)), std::move(version),
-      DocumentState::kSynced);
+      DecodeKey(reader, DecodeString(proto.name)), std::move(version), state);
 }
 
 google_firestore_v1_Write Serializer::EncodeMutation(
@@ -759,6 +860,19 @@ google_firestore_v1_Target_QueryTarget Serializer::EncodeQueryTarget(
     result.structured_query.from_count = 0;
   }
 
+  // Encode the projection.
+  if (query.HasProjection()) {
+    const std::vector<FieldPath>& projection = query.projection();
+    auto count = static_cast<pb_size_t>(projection.size());
+    result.structured_query.select.fields_count = count;
+    result.structured_query.select.fields =
+        MakeArray<google_firestore_v1_StructuredQuery_FieldReference>(count);
+    for (pb_size_t i = 0; i < count; i++) {
+      result.structured_query.select.fields[i].field_path =
+          EncodeString(projection[i].CanonicalString());
+    }
+  }
+
   // Encode the filters.
   if (!query.filters().empty()) {
     // TODO(rsgowman): Implement
@@ -817,7 +931,7 @@ Query Serializer::DecodeQueryTarget(
   // TODO(rsgowman): Dencode the startat.
   // TODO(rsgowman): Dencode the endat.
 
-  return Query(path, {});
+  return Query(path, {}, std::move(query.select));
 }
 
 std::string Serializer::EncodeQueryPath(const ResourcePath& path) const {
@@ -192,8 +192,27 @@ class Serializer {
   google_firestore_v1_Target_QueryTarget EncodeQueryTarget(
       const core::Query& query) const;
 
+  /**
+   * Decodes a Document proto. The returned document is in the given `state`;
+   * documents sent by the backend are synced.
+   */
   std::unique_ptr<model::Document> DecodeDocument(
-      nanopb::Reader* reader, const google_firestore_v1_Document& proto) const;
+      nanopb::Reader* reader,
+      const google_firestore_v1_Document& proto,
+      model::DocumentState state = model::DocumentState::kSynced) const;
+
+  /**
+   * Like DecodeDocument, but moves the fields out of the proto and only
+   * decodes them as they are accessed. The caller still needs to free the
+   * remainder of the proto.
+   *
+   * Only use this for trusted input, such as local storage: errors in field
+   * values are only detected when the field is accessed and are then fatal.
+   */
+  std::unique_ptr<model::Document> DecodeDocumentLazily(
+      nanopb::Reader* reader,
+      google_firestore_v1_Document* proto,
+      model::DocumentState state = model::DocumentState::kSynced) const;
 
   static google_protobuf_Timestamp EncodeVersion(
       const model::SnapshotVersion& version);
@@ -17,20 +17,25 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_STREAM_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_STREAM_H_
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <string>
 
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
 #include "Firestore/core/src/firebase/firestore/auth/token.h"
+#include "Firestore/core/src/firebase/firestore/remote/connectivity_monitor.h"
 #include "Firestore/core/src/firebase/firestore/remote/exponential_backoff.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_stream.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
+#include "Firestore/core/src/firebase/firestore/remote/rpc_metrics.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/any.h"
+#include "absl/types/optional.h"
 #include "grpcpp/support/byte_buffer.h"
 
 namespace firebase {
@@ -158,6 +163,11 @@ class Stream : public GrpcStreamObserver,
    */
   virtual bool IsOpen() const;
 
+  /**
+   * The size of the messages waiting to be written to the underlying stream.
+   */
+  size_t GetBufferedBytes() const;
+
   /**
    * After an error, the stream will usually back off on the next attempt to
    * start it. If the error warrants an immediate restart of the stream, the
@@ -168,12 +178,19 @@ class Stream : public GrpcStreamObserver,
    */
   void InhibitBackoff();
 
+  /**
+   * Makes the stream record its traffic, restarts and backoffs in the given
+   * `metrics` under the given RPC name. Must be called before the stream is
+   * started.
+   */
+  void SetRpcMetrics(RpcMetrics* metrics, std::string rpc_name);
+
   /**
    * Marks this stream as idle. If no further actions are performed on the
-   * stream for one minute, the stream will automatically close itself and
-   * notify the stream's `OnClose` handler with Status::OK. The stream will then
-   * be in a non-started state, requiring the caller to start the stream again
-   * before further use.
+   * stream for one minute (five minutes while on Wi-Fi), the stream will
+   * automatically close itself and notify the stream's `OnClose` handler with
+   * Status::OK. The stream will then be in a non-started state, requiring the
+   * caller to start the stream again before further use.
    *
    * Only streams that are in state 'Open' can be marked idle, as all other
    * states imply pending network operations.
@@ -191,12 +208,30 @@ class Stream : public GrpcStreamObserver,
   void OnStreamStart() override;
   void OnStreamRead(const grpc::ByteBuffer& message) override;
   void OnStreamFinish(const util::Status& status) override;
+  absl::any DecodeStreamRead(const grpc::ByteBuffer& message) override;
+  void OnStreamDecodedRead(const grpc::ByteBuffer& message,
+                           const absl::any& decoded) override;
 
  protected:
   // `Stream` expects all its methods to be called on the worker queue.
   void EnsureOnQueue() const;
   void Write(grpc::ByteBuffer&& message);
   std::string GetDebugDescription() const;
+  util::AsyncQueue* worker_queue() const {
+    return worker_queue_;
+  }
+
+  /**
+   * Closes the stream after a response from the server couldn't be handled,
+   * for subclasses that handle responses outside of `NotifyStreamResponse`.
+   */
+  void CloseDueToResponseError(const util::Status& status);
+
+  /**
+   * Records the time between sending a request and receiving its response, if
+   * the stream is instrumented.
+   */
+  void RecordLatency(std::chrono::milliseconds latency);
 
   ExponentialBackoff backoff_;
 
@@ -209,6 +244,17 @@ class Stream : public GrpcStreamObserver,
   virtual void NotifyStreamOpen() = 0;
   virtual util::Status NotifyStreamResponse(
       const grpc::ByteBuffer& message) = 0;
+  // Invoked on the gRPC polling thread; must not touch any state owned by the
+  // worker queue. The result is passed to `NotifyDecodedStreamResponse`. By
+  // default, no decoding happens off the worker queue.
+  virtual absl::any DecodeStreamResponse(
+      const grpc::ByteBuffer& /*message*/) {
+    return {};
+  }
+  virtual util::Status NotifyDecodedStreamResponse(
+      const grpc::ByteBuffer& message, const absl::any& /*decoded*/) {
+    return NotifyStreamResponse(message);
+  }
   virtual void NotifyStreamClose(const util::Status& status) = 0;
   // PORTING NOTE: C++ cannot rely on RTTI, unlike other platforms.
   virtual std::string GetDebugName() const = 0;
@@ -223,6 +269,10 @@ class Stream : public GrpcStreamObserver,
   void BackoffAndTryRestarting();
   void StopDueToIdleness();
 
+  /** The network status last reported by the connectivity monitor, if any. */
+  absl::optional<ConnectivityMonitor::NetworkStatus> CurrentNetworkStatus()
+      const;
+
   State state_ = State::Initial;
 
   std::unique_ptr<GrpcStream> grpc_stream_;
@@ -232,8 +282,14 @@ class Stream : public GrpcStreamObserver,
   GrpcConnection* grpc_connection_ = nullptr;
 
   util::TimerId idle_timer_id_{};
+
+  // Used to tell whether the stream failed after a change of network.
+  absl::optional<ConnectivityMonitor::NetworkStatus> network_status_at_start_;
   util::DelayedOperation idleness_timer_;
 
+  RpcMetrics* rpc_metrics_ = nullptr;
+  std::string rpc_name_;
+
   // Used to prevent auth if the stream happens to be restarted before token is
   // received.
   int close_count_ = 0;
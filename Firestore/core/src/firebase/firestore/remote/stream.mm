@@ -50,6 +50,13 @@ const AsyncQueue::Milliseconds kBackoffMaxDelay{std::chrono::seconds(60)};
 /** The time a stream stays open after it is marked idle. */
 const AsyncQueue::Milliseconds kIdleTimeout{std::chrono::seconds(60)};
 
+/**
+ * The time a stream stays open after it is marked idle while on Wi-Fi, where
+ * keeping the connection around is cheap compared to re-establishing it (a TLS
+ * handshake and re-sending all the listens).
+ */
+const AsyncQueue::Milliseconds kIdleTimeoutOnWifi{std::chrono::minutes(5)};
+
 }  // namespace
 
 Stream::Stream(AsyncQueue* worker_queue,
@@ -72,6 +79,11 @@ bool Stream::IsOpen() const {
   return state_ == State::Open;
 }
 
+size_t Stream::GetBufferedBytes() const {
+  EnsureOnQueue();
+  return grpc_stream_ ? grpc_stream_->buffered_bytes() : 0;
+}
+
 bool Stream::IsStarted() const {
   EnsureOnQueue();
   return state_ == State::Starting || state_ == State::Backoff || IsOpen();
@@ -91,6 +103,10 @@ void Stream::Start() {
 
   HARD_ASSERT(state_ == State::Initial, "Already started");
   state_ = State::Starting;
+  network_status_at_start_ = CurrentNetworkStatus();
+  if (rpc_metrics_) {
+    rpc_metrics_->RecordStart(rpc_name_);
+  }
 
   RequestCredentials();
 }
@@ -155,14 +171,25 @@ void Stream::BackoffAndTryRestarting() {
               "Should only perform backoff in an error case");
 
   state_ = State::Backoff;
-  backoff_.BackoffAndRun([this] {
+  auto restart = [this] {
     HARD_ASSERT(state_ == State::Backoff,
                 "Backoff elapsed but state is now: %s", state_);
 
     state_ = State::Initial;
     Start();
     HARD_ASSERT(IsStarted(), "Stream should have started.");
-  });
+  };
+
+  // Attempts made while the device is offline are bound to fail and say
+  // nothing about the backend, so they shouldn't lengthen the delay of the
+  // attempts made once the device is back online.
+  AsyncQueue::Milliseconds delay =
+      CurrentNetworkStatus() == ConnectivityMonitor::NetworkStatus::Unavailable
+          ? backoff_.BackoffWithoutEscalationAndRun(restart)
+          : backoff_.BackoffAndRun(restart);
+  if (rpc_metrics_) {
+    rpc_metrics_->RecordBackoff(rpc_name_, delay);
+  }
 }
 
 void Stream::InhibitBackoff() {
@@ -182,8 +209,12 @@ void Stream::MarkIdle() {
   EnsureOnQueue();
 
   if (IsOpen() && !idleness_timer_) {
+    AsyncQueue::Milliseconds timeout =
+        CurrentNetworkStatus() == ConnectivityMonitor::NetworkStatus::Available
+            ? kIdleTimeoutOnWifi
+            : kIdleTimeout;
     idleness_timer_ = worker_queue_->EnqueueAfterDelay(
-        kIdleTimeout, idle_timer_id_, [this] { Stop(); });
+        timeout, idle_timer_id_, [this] { Stop(); });
   }
 }
 
@@ -195,9 +226,21 @@ void Stream::CancelIdleCheck() {
 // Read/write
 
 void Stream::OnStreamRead(const grpc::ByteBuffer& message) {
+  OnStreamDecodedRead(message, absl::any{});
+}
+
+absl::any Stream::DecodeStreamRead(const grpc::ByteBuffer& message) {
+  return DecodeStreamResponse(message);
+}
+
+void Stream::OnStreamDecodedRead(const grpc::ByteBuffer& message,
+                                 const absl::any& decoded) {
   EnsureOnQueue();
 
   HARD_ASSERT(IsStarted(), "OnStreamRead called for a stopped stream.");
+  if (rpc_metrics_) {
+    rpc_metrics_->RecordMessageReceived(rpc_name_, message.Length());
+  }
 
   if (bridge::IsLoggingEnabled()) {
     LOG_DEBUG("%s headers (whitelisted): %s", GetDebugDescription(),
@@ -205,16 +248,23 @@ void Stream::OnStreamRead(const grpc::ByteBuffer& message) {
                   grpc_stream_->GetResponseHeaders()));
   }
 
-  Status read_status = NotifyStreamResponse(message);
+  Status read_status = decoded.has_value()
+                           ? NotifyDecodedStreamResponse(message, decoded)
+                           : NotifyStreamResponse(message);
   if (!read_status.ok()) {
-    grpc_stream_->FinishImmediately();
-    // Don't expect gRPC to produce status -- since the error happened on the
-    // client, we have all the information we need.
-    OnStreamFinish(read_status);
-    return;
+    CloseDueToResponseError(read_status);
   }
 }
 
+void Stream::CloseDueToResponseError(const Status& status) {
+  EnsureOnQueue();
+
+  grpc_stream_->FinishImmediately();
+  // Don't expect gRPC to produce status -- since the error happened on the
+  // client, we have all the information we need.
+  OnStreamFinish(status);
+}
+
 // Stopping
 
 void Stream::Stop() {
@@ -287,9 +337,23 @@ void Stream::HandleErrorStatus(const Status& status) {
     // "unauthenticated" error means the token was rejected. Try force
     // refreshing it in case it just expired.
     credentials_provider_->InvalidateToken();
+  } else if (CurrentNetworkStatus() != network_status_at_start_ &&
+             CurrentNetworkStatus() !=
+                 ConnectivityMonitor::NetworkStatus::Unavailable) {
+    // The stream most likely failed because the network changed (which resets
+    // all the calls) rather than because of the backend, and the new network
+    // is usable, so retry right away.
+    LOG_DEBUG("%s Network changed, retrying without delay",
+              GetDebugDescription());
+    backoff_.Reset();
   }
 }
 
+absl::optional<ConnectivityMonitor::NetworkStatus>
+Stream::CurrentNetworkStatus() const {
+  return grpc_connection_->connectivity_monitor()->status();
+}
+
 void Stream::OnStreamFinish(const Status& status) {
   EnsureOnQueue();
   // TODO(varconst): log error here?
@@ -310,9 +374,23 @@ void Stream::Write(grpc::ByteBuffer&& message) {
   HARD_ASSERT(IsOpen(), "Cannot write when the stream is not open.");
 
   CancelIdleCheck();
+  if (rpc_metrics_) {
+    rpc_metrics_->RecordMessageSent(rpc_name_, message.Length());
+  }
   grpc_stream_->Write(std::move(message));
 }
 
+void Stream::SetRpcMetrics(RpcMetrics* metrics, std::string rpc_name) {
+  rpc_metrics_ = metrics;
+  rpc_name_ = std::move(rpc_name);
+}
+
+void Stream::RecordLatency(std::chrono::milliseconds latency) {
+  if (rpc_metrics_) {
+    rpc_metrics_->RecordLatency(rpc_name_, latency);
+  }
+}
+
 std::string Stream::GetDebugDescription() const {
   EnsureOnQueue();
   return StringFormat("%s (%s)", GetDebugName(), this);
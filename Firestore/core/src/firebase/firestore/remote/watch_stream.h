@@ -21,11 +21,15 @@
 #error "This header only supports Objective-C++"
 #endif  // !defined(__OBJC__)
 
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <string>
 
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/decode_pool.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
 #include "Firestore/core/src/firebase/firestore/remote/stream.h"
@@ -33,6 +37,8 @@
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/any.h"
+#include "absl/types/optional.h"
 #include "grpcpp/support/byte_buffer.h"
 
 #import "Firestore/Source/Core/FSTTypes.h"
@@ -85,15 +91,18 @@ class WatchStream : public Stream {
               auth::CredentialsProvider* credentials_provider,
               FSTSerializerBeta* serializer,
               GrpcConnection* grpc_connection,
-              WatchStreamCallback* callback);
+              WatchStreamCallback* callback,
+              DecodePool* decode_pool = nullptr);
 
   /**
    * Registers interest in the results of the given query. If the query includes
-   * a resume token, it will be included in the request. Results that affect the
-   * query will be streamed back as WatchChange messages that reference the
-   * target ID included in `query`.
+   * a resume token, it will be included in the request, along with
+   * `expected_count`, the number of documents the client knows to match the
+   * query as of that token. Results that affect the query will be streamed back
+   * as WatchChange messages that reference the target ID included in `query`.
    */
-  virtual /*virtual for tests only*/ void WatchQuery(FSTQueryData* query);
+  virtual /*virtual for tests only*/ void WatchQuery(
+      FSTQueryData* query, absl::optional<int32_t> expected_count);
 
   /**
    * Unregisters interest in the results of the query associated with the given
@@ -103,12 +112,30 @@ class WatchStream : public Stream {
       model::TargetId target_id);
 
  private:
+  // The result of decoding a response off the worker queue. The other fields
+  // may only be read once `is_decoded` is set.
+  struct DecodedResponse {
+    std::atomic<bool> is_decoded{false};
+    util::Status status;
+    GCFSListenResponse* proto = nil;
+    std::unique_ptr<WatchChange> change;
+    model::SnapshotVersion version;
+  };
+
+  static void Decode(const bridge::WatchStreamSerializer& serializer,
+                     const grpc::ByteBuffer& message,
+                     DecodedResponse* result);
+  util::Status DeliverDecodedResponses();
+
   std::unique_ptr<GrpcStream> CreateGrpcStream(
       GrpcConnection* grpc_connection, const auth::Token& token) override;
   void TearDown(GrpcStream* grpc_stream) override;
 
   void NotifyStreamOpen() override;
   util::Status NotifyStreamResponse(const grpc::ByteBuffer& message) override;
+  absl::any DecodeStreamResponse(const grpc::ByteBuffer& message) override;
+  util::Status NotifyDecodedStreamResponse(const grpc::ByteBuffer& message,
+                                           const absl::any& decoded) override;
   void NotifyStreamClose(const util::Status& status) override;
 
   std::string GetDebugName() const override {
@@ -117,6 +144,13 @@ class WatchStream : public Stream {
 
   bridge::WatchStreamSerializer serializer_bridge_;
   WatchStreamCallback* callback_;
+
+  // If set, responses are decoded in parallel on the pool rather than one by
+  // one on the gRPC polling thread.
+  DecodePool* decode_pool_ = nullptr;
+  // Responses in the order they were received, some of which may still be
+  // being decoded. They are only passed on to `callback_` in this order.
+  std::deque<std::shared_ptr<DecodedResponse>> pending_responses_;
 };
 
 }  // namespace remote
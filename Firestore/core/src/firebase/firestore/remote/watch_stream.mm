@@ -16,6 +16,9 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
 
+#include <memory>
+#include <utility>
+
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
@@ -37,17 +40,21 @@ WatchStream::WatchStream(AsyncQueue* async_queue,
                          CredentialsProvider* credentials_provider,
                          FSTSerializerBeta* serializer,
                          GrpcConnection* grpc_connection,
-                         WatchStreamCallback* callback)
+                         WatchStreamCallback* callback,
+                         DecodePool* decode_pool)
     : Stream{async_queue, credentials_provider, grpc_connection,
              TimerId::ListenStreamConnectionBackoff, TimerId::ListenStreamIdle},
       serializer_bridge_{serializer},
-      callback_{NOT_NULL(callback)} {
+      callback_{NOT_NULL(callback)},
+      decode_pool_{decode_pool} {
 }
 
-void WatchStream::WatchQuery(FSTQueryData* query) {
+void WatchStream::WatchQuery(FSTQueryData* query,
+                             absl::optional<int32_t> expected_count) {
   EnsureOnQueue();
 
-  GCFSListenRequest* request = serializer_bridge_.CreateWatchRequest(query);
+  GCFSListenRequest* request =
+      serializer_bridge_.CreateWatchRequest(query, expected_count);
   LOG_DEBUG("%s watch: %s", GetDebugDescription(),
             serializer_bridge_.Describe(request));
   Write(serializer_bridge_.ToByteBuffer(request));
@@ -78,28 +85,106 @@ void WatchStream::NotifyStreamOpen() {
 }
 
 Status WatchStream::NotifyStreamResponse(const grpc::ByteBuffer& message) {
-  Status status;
-  GCFSListenResponse* response =
-      serializer_bridge_.ParseResponse(message, &status);
-  if (!status.ok()) {
-    return status;
+  auto decoded = std::make_shared<DecodedResponse>();
+  Decode(serializer_bridge_, message, decoded.get());
+  return NotifyDecodedStreamResponse(message, decoded);
+}
+
+absl::any WatchStream::DecodeStreamResponse(const grpc::ByteBuffer& message) {
+  // Parsing and converting large listen responses (e.g., the initial results
+  // for a big query) is CPU-bound, so keep it off the worker queue.
+  auto decoded = std::make_shared<DecodedResponse>();
+  if (!decode_pool_) {
+    Decode(serializer_bridge_, message, decoded.get());
+    return decoded;
   }
 
-  if (bridge::IsLoggingEnabled()) {
-    LOG_DEBUG("%s response: %s", GetDebugDescription(),
-              serializer_bridge_.Describe(response));
+  // Hand the response over to the pool, so that the polling thread can move on
+  // right away and consecutive responses can be decoded in parallel.
+  // `pending_responses_` restores the order in which they were received.
+  std::weak_ptr<Stream> weak_this{shared_from_this()};
+  AsyncQueue* queue = worker_queue();
+  bridge::WatchStreamSerializer serializer = serializer_bridge_;
+  decode_pool_->Execute([weak_this, queue, serializer, message, decoded] {
+    Decode(serializer, message, decoded.get());
+
+    queue->Enqueue([weak_this] {
+      auto strong_this =
+          std::static_pointer_cast<WatchStream>(weak_this.lock());
+      if (!strong_this || !strong_this->IsOpen()) {
+        return;
+      }
+      Status status = strong_this->DeliverDecodedResponses();
+      if (!status.ok()) {
+        strong_this->CloseDueToResponseError(status);
+      }
+    });
+  });
+  return decoded;
+}
+
+void WatchStream::Decode(const bridge::WatchStreamSerializer& serializer,
+                         const grpc::ByteBuffer& message,
+                         DecodedResponse* result) {
+#if FIRESTORE_NATIVE_STREAM_SERIALIZATION
+  if (serializer.DecodeResponse(message, &result->change, &result->version)) {
+    if (bridge::IsLoggingEnabled()) {
+      // Only needed to describe the response in the debug log.
+      Status ignored;
+      result->proto = serializer.ParseResponse(message, &ignored);
+    }
+    result->is_decoded = true;
+    return;
   }
+#endif  // FIRESTORE_NATIVE_STREAM_SERIALIZATION
 
-  // A successful response means the stream is healthy.
-  backoff_.Reset();
+  result->proto = serializer.ParseResponse(message, &result->status);
+  if (result->status.ok()) {
+    result->change = serializer.ToWatchChange(result->proto);
+    result->version = serializer.ToSnapshotVersion(result->proto);
+  }
+  result->is_decoded = true;
+}
+
+Status WatchStream::NotifyDecodedStreamResponse(
+    const grpc::ByteBuffer& /*message*/, const absl::any& decoded) {
+  const auto* response =
+      absl::any_cast<std::shared_ptr<DecodedResponse>>(&decoded);
+  HARD_ASSERT(response, "WatchStream received an undecoded response");
+  pending_responses_.push_back(*response);
+  return DeliverDecodedResponses();
+}
 
-  callback_->OnWatchStreamChange(
-      *serializer_bridge_.ToWatchChange(response),
-      serializer_bridge_.ToSnapshotVersion(response));
+Status WatchStream::DeliverDecodedResponses() {
+  EnsureOnQueue();
+
+  // Note that the callback may close the stream, which clears
+  // `pending_responses_`.
+  while (!pending_responses_.empty() &&
+         pending_responses_.front()->is_decoded) {
+    std::shared_ptr<DecodedResponse> response =
+        std::move(pending_responses_.front());
+    pending_responses_.pop_front();
+    if (!response->status.ok()) {
+      return response->status;
+    }
+
+    if (bridge::IsLoggingEnabled()) {
+      LOG_DEBUG("%s response: %s", GetDebugDescription(),
+                serializer_bridge_.Describe(response->proto));
+    }
+
+    // A successful response means the stream is healthy.
+    backoff_.Reset();
+
+    callback_->OnWatchStreamChange(*response->change, response->version);
+  }
   return Status::OK();
 }
 
 void WatchStream::NotifyStreamClose(const Status& status) {
+  // Responses that are still being decoded belong to the closed stream.
+  pending_responses_.clear();
   callback_->OnWatchStreamClose(status);
 }
 
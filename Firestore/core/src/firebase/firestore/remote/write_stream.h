@@ -22,6 +22,8 @@
 #endif  // !defined(__OBJC__)
 
 #import <Foundation/Foundation.h>
+#include <chrono>  // NOLINT(build/c++11)
+#include <deque>
 #include <memory>
 #include <string>
 #include <vector>
@@ -94,6 +96,11 @@ class WriteStreamCallback {
  * submitting multiple batches of mutations at the same time, it's
  * okay to use the same stream token for the calls to `WriteMutations`.
  *
+ * If resumption is enabled and an earlier stream is known, the handshake
+ * resumes that stream at its last stream token instead. The server then
+ * accepts mutations carrying that token right away, so they can be written
+ * right behind the handshake without waiting for its response.
+ *
  * This class is not intended as a base class; all virtual methods exist only
  * for the sake of tests.
  */
@@ -124,6 +131,26 @@ class WriteStream : public Stream {
     return handshake_complete_;
   }
 
+  /**
+   * Whether mutations may be written: once the handshake has completed, or
+   * right after it if it resumed an earlier stream.
+   */
+  bool CanWriteMutations() const {
+    return handshake_complete_ || resuming_;
+  }
+
+  /**
+   * Sets whether handshakes resume the last stream when possible, saving a
+   * round trip before mutations can be written each time the stream
+   * restarts. Off by default.
+   */
+  void set_resumption_enabled(bool enabled) {
+    resumption_enabled_ = enabled;
+  }
+  bool resumption_enabled() const {
+    return resumption_enabled_;
+  }
+
   /**
    * Sends an initial stream token to the server, performing the handshake
    * required to make the StreamingWrite RPC work.
@@ -139,6 +166,17 @@ class WriteStream : public Stream {
     handshake_complete_ = value;
   }
 
+  // For tests only
+  void UpdateLastStreamToken(GCFSWriteResponse* response) {
+    serializer_bridge_.UpdateLastStreamToken(response);
+  }
+
+  /**
+   * Creates the handshake of the current stream, which resumes the last stream
+   * if resumption is enabled and possible.
+   */
+  GCFSWriteRequest* CreateHandshake();
+
  private:
   std::unique_ptr<GrpcStream> CreateGrpcStream(
       GrpcConnection* grpc_connection, const auth::Token& token) override;
@@ -152,9 +190,19 @@ class WriteStream : public Stream {
     return "WriteStream";
   }
 
+  void WriteRequest(GCFSWriteRequest* request);
+
   bridge::WriteStreamSerializer serializer_bridge_;
   WriteStreamCallback* callback_ = nullptr;
   bool handshake_complete_ = false;
+  bool resumption_enabled_ = false;
+
+  // Whether the handshake of the current stream resumed an earlier one.
+  bool resuming_ = false;
+
+  // When each request awaiting a response was sent. The backend responds to
+  // write requests in order, one response per request.
+  std::deque<std::chrono::steady_clock::time_point> pending_request_times_;
 };
 
 }  // namespace remote
@@ -56,25 +56,36 @@ void WriteStream::WriteHandshake() {
   HARD_ASSERT(IsOpen(), "Writing handshake requires an opened stream");
   HARD_ASSERT(!handshake_complete(), "Handshake already completed");
 
-  GCFSWriteRequest* request = serializer_bridge_.CreateHandshake();
+  GCFSWriteRequest* request = CreateHandshake();
   LOG_DEBUG("%s initial request: %s", GetDebugDescription(),
             serializer_bridge_.Describe(request));
-  Write(serializer_bridge_.ToByteBuffer(request));
+  WriteRequest(request);
+}
 
-  // TODO(dimond): Support stream resumption. We intentionally do not set the
-  // stream token on the handshake, ignoring any stream token we might have.
+GCFSWriteRequest* WriteStream::CreateHandshake() {
+  // TODO(dimond): Support stream resumption. Resumption is off by default, in
+  // which case we intentionally do not set the stream token on the handshake,
+  // ignoring any stream token we might have.
+  resuming_ = resumption_enabled_ && serializer_bridge_.CanResumeStream();
+  return resuming_ ? serializer_bridge_.CreateResumeHandshake()
+                   : serializer_bridge_.CreateHandshake();
 }
 
 void WriteStream::WriteMutations(const std::vector<FSTMutation*>& mutations) {
   EnsureOnQueue();
   HARD_ASSERT(IsOpen(), "Writing mutations requires an opened stream");
-  HARD_ASSERT(handshake_complete(),
+  HARD_ASSERT(CanWriteMutations(),
               "Handshake must be complete before writing mutations");
 
   GCFSWriteRequest* request =
       serializer_bridge_.CreateWriteMutationsRequest(mutations);
   LOG_DEBUG("%s write request: %s", GetDebugDescription(),
             serializer_bridge_.Describe(request));
+  WriteRequest(request);
+}
+
+void WriteStream::WriteRequest(GCFSWriteRequest* request) {
+  pending_request_times_.push_back(std::chrono::steady_clock::now());
   Write(serializer_bridge_.ToByteBuffer(request));
 }
 
@@ -105,6 +116,8 @@ void WriteStream::NotifyStreamClose(const Status& status) {
   // Delegate's logic might depend on whether handshake was completed, so only
   // reset it after notifying.
   handshake_complete_ = false;
+  resuming_ = false;
+  pending_request_times_.clear();
 }
 
 Status WriteStream::NotifyStreamResponse(const grpc::ByteBuffer& message) {
@@ -121,6 +134,12 @@ Status WriteStream::NotifyStreamResponse(const grpc::ByteBuffer& message) {
   // Always capture the last stream token.
   serializer_bridge_.UpdateLastStreamToken(response);
 
+  if (!pending_request_times_.empty()) {
+    RecordLatency(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - pending_request_times_.front()));
+    pending_request_times_.pop_front();
+  }
+
   if (!handshake_complete()) {
     // The first response is the handshake response
     handshake_complete_ = true;
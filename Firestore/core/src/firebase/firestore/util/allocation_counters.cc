@@ -0,0 +1,90 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/allocation_counters.h"
+
+#include <atomic>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+#if defined(FIRESTORE_COUNT_ALLOCATIONS)
+struct AtomicCounts {
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> bytes{0};
+};
+
+// Zero-initialized before any code runs, so allocations made by static
+// initializers are counted too.
+AtomicCounts counts[kAllocationSubsystemCount];
+#endif
+
+}  // namespace
+
+const char* AllocationSubsystemName(AllocationSubsystem subsystem) {
+  switch (subsystem) {
+    case AllocationSubsystem::kImmutable:
+      return "immutable";
+    case AllocationSubsystem::kModel:
+      return "model";
+    case AllocationSubsystem::kNanopb:
+      return "nanopb";
+    case AllocationSubsystem::kLocal:
+      return "local";
+  }
+  return "unknown";
+}
+
+#if defined(FIRESTORE_COUNT_ALLOCATIONS)
+
+void CountAllocation(AllocationSubsystem subsystem, size_t bytes) {
+  AtomicCounts& counted = counts[static_cast<int>(subsystem)];
+  counted.allocations.fetch_add(1, std::memory_order_relaxed);
+  counted.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+AllocationCounts GetAllocationCounts(AllocationSubsystem subsystem) {
+  const AtomicCounts& counted = counts[static_cast<int>(subsystem)];
+  AllocationCounts result;
+  result.allocations = counted.allocations.load(std::memory_order_relaxed);
+  result.bytes = counted.bytes.load(std::memory_order_relaxed);
+  return result;
+}
+
+void ResetAllocationCounts() {
+  for (AtomicCounts& counted : counts) {
+    counted.allocations.store(0, std::memory_order_relaxed);
+    counted.bytes.store(0, std::memory_order_relaxed);
+  }
+}
+
+#else  // !defined(FIRESTORE_COUNT_ALLOCATIONS)
+
+AllocationCounts GetAllocationCounts(AllocationSubsystem) {
+  return AllocationCounts{};
+}
+
+void ResetAllocationCounts() {
+}
+
+#endif  // defined(FIRESTORE_COUNT_ALLOCATIONS)
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ALLOCATION_COUNTERS_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ALLOCATION_COUNTERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * The parts of the core whose allocations are counted. Only their hot paths
+ * are instrumented:
+ *
+ *   - `kImmutable`: the nodes of sorted maps and sets.
+ *   - `kModel`: the boxed values of `FieldValue`s and the paths of keys.
+ *   - `kNanopb`: the memory of decoded and encoded protos.
+ *   - `kLocal`: the pending changes of LevelDB transactions.
+ */
+enum class AllocationSubsystem {
+  kImmutable,
+  kModel,
+  kNanopb,
+  kLocal,
+};
+
+constexpr int kAllocationSubsystemCount = 4;
+
+/** Returns a short, lowercase name for the given subsystem. */
+const char* AllocationSubsystemName(AllocationSubsystem subsystem);
+
+/** The number of allocations made by a subsystem, and their total size. */
+struct AllocationCounts {
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+};
+
+/**
+ * Whether allocations are counted at all. Counting is compiled in only when
+ * `FIRESTORE_COUNT_ALLOCATIONS` is defined, since even relaxed atomic
+ * increments show up on the paths it instruments.
+ */
+#if defined(FIRESTORE_COUNT_ALLOCATIONS)
+constexpr bool kAllocationCountingEnabled = true;
+#else
+constexpr bool kAllocationCountingEnabled = false;
+#endif
+
+#if defined(FIRESTORE_COUNT_ALLOCATIONS)
+/** Counts an allocation of `bytes` bytes made by `subsystem`. Thread-safe. */
+void CountAllocation(AllocationSubsystem subsystem, size_t bytes);
+#else
+inline void CountAllocation(AllocationSubsystem, size_t) {
+}
+#endif
+
+/**
+ * Returns the allocations counted for `subsystem` since the process started,
+ * or since the last call to `ResetAllocationCounts`. Always zero if counting
+ * is compiled out.
+ */
+AllocationCounts GetAllocationCounts(AllocationSubsystem subsystem);
+
+/** Resets the counts of every subsystem to zero. */
+void ResetAllocationCounts();
+
+/**
+ * A standard allocator that counts its allocations against `Subsystem` and
+ * otherwise defers to `std::allocator`. Intended for `std::allocate_shared`
+ * and node-based containers.
+ */
+template <typename T, AllocationSubsystem Subsystem>
+class CountingAllocator {
+ public:
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = CountingAllocator<U, Subsystem>;
+  };
+
+  CountingAllocator() = default;
+
+  template <typename U>
+  CountingAllocator(  // NOLINT(runtime/explicit)
+      const CountingAllocator<U, Subsystem>&) noexcept {
+  }
+
+  T* allocate(size_t n) {
+    CountAllocation(Subsystem, n * sizeof(T));
+    return std::allocator<T>{}.allocate(n);
+  }
+
+  void deallocate(T* pointer, size_t n) noexcept {
+    std::allocator<T>{}.deallocate(pointer, n);
+  }
+
+  friend bool operator==(const CountingAllocator&, const CountingAllocator&) {
+    return true;
+  }
+
+  friend bool operator!=(const CountingAllocator&, const CountingAllocator&) {
+    return false;
+  }
+};
+
+/**
+ * Like `std::make_shared`, but counts the allocation against `Subsystem`.
+ */
+template <AllocationSubsystem Subsystem, typename T, typename... Args>
+std::shared_ptr<T> MakeCountedShared(Args&&... args) {
+  return std::allocate_shared<T>(CountingAllocator<T, Subsystem>{},
+                                 std::forward<Args>(args)...);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ALLOCATION_COUNTERS_H_
@@ -16,6 +16,9 @@
 
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 
+#include <algorithm>
+#include <functional>
+#include <string>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -25,9 +28,44 @@ namespace firebase {
 namespace firestore {
 namespace util {
 
+constexpr size_t AsyncQueue::kPriorityCount;
+
+namespace chr = std::chrono;
+
+namespace {
+
+const char* TimerIdLabel(const TimerId timer_id) {
+  switch (timer_id) {
+    case TimerId::All:
+      return "All";
+    case TimerId::ListenStreamIdle:
+      return "ListenStreamIdle";
+    case TimerId::ListenStreamConnectionBackoff:
+      return "ListenStreamConnectionBackoff";
+    case TimerId::WriteStreamIdle:
+      return "WriteStreamIdle";
+    case TimerId::WriteStreamConnectionBackoff:
+      return "WriteStreamConnectionBackoff";
+    case TimerId::OnlineStateTimeout:
+      return "OnlineStateTimeout";
+    case TimerId::GarbageCollectionDelay:
+      return "GarbageCollectionDelay";
+    case TimerId::CoalescedSnapshotsDelay:
+      return "CoalescedSnapshotsDelay";
+    case TimerId::GroupCommitDelay:
+      return "GroupCommitDelay";
+    case TimerId::SnapshotExportDelay:
+      return "SnapshotExportDelay";
+  }
+  UNREACHABLE();
+}
+
+}  // namespace
+
 AsyncQueue::AsyncQueue(std::unique_ptr<Executor> executor)
     : executor_{std::move(executor)} {
   is_operation_in_progress_ = false;
+  instrumentation_enabled_ = false;
 }
 
 // TODO(varconst): assert in destructor that the queue is empty.
@@ -59,18 +97,75 @@ void AsyncQueue::ExecuteBlocking(const Operation& operation) {
   is_operation_in_progress_ = false;
 }
 
-void AsyncQueue::Enqueue(const Operation& operation) {
+void AsyncQueue::Enqueue(Operation&& operation) {
+  Enqueue(Priority::Normal, std::move(operation));
+}
+
+void AsyncQueue::Enqueue(const Priority priority,
+                         Operation&& operation,
+                         const absl::string_view label) {
   VerifySequentialOrder();
-  EnqueueRelaxed(operation);
+  EnqueueRelaxed(priority, std::move(operation), label);
+}
+
+void AsyncQueue::EnqueueRelaxed(Operation&& operation) {
+  EnqueueRelaxed(Priority::Normal, std::move(operation));
 }
 
-void AsyncQueue::EnqueueRelaxed(const Operation& operation) {
-  executor_->Execute(Wrap(operation));
+void AsyncQueue::EnqueueRelaxed(const Priority priority,
+                                Operation&& operation,
+                                const absl::string_view label) {
+  Operation wrapped = Wrap(std::move(operation), label);
+  {
+    std::lock_guard<std::mutex> lock{lanes_mutex_};
+    lanes_[static_cast<size_t>(priority)].push_back(std::move(wrapped));
+  }
+
+  // The executor itself is FIFO, so it is only asked to run "the next pending
+  // operation"; which one that is gets decided once it is time to run it.
+  // Background work is still run with a lower quality of service, so that
+  // while the queue has nothing else to do, it doesn't compete with the app
+  // for the CPU.
+  using QualityOfService = Executor::QualityOfService;
+  QualityOfService qos = priority == Priority::Background
+                             ? QualityOfService::Utility
+                             : QualityOfService::UserInitiated;
+  executor_->ExecuteWithQos(qos, [this] { RunNextPending(); });
+}
+
+void AsyncQueue::EnqueueBackgroundSteps(const Step& step,
+                                        const absl::string_view label) {
+  std::string label_copy{label};
+  EnqueueRelaxed(
+      Priority::Background,
+      [this, step, label_copy] {
+        if (step()) {
+          EnqueueBackgroundSteps(step, label_copy);
+        }
+      },
+      label);
+}
+
+void AsyncQueue::RunNextPending() {
+  Operation next;
+  {
+    std::lock_guard<std::mutex> lock{lanes_mutex_};
+    for (std::deque<Operation>& lane : lanes_) {
+      if (!lane.empty()) {
+        next = std::move(lane.front());
+        lane.pop_front();
+        break;
+      }
+    }
+  }
+
+  HARD_ASSERT(next, "Expected a pending operation on the queue");
+  next();
 }
 
 DelayedOperation AsyncQueue::EnqueueAfterDelay(const Milliseconds delay,
                                                const TimerId timer_id,
-                                               const Operation& operation) {
+                                               Operation&& operation) {
   VerifyIsCurrentExecutor();
 
   // While not necessarily harmful, we currently don't expect to have multiple
@@ -79,16 +174,57 @@ DelayedOperation AsyncQueue::EnqueueAfterDelay(const Milliseconds delay,
   HARD_ASSERT(!IsScheduled(timer_id),
               "Attempted to schedule multiple operations with id %s", timer_id);
 
-  Executor::TaggedOperation tagged{static_cast<int>(timer_id), Wrap(operation)};
+  Executor::TaggedOperation tagged{
+      static_cast<int>(timer_id),
+      Wrap(std::move(operation), TimerIdLabel(timer_id), delay)};
   return executor_->Schedule(delay, std::move(tagged));
 }
 
-AsyncQueue::Operation AsyncQueue::Wrap(const Operation& operation) {
+AsyncQueue::Operation AsyncQueue::Wrap(Operation&& operation,
+                                       const absl::string_view label,
+                                       const Milliseconds delay) {
   // Decorator pattern: wrap `operation` into a call to `ExecuteBlocking` to
   // ensure that it doesn't spawn any nested operations.
 
-  // Note: can't move `operation` into lambda until C++14.
-  return [this, operation] { ExecuteBlocking(operation); };
+  // TODO(c++14): move `operation` into lambda instead of binding it.
+  if (!instrumentation_enabled_) {
+    return std::bind(
+        [this](const Operation& bound) { ExecuteBlocking(bound); },
+        std::move(operation));
+  }
+
+  std::string label_copy{label};
+  const Clock::time_point ready = Clock::now() + delay;
+  return std::bind(
+      [this, label_copy, ready](const Operation& bound) {
+        const Clock::time_point start = Clock::now();
+        ExecuteBlocking(bound);
+        const Clock::time_point end = Clock::now();
+
+        // Operations run in advance (in tests) start before they become due.
+        RecordOperation(label_copy,
+                        std::max(start - ready, Clock::duration{0}),
+                        end - start);
+      },
+      std::move(operation));
+}
+
+void AsyncQueue::SetInstrumentationEnabled(const bool enabled) {
+  instrumentation_enabled_ = enabled;
+}
+
+AsyncQueue::OperationStatsMap AsyncQueue::GetOperationStats() const {
+  std::lock_guard<std::mutex> lock{stats_mutex_};
+  return stats_;
+}
+
+void AsyncQueue::RecordOperation(const std::string& label,
+                                 const Clock::duration queue_delay,
+                                 const Clock::duration run_duration) {
+  std::lock_guard<std::mutex> lock{stats_mutex_};
+  OperationStats& stats = stats_[label];
+  stats.queue_delay.Record(chr::duration_cast<Milliseconds>(queue_delay));
+  stats.run_duration.Record(chr::duration_cast<Milliseconds>(run_duration));
 }
 
 void AsyncQueue::VerifySequentialOrder() const {
@@ -102,9 +238,9 @@ void AsyncQueue::VerifySequentialOrder() const {
 
 // Test-only functions
 
-void AsyncQueue::EnqueueBlocking(const Operation& operation) {
+void AsyncQueue::EnqueueBlocking(Operation&& operation) {
   VerifySequentialOrder();
-  executor_->ExecuteBlocking(Wrap(operation));
+  executor_->ExecuteBlocking(Wrap(std::move(operation)));
 }
 
 bool AsyncQueue::IsScheduled(const TimerId timer_id) const {
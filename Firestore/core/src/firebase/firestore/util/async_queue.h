@@ -17,12 +17,19 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ASYNC_QUEUE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ASYNC_QUEUE_H_
 
+#include <array>
 #include <atomic>
 #include <chrono>  // NOLINT(build/c++11)
+#include <deque>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
 
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/latency_histogram.h"
+#include "absl/strings/string_view.h"
 
 namespace firebase {
 namespace firestore {
@@ -57,13 +64,33 @@ enum class TimerId {
   /**
    * A timer used to periodically attempt LRU Garbage collection
    */
-  GarbageCollectionDelay
+  GarbageCollectionDelay,
+  /**
+   * A timer used by the event manager to raise the events of listeners that
+   * coalesce snapshots.
+   */
+  CoalescedSnapshotsDelay,
+  /**
+   * A timer used to write the commits that local persistence held back for
+   * group commit.
+   */
+  GroupCommitDelay,
+  /**
+   * A timer used to periodically export a snapshot of local persistence for
+   * read-only instances in other processes.
+   */
+  SnapshotExportDelay
 };
 
 // A serial queue that executes given operations asynchronously, one at a time.
 // Operations may be scheduled to be executed as soon as possible or in the
 // future. Operations scheduled for the same time are FIFO-ordered.
 //
+// Operations enqueued for execution as soon as possible are given a
+// `Priority`. Whenever the queue is ready to run its next operation, it picks
+// the oldest operation of the highest priority that has any pending. Within a
+// single priority, operations are FIFO-ordered.
+//
 // `AsyncQueue` wraps a platform-specific executor, adding checks that enforce
 // sequential ordering of operations: an enqueued operation, while being run,
 // normally cannot enqueue other operations for immediate execution (but see
@@ -73,6 +100,12 @@ enum class TimerId {
 // invoked on the queue or not; check "preconditions" section in comments on
 // each method.
 //
+// Optionally, `AsyncQueue` measures how long each operation waited on the queue
+// and how long it ran, aggregated by a label the caller supplies when
+// enqueueing it (operations scheduled with a `TimerId` are labeled after it).
+// This makes it possible to tell which kind of operation is responsible for
+// stalling the queue.
+//
 // A significant portion of `AsyncQueue` interface only exists for test purposes
 // and must *not* be used in regular code.
 class AsyncQueue {
@@ -80,6 +113,33 @@ class AsyncQueue {
   using Operation = Executor::Operation;
   using Milliseconds = Executor::Milliseconds;
 
+  // A single step of a long-running background task. Returns whether the task
+  // has more steps to run.
+  using Step = std::function<bool()>;
+
+  // The classes of operations, from the most to the least urgent.
+  enum class Priority {
+    // Work a user is actively waiting on, such as applying local writes.
+    Interactive,
+    // The default for all operations.
+    Normal,
+    // Maintenance that can be postponed, such as garbage collection.
+    Background,
+  };
+
+  // Timing statistics of all the operations run under a single label.
+  struct OperationStats {
+    // The time from enqueueing an operation (for delayed operations, from the
+    // time it became due) until it started running.
+    LatencyHistogram queue_delay;
+    // The time an operation took to run.
+    LatencyHistogram run_duration;
+  };
+
+  // Statistics keyed by operation label. Operations enqueued without a label
+  // are recorded under the empty label.
+  using OperationStatsMap = std::map<std::string, OperationStats>;
+
   explicit AsyncQueue(std::unique_ptr<Executor> executor);
 
   // Asserts for the caller that it is being invoked as part of an operation on
@@ -95,10 +155,27 @@ class AsyncQueue {
   // be called by a previously enqueued operation when it is run (as a special
   // case, destructors invoked when an enqueued operation has run and is being
   // destroyed may invoke `Enqueue`).
-  void Enqueue(const Operation& operation);
+  void Enqueue(Operation&& operation);
+
+  // Like `Enqueue`, but `operation` is run ahead of any pending operations of
+  // lower `priority`. If instrumentation is enabled, the timing of `operation`
+  // is recorded under `label`.
+  void Enqueue(Priority priority,
+               Operation&& operation,
+               absl::string_view label = {});
 
   // Like `Enqueue`, but without applying any prerequisite checks.
-  void EnqueueRelaxed(const Operation& operation);
+  void EnqueueRelaxed(Operation&& operation);
+  void EnqueueRelaxed(Priority priority,
+                      Operation&& operation,
+                      absl::string_view label = {});
+
+  // Runs `step` with `Priority::Background` repeatedly until it returns false.
+  // Each step is enqueued anew after the previous one finishes, so any
+  // operation of higher priority enqueued in the meantime runs in between.
+  //
+  // Like `EnqueueRelaxed`, this may be invoked from an operation on the queue.
+  void EnqueueBackgroundSteps(const Step& step, absl::string_view label = {});
 
   // Puts the `operation` on the queue to be executed `delay` milliseconds from
   // now, and returns a handle that allows to cancel the operation (provided it
@@ -114,7 +191,7 @@ class AsyncQueue {
   // queue.
   DelayedOperation EnqueueAfterDelay(Milliseconds delay,
                                      TimerId timer_id,
-                                     const Operation& operation);
+                                     Operation&& operation);
 
   // Direct execution
 
@@ -136,13 +213,24 @@ class AsyncQueue {
     return executor_.get();
   }
 
+  // Instrumentation
+
+  // Starts or stops recording the timing of operations. Only operations
+  // enqueued while instrumentation is enabled are recorded. Disabled by
+  // default.
+  void SetInstrumentationEnabled(bool enabled);
+
+  // Returns a copy of the statistics recorded so far. May be called from any
+  // thread.
+  OperationStatsMap GetOperationStats() const;
+
   // Test-only interface follows
   // TODO(varconst): move the test-only interface into a helper object that is
   // a friend of AsyncQueue and delegates its public methods to private methods
   // on AsyncQueue.
 
   // Like `Enqueue`, but blocks until the `operation` is complete.
-  void EnqueueBlocking(const Operation& operation);
+  void EnqueueBlocking(Operation&& operation);
 
   // Checks whether an operation tagged with `timer_id` is currently scheduled
   // for execution in the future.
@@ -156,7 +244,26 @@ class AsyncQueue {
   void RunScheduledOperationsUntil(TimerId last_timer_id);
 
  private:
-  Operation Wrap(const Operation& operation);
+  static constexpr size_t kPriorityCount =
+      static_cast<size_t>(Priority::Background) + 1;
+
+  using Clock = std::chrono::steady_clock;
+
+  // Wraps `operation` to verify sequential order and, if instrumentation is
+  // enabled, record its timing under `label`. The operation is expected to
+  // become runnable `delay` from now.
+  Operation Wrap(Operation&& operation,
+                 absl::string_view label = {},
+                 Milliseconds delay = Milliseconds{0});
+
+  void RecordOperation(const std::string& label,
+                       Clock::duration queue_delay,
+                       Clock::duration run_duration);
+
+  // Runs the most urgent operation pending in `lanes_`. Every operation added
+  // to the lanes is matched by exactly one call to this function on the
+  // executor.
+  void RunNextPending();
 
   // Asserts that the current invocation happens asynchronously on the queue.
   void VerifyIsCurrentExecutor() const;
@@ -164,6 +271,14 @@ class AsyncQueue {
 
   std::atomic<bool> is_operation_in_progress_;
   std::unique_ptr<Executor> executor_;
+
+  // Operations waiting to run, indexed by `Priority`.
+  std::mutex lanes_mutex_;
+  std::array<std::deque<Operation>, kPriorityCount> lanes_;
+
+  std::atomic<bool> instrumentation_enabled_;
+  mutable std::mutex stats_mutex_;
+  OperationStatsMap stats_;
 };
 
 }  // namespace util
@@ -16,10 +16,14 @@
 
 #include "Firestore/core/src/firebase/firestore/util/autoid.h"
 
-#include <random>
+#include <array>
+#include <cstdint>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
+#include "absl/base/config.h"
 
 namespace firebase {
 namespace firestore {
@@ -31,26 +35,90 @@ const int kAutoIdLength = 20;
 const char kAutoIdAlphabet[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
 
-SecureRandom shared_random;
+// -1 because sizeof(kAutoIdAlphabet) includes the trailing null terminator.
+const uint8_t kAlphabetSize = sizeof(kAutoIdAlphabet) - 1;
 
-}  // namespace
+static_assert(kAlphabetSize <= 64, "Indices must fit into 6 bits");
 
-std::string CreateAutoId() {
-  std::string auto_id;
-  auto_id.reserve(kAutoIdLength);
+/**
+ * Random bytes fetched from SecureRandom in bulk. Depending on the platform,
+ * every call into the underlying generator may cost a system call or a trip
+ * through OpenSSL, so fetching a few bytes at a time dominates the cost of
+ * generating IDs.
+ */
+class RandomPool {
+ public:
+  /** Returns a uniformly distributed random index into kAutoIdAlphabet. */
+  uint8_t NextIndex() {
+    // Rejection sampling: draw 6 bits at a time and retry the few values that
+    // fall outside the alphabet, which avoids any modulo bias.
+    for (;;) {
+      if (position_ == bytes_.size()) {
+        SecureRandom{}.Fill(bytes_.data(), bytes_.size());
+        position_ = 0;
+      }
+      uint8_t index = bytes_[position_++] & 0x3F;
+      if (index < kAlphabetSize) {
+        return index;
+      }
+    }
+  }
 
-  // -2 here because:
-  //   * sizeof(kAutoIdAlphabet) includes the trailing null terminator
-  //   * uniform_int_distribution is inclusive on both sizes
-  std::uniform_int_distribution<int> letters(0, sizeof(kAutoIdAlphabet) - 2);
+ private:
+  std::array<uint8_t, 4096> bytes_;
+  size_t position_ = bytes_.size();
+};
 
+void AppendAutoId(RandomPool* pool, std::string* auto_id) {
   for (int i = 0; i < kAutoIdLength; i++) {
-    int rand_index = letters(shared_random);
-    auto_id.append(1, kAutoIdAlphabet[rand_index]);
+    auto_id->push_back(kAutoIdAlphabet[pool->NextIndex()]);
   }
+}
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+
+// Each thread draws from its own pool so that generating IDs never contends
+// on a lock.
+template <typename F>
+void WithRandomPool(const F& action) {
+  static thread_local RandomPool pool;
+  action(&pool);
+}
+
+#else
+
+// On platforms without `thread_local` (notably iOS 8) threads share a single
+// pool.
+template <typename F>
+void WithRandomPool(const F& action) {
+  static std::mutex* mutex = new std::mutex();
+  static RandomPool* pool = new RandomPool();
+  std::lock_guard<std::mutex> lock{*mutex};
+  action(pool);
+}
+
+#endif  // defined(ABSL_HAVE_THREAD_LOCAL)
+
+}  // namespace
+
+std::string CreateAutoId() {
+  std::string auto_id;
+  auto_id.reserve(kAutoIdLength);
+  WithRandomPool([&](RandomPool* pool) { AppendAutoId(pool, &auto_id); });
   return auto_id;
 }
 
+std::vector<std::string> CreateAutoIds(size_t count) {
+  std::vector<std::string> auto_ids(count);
+  WithRandomPool([&](RandomPool* pool) {
+    for (std::string& auto_id : auto_ids) {
+      auto_id.reserve(kAutoIdLength);
+      AppendAutoId(pool, &auto_id);
+    }
+  });
+  return auto_ids;
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
@@ -17,7 +17,9 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_AUTOID_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_AUTOID_H_
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 namespace firebase {
 namespace firestore {
@@ -26,6 +28,10 @@ namespace util {
 // Generates a random ID suitable for use as a document ID.
 std::string CreateAutoId();
 
+// Generates `count` random IDs at once, more cheaply than calling
+// CreateAutoId() `count` times.
+std::vector<std::string> CreateAutoIds(size_t count);
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
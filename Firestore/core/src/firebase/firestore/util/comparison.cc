@@ -64,6 +64,57 @@ ComparisonResult Comparator<std::vector<uint8_t>>::Compare(
   return ComparisonResult::Same;
 }
 
+#if defined(__APPLE__)
+
+namespace {
+
+/**
+ * Maps a UTF-16 code unit to a value that orders code units the way their
+ * code points are ordered. Surrogates encode code points above U+FFFF, so they
+ * have to sort after U+E000..U+FFFF rather than before.
+ */
+int32_t CodePointOrder(UniChar unit) {
+  if (unit >= 0xD800) {
+    return unit >= 0xE000 ? unit - 0x800 : unit + 0x2000;
+  }
+  return unit;
+}
+
+}  // namespace
+
+ComparisonResult CompareUtf8(CFStringRef left, CFStringRef right) {
+  CFIndex left_length = CFStringGetLength(left);
+  CFIndex right_length = CFStringGetLength(right);
+
+  // CoreFoundation can only hand out its storage as UTF-8 if the contents are
+  // ASCII, in which case there is one byte per code unit.
+  const char* left_bytes = CFStringGetCStringPtr(left, kCFStringEncodingUTF8);
+  const char* right_bytes = CFStringGetCStringPtr(right, kCFStringEncodingUTF8);
+  if (left_bytes && right_bytes) {
+    return Compare<absl::string_view>(
+        absl::string_view{left_bytes, static_cast<size_t>(left_length)},
+        absl::string_view{right_bytes, static_cast<size_t>(right_length)});
+  }
+
+  CFStringInlineBuffer left_buffer;
+  CFStringInlineBuffer right_buffer;
+  CFStringInitInlineBuffer(left, &left_buffer, CFRangeMake(0, left_length));
+  CFStringInitInlineBuffer(right, &right_buffer, CFRangeMake(0, right_length));
+
+  CFIndex min_length = std::min(left_length, right_length);
+  for (CFIndex i = 0; i < min_length; ++i) {
+    UniChar left_unit = CFStringGetCharacterFromInlineBuffer(&left_buffer, i);
+    UniChar right_unit = CFStringGetCharacterFromInlineBuffer(&right_buffer, i);
+    if (left_unit != right_unit) {
+      return Compare<int32_t>(CodePointOrder(left_unit),
+                              CodePointOrder(right_unit));
+    }
+  }
+  return Compare<int64_t>(left_length, right_length);
+}
+
+#endif  // defined(__APPLE__)
+
 ComparisonResult Comparator<double>::Compare(double left, double right) const {
   // NaN sorts equal to itself and before any other number.
   if (left < right) {
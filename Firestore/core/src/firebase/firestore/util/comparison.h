@@ -153,13 +153,23 @@ struct Comparator<std::string> {
                            const std::string& right) const;
 };
 
+#if defined(__APPLE__)
+/**
+ * Compares two CFStrings in the order of their UTF-8 encodings, which is the
+ * order of their Unicode code points and the order used by the backend (and
+ * by `Comparator<absl::string_view>`).
+ *
+ * Neither string is converted or copied: ASCII contents are compared with
+ * `memcmp` and anything else by walking the UTF-16 code units in place.
+ */
+ComparisonResult CompareUtf8(CFStringRef left, CFStringRef right);
+#endif  // defined(__APPLE__)
+
 #if __OBJC__
 template <>
 struct Comparator<NSString*> {
   ComparisonResult Compare(NSString* left, NSString* right) const {
-    // Delegate to the string_view implementation so these are consistent.
-    Comparator<absl::string_view> delegate;
-    return delegate.Compare(MakeString(left), MakeString(right));
+    return CompareUtf8((__bridge CFStringRef)left, (__bridge CFStringRef)right);
   }
 };
 #endif  // __OBJC__
@@ -22,6 +22,7 @@
 #include <string>
 #include <utility>
 
+#include "Firestore/core/src/firebase/firestore/util/move_only_function.h"
 #include "absl/types/optional.h"
 
 namespace firebase {
@@ -74,9 +75,22 @@ class DelayedOperation {
 class Executor {
  public:
   using Tag = int;
-  using Operation = std::function<void()>;
+  // Operations are move-only, so that whatever they capture is moved, never
+  // copied, on its way to being executed.
+  using Operation = MoveOnlyFunction<void()>;
   using Milliseconds = std::chrono::milliseconds;
 
+  // How urgently an operation needs to run, for executors on platforms that
+  // schedule threads accordingly. It never changes the order in which
+  // operations run.
+  enum class QualityOfService {
+    // Work a user is waiting on, such as writes and delivering snapshots.
+    UserInitiated,
+    // Work that may take a while without anyone noticing, such as garbage
+    // collection.
+    Utility,
+  };
+
   // Operations scheduled for future execution have an opaque tag. The value of
   // the tag is ignored by the executor but can be used to find operations with
   // a given tag after they are scheduled.
@@ -96,6 +110,13 @@ class Executor {
   // Schedules the `operation` to be asynchronously executed as soon as
   // possible, in FIFO order.
   virtual void Execute(Operation&& operation) = 0;
+  // Like `Execute`, but hints that `operation` should run with the given
+  // quality of service. Executors that can't act on the hint run `operation`
+  // exactly like `Execute` does.
+  virtual void ExecuteWithQos(QualityOfService qos, Operation&& operation) {
+    (void)qos;
+    Execute(std::move(operation));
+  }
   // Like `Execute`, but blocks until the `operation` finishes, consequently
   // draining immediate operations from the executor.
   virtual void ExecuteBlocking(Operation&& operation) = 0;
@@ -44,10 +44,18 @@ namespace internal {
 // Generic wrapper over `dispatch_async_f`, providing `dispatch_async`-like
 // interface: accepts an arbitrary invocable object in place of an Objective-C
 // block.
-void DispatchAsync(dispatch_queue_t queue, std::function<void()>&& work);
+void DispatchAsync(dispatch_queue_t queue, Executor::Operation&& work);
+
+// Like `DispatchAsync`, but runs `work` with the given QoS class even if the
+// queue has a different one. On a serial queue, work still runs in the order
+// it was dispatched; work of a higher class raises the class of the work
+// ahead of it until it has run.
+void DispatchAsync(dispatch_queue_t queue,
+                   qos_class_t qos_class,
+                   Executor::Operation&& work);
 
 // Similar to `DispatchAsync` but wraps `dispatch_sync_f`.
-void DispatchSync(dispatch_queue_t queue, std::function<void()> work);
+void DispatchSync(dispatch_queue_t queue, Executor::Operation work);
 
 }  // namespace internal
 
@@ -65,6 +73,7 @@ class ExecutorLibdispatch : public Executor {
   std::string Name() const override;
 
   void Execute(Operation&& operation) override;
+  void ExecuteWithQos(QualityOfService qos, Operation&& operation) override;
   void ExecuteBlocking(Operation&& operation) override;
   DelayedOperation Schedule(Milliseconds delay,
                             TaggedOperation&& operation) override;
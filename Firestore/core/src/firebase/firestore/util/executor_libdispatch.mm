@@ -47,19 +47,33 @@ absl::string_view GetCurrentQueueLabel() {
 
 namespace internal {
 
-void DispatchAsync(const dispatch_queue_t queue, std::function<void()>&& work) {
+void DispatchAsync(const dispatch_queue_t queue, Executor::Operation&& work) {
   // Dynamically allocate the function to make sure the object is valid by the
   // time libdispatch gets to it.
-  const auto wrap = new std::function<void()>{std::move(work)};
+  const auto wrap = new Executor::Operation{std::move(work)};
 
   dispatch_async_f(queue, wrap, [](void* const raw_work) {
-    const auto unwrap = static_cast<std::function<void()>*>(raw_work);
+    const auto unwrap = static_cast<Executor::Operation*>(raw_work);
     (*unwrap)();
     delete unwrap;
   });
 }
 
-void DispatchSync(const dispatch_queue_t queue, std::function<void()> work) {
+void DispatchAsync(const dispatch_queue_t queue,
+                   const qos_class_t qos_class,
+                   Executor::Operation&& work) {
+  // Blocks copy what they capture, and operations can't be copied.
+  const auto wrap = new Executor::Operation{std::move(work)};
+
+  dispatch_block_t block = dispatch_block_create_with_qos_class(
+      DISPATCH_BLOCK_ENFORCE_QOS_CLASS, qos_class, 0, ^{
+        (*wrap)();
+        delete wrap;
+      });
+  dispatch_async(queue, block);
+}
+
+void DispatchSync(const dispatch_queue_t queue, Executor::Operation work) {
   HARD_ASSERT(
       GetCurrentQueueLabel() != GetQueueLabel(queue),
       "Calling DispatchSync on the current queue will lead to a deadlock.");
@@ -67,7 +81,7 @@ void DispatchSync(const dispatch_queue_t queue, std::function<void()> work) {
   // Unlike dispatch_async_f, dispatch_sync_f blocks until the work passed to it
   // is done, so passing a reference to a local variable is okay.
   dispatch_sync_f(queue, &work, [](void* const raw_work) {
-    const auto unwrap = static_cast<std::function<void()>*>(raw_work);
+    const auto unwrap = static_cast<Executor::Operation*>(raw_work);
     (*unwrap)();
   });
 }
@@ -79,6 +93,16 @@ namespace {
 using internal::DispatchAsync;
 using internal::DispatchSync;
 
+qos_class_t ToQosClass(const Executor::QualityOfService qos) {
+  switch (qos) {
+    case Executor::QualityOfService::UserInitiated:
+      return QOS_CLASS_USER_INITIATED;
+    case Executor::QualityOfService::Utility:
+      return QOS_CLASS_UTILITY;
+  }
+  UNREACHABLE();
+}
+
 template <typename Work>
 void RunSynchronized(const ExecutorLibdispatch* const executor, Work&& work) {
   if (executor->IsCurrentExecutor()) {
@@ -229,6 +253,10 @@ std::string ExecutorLibdispatch::Name() const {
 void ExecutorLibdispatch::Execute(Operation&& operation) {
   DispatchAsync(dispatch_queue(), std::move(operation));
 }
+void ExecutorLibdispatch::ExecuteWithQos(const QualityOfService qos,
+                                         Operation&& operation) {
+  DispatchAsync(dispatch_queue(), ToQosClass(qos), std::move(operation));
+}
 void ExecutorLibdispatch::ExecuteBlocking(Operation&& operation) {
   DispatchSync(dispatch_queue(), std::move(operation));
 }
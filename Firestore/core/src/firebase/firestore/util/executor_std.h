@@ -21,6 +21,7 @@
 #include <atomic>
 #include <condition_variable>  // NOLINT(build/c++11)
 #include <deque>
+#include <initializer_list>
 #include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
@@ -47,11 +48,16 @@ namespace async {
 // The details of time management are completely concealed within the class.
 // Once an entry is scheduled, there is no way to reschedule or even retrieve
 // the time.
+//
+// Entries scheduled for `Immediate()` are kept in a separate FIFO queue, so
+// that pushing them never has to search for (or shift entries to make room
+// for) their position among the delayed entries.
 template <typename T>
 class Schedule {
   // Internal invariants:
-  // - entries are always in sorted order, leftmost entry is always the most
-  //   due;
+  // - `immediate_` only holds entries due at `Immediate()`, in FIFO order;
+  // - `scheduled_` holds all other entries and is always in sorted order,
+  //   leftmost entry is always the most due;
   // - each operation modifying the queue notifies the condition variable `cv_`.
  public:
   using Duration = std::chrono::milliseconds;
@@ -59,6 +65,12 @@ class Schedule {
   // Entries are scheduled using absolute time.
   using TimePoint = std::chrono::time_point<Clock, Duration>;
 
+  // The time point conventionally used for entries that should run as soon as
+  // possible. It is earlier than any time returned by `Clock::now()`.
+  static TimePoint Immediate() {
+    return TimePoint{};
+  }
+
   // Schedules an entry for the specified time due. `due` may be in the past.
   void Push(const T& value, const TimePoint due) {
     InsertPreservingOrder(Entry{value, due});
@@ -75,7 +87,7 @@ class Schedule {
     std::lock_guard<std::mutex> lock{mutex_};
 
     if (HasDueLocked()) {
-      return ExtractLocked(scheduled_.begin());
+      return ExtractFrontLocked();
     }
     return {};
   }
@@ -88,13 +100,17 @@ class Schedule {
     std::unique_lock<std::mutex> lock{mutex_};
 
     while (true) {
-      cv_.wait(lock, [this] { return !scheduled_.empty(); });
+      cv_.wait(lock, [this] { return !EmptyLocked(); });
+      if (!immediate_.empty()) {
+        return ExtractFrontLocked();
+      }
 
       // To minimize busy waiting, sleep until either the nearest entry in the
       // future either changes, or else becomes due.
       const auto until = scheduled_.front().due;
       cv_.wait_until(lock, until, [this, until] {
-        return scheduled_.empty() || scheduled_.front().due != until;
+        return !immediate_.empty() || scheduled_.empty() ||
+               scheduled_.front().due != until;
       });
       // There are 3 possibilities why `wait_until` has returned:
       // - `wait_until` has timed out, in which case the current time is at
@@ -108,19 +124,19 @@ class Schedule {
       //   to #2.
 
       if (HasDueLocked()) {
-        return ExtractLocked(scheduled_.begin());
+        return ExtractFrontLocked();
       }
     }
   }
 
   bool empty() const {
     std::lock_guard<std::mutex> lock{mutex_};
-    return scheduled_.empty();
+    return EmptyLocked();
   }
 
   size_t size() const {
     std::lock_guard<std::mutex> lock{mutex_};
-    return scheduled_.size();
+    return immediate_.size() + scheduled_.size();
   }
 
   // Removes the first entry satisfying predicate from the queue and returns it.
@@ -133,10 +149,12 @@ class Schedule {
   absl::optional<T> RemoveIf(const Pred pred) {
     std::lock_guard<std::mutex> lock{mutex_};
 
-    for (auto iter = scheduled_.begin(), end = scheduled_.end(); iter != end;
-         ++iter) {
-      if (pred(iter->value)) {
-        return ExtractLocked(iter);
+    for (Container* container : {&immediate_, &scheduled_}) {
+      for (auto iter = container->begin(), end = container->end(); iter != end;
+           ++iter) {
+        if (pred(iter->value)) {
+          return ExtractLocked(container, iter);
+        }
       }
     }
     return {};
@@ -146,8 +164,9 @@ class Schedule {
   template <typename Pred>
   bool Contains(const Pred pred) const {
     std::lock_guard<std::mutex> lock{mutex_};
-    return std::any_of(scheduled_.begin(), scheduled_.end(),
-                       [&pred](const Entry& s) { return pred(s.value); });
+    auto matches = [&pred](const Entry& s) { return pred(s.value); };
+    return std::any_of(immediate_.begin(), immediate_.end(), matches) ||
+           std::any_of(scheduled_.begin(), scheduled_.end(), matches);
   }
 
  private:
@@ -167,27 +186,54 @@ class Schedule {
   void InsertPreservingOrder(Entry&& new_entry) {
     std::lock_guard<std::mutex> lock{mutex_};
 
-    const auto insertion_point =
-        std::upper_bound(scheduled_.begin(), scheduled_.end(), new_entry);
-    scheduled_.insert(insertion_point, std::move(new_entry));
+    if (new_entry.due == Immediate()) {
+      immediate_.push_back(std::move(new_entry));
+    } else {
+      const auto insertion_point =
+          std::upper_bound(scheduled_.begin(), scheduled_.end(), new_entry);
+      scheduled_.insert(insertion_point, std::move(new_entry));
+    }
 
     cv_.notify_one();
   }
 
   // This function expects the mutex to be already locked.
-  bool HasDueLocked() const {
+  bool EmptyLocked() const {
+    return immediate_.empty() && scheduled_.empty();
+  }
+
+  // Returns the container holding the most due entry. This function expects
+  // the mutex to be already locked and the queue to be non-empty.
+  Container* FrontLocked() {
+    if (immediate_.empty() ||
+        (!scheduled_.empty() && scheduled_.front().due < Immediate())) {
+      return &scheduled_;
+    }
+    return &immediate_;
+  }
+
+  // This function expects the mutex to be already locked.
+  bool HasDueLocked() {
     namespace chr = std::chrono;
+    if (EmptyLocked()) return false;
+
     const auto now = chr::time_point_cast<Duration>(Clock::now());
-    return !scheduled_.empty() && now >= scheduled_.front().due;
+    return now >= FrontLocked()->front().due;
   }
 
   // This function expects the mutex to be already locked.
-  T ExtractLocked(const Iterator where) {
-    HARD_ASSERT(!scheduled_.empty(),
+  T ExtractFrontLocked() {
+    Container* container = FrontLocked();
+    return ExtractLocked(container, container->begin());
+  }
+
+  // This function expects the mutex to be already locked.
+  T ExtractLocked(Container* container, const Iterator where) {
+    HARD_ASSERT(!container->empty(),
                 "Trying to pop an entry from an empty queue.");
 
     T result = std::move(where->value);
-    scheduled_.erase(where);
+    container->erase(where);
     cv_.notify_one();
 
     return result;
@@ -195,6 +241,7 @@ class Schedule {
 
   mutable std::mutex mutex_;
   std::condition_variable cv_;
+  Container immediate_;
   Container scheduled_;
 };
 
@@ -241,7 +288,7 @@ class ExecutorStd : public Executor {
   // the immediate operation was scheduled after a delayed operation was due
   // (but hasn't yet run).
   static TimePoint Immediate() {
-    return TimePoint{};
+    return async::Schedule<Operation>::Immediate();
   }
 
   struct Entry {
@@ -17,12 +17,14 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_FILESYSTEM_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_FILESYSTEM_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
 #include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/strings/string_view.h"
 
 namespace firebase {
 namespace firestore {
@@ -86,6 +88,74 @@ StatusOr<int64_t> FileSize(const Path& path);
  */
 StatusOr<std::string> ReadFile(const Path& path);
 
+/** Whether a write waits until its data has reached stable storage. */
+enum class Durability {
+  /**
+   * The write survives a crash of the process, but may be lost (in which case
+   * the file keeps its old contents) if the whole system goes down.
+   */
+  Unsynced,
+
+  /** The write, including the rename that commits it, survives a power loss. */
+  Synced,
+};
+
+/**
+ * Replaces the contents of the file at `path` with `contents` such that,
+ * whenever the process or the system crashes, the file either has its old or
+ * its new contents and never a mix of the two.
+ *
+ * The contents are written to a temporary file next to `path` which is then
+ * renamed over `path`. Concurrent writes to the same `path` are not supported.
+ */
+Status WriteFileAtomically(const Path& path,
+                           absl::string_view contents,
+                           Durability durability = Durability::Synced);
+
+/**
+ * On success, returns the total size in bytes of all the regular files in the
+ * directory at `path` and its subdirectories.
+ */
+StatusOr<int64_t> DirectorySize(const Path& path);
+
+/**
+ * A read-only view of the contents of a file, mapped into memory so that large
+ * files can be read without copying them. The file is unmapped when the
+ * MappedFile is destroyed; the contents must not be used after that.
+ */
+class MappedFile {
+ public:
+  /** On success, maps the whole file at the given `path` into memory. */
+  static StatusOr<MappedFile> Open(const Path& path);
+
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  MappedFile(const MappedFile& other) = delete;
+  MappedFile& operator=(const MappedFile& other) = delete;
+
+  absl::string_view contents() const {
+    return absl::string_view{data_, size_};
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  MappedFile(const char* data, size_t size) : data_{data}, size_{size} {
+  }
+
+  void Unmap();
+
+  // Empty files are not mapped at all: `data_` is null and `size_` is zero.
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
 /**
  * Implements an iterator over the contents of a directory. Initializes to the
  * first entry in the directory.
@@ -20,6 +20,8 @@
 
 #import <Foundation/Foundation.h>
 
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+
 namespace firebase {
 namespace firestore {
 namespace util {
@@ -38,6 +40,48 @@ Path TempDir() {
   return Path::FromUtf8("/tmp");
 }
 
+StatusOr<int64_t> DirectorySize(const Path& path) {
+  @autoreleasepool {
+    // Have the enumerator fetch the attributes of the entries in bulk as it
+    // reads the directory instead of stat'ing every file one by one.
+    NSArray<NSURLResourceKey>* keys =
+        @[ NSURLIsRegularFileKey, NSURLFileSizeKey ];
+    __block NSError* enumeration_error = nil;
+    NSDirectoryEnumerator<NSURL*>* enumerator = [[NSFileManager defaultManager]
+                   enumeratorAtURL:[NSURL fileURLWithPath:path.ToNSString()
+                                              isDirectory:YES]
+        includingPropertiesForKeys:keys
+                           options:0
+                      errorHandler:^BOOL(NSURL* url, NSError* error) {
+                        enumeration_error = error;
+                        return NO;
+                      }];
+    if (!enumerator) {
+      return Status{FirestoreErrorCode::NotFound,
+                    StringFormat("Could not open directory %s",
+                                 path.ToUtf8String())};
+    }
+
+    int64_t total = 0;
+    for (NSURL* url in enumerator) {
+      NSError* error = nil;
+      NSDictionary<NSURLResourceKey, id>* values =
+          [url resourceValuesForKeys:keys error:&error];
+      if (!values) {
+        return Status::FromNSError(error);
+      }
+      if ([values[NSURLIsRegularFileKey] boolValue]) {
+        total += [values[NSURLFileSizeKey] longLongValue];
+      }
+    }
+
+    if (enumeration_error) {
+      return Status::FromNSError(enumeration_error);
+    }
+    return total;
+  }
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
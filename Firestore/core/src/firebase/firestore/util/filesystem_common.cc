@@ -101,6 +101,27 @@ StatusOr<std::string> ReadFile(const Path& path) {
   return buffer.str();
 }
 
+MappedFile::~MappedFile() {
+  Unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_{other.data_}, size_{other.size_} {
+  other.data_ = nullptr;
+  other.size_ = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    Unmap();
+    data_ = other.data_;
+    size_ = other.size_;
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+  return *this;
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
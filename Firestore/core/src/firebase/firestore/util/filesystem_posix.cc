@@ -17,15 +17,19 @@
 #include "Firestore/core/src/firebase/firestore/util/filesystem.h"
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <cerrno>
+#include <cstring>
 #include <deque>
 #include <string>
 
 #include "Firestore/core/src/firebase/firestore/util/filesystem_detail.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/src/firebase/firestore/util/string_format.h"
 #include "absl/memory/memory.h"
@@ -105,6 +109,217 @@ StatusOr<int64_t> FileSize(const Path& path) {
   }
 }
 
+namespace {
+
+/** Writes all of `contents` to `fd`, retrying short and interrupted writes. */
+Status WriteAll(int fd, absl::string_view contents, const Path& path) {
+  const char* data = contents.data();
+  size_t remaining = contents.size();
+  while (remaining > 0) {
+    ssize_t written = ::write(fd, data, remaining);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return Status::FromErrno(
+          errno, StringFormat("Could not write file %s", path.ToUtf8String()));
+    }
+    data += written;
+    remaining -= static_cast<size_t>(written);
+  }
+  return Status::OK();
+}
+
+/** Flushes everything written to `fd` to stable storage. */
+Status Sync(int fd, const Path& path) {
+#if defined(__APPLE__)
+  // On Apple platforms fsync() only hands the data over to the drive, which
+  // may keep it in its own volatile cache. F_FULLFSYNC flushes that too, but
+  // is not supported by all file systems, in which case fall back to fsync().
+  if (::fcntl(fd, F_FULLFSYNC) == 0) {
+    return Status::OK();
+  }
+#endif  // defined(__APPLE__)
+
+  if (::fsync(fd) != 0) {
+    return Status::FromErrno(
+        errno, StringFormat("Could not sync %s", path.ToUtf8String()));
+  }
+  return Status::OK();
+}
+
+/**
+ * Makes the creation, deletion or renaming of entries in the directory at
+ * `path` durable.
+ */
+Status SyncDir(const Path& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    return Status::FromErrno(
+        errno,
+        StringFormat("Could not open directory %s", path.ToUtf8String()));
+  }
+
+  Status status = Sync(fd, path);
+  ::close(fd);
+  return status;
+}
+
+}  // namespace
+
+Status WriteFileAtomically(const Path& path,
+                           absl::string_view contents,
+                           Durability durability) {
+  Path temp = Path::FromUtf8(path.ToUtf8String() + ".tmp");
+
+  int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (fd < 0) {
+    return Status::FromErrno(
+        errno, StringFormat("Could not create file %s", temp.ToUtf8String()));
+  }
+
+  // Unless the data reaches the disk before the rename, a crash could leave
+  // `path` renamed but empty.
+  Status status = WriteAll(fd, contents, temp);
+  if (status.ok() && durability == Durability::Synced) {
+    status = Sync(fd, temp);
+  }
+  if (::close(fd) != 0 && status.ok()) {
+    status = Status::FromErrno(
+        errno, StringFormat("Could not close file %s", temp.ToUtf8String()));
+  }
+  if (status.ok() && ::rename(temp.c_str(), path.c_str()) != 0) {
+    status = Status::FromErrno(
+        errno, StringFormat("Could not rename %s to %s", temp.ToUtf8String(),
+                            path.ToUtf8String()));
+  }
+
+  if (!status.ok()) {
+    detail::DeleteFile(temp).IgnoreError();
+    return status;
+  }
+
+  if (durability == Durability::Synced) {
+    Path parent = path.Dirname();
+    if (parent.native_value().empty()) {
+      parent = Path::FromUtf8(".");
+    }
+    return SyncDir(parent);
+  }
+  return Status::OK();
+}
+
+#if !defined(__APPLE__)
+// See filesystem_apple.mm for an alternative implementation.
+StatusOr<int64_t> DirectorySize(const Path& path) {
+  DIR* dir = ::opendir(path.c_str());
+  if (!dir) {
+    return Status::FromErrno(
+        errno,
+        StringFormat("Could not open directory %s", path.ToUtf8String()));
+  }
+
+  // Most file systems report the type of each entry in the entry itself, so
+  // only regular files need to be stat'ed, and relative to the already open
+  // directory rather than by resolving their full path again.
+  int dir_fd = ::dirfd(dir);
+  int64_t total = 0;
+  Status status;
+  for (;;) {
+    errno = 0;
+    struct dirent* entry = ::readdir(dir);
+    if (!entry) {
+      if (errno != 0) {
+        status = Status::FromErrno(
+            errno, StringFormat("Could not read %s", path.ToUtf8String()));
+      }
+      break;
+    }
+
+    const char* name = entry->d_name;
+    if (::strcmp(".", name) == 0 || ::strcmp("..", name) == 0) {
+      continue;
+    }
+
+    bool is_dir = entry->d_type == DT_DIR;
+    if (entry->d_type == DT_REG || entry->d_type == DT_UNKNOWN) {
+      struct stat st {};
+      if (::fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        status = Status::FromErrno(
+            errno,
+            StringFormat("Failed to stat file: %s",
+                         path.AppendUtf8(name, strlen(name)).ToUtf8String()));
+        break;
+      }
+      if (S_ISREG(st.st_mode)) {
+        total += st.st_size;
+      }
+      is_dir = S_ISDIR(st.st_mode);
+    }
+
+    if (is_dir) {
+      StatusOr<int64_t> subdir_size =
+          DirectorySize(path.AppendUtf8(name, strlen(name)));
+      if (!subdir_size.ok()) {
+        status = subdir_size.status();
+        break;
+      }
+      total += subdir_size.ValueOrDie();
+    }
+  }
+
+  ::closedir(dir);
+  if (!status.ok()) {
+    return status;
+  }
+  return total;
+}
+#endif  // !defined(__APPLE__)
+
+StatusOr<MappedFile> MappedFile::Open(const Path& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return Status::FromErrno(
+        errno, StringFormat("Could not open file %s", path.ToUtf8String()));
+  }
+
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    int error = errno;
+    ::close(fd);
+    return Status::FromErrno(
+        error, StringFormat("Failed to stat file: %s", path.ToUtf8String()));
+  }
+
+  // mmap() rejects empty mappings.
+  auto size = static_cast<size_t>(st.st_size);
+  if (size == 0) {
+    ::close(fd);
+    return MappedFile{};
+  }
+
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  int error = errno;
+
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+
+  if (data == MAP_FAILED) {
+    return Status::FromErrno(
+        error, StringFormat("Could not map file %s", path.ToUtf8String()));
+  }
+  return MappedFile{static_cast<const char*>(data), size};
+}
+
+void MappedFile::Unmap() {
+  if (data_) {
+    if (::munmap(const_cast<char*>(data_), size_) != 0) {
+      Status status = Status::FromErrno(errno, "Could not unmap file");
+      HARD_FAIL("%s", status.ToString());
+    }
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
 namespace detail {
 
 Status CreateDir(const Path& path) {
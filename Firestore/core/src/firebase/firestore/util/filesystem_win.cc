@@ -20,9 +20,12 @@
 
 #include <windows.h>
 
+#include <algorithm>
 #include <cerrno>
+#include <limits>
 #include <string>
 
+#include "Firestore/core/src/firebase/firestore/util/filesystem_detail.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/src/firebase/firestore/util/string_format.h"
@@ -69,6 +72,187 @@ StatusOr<int64_t> FileSize(const Path& path) {
   return result.QuadPart;
 }
 
+Status WriteFileAtomically(const Path& path,
+                           absl::string_view contents,
+                           Durability durability) {
+  Path temp = Path::FromUtf8(path.ToUtf8String() + ".tmp");
+
+  HANDLE file =
+      ::CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                    FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    DWORD error = ::GetLastError();
+    return Status::FromLastError(
+        error, StringFormat("Could not create file %s", temp.ToUtf8String()));
+  }
+
+  Status status;
+  const char* data = contents.data();
+  size_t remaining = contents.size();
+  while (remaining > 0 && status.ok()) {
+    // WriteFile takes a 32-bit count, so write large contents in chunks.
+    auto chunk = static_cast<DWORD>(
+        std::min<size_t>(remaining, std::numeric_limits<DWORD>::max()));
+    DWORD written = 0;
+    if (!::WriteFile(file, data, chunk, &written, nullptr)) {
+      DWORD error = ::GetLastError();
+      status = Status::FromLastError(
+          error, StringFormat("Could not write file %s", temp.ToUtf8String()));
+    }
+    data += written;
+    remaining -= written;
+  }
+
+  // Unless the data reaches the disk before the rename, a crash could leave
+  // `path` renamed but empty.
+  if (status.ok() && durability == Durability::Synced &&
+      !::FlushFileBuffers(file)) {
+    DWORD error = ::GetLastError();
+    status = Status::FromLastError(
+        error, StringFormat("Could not sync %s", temp.ToUtf8String()));
+  }
+  ::CloseHandle(file);
+
+  // MOVEFILE_WRITE_THROUGH only returns once the rename is on disk, so there
+  // is no need to flush the directory separately like on POSIX.
+  DWORD flags = MOVEFILE_REPLACE_EXISTING;
+  if (durability == Durability::Synced) {
+    flags |= MOVEFILE_WRITE_THROUGH;
+  }
+  if (status.ok() && !::MoveFileExW(temp.c_str(), path.c_str(), flags)) {
+    DWORD error = ::GetLastError();
+    status = Status::FromLastError(
+        error, StringFormat("Could not rename %s to %s", temp.ToUtf8String(),
+                            path.ToUtf8String()));
+  }
+
+  if (!status.ok()) {
+    detail::DeleteFile(temp).IgnoreError();
+  }
+  return status;
+}
+
+StatusOr<int64_t> DirectorySize(const Path& path) {
+  // The entries returned by FindFirstFileExW already carry the size of each
+  // file, so unlike the generic DirectoryIterator approach no file needs to
+  // be examined separately.
+  Path pattern = path.AppendUtf16(L"*", 1);
+  WIN32_FIND_DATAW find_data{};
+  HANDLE find_handle =
+      ::FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &find_data,
+                         FindExSearchNameMatch, nullptr,
+                         FIND_FIRST_EX_LARGE_FETCH);
+  if (find_handle == INVALID_HANDLE_VALUE) {
+    DWORD error = ::GetLastError();
+    return Status::FromLastError(
+        error,
+        StringFormat("Could not open directory %s", path.ToUtf8String()));
+  }
+
+  int64_t total = 0;
+  Status status;
+  do {
+    const wchar_t* name = find_data.cFileName;
+    if (wcscmp(name, L".") == 0 || wcscmp(name, L"..") == 0) {
+      continue;
+    }
+
+    DWORD attrs = find_data.dwFileAttributes;
+    if (attrs & FILE_ATTRIBUTE_DIRECTORY) {
+      // Don't follow junctions and symbolic links to directories.
+      if (attrs & FILE_ATTRIBUTE_REPARSE_POINT) {
+        continue;
+      }
+
+      StatusOr<int64_t> subdir_size =
+          DirectorySize(path.AppendUtf16(name, wcslen(name)));
+      if (!subdir_size.ok()) {
+        status = subdir_size.status();
+        break;
+      }
+      total += subdir_size.ValueOrDie();
+
+    } else {
+      LARGE_INTEGER size{};
+      size.HighPart = find_data.nFileSizeHigh;
+      size.LowPart = find_data.nFileSizeLow;
+      total += size.QuadPart;
+    }
+  } while (::FindNextFileW(find_handle, &find_data));
+
+  if (status.ok()) {
+    DWORD error = ::GetLastError();
+    if (error != ERROR_NO_MORE_FILES) {
+      status = Status::FromLastError(
+          error, StringFormat("Could not read %s", path.ToUtf8String()));
+    }
+  }
+
+  ::FindClose(find_handle);
+  if (!status.ok()) {
+    return status;
+  }
+  return total;
+}
+
+StatusOr<MappedFile> MappedFile::Open(const Path& path) {
+  HANDLE file =
+      ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    DWORD error = ::GetLastError();
+    return Status::FromLastError(
+        error, StringFormat("Could not open file %s", path.ToUtf8String()));
+  }
+
+  LARGE_INTEGER size{};
+  if (!::GetFileSizeEx(file, &size)) {
+    DWORD error = ::GetLastError();
+    ::CloseHandle(file);
+    return Status::FromLastError(error, path.ToUtf8String());
+  }
+
+  // CreateFileMappingW rejects empty files.
+  if (size.QuadPart == 0) {
+    ::CloseHandle(file);
+    return MappedFile{};
+  }
+
+  HANDLE mapping =
+      ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  DWORD error = ::GetLastError();
+  ::CloseHandle(file);
+  if (!mapping) {
+    return Status::FromLastError(
+        error, StringFormat("Could not map file %s", path.ToUtf8String()));
+  }
+
+  void* data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  error = ::GetLastError();
+
+  // The view keeps its own references to the mapping and the file.
+  ::CloseHandle(mapping);
+
+  if (!data) {
+    return Status::FromLastError(
+        error, StringFormat("Could not map file %s", path.ToUtf8String()));
+  }
+  return MappedFile{static_cast<const char*>(data),
+                    static_cast<size_t>(size.QuadPart)};
+}
+
+void MappedFile::Unmap() {
+  if (data_) {
+    if (!::UnmapViewOfFile(data_)) {
+      Status status =
+          Status::FromLastError(::GetLastError(), "Could not unmap file");
+      HARD_FAIL("%s", status.ToString());
+    }
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
 namespace detail {
 
 Status CreateDir(const Path& path) {
@@ -50,7 +50,9 @@ namespace util {
 //
 //     return util::Hash(first_, second_, /* ..., */ third_);
 //
-// TODO(wilhuff): Replace this with whatever Abseil releases.
+// Use util::Hash where a result must agree with an Objective-C `-hash`. For
+// the hasher of an unordered container, prefer absl::Hash, which mixes its
+// inputs thoroughly; model types opt in by defining `AbslHashValue`.
 
 namespace impl {
 
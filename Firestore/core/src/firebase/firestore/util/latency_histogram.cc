@@ -0,0 +1,48 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/latency_histogram.h"
+
+#include <algorithm>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace chr = std::chrono;
+
+const std::vector<int64_t>& LatencyHistogram::BucketUpperBoundsMs() {
+  static const std::vector<int64_t> bounds{
+      1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000};
+  return bounds;
+}
+
+LatencyHistogram::LatencyHistogram()
+    : bucket_counts_(BucketUpperBoundsMs().size() + 1) {
+}
+
+void LatencyHistogram::Record(chr::milliseconds latency) {
+  const std::vector<int64_t>& bounds = BucketUpperBoundsMs();
+  auto bucket =
+      std::lower_bound(bounds.begin(), bounds.end(), latency.count());
+  ++bucket_counts_[bucket - bounds.begin()];
+  ++count_;
+  total_ += latency;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_LATENCY_HISTOGRAM_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_LATENCY_HISTOGRAM_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * Counts latencies into buckets with fixed, roughly exponential upper bounds,
+ * from 1 ms to 10 s. The last bucket counts everything above 10 s.
+ */
+class LatencyHistogram {
+ public:
+  /**
+   * The inclusive upper bound of each bucket but the last one, in
+   * milliseconds.
+   */
+  static const std::vector<int64_t>& BucketUpperBoundsMs();
+
+  LatencyHistogram();
+
+  void Record(std::chrono::milliseconds latency);
+
+  /** The number of recorded latencies in each bucket. */
+  const std::vector<int64_t>& bucket_counts() const {
+    return bucket_counts_;
+  }
+
+  int64_t count() const {
+    return count_;
+  }
+
+  std::chrono::milliseconds total() const {
+    return total_;
+  }
+
+ private:
+  std::vector<int64_t> bucket_counts_;
+  int64_t count_ = 0;
+  std::chrono::milliseconds total_{0};
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_LATENCY_HISTOGRAM_H_
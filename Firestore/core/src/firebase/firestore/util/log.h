@@ -37,20 +37,21 @@ enum LogLevel {
   kLogLevelError,
 };
 
+// The lowest level that is logged in this build, as the numeric value of a
+// `LogLevel`. Logging statements below it compile to nothing, regardless of
+// the level set at runtime; e.g. building with -DFIRESTORE_MIN_LOG_LEVEL=1
+// strips all debug logging. Defaults to keeping every level.
+#ifndef FIRESTORE_MIN_LOG_LEVEL
+#define FIRESTORE_MIN_LOG_LEVEL 0
+#endif
+
 // Log a message if kLogLevelDebug is enabled. Arguments are not evaluated if
 // logging is disabled.
 //
 // @param format A format string suitable for use with `util::StringFormat`
 // @param ... C++ variadic arguments that match the format string. Not C
 //     varargs.
-#define LOG_DEBUG(...)                                         \
-  do {                                                         \
-    namespace _util = firebase::firestore::util;               \
-    if (_util::LogIsLoggable(_util::kLogLevelDebug)) {         \
-      std::string _message = _util::StringFormat(__VA_ARGS__); \
-      _util::LogMessage(_util::kLogLevelDebug, _message);      \
-    }                                                          \
-  } while (0)
+#define LOG_DEBUG(...) FIRESTORE_LOG_INTERNAL(kLogLevelDebug, __VA_ARGS__)
 
 // Log a message if kLogLevelWarn is enabled (it is by default). Arguments are
 // not evaluated if logging is disabled.
@@ -58,14 +59,7 @@ enum LogLevel {
 // @param format A format string suitable for use with `util::StringFormat`
 // @param ... C++ variadic arguments that match the format string. Not C
 //     varargs.
-#define LOG_WARN(...)                                          \
-  do {                                                         \
-    namespace _util = firebase::firestore::util;               \
-    if (_util::LogIsLoggable(_util::kLogLevelWarning)) {       \
-      std::string _message = _util::StringFormat(__VA_ARGS__); \
-      _util::LogMessage(_util::kLogLevelWarning, _message);    \
-    }                                                          \
-  } while (0)
+#define LOG_WARN(...) FIRESTORE_LOG_INTERNAL(kLogLevelWarning, __VA_ARGS__)
 
 // Log a message if kLogLevelError is enabled (it is by default). Arguments are
 // not evaluated if logging is disabled.
@@ -73,21 +67,30 @@ enum LogLevel {
 // @param format A format string suitable for use with `util::StringFormat`
 // @param ... C++ variadic arguments that match the format string. Not C
 //     varargs.
-#define LOG_ERROR(...)                                         \
+#define LOG_ERROR(...) FIRESTORE_LOG_INTERNAL(kLogLevelError, __VA_ARGS__)
+
+#define FIRESTORE_LOG_INTERNAL(level, ...)                     \
   do {                                                         \
     namespace _util = firebase::firestore::util;               \
-    if (_util::LogIsLoggable(_util::kLogLevelError)) {         \
+    if (_util::LogIsCompiledIn(_util::level) &&                \
+        _util::LogIsLoggable(_util::level)) {                  \
       std::string _message = _util::StringFormat(__VA_ARGS__); \
-      _util::LogMessage(_util::kLogLevelError, _message);      \
+      _util::LogMessage(_util::level, _message);               \
     }                                                          \
   } while (0)
 
+// Tests whether logging at the given level is compiled into this build (see
+// FIRESTORE_MIN_LOG_LEVEL).
+constexpr bool LogIsCompiledIn(LogLevel level) {
+  return static_cast<int>(level) >= FIRESTORE_MIN_LOG_LEVEL;
+}
+
 // Tests to see if the given log level is loggable.
 bool LogIsLoggable(LogLevel level);
 
 // Is debug logging enabled?
 inline bool LogIsDebugEnabled() {
-  return LogIsLoggable(kLogLevelDebug);
+  return LogIsCompiledIn(kLogLevelDebug) && LogIsLoggable(kLogLevelDebug);
 }
 
 // All messages at or above the specified log level value are displayed.
@@ -0,0 +1,215 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_MOVE_ONLY_FUNCTION_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_MOVE_ONLY_FUNCTION_H_
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+template <typename Signature>
+class MoveOnlyFunction;
+
+// MoveOnlyFunction<R(Args...)> is a polymorphic function wrapper like
+// `std::function`, except that
+//
+//   * it can only be moved, never copied, so it may hold callables that are
+//     themselves move-only (e.g. ones that own a `std::unique_ptr`), and
+//     passing it along never copies what the callable captured;
+//   * callables no larger than three pointers that can be moved without
+//     throwing are stored inline, without a heap allocation. Moving
+//     a MoveOnlyFunction that holds a larger callable only moves a pointer.
+//
+// Until C++14, lambdas cannot move-capture, so to move a payload into
+// a MoveOnlyFunction, bind it: `std::bind(lambda, std::move(payload))`.
+template <typename R, typename... Args>
+class MoveOnlyFunction<R(Args...)> {
+ public:
+  MoveOnlyFunction() = default;
+
+  MoveOnlyFunction(std::nullptr_t) {  // NOLINT(runtime/explicit)
+  }
+
+  template <typename F,
+            typename Decayed = typename std::decay<F>::type,
+            typename std::enable_if<
+                !std::is_same<Decayed, MoveOnlyFunction>::value &&
+                    !std::is_same<Decayed, std::nullptr_t>::value,
+                int>::type = 0>
+  MoveOnlyFunction(F&& f) {  // NOLINT(runtime/explicit)
+    if (IsNull(f)) {
+      return;
+    }
+    Init<Decayed>(std::forward<F>(f), IsInline<Decayed>{});
+  }
+
+  MoveOnlyFunction(MoveOnlyFunction&& other) noexcept {
+    MoveFrom(&other);
+  }
+
+  MoveOnlyFunction& operator=(MoveOnlyFunction&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      MoveFrom(&other);
+    }
+    return *this;
+  }
+
+  MoveOnlyFunction& operator=(std::nullptr_t) noexcept {
+    Reset();
+    return *this;
+  }
+
+  MoveOnlyFunction(const MoveOnlyFunction&) = delete;
+  MoveOnlyFunction& operator=(const MoveOnlyFunction&) = delete;
+
+  ~MoveOnlyFunction() {
+    Reset();
+  }
+
+  explicit operator bool() const noexcept {
+    return vtable_ != nullptr;
+  }
+
+  R operator()(Args... args) const {
+    HARD_ASSERT(vtable_, "Invoked an empty MoveOnlyFunction");
+    return vtable_->invoke(&storage_, std::forward<Args>(args)...);
+  }
+
+ private:
+  static constexpr size_t kInlineSize = 3 * sizeof(void*);
+
+  using Storage =
+      typename std::aligned_storage<kInlineSize, alignof(void*)>::type;
+
+  struct VTable {
+    R (*invoke)(Storage* storage, Args&&... args);
+    // Move-constructs the callable into `to` and destroys the one in `from`.
+    void (*relocate)(Storage* from, Storage* to);
+    void (*destroy)(Storage* storage);
+  };
+
+  template <typename F>
+  using IsInline = std::integral_constant<
+      bool,
+      sizeof(F) <= kInlineSize && alignof(Storage) % alignof(F) == 0 &&
+          std::is_nothrow_move_constructible<F>::value>;
+
+  // Callables stored inline live directly in `storage_`.
+  template <typename F>
+  struct InlineOps {
+    static F* Get(Storage* storage) {
+      return reinterpret_cast<F*>(storage);
+    }
+    static R Invoke(Storage* storage, Args&&... args) {
+      return (*Get(storage))(std::forward<Args>(args)...);
+    }
+    static void Relocate(Storage* from, Storage* to) {
+      new (to) F(std::move(*Get(from)));
+      Get(from)->~F();
+    }
+    static void Destroy(Storage* storage) {
+      Get(storage)->~F();
+    }
+    static const VTable* Table() {
+      static const VTable table{Invoke, Relocate, Destroy};
+      return &table;
+    }
+  };
+
+  // Larger callables live on the heap; `storage_` holds a pointer to them.
+  template <typename F>
+  struct HeapOps {
+    static F*& Get(Storage* storage) {
+      return *reinterpret_cast<F**>(storage);
+    }
+    static R Invoke(Storage* storage, Args&&... args) {
+      return (*Get(storage))(std::forward<Args>(args)...);
+    }
+    static void Relocate(Storage* from, Storage* to) {
+      new (to) F*(Get(from));
+    }
+    static void Destroy(Storage* storage) {
+      delete Get(storage);
+    }
+    static const VTable* Table() {
+      static const VTable table{Invoke, Relocate, Destroy};
+      return &table;
+    }
+  };
+
+  template <typename F, typename G>
+  void Init(G&& f, std::true_type /*inline*/) {
+    new (&storage_) F(std::forward<G>(f));
+    vtable_ = InlineOps<F>::Table();
+  }
+
+  template <typename F, typename G>
+  void Init(G&& f, std::false_type /*inline*/) {
+    new (&storage_) F*(new F(std::forward<G>(f)));
+    vtable_ = HeapOps<F>::Table();
+  }
+
+  void MoveFrom(MoveOnlyFunction* other) noexcept {
+    if (other->vtable_) {
+      other->vtable_->relocate(&other->storage_, &storage_);
+      vtable_ = other->vtable_;
+      other->vtable_ = nullptr;
+    }
+  }
+
+  void Reset() noexcept {
+    if (vtable_) {
+      vtable_->destroy(&storage_);
+      vtable_ = nullptr;
+    }
+  }
+
+  // Wrapping an empty `std::function` or a null function pointer results in an
+  // empty MoveOnlyFunction, mirroring how `std::function` treats them.
+  template <typename F>
+  static bool IsNull(const F&) {
+    return false;
+  }
+  template <typename S>
+  static bool IsNull(const std::function<S>& f) {
+    return !f;
+  }
+  template <typename Ret, typename... Params>
+  static bool IsNull(Ret (*f)(Params...)) {
+    return f == nullptr;
+  }
+
+  // Mutable so that, like `std::function`, a const MoveOnlyFunction may
+  // invoke a callable with a non-const call operator.
+  mutable Storage storage_;
+  const VTable* vtable_ = nullptr;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_MOVE_ONLY_FUNCTION_H_
@@ -0,0 +1,205 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TASK_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TASK_H_
+
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/move_only_function.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+template <typename T>
+class Promise;
+
+namespace internal {
+
+// The state shared by a `Promise` and its `Task`: the value, once there is
+// one, and the continuation, once there is one. Whichever arrives second
+// runs the continuation.
+template <typename T>
+class TaskState {
+ public:
+  using Continuation = MoveOnlyFunction<void(T)>;
+
+  void SetValue(T&& value) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    HARD_ASSERT(!has_value_been_set_, "A Promise can only be fulfilled once");
+    has_value_been_set_ = true;
+    if (!continuation_) {
+      value_ = std::move(value);
+      return;
+    }
+
+    Continuation continuation = std::move(continuation_);
+    lock.unlock();
+    Run(std::move(continuation), std::move(value));
+  }
+
+  void SetContinuation(AsyncQueue* queue,
+                       Executor* executor,
+                       Continuation&& continuation) {
+    HARD_ASSERT(continuation, "A Task needs a non-empty continuation");
+    std::unique_lock<std::mutex> lock{mutex_};
+    HARD_ASSERT(!has_continuation_been_set_,
+                "A Task can only have one continuation");
+    has_continuation_been_set_ = true;
+    queue_ = queue;
+    executor_ = executor;
+    if (!value_) {
+      continuation_ = std::move(continuation);
+      return;
+    }
+
+    T value = std::move(*value_);
+    value_.reset();
+    lock.unlock();
+    Run(std::move(continuation), std::move(value));
+  }
+
+ private:
+  void Run(Continuation&& continuation, T&& value) {
+    if (!queue_ && !executor_) {
+      continuation(std::move(value));
+      return;
+    }
+
+    // TODO(c++14): move `continuation` and `value` into lambda instead of
+    // binding them.
+    Executor::Operation operation = std::bind(
+        [](const Continuation& bound_continuation, T& bound_value) {
+          bound_continuation(std::move(bound_value));
+        },
+        std::move(continuation), std::move(value));
+    if (queue_) {
+      queue_->EnqueueRelaxed(std::move(operation));
+    } else {
+      executor_->Execute(std::move(operation));
+    }
+  }
+
+  std::mutex mutex_;
+  absl::optional<T> value_;
+  Continuation continuation_;
+  AsyncQueue* queue_ = nullptr;
+  Executor* executor_ = nullptr;
+  bool has_value_been_set_ = false;
+  bool has_continuation_been_set_ = false;
+};
+
+}  // namespace internal
+
+/**
+ * The eventual result of an asynchronous operation, set by the `Promise` the
+ * task was obtained from.
+ *
+ * A task has exactly one continuation, which receives the result by value, so
+ * both the result and the continuation may be move-only. Besides the state
+ * shared with its promise, a task allocates nothing for its continuation if
+ * the continuation fits into a `MoveOnlyFunction` inline; handing it to
+ * a queue along with the result is a single `Executor::Operation`.
+ *
+ * Tasks are how callbacks that must be copyable, like the ones credentials
+ * providers and `Datastore` take, pass their result on to code that owns
+ * move-only state: the callback captures (a copy of) the promise, and the
+ * state is bound into the continuation:
+ *
+ *     Promise<StatusOr<Token>> promise;
+ *     // TODO(c++14): move `message` into lambda instead of binding it.
+ *     promise.GetTask().Then(
+ *         worker_queue,
+ *         std::bind([](Message& message, const StatusOr<Token>& token) {...},
+ *                   std::move(message), std::placeholders::_1));
+ *     provider->GetToken([promise](const StatusOr<Token>& token) {
+ *       promise.SetValue(token);
+ *     });
+ */
+template <typename T>
+class Task {
+ public:
+  using Continuation = typename internal::TaskState<T>::Continuation;
+
+  Task(Task&& other) noexcept = default;
+  Task& operator=(Task&& other) noexcept = default;
+
+  /**
+   * Invokes the continuation with the result: on the thread that sets it or,
+   * if the result is already there, right away.
+   */
+  void Then(Continuation&& continuation) {
+    state_->SetContinuation(nullptr, nullptr, std::move(continuation));
+  }
+
+  /** Enqueues the continuation on the given queue once there is a result. */
+  void Then(AsyncQueue* queue, Continuation&& continuation) {
+    state_->SetContinuation(NOT_NULL(queue), nullptr, std::move(continuation));
+  }
+
+  /** Executes the continuation on the given executor once there is a result. */
+  void Then(Executor* executor, Continuation&& continuation) {
+    state_->SetContinuation(nullptr, NOT_NULL(executor),
+                            std::move(continuation));
+  }
+
+ private:
+  friend class Promise<T>;
+
+  explicit Task(std::shared_ptr<internal::TaskState<T>> state)
+      : state_{std::move(state)} {
+  }
+
+  std::shared_ptr<internal::TaskState<T>> state_;
+};
+
+/**
+ * Sets the result of a `Task`. Copies of a promise all set the result of the
+ * same task, which must happen exactly once.
+ */
+template <typename T>
+class Promise {
+ public:
+  Promise() : state_{std::make_shared<internal::TaskState<T>>()} {
+  }
+
+  /** Returns the task whose result this promise sets. */
+  Task<T> GetTask() const {
+    return Task<T>{state_};
+  }
+
+  // `const` so that promises captured by non-mutable lambdas can be fulfilled.
+  void SetValue(T value) const {
+    state_->SetValue(std::move(value));
+  }
+
+ private:
+  std::shared_ptr<internal::TaskState<T>> state_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TASK_H_
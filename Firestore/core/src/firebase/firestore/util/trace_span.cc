@@ -0,0 +1,108 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/trace_span.h"
+
+#include <mutex>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/log.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace internal {
+std::atomic<bool> trace_exporter_installed{false};
+}  // namespace internal
+
+namespace {
+
+std::mutex& ExporterMutex() {
+  static auto* mutex = new std::mutex();
+  return *mutex;
+}
+
+std::shared_ptr<TraceExporter>& Exporter() {
+  static auto* exporter = new std::shared_ptr<TraceExporter>();
+  return *exporter;
+}
+
+}  // namespace
+
+void SetTraceExporter(std::shared_ptr<TraceExporter> exporter) {
+  std::lock_guard<std::mutex> lock{ExporterMutex()};
+  internal::trace_exporter_installed.store(exporter != nullptr,
+                                           std::memory_order_relaxed);
+  Exporter() = std::move(exporter);
+}
+
+void ExportTraceSpan(const TraceSpanRecord& span) {
+  if (!IsTracingEnabled()) {
+    return;
+  }
+
+  std::shared_ptr<TraceExporter> exporter;
+  {
+    std::lock_guard<std::mutex> lock{ExporterMutex()};
+    exporter = Exporter();
+  }
+  // Don't hold the lock while exporting, so that the exporter may be replaced
+  // (or spans ended) from within `Export`.
+  if (exporter) {
+    exporter->Export(span);
+  }
+}
+
+TraceSpan::TraceSpan(const char* name, int64_t correlation_id)
+    : active_{IsTracingEnabled() || LogIsDebugEnabled()} {
+  record_.name = name;
+  record_.correlation_id = correlation_id;
+  if (active_) {
+    record_.start = Clock::now();
+  }
+}
+
+TraceSpan::~TraceSpan() {
+  End();
+}
+
+void TraceSpan::End() {
+  if (ended_) {
+    return;
+  }
+  ended_ = true;
+  if (!active_) {
+    return;
+  }
+
+  record_.end = Clock::now();
+  ExportTraceSpan(record_);
+  LOG_DEBUG("%s took %s ms", record_.name, elapsed().count());
+}
+
+std::chrono::milliseconds TraceSpan::elapsed() const {
+  if (!active_) {
+    return std::chrono::milliseconds{0};
+  }
+  Clock::time_point end = ended_ ? record_.end : Clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(end -
+                                                               record_.start);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
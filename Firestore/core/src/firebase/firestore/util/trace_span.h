@@ -0,0 +1,137 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACE_SPAN_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACE_SPAN_H_
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <memory>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/** The correlation ID of spans that don't belong to a particular operation. */
+constexpr int64_t kNoTraceCorrelationId = -1;
+
+/** A span that has ended, as handed to a `TraceExporter`. */
+struct TraceSpanRecord {
+  using Clock = std::chrono::steady_clock;
+
+  const char* name = nullptr;
+
+  /**
+   * Ties together the spans of one operation, e.g. the ID of a mutation batch
+   * on its way from the local write to the server acknowledgement.
+   */
+  int64_t correlation_id = kNoTraceCorrelationId;
+
+  Clock::time_point start;
+  Clock::time_point end;
+};
+
+/**
+ * Receives every span that ends while it is installed (see
+ * `SetTraceExporter`), e.g. to forward them to an APM tool.
+ *
+ * `Export` is called on the thread that ended the span, usually the worker
+ * queue, so it should return quickly.
+ */
+class TraceExporter {
+ public:
+  virtual ~TraceExporter() = default;
+
+  virtual void Export(const TraceSpanRecord& span) = 0;
+};
+
+/**
+ * Installs the exporter that receives all spans from now on, replacing any
+ * previous one. Passing `nullptr` disables tracing.
+ */
+void SetTraceExporter(std::shared_ptr<TraceExporter> exporter);
+
+namespace internal {
+extern std::atomic<bool> trace_exporter_installed;
+}  // namespace internal
+
+/**
+ * Whether a `TraceExporter` is installed. Spans that are neither exported nor
+ * logged don't even read the clock, so tracing is almost free until enabled.
+ */
+inline bool IsTracingEnabled() {
+  return internal::trace_exporter_installed.load(std::memory_order_relaxed);
+}
+
+/**
+ * Hands a span whose start and end were measured by the caller to the
+ * installed exporter, if any. Useful for spans that don't fit a scope, e.g.
+ * the time a batch waits in the write pipeline.
+ */
+void ExportTraceSpan(const TraceSpanRecord& span);
+
+/**
+ * Measures how long a named phase of work takes, e.g. a step of starting the
+ * client or of writing a mutation batch. When the span ends, it is handed to
+ * the installed `TraceExporter` and its duration is logged at debug level.
+ *
+ * A span ends when `End` is called or when it is destroyed, whichever happens
+ * first. If neither tracing nor debug logging is enabled when the span starts,
+ * it measures nothing and `elapsed` is always zero.
+ */
+class TraceSpan {
+ public:
+  using Clock = TraceSpanRecord::Clock;
+
+  /** `name` must outlive the span, which string literals do. */
+  explicit TraceSpan(const char* name,
+                     int64_t correlation_id = kNoTraceCorrelationId);
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+  ~TraceSpan();
+
+  /**
+   * Sets the correlation ID of a span whose operation only got its ID while
+   * the span was running, e.g. after a mutation batch was added to the queue.
+   */
+  void set_correlation_id(int64_t correlation_id) {
+    record_.correlation_id = correlation_id;
+  }
+
+  /** Ends the span and exports it. Does nothing if already ended. */
+  void End();
+
+  /** The time since the span started, or its duration if it has ended. */
+  std::chrono::milliseconds elapsed() const;
+
+  bool ended() const {
+    return ended_;
+  }
+
+ private:
+  TraceSpanRecord record_;
+  bool active_ = false;
+  bool ended_ = false;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACE_SPAN_H_
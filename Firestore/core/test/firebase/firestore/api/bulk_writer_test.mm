@@ -0,0 +1,182 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/api/bulk_writer.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#import "Firestore/Source/Model/FSTMutation.h"
+
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/src/firebase/firestore/api/document_reference.h"
+#include "Firestore/core/src/firebase/firestore/api/firestore.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace api {
+
+using util::Status;
+using util::StatusCallback;
+
+namespace {
+
+/** A commit that the writer started and that the test has yet to complete. */
+struct Commit {
+  std::vector<FSTMutation*> mutations;
+  StatusCallback callback;
+};
+
+class BulkWriterTest : public testing::Test {
+ public:
+  BulkWriterTest()
+      : firestore_{std::make_shared<Firestore>(
+            "project", "database", "persistence", nullptr, nullptr, nullptr)} {
+  }
+
+ protected:
+  std::shared_ptr<BulkWriter> CreateWriter(BulkWriterOptions options) {
+    return std::make_shared<BulkWriter>(
+        firestore_, options,
+        [this](std::vector<FSTMutation*> mutations, StatusCallback callback) {
+          commits_.push_back(Commit{std::move(mutations), std::move(callback)});
+        });
+  }
+
+  DocumentReference Doc(int index) {
+    return DocumentReference{testutil::Key("docs/" + std::to_string(index)),
+                             firestore_};
+  }
+
+  /** Completes the oldest commit in flight with the given status. */
+  void CompleteCommit(const Status& status) {
+    ASSERT_FALSE(commits_.empty());
+    Commit commit = std::move(commits_.front());
+    commits_.pop_front();
+    commit.callback(status);
+  }
+
+  std::shared_ptr<Firestore> firestore_;
+  std::deque<Commit> commits_;
+};
+
+}  // namespace
+
+TEST_F(BulkWriterTest, ChunksWritesAtTheBatchLimit) {
+  auto writer = CreateWriter(BulkWriterOptions{});
+  for (int i = 0; i != 1001; ++i) {
+    writer->DeleteData(Doc(i));
+  }
+
+  // Full batches are committed right away.
+  ASSERT_EQ(commits_.size(), 2u);
+  EXPECT_EQ(commits_[0].mutations.size(), 500u);
+  EXPECT_EQ(commits_[1].mutations.size(), 500u);
+  EXPECT_EQ([commits_[0].mutations.front() key], testutil::Key("docs/0"));
+  EXPECT_EQ([commits_[1].mutations.front() key], testutil::Key("docs/500"));
+
+  writer->Flush();
+  ASSERT_EQ(commits_.size(), 3u);
+  ASSERT_EQ(commits_[2].mutations.size(), 1u);
+  EXPECT_EQ([commits_[2].mutations.front() key], testutil::Key("docs/1000"));
+}
+
+TEST_F(BulkWriterTest, WaitsWhileTheMaximumNumberOfBatchesIsPending) {
+  BulkWriterOptions options;
+  options.max_mutations_per_batch = 2;
+  auto writer = CreateWriter(options);
+  for (int i = 0; i != 24; ++i) {
+    writer->DeleteData(Doc(i));
+  }
+
+  // Only 10 of the 12 full batches are committed.
+  ASSERT_EQ(commits_.size(), 10u);
+  EXPECT_EQ([commits_.back().mutations.front() key], testutil::Key("docs/18"));
+
+  // Every acknowledgement lets a waiting batch through, in order.
+  CompleteCommit(Status::OK());
+  ASSERT_EQ(commits_.size(), 10u);
+  EXPECT_EQ([commits_.back().mutations.front() key], testutil::Key("docs/20"));
+
+  CompleteCommit(Status::OK());
+  ASSERT_EQ(commits_.size(), 10u);
+  EXPECT_EQ([commits_.back().mutations.front() key], testutil::Key("docs/22"));
+
+  CompleteCommit(Status::OK());
+  EXPECT_EQ(commits_.size(), 9u);
+  EXPECT_EQ(writer->stats().batches_committed, 3);
+  EXPECT_EQ(writer->stats().documents_written, 6);
+}
+
+TEST_F(BulkWriterTest, RetriesARejectedBatchOneDocumentAtATime) {
+  BulkWriterOptions options;
+  options.max_mutations_per_batch = 3;
+  auto writer = CreateWriter(options);
+
+  std::vector<Status> results(3);
+  std::vector<bool> completed(3, false);
+  for (int i = 0; i != 3; ++i) {
+    writer->DeleteData(Doc(i), [&results, &completed, i](Status status) {
+      results[i] = std::move(status);
+      completed[i] = true;
+    });
+  }
+
+  bool closed = false;
+  BulkWriterStats stats;
+  writer->Close([&](BulkWriterStats close_stats) {
+    closed = true;
+    stats = close_stats;
+  });
+
+  // Nobody hears about the rejection of the whole batch, since it doesn't tell
+  // which document was bad.
+  ASSERT_EQ(commits_.size(), 1u);
+  CompleteCommit(Status{FirestoreErrorCode::InvalidArgument, "Bad document"});
+  EXPECT_EQ(completed, (std::vector<bool>{false, false, false}));
+
+  ASSERT_EQ(commits_.size(), 3u);
+  for (int i = 0; i != 3; ++i) {
+    ASSERT_EQ(commits_[i].mutations.size(), 1u);
+    EXPECT_EQ([commits_[i].mutations.front() key],
+              testutil::Key("docs/" + std::to_string(i)));
+  }
+
+  CompleteCommit(Status::OK());
+  CompleteCommit(Status{FirestoreErrorCode::InvalidArgument, "Bad document"});
+  EXPECT_FALSE(closed);
+  CompleteCommit(Status::OK());
+
+  EXPECT_EQ(completed, (std::vector<bool>{true, true, true}));
+  EXPECT_TRUE(results[0].ok());
+  EXPECT_EQ(results[1].code(), FirestoreErrorCode::InvalidArgument);
+  EXPECT_TRUE(results[2].ok());
+
+  ASSERT_TRUE(closed);
+  EXPECT_EQ(stats.documents_written, 2);
+  EXPECT_EQ(stats.documents_failed, 1);
+  EXPECT_EQ(stats.batches_committed, 2);
+}
+
+}  // namespace api
+}  // namespace firestore
+}  // namespace firebase
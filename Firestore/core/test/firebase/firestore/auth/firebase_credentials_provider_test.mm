@@ -34,6 +34,7 @@
 @property(nonatomic, nullable, strong, readonly) NSString* token;
 @property(nonatomic, nullable, strong, readonly) NSString* uid;
 @property(nonatomic, readonly) BOOL forceRefreshTriggered;
+@property(nonatomic, readonly) int getTokenCount;
 - (instancetype)initWithToken:(nullable NSString*)token
                           uid:(nullable NSString*)uid NS_DESIGNATED_INITIALIZER;
 - (instancetype)init NS_UNAVAILABLE;
@@ -61,6 +62,7 @@
 - (void)getTokenForcingRefresh:(BOOL)forceRefresh
                   withCallback:(nonnull FIRTokenCallback)callback {
   _forceRefreshTriggered = forceRefresh;
+  _getTokenCount++;
   callback(self.token, nil);
 }
 
@@ -153,6 +155,40 @@ TEST(FirebaseCredentialsProviderTest, InvalidateToken) {
   });
 }
 
+TEST(FirebaseCredentialsProviderTest, GetTokenReusesUnexpiredToken) {
+  // An unsigned JWT with {"exp": 4102444800}, i.e. expiring in 2100.
+  NSString* jwt = @"eyJhbGciOiJub25lIn0.eyJleHAiOjQxMDI0NDQ4MDB9.";
+  FIRApp* app = testutil::AppForUnitTesting();
+  FSTAuthFake* auth = [[FSTAuthFake alloc] initWithToken:jwt uid:@"fake uid"];
+  FirebaseCredentialsProvider credentials_provider(app, auth);
+
+  for (int i = 0; i < 3; i++) {
+    credentials_provider.GetToken([jwt](util::StatusOr<Token> result) {
+      EXPECT_TRUE(result.ok());
+      EXPECT_EQ(util::MakeString(jwt), result.ValueOrDie().token());
+    });
+  }
+  EXPECT_EQ(1, auth.getTokenCount);
+
+  // An invalidated token is never reused.
+  credentials_provider.InvalidateToken();
+  credentials_provider.GetToken([](util::StatusOr<Token> result) {
+    EXPECT_TRUE(result.ok());
+  });
+  EXPECT_TRUE(auth.forceRefreshTriggered);
+  EXPECT_EQ(2, auth.getTokenCount);
+}
+
+TEST(FirebaseCredentialsProviderTest, GetTokenAsksAuthForUnparsableToken) {
+  FIRApp* app = testutil::AppForUnitTesting();
+  FSTAuthFake* auth = [[FSTAuthFake alloc] initWithToken:@"token for fake uid"
+                                                     uid:@"fake uid"];
+  FirebaseCredentialsProvider credentials_provider(app, auth);
+  credentials_provider.GetToken([](util::StatusOr<Token>) {});
+  credentials_provider.GetToken([](util::StatusOr<Token>) {});
+  EXPECT_EQ(2, auth.getTokenCount);
+}
+
 }  // namespace auth
 }  // namespace firestore
 }  // namespace firebase
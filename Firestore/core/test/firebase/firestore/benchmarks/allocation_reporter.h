@@ -0,0 +1,77 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_BENCHMARKS_ALLOCATION_REPORTER_H_
+#define FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_BENCHMARKS_ALLOCATION_REPORTER_H_
+
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/util/allocation_counters.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace benchmarks {
+
+/**
+ * Reports the allocations made by each instrumented subsystem of the core
+ * while a benchmark runs, as the counters `<subsystem>_allocs` and
+ * `<subsystem>_bytes`, averaged per iteration. Subsystems that didn't allocate
+ * at all are left out.
+ *
+ * Create one right before the benchmark loop; it reports when it goes out of
+ * scope. Allocations are only counted in builds with
+ * `FIRESTORE_COUNT_ALLOCATIONS` defined (`-DFIRESTORE_COUNT_ALLOCATIONS=ON`
+ * with CMake); in other builds nothing is reported.
+ */
+class AllocationReporter {
+ public:
+  explicit AllocationReporter(benchmark::State& state) : state_{state} {
+    for (int i = 0; i < util::kAllocationSubsystemCount; ++i) {
+      start_[i] =
+          util::GetAllocationCounts(static_cast<util::AllocationSubsystem>(i));
+    }
+  }
+
+  AllocationReporter(const AllocationReporter&) = delete;
+  AllocationReporter& operator=(const AllocationReporter&) = delete;
+
+  ~AllocationReporter() {
+    for (int i = 0; i < util::kAllocationSubsystemCount; ++i) {
+      auto subsystem = static_cast<util::AllocationSubsystem>(i);
+      util::AllocationCounts end = util::GetAllocationCounts(subsystem);
+      if (end.allocations == start_[i].allocations) continue;
+
+      std::string name = util::AllocationSubsystemName(subsystem);
+      state_.counters[name + "_allocs"] = benchmark::Counter(
+          static_cast<double>(end.allocations - start_[i].allocations),
+          benchmark::Counter::kAvgIterations);
+      state_.counters[name + "_bytes"] =
+          benchmark::Counter(static_cast<double>(end.bytes - start_[i].bytes),
+                             benchmark::Counter::kAvgIterations);
+    }
+  }
+
+ private:
+  benchmark::State& state_;
+  util::AllocationCounts start_[util::kAllocationSubsystemCount];
+};
+
+}  // namespace benchmarks
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_BENCHMARKS_ALLOCATION_REPORTER_H_
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/test/firebase/firestore/benchmarks/benchmark_util.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace benchmarks {
+
+using model::DatabaseId;
+using model::FieldValue;
+using model::MaybeDocument;
+using nanopb::Reader;
+using nanopb::Writer;
+
+FieldValue::Map MakeFields(int field_count, int index) {
+  FieldValue::Map fields;
+  for (int i = 0; i < field_count; ++i) {
+    std::string name = absl::StrCat("field", i);
+    switch (i % 3) {
+      case 0:
+        fields = fields.insert(name, FieldValue::FromInteger(i));
+        break;
+      case 1:
+        fields = fields.insert(
+            name, FieldValue::FromString(absl::StrCat("some text ", i)));
+        break;
+      default:
+        fields = fields.insert(name, FieldValue::FromDouble(i + 0.5));
+        break;
+    }
+  }
+  return fields.insert("index", FieldValue::FromInteger(index));
+}
+
+std::shared_ptr<model::Document> MakeDocument(absl::string_view path,
+                                              int field_count,
+                                              int index) {
+  return testutil::Doc(path, 1, MakeFields(field_count, index));
+}
+
+Serializers::Serializers()
+    : remote_{DatabaseId{"benchmark-project", DatabaseId::kDefault}},
+      local_{remote_} {
+}
+
+std::string Serializers::EncodeMaybeDocument(
+    const MaybeDocument& document) const {
+  std::string result;
+  Writer writer = Writer::Wrap(&result);
+  firestore_client_MaybeDocument proto = local_.EncodeMaybeDocument(document);
+  writer.WriteNanopbMessage(firestore_client_MaybeDocument_fields, &proto);
+  local_.FreeNanopbMessage(firestore_client_MaybeDocument_fields, &proto);
+  return result;
+}
+
+std::unique_ptr<MaybeDocument> Serializers::DecodeMaybeDocument(
+    absl::string_view encoded) const {
+  Reader reader = Reader::Wrap(encoded);
+  firestore_client_MaybeDocument proto{};
+  reader.ReadNanopbMessage(firestore_client_MaybeDocument_fields, &proto);
+  std::unique_ptr<MaybeDocument> result =
+      local_.DecodeMaybeDocumentLazily(&reader, &proto);
+  reader.FreeNanopbMessage(firestore_client_MaybeDocument_fields, &proto);
+  HARD_ASSERT(reader.status().ok(), "Failed to decode document: %s",
+              reader.status().ToString());
+  return result;
+}
+
+}  // namespace benchmarks
+}  // namespace firestore
+}  // namespace firebase
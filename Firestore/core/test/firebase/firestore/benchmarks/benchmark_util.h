@@ -0,0 +1,75 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_BENCHMARKS_BENCHMARK_UTIL_H_
+#define FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_BENCHMARKS_BENCHMARK_UTIL_H_
+
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace benchmarks {
+
+/**
+ * Returns the fields of a typical document: `field_count` top-level fields
+ * cycling through integers, short strings and doubles, plus an `index` field
+ * holding `index` that benchmarks can filter on.
+ */
+model::FieldValue::Map MakeFields(int field_count, int index = 0);
+
+/** Returns a document at `path` with the fields from `MakeFields()`. */
+std::shared_ptr<model::Document> MakeDocument(absl::string_view path,
+                                              int field_count,
+                                              int index = 0);
+
+/**
+ * Owns a remote and a local serializer for a fixed database, since the local
+ * one only references the remote one.
+ */
+class Serializers {
+ public:
+  Serializers();
+
+  const local::LocalSerializer& local() const {
+    return local_;
+  }
+
+  /** Encodes the document as it is stored in the remote document cache. */
+  std::string EncodeMaybeDocument(const model::MaybeDocument& document) const;
+
+  /** Decodes a document encoded by `EncodeMaybeDocument()`. */
+  std::unique_ptr<model::MaybeDocument> DecodeMaybeDocument(
+      absl::string_view encoded) const;
+
+ private:
+  remote::Serializer remote_;
+  local::LocalSerializer local_;
+};
+
+}  // namespace benchmarks
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_BENCHMARKS_BENCHMARK_UTIL_H_
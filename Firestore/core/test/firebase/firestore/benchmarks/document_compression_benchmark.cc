@@ -0,0 +1,134 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_document_compressor.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/test/firebase/firestore/benchmarks/benchmark_util.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace benchmarks {
+namespace {
+
+using local::LevelDbDocumentCompressor;
+
+/**
+ * Encoded documents of one collection with `field_count` fields each, and the
+ * dictionary trained from the first of them, as the remote document cache
+ * would train it.
+ */
+class EncodedDocuments {
+ public:
+  explicit EncodedDocuments(int field_count) {
+    for (int i = 0; i < kDocumentCount; ++i) {
+      auto document = MakeDocument(absl::StrCat("rooms/", i), field_count, i);
+      documents_.push_back(serializers_.EncodeMaybeDocument(*document));
+    }
+    std::vector<std::string> samples(
+        documents_.begin(),
+        documents_.begin() + LevelDbDocumentCompressor::kDictionarySampleCount);
+    dictionary_ = LevelDbDocumentCompressor::TrainDictionary(samples);
+  }
+
+  const std::vector<std::string>& documents() const {
+    return documents_;
+  }
+
+  const std::string& dictionary() const {
+    return dictionary_;
+  }
+
+  static constexpr int kDocumentCount = 64;
+
+ private:
+  Serializers serializers_;
+  std::vector<std::string> documents_;
+  std::string dictionary_;
+};
+
+constexpr int EncodedDocuments::kDocumentCount;
+
+// Reports the size of the compressed documents relative to the raw ones,
+// which is what the CPU time below buys.
+void ReportRatio(benchmark::State& state,
+                 const std::vector<std::string>& raw,
+                 const std::vector<std::string>& compressed) {
+  size_t raw_bytes = 0;
+  size_t compressed_bytes = 0;
+  for (size_t i = 0; i < raw.size(); ++i) {
+    raw_bytes += raw[i].size();
+    compressed_bytes += compressed[i].size();
+  }
+  state.counters["raw_bytes"] = static_cast<double>(raw_bytes);
+  state.counters["ratio"] =
+      static_cast<double>(compressed_bytes) / static_cast<double>(raw_bytes);
+}
+
+// The argument is the number of fields per document. The second argument is
+// 1 to compress with the trained dictionary, 0 without any dictionary.
+void BM_CompressDocument(benchmark::State& state) {
+  EncodedDocuments encoded{static_cast<int>(state.range(0))};
+  std::string dictionary = state.range(1) ? encoded.dictionary() : "";
+
+  std::vector<std::string> compressed(encoded.documents().size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < compressed.size(); ++i) {
+      compressed[i] = LevelDbDocumentCompressor::Compress(
+          encoded.documents()[i], dictionary);
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          EncodedDocuments::kDocumentCount);
+  ReportRatio(state, encoded.documents(), compressed);
+}
+BENCHMARK(BM_CompressDocument)
+    ->Ranges({{1 << 2, 1 << 8}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// The argument is the number of fields per document.
+void BM_DecompressDocument(benchmark::State& state) {
+  EncodedDocuments encoded{static_cast<int>(state.range(0))};
+  std::vector<std::string> compressed;
+  for (const std::string& document : encoded.documents()) {
+    compressed.push_back(
+        LevelDbDocumentCompressor::Compress(document, encoded.dictionary()));
+  }
+
+  std::string raw;
+  for (auto _ : state) {
+    for (const std::string& value : compressed) {
+      bool ok = LevelDbDocumentCompressor::Decompress(
+          value, encoded.dictionary(), &raw);
+      HARD_ASSERT(ok, "Failed to decompress a document");
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          EncodedDocuments::kDocumentCount);
+  ReportRatio(state, encoded.documents(), compressed);
+}
+BENCHMARK(BM_DecompressDocument)
+    ->Range(1 << 2, 1 << 8)
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace firestore
+}  // namespace firebase
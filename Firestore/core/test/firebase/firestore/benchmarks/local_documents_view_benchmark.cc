@@ -0,0 +1,75 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation.h"
+#include "Firestore/core/test/firebase/firestore/benchmarks/benchmark_util.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace benchmarks {
+namespace {
+
+using model::FieldValue;
+using model::MaybeDocumentPtr;
+using model::Mutation;
+
+constexpr int kFieldsPerDocument = 10;
+
+// What `LocalDocumentsView` does to compute the local view of a document:
+// apply every pending mutation to it, in batch order, on top of the remote
+// document. The argument is the number of pending mutations, each of which
+// updates one field.
+void BM_ApplyPendingMutations(benchmark::State& state) {
+  int count = static_cast<int>(state.range(0));
+  MaybeDocumentPtr remote_document =
+      MakeDocument("rooms/eros", kFieldsPerDocument);
+
+  std::vector<std::unique_ptr<Mutation>> mutations;
+  for (int i = 0; i < count; ++i) {
+    std::string field = absl::StrCat("field", i % kFieldsPerDocument);
+    mutations.push_back(testutil::PatchMutation(
+        "rooms/eros", {{field, FieldValue::FromString(absl::StrCat(i))}},
+        {testutil::Field(field)}));
+  }
+  Timestamp local_write_time = Timestamp::Now();
+
+  for (auto _ : state) {
+    MaybeDocumentPtr document = remote_document;
+    for (const auto& mutation : mutations) {
+      document = mutation->ApplyToLocalView(document, remote_document.get(),
+                                            local_write_time);
+    }
+    benchmark::DoNotOptimize(document);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * count);
+}
+BENCHMARK(BM_ApplyPendingMutations)->Range(1, 1 << 10);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace firestore
+}  // namespace firebase
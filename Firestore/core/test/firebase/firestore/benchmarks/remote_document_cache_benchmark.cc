@@ -0,0 +1,169 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/util/autoid.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/test/firebase/firestore/benchmarks/benchmark_util.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "leveldb/db.h"
+
+namespace firebase {
+namespace firestore {
+namespace benchmarks {
+namespace {
+
+using local::LevelDbRemoteDocumentKey;
+using local::LevelDbRemoteDocumentKeyView;
+using local::LevelDbTransaction;
+using model::Document;
+using model::DocumentKey;
+using model::MaybeDocument;
+using model::ResourcePath;
+using util::Path;
+
+constexpr int kFieldsPerDocument = 10;
+
+/**
+ * A LevelDB database in a temporary directory holding `size` documents in
+ * the "rooms" collection, as written by the remote document cache. Each room
+ * also has a document in a subcollection, and there are as many documents in
+ * an unrelated collection, so that a scan of "rooms" has to skip rows like it
+ * would in a real cache.
+ */
+class RemoteDocuments {
+ public:
+  explicit RemoteDocuments(int size)
+      : dir_{Path::JoinUtf8(util::TempDir(),
+                            "firestore-benchmark-" + util::CreateAutoId())} {
+    leveldb::Options options;
+    options.create_if_missing = true;
+    leveldb::DB* db = nullptr;
+    leveldb::Status status =
+        leveldb::DB::Open(options, dir_.ToUtf8String(), &db);
+    HARD_ASSERT(status.ok(), "Failed to open %s: %s", dir_.ToUtf8String(),
+                status.ToString());
+    db_.reset(db);
+
+    LevelDbTransaction transaction{db_.get(), "RemoteDocuments"};
+    for (int i = 0; i < size; ++i) {
+      Put(&transaction, absl::StrCat("rooms/", i), i);
+      Put(&transaction, absl::StrCat("rooms/", i, "/messages/first"), i);
+      Put(&transaction, absl::StrCat("users/", i), i);
+    }
+    transaction.Commit();
+  }
+
+  ~RemoteDocuments() {
+    db_.reset();
+    util::Status status = util::RecursivelyDelete(dir_);
+    HARD_ASSERT(status.ok(), "Failed to clean up %s: %s", dir_.ToUtf8String(),
+                status.ToString());
+  }
+
+  leveldb::DB* db() const {
+    return db_.get();
+  }
+
+  const Serializers& serializers() const {
+    return serializers_;
+  }
+
+ private:
+  void Put(LevelDbTransaction* transaction, absl::string_view path, int index) {
+    auto document = MakeDocument(path, kFieldsPerDocument, index);
+    transaction->Put(LevelDbRemoteDocumentKey::Key(document->key()),
+                     serializers_.EncodeMaybeDocument(*document));
+  }
+
+  Path dir_;
+  std::unique_ptr<leveldb::DB> db_;
+  Serializers serializers_;
+};
+
+/**
+ * Reads the documents matching `query` the way
+ * `LevelDbRemoteDocumentCache::GetMatchingModels` does: a prefix scan over
+ * the collection that skips subcollections, decoding and matching each
+ * document.
+ */
+int64_t GetMatching(LevelDbTransaction* transaction,
+                    const Serializers& serializers,
+                    const core::Query& query) {
+  const ResourcePath& query_path = query.path();
+  auto it = transaction->NewIterator();
+  it->Seek(LevelDbRemoteDocumentKey::KeyPrefix(query_path));
+
+  int64_t matches = 0;
+  LevelDbRemoteDocumentKeyView current_key;
+  for (; it->Valid() && current_key.Decode(it->key()); it->Next()) {
+    if (!current_key.HasPrefix(query_path)) {
+      break;
+    }
+    if (current_key.segments().size() != query_path.size() + 1) {
+      continue;
+    }
+
+    std::unique_ptr<MaybeDocument> maybe_doc =
+        serializers.DecodeMaybeDocument(it->value());
+    if (maybe_doc->type() == MaybeDocument::Type::Document &&
+        query.Matches(static_cast<const Document&>(*maybe_doc))) {
+      ++matches;
+    }
+  }
+  return matches;
+}
+
+// The argument is the number of documents in the queried collection, half of
+// which match the query.
+void BM_GetMatching(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  RemoteDocuments documents{size};
+  core::Query query = testutil::Query("rooms").Filter(
+      testutil::Filter("index", ">=", size / 2));
+
+  for (auto _ : state) {
+    LevelDbTransaction transaction{documents.db(), "BM_GetMatching"};
+    int64_t matches =
+        GetMatching(&transaction, documents.serializers(), query);
+    HARD_ASSERT(matches == size - size / 2, "Unexpected number of matches");
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * size);
+}
+BENCHMARK(BM_GetMatching)
+    ->Range(1 << 4, 1 << 14)
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace firestore
+}  // namespace firebase
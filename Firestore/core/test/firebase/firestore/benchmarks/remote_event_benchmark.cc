@@ -0,0 +1,164 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <unordered_map>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/remote/decode_pool.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace benchmarks {
+namespace {
+
+using model::DocumentKey;
+using model::DocumentKeyHash;
+using model::DocumentKeySet;
+using remote::DecodePool;
+
+enum class ChangeType { kAdded, kModified, kRemoved };
+
+using DocumentChanges =
+    std::unordered_map<DocumentKey, ChangeType, DocumentKeyHash>;
+
+struct TargetChange {
+  DocumentKeySet added;
+  DocumentKeySet modified;
+  DocumentKeySet removed;
+};
+
+/**
+ * Builds the change of a single target from its pending document changes,
+ * like `TargetState::ToTargetChange` does for every target of a remote event
+ * created by `WatchChangeAggregator::CreateRemoteEvent`.
+ */
+TargetChange ToTargetChange(const DocumentChanges& changes) {
+  std::vector<DocumentKey> added;
+  std::vector<DocumentKey> modified;
+  std::vector<DocumentKey> removed;
+  for (const auto& entry : changes) {
+    switch (entry.second) {
+      case ChangeType::kAdded:
+        added.push_back(entry.first);
+        break;
+      case ChangeType::kModified:
+        modified.push_back(entry.first);
+        break;
+      case ChangeType::kRemoved:
+        removed.push_back(entry.first);
+        break;
+    }
+  }
+
+  auto less = [](const DocumentKey& lhs, const DocumentKey& rhs) {
+    return util::Ascending(lhs.CompareTo(rhs));
+  };
+  std::sort(added.begin(), added.end(), less);
+  std::sort(modified.begin(), modified.end(), less);
+  std::sort(removed.begin(), removed.end(), less);
+
+  return TargetChange{DocumentKeySet::FromSorted(added.begin(), added.end()),
+                      DocumentKeySet::FromSorted(modified.begin(),
+                                                 modified.end()),
+                      DocumentKeySet::FromSorted(removed.begin(),
+                                                 removed.end())};
+}
+
+std::vector<DocumentChanges> MakeTargets(int target_count,
+                                         int changes_per_target) {
+  std::vector<DocumentChanges> result(static_cast<size_t>(target_count));
+  for (int target = 0; target < target_count; ++target) {
+    for (int i = 0; i < changes_per_target; ++i) {
+      DocumentKey key =
+          testutil::Key(absl::StrCat("rooms", target, "/doc", i));
+      result[target][key] = static_cast<ChangeType>(i % 3);
+    }
+  }
+  return result;
+}
+
+// The arguments are the number of targets and the number of document changes
+// of each.
+void BM_CreateRemoteEvent(benchmark::State& state) {
+  std::vector<DocumentChanges> targets =
+      MakeTargets(static_cast<int>(state.range(0)),
+                  static_cast<int>(state.range(1)));
+
+  for (auto _ : state) {
+    std::vector<TargetChange> result;
+    result.reserve(targets.size());
+    for (const DocumentChanges& changes : targets) {
+      result.push_back(ToTargetChange(changes));
+    }
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0) * state.range(1));
+}
+BENCHMARK(BM_CreateRemoteEvent)
+    ->Ranges({{1, 1 << 6}, {1 << 4, 1 << 12}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Like the above, with the targets split across a `DecodePool`, as remote
+// events with many document changes are.
+void BM_CreateRemoteEventInParallel(benchmark::State& state) {
+  std::vector<DocumentChanges> targets =
+      MakeTargets(static_cast<int>(state.range(0)),
+                  static_cast<int>(state.range(1)));
+
+  std::vector<std::unique_ptr<util::Executor>> executors;
+  size_t threads = std::max(std::thread::hardware_concurrency(), 2U);
+  for (size_t i = 0; i < threads; ++i) {
+    executors.push_back(absl::make_unique<util::ExecutorStd>());
+  }
+  DecodePool pool{std::move(executors)};
+
+  for (auto _ : state) {
+    std::vector<TargetChange> result(targets.size());
+    std::vector<std::function<void()>> operations;
+    for (size_t i = 0; i < targets.size(); ++i) {
+      operations.push_back(
+          [&result, &targets, i] { result[i] = ToTargetChange(targets[i]); });
+    }
+    pool.RunAll(std::move(operations));
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0) * state.range(1));
+}
+BENCHMARK(BM_CreateRemoteEventInParallel)
+    ->Ranges({{1 << 2, 1 << 6}, {1 << 4, 1 << 12}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/test/firebase/firestore/benchmarks/allocation_reporter.h"
+#include "Firestore/core/test/firebase/firestore/benchmarks/benchmark_util.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace benchmarks {
+namespace {
+
+using model::Document;
+using model::FieldPath;
+using model::MaybeDocument;
+
+// The argument of each benchmark is the number of fields in the document.
+
+void BM_EncodeDocument(benchmark::State& state) {
+  Serializers serializers;
+  auto document = MakeDocument("rooms/eros", static_cast<int>(state.range(0)));
+
+  int64_t bytes = 0;
+  AllocationReporter allocations{state};
+  for (auto _ : state) {
+    std::string encoded = serializers.EncodeMaybeDocument(*document);
+    bytes += static_cast<int64_t>(encoded.size());
+  }
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_EncodeDocument)->Range(1, 1 << 12);
+
+// Fields are decoded lazily, so this is the cost of decoding the document
+// for a query that reads a single field of it...
+void BM_DecodeDocument(benchmark::State& state) {
+  Serializers serializers;
+  auto document = MakeDocument("rooms/eros", static_cast<int>(state.range(0)));
+  std::string encoded = serializers.EncodeMaybeDocument(*document);
+
+  AllocationReporter allocations{state};
+  for (auto _ : state) {
+    std::unique_ptr<MaybeDocument> decoded =
+        serializers.DecodeMaybeDocument(encoded);
+    const auto& data = static_cast<Document&>(*decoded).data();
+    benchmark::DoNotOptimize(data.Get(FieldPath{"index"}));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(encoded.size()));
+}
+BENCHMARK(BM_DecodeDocument)->Range(1, 1 << 12);
+
+// ...and this is the cost for a caller that reads every field.
+void BM_DecodeDocumentAndReadAllFields(benchmark::State& state) {
+  Serializers serializers;
+  auto document = MakeDocument("rooms/eros", static_cast<int>(state.range(0)));
+  std::string encoded = serializers.EncodeMaybeDocument(*document);
+
+  AllocationReporter allocations{state};
+  for (auto _ : state) {
+    std::unique_ptr<MaybeDocument> decoded =
+        serializers.DecodeMaybeDocument(encoded);
+    const auto& data = static_cast<Document&>(*decoded).data();
+    benchmark::DoNotOptimize(data.GetInternalValue().size());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(encoded.size()));
+}
+BENCHMARK(BM_DecodeDocumentAndReadAllFields)->Range(1, 1 << 12);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace firestore
+}  // namespace firebase
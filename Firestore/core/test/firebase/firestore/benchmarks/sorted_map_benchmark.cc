@@ -0,0 +1,127 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+#include "Firestore/core/test/firebase/firestore/benchmarks/allocation_reporter.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace {
+
+using benchmarks::AllocationReporter;
+
+using IntMap = SortedMap<int, int>;
+
+// The argument of each benchmark is the number of entries. Maps of up to
+// `kFixedSize` entries are backed by arrays, larger ones by trees.
+
+std::vector<int> Sequence(int size) {
+  std::vector<int> result(static_cast<size_t>(size));
+  std::iota(result.begin(), result.end(), 0);
+  return result;
+}
+
+std::vector<int> Shuffled(int size) {
+  std::vector<int> result = Sequence(size);
+  std::shuffle(result.begin(), result.end(), std::mt19937{42});
+  return result;
+}
+
+IntMap Build(const std::vector<int>& keys) {
+  IntMap map;
+  for (int key : keys) {
+    map = map.insert(key, key);
+  }
+  return map;
+}
+
+void BM_SortedMapInsertInOrder(benchmark::State& state) {
+  std::vector<int> keys = Sequence(static_cast<int>(state.range(0)));
+  AllocationReporter allocations{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Build(keys));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+BENCHMARK(BM_SortedMapInsertInOrder)->Range(1 << 3, 1 << 16);
+
+void BM_SortedMapInsertRandomly(benchmark::State& state) {
+  std::vector<int> keys = Shuffled(static_cast<int>(state.range(0)));
+  AllocationReporter allocations{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Build(keys));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+BENCHMARK(BM_SortedMapInsertRandomly)->Range(1 << 3, 1 << 16);
+
+// Building from sorted entries is how most maps loaded from persistence
+// are created.
+void BM_SortedMapFromSorted(benchmark::State& state) {
+  std::vector<int> keys = Sequence(static_cast<int>(state.range(0)));
+  AllocationReporter allocations{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(IntMap::FromSorted(keys.begin(), keys.end()));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+BENCHMARK(BM_SortedMapFromSorted)->Range(1 << 3, 1 << 16);
+
+void BM_SortedMapIterate(benchmark::State& state) {
+  IntMap map = Build(Shuffled(static_cast<int>(state.range(0))));
+  AllocationReporter allocations{state};
+  for (auto _ : state) {
+    int64_t sum = 0;
+    for (const auto& entry : map) {
+      sum += entry.second;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+BENCHMARK(BM_SortedMapIterate)->Range(1 << 3, 1 << 16);
+
+void BM_SortedMapFind(benchmark::State& state) {
+  std::vector<int> keys = Shuffled(static_cast<int>(state.range(0)));
+  IntMap map = Build(keys);
+  AllocationReporter allocations{state};
+  for (auto _ : state) {
+    for (int key : keys) {
+      benchmark::DoNotOptimize(map.find(key));
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+BENCHMARK(BM_SortedMapFind)->Range(1 << 3, 1 << 16);
+
+}  // namespace
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
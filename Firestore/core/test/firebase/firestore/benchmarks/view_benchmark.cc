@@ -0,0 +1,128 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/test/firebase/firestore/benchmarks/benchmark_util.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace benchmarks {
+namespace {
+
+using model::Document;
+using model::DocumentKey;
+using model::DocumentKeySet;
+
+using DocumentsByKey =
+    immutable::SortedMap<DocumentKey, std::shared_ptr<Document>>;
+
+constexpr int kFieldsPerDocument = 10;
+
+struct ViewChanges {
+  int added = 0;
+  int modified = 0;
+  int removed = 0;
+};
+
+/**
+ * Applies changed documents to the documents of a view the way `FSTView`
+ * computes its document changes: each changed document is matched against the
+ * query and added to, replaced in or removed from the view's documents.
+ */
+ViewChanges ComputeDocChanges(
+    const core::Query& query,
+    const std::vector<std::shared_ptr<Document>>& changed_documents,
+    DocumentsByKey* documents,
+    DocumentKeySet* keys) {
+  ViewChanges changes;
+  for (const auto& document : changed_documents) {
+    const DocumentKey& key = document->key();
+    bool was_in_view = keys->contains(key);
+    bool matches = query.Matches(*document);
+
+    if (matches) {
+      *documents = documents->insert(key, document);
+      if (was_in_view) {
+        ++changes.modified;
+      } else {
+        *keys = keys->insert(key);
+        ++changes.added;
+      }
+    } else if (was_in_view) {
+      *documents = documents->erase(key);
+      *keys = keys->erase(key);
+      ++changes.removed;
+    }
+  }
+  return changes;
+}
+
+// The argument is the number of documents in the view. A tenth of them as
+// many documents change: some start matching the query, some stop matching and
+// the rest are modified.
+void BM_ComputeDocChanges(benchmark::State& state) {
+  int size = static_cast<int>(state.range(0));
+  core::Query query =
+      testutil::Query("rooms").Filter(testutil::Filter("index", ">=", 0));
+
+  DocumentsByKey initial_documents;
+  DocumentKeySet initial_keys;
+  for (int i = 0; i < size; ++i) {
+    auto document =
+        MakeDocument(absl::StrCat("rooms/", i), kFieldsPerDocument, i);
+    initial_documents = initial_documents.insert(document->key(), document);
+    initial_keys = initial_keys.insert(document->key());
+  }
+
+  std::vector<std::shared_ptr<Document>> changed_documents;
+  int change_count = std::max(size / 10, 1);
+  for (int i = 0; i < change_count; ++i) {
+    // Negative indexes don't match the query.
+    int index = i % 3 == 0 ? -1 : i;
+    int id = i % 3 == 1 ? size + i : i * 10;
+    changed_documents.push_back(
+        MakeDocument(absl::StrCat("rooms/", id), kFieldsPerDocument, index));
+  }
+
+  for (auto _ : state) {
+    DocumentsByKey documents = initial_documents;
+    DocumentKeySet keys = initial_keys;
+    ViewChanges changes =
+        ComputeDocChanges(query, changed_documents, &documents, &keys);
+    benchmark::DoNotOptimize(changes);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          change_count);
+}
+BENCHMARK(BM_ComputeDocChanges)->Range(1 << 4, 1 << 14);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace firestore
+}  // namespace firebase
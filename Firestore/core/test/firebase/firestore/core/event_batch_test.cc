@@ -0,0 +1,176 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/event_batch.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/event_listener.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/base/config.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+namespace {
+
+using util::Executor;
+using util::StatusOr;
+
+// Holds on to operations until told to run them.
+class FakeExecutor : public Executor {
+ public:
+  void Execute(Operation&& operation) override {
+    operations.push_back(std::move(operation));
+  }
+  void ExecuteBlocking(Operation&& operation) override {
+    operation();
+  }
+  util::DelayedOperation Schedule(Milliseconds, TaggedOperation&&) override {
+    return {};
+  }
+  bool IsCurrentExecutor() const override {
+    return false;
+  }
+  std::string CurrentExecutorName() const override {
+    return "";
+  }
+  std::string Name() const override {
+    return "FakeExecutor";
+  }
+  bool IsScheduled(Tag) const override {
+    return false;
+  }
+  absl::optional<TaggedOperation> PopFromSchedule() override {
+    return {};
+  }
+
+  void RunAll() {
+    std::vector<Operation> pending = std::move(operations);
+    operations.clear();
+    for (Operation& operation : pending) {
+      operation();
+    }
+  }
+
+  std::vector<Operation> operations;
+};
+
+std::shared_ptr<AsyncEventListener<int>> MakeListener(
+    Executor* executor, std::vector<std::string>* events, std::string name) {
+  return AsyncEventListener<int>::Create(
+      executor, EventListener<int>::Create(
+                    [events, name](const StatusOr<int>& maybe_value) {
+                      events->push_back(
+                          name + std::to_string(maybe_value.ValueOrDie()));
+                    }));
+}
+
+}  // namespace
+
+TEST(EventBatchTest, WithoutBatchEachEventIsAnOperation) {
+  FakeExecutor executor;
+  std::vector<std::string> events;
+  auto a = MakeListener(&executor, &events, "a");
+  auto b = MakeListener(&executor, &events, "b");
+
+  a->OnEvent(1);
+  b->OnEvent(2);
+  EXPECT_EQ(2u, executor.operations.size());
+
+  executor.RunAll();
+  EXPECT_EQ((std::vector<std::string>{"a1", "b2"}), events);
+}
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+
+TEST(EventBatchTest, GroupsEventsPerExecutor) {
+  FakeExecutor first;
+  FakeExecutor second;
+  std::vector<std::string> events;
+  auto a = MakeListener(&first, &events, "a");
+  auto b = MakeListener(&second, &events, "b");
+  auto c = MakeListener(&first, &events, "c");
+
+  {
+    EventBatch batch;
+    a->OnEvent(1);
+    b->OnEvent(2);
+    c->OnEvent(3);
+    a->OnEvent(4);
+    EXPECT_TRUE(first.operations.empty());
+    EXPECT_TRUE(second.operations.empty());
+  }
+  EXPECT_EQ(1u, first.operations.size());
+  EXPECT_EQ(1u, second.operations.size());
+
+  first.RunAll();
+  EXPECT_EQ((std::vector<std::string>{"a1", "c3", "a4"}), events);
+  second.RunAll();
+  EXPECT_EQ((std::vector<std::string>{"a1", "c3", "a4", "b2"}), events);
+}
+
+TEST(EventBatchTest, ChecksMutedListenersWhenRun) {
+  FakeExecutor executor;
+  std::vector<std::string> events;
+  auto a = MakeListener(&executor, &events, "a");
+  auto b = MakeListener(&executor, &events, "b");
+
+  {
+    EventBatch batch;
+    a->OnEvent(1);
+    b->OnEvent(2);
+  }
+  a->Mute();
+
+  executor.RunAll();
+  EXPECT_EQ((std::vector<std::string>{"b2"}), events);
+}
+
+TEST(EventBatchTest, NestedBatchesDispatchSeparately) {
+  FakeExecutor executor;
+  std::vector<std::string> events;
+  auto a = MakeListener(&executor, &events, "a");
+
+  {
+    EventBatch outer;
+    a->OnEvent(1);
+    {
+      EventBatch inner;
+      EXPECT_EQ(&inner, EventBatch::Current());
+      a->OnEvent(2);
+      a->OnEvent(3);
+    }
+    EXPECT_EQ(&outer, EventBatch::Current());
+    EXPECT_EQ(1u, executor.operations.size());
+  }
+  EXPECT_EQ(nullptr, EventBatch::Current());
+  EXPECT_EQ(2u, executor.operations.size());
+
+  executor.RunAll();
+  EXPECT_EQ((std::vector<std::string>{"a2", "a3", "a1"}), events);
+}
+
+#endif  // defined(ABSL_HAVE_THREAD_LOCAL)
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/query_builder.h"
+
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::Document;
+using model::FieldPath;
+using model::FieldValue;
+using model::ResourcePath;
+using testutil::Doc;
+using testutil::Field;
+
+TEST(QueryBuilderTest, ParsesEachFieldNameOnce) {
+  QueryBuilder builder;
+  const FieldPath& first = builder.ParseField("a.b");
+  const FieldPath& second = builder.ParseField("a.b");
+
+  EXPECT_EQ(Field("a.b"), first);
+  EXPECT_EQ(&first, &second);
+  EXPECT_EQ(1u, builder.parsed_field_count());
+
+  builder.ParseField("c");
+  EXPECT_EQ(2u, builder.parsed_field_count());
+}
+
+TEST(QueryBuilderTest, BuildsFilters) {
+  QueryBuilder builder;
+  Query base = Query::AtPath(ResourcePath::FromString("collection"));
+
+  for (int i = 0; i < 3; i++) {
+    Query query = builder.Where(base, "a.b", Filter::Operator::GreaterThan,
+                                FieldValue::FromInteger(1));
+
+    ASSERT_EQ(1u, query.filters().size());
+    EXPECT_EQ(Field("a.b"), query.filters()[0]->field());
+
+    Document match = *Doc("collection/1", 0,
+                          {{"a", FieldValue::FromMap(
+                                     {{"b", FieldValue::FromInteger(2)}})}});
+    Document other = *Doc("collection/2", 0,
+                          {{"a", FieldValue::FromMap(
+                                     {{"b", FieldValue::FromInteger(0)}})}});
+    EXPECT_TRUE(query.Matches(match));
+    EXPECT_FALSE(query.Matches(other));
+  }
+  EXPECT_EQ(1u, builder.parsed_field_count());
+}
+
+TEST(QueryBuilderTest, BuildsProjections) {
+  QueryBuilder builder;
+  Query base = Query::AtPath(ResourcePath::FromString("collection"));
+
+  Query query = builder.Select(base, {"title", "a.b"});
+  EXPECT_EQ(base.Select({Field("title"), Field("a.b")}), query);
+  EXPECT_EQ(query, builder.Select(base, {"a.b", "title"}));
+  EXPECT_EQ(2u, builder.parsed_field_count());
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
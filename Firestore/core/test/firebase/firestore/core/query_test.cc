@@ -17,6 +17,7 @@
 #include "Firestore/core/src/firebase/firestore/core/query.h"
 
 #include <cmath>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
@@ -30,9 +31,11 @@ namespace firestore {
 namespace core {
 
 using model::Document;
+using model::FieldPath;
 using model::FieldValue;
 using model::ResourcePath;
 using testutil::Doc;
+using testutil::Field;
 using testutil::Filter;
 
 TEST(QueryTest, MatchesBasedOnDocumentKey) {
@@ -119,6 +122,33 @@ TEST(QueryTest, NanFilter) {
   EXPECT_FALSE(query.Matches(doc5));
 }
 
+TEST(QueryTest, ProjectionIncludesFilteredFields) {
+  // Filters compare by identity, so both queries share the same one.
+  auto filter = Filter("sort", ">=", 2);
+  Query query = Query::AtPath(ResourcePath::FromString("collection"))
+                    .Filter(filter)
+                    .Select({Field("title"), Field("a.b"), Field("title")});
+
+  std::vector<FieldPath> expected{Field("a.b"), Field("sort"), Field("title")};
+  EXPECT_TRUE(query.HasProjection());
+  EXPECT_EQ(expected, query.projection());
+
+  Query filtered_later = Query::AtPath(ResourcePath::FromString("collection"))
+                             .Select({Field("title"), Field("a.b")})
+                             .Filter(filter);
+  EXPECT_EQ(query, filtered_later);
+}
+
+TEST(QueryTest, ProjectionIsPartOfEquality) {
+  Query all_fields = Query::AtPath(ResourcePath::FromString("collection"));
+  Query projected = all_fields.Select({Field("title")});
+
+  EXPECT_FALSE(all_fields.HasProjection());
+  EXPECT_NE(all_fields, projected);
+  EXPECT_EQ(all_fields, projected.Select({}));
+  EXPECT_EQ(projected, all_fields.Select({Field("title"), Field("__name__")}));
+}
+
 }  // namespace core
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/transaction.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#import "Firestore/Source/Model/FSTDocument.h"
+
+#include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/remote/datastore.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "Firestore/core/test/firebase/firestore/util/fake_credentials_provider.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::DatabaseId;
+using model::DocumentKey;
+using remote::Datastore;
+using testutil::Key;
+using util::AsyncQueue;
+using util::ExecutorStd;
+using util::FakeCredentialsProvider;
+using util::Status;
+
+namespace {
+
+/** A `Datastore` that records lookups for the test to complete. */
+class FakeDatastore : public Datastore {
+ public:
+  using Datastore::Datastore;
+
+  struct Lookup {
+    std::vector<DocumentKey> keys;
+    LookupCallback callback;
+  };
+
+  void LookupDocuments(const std::vector<DocumentKey>& keys,
+                       LookupCallback&& callback) override {
+    lookups.push_back(Lookup{keys, std::move(callback)});
+  }
+
+  std::vector<Lookup> lookups;
+};
+
+FSTMaybeDocument* Doc(const std::string& path) {
+  return [FSTDeletedDocument documentWithKey:Key(path)
+                                     version:testutil::Version(1)
+                       hasCommittedMutations:NO];
+}
+
+/** Collects the results of a lookup. */
+struct LookupResult {
+  Transaction::LookupCallback Callback() {
+    return [this](const std::vector<FSTMaybeDocument*>& docs,
+                  const Status& result_status) {
+      done = true;
+      documents = docs;
+      status = result_status;
+    };
+  }
+
+  bool done = false;
+  std::vector<FSTMaybeDocument*> documents;
+  Status status;
+};
+
+}  // namespace
+
+class TransactionTest : public testing::Test {
+ public:
+  TransactionTest()
+      : worker_queue{absl::make_unique<ExecutorStd>()},
+        database_info{DatabaseId{"p", "d"}, "", "some.host", false},
+        datastore{std::make_shared<FakeDatastore>(database_info, &worker_queue,
+                                                  &credentials)} {
+  }
+
+  ~TransactionTest() {
+    datastore->Shutdown();
+  }
+
+  std::shared_ptr<Transaction> CreateTransaction() {
+    return std::make_shared<Transaction>(datastore.get(), &worker_queue);
+  }
+
+  /** Completes the given lookup on the worker queue, like gRPC would. */
+  void CompleteLookup(size_t index,
+                      const std::vector<FSTMaybeDocument*>& documents) {
+    worker_queue.EnqueueBlocking(
+        [&] { datastore->lookups[index].callback(documents, Status::OK()); });
+    // Let the lookups that were waiting for this one get sent.
+    worker_queue.EnqueueBlocking([] {});
+  }
+
+  AsyncQueue worker_queue;
+  DatabaseInfo database_info;
+  FakeCredentialsProvider credentials;
+  std::shared_ptr<FakeDatastore> datastore;
+};
+
+TEST_F(TransactionTest, MergesLookupsIntoOneRequest) {
+  auto transaction = CreateTransaction();
+  LookupResult first;
+  LookupResult second;
+  transaction->Lookup({Key("docs/a")}, first.Callback());
+  transaction->Lookup({Key("docs/a"), Key("docs/b")}, second.Callback());
+  worker_queue.EnqueueBlocking([] {});
+
+  ASSERT_EQ(datastore->lookups.size(), 1u);
+  EXPECT_EQ(datastore->lookups[0].keys,
+            (std::vector<DocumentKey>{Key("docs/a"), Key("docs/b")}));
+
+  CompleteLookup(0, {Doc("docs/b"), Doc("docs/a")});
+  ASSERT_TRUE(first.done);
+  EXPECT_TRUE(first.status.ok());
+  ASSERT_EQ(first.documents.size(), 1u);
+  EXPECT_EQ([first.documents[0] key], Key("docs/a"));
+
+  ASSERT_TRUE(second.done);
+  EXPECT_TRUE(second.status.ok());
+  ASSERT_EQ(second.documents.size(), 2u);
+  EXPECT_EQ([second.documents[0] key], Key("docs/a"));
+  EXPECT_EQ([second.documents[1] key], Key("docs/b"));
+  EXPECT_EQ(transaction->read_keys().size(), 2u);
+}
+
+TEST_F(TransactionTest, LooksUpOnlyDocumentsThatWereNotPrefetched) {
+  auto transaction = CreateTransaction();
+  transaction->Prefetch({Key("docs/a"), Key("docs/b")});
+  ASSERT_EQ(datastore->lookups.size(), 1u);
+
+  LookupResult result;
+  transaction->Lookup({Key("docs/a"), Key("docs/c")}, result.Callback());
+  worker_queue.EnqueueBlocking([] {});
+
+  // The lookup waits for the prefetch rather than fetch docs/a a second time.
+  EXPECT_EQ(datastore->lookups.size(), 1u);
+  EXPECT_FALSE(result.done);
+
+  CompleteLookup(0, {Doc("docs/a"), Doc("docs/b")});
+  ASSERT_EQ(datastore->lookups.size(), 2u);
+  EXPECT_EQ(datastore->lookups[1].keys,
+            (std::vector<DocumentKey>{Key("docs/c")}));
+  EXPECT_FALSE(result.done);
+
+  CompleteLookup(1, {Doc("docs/c")});
+  ASSERT_TRUE(result.done);
+  EXPECT_TRUE(result.status.ok());
+  ASSERT_EQ(result.documents.size(), 2u);
+  EXPECT_EQ([result.documents[0] key], Key("docs/a"));
+  EXPECT_EQ([result.documents[1] key], Key("docs/c"));
+
+  // Prefetched documents only count as read once they are looked up.
+  EXPECT_EQ(transaction->read_keys().size(), 2u);
+}
+
+TEST_F(TransactionTest, IgnoresPrefetchThatFinishesAfterTheTransaction) {
+  std::weak_ptr<Transaction> weak_transaction;
+  {
+    auto transaction = CreateTransaction();
+    transaction->Prefetch({Key("docs/a")});
+    weak_transaction = transaction;
+  }
+  EXPECT_TRUE(weak_transaction.expired());
+
+  ASSERT_EQ(datastore->lookups.size(), 1u);
+  CompleteLookup(0, {Doc("docs/a")});
+  EXPECT_EQ(datastore->lookups.size(), 1u);
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2018 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/pool_allocator.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/config.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+struct Payload {
+  char bytes[40];
+};
+
+TEST(PoolAllocatorTest, ReusesFreedBlocks) {
+  using Pool = BlockPool<sizeof(Payload)>;
+
+  void* first = Pool::Allocate();
+  Pool::Deallocate(first);
+  void* second = Pool::Allocate();
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  EXPECT_EQ(first, second);
+#endif
+  Pool::Deallocate(second);
+}
+
+TEST(PoolAllocatorTest, BoundsRetainedMemory) {
+  using SmallPool = BlockPool<64>;
+  using LargePool = BlockPool<SmallPool::kMaxPooledBytes * 2>;
+  EXPECT_EQ(SmallPool::kMaxPooledBytes / 64, SmallPool::kMaxPooledBlocks);
+  EXPECT_EQ(1u, LargePool::kMaxPooledBlocks);
+}
+
+TEST(PoolAllocatorTest, WorksWithAllocateShared) {
+  std::vector<std::shared_ptr<std::string>> strings;
+  for (int i = 0; i < 100; ++i) {
+    strings.push_back(std::allocate_shared<std::string>(
+        PoolAllocator<std::string>{}, std::to_string(i)));
+  }
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(std::to_string(i), *strings[i]);
+  }
+}
+
+TEST(PoolAllocatorTest, WorksWithArrays) {
+  std::vector<int, PoolAllocator<int>> values;
+  for (int i = 0; i < 100; ++i) {
+    values.push_back(i);
+  }
+  EXPECT_EQ(100u, values.size());
+  EXPECT_EQ(99, values.back());
+}
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
@@ -65,8 +65,13 @@ class SortedMapTest : public ::testing::Test {
   }
 };
 
+// A SortedMap that switches to a tree after only a few entries, so that the
+// conversion is exercised by every test.
+using SmallArraySortedMap = SortedMap<int, int, util::Comparator<int>, 4>;
+
 // NOLINTNEXTLINE: must be a typedef for the gtest macros
 typedef ::testing::Types<SortedMap<int, int>,
+                         SmallArraySortedMap,
                          impl::ArraySortedMap<int, int>,
                          impl::TreeSortedMap<int, int>>
     TestedTypes;
@@ -225,6 +230,46 @@ TYPED_TEST(SortedMapTest, InsertionAndRemovalOfMaxItems) {
   ASSERT_EQ(0u, map.size()) << "Check we removed all of the items";
 }
 
+TYPED_TEST(SortedMapTest, ConsumingUpdatesDoNotAffectCopies) {
+  int n = this->large_number();
+  std::vector<int> to_insert = Shuffled(Sequence(n));
+  std::vector<int> to_remove = Shuffled(to_insert);
+
+  TypeParam map;
+  std::vector<TypeParam> snapshots;
+  for (int i : to_insert) {
+    map = std::move(map).insert(i, i);
+    if (i % 7 == 0) {
+      snapshots.push_back(map);
+    }
+  }
+  ASSERT_SEQ_EQ(Pairs(Sequence(n)), map);
+
+  // Overwriting values in place
+  for (int i : to_insert) {
+    map = std::move(map).insert(i, -i);
+  }
+  for (const auto& entry : map) {
+    ASSERT_EQ(-entry.first, entry.second);
+  }
+
+  for (int i : to_remove) {
+    map = std::move(map).erase(i);
+  }
+  ASSERT_TRUE(map.empty());
+
+  // Each snapshot still holds exactly the entries inserted before it was taken.
+  size_t snapshot = 0;
+  std::vector<int> inserted;
+  for (int i : to_insert) {
+    inserted.push_back(i);
+    if (i % 7 == 0) {
+      ASSERT_SEQ_EQ(Pairs(Sorted(inserted)), snapshots[snapshot]);
+      ++snapshot;
+    }
+  }
+}
+
 TYPED_TEST(SortedMapTest, EraseDoesNotInvalidateIterators) {
   std::vector<int> keys = Sequence(1, 4);
   TypeParam original = ToMap<TypeParam>(keys);
@@ -472,6 +517,17 @@ TYPED_TEST(SortedMapTest, KeysIn) {
   ASSERT_SEQ_EQ(Seq(8, 14), map.keys_in(7, 13));   // in between to in between
 }
 
+TEST(SortedMapFromSorted, BuildsArraysAndTrees) {
+  using IntMap = SortedMap<int, int>;
+
+  for (int size : {0, 1, static_cast<int>(SortedMapBase::kFixedSize),
+                   static_cast<int>(SortedMapBase::kFixedSize) + 1, 100}) {
+    std::vector<std::pair<int, int>> pairs = Pairs(Sequence(size));
+    IntMap map = IntMap::FromSorted(pairs.begin(), pairs.end());
+    EXPECT_EQ(pairs, Collect(map));
+  }
+}
+
 }  // namespace immutable
 }  // namespace firestore
 }  // namespace firebase
@@ -109,6 +109,61 @@ TEST(SortedSetTest, CanBeConstructedFromSortedMap) {
   ASSERT_TRUE(NotFound(map, 2));
 }
 
+TEST(SortedSetTest, FromSorted) {
+  std::vector<int> all = Sequence(kLargeNumber);
+  SortedSet<int> set = SortedSet<int>::FromSorted(all.begin(), all.end());
+
+  ASSERT_SEQ_EQ(all, set);
+  ASSERT_EQ(ToSet(all), set);
+}
+
+TEST(SortedSetTest, UnionWith) {
+  SortedSet<int> evens = ToSet(Sequence(0, kLargeNumber, 2));
+  SortedSet<int> odds = ToSet(Sequence(1, kLargeNumber, 2));
+
+  // Similarly-sized sets are merged.
+  ASSERT_SEQ_EQ(Sequence(kLargeNumber), evens.union_with(odds));
+  ASSERT_SEQ_EQ(Sequence(kLargeNumber), odds.union_with(evens));
+  ASSERT_SEQ_EQ(Collect(evens), evens.union_with(evens));
+  ASSERT_SEQ_EQ(Collect(evens), evens.union_with(SortedSet<int>{}));
+
+  // A small set is inserted into a large one.
+  SortedSet<int> few = ToSet(std::vector<int>{1, 2, 3});
+  std::vector<int> expected = Sequence(0, kLargeNumber, 2);
+  expected.insert(expected.begin() + 1, 1);
+  expected.insert(expected.begin() + 3, 3);
+  ASSERT_SEQ_EQ(expected, evens.union_with(few));
+  ASSERT_SEQ_EQ(expected, few.union_with(evens));
+}
+
+TEST(SortedSetTest, DifferenceWith) {
+  SortedSet<int> all = ToSet(Sequence(kLargeNumber));
+  SortedSet<int> evens = ToSet(Sequence(0, kLargeNumber, 2));
+
+  // Similarly-sized sets are merged.
+  ASSERT_SEQ_EQ(Sequence(1, kLargeNumber, 2), all.difference_with(evens));
+  ASSERT_SEQ_EQ(Empty(), evens.difference_with(all));
+  ASSERT_SEQ_EQ(Collect(all), all.difference_with(SortedSet<int>{}));
+
+  // A small set is erased from a large one.
+  SortedSet<int> few = ToSet(std::vector<int>{0, 1, 1000});
+  ASSERT_SEQ_EQ(Sequence(2, kLargeNumber), all.difference_with(few));
+}
+
+TEST(SortedSetTest, ConsumingUpdatesDoNotAffectCopies) {
+  SortedSet<int> set;
+  for (int i : Shuffled(Sequence(kLargeNumber))) {
+    set = std::move(set).insert(i);
+  }
+  SortedSet<int> copy = set;
+
+  for (int i : Sequence(0, kLargeNumber, 2)) {
+    set = std::move(set).erase(i);
+  }
+  ASSERT_SEQ_EQ(Sequence(1, kLargeNumber, 2), set);
+  ASSERT_SEQ_EQ(Sequence(kLargeNumber), copy);
+}
+
 TEST(SortedSetTest, Iterator) {
   std::vector<int> all = Sequence(kLargeNumber);
   SortedSet<int> set = ToSet(Shuffled(all));
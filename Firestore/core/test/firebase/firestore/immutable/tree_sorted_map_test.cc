@@ -230,6 +230,42 @@ TEST(TreeSortedMap, InitializerIsSorted) {
   EXPECT_TRUE(std::is_sorted(map.begin(), map.end()));
 }
 
+/**
+ * Verifies the left-leaning red-black invariants below the given node and
+ * returns its black height.
+ */
+static int CheckInvariants(const IntMap::node_type& node) {
+  if (node.empty()) {
+    return 0;
+  }
+  EXPECT_FALSE(node.right().red());
+  if (node.red()) {
+    EXPECT_FALSE(node.left().red());
+  }
+  EXPECT_EQ(node.left().size() + 1 + node.right().size(), node.size());
+
+  int left_height = CheckInvariants(node.left());
+  int right_height = CheckInvariants(node.right());
+  EXPECT_EQ(left_height, right_height);
+  return left_height + (node.red() ? 0 : 1);
+}
+
+TEST(TreeSortedMap, FromSortedBuildsValidTree) {
+  for (int size = 0; size <= 200; ++size) {
+    std::vector<std::pair<int, int>> pairs = Pairs(Sequence(size));
+    IntMap map = IntMap::FromSorted(pairs.begin(), pairs.end(), {});
+
+    ASSERT_EQ(pairs, Collect(map));
+    EXPECT_FALSE(map.root().red());
+    CheckInvariants(map.root());
+
+    // The result behaves like any other tree.
+    IntMap modified = map.insert(size, size).erase(0);
+    EXPECT_EQ(Pairs(Sequence(1, size + 1)), Collect(modified));
+    CheckInvariants(modified.root());
+  }
+}
+
 }  // namespace impl
 }  // namespace immutable
 }  // namespace firestore
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_document_compressor.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+// Looks enough like an encoded document: field names shared by every sample,
+// with values that differ.
+std::string Sample(int i) {
+  std::string result = "\x0a\x20projects/p/databases/(default)/documents/";
+  for (int field = 0; field < 10; ++field) {
+    result += "field_name_" + std::to_string(field) + "=value_" +
+              std::to_string(i * 31 + field) + ";";
+  }
+  return result;
+}
+
+std::vector<std::string> Samples() {
+  std::vector<std::string> samples;
+  for (int i = 0; i < 8; ++i) {
+    samples.push_back(Sample(i));
+  }
+  return samples;
+}
+
+}  // namespace
+
+TEST(LevelDbDocumentCompressorTest, CompressDecompressCycle) {
+  std::string dictionary =
+      LevelDbDocumentCompressor::TrainDictionary(Samples());
+  std::string raw = Sample(100);
+
+  std::string compressed =
+      LevelDbDocumentCompressor::Compress(raw, dictionary);
+  ASSERT_TRUE(LevelDbDocumentCompressor::IsCompressed(compressed));
+  ASSERT_LT(compressed.size(), raw.size());
+
+  std::string decompressed;
+  ASSERT_TRUE(LevelDbDocumentCompressor::Decompress(compressed, dictionary,
+                                                    &decompressed));
+  ASSERT_EQ(raw, decompressed);
+}
+
+TEST(LevelDbDocumentCompressorTest, RawValuesAreNotCompressed) {
+  ASSERT_FALSE(LevelDbDocumentCompressor::IsCompressed(""));
+  ASSERT_FALSE(LevelDbDocumentCompressor::IsCompressed(Sample(0)));
+}
+
+TEST(LevelDbDocumentCompressorTest, DictionaryHelpsSmallValues) {
+  std::string dictionary =
+      LevelDbDocumentCompressor::TrainDictionary(Samples());
+  std::string raw = Sample(100);
+
+  std::string with_dictionary =
+      LevelDbDocumentCompressor::Compress(raw, dictionary);
+  std::string without_dictionary =
+      LevelDbDocumentCompressor::Compress(raw, "");
+  ASSERT_LT(with_dictionary.size(), without_dictionary.size());
+}
+
+TEST(LevelDbDocumentCompressorTest, WrongDictionaryFails) {
+  std::string dictionary =
+      LevelDbDocumentCompressor::TrainDictionary(Samples());
+  std::string compressed =
+      LevelDbDocumentCompressor::Compress(Sample(100), dictionary);
+
+  std::string decompressed;
+  ASSERT_FALSE(LevelDbDocumentCompressor::Decompress(
+      compressed, "some other dictionary", &decompressed));
+  ASSERT_FALSE(LevelDbDocumentCompressor::Decompress(
+      compressed.substr(0, 4), dictionary, &decompressed));
+}
+
+TEST(LevelDbDocumentCompressorTest, TrainKeepsSharedBytes) {
+  std::string dictionary =
+      LevelDbDocumentCompressor::TrainDictionary(Samples());
+  ASSERT_NE(dictionary.find("projects/p/databases/(default)/documents/"),
+            std::string::npos);
+  ASSERT_NE(dictionary.find("_name_9=value_"), std::string::npos);
+  ASSERT_LE(dictionary.size(), LevelDbDocumentCompressor::kMaxDictionarySize);
+}
+
+TEST(LevelDbDocumentCompressorTest, TrainWithoutSharedBytes) {
+  std::vector<std::string> samples{"abcdefghijklmnop", "0123456789012345"};
+  ASSERT_EQ(samples.back(),
+            LevelDbDocumentCompressor::TrainDictionary(samples));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
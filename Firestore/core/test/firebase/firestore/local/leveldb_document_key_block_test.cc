@@ -0,0 +1,92 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_document_key_block.h"
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::DocumentKey;
+
+TEST(LevelDbDocumentKeyBlockTest, EncodeDecodeCycle) {
+  std::vector<DocumentKey> keys{
+      testutil::Key("coll/a"), testutil::Key("coll/a/sub/1"),
+      testutil::Key("coll/b"), testutil::Key("coll/bb"),
+      testutil::Key("other/a"),
+  };
+  std::string block = LevelDbDocumentKeyBlock::Encode(keys);
+
+  std::vector<DocumentKey> decoded;
+  ASSERT_TRUE(LevelDbDocumentKeyBlock::Decode(block, &decoded));
+  ASSERT_EQ(keys, decoded);
+}
+
+TEST(LevelDbDocumentKeyBlockTest, EmptyBlock) {
+  std::string block = LevelDbDocumentKeyBlock::Encode({});
+  ASSERT_TRUE(block.empty());
+
+  std::vector<DocumentKey> decoded;
+  ASSERT_TRUE(LevelDbDocumentKeyBlock::Decode(block, &decoded));
+  ASSERT_TRUE(decoded.empty());
+}
+
+TEST(LevelDbDocumentKeyBlockTest, SharesPrefixes) {
+  std::vector<DocumentKey> keys;
+  for (int i = 0; i < 100; ++i) {
+    keys.push_back(testutil::Key("a/long/collection/path/docs/doc" +
+                                 std::to_string(1000 + i)));
+  }
+  std::string block = LevelDbDocumentKeyBlock::Encode(keys);
+
+  // Each key after the first costs two length bytes and its last digits.
+  size_t first_key_size = keys.front().path().CanonicalString().size() + 2;
+  ASSERT_LE(block.size(), first_key_size + 99 * 4);
+
+  std::vector<DocumentKey> decoded;
+  ASSERT_TRUE(LevelDbDocumentKeyBlock::Decode(block, &decoded));
+  ASSERT_EQ(keys, decoded);
+}
+
+TEST(LevelDbDocumentKeyBlockTest, RejectsMalformedBlocks) {
+  std::string block =
+      LevelDbDocumentKeyBlock::Encode({testutil::Key("coll/a")});
+  std::vector<DocumentKey> decoded;
+
+  // Truncated.
+  ASSERT_FALSE(LevelDbDocumentKeyBlock::Decode(
+      block.substr(0, block.size() - 1), &decoded));
+
+  // Shares more than the previous key has.
+  std::string too_much_shared = block;
+  too_much_shared[0] = 5;
+  ASSERT_FALSE(LevelDbDocumentKeyBlock::Decode(too_much_shared, &decoded));
+
+  // Not a document path.
+  std::string collection{"\x00\x04" "coll", 6};
+  ASSERT_FALSE(LevelDbDocumentKeyBlock::Decode(collection, &decoded));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
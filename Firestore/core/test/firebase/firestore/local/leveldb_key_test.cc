@@ -24,6 +24,8 @@
 
 using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::ResourcePath;
+using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
 
 namespace firebase {
@@ -46,6 +48,13 @@ std::string DocMutationKey(absl::string_view user_id,
   return LevelDbDocumentMutationKey::Key(user_id, testutil::Key(key), batch_id);
 }
 
+std::string CollectionMutationKey(absl::string_view user_id,
+                                  absl::string_view key,
+                                  model::BatchId batch_id) {
+  return LevelDbCollectionMutationKey::Key(user_id, testutil::Key(key),
+                                           batch_id);
+}
+
 std::string TargetDocKey(TargetId target_id, absl::string_view key) {
   return LevelDbTargetDocumentKey::Key(target_id, testutil::Key(key));
 }
@@ -54,6 +63,34 @@ std::string DocTargetKey(absl::string_view key, TargetId target_id) {
   return LevelDbDocumentTargetKey::Key(testutil::Key(key), target_id);
 }
 
+/**
+ * Rewrites a key of a tagged table the way it was written before schema
+ * version 13, with the table name spelled out.
+ */
+std::string LegacyKey(const std::string& key,
+                      const std::string& prefix,
+                      const std::string& legacy_prefix) {
+  return legacy_prefix + key.substr(prefix.size());
+}
+
+std::string FieldIndexKey(absl::string_view field,
+                          absl::string_view index_value,
+                          absl::string_view key) {
+  return LevelDbFieldIndexKey::Key(testutil::Field(field), index_value,
+                                   testutil::Key(key));
+}
+
+std::string FieldIndexKeyPrefix(absl::string_view collection,
+                                absl::string_view field) {
+  return LevelDbFieldIndexKey::KeyPrefix(testutil::Resource(collection),
+                                         testutil::Field(field));
+}
+
+std::string ReadTimeKey(absl::string_view key, int64_t seconds) {
+  return LevelDbRemoteDocumentReadTimeKey::Key(
+      testutil::Key(key), SnapshotVersion{Timestamp{seconds, 0}});
+}
+
 }  // namespace
 
 /**
@@ -208,6 +245,102 @@ TEST(LevelDbDocumentMutationKeyTest, Description) {
       "[document_mutation: user_id=user1 path=foo/bar batch_id=42]", key);
 }
 
+TEST(LevelDbCollectionMutationKeyTest, Prefixing) {
+  auto table_key = LevelDbCollectionMutationKey::KeyPrefix();
+  auto foo_user_key = LevelDbCollectionMutationKey::KeyPrefix("foo");
+  auto foo_collection_key = LevelDbCollectionMutationKey::KeyPrefix(
+      "foo", testutil::Resource("foo"));
+
+  ASSERT_TRUE(absl::StartsWith(foo_user_key, table_key));
+  ASSERT_TRUE(absl::StartsWith(foo_collection_key, foo_user_key));
+
+  ASSERT_TRUE(absl::StartsWith(CollectionMutationKey("foo", "foo/bar", 2),
+                               foo_collection_key));
+  ASSERT_FALSE(absl::StartsWith(CollectionMutationKey("foo", "food/bar", 2),
+                                foo_collection_key));
+}
+
+TEST(LevelDbCollectionMutationKeyTest, EncodeDecodeCycle) {
+  LevelDbCollectionMutationKey key;
+  std::string user("foo");
+
+  std::vector<DocumentKey> document_keys{testutil::Key("a/b"),
+                                         testutil::Key("a/b/c/d")};
+
+  std::vector<BatchId> batch_ids{0, 1, 100, INT_MAX - 1, INT_MAX};
+
+  for (BatchId batch_id : batch_ids) {
+    for (auto&& document_key : document_keys) {
+      auto encoded =
+          LevelDbCollectionMutationKey::Key(user, document_key, batch_id);
+
+      bool ok = key.Decode(encoded);
+      ASSERT_TRUE(ok);
+      ASSERT_EQ(user, key.user_id());
+      ASSERT_EQ(document_key, key.document_key());
+      ASSERT_EQ(batch_id, key.batch_id());
+    }
+  }
+}
+
+TEST(LevelDbCollectionMutationKeyTest, EncodesIntoBuffer) {
+  std::string buffer = "previous contents";
+  LevelDbCollectionMutationKey::Key("foo", testutil::Key("a/b"), 42, &buffer);
+  ASSERT_EQ(CollectionMutationKey("foo", "a/b", 42), buffer);
+}
+
+TEST(LevelDbCollectionMutationKeyTest, DecodesBatchIdOfImmediateChildren) {
+  std::string prefix = LevelDbCollectionMutationKey::KeyPrefix(
+      "foo", testutil::Resource("rooms"));
+  BatchId batch_id = 0;
+
+  ASSERT_TRUE(LevelDbCollectionMutationKey::DecodeBatchId(
+      CollectionMutationKey("foo", "rooms/abc", 42), prefix, &batch_id));
+  ASSERT_EQ(42, batch_id);
+
+  ASSERT_FALSE(LevelDbCollectionMutationKey::DecodeBatchId(
+      CollectionMutationKey("foo", "rooms/abc/messages/xyz", 7), prefix,
+      &batch_id));
+  ASSERT_FALSE(LevelDbCollectionMutationKey::DecodeBatchId(
+      CollectionMutationKey("foo", "roomsx/abc", 7), prefix, &batch_id));
+  ASSERT_FALSE(LevelDbCollectionMutationKey::DecodeBatchId(
+      CollectionMutationKey("bar", "rooms/abc", 7), prefix, &batch_id));
+}
+
+TEST(LevelDbCollectionMutationKeyTest, Ordering) {
+  // Different user:
+  ASSERT_LT(CollectionMutationKey("1", "foo/bar", 0),
+            CollectionMutationKey("2", "foo/bar", 0));
+
+  // Within a collection, batch_id orders before document:
+  ASSERT_LT(CollectionMutationKey("1", "foo/baz", 0),
+            CollectionMutationKey("1", "foo/bar", 1));
+  ASSERT_LT(CollectionMutationKey("1", "foo/bar", 1),
+            CollectionMutationKey("1", "foo/baz", 1));
+
+  // Subcollections sort after every batch in the parent collection:
+  ASSERT_LT(CollectionMutationKey("1", "foo/bar", INT_MAX),
+            CollectionMutationKey("1", "foo/bar/suffix/key", 0));
+  ASSERT_LT(CollectionMutationKey("1", "foo/bar/suffix/key", 0),
+            CollectionMutationKey("1", "food/bar", 0));
+}
+
+TEST(LevelDbCollectionMutationKeyTest, Description) {
+  AssertExpectedKeyDescription("[collection_mutation: incomplete key]",
+                               LevelDbCollectionMutationKey::KeyPrefix());
+
+  auto key = LevelDbCollectionMutationKey::KeyPrefix(
+      "user1", testutil::Resource("foo"));
+  AssertExpectedKeyDescription(
+      "[collection_mutation: user_id=user1 path=foo incomplete key]", key);
+
+  key = CollectionMutationKey("user1", "foo/bar", 42);
+  AssertExpectedKeyDescription(
+      "[collection_mutation: user_id=user1 path=foo batch_id=42 "
+      "document_id=bar]",
+      key);
+}
+
 TEST(LevelDbTargetGlobalKeyTest, EncodeDecodeCycle) {
   LevelDbTargetGlobalKey key;
 
@@ -282,6 +415,61 @@ TEST(TargetDocumentKeyTest, Description) {
   ASSERT_EQ("[target_document: target_id=42 path=foo/bar]", DescribeKey(key));
 }
 
+TEST(TargetDocumentKeyTest, DecodesLegacyKeys) {
+  std::string legacy = LegacyKey(TargetDocKey(42, "foo/bar"),
+                                 LevelDbTargetDocumentKey::KeyPrefix(),
+                                 LevelDbTargetDocumentKey::LegacyKeyPrefix());
+  ASSERT_LT(TargetDocKey(42, "foo/bar").size(), legacy.size());
+
+  LevelDbTargetDocumentKey key;
+  ASSERT_TRUE(key.Decode(legacy));
+  ASSERT_EQ(42, key.target_id());
+  ASSERT_EQ(testutil::Key("foo/bar"), key.document_key());
+  ASSERT_EQ("[target_document: target_id=42 path=foo/bar]",
+            DescribeKey(legacy));
+
+  // Tags aren't interchangeable between tables.
+  ASSERT_FALSE(key.Decode(DocTargetKey("foo/bar", 42)));
+}
+
+TEST(TargetDocumentBlockKeyTest, EncodeDecodeCycle) {
+  LevelDbTargetDocumentBlockKey key;
+
+  auto encoded =
+      LevelDbTargetDocumentBlockKey::Key(42, testutil::Key("foo/bar"));
+  ASSERT_TRUE(key.Decode(encoded));
+  ASSERT_EQ(42, key.target_id());
+  ASSERT_TRUE(key.bounded());
+  ASSERT_EQ(testutil::Key("foo/bar"), key.upper_bound());
+
+  ASSERT_TRUE(key.Decode(LevelDbTargetDocumentBlockKey::UnboundedKey(42)));
+  ASSERT_EQ(42, key.target_id());
+  ASSERT_FALSE(key.bounded());
+}
+
+TEST(TargetDocumentBlockKeyTest, Ordering) {
+  auto block_key = [](TargetId target_id, absl::string_view path) {
+    return LevelDbTargetDocumentBlockKey::Key(target_id, testutil::Key(path));
+  };
+  auto unbounded_key = LevelDbTargetDocumentBlockKey::UnboundedKey;
+
+  ASSERT_LT(block_key(1, "foo/bar"), block_key(1, "foo/baz"));
+  ASSERT_LT(block_key(1, "foo/bar"), block_key(1, "foo/bar/suffix/key"));
+  ASSERT_LT(block_key(1, "zzz/zzz"), unbounded_key(1));
+  ASSERT_LT(unbounded_key(1), block_key(2, "foo/bar"));
+  ASSERT_TRUE(absl::StartsWith(unbounded_key(1),
+                               LevelDbTargetDocumentBlockKey::KeyPrefix(1)));
+}
+
+TEST(TargetDocumentBlockKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[target_document_block: target_id=42 block_kind=0 path=foo/bar]",
+      LevelDbTargetDocumentBlockKey::Key(42, testutil::Key("foo/bar")));
+  AssertExpectedKeyDescription(
+      "[target_document_block: target_id=42 block_kind=1]",
+      LevelDbTargetDocumentBlockKey::UnboundedKey(42));
+}
+
 TEST(DocumentTargetKeyTest, EncodeDecodeCycle) {
   LevelDbDocumentTargetKey key;
 
@@ -311,6 +499,20 @@ TEST(DocumentTargetKeyTest, Ordering) {
   ASSERT_LT(DocTargetKey("foo/bar", 42), DocTargetKey("foo/bar", 100));
 }
 
+TEST(DocumentTargetKeyTest, DecodesLegacyKeys) {
+  std::string legacy = LegacyKey(DocTargetKey("foo/bar", 42),
+                                 LevelDbDocumentTargetKey::KeyPrefix(),
+                                 LevelDbDocumentTargetKey::LegacyKeyPrefix());
+  ASSERT_LT(DocTargetKey("foo/bar", 42).size(), legacy.size());
+
+  LevelDbDocumentTargetKey key;
+  ASSERT_TRUE(key.Decode(legacy));
+  ASSERT_EQ(testutil::Key("foo/bar"), key.document_key());
+  ASSERT_EQ(42, key.target_id());
+  ASSERT_EQ("[document_target: path=foo/bar target_id=42]",
+            DescribeKey(legacy));
+}
+
 TEST(RemoteDocumentKeyTest, Prefixing) {
   auto tableKey = LevelDbRemoteDocumentKey::KeyPrefix();
 
@@ -350,12 +552,385 @@ TEST(RemoteDocumentKeyTest, EncodeDecodeCycle) {
   }
 }
 
+TEST(RemoteDocumentKeyTest, EncodesIntoBuffer) {
+  std::string buffer = "previous contents";
+  LevelDbRemoteDocumentKey::Key(testutil::Key("foo/bar"), &buffer);
+  ASSERT_EQ(RemoteDocKey("foo/bar"), buffer);
+}
+
+TEST(RemoteDocumentKeyTest, ViewDecodeCycle) {
+  LevelDbRemoteDocumentKeyView view;
+
+  std::vector<std::string> paths{"foo/bar", "foo/bar2", "foo/bar/baz/quux"};
+  for (auto&& path : paths) {
+    auto encoded_path = RemoteDocKey(path);
+    ASSERT_TRUE(view.Decode(encoded_path));
+    ASSERT_EQ(testutil::Key(path), view.ToDocumentKey());
+  }
+
+  // The segments are views of the encoded key, so it must outlive them.
+  std::string encoded = RemoteDocKey("foo/bar/baz/quux");
+  ASSERT_TRUE(view.Decode(encoded));
+  ASSERT_EQ(4u, view.segments().size());
+  ASSERT_EQ("baz", view.segments()[2]);
+  ASSERT_TRUE(view.HasPrefix(testutil::Resource("foo/bar")));
+  ASSERT_FALSE(view.HasPrefix(testutil::Resource("foo/ba")));
+  ASSERT_FALSE(view.HasPrefix(testutil::Resource("foo/bar/baz/quux/x")));
+
+  ASSERT_FALSE(view.Decode(RemoteDocKeyPrefix("foo")));
+  ASSERT_FALSE(view.Decode(LevelDbMutationKey::Key("user", 1)));
+}
+
+TEST(RemoteDocumentKeyTest, ViewUnescapesSegments) {
+  DocumentKey key{ResourcePath{"coll", std::string{"a\0b\xff", 4}}};
+  std::string encoded = LevelDbRemoteDocumentKey::Key(key);
+  LevelDbRemoteDocumentKeyView view;
+  ASSERT_TRUE(view.Decode(encoded));
+  ASSERT_EQ(key, view.ToDocumentKey());
+}
+
 TEST(RemoteDocumentKeyTest, Description) {
   AssertExpectedKeyDescription(
       "[remote_document: path=foo/bar/baz/quux]",
       LevelDbRemoteDocumentKey::Key(testutil::Key("foo/bar/baz/quux")));
 }
 
+TEST(RemoteDocumentKeyTest, DecodesLegacyKeys) {
+  std::string legacy = LegacyKey(RemoteDocKey("foo/bar"),
+                                 LevelDbRemoteDocumentKey::KeyPrefix(),
+                                 LevelDbRemoteDocumentKey::LegacyKeyPrefix());
+  ASSERT_LT(RemoteDocKey("foo/bar").size(), legacy.size());
+
+  LevelDbRemoteDocumentKey key;
+  ASSERT_TRUE(key.Decode(legacy));
+  ASSERT_EQ(testutil::Key("foo/bar"), key.document_key());
+  LevelDbRemoteDocumentKeyView view;
+  ASSERT_TRUE(view.Decode(legacy));
+  ASSERT_EQ(testutil::Key("foo/bar"), view.ToDocumentKey());
+  AssertExpectedKeyDescription("[remote_document: path=foo/bar]", legacy);
+
+  ASSERT_FALSE(key.Decode(LevelDbRemoteDocumentKey::LegacyKeyPrefix()));
+  ASSERT_FALSE(key.Decode(TargetDocKey(42, "foo/bar")));
+}
+
+TEST(CollectionGroupDocumentKeyTest, Prefixing) {
+  auto messages_prefix =
+      LevelDbCollectionGroupDocumentKey::KeyPrefix("messages");
+
+  ASSERT_TRUE(absl::StartsWith(
+      LevelDbCollectionGroupDocumentKey::Key(testutil::Key("messages/a")),
+      messages_prefix));
+  ASSERT_TRUE(absl::StartsWith(LevelDbCollectionGroupDocumentKey::Key(
+                                   testutil::Key("chats/1/messages/a")),
+                               messages_prefix));
+  ASSERT_FALSE(absl::StartsWith(LevelDbCollectionGroupDocumentKey::Key(
+                                    testutil::Key("messages/a/replies/b")),
+                                messages_prefix));
+  ASSERT_FALSE(absl::StartsWith(
+      LevelDbCollectionGroupDocumentKey::Key(testutil::Key("messagesX/a")),
+      messages_prefix));
+}
+
+TEST(CollectionGroupDocumentKeyTest, EncodeDecodeCycle) {
+  LevelDbCollectionGroupDocumentKey key;
+
+  std::vector<std::string> paths{"messages/a", "chats/1/messages/a"};
+  for (auto&& path : paths) {
+    auto encoded =
+        LevelDbCollectionGroupDocumentKey::Key(testutil::Key(path));
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ("messages", key.collection_id());
+    ASSERT_EQ(testutil::Key(path), key.document_key());
+  }
+}
+
+TEST(CollectionGroupDocumentKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[collection_group_document: collection_id=messages "
+      "path=chats/1/messages/a]",
+      LevelDbCollectionGroupDocumentKey::Key(
+          testutil::Key("chats/1/messages/a")));
+}
+
+TEST(FieldIndexKeyTest, Prefixing) {
+  auto table_key = LevelDbFieldIndexKey::KeyPrefix();
+  auto key = FieldIndexKey("a", "value", "coll/doc");
+
+  ASSERT_TRUE(absl::StartsWith(key, table_key));
+  ASSERT_TRUE(absl::StartsWith(key, FieldIndexKeyPrefix("coll", "a")));
+  ASSERT_TRUE(absl::StartsWith(
+      key, LevelDbFieldIndexKey::KeyPrefix(testutil::Resource("coll"),
+                                           testutil::Field("a"), "value")));
+
+  // Neither partial field paths nor partial values are prefixes.
+  ASSERT_FALSE(absl::StartsWith(FieldIndexKey("ab", "value", "coll/doc"),
+                                FieldIndexKeyPrefix("coll", "a")));
+  ASSERT_FALSE(absl::StartsWith(
+      FieldIndexKey("a", "value2", "coll/doc"),
+      LevelDbFieldIndexKey::KeyPrefix(testutil::Resource("coll"),
+                                      testutil::Field("a"), "value")));
+
+  // Documents in subcollections don't share the parent collection's prefix.
+  ASSERT_FALSE(absl::StartsWith(FieldIndexKey("a", "value", "coll/doc/sub/d"),
+                                FieldIndexKeyPrefix("coll", "a")));
+}
+
+TEST(FieldIndexKeyTest, Ordering) {
+  // Different values:
+  ASSERT_LT(FieldIndexKey("a", "1", "coll/z"), FieldIndexKey("a", "2", "coll/a"));
+  ASSERT_LT(FieldIndexKey("a", "1", "coll/z"),
+            FieldIndexKey("a", "10", "coll/a"));
+  ASSERT_LT(FieldIndexKey("a", "", "coll/z"), FieldIndexKey("a", "1", "coll/a"));
+
+  // Same value, different documents:
+  ASSERT_LT(FieldIndexKey("a", "1", "coll/a"), FieldIndexKey("a", "1", "coll/b"));
+
+  // A value prefix sorts at or before every key with that value.
+  ASSERT_LE(LevelDbFieldIndexKey::KeyPrefix(testutil::Resource("coll"),
+                                            testutil::Field("a"), "1"),
+            FieldIndexKey("a", "1", "coll/a"));
+  ASSERT_LE(LevelDbFieldIndexKey::KeyPrefix(testutil::Resource("coll"),
+                                            testutil::Field("a"), "1"),
+            FieldIndexKey("a", std::string("1\0", 2), "coll/a"));
+}
+
+TEST(FieldIndexKeyTest, EncodeDecodeCycle) {
+  LevelDbFieldIndexKey key;
+
+  std::vector<std::string> values{"", "foo", std::string("\0\xff", 2)};
+  std::vector<std::string> paths{"coll/doc", "coll/doc/sub/doc2"};
+  for (auto&& value : values) {
+    for (auto&& path : paths) {
+      auto encoded = FieldIndexKey("a.b", value, path);
+      bool ok = key.Decode(encoded);
+      ASSERT_TRUE(ok);
+      ASSERT_EQ("a.b", key.field_path());
+      ASSERT_EQ(value, key.index_value());
+      ASSERT_EQ(testutil::Key(path), key.document_key());
+    }
+  }
+}
+
+TEST(FieldIndexKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[field_index: path=coll field_path=a.b index_value=foo "
+      "document_id=doc]",
+      FieldIndexKey("a.b", "foo", "coll/doc"));
+}
+
+TEST(IndexedCollectionKeyTest, EncodeDecodeCycle) {
+  LevelDbIndexedCollectionKey key;
+
+  std::vector<std::string> paths{"coll", "coll/doc/sub"};
+  for (auto&& path : paths) {
+    auto encoded = LevelDbIndexedCollectionKey::Key(testutil::Resource(path));
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(testutil::Resource(path), key.collection_path());
+  }
+}
+
+TEST(IndexedCollectionKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[indexed_collection: path=coll/doc/sub]",
+      LevelDbIndexedCollectionKey::Key(testutil::Resource("coll/doc/sub")));
+}
+
+TEST(CollectionGroupSizeKeyTest, EncodeDecodeCycle) {
+  LevelDbCollectionGroupSizeKey key;
+
+  std::vector<std::string> collection_ids{"coll", "messages", ""};
+  for (auto&& collection_id : collection_ids) {
+    auto encoded = LevelDbCollectionGroupSizeKey::Key(collection_id);
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(collection_id, key.collection_id());
+  }
+}
+
+TEST(CollectionGroupSizeKeyTest, EncodeDecodeSize) {
+  std::vector<int64_t> sizes{0, 1, 4096, -10, 100 * 1024 * 1024};
+  for (int64_t size : sizes) {
+    auto encoded = LevelDbCollectionGroupSizeKey::EncodeSize(size);
+    ASSERT_EQ(size, LevelDbCollectionGroupSizeKey::DecodeSize(encoded));
+  }
+}
+
+TEST(CollectionGroupSizeKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[collection_group_size: collection_id=messages]",
+      LevelDbCollectionGroupSizeKey::Key("messages"));
+}
+
+TEST(PendingMigrationKeyTest, EncodeDecodeCycle) {
+  LevelDbPendingMigrationKey key;
+
+  std::vector<int32_t> versions{4, 6, 100};
+  for (int32_t version : versions) {
+    auto encoded = LevelDbPendingMigrationKey::Key(version);
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(version, key.schema_version());
+  }
+}
+
+TEST(PendingMigrationKeyTest, EncodeDecodeProgress) {
+  std::string last_key = LevelDbRemoteDocumentKey::Key(testutil::Key("a/b"));
+  auto encoded = LevelDbPendingMigrationKey::EncodeProgress(42, last_key);
+
+  int64_t rows_processed = 0;
+  std::string decoded_key;
+  ASSERT_TRUE(LevelDbPendingMigrationKey::DecodeProgress(
+      encoded, &rows_processed, &decoded_key));
+  ASSERT_EQ(42, rows_processed);
+  ASSERT_EQ(last_key, decoded_key);
+
+  ASSERT_FALSE(LevelDbPendingMigrationKey::DecodeProgress(
+      "", &rows_processed, &decoded_key));
+}
+
+TEST(PendingMigrationKeyTest, Description) {
+  AssertExpectedKeyDescription("[pending_migration: schema_version=6]",
+                               LevelDbPendingMigrationKey::Key(6));
+}
+
+TEST(WarmSnapshotKeyTest, EncodeDecodeCycle) {
+  LevelDbWarmSnapshotKey key;
+
+  std::vector<TargetId> target_ids{1, 2, 1234};
+  for (TargetId target_id : target_ids) {
+    auto encoded = LevelDbWarmSnapshotKey::Key(target_id);
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(target_id, key.target_id());
+  }
+}
+
+TEST(WarmSnapshotKeyTest, Description) {
+  AssertExpectedKeyDescription("[warm_snapshot: target_id=42]",
+                               LevelDbWarmSnapshotKey::Key(42));
+}
+
+TEST(WarmSnapshotGlobalKeyTest, EncodeDecodeTargetIds) {
+  LevelDbWarmSnapshotGlobalKey key;
+  ASSERT_TRUE(key.Decode(LevelDbWarmSnapshotGlobalKey::Key()));
+
+  std::vector<TargetId> target_ids{8, 2, 1234};
+  auto encoded = LevelDbWarmSnapshotGlobalKey::EncodeTargetIds(target_ids);
+
+  std::vector<TargetId> decoded;
+  ASSERT_TRUE(
+      LevelDbWarmSnapshotGlobalKey::DecodeTargetIds(encoded, &decoded));
+  ASSERT_EQ(target_ids, decoded);
+
+  ASSERT_TRUE(LevelDbWarmSnapshotGlobalKey::DecodeTargetIds("", &decoded));
+  ASSERT_TRUE(decoded.empty());
+}
+
+TEST(RemoteDocumentReadTimeKeyTest, Prefixing) {
+  auto table_key = LevelDbRemoteDocumentReadTimeKey::KeyPrefix();
+  auto key = ReadTimeKey("coll/doc", 10);
+
+  ASSERT_TRUE(absl::StartsWith(key, table_key));
+  ASSERT_TRUE(absl::StartsWith(
+      key,
+      LevelDbRemoteDocumentReadTimeKey::KeyPrefix(testutil::Resource("coll"))));
+  ASSERT_FALSE(absl::StartsWith(key,
+                                LevelDbRemoteDocumentReadTimeKey::KeyPrefix(
+                                    testutil::Resource("coll/doc/sub"))));
+}
+
+TEST(RemoteDocumentReadTimeKeyTest, Ordering) {
+  // Read times order the documents of a collection.
+  ASSERT_LT(ReadTimeKey("coll/z", 1), ReadTimeKey("coll/a", 2));
+  ASSERT_LT(ReadTimeKey("coll/z", 2), ReadTimeKey("coll/a", 10));
+  ASSERT_LT(ReadTimeKey("coll/a", 1), ReadTimeKey("coll/b", 1));
+  ASSERT_LT(LevelDbRemoteDocumentReadTimeKey::Key(
+                testutil::Key("coll/a"), SnapshotVersion{Timestamp{1, 5}}),
+            LevelDbRemoteDocumentReadTimeKey::Key(
+                testutil::Key("coll/a"), SnapshotVersion{Timestamp{1, 6}}));
+
+  // A read time prefix sorts before every later read time.
+  auto prefix = LevelDbRemoteDocumentReadTimeKey::KeyPrefix(
+      testutil::Resource("coll"), SnapshotVersion{Timestamp{2, 0}});
+  ASSERT_GT(prefix, ReadTimeKey("coll/a", 1));
+  ASSERT_LE(prefix, ReadTimeKey("coll/a", 2));
+
+  // Subcollections sort after all the documents of their ancestors.
+  ASSERT_LT(ReadTimeKey("coll/a", 100), ReadTimeKey("coll/a/sub/b", 1));
+}
+
+TEST(RemoteDocumentReadTimeKeyTest, EncodeDecodeCycle) {
+  LevelDbRemoteDocumentReadTimeKey key;
+
+  std::vector<SnapshotVersion> read_times{
+      SnapshotVersion::None(), SnapshotVersion{Timestamp{1, 2}},
+      SnapshotVersion{Timestamp{-5, 999999999}}};
+  std::vector<std::string> paths{"coll/doc", "coll/doc/sub/doc2"};
+  for (auto&& read_time : read_times) {
+    for (auto&& path : paths) {
+      auto encoded =
+          LevelDbRemoteDocumentReadTimeKey::Key(testutil::Key(path), read_time);
+      bool ok = key.Decode(encoded);
+      ASSERT_TRUE(ok);
+      ASSERT_EQ(read_time, key.read_time());
+      ASSERT_EQ(testutil::Key(path), key.document_key());
+    }
+  }
+}
+
+TEST(RemoteDocumentReadTimeKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[remote_document_read_time: path=coll read_time=10.0 "
+      "document_id=doc]",
+      ReadTimeKey("coll/doc", 10));
+}
+
+TEST(DocumentReadTimeKeyTest, EncodeDecodeCycle) {
+  LevelDbDocumentReadTimeKey key;
+
+  std::vector<std::string> paths{"coll/doc", "coll/doc/sub/doc2"};
+  for (auto&& path : paths) {
+    auto encoded = LevelDbDocumentReadTimeKey::Key(testutil::Key(path));
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(testutil::Key(path), key.document_key());
+  }
+
+  SnapshotVersion read_time{Timestamp{12, 34}};
+  SnapshotVersion decoded;
+  ASSERT_TRUE(LevelDbDocumentReadTimeKey::DecodeReadTime(
+      LevelDbDocumentReadTimeKey::EncodeReadTime(read_time), &decoded));
+  ASSERT_EQ(read_time, decoded);
+  ASSERT_FALSE(LevelDbDocumentReadTimeKey::DecodeReadTime("", &decoded));
+}
+
+TEST(DocumentReadTimeKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[document_read_time: path=coll/doc]",
+      LevelDbDocumentReadTimeKey::Key(testutil::Key("coll/doc")));
+}
+
+TEST(CompressionDictionaryKeyTest, EncodeDecodeCycle) {
+  LevelDbCompressionDictionaryKey key;
+
+  std::vector<std::string> paths{"coll", "coll/doc/sub"};
+  for (auto&& path : paths) {
+    auto encoded =
+        LevelDbCompressionDictionaryKey::Key(testutil::Resource(path));
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(testutil::Resource(path), key.collection_path());
+  }
+}
+
+TEST(CompressionDictionaryKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[compression_dictionary: path=coll/doc/sub]",
+      LevelDbCompressionDictionaryKey::Key(testutil::Resource("coll/doc/sub")));
+}
+
 #undef AssertExpectedKeyDescription
 
 }  // namespace local
@@ -50,6 +50,7 @@ using ::google::protobuf::util::MessageDifferencer;
 using model::DatabaseId;
 using model::Document;
 using model::DocumentKey;
+using model::DocumentState;
 using model::FieldMask;
 using model::FieldPath;
 using model::FieldValue;
@@ -71,6 +72,7 @@ using testutil::DeletedDoc;
 using testutil::Doc;
 using testutil::Key;
 using testutil::Query;
+using testutil::Version;
 using testutil::UnknownDoc;
 using util::Status;
 
@@ -155,6 +157,20 @@ class LocalSerializerTest : public ::testing::Test {
     EXPECT_OK(reader.status());
     EXPECT_EQ(type, actual_model->type());
     EXPECT_EQ(model, *actual_model);
+
+    // The lazy variant must produce the same model, even after the rest of
+    // the proto has been freed.
+    reader = Reader::Wrap(bytes.data(), bytes.size());
+    nanopb_proto = firestore_client_MaybeDocument_init_zero;
+    reader.ReadNanopbMessage(firestore_client_MaybeDocument_fields,
+                             &nanopb_proto);
+    std::unique_ptr<MaybeDocument> lazy_model =
+        serializer.DecodeMaybeDocumentLazily(&reader, &nanopb_proto);
+    reader.FreeNanopbMessage(firestore_client_MaybeDocument_fields,
+                             &nanopb_proto);
+    EXPECT_OK(reader.status());
+    EXPECT_EQ(type, lazy_model->type());
+    EXPECT_EQ(model, *lazy_model);
   }
 
   std::vector<uint8_t> EncodeMaybeDocument(local::LocalSerializer* serializer,
@@ -326,6 +342,25 @@ TEST_F(LocalSerializerTest, EncodesDocumentAsMaybeDocument) {
   ExpectRoundTrip(doc, maybe_doc_proto, doc.type());
 }
 
+TEST_F(LocalSerializerTest, EncodesDocumentWithCommittedMutations) {
+  Document doc = *Doc("some/path", /*version=*/42,
+                      {{"foo", FieldValue::FromString("bar")}},
+                      DocumentState::kCommittedMutations);
+
+  ::firestore::client::MaybeDocument maybe_doc_proto;
+  maybe_doc_proto.mutable_document()->set_name(
+      "projects/p/databases/d/documents/some/path");
+  ::google::firestore::v1::Value value_proto;
+  value_proto.set_string_value("bar");
+  maybe_doc_proto.mutable_document()->mutable_fields()->insert(
+      {"foo", value_proto});
+  maybe_doc_proto.mutable_document()->mutable_update_time()->set_seconds(0);
+  maybe_doc_proto.mutable_document()->mutable_update_time()->set_nanos(42000);
+  maybe_doc_proto.set_has_committed_mutations(true);
+
+  ExpectRoundTrip(doc, maybe_doc_proto, doc.type());
+}
+
 TEST_F(LocalSerializerTest, EncodesNoDocumentAsMaybeDocument) {
   NoDocument no_doc = *DeletedDoc("some/path", /*version=*/42);
 
@@ -338,6 +373,20 @@ TEST_F(LocalSerializerTest, EncodesNoDocumentAsMaybeDocument) {
   ExpectRoundTrip(no_doc, maybe_doc_proto, no_doc.type());
 }
 
+TEST_F(LocalSerializerTest, EncodesNoDocumentWithCommittedMutations) {
+  NoDocument no_doc(Key("some/path"), Version(42),
+                    /*has_committed_mutations=*/true);
+
+  ::firestore::client::MaybeDocument maybe_doc_proto;
+  maybe_doc_proto.mutable_no_document()->set_name(
+      "projects/p/databases/d/documents/some/path");
+  maybe_doc_proto.mutable_no_document()->mutable_read_time()->set_seconds(0);
+  maybe_doc_proto.mutable_no_document()->mutable_read_time()->set_nanos(42000);
+  maybe_doc_proto.set_has_committed_mutations(true);
+
+  ExpectRoundTrip(no_doc, maybe_doc_proto, no_doc.type());
+}
+
 TEST_F(LocalSerializerTest, EncodesUnknownDocumentAsMaybeDocument) {
   UnknownDocument unknown_doc = *UnknownDoc("some/path", /*version=*/42);
 
@@ -347,6 +396,7 @@ TEST_F(LocalSerializerTest, EncodesUnknownDocumentAsMaybeDocument) {
   maybe_doc_proto.mutable_unknown_document()->mutable_version()->set_seconds(0);
   maybe_doc_proto.mutable_unknown_document()->mutable_version()->set_nanos(
       42000);
+  maybe_doc_proto.set_has_committed_mutations(true);
 
   ExpectRoundTrip(unknown_doc, maybe_doc_proto, unknown_doc.type());
 }
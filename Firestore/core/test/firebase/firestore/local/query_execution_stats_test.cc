@@ -0,0 +1,68 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/query_execution_stats.h"
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+TEST(QueryExecutionStatsTest, StartsEmpty) {
+  QueryExecutionStats stats;
+  EXPECT_EQ(QueryAccessPath::None, stats.access_path);
+  EXPECT_EQ(
+      "QueryExecutionStats(access_path=none, documents_scanned=0, "
+      "documents_decoded=0, mutation_batches_read=0, documents_overlaid=0, "
+      "overlays_reused=0, documents_returned=0, remote_documents_time=0us, "
+      "mutations_time=0us, total_time=0us)",
+      stats.ToString());
+}
+
+TEST(QueryExecutionStatsTest, Describes) {
+  QueryExecutionStats stats;
+  stats.access_path = QueryAccessPath::FieldIndex;
+  stats.documents_scanned = 12;
+  stats.documents_decoded = 10;
+  stats.mutation_batches_read = 3;
+  stats.documents_overlaid = 2;
+  stats.overlays_reused = 1;
+  stats.documents_returned = 9;
+  stats.remote_documents_time = std::chrono::microseconds(40);
+  stats.mutations_time = std::chrono::microseconds(5);
+  stats.total_time = std::chrono::microseconds(50);
+
+  EXPECT_EQ(
+      "QueryExecutionStats(access_path=field_index, documents_scanned=12, "
+      "documents_decoded=10, mutation_batches_read=3, documents_overlaid=2, "
+      "overlays_reused=1, documents_returned=9, remote_documents_time=40us, "
+      "mutations_time=5us, total_time=50us)",
+      stats.ToString());
+}
+
+TEST(QueryExecutionStatsTest, NamesAccessPaths) {
+  EXPECT_STREQ("document_lookup", ToString(QueryAccessPath::DocumentLookup));
+  EXPECT_STREQ("collection_scan", ToString(QueryAccessPath::CollectionScan));
+  EXPECT_STREQ("collection_group_scan",
+               ToString(QueryAccessPath::CollectionGroupScan));
+  EXPECT_STREQ("collection_query_per_parent",
+               ToString(QueryAccessPath::CollectionQueryPerParent));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -23,6 +23,7 @@
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/hash/hash.h"
 #include "gtest/gtest.h"
 
 using firebase::firestore::testutil::Key;
@@ -55,6 +56,20 @@ TEST(DocumentKey, Constructor_FromPath) {
   EXPECT_EQ(key_from_path_copy.path(), key_from_moved_path.path());
 }
 
+TEST(DocumentKey, Interned) {
+  const DocumentKey interned =
+      DocumentKey::Interned(ResourcePath{"rooms", "firestore"});
+  const DocumentKey from_string =
+      DocumentKey::FromPathString("rooms/firestore");
+  const DocumentKey uninterned{ResourcePath{"rooms", "firestore"}};
+
+  EXPECT_EQ(&interned.path(), &from_string.path());
+  EXPECT_NE(&interned.path(), &uninterned.path());
+  EXPECT_EQ(interned, from_string);
+  EXPECT_EQ(interned, uninterned);
+  EXPECT_LT(interned, DocumentKey::FromPathString("rooms/firestorf"));
+}
+
 TEST(DocumentKey, CopyAndMove) {
   DocumentKey key({"rooms", "firestore", "messages", "1"});
   const std::string path_string = "rooms/firestore/messages/1";
@@ -159,6 +174,18 @@ TEST(DocumentKey, Comparator) {
   EXPECT_EQ(comparator.Compare(abcd, xyzw), util::ComparisonResult::Ascending);
 }
 
+TEST(DocumentKey, AbslHash) {
+  absl::Hash<DocumentKey> hash;
+  EXPECT_EQ(hash(Key("a/b")), hash(Key("a/b")));
+  EXPECT_NE(hash(Key("a/b")), hash(Key("a/c")));
+  // Segment boundaries are part of the hash.
+  EXPECT_NE(hash(Key("ab/c/d/e")), hash(Key("a/bc/d/e")));
+
+  absl::Hash<ResourcePath> path_hash;
+  EXPECT_EQ(path_hash(Key("a/b").path()), path_hash(ResourcePath{"a", "b"}));
+  EXPECT_EQ(DocumentKeyHash{}(Key("a/b")), hash(Key("a/b")));
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
@@ -51,6 +51,22 @@ TEST(Document, Getter) {
   EXPECT_TRUE(doc.HasLocalMutations());
 }
 
+TEST(Document, DataHash) {
+  const Document doc = MakeDocument("foo", "i/am/a/path", Timestamp(123, 456),
+                                    DocumentState::kSynced);
+  const Document copy = doc;
+  EXPECT_EQ(doc.data().Hash(), doc.data_hash());
+  EXPECT_EQ(doc.data_hash(), copy.data_hash());
+  EXPECT_EQ(doc.data_hash(),
+            MakeDocument("foo", "i/am/another/path", Timestamp(1, 2),
+                         DocumentState::kLocalMutations)
+                .data_hash());
+  EXPECT_NE(doc.data_hash(),
+            MakeDocument("bar", "i/am/a/path", Timestamp(123, 456),
+                         DocumentState::kSynced)
+                .data_hash());
+}
+
 TEST(Document, Comparison) {
   EXPECT_EQ(MakeDocument("foo", "i/am/a/path", Timestamp(123, 456),
                          DocumentState::kLocalMutations),
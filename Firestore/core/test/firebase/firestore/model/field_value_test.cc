@@ -17,9 +17,12 @@
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 
 #include <climits>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/hash/hash.h"
 #include "gtest/gtest.h"
 
 namespace firebase {
@@ -34,6 +37,34 @@ const uint8_t* Bytes(const char* value) {
   return reinterpret_cast<const uint8_t*>(value);
 }
 
+/** An ObjectValueSource that counts how often it's asked to decode. */
+class CountingSource : public ObjectValueSource {
+ public:
+  explicit CountingSource(FieldValue::Map fields) : fields_(std::move(fields)) {
+  }
+
+  absl::optional<FieldValue> DecodeField(
+      absl::string_view name) const override {
+    field_decodes_++;
+    const auto iter = fields_.find(std::string{name});
+    if (iter == fields_.end()) {
+      return absl::nullopt;
+    }
+    return iter->second;
+  }
+
+  FieldValue::Map DecodeFields() const override {
+    all_decodes_++;
+    return fields_;
+  }
+
+  mutable int field_decodes_ = 0;
+  mutable int all_decodes_ = 0;
+
+ private:
+  FieldValue::Map fields_;
+};
+
 }  // namespace
 
 TEST(FieldValue, NullType) {
@@ -535,6 +566,55 @@ TEST(FieldValue, Delete) {
   EXPECT_EQ(expected, value.Delete(testutil::Field("b.bb")));
 }
 
+TEST(FieldValue, BuilderAppliesUpdatesInOrder) {
+  const ObjectValue value = ObjectValue::FromMap({
+      {"a", FieldValue::FromString("A")},
+      {"b", FieldValue::FromMap({
+                {"ba", FieldValue::FromString("BA")},
+                {"bb", FieldValue::FromString("BB")},
+            })},
+      {"c", FieldValue::FromInteger(1)},
+  });
+
+  ObjectValue sequential =
+      value.Set(testutil::Field("b.bc"), FieldValue::FromString("BC"))
+          .Delete(testutil::Field("b.ba"))
+          .Set(testutil::Field("c.ca"), FieldValue::FromString("CA"))
+          .Delete(testutil::Field("a.x"))
+          .Set(testutil::Field("d.da.daa"), FieldValue::FromString("DAA"))
+          .Set(testutil::Field("b"), FieldValue::FromString("B"))
+          .Set(testutil::Field("b.ba"), FieldValue::FromString("BA2"));
+
+  ObjectValue batched =
+      ObjectValueBuilder{value}
+          .Set(testutil::Field("b.bc"), FieldValue::FromString("BC"))
+          .Delete(testutil::Field("b.ba"))
+          .Set(testutil::Field("c.ca"), FieldValue::FromString("CA"))
+          .Delete(testutil::Field("a.x"))
+          .Set(testutil::Field("d.da.daa"), FieldValue::FromString("DAA"))
+          .Set(testutil::Field("b"), FieldValue::FromString("B"))
+          .Set(testutil::Field("b.ba"), FieldValue::FromString("BA2"))
+          .Build();
+
+  EXPECT_EQ(sequential, batched);
+  EXPECT_EQ(FieldValue::FromString("A"), batched.Get(testutil::Field("a")));
+  EXPECT_EQ(FieldValue::FromString("BA2"),
+            batched.Get(testutil::Field("b.ba")));
+}
+
+TEST(FieldValue, BuilderDeletesWithoutCreatingParents) {
+  const ObjectValue value = ObjectValue::FromMap({
+      {"a", FieldValue::FromString("A")},
+  });
+
+  EXPECT_EQ(value, ObjectValueBuilder{value}
+                       .Delete(testutil::Field("a.b"))
+                       .Delete(testutil::Field("c.d"))
+                       .Build());
+  EXPECT_EQ(ObjectValue::Empty(),
+            ObjectValueBuilder{value}.Delete(testutil::Field("a")).Build());
+}
+
 TEST(FieldValue, DeleteNothing) {
   const ObjectValue value = ObjectValue::FromMap({
       {"a", FieldValue::FromString("A")},
@@ -571,11 +651,106 @@ TEST(FieldValue, GetNothing) {
   EXPECT_EQ(absl::nullopt, value.Get(testutil::Field("a.a")));
 }
 
+TEST(FieldValue, GetFromSourceDecodesOnlyTopLevelField) {
+  auto source = std::make_shared<CountingSource>(FieldValue::Map{
+      {"a", FieldValue::FromString("A")},
+      {"b", FieldValue::FromMap({
+                {"ba", FieldValue::FromString("BA")},
+            })},
+  });
+  const ObjectValue value = ObjectValue::FromSource(source);
+
+  EXPECT_EQ(FieldValue::FromString("BA"), value.Get(testutil::Field("b.ba")));
+  EXPECT_EQ(absl::nullopt, value.Get(testutil::Field("b.bb")));
+  EXPECT_EQ(absl::nullopt, value.Get(testutil::Field("c")));
+  EXPECT_EQ(2, source->field_decodes_);
+  EXPECT_EQ(0, source->all_decodes_);
+
+  // Copies share what has already been decoded.
+  const ObjectValue copy = value;
+  EXPECT_EQ(FieldValue::FromString("A"), copy.Get(testutil::Field("a")));
+  EXPECT_EQ(FieldValue::FromString("A"), value.Get(testutil::Field("a")));
+  EXPECT_EQ(3, source->field_decodes_);
+}
+
+TEST(FieldValue, FromSourceDecodesAllFieldsOnce) {
+  FieldValue::Map fields{
+      {"a", FieldValue::FromString("A")},
+      {"b", FieldValue::FromMap({
+                {"ba", FieldValue::FromString("BA")},
+            })},
+  };
+  auto source = std::make_shared<CountingSource>(fields);
+  const ObjectValue value = ObjectValue::FromSource(source);
+
+  EXPECT_EQ(ObjectValue::FromMap(fields), value);
+  EXPECT_EQ(ObjectValue::FromMap(fields).Set(testutil::Field("c"),
+                                             FieldValue::FromString("C")),
+            value.Set(testutil::Field("c"), FieldValue::FromString("C")));
+  EXPECT_EQ(ObjectValue::FromMap({{"a", FieldValue::FromString("A")}}),
+            value.Delete(testutil::Field("b")));
+  EXPECT_EQ(FieldValue::FromString("A"), value.Get(testutil::Field("a")));
+  EXPECT_EQ(1, source->all_decodes_);
+  EXPECT_EQ(0, source->field_decodes_);
+}
+
+TEST(FieldValue, CopiesShareContents) {
+  const FieldValue string_value = FieldValue::FromString("abc");
+  const FieldValue string_copy = string_value;
+  EXPECT_EQ(&string_value.string_value(), &string_copy.string_value());
+
+  const FieldValue array_value =
+      FieldValue::FromArray({FieldValue::FromInteger(1)});
+  const FieldValue array_copy = array_value;
+  EXPECT_EQ(&array_value.array_value(), &array_copy.array_value());
+
+  FieldValue moved_from = FieldValue::FromString("abc");
+  const FieldValue moved_to = std::move(moved_from);
+  EXPECT_EQ(FieldValue::FromString("abc"), moved_to);
+  EXPECT_EQ(Type::Null, moved_from.type());  // NOLINT: use after move intended
+}
+
+TEST(FieldValue, HashIsConsistentWithEquality) {
+  EXPECT_EQ(FieldValue::FromInteger(1).Hash(),
+            FieldValue::FromDouble(1.0).Hash());
+  EXPECT_EQ(FieldValue::FromDouble(0.0).Hash(),
+            FieldValue::FromDouble(-0.0).Hash());
+  EXPECT_EQ(FieldValue::Nan().Hash(), FieldValue::FromDouble(-NAN).Hash());
+  EXPECT_EQ(FieldValue::FromServerTimestamp(Timestamp(1, 2)).Hash(),
+            FieldValue::FromServerTimestamp(Timestamp(1, 2), Timestamp(3, 4))
+                .Hash());
+
+  const ObjectValue object = ObjectValue::FromMap({
+      {"a", FieldValue::FromString("A")},
+      {"b", FieldValue::FromArray({FieldValue::Null(), FieldValue::True()})},
+  });
+  const ObjectValue same = ObjectValue::FromMap({
+      {"a", FieldValue::FromString("A")},
+      {"b", FieldValue::FromArray({FieldValue::Null(), FieldValue::True()})},
+  });
+  EXPECT_EQ(object, same);
+  EXPECT_EQ(object.Hash(), same.Hash());
+  EXPECT_NE(object.Hash(),
+            object.Set(testutil::Field("a"), FieldValue::FromString("B"))
+                .Hash());
+}
+
+TEST(FieldValue, AbslHashIsConsistentWithEquality) {
+  absl::Hash<FieldValue> hash;
+  EXPECT_EQ(hash(FieldValue::FromInteger(1)),
+            hash(FieldValue::FromDouble(1.0)));
+  EXPECT_EQ(hash(FieldValue::FromString("abc")),
+            hash(FieldValue::FromString("abc")));
+  EXPECT_NE(hash(FieldValue::FromString("abc")),
+            hash(FieldValue::FromString("abd")));
+}
+
 TEST(FieldValue, IsSmallish) {
-  // We expect the FV to use 4 bytes to track the type of the union, plus 8
-  // bytes for the union contents themselves. The other 4 is for padding. We
-  // want to keep FV as small as possible.
-  EXPECT_LE(sizeof(FieldValue), 2 * sizeof(int64_t));
+  // We expect the FV to use 4 bytes to track the type of the union, plus 16
+  // bytes for the union contents themselves (an inline Timestamp or GeoPoint,
+  // or a shared pointer). The other 4 is for padding. We want to keep FV as
+  // small as possible.
+  EXPECT_LE(sizeof(FieldValue), 3 * sizeof(int64_t));
 }
 
 }  //  namespace model
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/path_interner.h"
+
+#include <memory>
+
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+TEST(PathInternerTest, ReturnsSameInstanceForEqualPaths) {
+  PathInterner interner;
+  auto first = interner.Intern(ResourcePath{"rooms", "abc"});
+  auto second = interner.Intern(ResourcePath{"rooms", "abc"});
+  auto other = interner.Intern(ResourcePath{"rooms", "abd"});
+
+  EXPECT_EQ(first, second);
+  EXPECT_NE(first, other);
+  EXPECT_EQ(*first, (ResourcePath{"rooms", "abc"}));
+  EXPECT_EQ(*other, (ResourcePath{"rooms", "abd"}));
+}
+
+TEST(PathInternerTest, SharesSegmentsAndPrefixes) {
+  PathInterner interner;
+  auto first = interner.Intern(ResourcePath{"rooms", "a", "messages", "1"});
+  auto second = interner.Intern(ResourcePath{"rooms", "a", "messages", "2"});
+  auto third = interner.Intern(ResourcePath{"rooms", "b", "messages", "1"});
+
+  // "rooms", "a", "b", "messages", "1", "2".
+  EXPECT_EQ(interner.segment_count(), 6u);
+  // rooms/, rooms/a/, rooms/a/messages/ and its two children, plus
+  // rooms/b/, rooms/b/messages/ and its child.
+  EXPECT_EQ(interner.node_count(), 8u);
+}
+
+TEST(PathInternerTest, ReleasesNodesWithLastPath) {
+  PathInterner interner;
+  auto parent = interner.Intern(ResourcePath{"rooms", "a"});
+  auto child = interner.Intern(ResourcePath{"rooms", "a", "messages", "1"});
+  EXPECT_EQ(interner.node_count(), 4u);
+
+  child.reset();
+  EXPECT_EQ(interner.node_count(), 2u);
+  EXPECT_EQ(interner.segment_count(), 2u);
+
+  parent.reset();
+  EXPECT_EQ(interner.node_count(), 0u);
+  EXPECT_EQ(interner.segment_count(), 0u);
+}
+
+TEST(PathInternerTest, ReinternsAfterRelease) {
+  PathInterner interner;
+  auto path = interner.Intern(ResourcePath{"rooms", "a"});
+  std::weak_ptr<const ResourcePath> weak = path;
+  path.reset();
+  EXPECT_TRUE(weak.expired());
+
+  path = interner.Intern(ResourcePath{"rooms", "a"});
+  EXPECT_EQ(*path, (ResourcePath{"rooms", "a"}));
+  EXPECT_EQ(interner.node_count(), 2u);
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
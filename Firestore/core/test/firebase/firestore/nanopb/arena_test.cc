@@ -0,0 +1,131 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/nanopb/arena.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/nanopb_system_header.h"
+#include "absl/base/config.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+namespace {
+
+bool IsAligned(const void* ptr) {
+  return reinterpret_cast<uintptr_t>(ptr) % alignof(std::max_align_t) == 0;
+}
+
+}  // namespace
+
+TEST(ArenaTest, AllocatesAlignedMemoryFromOneBlock) {
+  Arena arena{1024};
+  void* first = arena.Allocate(3);
+  void* second = arena.Allocate(40);
+  ASSERT_NE(nullptr, first);
+  ASSERT_NE(nullptr, second);
+  EXPECT_NE(first, second);
+  EXPECT_TRUE(IsAligned(first));
+  EXPECT_TRUE(IsAligned(second));
+  EXPECT_TRUE(arena.Owns(first));
+  EXPECT_TRUE(arena.Owns(second));
+  EXPECT_EQ(1u, arena.block_count());
+
+  int on_stack = 0;
+  EXPECT_FALSE(arena.Owns(&on_stack));
+}
+
+TEST(ArenaTest, GrowsWithLargerBlocks) {
+  Arena arena{64};
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_NE(nullptr, arena.Allocate(32));
+  }
+  // 100 allocations of 48 bytes (with their headers) fit in blocks of 64,
+  // 128, ..., 4096 bytes.
+  EXPECT_LE(arena.block_count(), 7u);
+
+  void* large = arena.Allocate(100000);
+  ASSERT_NE(nullptr, large);
+  EXPECT_TRUE(arena.Owns(large));
+}
+
+TEST(ArenaTest, ReallocatesTheLastAllocationInPlace) {
+  Arena arena{1024};
+  auto* values = static_cast<int*>(arena.Reallocate(nullptr, sizeof(int)));
+  values[0] = 1;
+  for (int size = 2; size <= 16; ++size) {
+    auto* grown =
+        static_cast<int*>(arena.Reallocate(values, sizeof(int) * size));
+    EXPECT_EQ(values, grown);
+    grown[size - 1] = size;
+    values = grown;
+  }
+  EXPECT_EQ(1, values[0]);
+  EXPECT_EQ(16, values[15]);
+}
+
+TEST(ArenaTest, ReallocatingCopiesEarlierAllocations) {
+  Arena arena{1024};
+  auto* first = static_cast<char*>(arena.Allocate(4));
+  std::memcpy(first, "abc", 4);
+  arena.Allocate(8);
+
+  auto* moved = static_cast<char*>(arena.Reallocate(first, 64));
+  ASSERT_NE(nullptr, moved);
+  EXPECT_NE(first, moved);
+  EXPECT_STREQ("abc", moved);
+
+  EXPECT_EQ(moved, arena.Reallocate(moved, 16));
+}
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+TEST(ArenaTest, ScopeRoutesNanopbAllocations) {
+  Arena arena;
+  void* outside = firebase_firestore_nanopb_realloc(nullptr, 16);
+  EXPECT_FALSE(arena.Owns(outside));
+
+  void* inside = nullptr;
+  {
+    ArenaScope scope{&arena};
+    inside = firebase_firestore_nanopb_realloc(nullptr, 16);
+    EXPECT_TRUE(arena.Owns(inside));
+
+    // Freeing arena memory is a no-op; other memory is still freed.
+    firebase_firestore_nanopb_free(inside);
+    firebase_firestore_nanopb_free(outside);
+
+    {
+      ArenaScope no_arena{nullptr};
+      void* malloced = firebase_firestore_nanopb_realloc(nullptr, 16);
+      EXPECT_FALSE(arena.Owns(malloced));
+      firebase_firestore_nanopb_free(malloced);
+    }
+    EXPECT_TRUE(arena.Owns(firebase_firestore_nanopb_realloc(nullptr, 16)));
+  }
+
+  void* after = firebase_firestore_nanopb_realloc(nullptr, 16);
+  EXPECT_FALSE(arena.Owns(after));
+  firebase_firestore_nanopb_free(after);
+}
+#endif  // defined(ABSL_HAVE_THREAD_LOCAL)
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+namespace {
+
+google_firestore_v1_Value IntegerValue(int64_t value) {
+  google_firestore_v1_Value proto{};
+  proto.which_value_type = google_firestore_v1_Value_integer_value_tag;
+  proto.integer_value = value;
+  return proto;
+}
+
+}  // namespace
+
+TEST(WriterTest, AppendsMessagesToVectors) {
+  std::vector<std::uint8_t> bytes{0xFF};
+  Writer writer = Writer::Wrap(&bytes);
+
+  google_firestore_v1_Value proto = IntegerValue(42);
+  writer.WriteNanopbMessage(google_firestore_v1_Value_fields, &proto);
+  EXPECT_EQ((std::vector<std::uint8_t>{0xFF, 0x10, 0x2A}), bytes);
+
+  proto = IntegerValue(1);
+  writer.WriteNanopbMessage(google_firestore_v1_Value_fields, &proto);
+  EXPECT_EQ((std::vector<std::uint8_t>{0xFF, 0x10, 0x2A, 0x10, 0x01}), bytes);
+}
+
+TEST(WriterTest, AppendsMessagesToStrings) {
+  std::string bytes;
+  Writer writer = Writer::Wrap(&bytes);
+
+  google_firestore_v1_Value proto = IntegerValue(42);
+  writer.WriteNanopbMessage(google_firestore_v1_Value_fields, &proto);
+  EXPECT_EQ(std::string("\x10\x2A"), bytes);
+}
+
+TEST(WriterTest, WritesEmptyMessages) {
+  std::vector<std::uint8_t> bytes;
+  Writer writer = Writer::Wrap(&bytes);
+
+  google_firestore_v1_Value proto{};
+  writer.WriteNanopbMessage(google_firestore_v1_Value_fields, &proto);
+  EXPECT_TRUE(bytes.empty());
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/remote/decode_pool.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+using util::Executor;
+using util::ExecutorStd;
+
+std::vector<std::unique_ptr<Executor>> CreateExecutors(size_t count) {
+  std::vector<std::unique_ptr<Executor>> result;
+  for (size_t i = 0; i != count; ++i) {
+    result.push_back(absl::make_unique<ExecutorStd>());
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(DecodePoolTest, RunAllWaitsForAllOperations) {
+  DecodePool pool{CreateExecutors(2)};
+  std::vector<int> results(10, 0);
+
+  std::vector<std::function<void()>> operations;
+  for (size_t i = 0; i != results.size(); ++i) {
+    operations.push_back([&results, i] { results[i] = static_cast<int>(i); });
+  }
+  pool.RunAll(std::move(operations));
+
+  for (size_t i = 0; i != results.size(); ++i) {
+    EXPECT_EQ(static_cast<int>(i), results[i]);
+  }
+}
+
+TEST(DecodePoolTest, RunAllRunsFirstOperationOnCallingThread) {
+  DecodePool pool{CreateExecutors(1)};
+  std::thread::id first;
+  std::thread::id second;
+
+  std::vector<std::function<void()>> operations;
+  operations.push_back([&first] { first = std::this_thread::get_id(); });
+  operations.push_back([&second] { second = std::this_thread::get_id(); });
+  pool.RunAll(std::move(operations));
+
+  EXPECT_EQ(std::this_thread::get_id(), first);
+  EXPECT_NE(std::this_thread::get_id(), second);
+}
+
+TEST(DecodePoolTest, RunAllAcceptsNoOperations) {
+  DecodePool pool{CreateExecutors(1)};
+  pool.RunAll({});
+  EXPECT_EQ(1u, pool.size());
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -86,6 +86,31 @@ TEST_F(ExponentialBackoffTest, SequentialCallsToBackoffAndRun) {
   EXPECT_TRUE(WaitForTestToFinish());
 }
 
+TEST_F(ExponentialBackoffTest, ReturnsScheduledDelay) {
+  queue.EnqueueBlocking([&] {
+    // The first attempt is never delayed.
+    EXPECT_EQ(backoff.BackoffAndRun([] {}).count(), 0);
+
+    // Initial delay of 5 seconds with up to 50% jitter.
+    auto delay = backoff.BackoffAndRun([] {});
+    EXPECT_GT(delay.count(), 0);
+    EXPECT_LE(delay, chr::milliseconds{7500});
+    backoff.Cancel();
+  });
+}
+
+TEST_F(ExponentialBackoffTest, BackoffWithoutEscalationKeepsDelay) {
+  queue.EnqueueBlocking([&] {
+    // Without escalation, the delay stays at zero however often it's used.
+    EXPECT_EQ(backoff.BackoffWithoutEscalationAndRun([] {}).count(), 0);
+    EXPECT_EQ(backoff.BackoffWithoutEscalationAndRun([] {}).count(), 0);
+
+    EXPECT_EQ(backoff.BackoffAndRun([] {}).count(), 0);
+    EXPECT_GT(backoff.BackoffWithoutEscalationAndRun([] {}).count(), 0);
+    backoff.Cancel();
+  });
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
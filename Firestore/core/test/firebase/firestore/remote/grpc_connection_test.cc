@@ -41,6 +41,7 @@ using util::ExecutorStd;
 using util::GrpcStreamTester;
 using util::Status;
 using util::StatusOr;
+using ChannelState = ConnectivityMonitor::ChannelState;
 using NetworkStatus = ConnectivityMonitor::NetworkStatus;
 
 namespace {
@@ -219,6 +220,55 @@ TEST_F(GrpcConnectionTest, ShutdownFastFinishesActiveCalls) {
   EXPECT_NO_THROW(baz.reset());
 }
 
+TEST_F(GrpcConnectionTest, ReportsChannelStateToConnectivityMonitor) {
+  EXPECT_FALSE(connectivity_monitor->channel_state(0).has_value());
+
+  ConnectivityObserver observer;
+  std::unique_ptr<GrpcStream> stream = tester.CreateStream(&observer);
+
+  // A freshly created channel doesn't try to connect until a call is started.
+  EXPECT_EQ(connectivity_monitor->channel_state(0), ChannelState::Idle);
+}
+
+TEST_F(GrpcConnectionTest, WarmUpCreatesChannelsBeforeAnyCall) {
+  EXPECT_FALSE(connectivity_monitor->channel_state(0).has_value());
+
+  worker_queue.EnqueueBlocking([&] { tester.grpc_connection()->WarmUp(); });
+
+  EXPECT_TRUE(connectivity_monitor->channel_state(0).has_value());
+}
+
+TEST_F(GrpcConnectionTest, ConnectionsToTheSameHostShareChannels) {
+  worker_queue.EnqueueBlocking([&] { tester.grpc_connection()->WarmUp(); });
+
+  FakeConnectivityMonitor other_monitor{&worker_queue};
+  GrpcStreamTester other_tester{&worker_queue, &other_monitor};
+  ConnectivityObserver observer;
+  std::unique_ptr<GrpcStream> stream = other_tester.CreateStream(&observer);
+
+  // A channel of its own would still be idle, like in
+  // ReportsChannelStateToConnectivityMonitor.
+  ASSERT_TRUE(other_monitor.channel_state(0).has_value());
+  EXPECT_NE(other_monitor.channel_state(0), ChannelState::Idle);
+}
+
+TEST_F(GrpcConnectionTest, ChannelStateCallbacksOnlyNoticeChanges) {
+  std::vector<ChannelState> states;
+  connectivity_monitor->AddChannelStateCallback(
+      [&](size_t channel_index, ChannelState state) {
+        EXPECT_EQ(channel_index, 1u);
+        states.push_back(state);
+      });
+
+  connectivity_monitor->UpdateChannelState(1, ChannelState::Connecting);
+  connectivity_monitor->UpdateChannelState(1, ChannelState::Connecting);
+  connectivity_monitor->UpdateChannelState(1, ChannelState::Ready);
+
+  EXPECT_EQ(states, (std::vector<ChannelState>{ChannelState::Connecting,
+                                                ChannelState::Ready}));
+  EXPECT_FALSE(connectivity_monitor->channel_state(0).has_value());
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_nanopb.h"
+
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/nanopb_string.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/test/firebase/firestore/util/grpc_stream_tester.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/slice.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using nanopb::Reader;
+using nanopb::String;
+using util::ByteBufferToString;
+
+namespace {
+
+google_firestore_v1_Value StringValue(const std::string& value) {
+  google_firestore_v1_Value proto{};
+  proto.which_value_type = google_firestore_v1_Value_string_value_tag;
+  proto.string_value = String::MakeBytesArray(value);
+  return proto;
+}
+
+// Splits `bytes` into slices of at most `slice_size` bytes.
+grpc::ByteBuffer MakeSlicedByteBuffer(const std::string& bytes,
+                                      size_t slice_size) {
+  std::vector<grpc::Slice> slices;
+  for (size_t i = 0; i < bytes.size(); i += slice_size) {
+    std::string part = bytes.substr(i, slice_size);
+    slices.emplace_back(part.data(), part.size());
+  }
+  return grpc::ByteBuffer{slices.data(), slices.size()};
+}
+
+std::string Encode(const google_firestore_v1_Value& proto) {
+  std::string bytes;
+  nanopb::Writer writer = nanopb::Writer::Wrap(&bytes);
+  writer.WriteNanopbMessage(google_firestore_v1_Value_fields, &proto);
+  return bytes;
+}
+
+}  // namespace
+
+TEST(GrpcNanopbTest, ReadsAcrossSlices) {
+  std::string value(1000, 'a');
+  google_firestore_v1_Value original = StringValue(value);
+  std::string bytes = Encode(original);
+  pb_release(google_firestore_v1_Value_fields, &original);
+
+  for (size_t slice_size : {1, 3, 64, 4096}) {
+    grpc::ByteBuffer buffer = MakeSlicedByteBuffer(bytes, slice_size);
+    ByteBufferReader buffer_reader{buffer};
+    Reader* reader = buffer_reader.reader();
+
+    google_firestore_v1_Value decoded{};
+    reader->ReadNanopbMessage(google_firestore_v1_Value_fields, &decoded);
+    ASSERT_TRUE(reader->status().ok());
+    const pb_bytes_array_t* bytes_array = decoded.string_value;
+    EXPECT_EQ(value,
+              std::string(reinterpret_cast<const char*>(bytes_array->bytes),
+                          bytes_array->size));
+    reader->FreeNanopbMessage(google_firestore_v1_Value_fields, &decoded);
+  }
+}
+
+TEST(GrpcNanopbTest, FailsOnTruncatedMessages) {
+  google_firestore_v1_Value original = StringValue("foo");
+  std::string bytes = Encode(original);
+  pb_release(google_firestore_v1_Value_fields, &original);
+
+  grpc::ByteBuffer buffer =
+      MakeSlicedByteBuffer(bytes.substr(0, bytes.size() - 1), 2);
+  ByteBufferReader buffer_reader{buffer};
+  Reader* reader = buffer_reader.reader();
+
+  google_firestore_v1_Value decoded{};
+  reader->ReadNanopbMessage(google_firestore_v1_Value_fields, &decoded);
+  EXPECT_FALSE(reader->status().ok());
+  reader->FreeNanopbMessage(google_firestore_v1_Value_fields, &decoded);
+}
+
+TEST(GrpcNanopbTest, WritesOneSlicePerMessage) {
+  google_firestore_v1_Value first = StringValue("foo");
+  google_firestore_v1_Value second = StringValue(std::string(500, 'b'));
+
+  ByteBufferWriter buffer_writer;
+  buffer_writer.writer()->WriteNanopbMessage(google_firestore_v1_Value_fields,
+                                             &first);
+  buffer_writer.writer()->WriteNanopbMessage(google_firestore_v1_Value_fields,
+                                             &second);
+  grpc::ByteBuffer buffer = buffer_writer.Release();
+
+  std::vector<grpc::Slice> slices;
+  ASSERT_TRUE(buffer.Dump(&slices).ok());
+  EXPECT_EQ(2u, slices.size());
+  EXPECT_EQ(Encode(first) + Encode(second), ByteBufferToString(buffer));
+
+  pb_release(google_firestore_v1_Value_fields, &first);
+  pb_release(google_firestore_v1_Value_fields, &second);
+}
+
+TEST(GrpcNanopbTest, ReleaseEmptiesTheWriter) {
+  google_firestore_v1_Value proto = StringValue("foo");
+
+  ByteBufferWriter buffer_writer;
+  buffer_writer.writer()->WriteNanopbMessage(google_firestore_v1_Value_fields,
+                                             &proto);
+  EXPECT_EQ(Encode(proto), ByteBufferToString(buffer_writer.Release()));
+  EXPECT_EQ(0u, buffer_writer.Release().Length());
+
+  pb_release(google_firestore_v1_Value_fields, &proto);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -32,6 +32,7 @@
 #include "Firestore/core/test/firebase/firestore/util/create_noop_connectivity_monitor.h"
 #include "Firestore/core/test/firebase/firestore/util/grpc_stream_tester.h"
 #include "absl/memory/memory.h"
+#include "absl/types/any.h"
 #include "grpcpp/support/byte_buffer.h"
 #include "gtest/gtest.h"
 
@@ -76,6 +77,17 @@ class Observer : public GrpcStreamObserver {
   std::vector<std::string> observed_states;
 };
 
+class DecodingObserver : public Observer {
+ public:
+  absl::any DecodeStreamRead(const grpc::ByteBuffer& message) override {
+    return StringFormat("decoded(%s)", ByteBufferToString(message));
+  }
+  void OnStreamDecodedRead(const grpc::ByteBuffer&,
+                           const absl::any& decoded) override {
+    observed_states.push_back(absl::any_cast<std::string>(decoded));
+  }
+};
+
 class DestroyingObserver : public GrpcStreamObserver {
  public:
   enum class Destroy { OnStart, OnRead, OnFinish };
@@ -209,6 +221,17 @@ TEST_F(GrpcStreamTest, ReadIsAutomaticallyReadded) {
                                        "OnStreamRead(bar)"}));
 }
 
+TEST_F(GrpcStreamTest, ReadIsDecodedBeforeReachingWorkerQueue) {
+  DecodingObserver decoding_observer;
+  stream = tester.CreateStream(&decoding_observer);
+
+  worker_queue.EnqueueBlocking([&] { stream->Start(); });
+
+  ForceFinish({{Type::Read, MakeByteBuffer("foo")}});
+  EXPECT_EQ(decoding_observer.observed_states,
+            States({"OnStreamStart", "decoded(foo)"}));
+}
+
 TEST_F(GrpcStreamTest, CanAddSeveralWrites) {
   worker_queue.EnqueueBlocking([&] { stream->Start(); });
 
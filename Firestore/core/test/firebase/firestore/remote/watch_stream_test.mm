@@ -0,0 +1,210 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
+
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/remote/decode_pool.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_stream.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "Firestore/core/test/firebase/firestore/util/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/firebase/firestore/util/fake_credentials_provider.h"
+#include "Firestore/core/test/firebase/firestore/util/grpc_stream_tester.h"
+#include "absl/memory/memory.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "gtest/gtest.h"
+
+#import "Firestore/Protos/objc/google/firestore/v1/Firestore.pbobjc.h"
+#import "Firestore/Source/Remote/FSTSerializerBeta.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using auth::CredentialsProvider;
+using auth::Token;
+using model::DatabaseId;
+using model::SnapshotVersion;
+using model::TargetId;
+using util::AsyncQueue;
+using util::CreateNoOpConnectivityMonitor;
+using util::Executor;
+using util::ExecutorStd;
+using util::FakeCredentialsProvider;
+using util::GrpcStreamTester;
+using util::Status;
+using Type = GrpcCompletion::Type;
+
+namespace {
+
+grpc::ByteBuffer MakeTargetChange(TargetId target_id) {
+  GCFSListenResponse* response = [GCFSListenResponse message];
+  response.targetChange.targetChangeType =
+      GCFSTargetChange_TargetChangeType_NoChange;
+  [response.targetChange.targetIdsArray addValue:target_id];
+
+  NSData* data = [response data];
+  grpc::Slice slice{[data bytes], [data length]};
+  return grpc::ByteBuffer{&slice, 1};
+}
+
+/** Records the target of every target change it receives. */
+class RecordingCallback : public WatchStreamCallback {
+ public:
+  void OnWatchStreamOpen() override {
+  }
+
+  void OnWatchStreamChange(const WatchChange& change,
+                           const SnapshotVersion&) override {
+    ASSERT_EQ(change.type(), WatchChange::Type::TargetChange);
+    const auto& target_change = static_cast<const WatchTargetChange&>(change);
+    target_ids.insert(target_ids.end(), target_change.target_ids().begin(),
+                      target_change.target_ids().end());
+  }
+
+  void OnWatchStreamClose(const Status&) override {
+  }
+
+  std::vector<TargetId> target_ids;
+};
+
+/** A `WatchStream` that runs on a `GrpcStreamTester` stream. */
+class TestWatchStream : public WatchStream {
+ public:
+  TestWatchStream(AsyncQueue* worker_queue,
+                  GrpcStreamTester* tester,
+                  CredentialsProvider* credentials_provider,
+                  FSTSerializerBeta* serializer,
+                  WatchStreamCallback* callback,
+                  DecodePool* decode_pool)
+      : WatchStream{worker_queue,
+                    credentials_provider,
+                    serializer,
+                    /*grpc_connection=*/nullptr,
+                    callback,
+                    decode_pool},
+        tester_{tester} {
+  }
+
+  grpc::ClientContext* context() {
+    return context_;
+  }
+
+ private:
+  std::unique_ptr<GrpcStream> CreateGrpcStream(GrpcConnection*,
+                                               const Token&) override {
+    auto result = tester_->CreateStream(this);
+    context_ = result->context();
+    return result;
+  }
+
+  GrpcStreamTester* tester_ = nullptr;
+  grpc::ClientContext* context_ = nullptr;
+};
+
+}  // namespace
+
+class WatchStreamTest : public testing::Test {
+ public:
+  WatchStreamTest()
+      : worker_queue{absl::make_unique<ExecutorStd>()},
+        connectivity_monitor{CreateNoOpConnectivityMonitor()},
+        tester{&worker_queue, connectivity_monitor.get()},
+        database_id{"p", "d"},
+        serializer{
+            [[FSTSerializerBeta alloc] initWithDatabaseID:&database_id]} {
+    std::vector<std::unique_ptr<Executor>> executors;
+    for (int i = 0; i != 2; ++i) {
+      executors.push_back(absl::make_unique<ExecutorStd>());
+      decode_executors.push_back(executors.back().get());
+    }
+    decode_pool = absl::make_unique<DecodePool>(std::move(executors));
+
+    watch_stream = std::make_shared<TestWatchStream>(
+        &worker_queue, &tester, &credentials, serializer, &callback,
+        decode_pool.get());
+  }
+
+  ~WatchStreamTest() {
+    worker_queue.EnqueueBlocking([&] {
+      if (watch_stream->IsStarted()) {
+        tester.KeepPollingGrpcQueue();
+        watch_stream->Stop();
+      }
+    });
+    tester.Shutdown();
+  }
+
+  void StartStream() {
+    worker_queue.EnqueueBlocking([&] { watch_stream->Start(); });
+    worker_queue.EnqueueBlocking([] {});
+  }
+
+  /** Waits for everything scheduled so far on the given decode executor. */
+  void DrainDecodeExecutor(size_t index) {
+    decode_executors[index]->ExecuteBlocking([] {});
+  }
+
+  AsyncQueue worker_queue;
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor;
+  GrpcStreamTester tester;
+  FakeCredentialsProvider credentials;
+
+  DatabaseId database_id;
+  FSTSerializerBeta* serializer = nil;
+  RecordingCallback callback;
+
+  std::vector<Executor*> decode_executors;
+  std::unique_ptr<DecodePool> decode_pool;
+  std::shared_ptr<TestWatchStream> watch_stream;
+};
+
+TEST_F(WatchStreamTest, DeliversResponsesInOrderWhenDecodesFinishOutOfOrder) {
+  StartStream();
+
+  // Hold up the executor that the first response is decoded on.
+  std::promise<void> gate;
+  std::shared_future<void> gate_opened = gate.get_future().share();
+  decode_executors[0]->Execute([gate_opened] { gate_opened.wait(); });
+
+  tester.ForceFinish(watch_stream->context(),
+                     {
+                         {Type::Read, MakeTargetChange(1)},
+                         {Type::Read, MakeTargetChange(2)},
+                     });
+
+  // The second response is decoded first, but has to wait for the first one.
+  DrainDecodeExecutor(1);
+  worker_queue.EnqueueBlocking(
+      [&] { EXPECT_TRUE(callback.target_ids.empty()); });
+
+  gate.set_value();
+  DrainDecodeExecutor(0);
+  worker_queue.EnqueueBlocking([&] {
+    EXPECT_EQ(callback.target_ids, (std::vector<TargetId>{1, 2}));
+  });
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/allocation_counters.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+// The number of allocations that counting is expected to have seen.
+uint64_t Expected(uint64_t allocations) {
+  return kAllocationCountingEnabled ? allocations : 0;
+}
+
+}  // namespace
+
+TEST(AllocationCountersTest, CountsBySubsystem) {
+  ResetAllocationCounts();
+  CountAllocation(AllocationSubsystem::kModel, 16);
+  CountAllocation(AllocationSubsystem::kModel, 32);
+  CountAllocation(AllocationSubsystem::kLocal, 8);
+
+  AllocationCounts model = GetAllocationCounts(AllocationSubsystem::kModel);
+  EXPECT_EQ(Expected(2), model.allocations);
+  EXPECT_EQ(Expected(48), model.bytes);
+  EXPECT_EQ(Expected(1),
+            GetAllocationCounts(AllocationSubsystem::kLocal).allocations);
+  EXPECT_EQ(0u,
+            GetAllocationCounts(AllocationSubsystem::kNanopb).allocations);
+
+  ResetAllocationCounts();
+  EXPECT_EQ(0u, GetAllocationCounts(AllocationSubsystem::kModel).allocations);
+}
+
+TEST(AllocationCountersTest, CountingAllocatorCountsNodes) {
+  using Allocator = CountingAllocator<std::pair<const int, int>,
+                                      AllocationSubsystem::kImmutable>;
+  std::map<int, int, std::less<int>, Allocator> map;
+
+  ResetAllocationCounts();
+  map[1] = 1;
+  map[2] = 2;
+  map[1] = 3;
+  EXPECT_EQ(Expected(2),
+            GetAllocationCounts(AllocationSubsystem::kImmutable).allocations);
+}
+
+TEST(AllocationCountersTest, MakeCountedShared) {
+  ResetAllocationCounts();
+  std::shared_ptr<std::string> value =
+      MakeCountedShared<AllocationSubsystem::kModel, std::string>("value");
+  EXPECT_EQ("value", *value);
+  EXPECT_EQ(Expected(1),
+            GetAllocationCounts(AllocationSubsystem::kModel).allocations);
+}
+
+TEST(AllocationCountersTest, Names) {
+  EXPECT_STREQ("immutable",
+               AllocationSubsystemName(AllocationSubsystem::kImmutable));
+  EXPECT_STREQ("local", AllocationSubsystemName(AllocationSubsystem::kLocal));
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -61,6 +61,78 @@ TEST_P(AsyncQueueTest, EnqueueRelaxedWorksFromWithinEnqueue) {
   EXPECT_TRUE(WaitForTestToFinish());
 }
 
+TEST_P(AsyncQueueTest, EnqueueRunsHigherPrioritiesFirst) {
+  using Priority = AsyncQueue::Priority;
+  std::string steps;
+
+  queue.Enqueue([&] {
+    // Enqueue everything from the queue so that nothing runs until all of it
+    // is pending.
+    queue.EnqueueRelaxed(Priority::Background, [&steps] { steps += '5'; });
+    queue.EnqueueRelaxed([&steps] { steps += '3'; });
+    queue.EnqueueRelaxed(Priority::Interactive, [&steps] { steps += '1'; });
+    queue.EnqueueRelaxed(Priority::Background, [&] {
+      steps += '6';
+      signal_finished();
+    });
+    queue.EnqueueRelaxed([&steps] { steps += '4'; });
+    queue.EnqueueRelaxed(Priority::Interactive, [&steps] { steps += '2'; });
+  });
+
+  EXPECT_TRUE(WaitForTestToFinish());
+  EXPECT_EQ(steps, "123456");
+}
+
+TEST_P(AsyncQueueTest, BackgroundStepsYieldToOtherOperations) {
+  std::string steps;
+  int remaining = 3;
+
+  queue.Enqueue([&] {
+    queue.EnqueueBackgroundSteps([&] {
+      steps += 'b';
+      if (remaining == 3) {
+        queue.EnqueueRelaxed([&steps] { steps += 'n'; });
+      }
+      if (--remaining > 0) return true;
+
+      signal_finished();
+      return false;
+    });
+  });
+
+  EXPECT_TRUE(WaitForTestToFinish());
+  EXPECT_EQ(steps, "bnbb");
+}
+
+TEST_P(AsyncQueueTest, RecordsOperationStatsByLabel) {
+  using Priority = AsyncQueue::Priority;
+
+  queue.Enqueue(Priority::Normal, [] {}, "unrecorded");
+  queue.SetInstrumentationEnabled(true);
+  queue.Enqueue(Priority::Normal, [] {}, "first");
+  queue.Enqueue(Priority::Normal, [] {}, "second");
+  queue.Enqueue(Priority::Normal, [&] {
+    queue.EnqueueAfterDelay(AsyncQueue::Milliseconds(1), kTimerId1,
+                            [&] { signal_finished(); });
+  });
+  queue.Enqueue(Priority::Normal, [] {}, "second");
+
+  EXPECT_TRUE(WaitForTestToFinish());
+
+  // The delayed operation records its stats only once it has returned.
+  queue.EnqueueBlocking([] {});
+
+  AsyncQueue::OperationStatsMap stats = queue.GetOperationStats();
+  EXPECT_EQ(stats.count("unrecorded"), 0u);
+  EXPECT_EQ(stats["first"].run_duration.count(), 1);
+  EXPECT_EQ(stats["second"].queue_delay.count(), 2);
+  EXPECT_EQ(stats["second"].run_duration.count(), 2);
+  // The unlabeled operations are the one that schedules the delayed operation
+  // and the blocking one above.
+  EXPECT_EQ(stats[""].run_duration.count(), 2);
+  EXPECT_EQ(stats["ListenStreamConnectionBackoff"].run_duration.count(), 1);
+}
+
 TEST_P(AsyncQueueTest, EnqueueBlocking) {
   bool finished = false;
   queue.EnqueueBlocking([&] { finished = true; });
@@ -17,10 +17,14 @@
 #include "Firestore/core/src/firebase/firestore/util/autoid.h"
 
 #include <cctype>
+#include <set>
+#include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 
 using firebase::firestore::util::CreateAutoId;
+using firebase::firestore::util::CreateAutoIds;
 
 TEST(AutoId, IsSane) {
   for (int i = 0; i < 50; i++) {
@@ -34,3 +38,22 @@ TEST(AutoId, IsSane) {
     }
   }
 }
+
+TEST(AutoId, CreatesDistinctIdsInBulk) {
+  std::vector<std::string> auto_ids = CreateAutoIds(1000);
+  ASSERT_EQ(1000u, auto_ids.size());
+
+  std::set<std::string> distinct;
+  for (const std::string& auto_id : auto_ids) {
+    EXPECT_EQ(20u, auto_id.length());
+    for (char c : auto_id) {
+      EXPECT_TRUE(isalpha(c) || isdigit(c))
+          << "Should be printable ascii character: '" << c << "' in \""
+          << auto_id << "\"";
+    }
+    distinct.insert(auto_id);
+  }
+  EXPECT_EQ(auto_ids.size(), distinct.size());
+
+  EXPECT_TRUE(CreateAutoIds(0).empty());
+}
@@ -18,6 +18,9 @@
 
 #include <cmath>
 #include <limits>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/string_format.h"
 #include "gtest/gtest.h"
@@ -61,6 +64,39 @@ TEST(Comparison, StringCompare) {
   ASSERT_SAME(Compare<absl::string_view>("a", "a"));
 }
 
+#if defined(__APPLE__)
+TEST(Comparison, Utf8StringCompare) {
+  // Each case is listed in ascending order. The UTF-16 encoding of U+1F600
+  // starts with a surrogate, which sorts before U+FFFD as a code unit but must
+  // sort after it as a code point.
+  std::vector<std::pair<std::string, std::string>> cases{
+      {"", "a"},
+      {"a", "aa"},
+      {"a", "b"},
+      {"abc", "abd"},
+      {u8"a", u8"\u00e9"},
+      {u8"\u00e9", u8"\ufffd"},
+      {u8"\ufffd", u8"\U0001f600"},
+      {u8"a\ufffd", u8"a\U0001f600"},
+      {u8"\U0001f600", u8"\U0001f601"},
+  };
+
+  for (const auto& pair : cases) {
+    CFStringRef lower = MakeCFString(pair.first);
+    CFStringRef upper = MakeCFString(pair.second);
+
+    // Agrees with the comparison of the UTF-8 bytes.
+    ASSERT_ASCENDING(Compare<absl::string_view>(pair.first, pair.second));
+    ASSERT_ASCENDING(CompareUtf8(lower, upper));
+    ASSERT_DESCENDING(CompareUtf8(upper, lower));
+    ASSERT_SAME(CompareUtf8(lower, lower));
+
+    CFRelease(lower);
+    CFRelease(upper);
+  }
+}
+#endif  // defined(__APPLE__)
+
 TEST(Comparison, BooleanCompare) {
   ASSERT_SAME(Compare<bool>(false, false));
   ASSERT_SAME(Compare<bool>(true, true));
@@ -17,6 +17,7 @@
 #include "Firestore/core/test/firebase/firestore/util/executor_test.h"
 
 #include <memory>
+#include <string>
 
 #include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
 #include "absl/memory/memory.h"
@@ -70,6 +71,28 @@ TEST_F(ExecutorLibdispatchOnlyTests,
   EXPECT_TRUE(WaitForTestToFinish());
 }
 
+TEST_F(ExecutorLibdispatchOnlyTests, ExecuteWithQosKeepsFifoOrder) {
+  std::string steps;
+  executor->ExecuteWithQos(Executor::QualityOfService::Utility,
+                           [&] { steps += '1'; });
+  executor->ExecuteWithQos(Executor::QualityOfService::UserInitiated,
+                           [&] { steps += '2'; });
+  executor->Execute([&] {
+    steps += '3';
+    signal_finished();
+  });
+  EXPECT_TRUE(WaitForTestToFinish());
+  EXPECT_EQ(steps, "123");
+}
+
+TEST_F(ExecutorLibdispatchOnlyTests, ExecuteWithQosRunsWithTheGivenClass) {
+  executor->ExecuteWithQos(Executor::QualityOfService::Utility, [&] {
+    EXPECT_EQ(qos_class_self(), QOS_CLASS_UTILITY);
+    signal_finished();
+  });
+  EXPECT_TRUE(WaitForTestToFinish());
+}
+
 TEST_F(ExecutorLibdispatchOnlyTests, ScheduledOperationOutlivesExecutor) {
   namespace chr = std::chrono;
   const auto far_away = chr::milliseconds(100);
@@ -127,6 +127,28 @@ TEST_F(ScheduleTest, Ordering) {
   EXPECT_EQ(values, expected);
 }
 
+TEST_F(ScheduleTest, ImmediateEntriesComeFirstInFifoOrder) {
+  const auto immediate = ScheduleT::Immediate();
+  schedule.Push(4, start_time);
+  schedule.Push(1, immediate);
+  schedule.Push(5, start_time + chr::milliseconds(1));
+  schedule.Push(2, immediate);
+  schedule.Push(3, immediate);
+  EXPECT_EQ(schedule.size(), 5u);
+  EXPECT_TRUE(schedule.Contains([](const int v) { return v == 2; }));
+  EXPECT_TRUE(schedule.Contains([](const int v) { return v == 5; }));
+
+  auto maybe_removed = schedule.RemoveIf([](const int v) { return v == 2; });
+  EXPECT_EQ(maybe_removed.value(), 2);
+
+  std::vector<int> values;
+  while (!schedule.empty()) {
+    values.push_back(schedule.PopBlocking());
+  }
+  const std::vector<int> expected = {1, 3, 4, 5};
+  EXPECT_EQ(values, expected);
+}
+
 TEST_F(ScheduleTest, AddingEntryUnblocksEmptyQueue) {
   const auto future = std::async(std::launch::async, [&] {
     ASSERT_FALSE(schedule.PopIfDue().has_value());
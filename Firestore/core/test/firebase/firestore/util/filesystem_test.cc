@@ -280,6 +280,68 @@ TEST(FilesystemTest, ReadFile) {
   ASSERT_EQ(result.ValueOrDie(), "foobar");
 }
 
+TEST(FilesystemTest, WriteFileAtomically) {
+  Path file = Path::JoinUtf8(TempDir(), TestFilename());
+
+  EXPECT_OK(WriteFileAtomically(file, "foobar"));
+  StatusOr<std::string> result = ReadFile(file);
+  ASSERT_OK(result.status());
+  ASSERT_EQ(result.ValueOrDie(), "foobar");
+
+  EXPECT_OK(WriteFileAtomically(file, "baz", Durability::Unsynced));
+  result = ReadFile(file);
+  ASSERT_OK(result.status());
+  ASSERT_EQ(result.ValueOrDie(), "baz");
+
+  // The temporary file is gone once the write is done.
+  Path temp = Path::FromUtf8(file.ToUtf8String() + ".tmp");
+  EXPECT_NOT_FOUND(FileSize(temp).status());
+
+  EXPECT_OK(RecursivelyDelete(file));
+}
+
+TEST(FilesystemTest, MappedFile) {
+  Path file = Path::JoinUtf8(TempDir(), TestFilename());
+  ASSERT_FALSE(MappedFile::Open(file).ok());
+
+  Touch(file);
+  {
+    StatusOr<MappedFile> result = MappedFile::Open(file);
+    ASSERT_OK(result.status());
+    ASSERT_TRUE(result.ValueOrDie().contents().empty());
+  }
+
+  WriteStringToFile(file, "foobar");
+  {
+    StatusOr<MappedFile> result = MappedFile::Open(file);
+    ASSERT_OK(result.status());
+    MappedFile mapped = std::move(result).ValueOrDie();
+    ASSERT_EQ(mapped.size(), 6u);
+    ASSERT_EQ(mapped.contents(), "foobar");
+  }
+
+  EXPECT_OK(RecursivelyDelete(file));
+}
+
+TEST(FilesystemTest, DirectorySize) {
+  Path root_dir = Path::JoinUtf8(TempDir(), TestFilename());
+  ASSERT_FALSE(DirectorySize(root_dir).ok());
+
+  Path nested_dir = Path::JoinUtf8(root_dir, "nested");
+  EXPECT_OK(RecursivelyCreateDir(nested_dir));
+  StatusOr<int64_t> result = DirectorySize(root_dir);
+  ASSERT_OK(result.status());
+  ASSERT_EQ(result.ValueOrDie(), 0);
+
+  WriteBytesToFile(Path::JoinUtf8(root_dir, "file"), 100);
+  WriteBytesToFile(Path::JoinUtf8(nested_dir, "file"), 23);
+  result = DirectorySize(root_dir);
+  ASSERT_OK(result.status());
+  ASSERT_EQ(result.ValueOrDie(), 123);
+
+  EXPECT_OK(RecursivelyDelete(root_dir));
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
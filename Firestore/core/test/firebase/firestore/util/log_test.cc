@@ -42,6 +42,24 @@ TEST(Log, SetAndGet) {
   EXPECT_FALSE(LogIsDebugEnabled());
 }
 
+TEST(Log, SkipsArgumentsWhenDisabled) {
+  int evaluated = 0;
+  auto argument = [&evaluated] {
+    ++evaluated;
+    return evaluated;
+  };
+
+  LogSetLevel(kLogLevelWarning);
+  LOG_DEBUG("not logged %s", argument());
+  EXPECT_EQ(0, evaluated);
+
+  LogSetLevel(kLogLevelDebug);
+  LOG_DEBUG("logged %s", argument());
+  EXPECT_EQ(LogIsCompiledIn(kLogLevelDebug) ? 1 : 0, evaluated);
+
+  LogSetLevel(kLogLevelWarning);
+}
+
 TEST(Log, LogAllKinds) {
   LOG_DEBUG("test debug logging %s", 1);
   LOG_WARN("test warning logging %s", 3);
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/move_only_function.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+int Twice(int value) {
+  return value * 2;
+}
+
+// Counts how many times instances were copied, moved and destroyed.
+struct Counters {
+  int copies = 0;
+  int moves = 0;
+  int destructions = 0;
+};
+
+// A callable that is larger than the inline storage of MoveOnlyFunction.
+struct Large {
+  explicit Large(Counters* counters) : counters{counters} {
+  }
+  Large(const Large& other) : counters{other.counters} {
+    ++counters->copies;
+  }
+  Large(Large&& other) noexcept : counters{other.counters} {
+    ++counters->moves;
+  }
+  ~Large() {
+    ++counters->destructions;
+  }
+
+  int operator()() const {
+    return 42;
+  }
+
+  Counters* counters;
+  char padding[64] = {};
+};
+
+}  // namespace
+
+TEST(MoveOnlyFunctionTest, DefaultConstructedIsEmpty) {
+  MoveOnlyFunction<void()> empty;
+  EXPECT_FALSE(empty);
+
+  MoveOnlyFunction<void()> null = nullptr;
+  EXPECT_FALSE(null);
+}
+
+TEST(MoveOnlyFunctionTest, InvokesLambdas) {
+  int calls = 0;
+  MoveOnlyFunction<void()> f = [&calls] { ++calls; };
+  ASSERT_TRUE(f);
+  f();
+  f();
+  EXPECT_EQ(2, calls);
+}
+
+TEST(MoveOnlyFunctionTest, ForwardsArgumentsAndResults) {
+  MoveOnlyFunction<std::string(const std::string&, int)> f =
+      [](const std::string& s, int n) { return s + std::to_string(n); };
+  EXPECT_EQ("a1", f("a", 1));
+
+  MoveOnlyFunction<int(int)> pointer = Twice;
+  EXPECT_EQ(6, pointer(3));
+}
+
+TEST(MoveOnlyFunctionTest, HoldsMoveOnlyCallables) {
+  auto payload = absl::make_unique<int>(7);
+  int* raw = payload.get();
+  MoveOnlyFunction<int()> f = std::bind(
+      [](const std::unique_ptr<int>& bound) { return *bound; },
+      std::move(payload));
+  EXPECT_EQ(7, f());
+
+  MoveOnlyFunction<int()> moved = std::move(f);
+  EXPECT_FALSE(f);  // NOLINT(bugprone-use-after-move)
+  EXPECT_EQ(7, moved());
+  EXPECT_EQ(7, *raw);
+}
+
+TEST(MoveOnlyFunctionTest, MovingLargeCallablesDoesNotMoveThem) {
+  Counters counters;
+  {
+    MoveOnlyFunction<int()> f = Large{&counters};
+    int moves_into_storage = counters.moves;
+
+    MoveOnlyFunction<int()> g = std::move(f);
+    MoveOnlyFunction<int()> h;
+    h = std::move(g);
+    EXPECT_EQ(42, h());
+
+    EXPECT_EQ(0, counters.copies);
+    EXPECT_EQ(moves_into_storage, counters.moves);
+  }
+  // The temporary and the one owned instance.
+  EXPECT_EQ(counters.moves + 1, counters.destructions);
+}
+
+TEST(MoveOnlyFunctionTest, DestroysInlineCallables) {
+  auto shared = std::make_shared<int>(0);
+  {
+    MoveOnlyFunction<void()> f = [shared] {};
+    EXPECT_EQ(2, shared.use_count());
+
+    MoveOnlyFunction<void()> g = std::move(f);
+    EXPECT_EQ(2, shared.use_count());
+
+    g = nullptr;
+    EXPECT_FALSE(g);
+    EXPECT_EQ(1, shared.use_count());
+  }
+  EXPECT_EQ(1, shared.use_count());
+}
+
+TEST(MoveOnlyFunctionTest, EmptyStdFunctionIsEmpty) {
+  std::function<void()> empty;
+  MoveOnlyFunction<void()> f = empty;
+  EXPECT_FALSE(f);
+
+  std::function<void()> non_empty = [] {};
+  MoveOnlyFunction<void()> g = non_empty;
+  EXPECT_TRUE(g);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -61,3 +61,72 @@ BENCHMARK(BM_SkipToNextSpecialByte)
     ->Arg(1 << 9)
     ->Arg(1 << 10)
     ->Arg(1 << 15);
+
+// Generates `count` strings of about `len` bytes, the way document keys look:
+// mostly printable, with a special byte in roughly one out of eight strings.
+static std::vector<std::string> MakeKeyLikeStrings(int64_t len, int count) {
+  SecureRandom rnd;
+  std::vector<std::string> values(static_cast<size_t>(count));
+  for (std::string& s : values) {
+    std::generate_n(std::back_inserter(s), len,
+                    [&] { return static_cast<char>(' ' + rnd.Uniform(95)); });
+    if (len > 0 && rnd.OneIn(8)) {
+      s[rnd.Uniform(static_cast<uint32_t>(len))] = rnd.OneIn(2) ? 0 : '\xff';
+    }
+  }
+  return values;
+}
+
+static void BM_WriteString(benchmark::State& state) {
+  const int kValues = 1024;
+  std::vector<std::string> values = MakeKeyLikeStrings(state.range(0), kValues);
+
+  int index = 0;
+  int64_t total_bytes = 0;
+  std::string dest;
+  for (auto _ : state) {
+    const std::string& value = values[index++ % kValues];
+    dest.clear();
+    OrderedCode::WriteString(&dest, value);
+    benchmark::DoNotOptimize(dest.data());
+    total_bytes += static_cast<int64_t>(value.size());
+  }
+  state.SetBytesProcessed(total_bytes);
+}
+BENCHMARK(BM_WriteString)
+    ->Arg(1 << 4)
+    ->Arg(1 << 5)
+    ->Arg(1 << 6)
+    ->Arg(1 << 7)
+    ->Arg(1 << 8)
+    ->Arg(1 << 10);
+
+static void BM_ReadString(benchmark::State& state) {
+  const int kValues = 1024;
+  std::vector<std::string> encoded;
+  for (const std::string& value :
+       MakeKeyLikeStrings(state.range(0), kValues)) {
+    std::string dest;
+    OrderedCode::WriteString(&dest, value);
+    encoded.push_back(std::move(dest));
+  }
+
+  int index = 0;
+  int64_t total_bytes = 0;
+  std::string result;
+  for (auto _ : state) {
+    absl::string_view src{encoded[index++ % kValues]};
+    result.clear();
+    bool ok = OrderedCode::ReadString(&src, &result);
+    benchmark::DoNotOptimize(ok);
+    total_bytes += static_cast<int64_t>(result.size());
+  }
+  state.SetBytesProcessed(total_bytes);
+}
+BENCHMARK(BM_ReadString)
+    ->Arg(1 << 4)
+    ->Arg(1 << 5)
+    ->Arg(1 << 6)
+    ->Arg(1 << 7)
+    ->Arg(1 << 8)
+    ->Arg(1 << 10);
@@ -55,3 +55,20 @@ TEST(SecureRandomTest, OneIn) {
   EXPECT_LT(50, count) << count;
   EXPECT_GT(150, count) << count;
 }
+
+TEST(SecureRandomTest, Fill) {
+  SecureRandom rng;
+  uint8_t buffer[4096] = {};
+  rng.Fill(buffer, sizeof(buffer));
+
+  bool seen[256] = {};
+  for (uint8_t byte : buffer) {
+    seen[byte] = true;
+  }
+  int distinct = 0;
+  for (bool value_seen : seen) {
+    if (value_seen) distinct++;
+  }
+  // Practically, every possible byte value should show up.
+  EXPECT_LT(250, distinct) << distinct;
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/task.h"
+
+#include <functional>
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "Firestore/core/test/firebase/firestore/util/async_tests_util.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+TEST(TaskTest, RunsContinuationWhenValueIsSet) {
+  Promise<int> promise;
+  int result = 0;
+  promise.GetTask().Then([&result](int value) { result = value; });
+  EXPECT_EQ(0, result);
+
+  promise.SetValue(42);
+  EXPECT_EQ(42, result);
+}
+
+TEST(TaskTest, RunsContinuationRightAwayWhenValueIsAlreadySet) {
+  Promise<int> promise;
+  promise.SetValue(42);
+
+  int result = 0;
+  promise.GetTask().Then([&result](int value) { result = value; });
+  EXPECT_EQ(42, result);
+}
+
+TEST(TaskTest, MovesValuesAndBoundStateIntoContinuation) {
+  Promise<std::unique_ptr<int>> promise;
+  auto bound = absl::make_unique<std::string>("bound");
+
+  std::string result;
+  promise.GetTask().Then(std::bind(
+      [&result](const std::unique_ptr<std::string>& bound_string,
+                std::unique_ptr<int> value) {
+        result = *bound_string + std::to_string(*value);
+      },
+      std::move(bound), std::placeholders::_1));
+
+  promise.SetValue(absl::make_unique<int>(7));
+  EXPECT_EQ("bound7", result);
+}
+
+TEST(TaskTest, CopiesOfPromiseSetTheSameTask) {
+  Promise<int> promise;
+  int result = 0;
+  promise.GetTask().Then([&result](int value) { result = value; });
+
+  // Copyable callbacks capture a copy of the promise.
+  std::function<void(int)> callback = [promise](int value) {
+    promise.SetValue(value);
+  };
+  callback(42);
+  EXPECT_EQ(42, result);
+}
+
+TEST(TaskTest, ComposesThroughPromises) {
+  Promise<int> first;
+  Promise<std::string> second;
+  first.GetTask().Then(
+      [second](int value) { second.SetValue(std::to_string(value * 2)); });
+
+  std::string result;
+  second.GetTask().Then([&result](std::string value) { result = value; });
+
+  first.SetValue(21);
+  EXPECT_EQ("42", result);
+}
+
+TEST(TaskTest, EnqueuesContinuationOnQueue) {
+  AsyncQueue queue{absl::make_unique<ExecutorStd>()};
+  Promise<int> promise;
+
+  std::packaged_task<void()> signal_finished{[] {}};
+  int result = 0;
+  promise.GetTask().Then(&queue, [&](int value) {
+    queue.VerifyIsCurrentQueue();
+    result = value;
+    signal_finished();
+  });
+
+  // The value is set on another thread, as credentials providers do.
+  std::thread setter{[promise] { promise.SetValue(42); }};
+  setter.join();
+
+  ABORT_ON_TIMEOUT(signal_finished.get_future());
+  EXPECT_EQ(42, result);
+}
+
+TEST(TaskTest, ExecutesContinuationOnExecutor) {
+  ExecutorStd executor;
+  Promise<int> promise;
+  promise.SetValue(42);
+
+  std::packaged_task<void()> signal_finished{[] {}};
+  int result = 0;
+  promise.GetTask().Then(&executor, [&](int value) {
+    EXPECT_TRUE(executor.IsCurrentExecutor());
+    result = value;
+    signal_finished();
+  });
+
+  ABORT_ON_TIMEOUT(signal_finished.get_future());
+  EXPECT_EQ(42, result);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/trace_span.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+class RecordingExporter : public TraceExporter {
+ public:
+  void Export(const TraceSpanRecord& span) override {
+    names.push_back(span.name);
+    correlation_ids.push_back(span.correlation_id);
+    EXPECT_LE(span.start, span.end);
+  }
+
+  std::vector<std::string> names;
+  std::vector<int64_t> correlation_ids;
+};
+
+class TraceSpanTest : public testing::Test {
+ public:
+  TraceSpanTest() : exporter_{std::make_shared<RecordingExporter>()} {
+    SetTraceExporter(exporter_);
+  }
+
+  ~TraceSpanTest() override {
+    SetTraceExporter(nullptr);
+  }
+
+ protected:
+  std::shared_ptr<RecordingExporter> exporter_;
+};
+
+}  // namespace
+
+TEST_F(TraceSpanTest, MeasuresUntilEnded) {
+  TraceSpan span{"Test"};
+  EXPECT_FALSE(span.ended());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_GE(span.elapsed().count(), 5);
+
+  span.End();
+  EXPECT_TRUE(span.ended());
+  std::chrono::milliseconds duration = span.elapsed();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  span.End();
+  EXPECT_EQ(duration, span.elapsed());
+}
+
+TEST_F(TraceSpanTest, ExportsEachSpanOnce) {
+  {
+    TraceSpan ended{"Ended", 1};
+    ended.End();
+    ended.End();
+
+    TraceSpan destroyed{"Destroyed"};
+    destroyed.set_correlation_id(2);
+  }
+
+  EXPECT_EQ((std::vector<std::string>{"Ended", "Destroyed"}),
+            exporter_->names);
+  EXPECT_EQ((std::vector<int64_t>{1, 2}), exporter_->correlation_ids);
+}
+
+TEST_F(TraceSpanTest, ExportsSpansMeasuredByTheCaller) {
+  TraceSpanRecord record;
+  record.name = "Measured";
+  record.correlation_id = 3;
+  record.start = TraceSpanRecord::Clock::now();
+  record.end = record.start;
+  ExportTraceSpan(record);
+
+  EXPECT_EQ(std::vector<std::string>{"Measured"}, exporter_->names);
+  EXPECT_EQ(std::vector<int64_t>{3}, exporter_->correlation_ids);
+}
+
+TEST_F(TraceSpanTest, DoesNothingWhileDisabled) {
+  SetTraceExporter(nullptr);
+  EXPECT_FALSE(IsTracingEnabled());
+  {
+    TraceSpan span{"Disabled"};
+  }
+  ExportTraceSpan(TraceSpanRecord{});
+  EXPECT_TRUE(exporter_->names.empty());
+
+  SetTraceExporter(exporter_);
+  EXPECT_TRUE(IsTracingEnabled());
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -22,6 +22,15 @@
 
 @implementation FUNContextProviderTests
 
+/** Returns an unsigned JWT that expires `interval` seconds from now. */
+- (NSString *)tokenExpiringIn:(NSTimeInterval)interval {
+  NSDictionary *claims = @{@"exp" : @((long long)[[NSDate date] timeIntervalSince1970] + interval)};
+  NSData *payload = [NSJSONSerialization dataWithJSONObject:claims options:0 error:nil];
+  NSString *encoded = [payload base64EncodedStringWithOptions:0];
+  encoded = [encoded stringByReplacingOccurrencesOfString:@"=" withString:@""];
+  return [NSString stringWithFormat:@"eyJhbGciOiJub25lIn0.%@.signature", encoded];
+}
+
 - (void)testContextWithAuth {
   FIRAuthInteropFake *auth = [[FIRAuthInteropFake alloc] initWithToken:@"token"
                                                                 userID:@"userID"
@@ -56,6 +65,56 @@
   [self waitForExpectations:@[ expectation ] timeout:0.1];
 }
 
+- (void)testConcurrentContextsShareAuthTokenFetch {
+  NSString *token = [self tokenExpiringIn:3600];
+  FIRAuthInteropFake *auth = [[FIRAuthInteropFake alloc] initWithToken:token
+                                                                userID:@"userID"
+                                                                 error:nil];
+  FUNContextProvider *provider = [[FUNContextProvider alloc] initWithAuth:(id<FIRAuthInterop>)auth];
+
+  NSMutableArray<XCTestExpectation *> *expectations = [NSMutableArray array];
+  for (int i = 0; i < 5; i++) {
+    XCTestExpectation *expectation =
+        [self expectationWithDescription:@"Each context should have the auth token."];
+    [expectations addObject:expectation];
+    [provider getContext:^(FUNContext *_Nullable context, NSError *_Nullable error) {
+      XCTAssertNil(error);
+      XCTAssertEqualObjects(context.authToken, token);
+      XCTAssertEqualObjects(context.instanceIDToken, @"iid");
+      [expectation fulfill];
+    }];
+  }
+  [self waitForExpectations:expectations timeout:0.1];
+
+  // The token is still fresh, so later contexts don't fetch it again either.
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Cached token is reused."];
+  [provider getContext:^(FUNContext *_Nullable context, NSError *_Nullable error) {
+    XCTAssertEqualObjects(context.authToken, token);
+    [expectation fulfill];
+  }];
+  [self waitForExpectations:@[ expectation ] timeout:0.1];
+
+  XCTAssertEqual(auth.getTokenCount, 1);
+}
+
+- (void)testContextRefetchesExpiringAuthToken {
+  FIRAuthInteropFake *auth = [[FIRAuthInteropFake alloc] initWithToken:[self tokenExpiringIn:60]
+                                                                userID:@"userID"
+                                                                 error:nil];
+  FUNContextProvider *provider = [[FUNContextProvider alloc] initWithAuth:(id<FIRAuthInterop>)auth];
+
+  for (int i = 0; i < 2; i++) {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Context is returned."];
+    [provider getContext:^(FUNContext *_Nullable context, NSError *_Nullable error) {
+      XCTAssertEqualObjects(context.authToken, auth.token);
+      [expectation fulfill];
+    }];
+    [self waitForExpectations:@[ expectation ] timeout:0.1];
+  }
+
+  XCTAssertEqual(auth.getTokenCount, 2);
+}
+
 - (void)testContextWithoutAuth {
   FUNContextProvider *provider = [[FUNContextProvider alloc] initWithAuth:nil];
   XCTestExpectation *expectation =
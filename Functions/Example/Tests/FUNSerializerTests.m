@@ -219,6 +219,59 @@
   XCTAssertNil(error);
 }
 
+- (void)testDecodeSharesUnchangedContainers {
+  NSArray *unchanged = @[ @1, @"two", @{@"three" : @3} ];
+  NSDictionary *input = @{
+    @"unchanged" : unchanged,
+    @"changed" : @{
+      @"@type" : @"type.googleapis.com/google.protobuf.Int64Value",
+      @"value" : @"9876543210",
+    },
+  };
+  FUNSerializer *serializer = [[FUNSerializer alloc] init];
+  NSError *error = nil;
+  NSDictionary *decoded = [serializer decode:input error:&error];
+  XCTAssertNil(error);
+  XCTAssertEqualObjects(decoded[@"changed"], @9876543210LL);
+  XCTAssertEqual(decoded[@"unchanged"], unchanged);
+  XCTAssertEqual([serializer decode:unchanged error:&error], unchanged);
+}
+
+- (void)testEncodeData {
+  NSData *input = [@"hello" dataUsingEncoding:NSUTF8StringEncoding];
+  NSDictionary *expected = @{
+    @"@type" : @"type.googleapis.com/google.protobuf.BytesValue",
+    @"value" : @"aGVsbG8=",
+  };
+  FUNSerializer *serializer = [[FUNSerializer alloc] init];
+  XCTAssertEqualObjects(expected, [serializer encode:input]);
+}
+
+- (void)testDecodeData {
+  NSDictionary *input = @{
+    @"@type" : @"type.googleapis.com/google.protobuf.BytesValue",
+    @"value" : @"aGVsbG8=",
+  };
+  NSData *expected = [@"hello" dataUsingEncoding:NSUTF8StringEncoding];
+  FUNSerializer *serializer = [[FUNSerializer alloc] init];
+  NSError *error = nil;
+  XCTAssertEqualObjects(expected, [serializer decode:input error:&error]);
+  XCTAssertNil(error);
+}
+
+- (void)testDecodeInvalidData {
+  NSDictionary *input = @{
+    @"@type" : @"type.googleapis.com/google.protobuf.BytesValue",
+    @"value" : @"not base64!",
+  };
+  FUNSerializer *serializer = [[FUNSerializer alloc] init];
+  NSError *error = nil;
+  XCTAssertNil([serializer decode:input error:&error]);
+  XCTAssertNotNil(error);
+  XCTAssertEqualObjects(FIRFunctionsErrorDomain, error.domain);
+  XCTAssertEqual(FIRFunctionsErrorCodeInternal, error.code);
+}
+
 - (void)testDecodeUnknownType {
   NSDictionary *input = @{@"@type" : @"unknown", @"value" : @"whatever"};
   FUNSerializer *serializer = [[FUNSerializer alloc] init];
@@ -95,6 +95,24 @@ NSString *const kFUNDefaultRegion = @"us-central1";
   return @[ internalProvider ];
 }
 
+/**
+ * The network client shared by all FIRFunctions instances. Sharing its session lets calls to
+ * different functions, even through different FIRFunctions instances, reuse the same HTTP/2
+ * connection instead of each setting up its own.
+ */
++ (GTMSessionFetcherService *)sharedFetcherService {
+  static GTMSessionFetcherService *fetcherService;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    fetcherService = [[GTMSessionFetcherService alloc] init];
+    fetcherService.reuseSession = YES;
+    // Requests to the same host are multiplexed over a single connection, so there is no reason
+    // to hold back callables fanned out at the same time.
+    fetcherService.maxRunningFetchersPerHost = 0;
+  });
+  return fetcherService;
+}
+
 + (instancetype)functions {
   return [[self alloc] initWithApp:[FIRApp defaultApp] region:kFUNDefaultRegion];
 }
@@ -125,7 +143,7 @@ NSString *const kFUNDefaultRegion = @"us-central1";
     if (!region) {
       FUNThrowInvalidArgument(@"FIRFunctions region cannot be nil.");
     }
-    _fetcherService = [[GTMSessionFetcherService alloc] init];
+    _fetcherService = [[self class] sharedFetcherService];
     _projectID = [projectID copy];
     _region = [region copy];
     _serializer = [[FUNSerializer alloc] init];
@@ -240,9 +258,6 @@ NSString *const kFUNDefaultRegion = @"us-central1";
           error = FUNErrorForCode(FIRFunctionsErrorCodeDeadlineExceeded);
         }
       }
-    } else {
-      // If there wasn't an HTTP error, see if there was an error in the body.
-      error = FUNErrorForResponse(200, data, serializer);
     }
     // If there was an error, report it to the user and stop.
     if (error) {
@@ -252,7 +267,12 @@ NSString *const kFUNDefaultRegion = @"us-central1";
       return;
     }
 
+    // Parse the body only once, both to look for an error and for the result.
     id responseJSON = [NSJSONSerialization JSONObjectWithData:data options:0 error:&error];
+    if (!error) {
+      // If there wasn't an HTTP error, see if there was an error in the body.
+      error = FUNErrorForResponseJSON(200, responseJSON, serializer);
+    }
     if (error) {
       if (completion) {
         completion(nil, error);
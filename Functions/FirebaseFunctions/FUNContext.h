@@ -31,6 +31,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 /**
  * A FUNContextProvider gathers metadata and creats a FUNContext.
+ *
+ * Auth tokens are cached until shortly before they expire, and concurrent requests for a context
+ * share a single token fetch, so that calling many functions at once doesn't fetch a token for
+ * each call.
  */
 @interface FUNContextProvider : NSObject
 
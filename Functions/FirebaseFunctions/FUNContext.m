@@ -42,9 +42,59 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+typedef void (^FUNAuthTokenCallback)(NSString *_Nullable token, NSError *_Nullable error);
+
+/** How long before it expires a cached auth token is no longer used. */
+static const NSTimeInterval kFUNAuthTokenExpirationMargin = 5 * 60;
+
+/** Returns the expiration date of a JWT, or nil if it can't be parsed. */
+static NSDate *_Nullable FUNExpirationDateOfToken(NSString *token) {
+  NSArray<NSString *> *parts = [token componentsSeparatedByString:@"."];
+  if (parts.count != 3) {
+    return nil;
+  }
+
+  // The payload is base64url encoded without padding.
+  NSMutableString *payload = [parts[1] mutableCopy];
+  [payload replaceOccurrencesOfString:@"-"
+                           withString:@"+"
+                              options:0
+                                range:NSMakeRange(0, payload.length)];
+  [payload replaceOccurrencesOfString:@"_"
+                           withString:@"/"
+                              options:0
+                                range:NSMakeRange(0, payload.length)];
+  while (payload.length % 4 != 0) {
+    [payload appendString:@"="];
+  }
+
+  NSData *data = [[NSData alloc] initWithBase64EncodedString:payload options:0];
+  if (!data) {
+    return nil;
+  }
+  id claims = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+  if (![claims isKindOfClass:[NSDictionary class]]) {
+    return nil;
+  }
+  id expiration = claims[@"exp"];
+  if (![expiration isKindOfClass:[NSNumber class]]) {
+    return nil;
+  }
+  return [NSDate dateWithTimeIntervalSince1970:[expiration doubleValue]];
+}
+
 @interface FUNContextProvider () {
   id<FIRAuthInterop> _auth;
   FUNInstanceIDProxy *_instanceIDProxy;
+
+  // Serializes access to the cached auth token and the pending callbacks.
+  dispatch_queue_t _authTokenQueue;
+  NSString *_Nullable _cachedAuthToken;
+  NSString *_Nullable _cachedAuthTokenUserID;
+  NSDate *_Nullable _cachedAuthTokenExpiration;
+
+  // The callbacks waiting for the auth token being fetched, or nil if no fetch is in flight.
+  NSMutableArray<FUNAuthTokenCallback> *_Nullable _pendingAuthTokenCallbacks;
 }
 @end
 
@@ -55,6 +105,8 @@ NS_ASSUME_NONNULL_BEGIN
   if (self) {
     _auth = auth;
     _instanceIDProxy = [[FUNInstanceIDProxy alloc] init];
+    _authTokenQueue =
+        dispatch_queue_create("com.google.firebase.functions.FUNContextProvider", NULL);
   }
   return self;
 }
@@ -75,21 +127,84 @@ NS_ASSUME_NONNULL_BEGIN
     return;
   }
 
-  // Auth exists, get the auth token.
-  [_auth getTokenForcingRefresh:NO
-                   withCallback:^(NSString *_Nullable token, NSError *_Nullable error) {
-                     if (error) {
-                       completion(nil, error);
-                       return;
-                     }
-
-                     // Get the instance id token.
-                     NSString *_Nullable instanceIDToken = [self instanceIDToken];
-
-                     FUNContext *context = [[FUNContext alloc] initWithAuthToken:token
-                                                                 instanceIDToken:instanceIDToken];
-                     completion(context, nil);
-                   }];
+  // Auth exists. Look up the instance ID token while the auth token is being fetched.
+  dispatch_group_t group = dispatch_group_create();
+  dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+
+  __block NSString *_Nullable instanceIDToken;
+  dispatch_group_async(group, queue, ^{
+    instanceIDToken = [self instanceIDToken];
+  });
+
+  __block NSString *_Nullable authToken;
+  __block NSError *_Nullable authError;
+  dispatch_group_enter(group);
+  [self getAuthToken:^(NSString *_Nullable token, NSError *_Nullable error) {
+    authToken = token;
+    authError = error;
+    dispatch_group_leave(group);
+  }];
+
+  dispatch_group_notify(group, queue, ^{
+    if (authError) {
+      completion(nil, authError);
+      return;
+    }
+    FUNContext *context = [[FUNContext alloc] initWithAuthToken:authToken
+                                                instanceIDToken:instanceIDToken];
+    completion(context, nil);
+  });
+}
+
+/**
+ * Calls `callback` with a cached auth token that is still valid for the current user, or fetches
+ * one. Callbacks that arrive while a fetch is in flight wait for its result.
+ */
+- (void)getAuthToken:(FUNAuthTokenCallback)callback {
+  dispatch_async(_authTokenQueue, ^{
+    NSString *_Nullable userID = [self->_auth getUserID];
+    NSDate *freshUntil = [NSDate dateWithTimeIntervalSinceNow:kFUNAuthTokenExpirationMargin];
+    if (self->_cachedAuthToken && userID &&
+        [userID isEqualToString:self->_cachedAuthTokenUserID] &&
+        [self->_cachedAuthTokenExpiration compare:freshUntil] == NSOrderedDescending) {
+      callback(self->_cachedAuthToken, nil);
+      return;
+    }
+
+    if (self->_pendingAuthTokenCallbacks) {
+      [self->_pendingAuthTokenCallbacks addObject:callback];
+      return;
+    }
+    self->_pendingAuthTokenCallbacks = [NSMutableArray arrayWithObject:callback];
+
+    [self->_auth
+        getTokenForcingRefresh:NO
+                  withCallback:^(NSString *_Nullable token, NSError *_Nullable error) {
+                    dispatch_async(self->_authTokenQueue, ^{
+                      [self finishAuthTokenFetchWithToken:token userID:userID error:error];
+                    });
+                  }];
+  });
+}
+
+- (void)finishAuthTokenFetchWithToken:(nullable NSString *)token
+                               userID:(nullable NSString *)userID
+                                error:(nullable NSError *)error {
+  if (token && !error) {
+    _cachedAuthToken = [token copy];
+    _cachedAuthTokenUserID = [userID copy];
+    _cachedAuthTokenExpiration = FUNExpirationDateOfToken(token);
+  } else {
+    _cachedAuthToken = nil;
+    _cachedAuthTokenUserID = nil;
+    _cachedAuthTokenExpiration = nil;
+  }
+
+  NSArray<FUNAuthTokenCallback> *callbacks = _pendingAuthTokenCallbacks;
+  _pendingAuthTokenCallbacks = nil;
+  for (FUNAuthTokenCallback callback in callbacks) {
+    callback(token, error);
+  }
 }
 
 @end
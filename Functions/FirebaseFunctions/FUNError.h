@@ -41,4 +41,15 @@ NSError *_Nullable FUNErrorForResponse(NSInteger status,
                                        NSData *_Nullable body,
                                        FUNSerializer *serializer);
 
+/**
+ * Like FUNErrorForResponse, but takes a body that has already been parsed from JSON.
+ * @param status An HTTP status code.
+ * @param json Optional parsed JSON body of the HTTP response.
+ * @param serializer A serializer to use to decode the details in the error response.
+ * @return The corresponding error.
+ */
+NSError *_Nullable FUNErrorForResponseJSON(NSInteger status,
+                                           id _Nullable json,
+                                           FUNSerializer *serializer);
+
 NS_ASSUME_NONNULL_END
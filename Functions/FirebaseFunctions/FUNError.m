@@ -144,37 +144,43 @@ NSError *_Nullable FUNErrorForCode(FIRFunctionsErrorCode code) {
 NSError *_Nullable FUNErrorForResponse(NSInteger status,
                                        NSData *_Nullable body,
                                        FUNSerializer *serializer) {
+  id json = nil;
+  if (body) {
+    json = [NSJSONSerialization JSONObjectWithData:body options:0 error:NULL];
+  }
+  return FUNErrorForResponseJSON(status, json, serializer);
+}
+
+NSError *_Nullable FUNErrorForResponseJSON(NSInteger status,
+                                           id _Nullable json,
+                                           FUNSerializer *serializer) {
   // Start with reasonable defaults from the status code.
   FIRFunctionsErrorCode code = FIRFunctionsErrorCodeForHTTPStatus(status);
   NSString *description = FUNDescriptionForErrorCode(code);
   id details = nil;
 
   // Then look through the body for explicit details.
-  if (body) {
-    NSError *parseError = nil;
-    id json = [NSJSONSerialization JSONObjectWithData:body options:0 error:&parseError];
-    if (!parseError && [json isKindOfClass:[NSDictionary class]]) {
-      id errorDetails = json[@"error"];
-      if ([errorDetails isKindOfClass:[NSDictionary class]]) {
-        if ([errorDetails[@"status"] isKindOfClass:[NSString class]]) {
-          NSNumber *codeNumber = FIRFunctionsErrorCodeForName(errorDetails[@"status"]);
-          if (!codeNumber) {
-            // If the code in the body is invalid, treat the whole response as malformed.
-            return FUNErrorForCode(FIRFunctionsErrorCodeInternal);
-          }
-          code = codeNumber.intValue;
-          // The default description needs to be updated for the new code.
-          description = FUNDescriptionForErrorCode(code);
-        }
-        if ([errorDetails[@"message"] isKindOfClass:[NSString class]]) {
-          description = (NSString *)errorDetails[@"message"];
-        }
-        details = errorDetails[@"details"];
-        if (details) {
-          NSError *decodeError = nil;
-          details = [serializer decode:details error:&decodeError];
-          // Just ignore the details if there an error decoding them.
+  if ([json isKindOfClass:[NSDictionary class]]) {
+    id errorDetails = json[@"error"];
+    if ([errorDetails isKindOfClass:[NSDictionary class]]) {
+      if ([errorDetails[@"status"] isKindOfClass:[NSString class]]) {
+        NSNumber *codeNumber = FIRFunctionsErrorCodeForName(errorDetails[@"status"]);
+        if (!codeNumber) {
+          // If the code in the body is invalid, treat the whole response as malformed.
+          return FUNErrorForCode(FIRFunctionsErrorCodeInternal);
         }
+        code = codeNumber.intValue;
+        // The default description needs to be updated for the new code.
+        description = FUNDescriptionForErrorCode(code);
+      }
+      if ([errorDetails[@"message"] isKindOfClass:[NSString class]]) {
+        description = (NSString *)errorDetails[@"message"];
+      }
+      details = errorDetails[@"details"];
+      if (details) {
+        NSError *decodeError = nil;
+        details = [serializer decode:details error:&decodeError];
+        // Just ignore the details if there an error decoding them.
       }
     }
   }
@@ -22,6 +22,7 @@ NS_ASSUME_NONNULL_BEGIN
 static NSString *const kLongType = @"type.googleapis.com/google.protobuf.Int64Value";
 static NSString *const kUnsignedLongType = @"type.googleapis.com/google.protobuf.UInt64Value";
 static NSString *const kDateType = @"type.googleapis.com/google.protobuf.Timestamp";
+static NSString *const kBytesType = @"type.googleapis.com/google.protobuf.BytesValue";
 
 @interface FUNSerializer () {
   NSDateFormatter *_dateFormatter;
@@ -103,6 +104,12 @@ static NSString *const kDateType = @"type.googleapis.com/google.protobuf.Timesta
   if ([object isKindOfClass:[NSString class]]) {
     return object;
   }
+  if ([object isKindOfClass:[NSData class]]) {
+    return @{
+      @"@type" : kBytesType,
+      @"value" : [object base64EncodedStringWithOptions:0],
+    };
+  }
   if ([object isKindOfClass:[NSDictionary class]]) {
     NSMutableDictionary *encoded = [NSMutableDictionary dictionary];
     [object
@@ -142,6 +149,16 @@ NSError *FUNInvalidNumberError(id value, id wrapped) {
                          userInfo:userInfo];
 }
 
+NSError *FUNInvalidBytesError(id value, id wrapped) {
+  NSString *description = [NSString stringWithFormat:@"Invalid bytes: %@ for %@", value, wrapped];
+  NSDictionary *userInfo = @{
+    NSLocalizedDescriptionKey : description,
+  };
+  return [NSError errorWithDomain:FIRFunctionsErrorDomain
+                             code:FIRFunctionsErrorCodeInternal
+                         userInfo:userInfo];
+}
+
 - (id)decodeWrappedType:(NSDictionary *)wrapped error:(NSError **)error {
   NSAssert(error, @"error must not be nil");
   NSString *type = wrapped[@"@type"];
@@ -173,6 +190,13 @@ NSError *FUNInvalidNumberError(id value, id wrapped) {
       return nil;
     }
     return @(n);
+  } else if ([type isEqualToString:kBytesType]) {
+    NSData *data = [[NSData alloc] initWithBase64EncodedString:value options:0];
+    if (data == nil) {
+      *error = FUNInvalidBytesError(value, wrapped);
+      return nil;
+    }
+    return data;
   }
   return nil;
 }
@@ -190,7 +214,9 @@ NSError *FUNInvalidNumberError(id value, id wrapped) {
       }
       // Treat unknown types as dictionaries, so we don't crash old clients when we add types.
     }
-    NSMutableDictionary *decoded = [NSMutableDictionary dictionary];
+    // Containers are only copied if decoding changes any of their values, so that the decoded
+    // result shares everything else with the parsed JSON rather than duplicating it.
+    __block NSMutableDictionary *decoded = nil;
     __block NSError *decodeError = nil;
     [object
         enumerateKeysAndObjectsUsingBlock:^(id _Nonnull key, id _Nonnull obj, BOOL *_Nonnull stop) {
@@ -199,24 +225,32 @@ NSError *FUNInvalidNumberError(id value, id wrapped) {
             *stop = YES;
             return;
           }
+          if (decodedItem != obj && !decoded) {
+            decoded = [object mutableCopy];
+          }
           decoded[key] = decodedItem;
         }];
     if (decodeError) {
       *error = decodeError;
       return nil;
     }
-    return decoded;
+    return decoded ?: object;
   }
   if ([object isKindOfClass:[NSArray class]]) {
-    NSMutableArray *result = [NSMutableArray arrayWithCapacity:[object count]];
-    for (id obj in object) {
-      id decoded = [self decode:obj error:error];
+    NSMutableArray *decoded = nil;
+    NSUInteger count = [object count];
+    for (NSUInteger i = 0; i < count; i++) {
+      id obj = object[i];
+      id decodedItem = [self decode:obj error:error];
       if (*error) {
         return nil;
       }
-      [result addObject:decoded];
+      if (decodedItem != obj && !decoded) {
+        decoded = [object mutableCopy];
+      }
+      decoded[i] = decodedItem;
     }
-    return result;
+    return decoded ?: object;
   }
   if ([object isKindOfClass:[NSNumber class]] || [object isKindOfClass:[NSString class]] ||
       [object isEqual:[NSNull null]]) {
@@ -67,6 +67,7 @@ NS_SWIFT_NAME(HTTPSCallable)
  * * NSNull
  * * NSString
  * * NSNumber
+ * * NSData, which is sent as a wrapped google.protobuf.BytesValue with base64 encoded contents.
  * * NSArray<id>, where the contained objects are also one of these types.
  * * NSDictionary<NSString, id>, where the values are also one of these types.
  *
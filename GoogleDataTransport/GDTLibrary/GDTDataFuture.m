@@ -24,9 +24,14 @@
 }
 
 - (instancetype)initWithFileURL:(NSURL *)fileURL {
+  return [self initWithFileURL:fileURL range:NSMakeRange(NSNotFound, 0)];
+}
+
+- (instancetype)initWithFileURL:(NSURL *)fileURL range:(NSRange)range {
   self = [super init];
   if (self) {
     _fileURL = fileURL;
+    _fileRange = range;
   }
   return self;
 }
@@ -35,6 +40,7 @@
   self = [super init];
   if (self) {
     _originalData = data;
+    _fileRange = NSMakeRange(NSNotFound, 0);
   }
   return self;
 }
@@ -43,7 +49,25 @@
   if (_fileURL) {
     NSAssert([[NSFileManager defaultManager] fileExistsAtPath:_fileURL.path isDirectory:NULL],
              @"A file should exist for this future at the given URL: %@", _fileURL);
-    return [NSData dataWithContentsOfURL:_fileURL];
+    // Map the file rather than read it, so that the bytes are paged in as they're used and can be
+    // evicted again under memory pressure.
+    NSData *fileData = [NSData dataWithContentsOfURL:_fileURL
+                                             options:NSDataReadingMappedIfSafe
+                                               error:nil];
+    if (_fileRange.location == NSNotFound || !fileData) {
+      return fileData;
+    }
+    if (NSMaxRange(_fileRange) > fileData.length) {
+      return nil;
+    }
+    // Point into the mapping instead of copying the range out of it. The deallocator keeps the
+    // mapping alive for as long as the returned data.
+    const uint8_t *bytes = (const uint8_t *)fileData.bytes + _fileRange.location;
+    return [[NSData alloc] initWithBytesNoCopy:(void *)bytes
+                                        length:_fileRange.length
+                                   deallocator:^(void *deallocatedBytes, NSUInteger length) {
+                                     (void)fileData;
+                                   }];
   } else if (_originalData) {
     return _originalData;
   }
@@ -56,7 +80,7 @@
 
 - (NSUInteger)hash {
   // In reality, only one of these should be populated.
-  return [_fileURL hash] ^ [_originalData hash];
+  return [_fileURL hash] ^ [_originalData hash] ^ _fileRange.location ^ (_fileRange.length << 16);
 }
 
 #pragma mark - NSSecureCoding
@@ -67,6 +91,9 @@ static NSString *kGDTDataFutureFileURLKey = @"GDTDataFutureFileURLKey";
 /** Coding key for _data ivar. */
 static NSString *kGDTDataFutureDataKey = @"GDTDataFutureDataKey";
 
+/** Coding key for _fileRange ivar. */
+static NSString *kGDTDataFutureFileRangeKey = @"GDTDataFutureFileRangeKey";
+
 + (BOOL)supportsSecureCoding {
   return YES;
 }
@@ -74,6 +101,9 @@ static NSString *kGDTDataFutureDataKey = @"GDTDataFutureDataKey";
 - (void)encodeWithCoder:(nonnull NSCoder *)aCoder {
   [aCoder encodeObject:_fileURL forKey:kGDTDataFutureFileURLKey];
   [aCoder encodeObject:_originalData forKey:kGDTDataFutureDataKey];
+  if (_fileRange.location != NSNotFound) {
+    [aCoder encodeObject:[NSValue valueWithRange:_fileRange] forKey:kGDTDataFutureFileRangeKey];
+  }
 }
 
 - (nullable instancetype)initWithCoder:(nonnull NSCoder *)aDecoder {
@@ -81,6 +111,9 @@ static NSString *kGDTDataFutureDataKey = @"GDTDataFutureDataKey";
   if (self) {
     _fileURL = [aDecoder decodeObjectOfClass:[NSURL class] forKey:kGDTDataFutureFileURLKey];
     _originalData = [aDecoder decodeObjectOfClass:[NSData class] forKey:kGDTDataFutureDataKey];
+    NSValue *fileRange = [aDecoder decodeObjectOfClass:[NSValue class]
+                                                forKey:kGDTDataFutureFileRangeKey];
+    _fileRange = fileRange ? [fileRange rangeValue] : NSMakeRange(NSNotFound, 0);
   }
   return self;
 }
@@ -49,7 +49,7 @@
   // This loses some precision, but it's probably fine.
   NSUInteger mappingIDHash = [_mappingID hash];
   NSUInteger timeHash = [_clockSnapshot hash];
-  NSUInteger dataObjectTransportBytesHash = [_dataObjectTransportBytes hash];
+  NSUInteger dataObjectTransportBytesHash = [self.dataObjectTransportBytes hash];
   return mappingIDHash ^ _target ^ dataObjectTransportBytesHash ^ _qosTier ^ timeHash;
 }
 
@@ -58,15 +58,21 @@
 }
 
 - (void)setDataObject:(id<GDTEventDataObject>)dataObject {
-  // If you're looking here because of a performance issue in -transportBytes slowing the assignment
-  // of -dataObject, one way to address this is to add a queue to this class,
-  // dispatch_(barrier_ if concurrent)async here, and implement the getter with a dispatch_sync.
+  // The data object is serialized on first use of -dataObjectTransportBytes, which GDTTransformer
+  // does off the thread the event was sent from.
   if (dataObject != _dataObject) {
     _dataObject = dataObject;
-    _dataObjectTransportBytes = [dataObject transportBytes];
+    _dataObjectTransportBytes = nil;
   }
 }
 
+- (NSData *)dataObjectTransportBytes {
+  if (!_dataObjectTransportBytes && _dataObject) {
+    _dataObjectTransportBytes = [_dataObject transportBytes];
+  }
+  return _dataObjectTransportBytes;
+}
+
 - (GDTStoredEvent *)storedEventWithDataFuture:(GDTDataFuture *)dataFuture {
   return [[GDTStoredEvent alloc] initWithEvent:self dataFuture:dataFuture];
 }
@@ -108,7 +114,7 @@ static NSString *clockSnapshotKey = @"_clockSnapshot";
 - (void)encodeWithCoder:(NSCoder *)aCoder {
   [aCoder encodeObject:_mappingID forKey:mappingIDKey];
   [aCoder encodeInteger:_target forKey:targetKey];
-  [aCoder encodeObject:_dataObjectTransportBytes forKey:dataObjectTransportBytesKey];
+  [aCoder encodeObject:self.dataObjectTransportBytes forKey:dataObjectTransportBytesKey];
   [aCoder encodeInteger:_qosTier forKey:qosTierKey];
   [aCoder encodeObject:_clockSnapshot forKey:clockSnapshotKey];
 }
@@ -18,13 +18,17 @@
 
 #import "GDTLibrary/Private/GDTRegistrar_Private.h"
 
-@implementation GDTRegistrar {
-  /** Backing ivar for targetToUploader property. */
-  NSMutableDictionary<NSNumber *, id<GDTUploader>> *_targetToUploader;
+@interface GDTRegistrar ()
 
-  /** Backing ivar for targetToPrioritizer property. */
-  NSMutableDictionary<NSNumber *, id<GDTPrioritizer>> *_targetToPrioritizer;
-}
+// Redeclared as readwrite. The maps are replaced rather than mutated, so that readers can use them
+// without going through the registrar queue.
+@property(atomic, readwrite, copy) NSDictionary<NSNumber *, id<GDTUploader>> *targetToUploader;
+@property(atomic, readwrite, copy)
+    NSDictionary<NSNumber *, id<GDTPrioritizer>> *targetToPrioritizer;
+
+@end
+
+@implementation GDTRegistrar
 
 + (instancetype)sharedInstance {
   static GDTRegistrar *sharedInstance;
@@ -39,64 +43,39 @@
   self = [super init];
   if (self) {
     _registrarQueue = dispatch_queue_create("com.google.GDTRegistrar", DISPATCH_QUEUE_CONCURRENT);
-    _targetToPrioritizer = [[NSMutableDictionary alloc] init];
-    _targetToUploader = [[NSMutableDictionary alloc] init];
+    _targetToPrioritizer = @{};
+    _targetToUploader = @{};
   }
   return self;
 }
 
 - (void)registerUploader:(id<GDTUploader>)backend target:(GDTTarget)target {
-  __weak GDTRegistrar *weakSelf = self;
-  dispatch_barrier_async(_registrarQueue, ^{
-    GDTRegistrar *strongSelf = weakSelf;
-    if (strongSelf) {
-      strongSelf->_targetToUploader[@(target)] = backend;
-    }
+  // Registration is rare, so copying the map is cheaper than synchronizing every lookup.
+  dispatch_barrier_sync(_registrarQueue, ^{
+    NSMutableDictionary<NSNumber *, id<GDTUploader>> *targetToUploader =
+        [self.targetToUploader mutableCopy];
+    targetToUploader[@(target)] = backend;
+    self.targetToUploader = targetToUploader;
   });
 }
 
 - (void)registerPrioritizer:(id<GDTPrioritizer>)prioritizer target:(GDTTarget)target {
-  __weak GDTRegistrar *weakSelf = self;
-  dispatch_barrier_async(_registrarQueue, ^{
-    GDTRegistrar *strongSelf = weakSelf;
-    if (strongSelf) {
-      strongSelf->_targetToPrioritizer[@(target)] = prioritizer;
-    }
-  });
-}
-
-- (NSMutableDictionary<NSNumber *, id<GDTUploader>> *)targetToUploader {
-  __block NSMutableDictionary<NSNumber *, id<GDTUploader>> *targetToUploader;
-  __weak GDTRegistrar *weakSelf = self;
-  dispatch_sync(_registrarQueue, ^{
-    GDTRegistrar *strongSelf = weakSelf;
-    if (strongSelf) {
-      targetToUploader = strongSelf->_targetToUploader;
-    }
-  });
-  return targetToUploader;
-}
-
-- (NSMutableDictionary<NSNumber *, id<GDTPrioritizer>> *)targetToPrioritizer {
-  __block NSMutableDictionary<NSNumber *, id<GDTPrioritizer>> *targetToPrioritizer;
-  __weak GDTRegistrar *weakSelf = self;
-  dispatch_sync(_registrarQueue, ^{
-    GDTRegistrar *strongSelf = weakSelf;
-    if (strongSelf) {
-      targetToPrioritizer = strongSelf->_targetToPrioritizer;
-    }
+  dispatch_barrier_sync(_registrarQueue, ^{
+    NSMutableDictionary<NSNumber *, id<GDTPrioritizer>> *targetToPrioritizer =
+        [self.targetToPrioritizer mutableCopy];
+    targetToPrioritizer[@(target)] = prioritizer;
+    self.targetToPrioritizer = targetToPrioritizer;
   });
-  return targetToPrioritizer;
 }
 
 #pragma mark - GDTLifecycleProtocol
 
 - (void)appWillBackground:(nonnull UIApplication *)app {
   dispatch_async(_registrarQueue, ^{
-    for (id<GDTUploader> uploader in [self->_targetToUploader allValues]) {
+    for (id<GDTUploader> uploader in [self.targetToUploader allValues]) {
       [uploader appWillBackground:app];
     }
-    for (id<GDTPrioritizer> prioritizer in [self->_targetToPrioritizer allValues]) {
+    for (id<GDTPrioritizer> prioritizer in [self.targetToPrioritizer allValues]) {
       [prioritizer appWillBackground:app];
     }
   });
@@ -104,10 +83,10 @@
 
 - (void)appWillForeground:(nonnull UIApplication *)app {
   dispatch_async(_registrarQueue, ^{
-    for (id<GDTUploader> uploader in [self->_targetToUploader allValues]) {
+    for (id<GDTUploader> uploader in [self.targetToUploader allValues]) {
       [uploader appWillForeground:app];
     }
-    for (id<GDTPrioritizer> prioritizer in [self->_targetToPrioritizer allValues]) {
+    for (id<GDTPrioritizer> prioritizer in [self.targetToPrioritizer allValues]) {
       [prioritizer appWillForeground:app];
     }
   });
@@ -115,10 +94,10 @@
 
 - (void)appWillTerminate:(nonnull UIApplication *)app {
   dispatch_sync(_registrarQueue, ^{
-    for (id<GDTUploader> uploader in [self->_targetToUploader allValues]) {
+    for (id<GDTUploader> uploader in [self.targetToUploader allValues]) {
       [uploader appWillTerminate:app];
     }
-    for (id<GDTPrioritizer> prioritizer in [self->_targetToPrioritizer allValues]) {
+    for (id<GDTPrioritizer> prioritizer in [self.targetToPrioritizer allValues]) {
       [prioritizer appWillTerminate:app];
     }
   });
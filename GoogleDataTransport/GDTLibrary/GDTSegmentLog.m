@@ -0,0 +1,479 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "GDTLibrary/Private/GDTSegmentLog.h"
+
+#import <GoogleDataTransport/GDTStoredEvent.h>
+
+#import "GDTLibrary/Private/GDTConsoleLogger.h"
+#import "GDTLibrary/Private/GDTEvent_Private.h"
+
+/** The file name of the index. */
+static NSString *const kGDTSegmentLogIndexFileName = @"index";
+
+/** The prefix of the file names of segments, followed by the segment ID. */
+static NSString *const kGDTSegmentLogSegmentFilePrefix = @"segment-";
+
+/** The number of tombstones the index may hold before it is rewritten without them, as long as
+ * there are more live events than tombstones.
+ */
+static const NSUInteger kGDTSegmentLogMaxTombstones = 256;
+
+/** The types of the records of the index. */
+typedef NS_ENUM(uint32_t, GDTSegmentLogRecordType) {
+  /** An event was appended to a segment. */
+  GDTSegmentLogRecordTypeEvent = 1,
+
+  /** The event of an earlier record was removed. */
+  GDTSegmentLogRecordTypeTombstone = 2,
+};
+
+/** The fixed-size part of a record of the index. An event record is followed by metadataLength
+ * bytes of the archived GDTStoredEvent.
+ */
+typedef struct {
+  uint32_t type;
+  uint32_t segmentID;
+  uint64_t offset;
+  uint32_t length;
+  int32_t target;
+  int32_t qosTier;
+  uint32_t metadataLength;
+} GDTSegmentLogRecord;
+
+/** An event that is stored and not removed. */
+@interface GDTSegmentLogEntry : NSObject
+
+/** The record the event was stored with. */
+@property(nonatomic) GDTSegmentLogRecord record;
+
+/** The archived stored event. */
+@property(nonatomic) NSData *metadata;
+
+/** The stored event. */
+@property(nonatomic) GDTStoredEvent *storedEvent;
+
+@end
+
+@implementation GDTSegmentLogEntry
+@end
+
+@implementation GDTSegmentLog {
+  /** The directory of the segment and index files. */
+  NSString *_directory;
+
+  /** The size after which events are appended to a new segment. */
+  NSUInteger _maxSegmentSize;
+
+  /** The handle the index is appended to. */
+  NSFileHandle *_indexHandle;
+
+  /** The handle the current segment is appended to, or nil if it hasn't been created yet. */
+  NSFileHandle *_segmentHandle;
+
+  /** The ID of the segment events are appended to. */
+  uint32_t _segmentID;
+
+  /** The size of the segment events are appended to. */
+  uint64_t _segmentSize;
+
+  /** The events that are stored and not removed, keyed by their segment ID and offset. */
+  NSMutableDictionary<NSString *, GDTSegmentLogEntry *> *_entries;
+
+  /** The number of events that are stored and not removed, by segment ID. */
+  NSMutableDictionary<NSNumber *, NSNumber *> *_liveEventCounts;
+
+  /** The number of tombstones in the index. */
+  NSUInteger _tombstoneCount;
+}
+
+- (instancetype)initWithDirectory:(NSString *)directory maxSegmentSize:(NSUInteger)maxSegmentSize {
+  self = [super init];
+  if (self) {
+    _directory = [directory stringByStandardizingPath];
+    _maxSegmentSize = maxSegmentSize;
+    _entries = [[NSMutableDictionary alloc] init];
+    _liveEventCounts = [[NSMutableDictionary alloc] init];
+
+    NSError *error;
+    if (![[NSFileManager defaultManager] createDirectoryAtPath:_directory
+                                   withIntermediateDirectories:YES
+                                                    attributes:nil
+                                                         error:&error]) {
+      GDTLogError(GDTMCEDirectoryCreationError, @"Error creating the directory: %@", error);
+    }
+    uint32_t lastSegmentID = [self replayIndex];
+    lastSegmentID = MAX(lastSegmentID, [self deleteUnusedSegments]);
+    // Never append to an existing segment, it may end in an incomplete write.
+    _segmentID = lastSegmentID + 1;
+    _indexHandle = [self fileHandleForAppendingToPath:[self indexPath]];
+
+    NSArray<GDTSegmentLogEntry *> *entries = [self sortedEntries];
+    NSMutableArray<GDTStoredEvent *> *restoredEvents =
+        [[NSMutableArray alloc] initWithCapacity:entries.count];
+    for (GDTSegmentLogEntry *entry in entries) {
+      [restoredEvents addObject:entry.storedEvent];
+    }
+    _restoredEvents = restoredEvents;
+  }
+  return self;
+}
+
+- (GDTStoredEvent *)appendEvent:(GDTEvent *)event {
+  NSData *bytes = event.dataObjectTransportBytes;
+  if (_segmentHandle && _segmentSize > 0 && _segmentSize + bytes.length > _maxSegmentSize) {
+    [self closeSegment];
+    _segmentID++;
+  }
+  if (!_segmentHandle) {
+    _segmentHandle = [self fileHandleForAppendingToPath:[self pathForSegment:_segmentID]];
+    _segmentSize = 0;
+    if (!_segmentHandle) {
+      return nil;
+    }
+  }
+
+  uint64_t offset = _segmentSize;
+  if (![self writeData:bytes toFileHandle:_segmentHandle]) {
+    return nil;
+  }
+  _segmentSize += bytes.length;
+
+  NSURL *segmentURL = [NSURL fileURLWithPath:[self pathForSegment:_segmentID]];
+  GDTDataFuture *dataFuture =
+      [[GDTDataFuture alloc] initWithFileURL:segmentURL
+                                       range:NSMakeRange((NSUInteger)offset, bytes.length)];
+  GDTStoredEvent *storedEvent = [event storedEventWithDataFuture:dataFuture];
+
+  GDTSegmentLogEntry *entry = [[GDTSegmentLogEntry alloc] init];
+  entry.metadata = [NSKeyedArchiver archivedDataWithRootObject:storedEvent];
+  entry.storedEvent = storedEvent;
+  entry.record = (GDTSegmentLogRecord){
+      .type = GDTSegmentLogRecordTypeEvent,
+      .segmentID = _segmentID,
+      .offset = offset,
+      .length = (uint32_t)bytes.length,
+      .target = (int32_t)event.target,
+      .qosTier = (int32_t)event.qosTier,
+      .metadataLength = (uint32_t)entry.metadata.length,
+  };
+
+  NSMutableData *indexData = [self dataForEntry:entry];
+  if (![self writeData:indexData toFileHandle:_indexHandle]) {
+    return nil;
+  }
+  [self addEntry:entry];
+  return storedEvent;
+}
+
+- (void)removeEvents:(NSSet<GDTStoredEvent *> *)events {
+  NSMutableData *tombstones = [[NSMutableData alloc] init];
+  NSMutableSet<NSNumber *> *emptySegmentIDs = [[NSMutableSet alloc] init];
+  for (GDTStoredEvent *event in events) {
+    NSString *key = [self keyForDataFuture:event.dataFuture];
+    GDTSegmentLogEntry *entry = key ? _entries[key] : nil;
+    if (!entry) {
+      continue;
+    }
+    GDTSegmentLogRecord tombstone = entry.record;
+    tombstone.type = GDTSegmentLogRecordTypeTombstone;
+    tombstone.metadataLength = 0;
+    [tombstones appendBytes:&tombstone length:sizeof(tombstone)];
+    if ([self removeEntryForKey:key]) {
+      [emptySegmentIDs addObject:@(tombstone.segmentID)];
+    }
+  }
+  if (tombstones.length == 0) {
+    return;
+  }
+  [self writeData:tombstones toFileHandle:_indexHandle];
+  _tombstoneCount += tombstones.length / sizeof(GDTSegmentLogRecord);
+
+  // Segments are only appended to, so one whose events have all been removed is done with.
+  for (NSNumber *segmentID in emptySegmentIDs) {
+    if (segmentID.unsignedIntValue == _segmentID) {
+      [self closeSegment];
+      _segmentID++;
+    } else {
+      [self deleteSegment:segmentID.unsignedIntValue];
+    }
+  }
+
+  BOOL mostlyTombstones =
+      _tombstoneCount > kGDTSegmentLogMaxTombstones && _tombstoneCount > _entries.count;
+  if (_entries.count == 0 || mostlyTombstones) {
+    [self rewriteIndex];
+  }
+}
+
+- (void)checkpoint {
+  if (_tombstoneCount > 0) {
+    [self rewriteIndex];
+  }
+  @try {
+    [_segmentHandle synchronizeFile];
+    [_indexHandle synchronizeFile];
+  } @catch (NSException *exception) {
+    GDTLogError(GDTMCEFileWriteError, @"The storage log could not be synchronized: %@", exception);
+  }
+}
+
+- (void)removeAllEvents {
+  [self closeSegment];
+  [_indexHandle closeFile];
+  [[NSFileManager defaultManager] removeItemAtPath:_directory error:nil];
+  [[NSFileManager defaultManager] createDirectoryAtPath:_directory
+                            withIntermediateDirectories:YES
+                                             attributes:nil
+                                                  error:nil];
+  [_entries removeAllObjects];
+  [_liveEventCounts removeAllObjects];
+  _tombstoneCount = 0;
+  _segmentID++;
+  _indexHandle = [self fileHandleForAppendingToPath:[self indexPath]];
+}
+
+- (NSString *)indexPath {
+  return [_directory stringByAppendingPathComponent:kGDTSegmentLogIndexFileName];
+}
+
+#pragma mark - Private helper methods
+
+/** Returns the path of a segment.
+ *
+ * @param segmentID The ID of the segment.
+ * @return The path of the segment file.
+ */
+- (NSString *)pathForSegment:(uint32_t)segmentID {
+  NSString *fileName =
+      [NSString stringWithFormat:@"%@%u", kGDTSegmentLogSegmentFilePrefix, segmentID];
+  return [_directory stringByAppendingPathComponent:fileName];
+}
+
+/** Returns the key of an entry in _entries. */
+- (NSString *)keyForSegment:(uint32_t)segmentID offset:(uint64_t)offset {
+  return [NSString stringWithFormat:@"%u:%llu", segmentID, offset];
+}
+
+/** Returns the key of the entry whose bytes the data future reads, or nil if it doesn't read from
+ * a segment of this log.
+ */
+- (NSString *)keyForDataFuture:(GDTDataFuture *)dataFuture {
+  NSURL *fileURL = dataFuture.fileURL;
+  if (!fileURL || dataFuture.fileRange.location == NSNotFound ||
+      ![[fileURL.path.stringByDeletingLastPathComponent stringByStandardizingPath]
+          isEqualToString:_directory]) {
+    return nil;
+  }
+  NSString *fileName = fileURL.lastPathComponent;
+  if (![fileName hasPrefix:kGDTSegmentLogSegmentFilePrefix]) {
+    return nil;
+  }
+  NSInteger segmentID =
+      [[fileName substringFromIndex:kGDTSegmentLogSegmentFilePrefix.length] integerValue];
+  return [self keyForSegment:(uint32_t)segmentID offset:dataFuture.fileRange.location];
+}
+
+/** Opens a file for appending, creating it if it doesn't exist. */
+- (NSFileHandle *)fileHandleForAppendingToPath:(NSString *)path {
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  if (![fileManager fileExistsAtPath:path] &&
+      ![fileManager createFileAtPath:path contents:nil attributes:nil]) {
+    GDTLogError(GDTMCEFileWriteError, @"A storage file could not be created: %@", path);
+    return nil;
+  }
+  NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:path];
+  [fileHandle seekToEndOfFile];
+  return fileHandle;
+}
+
+/** Appends data to a file, returning NO if it couldn't be written. */
+- (BOOL)writeData:(NSData *)data toFileHandle:(NSFileHandle *)fileHandle {
+  if (!fileHandle) {
+    return NO;
+  }
+  @try {
+    [fileHandle writeData:data];
+  } @catch (NSException *exception) {
+    GDTLogError(GDTMCEFileWriteError, @"A storage file could not be written: %@", exception);
+    return NO;
+  }
+  return YES;
+}
+
+/** Returns the bytes of the index record of an entry. */
+- (NSMutableData *)dataForEntry:(GDTSegmentLogEntry *)entry {
+  GDTSegmentLogRecord record = entry.record;
+  NSMutableData *data =
+      [[NSMutableData alloc] initWithCapacity:sizeof(record) + entry.metadata.length];
+  [data appendBytes:&record length:sizeof(record)];
+  [data appendData:entry.metadata];
+  return data;
+}
+
+/** Tracks an event that is stored and not removed. */
+- (void)addEntry:(GDTSegmentLogEntry *)entry {
+  GDTSegmentLogRecord record = entry.record;
+  _entries[[self keyForSegment:record.segmentID offset:record.offset]] = entry;
+  NSNumber *segmentID = @(record.segmentID);
+  _liveEventCounts[segmentID] = @(_liveEventCounts[segmentID].unsignedIntegerValue + 1);
+}
+
+/** Stops tracking an event, returning YES if it was the last one of its segment. */
+- (BOOL)removeEntryForKey:(NSString *)key {
+  GDTSegmentLogEntry *entry = _entries[key];
+  if (!entry) {
+    return NO;
+  }
+  [_entries removeObjectForKey:key];
+  NSNumber *segmentID = @(entry.record.segmentID);
+  NSUInteger count = _liveEventCounts[segmentID].unsignedIntegerValue - 1;
+  if (count > 0) {
+    _liveEventCounts[segmentID] = @(count);
+    return NO;
+  }
+  [_liveEventCounts removeObjectForKey:segmentID];
+  return YES;
+}
+
+/** Returns the tracked events in the order they were stored. */
+- (NSArray<GDTSegmentLogEntry *> *)sortedEntries {
+  return [_entries.allValues sortedArrayUsingComparator:^NSComparisonResult(
+                                GDTSegmentLogEntry *left, GDTSegmentLogEntry *right) {
+    if (left.record.segmentID != right.record.segmentID) {
+      return left.record.segmentID < right.record.segmentID ? NSOrderedAscending
+                                                            : NSOrderedDescending;
+    }
+    if (left.record.offset != right.record.offset) {
+      return left.record.offset < right.record.offset ? NSOrderedAscending : NSOrderedDescending;
+    }
+    return NSOrderedSame;
+  }];
+}
+
+/** Reads the index into _entries, truncating an incomplete record at its end.
+ *
+ * @return The highest segment ID the index refers to.
+ */
+- (uint32_t)replayIndex {
+  NSData *index = [NSData dataWithContentsOfFile:[self indexPath]
+                                         options:NSDataReadingMappedIfSafe
+                                           error:nil];
+  const uint8_t *bytes = index.bytes;
+  NSUInteger position = 0;
+  uint32_t lastSegmentID = 0;
+  while (position + sizeof(GDTSegmentLogRecord) <= index.length) {
+    GDTSegmentLogRecord record;
+    memcpy(&record, bytes + position, sizeof(record));
+    NSUInteger recordLength = sizeof(record) + record.metadataLength;
+    if (position + recordLength > index.length) {
+      break;
+    }
+    lastSegmentID = MAX(lastSegmentID, record.segmentID);
+    NSString *key = [self keyForSegment:record.segmentID offset:record.offset];
+    if (record.type == GDTSegmentLogRecordTypeEvent) {
+      GDTSegmentLogEntry *entry = [[GDTSegmentLogEntry alloc] init];
+      entry.record = record;
+      entry.metadata = [index subdataWithRange:NSMakeRange(position + sizeof(record),
+                                                           record.metadataLength)];
+      @try {
+        entry.storedEvent = [NSKeyedUnarchiver unarchiveObjectWithData:entry.metadata];
+      } @catch (NSException *exception) {
+        entry.storedEvent = nil;
+      }
+      if ([entry.storedEvent isKindOfClass:[GDTStoredEvent class]]) {
+        [self addEntry:entry];
+      } else {
+        GDTLogWarning(GDTMCWStorageLogRecordUnreadable, @"Dropping an unreadable event: %@",
+                      key);
+      }
+    } else {
+      [self removeEntryForKey:key];
+      _tombstoneCount++;
+    }
+    position += recordLength;
+  }
+
+  if (position < index.length) {
+    GDTLogWarning(GDTMCWStorageLogRecordUnreadable, @"Truncating the storage index at %lu",
+                  (unsigned long)position);
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:[self indexPath]];
+    [fileHandle truncateFileAtOffset:position];
+    [fileHandle closeFile];
+  }
+  return lastSegmentID;
+}
+
+/** Deletes the segments that hold no stored events.
+ *
+ * @return The highest segment ID found in the directory.
+ */
+- (uint32_t)deleteUnusedSegments {
+  uint32_t lastSegmentID = 0;
+  NSArray<NSString *> *fileNames =
+      [[NSFileManager defaultManager] contentsOfDirectoryAtPath:_directory error:nil];
+  for (NSString *fileName in fileNames) {
+    if (![fileName hasPrefix:kGDTSegmentLogSegmentFilePrefix]) {
+      continue;
+    }
+    uint32_t segmentID = (uint32_t)[[fileName
+        substringFromIndex:kGDTSegmentLogSegmentFilePrefix.length] longLongValue];
+    lastSegmentID = MAX(lastSegmentID, segmentID);
+    if (!_liveEventCounts[@(segmentID)]) {
+      [self deleteSegment:segmentID];
+    }
+  }
+  return lastSegmentID;
+}
+
+/** Deletes the file of a segment. */
+- (void)deleteSegment:(uint32_t)segmentID {
+  NSError *error;
+  NSString *path = [self pathForSegment:segmentID];
+  if (![[NSFileManager defaultManager] removeItemAtPath:path error:&error]) {
+    GDTLogWarning(GDTMCWFileRemovalFailed, @"A storage segment could not be removed: %@", error);
+  }
+}
+
+/** Closes the current segment, deleting it if all of its events have been removed. */
+- (void)closeSegment {
+  if (!_segmentHandle) {
+    return;
+  }
+  [_segmentHandle closeFile];
+  _segmentHandle = nil;
+  if (!_liveEventCounts[@(_segmentID)]) {
+    [self deleteSegment:_segmentID];
+  }
+}
+
+/** Replaces the index with one that only holds the records of the tracked events. */
+- (void)rewriteIndex {
+  NSMutableData *index = [[NSMutableData alloc] init];
+  for (GDTSegmentLogEntry *entry in [self sortedEntries]) {
+    [index appendData:[self dataForEntry:entry]];
+  }
+  NSError *error;
+  [_indexHandle closeFile];
+  if (![index writeToFile:[self indexPath] options:NSDataWritingAtomic error:&error]) {
+    GDTLogError(GDTMCEFileWriteError, @"The storage index could not be rewritten: %@", error);
+  } else {
+    _tombstoneCount = 0;
+  }
+  _indexHandle = [self fileHandleForAppendingToPath:[self indexPath]];
+}
+
+@end
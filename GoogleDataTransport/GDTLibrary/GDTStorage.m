@@ -25,6 +25,7 @@
 #import "GDTLibrary/Private/GDTConsoleLogger.h"
 #import "GDTLibrary/Private/GDTEvent_Private.h"
 #import "GDTLibrary/Private/GDTRegistrar_Private.h"
+#import "GDTLibrary/Private/GDTSegmentLog.h"
 #import "GDTLibrary/Private/GDTUploadCoordinator.h"
 
 /** Creates and/or returns a singleton NSString that is the shared storage path.
@@ -42,6 +43,42 @@ static NSString *GDTStoragePath() {
   return storagePath;
 }
 
+/** The size after which events are appended to a new segment of the storage log. */
+static const NSUInteger kGDTStorageMaxSegmentSize = 1024 * 1024;
+
+/** The NSKeyedCoder key for the storedEvents property. */
+static NSString *const kGDTStorageStoredEventsKey = @"GDTStorageStoredEventsKey";
+
+/** The NSKeyedCoder key for the targetToEventSet property. */
+static NSString *const kGDTStorageTargetToEventSetKey = @"GDTStorageTargetToEventSetKey";
+
+/** Decodes the stored events of an archive of the singleton without touching the singleton, whose
+ * -initWithCoder: can't be used while restoring it on the storage queue.
+ */
+@interface GDTStorageLegacyArchive : NSObject <NSCoding>
+
+/** The events of the archive. */
+@property(nonatomic) NSOrderedSet<GDTStoredEvent *> *storedEvents;
+
+@end
+
+@implementation GDTStorageLegacyArchive
+
+- (instancetype)initWithCoder:(NSCoder *)aDecoder {
+  self = [super init];
+  if (self) {
+    _storedEvents = [aDecoder decodeObjectOfClass:[NSOrderedSet class]
+                                           forKey:kGDTStorageStoredEventsKey];
+  }
+  return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)aCoder {
+  [aCoder encodeObject:_storedEvents forKey:kGDTStorageStoredEventsKey];
+}
+
+@end
+
 @implementation GDTStorage
 
 + (NSString *)archivePath {
@@ -69,13 +106,20 @@ static NSString *GDTStoragePath() {
     _targetToEventSet = [[NSMutableDictionary alloc] init];
     _storedEvents = [[NSMutableOrderedSet alloc] init];
     _uploader = [GDTUploadCoordinator sharedInstance];
+    dispatch_async(_storageQueue, ^{
+      NSString *logPath = [GDTStoragePath() stringByAppendingPathComponent:@"segments"];
+      self->_segmentLog = [[GDTSegmentLog alloc] initWithDirectory:logPath
+                                                    maxSegmentSize:kGDTStorageMaxSegmentSize];
+      for (GDTStoredEvent *storedEvent in self->_segmentLog.restoredEvents) {
+        [self addEventToTrackingCollections:storedEvent];
+      }
+      [self restoreLegacyArchive];
+    });
   }
   return self;
 }
 
 - (void)storeEvent:(GDTEvent *)event {
-  [self createEventDirectoryIfNotExists];
-
   __block UIBackgroundTaskIdentifier bgID = UIBackgroundTaskInvalid;
   if (_runningInBackground) {
     bgID = [[UIApplication sharedApplication] beginBackgroundTaskWithExpirationHandler:^{
@@ -91,12 +135,15 @@ static NSString *GDTStoragePath() {
     id<GDTPrioritizer> prioritizer = [GDTRegistrar sharedInstance].targetToPrioritizer[@(target)];
     GDTAssert(prioritizer, @"There's no prioritizer registered for the given target.");
 
-    // Write the transport bytes to disk, get a filename.
+    // Append the transport bytes to the log, which also records the event.
     GDTAssert(event.dataObjectTransportBytes, @"The event should have been serialized to bytes");
-    NSURL *eventFile = [self saveEventBytesToDisk:event.dataObjectTransportBytes
-                                        eventHash:event.hash];
-    GDTDataFuture *dataFuture = [[GDTDataFuture alloc] initWithFileURL:eventFile];
-    GDTStoredEvent *storedEvent = [event storedEventWithDataFuture:dataFuture];
+    GDTStoredEvent *storedEvent = [self.segmentLog appendEvent:event];
+    if (!storedEvent) {
+      if (bgID != UIBackgroundTaskInvalid) {
+        [[UIApplication sharedApplication] endBackgroundTask:bgID];
+      }
+      return;
+    }
 
     // Add event to tracking collections.
     [self addEventToTrackingCollections:storedEvent];
@@ -109,9 +156,9 @@ static NSString *GDTStoragePath() {
       [self.uploader forceUploadForTarget:target];
     }
 
-    // If running in the background, save state to disk and end the associated background task.
+    // If running in the background, end the associated background task. The log already holds
+    // everything needed to restore the event.
     if (bgID != UIBackgroundTaskInvalid) {
-      [NSKeyedArchiver archiveRootObject:self toFile:[GDTStorage archivePath]];
       [[UIApplication sharedApplication] endBackgroundTask:bgID];
     }
   });
@@ -126,15 +173,19 @@ static NSString *GDTStoragePath() {
   [prioritizer unprioritizeEvents:events];
 
   dispatch_async(_storageQueue, ^{
+    // Remove from disk, first and foremost.
+    [self.segmentLog removeEvents:eventsToRemove];
+
     for (GDTStoredEvent *event in eventsToRemove) {
-      // Remove from disk, first and foremost.
-      NSError *error;
-      if (event.dataFuture.fileURL) {
-        NSURL *fileURL = event.dataFuture.fileURL;
+      GDTAssert([GDTRegistrar sharedInstance].targetToPrioritizer[event.target] == prioritizer,
+                @"All logs within an upload set should have the same prioritizer.");
+
+      // Events stored before the log was introduced have a file each.
+      NSURL *fileURL = event.dataFuture.fileURL;
+      if (fileURL && event.dataFuture.fileRange.location == NSNotFound) {
+        NSError *error;
         [[NSFileManager defaultManager] removeItemAtURL:fileURL error:&error];
         GDTAssert(error == nil, @"There was an error removing an event file: %@", error);
-        GDTAssert([GDTRegistrar sharedInstance].targetToPrioritizer[event.target] == prioritizer,
-                  @"All logs within an upload set should have the same prioritizer.");
       }
 
       // Remove from the tracking collections.
@@ -146,43 +197,6 @@ static NSString *GDTStoragePath() {
 
 #pragma mark - Private helper methods
 
-/** Creates the storage directory if it does not exist. */
-- (void)createEventDirectoryIfNotExists {
-  NSError *error;
-  BOOL result = [[NSFileManager defaultManager] createDirectoryAtPath:GDTStoragePath()
-                                          withIntermediateDirectories:YES
-                                                           attributes:0
-                                                                error:&error];
-  if (!result || error) {
-    GDTLogError(GDTMCEDirectoryCreationError, @"Error creating the directory: %@", error);
-  }
-}
-
-/** Saves the event's dataObjectTransportBytes to a file using NSData mechanisms.
- *
- * @note This method should only be called from a method within a block on _storageQueue to maintain
- * thread safety.
- *
- * @param transportBytes The transport bytes of the event.
- * @param eventHash The hash value of the event.
- * @return The filename
- */
-- (NSURL *)saveEventBytesToDisk:(NSData *)transportBytes eventHash:(NSUInteger)eventHash {
-  NSString *storagePath = GDTStoragePath();
-  NSString *event = [NSString stringWithFormat:@"event-%lu", (unsigned long)eventHash];
-  NSURL *eventFilePath = [NSURL fileURLWithPath:[storagePath stringByAppendingPathComponent:event]];
-
-  GDTAssert(![[NSFileManager defaultManager] fileExistsAtPath:eventFilePath.path],
-            @"An event shouldn't already exist at this path: %@", eventFilePath.path);
-
-  BOOL writingSuccess = [transportBytes writeToURL:eventFilePath atomically:YES];
-  if (!writingSuccess) {
-    GDTLogError(GDTMCEFileWriteError, @"An event file could not be written: %@", eventFilePath);
-  }
-
-  return eventFilePath;
-}
-
 /** Adds the event to internal tracking collections.
  *
  * @note This method should only be called from a method within a block on _storageQueue to maintain
@@ -198,37 +212,69 @@ static NSString *GDTStoragePath() {
   _targetToEventSet[event.target] = events;
 }
 
+/** Tracks the events of an archive written before the segment log was introduced, and deletes
+ * the archive. Those events each have a file of their own.
+ *
+ * @note This method should only be called from a method within a block on _storageQueue to maintain
+ * thread safety.
+ */
+- (void)restoreLegacyArchive {
+  NSString *archivePath = [GDTStorage archivePath];
+  NSData *archiveData = [NSData dataWithContentsOfFile:archivePath];
+  if (!archiveData) {
+    return;
+  }
+  NSKeyedUnarchiver *unarchiver = [[NSKeyedUnarchiver alloc] initForReadingWithData:archiveData];
+  [unarchiver setClass:[GDTStorageLegacyArchive class]
+          forClassName:NSStringFromClass([GDTStorage class])];
+  GDTStorageLegacyArchive *archive;
+  @try {
+    archive = [unarchiver decodeObjectForKey:NSKeyedArchiveRootObjectKey];
+  } @catch (NSException *exception) {
+    archive = nil;
+  }
+  [unarchiver finishDecoding];
+  if ([archive isKindOfClass:[GDTStorageLegacyArchive class]]) {
+    for (GDTStoredEvent *storedEvent in archive.storedEvents) {
+      if (![_storedEvents containsObject:storedEvent]) {
+        [self addEventToTrackingCollections:storedEvent];
+      }
+    }
+  }
+  NSError *error;
+  if (![[NSFileManager defaultManager] removeItemAtPath:archivePath error:&error]) {
+    GDTLogWarning(GDTMCWFileRemovalFailed, @"The storage archive could not be removed: %@", error);
+  }
+}
+
 #pragma mark - GDTLifecycleProtocol
 
 - (void)appWillForeground:(UIApplication *)app {
-  [NSKeyedUnarchiver unarchiveObjectWithFile:[GDTStorage archivePath]];
+  // The tracking collections are kept in memory while in the background, nothing to restore.
   self->_runningInBackground = NO;
 }
 
 - (void)appWillBackground:(UIApplication *)app {
   self->_runningInBackground = YES;
-  [NSKeyedArchiver archiveRootObject:self toFile:[GDTStorage archivePath]];
-  // Create an immediate background task to run until the end of the current queue of work.
+  // Create an immediate background task to run until the end of the current queue of work. The
+  // log already holds every stored event, so only its pending writes need to reach the disk.
   __block UIBackgroundTaskIdentifier bgID = [app beginBackgroundTaskWithExpirationHandler:^{
     [app endBackgroundTask:bgID];
   }];
   dispatch_async(_storageQueue, ^{
+    [self.segmentLog checkpoint];
     [app endBackgroundTask:bgID];
   });
 }
 
 - (void)appWillTerminate:(UIApplication *)application {
-  [NSKeyedArchiver archiveRootObject:self toFile:[GDTStorage archivePath]];
+  dispatch_sync(_storageQueue, ^{
+    [self.segmentLog checkpoint];
+  });
 }
 
 #pragma mark - NSSecureCoding
 
-/** The NSKeyedCoder key for the storedEvents property. */
-static NSString *const kGDTStorageStoredEventsKey = @"GDTStorageStoredEventsKey";
-
-/** The NSKeyedCoder key for the targetToEventSet property. */
-static NSString *const kGDTStorageTargetToEventSetKey = @"GDTStorageTargetToEventSetKey";
-
 + (BOOL)supportsSecureCoding {
   return YES;
 }
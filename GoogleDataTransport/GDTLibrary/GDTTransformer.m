@@ -22,9 +22,59 @@
 
 #import "GDTLibrary/Private/GDTAssert.h"
 #import "GDTLibrary/Private/GDTConsoleLogger.h"
+#import "GDTLibrary/Private/GDTEvent_Private.h"
 #import "GDTLibrary/Private/GDTStorage.h"
 
-@implementation GDTTransformer
+/** The most events that may wait to be transformed. Beyond that, the events of the lowest QoS tier
+ * are dropped, so that logging faster than events can be stored doesn't grow memory unbounded.
+ */
+static const NSUInteger kGDTTransformerMaxPendingEvents = 1000;
+
+/** Returns how important it is to keep events of a QoS tier when the pending events overflow.
+ *
+ * @param qosTier The QoS tier.
+ * @return The rank of the tier. Events of the lowest rank are dropped first.
+ */
+static NSInteger GDTTransformerRetentionRank(GDTEventQoS qosTier) {
+  switch (qosTier) {
+    case GDTEventQoSFast:
+      return 5;
+    case GDTEventQosDefault:
+      return 4;
+    case GDTEventQoSWifiOnly:
+      return 3;
+    case GDTEventQoSDaily:
+      return 2;
+    case GDTEventQoSTelemetry:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+/** An event waiting to be transformed, along with the transformers to apply to it. */
+@interface GDTTransformerPendingEvent : NSObject
+
+/** The event to transform. */
+@property(nonatomic) GDTEvent *event;
+
+/** The transformers to apply. */
+@property(nullable, nonatomic) NSArray<id<GDTEventTransformer>> *transformers;
+
+@end
+
+@implementation GDTTransformerPendingEvent
+@end
+
+@implementation GDTTransformer {
+  /** The events waiting to be transformed, oldest first. Guarded by @synchronized(self). */
+  NSMutableArray<GDTTransformerPendingEvent *> *_pendingEvents;
+
+  /** YES if a block that transforms the pending events is on _eventWritingQueue and hasn't
+   * started yet. Guarded by @synchronized(self).
+   */
+  BOOL _drainScheduled;
+}
 
 + (instancetype)sharedInstance {
   static GDTTransformer *eventTransformer;
@@ -39,7 +89,10 @@
   self = [super init];
   if (self) {
     _eventWritingQueue = dispatch_queue_create("com.google.GDTTransformer", DISPATCH_QUEUE_SERIAL);
+    _serializationQueue =
+        dispatch_queue_create("com.google.GDTTransformer.serialization", DISPATCH_QUEUE_CONCURRENT);
     _storageInstance = [GDTStorage sharedInstance];
+    _pendingEvents = [[NSMutableArray alloc] init];
   }
   return self;
 }
@@ -48,6 +101,63 @@
       withTransformers:(NSArray<id<GDTEventTransformer>> *)transformers {
   GDTAssert(event, @"You can't write a nil event");
 
+  // Only queue the event here, so that the calling thread can return right away.
+  GDTTransformerPendingEvent *pendingEvent = [[GDTTransformerPendingEvent alloc] init];
+  pendingEvent.event = event;
+  pendingEvent.transformers = transformers;
+  GDTEvent *droppedEvent;
+  BOOL scheduleDrain;
+  @synchronized(self) {
+    if (_pendingEvents.count >= kGDTTransformerMaxPendingEvents) {
+      droppedEvent = [self dropPendingEventToMakeRoomFor:event];
+    }
+    if (droppedEvent != event) {
+      [_pendingEvents addObject:pendingEvent];
+    }
+    scheduleDrain = !_drainScheduled;
+    _drainScheduled = YES;
+  }
+  if (droppedEvent) {
+    GDTLogWarning(GDTMCWEventDropped, @"Too many events are pending, dropping an event of %@",
+                  droppedEvent.mappingID);
+  }
+  if (scheduleDrain) {
+    [self scheduleDrain];
+  }
+}
+
+#pragma mark - Private helper methods
+
+/** Removes the oldest pending event of the lowest QoS tier, unless the new event is of a lower
+ * tier.
+ *
+ * @note This method should only be called while synchronized on self.
+ *
+ * @param event The event that is about to be added.
+ * @return The event that should be dropped, which may be the new event.
+ */
+- (GDTEvent *)dropPendingEventToMakeRoomFor:(GDTEvent *)event {
+  NSInteger lowestRank = GDTTransformerRetentionRank(event.qosTier);
+  NSUInteger lowestIndex = NSNotFound;
+  for (NSUInteger i = 0; i < _pendingEvents.count; i++) {
+    NSInteger rank = GDTTransformerRetentionRank(_pendingEvents[i].event.qosTier);
+    if (rank < lowestRank) {
+      lowestRank = rank;
+      lowestIndex = i;
+    }
+  }
+  if (lowestIndex == NSNotFound) {
+    return event;
+  }
+  GDTEvent *droppedEvent = _pendingEvents[lowestIndex].event;
+  [_pendingEvents removeObjectAtIndex:lowestIndex];
+  return droppedEvent;
+}
+
+/** Enqueues a block that transforms and stores all the events pending when it runs. Events that
+ * are sent while a drain is scheduled are batched into it.
+ */
+- (void)scheduleDrain {
   __block UIBackgroundTaskIdentifier bgID = UIBackgroundTaskInvalid;
   if (_runningInBackground) {
     bgID = [[UIApplication sharedApplication] beginBackgroundTaskWithExpirationHandler:^{
@@ -55,26 +165,83 @@
     }];
   }
   dispatch_async(_eventWritingQueue, ^{
-    GDTEvent *transformedEvent = event;
-    for (id<GDTEventTransformer> transformer in transformers) {
-      if ([transformer respondsToSelector:@selector(transform:)]) {
-        transformedEvent = [transformer transform:transformedEvent];
-        if (!transformedEvent) {
-          return;
-        }
-      } else {
-        GDTLogError(GDTMCETransformerDoesntImplementTransform,
-                    @"Transformer doesn't implement transform: %@", transformer);
-        return;
-      }
+    NSArray<GDTTransformerPendingEvent *> *pendingEvents;
+    @synchronized(self) {
+      pendingEvents = self->_pendingEvents;
+      self->_pendingEvents = [[NSMutableArray alloc] init];
+      self->_drainScheduled = NO;
     }
-    [self.storageInstance storeEvent:transformedEvent];
-    if (self->_runningInBackground) {
+    [self transformAndStorePendingEvents:pendingEvents];
+    if (bgID != UIBackgroundTaskInvalid) {
       [[UIApplication sharedApplication] endBackgroundTask:bgID];
     }
   });
 }
 
+/** Transforms a batch of events, serializes their data objects and stores them.
+ *
+ * @note This method should only be called from a block on _eventWritingQueue.
+ *
+ * @param pendingEvents The events to transform, oldest first.
+ */
+- (void)transformAndStorePendingEvents:(NSArray<GDTTransformerPendingEvent *> *)pendingEvents {
+  // Transformers may hold state, so they're only ever run on this serial queue.
+  NSMutableDictionary<NSNumber *, NSMutableArray<GDTEvent *> *> *targetToEvents =
+      [[NSMutableDictionary alloc] init];
+  NSMutableArray<GDTEvent *> *transformedEvents =
+      [[NSMutableArray alloc] initWithCapacity:pendingEvents.count];
+  for (GDTTransformerPendingEvent *pendingEvent in pendingEvents) {
+    GDTEvent *transformedEvent = [self applyTransformers:pendingEvent.transformers
+                                                 toEvent:pendingEvent.event];
+    if (!transformedEvent) {
+      continue;
+    }
+    [transformedEvents addObject:transformedEvent];
+    NSMutableArray<GDTEvent *> *events = targetToEvents[@(transformedEvent.target)];
+    if (!events) {
+      events = [[NSMutableArray alloc] init];
+      targetToEvents[@(transformedEvent.target)] = events;
+    }
+    [events addObject:transformedEvent];
+  }
+
+  // Serializing a data object only involves the event, so the batch is spread over the cores.
+  dispatch_apply(transformedEvents.count, _serializationQueue, ^(size_t i) {
+    (void)transformedEvents[i].dataObjectTransportBytes;
+  });
+
+  // Keep the events of a target together, so that storage and prioritizers see them in a row.
+  for (NSNumber *target in targetToEvents) {
+    for (GDTEvent *event in targetToEvents[target]) {
+      [self.storageInstance storeEvent:event];
+    }
+  }
+}
+
+/** Applies transformers to an event.
+ *
+ * @param transformers The transformers to apply, in order.
+ * @param event The event to transform.
+ * @return The transformed event, or nil if a transformer dropped it.
+ */
+- (nullable GDTEvent *)applyTransformers:(nullable NSArray<id<GDTEventTransformer>> *)transformers
+                                 toEvent:(GDTEvent *)event {
+  GDTEvent *transformedEvent = event;
+  for (id<GDTEventTransformer> transformer in transformers) {
+    if ([transformer respondsToSelector:@selector(transform:)]) {
+      transformedEvent = [transformer transform:transformedEvent];
+      if (!transformedEvent) {
+        return nil;
+      }
+    } else {
+      GDTLogError(GDTMCETransformerDoesntImplementTransform,
+                  @"Transformer doesn't implement transform: %@", transformer);
+      return nil;
+    }
+  }
+  return transformedEvent;
+}
+
 #pragma mark - GDTLifecycleProtocol
 
 - (void)appWillForeground:(UIApplication *)app {
@@ -24,8 +24,23 @@
 #import "GDTLibrary/Private/GDTReachability.h"
 #import "GDTLibrary/Private/GDTRegistrar_Private.h"
 #import "GDTLibrary/Private/GDTStorage.h"
+#import "GDTLibrary/Private/GDTStorage_Private.h"
 #import "GDTLibrary/Private/GDTUploadPackage_Private.h"
 
+/** The multiple of _timerInterval the timer waits for while there's no network. */
+static const uint64_t kGDTNoNetworkTimerIntervalMultiplier = 10;
+
+/** The multiple of _timerInterval the timer waits for on mobile data, unless the backlog is large.
+ * Waking the cellular radio up is expensive, so small backlogs are left to accumulate.
+ */
+static const uint64_t kGDTMobileDataTimerIntervalMultiplier = 10;
+
+/** The multiple of _timerInterval the timer never waits longer than. */
+static const uint64_t kGDTMaxTimerIntervalMultiplier = 30;
+
+/** The number of stored events from which uploads on mobile data happen every _timerInterval. */
+static const NSUInteger kGDTLargeBacklogEventCount = 100;
+
 @implementation GDTUploadCoordinator
 
 + (instancetype)sharedInstance {
@@ -122,6 +137,10 @@
         NSNumber *targetNumber = @(target);
         if (error) {
           GDTLogWarning(GDTMCWUploadFailed, @"Error during upload: %@", error);
+          // Respect the backoff of the uploader before retrying.
+          if (nextUploadAttemptUTC) {
+            self->_targetToNextUploadTimes[targetNumber] = nextUploadAttemptUTC;
+          }
           [self->_targetToInFlightEventSet removeObjectForKey:targetNumber];
           return;
         }
@@ -184,12 +203,11 @@
     }
 
     GDTUploadConditions conds = [self uploadConditions];
+    [self scheduleNextCheckWithConditions:conds];
     if ((conds & GDTUploadConditionNoNetwork) == GDTUploadConditionNoNetwork) {
       return;
     }
 
-    static int count = 0;
-    count++;
     NSArray<NSNumber *> *targetsReadyForUpload = [self targetsReadyForUpload];
     for (NSNumber *target in targetsReadyForUpload) {
       id<GDTPrioritizer> prioritizer = self->_registrar.targetToPrioritizer[target];
@@ -205,6 +223,63 @@
   });
 }
 
+/** Reschedules the timer according to the backlog, the network and the next upload times of the
+ * targets, so that the device isn't woken up to check for uploads that can't or needn't happen.
+ *
+ * @note This should only be called on the coordination queue.
+ * @param conditions The current upload conditions.
+ */
+- (void)scheduleNextCheckWithConditions:(GDTUploadConditions)conditions {
+  if (!_timer) {
+    return;
+  }
+  uint64_t interval = _timerInterval;
+  if ((conditions & GDTUploadConditionNoNetwork) == GDTUploadConditionNoNetwork) {
+    interval = _timerInterval * kGDTNoNetworkTimerIntervalMultiplier;
+  } else if ((conditions & GDTUploadConditionWifiData) != GDTUploadConditionWifiData &&
+             [self numberOfStoredEvents] < kGDTLargeBacklogEventCount) {
+    interval = _timerInterval * kGDTMobileDataTimerIntervalMultiplier;
+  }
+  interval = MAX(interval, [self timeUntilNextAllowedUpload]);
+  interval = MIN(interval, _timerInterval * kGDTMaxTimerIntervalMultiplier);
+
+  // Give libdispatch more leeway for longer intervals, so that it can coalesce wake-ups.
+  uint64_t leeway = MAX(_timerLeeway, interval / 10);
+  dispatch_source_set_timer(_timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)interval), interval,
+                            leeway);
+}
+
+/** Returns the number of events waiting in storage.
+ *
+ * @return The number of stored events.
+ */
+- (NSUInteger)numberOfStoredEvents {
+  __block NSUInteger count = 0;
+  GDTStorage *storage = self.storage;
+  dispatch_sync(storage.storageQueue, ^{
+    count = storage.storedEvents.count;
+  });
+  return count;
+}
+
+/** Returns the time until the first target that isn't in flight is allowed to upload again.
+ *
+ * @return The time in nanoseconds, or 0 if a target may upload now.
+ */
+- (uint64_t)timeUntilNextAllowedUpload {
+  int64_t currentTimeMillis = [GDTClock snapshot].timeMillis;
+  int64_t minWaitMillis = INT64_MAX;
+  for (NSNumber *target in self.registrar.targetToPrioritizer) {
+    if (_targetToInFlightEventSet[target]) {
+      continue;
+    }
+    GDTClock *nextUploadTime = _targetToNextUploadTimes[target];
+    int64_t waitMillis = nextUploadTime ? nextUploadTime.timeMillis - currentTimeMillis : 0;
+    minWaitMillis = MIN(minWaitMillis, MAX(waitMillis, (int64_t)0));
+  }
+  return minWaitMillis == INT64_MAX ? 0 : (uint64_t)minWaitMillis * NSEC_PER_MSEC;
+}
+
 /** Returns the current upload conditions after making determinations about the network connection.
  *
  * @return The current upload conditions.
@@ -34,6 +34,15 @@ typedef NS_ENUM(NSInteger, GDTMessageCode) {
   /** For warning messages concerning a forced event upload. */
   GDTMCWForcedUpload = 3,
 
+  /** For warning messages concerning an unreadable or truncated record in the storage log. */
+  GDTMCWStorageLogRecordUnreadable = 4,
+
+  /** For warning messages concerning a storage file that could not be removed. */
+  GDTMCWFileRemovalFailed = 5,
+
+  /** For warning messages concerning an event dropped because too many events were pending. */
+  GDTMCWEventDropped = 6,
+
   /** For error messages concerning transform: not being implemented by an event transformer. */
   GDTMCETransformerDoesntImplementTransform = 1000,
 
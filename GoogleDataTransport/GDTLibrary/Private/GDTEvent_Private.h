@@ -22,7 +22,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface GDTEvent ()
 
-/** The serialized bytes of the event data object. */
+/** The serialized bytes of the event data object, computed from dataObject on first use. */
 @property(nonatomic) NSData *dataObjectTransportBytes;
 
 @end
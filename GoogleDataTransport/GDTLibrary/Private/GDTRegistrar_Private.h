@@ -23,12 +23,16 @@ NS_ASSUME_NONNULL_BEGIN
 /** The concurrent queue on which all registration occurs. */
 @property(nonatomic, readonly) dispatch_queue_t registrarQueue;
 
-/** A map of targets to backend implementations. */
-@property(atomic, readonly) NSMutableDictionary<NSNumber *, id<GDTUploader>> *targetToUploader;
+/** A map of targets to backend implementations. This is an immutable snapshot that is swapped out
+ * on registration, so reading it doesn't block.
+ */
+@property(atomic, readonly, copy) NSDictionary<NSNumber *, id<GDTUploader>> *targetToUploader;
 
-/** A map of targets to prioritizer implementations. */
-@property(atomic, readonly)
-    NSMutableDictionary<NSNumber *, id<GDTPrioritizer>> *targetToPrioritizer;
+/** A map of targets to prioritizer implementations. This is an immutable snapshot that is swapped
+ * out on registration, so reading it doesn't block.
+ */
+@property(atomic, readonly, copy)
+    NSDictionary<NSNumber *, id<GDTPrioritizer>> *targetToPrioritizer;
 
 @end
 
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class GDTEvent;
+@class GDTStoredEvent;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** Stores the transport bytes of events in append-only segment files.
+ *
+ * Each event is appended to the current segment, and a record of its target, QoS tier, range in
+ * the segment and archived GDTStoredEvent is appended to an index file. Removing events appends
+ * tombstones to the index. A segment is deleted once all of its events have been removed, and the
+ * index is rewritten once it is mostly tombstones. Storing an event thus costs two appends to files
+ * that are already open, and the index is all that's needed to restore the stored events.
+ *
+ * @note This class is not thread-safe. GDTStorage only uses it on its storageQueue.
+ */
+@interface GDTSegmentLog : NSObject
+
+/** The events found in the log when it was opened, in the order they were stored. */
+@property(readonly, nonatomic) NSArray<GDTStoredEvent *> *restoredEvents;
+
+/** The path of the index file. */
+@property(readonly, nonatomic) NSString *indexPath;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/** Opens the log kept in the given directory, creating the directory if needed.
+ *
+ * @param directory The directory of the segment and index files.
+ * @param maxSegmentSize The size after which events are appended to a new segment.
+ * @return An instance of this class.
+ */
+- (instancetype)initWithDirectory:(NSString *)directory
+                   maxSegmentSize:(NSUInteger)maxSegmentSize NS_DESIGNATED_INITIALIZER;
+
+/** Appends the transport bytes of an event to the log.
+ *
+ * @param event The event to store.
+ * @return The stored event, whose data future reads the bytes back from the log, or nil if the
+ *     event couldn't be written.
+ */
+- (nullable GDTStoredEvent *)appendEvent:(GDTEvent *)event;
+
+/** Removes events from the log. Events that aren't in the log are ignored.
+ *
+ * @param events The events to remove.
+ */
+- (void)removeEvents:(NSSet<GDTStoredEvent *> *)events;
+
+/** Writes the files of the log through to disk and drops the tombstones from the index. This only
+ * rewrites the index if events were removed since the last checkpoint, and never touches the
+ * segments, so it's cheap enough to call whenever the app may be suspended.
+ */
+- (void)checkpoint;
+
+/** Removes all events from the log and deletes its files. */
+- (void)removeAllEvents;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -16,6 +16,7 @@
 
 #import "GDTLibrary/Private/GDTStorage.h"
 
+@class GDTSegmentLog;
 @class GDTUploadCoordinator;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -32,15 +33,20 @@ NS_ASSUME_NONNULL_BEGIN
 /** All the events that have been stored. */
 @property(readonly, nonatomic) NSMutableOrderedSet<GDTStoredEvent *> *storedEvents;
 
+/** The log holding the stored events. */
+@property(readonly, nonatomic) GDTSegmentLog *segmentLog;
+
 /** The upload coordinator instance to use. */
 @property(nonatomic) GDTUploadCoordinator *uploader;
 
-/** If YES, every call to -storeLog results in background task and serializes the singleton to disk.
+/** If YES, every call to -storeLog results in a background task that lasts until the event has
+ * been appended to the log.
  */
 @property(nonatomic, readonly) BOOL runningInBackground;
 
-/** Returns the path to the keyed archive of the singleton. This is where the singleton is saved
- * to disk during certain app lifecycle events.
+/** Returns the path to the keyed archive of the singleton. Earlier versions saved the singleton
+ * there during certain app lifecycle events; the archive is now only read once to restore the
+ * events it tracks, and then deleted.
  *
  * @return File path to serialized singleton.
  */
@@ -39,6 +39,9 @@ NS_ASSUME_NONNULL_BEGIN
 + (instancetype)sharedInstance;
 
 /** Writes the result of applying the given transformers' -transform method on the given event.
+ * The event is only queued on the calling thread. It is transformed, serialized and stored later,
+ * batched with the other events sent in the meantime. If too many events are pending, the events of
+ * the lowest QoS tier are dropped.
  *
  * @note If the app is suspended, a background task will be created to complete work in-progress,
  * but this method will not send any further events until the app is resumed.
@@ -25,10 +25,13 @@ NS_ASSUME_NONNULL_BEGIN
 /** The queue on which all work will occur. */
 @property(nonatomic) dispatch_queue_t eventWritingQueue;
 
+/** The concurrent queue batches of data objects are serialized on. */
+@property(nonatomic, readonly) dispatch_queue_t serializationQueue;
+
 /** The storage instance used to store events. Should only be used to inject a testing fake. */
 @property(nonatomic) GDTStorage *storageInstance;
 
-/** If YES, every call to -transformEvent will result in a background task. */
+/** If YES, every batch of events that's transformed will result in a background task. */
 @property(nonatomic, readonly) BOOL runningInBackground;
 
 @end
@@ -46,7 +46,9 @@ NS_ASSUME_NONNULL_BEGIN
 /** A timer that will causes regular checks for events to upload. */
 @property(nonatomic, readonly) dispatch_source_t timer;
 
-/** The interval the timer will fire. */
+/** The shortest interval the timer will fire at. The timer waits longer while there's no network,
+ * on mobile data with a small backlog, and until targets are allowed to upload again.
+ */
 @property(nonatomic, readonly) uint64_t timerInterval;
 
 /** Some leeway given to libdispatch for the timer interval event. */
@@ -21,12 +21,19 @@ NS_ASSUME_NONNULL_BEGIN
 /** This class represents a future data object, determined at instantiation time. */
 @interface GDTDataFuture : NSObject <NSSecureCoding>
 
-/** The data, computed on-demand, depending on the initializer. */
+/** The data, computed on-demand, depending on the initializer. The data of a file is memory-mapped
+ * when possible, so reading it doesn't copy the file to the heap.
+ */
 @property(nullable, readonly, nonatomic) NSData *data;
 
 /** If not nil, this data future was instantiated with this file URL. */
 @property(nullable, readonly, nonatomic) NSURL *fileURL;
 
+/** The range of the file at fileURL that holds the data, or {NSNotFound, 0} if the data is the
+ * whole file.
+ */
+@property(readonly, nonatomic) NSRange fileRange;
+
 /** If not nil, this data future was instantiated with this NSData instance. */
 @property(nullable, readonly, nonatomic) NSData *originalData;
 
@@ -35,7 +42,15 @@ NS_ASSUME_NONNULL_BEGIN
  * @param fileURL The fileURL containing the data to return in -data.
  * @return An instance of this class.
  */
-- (instancetype)initWithFileURL:(NSURL *)fileURL NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithFileURL:(NSURL *)fileURL;
+
+/** Initializes an instance with a range of the file at fileURL.
+ *
+ * @param fileURL The fileURL containing the data to return in -data.
+ * @param range The range of the file containing the data.
+ * @return An instance of this class.
+ */
+- (instancetype)initWithFileURL:(NSURL *)fileURL range:(NSRange)range NS_DESIGNATED_INITIALIZER;
 
 /** Initializes an instance with the given data.
  *
@@ -54,7 +54,11 @@ typedef NS_ENUM(NSInteger, GDTEventQoS) {
 @property(readonly, nonatomic) NSInteger target;
 
 /** The data object encapsulated in the transport of your choice, as long as it implements
- * the GDTEventDataObject protocol. */
+ * the GDTEventDataObject protocol.
+ *
+ * @note The data object is serialized after the event is sent, off the sending thread, so it
+ * shouldn't be mutated once the event has been sent.
+ */
 @property(nullable, nonatomic) id<GDTEventDataObject> dataObject;
 
 /** The quality of service tier this event belongs to. */
@@ -21,9 +21,9 @@
 @implementation GDTRegistrar (Testing)
 
 - (void)reset {
-  dispatch_sync(self.registrarQueue, ^{
-    [self.targetToPrioritizer removeAllObjects];
-    [self.targetToUploader removeAllObjects];
+  dispatch_barrier_sync(self.registrarQueue, ^{
+    [self setValue:@{} forKey:@"targetToPrioritizer"];
+    [self setValue:@{} forKey:@"targetToUploader"];
   });
 }
 
@@ -16,6 +16,7 @@
 
 #import "GDTTests/Common/Categories/GDTStorage+Testing.h"
 
+#import "GDTLibrary/Private/GDTSegmentLog.h"
 #import "GDTLibrary/Private/GDTStorage_Private.h"
 
 @implementation GDTStorage (Testing)
@@ -24,6 +25,7 @@
   dispatch_sync(self.storageQueue, ^{
     [self.targetToEventSet removeAllObjects];
     [self.storedEvents removeAllObjects];
+    [self.segmentLog removeAllEvents];
     NSError *error;
     [[NSFileManager defaultManager] removeItemAtPath:[GDTStorage archivePath] error:&error];
   });
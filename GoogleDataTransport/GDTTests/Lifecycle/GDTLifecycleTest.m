@@ -20,6 +20,7 @@
 #import <GoogleDataTransport/GDTEventDataObject.h>
 #import <GoogleDataTransport/GDTTransport.h>
 
+#import "GDTLibrary/Private/GDTSegmentLog.h"
 #import "GDTLibrary/Private/GDTStorage_Private.h"
 #import "GDTLibrary/Private/GDTTransformer_Private.h"
 #import "GDTLibrary/Private/GDTUploadCoordinator_Private.h"
@@ -91,7 +92,7 @@
   [[GDTUploadCoordinator sharedInstance] reset];
 }
 
-/** Tests that the library serializes itself to disk when the app backgrounds. */
+/** Tests that the library writes its state to disk when the app backgrounds. */
 - (void)testBackgrounding {
   GDTTransport *transport = [[GDTTransport alloc] initWithMappingID:@"test"
                                                        transformers:nil
@@ -113,13 +114,16 @@
   GDTWaitForBlock(
       ^BOOL {
         NSFileManager *fm = [NSFileManager defaultManager];
-        return [fm fileExistsAtPath:[GDTStorage archivePath] isDirectory:NULL] &&
+        return [fm fileExistsAtPath:[GDTStorage sharedInstance].segmentLog.indexPath
+                        isDirectory:NULL] &&
                [fm fileExistsAtPath:[GDTUploadCoordinator archivePath] isDirectory:NULL];
       },
       5.0);
+  // The stored events are kept in the storage log, not in an archive of the whole singleton.
+  XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[GDTStorage archivePath]]);
 }
 
-/** Tests that the library deserializes itself from disk when the app foregrounds. */
+/** Tests that the library still tracks its events when the app foregrounds. */
 - (void)testForegrounding {
   GDTTransport *transport = [[GDTTransport alloc] initWithMappingID:@"test"
                                                        transformers:nil
@@ -140,7 +144,8 @@
   GDTWaitForBlock(
       ^BOOL {
         NSFileManager *fm = [NSFileManager defaultManager];
-        return [fm fileExistsAtPath:[GDTStorage archivePath] isDirectory:NULL] &&
+        return [fm fileExistsAtPath:[GDTStorage sharedInstance].segmentLog.indexPath
+                        isDirectory:NULL] &&
                [fm fileExistsAtPath:[GDTUploadCoordinator archivePath] isDirectory:NULL];
       },
       5.0);
@@ -176,7 +181,8 @@
   GDTWaitForBlock(
       ^BOOL {
         NSFileManager *fm = [NSFileManager defaultManager];
-        return [fm fileExistsAtPath:[GDTStorage archivePath] isDirectory:NULL] &&
+        return [fm fileExistsAtPath:[GDTStorage sharedInstance].segmentLog.indexPath
+                        isDirectory:NULL] &&
                [fm fileExistsAtPath:[GDTUploadCoordinator archivePath] isDirectory:NULL];
       },
       5.0);
@@ -56,4 +56,14 @@
   XCTAssertEqual(prioritizer, registrar.targetToPrioritizer[@(_target)]);
 }
 
+/** Tests that registering replaces the maps rather than mutating maps that were handed out. */
+- (void)testRegisteringDoesNotMutateEarlierMaps {
+  GDTRegistrar *registrar = [GDTRegistrar sharedInstance];
+  NSDictionary<NSNumber *, id<GDTPrioritizer>> *targetToPrioritizer = registrar.targetToPrioritizer;
+  GDTTestPrioritizer *prioritizer = [[GDTTestPrioritizer alloc] init];
+  [registrar registerPrioritizer:prioritizer target:self.target + 1];
+  XCTAssertNil(targetToPrioritizer[@(self.target + 1)]);
+  XCTAssertEqual(prioritizer, registrar.targetToPrioritizer[@(self.target + 1)]);
+}
+
 @end
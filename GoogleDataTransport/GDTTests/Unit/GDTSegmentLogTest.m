@@ -0,0 +1,172 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "GDTTests/Unit/GDTTestCase.h"
+
+#import <GoogleDataTransport/GDTEvent.h>
+#import <GoogleDataTransport/GDTStoredEvent.h>
+
+#import "GDTLibrary/Private/GDTEvent_Private.h"
+#import "GDTLibrary/Private/GDTSegmentLog.h"
+
+@interface GDTSegmentLogTest : GDTTestCase
+
+/** The directory of the log under test. */
+@property(nonatomic) NSString *directory;
+
+@end
+
+@implementation GDTSegmentLogTest
+
+- (void)setUp {
+  [super setUp];
+  self.directory = [NSTemporaryDirectory() stringByAppendingPathComponent:@"GDTSegmentLogTest"];
+  [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+}
+
+- (void)tearDown {
+  [[NSFileManager defaultManager] removeItemAtPath:self.directory error:nil];
+  [super tearDown];
+}
+
+/** Returns an event with the given transport bytes. */
+- (GDTEvent *)eventWithString:(NSString *)string {
+  GDTEvent *event = [[GDTEvent alloc] initWithMappingID:@"404" target:kGDTTargetTest];
+  event.dataObjectTransportBytes = [string dataUsingEncoding:NSUTF8StringEncoding];
+  return event;
+}
+
+/** Returns the segment files in the log directory. */
+- (NSArray<NSString *> *)segmentFiles {
+  NSArray<NSString *> *files =
+      [[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.directory error:nil];
+  NSPredicate *predicate = [NSPredicate predicateWithFormat:@"SELF BEGINSWITH 'segment-'"];
+  return [files filteredArrayUsingPredicate:predicate];
+}
+
+/** Tests that appended events read their bytes back from a shared segment. */
+- (void)testAppendEvents {
+  GDTSegmentLog *log = [[GDTSegmentLog alloc] initWithDirectory:self.directory maxSegmentSize:1024];
+  GDTStoredEvent *event1 = [log appendEvent:[self eventWithString:@"event1"]];
+  GDTStoredEvent *event2 = [log appendEvent:[self eventWithString:@"event2"]];
+  XCTAssertEqualObjects(event1.dataFuture.data, [@"event1" dataUsingEncoding:NSUTF8StringEncoding]);
+  XCTAssertEqualObjects(event2.dataFuture.data, [@"event2" dataUsingEncoding:NSUTF8StringEncoding]);
+  XCTAssertEqualObjects(event1.dataFuture.fileURL, event2.dataFuture.fileURL);
+  XCTAssertNotEqualObjects(event1, event2);
+  XCTAssertEqual([self segmentFiles].count, 1);
+}
+
+/** Tests that reopening the log restores the stored events, but not the removed ones. */
+- (void)testReopenRestoresEvents {
+  GDTSegmentLog *log = [[GDTSegmentLog alloc] initWithDirectory:self.directory maxSegmentSize:1024];
+  GDTStoredEvent *event1 = [log appendEvent:[self eventWithString:@"event1"]];
+  GDTStoredEvent *event2 = [log appendEvent:[self eventWithString:@"event2"]];
+  GDTStoredEvent *event3 = [log appendEvent:[self eventWithString:@"event3"]];
+  [log removeEvents:[NSSet setWithObject:event2]];
+
+  log = [[GDTSegmentLog alloc] initWithDirectory:self.directory maxSegmentSize:1024];
+  XCTAssertEqual(log.restoredEvents.count, 2);
+  XCTAssertEqualObjects(log.restoredEvents[0], event1);
+  XCTAssertEqualObjects(log.restoredEvents[1], event3);
+  XCTAssertEqualObjects(log.restoredEvents[0].mappingID, @"404");
+  XCTAssertEqualObjects(log.restoredEvents[1].target, @(kGDTTargetTest));
+  XCTAssertEqualObjects(log.restoredEvents[1].dataFuture.data,
+                        [@"event3" dataUsingEncoding:NSUTF8StringEncoding]);
+
+  // Events removed after reopening stay removed.
+  [log removeEvents:[NSSet setWithObject:log.restoredEvents[0]]];
+  log = [[GDTSegmentLog alloc] initWithDirectory:self.directory maxSegmentSize:1024];
+  XCTAssertEqualObjects(log.restoredEvents, @[ event3 ]);
+}
+
+/** Tests that segments are rolled over and deleted once all of their events are removed. */
+- (void)testSegmentsAreDeletedWhenEmpty {
+  GDTSegmentLog *log = [[GDTSegmentLog alloc] initWithDirectory:self.directory maxSegmentSize:10];
+  GDTStoredEvent *event1 = [log appendEvent:[self eventWithString:@"event1"]];
+  GDTStoredEvent *event2 = [log appendEvent:[self eventWithString:@"event2"]];
+  GDTStoredEvent *event3 = [log appendEvent:[self eventWithString:@"event3"]];
+  XCTAssertEqual([self segmentFiles].count, 3);
+
+  [log removeEvents:[NSSet setWithObject:event1]];
+  XCTAssertEqual([self segmentFiles].count, 2);
+  XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:event1.dataFuture.fileURL.path]);
+
+  [log removeEvents:[NSSet setWithObjects:event2, event3, nil]];
+  XCTAssertEqual([self segmentFiles].count, 0);
+
+  // Appending after the current segment was deleted starts a new one.
+  GDTStoredEvent *event4 = [log appendEvent:[self eventWithString:@"event4"]];
+  XCTAssertEqualObjects(event4.dataFuture.data, [@"event4" dataUsingEncoding:NSUTF8StringEncoding]);
+  XCTAssertEqual([self segmentFiles].count, 1);
+}
+
+/** Tests that the index is compacted once all events have been removed. */
+- (void)testIndexIsCompacted {
+  GDTSegmentLog *log = [[GDTSegmentLog alloc] initWithDirectory:self.directory maxSegmentSize:1024];
+  NSMutableSet<GDTStoredEvent *> *events = [[NSMutableSet alloc] init];
+  for (int i = 0; i < 10; i++) {
+    [events addObject:[log appendEvent:[self eventWithString:@"event"]]];
+  }
+  [log removeEvents:events];
+
+  NSString *indexPath = [self.directory stringByAppendingPathComponent:@"index"];
+  NSDictionary *attributes =
+      [[NSFileManager defaultManager] attributesOfItemAtPath:indexPath error:nil];
+  XCTAssertEqual([attributes fileSize], 0);
+}
+
+/** Tests that a checkpoint drops the tombstones from the index. */
+- (void)testCheckpointCompactsIndex {
+  GDTSegmentLog *log = [[GDTSegmentLog alloc] initWithDirectory:self.directory maxSegmentSize:1024];
+  GDTStoredEvent *event1 = [log appendEvent:[self eventWithString:@"event1"]];
+  GDTStoredEvent *event2 = [log appendEvent:[self eventWithString:@"event2"]];
+  [log checkpoint];
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  unsigned long long twoEventsSize = [[fileManager attributesOfItemAtPath:log.indexPath
+                                                                    error:nil] fileSize];
+
+  [log removeEvents:[NSSet setWithObject:event1]];
+  [log checkpoint];
+  unsigned long long oneEventSize = [[fileManager attributesOfItemAtPath:log.indexPath
+                                                                   error:nil] fileSize];
+  XCTAssertLessThan(oneEventSize, twoEventsSize);
+
+  log = [[GDTSegmentLog alloc] initWithDirectory:self.directory maxSegmentSize:1024];
+  XCTAssertEqualObjects(log.restoredEvents, @[ event2 ]);
+}
+
+/** Tests that an incomplete record at the end of the index is dropped. */
+- (void)testTruncatedIndexIsRecovered {
+  GDTSegmentLog *log = [[GDTSegmentLog alloc] initWithDirectory:self.directory maxSegmentSize:1024];
+  GDTStoredEvent *event1 = [log appendEvent:[self eventWithString:@"event1"]];
+  [log appendEvent:[self eventWithString:@"event2"]];
+  log = nil;
+
+  NSString *indexPath = [self.directory stringByAppendingPathComponent:@"index"];
+  NSFileHandle *fileHandle = [NSFileHandle fileHandleForUpdatingAtPath:indexPath];
+  unsigned long long length = [fileHandle seekToEndOfFile];
+  [fileHandle truncateFileAtOffset:length - 1];
+  [fileHandle closeFile];
+
+  log = [[GDTSegmentLog alloc] initWithDirectory:self.directory maxSegmentSize:1024];
+  XCTAssertEqualObjects(log.restoredEvents, @[ event1 ]);
+  GDTStoredEvent *event3 = [log appendEvent:[self eventWithString:@"event3"]];
+
+  log = [[GDTSegmentLog alloc] initWithDirectory:self.directory maxSegmentSize:1024];
+  XCTAssertEqualObjects(log.restoredEvents, (@[ event1, event3 ]));
+}
+
+@end
@@ -192,26 +192,18 @@ static NSInteger target = 1337;
     XCTAssertEqual([GDTStorage sharedInstance].storedEvents.count, 3);
     XCTAssertEqual([GDTStorage sharedInstance].targetToEventSet[@(target)].count, 3);
 
-    NSURL *event1File = storedEvent1.dataFuture.fileURL;
-    XCTAssertNotNil(event1File);
-    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:event1File.path]);
-    NSError *error;
-    XCTAssertTrue([[NSFileManager defaultManager] removeItemAtURL:event1File error:&error]);
-    XCTAssertNil(error, @"There was an error deleting the eventFile: %@", error);
-
-    NSURL *event2File = storedEvent2.dataFuture.fileURL;
-    XCTAssertNotNil(event2File);
-    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:event2File.path]);
-    error = nil;
-    XCTAssertTrue([[NSFileManager defaultManager] removeItemAtURL:event2File error:&error]);
-    XCTAssertNil(error, @"There was an error deleting the eventFile: %@", error);
-
-    NSURL *event3File = storedEvent3.dataFuture.fileURL;
-    XCTAssertNotNil(event3File);
-    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:event3File.path]);
-    error = nil;
-    XCTAssertTrue([[NSFileManager defaultManager] removeItemAtURL:event3File error:&error]);
-    XCTAssertNil(error, @"There was an error deleting the eventFile: %@", error);
+    // The events are appended to the same segment file.
+    NSURL *segmentFile = storedEvent1.dataFuture.fileURL;
+    XCTAssertNotNil(segmentFile);
+    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:segmentFile.path]);
+    XCTAssertEqualObjects(storedEvent2.dataFuture.fileURL, segmentFile);
+    XCTAssertEqualObjects(storedEvent3.dataFuture.fileURL, segmentFile);
+    XCTAssertEqualObjects(storedEvent1.dataFuture.data,
+                          [@"testString1" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertEqualObjects(storedEvent2.dataFuture.data,
+                          [@"testString2" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertEqualObjects(storedEvent3.dataFuture.data,
+                          [@"testString3" dataUsingEncoding:NSUTF8StringEncoding]);
   });
 }
 
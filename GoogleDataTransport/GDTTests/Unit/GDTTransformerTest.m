@@ -19,6 +19,7 @@
 #import <GoogleDataTransport/GDTEvent.h>
 #import <GoogleDataTransport/GDTEventTransformer.h>
 
+#import "GDTLibrary/Private/GDTEvent_Private.h"
 #import "GDTLibrary/Private/GDTStorage.h"
 #import "GDTLibrary/Private/GDTTransformer.h"
 #import "GDTLibrary/Private/GDTTransformer_Private.h"
@@ -52,6 +53,25 @@
 
 @end
 
+/** A storage fake that records the events it's given. */
+@interface GDTTransformerTestRecordingStorage : GDTStorageFake
+
+/** The events stored so far. */
+@property(nonatomic) NSMutableArray<GDTEvent *> *storedEvents;
+
+@end
+
+@implementation GDTTransformerTestRecordingStorage
+
+- (void)storeEvent:(GDTEvent *)event {
+  if (!_storedEvents) {
+    _storedEvents = [[NSMutableArray alloc] init];
+  }
+  [_storedEvents addObject:event];
+}
+
+@end
+
 @interface GDTTransformerTest : GDTTestCase
 
 @end
@@ -125,4 +145,56 @@
   [self waitForExpectations:@[ errorExpectation ] timeout:5.0];
 }
 
+/** Tests that events sent while a batch is pending are transformed and stored together. */
+- (void)testEventsAreBatched {
+  GDTTransformer *transformer = [[GDTTransformer alloc] init];
+  GDTTransformerTestRecordingStorage *storage = [[GDTTransformerTestRecordingStorage alloc] init];
+  transformer.storageInstance = storage;
+  dispatch_suspend(transformer.eventWritingQueue);
+  for (int i = 0; i < 10; i++) {
+    GDTEvent *event = [[GDTEvent alloc] initWithMappingID:@"batch" target:1];
+    event.dataObject = [[GDTDataObjectTesterSimple alloc] init];
+    [transformer transformEvent:event withTransformers:nil];
+  }
+  XCTAssertEqual(storage.storedEvents.count, 0);
+  dispatch_resume(transformer.eventWritingQueue);
+  dispatch_sync(transformer.eventWritingQueue, ^{
+                });
+  XCTAssertEqual(storage.storedEvents.count, 10);
+  for (GDTEvent *event in storage.storedEvents) {
+    XCTAssertNotNil(event.dataObjectTransportBytes);
+  }
+}
+
+/** Tests that the events of the lowest QoS tier are dropped when too many events are pending. */
+- (void)testOverflowDropsTheLowestQoSTier {
+  GDTTransformer *transformer = [[GDTTransformer alloc] init];
+  GDTTransformerTestRecordingStorage *storage = [[GDTTransformerTestRecordingStorage alloc] init];
+  transformer.storageInstance = storage;
+  dispatch_suspend(transformer.eventWritingQueue);
+  GDTEvent *telemetryEvent = [[GDTEvent alloc] initWithMappingID:@"telemetry" target:1];
+  telemetryEvent.qosTier = GDTEventQoSTelemetry;
+  [transformer transformEvent:telemetryEvent withTransformers:nil];
+  for (int i = 0; i < 999; i++) {
+    GDTEvent *event = [[GDTEvent alloc] initWithMappingID:@"default" target:1];
+    event.qosTier = GDTEventQosDefault;
+    [transformer transformEvent:event withTransformers:nil];
+  }
+  // The pending events are full: this drops the telemetry event.
+  GDTEvent *fastEvent = [[GDTEvent alloc] initWithMappingID:@"fast" target:1];
+  fastEvent.qosTier = GDTEventQoSFast;
+  [transformer transformEvent:fastEvent withTransformers:nil];
+  // Nothing pending is of a lower tier than this one, so it's dropped itself.
+  GDTEvent *dailyEvent = [[GDTEvent alloc] initWithMappingID:@"daily" target:1];
+  dailyEvent.qosTier = GDTEventQoSDaily;
+  [transformer transformEvent:dailyEvent withTransformers:nil];
+  dispatch_resume(transformer.eventWritingQueue);
+  dispatch_sync(transformer.eventWritingQueue, ^{
+                });
+  XCTAssertEqual(storage.storedEvents.count, 1000);
+  XCTAssertFalse([storage.storedEvents containsObject:telemetryEvent]);
+  XCTAssertFalse([storage.storedEvents containsObject:dailyEvent]);
+  XCTAssertEqualObjects(storage.storedEvents.lastObject.mappingID, @"fast");
+}
+
 @end
@@ -188,4 +188,21 @@
   });
 }
 
+/** Tests that a failed upload still records when the target may upload again. */
+- (void)testFailedUploadRecordsTheBackoffOfTheUploader {
+  GDTClock *nextUploadTime = [GDTClock clockSnapshotInTheFuture:60 * 1000];
+  NSError *error = [NSError errorWithDomain:NSURLErrorDomain code:1337 userInfo:nil];
+  dispatch_sync([GDTUploadCoordinator sharedInstance].coordinationQueue, ^{
+    [GDTUploadCoordinator sharedInstance].targetToInFlightEventSet[@(kGDTTargetTest)] =
+        [[NSSet alloc] init];
+    [GDTUploadCoordinator sharedInstance].onCompleteBlock(kGDTTargetTest, nextUploadTime, error);
+  });
+  dispatch_sync([GDTUploadCoordinator sharedInstance].coordinationQueue, ^{
+    GDTUploadCoordinator *uploadCoordinator = [GDTUploadCoordinator sharedInstance];
+    XCTAssertNil(uploadCoordinator.targetToInFlightEventSet[@(kGDTTargetTest)]);
+    XCTAssertEqualObjects(uploadCoordinator.targetToNextUploadTimes[@(kGDTTargetTest)],
+                          nextUploadTime);
+  });
+}
+
 @end
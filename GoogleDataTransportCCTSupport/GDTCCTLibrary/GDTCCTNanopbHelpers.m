@@ -109,13 +109,24 @@ gdt_cct_LogEvent GDTCCTConstructLogEvent(GDTStoredEvent *event) {
   logEvent.has_timezone_offset_seconds = 1;
   // TODO: Read network_connection_info from the custom params dict.
 
-  NSError *error;
-  NSData *extensionBytes = [NSData dataWithContentsOfURL:event.eventFileURL options:0 error:&error];
-  NSCAssert(error == nil, @"There was an error reading extension bytes from disk: %@", error);
-  logEvent.source_extension = GDTCCTEncodeData(extensionBytes);  // read bytes from the file.
+  // The bytes are written straight from the event's data future into the output stream when the
+  // request is encoded, rather than copied into the request first.
+  logEvent.source_extension.funcs.encode = GDTCCTEncodeSourceExtension;
+  logEvent.source_extension.arg = (__bridge void *)event;
   return logEvent;
 }
 
+bool GDTCCTEncodeSourceExtension(pb_ostream_t *stream, const pb_field_t *field, void *const *arg) {
+  GDTStoredEvent *event = (__bridge GDTStoredEvent *)*arg;
+  // File backed data futures map their file, so this doesn't copy the bytes to the heap.
+  NSData *extensionBytes = event.dataFuture.data;
+  NSCAssert(extensionBytes, @"There was an error reading extension bytes from disk: %@", event);
+  if (!pb_encode_tag_for_field(stream, field)) {
+    return false;
+  }
+  return pb_encode_string(stream, extensionBytes.bytes, extensionBytes.length);
+}
+
 gdt_cct_ClientInfo GDTCCTConstructClientInfo() {
   gdt_cct_ClientInfo clientInfo = gdt_cct_ClientInfo_init_default;
   clientInfo.client_type = gdt_cct_ClientInfo_ClientType_IOS_FIREBASE;
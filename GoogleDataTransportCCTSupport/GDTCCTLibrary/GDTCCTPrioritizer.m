@@ -23,7 +23,35 @@
 
 const static NSUInteger kMillisPerDay = 8.64e+7;
 
-@implementation GDTCCTPrioritizer
+/** The default value of maxPackageBytesOnWifi. */
+const static NSUInteger kGDTCCTMaxPackageBytesOnWifi = 1024 * 1024;
+
+/** The default value of maxPackageBytesOnMobileData. Smaller packages keep each upload short, so
+ * the cellular radio can go back to idle sooner.
+ */
+const static NSUInteger kGDTCCTMaxPackageBytesOnMobileData = 128 * 1024;
+
+/** The different possible quality of service specifiers. High values indicate high priority. */
+typedef NS_ENUM(NSInteger, GDTCCTQoSTier) {
+  /** The QoS tier wasn't set, and won't ever be sent. */
+  GDTCCTQoSDefault = 0,
+
+  /** This event is internal telemetry data that should not be sent on its own if possible. */
+  GDTCCTQoSTelemetry = 1,
+
+  /** This event should be sent, but in a batch only roughly once per day. */
+  GDTCCTQoSDaily = 2,
+
+  /** This event should only be uploaded on wifi. */
+  GDTCCTQoSWifiOnly = 5,
+};
+
+@implementation GDTCCTPrioritizer {
+  /** The events of `events` grouped by CCT QoS tier, each group sorted oldest first, so that an
+   * upload package takes the oldest eligible events without filtering and sorting every event.
+   */
+  NSMutableDictionary<NSNumber *, NSMutableArray<GDTStoredEvent *> *> *_eventsByTier;
+}
 
 + (void)load {
   GDTCCTPrioritizer *prioritizer = [GDTCCTPrioritizer sharedInstance];
@@ -44,6 +72,9 @@ const static NSUInteger kMillisPerDay = 8.64e+7;
   if (self) {
     _queue = dispatch_queue_create("com.google.GDTCCTPrioritizer", DISPATCH_QUEUE_SERIAL);
     _events = [[NSMutableSet alloc] init];
+    _eventsByTier = [[NSMutableDictionary alloc] init];
+    _maxPackageBytesOnWifi = kGDTCCTMaxPackageBytesOnWifi;
+    _maxPackageBytesOnMobileData = kGDTCCTMaxPackageBytesOnMobileData;
   }
   return self;
 }
@@ -52,67 +83,57 @@ const static NSUInteger kMillisPerDay = 8.64e+7;
 
 - (void)prioritizeEvent:(GDTStoredEvent *)event {
   dispatch_async(_queue, ^{
-    [self.events addObject:event];
+    if (![self.events containsObject:event]) {
+      [self.events addObject:event];
+      [self indexEvent:event];
+    }
   });
 }
 
 - (void)unprioritizeEvents:(NSSet<GDTStoredEvent *> *)events {
   dispatch_async(_queue, ^{
     for (GDTStoredEvent *event in events) {
-      [self.events removeObject:event];
+      GDTStoredEvent *member = [self.events member:event];
+      if (member) {
+        [self.events removeObject:member];
+        [self unindexEvent:member];
+      }
     }
   });
 }
 
 - (GDTUploadPackage *)uploadPackageWithConditions:(GDTUploadConditions)conditions {
   GDTUploadPackage *package = [[GDTUploadPackage alloc] init];
+  BOOL onWifi = (conditions & GDTUploadConditionWifiData) == GDTUploadConditionWifiData;
   dispatch_sync(_queue, ^{
-    NSSet<GDTStoredEvent *> *logEventsThatWillBeSent;
+    NSUInteger maxBytes = onWifi ? self.maxPackageBytesOnWifi : self.maxPackageBytesOnMobileData;
     // A high priority event effectively flushes all events to be sent.
     if ((conditions & GDTUploadConditionHighPriority) == GDTUploadConditionHighPriority) {
-      package.events = self.events;
+      package.events = [self oldestEventsInTiers:self->_eventsByTier.allKeys upToBytes:maxBytes];
       return;
     }
 
-    if ((conditions & GDTUploadConditionWifiData) == GDTUploadConditionWifiData) {
-      logEventsThatWillBeSent = [self logEventsOkToSendOnWifi];
-    } else {
-      logEventsThatWillBeSent = [self logEventsOkToSendOnMobileData];
+    NSMutableArray<NSNumber *> *tiers = [NSMutableArray arrayWithObject:@(GDTCCTQoSDefault)];
+    if (onWifi) {
+      [tiers addObject:@(GDTCCTQoSWifiOnly)];
     }
     if (self.timeOfLastDailyUpload) {
       int64_t millisSinceLastUpload =
           [GDTClock snapshot].timeMillis - self.timeOfLastDailyUpload.timeMillis;
       if (millisSinceLastUpload > kMillisPerDay) {
-        logEventsThatWillBeSent =
-            [logEventsThatWillBeSent setByAddingObjectsFromSet:[self logEventsOkToSendDaily]];
+        [tiers addObject:@(GDTCCTQoSDaily)];
       }
     } else {
       self.timeOfLastDailyUpload = [GDTClock snapshot];
-      logEventsThatWillBeSent =
-          [logEventsThatWillBeSent setByAddingObjectsFromSet:[self logEventsOkToSendDaily]];
+      [tiers addObject:@(GDTCCTQoSDaily)];
     }
-    package.events = logEventsThatWillBeSent;
+    package.events = [self oldestEventsInTiers:tiers upToBytes:maxBytes];
   });
   return package;
 }
 
 #pragma mark - Private helper methods
 
-/** The different possible quality of service specifiers. High values indicate high priority. */
-typedef NS_ENUM(NSInteger, GDTCCTQoSTier) {
-  /** The QoS tier wasn't set, and won't ever be sent. */
-  GDTCCTQoSDefault = 0,
-
-  /** This event is internal telemetry data that should not be sent on its own if possible. */
-  GDTCCTQoSTelemetry = 1,
-
-  /** This event should be sent, but in a batch only roughly once per day. */
-  GDTCCTQoSDaily = 2,
-
-  /** This event should only be uploaded on wifi. */
-  GDTCCTQoSWifiOnly = 5,
-};
-
 /** Converts a GDTEventQoS to a GDTCCTQoS tier.
  *
  * @param qosTier The GDTEventQoS value.
@@ -136,41 +157,127 @@ NSNumber *GDTCCTQosTierFromGDTEventQosTier(GDTEventQoS qosTier) {
   }
 }
 
-/** Returns a set of logs that are ok to upload whilst on mobile data.
+/** Returns the number of bytes of event data an event will add to an upload.
+ *
+ * @param event The event.
+ * @return The length of the data of the event, without reading the data.
+ */
+static NSUInteger GDTCCTEventDataLength(GDTStoredEvent *event) {
+  GDTDataFuture *dataFuture = event.dataFuture;
+  if (dataFuture.fileURL && dataFuture.fileRange.location != NSNotFound) {
+    return dataFuture.fileRange.length;
+  } else if (dataFuture.fileURL) {
+    NSDictionary *attributes =
+        [[NSFileManager defaultManager] attributesOfItemAtPath:dataFuture.fileURL.path error:nil];
+    return (NSUInteger)[attributes fileSize];
+  }
+  return dataFuture.originalData.length;
+}
+
+/** Orders events by the time they were logged, oldest first. */
+static NSComparisonResult GDTCCTCompareEventTimes(GDTStoredEvent *left, GDTStoredEvent *right) {
+  int64_t leftTime = left.clockSnapshot.timeMillis;
+  int64_t rightTime = right.clockSnapshot.timeMillis;
+  if (leftTime == rightTime) {
+    return NSOrderedSame;
+  }
+  return leftTime < rightTime ? NSOrderedAscending : NSOrderedDescending;
+}
+
+/** Adds an event to the group of its QoS tier, after any event logged at the same time.
  *
  * @note This should be called from a thread safe method.
- * @return A set of logs that are ok to upload whilst on mobile data.
+ * @param event The event.
  */
-- (NSSet<GDTStoredEvent *> *)logEventsOkToSendOnMobileData {
-  return
-      [self.events objectsPassingTest:^BOOL(GDTStoredEvent *_Nonnull event, BOOL *_Nonnull stop) {
-        return [GDTCCTQosTierFromGDTEventQosTier(event.qosTier) isEqual:@(GDTCCTQoSDefault)];
-      }];
+- (void)indexEvent:(GDTStoredEvent *)event {
+  NSNumber *tier = GDTCCTQosTierFromGDTEventQosTier(event.qosTier);
+  NSMutableArray<GDTStoredEvent *> *tierEvents = _eventsByTier[tier];
+  if (!tierEvents) {
+    tierEvents = [[NSMutableArray alloc] init];
+    _eventsByTier[tier] = tierEvents;
+  }
+  NSUInteger index = [tierEvents indexOfObject:event
+                                 inSortedRange:NSMakeRange(0, tierEvents.count)
+                                       options:NSBinarySearchingInsertionIndex |
+                                               NSBinarySearchingLastEqual
+                               usingComparator:^NSComparisonResult(id left, id right) {
+                                 return GDTCCTCompareEventTimes(left, right);
+                               }];
+  [tierEvents insertObject:event atIndex:index];
 }
 
-/** Returns a set of logs that are ok to upload whilst on wifi.
+/** Removes an event from the group of its QoS tier.
  *
  * @note This should be called from a thread safe method.
- * @return A set of logs that are ok to upload whilst on wifi.
+ * @param event The event.
  */
-- (NSSet<GDTStoredEvent *> *)logEventsOkToSendOnWifi {
-  return
-      [self.events objectsPassingTest:^BOOL(GDTStoredEvent *_Nonnull event, BOOL *_Nonnull stop) {
-        NSNumber *qosTier = GDTCCTQosTierFromGDTEventQosTier(event.qosTier);
-        return [qosTier isEqual:@(GDTCCTQoSDefault)] || [qosTier isEqual:@(GDTCCTQoSWifiOnly)];
-      }];
+- (void)unindexEvent:(GDTStoredEvent *)event {
+  NSMutableArray<GDTStoredEvent *> *tierEvents =
+      _eventsByTier[GDTCCTQosTierFromGDTEventQosTier(event.qosTier)];
+  NSUInteger index = [tierEvents indexOfObject:event
+                                 inSortedRange:NSMakeRange(0, tierEvents.count)
+                                       options:NSBinarySearchingFirstEqual
+                               usingComparator:^NSComparisonResult(id left, id right) {
+                                 return GDTCCTCompareEventTimes(left, right);
+                               }];
+  // Events logged at the same time are next to each other; find this one among them.
+  for (; index < tierEvents.count &&
+         GDTCCTCompareEventTimes(tierEvents[index], event) == NSOrderedSame;
+       index++) {
+    if ([tierEvents[index] isEqual:event]) {
+      [tierEvents removeObjectAtIndex:index];
+      return;
+    }
+  }
 }
 
-/** Returns a set of logs that only should have a single upload attempt per day.
+/** Returns the oldest events of the given QoS tiers whose data fits in the given number of bytes.
+ * The oldest event is always returned, so that an event larger than the limit still gets uploaded.
  *
  * @note This should be called from a thread safe method.
- * @return A set of logs that are ok to upload only once per day.
+ * @param tiers The CCT QoS tiers of the events that are ok to upload.
+ * @param maxBytes The most bytes of event data to return.
+ * @return The events to put in the upload package.
  */
-- (NSSet<GDTStoredEvent *> *)logEventsOkToSendDaily {
-  return
-      [self.events objectsPassingTest:^BOOL(GDTStoredEvent *_Nonnull event, BOOL *_Nonnull stop) {
-        return [GDTCCTQosTierFromGDTEventQosTier(event.qosTier) isEqual:@(GDTCCTQoSDaily)];
-      }];
+- (NSSet<GDTStoredEvent *> *)oldestEventsInTiers:(NSArray<NSNumber *> *)tiers
+                                       upToBytes:(NSUInteger)maxBytes {
+  NSMutableArray<NSArray<GDTStoredEvent *> *> *groups = [[NSMutableArray alloc] init];
+  for (NSNumber *tier in tiers) {
+    NSArray<GDTStoredEvent *> *tierEvents = _eventsByTier[tier];
+    if (tierEvents.count > 0) {
+      [groups addObject:tierEvents];
+    }
+  }
+
+  // Merge the sorted groups, taking the oldest remaining event each time.
+  NSUInteger positions[groups.count];
+  memset(positions, 0, sizeof(positions));
+  NSMutableSet<GDTStoredEvent *> *packageEvents = [[NSMutableSet alloc] init];
+  NSUInteger packageBytes = 0;
+  while (YES) {
+    NSUInteger oldestGroup = NSNotFound;
+    for (NSUInteger i = 0; i < groups.count; i++) {
+      if (positions[i] < groups[i].count &&
+          (oldestGroup == NSNotFound ||
+           GDTCCTCompareEventTimes(groups[i][positions[i]],
+                                   groups[oldestGroup][positions[oldestGroup]]) ==
+               NSOrderedAscending)) {
+        oldestGroup = i;
+      }
+    }
+    if (oldestGroup == NSNotFound) {
+      break;
+    }
+    GDTStoredEvent *event = groups[oldestGroup][positions[oldestGroup]];
+    NSUInteger length = GDTCCTEventDataLength(event);
+    if (packageEvents.count > 0 && packageBytes + length > maxBytes) {
+      break;
+    }
+    [packageEvents addObject:event];
+    packageBytes += length;
+    positions[oldestGroup]++;
+  }
+  return packageEvents;
 }
 
 #pragma mark - GDTLifecycleProtocol
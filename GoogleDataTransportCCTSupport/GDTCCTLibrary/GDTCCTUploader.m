@@ -17,6 +17,7 @@
 #import "GDTCCTLibrary/Private/GDTCCTUploader.h"
 
 #import <GoogleDataTransport/GDTRegistrar.h>
+#import <GoogleUtilities/GULNSData+zlib.h>
 
 #import <nanopb/pb.h>
 #import <nanopb/pb_decode.h>
@@ -27,11 +28,22 @@
 
 #import "GDTCCTLibrary/Protogen/nanopb/cct.nanopb.h"
 
+/** The time to wait before the next upload if the server didn't specify one. */
+static const uint64_t kGDTCCTDefaultUploadWaitMillis = 15 * 60 * 1000;
+
+/** The time to wait before retrying after the first failed upload. Each consecutive failure doubles
+ * it, up to kGDTCCTDefaultUploadWaitMillis.
+ */
+static const uint64_t kGDTCCTInitialBackoffMillis = 30 * 1000;
+
 @interface GDTCCTUploader ()
 
 // Redeclared as readwrite.
 @property(nullable, nonatomic, readwrite) NSURLSessionUploadTask *currentTask;
 
+/** The number of uploads that failed in a row. */
+@property(nonatomic) NSUInteger consecutiveFailureCount;
+
 @end
 
 @implementation GDTCCTUploader
@@ -90,22 +102,47 @@
     id completionHandler = ^(NSData *_Nullable data, NSURLResponse *_Nullable response,
                              NSError *_Nullable error) {
       NSAssert(!error, @"There should be no errors uploading events: %@", error);
+      NSInteger statusCode = 200;
+      if ([response isKindOfClass:[NSHTTPURLResponse class]]) {
+        statusCode = ((NSHTTPURLResponse *)response).statusCode;
+      }
+      if (!error && (statusCode < 200 || statusCode >= 300)) {
+        error = [NSError errorWithDomain:NSURLErrorDomain
+                                    code:NSURLErrorBadServerResponse
+                                userInfo:@{@"statusCode" : @(statusCode)}];
+      }
       if (onComplete) {
         GDTClock *nextUploadTime;
-        NSError *decodingError;
-        gdt_cct_LogResponse response = GDTCCTDecodeLogResponse(data, &decodingError);
-        if (!decodingError && response.has_next_request_wait_millis) {
-          nextUploadTime = [GDTClock clockSnapshotInTheFuture:response.next_request_wait_millis];
+        if (error) {
+          // Back off exponentially, so that an unreachable or overloaded server doesn't keep the
+          // radio awake.
+          uint64_t backoffMillis = kGDTCCTInitialBackoffMillis
+                                   << MIN(self.consecutiveFailureCount, (NSUInteger)5);
+          nextUploadTime = [GDTClock
+              clockSnapshotInTheFuture:MIN(backoffMillis, kGDTCCTDefaultUploadWaitMillis)];
         } else {
-          // 15 minutes from now.
-          nextUploadTime = [GDTClock clockSnapshotInTheFuture:15 * 60 * 1000];
+          NSError *decodingError;
+          gdt_cct_LogResponse logResponse = GDTCCTDecodeLogResponse(data, &decodingError);
+          if (!decodingError && logResponse.has_next_request_wait_millis) {
+            nextUploadTime =
+                [GDTClock clockSnapshotInTheFuture:logResponse.next_request_wait_millis];
+          } else {
+            nextUploadTime = [GDTClock clockSnapshotInTheFuture:kGDTCCTDefaultUploadWaitMillis];
+          }
+          pb_release(gdt_cct_LogResponse_fields, &logResponse);
         }
-        pb_release(gdt_cct_LogResponse_fields, &response);
         onComplete(kGDTTargetCCT, nextUploadTime, error);
       }
+      self.consecutiveFailureCount = error ? self.consecutiveFailureCount + 1 : 0;
       self.currentTask = nil;
     };
     NSData *requestProtoData = [self constructRequestProtoFromPackage:(GDTUploadPackage *)package];
+    // Batched log requests are mostly repeated field names and metadata, which compress well.
+    NSData *gzippedData = [NSData gul_dataByGzippingData:requestProtoData error:nil];
+    if (gzippedData && gzippedData.length < requestProtoData.length) {
+      [request setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+      requestProtoData = gzippedData;
+    }
     self.currentTask = [self.uploaderSession uploadTaskWithRequest:request
                                                           fromData:requestProtoData
                                                  completionHandler:completionHandler];
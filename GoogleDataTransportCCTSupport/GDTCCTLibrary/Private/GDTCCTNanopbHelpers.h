@@ -75,6 +75,9 @@ FOUNDATION_EXPORT
 gdt_cct_LogRequest GDTCCTConstructLogRequest(int32_t logSource, NSSet<GDTStoredEvent *> *logSet);
 
 /** Constructs a gdt_cct_LogEvent given a GDTStoredEvent*.
+ *
+ * @note The log event doesn't retain the stored event, whose bytes are only read when the log event
+ * is encoded. The stored event must outlive the log event.
  *
  * @param event The GDTStoredEvent to convert.
  * @return The new gdt_cct_LogEvent object.
@@ -82,6 +85,17 @@ gdt_cct_LogRequest GDTCCTConstructLogRequest(int32_t logSource, NSSet<GDTStoredE
 FOUNDATION_EXPORT
 gdt_cct_LogEvent GDTCCTConstructLogEvent(GDTStoredEvent *event);
 
+/** The nanopb encode callback of the source_extension field of a gdt_cct_LogEvent. Writes the
+ * bytes of the GDTStoredEvent given as the callback argument to the stream.
+ *
+ * @param stream The stream to write to.
+ * @param field The source_extension field.
+ * @param arg A pointer to the unretained GDTStoredEvent.
+ * @return YES if the bytes were written.
+ */
+FOUNDATION_EXPORT
+bool GDTCCTEncodeSourceExtension(pb_ostream_t *stream, const pb_field_t *field, void *const *arg);
+
 /** Constructs a gdt_cct_ClientInfo representing the client device.
  *
  * @return The new gdt_cct_ClientInfo object.
@@ -33,6 +33,12 @@ NS_ASSUME_NONNULL_BEGIN
 /** The most recent attempted upload of daily uploaded logs. */
 @property(nonatomic) GDTClock *timeOfLastDailyUpload;
 
+/** The most bytes of event data put in an upload package while on wifi. */
+@property(nonatomic) NSUInteger maxPackageBytesOnWifi;
+
+/** The most bytes of event data put in an upload package while on mobile data. */
+@property(nonatomic) NSUInteger maxPackageBytesOnMobileData;
+
 /** Creates and/or returns the singleton instance of this class.
  *
  * @return The singleton instance of this class.
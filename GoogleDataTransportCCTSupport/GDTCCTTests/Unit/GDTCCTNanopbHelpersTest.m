@@ -109,4 +109,21 @@
   pb_release(gdt_cct_BatchedLogRequest_fields, &decodedBatch);
 }
 
+/** Tests that the bytes of an event are encoded as its source extension. */
+- (void)testSourceExtensionIsEncodedFromTheDataFuture {
+  NSBundle *testBundle = [NSBundle bundleForClass:[self class]];
+  NSURL *fileURL = [testBundle URLForResource:@"message-32347456.dat" withExtension:nil];
+  GDTStoredEvent *storedEvent = [_generator generateStoredEvent:GDTEventQosDefault fileURL:fileURL];
+  gdt_cct_BatchedLogRequest batch =
+      GDTCCTConstructBatchedLogRequest(@{@"1018" : [NSSet setWithObject:storedEvent]});
+  NSData *encodedBatchLogRequest = GDTCCTEncodeBatchedLogRequest(&batch);
+  pb_release(gdt_cct_BatchedLogRequest_fields, &batch);
+
+  NSData *eventBytes = [NSData dataWithContentsOfURL:fileURL];
+  XCTAssertGreaterThan(eventBytes.length, 0);
+  NSRange searchRange = NSMakeRange(0, encodedBatchLogRequest.length);
+  NSRange range = [encodedBatchLogRequest rangeOfData:eventBytes options:0 range:searchRange];
+  XCTAssertNotEqual(range.location, NSNotFound);
+}
+
 @end
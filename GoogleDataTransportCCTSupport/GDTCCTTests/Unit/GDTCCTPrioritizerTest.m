@@ -135,4 +135,70 @@
   XCTAssertTrue([package.events containsObject:dailyEvent]);
 }
 
+/** Tests that upload packages are capped to the configured number of bytes. */
+- (void)testPackagesAreCappedInSize {
+  GDTCCTPrioritizer *prioritizer = [[GDTCCTPrioritizer alloc] init];
+  prioritizer.maxPackageBytesOnWifi = 250;
+  prioritizer.maxPackageBytesOnMobileData = 50;
+  for (int i = 0; i < 5; i++) {
+    NSString *fileName = [NSString stringWithFormat:@"test-100-bytes-%d.txt", i];
+    NSString *filePath = [NSTemporaryDirectory() stringByAppendingPathComponent:fileName];
+    [[NSFileManager defaultManager] createFileAtPath:filePath
+                                            contents:[NSMutableData dataWithLength:100]
+                                          attributes:nil];
+    NSURL *fileURL = [NSURL fileURLWithPath:filePath];
+    [prioritizer
+        prioritizeEvent:[_generator generateStoredEvent:GDTEventQosDefault fileURL:fileURL]];
+  }
+  GDTUploadPackage *package = [prioritizer uploadPackageWithConditions:GDTUploadConditionWifiData];
+  XCTAssertEqual(package.events.count, 2);
+
+  // An event larger than the cap is still uploaded on its own.
+  package = [prioritizer uploadPackageWithConditions:GDTUploadConditionMobileData];
+  XCTAssertEqual(package.events.count, 1);
+
+  // The remaining events are uploaded once the first ones are gone.
+  package = [prioritizer uploadPackageWithConditions:GDTUploadConditionWifiData];
+  [prioritizer unprioritizeEvents:package.events];
+  package = [prioritizer uploadPackageWithConditions:GDTUploadConditionWifiData];
+  XCTAssertEqual(package.events.count, 2);
+  [prioritizer unprioritizeEvents:package.events];
+  package = [prioritizer uploadPackageWithConditions:GDTUploadConditionWifiData];
+  XCTAssertEqual(package.events.count, 1);
+}
+
+/** Tests that capped packages take the oldest events across all the QoS tiers that can be sent. */
+- (void)testPackagesTakeTheOldestEventsAcrossTiers {
+  GDTCCTPrioritizer *prioritizer = [[GDTCCTPrioritizer alloc] init];
+  prioritizer.maxPackageBytesOnWifi = 250;
+  GDTEventQoS tiers[] = {GDTEventQosDefault, GDTEventQoSWifiOnly, GDTEventQoSTelemetry,
+                         GDTEventQosDefault, GDTEventQoSWifiOnly};
+  // Logged newest first, so that the oldest events aren't the first ones prioritized.
+  int64_t times[] = {5000, 4000, 3000, 2000, 1000};
+  NSMutableArray<GDTStoredEvent *> *events = [[NSMutableArray alloc] init];
+  for (int i = 0; i < 5; i++) {
+    NSString *fileName = [NSString stringWithFormat:@"test-100-bytes-%d.txt", i];
+    NSString *filePath = [NSTemporaryDirectory() stringByAppendingPathComponent:fileName];
+    [[NSFileManager defaultManager] createFileAtPath:filePath
+                                            contents:[NSMutableData dataWithLength:100]
+                                          attributes:nil];
+    GDTStoredEvent *event = [_generator generateStoredEvent:tiers[i]
+                                                    fileURL:[NSURL fileURLWithPath:filePath]];
+    [event.clockSnapshot setValue:@(times[i]) forKeyPath:@"timeMillis"];
+    [events addObject:event];
+    [prioritizer prioritizeEvent:event];
+  }
+  GDTUploadPackage *package = [prioritizer uploadPackageWithConditions:GDTUploadConditionWifiData];
+  XCTAssertEqualObjects(package.events, ([NSSet setWithObjects:events[4], events[3], nil]));
+
+  // Wifi only events are skipped on mobile data.
+  prioritizer.maxPackageBytesOnMobileData = 250;
+  package = [prioritizer uploadPackageWithConditions:GDTUploadConditionMobileData];
+  XCTAssertEqualObjects(package.events, ([NSSet setWithObjects:events[3], events[0], nil]));
+
+  [prioritizer unprioritizeEvents:[NSSet setWithObjects:events[4], events[3], nil]];
+  package = [prioritizer uploadPackageWithConditions:GDTUploadConditionWifiData];
+  XCTAssertEqualObjects(package.events, ([NSSet setWithObjects:events[2], events[1], nil]));
+}
+
 @end
@@ -66,6 +66,7 @@
         id self = weakSelf;
         XCTAssertNotNil(self);
         [responseSentExpectation fulfill];
+        XCTAssertEqualObjects(request.headers[@"Content-Encoding"], @"gzip");
         XCTAssertEqual(response.statusCode, 200);
         XCTAssertTrue(response.hasBody);
       };
@@ -30,14 +30,14 @@
 /** Deletes the empty files created in a temporary directory. */
 - (void)deleteGeneratedFilesFromDisk;
 
-/** Generates a GDTStoredEvent, complete with a file specified in the eventFileURL property.
+/** Generates a GDTStoredEvent, complete with a file specified in the fileURL of its data future.
  *
  * @param qosTier The QoS tier the event should have.
  * @return A newly allocated fake stored event.
  */
 - (GDTStoredEvent *)generateStoredEvent:(GDTEventQoS)qosTier;
 
-/** Generates a GDTStoredEvent, complete with a file specified in the eventFileURL property.
+/** Generates a GDTStoredEvent, complete with a file specified in the fileURL of its data future.
  *
  * @param qosTier The QoS tier the event should have.
  * @param fileURL The file URL containing bytes of some event.
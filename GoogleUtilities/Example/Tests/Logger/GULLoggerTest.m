@@ -32,6 +32,10 @@ extern dispatch_queue_t getGULClientQueue(void);
 
 extern BOOL getGULLoggerDebugMode(void);
 
+extern BOOL GULLoggerShouldSuppressDuplicate(GULLoggerLevel level,
+                                             NSString *messageCode,
+                                             NSString *message);
+
 static NSString *const kMessageCode = @"I-COR000001";
 
 @interface GULLoggerTest : XCTestCase
@@ -102,6 +106,35 @@ static NSString *const kMessageCode = @"I-COR000001";
   XCTAssertNoThrow(GULLogDebug(@"my service", NO, kMessageCode, @"Configure %@.", @"blah"));
 }
 
+- (void)testLoggerMacrosSkipArgumentsWhenNotLoggable {
+  GULSetLoggerLevel(GULLoggerLevelNotice);
+  __block NSInteger evaluations = 0;
+  NSString * (^argument)(void) = ^NSString * {
+    evaluations++;
+    return @"blah";
+  };
+
+  GUL_LOG_DEBUG(@"my service", NO, kMessageCode, @"Configure %@.", argument());
+  GUL_LOG_INFO(@"my service", NO, kMessageCode, @"Configure %@.", argument());
+  XCTAssertEqual(evaluations, 0);
+
+  GUL_LOG_ERROR(@"my service", NO, kMessageCode, @"Configure %@.", argument());
+  GUL_LOG_DEBUG(@"my service", YES, kMessageCode, @"Configure %@.", argument());
+  XCTAssertEqual(evaluations, 2);
+}
+
+- (void)testDuplicateMessagesSuppressed {
+  GULLoggerInitializeASL();
+  dispatch_sync(getGULClientQueue(), ^{
+    XCTAssertFalse(GULLoggerShouldSuppressDuplicate(GULLoggerLevelDebug, @"I-COR000002", @"A"));
+    XCTAssertTrue(GULLoggerShouldSuppressDuplicate(GULLoggerLevelDebug, @"I-COR000002", @"A"));
+
+    // Different messages, or the same message under another code, are not duplicates.
+    XCTAssertFalse(GULLoggerShouldSuppressDuplicate(GULLoggerLevelDebug, @"I-COR000002", @"B"));
+    XCTAssertFalse(GULLoggerShouldSuppressDuplicate(GULLoggerLevelDebug, @"I-COR000003", @"B"));
+  });
+}
+
 // asl_set_filter does not perform as expected in unit test environment with simulator. The
 // following test only checks whether the logs have been sent to system with the default settings in
 // the unit test environment.
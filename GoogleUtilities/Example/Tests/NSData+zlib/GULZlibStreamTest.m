@@ -0,0 +1,161 @@
+// Copyright 2019 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <XCTest/XCTest.h>
+
+#import <GoogleUtilities/GULNSData+zlib.h>
+#import <GoogleUtilities/GULZlibStream.h>
+
+@interface GULZlibStreamTest : XCTestCase
+@end
+
+@implementation GULZlibStreamTest
+
+/// Returns data that compresses well but isn't a single repeated byte.
+- (NSData *)payloadOfLength:(NSUInteger)length {
+  NSMutableData *data = [NSMutableData dataWithLength:length];
+  uint8_t *bytes = data.mutableBytes;
+  for (NSUInteger i = 0; i < length; i++) {
+    bytes[i] = (uint8_t)((i * 7) % 61);
+  }
+  return data;
+}
+
+/// Feeds the data to the stream in chunks of the given size and finishes the payload.
+- (NSData *)processData:(NSData *)data
+               inChunks:(NSUInteger)chunkSize
+             withStream:(GULZlibStream *)stream
+                  error:(NSError **)error {
+  NSMutableData *output = [NSMutableData data];
+  for (NSUInteger offset = 0; offset < data.length; offset += chunkSize) {
+    NSUInteger length = MIN(chunkSize, data.length - offset);
+    NSData *chunk = [stream processData:[data subdataWithRange:NSMakeRange(offset, length)]
+                                  error:error];
+    if (!chunk) {
+      return nil;
+    }
+    [output appendData:chunk];
+  }
+  NSData *end = [stream finishWithError:error];
+  if (!end) {
+    return nil;
+  }
+  [output appendData:end];
+  return output;
+}
+
+- (void)testRoundTrip {
+  NSData *payload = [self payloadOfLength:100 * 1024];
+  NSError *error;
+  GULZlibStream *gzip =
+      [GULZlibStream gzipStreamWithCompressionLevel:GULZlibStreamDefaultCompressionLevel
+                                              error:&error];
+  GULZlibStream *inflate = [GULZlibStream inflateStreamWithError:&error];
+  XCTAssertNotNil(gzip);
+  XCTAssertNotNil(inflate);
+
+  NSData *gzipped = [self processData:payload inChunks:payload.length withStream:gzip error:&error];
+  XCTAssertNotNil(gzipped, @"%@", error);
+  XCTAssertLessThan(gzipped.length, payload.length);
+  XCTAssertEqualObjects([NSData gul_dataByInflatingGzippedData:gzipped error:NULL], payload);
+
+  NSData *inflated = [self processData:gzipped
+                              inChunks:gzipped.length
+                            withStream:inflate
+                                 error:&error];
+  XCTAssertEqualObjects(inflated, payload, @"%@", error);
+}
+
+- (void)testChunkedInput {
+  NSData *payload = [self payloadOfLength:100 * 1024];
+  GULZlibStream *gzip =
+      [GULZlibStream gzipStreamWithCompressionLevel:GULZlibStreamDefaultCompressionLevel
+                                              error:NULL];
+  GULZlibStream *inflate = [GULZlibStream inflateStreamWithError:NULL];
+
+  NSError *error;
+  NSData *gzipped = [self processData:payload inChunks:1000 withStream:gzip error:&error];
+  XCTAssertNotNil(gzipped, @"%@", error);
+
+  // Chunks that split the gzip header and trailer still inflate to the original payload.
+  NSData *inflated = [self processData:gzipped inChunks:7 withStream:inflate error:&error];
+  XCTAssertEqualObjects(inflated, payload, @"%@", error);
+
+  // The streams are reused for the next payload.
+  NSData *small = [self payloadOfLength:10];
+  gzipped = [self processData:small inChunks:3 withStream:gzip error:&error];
+  inflated = [self processData:gzipped inChunks:3 withStream:inflate error:&error];
+  XCTAssertEqualObjects(inflated, small, @"%@", error);
+}
+
+- (void)testCorruptInput {
+  NSData *payload = [self payloadOfLength:10 * 1024];
+  NSData *gzipped = [NSData gul_dataByGzippingData:payload error:NULL];
+  NSMutableData *corrupt = [gzipped mutableCopy];
+  memset((uint8_t *)corrupt.mutableBytes + 10, 0xFF, 32);
+
+  GULZlibStream *inflate = [GULZlibStream inflateStreamWithError:NULL];
+  NSError *error;
+  XCTAssertNil([self processData:corrupt inChunks:corrupt.length withStream:inflate error:&error]);
+  XCTAssertEqualObjects(error.domain, GULNSDataZlibErrorDomain);
+  XCTAssertEqual(error.code, GULNSDataZlibErrorInternal);
+
+  // The failed payload doesn't leave the stream unusable.
+  error = nil;
+  NSData *inflated = [self processData:gzipped
+                              inChunks:gzipped.length
+                            withStream:inflate
+                                 error:&error];
+  XCTAssertEqualObjects(inflated, payload, @"%@", error);
+}
+
+- (void)testTruncatedInput {
+  NSData *payload = [self payloadOfLength:10 * 1024];
+  NSData *gzipped = [NSData gul_dataByGzippingData:payload error:NULL];
+  NSData *truncated = [gzipped subdataWithRange:NSMakeRange(0, gzipped.length / 2)];
+
+  GULZlibStream *inflate = [GULZlibStream inflateStreamWithError:NULL];
+  NSError *error;
+  XCTAssertNil([self processData:truncated
+                        inChunks:truncated.length
+                      withStream:inflate
+                           error:&error]);
+  XCTAssertEqual(error.code, GULNSDataZlibErrorInternal);
+
+  error = nil;
+  XCTAssertEqualObjects([self processData:gzipped inChunks:100 withStream:inflate error:&error],
+                        payload, @"%@", error);
+}
+
+- (void)testDataAfterEndOfPayload {
+  NSData *payload = [self payloadOfLength:1024];
+  NSMutableData *gzipped = [[NSData gul_dataByGzippingData:payload error:NULL] mutableCopy];
+  NSUInteger validLength = gzipped.length;
+  [gzipped appendBytes:"extra" length:5];
+
+  GULZlibStream *inflate = [GULZlibStream inflateStreamWithError:NULL];
+  NSError *error;
+  XCTAssertNil([inflate processData:gzipped error:&error]);
+  XCTAssertEqual(error.code, GULNSDataZlibErrorDataRemaining);
+
+  error = nil;
+  NSData *valid = [gzipped subdataWithRange:NSMakeRange(0, validLength)];
+  NSData *inflated = [self processData:valid
+                              inChunks:validLength
+                            withStream:inflate
+                                 error:&error];
+  XCTAssertEqualObjects(inflated, payload, @"%@", error);
+}
+
+@end
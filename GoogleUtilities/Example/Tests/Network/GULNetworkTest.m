@@ -172,6 +172,74 @@
                                }];
 }
 
+- (void)testUncompressedPayloadBelowThreshold_POST_foreground {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Expect block is called"];
+
+  NSData *uncompressedData = [@"Google" dataUsingEncoding:NSUTF8StringEncoding];
+  NSURL *url =
+      [NSURL URLWithString:[NSString stringWithFormat:@"http://localhost:%d/2", _httpServer.port]];
+  _statusCode = 200;
+  _network.compressionThreshold = uncompressedData.length + 1;
+
+  [_network postURL:url
+                     payload:uncompressedData
+                       queue:_backgroundQueue
+      usingBackgroundSession:NO
+           completionHandler:^(NSHTTPURLResponse *response, NSData *data, NSError *error) {
+             [self verifyResponse:response error:error];
+             XCTAssertEqualObjects([self->_request body], uncompressedData);
+             XCTAssertNil([self->_request.allHeaderFieldValues valueForKey:@"Content-Encoding"]);
+             [expectation fulfill];
+           }];
+  // Wait a little bit so the server has enough time to respond.
+  [self waitForExpectationsWithTimeout:10
+                               handler:^(NSError *error) {
+                                 if (error) {
+                                   XCTFail(@"Timeout Error: %@", error);
+                                 }
+                               }];
+}
+
+- (void)testConcurrentRequests_POST_foreground {
+  XCTestExpectation *expectation1 = [self expectationWithDescription:@"Expect block 1 is called"];
+  XCTestExpectation *expectation2 = [self expectationWithDescription:@"Expect block 2 is called"];
+
+  NSData *uncompressedData = [@"Google" dataUsingEncoding:NSUTF8StringEncoding];
+  NSURL *url =
+      [NSURL URLWithString:[NSString stringWithFormat:@"http://localhost:%d/2", _httpServer.port]];
+  _statusCode = 200;
+
+  NSString *requestID1 =
+      [_network postURL:url
+                         payload:uncompressedData
+                           queue:_backgroundQueue
+          usingBackgroundSession:NO
+               completionHandler:^(NSHTTPURLResponse *response, NSData *data, NSError *error) {
+                 [self verifyResponse:response error:error];
+                 [expectation1 fulfill];
+               }];
+  NSString *requestID2 =
+      [_network postURL:url
+                         payload:uncompressedData
+                           queue:_backgroundQueue
+          usingBackgroundSession:NO
+               completionHandler:^(NSHTTPURLResponse *response, NSData *data, NSError *error) {
+                 [self verifyResponse:response error:error];
+                 [expectation2 fulfill];
+               }];
+  XCTAssertNotNil(requestID1);
+  XCTAssertNotNil(requestID2);
+  XCTAssertNotEqualObjects(requestID1, requestID2);
+  XCTAssertTrue(self->_network.hasUploadInProgress, "There must be pending requests");
+  // Wait a little bit so the server has enough time to respond.
+  [self waitForExpectationsWithTimeout:10
+                               handler:^(NSError *error) {
+                                 if (error) {
+                                   XCTFail(@"Timeout Error: %@", error);
+                                 }
+                               }];
+}
+
 - (void)testNilURLNSURLSession_POST_foreground {
   XCTestExpectation *expectation = [self expectationWithDescription:@"Expect block is called"];
 
@@ -464,6 +464,38 @@ static const NSTimeInterval kGULTestCaseTimeoutInterval = 10;
   [self removePreferenceFileWithSuiteName:suiteName];
 }
 
+- (void)testScheduledSynchronizeToDisk {
+#if TARGET_OS_OSX
+  // See testSynchronizeToDisk for why this is disabled on macOS.
+  return;
+#endif  // TARGET_OS_OSX
+  NSString *suiteName = @"scheduled_synchronize_test_suite";
+  NSString *filePath = [self filePathForPreferencesName:suiteName];
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  [fileManager removeItemAtPath:filePath error:NULL];
+
+  // Several writes from a background queue are written to disk without calling synchronize.
+  GULUserDefaults *newUserDefaults = [[GULUserDefaults alloc] initWithSuiteName:suiteName];
+  dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    for (int i = 0; i < 10; i++) {
+      [newUserDefaults setInteger:i forKey:@"counter"];
+    }
+  });
+  XCTAssertEqual([newUserDefaults integerForKey:@"counter"], 9);
+
+  NSPredicate *fileExists = [NSPredicate predicateWithBlock:^BOOL(id object, NSDictionary *_) {
+    return [fileManager fileExistsAtPath:filePath];
+  }];
+  XCTestExpectation *expectation = [self expectationForPredicate:fileExists
+                                             evaluatedWithObject:self
+                                                         handler:nil];
+  [self waitForExpectations:@[ expectation ] timeout:kGULTestCaseTimeoutInterval];
+
+  [newUserDefaults clearAllData];
+  [newUserDefaults synchronize];
+  [self removePreferenceFileWithSuiteName:suiteName];
+}
+
 - (void)testInvalidKeys {
   NSString *suiteName = @"test_suite_invalid_key";
   GULUserDefaults *newUserDefaults = [[GULUserDefaults alloc] initWithSuiteName:suiteName];
@@ -37,6 +37,26 @@ static const char *sVersion = "";
 
 static GULLoggerService kGULLoggerLogger = @"[GULLogger]";
 
+/// Identical Info and Debug messages logged with the same message code within this interval are
+/// logged only once.
+static const NSTimeInterval kGULLoggerDuplicateSuppressionInterval = 1;
+
+/// The last message logged for a message code, used to suppress duplicates.
+@interface GULLoggerMessageRecord : NSObject
+
+@property(nonatomic, copy) NSString *message;
+@property(nonatomic) GULLoggerLevel level;
+@property(nonatomic) CFAbsoluteTime timestamp;
+@property(nonatomic) NSUInteger suppressedCount;
+
+@end
+
+@implementation GULLoggerMessageRecord
+@end
+
+/// The last message logged for each message code. Only accessed on sGULClientQueue.
+static NSMutableDictionary<NSString *, GULLoggerMessageRecord *> *sGULLoggerMessageRecords;
+
 #ifdef DEBUG
 /// The regex pattern for the message code.
 static NSString *const kMessageCodePattern = @"^I-[A-Z]{3}[0-9]{6}$";
@@ -68,6 +88,7 @@ void GULLoggerInitializeASL(void) {
     // Set the filter used by system/device log. Initialize in default mode.
     asl_set_filter(sGULLoggerClient, ASL_FILTER_MASK_UPTO(ASL_LEVEL_NOTICE));
 
+    sGULLoggerMessageRecords = [[NSMutableDictionary alloc] init];
     sGULClientQueue = dispatch_queue_create("GULLoggingClientQueue", DISPATCH_QUEUE_SERIAL);
     dispatch_set_target_queue(sGULClientQueue,
                               dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0));
@@ -138,6 +159,37 @@ BOOL getGULLoggerDebugMode() {
 }
 #endif
 
+/**
+ * Returns YES if the message is identical to the one last logged for the message code within the
+ * suppression interval. Once a different message is logged for the code, or the interval has
+ * passed, the number of suppressed messages is logged first. Must be called on sGULClientQueue.
+ */
+BOOL GULLoggerShouldSuppressDuplicate(GULLoggerLevel level,
+                                      NSString *messageCode,
+                                      NSString *message) {
+  CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+  GULLoggerMessageRecord *record = sGULLoggerMessageRecords[messageCode];
+  if (record && [record.message isEqualToString:message] &&
+      now - record.timestamp < kGULLoggerDuplicateSuppressionInterval) {
+    record.suppressedCount++;
+    return YES;
+  }
+
+  if (record.suppressedCount > 0) {
+    asl_log(sGULLoggerClient, NULL, record.level, "%s - [%s] %lu identical messages suppressed.",
+            sVersion, messageCode.UTF8String, (unsigned long)record.suppressedCount);
+  }
+  if (!record) {
+    record = [[GULLoggerMessageRecord alloc] init];
+    sGULLoggerMessageRecords[messageCode] = record;
+  }
+  record.message = message;
+  record.level = level;
+  record.timestamp = now;
+  record.suppressedCount = 0;
+  return NO;
+}
+
 void GULLoggerRegisterVersion(const char *version) {
   sVersion = version;
 }
@@ -164,6 +216,11 @@ void GULLogBasic(GULLoggerLevel level,
   NSString *logMsg = [[NSString alloc] initWithFormat:message arguments:args_ptr];
   logMsg = [NSString stringWithFormat:@"%s - %@[%@] %@", sVersion, service, messageCode, logMsg];
   dispatch_async(sGULClientQueue, ^{
+    // Errors, warnings and notices are rare enough that they're always logged.
+    if (level >= GULLoggerLevelInfo &&
+        GULLoggerShouldSuppressDuplicate(level, messageCode, logMsg)) {
+      return;
+    }
     asl_log(sGULLoggerClient, NULL, level, "%s", logMsg.UTF8String);
   });
 }
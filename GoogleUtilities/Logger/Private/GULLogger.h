@@ -66,6 +66,8 @@ extern void GULLoggerRegisterVersion(const char *version);
 /**
  * Logs a message to the Xcode console and the device log. If running from AppStore, will
  * not log any messages with a level higher than GULLoggerLevelNotice to avoid log spamming.
+ * The message is written asynchronously. Identical Info and Debug messages logged with the same
+ * message code in quick succession are logged once, followed by the number of duplicates dropped.
  * (required) log level (one of the GULLoggerLevel enum values).
  * (required) service name of type GULLoggerService.
  * (required) message code starting with "I-" which means iOS, followed by a capitalized
@@ -133,6 +135,31 @@ extern void GULLogDebug(GULLoggerService service,
 }  // extern "C"
 #endif  // __cplusplus
 
+/**
+ * The following macros take the same parameters as the functions above, but check the level before
+ * anything else, so the arguments aren't evaluated and the message isn't formatted unless it's
+ * going to be logged. Prefer them on hot paths.
+ * Example usage:
+ * GUL_LOG_DEBUG(kGULLoggerCore, NO, @"I-COR000001", @"Loaded %@.", [object expensiveDescription]);
+ */
+#define GUL_LOG_IF_LOGGABLE(level, service, force, messageCode, ...)  \
+  do {                                                                 \
+    if ((force) || GULIsLoggableLevel(GULLoggerLevel##level)) {        \
+      GULLog##level((service), (force), (messageCode), __VA_ARGS__);   \
+    }                                                                  \
+  } while (0)
+
+#define GUL_LOG_ERROR(service, force, messageCode, ...) \
+  GUL_LOG_IF_LOGGABLE(Error, service, force, messageCode, __VA_ARGS__)
+#define GUL_LOG_WARNING(service, force, messageCode, ...) \
+  GUL_LOG_IF_LOGGABLE(Warning, service, force, messageCode, __VA_ARGS__)
+#define GUL_LOG_NOTICE(service, force, messageCode, ...) \
+  GUL_LOG_IF_LOGGABLE(Notice, service, force, messageCode, __VA_ARGS__)
+#define GUL_LOG_INFO(service, force, messageCode, ...) \
+  GUL_LOG_IF_LOGGABLE(Info, service, force, messageCode, __VA_ARGS__)
+#define GUL_LOG_DEBUG(service, force, messageCode, ...) \
+  GUL_LOG_IF_LOGGABLE(Debug, service, force, messageCode, __VA_ARGS__)
+
 @interface GULLoggerWrapper : NSObject
 
 /**
@@ -18,7 +18,7 @@
 
 // NOTE: For 64bit, none of these apis handle input sizes >32bits, they will return nil when given
 // such data. To handle data of that size you really should be streaming it rather then doing it all
-// in memory.
+// in memory, see GULZlibStream.
 
 @interface NSData (GULGzip)
 
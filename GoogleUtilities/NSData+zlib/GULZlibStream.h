@@ -0,0 +1,56 @@
+// Copyright 2018 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// The compression level zlib picks as a balance between speed and size.
+FOUNDATION_EXPORT const int GULZlibStreamDefaultCompressionLevel;
+
+/// Gzips or inflates data a chunk at a time, so that large payloads can be processed with bounded
+/// memory. The underlying z_stream and its output buffer are reused: once a payload is finished,
+/// the same object can process the next one. Errors are reported in GULNSDataZlibErrorDomain.
+/// This is not thread safe.
+@interface GULZlibStream : NSObject
+
+/// Creates a stream that gzips its input with the given compression level, from 0 (no compression)
+/// to 9 (best compression), or GULZlibStreamDefaultCompressionLevel.
++ (nullable instancetype)gzipStreamWithCompressionLevel:(int)compressionLevel
+                                                  error:(NSError **)error;
+
+/// Creates a stream that inflates gzip or zlib compressed input.
++ (nullable instancetype)inflateStreamWithError:(NSError **)error;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Processes the next chunk of the payload and returns the output it produced, which may be empty
+/// since zlib buffers input internally. Returns nil if an error occurs, in which case the rest of
+/// the payload is dropped and the stream is ready to process another payload.
+- (nullable NSData *)processData:(NSData *)data error:(NSError **)error;
+
+/// Ends the current payload and returns the remaining output. The stream is then ready to process
+/// another payload. Returns nil if an error occurs, for example if compressed input was truncated.
+- (nullable NSData *)finishWithError:(NSError **)error;
+
+/// Reads the input stream until its end, writes the processed data to the output stream and
+/// finishes the payload. Both streams must already be open and are left open. Returns NO if an
+/// error occurs while reading, processing or writing.
+- (BOOL)processInputStream:(NSInputStream *)inputStream
+            toOutputStream:(NSOutputStream *)outputStream
+                     error:(NSError **)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,282 @@
+// Copyright 2018 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "GULZlibStream.h"
+
+#import <zlib.h>
+
+#import "GULNSData+zlib.h"
+
+/// The size of the buffers used to read input and collect output.
+#define kGULZlibStreamChunkSize (16 * 1024)
+
+const int GULZlibStreamDefaultCompressionLevel = Z_DEFAULT_COMPRESSION;
+
+/// Receives the output of the stream, returns NO if it couldn't be consumed.
+typedef BOOL (^GULZlibStreamSink)(const uint8_t *bytes, NSUInteger length, NSError **error);
+
+/// Returns an error for the zlib return code, with the message of the stream if there is one.
+static NSError *GULZlibStreamError(NSInteger code, int retCode, z_stream *strm) {
+  NSMutableDictionary *userInfo =
+      [NSMutableDictionary dictionaryWithObject:@(retCode) forKey:GULNSDataZlibErrorKey];
+  if (strm && strm->msg) {
+    NSString *message = [NSString stringWithUTF8String:strm->msg];
+    if (message) {
+      userInfo[NSLocalizedDescriptionKey] = message;
+    }
+  }
+  return [NSError errorWithDomain:GULNSDataZlibErrorDomain code:code userInfo:userInfo];
+}
+
+@implementation GULZlibStream {
+  /// The zlib state, reset rather than recreated between payloads.
+  z_stream _stream;
+
+  /// YES if the stream gzips its input, NO if it inflates it.
+  BOOL _gzipping;
+
+  /// Whether the current payload got any input.
+  BOOL _receivedInput;
+
+  /// Whether inflating reached the end of the compressed payload.
+  BOOL _ended;
+
+  /// The buffer output is collected into before being handed to a sink.
+  uint8_t _buffer[kGULZlibStreamChunkSize];
+}
+
++ (instancetype)gzipStreamWithCompressionLevel:(int)compressionLevel error:(NSError **)error {
+  return [[self alloc] initWithGzipping:YES compressionLevel:compressionLevel error:error];
+}
+
++ (instancetype)inflateStreamWithError:(NSError **)error {
+  return [[self alloc] initWithGzipping:NO
+                       compressionLevel:Z_DEFAULT_COMPRESSION
+                                  error:error];
+}
+
+- (instancetype)initWithGzipping:(BOOL)gzipping
+                compressionLevel:(int)compressionLevel
+                           error:(NSError **)error {
+  self = [super init];
+  if (self) {
+    _gzipping = gzipping;
+    bzero(&_stream, sizeof(z_stream));
+
+    int retCode;
+    if (gzipping) {
+      int memLevel = 8;          // Default.
+      int windowBits = 15 + 16;  // Enable gzip header instead of zlib header.
+      retCode = deflateInit2(&_stream, compressionLevel, Z_DEFLATED, windowBits, memLevel,
+                             Z_DEFAULT_STRATEGY);
+    } else {
+      int windowBits = 15;  // 15 to enable any window size
+      windowBits += 32;     // and +32 to enable zlib or gzip header detection.
+      retCode = inflateInit2(&_stream, windowBits);
+    }
+    if (retCode != Z_OK) {
+      if (error) {
+        *error = GULZlibStreamError(GULNSDataZlibErrorInternal, retCode, NULL);
+      }
+      // The z_stream wasn't initialized, so dealloc must not end it.
+      _gzipping = NO;
+      _stream.state = NULL;
+      return nil;
+    }
+  }
+  return self;
+}
+
+- (void)dealloc {
+  if (!_stream.state) {
+    return;
+  }
+  if (_gzipping) {
+    deflateEnd(&_stream);
+  } else {
+    inflateEnd(&_stream);
+  }
+}
+
+#pragma mark - Processing
+
+- (NSData *)processData:(NSData *)data error:(NSError **)error {
+  NSMutableData *output = [NSMutableData data];
+  BOOL processed = [self processBytes:data.bytes
+                               length:data.length
+                                 sink:[self sinkAppendingToData:output]
+                                error:error];
+  if (!processed) {
+    // zlib can't continue a stream it failed on, so drop the rest of the payload.
+    [self reset];
+    return nil;
+  }
+  return output;
+}
+
+- (NSData *)finishWithError:(NSError **)error {
+  NSMutableData *output = [NSMutableData data];
+  BOOL finished = [self finishIntoSink:[self sinkAppendingToData:output] error:error];
+  return finished ? output : nil;
+}
+
+- (BOOL)processInputStream:(NSInputStream *)inputStream
+            toOutputStream:(NSOutputStream *)outputStream
+                     error:(NSError **)error {
+  GULZlibStreamSink sink = [self sinkWritingToStream:outputStream];
+  uint8_t input[kGULZlibStreamChunkSize];
+  while (YES) {
+    NSInteger bytesRead = [inputStream read:input maxLength:kGULZlibStreamChunkSize];
+    if (bytesRead < 0) {
+      if (error) {
+        *error = inputStream.streamError
+                     ?: GULZlibStreamError(GULNSDataZlibErrorInternal, Z_ERRNO, NULL);
+      }
+      [self reset];
+      return NO;
+    }
+    if (bytesRead == 0) {
+      break;
+    }
+    if (![self processBytes:input length:(NSUInteger)bytesRead sink:sink error:error]) {
+      [self reset];
+      return NO;
+    }
+  }
+  return [self finishIntoSink:sink error:error];
+}
+
+#pragma mark - Private
+
+/// Feeds the bytes to zlib and hands everything it outputs to the sink.
+- (BOOL)processBytes:(const void *)bytes
+              length:(NSUInteger)length
+                sink:(GULZlibStreamSink)sink
+               error:(NSError **)error {
+  const uint8_t *next = bytes;
+  while (length > 0) {
+    if (_ended) {
+      // There was more data tacked onto the end of a valid compressed stream.
+      if (error) {
+        *error = [NSError errorWithDomain:GULNSDataZlibErrorDomain
+                                     code:GULNSDataZlibErrorDataRemaining
+                                 userInfo:@{GULNSDataZlibRemainingBytesKey : @(length)}];
+      }
+      return NO;
+    }
+
+    // avail_in is 32 bits wide, so feed larger inputs in slices.
+    unsigned int sliceLength = (unsigned int)MIN(length, (NSUInteger)UINT_MAX);
+    _stream.next_in = (Bytef *)next;
+    _stream.avail_in = sliceLength;
+    _receivedInput = YES;
+    if (![self runWithFlush:Z_NO_FLUSH sink:sink error:error]) {
+      return NO;
+    }
+
+    NSUInteger consumed = sliceLength - _stream.avail_in;
+    next += consumed;
+    length -= consumed;
+  }
+  return YES;
+}
+
+/// Flushes the end of the payload to the sink and resets the stream for the next payload.
+- (BOOL)finishIntoSink:(GULZlibStreamSink)sink error:(NSError **)error {
+  _stream.next_in = NULL;
+  _stream.avail_in = 0;
+
+  BOOL finished = YES;
+  if (_gzipping) {
+    finished = [self runWithFlush:Z_FINISH sink:sink error:error];
+  } else if (_receivedInput && !_ended) {
+    // The compressed payload is incomplete.
+    if (error) {
+      *error = GULZlibStreamError(GULNSDataZlibErrorInternal, Z_BUF_ERROR, &_stream);
+    }
+    finished = NO;
+  }
+  [self reset];
+  return finished;
+}
+
+/// Runs zlib on the pending input until it needs more input, or until the stream ends when
+/// finishing.
+- (BOOL)runWithFlush:(int)flush sink:(GULZlibStreamSink)sink error:(NSError **)error {
+  int retCode;
+  do {
+    _stream.next_out = _buffer;
+    _stream.avail_out = kGULZlibStreamChunkSize;
+    retCode = _gzipping ? deflate(&_stream, flush) : inflate(&_stream, Z_NO_FLUSH);
+    // Z_BUF_ERROR only means no progress was possible, which isn't fatal unless finishing.
+    BOOL stalled = (retCode == Z_BUF_ERROR && flush != Z_FINISH);
+    if (retCode != Z_OK && retCode != Z_STREAM_END && !stalled) {
+      if (error) {
+        *error = GULZlibStreamError(GULNSDataZlibErrorInternal, retCode, &_stream);
+      }
+      return NO;
+    }
+
+    NSUInteger produced = kGULZlibStreamChunkSize - _stream.avail_out;
+    if (produced > 0 && !sink(_buffer, produced, error)) {
+      return NO;
+    }
+    if (retCode == Z_STREAM_END) {
+      _ended = YES;
+      return YES;
+    }
+    if (stalled) {
+      return YES;
+    }
+  } while (flush == Z_FINISH || _stream.avail_out == 0);
+  return YES;
+}
+
+/// Prepares the stream for the next payload without reallocating the zlib state.
+- (void)reset {
+  if (_gzipping) {
+    deflateReset(&_stream);
+  } else {
+    inflateReset(&_stream);
+  }
+  _receivedInput = NO;
+  _ended = NO;
+}
+
+- (GULZlibStreamSink)sinkAppendingToData:(NSMutableData *)data {
+  return ^BOOL(const uint8_t *bytes, NSUInteger length, NSError **error) {
+    [data appendBytes:bytes length:length];
+    return YES;
+  };
+}
+
+- (GULZlibStreamSink)sinkWritingToStream:(NSOutputStream *)stream {
+  return ^BOOL(const uint8_t *bytes, NSUInteger length, NSError **error) {
+    while (length > 0) {
+      NSInteger written = [stream write:bytes maxLength:length];
+      if (written <= 0) {
+        if (error) {
+          *error =
+              stream.streamError ?: GULZlibStreamError(GULNSDataZlibErrorInternal, Z_ERRNO, NULL);
+        }
+        return NO;
+      }
+      bytes += written;
+      length -= (NSUInteger)written;
+    }
+    return YES;
+  };
+}
+
+@end
@@ -113,28 +113,37 @@ static NSString *const kGULNetworkLogTag = @"Google/Utilities/Network";
     return nil;
   }
 
-  NSError *compressError = nil;
-  NSData *compressedData = [NSData gul_dataByGzippingData:payload error:&compressError];
-  if (!compressedData || compressError) {
-    if (compressError || payload.length > 0) {
-      // If the payload is not empty but it fails to compress the payload, something has been wrong.
-      [self handleErrorWithCode:GULErrorCodeNetworkPayloadCompression
-                          queue:queue
-                    withHandler:handler];
-      return nil;
+  // Payloads smaller than the threshold are sent as is, since compressing them saves too little to
+  // be worth the time.
+  BOOL shouldCompress = payload.length >= _compressionThreshold;
+  NSData *body = payload ?: [[NSData alloc] init];
+  if (shouldCompress) {
+    NSError *compressError = nil;
+    body = [NSData gul_dataByGzippingData:payload error:&compressError];
+    if (!body || compressError) {
+      if (compressError || payload.length > 0) {
+        // If the payload is not empty but it fails to compress the payload, something has been
+        // wrong.
+        [self handleErrorWithCode:GULErrorCodeNetworkPayloadCompression
+                            queue:queue
+                      withHandler:handler];
+        return nil;
+      }
+      body = [[NSData alloc] init];
     }
-    compressedData = [[NSData alloc] init];
   }
 
-  NSString *postLength = @(compressedData.length).stringValue;
+  NSString *postLength = @(body.length).stringValue;
 
-  // Set up the request with the compressed data.
+  // Set up the request with the (possibly compressed) data.
   [request setValue:postLength forHTTPHeaderField:kGULNetworkContentLengthKey];
-  request.HTTPBody = compressedData;
+  request.HTTPBody = body;
   request.HTTPMethod = kGULNetworkPOSTRequestMethod;
   [request setValue:kGULNetworkContentTypeValue forHTTPHeaderField:kGULNetworkContentTypeKey];
-  [request setValue:kGULNetworkContentCompressionValue
-      forHTTPHeaderField:kGULNetworkContentCompressionKey];
+  if (shouldCompress) {
+    [request setValue:kGULNetworkContentCompressionValue
+        forHTTPHeaderField:kGULNetworkContentCompressionKey];
+  }
 
   GULNetworkURLSession *fetcher = [[GULNetworkURLSession alloc] initWithNetworkLoggerDelegate:self];
   fetcher.backgroundNetworkEnabled = usingBackgroundSession;
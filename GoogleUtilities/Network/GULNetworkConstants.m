@@ -21,6 +21,7 @@ NSString *const kGULNetworkApplicationSupportSubdirectory = @"GUL/Network";
 NSString *const kGULNetworkTempDirectoryName = @"GULNetworkTemporaryDirectory";
 const NSTimeInterval kGULNetworkTempFolderExpireTime = 60 * 60;  // 1 hour
 const NSTimeInterval kGULNetworkTimeOutInterval = 60;            // 1 minute.
+const NSInteger kGULNetworkMaximumConnectionsPerHost = 4;
 NSString *const kGULNetworkReachabilityHost = @"app-measurement.com";
 NSString *const kGULNetworkErrorContext = @"Context";
 
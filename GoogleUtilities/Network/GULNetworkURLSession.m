@@ -26,6 +26,93 @@
                                     NSURLSessionDownloadDelegate>
 @end
 
+/// The delegate of the shared foreground session. An NSURLSession has a single delegate, so this
+/// forwards the events of each task to the fetcher that started it.
+API_AVAILABLE(ios(7.0))
+@interface GULNetworkURLSessionTaskRouter
+    : NSObject <NSURLSessionTaskDelegate, NSURLSessionDownloadDelegate>
+
+/// Routes the events of the task to the fetcher until the task completes.
+- (void)setFetcher:(GULNetworkURLSession *)fetcher forTask:(NSURLSessionTask *)task;
+
+@end
+
+@implementation GULNetworkURLSessionTaskRouter {
+  /// The fetchers of the tasks in flight by task identifier. Guarded by `@synchronized(self)`.
+  NSMutableDictionary<NSNumber *, GULNetworkURLSession *> *_fetchers;
+}
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _fetchers = [[NSMutableDictionary alloc] init];
+  }
+  return self;
+}
+
+- (void)setFetcher:(GULNetworkURLSession *)fetcher forTask:(NSURLSessionTask *)task {
+  @synchronized(self) {
+    _fetchers[@(task.taskIdentifier)] = fetcher;
+  }
+}
+
+- (nullable GULNetworkURLSession *)fetcherForTask:(NSURLSessionTask *)task {
+  @synchronized(self) {
+    return _fetchers[@(task.taskIdentifier)];
+  }
+}
+
+- (void)URLSession:(NSURLSession *)session
+                 downloadTask:(NSURLSessionDownloadTask *)task
+    didFinishDownloadingToURL:(NSURL *)url {
+  [[self fetcherForTask:task] URLSession:session downloadTask:task didFinishDownloadingToURL:url];
+}
+
+- (void)URLSession:(NSURLSession *)session
+                    task:(NSURLSessionTask *)task
+    didCompleteWithError:(NSError *)error {
+  GULNetworkURLSession *fetcher = [self fetcherForTask:task];
+  @synchronized(self) {
+    [_fetchers removeObjectForKey:@(task.taskIdentifier)];
+  }
+  [fetcher URLSession:session task:task didCompleteWithError:error];
+}
+
+- (void)URLSession:(NSURLSession *)session
+                   task:(NSURLSessionTask *)task
+    didReceiveChallenge:(NSURLAuthenticationChallenge *)challenge
+      completionHandler:(void (^)(NSURLSessionAuthChallengeDisposition disposition,
+                                  NSURLCredential *credential))completionHandler {
+  GULNetworkURLSession *fetcher = [self fetcherForTask:task];
+  if (!fetcher) {
+    completionHandler(NSURLSessionAuthChallengePerformDefaultHandling, nil);
+    return;
+  }
+  [fetcher URLSession:session
+                     task:task
+      didReceiveChallenge:challenge
+        completionHandler:completionHandler];
+}
+
+- (void)URLSession:(NSURLSession *)session
+                          task:(NSURLSessionTask *)task
+    willPerformHTTPRedirection:(NSHTTPURLResponse *)response
+                    newRequest:(NSURLRequest *)request
+             completionHandler:(void (^)(NSURLRequest *))completionHandler {
+  GULNetworkURLSession *fetcher = [self fetcherForTask:task];
+  if (!fetcher) {
+    completionHandler(request);
+    return;
+  }
+  [fetcher URLSession:session
+                            task:task
+      willPerformHTTPRedirection:response
+                      newRequest:request
+               completionHandler:completionHandler];
+}
+
+@end
+
 @implementation GULNetworkURLSession {
   /// The handler to be called when the request completes or error has occurs.
   GULNetworkURLSessionCompletionHandler _completionHandler;
@@ -53,6 +140,10 @@
 
   /// The current request.
   NSURLRequest *_request;
+
+  /// Whether the current request was sent through the shared foreground session, which must not be
+  /// invalidated once the request completes.
+  BOOL _usesSharedSession;
 }
 
 #pragma mark - Init
@@ -147,12 +238,9 @@
     postRequestTask = [session uploadTaskWithRequest:request fromFile:_uploadingFileURL];
   } else {
     // If we cannot write to file, just send it in the foreground.
-    _sessionConfig = [NSURLSessionConfiguration defaultSessionConfiguration];
-    [self populateSessionConfig:_sessionConfig withRequest:request];
-    session = [NSURLSession sessionWithConfiguration:_sessionConfig
-                                            delegate:self
-                                       delegateQueue:[NSOperationQueue mainQueue]];
+    session = [[self class] sharedForegroundSession];
     postRequestTask = [session uploadTaskWithRequest:request fromData:request.HTTPBody];
+    _usesSharedSession = YES;
   }
 
   if (!session || !postRequestTask) {
@@ -165,9 +253,7 @@
   }
 
   _URLSession = session;
-
-  // Save the session into memory.
-  [[self class] setSessionInFetcherMap:self forSessionID:_sessionID];
+  [self registerTask:postRequestTask];
 
   _request = [request copy];
 
@@ -183,20 +269,21 @@
 - (nullable NSString *)sessionIDFromAsyncGETRequest:(NSURLRequest *)request
                                   completionHandler:(GULNetworkURLSessionCompletionHandler)handler
     API_AVAILABLE(ios(7.0)) {
+  NSURLSession *session;
   if (_backgroundNetworkEnabled) {
     _sessionConfig = [self backgroundSessionConfigWithSessionID:_sessionID];
-  } else {
-    _sessionConfig = [NSURLSessionConfiguration defaultSessionConfiguration];
-  }
-
-  [self populateSessionConfig:_sessionConfig withRequest:request];
+    [self populateSessionConfig:_sessionConfig withRequest:request];
 
-  // Do not cache the GET request.
-  _sessionConfig.URLCache = nil;
+    // Do not cache the GET request.
+    _sessionConfig.URLCache = nil;
 
-  NSURLSession *session = [NSURLSession sessionWithConfiguration:_sessionConfig
-                                                        delegate:self
-                                                   delegateQueue:[NSOperationQueue mainQueue]];
+    session = [NSURLSession sessionWithConfiguration:_sessionConfig
+                                            delegate:self
+                                       delegateQueue:[NSOperationQueue mainQueue]];
+  } else {
+    session = [[self class] sharedForegroundSession];
+    _usesSharedSession = YES;
+  }
   NSURLSessionDownloadTask *downloadTask = [session downloadTaskWithRequest:request];
 
   if (!session || !downloadTask) {
@@ -209,9 +296,7 @@
   }
 
   _URLSession = session;
-
-  // Save the session into memory.
-  [[self class] setSessionInFetcherMap:self forSessionID:_sessionID];
+  [self registerTask:downloadTask];
 
   _request = [request copy];
 
@@ -294,6 +379,11 @@
   [self maybeRemoveTempFilesAtURL:_networkDirectoryURL
                      expiringTime:kGULNetworkTempFolderExpireTime];
 
+  // The shared session outlives the request, and its fetcher was never added to the fetcher map.
+  if (_usesSharedSession) {
+    return;
+  }
+
   // This is called without checking the sessionID here since non-background sessions
   // won't have an ID.
   [session finishTasksAndInvalidate];
@@ -398,6 +488,38 @@
 
 #pragma mark - Internal Methods
 
+/// Returns the session that sends all foreground requests. Sharing it lets requests to the same host
+/// reuse connections instead of paying for a TLS handshake each time.
++ (NSURLSession *)sharedForegroundSession API_AVAILABLE(ios(7.0)) {
+  static NSURLSession *sharedSession;
+
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSURLSessionConfiguration *config = [NSURLSessionConfiguration defaultSessionConfiguration];
+    // Do not cache the requests. Headers, timeout and cache policy are taken from each request.
+    config.URLCache = nil;
+    config.HTTPMaximumConnectionsPerHost = kGULNetworkMaximumConnectionsPerHost;
+    sharedSession =
+        [NSURLSession sessionWithConfiguration:config
+                                      delegate:[[GULNetworkURLSessionTaskRouter alloc] init]
+                                 delegateQueue:[NSOperationQueue mainQueue]];
+  });
+  return sharedSession;
+}
+
+/// Makes sure the events of the task reach this fetcher. Background sessions are owned by the
+/// fetcher and kept in the fetcher map so they can be found again after the app is relaunched.
+- (void)registerTask:(NSURLSessionTask *)task API_AVAILABLE(ios(7.0)) {
+  if (_usesSharedSession) {
+    GULNetworkURLSessionTaskRouter *router =
+        (GULNetworkURLSessionTaskRouter *)[[self class] sharedForegroundSession].delegate;
+    [router setFetcher:self forTask:task];
+  } else {
+    // Save the session into memory.
+    [[self class] setSessionInFetcherMap:self forSessionID:_sessionID];
+  }
+}
+
 /// Stores system completion handler with session ID as key.
 - (void)addSystemCompletionHandler:(GULNetworkSystemCompletionHandler)handler
                         forSession:(NSString *)identifier {
@@ -40,7 +40,8 @@
 /// Indicates if network connectivity is available.
 @property(nonatomic, readonly, getter=isNetworkConnected) BOOL networkConnected;
 
-/// Indicates if there are any uploads in progress.
+/// Indicates if there are any uploads in progress. Several requests can be in flight at once;
+/// foreground requests share one session, so requests to the same host reuse connections.
 @property(nonatomic, readonly, getter=hasUploadInProgress) BOOL uploadInProgress;
 
 /// An optional delegate that can be used in the event when network reachability changes.
@@ -56,6 +57,11 @@
 /// The time interval in seconds for the network request to timeout.
 @property(nonatomic, assign) NSTimeInterval timeoutInterval;
 
+/// The minimum size in bytes of a POST payload for it to be gzipped. Smaller payloads are sent
+/// uncompressed and without a Content-Encoding header. Default value is 0, which compresses every
+/// payload.
+@property(nonatomic, assign) NSUInteger compressionThreshold;
+
 /// Initializes with the default reachability host.
 - (instancetype)init;
 
@@ -66,9 +72,10 @@
 + (void)handleEventsForBackgroundURLSessionID:(NSString *)sessionID
                             completionHandler:(GULNetworkSystemCompletionHandler)completionHandler;
 
-/// Compresses and sends a POST request with the provided data to the URL. The session will be
-/// background session if usingBackgroundSession is YES. Otherwise, the POST session is default
-/// session. Returns a session ID or nil if an error occurs.
+/// Compresses the provided data if it's at least `compressionThreshold` bytes long and sends it in a
+/// POST request to the URL. The session will be background session if usingBackgroundSession is
+/// YES. Otherwise, the POST session is default session. Returns a session ID or nil if an error
+/// occurs.
 - (NSString *)postURL:(NSURL *)url
                    payload:(NSData *)payload
                      queue:(dispatch_queue_t)queue
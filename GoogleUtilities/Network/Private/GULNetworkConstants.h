@@ -52,6 +52,10 @@ extern const NSTimeInterval kGULNetworkTempFolderExpireTime;
 /// The default network request timeout interval.
 extern const NSTimeInterval kGULNetworkTimeOutInterval;
 
+/// The maximum number of simultaneous connections to a host made by foreground requests. Requests
+/// beyond that wait until a connection is available.
+extern const NSInteger kGULNetworkMaximumConnectionsPerHost;
+
 /// The host to check the reachability of the network.
 extern NSString *const kGULNetworkReachabilityHost;
 
@@ -16,6 +16,10 @@
 
 #import <GoogleUtilities/GULLogger.h>
 
+#if TARGET_OS_IOS || TARGET_OS_TV
+#import <UIKit/UIKit.h>
+#endif  // TARGET_OS_IOS || TARGET_OS_TV
+
 NS_ASSUME_NONNULL_BEGIN
 
 static NSTimeInterval const kGULSynchronizeInterval = 1.0;
@@ -44,6 +48,20 @@ typedef NS_ENUM(NSInteger, GULUDMessageCode) {
   // The application name is the same with the suite name of the NSUserDefaults, and it is used for
   // preferences.
   CFStringRef _appNameRef;
+
+  /// The queue that writes the preferences to disk off the calling thread.
+  dispatch_queue_t _synchronizeQueue;
+
+  /// Whether there are changes that haven't been written to disk yet. Guarded by
+  /// `@synchronized(self)`.
+  BOOL _hasPendingChanges;
+
+  /// Whether a write to disk is already scheduled on `_synchronizeQueue`. Guarded by
+  /// `@synchronized(self)`.
+  BOOL _isSynchronizeScheduled;
+
+  /// The observer that writes pending changes to disk when the app enters the background.
+  id _backgroundObserver;
 }
 
 + (GULUserDefaults *)standardUserDefaults {
@@ -69,21 +87,40 @@ typedef NS_ENUM(NSInteger, GULUDMessageCode) {
     // `[NSUserDefaults standardUserDefaults]`.
     _appNameRef =
         name.length ? (__bridge_retained CFStringRef)name : kCFPreferencesCurrentApplication;
+    _synchronizeQueue =
+        dispatch_queue_create("com.google.GULUserDefaults.synchronize", DISPATCH_QUEUE_SERIAL);
+
+#if TARGET_OS_IOS || TARGET_OS_TV
+    // The app may be suspended before a scheduled write happens, so flush pending changes now.
+    __weak GULUserDefaults *weakSelf = self;
+    _backgroundObserver = [[NSNotificationCenter defaultCenter]
+        addObserverForName:UIApplicationDidEnterBackgroundNotification
+                    object:nil
+                     queue:nil
+                usingBlock:^(NSNotification *_Nonnull notification) {
+                  [weakSelf synchronizeIfNeeded];
+                }];
+#endif  // TARGET_OS_IOS || TARGET_OS_TV
   }
 
   return self;
 }
 
 - (void)dealloc {
+  if (_backgroundObserver) {
+    [[NSNotificationCenter defaultCenter] removeObserver:_backgroundObserver];
+  }
+
+  // The scheduled write only holds a weak reference, so write the pending changes now.
+  if (_hasPendingChanges) {
+    [self synchronize];
+  }
+
   // If we're using a custom `_appNameRef` it needs to be released. If it's a constant, it shouldn't
   // need to be released since we don't own it.
   if (CFStringCompare(_appNameRef, kCFPreferencesCurrentApplication, 0) != kCFCompareEqualTo) {
     CFRelease(_appNameRef);
   }
-
-  [NSObject cancelPreviousPerformRequestsWithTarget:self
-                                           selector:@selector(synchronize)
-                                             object:nil];
 }
 
 - (nullable id)objectForKey:(NSString *)defaultName {
@@ -186,6 +223,9 @@ typedef NS_ENUM(NSInteger, GULUDMessageCode) {
 #pragma mark - Save data
 
 - (void)synchronize {
+  @synchronized(self) {
+    _hasPendingChanges = NO;
+  }
   if (!CFPreferencesAppSynchronize(_appNameRef)) {
     GULLogError(kGULLogUserDefaultsService, NO,
                 [NSString stringWithFormat:kGULLogFormat, (long)GULUDMessageCodeSynchronizeFailed],
@@ -218,16 +258,41 @@ typedef NS_ENUM(NSInteger, GULUDMessageCode) {
 }
 
 - (void)scheduleSynchronize {
-  // Synchronize data using a timer so that multiple set... calls can be coalesced under one
-  // synchronize.
-  [NSObject cancelPreviousPerformRequestsWithTarget:self
-                                           selector:@selector(synchronize)
-                                             object:nil];
-  // This method may be called on multiple queues (due to set... methods can be called on any queue)
-  // synchronize can be scheduled on different queues, so make sure that it does not crash. If this
-  // instance goes away, self will be released also, no one will retain it and the schedule won't be
-  // called.
-  [self performSelector:@selector(synchronize) withObject:nil afterDelay:kGULSynchronizeInterval];
+  // The values are already visible to readers in this process, including NSUserDefaults, since
+  // CFPreferences keeps them in memory. Only writing them to disk is deferred, so that all the
+  // set... calls within the interval are coalesced under one synchronize on a background queue.
+  @synchronized(self) {
+    _hasPendingChanges = YES;
+    if (_isSynchronizeScheduled) {
+      return;
+    }
+    _isSynchronizeScheduled = YES;
+  }
+
+  // If this instance goes away, dealloc writes the pending changes instead.
+  __weak GULUserDefaults *weakSelf = self;
+  dispatch_time_t when =
+      dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kGULSynchronizeInterval * NSEC_PER_SEC));
+  dispatch_after(when, _synchronizeQueue, ^{
+    GULUserDefaults *strongSelf = weakSelf;
+    if (!strongSelf) {
+      return;
+    }
+    @synchronized(strongSelf) {
+      strongSelf->_isSynchronizeScheduled = NO;
+    }
+    [strongSelf synchronizeIfNeeded];
+  });
+}
+
+/// Writes the preferences to disk if they changed since the last write.
+- (void)synchronizeIfNeeded {
+  @synchronized(self) {
+    if (!_hasPendingChanges) {
+      return;
+    }
+  }
+  [self synchronize];
 }
 
 @end
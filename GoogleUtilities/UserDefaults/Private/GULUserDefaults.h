@@ -78,7 +78,8 @@ NS_ASSUME_NONNULL_BEGIN
 /// Immediately stores a value (or removes the value if `nil` is passed as the value) for the
 /// provided key in the search list entry for the receiver's suite name in the current user and any
 /// host, then asynchronously stores the value persistently, where it is made available to other
-/// processes.
+/// processes. Changes made within a short interval are written to disk together on a background
+/// queue, and pending changes are written when the app enters the background.
 - (void)setObject:(nullable id)value forKey:(NSString *)defaultName;
 
 /// Equivalent to -setObject:forKey: except that the value is converted from a float to an NSNumber.
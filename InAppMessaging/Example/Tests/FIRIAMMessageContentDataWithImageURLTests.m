@@ -16,6 +16,7 @@
 
 #import <OCMock/OCMock.h>
 #import <XCTest/XCTest.h>
+#import "FIRIAMImageDataCache.h"
 #import "FIRIAMMessageContentDataWithImageURL.h"
 
 static NSString *defaultTitle = @"Message Title";
@@ -42,7 +43,8 @@ static NSString *defaultImageURL = @"http://firebase.com/iam/test.png";
           actionButtonText:defaultActionButtonText
                  actionURL:[NSURL URLWithString:defaultActionURL]
                   imageURL:[NSURL URLWithString:defaultImageURL]
-           usingURLSession:_mockedNSURLSession];
+           usingURLSession:_mockedNSURLSession
+            imageDataCache:nil];
 }
 
 - (void)tearDown {
@@ -238,4 +240,58 @@ static NSString *defaultImageURL = @"http://firebase.com/iam/test.png";
   capturedCompletionHandler(imageData, successfulHTTPResponse, nil);
   [self waitForExpectationsWithTimeout:5.0 handler:nil];
 }
+
+- (void)testImageDataIsServedFromCacheAfterFirstLoad {
+  NSString *cacheDirectory = [NSTemporaryDirectory()
+      stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+  FIRIAMImageDataCache *imageDataCache =
+      [[FIRIAMImageDataCache alloc] initWithDirectoryPath:cacheDirectory
+                                   memoryCostLimitInBytes:1024
+                                     diskSizeLimitInBytes:1024];
+  FIRIAMMessageContentDataWithImageURL *contentData = [[FIRIAMMessageContentDataWithImageURL alloc]
+      initWithMessageTitle:defaultTitle
+               messageBody:defaultBody
+          actionButtonText:defaultActionButtonText
+                 actionURL:[NSURL URLWithString:defaultActionURL]
+                  imageURL:[NSURL URLWithString:defaultImageURL]
+           usingURLSession:self.mockedNSURLSession
+            imageDataCache:imageDataCache];
+
+  NSData *imageData = [@"test image data" dataUsingEncoding:NSUTF8StringEncoding];
+  NSURL *url = [[NSURL alloc] initWithString:defaultImageURL];
+  NSHTTPURLResponse *successfulHTTPResponse =
+      [[NSHTTPURLResponse alloc] initWithURL:url
+                                  statusCode:200
+                                 HTTPVersion:nil
+                                headerFields:@{@"Content-Type" : @"image/jpeg"}];
+
+  __block int dataTaskCount = 0;
+  OCMStub([self.mockedNSURLSession dataTaskWithRequest:[OCMArg any] completionHandler:[OCMArg any]])
+      .andDo(^(NSInvocation *invocation) {
+        dataTaskCount++;
+        __unsafe_unretained void (^completionHandler)(NSData *data, NSURLResponse *response,
+                                                      NSError *error);
+        [invocation getArgument:&completionHandler atIndex:3];
+        completionHandler(imageData, successfulHTTPResponse, nil);
+      });
+
+  XCTestExpectation *firstLoad = [self expectationWithDescription:@"first image load"];
+  [contentData loadImageDataWithBlock:^(NSData *_Nullable data, NSError *_Nullable error) {
+    XCTAssertEqualObjects(imageData, data);
+    [firstLoad fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+  XCTestExpectation *secondLoad = [self expectationWithDescription:@"second image load"];
+  [contentData loadImageDataWithBlock:^(NSData *_Nullable data, NSError *_Nullable error) {
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(imageData, data);
+    [secondLoad fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+  // only the first load goes to the network
+  XCTAssertEqual(1, dataTaskCount);
+  [[NSFileManager defaultManager] removeItemAtPath:cacheDirectory error:nil];
+}
 @end
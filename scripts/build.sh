@@ -34,6 +34,7 @@ platform can be one of:
   iOS (default)
   macOS
   tvOS
+  Linux (cmake only)
 
 method can be one of:
   xcodebuild (default)
@@ -129,9 +130,12 @@ cmake_options=(
   --warn-uninitialized
 )
 
-xcode_version=$(xcodebuild -version | head -n 1)
-xcode_version="${xcode_version/Xcode /}"
-xcode_major="${xcode_version/.*/}"
+xcode_major=0
+if [[ "$platform" != "Linux" ]]; then
+  xcode_version=$(xcodebuild -version | head -n 1)
+  xcode_version="${xcode_version/Xcode /}"
+  xcode_major="${xcode_version/.*/}"
+fi
 
 if [[ -n "${SANITIZERS:-}" ]]; then
   for sanitizer in $SANITIZERS; do
@@ -327,6 +331,23 @@ case "$product-$method-$platform" in
     (cd build; env CTEST_OUTPUT_ON_FAILURE=1 make -j $cpus test)
     ;;
 
+  Firestore-cmake-Linux)
+    test -d build || mkdir build
+    echo "Preparing cmake build ..."
+    (cd build; cmake "${cmake_options[@]}" ..)
+
+    echo "Building cmake build ..."
+    cpus=$(nproc)
+    (cd build; env make -j $cpus all generate_protos)
+    (cd build; env CTEST_OUTPUT_ON_FAILURE=1 make -j $cpus test)
+
+    # A short run that keeps the benchmarks building and working. The timings
+    # of shared CI machines are too noisy to compare against a baseline.
+    echo "Running benchmarks ..."
+    (cd build/Firestore/core/test/firebase/firestore/benchmarks;
+        ./firebase_firestore_benchmarks --benchmark_min_time=0.01)
+    ;;
+
   SymbolCollision-xcodebuild-*)
     RunXcodebuild \
         -workspace 'SymbolCollisionTest/SymbolCollisionTest.xcworkspace' \
@@ -79,6 +79,11 @@ case "$PROJECT-$PLATFORM-$METHOD" in
     bundle exec pod repo update
     ;;
 
+  Firestore-Linux-cmake)
+    # Install python packages required to generate proto sources
+    pip install --user six
+    ;;
+
   Firestore-*-cmake)
     brew outdated cmake || brew upgrade cmake
     brew outdated go || brew upgrade go # Somehow the build for Abseil requires this.